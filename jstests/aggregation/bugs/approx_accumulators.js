@@ -0,0 +1,42 @@
+// $approxCountDistinct and $percentile estimate in bounded memory what $addToSet and sorting would
+// compute exactly.
+
+var t = db.jstests_aggregation_approx_accumulators;
+t.drop();
+
+var bulk = t.initializeUnorderedBulkOp();
+for (var i = 0; i < 20000; i++) {
+    bulk.insert({ g: i % 2, x: i % 5000, y: (i * 7919) % 20000 });
+}
+assert.writeOK(bulk.execute());
+
+function group(accumulators) {
+    return t.aggregate([ { $group: { _id: null, out: accumulators } } ]).toArray()[0].out;
+}
+
+function assertNear(expected, actual, tolerance) {
+    assert.lte(Math.abs(expected - actual), tolerance, "expected " + expected + ", got " + actual);
+}
+
+// Small groups are counted exactly.
+assert.eq(2, group({ $approxCountDistinct: "$g" }));
+assert.eq(0, group({ $approxCountDistinct: "$missing" }));
+assertNear(5000, group({ $approxCountDistinct: "$x" }), 150);
+assertNear(20000, group({ $approxCountDistinct: "$y" }), 600);
+
+assertNear(10000, group({ $percentile: { input: "$y", p: { $literal: 0.5 } } }), 20);
+assertNear(19800, group({ $percentile: { input: "$y", p: { $literal: 0.99 } } }), 20);
+assert.eq(0, group({ $percentile: { input: "$y", p: { $literal: 0 } } }));
+assert.eq(19999, group({ $percentile: { input: "$y", p: { $literal: 1 } } }));
+assert.eq(null, group({ $percentile: { input: "$missing", p: { $literal: 0.5 } } }));
+
+// Bad percentiles.
+function assertFails(p) {
+    assert.commandFailed(db.runCommand({
+        aggregate: t.getName(),
+        pipeline: [ { $group: { _id: null, out: { $percentile: { input: "$y", p: p } } } } ]
+    }), tojson(p));
+}
+assertFails({ $literal: 2 });
+assertFails({ $literal: "a" });
+assertFails("$y");
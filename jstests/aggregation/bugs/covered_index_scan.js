@@ -0,0 +1,42 @@
+// A pipeline which only depends on fields held by an index reads that index's keys in place of
+// scanning the collection's documents.
+
+var t = db.jstests_aggregation_covered_index_scan;
+t.drop();
+
+for (var i = 0; i < 100; i++) {
+    t.insert({ a: i % 10, b: i, c: "padding" + i });
+}
+t.ensureIndex({ a: 1, b: 1 });
+
+var pipeline = [ { $group: { _id: "$a", total: { $sum: "$b" } } }, { $sort: { _id: 1 } } ];
+
+function plan(pipeline) {
+    return tojson(t.aggregate(pipeline, { explain: true }));
+}
+
+var explain = plan(pipeline);
+assert(explain.indexOf("IXSCAN") >= 0, explain);
+assert.eq(-1, explain.indexOf("COLLSCAN"), explain);
+assert.eq(-1, explain.indexOf("FETCH"), explain);
+
+var results = t.aggregate(pipeline).toArray();
+assert.eq(10, results.length);
+for (var i = 0; i < 10; i++) {
+    assert.eq({ _id: i, total: 10 * i + 450 }, results[i]);
+}
+
+// Fields the index lacks need the documents.
+explain = plan([ { $group: { _id: "$a", c: { $first: "$c" } } } ]);
+assert(explain.indexOf("COLLSCAN") >= 0, explain);
+
+// So does _id, unless the pipeline drops it.
+explain = plan([ { $project: { a: 1 } } ]);
+assert(explain.indexOf("COLLSCAN") >= 0, explain);
+explain = plan([ { $project: { _id: 0, a: 1 } } ]);
+assert.eq(-1, explain.indexOf("COLLSCAN"), explain);
+
+// A multikey index has several keys for some documents.
+t.insert({ a: [ 1, 2 ], b: 1000 });
+explain = plan(pipeline);
+assert(explain.indexOf("COLLSCAN") >= 0, explain);
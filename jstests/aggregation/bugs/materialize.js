@@ -0,0 +1,57 @@
+// $materialize keeps the results of a $group in a collection, merging each refresh over newly
+// added documents into the groups already stored there.
+
+var t = db.jstests_aggregation_materialize;
+var view = db.jstests_aggregation_materialize_view;
+t.drop();
+view.drop();
+
+function refresh(sinceId) {
+    t.aggregate([ { $match: { _id: { $gte: sinceId } } },
+                  { $group: { _id: "$g",
+                              total: { $sum: "$x" },
+                              avg: { $avg: "$x" },
+                              first: { $first: "$x" },
+                              last: { $last: "$x" } } },
+                  { $materialize: view.getName() } ]);
+}
+
+for (var i = 0; i < 10; i++) {
+    t.insert({ _id: i, g: i % 2, x: i });
+}
+refresh(0);
+assert.eq(2, view.count());
+var odd = view.findOne({ _id: 1 });
+assert.eq(25, odd.total);
+assert.eq(5, odd.avg);
+assert.eq(1, odd.first);
+assert.eq(9, odd.last);
+
+// A refresh over only the new documents updates the existing groups and adds new ones.
+for (var i = 10; i < 15; i++) {
+    t.insert({ _id: i, g: i % 3, x: i });
+}
+refresh(10);
+assert.eq(3, view.count());
+odd = view.findOne({ _id: 1 });
+assert.eq(25 + 10 + 13, odd.total);
+assert.eq((25 + 10 + 13) / 7, odd.avg);
+assert.eq(1, odd.first);
+assert.eq(13, odd.last);
+assert.eq({ _id: 2, total: 25, avg: 12.5, first: 11, last: 14 },
+          view.findOne({ _id: 2 }, { _state: 0 }));
+
+// Rerunning over the whole input from scratch gives the same results.
+var expected = t.aggregate([ { $group: { _id: "$g", total: { $sum: "$x" } } },
+                             { $sort: { _id: 1 } } ]).toArray();
+assert.eq(expected, view.find({}, { total: 1 }).sort({ _id: 1 }).toArray());
+
+// Bad uses.
+function assertFails(pipeline) {
+    assert.commandFailed(db.runCommand({ aggregate: t.getName(), pipeline: pipeline }),
+                         tojson(pipeline));
+}
+assertFails([ { $match: {} }, { $materialize: view.getName() } ]);
+assertFails([ { $group: { _id: "$g" } }, { $materialize: view.getName() }, { $match: {} } ]);
+assertFails([ { $group: { _id: "$g", _state: { $sum: 1 } } }, { $materialize: view.getName() } ]);
+assertFails([ { $group: { _id: "$g" } }, { $materialize: 1 } ]);
@@ -0,0 +1,52 @@
+// The aggregation result cache answers a repeated pipeline until the collection changes.
+
+var t = db.jstests_aggregation_result_cache;
+t.drop();
+
+for (var i = 0; i < 100; i++) {
+    t.insert({ _id: i, g: i % 4 });
+}
+
+function metrics() {
+    return db.serverStatus().metrics.aggregate.resultCache;
+}
+
+function group() {
+    return t.aggregate([ { $group: { _id: "$g", n: { $sum: 1 } } },
+                         { $sort: { _id: 1 } } ]).toArray();
+}
+
+assert.commandWorked(db.adminCommand({ setParameter: 1,
+                                       aggregationResultCacheSizeBytes: 1024 * 1024 }));
+
+try {
+    var before = metrics();
+    var expected = group();
+    assert.eq(4, expected.length);
+    assert.eq(expected, group());
+    var after = metrics();
+    assert.eq(before.hits + 1, after.hits, tojson(after));
+
+    // A write makes the cached results outdated.
+    t.insert({ _id: 100, g: 0 });
+    var changed = group();
+    assert.eq(26, changed[0].n);
+    assert.eq(after.hits, metrics().hits);
+
+    // Inline results are cached separately from cursors.
+    var inline = db.runCommand({ aggregate: t.getName(),
+                                 pipeline: [ { $group: { _id: "$g", n: { $sum: 1 } } },
+                                             { $sort: { _id: 1 } } ] });
+    assert.commandWorked(inline);
+    assert.eq(changed, inline.result);
+
+    // $sample is random, so it is never cached.
+    var hits = metrics().hits;
+    t.aggregate([ { $sample: { size: 2 } } ]).toArray();
+    t.aggregate([ { $sample: { size: 2 } } ]).toArray();
+    assert.eq(hits, metrics().hits);
+}
+finally {
+    assert.commandWorked(db.adminCommand({ setParameter: 1,
+                                           aggregationResultCacheSizeBytes: 0 }));
+}
@@ -0,0 +1,58 @@
+// $sample returns distinct documents of its input, read through a random cursor when it starts the
+// pipeline over a collection whose storage engine has one and the sample is small.
+
+var t = db.jstests_aggregation_sample;
+t.drop();
+
+// Asserts that 'docs' are 'n' distinct documents with _ids in [0, 'limit').
+function assertDistinct(docs, n, limit) {
+    assert.eq(n, docs.length, tojson(docs));
+    var seen = {};
+    docs.forEach(function(doc) {
+        assert.lt(doc._id, limit, tojson(doc));
+        assert(!seen[doc._id], "duplicate " + tojson(doc));
+        assert.eq(undefined, doc.$randVal);
+        seen[doc._id] = true;
+    });
+}
+
+function sample(size, before) {
+    return t.aggregate((before || []).concat([ { $sample: { size: size } } ])).toArray();
+}
+
+assert.eq([], sample(1));
+
+for (var i = 0; i < 1000; i++) {
+    t.insert({ _id: i, even: i % 2 == 0 });
+}
+
+assertDistinct(sample(10), 10, 1000);  // a random cursor on engines which have one
+assertDistinct(sample(500), 500, 1000);  // too large for a random cursor, so a collection scan
+assertDistinct(sample(2000), 1000, 1000);
+
+var evens = sample(50, [ { $match: { even: true } } ]);
+assertDistinct(evens, 50, 1000);
+evens.forEach(function(doc) {
+    assert(doc.even, tojson(doc));
+});
+
+// Later stages see the sampled documents.
+assert.eq(5, t.aggregate([ { $sample: { size: 5 } }, { $group: { _id: null, n: { $sum: 1 } } } ])
+                .toArray()[0].n);
+
+// WiredTiger reads a small sample through a random cursor.
+if (db.serverStatus().storageEngine.name == "wiredTiger") {
+    var explain = t.aggregate([ { $sample: { size: 10 } } ], { explain: true });
+    assert(tojson(explain).indexOf("$sampleFromRandomCursor") >= 0, tojson(explain));
+}
+
+// Bad specifications.
+function assertFails(spec) {
+    assert.commandFailed(db.runCommand({ aggregate: t.getName(), pipeline: [ { $sample: spec } ] }),
+                         tojson(spec));
+}
+assertFails(1);
+assertFails({});
+assertFails({ size: 0 });
+assertFails({ size: "1" });
+assertFails({ size: 1, other: 1 });
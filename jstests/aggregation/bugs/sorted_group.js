@@ -0,0 +1,45 @@
+// A $group directly after a $sort on its key returns each group as the key changes.  Its results
+// must be the same as grouping the unsorted input.
+
+var t = db.jstests_aggregation_sorted_group;
+t.drop();
+
+for (var i = 0; i < 100; i++) {
+    t.insert({ _id: i, ts: i % 7, bucket: { hour: i % 5 }, v: i });
+}
+t.insert({ _id: 100, v: 100 });           // missing ts groups with null
+t.insert({ _id: 101, ts: null, v: 101 });
+
+function byId(a, b) {
+    return bsonWoCompare({ x: a._id }, { x: b._id });
+}
+
+// Compares the results of 'group' after 'sort' with the results of 'group' alone.
+function assertSameGroups(sort, group) {
+    var sorted = t.aggregate([ { $sort: sort }, { $group: group } ]).toArray();
+    var hashed = t.aggregate([ { $group: group } ]).toArray();
+    assert.eq(hashed.sort(byId), sorted.sort(byId), tojson(sort) + " " + tojson(group));
+}
+
+function assertAllSameGroups() {
+    assertSameGroups({ ts: 1 }, { _id: "$ts", n: { $sum: 1 }, max: { $max: "$v" } });
+    assertSameGroups({ ts: -1, v: 1 }, { _id: "$ts", min: { $min: "$v" } });
+    assertSameGroups({ "bucket.hour": 1 }, { _id: "$bucket.hour", total: { $sum: "$v" } });
+    assertSameGroups({ "bucket.hour": 1, ts: 1 },
+                     { _id: { ts: "$ts", hour: "$bucket.hour" }, n: { $sum: 1 } });
+}
+
+// The $sort is done in the pipeline.
+assertAllSameGroups();
+
+// The $sort is pushed into an index scan.
+t.ensureIndex({ ts: 1 });
+t.ensureIndex({ "bucket.hour": 1, ts: 1 });
+assertAllSameGroups();
+
+// A multikey index orders documents by their array elements, which doesn't keep equal arrays
+// together.
+t.insert({ _id: 102, ts: [ 1, 5 ], v: 102 });
+t.insert({ _id: 103, ts: [ 1, 5 ], v: 103 });
+assertAllSameGroups();
+
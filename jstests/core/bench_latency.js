@@ -0,0 +1,53 @@
+// benchRun() reports latency percentiles for each type of op, overall and for each interval.
+
+var t = db.bench_latency;
+t.drop();
+
+t.insert( { _id : 1 , x : 1 } );
+
+var ops = [
+    { op : "findOne" , ns : t.getFullName() , query : { _id : 1 } } ,
+    { op : "update" , ns : t.getFullName() , query : { _id : 1 } , update : { $inc : { x : 1 } } }
+];
+
+var benchArgs = { ops : ops , parallel : 2 , seconds : 2 , statsIntervalSeconds : 0.5 ,
+                  host : db.getMongo().host };
+
+if (jsTest.options().auth) {
+    benchArgs['db'] = 'admin';
+    benchArgs['username'] = jsTest.options().adminUser;
+    benchArgs['password'] = jsTest.options().adminPassword;
+}
+var res = benchRun( benchArgs );
+printjson( res.latency );
+
+[ "findOne" , "update" ].forEach( function( op ) {
+    var latency = res.latency[op];
+    assert( latency , op + " latency missing" );
+    assert.gt( latency.count , 0 , op );
+    assert.lte( latency.minMicros , latency.p50Micros , op );
+    assert.lte( latency.p50Micros , latency.p95Micros , op );
+    assert.lte( latency.p95Micros , latency.p99Micros , op );
+    assert.lte( latency.p99Micros , latency.p999Micros , op );
+    assert.lte( latency.p999Micros , latency.maxMicros , op );
+    assert.lte( latency.minMicros , latency.averageMicros , op );
+    assert.lte( latency.averageMicros , latency.maxMicros , op );
+} );
+assert.eq( undefined , res.latency.insert );
+
+// The intervals add up to the totals.
+assert.gte( res.intervals.length , 2 );
+var findOnes = 0;
+res.intervals.forEach( function( interval , i ) {
+    assert.eq( i * 0.5 , interval.startSeconds );
+    if ( interval.latency.findOne )
+        findOnes += interval.latency.findOne.count;
+} );
+assert.eq( res.latency.findOne.count , findOnes );
+
+// Without statsIntervalSeconds there are no intervals.
+delete benchArgs.statsIntervalSeconds;
+benchArgs.seconds = 1;
+res = benchRun( benchArgs );
+assert.eq( undefined , res.intervals );
+assert.gt( res.latency.findOne.count , 0 );
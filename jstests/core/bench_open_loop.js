@@ -0,0 +1,36 @@
+// benchRun() can send at a target rate ("open loop") and wait a think time between ops.
+
+var t = db.bench_open_loop;
+t.drop();
+
+t.insert( { _id : 1 , x : 1 } );
+
+var benchArgs = { ops : [ { op : "findOne" , ns : t.getFullName() , query : { _id : 1 } } ] ,
+                  parallel : 2 , seconds : 2 , host : db.getMongo().host };
+
+if (jsTest.options().auth) {
+    benchArgs['db'] = 'admin';
+    benchArgs['username'] = jsTest.options().adminUser;
+    benchArgs['password'] = jsTest.options().adminPassword;
+}
+
+// At 100 ops/sec for 2 seconds about 200 ops are sent, whichever the arrivals.
+[ "uniform" , "poisson" ].forEach( function( arrivals ) {
+    benchArgs.opsPerSecond = 100;
+    benchArgs.arrivals = arrivals;
+    var res = benchRun( benchArgs );
+    printjson( res.latency );
+    assert.gt( res.latency.findOne.count , 50 , arrivals );
+    assert.lt( res.latency.findOne.count , 400 , arrivals );
+} );
+
+benchArgs.arrivals = "bursty";
+assert.throws( function() { benchRun( benchArgs ); } );
+
+// A closed loop thinking for 100ms after each op sends at most about 20 ops per thread.
+delete benchArgs.opsPerSecond;
+delete benchArgs.arrivals;
+benchArgs.thinkTimeMillis = 100;
+var res = benchRun( benchArgs );
+assert.gt( res.latency.findOne.count , 0 );
+assert.lte( res.latency.findOne.count , 2 * 21 );
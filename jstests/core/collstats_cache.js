@@ -0,0 +1,28 @@
+// collStats reports the storage engine's cache statistics for a collection and its indexes when
+// asked with cacheStats.
+
+var t = db.jstests_collstats_cache;
+t.drop();
+t.ensureIndex({ a: 1 });
+for (var i = 0; i < 100; i++) {
+    t.insert({ _id: i, a: i });
+}
+assert.eq(100, t.find({ a: { $gte: 0 } }).itcount());
+
+var stats = t.stats();
+assert(!stats.cache, tojson(stats));
+assert(!stats.indexCache, tojson(stats));
+
+stats = assert.commandWorked(db.runCommand({ collStats: t.getName(), cacheStats: true }));
+assert.eq("object", typeof stats.indexCache, tojson(stats));
+
+var engine = db.serverStatus().storageEngine.name;
+if (engine == "wiredTiger") {
+    assert.gte(stats.cache.cursor.inserts, 100, tojson(stats));
+    assert.gte(stats.indexCache.a_1.cursor.inserts, 100, tojson(stats));
+    assert.gte(stats.indexCache._id_.bytesReadIntoCache, 0, tojson(stats));
+}
+else if (engine == "mmapv1") {
+    assert.gt(stats.cache.bytesInCache, 0, tojson(stats));
+    assert.gt(stats.indexCache.a_1.bytesInCache, 0, tojson(stats));
+}
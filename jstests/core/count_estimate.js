@@ -0,0 +1,40 @@
+// The count command's 'estimate' option. Storage engines which cannot estimate an index range, or
+// which have nothing flushed to estimate from yet, fall back to an exact count.
+
+var t = db.jstests_count_estimate;
+t.drop();
+
+t.ensureIndex({ ts: 1 });
+for (var i = 0; i < 1000; i++) {
+    t.insert({ ts: i, arr: [ i, i + 1 ] });
+}
+
+function count(query, estimate) {
+    var res = db.runCommand({ count: t.getName(), query: query, estimate: estimate });
+    assert.commandWorked(res);
+    return res;
+}
+
+var exact = count({ ts: { $gte: 100 } }, false);
+assert.eq(900, exact.n);
+assert(!exact.estimated, tojson(exact));
+
+var res = count({ ts: { $gte: 100 } }, true);
+if (res.estimated) {
+    assert.gte(res.n, 0, tojson(res));
+    assert.lte(res.n, 1000, tojson(res));
+}
+else {
+    assert.eq(900, res.n, tojson(res));
+}
+
+// Counts which cannot be answered by a count scan are always exact.
+t.ensureIndex({ arr: 1 });
+res = count({ arr: { $gte: 100 } }, true);
+assert(!res.estimated, tojson(res));
+assert.eq(901, res.n, tojson(res));
+res = count({ ts: { $gte: 100 }, arr: 101 }, true);
+assert(!res.estimated, tojson(res));
+assert.eq(2, res.n, tojson(res));
+
+assert.commandFailed(db.runCommand({ count: t.getName(), query: {}, estimate: 1 }));
@@ -0,0 +1,46 @@
+// dbHash with hashFunction "murmur3" hashes collections independently of the order their
+// documents are stored in.
+
+var testDB = db.getSiblingDB("dbhash_murmur3");
+testDB.dropDatabase();
+
+function dbhash(cmd) {
+    var res = testDB.runCommand(Object.extend({ dbHash: 1, hashFunction: "murmur3" }, cmd));
+    assert.commandWorked(res);
+    assert.eq("murmur3", res.hashFunction, tojson(res));
+    assert.eq(32, res.hash.length, tojson(res));
+    return res;
+}
+
+for (var i = 0; i < 100; i++) {
+    testDB.a.insert({ _id: i, x: i });
+    testDB.b.insert({ _id: 99 - i, x: 99 - i });
+}
+testDB.c.insert({ _id: 0 });
+testDB.createCollection("empty");
+
+var res = dbhash({});
+assert.eq(res.collections.a, res.collections.b, tojson(res));
+assert.neq(res.collections.a, res.collections.c, tojson(res));
+assert.eq(32, res.collections.empty.length, tojson(res));
+
+// The hash is stable and follows the contents.
+assert.eq(res.hash, dbhash({}).hash);
+testDB.b.update({ _id: 5 }, { $set: { x: -1 } });
+var after = dbhash({});
+assert.neq(res.collections.b, after.collections.b, tojson(after));
+assert.eq(res.collections.a, after.collections.a, tojson(after));
+assert.neq(res.hash, after.hash);
+
+// Only the requested collections are hashed.
+var some = dbhash({ collections: [ "a" ] });
+assert.eq([ "a" ], Object.keySet(some.collections), tojson(some));
+
+// md5 stays the default.
+var md5 = testDB.runCommand({ dbHash: 1 });
+assert.commandWorked(md5);
+assert.eq(32, md5.md5.length, tojson(md5));
+assert.commandFailed(testDB.runCommand({ dbHash: 1, hashFunction: "sha1" }));
+assert.commandFailed(testDB.runCommand({ dbHash: 1, hashFunction: 1 }));
+
+testDB.dropDatabase();
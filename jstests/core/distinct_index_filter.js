@@ -0,0 +1,28 @@
+// A distinct over an index prefix stays a distinct scan when the rest of the query can only be
+// applied as a filter over the index keys.
+
+var t = db.jstests_distinct_index_filter;
+t.drop();
+
+t.ensureIndex({ a: 1, b: 1 });
+for (var i = 0; i < 100; i++) {
+    t.insert({ a: i % 10, b: i });
+}
+
+function check(query, expected) {
+    var res = t.runCommand("distinct", { key: "a", query: query });
+    assert.commandWorked(res);
+    assert.eq(expected, res.values.sort(), tojson(query));
+    assert(/DISTINCT/.test(res.stats.planSummary), tojson(res.stats));
+    assert.eq(0, res.stats.nscannedObjects, tojson(res.stats));
+}
+
+check({ a: { $gte: 0 }, b: { $mod: [ 20, 3 ] } }, [ 3 ]);
+check({ a: { $gte: 0 }, b: { $mod: [ 5, 0 ] } }, [ 0, 5 ]);
+check({ a: { $gte: 4 }, b: { $mod: [ 2, 1 ] } }, [ 5, 7, 9 ]);
+check({ a: { $gte: 0 }, b: { $mod: [ 1000, 999 ] } }, []);
+
+// Numbers of different types are one distinct value.
+t.insert({ a: NumberLong(3), b: 203 });
+t.insert({ a: 3.0, b: 223 });
+check({ a: { $gte: 0 }, b: { $mod: [ 20, 3 ] } }, [ 3 ]);
@@ -119,3 +119,13 @@ assert.eq(1, db.runCommand({count: collName, query: {a: 2}, limit: 2}).n);
 explain = db.runCommand({explain: {count: collName, query: {a: 2}, limit: 2},
                          verbosity: "executionStats"});
 checkCountExplain(explain, 1);
+
+// A count over several index intervals is answered from the index without fetching.
+assert.eq(11, db.runCommand({count: collName, query: {a: {$in: [1, 2]}}}).n);
+explain = db.runCommand({explain: {count: collName, query: {a: {$in: [1, 2]}}},
+                         verbosity: "executionStats"});
+checkCountExplain(explain, 11);
+if ("SINGLE_SHARD" != explain.executionStats.executionStages.stage) {
+    assert.eq("IXSCAN", explain.executionStats.executionStages.inputStage.stage,
+              "count over an index should not fetch");
+}
@@ -0,0 +1,40 @@
+// Explain with execution stats reports nanosecond timings and storage cursor calls per stage.
+
+var t = db.jstests_explain_detailed_stats;
+t.drop();
+
+t.ensureIndex({ a: 1 });
+for (var i = 0; i < 100; i++) {
+    t.insert({ _id: i, a: i, b: i % 10 });
+}
+
+function checkStage(stage) {
+    assert(stage.hasOwnProperty("executionTimeNanos"), tojson(stage));
+    assert.gte(stage.executionTimeNanos, 0, tojson(stage));
+    assert(stage.hasOwnProperty("storageCursorOps"), tojson(stage));
+    if (stage.inputStage) {
+        // A stage's time includes its child's.
+        assert.gte(stage.executionTimeNanos, stage.inputStage.executionTimeNanos, tojson(stage));
+        checkStage(stage.inputStage);
+    }
+}
+
+var explain = t.find({ a: { $gte: 10 }, b: 3 }).explain("executionStats");
+assert.commandWorked(explain);
+var stages = explain.executionStats.executionStages;
+checkStage(stages);
+
+// The fetch reads each of the 90 documents, and the index scan steps over each key.
+assert.eq("FETCH", stages.stage, tojson(stages));
+assert.gte(stages.storageCursorOps, 90, tojson(stages));
+assert.eq("IXSCAN", stages.inputStage.stage, tojson(stages));
+assert.gte(stages.inputStage.storageCursorOps, 90, tojson(stages));
+
+explain = t.find({ b: 3 }).explain("executionStats");
+stages = explain.executionStats.executionStages;
+assert.eq("COLLSCAN", stages.stage, tojson(stages));
+assert.gte(stages.storageCursorOps, 100, tojson(stages));
+
+// Plans which are not run only have the plain stats.
+explain = t.find({ a: 1 }).explain("queryPlanner");
+assert(!explain.queryPlanner.winningPlan.hasOwnProperty("executionTimeNanos"), tojson(explain));
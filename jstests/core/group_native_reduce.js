@@ -0,0 +1,62 @@
+// Common group reducers run natively, without JavaScript, and return exactly what the JavaScript
+// reducer would.
+
+var t = db.jstests_group_native_reduce;
+t.drop();
+
+for (var i = 0; i < 40; i++) {
+    t.insert({ a: i % 4, qty: i, price: i % 3 == 0 ? null : i / 2 });
+}
+t.insert({ a: 5 });
+
+var cmds = [
+    { ns: t.getName(), key: { a: 1 }, initial: { count: 0 },
+      $reduce: function(obj, prev) { prev.count++; } },
+    { ns: t.getName(), key: { a: 1 }, initial: { total: 0, n: 0, label: "x" },
+      $reduce: function(doc, out) { out.total += doc.price; out.n += 1; } },
+    { ns: t.getName(), key: {}, initial: { lo: 1000, hi: -1000 },
+      $reduce: function(o, p) { p.lo = Math.min(p.lo, o.qty); p.hi = Math.max(p.hi, o.qty); } },
+    { ns: t.getName(), key: { a: 1 }, cond: { qty: { $gt: 10 } }, initial: { a: "initial", n: 0 },
+      $reduce: function(o, p) { p.n++; } }
+];
+
+function group(cmd, nativeReduce) {
+    assert.commandWorked(db.adminCommand({ setParameter: 1,
+                                           internalQueryGroupNativeReduce: nativeReduce }));
+    var explain = db.runCommand({ explain: { group: cmd }, verbosity: "executionStats" });
+    var res = db.runCommand({ group: cmd });
+    assert.commandWorked(res);
+    return { retval: res.retval, native: explain.executionStats.executionStages.reducedNatively };
+}
+
+function sortedByKey(retval) {
+    return retval.sort(function(x, y) { return tojson(x) < tojson(y) ? -1 : 1; });
+}
+
+try {
+    cmds.forEach(function(cmd) {
+        var scripted = group(cmd, false);
+        assert(!scripted.native, tojson(cmd));
+
+        var native = group(cmd, true);
+        assert(native.native, tojson(cmd));
+        assert.eq(tojson(sortedByKey(scripted.retval)), tojson(sortedByKey(native.retval)),
+                  tojson(cmd));
+    });
+
+    // A value the native reducer cannot add the way JavaScript would hands the groups reduced so
+    // far over to JavaScript.
+    t.insert({ a: 1, qty: 100, price: "cheap" });
+    var scripted = group(cmds[1], false);
+    var native = group(cmds[1], true);
+    assert(!native.native);
+    assert.eq(tojson(sortedByKey(scripted.retval)), tojson(sortedByKey(native.retval)));
+
+    // So do reducers which are not one of the common forms.
+    var other = { ns: t.getName(), key: { a: 1 }, initial: { count: 0 },
+                  $reduce: function(obj, prev) { if (obj.qty > 3) prev.count++; } };
+    assert(!group(other, true).native);
+}
+finally {
+    db.adminCommand({ setParameter: 1, internalQueryGroupNativeReduce: true });
+}
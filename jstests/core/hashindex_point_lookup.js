@@ -0,0 +1,35 @@
+// Equality queries on a hashed index return every matching document, in either direction, even
+// when the documents under the hash change between batches.
+
+var t = db.jstests_hashindex_point_lookup;
+t.drop();
+
+t.ensureIndex({ a: "hashed" });
+for (var i = 0; i < 100; i++) {
+    t.insert({ _id: i, a: i % 2 == 0 ? "even" : "odd" });
+}
+
+assert.eq(50, t.find({ a: "even" }).hint({ a: "hashed" }).itcount());
+assert.eq(50, t.find({ a: "odd" }).sort({ a: -1 }).hint({ a: "hashed" }).itcount());
+assert.eq(0, t.find({ a: "neither" }).hint({ a: "hashed" }).itcount());
+assert.eq(50, t.find({ a: { $in: [ "even", "neither" ] } }).hint({ a: "hashed" }).itcount());
+
+// Remove documents which the cursor has not reached yet between getMores.
+var cursor = t.find({ a: "even" }).hint({ a: "hashed" }).batchSize(2);
+var seen = {};
+for (var j = 0; j < 2; j++) {
+    seen[cursor.next()._id] = true;
+}
+for (var k = 0; k < 100; k += 4) {
+    if (!seen[k]) {
+        t.remove({ _id: k });
+    }
+}
+t.insert({ _id: 100, a: "even" });
+while (cursor.hasNext()) {
+    var doc = cursor.next();
+    assert.eq("even", doc.a, tojson(doc));
+    assert(!seen[doc._id], "returned twice: " + tojson(doc));
+    seen[doc._id] = true;
+}
+assert.eq(t.find({ a: "even" }).count(), t.find({ a: "even" }).hint({ a: "hashed" }).itcount());
@@ -0,0 +1,27 @@
+// An index built over existing documents can leave free space in each btree bucket with the
+// "fillFactor" option. Storage engines other than mmapv1 accept and ignore it.
+
+var t = db.jstests_index_fill_factor;
+t.drop();
+
+var bulk = t.initializeUnorderedBulkOp();
+for (var i = 0; i < 5000; i++) {
+    bulk.insert({ _id: i, a: i % 100, b: "b" + i });
+}
+assert.writeOK(bulk.execute());
+
+assert.commandWorked(t.ensureIndex({ a: 1 }, { fillFactor: 50 }));
+assert.commandWorked(t.ensureIndex({ b: 1 }, { fillFactor: 100 }));
+
+assert.commandFailed(t.ensureIndex({ c: 1 }, { fillFactor: 5 }));
+assert.commandFailed(t.ensureIndex({ c: 1 }, { fillFactor: 101 }));
+assert.commandFailed(t.ensureIndex({ c: 1 }, { fillFactor: "half" }));
+
+// Later inserts go into the space which was left free.
+for (var i = 5000; i < 6000; i++) {
+    assert.writeOK(t.insert({ _id: i, a: i % 100, b: "b" + i }));
+}
+
+assert.eq(6000, t.find({ a: { $gte: 0 } }).hint({ a: 1 }).itcount());
+assert.eq(1, t.find({ b: "b5500" }).hint({ b: 1 }).itcount());
+assert(t.validate(true).valid);
@@ -0,0 +1,41 @@
+// Version 2 indexes keep the keys of version 1 indexes in larger btree buckets, whose size is
+// chosen when the index is created.
+
+var t = db.jstests_index_v2;
+t.drop();
+
+function specOf(name) {
+    return t.getIndexes().filter(function(spec) { return spec.name == name; })[0];
+}
+
+assert.commandWorked(t.ensureIndex({ a: 1, b: 1 }, { v: 2 }));
+assert.commandWorked(t.ensureIndex({ b: 1 }, { v: 2, btreeBucketSize: 16 * 1024 }));
+assert.commandWorked(t.ensureIndex({ a: 1, c: 1 }, { v: 2, btreeBucketSize: 64 * 1024 }));
+
+assert.eq(2, specOf("a_1_b_1").v);
+assert.eq(32 * 1024, specOf("a_1_b_1").btreeBucketSize, "the default is not pinned in the spec");
+assert.eq(16 * 1024, specOf("b_1").btreeBucketSize);
+
+assert.commandFailed(t.ensureIndex({ d: 1 }, { v: 2, btreeBucketSize: 12345 }));
+assert.commandFailed(t.ensureIndex({ d: 1 }, { v: 1, btreeBucketSize: 16 * 1024 }));
+
+var prefix = new Array(200).join("x");
+var bulk = t.initializeUnorderedBulkOp();
+for (var i = 0; i < 5000; i++) {
+    bulk.insert({ _id: i, a: prefix + (i % 50), b: prefix + i, c: i });
+}
+assert.writeOK(bulk.execute());
+
+assert.eq(5000, t.find({ a: { $gte: "" } }).hint({ a: 1, b: 1 }).itcount());
+assert.eq(100, t.find({ a: prefix + 7 }).hint({ a: 1, c: 1 }).itcount());
+assert.eq(1, t.find({ b: prefix + 4321 }).hint({ b: 1 }).itcount());
+assert(t.validate(true).valid);
+
+assert.writeOK(t.remove({ c: { $mod: [ 2, 0 ] } }));
+assert.eq(2500, t.find({ a: { $gte: "" } }).hint({ a: 1, c: 1 }).itcount());
+assert(t.validate(true).valid);
+
+// Bulk built indexes take the same path.
+assert.commandWorked(t.ensureIndex({ c: 1 }, { v: 2, btreeBucketSize: 64 * 1024 }));
+assert.eq(2500, t.find({ c: { $gte: 0 } }).hint({ c: 1 }).itcount());
+assert(t.validate(true).valid);
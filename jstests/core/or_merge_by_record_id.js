@@ -0,0 +1,60 @@
+// An $or of point index scans merges its branches by RecordId, and returns each matching
+// document once, as an $or read branch by branch does.
+
+var t = db.jstests_or_merge_by_record_id;
+t.drop();
+
+t.ensureIndex({ a: 1 });
+t.ensureIndex({ b: 1 });
+for (var i = 0; i < 300; i++) {
+    t.insert({ _id: i, a: i % 3, b: i % 5 });
+}
+
+var query = { $or: [ { a: 0 }, { b: 0 }, { a: 0, b: 0 } ] };
+var expected = t.find(query).hint({ $natural: 1 }).itcount();
+assert.eq(100 + 60 - 20, expected);
+
+function orStage(explain) {
+    var stage = explain.queryPlanner.winningPlan;
+    while (stage && stage.stage != "OR") {
+        stage = stage.inputStage;
+    }
+    return stage;
+}
+
+var explain = t.find(query).explain("executionStats");
+var or = orStage(explain);
+if (or) {
+    assert(or.mergeByRecordId, tojson(or));
+    assert.eq(expected, explain.executionStats.nReturned, tojson(explain));
+}
+
+// Removing documents the merge has not reached yet between getMores.
+var cursor = t.find(query).batchSize(5);
+var seen = {};
+for (var j = 0; j < 5; j++) {
+    seen[cursor.next()._id] = true;
+}
+t.remove({ _id: { $gte: 150 } });
+var count = 5;
+while (cursor.hasNext()) {
+    var doc = cursor.next();
+    assert(!seen[doc._id], "returned twice: " + tojson(doc));
+    seen[doc._id] = true;
+    count++;
+}
+// Results the merge had already read ahead from each branch may still be returned.
+var remaining = t.find(query).hint({ $natural: 1 }).itcount();
+assert.gte(count, remaining);
+assert.lte(count, remaining + query.$or.length);
+
+// The same documents come back without the merge.
+assert.commandWorked(db.adminCommand({ setParameter: 1,
+                                       internalQueryPlannerEnableOrMergeByRecordId: false }));
+try {
+    assert.eq(t.find(query).hint({ $natural: 1 }).itcount(), t.find(query).itcount());
+}
+finally {
+    assert.commandWorked(db.adminCommand({ setParameter: 1,
+                                           internalQueryPlannerEnableOrMergeByRecordId: true }));
+}
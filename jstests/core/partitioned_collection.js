@@ -0,0 +1,48 @@
+// A collection partitioned by date keeps each hour apart, so that whole hours can be dropped.
+
+var coll = db.jstests_partitioned_collection;
+coll.drop();
+
+var hour = 3600 * 1000;
+var res = db.runCommand({ create: coll.getName(), partitionKey: "ts", partitionSpanSecs: 3600 });
+if (db.serverStatus().storageEngine.name == "mmapv1") {
+    assert.commandFailed(res);
+}
+else {
+    assert.commandWorked(res);
+    assert.commandFailed(db.runCommand({ create: coll.getName() + "_bad", partitionKey: "ts" }));
+
+    for (var h = 0; h < 3; h++) {
+        assert.commandWorked(coll.runCommand("collMod", { addPartition: new Date(h * hour) }));
+    }
+    coll.ensureIndex({ a: 1 });
+
+    for (var i = 0; i < 30; i++) {
+        coll.insert({ _id: i, a: i % 7, ts: new Date((i % 4) * hour + i) });
+    }
+    coll.insert({ _id: 100, a: 0 });
+    assert.eq(31, coll.count());
+    assert.eq(5, coll.find({ a: 0 }).hint({ a: 1 }).itcount());
+
+    // Index scans come back in key order across partitions.
+    var last = -1;
+    coll.find().sort({ a: 1 }).hint({ a: 1 }).forEach(function(doc) {
+        assert.lte(last, doc.a);
+        last = doc.a;
+    });
+
+    // Updates move documents between partitions.
+    coll.update({ _id: 0 }, { $set: { ts: new Date(2 * hour) } });
+    assert.eq(2 * hour, coll.findOne({ _id: 0 }).ts.getTime());
+
+    // Dropping the first two hours removes their documents. Those of later hours stay, in a
+    // partition of their own or in the default one like the fourth hour's.
+    res = coll.runCommand("collMod", { dropPartitionsBefore: new Date(2 * hour) });
+    assert.commandWorked(res);
+    assert.eq(2, res.partitionsDropped);
+    assert.eq(0, coll.find({ ts: { $lt: new Date(2 * hour) } }).itcount());
+    assert.eq(coll.find({ ts: { $gte: new Date(2 * hour) } }).itcount() + 1, coll.count());
+    assert.eq(coll.count(), coll.find().hint({ a: 1 }).itcount());
+    assert(coll.validate(true).valid);
+}
+coll.drop();
@@ -0,0 +1,53 @@
+// The queryShapeStats command totals queries by shape.
+
+var coll = db.query_shape_stats;
+coll.drop();
+coll.ensureIndex({ a: 1 });
+for (var i = 0; i < 100; i++) {
+    assert.writeOK(coll.insert({ _id: i, a: i, b: i % 10 }));
+}
+
+function shapesOf(res) {
+    return res.shapes.filter(function(shape) { return shape.ns == coll.getFullName(); });
+}
+
+// Start from nothing.
+assert.commandWorked(db.adminCommand({ queryShapeStats: 1, limit: 0, clear: true }));
+
+// Three queries of one shape, with different values, and two of another.
+for (i = 0; i < 3; i++) {
+    assert.eq(1, coll.find({ a: i }).itcount());
+}
+for (i = 0; i < 2; i++) {
+    assert.eq(10, coll.find({ b: i }).itcount());
+}
+
+var res = assert.commandWorked(db.adminCommand({ queryShapeStats: 1, sortBy: "count",
+                                                 ns: coll.getFullName() }));
+var shapes = shapesOf(res);
+assert.eq(2, shapes.length, tojson(res));
+
+var byIndex = shapes[0];
+assert.eq(3, byIndex.count, tojson(byIndex));
+assert.eq({ a: 0 }, byIndex.query);
+assert.eq(3, byIndex.nreturned);
+assert.gte(byIndex.totalMicros, byIndex.maxMicros);
+assert(/IXSCAN/.test(byIndex.planSummary), tojson(byIndex));
+var histogramCount = 0;
+byIndex.latencyHistogram.forEach(function(bucket) { histogramCount += bucket.count; });
+assert.eq(3, histogramCount);
+
+var byScan = shapes[1];
+assert.eq(2, byScan.count);
+assert.eq(200, byScan.docsExamined);
+
+// The collection scan examined more documents.
+res = assert.commandWorked(db.adminCommand({ queryShapeStats: 1, sortBy: "docsExamined",
+                                             limit: 1, ns: coll.getFullName() }));
+assert.eq(1, res.shapes.length);
+assert.eq({ b: 0 }, res.shapes[0].query);
+
+assert.commandFailed(db.adminCommand({ queryShapeStats: 1, sortBy: "nonsense" }));
+assert.commandFailed(db.runCommand({ queryShapeStats: 1 }));
+
+coll.drop();
@@ -0,0 +1,55 @@
+// Queries and aggregations with snapshotRead see the collection as it was when they started,
+// through every getMore, however it is written meanwhile.
+
+var t = db.jstests_snapshot_read;
+t.drop();
+
+for (var i = 0; i < 100; i++) {
+    t.insert({ _id: i, a: i });
+}
+t.ensureIndex({ a: 1 });
+
+var engine = db.serverStatus().storageEngine.name;
+if (engine != "wiredTiger" && engine != "rocksdb") {
+    // Other engines have no snapshots to keep.
+    assert.throws(function() {
+        t.find()._addSpecial("$snapshotRead", true).itcount();
+    });
+    assert.commandFailed(db.runCommand({ aggregate: t.getName(), pipeline: [ { $match: {} } ],
+                                         cursor: {}, snapshotRead: true }));
+}
+else {
+    // Moving documents ahead of an index scan doesn't make it return them twice, and documents
+    // inserted or removed after it started don't change what it returns.
+    var cursor = t.find({ a: { $gte: 0 } }).hint({ a: 1 })._addSpecial("$snapshotRead", true)
+                  .batchSize(10);
+    var seen = {};
+    for (var j = 0; j < 10; j++) {
+        seen[cursor.next()._id] = true;
+    }
+    for (var k = 0; k < 10; k++) {
+        t.update({ _id: k }, { $set: { a: 1000 + k } });
+    }
+    t.remove({ _id: { $gte: 90 } });
+    t.insert({ _id: 100, a: 50 });
+    var count = 10;
+    while (cursor.hasNext()) {
+        var doc = cursor.next();
+        assert(!seen[doc._id], "returned twice: " + tojson(doc));
+        assert.lt(doc._id, 100, tojson(doc));
+        seen[doc._id] = true;
+        count++;
+    }
+    assert.eq(100, count);
+
+    var res = db.runCommand({ aggregate: t.getName(), pipeline: [ { $match: {} } ],
+                              cursor: { batchSize: 10 }, snapshotRead: true });
+    assert.commandWorked(res);
+    var aggCursor = new DBCommandCursor(db.getMongo(), res, 10);
+    t.remove({});
+    assert.eq(91, aggCursor.itcount());
+
+    assert.commandFailed(db.runCommand({ aggregate: t.getName(),
+                                         pipeline: [ { $out: "jstests_snapshot_read_out" } ],
+                                         snapshotRead: true }));
+}
@@ -0,0 +1,65 @@
+// Updates only regenerate the keys of indexes over the fields they modify; check that every index
+// still finds the updated documents.
+
+var t = db.jstests_update_index_keys;
+t.drop();
+
+t.ensureIndex({ a: 1 });
+t.ensureIndex({ b: 1 });
+t.ensureIndex({ "c.d": 1, e: 1 });
+t.ensureIndex({ f: 1 });
+
+t.insert({ _id: 0, a: 1, b: 1, c: { d: 1 }, e: 1, f: [ 1, 2 ] });
+
+function assertFound(query, index) {
+    assert.eq(1, t.find(query).hint(index).itcount(), tojson(query) + " " + tojson(index));
+}
+
+function assertNotFound(query, index) {
+    assert.eq(0, t.find(query).hint(index).itcount(), tojson(query) + " " + tojson(index));
+}
+
+// Modifiers which touch a single indexed field.
+t.update({ _id: 0 }, { $set: { a: 2 }, $inc: { g: 1 } });
+assertFound({ a: 2 }, { a: 1 });
+assertNotFound({ a: 1 }, { a: 1 });
+assertFound({ b: 1 }, { b: 1 });
+
+// A parent of an indexed path.
+t.update({ _id: 0 }, { $set: { c: { d: 2 } } });
+assertFound({ "c.d": 2, e: 1 }, { "c.d": 1, e: 1 });
+assertNotFound({ "c.d": 1 }, { "c.d": 1, e: 1 });
+
+// A second field of a compound index.
+t.update({ _id: 0 }, { $unset: { e: 1 } });
+assertFound({ "c.d": 2, e: null }, { "c.d": 1, e: 1 });
+
+// Array modifiers on a multikey index.
+t.update({ _id: 0 }, { $push: { f: 3 } });
+assertFound({ f: 3 }, { f: 1 });
+t.update({ _id: 0 }, { $pull: { f: 1 } });
+assertNotFound({ f: 1 }, { f: 1 });
+t.update({ f: 2 }, { $set: { "f.$": 5 } });
+assertFound({ f: 5 }, { f: 1 });
+assertNotFound({ f: 2 }, { f: 1 });
+
+// Renames touch both the source and the target.
+t.update({ _id: 0 }, { $rename: { b: "a" } });
+assertFound({ a: 1 }, { a: 1 });
+assertNotFound({ b: 1 }, { b: 1 });
+
+// Growing the document may move it, which reindexes it everywhere.
+var big = new Array(10 * 1024).toString();
+t.update({ _id: 0 }, { $set: { g: big, b: 3 } });
+assertFound({ a: 1 }, { a: 1 });
+assertFound({ b: 3 }, { b: 1 });
+assertFound({ f: 5 }, { f: 1 });
+
+// A replacement regenerates the keys of every index.
+t.update({ _id: 0 }, { a: 4, f: 6 });
+assertFound({ a: 4 }, { a: 1 });
+assertFound({ f: 6 }, { f: 1 });
+assertNotFound({ b: 3 }, { b: 1 });
+assertNotFound({ "c.d": 2 }, { "c.d": 1, e: 1 });
+
+assert(t.validate().valid);
@@ -0,0 +1,33 @@
+// Data files are preallocated further ahead while new ones are needed in quick succession.
+
+var baseName = "jstests_preallocate_ahead";
+var dbpath = MongoRunner.dataPath + baseName;
+
+var m = MongoRunner.runMongod({ dbpath: dbpath,
+                                smallfiles: "",
+                                setParameter: "mmapv1PreallocateFilesAhead=3" });
+var testDB = m.getDB(baseName);
+
+if (testDB.serverStatus().storageEngine.name == "mmapv1") {
+    var numDataFiles = function() {
+        return listFiles(dbpath).filter(function(f) {
+            return new RegExp(baseName + "\\.\\d+$").test(f.name);
+        }).length;
+    };
+
+    // The first file gets only its successor preallocated.
+    testDB.createCollection(baseName);
+    assert.soon(function() { return numDataFiles() == 2; }, "expected one preallocated file");
+
+    // Filling the first file straight away moves on to the second, which is opened soon enough
+    // after the first to have three more requested behind it.
+    var big = new Array(1024 * 1024).join("x");
+    for (var i = 0; i < 20; i++) {
+        assert.writeOK(testDB[baseName].insert({ big: big }));
+    }
+    assert.lt(1, testDB.stats().numExtents);
+    assert.soon(function() { return numDataFiles() >= 5; },
+                "expected three files preallocated ahead, found " + numDataFiles());
+}
+
+MongoRunner.stopMongod(m);
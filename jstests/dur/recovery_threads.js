@@ -0,0 +1,57 @@
+// Journal recovery writes the same data files whether it applies sections one at a time or
+// parses ahead and applies writes to several files in parallel (journalRecoveryThreads).
+
+var testname = "recovery_threads";
+var path = MongoRunner.dataPath + testname;
+var serialPath = path + "_serial";
+var parallelPath = path + "_parallel";
+var numDBs = 4;
+
+var conn = startMongodEmpty("--port", 30001, "--dbpath", path, "--dur", "--smallfiles",
+                            "--durOptions", 8);
+for (var i = 0; i < numDBs; i++) {
+    var d = conn.getDB(testname + i);
+    for (var j = 0; j < 200; j++) {
+        d.foo.insert({ _id: j, x: new Array(j + 1).join("x") });
+    }
+    d.foo.ensureIndex({ x: 1 });
+    d.foo.update({}, { $set: { y: i } }, { multi: true });
+    d.foo.remove({ _id: { $lt: 50 } });
+}
+d = conn.getDB("dropped");
+d.foo.insert({ _id: 1 });
+d.dropDatabase();
+
+// assure writes are journaled before the kill
+assert.writeOK(conn.getDB(testname + "0").foo.insert({ _id: "last" },
+                                                     { writeConcern: { j: true } }));
+stopMongod(30001, /*signal*/9);
+
+// replay every section rather than only those after the last data file sync
+removeFile(path + "/lsn");
+
+copyDbpath(path, serialPath);
+copyDbpath(path, parallelPath);
+
+// --durOptions 4 stops mongod once recovery is done
+runMongoProgram("mongod", "--port", 30002, "--dbpath", serialPath, "--dur", "--smallfiles",
+                "--durOptions", 4, "--setParameter", "journalRecoveryThreads=1");
+runMongoProgram("mongod", "--port", 30003, "--dbpath", parallelPath, "--dur", "--smallfiles",
+                "--durOptions", 4, "--setParameter", "journalRecoveryThreads=8");
+
+for (var i = 0; i < numDBs; i++) {
+    [".ns", ".0"].forEach(function(suffix) {
+        var file = "/" + testname + i + suffix;
+        assert.eq(md5sumFile(serialPath + file), md5sumFile(parallelPath + file), file);
+    });
+}
+
+conn = startMongodNoReset("--port", 30004, "--dbpath", parallelPath, "--dur", "--smallfiles");
+for (var i = 0; i < numDBs; i++) {
+    var foo = conn.getDB(testname + i).foo;
+    assert.eq(i == 0 ? 151 : 150, foo.count(), foo.getFullName());
+    assert.eq(150, foo.find({ y: i }).hint({ x: 1 }).itcount(), foo.getFullName());
+}
+stopMongod(30004);
+
+print(testname + " SUCCESS");
@@ -0,0 +1,276 @@
+// A suite of named benchRun() workloads, for comparing the throughput and latency of builds.
+//
+// From the mongo shell, against the server or mongos to measure:
+//
+//     load("jstests/libs/bench_workloads.js");
+//     runBenchWorkloads();                           // every workload, with the defaults
+//     runBenchWorkloads(["ycsbA", "ycsbC"], { seconds: 30, parallel: 16 });
+//
+// runBenchWorkloads() prints one line of JSON per workload, prefixed with "BENCH_RESULT: ", and
+// returns the results.  Each result holds the options it ran with, the server version and the
+// benchRun() result, whose "latency" field has the count, average, min, max and p50/p95/p99/p999
+// latencies of each type of operation.  With the statsIntervalSeconds option "intervals" also
+// lists the latencies of each interval of the run.
+//
+// Options, all optional:
+//     host, db, username, password -- where to run, as for benchRun()
+//     parallel              -- number of client threads, default 8
+//     seconds               -- length of each run, default 10
+//     statsIntervalSeconds  -- length of the reported intervals, default 1; 0 reports none
+//     records               -- size of the collection loaded before the YCSB style workloads,
+//                              default 10000
+//
+// The YCSB workloads follow the core workloads of the Yahoo! Cloud Serving Benchmark.  Every
+// benchRun() thread repeats the ops of a workload in order, so their proportions come from
+// repeating ops, and keys are uniformly rather than zipfian distributed.
+
+var BenchWorkloads = (function() {
+    "use strict";
+
+    var kFieldLength = 100;
+
+    function randomKey(opts) {
+        return { "#RAND_INT": [ 0, opts.records ] };
+    }
+
+    function randomString() {
+        return { "#RAND_STRING": [ kFieldLength ] };
+    }
+
+    function repeat(op, times) {
+        var ops = [];
+        for (var i = 0; i < times; i++) {
+            ops.push(op);
+        }
+        return ops;
+    }
+
+    // Loads 'records' documents { _id: <0 to records - 1>, field0: <string>, ..., field9 }.
+    function loadRecords(coll, opts) {
+        var bulk = coll.initializeUnorderedBulkOp();
+        for (var i = 0; i < opts.records; i++) {
+            var doc = { _id: i };
+            for (var f = 0; f < 10; f++) {
+                doc["field" + f] = new Array(kFieldLength + 1).join(String.fromCharCode(97 + f));
+            }
+            bulk.insert(doc);
+        }
+        assert.writeOK(bulk.execute());
+    }
+
+    function read(ns, opts) {
+        return { op: "findOne", ns: ns, query: { _id: randomKey(opts) } };
+    }
+
+    function update(ns, opts) {
+        return { op: "update", ns: ns, writeCmd: true,
+                 query: { _id: randomKey(opts) },
+                 update: { $set: { field0: randomString() } } };
+    }
+
+    function insert(ns) {
+        return { op: "insert", ns: ns, writeCmd: true,
+                 doc: { _id: { "#OID": 1 }, field0: randomString() } };
+    }
+
+    return {
+        ycsbA: {
+            description: "update heavy: 50% reads, 50% updates",
+            setup: loadRecords,
+            ops: function(ns, opts) {
+                return [ read(ns, opts), update(ns, opts) ];
+            }
+        },
+
+        ycsbB: {
+            description: "read mostly: 95% reads, 5% updates",
+            setup: loadRecords,
+            ops: function(ns, opts) {
+                return repeat(read(ns, opts), 19).concat([ update(ns, opts) ]);
+            }
+        },
+
+        ycsbC: {
+            description: "read only",
+            setup: loadRecords,
+            ops: function(ns, opts) {
+                return [ read(ns, opts) ];
+            }
+        },
+
+        ycsbD: {
+            description: "read latest: 95% reads of the newest document, 5% inserts",
+            setup: loadRecords,
+            ops: function(ns, opts) {
+                // ObjectIds sort after the numeric _ids of the loaded records.
+                var readLatest = { op: "find", ns: ns, limit: 1,
+                                   query: { $query: {}, $orderby: { _id: -1 } } };
+                return repeat(readLatest, 19).concat([ insert(ns) ]);
+            }
+        },
+
+        ycsbE: {
+            description: "short ranges: 95% scans of up to 100 documents, 5% inserts",
+            setup: loadRecords,
+            ops: function(ns, opts) {
+                var scan = { op: "find", ns: ns, limit: 100,
+                             query: { $query: { _id: { $gte: randomKey(opts) } },
+                                      $orderby: { _id: 1 } } };
+                return repeat(scan, 19).concat([ insert(ns) ]);
+            }
+        },
+
+        ycsbF: {
+            description: "read-modify-write: read a document, then update it",
+            setup: loadRecords,
+            ops: function(ns, opts) {
+                return [
+                    { op: "let", target: "key", value: randomKey(opts) },
+                    { op: "findOne", ns: ns, query: { _id: { "#VARIABLE": "key" } } },
+                    { op: "update", ns: ns, writeCmd: true,
+                      query: { _id: { "#VARIABLE": "key" } },
+                      update: { $set: { field0: randomString() } } }
+                ];
+            }
+        },
+
+        insertHeavy: {
+            description: "inserts of new documents into a collection with only the _id index",
+            setup: function(coll, opts) { },
+            ops: function(ns, opts) {
+                return [ { op: "insert", ns: ns, writeCmd: true,
+                           doc: { _id: { "#OID": 1 }, a: { "#RAND_INT": [ 0, 1000000 ] },
+                                  s: randomString() } } ];
+            }
+        },
+
+        indexHeavy: {
+            description: "inserts and updates of documents with five secondary indexes",
+            setup: function(coll, opts) {
+                loadRecords(coll, opts);
+                for (var i = 1; i <= 5; i++) {
+                    var key = {};
+                    key["i" + i] = 1;
+                    coll.ensureIndex(key);
+                }
+            },
+            ops: function(ns, opts) {
+                var doc = { _id: { "#OID": 1 } };
+                var set = {};
+                for (var i = 1; i <= 5; i++) {
+                    doc["i" + i] = { "#RAND_INT": [ 0, 1000000 ] };
+                    set["i" + i] = { "#RAND_INT": [ 0, 1000000 ] };
+                }
+                return [
+                    { op: "insert", ns: ns, writeCmd: true, doc: doc },
+                    { op: "update", ns: ns, writeCmd: true,
+                      query: { _id: randomKey(opts) }, update: { $set: set } }
+                ];
+            }
+        },
+
+        aggregation: {
+            description: "$match, $group and $sort over about a tenth of the records",
+            setup: function(coll, opts) {
+                var bulk = coll.initializeUnorderedBulkOp();
+                for (var i = 0; i < opts.records; i++) {
+                    bulk.insert({ _id: i, a: i % 10, g: i % 100, x: i });
+                }
+                assert.writeOK(bulk.execute());
+                coll.ensureIndex({ a: 1 });
+            },
+            ops: function(ns, opts) {
+                var collName = ns.substring(ns.indexOf(".") + 1);
+                return [ { op: "command", ns: ns.substring(0, ns.indexOf(".")),
+                           command: { aggregate: collName,
+                                      pipeline: [ { $match: { a: 3 } },
+                                                  { $group: { _id: "$g",
+                                                              total: { $sum: "$x" } } },
+                                                  { $sort: { total: -1 } } ] } } ];
+            }
+        },
+
+        scatterGather: {
+            description: "against mongos, queries on a field other than the shard key, which " +
+                         "every shard must answer",
+            setup: function(coll, opts) {
+                if (coll.getDB().isMaster().msg == "isdbgrid") {
+                    var admin = coll.getDB().getSiblingDB("admin");
+                    admin.runCommand({ enableSharding: coll.getDB().getName() });
+                    assert.commandWorked(admin.runCommand({ shardCollection: coll.getFullName(),
+                                                            key: { _id: "hashed" } }));
+                }
+                var bulk = coll.initializeUnorderedBulkOp();
+                for (var i = 0; i < opts.records; i++) {
+                    bulk.insert({ _id: i, a: i % 1000 });
+                }
+                assert.writeOK(bulk.execute());
+                coll.ensureIndex({ a: 1 });
+            },
+            ops: function(ns, opts) {
+                return [ { op: "find", ns: ns, query: { a: { "#RAND_INT": [ 0, 1000 ] } } } ];
+            }
+        }
+    };
+})();
+
+// Replaces NumberLongs in 'obj' by Numbers, so that JSON.stringify() writes them as numbers.
+function _benchPlainNumbers(obj) {
+    if (obj instanceof NumberLong) {
+        return obj.toNumber();
+    }
+    if (obj === null || typeof obj != "object") {
+        return obj;
+    }
+    var out = Array.isArray(obj) ? [] : {};
+    for (var key in obj) {
+        if (obj.hasOwnProperty(key)) {
+            out[key] = _benchPlainNumbers(obj[key]);
+        }
+    }
+    return out;
+}
+
+/**
+ * Loads the collection for workload 'name' of BenchWorkloads, runs it with benchRun() and
+ * returns { workload, options, version, results }.  See the top of this file for 'options'.
+ */
+function runBenchWorkload(name, options) {
+    var workload = BenchWorkloads[name];
+    assert(workload, "no benchRun workload named " + name);
+
+    var opts = Object.extend({ host: db.getMongo().host, db: db.getName(), parallel: 8,
+                               seconds: 10, statsIntervalSeconds: 1, records: 10000 },
+                             options || {});
+
+    var testDB = db.getSiblingDB(opts.db);
+    var coll = testDB.getCollection("bench_" + name);
+    coll.drop();
+    workload.setup(coll, opts);
+
+    var args = { ops: workload.ops(coll.getFullName(), opts), host: opts.host,
+                 parallel: opts.parallel, seconds: opts.seconds,
+                 statsIntervalSeconds: opts.statsIntervalSeconds };
+    if (opts.username) {
+        args.db = "admin";
+        args.username = opts.username;
+        args.password = opts.password;
+    }
+
+    return { workload: name, options: opts, version: testDB.version(), results: benchRun(args) };
+}
+
+/**
+ * Runs each workload named in 'names', or every workload by default, printing one line of
+ * "BENCH_RESULT: <JSON>" per workload.  Returns the results as an array.
+ */
+function runBenchWorkloads(names, options) {
+    names = names || Object.keySet(BenchWorkloads);
+    var results = [];
+    for (var i = 0; i < names.length; i++) {
+        var result = runBenchWorkload(names[i], options);
+        print("BENCH_RESULT: " + JSON.stringify(_benchPlainNumbers(result)));
+        results.push(result);
+    }
+    return results;
+}
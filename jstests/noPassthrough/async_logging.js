@@ -0,0 +1,62 @@
+/**
+ * Tests that with asyncLogWrites the log file still gets every message up to the exit, whether
+ * the server shuts down cleanly or crashes.
+ */
+
+(function () {
+    "use strict";
+
+    var logFileName = MongoRunner.dataPath + "async_logging.log";
+
+    function runAndShutDown(overflowPolicy, shutdownFn) {
+        var conn = MongoRunner.runMongod({
+            nojournal: "",
+            logpath: logFileName,
+            setParameter: { asyncLogWrites: true, asyncLogOverflowPolicy: overflowPolicy }
+        });
+        assert.neq(null, conn, "mongod failed to start with asyncLogWrites");
+        var admin = conn.getDB("admin");
+        try {
+            // Server side print() goes to the javascriptOutput log domain.
+            conn.getDB("test").eval("print('async hello')");
+            shutdownFn(admin);
+        }
+        finally {
+            MongoRunner.stopMongod(conn);
+        }
+        return cat(logFileName);
+    }
+
+    function assertLogMatches(text, pattern) {
+        if (!pattern.test(text)) {
+            print("--- LOG CONTENTS ---");
+            print(text);
+            print("--- END LOG CONTENTS ---");
+            doassert("Log contents did not match " + pattern);
+        }
+    }
+
+    var cleanShutdown = function (admin) { admin.shutdownServer(); };
+    assertLogMatches(runAndShutDown("block", cleanShutdown),
+                     /async hello[\s\S]*shutdown command received[\s\S]*dbexit:/);
+    assertLogMatches(runAndShutDown("drop", cleanShutdown),
+                     /async hello[\s\S]*dbexit:/);
+
+    if (!_isWindows() && !_isAddressSanitizerActive()) {
+        var crash = function (admin) {
+            assert.commandWorked(admin.runCommand({ configureFailPoint: "crashOnShutdown",
+                                                    mode: "alwaysOn",
+                                                    data: { how: "abort" } }));
+            admin.shutdownServer();
+        };
+        assertLogMatches(runAndShutDown("block", crash), /Got signal[\s\S]*printStackTrace/);
+    }
+
+    // An unknown overflow policy stops the server from starting.
+    var conn = MongoRunner.runMongod({
+        nojournal: "",
+        logpath: logFileName,
+        setParameter: { asyncLogWrites: true, asyncLogOverflowPolicy: "sometimes" }
+    });
+    assert.eq(null, conn, "mongod started with an invalid asyncLogOverflowPolicy");
+})();
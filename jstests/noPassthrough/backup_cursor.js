@@ -0,0 +1,49 @@
+// beginBackup lists the data files while writes continue, and a backup taken incrementally from
+// an earlier one skips the files which did not change.
+
+var baseName = "jstests_backup_cursor";
+var conn = MongoRunner.runMongod({ dbpath: MongoRunner.dataPath + baseName });
+var admin = conn.getDB("admin");
+var t = conn.getDB("test")[baseName];
+
+var engine = admin.serverStatus().storageEngine.name;
+if (engine == "mmapv1" || engine == "inMemoryExperiment") {
+    // These engines fall back to fsync+lock.
+    assert.commandFailedWithCode(admin.runCommand({ beginBackup: 1 }),
+                                 ErrorCodes.CommandNotSupported);
+}
+else {
+    for (var i = 0; i < 1000; i++) {
+        t.insert({ _id: i, x: "abcdefghijklmnopqrstuvwxyz" });
+    }
+
+    var full = assert.commandWorked(admin.runCommand({ beginBackup: 1 }));
+    assert.gt(full.files.length, 0, tojson(full));
+    full.files.forEach(function(file) {
+        assert.eq(0, file.offset, tojson(file));
+        assert.eq(file.fileSize, file.length, tojson(file));
+    });
+
+    // Only one backup can be open, and writes are not blocked by it.
+    assert.commandFailed(admin.runCommand({ beginBackup: 1 }));
+    t.insert({ _id: 1000 });
+    assert.eq(1001, t.count());
+    assert.commandWorked(admin.runCommand({ endBackup: full.backupId }));
+    assert.commandFailed(admin.runCommand({ endBackup: full.backupId }));
+
+    sleep(2000);
+    var incr = assert.commandWorked(admin.runCommand({ beginBackup: 1,
+                                                      incrementalFrom: full.backupId }));
+    assert.eq(full.backupId, incr.incrementalFrom);
+    incr.files.forEach(function(file) {
+        assert.lte(file.offset + file.length, file.fileSize, tojson(file));
+    });
+    assert.commandWorked(admin.runCommand({ endBackup: incr.backupId, abandon: true }));
+
+    // An abandoned backup cannot be the base of another.
+    assert.commandFailedWithCode(admin.runCommand({ beginBackup: 1,
+                                                    incrementalFrom: incr.backupId }),
+                                 ErrorCodes.NoSuchKey);
+}
+
+MongoRunner.stopMongod(conn);
@@ -0,0 +1,46 @@
+// mongobridge --record captures the traffic it forwards, and mongoreplay drives the capture
+// against another server, following cursors from their recorded ids to the target's own ones.
+
+var baseName = "jstests_bridge_record_replay";
+var trafficFile = MongoRunner.dataPath + baseName + ".traffic";
+
+var source = MongoRunner.runMongod({});
+var target = MongoRunner.runMongod({});
+
+var bridgePort = allocatePorts(1, source.port + 100)[0];
+startMongoProgram("mongobridge", "--port", bridgePort, "--dest", source.host,
+                  "--record", trafficFile);
+
+var bridged;
+assert.soon(function() {
+    try {
+        bridged = new Mongo("127.0.0.1:" + bridgePort);
+        return true;
+    }
+    catch (e) {
+        return false;
+    }
+}, "couldn't connect to mongobridge");
+
+var t = bridged.getDB("test")[baseName];
+t.drop();
+for (var i = 0; i < 200; i++) {
+    assert.writeOK(t.insert({ _id: i, a: i % 10 }));
+}
+assert.writeOK(t.update({ a: 3 }, { $set: { b: 1 } }, { multi: true }));
+
+// A small batch size makes the query continue with getMores on its recorded cursor id.
+assert.eq(200, t.find().batchSize(10).itcount());
+
+// SIGTERM lets the bridge flush the recording.
+stopMongoProgram(bridgePort, 15);
+
+assert.eq(0, runMongoProgram("mongoreplay", "--file", trafficFile,
+                             "--host", target.host, "--speed", 10));
+
+var replayed = target.getDB("test")[baseName];
+assert.eq(200, replayed.count());
+assert.eq(20, replayed.count({ b: 1 }));
+
+MongoRunner.stopMongod(source);
+MongoRunner.stopMongod(target);
@@ -0,0 +1,60 @@
+// A foreground index build periodically saves the keys it has so far and how far its collection
+// scan has got. When the server is killed in the middle of the build, it goes on from the last
+// checkpoint at startup instead of from the beginning.
+
+var baseName = "jstests_index_build_checkpoint";
+var dbpath = MongoRunner.dataPath + baseName;
+var size = 50 * 1000;
+
+function logContains(conn, regex) {
+    var log = conn.getDB("admin").runCommand({ getLog: "global" }).log;
+    return log.some(function(line) { return regex.test(line); });
+}
+
+var conn = MongoRunner.runMongod({ dbpath: dbpath,
+                                   setParameter: "internalIndexBuildCheckpointPeriodMS=1" });
+
+if (conn.getDB("admin").serverStatus().storageEngine.name == "mmapv1") {
+    // The mmapv1 catalog has nowhere to keep checkpoints.
+    MongoRunner.stopMongod(conn);
+}
+else {
+    var t = conn.getDB("test")[baseName];
+    var bulk = t.initializeUnorderedBulkOp();
+    for (var i = 0; i < size; i++) {
+        bulk.insert({ _id: i, a: i % 100, b: [ i, -i ] });
+    }
+    assert.writeOK(bulk.execute());
+
+    assert.commandWorked(conn.getDB("admin").runCommand({
+        configureFailPoint: "hangAfterIndexBuildCheckpoint",
+        mode: "alwaysOn" }));
+
+    var join = startParallelShell(
+        "db.getSiblingDB('test')." + baseName + ".ensureIndex({ a: 1, b: 1 });", conn.port);
+
+    assert.soon(function() {
+        return logContains(conn, /hangAfterIndexBuildCheckpoint fail point enabled/);
+    }, "the index build did not save a checkpoint");
+
+    MongoRunner.stopMongod(conn.port, 9);
+    join();
+
+    conn = MongoRunner.runMongod({ dbpath: dbpath, noCleanData: true });
+    t = conn.getDB("test")[baseName];
+
+    assert(logContains(conn, new RegExp("resuming index build on test." + baseName)),
+           "the index build started over");
+    assert.eq(2, t.getIndexes().length, tojson(t.getIndexes()));
+    assert.eq(size, t.find({ a: { $gte: 0 } }).hint({ a: 1, b: 1 }).itcount());
+    assert.eq(1, t.find({ a: 7, b: -12307 }).hint({ a: 1, b: 1 }).itcount());
+    assert(t.validate(true).valid);
+
+    // The checkpoint is gone along with the build.
+    var leftovers = listFiles(dbpath).filter(function(file) {
+        return /_indexBuildCheckpoints$/.test(file.name) && listFiles(file.name).length > 0;
+    });
+    assert.eq(0, leftovers.length, tojson(leftovers));
+
+    MongoRunner.stopMongod(conn);
+}
@@ -0,0 +1,62 @@
+// A background build of a non-unique index keeps concurrent writes in a side table while it bulk
+// loads the index (on storage engines with document level locking). Whatever the engine, the
+// finished index must agree with a collection scan.
+
+load( "jstests/libs/slow_weekly_util.js" );
+
+var testServer = new SlowWeeklyMongod( "indexbg_side_writes" );
+var db = testServer.getDB( "test" );
+var t = db.jstests_indexbg_side_writes;
+t.drop();
+
+var size = 100 * 1000;
+var bulk = t.initializeUnorderedBulkOp();
+for ( var i = 0; i < size; ++i ) {
+    bulk.insert({ _id: i, a: i % 1000, b: [ i, -i ] });
+}
+assert.writeOK(bulk.execute());
+
+var join = startParallelShell(
+    "db.jstests_indexbg_side_writes.ensureIndex({ a: 1 }, { background: true });" +
+    "db.jstests_indexbg_side_writes.ensureIndex({ b: 1 }, { background: true });",
+    testServer.port);
+
+// Keep writing until both builds are done.
+var written = 0;
+var start = new Date();
+while ( t.getIndexes().length < 3 || db.currentOp({ "msg": /^Index Build/ }).inprog.length > 0 ) {
+    assert.lt(new Date() - start, 10 * 60 * 1000, "index builds did not finish");
+    var id = Random.randInt(size);
+    switch ( written % 4 ) {
+    case 0:
+        assert.writeOK(t.update({ _id: id }, { $set: { a: -1 } }));
+        break;
+    case 1:
+        assert.writeOK(t.remove({ _id: id }));
+        break;
+    case 2:
+        assert.writeOK(t.save({ _id: size + written, a: -2, b: [ -1, -2 ] }));
+        break;
+    case 3:
+        assert.writeOK(t.update({ _id: id }, { $push: { b: size } }));
+        break;
+    }
+    written++;
+}
+join();
+print("writes during the builds: " + written);
+
+function assertIndexMatchesScan(query, index) {
+    assert.eq(t.find(query).hint({ $natural: 1 }).itcount(), t.find(query).hint(index).itcount(),
+              tojson(query) + " " + tojson(index));
+}
+
+assertIndexMatchesScan({ a: -1 }, { a: 1 });
+assertIndexMatchesScan({ a: -2 }, { a: 1 });
+assertIndexMatchesScan({ a: { $gte: 0 } }, { a: 1 });
+assertIndexMatchesScan({ b: size }, { b: 1 });
+assertIndexMatchesScan({ b: -1 }, { b: 1 });
+assertIndexMatchesScan({ b: { $lt: 0 } }, { b: 1 });
+assert(t.validate(true).valid);
+
+testServer.stop();
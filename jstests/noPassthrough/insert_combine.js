@@ -0,0 +1,35 @@
+// With internalInsertCombineWindowMicros set, single-document inserts which clients issue into
+// the same collection at about the same time are written together, and each client still gets
+// the result of its own document.
+
+var conn = MongoRunner.runMongod({ setParameter: "internalInsertCombineWindowMicros=2000" });
+var t = conn.getDB("test").jstests_insert_combine;
+var numClients = 4;
+var perClient = 300;
+
+assert.writeOK(t.insert({ _id: "taken" }));
+
+function inserter(client, perClient) {
+    var coll = db.getSiblingDB("test").jstests_insert_combine;
+    for (var i = 0; i < perClient; i++) {
+        assert.writeOK(coll.insert({ _id: client * perClient + i }));
+        if (i % 50 == 0) {
+            var res = coll.insert({ _id: "taken" });
+            assert.writeError(res);
+            assert.eq(11000, res.getWriteError().code, tojson(res));
+        }
+    }
+}
+
+var joins = [];
+for (var c = 0; c < numClients; c++) {
+    joins.push(startParallelShell("(" + inserter.toString() + ")(" + c + ", " + perClient + ");",
+                                  conn.port));
+}
+joins.forEach(function(join) { join(); });
+
+assert.eq(numClients * perClient + 1, t.count());
+assert.gt(conn.getDB("admin").serverStatus().metrics.insert.combined, 0);
+assert(t.validate().valid);
+
+MongoRunner.stopMongod(conn);
@@ -0,0 +1,42 @@
+// A mongos using the event-driven connection executor waits for the replies to getMores on
+// unsharded collections without holding a thread, and still returns every document in order.
+
+var st = new ShardingTest({ shards: 1,
+                            mongos: 1,
+                            other: { mongosOptions:
+                                         { setParameter: "connectionExecutor=eventDriven" } } });
+var mongos = st.s0;
+var t = mongos.getDB("test").mongos_deferred_getmore;
+
+for (var i = 0; i < 200; i++) {
+    t.insert({ _id: i });
+}
+
+function waits() {
+    return mongos.getDB("admin").serverStatus().shardReplyWaiter.waits;
+}
+var before = waits();
+
+var cursor = t.find().sort({ _id: 1 }).batchSize(10);
+for (var j = 0; j < 200; j++) {
+    assert.eq(j, cursor.next()._id);
+}
+assert(!cursor.hasNext());
+
+// Several cursors at once, each on its own connection.
+var conns = [];
+var cursors = [];
+for (var k = 0; k < 5; k++) {
+    conns.push(new Mongo(mongos.host));
+    cursors.push(conns[k].getDB("test").mongos_deferred_getmore.find().batchSize(7));
+}
+for (var k = 0; k < 5; k++) {
+    assert.eq(200, cursors[k].itcount());
+}
+
+var status = mongos.getDB("admin").serverStatus().shardReplyWaiter;
+if (status.threads > 0) {
+    assert.gt(waits(), before, tojson(status));
+}
+
+st.stop();
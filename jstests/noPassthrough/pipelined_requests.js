@@ -0,0 +1,29 @@
+// Queries flagged as pipelined are answered by the event-driven connection executor, whether it
+// runs them out of order or not, and the connection goes on serving requests in order after them.
+
+var conn = MongoRunner.runMongod({ setParameter: { connectionExecutor: "eventDriven" } });
+var testDB = conn.getDB("test");
+var t = testDB.pipelined_requests;
+
+var options = testDB.runCommand({ availableQueryOptions: 1 }).options;
+assert.neq(0, options & DBQuery.Option.pipelined, options);
+
+for (var i = 0; i < 100; i++) {
+    t.insert({ _id: i });
+}
+
+function check() {
+    assert.eq(100, t.find().addOption(DBQuery.Option.pipelined).batchSize(10).itcount());
+    var res = testDB.$cmd.find({ count: t.getName() })
+                         .addOption(DBQuery.Option.pipelined).limit(-1).next();
+    assert.commandWorked(res);
+    assert.eq(100, res.n, tojson(res));
+    assert.eq(100, t.find().itcount());
+}
+
+check();
+assert.commandWorked(testDB.adminCommand({ setParameter: 1,
+                                           connectionExecutorMaxPipelinedRequests: 0 }));
+check();
+
+MongoRunner.stopMongod(conn);
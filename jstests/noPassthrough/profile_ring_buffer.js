@@ -0,0 +1,65 @@
+// Profiling into the in-memory ring buffer, read with the profileBuffer command, with sampling
+// and the asynchronous flush to system.profile.
+
+var conn = MongoRunner.runMongod({ setParameter: "profileRingBufferSize=8" });
+var testDB = conn.getDB("profile_ring_buffer");
+var coll = testDB.coll;
+assert.writeOK(coll.insert({ _id: 0 }));
+
+var res = testDB.setProfilingLevel(2);
+for (var i = 0; i < 5; i++) {
+    coll.findOne({ _id: i });
+}
+
+res = assert.commandWorked(testDB.runCommand({ profileBuffer: 1 }));
+assert.eq(8, res.capacity);
+var queries = res.entries.filter(function(entry) { return entry.op == "query"; });
+assert.eq(5, queries.length, tojson(res));
+assert.eq({ _id: 4 }, queries[4].query);
+
+// Nothing went to system.profile.
+assert.eq(0, testDB.system.profile.count());
+
+// Reading from nextSeq returns only the newer entries.
+coll.findOne({ _id: 100 });
+var next = assert.commandWorked(testDB.runCommand({ profileBuffer: 1, since: res.nextSeq }));
+assert.eq(1, next.entries.filter(function(entry) { return entry.op == "query"; }).length,
+          tojson(next));
+
+// Once the buffer wraps the oldest entries are gone.
+for (i = 0; i < 20; i++) {
+    coll.findOne({ _id: i });
+}
+res = assert.commandWorked(testDB.runCommand({ profileBuffer: 1 }));
+assert.eq(8, res.entries.length);
+assert.gt(res.overwritten, 0);
+
+// Entries are per database.
+res = assert.commandWorked(conn.getDB("other").runCommand({ profileBuffer: 1 }));
+assert.eq(0, res.entries.length);
+
+// With a sample rate of a tenth, about a tenth of the operations are profiled.
+assert.commandFailed(testDB.runCommand({ profile: 2, sampleRate: 0 }));
+assert.commandFailed(testDB.runCommand({ profile: 2, sampleRate: 2 }));
+res = assert.commandWorked(testDB.runCommand({ profile: 2, sampleRate: 0.1 }));
+assert.eq(1, res.sampleRate);
+assert.eq(0.1, testDB.runCommand({ profile: -1 }).sampleRate);
+
+var start = testDB.runCommand({ profileBuffer: 1 }).nextSeq;
+for (i = 0; i < 1000; i++) {
+    coll.findOne({ _id: i });
+}
+var sampled = testDB.runCommand({ profileBuffer: 1 }).nextSeq - start;
+assert.gt(sampled, 50);
+assert.lt(sampled, 200);
+assert.commandWorked(testDB.runCommand({ profile: 2, sampleRate: 1 }));
+
+// The flush copies new entries into system.profile.
+assert.commandWorked(conn.getDB("admin").runCommand({
+    setParameter: 1, profileRingBufferFlushIntervalMillis: 100 }));
+coll.findOne({ _id: "flushed" });
+assert.soon(function() {
+    return testDB.system.profile.count({ op: "query", "query._id": "flushed" }) == 1;
+}, "profile entry never flushed");
+
+MongoRunner.stopMongod(conn);
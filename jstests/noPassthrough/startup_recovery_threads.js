@@ -0,0 +1,34 @@
+// Databases are opened, and their collections and indexes found, when startupRecoveryThreads
+// opens them in parallel at startup.
+
+var baseName = "jstests_startup_recovery_threads";
+var dbpath = MongoRunner.dataPath + baseName;
+var numDBs = 20;
+
+var conn = MongoRunner.runMongod({ dbpath: dbpath });
+for (var i = 0; i < numDBs; i++) {
+    var testDB = conn.getDB(baseName + i);
+    for (var j = 0; j < 5; j++) {
+        assert.writeOK(testDB["c" + j].insert({ _id: j, x: i }));
+        assert.commandWorked(testDB["c" + j].ensureIndex({ x: 1 }));
+    }
+}
+MongoRunner.stopMongod(conn);
+
+conn = MongoRunner.runMongod({ dbpath: dbpath,
+                               noCleanData: true,
+                               setParameter: "startupRecoveryThreads=4" });
+assert.eq(4, conn.getDB("admin").runCommand({ getParameter: 1,
+                                               startupRecoveryThreads: 1 })
+                                 .startupRecoveryThreads);
+
+for (var i = 0; i < numDBs; i++) {
+    var testDB = conn.getDB(baseName + i);
+    for (var j = 0; j < 5; j++) {
+        var coll = testDB["c" + j];
+        assert.eq(1, coll.find({ x: i }).hint({ x: 1 }).itcount(), coll.getFullName());
+        assert.eq(2, coll.getIndexes().length, coll.getFullName());
+    }
+}
+
+MongoRunner.stopMongod(conn);
@@ -0,0 +1,34 @@
+// Operations on a database with a quota wait for their turn, and are counted in the
+// tenantScheduler section of serverStatus.
+
+var conn = MongoRunner.runMongod({ setParameter: "tenantSchedulerConcurrentOps=4" });
+var admin = conn.getDB("admin");
+
+assert.commandFailed(admin.runCommand({ setParameter: 1, tenantQuotas: { limited: 1 } }));
+assert.commandFailed(admin.runCommand({ setParameter: 1,
+                                        tenantQuotas: { limited: { weight: 0 } } }));
+assert.commandWorked(admin.runCommand({ setParameter: 1,
+                                        tenantQuotas: { limited: { maxOpsPerSec: 10 },
+                                                        favored: { weight: 4 } } }));
+var quotas = admin.runCommand({ getParameter: 1, tenantQuotas: 1 }).tenantQuotas;
+assert.eq(10, quotas.limited.maxOpsPerSec, tojson(quotas));
+
+var limited = conn.getDB("limited").tenant_quotas;
+var start = new Date();
+for (var i = 0; i < 30; i++) {
+    limited.insert({ _id: i });
+}
+assert.gte(new Date() - start, 1000, "the inserts were not throttled");
+assert.eq(30, limited.find().itcount());
+
+var favored = conn.getDB("favored").tenant_quotas;
+favored.insert({ _id: 0 });
+assert.eq(1, favored.find().itcount());
+
+var stats = admin.serverStatus().tenantScheduler;
+assert.eq(4, stats.concurrentOps, tojson(stats));
+assert.gt(stats.tenants.limited.throttled, 0, tojson(stats));
+assert.eq(4, stats.tenants.favored.weight, tojson(stats));
+assert.eq(undefined, stats.tenants.admin, tojson(stats));
+
+MongoRunner.stopMongod(conn);
@@ -0,0 +1,46 @@
+// mongod saves a sample of the documents it fetches to the dbpath, and reads them back into the
+// cache after a restart.
+
+var baseName = "jstests_warmup_working_set";
+var dbpath = MongoRunner.dataPath + baseName;
+
+function logContains(conn, regex) {
+    var log = conn.getDB("admin").runCommand({ getLog: "global" }).log;
+    return log.some(function(line) { return regex.test(line); });
+}
+
+function savedFile() {
+    return listFiles(dbpath).some(function(file) { return /warmup\.bson$/.test(file.name); });
+}
+
+var conn = MongoRunner.runMongod({ dbpath: dbpath,
+                                   setParameter: { warmupSaveIntervalSecs: 1,
+                                                   warmupSampleRate: 1 } });
+
+var engine = conn.getDB("admin").serverStatus().storageEngine.name;
+if (engine == "mmapv1" || engine == "inMemoryExperiment") {
+    // mmapv1 data stays in the page cache across restarts, and in memory data does not survive.
+    MongoRunner.stopMongod(conn);
+}
+else {
+    var t = conn.getDB("test")[baseName];
+    t.ensureIndex({ a: 1 });
+    for (var i = 0; i < 100; i++) {
+        t.insert({ _id: i, a: i });
+    }
+    for (var j = 0; j < 100; j++) {
+        assert.neq(null, t.findOne({ a: j }));
+    }
+
+    assert.soon(savedFile, "the working set was never saved");
+    MongoRunner.stopMongod(conn);
+
+    conn = MongoRunner.runMongod({ dbpath: dbpath, noCleanData: true });
+    assert.soon(function() {
+        return logContains(conn, /done warming the working set/);
+    }, "the working set was not warmed");
+    assert(logContains(conn, /warming [1-9][0-9]* documents of [1-9][0-9]* collections/),
+           "nothing was warmed");
+    assert.eq(100, conn.getDB("test")[baseName].find().itcount());
+    MongoRunner.stopMongod(conn);
+}
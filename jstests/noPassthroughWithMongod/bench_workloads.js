@@ -0,0 +1,15 @@
+// Runs each workload of jstests/libs/bench_workloads.js briefly, to keep the suite working.
+
+load("jstests/libs/bench_workloads.js");
+
+var results = runBenchWorkloads(null, { parallel: 2, seconds: 1, records: 200,
+                                        db: "bench_workloads" });
+
+assert.eq(Object.keySet(BenchWorkloads).length, results.length);
+results.forEach(function(result) {
+    assert.eq(0, result.results.errCount, tojson(result));
+    assert.neq(0, Object.keySet(result.results.latency).length, tojson(result));
+    assert(result.results.intervals, tojson(result));
+});
+
+db.getSiblingDB("bench_workloads").dropDatabase();
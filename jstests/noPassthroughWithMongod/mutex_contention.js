@@ -0,0 +1,48 @@
+// The mutexContention command reports the server's internal mutexes while profiling is on.
+
+var admin = db.getSiblingDB("admin");
+var coll = db.mutex_contention;
+coll.drop();
+
+assert.commandWorked(admin.runCommand({ setParameter: 1, mutexContentionProfiling: true }));
+try {
+    for (var i = 0; i < 100; i++) {
+        assert.writeOK(coll.insert({ _id: i }));
+        coll.findOne({ _id: i });
+    }
+
+    var res = assert.commandWorked(admin.runCommand({ mutexContention: 1, limit: 0 }));
+    assert.eq(true, res.enabled);
+    assert.gt(res.mutexes.length, 0, tojson(res));
+
+    var names = res.mutexes.map(function(m) { return m.name; });
+    assert(names.some(function(name) { return /^LockManager\./.test(name); }), tojson(names));
+
+    res.mutexes.forEach(function(m, j) {
+        assert.gte(m.acquisitions, m.contended, tojson(m));
+        assert.gte(m.waitMicros, m.maxWaitMicros, tojson(m));
+        assert.lte(m.callSites.length, 5);
+        if (j > 0) {
+            assert.gte(res.mutexes[j - 1].waitMicros, m.waitMicros);
+        }
+    });
+
+    res = assert.commandWorked(admin.runCommand({ mutexContention: 1, limit: 1, reset: true }));
+    assert.lte(res.mutexes.length, 1);
+
+    assert.commandFailed(admin.runCommand({ mutexContention: 1, limit: -1 }));
+}
+finally {
+    assert.commandWorked(admin.runCommand({ setParameter: 1, mutexContentionProfiling: false }));
+}
+
+// Nothing is counted while profiling is off.
+assert.commandWorked(admin.runCommand({ mutexContention: 1, reset: true }));
+for (i = 0; i < 10; i++) {
+    coll.findOne({ _id: i });
+}
+res = assert.commandWorked(admin.runCommand({ mutexContention: 1, limit: 0 }));
+assert.eq(false, res.enabled);
+assert.eq(0, res.mutexes.length, tojson(res));
+
+coll.drop();
@@ -0,0 +1,51 @@
+// The profileCpu command samples the server's stacks and returns them as folded stacks.
+
+var admin = db.getSiblingDB("admin");
+var coll = db.profile_cpu;
+coll.drop();
+for (var i = 0; i < 1000; i++) {
+    coll.insert({ _id: i, x: i });
+}
+
+assert.commandFailed(admin.runCommand({ profileCpu: "stop" }));
+assert.commandFailed(admin.runCommand({ profileCpu: "start", hz: 0 }));
+assert.commandFailed(admin.runCommand({ profileCpu: "start", hz: 100000 }));
+assert.commandFailed(admin.runCommand({ profileCpu: "nonsense" }));
+
+assert.commandWorked(admin.runCommand({ profileCpu: "start", hz: 1000 }));
+assert.eq(true, admin.runCommand({ profileCpu: "status" }).running);
+assert.commandFailed(admin.runCommand({ profileCpu: "start" }));
+
+// Keep the server busy with collection scans.
+var start = new Date();
+while (new Date() - start < 2000) {
+    coll.find({ x: { $gt: 500 }, y: { $exists: false } }).sort({ x: -1 }).itcount();
+}
+
+var res = assert.commandWorked(admin.runCommand({ profileCpu: "stop" }));
+assert.eq(false, admin.runCommand({ profileCpu: "status" }).running);
+
+assert.gt(res.samples, 0, tojson(res));
+assert.gte(res.durationMillis, 2000);
+assert.gt(res.folded.length, 0);
+
+var total = 0;
+var queries = 0;
+res.folded.forEach(function(line) {
+    var match = /^(.*) (\d+)$/.exec(line);
+    assert(match, "not a folded stack: " + line);
+    total += parseInt(match[2]);
+    if (match[1].indexOf("query;" + coll.getFullName() + ";") == 0) {
+        queries += parseInt(match[2]);
+    }
+});
+assert.eq(res.samples - res.dropped, total);
+assert.gt(queries, 0, tojson(res.folded.slice(0, 10)));
+
+assert.gt(res.topOps.length, 0);
+res.topOps.forEach(function(op) {
+    assert(op.hasOwnProperty("opid"));
+    assert.gt(op.samples, 0);
+});
+
+coll.drop();
@@ -0,0 +1,36 @@
+// The profiler and currentOp report where an operation's time went in "resources".
+
+var testDB = db.getSiblingDB("profile_resources");
+testDB.dropDatabase();
+var coll = testDB.coll;
+assert.writeOK(coll.insert({ _id: 1 }));
+
+testDB.setProfilingLevel(2);
+
+// Every operation uses some CPU.
+assert.eq(1, coll.find().itcount());
+var entry = testDB.system.profile.find({ op: "query", ns: coll.getFullName() })
+                                 .sort({ $natural: -1 }).limit(1).next();
+printjson(entry);
+assert(entry.resources, "no resources in profile entry");
+assert.gte(entry.resources.cpuMicros, 1);
+assert(!entry.resources.lockWaits, "unexpected lock wait");
+
+// A read behind a write lock waits for it.
+var awaitSleep = startParallelShell(
+    "db.adminCommand({ sleep: 1, w: true, secs: 3 });");
+assert.soon(function() {
+    return db.currentOp({ "query.sleep": 1 }).inprog.length > 0;
+}, "the sleep command never started");
+
+assert.eq(1, coll.find({ _id: 1 }).itcount());
+awaitSleep();
+
+entry = testDB.system.profile.find({ op: "query", ns: coll.getFullName(), "query._id": 1 })
+                             .sort({ $natural: -1 }).limit(1).next();
+printjson(entry);
+assert.gte(entry.resources.lockWaits, 1);
+assert.gt(entry.resources.lockWaitMicros, 0);
+
+testDB.setProfilingLevel(0);
+testDB.dropDatabase();
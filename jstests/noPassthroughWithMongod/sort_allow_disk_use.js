@@ -0,0 +1,64 @@
+// Test that a find() whose blocking sort outgrows the internal sort memory limit succeeds, and
+// returns its results in order, when it is allowed to spill to disk.
+//
+// Note that this test sets the server parameter "internalQueryExecMaxBlockingSortBytes", and
+// restores the original value of the parameter before exiting.  As a result, this test cannot run
+// in the sharding passthrough (because mongos does not have this parameter), and cannot run in the
+// parallel suite (because the change of the parameter value would interfere with other tests).
+
+var coll = db.sort_allow_disk_use;
+coll.drop();
+
+// Set the internal sort memory limit to 1MB.
+var result = db.adminCommand({getParameter: 1, internalQueryExecMaxBlockingSortBytes: 1});
+assert.commandWorked(result);
+var oldSortLimit = result.internalQueryExecMaxBlockingSortBytes;
+var newSortLimit = 1024 * 1024;
+assert.commandWorked(db.adminCommand({setParameter: 1,
+                                      internalQueryExecMaxBlockingSortBytes: newSortLimit}));
+
+try {
+    // Insert ~3MB of data, with the sort key in reverse insertion order.
+    var largeStr = '';
+    for (var i = 0; i < 32 * 1024; ++i) {
+        largeStr += 'x';
+    }
+    for (var i = 0; i < 100; ++i) {
+        assert.writeOK(coll.insert({a: largeStr, b: 99 - i}));
+    }
+
+    // Without allowDiskUse the sort still fails.
+    assert.throws(function() { coll.find({}).sort({b: 1}).itcount(); });
+
+    // With allowDiskUse it spills and returns everything in order.
+    var results = coll.find({}, {a: 0}).sort({b: 1}).allowDiskUse().toArray();
+    assert.eq(100, results.length);
+    for (var i = 0; i < results.length; ++i) {
+        assert.eq(i, results[i].b);
+    }
+
+    // Ties on the sort key are still broken consistently, and a descending sort works too.
+    results = coll.find({}, {a: 0}).sort({c: 1, b: -1}).allowDiskUse().toArray();
+    assert.eq(100, results.length);
+    for (var i = 0; i < results.length; ++i) {
+        assert.eq(99 - i, results[i].b);
+    }
+
+    // The explain output says that the sort used the disk.
+    var explain = coll.find({}).sort({b: 1}).allowDiskUse().explain("executionStats");
+    var sortStage = explain.executionStats.executionStages;
+    while (sortStage.stage !== "SORT") {
+        sortStage = sortStage.inputStage;
+    }
+    assert(sortStage.usedDisk, tojson(explain));
+
+    // A sort with a limit keeps using the in-memory top-K sort.
+    results = coll.find({}, {a: 0}).sort({b: 1}).limit(5).allowDiskUse().toArray();
+    assert.eq(5, results.length);
+    assert.eq(0, results[0].b);
+}
+finally {
+    // Restore the original sort memory limit.
+    assert.commandWorked(db.adminCommand({setParameter: 1,
+                                          internalQueryExecMaxBlockingSortBytes: oldSortLimit}));
+}
@@ -0,0 +1,40 @@
+// Secondaries prefetch the documents and index keys of replicated updates and deletes before
+// applying them, whatever the storage engine.
+
+var rt = new ReplSetTest({ name: "prefetch_secondary_indexes", nodes: 2 });
+rt.startSet();
+rt.initiate();
+
+var primary = rt.getPrimary();
+var secondary = rt.getSecondary();
+secondary.setSlaveOk();
+var t = primary.getDB("test").prefetch;
+t.ensureIndex({ a: 1 });
+t.ensureIndex({ b: 1 });
+
+var bulk = t.initializeUnorderedBulkOp();
+for (var i = 0; i < 100; i++) {
+    bulk.insert({ _id: i, a: i, b: -i });
+}
+assert.writeOK(bulk.execute({ w: 2 }));
+
+function preload() {
+    return secondary.getDB("admin").serverStatus().metrics.repl.preload;
+}
+var before = preload();
+
+for (var j = 0; j < 50; j++) {
+    t.update({ _id: j }, { $set: { a: j + 1000 } });
+}
+t.remove({ _id: { $gte: 50 } });
+assert.commandWorked(primary.getDB("test").runCommand({ getLastError: 1, w: 2 }));
+
+var after = preload();
+assert.gt(after.docs.num, before.docs.num, tojson(after));
+assert.gt(after.indexes.num, before.indexes.num, tojson(after));
+assert.eq(50, secondary.getDB("test").prefetch.find().hint({ b: 1 }).itcount());
+
+// Prefetching on engines which manage their own cache can be switched off.
+assert.commandWorked(secondary.getDB("admin").runCommand({ setParameter: 1,
+                                                           replPrefetchAllStorageEngines: false }));
+rt.stopSet();
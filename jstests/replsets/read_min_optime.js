@@ -0,0 +1,35 @@
+// A read sent to a secondary with the optime of a write made on the primary waits for the
+// secondary to apply that write, and fails with OpTimeNotReached if it is too far behind.
+
+var rt = new ReplSetTest({ name: "read_min_optime", nodes: 2 });
+rt.startSet();
+rt.initiate();
+
+var primary = rt.getPrimary();
+var secondary = rt.getSecondary();
+secondary.setSlaveOk();
+var primaryDB = primary.getDB("test");
+var secondaryDB = secondary.getDB("test");
+
+var res = primaryDB.runCommand({ insert: "read_min_optime", documents: [ { _id: 1 } ] });
+assert.commandWorked(res);
+assert(res.lastOp, tojson(res));
+
+var doc = secondaryDB.read_min_optime.find({ _id: 1 }).minOpTime(res.lastOp).next();
+assert.eq(1, doc._id);
+assert.eq(1, secondaryDB.read_min_optime.find().minOpTime(res.lastOp).itcount());
+
+// The optime also comes back from getLastError after a legacy write.
+primaryDB.read_min_optime.insert({ _id: 2 });
+var gle = primaryDB.runCommand({ getLastError: 1 });
+assert.eq(2, secondaryDB.read_min_optime.find({ _id: 2 }).minOpTime(gle.lastOp).next()._id);
+
+// A write the secondary will not apply in time.
+var future = new Timestamp(res.lastOp.t + 3600, 0);
+assert.commandWorked(secondary.adminCommand({ setParameter: 1, minOpTimeReadWaitMS: 50 }));
+var error = assert.throws(function() {
+    secondaryDB.read_min_optime.find().minOpTime(future).itcount();
+});
+assert(/but not/.test(error.toString()), error.toString());
+
+rt.stopSet();
@@ -0,0 +1,70 @@
+// Sorted queries and aggregations with a limit and skip over several shards return the right
+// results while the batches fetched from the shards shrink, and kill the shard cursors they
+// leave unread.
+
+var st = new ShardingTest({ shards: 2, mongos: 1 });
+st.stopBalancer();
+
+var mongos = st.s0;
+var coll = mongos.getCollection("test.merge_limit_skip");
+assert.commandWorked(mongos.adminCommand({ enableSharding: "test" }));
+assert.commandWorked(mongos.adminCommand({ shardCollection: coll + "", key: { _id: 1 } }));
+assert.commandWorked(mongos.adminCommand({ split: coll + "", middle: { _id: 0 } }));
+assert.commandWorked(mongos.adminCommand({ moveChunk: coll + "", find: { _id: 0 },
+                                           to: st.getOther(st.getServer("test")).name }));
+
+var bulk = coll.initializeUnorderedBulkOp();
+for (var i = -500; i < 500; i++) {
+    bulk.insert({ _id: i, a: (i * 7919) % 1000, pad: new Array(100).join("x") });
+}
+assert.writeOK(bulk.execute());
+
+function expected(skip, limit) {
+    var out = [];
+    for (var i = -500; i < 500; i++) {
+        out.push((i * 7919) % 1000);
+    }
+    out.sort(function(x, y) { return x - y; });
+    return out.slice(skip, skip + limit);
+}
+
+function values(docs) {
+    return docs.map(function(doc) { return doc.a; });
+}
+
+function openShardCursors() {
+    return st.shard0.getDB("admin").serverStatus().metrics.cursor.open.total +
+           st.shard1.getDB("admin").serverStatus().metrics.cursor.open.total;
+}
+
+// Limits smaller and larger than the batch size, with and without a skip.
+[[0, 5, 2], [3, 5, 2], [0, 150, 7], [40, 150, 0], [995, 10, 3]].forEach(function(test) {
+    var skip = test[0], limit = test[1], batchSize = test[2];
+    var want = expected(skip, limit);
+
+    var cursor = coll.find().sort({ a: 1 }).skip(skip).limit(limit);
+    if (batchSize) {
+        cursor = cursor.batchSize(batchSize);
+    }
+    assert.eq(want, values(cursor.toArray()), tojson(test));
+
+    assert.eq(want, values(coll.aggregate([{ $sort: { a: 1 } }, { $skip: skip },
+                                           { $limit: limit }]).toArray()), tojson(test));
+});
+
+// A single batch leaves nothing to read on the shards.
+assert.eq(expected(0, 3), values(coll.find().sort({ a: 1 }).limit(-3).toArray()));
+assert.eq(expected(0, 1), values([coll.find().sort({ a: 1 }).limit(1).next()]));
+assert.soon(function() { return openShardCursors() == 0; },
+            "shard cursors left open: " + openShardCursors());
+
+// Closing a mongos cursor before the end kills the shard cursors under it.
+var cursor = coll.find().sort({ a: 1 }).batchSize(10);
+assert.eq(expected(0, 10), values([0, 1, 2, 3, 4, 5, 6, 7, 8, 9].map(function() {
+    return cursor.next();
+})));
+cursor.close();
+assert.soon(function() { return openShardCursors() == 0; },
+            "shard cursors left open after close: " + openShardCursors());
+
+st.stop();
@@ -0,0 +1,37 @@
+// Reconnections from the same client resume their TLS session instead of doing a full handshake,
+// unless session caching is turned off with sslSessionCacheSize=0.
+
+var SERVER_CERT = "jstests/libs/server.pem";
+var CA_CERT = "jstests/libs/ca.pem";
+
+function handshakes(conn) {
+    var status = conn.getDB("admin").serverStatus();
+    assert.commandWorked(status);
+    return status.security.SSLHandshakes;
+}
+
+function reconnect(conn, times) {
+    for (var i = 0; i < times; i++) {
+        var other = new Mongo(conn.host);
+        assert.commandWorked(other.getDB("admin").runCommand({ ping: 1 }));
+    }
+}
+
+var conn = MongoRunner.runMongod({ sslMode: "requireSSL",
+                                   sslPEMKeyFile: SERVER_CERT,
+                                   sslCAFile: CA_CERT });
+var before = handshakes(conn);
+reconnect(conn, 5);
+var after = handshakes(conn);
+assert.gte(after.accepted - before.accepted, 5, tojson(after));
+assert.gte(after.acceptedResumed - before.acceptedResumed, 4, tojson(after));
+assert.eq(before.failed, after.failed, tojson(after));
+MongoRunner.stopMongod(conn.port);
+
+conn = MongoRunner.runMongod({ sslMode: "requireSSL",
+                               sslPEMKeyFile: SERVER_CERT,
+                               sslCAFile: CA_CERT,
+                               setParameter: "sslSessionCacheSize=0" });
+reconnect(conn, 5);
+assert.eq(0, handshakes(conn).acceptedResumed, tojson(handshakes(conn)));
+MongoRunner.stopMongod(conn.port);
@@ -0,0 +1,101 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/unittest/benchmark.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace {
+
+    /**
+     * An object of 'numFields' fields of mixed types, named "a0", "a1", ...
+     */
+    BSONObj makeObject(long long numFields) {
+        BSONObjBuilder bob;
+        for (long long i = 0; i < numFields; i++) {
+            const std::string name = str::stream() << 'a' << i;
+            switch (i % 3) {
+            case 0: bob.append(name, static_cast<int>(i)); break;
+            case 1: bob.append(name, static_cast<double>(i)); break;
+            default: bob.append(name, "a string value"); break;
+            }
+        }
+        return bob.obj();
+    }
+
+    MONGO_BENCHMARK_WITH_ARGS(BSONObjBuild, "1,10,100") {
+        const long long numFields = state.arg();
+        while (state.keepRunning()) {
+            BSONObjBuilder bob;
+            for (long long i = 0; i < numFields; i++) {
+                bob.append("field", static_cast<int>(i));
+            }
+            state.doNotOptimize(bob.done().objsize());
+        }
+    }
+
+    MONGO_BENCHMARK_WITH_ARGS(BSONObjIterate, "1,10,100") {
+        const BSONObj obj = makeObject(state.arg());
+        while (state.keepRunning()) {
+            int types = 0;
+            BSONObjIterator it(obj);
+            while (it.more()) {
+                types += it.next().type();
+            }
+            state.doNotOptimize(types);
+        }
+    }
+
+    MONGO_BENCHMARK_WITH_ARGS(BSONObjGetFieldLast, "1,10,100") {
+        const BSONObj obj = makeObject(state.arg());
+        const std::string last = str::stream() << 'a' << (state.arg() - 1);
+        while (state.keepRunning()) {
+            state.doNotOptimize(obj.getField(last).type());
+        }
+    }
+
+    MONGO_BENCHMARK_WITH_ARGS(BSONObjWoCompare, "1,10,100") {
+        const BSONObj lhs = makeObject(state.arg());
+        const BSONObj rhs = lhs.copy();
+        while (state.keepRunning()) {
+            state.doNotOptimize(lhs.woCompare(rhs));
+        }
+    }
+
+    MONGO_BENCHMARK_WITH_ARGS(BSONObjToJson, "1,10,100") {
+        const BSONObj obj = makeObject(state.arg());
+        while (state.keepRunning()) {
+            state.doNotOptimize(obj.jsonString().size());
+        }
+    }
+
+}  // namespace
+}  // namespace mongo
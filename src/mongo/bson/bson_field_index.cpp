@@ -0,0 +1,112 @@
+/*    Copyright 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/bson_field_index.h"
+
+#include <cstring>
+
+#include "mongo/bson/bsonobjiterator.h"
+
+namespace mongo {
+
+    namespace {
+
+        // FNV-1a, which is cheap for the short strings field names usually are.
+        unsigned hashFieldName(const StringData& name) {
+            unsigned hash = 2166136261U;
+            for (size_t i = 0; i < name.size(); ++i) {
+                hash ^= static_cast<unsigned char>(name[i]);
+                hash *= 16777619U;
+            }
+            return hash;
+        }
+
+    }  // namespace
+
+    BSONElement BSONFieldIndex::getField(const BSONObj& obj, const StringData& name) {
+        if (obj.objdata() != _obj.objdata() || obj.objsize() != _obj.objsize()) {
+            clear();
+            _obj = obj;
+        }
+
+        if (_slots.empty()) {
+            if (++_numLookups < 2) {
+                return _obj.getField(name);
+            }
+            _build();
+        }
+
+        const size_t mask = _slots.size() - 1;
+        size_t slot = hashFieldName(name) & mask;
+        while (_slots[slot] != -1) {
+            const BSONElement& field = _fields[_slots[slot]];
+            if (name == field.fieldNameStringData()) {
+                return field;
+            }
+            slot = (slot + 1) & mask;
+        }
+        return BSONElement();
+    }
+
+    void BSONFieldIndex::clear() {
+        _obj = BSONObj();
+        _numLookups = 0;
+        _fields.clear();
+        _slots.clear();
+    }
+
+    void BSONFieldIndex::_build() {
+        BSONObjIterator it(_obj);
+        while (it.more()) {
+            _fields.push_back(it.next());
+        }
+
+        // Keep the table at most half full so probe sequences stay short.
+        size_t numSlots = 16;
+        while (numSlots < 2 * _fields.size()) {
+            numSlots *= 2;
+        }
+        _slots.assign(numSlots, -1);
+
+        const size_t mask = numSlots - 1;
+        for (size_t i = 0; i < _fields.size(); ++i) {
+            const StringData name = _fields[i].fieldNameStringData();
+            size_t slot = hashFieldName(name) & mask;
+            while (_slots[slot] != -1 && name != _fields[_slots[slot]].fieldNameStringData()) {
+                slot = (slot + 1) & mask;
+            }
+
+            // Like getField, a repeated name resolves to its first occurrence.
+            if (_slots[slot] == -1) {
+                _slots[slot] = static_cast<int>(i);
+            }
+        }
+    }
+
+}  // namespace mongo
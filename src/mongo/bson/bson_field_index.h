@@ -0,0 +1,77 @@
+/*    Copyright 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonelement.h"
+#include "mongo/bson/bsonobj.h"
+
+namespace mongo {
+
+    /**
+     * Looks up the top-level fields of one object by name without rescanning the object for
+     * every lookup, for callers such as the matcher that ask one wide document for many fields.
+     *
+     * The first lookup scans the object just as BSONObj::getField does.  The second records
+     * every field in a hash table in one pass, so all later lookups are a probe.  An index is
+     * bound to the last object it was asked about and starts over when given another one.
+     */
+    class BSONFieldIndex {
+        MONGO_DISALLOW_COPYING(BSONFieldIndex);
+    public:
+        BSONFieldIndex() : _numLookups(0) { }
+
+        /**
+         * Returns the first top-level field of 'obj' named 'name', or EOO if there is none,
+         * exactly as obj.getField(name) would.
+         */
+        BSONElement getField(const BSONObj& obj, const StringData& name);
+
+        /**
+         * Forgets the current object, keeping the memory for the next one.
+         */
+        void clear();
+
+    private:
+        void _build();
+
+        // Holding the object keeps an owned buffer, and so the recorded fields, alive.
+        BSONObj _obj;
+        int _numLookups;
+
+        // The fields of '_obj' in order, and an open-addressed table of positions in '_fields'
+        // with -1 marking an empty slot.  The table size is a power of two, or zero before the
+        // table is built.
+        std::vector<BSONElement> _fields;
+        std::vector<int> _slots;
+    };
+
+}  // namespace mongo
@@ -0,0 +1,97 @@
+/*    Copyright 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/bson/bson_field_index.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace {
+
+    using mongo::BSONElement;
+    using mongo::BSONFieldIndex;
+    using mongo::BSONObj;
+    using mongo::BSONObjBuilder;
+
+    BSONObj makeWide(int numFields) {
+        BSONObjBuilder bob;
+        for (int i = 0; i < numFields; ++i) {
+            bob.append(std::string(mongo::str::stream() << "f" << i), i);
+        }
+        return bob.obj();
+    }
+
+    TEST(BSONFieldIndex, MatchesGetField) {
+        BSONObj obj = makeWide(100);
+        BSONFieldIndex index;
+
+        // The first lookups scan and the later ones use the table; all must agree.
+        for (int i = 0; i < 100; ++i) {
+            const std::string name = mongo::str::stream() << "f" << i;
+            BSONElement e = index.getField(obj, name);
+            ASSERT_EQUALS(obj.getField(name).rawdata(), e.rawdata());
+        }
+        ASSERT(index.getField(obj, "missing").eoo());
+        ASSERT(index.getField(obj, "f").eoo());
+        ASSERT(index.getField(obj, "f100").eoo());
+        ASSERT(index.getField(obj, "").eoo());
+    }
+
+    TEST(BSONFieldIndex, DuplicateNamesReturnFirst) {
+        BSONObj obj = BSON("a" << 1 << "b" << 2 << "a" << 3);
+        BSONFieldIndex index;
+        for (int i = 0; i < 3; ++i) {
+            ASSERT_EQUALS(1, index.getField(obj, "a").numberInt());
+        }
+    }
+
+    TEST(BSONFieldIndex, RebindsToNewObject) {
+        BSONObj first = BSON("a" << 1 << "b" << 2);
+        BSONObj second = BSON("b" << 3 << "c" << 4);
+        BSONFieldIndex index;
+
+        ASSERT_EQUALS(1, index.getField(first, "a").numberInt());
+        ASSERT_EQUALS(2, index.getField(first, "b").numberInt());
+        ASSERT_EQUALS(2, index.getField(first, "b").numberInt());
+
+        ASSERT(index.getField(second, "a").eoo());
+        ASSERT_EQUALS(3, index.getField(second, "b").numberInt());
+        ASSERT_EQUALS(4, index.getField(second, "c").numberInt());
+
+        index.clear();
+        ASSERT_EQUALS(1, index.getField(first, "a").numberInt());
+    }
+
+    TEST(BSONFieldIndex, EmptyObject) {
+        BSONFieldIndex index;
+        for (int i = 0; i < 3; ++i) {
+            ASSERT(index.getField(BSONObj(), "a").eoo());
+        }
+    }
+
+}  // namespace
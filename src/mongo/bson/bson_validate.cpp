@@ -168,11 +168,16 @@ namespace mongo {
         };
 
         /**
+         * Validates the type, field name and, unless it is a nested object, the value of the
+         * element at the current position.  Sets '*name' to the field name, which is left empty
+         * at the end of an object.
+         *
          * WARNING: only pass in a non-EOO idElem if it has been fully validated already!
          */
         Status validateElementInfo(Buffer* buffer,
                                    ValidationState::State* nextState,
-                                   BSONElement idElem) {
+                                   BSONElement idElem,
+                                   StringData* name) {
             Status status = Status::OK();
 
             signed char type;
@@ -184,8 +189,7 @@ namespace mongo {
                 return Status::OK();
             }
 
-            StringData name;
-            status = buffer->readCString( &name );
+            status = buffer->readCString( name );
             if ( !status.isOK() )
                 return status;
 
@@ -297,16 +301,15 @@ namespace mongo {
 
                     const uint64_t elemStartPos = buffer->position();
                     ValidationState::State nextState = state;
-                    Status status = validateElementInfo(buffer, &nextState, idElem);
+                    StringData name;
+                    Status status = validateElementInfo(buffer, &nextState, idElem, &name);
                     if (!status.isOK())
                         return status;
 
-                    // we've already validated that fieldname is safe to access as long as we aren't
-                    // at the end of the object, since EOO doesn't have a fieldname.
-                    if (nextState != ValidationState::EndObj && idElem.eoo() && atTopLevel) {
-                        if (strcmp(buffer->getBasePtr() + elemStartPos + 1/*type*/, "_id") == 0) {
-                            idElemStartPos = elemStartPos;
-                        }
+                    // The name was measured while validating it, so this needs no second scan of
+                    // the field name.  EOO has no field name and leaves 'name' empty.
+                    if (atTopLevel && idElem.eoo() && name == "_id") {
+                        idElemStartPos = elemStartPos;
                     }
 
                     state = nextState;
@@ -42,43 +42,48 @@ namespace mongo {
     namespace str = mongoutils::str;
 
     string BSONElement::jsonString( JsonStringFormat format, bool includeFieldNames, int pretty ) const {
+        StringBuilder s;
+        jsonStringBuffer( format, includeFieldNames, pretty, s );
+        return s.str();
+    }
+
+    void BSONElement::jsonStringBuffer( JsonStringFormat format, bool includeFieldNames,
+                                        int pretty, StringBuilder& buffer ) const {
         int sign;
 
-        std::stringstream s;
-        if ( includeFieldNames )
-            s << '"' << escape( fieldName() ) << "\" : ";
+        if ( includeFieldNames ) {
+            buffer << '"';
+            appendEscaped( StringData( fieldName(), fieldNameSize() - 1 ), false, buffer );
+            buffer << "\" : ";
+        }
+
+        // The common types go straight into the buffer...
         switch ( type() ) {
         case mongo::String:
         case Symbol:
-            s << '"' << escape( string(valuestr(), valuestrsize()-1) ) << '"';
-            break;
-        case NumberLong:
-            if (format == TenGen) {
-                s << "NumberLong(" << _numberLong() << ")";
-            }
-            else {
-                s << "{ \"$numberLong\" : \"" << _numberLong() << "\" }";
-            }
-            break;
+            buffer << '"';
+            appendEscaped( StringData( valuestr(), valuestrsize() - 1 ), false, buffer );
+            buffer << '"';
+            return;
         case NumberInt:
-            if(format == JS) {
-                s << "NumberInt(" << _numberInt() << ")";
-                break;
-            }
+            if ( format == JS )
+                buffer << "NumberInt(" << _numberInt() << ")";
+            else
+                buffer << _numberInt();
+            return;
         case NumberDouble:
             if ( number() >= -std::numeric_limits< double >::max() &&
                  number() <= std::numeric_limits< double >::max() ) {
-                s.precision( 16 );
-                s << number();
+                buffer.appendDoublePrecise( number() );
             }
             // This is not valid JSON, but according to RFC-4627, "Numeric values that cannot be
             // represented as sequences of digits (such as Infinity and NaN) are not permitted." so
             // we are accepting the fact that if we have such values we cannot output valid JSON.
             else if ( mongo::isNaN(number()) ) {
-                s << "NaN";
+                buffer << "NaN";
             }
             else if ( mongo::isInf(number(), &sign) ) {
-                s << ( sign == 1 ? "Infinity" : "-Infinity");
+                buffer << ( sign == 1 ? "Infinity" : "-Infinity");
             }
             else {
                 StringBuilder ss;
@@ -86,57 +91,72 @@ namespace mongo {
                 string message = ss.str();
                 massert( 10311 ,  message.c_str(), false );
             }
-            break;
+            return;
         case mongo::Bool:
-            s << ( boolean() ? "true" : "false" );
-            break;
+            buffer << ( boolean() ? "true" : "false" );
+            return;
         case jstNULL:
-            s << "null";
-            break;
-        case Undefined:
-            if ( format == Strict ) {
-                s << "{ \"$undefined\" : true }";
-            }
-            else {
-                s << "undefined";
-            }
-            break;
+            buffer << "null";
+            return;
         case Object:
-            s << embeddedObject().jsonString( format, pretty );
-            break;
+            embeddedObject().jsonStringBuffer( format, pretty, false, buffer );
+            return;
         case mongo::Array: {
             if ( embeddedObject().isEmpty() ) {
-                s << "[]";
-                break;
+                buffer << "[]";
+                return;
             }
-            s << "[ ";
+            buffer << "[ ";
             BSONObjIterator i( embeddedObject() );
             BSONElement e = i.next();
             if ( !e.eoo() ) {
                 int count = 0;
                 while ( 1 ) {
                     if( pretty ) {
-                        s << '\n';
+                        buffer << '\n';
                         for( int x = 0; x < pretty; x++ )
-                            s << "  ";
+                            buffer << "  ";
                     }
 
                     if (strtol(e.fieldName(), 0, 10) > count) {
-                        s << "undefined";
+                        buffer << "undefined";
                     }
                     else {
-                        s << e.jsonString( format, false, pretty?pretty+1:0 );
+                        e.jsonStringBuffer( format, false, pretty?pretty+1:0, buffer );
                         e = i.next();
                     }
                     count++;
                     if ( e.eoo() )
                         break;
-                    s << ", ";
+                    buffer << ", ";
                 }
             }
-            s << " ]";
+            buffer << " ]";
+            return;
+        }
+        default:
             break;
         }
+
+        // ...and the others through a stream.
+        std::stringstream s;
+        switch ( type() ) {
+        case NumberLong:
+            if (format == TenGen) {
+                s << "NumberLong(" << _numberLong() << ")";
+            }
+            else {
+                s << "{ \"$numberLong\" : \"" << _numberLong() << "\" }";
+            }
+            break;
+        case Undefined:
+            if ( format == Strict ) {
+                s << "{ \"$undefined\" : true }";
+            }
+            else {
+                s << "undefined";
+            }
+            break;
         case DBRef: {
             if ( format == TenGen )
                 s << "Dbref( ";
@@ -282,7 +302,7 @@ namespace mongo {
             string message = ss.str();
             massert( 10312 ,  message.c_str(), false );
         }
-        return s.str();
+        buffer << s.str();
     }
 
     int BSONElement::getGtLtOp( int def ) const {
@@ -517,10 +537,7 @@ namespace mongo {
         return totalSize;
     }
 
-    int BSONElement::size() const {
-        if ( totalSize >= 0 )
-            return totalSize;
-
+    int BSONElement::computeSize() const {
         int x = 0;
         switch ( type() ) {
         case EOO:
@@ -771,45 +788,59 @@ namespace mongo {
     }
 
     // used by jsonString()
-    std::string escape( const std::string& s , bool escape_slash) {
-        StringBuilder ret;
-        for ( std::string::const_iterator i = s.begin(); i != s.end(); ++i ) {
+    void appendEscaped( const StringData& s, bool escape_slash, StringBuilder& out ) {
+        const char* i = s.rawData();
+        const char* const end = i + s.size();
+        while ( i != end ) {
+            // Copy the characters which need no escaping a run at a time.
+            const char* run = i;
+            while ( i != end &&
+                    static_cast<unsigned char>( *i ) > 0x1f &&
+                    *i != '"' && *i != '\\' && *i != '/' ) {
+                ++i;
+            }
+            out.write( run, i - run );
+            if ( i == end )
+                break;
+
             switch ( *i ) {
             case '"':
-                ret << "\\\"";
+                out << "\\\"";
                 break;
             case '\\':
-                ret << "\\\\";
+                out << "\\\\";
                 break;
             case '/':
-                ret << (escape_slash ? "\\/" : "/");
+                out << (escape_slash ? "\\/" : "/");
                 break;
             case '\b':
-                ret << "\\b";
+                out << "\\b";
                 break;
             case '\f':
-                ret << "\\f";
+                out << "\\f";
                 break;
             case '\n':
-                ret << "\\n";
+                out << "\\n";
                 break;
             case '\r':
-                ret << "\\r";
+                out << "\\r";
                 break;
             case '\t':
-                ret << "\\t";
+                out << "\\t";
                 break;
-            default:
-                if ( *i >= 0 && *i <= 0x1f ) {
-                    //TODO: these should be utf16 code-units not bytes
-                    char c = *i;
-                    ret << "\\u00" << toHexLower(&c, 1);
-                }
-                else {
-                    ret << *i;
-                }
+            default: {
+                //TODO: these should be utf16 code-units not bytes
+                char c = *i;
+                out << "\\u00" << toHexLower(&c, 1);
+            }
             }
+            ++i;
         }
+    }
+
+    std::string escape( const std::string& s , bool escape_slash) {
+        StringBuilder ret;
+        appendEscaped( s, escape_slash, ret );
         return ret.str();
     }
 
@@ -117,6 +117,8 @@ namespace mongo {
         std::string toString( bool includeFieldName = true, bool full=false) const;
         void toString(StringBuilder& s, bool includeFieldName = true, bool full=false, int depth=0) const;
         std::string jsonString( JsonStringFormat format, bool includeFieldNames = true, int pretty = 0 ) const;
+        void jsonStringBuffer( JsonStringFormat format, bool includeFieldNames, int pretty,
+                               StringBuilder& buffer ) const;
         operator std::string() const { return toString(); }
 
         /** Returns the type of the element */
@@ -142,7 +144,11 @@ namespace mongo {
             @param maxLen If maxLen is specified, don't scan more than maxLen bytes to calculate size.
         */
         int size( int maxLen ) const;
-        int size() const;
+        int size() const {
+            if ( totalSize >= 0 )
+                return totalSize;
+            return computeSize();
+        }
 
         /** Wrap this element up as a singleton object. */
         BSONObj wrap() const;
@@ -513,6 +519,8 @@ namespace mongo {
 
         mutable int totalSize; /* caches the computed size */
 
+        int computeSize() const;
+
         friend class BSONObjIterator;
         friend class BSONObj;
         const BSONElement& chk(int t) const {
@@ -656,4 +664,7 @@ namespace mongo {
     // TODO(SERVER-14596): move to a better place; take a StringData.
     std::string escape( const std::string& s , bool escape_slash=false);
 
+    /** Appends 's' to 'out' with the escaping escape() applies. */
+    void appendEscaped( const StringData& s, bool escape_slash, StringBuilder& out );
+
 }
@@ -88,16 +88,25 @@ namespace mongo {
     }
 
     string BSONObj::jsonString( JsonStringFormat format, int pretty, bool isArray ) const {
+        StringBuilder s;
+        jsonStringBuffer( format, pretty, isArray, s );
+        return s.str();
+    }
 
-        if ( isEmpty() ) return isArray ? "[]" : "{}";
+    void BSONObj::jsonStringBuffer( JsonStringFormat format, int pretty, bool isArray,
+                                    StringBuilder& s ) const {
+
+        if ( isEmpty() ) {
+            s << (isArray ? "[]" : "{}");
+            return;
+        }
 
-        StringBuilder s;
         s << (isArray ?  "[ " : "{ ");
         BSONObjIterator i(*this);
         BSONElement e = i.next();
         if ( !e.eoo() )
             while ( 1 ) {
-                s << e.jsonString( format, !isArray, pretty?pretty+1:0 );
+                e.jsonStringBuffer( format, !isArray, pretty?pretty+1:0, s );
                 e = i.next();
                 if ( e.eoo() )
                     break;
@@ -112,7 +121,6 @@ namespace mongo {
                 }
             }
         s << (isArray ? " ]" : " }");
-        return s.str();
     }
 
     bool BSONObj::valid() const {
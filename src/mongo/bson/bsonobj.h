@@ -113,6 +113,15 @@ namespace mongo {
                 , _ownedBuffer(ownedBuffer.moveFrom()) {
         }
 
+        /** Construct a BSONObj from data in the proper format, which is located somewhere inside
+         *  ownedBuffer (not necessarily at its start). The BSONObj shares ownership of the whole
+         *  buffer, so it stays valid for as long as the BSONObj or any of its copies are alive.
+         */
+        BSONObj(const char *bsonData, SharedBuffer ownedBuffer)
+                : _objdata(bsonData)
+                , _ownedBuffer(ownedBuffer.moveFrom()) {
+        }
+
 #if __cplusplus >= 201103L
         /** Move construct a BSONObj */
         BSONObj(BSONObj&& other)
@@ -199,6 +208,10 @@ namespace mongo {
             bool isArray = false
         ) const;
 
+        /** Appends jsonString() to 'buffer'. */
+        void jsonStringBuffer( JsonStringFormat format, int pretty, bool isArray,
+                               StringBuilder& buffer ) const;
+
         /** note: addFields always adds _id even if not specified */
         int addFields(BSONObj& from, std::set<std::string>& fields); /* returns n added */
 
@@ -53,5 +53,15 @@ namespace mutablebson {
 
     typedef std::vector<DamageEvent> DamageVector;
 
+    // Returns the size of a 'size' byte target buffer once 'damages' have been applied to it.
+    // This is larger than 'size' if the damages append past the end of the buffer.
+    inline size_t getDamagedSize(size_t size, const DamageVector& damages) {
+        for (DamageVector::const_iterator it = damages.begin(); it != damages.end(); ++it) {
+            if (it->targetOffset + it->size > size)
+                size = it->targetOffset + it->size;
+        }
+        return size;
+    }
+
 } // namespace mutablebson
 } // namespace mongo
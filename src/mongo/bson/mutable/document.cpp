@@ -565,7 +565,9 @@ namespace mutablebson {
             , _leafBuilder(_leafBuf)
             , _fieldNameScratch()
             , _damages()
-            , _inPlaceMode(inPlaceMode) {
+            , _inPlaceMode(inPlaceMode)
+            , _inPlaceEnd(0)
+            , _inPlaceGrown(false) {
 
             // We always have a BSONObj for the leaves, and we often have
             // one for our base document, so reserve 2.
@@ -606,6 +608,8 @@ namespace mutablebson {
             _fieldNameScratch.clear();
             _damages.clear();
             _inPlaceMode = inPlaceMode;
+            _inPlaceEnd = 0;
+            _inPlaceGrown = false;
 
             // Ensure that we start in the same state as the ctor would leave us in.
             _objects.push_back(_leafBuilder.asTempObj());
@@ -965,6 +969,49 @@ namespace mutablebson {
             return (data >= start) && (data < end);
         }
 
+        // Link the detached element 'newIdx' into the tree as the right sibling of 'thisIdx',
+        // which must have a parent.
+        void linkRightSibling(Element::RepIdx thisIdx, Element::RepIdx newIdx) {
+            ElementRep* newRep = &getElementRep(newIdx);
+            ElementRep* thisRep = &getElementRep(thisIdx);
+            ElementRep* parentRep = &getElementRep(thisRep->parent);
+
+            // If our current right sibling is opaque it needs to be resolved. This will
+            // invalidate our reps so we need to reacquire them.
+            Element::RepIdx rightSiblingIdx = thisRep->sibling.right;
+            if (rightSiblingIdx == Element::kOpaqueRepIdx) {
+                rightSiblingIdx = resolveRightSibling(thisIdx);
+                dassert(rightSiblingIdx != Element::kOpaqueRepIdx);
+                newRep = &getElementRep(newIdx);
+                thisRep = &getElementRep(thisIdx);
+                parentRep = &getElementRep(thisRep->parent);
+            }
+
+            // The new element shares our parent.
+            newRep->parent = thisRep->parent;
+
+            // We are the new element's left sibling.
+            newRep->sibling.left = thisIdx;
+
+            // The new element right sibling is our right sibling.
+            newRep->sibling.right = rightSiblingIdx;
+
+            // The new element becomes our right sibling.
+            thisRep->sibling.right = newIdx;
+
+            // If the new element has a right sibling after the adjustments above, then that
+            // right sibling must be updated to have the new element as its left sibling.
+            if (newRep->sibling.right != Element::kInvalidRepIdx)
+                getElementRep(rightSiblingIdx).sibling.left = newIdx;
+
+            // If we were our parent's right child, then we no longer are. Make the new right
+            // sibling the right child.
+            if (parentRep->child.right == thisIdx)
+                parentRep->child.right = newIdx;
+
+            deserialize(thisRep->parent);
+        }
+
         void reserveDamageEvents(size_t expectedEvents) {
             _damages.reserve(expectedEvents);
         }
@@ -981,6 +1028,19 @@ namespace mutablebson {
                 return false;
             }
 
+            // If elements were appended to the root, the damage must also rewrite the total
+            // size of the document and move its EOO to the new end. Both are taken from an
+            // int element with an empty field name written to the leaf heap: its value is the
+            // new size and the terminator of its field name is a zero byte.
+            if (_inPlaceGrown) {
+                const int leafRef = _leafBuilder.len();
+                _leafBuilder.append("", static_cast<int>(_inPlaceEnd + 1));
+                _objects[kLeafObjIdx] = _leafBuilder.asTempObj();
+                recordDamageEvent(0, leafRef + 2, sizeof(int32_t));
+                recordDamageEvent(_inPlaceEnd, leafRef + 1, 1);
+                _inPlaceGrown = false;
+            }
+
             // Set up the source and source size out parameters.
             *source = _objects[0].objdata();
             if (size)
@@ -1020,6 +1080,36 @@ namespace mutablebson {
             }
         }
 
+        // If the serialized leaf heap element 'rep' is being appended to the root, record
+        // damage which writes it past the end of the original document and return true.
+        // Returns false, recording nothing, if the append cannot be expressed in-place.
+        bool recordInPlaceAppend(Element::RepIdx parentIdx, const ElementRep& rep) {
+            if (!isInPlaceModeEnabled() || (parentIdx != kRootRepIdx))
+                return false;
+
+            if ((rep.objIdx != kLeafObjIdx) || !hasValue(rep))
+                return false;
+
+            if (_inPlaceEnd == 0) {
+                const BSONObj& original = getObject(getElementRep(kRootRepIdx).objIdx);
+                _inPlaceEnd = original.objsize() - 1;
+            }
+
+            const BSONElement elt = getSerializedElement(rep);
+            if (_inPlaceEnd + elt.size() + 1 > static_cast<size_t>(BSONObjMaxInternalSize))
+                return false;
+
+            recordDamageEvent(_inPlaceEnd, getElementOffset(getObject(kLeafObjIdx), elt),
+                              elt.size());
+            _inPlaceEnd += elt.size();
+            _inPlaceGrown = true;
+            return true;
+        }
+
+        bool hasInPlaceAppends() const {
+            return _inPlaceEnd != 0;
+        }
+
         // Check all preconditions on doing an in-place update, except for size match.
         bool canUpdateInPlace(const ElementRep& sourceRep, const ElementRep& targetRep) {
 
@@ -1107,6 +1197,12 @@ namespace mutablebson {
         // Queue of damage events and status bit for whether  in-place updates are possible.
         DamageVector _damages;
         Document::InPlaceMode _inPlaceMode;
+
+        // Offset of the EOO of the root object once elements have been appended to it
+        // in-place, or zero if none have been. _inPlaceGrown is set if that happened since the
+        // damage events were last handed out.
+        size_t _inPlaceEnd;
+        bool _inPlaceGrown;
     };
 
     Status Element::addSiblingLeft(Element e) {
@@ -1167,13 +1263,13 @@ namespace mutablebson {
         verify(_doc == e._doc);
 
         Document::Impl& impl = getDocument().getImpl();
-        ElementRep* newRep = &impl.getElementRep(e._repIdx);
+        const ElementRep& newRep = impl.getElementRep(e._repIdx);
 
         // check that new element roots a clean subtree.
-        if (!canAttach(e._repIdx, *newRep))
-            return getAttachmentError(*newRep);
+        if (!canAttach(e._repIdx, newRep))
+            return getAttachmentError(newRep);
 
-        ElementRep* thisRep = &impl.getElementRep(_repIdx);
+        const ElementRep* thisRep = &impl.getElementRep(_repIdx);
 
         dassert(thisRep->parent != kOpaqueRepIdx);
         if (thisRep->parent == kInvalidRepIdx)
@@ -1181,45 +1277,11 @@ namespace mutablebson {
                 ErrorCodes::IllegalOperation,
                 "Attempt to add a sibling to an element without a parent");
 
-        ElementRep* parentRep = &impl.getElementRep(thisRep->parent);
-        dassert(!impl.isLeaf(*parentRep));
+        dassert(!impl.isLeaf(impl.getElementRep(thisRep->parent)));
 
         impl.disableInPlaceUpdates();
 
-        // If our current right sibling is opaque it needs to be resolved. This will invalidate
-        // our reps so we need to reacquire them.
-        Element::RepIdx rightSiblingIdx = thisRep->sibling.right;
-        if (rightSiblingIdx == kOpaqueRepIdx) {
-            rightSiblingIdx = impl.resolveRightSibling(_repIdx);
-            dassert(rightSiblingIdx != kOpaqueRepIdx);
-            newRep = &impl.getElementRep(e._repIdx);
-            thisRep = &impl.getElementRep(_repIdx);
-            parentRep = &impl.getElementRep(thisRep->parent);
-        }
-
-        // The new element shares our parent.
-        newRep->parent = thisRep->parent;
-
-        // We are the new element's left sibling.
-        newRep->sibling.left = _repIdx;
-
-        // The new element right sibling is our right sibling.
-        newRep->sibling.right = rightSiblingIdx;
-
-        // The new element becomes our right sibling.
-        thisRep->sibling.right = e._repIdx;
-
-        // If the new element has a right sibling after the adjustments above, then that right
-        // sibling must be updated to have the new element as its left sibling.
-        if (newRep->sibling.right != kInvalidRepIdx)
-            impl.getElementRep(rightSiblingIdx).sibling.left = e._repIdx;
-
-        // If we were our parent's right child, then we no longer are. Make the new right
-        // sibling the right child.
-        if (parentRep->child.right == _repIdx)
-            parentRep->child.right = e._repIdx;
-
-        impl.deserialize(thisRep->parent);
+        impl.linkRightSibling(_repIdx, e._repIdx);
 
         return Status::OK();
     }
@@ -1965,7 +2027,11 @@ namespace mutablebson {
                 ErrorCodes::IllegalOperation,
                 "Attempt to add a child element to a non-object element");
 
-        impl.disableInPlaceUpdates();
+        // Appending a serialized element to the root only writes past the end of the original
+        // document, so it need not end in-place updates.
+        const bool inPlaceAppend = !front && impl.recordInPlaceAppend(_repIdx, newRep);
+        if (!inPlaceAppend)
+            impl.disableInPlaceUpdates();
 
         // TODO: In both of the following cases, we call two public API methods each. We can
         // probably do better by writing this explicitly here and drying it with the public
@@ -1984,8 +2050,12 @@ namespace mutablebson {
             // that your left sibling is never opaque. But adding new Elements to the end is a
             // quite common operation, so it would be nice if we could do this efficiently.
             Element rc = rightChild();
-            if (rc.ok())
-                return rc.addSiblingRight(e);
+            if (rc.ok()) {
+                if (!inPlaceAppend)
+                    return rc.addSiblingRight(e);
+                impl.linkRightSibling(rc._repIdx, e._repIdx);
+                return Status::OK();
+            }
         }
 
         // It must be the case that we have no children, so the new element becomes both the
@@ -2054,6 +2124,10 @@ namespace mutablebson {
                 impl.disableInPlaceUpdates();
 
             }
+        } else if (impl.isInPlaceModeEnabled() && impl.hasInPlaceAppends()) {
+            // The bytes of elements appended in-place were captured when they were appended,
+            // so a later change to one of them, or to anything under it, cannot be in-place.
+            impl.disableInPlaceUpdates();
         }
 
         // If we are not rootish, then wire in the new value among our relations.
@@ -469,7 +469,9 @@ namespace mutablebson {
          *  destruction, so this is not so great a restriction.
          *
          *  The destination offsets in the damage events are implicitly offsets into the
-         *  BSONObj used to construct this Document.
+         *  BSONObj used to construct this Document. Elements appended to the root are written
+         *  past the end of that BSONObj, along with a new size and EOO, so the target must be
+         *  able to hold mutablebson::getDamagedSize() bytes.
          */
         bool getInPlaceUpdates(DamageVector* damages,
                                const char** source,
@@ -2543,13 +2543,22 @@ namespace {
         ASSERT_FALSE(doc.isInPlaceModeEnabled());
     }
 
-    TEST(DocumentInPlace, InPlaceModeIsDisabledByPushBack) {
+    // Appending to the root can be expressed as damage past the end of the document.
+    TEST(DocumentInPlace, InPlaceModeIsNotDisabledByPushBackToRoot) {
         mongo::BSONObj obj = mongo::fromjson("{ foo : 'foo' }");
         mmb::Document doc(obj, mmb::Document::kInPlaceEnabled);
         ASSERT_TRUE(doc.isInPlaceModeEnabled());
         mmb::Element newElt = doc.makeElementInt("bar", 42);
         ASSERT_TRUE(doc.isInPlaceModeEnabled());
         ASSERT_OK(doc.root().pushBack(newElt));
+        ASSERT_TRUE(doc.isInPlaceModeEnabled());
+    }
+
+    TEST(DocumentInPlace, InPlaceModeIsDisabledByPushBackOfUnserializedElement) {
+        mongo::BSONObj obj = mongo::fromjson("{ foo : 'foo' }");
+        mmb::Document doc(obj, mmb::Document::kInPlaceEnabled);
+        mmb::Element newElt = doc.makeElementObject("bar");
+        ASSERT_OK(newElt.appendInt("baz", 42));
         ASSERT_FALSE(doc.isInPlaceModeEnabled());
     }
 
@@ -2601,6 +2610,84 @@ namespace {
         ASSERT_EQUALS(0U, size);
     }
 
+    namespace {
+        // Applies 'damages' to a copy of 'obj' which is large enough for any appends they
+        // describe, and returns the result.
+        mongo::BSONObj applyWithGrowth(const mongo::BSONObj& obj,
+                                       const mmb::DamageVector& damages,
+                                       const char* source) {
+            size_t size = obj.objsize();
+            for (size_t i = 0; i < damages.size(); ++i)
+                size = std::max(size, damages[i].targetOffset + damages[i].size);
+            mongo::BufBuilder buf(size);
+            buf.appendBuf(obj.objdata(), obj.objsize());
+            buf.skip(size - obj.objsize());
+            for (size_t i = 0; i < damages.size(); ++i) {
+                std::memcpy(buf.buf() + damages[i].targetOffset,
+                            source + damages[i].sourceOffset,
+                            damages[i].size);
+            }
+            return mongo::BSONObj(buf.buf()).getOwned();
+        }
+    } // namespace
+
+    TEST(DocumentInPlace, AppendToRootIsInPlace) {
+        mongo::BSONObj obj = mongo::fromjson("{ foo : 'foo' }");
+        mmb::Document doc(obj, mmb::Document::kInPlaceEnabled);
+        ASSERT_OK(doc.root().appendInt("bar", 42));
+        ASSERT_TRUE(doc.isInPlaceModeEnabled());
+
+        mmb::DamageVector damages;
+        const char* source = NULL;
+        ASSERT_TRUE(doc.getInPlaceUpdates(&damages, &source));
+        const mongo::BSONObj result = applyWithGrowth(obj, damages, source);
+        ASSERT_EQUALS(mongo::fromjson("{ foo : 'foo', bar : 42 }"), result);
+        ASSERT_EQUALS(doc.getObject(), result);
+    }
+
+    TEST(DocumentInPlace, AppendsToRootCombineWithSetValue) {
+        mongo::BSONObj obj = mongo::fromjson("{ a : 1, b : { c : 2 } }");
+        mmb::Document doc(obj, mmb::Document::kInPlaceEnabled);
+        ASSERT_OK(doc.root().leftChild().setValueInt(10));
+        ASSERT_OK(doc.root().appendString("d", "dee"));
+        ASSERT_OK(doc.root()["b"]["c"].setValueInt(20));
+        ASSERT_OK(doc.root().appendBool("e", true));
+        ASSERT_TRUE(doc.isInPlaceModeEnabled());
+
+        mmb::DamageVector damages;
+        const char* source = NULL;
+        ASSERT_TRUE(doc.getInPlaceUpdates(&damages, &source));
+        ASSERT_EQUALS(mongo::fromjson("{ a : 10, b : { c : 20 }, d : 'dee', e : true }"),
+                      applyWithGrowth(obj, damages, source));
+    }
+
+    TEST(DocumentInPlace, AppendToRootOfEmptyDocumentIsInPlace) {
+        mongo::BSONObj obj;
+        mmb::Document doc(obj, mmb::Document::kInPlaceEnabled);
+        ASSERT_OK(doc.root().appendInt("x", 1));
+        ASSERT_TRUE(doc.isInPlaceModeEnabled());
+
+        mmb::DamageVector damages;
+        const char* source = NULL;
+        ASSERT_TRUE(doc.getInPlaceUpdates(&damages, &source));
+        ASSERT_EQUALS(mongo::fromjson("{ x : 1 }"), applyWithGrowth(obj, damages, source));
+    }
+
+    TEST(DocumentInPlace, InPlaceModeIsDisabledByAppendToNestedObject) {
+        mongo::BSONObj obj = mongo::fromjson("{ foo : { bar : 1 } }");
+        mmb::Document doc(obj, mmb::Document::kInPlaceEnabled);
+        ASSERT_OK(doc.root().leftChild().appendInt("baz", 42));
+        ASSERT_FALSE(doc.isInPlaceModeEnabled());
+    }
+
+    TEST(DocumentInPlace, InPlaceModeIsDisabledByChangeToAppendedElement) {
+        mongo::BSONObj obj = mongo::fromjson("{ foo : 'foo' }");
+        mmb::Document doc(obj, mmb::Document::kInPlaceEnabled);
+        ASSERT_OK(doc.root().appendInt("bar", 42));
+        ASSERT_OK(doc.root().rightChild().setValueInt(43));
+        ASSERT_FALSE(doc.isInPlaceModeEnabled());
+    }
+
     // This isn't a great test since we aren't testing all possible combinations of compatible
     // and incompatible sets, but since all setValueX calls decay to the internal setValue, we
     // can be pretty sure that this will at least check the logic somewhat.
@@ -2629,11 +2716,11 @@ namespace {
         ASSERT_OK(bar.setValueBool(false));
         ASSERT_TRUE(doc.isInPlaceModeEnabled());
 
-        ASSERT_OK(doc.root().appendString("baz", "baz"));
+        ASSERT_OK(doc.root().pushFront(doc.makeElementString("baz", "baz")));
         ASSERT_FALSE(doc.isInPlaceModeEnabled());
 
         static const char outJson[] =
-            "{ foo : true, bar : false, baz : 'baz' }";
+            "{ baz : 'baz', foo : true, bar : false }";
         ASSERT_EQUALS(mongo::fromjson(outJson), doc.getObject());
     }
 
@@ -38,6 +38,7 @@
 #include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/platform/random.h"
+#include "mongo/util/concurrency/threadlocal.h"
 #include "mongo/util/hex.h"
 
 namespace mongo {
@@ -51,8 +52,24 @@ namespace {
     const std::size_t kIncrementOffset = kInstanceUniqueOffset +
                                          OID::kInstanceUniqueSize;
     OID::InstanceUnique _instanceUnique;
+
+    // Threads take increments from the shared counter this many at a time, so that generating
+    // an OID writes to the counter's cache line once per block rather than every time.
+    const uint32_t kIncrementBlockSize = 64;
 }  // namespace
 
+    /**
+     * The increments a thread has taken from the shared counter but not used yet.
+     */
+    struct OIDIncrementBlock {
+        OIDIncrementBlock() : next(0), end(0) { }
+        uint32_t next;
+        uint32_t end;
+    };
+
+    TSP_DECLARE(OIDIncrementBlock, oidIncrementBlock)
+    TSP_DEFINE(OIDIncrementBlock, oidIncrementBlock)
+
     MONGO_INITIALIZER_GENERAL(OIDGeneration, MONGO_NO_PREREQUISITES, ("default"))
         (InitializerContext* context) {
         boost::scoped_ptr<SecureRandom> entropy(SecureRandom::create());
@@ -62,7 +79,12 @@ namespace {
     }
 
     OID::Increment OID::Increment::next() {
-        uint64_t nextCtr = counter->fetchAndAdd(1);
+        OIDIncrementBlock* block = oidIncrementBlock.getMake();
+        if (block->next == block->end) {
+            block->next = counter->fetchAndAdd(kIncrementBlockSize);
+            block->end = block->next + kIncrementBlockSize;
+        }
+        uint64_t nextCtr = block->next++;
         OID::Increment incr;
 
         incr.bytes[0] = uint8_t(nextCtr >> 16);
@@ -132,6 +154,12 @@ namespace {
 
     void OID::justForked() {
         regenMachineId();
+
+        // Don't hand out the rest of the parent's block.
+        OIDIncrementBlock* block = oidIncrementBlock.get();
+        if (block) {
+            block->next = block->end;
+        }
     }
 
     void OID::init() {
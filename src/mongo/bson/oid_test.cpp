@@ -27,6 +27,11 @@
 
 #include "mongo/bson/oid.h"
 
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <set>
+#include <vector>
+
 #include "mongo/platform/endian.h"
 #include "mongo/unittest/unittest.h"
 
@@ -57,6 +62,39 @@ namespace {
         ASSERT_TRUE(o1 < o2);
     }
 
+    TEST(Increasing, AcrossIncrementBlocks) {
+        OID last = OID::gen();
+        for (int i = 0; i < 1000; i++) {
+            const OID next = OID::gen();
+            if (next.getTimestamp() == last.getTimestamp()) {
+                ASSERT_TRUE(last < next);
+            }
+            last = next;
+        }
+    }
+
+    void genOIDs(std::vector<OID>* out) {
+        for (size_t i = 0; i < out->size(); i++) {
+            (*out)[i] = OID::gen();
+        }
+    }
+
+    TEST(Unique, AcrossThreads) {
+        const size_t kThreads = 8;
+        std::vector<std::vector<OID> > generated(kThreads, std::vector<OID>(1000));
+        boost::thread_group threads;
+        for (size_t i = 0; i < kThreads; i++) {
+            threads.create_thread(boost::bind(genOIDs, &generated[i]));
+        }
+        threads.join_all();
+
+        std::set<OID> all;
+        for (size_t i = 0; i < kThreads; i++) {
+            all.insert(generated[i].begin(), generated[i].end());
+        }
+        ASSERT_EQUALS(kThreads * 1000, all.size());
+    }
+
     TEST(IsSet, Simple) {
         OID o;
         ASSERT_FALSE(o.isSet());
@@ -43,6 +43,7 @@
 #include "mongo/bson/inline_decls.h"
 #include "mongo/util/allocator.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/thread_buffer_cache.h"
 
 namespace mongo {
     /* Accessing unaligned doubles on ARM generates an alignment trap and aborts with SIGBUS on Linux.
@@ -83,6 +84,24 @@ namespace mongo {
         void Free(void *p) { free(p); }
     };
 
+    /**
+     * Allocator for BufBuilder that recycles buffers through the thread's ThreadBufferCache, so
+     * that a thread which has warmed up builds without calling malloc.  Remembers the capacity of
+     * the buffer it handed out, which lets Realloc() grow within it without copying.  The buffers
+     * are ordinary malloc'd memory, so a decouple()d buffer is still free()d by its new owner.
+     */
+    class CachingAllocator {
+    public:
+        CachingAllocator() : _capacity(0) {}
+        void* Malloc(size_t sz) { return ThreadBufferCache::allocate(sz, &_capacity); }
+        void* Realloc(void *p, size_t sz) {
+            return ThreadBufferCache::reallocate(p, _capacity, sz, &_capacity);
+        }
+        void Free(void *p) { ThreadBufferCache::release(p, _capacity); }
+    private:
+        size_t _capacity;
+    };
+
     class StackAllocator {
     public:
         enum { SZ = 512 };
@@ -270,7 +289,7 @@ namespace mongo {
         friend class StringBuilderImpl<Allocator>;
     };
 
-    typedef _BufBuilder<TrivialAllocator> BufBuilder;
+    typedef _BufBuilder<CachingAllocator> BufBuilder;
 
     /** The StackBufBuilder builds smaller datasets on the stack instead of using malloc.
           this can be significantly faster for small bufs.  However, you can not decouple() the 
@@ -362,6 +381,9 @@ namespace mongo {
             }
         }
 
+        /** Appends 'x' the way an ostream with precision(16) would format it. */
+        void appendDoublePrecise( double x ) { SBNUM( x , 32 , "%.16g" ); }
+
         void write( const char* buf, int len) { memcpy( _buf.grow( len ) , buf , len ); }
 
         void append( const StringData& str ) { str.copyTo( _buf.grow( str.size() ), false ); }
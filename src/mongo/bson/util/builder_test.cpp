@@ -44,6 +44,39 @@ namespace mongo {
         ASSERT_EQUALS( 0, strcmp( "eliot", bb.buf() ) );
     }
 
+    TEST(Builder, ReusesFreedBuffer) {
+        const void* first;
+        {
+            BufBuilder bb;
+            bb.appendStr("first");
+            first = bb.buf();
+        }
+
+        BufBuilder bb;
+        ASSERT_EQUALS(first, static_cast<const void*>(bb.buf()));
+        bb.appendStr("second");
+        ASSERT_EQUALS(0, strcmp("second", bb.buf()));
+    }
+
+    TEST(Builder, GrowKeepsContents) {
+        BufBuilder bb;
+        for (int i = 0; i < 100 * 1000; i++) {
+            bb.appendNum(i);
+        }
+        for (int i = 0; i < 100 * 1000; i++) {
+            ASSERT_EQUALS(i, ConstDataView(bb.buf()).readLE<int>(i * sizeof(int)));
+        }
+    }
+
+    TEST(Builder, DecoupledBufferIsFreeable) {
+        BufBuilder bb;
+        bb.appendStr("decoupled");
+        char* buf = bb.buf();
+        bb.decouple();
+        ASSERT_EQUALS(0, strcmp("decoupled", buf));
+        free(buf);
+    }
+
     TEST(Builder, StringBuilderAddress) {
         const void* longPtr = reinterpret_cast<const void*>(-1);
         const void* shortPtr = reinterpret_cast<const void*>(0xDEADBEEF);
@@ -38,6 +38,7 @@
 #include "mongo/client/replica_set_monitor.h"
 #include "mongo/client/syncclusterconnection.h"
 #include "mongo/util/log.h"
+#include "mongo/util/timer.h"
 #include "mongo/s/shard.h"
 
 namespace mongo {
@@ -58,6 +59,8 @@ namespace mongo {
 
     void PoolForHost::done(DBConnectionPool* pool, DBClientBase* c) {
 
+        markCheckedIn();
+
         bool isFailed = c->isFailed();
 
         // Remember that this host had a broken connection for later
@@ -176,6 +179,7 @@ namespace mongo {
         : _mutex("DBConnectionPool") , 
           _name( "dbconnectionpool" ) , 
           _maxPoolSize(PoolForHost::kPoolSizeUnlimited) ,
+          _maxInUse(PoolForHost::kPoolSizeUnlimited) ,
           _hooks( new list<DBConnectionHook*>() ) {
     }
 
@@ -185,10 +189,40 @@ namespace mongo {
         scoped_lock L(_mutex);
         PoolForHost& p = _pools[PoolKey(ident,socketTimeout)];
         p.setMaxPoolSize(_maxPoolSize);
+        p.setMaxInUse(_maxInUse);
         p.initializeHostName(ident);
+
+        if ( ! p.hasFreeSlot() ) {
+            Timer timer;
+            const boost::xtime deadline = incxtimemillis( static_cast<long long>( socketTimeout * 1000 ) );
+            while ( ! p.hasFreeSlot() ) {
+                if ( socketTimeout > 0 ) {
+                    if ( ! _connectionCheckedIn.timed_wait( L.boost() , deadline ) &&
+                         ! p.hasFreeSlot() ) {
+                        p.recordWait( timer.micros() );
+                        uasserted( 28605 , str::stream() << _name << ": timed out waiting for a"
+                                           << " connection to " << ident << ", "
+                                           << p.numInUse() << " in use" );
+                    }
+                }
+                else {
+                    _connectionCheckedIn.wait( L.boost() );
+                }
+            }
+            p.recordWait( timer.micros() );
+        }
+
+        // The slot is taken here, before a new connection is made outside the lock
+        p.markCheckedOut();
         return p.get( this , socketTimeout );
     }
 
+    void DBConnectionPool::_checkIn( const string& ident , double socketTimeout ) {
+        scoped_lock L(_mutex);
+        _pools[PoolKey(ident,socketTimeout)].markCheckedIn();
+        _connectionCheckedIn.notify_all();
+    }
+
     DBClientBase* DBConnectionPool::_finishCreate( const string& host , double socketTimeout , DBClientBase* conn ) {
         {
             scoped_lock L(_mutex);
@@ -204,6 +238,7 @@ namespace mongo {
         }
         catch ( std::exception & ) {
             delete conn;
+            _checkIn( host , socketTimeout );
             throw;
         }
 
@@ -218,14 +253,21 @@ namespace mongo {
             }
             catch ( std::exception& ) {
                 delete c;
+                _checkIn( url.toString() , socketTimeout );
                 throw;
             }
             return c;
         }
 
-        string errmsg;
-        c = url.connect( errmsg, socketTimeout );
-        uassert( 13328 ,  _name + ": connect failed " + url.toString() + " : " + errmsg , c );
+        try {
+            string errmsg;
+            c = url.connect( errmsg, socketTimeout );
+            uassert( 13328 ,  _name + ": connect failed " + url.toString() + " : " + errmsg , c );
+        }
+        catch ( std::exception& ) {
+            _checkIn( url.toString() , socketTimeout );
+            throw;
+        }
 
         return _finishCreate( url.toString() , socketTimeout , c );
     }
@@ -238,18 +280,26 @@ namespace mongo {
             }
             catch ( std::exception& ) {
                 delete c;
+                _checkIn( host , socketTimeout );
                 throw;
             }
             return c;
         }
 
-        string errmsg;
-        ConnectionString cs = ConnectionString::parse( host , errmsg );
-        uassert( 13071 , (string)"invalid hostname [" + host + "]" + errmsg , cs.isValid() );
+        try {
+            string errmsg;
+            ConnectionString cs = ConnectionString::parse( host , errmsg );
+            uassert( 13071 , (string)"invalid hostname [" + host + "]" + errmsg , cs.isValid() );
+
+            c = cs.connect( errmsg, socketTimeout );
+            if ( ! c )
+                throw SocketException( SocketException::CONNECT_ERROR , host , 11002 , str::stream() << _name << " error: " << errmsg );
+        }
+        catch ( std::exception& ) {
+            _checkIn( host , socketTimeout );
+            throw;
+        }
 
-        c = cs.connect( errmsg, socketTimeout );
-        if ( ! c )
-            throw SocketException( SocketException::CONNECT_ERROR , host , 11002 , str::stream() << _name << " error: " << errmsg );
         return _finishCreate( host , socketTimeout , c );
     }
 
@@ -268,6 +318,11 @@ namespace mongo {
 
         scoped_lock L(_mutex);
         _pools[PoolKey(host,c->getSoTimeout())].done(this,c);
+        _connectionCheckedIn.notify_all();
+    }
+
+    void DBConnectionPool::decrementEgress(const string& host, DBClientBase* conn) {
+        _checkIn( host , conn->getSoTimeout() );
     }
 
 
@@ -338,6 +393,9 @@ namespace mongo {
 
         int avail = 0;
         long long created = 0;
+        int inUse = 0;
+        long long waits = 0;
+        long long waitMicros = 0;
 
 
         map<ConnectionString::ConnectionType,long long> createdByType;
@@ -354,10 +412,16 @@ namespace mongo {
                 BSONObjBuilder temp( bb.subobjStart( s ) );
                 temp.append( "available" , i->second.numAvailable() );
                 temp.appendNumber( "created" , i->second.numCreated() );
+                temp.append( "inUse" , i->second.numInUse() );
+                temp.appendNumber( "waits" , i->second.numWaits() );
+                temp.appendNumber( "waitMicros" , i->second.totalWaitMicros() );
                 temp.done();
 
                 avail += i->second.numAvailable();
                 created += i->second.numCreated();
+                inUse += i->second.numInUse();
+                waits += i->second.numWaits();
+                waitMicros += i->second.totalWaitMicros();
 
                 long long& x = createdByType[i->second.type()];
                 x += i->second.numCreated();
@@ -393,6 +457,9 @@ namespace mongo {
 
         b.append( "totalAvailable" , avail );
         b.appendNumber( "totalCreated" , created );
+        b.append( "totalInUse" , inUse );
+        b.appendNumber( "totalWaits" , waits );
+        b.appendNumber( "totalWaitMicros" , waitMicros );
     }
 
     bool DBConnectionPool::serverNameCompare::operator()( const string& a , const string& b ) const{
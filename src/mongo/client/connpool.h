@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <boost/thread/condition.hpp>
 #include <stack>
 
 #include "mongo/client/dbclientinterface.h"
@@ -56,15 +57,24 @@ namespace mongo {
             _created(0),
             _minValidCreationTimeMicroSec(0),
             _type(ConnectionString::INVALID),
-            _maxPoolSize(kPoolSizeUnlimited) {
+            _maxPoolSize(kPoolSizeUnlimited),
+            _maxInUse(kPoolSizeUnlimited),
+            _checkedOut(0),
+            _numWaits(0),
+            _totalWaitMicros(0) {
         }
 
         PoolForHost(const PoolForHost& other) :
             _created(other._created),
             _minValidCreationTimeMicroSec(other._minValidCreationTimeMicroSec),
             _type(other._type),
-            _maxPoolSize(other._maxPoolSize) {
+            _maxPoolSize(other._maxPoolSize),
+            _maxInUse(other._maxInUse),
+            _checkedOut(other._checkedOut),
+            _numWaits(other._numWaits),
+            _totalWaitMicros(other._totalWaitMicros) {
             verify(_created == 0);
+            verify(_checkedOut == 0);
             verify(other._pool.size() == 0);
         }
 
@@ -82,6 +92,40 @@ namespace mongo {
 
         int numAvailable() const { return (int)_pool.size(); }
 
+        /**
+         * Returns the maximum number of connections to this host which may be handed out at once
+         */
+        int getMaxInUse() const { return _maxInUse; }
+
+        /**
+         * Sets the maximum number of connections to this host which may be handed out at once
+         */
+        void setMaxInUse( int maxInUse ) { _maxInUse = maxInUse; }
+
+        /**
+         * Returns true if another connection may be handed out without exceeding getMaxInUse()
+         */
+        bool hasFreeSlot() const {
+            return _maxInUse == kPoolSizeUnlimited || _checkedOut < _maxInUse;
+        }
+
+        /**
+         * Number of connections handed out and neither returned to the pool nor destroyed yet
+         */
+        int numInUse() const { return _checkedOut; }
+        void markCheckedOut() { _checkedOut++; }
+        void markCheckedIn() { if ( _checkedOut > 0 ) _checkedOut--; }
+
+        /**
+         * Counts a wait for a connection because the host was at getMaxInUse()
+         */
+        void recordWait( long long micros ) {
+            _numWaits++;
+            _totalWaitMicros += micros;
+        }
+        long long numWaits() const { return _numWaits; }
+        long long totalWaitMicros() const { return _totalWaitMicros; }
+
         void createdOne( DBClientBase * base );
         long long numCreated() const { return _created; }
 
@@ -138,6 +182,14 @@ namespace mongo {
 
         // The maximum number of connections we'll save in the pool
         int _maxPoolSize;
+
+        // The maximum number of connections handed out at once, and how many are currently
+        int _maxInUse;
+        int _checkedOut;
+
+        // Waits because the host had _maxInUse connections out, and their total duration
+        long long _numWaits;
+        long long _totalWaitMicros;
     };
 
     class DBConnectionHook {
@@ -190,6 +242,19 @@ namespace mongo {
          */
         void setMaxPoolSize( int maxPoolSize ) { _maxPoolSize = maxPoolSize; }
 
+        /**
+         * Returns the maximum number of connections per-host which may be handed out at once.
+         */
+        int getMaxInUse() { return _maxInUse; }
+
+        /**
+         * Sets the maximum number of connections per-host which may be handed out at once. Once a
+         * host is at the limit, get() waits until a connection to it is released or destroyed, or
+         * until the socket timeout passes if one is given. PoolForHost::kPoolSizeUnlimited, the
+         * default, means no limit.
+         */
+        void setMaxInUse( int maxInUse ) { _maxInUse = maxInUse; }
+
         void onCreate( DBClientBase * conn );
         void onHandedOut( DBClientBase * conn );
         void onDestroy( DBClientBase * conn );
@@ -202,6 +267,12 @@ namespace mongo {
 
         void release(const std::string& host, DBClientBase *c);
 
+        /**
+         * Must be called instead of release() when a connection handed out by get() is destroyed
+         * by its user, so that it no longer counts against the host's in-use limit.
+         */
+        void decrementEgress(const std::string& host, DBClientBase* conn);
+
         void addHook( DBConnectionHook * hook ); // we take ownership
         void appendInfo( BSONObjBuilder& b );
 
@@ -239,6 +310,9 @@ namespace mongo {
 
         DBClientBase* _finishCreate( const std::string& ident , double socketTimeout, DBClientBase* conn );
 
+        // Gives back the in-use slot taken by _get() for a connection which was never handed out
+        void _checkIn( const std::string& ident , double socketTimeout );
+
         struct PoolKey {
             PoolKey( const std::string& i , double t ) : ident( i ) , timeout( t ) {}
             std::string ident;
@@ -259,8 +333,14 @@ namespace mongo {
         // 0 effectively disables the pool
         int _maxPoolSize;
 
+        // The maximum number of connections per-host handed out at once, see setMaxInUse()
+        int _maxInUse;
+
         PoolMap _pools;
 
+        // Signalled whenever a handed out connection is released or destroyed
+        boost::condition _connectionCheckedIn;
+
         // pointers owned by me, right now they leak on shutdown
         // _hooks itself also leaks because it creates a shutdown race condition
         std::list<DBConnectionHook*> * _hooks;
@@ -346,6 +426,9 @@ namespace mongo {
             a bad state.  Destructor will do this too, but it is verbose.
         */
         void kill() {
+            if ( _conn ) {
+                pool.decrementEgress(_host, _conn);
+            }
             delete _conn;
             _conn = 0;
         }
@@ -45,6 +45,7 @@
 #include "mongo/s/stale_exception.h"  // for RecvStaleConfigException
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
+#include "mongo/util/net/message_compressor.h"
 #include "mongo/util/net/ssl_manager.h"
 #include "mongo/util/net/ssl_options.h"
 #include "mongo/util/password_digest.h"
@@ -1053,10 +1054,31 @@ namespace mongo {
         int sslModeVal = sslGlobalParams.sslMode.load();
         if (sslModeVal == SSLGlobalParams::SSLMode_preferSSL ||
             sslModeVal == SSLGlobalParams::SSLMode_requireSSL) {
-            return p->secure( sslManager(), _server.host() );
+            if ( !p->secure( sslManager(), _server.host() ) ) {
+                return false;
+            }
         }
 #endif
 
+        if ( hasMessageCompressors() ) {
+            BSONObjBuilder isMasterCmd;
+            isMasterCmd.append( "isMaster", 1 );
+            appendMessageCompressors( &isMasterCmd );
+
+            BSONObj reply;
+            try {
+                if ( runCommand( "admin", isMasterCmd.obj(), reply ) ) {
+                    p->setMessageCompressor( getNegotiatedMessageCompressor( reply ) );
+                }
+            }
+            catch ( const DBException& e ) {
+                errmsg = str::stream() << "couldn't negotiate message compression with "
+                                       << toString() << ": " << e.toString();
+                _failed = true;
+                return false;
+            }
+        }
+
         return true;
     }
 
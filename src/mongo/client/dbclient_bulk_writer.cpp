@@ -0,0 +1,379 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/client/dbclient_bulk_writer.h"
+
+#include <algorithm>
+#include <deque>
+
+#include "mongo/base/owned_pointer_vector.h"
+#include "mongo/client/dbclientinterface.h"
+#include "mongo/db/dbmessage.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/wire_version.h"
+#include "mongo/s/write_ops/batched_command_response.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+
+    using std::string;
+    using std::vector;
+
+namespace {
+
+    // The same conservative estimates of the update and delete statement overhead that mongos
+    // uses when it splits batches.
+    const int kEstUpdateOverheadBytes = (BSONObjMaxInternalSize - BSONObjMaxUserSize) / 100;
+    const int kEstDeleteOverheadBytes = (BSONObjMaxInternalSize - BSONObjMaxUserSize) / 100;
+
+    bool lessByIndex( const WriteErrorDetail* a, const WriteErrorDetail* b ) {
+        return a->getIndex() < b->getIndex();
+    }
+
+    bool lessUpsertByIndex( const BatchedUpsertDetail* a, const BatchedUpsertDetail* b ) {
+        return a->getIndex() < b->getIndex();
+    }
+
+    /** Sends 'cmdObj' to 'dbName' without waiting for the reply, and returns its request id. */
+    MSGID sayCommand( DBClientBase* conn, const StringData& dbName, const BSONObj& cmdObj ) {
+        BufBuilder bufB;
+        bufB.appendNum( 0 ); // command/query options
+        bufB.appendStr( dbName.toString() + ".$cmd" );
+        bufB.appendNum( 0 ); // ntoskip
+        bufB.appendNum( 1 ); // ntoreturn
+        cmdObj.appendSelfToBufBuilder( bufB );
+
+        Message toSend;
+        toSend.setData( dbQuery, bufB.buf(), bufB.len() );
+        conn->say( toSend );
+        return toSend.header().getId();
+    }
+
+    /** Reads the reply to the command sent as 'requestId'. */
+    Status recvCommandReply( DBClientBase* conn, MSGID requestId, BSONObj* result ) {
+        Message toRecv;
+        if ( !conn->recv( toRecv ) ) {
+            return Status( ErrorCodes::HostUnreachable,
+                           str::stream() << "error receiving write command reply from "
+                                         << conn->toString() );
+        }
+        if ( toRecv.header().getResponseTo() != requestId ) {
+            return Status( ErrorCodes::ProtocolError,
+                           str::stream() << "expected the reply to request " << requestId
+                                         << ", got the reply to "
+                                         << toRecv.header().getResponseTo() );
+        }
+
+        QueryResult::View reply = toRecv.singleData().view2ptr();
+        if ( reply.getNReturned() != 1 ) {
+            return Status( ErrorCodes::ProtocolError, "write command reply has no document" );
+        }
+        *result = BSONObj( reply.data() ).getOwned();
+        return Status::OK();
+    }
+
+    int writeSizeBytes( const BSONObj& query, const BSONObj& updateExpr,
+                        BatchedCommandRequest::BatchType type ) {
+        if ( type == BatchedCommandRequest::BatchType_Insert )
+            return query.objsize();
+        if ( type == BatchedCommandRequest::BatchType_Update )
+            return query.objsize() + updateExpr.objsize() + kEstUpdateOverheadBytes;
+        return query.objsize() + kEstDeleteOverheadBytes;
+    }
+
+    /**
+     * Adds the reply to a batch to the merged response. A command which failed as a whole counts
+     * as a write error for each write in it, or for the first one if the batch is ordered.
+     * @return whether the batch had any write errors
+     */
+    bool mergeReply( const BatchedCommandResponse& reply, const vector<int>& indexes,
+                     bool ordered, BatchedCommandResponse* merged ) {
+        if ( !reply.getOk() ) {
+            for ( size_t i = 0; i < indexes.size(); i++ ) {
+                WriteErrorDetail* error = new WriteErrorDetail;
+                error->setIndex( indexes[i] );
+                error->setErrCode( reply.getErrCode() );
+                error->setErrMessage( reply.getErrMessage() );
+                merged->addToErrDetails( error );
+                if ( ordered )
+                    break;
+            }
+            return true;
+        }
+
+        merged->setN( merged->getN() + reply.getN() );
+        if ( reply.isNModified() ) {
+            merged->setNModified( ( merged->isNModified() ? merged->getNModified() : 0 )
+                                  + reply.getNModified() );
+        }
+
+        if ( reply.isUpsertDetailsSet() ) {
+            for ( size_t i = 0; i < reply.sizeUpsertDetails(); i++ ) {
+                BatchedUpsertDetail* upsert = new BatchedUpsertDetail;
+                reply.getUpsertDetailsAt( i )->cloneTo( upsert );
+                upsert->setIndex( indexes[ upsert->getIndex() ] );
+                merged->addToUpsertDetails( upsert );
+            }
+        }
+
+        if ( reply.isWriteConcernErrorSet() ) {
+            WCErrorDetail* wcError = new WCErrorDetail;
+            reply.getWriteConcernError()->cloneTo( wcError );
+            merged->setWriteConcernError( wcError );
+        }
+
+        if ( !reply.isErrDetailsSet() || reply.sizeErrDetails() == 0 )
+            return false;
+
+        for ( size_t i = 0; i < reply.sizeErrDetails(); i++ ) {
+            WriteErrorDetail* error = new WriteErrorDetail;
+            reply.getErrDetailsAt( i )->cloneTo( error );
+            error->setIndex( indexes[ error->getIndex() ] );
+            merged->addToErrDetails( error );
+        }
+        return true;
+    }
+
+} // namespace
+
+    DBClientBulkWriter::DBClientBulkWriter( DBClientBase* conn,
+                                            const StringData& ns,
+                                            bool ordered ) :
+        _conn( conn ),
+        _ns( ns.toString() ),
+        _ordered( ordered ),
+        _maxBatchesInFlight( kDefaultMaxBatchesInFlight ) {
+    }
+
+    void DBClientBulkWriter::insert( const BSONObj& doc ) {
+        Write write;
+        write.type = BatchedCommandRequest::BatchType_Insert;
+        write.query = doc.getOwned();
+        write.upsert = false;
+        write.multi = false;
+        _writes.push_back( write );
+    }
+
+    void DBClientBulkWriter::update( const BSONObj& query,
+                                     const BSONObj& updateExpr,
+                                     bool upsert,
+                                     bool multi ) {
+        Write write;
+        write.type = BatchedCommandRequest::BatchType_Update;
+        write.query = query.getOwned();
+        write.updateExpr = updateExpr.getOwned();
+        write.upsert = upsert;
+        write.multi = multi;
+        _writes.push_back( write );
+    }
+
+    void DBClientBulkWriter::remove( const BSONObj& query, bool justOne ) {
+        Write write;
+        write.type = BatchedCommandRequest::BatchType_Delete;
+        write.query = query.getOwned();
+        write.upsert = false;
+        write.multi = !justOne;
+        _writes.push_back( write );
+    }
+
+    void DBClientBulkWriter::setMaxBatchesInFlight( int maxBatches ) {
+        _maxBatchesInFlight = std::max( maxBatches, 1 );
+    }
+
+    void DBClientBulkWriter::buildBatches( const BSONObj& writeConcern,
+                                           vector<Batch*>* batches ) const {
+
+        const NamespaceString nss( _ns );
+
+        // Ordered writes must keep their order, so only consecutive writes of a type share a
+        // batch. Unordered ones are grouped by type.
+        const BatchedCommandRequest::BatchType types[] = {
+            BatchedCommandRequest::BatchType_Insert,
+            BatchedCommandRequest::BatchType_Update,
+            BatchedCommandRequest::BatchType_Delete
+        };
+        const size_t numPasses = _ordered ? 1 : sizeof( types ) / sizeof( types[0] );
+
+        for ( size_t pass = 0; pass < numPasses; pass++ ) {
+            Batch* batch = NULL;
+            int batchBytes = 0;
+
+            for ( size_t i = 0; i < _writes.size(); i++ ) {
+                const Write& write = _writes[i];
+                if ( !_ordered && write.type != types[pass] )
+                    continue;
+
+                const int sizeBytes = writeSizeBytes( write.query, write.updateExpr, write.type );
+                if ( batch == NULL || batch->request.getBatchType() != write.type ||
+                     batch->indexes.size() >= BatchedCommandRequest::kMaxWriteBatchSize ||
+                     batchBytes + sizeBytes > BSONObjMaxUserSize ) {
+
+                    batch = new Batch( write.type );
+                    batch->request.setNS( nss.coll() );
+                    batch->request.setOrdered( _ordered );
+                    if ( !writeConcern.isEmpty() )
+                        batch->request.setWriteConcern( writeConcern );
+                    batches->push_back( batch );
+                    batchBytes = 0;
+                }
+
+                if ( write.type == BatchedCommandRequest::BatchType_Insert ) {
+                    batch->request.getInsertRequest()->addToDocuments( write.query );
+                }
+                else if ( write.type == BatchedCommandRequest::BatchType_Update ) {
+                    BatchedUpdateDocument* update = new BatchedUpdateDocument;
+                    update->setQuery( write.query );
+                    update->setUpdateExpr( write.updateExpr );
+                    update->setUpsert( write.upsert );
+                    update->setMulti( write.multi );
+                    batch->request.getUpdateRequest()->addToUpdates( update );
+                }
+                else {
+                    BatchedDeleteDocument* del = new BatchedDeleteDocument;
+                    del->setQuery( write.query );
+                    del->setLimit( write.multi ? 0 : 1 );
+                    batch->request.getDeleteRequest()->addToDeletes( del );
+                }
+
+                batch->indexes.push_back( static_cast<int>( i ) );
+                batchBytes += sizeBytes;
+            }
+        }
+    }
+
+    Status DBClientBulkWriter::execute( const BSONObj& writeConcern,
+                                        BatchedCommandResponse* response ) {
+
+        response->clear();
+        response->setOk( 1 );
+        response->setN( 0 );
+
+        if ( _writes.empty() )
+            return Status::OK();
+
+        if ( _conn->getMaxWireVersion() < BATCH_COMMANDS ) {
+            _writes.clear();
+            return Status( ErrorCodes::CommandNotSupported,
+                           str::stream() << _conn->toString()
+                                         << " does not support write commands" );
+        }
+
+        OwnedPointerVector<Batch> batchesOwned;
+        vector<Batch*>& batches = batchesOwned.mutableVector();
+        buildBatches( writeConcern, &batches );
+        _writes.clear();
+
+        const string dbName = NamespaceString( _ns ).db().toString();
+        const size_t window = _ordered ? 1 : static_cast<size_t>( _maxBatchesInFlight );
+
+        // The batches sent and not yet answered, oldest first; a connection answers in order.
+        std::deque< std::pair<size_t, MSGID> > inFlight;
+        size_t next = 0;
+        bool stop = false;
+        Status status = Status::OK();
+
+        while ( true ) {
+            while ( !stop && next < batches.size() && inFlight.size() < window ) {
+                try {
+                    const MSGID id = sayCommand( _conn, dbName, batches[next]->request.toBSON() );
+                    inFlight.push_back( std::make_pair( next, id ) );
+                    next++;
+                }
+                catch ( const DBException& ex ) {
+                    status = ex.toStatus();
+                    stop = true;
+                }
+            }
+
+            if ( inFlight.empty() )
+                break;
+
+            const std::pair<size_t, MSGID> sent = inFlight.front();
+            inFlight.pop_front();
+
+            BSONObj result;
+            Status recvStatus = Status::OK();
+            try {
+                recvStatus = recvCommandReply( _conn, sent.second, &result );
+            }
+            catch ( const DBException& ex ) {
+                recvStatus = ex.toStatus();
+            }
+
+            BatchedCommandResponse reply;
+            string errMsg;
+            if ( recvStatus.isOK() &&
+                 ( !reply.parseBSON( result, &errMsg ) || !reply.isValid( &errMsg ) ) ) {
+                recvStatus = Status( ErrorCodes::FailedToParse, errMsg );
+            }
+
+            if ( !recvStatus.isOK() ) {
+                // The connection can't be trusted to answer the rest either.
+                if ( status.isOK() )
+                    status = recvStatus;
+                stop = true;
+                inFlight.clear();
+                break;
+            }
+
+            if ( mergeReply( reply, batches[sent.first]->indexes, _ordered, response ) &&
+                 _ordered ) {
+                stop = true;
+            }
+        }
+
+        // Report errors and upserts in the order of the writes rather than of the replies;
+        // setErrDetails() and setUpsertDetails() clone what they are given.
+        if ( response->isErrDetailsSet() ) {
+            OwnedPointerVector<WriteErrorDetail> errors;
+            for ( size_t i = 0; i < response->sizeErrDetails(); i++ ) {
+                errors.push_back( new WriteErrorDetail );
+                response->getErrDetailsAt( i )->cloneTo( errors.back() );
+            }
+            std::stable_sort( errors.mutableVector().begin(), errors.mutableVector().end(),
+                              lessByIndex );
+            response->setErrDetails( errors.vector() );
+        }
+        if ( response->isUpsertDetailsSet() ) {
+            OwnedPointerVector<BatchedUpsertDetail> upserts;
+            for ( size_t i = 0; i < response->sizeUpsertDetails(); i++ ) {
+                upserts.push_back( new BatchedUpsertDetail );
+                response->getUpsertDetailsAt( i )->cloneTo( upserts.back() );
+            }
+            std::stable_sort( upserts.mutableVector().begin(), upserts.mutableVector().end(),
+                              lessUpsertByIndex );
+            response->setUpsertDetails( upserts.vector() );
+        }
+
+        return status;
+    }
+
+} // namespace mongo
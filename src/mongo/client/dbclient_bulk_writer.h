@@ -0,0 +1,119 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/s/write_ops/batched_command_request.h"
+
+namespace mongo {
+
+    class BatchedCommandResponse;
+    class DBClientBase;
+
+    /**
+     * A DBClientBulkWriter collects inserts, updates and deletes on one namespace and sends them
+     * as write commands, the client-side equivalent of the shell's bulk API:
+     *
+     *     DBClientBulkWriter bulk( &conn, "test.foo", false );
+     *     bulk.insert( BSON( "x" << 1 ) );
+     *     bulk.update( BSON( "x" << 1 ), BSON( "$inc" << BSON( "y" << 1 ) ), false, false );
+     *     bulk.remove( BSON( "x" << 2 ), false );
+     *
+     *     BatchedCommandResponse response;
+     *     Status status = bulk.execute( BSON( "w" << 1 ), &response );
+     *
+     * The writes are split into batches which fit in a write command. An unordered writer keeps
+     * several batches in flight on the connection and matches each reply to its request, so the
+     * round trips overlap; an ordered one waits for each batch, since a write error must stop the
+     * writes after it.
+     *
+     * The connection must be a direct connection (e.g. a DBClientConnection) to a server which
+     * supports write commands, and must outlive the writer.
+     */
+    class DBClientBulkWriter {
+        MONGO_DISALLOW_COPYING(DBClientBulkWriter);
+    public:
+
+        static const int kDefaultMaxBatchesInFlight = 4;
+
+        DBClientBulkWriter( DBClientBase* conn, const StringData& ns, bool ordered );
+
+        void insert( const BSONObj& doc );
+        void update( const BSONObj& query, const BSONObj& updateExpr, bool upsert, bool multi );
+        void remove( const BSONObj& query, bool justOne );
+
+        /** The number of writes queued since the last execute(). */
+        size_t numWrites() const { return _writes.size(); }
+
+        /** How many batches an unordered writer may have awaiting a reply at once. */
+        void setMaxBatchesInFlight( int maxBatches );
+
+        /**
+         * Sends the queued writes with 'writeConcern' and merges the replies into 'response',
+         * whose write error and upsert indexes count the writes in the order they were queued.
+         * The queue is empty afterwards.
+         *
+         * Write errors are reported in 'response'; the returned status is only an error if the
+         * batches could not be sent or their replies read, in which case 'response' covers the
+         * batches which were answered.
+         */
+        Status execute( const BSONObj& writeConcern, BatchedCommandResponse* response );
+
+    private:
+
+        struct Write {
+            BatchedCommandRequest::BatchType type;
+            BSONObj query;      // the document to insert, or the query of an update or delete
+            BSONObj updateExpr;
+            bool upsert;
+            bool multi;         // for a delete, whether to remove every match
+        };
+
+        /** The requests to send, each with the queue index of every write in it. */
+        struct Batch {
+            explicit Batch( BatchedCommandRequest::BatchType type ) : request( type ) {}
+            BatchedCommandRequest request;
+            std::vector<int> indexes;
+        };
+
+        void buildBatches( const BSONObj& writeConcern, std::vector<Batch*>* batches ) const;
+
+        DBClientBase* const _conn;
+        const std::string _ns;
+        const bool _ordered;
+        int _maxBatchesInFlight;
+        std::vector<Write> _writes;
+    };
+
+} // namespace mongo
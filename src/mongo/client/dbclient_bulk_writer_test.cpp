@@ -0,0 +1,254 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/client/dbclient_bulk_writer.h"
+
+#include <deque>
+#include <vector>
+
+#include "mongo/client/dbclientinterface.h"
+#include "mongo/db/dbmessage.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/s/write_ops/batched_command_response.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace {
+
+    using namespace mongo;
+    using std::vector;
+
+    /**
+     * A connection which answers write commands itself, failing every write whose document or
+     * query has 'fail: true', and which records what was sent.
+     */
+    class FakeWriteConnection : public DBClientConnection {
+    public:
+        FakeWriteConnection() : _nextId( 1 ), _maxInFlight( 0 ) {
+            setWireVersions( 0, 3 );
+        }
+
+        virtual void say( Message& toSend, bool isRetry = false, std::string* actualServer = 0 ) {
+            toSend.header().setId( _nextId++ );
+            DbMessage dbMessage( toSend );
+            QueryMessage query( dbMessage );
+            commands.push_back( query.query.getOwned() );
+            _pending.push_back( std::make_pair( toSend.header().getId(), commands.back() ) );
+            _maxInFlight = std::max( _maxInFlight, _pending.size() );
+        }
+
+        virtual bool recv( Message& m ) {
+            ASSERT( !_pending.empty() );
+            replyToQuery( 0, m, reply( _pending.front().second ) );
+            m.header().setResponseTo( _pending.front().first );
+            _pending.pop_front();
+            return true;
+        }
+
+        virtual std::string toString() const { return "fake"; }
+
+        size_t maxInFlight() const { return _maxInFlight; }
+
+        vector<BSONObj> commands;
+
+    private:
+        BSONObj reply( const BSONObj& cmd ) {
+            const StringData type = cmd.firstElementFieldName();
+            const char* listName = type == "insert" ? "documents" :
+                                   type == "update" ? "updates" : "deletes";
+            const bool ordered = !cmd.hasField( "ordered" ) || cmd["ordered"].trueValue();
+
+            BSONArrayBuilder errors;
+            int n = 0;
+            int index = 0;
+            BSONObjIterator it( cmd[listName].Obj() );
+            while ( it.more() ) {
+                BSONObj write = it.next().Obj();
+                BSONObj doc = type == "insert" ? write : write["q"].Obj();
+                if ( doc["fail"].trueValue() ) {
+                    errors.append( BSON( "index" << index << "code" << 11000
+                                         << "errmsg" << "failed" ) );
+                    if ( ordered )
+                        break;
+                }
+                else {
+                    n++;
+                }
+                index++;
+            }
+
+            BSONObjBuilder b;
+            b.append( "ok", 1 );
+            b.append( "n", n );
+            if ( type == "update" )
+                b.append( "nModified", n );
+            if ( errors.arrSize() )
+                b.append( "writeErrors", errors.arr() );
+            return b.obj();
+        }
+
+        MSGID _nextId;
+        std::deque< std::pair<MSGID, BSONObj> > _pending;
+        size_t _maxInFlight;
+    };
+
+    TEST(DBClientBulkWriter, SplitsAtMaxBatchSize) {
+        FakeWriteConnection conn;
+        DBClientBulkWriter bulk( &conn, "test.foo", false );
+        for ( int i = 0; i < 2500; i++ )
+            bulk.insert( BSON( "_id" << i ) );
+        ASSERT_EQUALS( 2500U, bulk.numWrites() );
+
+        BatchedCommandResponse response;
+        ASSERT_OK( bulk.execute( BSON( "w" << 1 ), &response ) );
+        ASSERT_EQUALS( 0U, bulk.numWrites() );
+        ASSERT_EQUALS( 2500, response.getN() );
+        ASSERT( !response.isErrDetailsSet() );
+
+        ASSERT_EQUALS( 3U, conn.commands.size() );
+        ASSERT_EQUALS( "foo", conn.commands[0]["insert"].str() );
+        ASSERT_EQUALS( 1000, conn.commands[0]["documents"].Obj().nFields() );
+        ASSERT_EQUALS( 500, conn.commands[2]["documents"].Obj().nFields() );
+        ASSERT_EQUALS( BSON( "w" << 1 ), conn.commands[0]["writeConcern"].Obj() );
+
+        // All three were sent before the first reply was read.
+        ASSERT_EQUALS( 3U, conn.maxInFlight() );
+    }
+
+    TEST(DBClientBulkWriter, SplitsAtMaxMessageSize) {
+        FakeWriteConnection conn;
+        DBClientBulkWriter bulk( &conn, "test.foo", false );
+        const std::string big( 1024 * 1024, 'x' );
+        for ( int i = 0; i < 40; i++ )
+            bulk.insert( BSON( "_id" << i << "big" << big ) );
+
+        BatchedCommandResponse response;
+        ASSERT_OK( bulk.execute( BSONObj(), &response ) );
+        ASSERT_EQUALS( 40, response.getN() );
+        ASSERT_EQUALS( 3U, conn.commands.size() );
+        for ( size_t i = 0; i < conn.commands.size(); i++ )
+            ASSERT_LESS_THAN_OR_EQUALS( conn.commands[i].objsize(), BSONObjMaxInternalSize );
+    }
+
+    TEST(DBClientBulkWriter, InFlightLimit) {
+        FakeWriteConnection conn;
+        DBClientBulkWriter bulk( &conn, "test.foo", false );
+        bulk.setMaxBatchesInFlight( 2 );
+        for ( int i = 0; i < 5000; i++ )
+            bulk.insert( BSON( "_id" << i ) );
+
+        BatchedCommandResponse response;
+        ASSERT_OK( bulk.execute( BSONObj(), &response ) );
+        ASSERT_EQUALS( 5000, response.getN() );
+        ASSERT_EQUALS( 5U, conn.commands.size() );
+        ASSERT_EQUALS( 2U, conn.maxInFlight() );
+    }
+
+    TEST(DBClientBulkWriter, OrderedKeepsOrder) {
+        FakeWriteConnection conn;
+        DBClientBulkWriter bulk( &conn, "test.foo", true );
+        bulk.insert( BSON( "_id" << 1 ) );
+        bulk.insert( BSON( "_id" << 2 ) );
+        bulk.update( BSON( "_id" << 1 ), BSON( "$set" << BSON( "x" << 1 ) ), true, false );
+        bulk.remove( BSON( "_id" << 2 ), true );
+        bulk.insert( BSON( "_id" << 3 ) );
+
+        BatchedCommandResponse response;
+        ASSERT_OK( bulk.execute( BSONObj(), &response ) );
+        ASSERT_EQUALS( 5, response.getN() );
+        ASSERT_EQUALS( 1, response.getNModified() );
+
+        ASSERT_EQUALS( 4U, conn.commands.size() );
+        ASSERT_EQUALS( "insert", StringData( conn.commands[0].firstElementFieldName() ) );
+        ASSERT_EQUALS( "update", StringData( conn.commands[1].firstElementFieldName() ) );
+        ASSERT_EQUALS( "delete", StringData( conn.commands[2].firstElementFieldName() ) );
+        ASSERT_EQUALS( "insert", StringData( conn.commands[3].firstElementFieldName() ) );
+        ASSERT( conn.commands[0]["ordered"].trueValue() );
+        ASSERT_EQUALS( 1, conn.maxInFlight() );
+
+        BSONObj update = conn.commands[1]["updates"].Obj().firstElement().Obj();
+        ASSERT( update["upsert"].trueValue() );
+        ASSERT( !update["multi"].trueValue() );
+        BSONObj del = conn.commands[2]["deletes"].Obj().firstElement().Obj();
+        ASSERT_EQUALS( 1, del["limit"].numberInt() );
+    }
+
+    TEST(DBClientBulkWriter, OrderedStopsAtError) {
+        FakeWriteConnection conn;
+        DBClientBulkWriter bulk( &conn, "test.foo", true );
+        bulk.insert( BSON( "_id" << 1 ) );
+        bulk.insert( BSON( "_id" << 2 << "fail" << true ) );
+        bulk.insert( BSON( "_id" << 3 ) );
+        bulk.remove( BSON( "_id" << 1 ), false );
+
+        BatchedCommandResponse response;
+        ASSERT_OK( bulk.execute( BSONObj(), &response ) );
+        ASSERT_EQUALS( 1, response.getN() );
+        ASSERT_EQUALS( 1U, response.sizeErrDetails() );
+        ASSERT_EQUALS( 1, response.getErrDetailsAt( 0 )->getIndex() );
+
+        // The delete after the failed batch was never sent.
+        ASSERT_EQUALS( 1U, conn.commands.size() );
+    }
+
+    TEST(DBClientBulkWriter, UnorderedErrorIndexes) {
+        FakeWriteConnection conn;
+        DBClientBulkWriter bulk( &conn, "test.foo", false );
+        bulk.remove( BSON( "fail" << true ), true );
+        bulk.insert( BSON( "_id" << 1 ) );
+        bulk.update( BSON( "fail" << true ), BSON( "$set" << BSON( "x" << 1 ) ), false, true );
+        bulk.insert( BSON( "_id" << 2 << "fail" << true ) );
+        bulk.insert( BSON( "_id" << 3 ) );
+
+        BatchedCommandResponse response;
+        ASSERT_OK( bulk.execute( BSONObj(), &response ) );
+        ASSERT_EQUALS( 2, response.getN() );
+
+        // Grouped by type, but the errors refer to the writes' positions in the queue.
+        ASSERT_EQUALS( 3U, conn.commands.size() );
+        ASSERT_EQUALS( 3U, response.sizeErrDetails() );
+        ASSERT_EQUALS( 0, response.getErrDetailsAt( 0 )->getIndex() );
+        ASSERT_EQUALS( 2, response.getErrDetailsAt( 1 )->getIndex() );
+        ASSERT_EQUALS( 3, response.getErrDetailsAt( 2 )->getIndex() );
+    }
+
+    TEST(DBClientBulkWriter, RequiresWriteCommands) {
+        FakeWriteConnection conn;
+        conn.setWireVersions( 0, 0 );
+        DBClientBulkWriter bulk( &conn, "test.foo", false );
+        bulk.insert( BSON( "_id" << 1 ) );
+
+        BatchedCommandResponse response;
+        ASSERT_EQUALS( ErrorCodes::CommandNotSupported,
+                       bulk.execute( BSONObj(), &response ).code() );
+        ASSERT( conn.commands.empty() );
+    }
+
+} // namespace
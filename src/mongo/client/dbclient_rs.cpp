@@ -41,6 +41,7 @@
 #include "mongo/db/dbmessage.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/util/log.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -68,6 +69,36 @@ namespace {
         }
     } _populateReadPrefSecOkCmdList;
 
+    /**
+     * Reports an operation on a replica set member to the set's monitor for the lifetime of this
+     * object, so that load aware host selection sees its latency and that it is in flight.
+     */
+    class MonitoredOperation {
+        MONGO_DISALLOW_COPYING(MonitoredOperation);
+    public:
+        MonitoredOperation(const ReplicaSetMonitorPtr& monitor, const HostAndPort& host)
+            : _monitor(ReplicaSetMonitor::useLoadAwareHostSelection ? monitor
+                                                                    : ReplicaSetMonitorPtr())
+            , _host(host)
+            , _succeeded(false) {
+            if (_monitor)
+                _monitor->startedOperation(_host);
+        }
+
+        ~MonitoredOperation() {
+            if (_monitor)
+                _monitor->finishedOperation(_host, _succeeded ? _timer.micros() : -1);
+        }
+
+        void succeeded() { _succeeded = true; }
+
+    private:
+        const ReplicaSetMonitorPtr _monitor; // NULL when not reporting
+        const HostAndPort _host;
+        const Timer _timer;
+        bool _succeeded;
+    };
+
     /**
      * Extracts the read preference settings from the query document. Note that this method
      * assumes that the query is ok for secondaries so it defaults to
@@ -542,9 +573,11 @@ namespace {
                         break;
                     }
 
+                    MonitoredOperation op(_getMonitor(), _lastSlaveOkHost);
                     auto_ptr<DBClientCursor> cursor = conn->query(ns, query,
                             nToReturn, nToSkip, fieldsToReturn, queryOptions,
                             batchSize);
+                    op.succeeded();
 
                     return checkSlaveQueryResult(cursor);
                 }
@@ -602,7 +635,11 @@ namespace {
                         break;
                     }
 
-                    return conn->findOne(ns,query,fieldsToReturn,queryOptions);
+                    MonitoredOperation op(_getMonitor(), _lastSlaveOkHost);
+                    BSONObj result = conn->findOne(ns,query,fieldsToReturn,queryOptions);
+                    op.succeeded();
+
+                    return result;
                 }
                 catch ( const DBException &dbExcep ) {
                     StringBuilder errMsgBuilder;
@@ -962,7 +999,12 @@ namespace {
                             *actualServer = conn->getServerAddress();
                         }
 
-                        return conn->call(toSend, response, assertOk);
+                        MonitoredOperation op(_getMonitor(), _lastSlaveOkHost);
+                        const bool ok = conn->call(toSend, response, assertOk);
+                        if (ok)
+                            op.succeeded();
+
+                        return ok;
                     }
                     catch ( const DBException& dbExcep ) {
                         LOG(1) << "can't call replica set node " << _lastSlaveOkHost << ": "
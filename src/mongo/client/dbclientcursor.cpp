@@ -147,21 +147,30 @@ namespace mongo {
         return ok;
     }
 
+    void DBClientCursor::_assembleGetMore( Message& toSend ) {
+        BufBuilder b;
+        b.appendNum(opts);
+        b.appendStr(ns);
+        b.appendNum(nextBatchSize());
+        b.appendNum(cursorId);
+        toSend.setData(dbGetMore, b.buf(), b.len());
+    }
+
     void DBClientCursor::requestMore() {
         verify( cursorId && batch.pos == batch.nReturned );
 
+        if ( _readAheadConn ) {
+            _receiveReadAhead();
+            return;
+        }
+
         if (haveLimit) {
             nToReturn -= batch.nReturned;
             verify(nToReturn > 0);
         }
-        BufBuilder b;
-        b.appendNum(opts);
-        b.appendStr(ns);
-        b.appendNum(nextBatchSize());
-        b.appendNum(cursorId);
 
         Message toSend;
-        toSend.setData(dbGetMore, b.buf(), b.len());
+        _assembleGetMore( toSend );
         auto_ptr<Message> response(new Message());
 
         if ( _client ) {
@@ -178,9 +187,61 @@ namespace mongo {
             dataReceived();
             _client = 0;
             conn.done();
+            _sendReadAhead();
         }
     }
 
+    void DBClientCursor::enableReadAhead() {
+        if ( haveLimit || ( opts & ( QueryOption_CursorTailable | QueryOption_Exhaust ) ) )
+            return;
+
+        _readAhead = true;
+        _sendReadAhead();
+    }
+
+    void DBClientCursor::_sendReadAhead() {
+        // Only attached cursors get their getMores on a connection of their own.
+        if ( ! _readAhead || _readAheadConn || ! cursorId || _client || _scopedHost.empty() )
+            return;
+
+        try {
+            auto_ptr<ScopedDbConnection> conn( new ScopedDbConnection( _scopedHost ) );
+            if ( ! conn->get()->lazySupported() ) {
+                conn->done();
+                _readAhead = false;
+                return;
+            }
+
+            Message toSend;
+            _assembleGetMore( toSend );
+            conn->get()->say( toSend );
+            _readAheadConn = conn.release();
+        }
+        catch ( DBException& e ) {
+            // The next getMore will be sent synchronously and report any real problem.
+            LOG(1) << "read ahead getMore to " << _scopedHost << " failed: " << e.what() << endl;
+            _readAhead = false;
+        }
+    }
+
+    void DBClientCursor::_receiveReadAhead() {
+        boost::scoped_ptr<ScopedDbConnection> conn( _readAheadConn );
+        _readAheadConn = NULL;
+
+        auto_ptr<Message> response(new Message());
+        if ( ! conn->get()->recv( *response ) ) {
+            uasserted( 28604, str::stream() << "recv failed while reading ahead on cursor "
+                                            << cursorId << " from " << _scopedHost );
+        }
+
+        _client = conn->get();
+        this->batch.m = response;
+        dataReceived();
+        _client = 0;
+        conn->done();
+        _sendReadAhead();
+    }
+
     /** with QueryOption_Exhaust, the server just blasts data at us (marked at end with cursorid==0). */
     void DBClientCursor::exhaustReceiveMore() {
         verify( cursorId && batch.pos == batch.nReturned );
@@ -351,40 +412,63 @@ namespace mongo {
 
     DBClientCursor::~DBClientCursor() {
         DESTRUCTOR_GUARD (
+        _releaseReadAhead();
+        );
 
-        if ( cursorId && _ownCursor && ! inShutdown() ) {
-            BufBuilder b;
-            b.appendNum( (int)0 ); // reserved
-            b.appendNum( (int)1 ); // number
-            b.appendNum( cursorId );
-            
-            Message m;
-            m.setData( dbKillCursors , b.buf() , b.len() );
+        DESTRUCTOR_GUARD (
+        if ( cursorId && _ownCursor && ! inShutdown() )
+            _sendKillCursors( DBClientConnection::getLazyKillCursor() );
+        );
+    }
 
-            if ( _client ) {
+    void DBClientCursor::kill() {
+        _releaseReadAhead();
+        if ( cursorId && _ownCursor && ! inShutdown() )
+            _sendKillCursors( false );
+        cursorId = 0;
+    }
 
-                // Kill the cursor the same way the connection itself would.  Usually, non-lazily
-                if( DBClientConnection::getLazyKillCursor() )
-                    _client->sayPiggyBack( m );
-                else
-                    _client->say( m );
+    void DBClientCursor::_releaseReadAhead() {
+        if ( ! _readAheadConn )
+            return;
 
-            }
-            else {
-                verify( _scopedHost.size() );
-                ScopedDbConnection conn(_scopedHost);
+        // Read the outstanding reply so that the connection can go back to the pool. If that
+        // fails the connection is not returned.
+        boost::scoped_ptr<ScopedDbConnection> conn( _readAheadConn );
+        _readAheadConn = NULL;
 
-                if( DBClientConnection::getLazyKillCursor() )
-                    conn->sayPiggyBack( m );
-                else
-                    conn->say( m );
+        Message response;
+        if ( ! inShutdown() && conn->get()->recv( response ) )
+            conn->done();
+    }
+
+    void DBClientCursor::_sendKillCursors( bool piggyBack ) {
+        BufBuilder b;
+        b.appendNum( (int)0 ); // reserved
+        b.appendNum( (int)1 ); // number
+        b.appendNum( cursorId );
+
+        Message m;
+        m.setData( dbKillCursors , b.buf() , b.len() );
+
+        if ( _client ) {
+            if( piggyBack )
+                _client->sayPiggyBack( m );
+            else
+                _client->say( m );
 
-                conn.done();
-            }
         }
+        else {
+            verify( _scopedHost.size() );
+            ScopedDbConnection conn(_scopedHost);
 
-        );
-    }
+            if( piggyBack )
+                conn->sayPiggyBack( m );
+            else
+                conn->say( m );
 
+            conn.done();
+        }
+    }
 
 } // namespace mongo
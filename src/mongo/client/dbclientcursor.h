@@ -40,6 +40,7 @@
 namespace mongo {
 
     class AScopedConnection;
+    class ScopedDbConnection;
 
     /** for mock purposes only -- do not create variants of DBClientCursor, nor hang code here
         @see DBClientMockCursor
@@ -149,7 +150,9 @@ namespace mongo {
             resultFlags(0),
             cursorId(),
             _ownCursor( true ),
-            wasError( false ) {
+            wasError( false ),
+            _readAhead( false ),
+            _readAheadConn( NULL ) {
             _finishConsInit();
         }
 
@@ -165,7 +168,9 @@ namespace mongo {
             resultFlags(0),
             cursorId(_cursorId),
             _ownCursor(true),
-            wasError(false) {
+            wasError(false),
+            _readAhead(false),
+            _readAheadConn(NULL) {
             _finishConsInit();
         }
 
@@ -178,8 +183,23 @@ namespace mongo {
         */
         void decouple() { _ownCursor = false; }
 
+        /**
+         * Kills the cursor on the server right away, where the destructor may leave the
+         * killCursors to piggyback on the next message sent over the connection.  Results
+         * already received can still be read.
+         */
+        void kill();
+
         void attach( AScopedConnection * conn );
 
+        /**
+         * Keeps one batch in flight for a cursor that has been attach()ed: whenever a batch
+         * arrives, the getMore for the following one is sent right away on a pooled connection
+         * held by the cursor, and its reply is only read once the current batch is used up.
+         * Has no effect on tailable, exhaust or limited cursors.
+         */
+        void enableReadAhead();
+
         std::string originalHost() const { return _originalHost; }
 
         std::string getns() const { return ns; }
@@ -220,6 +240,8 @@ namespace mongo {
 
         int nextBatchSize();
         void _finishConsInit();
+        void _releaseReadAhead();
+        void _sendKillCursors( bool piggyBack );
 
         Batch batch;
         DBClientBase* _client;
@@ -245,6 +267,13 @@ namespace mongo {
         void requestMore();
         void exhaustReceiveMore(); // for exhaust
 
+        // read ahead, see enableReadAhead()
+        bool _readAhead;
+        ScopedDbConnection* _readAheadConn; // owned, non-NULL while a getMore is in flight
+        void _sendReadAhead();
+        void _receiveReadAhead();
+        void _assembleGetMore( Message& toSend );
+
         // Don't call from a virtual function
         void _assertIfNull() const { uassert(13348, "connection died", this); }
 
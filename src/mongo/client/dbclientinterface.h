@@ -96,13 +96,21 @@ namespace mongo {
          */
         QueryOption_PartialResults = 1 << 7 ,
 
+        /** The reply may come after replies to requests sent later on the same connection, and
+            the request may run at the same time as them.  Match replies to requests by their
+            responseTo.  Such a request gets its own last error.  Only the event-driven connection
+            executor of mongod takes advantage of this; otherwise it is ignored.
+         */
+        QueryOption_Pipelined = 1 << 8,
+
         QueryOption_AllSupported = QueryOption_CursorTailable |
             QueryOption_SlaveOk |
             QueryOption_OplogReplay |
             QueryOption_NoCursorTimeout |
             QueryOption_AwaitData |
             QueryOption_Exhaust |
-            QueryOption_PartialResults,
+            QueryOption_PartialResults |
+            QueryOption_Pipelined,
 
         QueryOption_AllSupportedForSharding = QueryOption_CursorTailable |
             QueryOption_SlaveOk |
@@ -42,6 +42,7 @@
 #endif
 
 #include "mongo/client/dbclientcursor.h"
+#include "mongo/util/md5.hpp"
 
 #ifndef MIN
 #define MIN(a,b) ( (a) < (b) ? (a) : (b) )
@@ -52,6 +53,67 @@ namespace mongo {
 
     const unsigned DEFAULT_CHUNK_SIZE = 255 * 1024;
 
+namespace {
+    // Chunks are inserted, and read back, in batches of about this many bytes, so that each
+    // message carries many chunks while staying well below the maximum message size.
+    const int kChunkBatchBytes = 8 * 1024 * 1024;
+
+    /**
+     * Sends a file's chunks as batched inserts spread round-robin over the upload connections,
+     * hashing the data as it goes so that the server need not read it all back for filemd5.
+     */
+    class ChunkWriter {
+    public:
+        ChunkWriter( const vector<DBClientBase*>& connections , const string& ns )
+            : _connections( connections ) , _ns( ns ) , _next( 0 ) , _batchBytes( 0 ) {
+            md5_init( &_md5 );
+        }
+
+        void add( const BSONObj& chunk , const char* data , int len ) {
+            md5_append( &_md5 , reinterpret_cast<const md5_byte_t*>( data ) , len );
+            _batch.push_back( chunk );
+            _batchBytes += chunk.objsize();
+            if ( _batchBytes >= kChunkBatchBytes )
+                flush();
+        }
+
+        /**
+         * Sends any remaining chunks and waits for every connection to finish its inserts.
+         * @return the md5 of the file's data
+         */
+        string finish( const string& name ) {
+            flush();
+            for ( size_t i = 0; i < _connections.size(); i++ ) {
+                BSONObj errObj = _connections[i]->getLastErrorDetailed();
+                uassert( 16428,
+                         str::stream() << "Error storing GridFS chunk for file: " << name
+                                       << ", error: " << errObj,
+                         DBClientWithCommands::getLastErrorString(errObj) == "" );
+            }
+
+            md5digest digest;
+            md5_finish( &_md5 , digest );
+            return digestToString( digest );
+        }
+
+    private:
+        void flush() {
+            if ( _batch.empty() )
+                return;
+            _connections[ _next++ % _connections.size() ]->insert( _ns , _batch );
+            _batch.clear();
+            _batchBytes = 0;
+        }
+
+        const vector<DBClientBase*>& _connections;
+        const string _ns;
+        size_t _next;
+        vector<BSONObj> _batch;
+        int _batchBytes;
+        md5_state_t _md5;
+    };
+} // namespace
+
     GridFSChunk::GridFSChunk( BSONObj o ) {
         _data = o;
     }
@@ -69,6 +131,7 @@ namespace mongo {
         _filesNS = dbName + "." + prefix + ".files";
         _chunksNS = dbName + "." + prefix + ".chunks";
         _chunkSize = DEFAULT_CHUNK_SIZE;
+        _uploadConnections.push_back( &client );
 
         client.ensureIndex( _filesNS , BSON( "filename" << 1 ) );
         client.ensureIndex( _chunksNS , BSON( "files_id" << 1 << "n" << 1 ) , /*unique=*/true );
@@ -87,6 +150,10 @@ namespace mongo {
         return _chunkSize;
     }
 
+    void GridFS::addUploadConnection( DBClientBase& client ) {
+        _uploadConnections.push_back( &client );
+    }
+
     BSONObj GridFS::storeFile( const char* data , size_t length , const string& remoteName , const string& contentType) {
         char const * const end = data + length;
 
@@ -94,17 +161,18 @@ namespace mongo {
         id.init();
         BSONObj idObj = BSON("_id" << id);
 
+        ChunkWriter writer( _uploadConnections , _chunksNS );
         int chunkNumber = 0;
         while (data < end) {
             int chunkLen = MIN(_chunkSize, (unsigned)(end-data));
             GridFSChunk c(idObj, chunkNumber, data, chunkLen);
-            _client.insert( _chunksNS.c_str() , c._data );
+            writer.add( c._data , data , chunkLen );
 
             chunkNumber++;
             data += chunkLen;
         }
 
-        return insertFile(remoteName, id, length, contentType);
+        return insertFile(remoteName, id, length, contentType, writer.finish( remoteName ));
     }
 
 
@@ -122,12 +190,13 @@ namespace mongo {
         id.init();
         BSONObj idObj = BSON("_id" << id);
 
+        const string name = remoteName.empty() ? fileName : remoteName;
+        ChunkWriter writer( _uploadConnections , _chunksNS );
+        boost::scoped_array<char> buf( new char[_chunkSize+1] );
         int chunkNumber = 0;
         gridfs_offset length = 0;
         while (!feof(fd)) {
-            //boost::scoped_array<char>buf (new char[_chunkSize+1]);
-            char * buf = new char[_chunkSize+1];
-            char* bufPos = buf;//.get();
+            char* bufPos = buf.get();
             unsigned int chunkLen = 0; // how much in the chunk now
             while(chunkLen != _chunkSize && !feof(fd)) {
                 int readLen = fread(bufPos, 1, _chunkSize - chunkLen, fd);
@@ -137,38 +206,27 @@ namespace mongo {
                 verify(chunkLen <= _chunkSize);
             }
 
-            GridFSChunk c(idObj, chunkNumber, buf, chunkLen);
-            _client.insert( _chunksNS.c_str() , c._data );
+            GridFSChunk c(idObj, chunkNumber, buf.get(), chunkLen);
+            writer.add( c._data , buf.get() , chunkLen );
 
             length += chunkLen;
             chunkNumber++;
-            delete[] buf;
         }
 
         if (fd != stdin)
             fclose( fd );
 
-        return insertFile((remoteName.empty() ? fileName : remoteName), id, length, contentType);
+        return insertFile(name, id, length, contentType, writer.finish( name ));
     }
 
-    BSONObj GridFS::insertFile(const string& name, const OID& id, gridfs_offset length, const string& contentType) {
-        // Wait for any pending writebacks to finish
-        BSONObj errObj = _client.getLastErrorDetailed();
-        uassert( 16428,
-                 str::stream() << "Error storing GridFS chunk for file: " << name
-                               << ", error: " << errObj,
-                 DBClientWithCommands::getLastErrorString(errObj) == "" );
-
-        BSONObj res;
-        if ( ! _client.runCommand( _dbName.c_str() , BSON( "filemd5" << id << "root" << _prefix ) , res ) )
-            throw UserException( 9008 , "filemd5 failed" );
-
+    BSONObj GridFS::insertFile(const string& name, const OID& id, gridfs_offset length,
+                               const string& contentType, const string& md5) {
         BSONObjBuilder file;
         file << "_id" << id
              << "filename" << name
              << "chunkSize" << _chunkSize
              << "uploadDate" << DATENOW
-             << "md5" << res["md5"]
+             << "md5" << md5
              ;
 
         if (length < 1024*1024*1024) { // 2^30
@@ -244,14 +302,42 @@ namespace mongo {
 
         const int num = getNumChunks();
 
+        // Read the chunks through one cursor in large batches rather than querying for each.
+        BSONObjBuilder b;
+        b.appendAs( _obj["_id"] , "files_id" );
+        const int batchSize = kChunkBatchBytes / std::max( getChunkSize() , 1 ) + 1;
+        auto_ptr<DBClientCursor> cursor =
+            _grid->_client.query( _grid->_chunksNS , Query( b.obj() ).sort( BSON( "n" << 1 ) ) ,
+                                  0 , 0 , NULL , 0 , batchSize );
+        uassert( 28648 , "GridFS chunk query failed" , cursor.get() );
+
+        md5_state_t st;
+        md5_init( &st );
         for ( int i=0; i<num; i++ ) {
-            GridFSChunk c = getChunk( i );
+            uassert( 10014 ,  "chunk is empty!" , cursor->more() );
+            BSONObj chunk = cursor->nextSafe();
+            uassert( 28649 ,
+                     str::stream() << "expected GridFS chunk " << i << " of file "
+                                   << getFilename() << ", got: " << chunk["n"] ,
+                     chunk["n"].isNumber() && chunk["n"].numberInt() == i );
+            GridFSChunk c( chunk );
 
             int len;
             const char * data = c.data( len );
+            md5_append( &st , reinterpret_cast<const md5_byte_t*>( data ) , len );
             out.write( data , len );
         }
 
+        // Check the data we wrote against the file's md5, when it has one.
+        if ( _obj["md5"].type() == String ) {
+            md5digest digest;
+            md5_finish( &st , digest );
+            uassert( 28650 ,
+                     str::stream() << "md5 of GridFS file " << getFilename() << " is "
+                                   << digestToString( digest ) << ", expected " << getMD5() ,
+                     digestToString( digest ) == getMD5() );
+        }
+
         return getContentLength();
     }
 
@@ -83,6 +83,13 @@ namespace mongo {
 
         unsigned int getChunkSize() const;
 
+        /**
+         * Spreads the chunk inserts of storeFile() over 'client' as well as the connection this
+         * GridFS was constructed with. 'client' must be connected to the same deployment and
+         * outlive this GridFS.
+         */
+        void addUploadConnection( DBClientBase& client );
+
         /**
          * puts the file reference by fileName into the db
          * @param fileName local filename relative to process
@@ -139,9 +146,11 @@ namespace mongo {
         std::string _filesNS;
         std::string _chunksNS;
         unsigned int _chunkSize;
+        std::vector<DBClientBase*> _uploadConnections;
 
         // insert fileobject. All chunks must be in DB.
-        BSONObj insertFile(const std::string& name, const OID& id, gridfs_offset length, const std::string& contentType);
+        BSONObj insertFile(const std::string& name, const OID& id, gridfs_offset length,
+                           const std::string& contentType, const std::string& md5);
 
         friend class GridFile;
     };
@@ -34,10 +34,13 @@
 
 #include "mongo/client/parallel.h"
 
+#include <algorithm>
+
 #include "mongo/client/connpool.h"
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/db/dbmessage.h"
 #include "mongo/db/query/lite_parsed_query.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/chunk.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/config.h"
@@ -51,6 +54,11 @@ namespace mongo {
 
     LabeledLevel pc( "pcursor", 2 );
 
+    // If true, each shard cursor of a query keeps its next getMore in flight while the current
+    // batch is merged, see DBClientCursor::enableReadAhead(). Every open cursor then holds one
+    // pooled connection per shard with results left.
+    MONGO_EXPORT_SERVER_PARAMETER(internalShardCursorReadAhead, bool, false);
+
     void ParallelSortClusteredCursor::init() {
         if ( _didInit )
             return;
@@ -283,6 +291,8 @@ namespace mongo {
         _numServers = _servers.size();
         _lastFrom = 0;
         _cursors = 0;
+        _mergeHeapBuilt = false;
+        _mergePending = -1;
 
         if( ! _qSpec.isEmpty() ){
             _needToSkip = _qSpec.ntoskip();
@@ -1085,6 +1095,8 @@ namespace mongo {
             PCMData& mdata = i->second;
 
             _cursors[ index ].reset( mdata.pcState->cursor.get(), &mdata );
+            if ( internalShardCursorReadAhead )
+                mdata.pcState->cursor->enableReadAhead();
             _servers.insert( ServerAndQuery( i->first.getConnString(), BSONObj() ) );
 
             index++;
@@ -1464,6 +1476,13 @@ namespace mongo {
             _needToSkip = n;
         }
 
+        if ( ! _sortKey.isEmpty() ) {
+            if ( ! _mergeHeapBuilt )
+                _buildMergeHeap();
+            _refillMerge();
+            return ! _mergeHeap.empty();
+        }
+
         for ( int i=0; i<_numServers; i++ ) {
             if (_cursors[i].get() && _cursors[i].get()->more())
                 return true;
@@ -1472,6 +1491,9 @@ namespace mongo {
     }
 
     BSONObj ParallelSortClusteredCursor::next() {
+        if ( ! _sortKey.isEmpty() )
+            return _nextSorted();
+
         BSONObj best = BSONObj();
         int bestFrom = -1;
 
@@ -1525,6 +1547,130 @@ namespace mongo {
         return best;
     }
 
+    namespace {
+
+        /**
+         * Orders cursor indexes for a min-heap on the results at the head of the cursors. Ties go
+         * to the lower index so that the merge is deterministic.
+         */
+        class MergeHeadGreater {
+        public:
+            MergeHeadGreater( const vector<BSONObj>& heads, const BSONObj& sortKey )
+                : _heads( heads ), _sortKey( sortKey ) { }
+
+            bool operator()( int lhs, int rhs ) const {
+                int comp = _heads[lhs].woSortOrder( _heads[rhs], _sortKey, true );
+                if ( comp != 0 )
+                    return comp > 0;
+                return lhs > rhs;
+            }
+
+        private:
+            const vector<BSONObj>& _heads;
+            const BSONObj& _sortKey;
+        };
+
+    } // namespace
+
+    void ParallelSortClusteredCursor::_buildMergeHeap() {
+        _mergeHeapBuilt = true;
+        _mergeHeads.resize( _numServers );
+        for ( int i = 0; i < _numServers; i++ ) {
+            _pushMergeCursor( i );
+        }
+    }
+
+    void ParallelSortClusteredCursor::_pushMergeCursor( int index ) {
+        DBClientCursor* cursor = _cursors[index].get();
+
+        // Unlike the unsorted path, only the cursor a result was just taken from can run out
+        // of its batch, so only it may need a getMore here.
+        if ( ! cursor || ! cursor->more() ) {
+            if ( _cursors[index].getMData() )
+                _cursors[index].getMData()->pcState->done = true;
+            _mergeHeads[index] = BSONObj();
+            return;
+        }
+
+        _mergeHeads[index] = cursor->peekFirst();
+        _mergeHeap.push_back( index );
+        std::push_heap( _mergeHeap.begin(), _mergeHeap.end(),
+                        MergeHeadGreater( _mergeHeads, _sortKey ) );
+    }
+
+    void ParallelSortClusteredCursor::_refillMerge() {
+        if ( _mergePending < 0 )
+            return;
+
+        const int index = _mergePending;
+        _mergePending = -1;
+        _pushMergeCursor( index );
+    }
+
+    BSONObj ParallelSortClusteredCursor::_nextSorted() {
+        if ( ! _mergeHeapBuilt )
+            _buildMergeHeap();
+        _refillMerge();
+
+        uassert( 10019, "no more elements", ! _mergeHeap.empty() );
+
+        std::pop_heap( _mergeHeap.begin(), _mergeHeap.end(),
+                       MergeHeadGreater( _mergeHeads, _sortKey ) );
+        const int bestFrom = _mergeHeap.back();
+        _mergeHeap.pop_back();
+        _lastFrom = bestFrom;
+
+        DBClientCursor* cursor = _cursors[bestFrom].get();
+        BSONObj best = cursor->next();
+
+        // Make sure the result data won't go away when the cursor fetches its next batch
+        if ( ! cursor->moreInCurrentBatch() ) {
+            best = best.getOwned();
+        }
+
+        if ( _cursors[bestFrom].getMData() )
+            _cursors[bestFrom].getMData()->pcState->count++;
+
+        // The cursor goes back into the heap on the next call, so that a caller which stops
+        // after this result does not make it fetch a batch which will never be read.
+        _mergePending = bestFrom;
+        return best;
+    }
+
+    void ParallelSortClusteredCursor::setShardBatchSize( int batchSize ) {
+        if ( ! _cursors )
+            return;
+
+        // A batch size of 1 would close the shard cursors after their next batch.
+        if ( batchSize == 1 )
+            batchSize = 2;
+
+        for ( int i = 0; i < _numServers; i++ ) {
+            if ( _cursors[i].get() )
+                _cursors[i].get()->setBatchSize( batchSize );
+        }
+    }
+
+    void ParallelSortClusteredCursor::killShardCursors() {
+        if ( ! _cursors )
+            return;
+
+        for ( int i = 0; i < _numServers; i++ ) {
+            DBClientCursor* cursor = _cursors[i].get();
+            if ( ! cursor || cursor->getCursorId() == 0 )
+                continue;
+
+            try {
+                cursor->kill();
+            }
+            catch ( DBException& e ) {
+                // The shard times the cursor out instead.
+                LOG( pc ) << "could not kill cursor " << cursor->getCursorId() << " on "
+                          << cursor->originalHost() << causedBy( e ) << endl;
+            }
+        }
+    }
+
     void ParallelSortClusteredCursor::_explain( map< string,list<BSONObj> >& out ) {
 
         set<Shard> shards;
@@ -239,11 +239,29 @@ namespace mongo {
 
         void explain(BSONObjBuilder& b);
 
+        /**
+         * Sets how many results each shard cursor asks for in its following getMores, 0 for
+         * the server default.  The first batch is sized by the query itself.
+         */
+        void setShardBatchSize( int batchSize );
+
+        /**
+         * Kills the cursors left open on the shards right away, once the caller knows it will
+         * not read any more results.
+         */
+        void killShardCursors();
+
     private:
         void _finishCons();
 
         void _explain( std::map< std::string,std::list<BSONObj> >& out );
 
+        // Sorted merge over the shard cursors, see _mergeHeap
+        void _buildMergeHeap();
+        void _pushMergeCursor( int index );
+        void _refillMerge();
+        BSONObj _nextSorted();
+
         void _markStaleNS( const NamespaceString& staleNS, const StaleConfigException& e, bool& forceReload, bool& fullReload );
         void _handleStaleNS( const NamespaceString& staleNS, bool forceReload, bool fullReload );
 
@@ -268,6 +286,17 @@ namespace mongo {
         DBClientCursorHolder * _cursors;
         int _needToSkip;
 
+        // Used instead of scanning every cursor when there is a _sortKey: a heap of the indexes
+        // of the cursors which still have results, ordered by the result at the head of each
+        // cursor, which is kept in _mergeHeads.
+        bool _mergeHeapBuilt;
+        std::vector<int> _mergeHeap;
+        std::vector<BSONObj> _mergeHeads;
+
+        // The cursor the last sorted result was taken from, which goes back into _mergeHeap on
+        // the next call to more() or next(), or -1.
+        int _mergePending;
+
         /**
          * Setups the shard version of the connection. When using a replica
          * set connection and the primary cannot be reached, the version
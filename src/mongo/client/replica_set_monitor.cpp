@@ -36,6 +36,7 @@
 #include <limits>
 
 #include "mongo/db/server_options.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/client/connpool.h"
 #include "mongo/client/replica_set_monitor_internal.h"
 #include "mongo/util/concurrency/mutex.h" // for StaticObserver
@@ -263,6 +264,15 @@ namespace {
     // Defaults to random selection as required by the spec
     bool ReplicaSetMonitor::useDeterministicHostSelection = false;
 
+    bool ReplicaSetMonitor::useLoadAwareHostSelection = false;
+
+    ExportedServerParameter<bool> LoadAwareHostSelectionSetting(
+                                        ServerParameterSet::getGlobal(),
+                                        "replMonitorLoadAwareSelection",
+                                        &ReplicaSetMonitor::useLoadAwareHostSelection,
+                                        true,
+                                        true);
+
     ReplicaSetMonitor::ReplicaSetMonitor(StringData name, const std::set<HostAndPort>& seeds)
             : _state(boost::make_shared<SetState>(name, seeds)) {
         LogstreamBuilder lsb = log();
@@ -321,6 +331,35 @@ namespace {
         DEV _state->checkInvariants();
     }
 
+    void ReplicaSetMonitor::startedOperation(const HostAndPort& host) {
+        boost::mutex::scoped_lock lk(_state->mutex);
+        Node* node = _state->findNode(host);
+        if (node)
+            node->inFlightOps++;
+    }
+
+    void ReplicaSetMonitor::finishedOperation(const HostAndPort& host, int64_t latencyMicros) {
+        boost::mutex::scoped_lock lk(_state->mutex);
+        Node* node = _state->findNode(host);
+        if (!node)
+            return;
+
+        // the node may have been removed and re-added while the operation was in flight
+        if (node->inFlightOps > 0)
+            node->inFlightOps--;
+
+        if (latencyMicros < 0)
+            return;
+
+        if (node->opLatencyMicros == Node::unknownLatency) {
+            node->opLatencyMicros = latencyMicros;
+        }
+        else {
+            // same smoothing as the isMaster latency
+            node->opLatencyMicros += (latencyMicros - node->opLatencyMicros) / 4;
+        }
+    }
+
     bool ReplicaSetMonitor::isPrimary(const HostAndPort& host) const {
         boost::mutex::scoped_lock lk(_state->mutex);
         Node* node = _state->findNode(host);
@@ -879,6 +918,15 @@ namespace {
         }
     }
 
+    int64_t Node::expectedWaitMicros() const {
+        const int64_t latency = opLatencyMicros != unknownLatency ? opLatencyMicros
+                                                                  : latencyMicros;
+        if (latency == unknownLatency)
+            return unknownLatency;
+
+        return latency * (1 + inFlightOps);
+    }
+
     ReplicaSetMonitor::ConfigChangeHook SetState::configChangeHook;
 
     SetState::SetState(StringData name, const std::set<HostAndPort>& seedNodes)
@@ -975,6 +1023,18 @@ namespace {
                     // only in tests
                     return matchingNodes[roundRobin++ % matchingNodes.size()]->host;
                 }
+                else if (ReplicaSetMonitor::useLoadAwareHostSelection) {
+                    // pick the less loaded of two random choices, which avoids herding every
+                    // client onto whichever node looked best at the last refresh
+                    const size_t first = rand.nextInt32(matchingNodes.size());
+                    size_t second = rand.nextInt32(matchingNodes.size() - 1);
+                    if (second >= first)
+                        second++;
+
+                    const Node* a = matchingNodes[first];
+                    const Node* b = matchingNodes[second];
+                    return (b->expectedWaitMicros() < a->expectedWaitMicros() ? b : a)->host;
+                }
                 else {
                     // normal case
                     return matchingNodes[rand.nextInt32(matchingNodes.size())]->host;
@@ -96,6 +96,18 @@ namespace mongo {
          */
         void failedHost(const HostAndPort& host);
 
+        /**
+         * Notifies this Monitor that an operation was sent to host. It counts as in flight until
+         * the matching call to finishedOperation.
+         */
+        void startedOperation(const HostAndPort& host);
+
+        /**
+         * Notifies this Monitor that an operation sent to host took latencyMicros to complete.
+         * Pass a negative latency if the operation failed, as it says nothing about the host.
+         */
+        void finishedOperation(const HostAndPort& host, int64_t latencyMicros);
+
         /**
          * Returns true if this node is the master based ONLY on local data. Be careful, return may
          * be stale.
@@ -212,6 +224,14 @@ namespace mongo {
          */
         static bool useDeterministicHostSelection;
 
+        /**
+         * Defaults to false, meaning that a host is picked uniformly at random among those within
+         * the latency threshold of the closest. When true, two of those hosts are drawn at random
+         * and the one expected to answer sooner, given its recent operation latency and its
+         * operations in flight, is picked. Set by the replMonitorLoadAwareSelection parameter.
+         */
+        static bool useLoadAwareHostSelection;
+
     private:
         const SetStatePtr _state; // never NULL
     };
@@ -84,7 +84,9 @@ namespace mongo {
         struct Node {
             explicit Node(const HostAndPort& host)
                     : host(host)
-                    , latencyMicros(unknownLatency) {
+                    , latencyMicros(unknownLatency)
+                    , opLatencyMicros(unknownLatency)
+                    , inFlightOps(0) {
                 markFailed();
             }
 
@@ -115,6 +117,13 @@ namespace mongo {
              */
             void update(const IsMasterReply& reply);
 
+            /**
+             * Returns how long an operation sent to this node now is expected to take, or
+             * unknownLatency if no latency is known. Prefers the latency of operations to the
+             * isMaster ping latency, and scales it by the operations already in flight.
+             */
+            int64_t expectedWaitMicros() const;
+
             // Intentionally chosen to compare worse than all known latencies.
             static const int64_t unknownLatency; // = numeric_limits<int64_t>::max()
 
@@ -122,6 +131,8 @@ namespace mongo {
             bool isUp;
             bool isMaster; // implies isUp
             int64_t latencyMicros; // unknownLatency if unknown
+            int64_t opLatencyMicros; // of operations reported to the monitor, same as above
+            int inFlightOps; // operations reported started but not yet finished
             BSONObj tags; // owned
         };
         typedef std::vector<Node> Nodes;
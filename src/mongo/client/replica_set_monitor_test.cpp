@@ -781,3 +781,46 @@ TEST(ReplicaSetMonitorTests, OutOfBandFailedHost) {
         }
     }
 }
+
+// Load aware selection prefers the node with fewer operations in flight and lower latency
+TEST(ReplicaSetMonitorTests, LoadAwareHostSelection) {
+    SetStatePtr state = boost::make_shared<SetState>("name", basicSeedsSet);
+    ReplicaSetMonitorPtr rsm = boost::make_shared<ReplicaSetMonitor>(state);
+
+    // "a" is the primary and "b" and "c" are equally close secondaries
+    for (size_t i = 0; i != basicSeeds.size(); ++i) {
+        Node* node = state->findNode(basicSeeds[i]);
+        ASSERT(node);
+        node->isUp = true;
+        node->isMaster = (i == 0);
+        node->latencyMicros = 1000;
+    }
+
+    const bool wasLoadAware = ReplicaSetMonitor::useLoadAwareHostSelection;
+    ReplicaSetMonitor::useLoadAwareHostSelection = true;
+
+    const ReadPreferenceSetting secondary(ReadPreference_SecondaryOnly, TagSet());
+    const HostAndPort b("b");
+    const HostAndPort c("c");
+
+    rsm->startedOperation(b);
+    for (int i = 0; i < 10; i++) {
+        ASSERT_EQUALS(state->getMatchingHost(secondary), c);
+    }
+
+    rsm->finishedOperation(b, 100);
+    ASSERT_EQUALS(state->findNode(b)->inFlightOps, 0);
+    ASSERT_EQUALS(state->findNode(b)->opLatencyMicros, 100);
+    for (int i = 0; i < 10; i++) {
+        ASSERT_EQUALS(state->getMatchingHost(secondary), b);
+    }
+
+    // failed operations leave the latency alone
+    rsm->startedOperation(c);
+    rsm->finishedOperation(c, -1);
+    ASSERT_EQUALS(state->findNode(c)->inFlightOps, 0);
+    ASSERT_EQUALS(state->findNode(c)->opLatencyMicros, Node::unknownLatency);
+    ASSERT_EQUALS(state->findNode(c)->expectedWaitMicros(), 1000);
+
+    ReplicaSetMonitor::useLoadAwareHostSelection = wasLoadAware;
+}
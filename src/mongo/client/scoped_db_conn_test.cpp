@@ -218,6 +218,7 @@ namespace mongo_test {
     public:
         void setUp() {
             _maxPoolSizePerHost = mongo::pool.getMaxPoolSize();
+            _maxInUsePerHost = mongo::pool.getMaxInUse();
             _dummyServer = new DummyServer(TARGET_PORT);
 
             _dummyServer->run(&dummyHandler);
@@ -242,6 +243,7 @@ namespace mongo_test {
             delete _dummyServer;
 
             mongo::pool.setMaxPoolSize(_maxPoolSizePerHost);
+            mongo::pool.setMaxInUse(_maxInUsePerHost);
         }
 
     protected:
@@ -303,6 +305,7 @@ namespace mongo_test {
 
         DummyServer* _dummyServer;
         uint32_t _maxPoolSizePerHost;
+        int _maxInUsePerHost;
     };
 
     TEST_F(DummyServerFixture, BasicScopedDbConnection) {
@@ -426,4 +429,31 @@ namespace mongo_test {
 
         conn1Again.done();
     }
+
+    TEST_F(DummyServerFixture, MaxInUseTimesOutAndFreesOnRelease) {
+        mongo::pool.setMaxInUse(2);
+
+        // A socket timeout bounds how long get() waits for a free connection
+        const double socketTimeout = 0.1;
+
+        ScopedDbConnection conn1(TARGET_HOST, socketTimeout);
+        ScopedDbConnection conn2(TARGET_HOST, socketTimeout);
+        ASSERT_THROWS(ScopedDbConnection conn3(TARGET_HOST, socketTimeout),
+                      mongo::UserException);
+
+        // Returning a connection to the pool frees its slot
+        conn1.done();
+        ScopedDbConnection conn3(TARGET_HOST, socketTimeout);
+
+        // So does destroying one
+        conn2.kill();
+        ScopedDbConnection conn4(TARGET_HOST, socketTimeout);
+
+        mongo::BSONObjBuilder stats;
+        mongo::pool.appendInfo(stats);
+        ASSERT_EQUALS(2, stats.obj()["totalInUse"].numberInt());
+
+        conn3.done();
+        conn4.done();
+    }
 }
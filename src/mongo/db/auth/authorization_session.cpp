@@ -53,6 +53,9 @@ namespace mongo {
 
 namespace {
     const std::string ADMIN_DBNAME = "admin";
+
+    // Bounds AuthorizationSession::_actionsForResourceMemo; it is emptied when full.
+    const size_t kMaxActionsForResourceMemoSize = 64;
 }  // namespace
 
     AuthorizationSession::AuthorizationSession(AuthzSessionExternalState* externalState) 
@@ -90,6 +93,7 @@ namespace {
         if (replacedUser) {
             getAuthorizationManager().releaseUser(replacedUser);
         }
+        _actionsForResourceMemo.clear();
 
         // If there are any users and roles in the impersonation data, clear it out.
         clearImpersonatedUserData();
@@ -106,6 +110,7 @@ namespace {
         User* removedUser = _authenticatedUsers.removeByDBName(dbname);
         if (removedUser) {
             getAuthorizationManager().releaseUser(removedUser);
+            _actionsForResourceMemo.clear();
         }
         clearImpersonatedUserData();
         _buildAuthenticatedRolesVector();
@@ -134,6 +139,7 @@ namespace {
 
     void AuthorizationSession::grantInternalAuthorization() {
         _authenticatedUsers.add(internalSecurity.user);
+        _actionsForResourceMemo.clear();
         _buildAuthenticatedRolesVector();
     }
 
@@ -457,6 +463,7 @@ namespace {
                     // Success! Replace the old User object with the updated one.
                     fassert(17067, _authenticatedUsers.replaceAt(it, updatedUser) == user);
                     authMan.releaseUser(user);
+                    _actionsForResourceMemo.clear();
                     LOG(1) << "Updated session cache of user information for " << name;
                     break;
                 }
@@ -464,6 +471,7 @@ namespace {
                     // User does not exist anymore; remove it from _authenticatedUsers.
                     fassert(17068, _authenticatedUsers.removeAt(it) == user);
                     authMan.releaseUser(user);
+                    _actionsForResourceMemo.clear();
                     log() << "Removed deleted user " << name <<
                         " from session cache of user information.";
                     continue;  // No need to advance "it" in this case.
@@ -495,9 +503,42 @@ namespace {
         }
     }
 
+    ActionSet AuthorizationSession::_getUserActionsForResource(const ResourcePattern& target) {
+        for (ActionsForResourceMemo::const_iterator it = _actionsForResourceMemo.begin();
+                it != _actionsForResourceMemo.end(); ++it) {
+            if (it->first == target)
+                return it->second;
+        }
+
+        ResourcePattern resourceSearchList[resourceSearchListCapacity];
+        const int resourceSearchListLength = buildResourceSearchList(target, resourceSearchList);
+
+        ActionSet actions;
+        for (UserSet::iterator it = _authenticatedUsers.begin();
+                it != _authenticatedUsers.end(); ++it) {
+            User* user = *it;
+            for (int i = 0; i < resourceSearchListLength; ++i) {
+                actions.addAllActionsFromSet(user->getActionsForResource(resourceSearchList[i]));
+            }
+        }
+
+        if (_actionsForResourceMemo.size() >= kMaxActionsForResourceMemoSize)
+            _actionsForResourceMemo.clear();
+        _actionsForResourceMemo.push_back(std::make_pair(target, actions));
+        return actions;
+    }
+
     bool AuthorizationSession::_isAuthorizedForPrivilege(const Privilege& privilege) {
         const ResourcePattern& target(privilege.getResourcePattern());
 
+        // Default privileges only exist under the localhost exception.  Otherwise the answer
+        // depends only on the authenticated users, which is what the memo holds.
+        if (!_externalState->shouldAllowLocalhost()) {
+            ActionSet unmetRequirements = privilege.getActions();
+            unmetRequirements.removeAllActionsFromSet(_getUserActionsForResource(target));
+            return unmetRequirements.empty();
+        }
+
         ResourcePattern resourceSearchList[resourceSearchListCapacity];
         const int resourceSearchListLength = buildResourceSearchList(target, resourceSearchList);
 
@@ -29,6 +29,7 @@
 #pragma once
 
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "mongo/base/disallow_copying.h"
@@ -222,8 +223,18 @@ namespace mongo {
         // lock on the admin database (to update out-of-date user privilege information).
         bool _isAuthorizedForPrivilege(const Privilege& privilege);
 
+        // Returns every action the authenticated users may perform on "target", remembering the
+        // answer in _actionsForResourceMemo.  Does not include any default privileges.
+        ActionSet _getUserActionsForResource(const ResourcePattern& target);
+
         scoped_ptr<AuthzSessionExternalState> _externalState;
 
+        // Per-resource results of _getUserActionsForResource().  Only depends on the User objects
+        // in _authenticatedUsers, so it is cleared whenever that set changes and otherwise lives
+        // across requests.  Searched linearly, as a session touches few resources.
+        typedef std::vector<std::pair<ResourcePattern, ActionSet> > ActionsForResourceMemo;
+        ActionsForResourceMemo _actionsForResourceMemo;
+
         // All Users who have been authenticated on this connection.
         UserSet _authenticatedUsers;
         // The roles of the authenticated users. This vector is generated when the authenticated
@@ -39,6 +39,7 @@
 #include "mongo/db/operation_context_noop.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/map_util.h"
+#include "mongo/util/mongoutils/str.h"
 
 #define ASSERT_NULL(EXPR) ASSERT_FALSE(EXPR)
 #define ASSERT_NON_NULL(EXPR) ASSERT_TRUE(EXPR)
@@ -195,6 +196,57 @@ namespace {
                              testFooCollResource, ActionType::collMod));
     }
 
+    TEST_F(AuthorizationSessionTest, RepeatedChecksSeeAuthenticatedUserChanges) {
+        ASSERT_OK(managerState->insertPrivilegeDocument(&_txn,
+                "admin",
+                BSON("user" << "spencer" <<
+                     "db" << "test" <<
+                     "credentials" << BSON("MONGODB-CR" << "a") <<
+                     "roles" << BSON_ARRAY(BSON("role" << "read" <<
+                                                "db" << "test"))),
+                BSONObj()));
+        ASSERT_OK(managerState->insertPrivilegeDocument(&_txn,
+                "admin",
+                BSON("user" << "admin" <<
+                     "db" << "admin" <<
+                     "credentials" << BSON("MONGODB-CR" << "a") <<
+                     "roles" << BSON_ARRAY(BSON("role" << "readWriteAnyDatabase" <<
+                                                "db" << "admin"))),
+                BSONObj()));
+        ASSERT_OK(authzSession->addAndAuthorizeUser(&_txn, UserName("spencer", "test")));
+
+        ActionSet findAndInsert;
+        findAndInsert.addAction(ActionType::find);
+        findAndInsert.addAction(ActionType::insert);
+
+        for (int i = 0; i < 2; ++i) {
+            ASSERT_TRUE(authzSession->isAuthorizedForActionsOnResource(
+                                testFooCollResource, ActionType::find));
+            ASSERT_FALSE(authzSession->isAuthorizedForActionsOnResource(
+                                 testFooCollResource, ActionType::insert));
+            ASSERT_FALSE(authzSession->isAuthorizedForActionsOnResource(
+                                 testFooCollResource, findAndInsert));
+        }
+
+        // A newly authenticated user's privileges are seen by the next check on the same resource.
+        ASSERT_OK(authzSession->addAndAuthorizeUser(&_txn, UserName("admin", "admin")));
+        ASSERT_TRUE(authzSession->isAuthorizedForActionsOnResource(
+                            testFooCollResource, findAndInsert));
+
+        authzSession->logoutDatabase("admin");
+        ASSERT_TRUE(authzSession->isAuthorizedForActionsOnResource(
+                            testFooCollResource, ActionType::find));
+        ASSERT_FALSE(authzSession->isAuthorizedForActionsOnResource(
+                             testFooCollResource, findAndInsert));
+
+        // Checks on many resources must not lose track of any of them.
+        for (int i = 0; i < 100; ++i) {
+            const NamespaceString ns(std::string(mongoutils::str::stream() << "test.coll" << i));
+            ASSERT_TRUE(authzSession->isAuthorizedForActionsOnNamespace(ns, ActionType::find));
+            ASSERT_FALSE(authzSession->isAuthorizedForActionsOnNamespace(ns, ActionType::insert));
+        }
+    }
+
     TEST_F(AuthorizationSessionTest, DuplicateRolesOK) {
         // Add a user with doubled-up readWrite and single dbAdmin on the test DB
         ASSERT_OK(managerState->insertPrivilegeDocument(&_txn,
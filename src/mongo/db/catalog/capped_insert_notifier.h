@@ -0,0 +1,86 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/platform/cstdint.h"
+
+namespace mongo {
+
+    /**
+     * Lets tailable awaitData cursors on a capped collection sleep until an insert into it
+     * commits, rather than polling.
+     *
+     * Waiters read getVersion() before looking for new data and, if there was none, call
+     * waitForInsert() with that version: an insert which commits in between has already bumped
+     * the version, so the wait returns at once and no insert can be missed.
+     *
+     * The Collection holds it through a shared_ptr which waiters copy before releasing their
+     * locks, so that it outlives a drop of the collection; the drop kill()s it.
+     */
+    class CappedInsertNotifier {
+        MONGO_DISALLOW_COPYING(CappedInsertNotifier);
+    public:
+        CappedInsertNotifier();
+
+        /**
+         * Wakes all waiters.  Called once an insert into the collection has committed.
+         */
+        void notifyAll();
+
+        /**
+         * Changes each time notifyAll() is called.
+         */
+        uint64_t getVersion() const;
+
+        /**
+         * Waits until the version is no longer 'prevVersion', the notifier is killed, or
+         * 'timeoutMillis' have passed, whichever is first.
+         */
+        void waitForInsert(uint64_t prevVersion, int64_t timeoutMillis) const;
+
+        /**
+         * Wakes all waiters for good: the collection is gone.
+         */
+        void kill();
+
+        bool isDead() const;
+
+    private:
+        mutable boost::mutex _mutex;
+        mutable boost::condition_variable _notifier;
+
+        uint64_t _version;
+        bool _dead;
+    };
+
+}  // namespace mongo
@@ -0,0 +1,97 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/catalog/capped_insert_notifier.h"
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+namespace {
+
+    void notifyAfter(CappedInsertNotifier* notifier, int millis) {
+        sleepmillis(millis);
+        notifier->notifyAll();
+    }
+
+    void killAfter(CappedInsertNotifier* notifier, int millis) {
+        sleepmillis(millis);
+        notifier->kill();
+    }
+
+    TEST(CappedInsertNotifier, StaleVersionReturnsAtOnce) {
+        CappedInsertNotifier notifier;
+        const uint64_t version = notifier.getVersion();
+        notifier.notifyAll();
+        ASSERT_NOT_EQUALS(version, notifier.getVersion());
+
+        Timer timer;
+        notifier.waitForInsert(version, 60 * 1000);
+        ASSERT_LESS_THAN(timer.millis(), 30 * 1000);
+    }
+
+    TEST(CappedInsertNotifier, WaitTimesOut) {
+        CappedInsertNotifier notifier;
+        Timer timer;
+        notifier.waitForInsert(notifier.getVersion(), 50);
+        ASSERT_GREATER_THAN_OR_EQUALS(timer.millis(), 40);
+    }
+
+    TEST(CappedInsertNotifier, InsertWakesWaiter) {
+        CappedInsertNotifier notifier;
+        const uint64_t version = notifier.getVersion();
+        boost::thread inserter(boost::bind(notifyAfter, &notifier, 20));
+
+        Timer timer;
+        notifier.waitForInsert(version, 60 * 1000);
+        ASSERT_LESS_THAN(timer.millis(), 30 * 1000);
+        ASSERT_NOT_EQUALS(version, notifier.getVersion());
+        inserter.join();
+    }
+
+    TEST(CappedInsertNotifier, KillWakesWaiter) {
+        CappedInsertNotifier notifier;
+        const uint64_t version = notifier.getVersion();
+        boost::thread dropper(boost::bind(killAfter, &notifier, 20));
+
+        Timer timer;
+        notifier.waitForInsert(version, 60 * 1000);
+        ASSERT_LESS_THAN(timer.millis(), 30 * 1000);
+        ASSERT_TRUE(notifier.isDead());
+        ASSERT_EQUALS(version, notifier.getVersion());
+        dropper.join();
+    }
+
+}  // namespace
+}  // namespace mongo
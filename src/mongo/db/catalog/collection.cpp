@@ -47,6 +47,7 @@
 #include "mongo/db/storage/mmap_v1/mmap_v1_options.h"
 #include "mongo/db/storage/record_fetcher.h"
 #include "mongo/db/repl/repl_coordinator_global.h"
+#include "mongo/db/warmup.h"
 
 #include "mongo/db/auth/user_document_parser.h" // XXX-ANDY
 #include "mongo/util/log.h"
@@ -76,6 +77,24 @@ namespace mongo {
 
     // ----
 
+    namespace {
+        // Write generations are drawn from one sequence, so that a collection recreated under the
+        // same name never reuses the generation of its predecessor.
+        AtomicUInt64 writeGenerationSequence;
+
+        class BumpWriteGenerationChange : public RecoveryUnit::Change {
+        public:
+            explicit BumpWriteGenerationChange(const boost::shared_ptr<AtomicUInt64>& generation)
+                : _generation(generation) { }
+
+            virtual void commit() { _generation->store(writeGenerationSequence.addAndFetch(1)); }
+            virtual void rollback() { }
+
+        private:
+            const boost::shared_ptr<AtomicUInt64> _generation;
+        };
+    }
+
     Collection::Collection( OperationContext* txn,
                             const StringData& fullNS,
                             CollectionCatalogEntry* details,
@@ -87,15 +106,20 @@ namespace mongo {
           _database( database ),
           _infoCache( this ),
           _indexCatalog( this ),
-          _cursorCache( fullNS ) {
+          _cursorCache( fullNS ),
+          _writeGeneration( new AtomicUInt64( writeGenerationSequence.addAndFetch( 1 ) ) ) {
         _magic = 1357924;
         _indexCatalog.init(txn);
-        if ( isCapped() )
+        if ( isCapped() ) {
             _recordStore->setCappedDeleteCallback( this );
+            _cappedNotifier.reset( new CappedInsertNotifier() );
+        }
     }
 
     Collection::~Collection() {
         verify( ok() );
+        if ( _cappedNotifier )
+            _cappedNotifier->kill();
         _magic = 0;
     }
 
@@ -156,6 +180,7 @@ namespace mongo {
     }
 
     BSONObj Collection::docFor(OperationContext* txn, const RecordId& loc) const {
+        noteDocumentFetched(_ns.ns(), loc);
         return  _recordStore->dataFor( txn, loc ).releaseToBson();
     }
 
@@ -178,6 +203,8 @@ namespace mongo {
         if ( !loc.isOK() )
             return loc;
 
+        _notifyCappedWaitersOnCommit( txn );
+
         return StatusWith<RecordId>( loc );
     }
 
@@ -211,14 +238,74 @@ namespace mongo {
         if ( !status.isOK() )
             return StatusWith<RecordId>( status );
 
+        _notifyCappedWaitersOnCommit( txn );
+
         return loc;
     }
 
+    Status Collection::insertDocuments( OperationContext* txn,
+                                        const std::vector<BSONObj>& docs,
+                                        bool enforceQuota,
+                                        std::vector<RecordId>* locs ) {
+        // Capped deletes made while the batch is inserted could remove documents of the batch
+        // before they are indexed, so only unindexed capped collections (the oplog) batch.
+        invariant( !isCapped() || !_indexCatalog.haveAnyIndexes() );
+
+        const bool needsId = _indexCatalog.findIdIndex( txn ) != NULL;
+
+        std::vector<RecordData> records;
+        records.reserve( docs.size() );
+
+        for ( std::vector<BSONObj>::const_iterator it = docs.begin(); it != docs.end(); ++it ) {
+            if ( needsId && (*it)["_id"].eoo() ) {
+                return Status( ErrorCodes::InternalError,
+                               str::stream() << "Collection::insertDocuments got "
+                               "document without _id for ns:" << _ns.ns() );
+            }
+
+            records.push_back( RecordData( it->objdata(), it->objsize() ) );
+        }
+
+        std::vector<RecordId> inserted;
+        inserted.reserve( docs.size() );
+
+        Status status = _recordStore->insertRecords( txn,
+                                                     records,
+                                                     _enforceQuota( enforceQuota ),
+                                                     &inserted );
+        if ( !status.isOK() )
+            return status;
+
+        for ( size_t i = 0; i < inserted.size(); i++ ) {
+            invariant( RecordId::min() < inserted[i] );
+            invariant( inserted[i] < RecordId::max() );
+        }
+
+        _infoCache.notifyOfWriteOp();
+        _bumpWriteGenerationOnCommit( txn );
+
+        Status s = _indexCatalog.indexRecords( txn, docs, inserted );
+        if ( !s.isOK() )
+            return s;
+
+        _notifyCappedWaitersOnCommit( txn );
+
+        if ( locs )
+            locs->swap( inserted );
+
+        return Status::OK();
+    }
+
     RecordFetcher* Collection::documentNeedsFetch( OperationContext* txn,
                                                    const RecordId& loc ) const {
         return _recordStore->recordNeedsFetch( txn, loc );
     }
 
+    void Collection::prefetchDocuments( OperationContext* txn,
+                                        const std::vector<RecordId>& locs ) const {
+        _recordStore->prefetchRecords( txn, locs );
+    }
+
 
     StatusWith<RecordId> Collection::_insertDocument( OperationContext* txn,
                                                      const BSONObj& docToInsert,
@@ -239,14 +326,45 @@ namespace mongo {
         invariant( loc.getValue() < RecordId::max() );
 
         _infoCache.notifyOfWriteOp();
+        _bumpWriteGenerationOnCommit( txn );
 
         Status s = _indexCatalog.indexRecord(txn, docToInsert, loc.getValue());
         if (!s.isOK())
             return StatusWith<RecordId>(s);
 
+        _notifyCappedWaitersOnCommit( txn );
+
         return loc;
     }
 
+    namespace {
+        class NotifyCappedWaitersChange : public RecoveryUnit::Change {
+        public:
+            explicit NotifyCappedWaitersChange(const boost::shared_ptr<CappedInsertNotifier>& n)
+                : _notifier(n) { }
+
+            virtual void commit() { _notifier->notifyAll(); }
+            virtual void rollback() { }
+
+        private:
+            const boost::shared_ptr<CappedInsertNotifier> _notifier;
+        };
+    }
+
+    void Collection::_notifyCappedWaitersOnCommit( OperationContext* txn ) {
+        if ( !_cappedNotifier )
+            return;
+
+        // Waking on commit, rather than now, means waiters find the insert once they look.
+        txn->recoveryUnit()->registerChange( new NotifyCappedWaitersChange( _cappedNotifier ) );
+    }
+
+    void Collection::_bumpWriteGenerationOnCommit( OperationContext* txn ) {
+        // Bumping on commit, rather than now, means no reader can see the old generation along
+        // with the new data.
+        txn->recoveryUnit()->registerChange( new BumpWriteGenerationChange( _writeGeneration ) );
+    }
+
     Status Collection::aboutToDeleteCapped( OperationContext* txn, const RecordId& loc ) {
 
         BSONObj doc = docFor( txn, loc );
@@ -255,6 +373,7 @@ namespace mongo {
         _cursorCache.invalidateDocument(txn, loc, INVALIDATION_DELETION);
 
         _indexCatalog.unindexRecord(txn, doc, loc, false);
+        _bumpWriteGenerationOnCommit( txn );
 
         return Status::OK();
     }
@@ -287,6 +406,7 @@ namespace mongo {
         _recordStore->deleteRecord( txn, loc );
 
         _infoCache.notifyOfWriteOp();
+        _bumpWriteGenerationOnCommit( txn );
     }
 
     Counter64 moveCounter;
@@ -296,7 +416,8 @@ namespace mongo {
                                                     const RecordId& oldLocation,
                                                     const BSONObj& objNew,
                                                     bool enforceQuota,
-                                                    OpDebug* debug ) {
+                                                    OpDebug* debug,
+                                                    const FieldRefSet* updatedFields ) {
 
         BSONObj objOld = _recordStore->dataFor( txn, oldLocation ).releaseToBson();
 
@@ -315,11 +436,16 @@ namespace mongo {
 
         // At the end of this step, we will have a map of UpdateTickets, one per index, which
         // represent the index updates needed to be done, based on the changes between objOld and
-        // objNew.
+        // objNew.  Indexes over none of the updated fields keep their keys and get no ticket.
         OwnedPointerMap<IndexDescriptor*,UpdateTicket> updateTickets;
         IndexCatalog::IndexIterator ii = _indexCatalog.getIndexIterator( txn, true );
         while ( ii.more() ) {
             IndexDescriptor* descriptor = ii.next();
+            if ( updatedFields &&
+                 !_infoCache.updateAffectsIndex( txn, descriptor, *updatedFields ) ) {
+                continue;
+            }
+
             IndexAccessMethod* iam = _indexCatalog.getIndex( descriptor );
 
             InsertDeleteOptions options;
@@ -352,6 +478,7 @@ namespace mongo {
         // moved.
 
         _infoCache.notifyOfWriteOp();
+        _bumpWriteGenerationOnCommit( txn );
 
         // If the object did move, we need to add the new location to all indexes.
         if ( newLocation.getValue() != oldLocation ) {
@@ -378,10 +505,15 @@ namespace mongo {
         ii = _indexCatalog.getIndexIterator( txn, true );
         while ( ii.more() ) {
             IndexDescriptor* descriptor = ii.next();
+            std::map<IndexDescriptor*,UpdateTicket*>::const_iterator ticket =
+                updateTickets.map().find( descriptor );
+            if ( ticket == updateTickets.map().end() )
+                continue;
+
             IndexAccessMethod* iam = _indexCatalog.getIndex( descriptor );
 
             int64_t updatedKeys;
-            Status ret = iam->update(txn, *updateTickets.mutableMap()[descriptor], &updatedKeys);
+            Status ret = iam->update(txn, *ticket->second, &updatedKeys);
             if ( !ret.isOK() )
                 return StatusWith<RecordId>( ret );
             if ( debug )
@@ -413,6 +545,7 @@ namespace mongo {
 
         // Broadcast the mutation so that query results stay correct.
         _cursorCache.invalidateDocument(txn, loc, INVALIDATION_MUTATION);
+        _bumpWriteGenerationOnCommit( txn );
 
         return _recordStore->updateWithDamages( txn, loc, oldRec, damageSource, damages );
     }
@@ -496,6 +629,7 @@ namespace mongo {
             return status;
         _cursorCache.invalidateAll( false );
         _infoCache.reset( txn );
+        _bumpWriteGenerationOnCommit( txn );
 
         // 3) truncate record store
         status = _recordStore->truncate(txn);
@@ -512,11 +646,38 @@ namespace mongo {
         return Status::OK();
     }
 
+    Status Collection::addPartition(OperationContext* txn, Date_t when) {
+        return _details->addPartition(txn, when);
+    }
+
+    Status Collection::dropPartitionsBefore(OperationContext* txn,
+                                            Date_t before,
+                                            int* numDropped) {
+        *numDropped = 0;
+        std::vector<RecordId> strays;
+        Status status = _details->dropPartitionsBefore(txn, before, numDropped, &strays);
+        if (!status.isOK())
+            return status;
+
+        if (*numDropped) {
+            // The records of the dropped partitions are gone without deletion notices.
+            _cursorCache.invalidateAll(false);
+            _infoCache.notifyOfWriteOp();
+            _bumpWriteGenerationOnCommit(txn);
+        }
+
+        for (size_t i = 0; i < strays.size(); i++) {
+            deleteDocument(txn, strays[i], false, true);
+        }
+        return Status::OK();
+    }
+
     void Collection::temp_cappedTruncateAfter(OperationContext* txn,
                                               RecordId end,
                                               bool inclusive) {
         invariant( isCapped() );
         _recordStore->temp_cappedTruncateAfter( txn, end, inclusive );
+        _bumpWriteGenerationOnCommit( txn );
     }
 
     namespace {
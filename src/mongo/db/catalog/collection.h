@@ -30,10 +30,13 @@
 
 #pragma once
 
+#include <boost/shared_ptr.hpp>
 #include <string>
+#include <vector>
 
 #include "mongo/base/string_data.h"
 #include "mongo/bson/mutable/damage_vector.h"
+#include "mongo/db/catalog/capped_insert_notifier.h"
 #include "mongo/db/catalog/collection_cursor_cache.h"
 #include "mongo/db/catalog/collection_info_cache.h"
 #include "mongo/db/catalog/index_catalog.h"
@@ -42,6 +45,7 @@
 #include "mongo/db/record_id.h"
 #include "mongo/db/storage/capped_callback.h"
 #include "mongo/db/storage/record_store.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/platform/cstdint.h"
 
 namespace mongo {
@@ -95,6 +99,23 @@ namespace mongo {
         long long corruptDocuments;
     };
 
+    /**
+     * Progress of an online compaction, summed over the calls to Collection::compactTail().
+     */
+    struct CompactTailStats {
+        CompactTailStats() {
+            recordsMoved = 0;
+            extentsFreed = 0;
+            done = false;
+        }
+
+        long long recordsMoved;
+        long long extentsFreed;
+
+        // Set once there is nothing left to move, or no room to move it to.
+        bool done;
+    };
+
     /**
      * this is NOT safe through a yield right now
      * not sure if it will be, or what yet
@@ -185,6 +206,22 @@ namespace mongo {
                                             MultiIndexBlock* indexBlock,
                                             bool enforceQuota );
 
+        /**
+         * Inserts all of 'docs', with the same checks as insertDocument(), and then indexes them
+         * one index at a time rather than one document at a time.  Like insertDocument() this
+         * does NOT add missing _id fields.
+         *
+         * Stops at the first failure, leaving earlier documents written; the caller's
+         * WriteUnitOfWork must be rolled back in that case.  Not supported on indexed capped
+         * collections, which may delete documents of the batch before they are indexed.
+         *
+         * If 'locs' is not NULL it is filled with the RecordId of each document, in order.
+         */
+        Status insertDocuments( OperationContext* txn,
+                                const std::vector<BSONObj>& docs,
+                                bool enforceQuota,
+                                std::vector<RecordId>* locs = NULL );
+
         /**
          * If the document at 'loc' is unlikely to be in physical memory, the storage
          * engine gives us back a RecordFetcher functor which we can invoke in order
@@ -197,17 +234,25 @@ namespace mongo {
         RecordFetcher* documentNeedsFetch( OperationContext* txn,
                                            const RecordId& loc ) const;
 
+        /**
+         * Hints that the documents at 'locs' will be read soon.  See RecordStore::prefetchRecords.
+         */
+        void prefetchDocuments( OperationContext* txn,
+                                const std::vector<RecordId>& locs ) const;
+
         /**
          * updates the document @ oldLocation with newDoc
          * if the document fits in the old space, it is put there
          * if not, it is moved
+         * if 'updatedFields' is given, only indexes over those fields have their keys regenerated
          * @return the post update location of the doc (may or may not be the same as oldLocation)
          */
         StatusWith<RecordId> updateDocument( OperationContext* txn,
                                             const RecordId& oldLocation,
                                             const BSONObj& newDoc,
                                             bool enforceQuota,
-                                            OpDebug* debug );
+                                            OpDebug* debug,
+                                            const FieldRefSet* updatedFields = NULL );
 
         /**
          * right now not allowed to modify indexes
@@ -222,6 +267,14 @@ namespace mongo {
 
         StatusWith<CompactStats> compact(OperationContext* txn, const CompactOptions* options);
 
+        /**
+         * Moves up to 'maxRecords' documents out of the end of the collection, keeping indexes
+         * and cursors up to date, in its own write unit of work; see RecordStore::compactTail.
+         * Unlike compact() this only needs the collection lock and may be called again after
+         * yielding it.  'stats' accumulates over calls.
+         */
+        Status compactTail(OperationContext* txn, int maxRecords, CompactTailStats* stats);
+
         /**
          * removes all documents as fast as possible
          * indexes before and after will be the same
@@ -229,6 +282,18 @@ namespace mongo {
          */
         Status truncate(OperationContext* txn);
 
+        /**
+         * Adds the partition of a partitioned collection for the range "when" falls in.
+         */
+        Status addPartition(OperationContext* txn, Date_t when);
+
+        /**
+         * Removes the documents of a partitioned collection dated before the partition range
+         * "before" falls in, dropping the partitions which hold them. Kills the cursors of the
+         * collection if any partition is dropped.
+         */
+        Status dropPartitionsBefore(OperationContext* txn, Date_t before, int* numDropped);
+
         /**
          * @param full - does more checks
          * @param scanData - scans each document
@@ -264,6 +329,22 @@ namespace mongo {
 
         bool isCapped() const;
 
+        /**
+         * Notified as each insert into this capped collection commits; NULL if not capped.
+         * Waiters must keep the returned pointer, which stays valid after the collection is
+         * dropped, across releasing their locks.
+         */
+        boost::shared_ptr<CappedInsertNotifier> getCappedInsertNotifier() const {
+            return _cappedNotifier;
+        }
+
+        /**
+         * Changes, to a value no collection has had before, as each write to this collection
+         * commits. Caches of results computed from the collection compare it to tell whether
+         * they are still current.
+         */
+        unsigned long long getWriteGeneration() const { return _writeGeneration->load(); }
+
         uint64_t numRecords( OperationContext* txn ) const;
 
         uint64_t dataSize( OperationContext* txn ) const;
@@ -301,6 +382,16 @@ namespace mongo {
 
         bool _enforceQuota( bool userEnforeQuota ) const;
 
+        /**
+         * If capped, arranges for waiters on the collection to be woken when 'txn' commits.
+         */
+        void _notifyCappedWaitersOnCommit( OperationContext* txn );
+
+        /**
+         * Arranges for the write generation to change when 'txn' commits.
+         */
+        void _bumpWriteGenerationOnCommit( OperationContext* txn );
+
         int _magic;
 
         NamespaceString _ns;
@@ -315,6 +406,12 @@ namespace mongo {
         // should be about the data.
         mutable CollectionCursorCache _cursorCache;
 
+        // Only set for capped collections.
+        boost::shared_ptr<CappedInsertNotifier> _cappedNotifier;
+
+        // Shared with the pending changes which bump it, which may commit after we are dropped.
+        boost::shared_ptr<AtomicUInt64> _writeGeneration;
+
         friend class Database;
         friend class IndexCatalog;
         friend class NamespaceDetails;
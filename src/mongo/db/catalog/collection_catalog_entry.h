@@ -82,6 +82,22 @@ namespace mongo {
         virtual bool isIndexReady( OperationContext* txn,
                                    const StringData& indexName ) const = 0;
 
+        /**
+         * Returns what setIndexBuildCheckpoint() last saved for an index which is not ready, or
+         * an empty object if nothing was.
+         */
+        virtual BSONObj getIndexBuildCheckpoint( OperationContext* txn,
+                                                 const StringData& indexName ) const = 0;
+
+        /**
+         * Saves how far the build of an index which is not ready has got, so that it can be
+         * resumed after a restart. An empty object clears it. Catalogs which have nowhere to keep
+         * it ignore it.
+         */
+        virtual void setIndexBuildCheckpoint( OperationContext* txn,
+                                              const StringData& indexName,
+                                              const BSONObj& checkpoint ) = 0;
+
         virtual Status removeIndex( OperationContext* txn,
                                     const StringData& indexName ) = 0;
 
@@ -98,6 +114,28 @@ namespace mongo {
         virtual void updateTTLSetting( OperationContext* txn,
                                        const StringData& idxName,
                                        long long newExpireSeconds ) = 0;
+
+        // ------- partitions ----------
+
+        /**
+         * Adds the partition of a partitioned collection for the range "when" falls in. Adding
+         * one which exists is a no-op.
+         */
+        virtual Status addPartition( OperationContext* txn, Date_t when ) {
+            return Status( ErrorCodes::InvalidOptions, "collection is not partitioned" );
+        }
+
+        /**
+         * Drops the partitions of the ranges before the one "before" falls in, counting them in
+         * "numDropped". The documents of those ranges left in the default partition are listed
+         * in "strays" for the caller to delete.
+         */
+        virtual Status dropPartitionsBefore( OperationContext* txn,
+                                             Date_t before,
+                                             int* numDropped,
+                                             std::vector<RecordId>* strays ) {
+            return Status( ErrorCodes::InvalidOptions, "collection is not partitioned" );
+        }
     private:
         NamespaceString _ns;
     };
@@ -95,6 +95,40 @@ namespace mongo {
             MultiIndexBlock* _multiIndexBlock;
         };
 
+        /**
+         * Indexes each record compactTail() moves at its new location.  The old location has
+         * already been unindexed by Collection::recordStoreGoingToMove.
+         */
+        class CompactTailAdaptor : public RecordStoreCompactAdaptor {
+        public:
+            CompactTailAdaptor(OperationContext* txn, IndexCatalog* indexCatalog)
+                : _txn( txn ),
+                  _indexCatalog( indexCatalog ),
+                  _status( Status::OK() ) {
+            }
+
+            virtual bool isDataValid( const RecordData& recData ) {
+                return recData.toBson().valid();
+            }
+
+            virtual size_t dataSize( const RecordData& recData ) {
+                return recData.toBson().objsize();
+            }
+
+            virtual void inserted( const RecordData& recData, const RecordId& newLocation ) {
+                if ( !_status.isOK() )
+                    return;
+                _status = _indexCatalog->indexRecord( _txn, recData.toBson(), newLocation );
+            }
+
+            const Status& status() const { return _status; }
+
+        private:
+            OperationContext* _txn;
+            IndexCatalog* _indexCatalog;
+            Status _status;
+        };
+
     }
 
 
@@ -177,4 +211,32 @@ namespace mongo {
         return StatusWith<CompactStats>( stats );
     }
 
+    Status Collection::compactTail( OperationContext* txn,
+                                    int maxRecords,
+                                    CompactTailStats* stats ) {
+        if ( _indexCatalog.numIndexesInProgress( txn ) )
+            return Status( ErrorCodes::BadValue, "cannot compact when indexes in progress" );
+
+        CompactTailAdaptor adaptor( txn, &_indexCatalog );
+
+        // Only count this step once it has committed.
+        CompactTailStats stepStats;
+
+        WriteUnitOfWork wunit(txn);
+        Status status = _recordStore->compactTail( txn, maxRecords, this, &adaptor, &stepStats );
+        if ( !status.isOK() )
+            return status;
+        if ( !adaptor.status().isOK() )
+            return adaptor.status();
+
+        if ( stepStats.recordsMoved )
+            _infoCache.notifyOfWriteOp();
+        wunit.commit();
+
+        stats->recordsMoved += stepStats.recordsMoved;
+        stats->extentsFreed += stepStats.extentsFreed;
+        stats->done = stepStats.done;
+        return Status::OK();
+    }
+
 }  // namespace mongo
@@ -41,6 +41,7 @@
 #include "mongo/db/operation_context.h"
 #include "mongo/db/query/plan_executor.h"
 #include "mongo/platform/random.h"
+#include "mongo/util/concurrency/simplerwlock.h"
 #include "mongo/util/startup_test.h"
 
 namespace mongo {
@@ -110,18 +111,21 @@ namespace mongo {
         int64_t nextSeed();
 
     private:
-        SimpleMutex _mutex;
+        // Lookups, done for every killCursors and timeout pass, share the lock.
+        SimpleRWLock _lock;
 
         typedef unordered_map<unsigned,string> Map;
         Map _idToNS;
         unsigned _nextId;
 
+        SimpleMutex _randomMutex;
         SecureRandom* _secureRandom;
     } _globalCursorIdCache;
 
     GlobalCursorIdCache::GlobalCursorIdCache()
-        : _mutex( "GlobalCursorIdCache" ),
+        : _lock( "GlobalCursorIdCache" ),
           _nextId( 0 ),
+          _randomMutex( "GlobalCursorIdCacheRandom" ),
           _secureRandom( NULL ) {
     }
 
@@ -130,7 +134,7 @@ namespace mongo {
     }
 
     int64_t GlobalCursorIdCache::nextSeed() {
-        SimpleMutex::scoped_lock lk( _mutex );
+        SimpleMutex::scoped_lock lk( _randomMutex );
         if ( !_secureRandom )
             _secureRandom = SecureRandom::create();
         return _secureRandom->nextInt64();
@@ -139,7 +143,7 @@ namespace mongo {
     unsigned GlobalCursorIdCache::created( const std::string& ns ) {
         static const unsigned MAX_IDS = 1000 * 1000 * 1000;
 
-        SimpleMutex::scoped_lock lk( _mutex );
+        SimpleRWLock::Exclusive lk( _lock );
 
         fassert( 17359, _idToNS.size() < MAX_IDS );
 
@@ -157,7 +161,7 @@ namespace mongo {
     }
 
     void GlobalCursorIdCache::destroyed( unsigned id, const std::string& ns ) {
-        SimpleMutex::scoped_lock lk( _mutex );
+        SimpleRWLock::Exclusive lk( _lock );
         invariant( ns == _idToNS[id] );
         _idToNS.erase( id );
     }
@@ -165,7 +169,7 @@ namespace mongo {
     bool GlobalCursorIdCache::eraseCursor(OperationContext* txn, CursorId id, bool checkAuth) {
         string ns;
         {
-            SimpleMutex::scoped_lock lk( _mutex );
+            SimpleRWLock::Shared lk( _lock );
             unsigned nsid = idFromCursorId( id );
             Map::const_iterator it = _idToNS.find( nsid );
             if ( it == _idToNS.end() ) {
@@ -210,7 +214,7 @@ namespace mongo {
     std::size_t GlobalCursorIdCache::timeoutCursors(OperationContext* txn, int millisSinceLastCall) {
         vector<string> todo;
         {
-            SimpleMutex::scoped_lock lk( _mutex );
+            SimpleRWLock::Shared lk( _lock );
             for ( Map::const_iterator i = _idToNS.begin(); i != _idToNS.end(); ++i )
                 todo.push_back( i->second );
         }
@@ -267,7 +271,8 @@ namespace mongo {
 
     CollectionCursorCache::CollectionCursorCache( const StringData& ns )
         : _nss( ns ),
-          _mutex( "CollectionCursorCache" ) {
+          _randomMutex( "CollectionCursorCacheRandom" ),
+          _executorsMutex( "CollectionCursorCache" ) {
         _collectionCacheRuntimeId = _globalCursorIdCache.created( _nss.ns() );
         _random.reset( new PseudoRandom( _globalCursorIdCache.nextSeed() ) );
     }
@@ -278,7 +283,7 @@ namespace mongo {
     }
 
     void CollectionCursorCache::invalidateAll( bool collectionGoingAway ) {
-        SimpleMutex::scoped_lock lk( _mutex );
+        SimpleMutex::scoped_lock lk( _executorsMutex );
 
         for ( ExecSet::iterator it = _nonCachedExecutors.begin();
               it != _nonCachedExecutors.end();
@@ -291,9 +296,19 @@ namespace mongo {
         }
         _nonCachedExecutors.clear();
 
+        for ( int i = 0; i < kNumPartitions; i++ ) {
+            SimpleMutex::scoped_lock partitionLock( _partitions[i].mutex );
+            _invalidateAllCursors_inlock( &_partitions[i], collectionGoingAway );
+        }
+    }
+
+    void CollectionCursorCache::_invalidateAllCursors_inlock( CursorPartition* partition,
+                                                              bool collectionGoingAway ) {
+        CursorMap& cursors = partition->cursors;
+
         if ( collectionGoingAway ) {
             // we're going to wipe out the world
-            for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
+            for ( CursorMap::const_iterator i = cursors.begin(); i != cursors.end(); ++i ) {
                 ClientCursor* cc = i->second;
 
                 cc->kill();
@@ -315,7 +330,7 @@ namespace mongo {
             CursorMap newMap;
 
             // collection will still be around, just all PlanExecutors are invalid
-            for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
+            for ( CursorMap::const_iterator i = cursors.begin(); i != cursors.end(); ++i ) {
                 ClientCursor* cc = i->second;
 
                 // Note that a valid ClientCursor state is "no cursor no executor."  This is because
@@ -342,7 +357,7 @@ namespace mongo {
 
             }
 
-            _cursors = newMap;
+            cursors.swap( newMap );
         }
     }
 
@@ -355,7 +370,7 @@ namespace mongo {
             return;
         }
 
-        SimpleMutex::scoped_lock lk( _mutex );
+        SimpleMutex::scoped_lock lk( _executorsMutex );
 
         for ( ExecSet::iterator it = _nonCachedExecutors.begin();
               it != _nonCachedExecutors.end();
@@ -365,113 +380,139 @@ namespace mongo {
             exec->invalidate(txn, dl, type);
         }
 
-        for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-            PlanExecutor* exec = i->second->getExecutor();
-            if ( exec ) {
-                exec->invalidate(txn, dl, type);
+        for ( int p = 0; p < kNumPartitions; p++ ) {
+            SimpleMutex::scoped_lock partitionLock( _partitions[p].mutex );
+            const CursorMap& cursors = _partitions[p].cursors;
+            for ( CursorMap::const_iterator i = cursors.begin(); i != cursors.end(); ++i ) {
+                PlanExecutor* exec = i->second->getExecutor();
+                if ( exec ) {
+                    exec->invalidate(txn, dl, type);
+                }
             }
         }
     }
 
     std::size_t CollectionCursorCache::timeoutCursors( int millisSinceLastCall ) {
-        SimpleMutex::scoped_lock lk( _mutex );
-
-        vector<ClientCursor*> toDelete;
+        size_t numTimedOut = 0;
+
+        // Sweep one partition at a time, so lookups only wait for the partition being swept.
+        for ( int p = 0; p < kNumPartitions; p++ ) {
+            vector<ClientCursor*> toDelete;
+            {
+                SimpleMutex::scoped_lock lk( _partitions[p].mutex );
+                CursorMap& cursors = _partitions[p].cursors;
+
+                for ( CursorMap::iterator i = cursors.begin(); i != cursors.end(); ) {
+                    ClientCursor* cc = i->second;
+                    if ( cc->shouldTimeout( millisSinceLastCall ) ) {
+                        toDelete.push_back( cc );
+                        cursors.erase( i++ );
+                    }
+                    else {
+                        ++i;
+                    }
+                }
+            }
 
-        for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-            ClientCursor* cc = i->second;
-            if ( cc->shouldTimeout( millisSinceLastCall ) )
-                toDelete.push_back( cc );
-        }
+            // Once out of the map the cursors can't be found, so they are destroyed unlocked.
+            for ( vector<ClientCursor*>::const_iterator i = toDelete.begin();
+                    i != toDelete.end(); ++i ) {
+                ClientCursor* cc = *i;
+                cc->kill();
+                delete cc;
+            }
 
-        for ( vector<ClientCursor*>::const_iterator i = toDelete.begin();
-                i != toDelete.end(); ++i ) {
-            ClientCursor* cc = *i;
-            _deregisterCursor_inlock( cc );
-            cc->kill();
-            delete cc;
+            numTimedOut += toDelete.size();
         }
 
-        return toDelete.size();
+        return numTimedOut;
     }
 
     void CollectionCursorCache::registerExecutor( PlanExecutor* exec ) {
-        SimpleMutex::scoped_lock lk(_mutex);
+        SimpleMutex::scoped_lock lk(_executorsMutex);
         const std::pair<ExecSet::iterator, bool> result = _nonCachedExecutors.insert(exec);
         invariant(result.second); // make sure this was inserted
     }
 
     void CollectionCursorCache::deregisterExecutor( PlanExecutor* exec ) {
-        SimpleMutex::scoped_lock lk(_mutex);
+        SimpleMutex::scoped_lock lk(_executorsMutex);
         _nonCachedExecutors.erase(exec);
     }
 
     ClientCursor* CollectionCursorCache::find( CursorId id, bool pin ) {
-        SimpleMutex::scoped_lock lk( _mutex );
-        CursorMap::const_iterator it = _cursors.find( id );
-        if ( it == _cursors.end() )
+        CursorPartition& partition = _partitionFor( id );
+        SimpleMutex::scoped_lock lk( partition.mutex );
+        CursorMap::const_iterator it = partition.cursors.find( id );
+        if ( it == partition.cursors.end() )
             return NULL;
 
         ClientCursor* cursor = it->second;
         if ( pin ) {
             uassert( 12051,
                      "clientcursor already in use? driver problem?",
-                     !cursor->isPinned() );
-            cursor->setPinned();
+                     cursor->tryPin() );
         }
 
         return cursor;
     }
 
     void CollectionCursorCache::unpin( ClientCursor* cursor ) {
-        SimpleMutex::scoped_lock lk( _mutex );
-
         invariant( cursor->isPinned() );
         cursor->unsetPinned();
     }
 
     void CollectionCursorCache::getCursorIds( std::set<CursorId>* openCursors ) {
-        SimpleMutex::scoped_lock lk( _mutex );
-
-        for ( CursorMap::const_iterator i = _cursors.begin(); i != _cursors.end(); ++i ) {
-            ClientCursor* cc = i->second;
-            openCursors->insert( cc->cursorid() );
+        for ( int p = 0; p < kNumPartitions; p++ ) {
+            SimpleMutex::scoped_lock lk( _partitions[p].mutex );
+            const CursorMap& cursors = _partitions[p].cursors;
+            for ( CursorMap::const_iterator i = cursors.begin(); i != cursors.end(); ++i ) {
+                ClientCursor* cc = i->second;
+                openCursors->insert( cc->cursorid() );
+            }
         }
     }
 
     size_t CollectionCursorCache::numCursors(){
-        SimpleMutex::scoped_lock lk( _mutex );
-        return _cursors.size();
+        size_t total = 0;
+        for ( int p = 0; p < kNumPartitions; p++ ) {
+            SimpleMutex::scoped_lock lk( _partitions[p].mutex );
+            total += _partitions[p].cursors.size();
+        }
+        return total;
     }
 
-    CursorId CollectionCursorCache::_allocateCursorId_inlock() {
+    CursorId CollectionCursorCache::registerCursor( ClientCursor* cc ) {
+        invariant( cc );
         for ( int i = 0; i < 10000; i++ ) {
-            unsigned mypart = static_cast<unsigned>( _random->nextInt32() );
+            unsigned mypart;
+            {
+                SimpleMutex::scoped_lock lk( _randomMutex );
+                mypart = static_cast<unsigned>( _random->nextInt32() );
+            }
             CursorId id = cursorIdFromParts( _collectionCacheRuntimeId, mypart );
-            if ( _cursors.count( id ) == 0 )
+
+            CursorPartition& partition = _partitionFor( id );
+            SimpleMutex::scoped_lock lk( partition.mutex );
+            if ( partition.cursors.insert( CursorMap::value_type( id, cc ) ).second )
                 return id;
         }
         fassertFailed( 17360 );
     }
 
-    CursorId CollectionCursorCache::registerCursor( ClientCursor* cc ) {
-        invariant( cc );
-        SimpleMutex::scoped_lock lk( _mutex );
-        CursorId id = _allocateCursorId_inlock();
-        _cursors[id] = cc;
-        return id;
-    }
-
     void CollectionCursorCache::deregisterCursor( ClientCursor* cc ) {
-        SimpleMutex::scoped_lock lk( _mutex );
-        _deregisterCursor_inlock( cc );
+        invariant( cc );
+        CursorId id = cc->cursorid();
+        CursorPartition& partition = _partitionFor( id );
+        SimpleMutex::scoped_lock lk( partition.mutex );
+        partition.cursors.erase( id );
     }
 
     bool CollectionCursorCache::eraseCursor(OperationContext* txn, CursorId id, bool checkAuth) {
-        SimpleMutex::scoped_lock lk( _mutex );
+        CursorPartition& partition = _partitionFor( id );
+        SimpleMutex::scoped_lock lk( partition.mutex );
 
-        CursorMap::iterator it = _cursors.find( id );
-        if ( it == _cursors.end() ) {
+        CursorMap::iterator it = partition.cursors.find( id );
+        if ( it == partition.cursors.end() ) {
             if ( checkAuth )
                 audit::logKillCursorsAuthzCheck( txn->getClient(),
                                                  _nss,
@@ -493,15 +534,9 @@ namespace mongo {
                  !cursor->isPinned() );
 
         cursor->kill();
-        _deregisterCursor_inlock( cursor );
+        partition.cursors.erase( it );
         delete cursor;
         return true;
     }
 
-    void CollectionCursorCache::_deregisterCursor_inlock( ClientCursor* cc ) {
-        invariant( cc );
-        CursorId id = cc->cursorid();
-        _cursors.erase( id );
-    }
-
 }
@@ -104,9 +104,14 @@ namespace mongo {
          * @param pin - if true, will try to pin cursor
          *                  if pinned already, will assert
          *                  otherwise will pin
+         *
+         * Only locks the partition holding 'id'.
          */
         ClientCursor* find( CursorId id, bool pin );
 
+        /**
+         * Does not lock: the pin state is atomic, and a pinned cursor cannot be removed.
+         */
         void unpin( ClientCursor* cursor );
 
         // ----------------------
@@ -123,20 +128,42 @@ namespace mongo {
         static std::size_t timeoutCursorsGlobal(OperationContext* txn, int millisSinceLastCall);
 
     private:
-        CursorId _allocateCursorId_inlock();
-        void _deregisterCursor_inlock( ClientCursor* cc );
+        typedef std::map<CursorId,ClientCursor*> CursorMap;
+
+        /**
+         * The cursors are split by id over several partitions, each with its own lock, so that
+         * lookups of different cursors rarely contend.  When more than one lock is needed,
+         * _executorsMutex is taken before the partitions, which are taken in index order.
+         */
+        enum { kNumPartitions = 16 };
+
+        struct CursorPartition {
+            CursorPartition() : mutex( "CollectionCursorCache" ) { }
+
+            SimpleMutex mutex;
+            CursorMap cursors;
+        };
+
+        CursorPartition& _partitionFor( CursorId id ) {
+            // The low half of an id is random, see registerCursor().
+            return _partitions[static_cast<unsigned>( id ) % kNumPartitions];
+        }
+
+        void _invalidateAllCursors_inlock( CursorPartition* partition, bool collectionGoingAway );
 
         NamespaceString _nss;
         unsigned _collectionCacheRuntimeId;
+
+        // Only guards _random.
+        SimpleMutex _randomMutex;
         scoped_ptr<PseudoRandom> _random;
 
-        SimpleMutex _mutex;
+        SimpleMutex _executorsMutex;
 
         typedef unordered_set<PlanExecutor*> ExecSet;
         ExecSet _nonCachedExecutors;
 
-        typedef std::map<CursorId,ClientCursor*> CursorMap;
-        CursorMap _cursors;
+        CursorPartition _partitions[kNumPartitions];
     };
 
 }
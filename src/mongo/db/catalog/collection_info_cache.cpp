@@ -34,12 +34,16 @@
 
 #include "mongo/db/catalog/collection_info_cache.h"
 
+#include <algorithm>
+
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/concurrency/d_concurrency.h"
+#include "mongo/db/field_ref_set.h"
 #include "mongo/db/fts/fts_spec.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/index_legacy.h"
 #include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/util/debug_util.h"
 #include "mongo/util/log.h"
 
@@ -50,62 +54,93 @@ namespace mongo {
         : _collection( collection ),
           _keysComputed( false ),
           _planCache(new PlanCache(collection->ns().ns())),
-          _querySettings(new QuerySettings()) { }
+          _querySettings(new QuerySettings()),
+          _indexStatsNumRecords(0) { }
 
     void CollectionInfoCache::reset( OperationContext* txn ) {
         LOG(1) << _collection->ns().ns() << ": clearing plan cache - collection info cache reset";
         clearQueryCache();
         _keysComputed = false;
         computeIndexKeys( txn );
+        // The indexes the statistics describe may have changed.
+        setIndexStatistics(IndexStatisticsMap(), 0);
         // query settings is not affected by info cache reset.
         // index filters should persist throughout life of collection
     }
 
-    void CollectionInfoCache::computeIndexKeys( OperationContext* txn ) {
-        _indexedPaths.clear();
-
-        IndexCatalog::IndexIterator i = _collection->getIndexCatalog()->getIndexIterator(txn, true);
-        while (i.more()) {
-            IndexDescriptor* descriptor = i.next();
-
+namespace {
+        // Registers the paths whose values determine the keys of the index 'descriptor'.
+        void addIndexedPaths(const IndexDescriptor* descriptor, UpdateIndexData* indexedPaths) {
             if (descriptor->getAccessMethodName() != IndexNames::TEXT) {
                 BSONObj key = descriptor->keyPattern();
                 BSONObjIterator j(key);
                 while (j.more()) {
                     BSONElement e = j.next();
-                    _indexedPaths.addPath(e.fieldName());
+                    indexedPaths->addPath(e.fieldName());
                 }
             }
             else {
                 fts::FTSSpec ftsSpec(descriptor->infoObj());
 
                 if (ftsSpec.wildcard()) {
-                    _indexedPaths.allPathsIndexed();
+                    indexedPaths->allPathsIndexed();
                 }
                 else {
                     for (size_t i = 0; i < ftsSpec.numExtraBefore(); ++i) {
-                        _indexedPaths.addPath(ftsSpec.extraBefore(i));
+                        indexedPaths->addPath(ftsSpec.extraBefore(i));
                     }
                     for (fts::Weights::const_iterator it = ftsSpec.weights().begin();
                          it != ftsSpec.weights().end();
                          ++it) {
-                        _indexedPaths.addPath(it->first);
+                        indexedPaths->addPath(it->first);
                     }
                     for (size_t i = 0; i < ftsSpec.numExtraAfter(); ++i) {
-                        _indexedPaths.addPath(ftsSpec.extraAfter(i));
+                        indexedPaths->addPath(ftsSpec.extraAfter(i));
                     }
                     // Any update to a path containing "language" as a component could change the
                     // language of a subdocument.  Add the override field as a path component.
-                    _indexedPaths.addPathComponent(ftsSpec.languageOverrideField());
+                    indexedPaths->addPathComponent(ftsSpec.languageOverrideField());
                 }
             }
         }
+    } // namespace
+
+    void CollectionInfoCache::computeIndexKeys( OperationContext* txn ) {
+        _indexedPaths.clear();
+        _indexedPathsByIndex.clear();
+
+        IndexCatalog::IndexIterator i = _collection->getIndexCatalog()->getIndexIterator(txn, true);
+        while (i.more()) {
+            IndexDescriptor* descriptor = i.next();
+            addIndexedPaths(descriptor, &_indexedPaths);
+            addIndexedPaths(descriptor, &_indexedPathsByIndex[descriptor]);
+        }
 
         _keysComputed = true;
 
     }
 
+    bool CollectionInfoCache::updateAffectsIndex( OperationContext* txn,
+                                                  const IndexDescriptor* descriptor,
+                                                  const FieldRefSet& updatedFields ) {
+        if ( !_keysComputed )
+            computeIndexKeys( txn );
+
+        IndexedPathsByIndex::const_iterator it = _indexedPathsByIndex.find(descriptor);
+        if (it == _indexedPathsByIndex.end())
+            return true;
+
+        for (FieldRefSet::const_iterator field = updatedFields.begin();
+             field != updatedFields.end();
+             ++field) {
+            if (it->second.mightBeIndexed((*field)->dottedField()))
+                return true;
+        }
+        return false;
+    }
+
     void CollectionInfoCache::notifyOfWriteOp() {
+        _writesSinceAnalyze.fetchAndAdd(1);
         if (NULL != _planCache.get()) {
             _planCache->notifyOfWriteOp();
         }
@@ -125,4 +160,28 @@ namespace mongo {
         return _querySettings.get();
     }
 
+    void CollectionInfoCache::setIndexStatistics(const IndexStatisticsMap& stats,
+                                                 long long numRecords) {
+        boost::lock_guard<boost::mutex> lk(_indexStatsMutex);
+        _indexStats = stats;
+        _indexStatsNumRecords = numRecords;
+        _writesSinceAnalyze.store(0);
+    }
+
+    boost::shared_ptr<const IndexStatistics> CollectionInfoCache::getIndexStatistics(
+                                                        const BSONObj& keyPattern) const {
+        boost::lock_guard<boost::mutex> lk(_indexStatsMutex);
+        IndexStatisticsMap::const_iterator it = _indexStats.find(keyPattern);
+        if (it == _indexStats.end()) {
+            return boost::shared_ptr<const IndexStatistics>();
+        }
+
+        const double maxWrites = std::max(1LL, _indexStatsNumRecords)
+                                 * internalQueryPlannerStatisticsMaxWriteFraction;
+        if (_writesSinceAnalyze.load() > maxWrites) {
+            return boost::shared_ptr<const IndexStatistics>();
+        }
+        return it->second;
+    }
+
 }
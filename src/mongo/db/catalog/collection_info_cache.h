@@ -30,15 +30,22 @@
 
 #pragma once
 
+#include <map>
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 
+#include "mongo/db/query/index_statistics.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/query_settings.h"
 #include "mongo/db/update_index_data.h"
+#include "mongo/platform/atomic_word.h"
 
 namespace mongo {
 
     class Collection;
+    class FieldRefSet;
+    class IndexDescriptor;
 
     /**
      * this is for storing things that you want to cache about a single collection
@@ -68,6 +75,22 @@ namespace mongo {
          */
         QuerySettings* getQuerySettings() const;
 
+        typedef std::map<BSONObj, boost::shared_ptr<const IndexStatistics>, BSONObjCmp>
+            IndexStatisticsMap;
+
+        /**
+         * Replaces the index statistics gathered by 'analyze', keyed by index key pattern.
+         * 'numRecords' is the size of the collection when they were gathered.
+         */
+        void setIndexStatistics(const IndexStatisticsMap& stats, long long numRecords);
+
+        /**
+         * Returns the statistics for the index with 'keyPattern', or NULL if there are none or
+         * the collection has been written to too much since they were gathered.
+         */
+        boost::shared_ptr<const IndexStatistics> getIndexStatistics(
+                                                        const BSONObj& keyPattern) const;
+
         // -------------------
 
         /* get set of index keys for this namespace.  handy to quickly check if a given
@@ -79,6 +102,14 @@ namespace mongo {
             return _indexedPaths;
         }
 
+        /**
+         * Returns true if an update which modified 'updatedFields' may change the keys of the
+         * index 'descriptor', so that its keys must be regenerated.
+         */
+        bool updateAffectsIndex( OperationContext* txn,
+                                 const IndexDescriptor* descriptor,
+                                 const FieldRefSet& updatedFields );
+
         // ---------------------
 
         /**
@@ -99,6 +130,11 @@ namespace mongo {
         bool _keysComputed;
         UpdateIndexData _indexedPaths;
 
+        // The same paths for each index on its own.  Descriptors are only compared, never
+        // dereferenced, and the cache is reset whenever an index is added or dropped.
+        typedef std::map<const IndexDescriptor*, UpdateIndexData> IndexedPathsByIndex;
+        IndexedPathsByIndex _indexedPathsByIndex;
+
         // A cache for query plans.
         boost::scoped_ptr<PlanCache> _planCache;
 
@@ -106,6 +142,14 @@ namespace mongo {
         // Includes index filters.
         boost::scoped_ptr<QuerySettings> _querySettings;
 
+        // Index statistics, which the planner may read while 'analyze' replaces them.
+        mutable boost::mutex _indexStatsMutex;
+        IndexStatisticsMap _indexStats;
+        long long _indexStatsNumRecords;
+
+        // Writes since the index statistics were gathered.
+        AtomicInt64 _writesSinceAnalyze;
+
         /**
          * Must be called under exclusive DB lock.
          */
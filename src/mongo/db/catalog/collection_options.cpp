@@ -61,6 +61,9 @@ namespace mongo {
         flagsSet = false;
         temp = false;
         storageEngine = BSONObj();
+        partitionKey.clear();
+        partitionSpanSecs = 0;
+        partitionExpireAfterSecs = 0;
     }
 
     Status CollectionOptions::parse(const BSONObj& options) {
@@ -161,6 +164,38 @@ namespace mongo {
 
                 storageEngine = e.Obj().getOwned();
             }
+            else if ( fieldName == "partitionKey" ) {
+                if ( e.type() != String || e.valueStringData().empty() ) {
+                    return Status( ErrorCodes::BadValue,
+                                   "partitionKey has to be a non-empty field name" );
+                }
+                partitionKey = e.String();
+            }
+            else if ( fieldName == "partitionSpanSecs" ) {
+                if ( !e.isNumber() || e.numberLong() <= 0 ) {
+                    return Status( ErrorCodes::BadValue, "partitionSpanSecs has to be > 0" );
+                }
+                partitionSpanSecs = e.numberLong();
+            }
+            else if ( fieldName == "partitionExpireAfterSecs" ) {
+                if ( !e.isNumber() || e.numberLong() < 0 ) {
+                    return Status( ErrorCodes::BadValue,
+                                   "partitionExpireAfterSecs has to be >= 0" );
+                }
+                partitionExpireAfterSecs = e.numberLong();
+            }
+        }
+
+        if ( partitionKey.empty() != ( partitionSpanSecs == 0 ) ) {
+            return Status( ErrorCodes::BadValue,
+                           "partitionKey and partitionSpanSecs have to be given together" );
+        }
+        if ( partitionExpireAfterSecs && !isPartitioned() ) {
+            return Status( ErrorCodes::BadValue,
+                           "partitionExpireAfterSecs needs partitionKey and partitionSpanSecs" );
+        }
+        if ( isPartitioned() && capped ) {
+            return Status( ErrorCodes::BadValue, "a capped collection can't be partitioned" );
         }
 
         return Status::OK();
@@ -194,6 +229,13 @@ namespace mongo {
             b.append("storageEngine", storageEngine);
         }
 
+        if ( isPartitioned() ) {
+            b.append( "partitionKey", partitionKey );
+            b.appendNumber( "partitionSpanSecs", partitionSpanSecs );
+            if ( partitionExpireAfterSecs )
+                b.appendNumber( "partitionExpireAfterSecs", partitionExpireAfterSecs );
+        }
+
         return b.obj();
     }
 
@@ -83,6 +83,18 @@ namespace mongo {
 
         // Storage engine collection options. Always owned or empty.
         BSONObj storageEngine;
+
+        // A partitioned collection keeps the documents whose date in the 'partitionKey' field
+        // falls in each 'partitionSpanSecs' long range apart from the others, so that a whole
+        // range can be dropped at once. Empty and 0 for other collections.
+        std::string partitionKey;
+        long long partitionSpanSecs;
+
+        // How old the ranges of a partitioned collection get before they are dropped. 0 keeps
+        // them.
+        long long partitionExpireAfterSecs;
+
+        bool isPartitioned() const { return partitionSpanSecs > 0; }
     };
 
 }
@@ -157,4 +157,21 @@ namespace mongo {
         BSONObj storageEngine1 = storageEngine.getObjectField("storageEngine1");
         ASSERT_EQUALS(1, storageEngine1.getIntField("x"));
     }
+    TEST(CollectionOptions, Partitioned) {
+        CollectionOptions options;
+        ASSERT_OK(options.parse(fromjson("{partitionKey: 'ts', partitionSpanSecs: 3600,"
+                                         " partitionExpireAfterSecs: 86400}")));
+        ASSERT_TRUE(options.isPartitioned());
+        ASSERT_EQUALS("ts", options.partitionKey);
+        ASSERT_EQUALS(3600, options.partitionSpanSecs);
+        ASSERT_EQUALS(86400, options.partitionExpireAfterSecs);
+        checkRoundTrip(options);
+
+        CollectionOptions bad;
+        ASSERT_NOT_OK(bad.parse(fromjson("{partitionKey: 'ts'}")));
+        ASSERT_NOT_OK(bad.parse(fromjson("{partitionSpanSecs: 3600}")));
+        ASSERT_NOT_OK(bad.parse(fromjson("{partitionKey: 'ts', partitionSpanSecs: 0}")));
+        ASSERT_NOT_OK(bad.parse(fromjson("{partitionKey: 'ts', partitionSpanSecs: 60,"
+                                         " capped: true, size: 4096}")));
+    }
 }
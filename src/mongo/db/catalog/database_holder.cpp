@@ -30,6 +30,8 @@
 
 #include "mongo/platform/basic.h"
 
+#include <boost/scoped_array.hpp>
+
 #include "mongo/db/audit.h"
 #include "mongo/db/auth/auth_index_d.h"
 #include "mongo/db/background.h"
@@ -68,19 +70,133 @@ namespace {
         return _dbHolder;
     }
 
+    struct DatabaseHolder::Entry {
+        Entry(const StringData& name, Database* db, Entry* next)
+            : name(name.toString()), db(db), next(next) { }
+
+        const std::string name;
+        Database* const db;
+
+        // Set before the entry is published.  Only changed under the global X lock.
+        Entry* next;
+    };
+
+    class DatabaseHolder::Table {
+        MONGO_DISALLOW_COPYING(Table);
+    public:
+        explicit Table(size_t numBuckets)
+            : _numBuckets(numBuckets),
+              _buckets(new AtomicWord<uintptr_t>[numBuckets]) {
+        }
+
+        ~Table() {
+            for (size_t i = 0; i < _numBuckets; i++) {
+                Entry* e = head(i);
+                while (e) {
+                    Entry* next = e->next;
+                    delete e;
+                    e = next;
+                }
+            }
+        }
+
+        size_t numBuckets() const { return _numBuckets; }
+
+        Entry* head(size_t bucket) const {
+            return reinterpret_cast<Entry*>(_buckets[bucket].load());
+        }
+
+        Database* find(const StringData& name) const {
+            for (Entry* e = head(_bucketFor(name)); e; e = e->next) {
+                if (name == e->name) {
+                    return e->db;
+                }
+            }
+            return NULL;
+        }
+
+        /**
+         * Requires DatabaseHolder::_m.  Safe with concurrent find() calls.
+         */
+        void insert(const StringData& name, Database* db) {
+            AtomicWord<uintptr_t>& bucket = _buckets[_bucketFor(name)];
+            Entry* e = new Entry(name, db, reinterpret_cast<Entry*>(bucket.load()));
+            bucket.store(reinterpret_cast<uintptr_t>(e));
+        }
+
+        /**
+         * Requires DatabaseHolder::_m and the global X lock.  Returns the removed database, or
+         * NULL if there was none.
+         */
+        Database* remove(const StringData& name) {
+            AtomicWord<uintptr_t>& bucket = _buckets[_bucketFor(name)];
+            Entry* prev = NULL;
+            for (Entry* e = reinterpret_cast<Entry*>(bucket.load()); e; e = e->next) {
+                if (name == e->name) {
+                    if (prev) {
+                        prev->next = e->next;
+                    }
+                    else {
+                        bucket.store(reinterpret_cast<uintptr_t>(e->next));
+                    }
+                    Database* db = e->db;
+                    delete e;
+                    return db;
+                }
+                prev = e;
+            }
+            return NULL;
+        }
+
+    private:
+        size_t _bucketFor(const StringData& name) const {
+            return StringData::Hasher()(name) % _numBuckets;
+        }
+
+        const size_t _numBuckets;
+        boost::scoped_array<AtomicWord<uintptr_t> > _buckets;
+    };
+
+    DatabaseHolder::DatabaseHolder()
+        : _m("dbholder"),
+          _table(reinterpret_cast<uintptr_t>(new Table(64))),
+          _numDbs(0) {
+    }
+
+    DatabaseHolder::~DatabaseHolder() {
+        SimpleMutex::scoped_lock lk(_m);
+        _freeRetiredTables_inlock();
+        delete _getTable();
+    }
+
+    DatabaseHolder::Table* DatabaseHolder::_getTable() const {
+        return reinterpret_cast<Table*>(_table.load());
+    }
+
+    void DatabaseHolder::_freeRetiredTables_inlock() {
+        for (size_t i = 0; i < _retiredTables.size(); i++) {
+            delete _retiredTables[i];
+        }
+        _retiredTables.clear();
+    }
+
     Database* DatabaseHolder::get(OperationContext* txn,
                                   const StringData& ns) const {
 
         const StringData db = _todb(ns);
         invariant(txn->lockState()->isDbLockedForMode(db, MODE_IS));
 
+        return _getTable()->find(db);
+    }
+
+    void DatabaseHolder::getAllShortNames( std::set<std::string>& all ) const {
         SimpleMutex::scoped_lock lk(_m);
-        DBs::const_iterator it = _dbs.find(db);
-        if (it != _dbs.end()) {
-            return it->second;
+        const Table* table = _getTable();
+        for (size_t i = 0; i < table->numBuckets(); i++) {
+            for (const Entry* e = table->head(i); e; e = e->next) {
+                all.insert(e->name);
+            }
         }
-
-        return NULL;
     }
 
     Database* DatabaseHolder::openDb(OperationContext* txn,
@@ -131,7 +247,24 @@ namespace {
         SimpleMutex::scoped_lock lk(_m);
 
         db = new Database(dbname, entry);
-        _dbs[dbname] = db;
+
+        Table* table = _getTable();
+        if (_numDbs >= table->numBuckets()) {
+            // Readers may still be walking the current table, so it is replaced by a larger copy
+            // and only freed once no reader can be left.
+            Table* grown = new Table(table->numBuckets() * 2);
+            for (size_t i = 0; i < table->numBuckets(); i++) {
+                for (const Entry* e = table->head(i); e; e = e->next) {
+                    grown->insert(e->name, e->db);
+                }
+            }
+            _table.store(reinterpret_cast<uintptr_t>(grown));
+            _retiredTables.push_back(table);
+            table = grown;
+        }
+
+        table->insert(dbname, db);
+        _numDbs++;
 
         return db;
     }
@@ -144,15 +277,16 @@ namespace {
         const StringData dbName = _todb(ns);
 
         SimpleMutex::scoped_lock lk(_m);
+        _freeRetiredTables_inlock();
 
-        DBs::const_iterator it = _dbs.find(dbName);
-        if (it == _dbs.end()) {
+        Database* db = _getTable()->remove(dbName);
+        if (!db) {
             return;
         }
+        _numDbs--;
 
-        it->second->close( txn );
-        delete it->second;
-        _dbs.erase(it);
+        db->close( txn );
+        delete db;
 
         getGlobalEnvironment()->getGlobalStorageEngine()->closeDatabase(txn, dbName.toString());
     }
@@ -161,10 +295,15 @@ namespace {
         invariant(txn->lockState()->isW());
 
         SimpleMutex::scoped_lock lk(_m);
+        _freeRetiredTables_inlock();
+
+        Table* table = _getTable();
 
         set< string > dbs;
-        for ( DBs::const_iterator i = _dbs.begin(); i != _dbs.end(); ++i ) {
-            dbs.insert( i->first );
+        for (size_t i = 0; i < table->numBuckets(); i++) {
+            for (const Entry* e = table->head(i); e; e = e->next) {
+                dbs.insert(e->name);
+            }
         }
 
         BSONArrayBuilder bb( result.subarrayStart( "dbs" ) );
@@ -183,12 +322,13 @@ namespace {
                 continue;
             }
 
-            Database* db = _dbs[name];
+            Database* db = table->remove(name);
+            invariant(db);
+            _numDbs--;
+
             db->close( txn );
             delete db;
 
-            _dbs.erase( name );
-
             getGlobalEnvironment()->getGlobalStorageEngine()->closeDatabase( txn, name );
 
             bb.append( name );
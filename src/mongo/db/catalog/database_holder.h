@@ -28,10 +28,17 @@
 
 #pragma once
 
+#include <set>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
 #include "mongo/base/string_data.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/namespace_string.h"
-#include "mongo/util/string_map.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/cstdint.h"
+#include "mongo/util/concurrency/mutex.h"
 
 namespace mongo {
 
@@ -39,12 +46,14 @@ namespace mongo {
      * Registry of opened databases.
      */
     class DatabaseHolder {
+        MONGO_DISALLOW_COPYING(DatabaseHolder);
     public:
-        DatabaseHolder() : _m("dbholder") { }
+        DatabaseHolder();
+        ~DatabaseHolder();
 
         /**
          * Retrieves an already opened database or returns NULL. Must be called with the database
-         * locked in at least IS-mode.
+         * locked in at least IS-mode.  Takes no other lock.
          */
         Database* get(OperationContext* txn, const StringData& ns) const;
 
@@ -75,18 +84,34 @@ namespace mongo {
          * is not guaranteed that the returned set of names will be still valid unless a global
          * lock is held, which would prevent database from disappearing or being created.
          */
-        void getAllShortNames( std::set<std::string>& all ) const {
-            SimpleMutex::scoped_lock lk(_m);
-            for( DBs::const_iterator j=_dbs.begin(); j!=_dbs.end(); ++j ) {
-                all.insert( j->first );
-            }
-        }
+        void getAllShortNames( std::set<std::string>& all ) const;
 
     private:
-        typedef StringMap<Database*> DBs;
+        /**
+         * The opened databases live in a chained hash table which get() reads without locking.
+         * Writers serialize on _m.  openDb() only publishes new entries at the head of a chain,
+         * and grows the table by publishing a copy of it.  Entries are only unlinked, and
+         * replaced tables only freed, by close() and closeAll(): they hold the global lock in
+         * X-mode, which excludes every reader, as get() requires a database lock.
+         */
+        struct Entry;
+        class Table;
+
+        Table* _getTable() const;
+
+        /**
+         * Frees the tables replaced since the last call.  Requires _m and the global X lock.
+         */
+        void _freeRetiredTables_inlock();
 
         mutable SimpleMutex _m;
-        DBs _dbs;
+
+        // The current Table*.
+        AtomicWord<uintptr_t> _table;
+
+        // Protected by _m.
+        size_t _numDbs;
+        std::vector<Table*> _retiredTables;
     };
 
     DatabaseHolder& dbHolder();
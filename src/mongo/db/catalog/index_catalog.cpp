@@ -515,13 +515,36 @@ namespace {
             double v = vElt.Number();
             // note (one day) we may be able to fresh build less versions than we can use
             // isASupportedIndexVersionNumber() is what we can use
-            if ( v != 0 && v != 1 ) {
+            if ( v != 0 && v != 1 && v != 2 ) {
                 return Status( ErrorCodes::CannotCreateIndex,
                                str::stream() << "this version of mongod cannot build new indexes "
                                              << "of version number " << v );
             }
         }
 
+        BSONElement bucketSizeElt = spec["btreeBucketSize"];
+        if ( !bucketSizeElt.eoo() ) {
+            if ( vElt.numberInt() != 2 ) {
+                return Status( ErrorCodes::CannotCreateIndex,
+                               "\"btreeBucketSize\" is only supported by version 2 indexes" );
+            }
+            if ( !bucketSizeElt.isNumber() ||
+                 !IndexDescriptor::isValidBtreeBucketSize( bucketSizeElt.numberInt() ) ) {
+                return Status( ErrorCodes::CannotCreateIndex,
+                               str::stream() << "\"btreeBucketSize\" must be 16384, 32768 or "
+                                             << "65536, not " << bucketSizeElt );
+            }
+        }
+
+        BSONElement fillFactorElt = spec["fillFactor"];
+        if ( !fillFactorElt.eoo() &&
+             ( !fillFactorElt.isNumber() ||
+               !IndexDescriptor::isValidFillFactor( fillFactorElt.numberInt() ) ) ) {
+            return Status( ErrorCodes::CannotCreateIndex,
+                           str::stream() << "\"fillFactor\" must be a percentage from 10 to 100, "
+                                         << "not " << fillFactorElt );
+        }
+
         if ( nss.isSystemDotIndexes() )
             return Status( ErrorCodes::CannotCreateIndex,
                            "cannot create indexes on the system.indexes collection" );
@@ -858,7 +881,8 @@ namespace {
         }
     }
 
-    vector<BSONObj> IndexCatalog::getAndClearUnfinishedIndexes(OperationContext* txn) {
+    vector<BSONObj> IndexCatalog::getAndClearUnfinishedIndexes(OperationContext* txn,
+                                                               vector<BSONObj>* checkpointsOut) {
         vector<BSONObj> toReturn = _unfinishedIndexes;
         _unfinishedIndexes.clear();
         for ( size_t i = 0; i < toReturn.size(); i++ ) {
@@ -867,6 +891,12 @@ namespace {
             BSONObj keyPattern = spec.getObjectField("key");
             IndexDescriptor desc( _collection, _getAccessMethodName(txn, keyPattern), spec );
 
+            if ( checkpointsOut ) {
+                CollectionCatalogEntry* entry = _collection->getCatalogEntry();
+                checkpointsOut->push_back( entry->getIndexBuildCheckpoint( txn,
+                                                                           desc.indexName() ) );
+            }
+
             _deleteIndexFromDisk( txn,
                                   desc.indexName(),
                                   desc.indexNamespace() );
@@ -1127,6 +1157,24 @@ namespace {
         return Status::OK();
     }
 
+    Status IndexCatalog::indexRecords(OperationContext* txn,
+                                      const std::vector<BSONObj>& objs,
+                                      const std::vector<RecordId>& locs) {
+        invariant(objs.size() == locs.size());
+
+        for ( IndexCatalogEntryContainer::const_iterator i = _entries.begin();
+              i != _entries.end();
+              ++i ) {
+            for (size_t j = 0; j < objs.size(); j++) {
+                Status s = _indexRecord(txn, *i, objs[j], locs[j]);
+                if (!s.isOK())
+                    return s;
+            }
+        }
+
+        return Status::OK();
+    }
+
     void IndexCatalog::unindexRecord(OperationContext* txn,
                                      const BSONObj& obj,
                                      const RecordId& loc,
@@ -1167,6 +1215,10 @@ namespace {
         // idea is to put things we use a lot earlier
         b.append("v", v);
 
+        // The bucket size is part of the on-disk format, so it is fixed when the index is created.
+        if ( v == 2 && o["btreeBucketSize"].eoo() )
+            b.append( "btreeBucketSize", IndexDescriptor::DefaultBtreeBucketSize );
+
         if( o["unique"].trueValue() )
             b.appendBool("unique", true); // normalize to bool true in case was int 1 or something...
 
@@ -190,8 +190,12 @@ namespace mongo {
         /**
          * will drop all incompleted indexes and return specs
          * after this, the indexes can be rebuilt
+         * if checkpointsOut is not NULL, it gets the build checkpoint of each index, in the same
+         * order as the specs, for MultiIndexBlock::resumeFromCheckpoints()
          */
-        std::vector<BSONObj> getAndClearUnfinishedIndexes(OperationContext* txn);
+        std::vector<BSONObj> getAndClearUnfinishedIndexes(OperationContext* txn,
+                                                          std::vector<BSONObj>* checkpointsOut =
+                                                              NULL);
 
 
         struct IndexKillCriteria {
@@ -289,6 +293,12 @@ namespace mongo {
         // this throws for now
         Status indexRecord(OperationContext* txn, const BSONObj& obj, const RecordId &loc);
 
+        // Indexes objs[i] at locs[i] for every i, filling each index in turn so that its
+        // access method and tree stay hot for the whole batch.  Stops at the first error.
+        Status indexRecords(OperationContext* txn,
+                            const std::vector<BSONObj>& objs,
+                            const std::vector<RecordId>& locs);
+
         void unindexRecord(OperationContext* txn,
                            const BSONObj& obj,
                            const RecordId& loc,
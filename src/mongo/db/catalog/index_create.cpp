@@ -34,23 +34,193 @@
 
 #include "mongo/db/catalog/index_create.h"
 
+#include <boost/filesystem/operations.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
 #include "mongo/base/error_codes.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/audit.h"
 #include "mongo/db/background.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/collection_catalog_entry.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/curop.h"
+#include "mongo/db/global_environment_experiment.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/repl_coordinator_global.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/storage_engine.h"
+#include "mongo/db/storage_options.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/progress_meter.h"
 
 namespace mongo {
 
+    using std::vector;
+
+    namespace {
+
+        // Number of threads a foreground build of several indexes may use to generate keys, each
+        // working on one index at a time. 0 or 1 generates every key on the building thread.
+        MONGO_EXPORT_STARTUP_SERVER_PARAMETER(internalIndexBuildKeyGenerationThreads, int, 0);
+
+        // Whether a background build of a non-unique index on a storage engine with document
+        // level locking bulk loads the index while concurrent writes go to a side table, rather
+        // than inserting every document into the live index.
+        MONGO_EXPORT_SERVER_PARAMETER(internalIndexBuildUseSideWrites, bool, true);
+
+        // How often a foreground bulk build saves the keys it has so far, and how far its
+        // collection scan has got, so that it can go on from there if the server is restarted
+        // before it is done. 0 never saves any.
+        MONGO_EXPORT_SERVER_PARAMETER(internalIndexBuildCheckpointPeriodMS, int, 60 * 1000);
+
+        MONGO_FP_DECLARE(hangAfterIndexBuildCheckpoint);
+
+        // Documents read from the collection between hand-offs to the key generation threads.
+        const size_t kKeyGenerationBatchSize = 1000;
+
+        // Checkpoints live outside of the temporary directory, which is emptied at startup.
+        std::string checkpointRoot() {
+            return storageGlobalParams.dbpath + "/_indexBuildCheckpoints";
+        }
+
+        void removeCheckpointDirs(const std::vector<std::string>& dirs) {
+            for (size_t i = 0; i < dirs.size(); i++) {
+                boost::system::error_code ec;
+                boost::filesystem::remove_all(checkpointRoot() + "/" + dirs[i], ec);
+                if (ec) {
+                    warning() << "couldn't remove index build checkpoint " << dirs[i] << ": "
+                              << ec.message();
+                }
+            }
+        }
+
+        boost::mutex keyGenerationPoolMutex;
+        threadpool::ThreadPool* keyGenerationPool = NULL;
+
+        threadpool::ThreadPool* getKeyGenerationPool() {
+            boost::lock_guard<boost::mutex> lk(keyGenerationPoolMutex);
+            if (NULL == keyGenerationPool) {
+                keyGenerationPool =
+                    new threadpool::ThreadPool(internalIndexBuildKeyGenerationThreads,
+                                               "indexKeyGen");
+            }
+            return keyGenerationPool;
+        }
+
+        /**
+         * Inserts batches of documents into several bulk index builders at once, with one task
+         * per index on the key generation pool, so the building thread can read the next batch
+         * meanwhile.
+         *
+         * Only for bulk builders: their insert() generates keys and feeds the index's own sorter
+         * without touching storage, so the builders of different indexes share nothing.
+         */
+        class ParallelKeyGenerator {
+            MONGO_DISALLOW_COPYING(ParallelKeyGenerator);
+        public:
+            ParallelKeyGenerator(OperationContext* txn,
+                                 const vector<IndexAccessMethod*>& methods,
+                                 const vector<InsertDeleteOptions>& options)
+                : _txn(txn),
+                  _methods(methods),
+                  _options(options),
+                  _objs(NULL),
+                  _locs(NULL),
+                  _numRunning(0),
+                  _status(Status::OK()) {
+                invariant(_methods.size() == _options.size());
+            }
+
+            ~ParallelKeyGenerator() {
+                // The tasks point at this object.
+                wait();
+            }
+
+            /**
+             * Starts indexing a batch.  The batch must not change until wait() returns, and
+             * wait() must have been called since the previous start().
+             */
+            void start(const vector<BSONObj>* objs, const vector<RecordId>* locs) {
+                {
+                    boost::lock_guard<boost::mutex> lk(_mutex);
+                    invariant(0 == _numRunning);
+                    _objs = objs;
+                    _locs = locs;
+                    _numRunning = _methods.size();
+                }
+
+                threadpool::ThreadPool* pool = getKeyGenerationPool();
+                for (size_t i = 0; i < _methods.size(); ++i) {
+                    pool->schedule(&ParallelKeyGenerator::insertBatch, this, i);
+                }
+            }
+
+            /**
+             * Waits until the batch passed to the last start(), if any, is indexed.  Returns the
+             * first error any index has hit so far.
+             */
+            Status wait() {
+                boost::unique_lock<boost::mutex> lk(_mutex);
+                while (_numRunning > 0) {
+                    _batchDone.wait(lk);
+                }
+                return _status;
+            }
+
+        private:
+            static void insertBatch(ParallelKeyGenerator* self, size_t index) {
+                self->_insertBatch(index);
+            }
+
+            void _insertBatch(size_t index) {
+                Status status = Status::OK();
+                try {
+                    IndexAccessMethod* method = _methods[index];
+                    for (size_t i = 0; i < _objs->size() && status.isOK(); ++i) {
+                        int64_t unused;
+                        status = method->insert(_txn,
+                                                (*_objs)[i],
+                                                (*_locs)[i],
+                                                _options[index],
+                                                &unused);
+                    }
+                }
+                catch (const DBException& ex) {
+                    status = ex.toStatus();
+                }
+
+                boost::lock_guard<boost::mutex> lk(_mutex);
+                if (!status.isOK() && _status.isOK()) {
+                    _status = status;
+                }
+                if (0 == --_numRunning) {
+                    _batchDone.notify_all();
+                }
+            }
+
+            OperationContext* const _txn;
+            const vector<IndexAccessMethod*> _methods;
+            const vector<InsertDeleteOptions> _options;
+
+            const vector<BSONObj>* _objs;
+            const vector<RecordId>* _locs;
+
+            // Guard '_numRunning' and '_status'.
+            boost::mutex _mutex;
+            boost::condition_variable _batchDone;
+            size_t _numRunning;
+            Status _status;
+        };
+
+    }  // namespace
+
     /**
      * On rollback sets MultiIndexBlock::_needToCleanup to true.
      */
@@ -65,6 +235,20 @@ namespace mongo {
         MultiIndexBlock* const _indexer;
     };
 
+    /**
+     * On commit removes the checkpoints of the indexes built, which nothing refers to anymore.
+     */
+    class MultiIndexBlock::RemoveCheckpointsOnCommit : public RecoveryUnit::Change {
+    public:
+        explicit RemoveCheckpointsOnCommit(const std::vector<std::string>& dirs) : _dirs(dirs) {}
+
+        virtual void commit() { removeCheckpointDirs(_dirs); }
+        virtual void rollback() {}
+
+    private:
+        const std::vector<std::string> _dirs;
+    };
+
     MultiIndexBlock::MultiIndexBlock(OperationContext* txn, Collection* collection)
         : _collection(collection),
           _txn(txn),
@@ -86,6 +270,7 @@ namespace mongo {
                 _indexes[i].block->fail();
             }
             wunit.commit();
+            removeCheckpointDirs(checkpointDirs());
             return;
         }
         catch (const std::exception& e) {
@@ -154,13 +339,25 @@ namespace mongo {
             if ( !status.isOK() )
                 return status;
 
+            const IndexDescriptor* descriptor = index.block->getEntry()->descriptor();
+
             if (!_buildInBackground) {
                 // Bulk build process requires foreground building as it assumes nothing is changing
                 // under it.
                 index.bulk.reset(index.real->initiateBulk(_txn));
             }
-
-            const IndexDescriptor* descriptor = index.block->getEntry()->descriptor();
+            else if (canUseSideWrites(descriptor)) {
+                // Concurrent writes are kept out of the index while it is bulk loaded, and applied
+                // by drainSideWrites(). With document level locking the collection scan sees each
+                // record once, so the sorter never gets the same key twice.
+                index.bulk.reset(index.real->initiateBulk(_txn));
+                if (index.bulk) {
+                    status = index.real->beginSideWrites();
+                    if ( !status.isOK() )
+                        return status;
+                    index.sideWrites = true;
+                }
+            }
 
             index.options.logIfError = false; // logging happens elsewhere if needed.
             index.options.dupsAllowed = !descriptor->unique()
@@ -171,6 +368,8 @@ namespace mongo {
             log() << "build index on: " << ns << " properties: " << descriptor->toString();
             if (index.bulk)
                 log() << "\t building index using bulk method";
+            if (index.sideWrites)
+                log() << "\t concurrent writes go to a side table until the bulk load is done";
 
             // TODO SERVER-14888 Suppress this in cases we don't want to audit.
             audit::logCreateIndex(_txn->getClient(), &info, descriptor->indexName(), ns);
@@ -189,6 +388,177 @@ namespace mongo {
         return Status::OK();
     }
 
+    bool MultiIndexBlock::canUseSideWrites(const IndexDescriptor* descriptor) const {
+        // A unique index could see a key twice in the sorter, from two versions of the same
+        // document, and report a duplicate which the side writes would have resolved.
+        return internalIndexBuildUseSideWrites
+            && !descriptor->unique()
+            && getGlobalEnvironment()->getGlobalStorageEngine()->supportsDocLocking();
+    }
+
+    bool MultiIndexBlock::canCheckpoint() const {
+        if (internalIndexBuildCheckpointPeriodMS <= 0 || _buildInBackground || _indexes.empty())
+            return false;
+
+        // The mmapv1 catalog has nowhere to keep checkpoints.
+        StorageEngine* storageEngine = getGlobalEnvironment()->getGlobalStorageEngine();
+        if (!storageEngine->isDurable() || storageEngine->isMmapV1())
+            return false;
+
+        for (size_t i = 0; i < _indexes.size(); i++) {
+            if (!_indexes[i].bulk || _indexes[i].sideWrites)
+                return false;
+        }
+        return true;
+    }
+
+    Status MultiIndexBlock::checkpoint(const RecordId& lastRecord) {
+        Timer t;
+
+        vector<BSONObj> checkpoints;
+        try {
+            for (size_t i = 0; i < _indexes.size(); i++) {
+                IndexToBuild& index = _indexes[i];
+                if (index.checkpointDir.empty())
+                    index.checkpointDir = OID::gen().toString();
+
+                BSONObjBuilder b;
+                b.append("dir", index.checkpointDir);
+                b.append("lastRecord", static_cast<long long>(lastRecord.repr()));
+
+                BSONObjBuilder bulk(b.subobjStart("bulk"));
+                Status status = index.real->checkpointBulk(index.bulk.get(),
+                                                           checkpointRoot() + "/"
+                                                               + index.checkpointDir,
+                                                           &bulk);
+                if (!status.isOK())
+                    return status;
+                bulk.done();
+
+                checkpoints.push_back(b.obj());
+            }
+        }
+        catch (const DBException& e) {
+            return e.toStatus();
+        }
+
+        // The sorted runs are on disk by now, so the catalog can refer to them.
+        WriteUnitOfWork wunit(_txn);
+        for (size_t i = 0; i < _indexes.size(); i++) {
+            const IndexDescriptor* descriptor = _indexes[i].block->getEntry()->descriptor();
+            _collection->getCatalogEntry()->setIndexBuildCheckpoint(_txn,
+                                                                    descriptor->indexName(),
+                                                                    checkpoints[i]);
+        }
+        wunit.commit();
+
+        LOG(1) << "\t checkpointed index build on " << _collection->ns().ns()
+               << " up to record " << lastRecord << " in " << t.millis() << "ms";
+
+        while (MONGO_FAIL_POINT(hangAfterIndexBuildCheckpoint)) {
+            log() << "hangAfterIndexBuildCheckpoint fail point enabled";
+            sleepsecs(1);
+        }
+
+        return Status::OK();
+    }
+
+    void MultiIndexBlock::checkpointIfDue(const RecordId& lastRecord,
+                                          Timer* sinceCheckpoint,
+                                          bool* checkpointing) {
+        if (!*checkpointing || sinceCheckpoint->millis() < internalIndexBuildCheckpointPeriodMS)
+            return;
+
+        Status status = checkpoint(lastRecord);
+        if (!status.isOK()) {
+            warning() << "index build on " << _collection->ns().ns()
+                      << " won't save any more checkpoints: " << status;
+            *checkpointing = false;
+        }
+        sinceCheckpoint->reset();
+    }
+
+    vector<std::string> MultiIndexBlock::checkpointDirs() const {
+        vector<std::string> dirs;
+        for (size_t i = 0; i < _indexes.size(); i++) {
+            if (!_indexes[i].checkpointDir.empty())
+                dirs.push_back(_indexes[i].checkpointDir);
+        }
+        return dirs;
+    }
+
+    void MultiIndexBlock::resumeFromCheckpoints(const std::vector<BSONObj>& checkpoints) {
+        invariant(checkpoints.size() == _indexes.size());
+
+        vector<std::string> dirs;
+        for (size_t i = 0; i < checkpoints.size(); i++) {
+            if (checkpoints[i]["dir"].type() == String)
+                dirs.push_back(checkpoints[i]["dir"].String());
+        }
+        if (dirs.empty())
+            return;
+
+        // The checkpoints are only good together, since the scan goes on from one record for
+        // all of the indexes.
+        bool resumable = canCheckpoint() && dirs.size() == checkpoints.size();
+        RecordId resumeAfter;
+        vector<boost::shared_ptr<IndexAccessMethod> > bulks;
+        for (size_t i = 0; i < checkpoints.size() && resumable; i++) {
+            const BSONObj& checkpoint = checkpoints[i];
+            if (checkpoint["lastRecord"].type() != NumberLong
+                    || !checkpoint["bulk"].isABSONObj()) {
+                resumable = false;
+                break;
+            }
+
+            const RecordId lastRecord(checkpoint["lastRecord"].Long());
+            if (i > 0 && lastRecord != resumeAfter) {
+                resumable = false;
+                break;
+            }
+            resumeAfter = lastRecord;
+
+            bulks.push_back(boost::shared_ptr<IndexAccessMethod>(
+                _indexes[i].real->resumeBulk(_txn,
+                                             checkpointRoot() + "/" + dirs[i],
+                                             checkpoint["bulk"].Obj())));
+            resumable = (NULL != bulks.back().get());
+        }
+
+        const string& ns = _collection->ns().ns();
+        if (!resumable) {
+            log() << "can't resume the index build on " << ns << " from its checkpoint, "
+                  << "starting over";
+            removeCheckpointDirs(dirs);
+            return;
+        }
+
+        WriteUnitOfWork wunit(_txn);
+        for (size_t i = 0; i < _indexes.size(); i++) {
+            IndexToBuild& index = _indexes[i];
+            index.bulk = bulks[i];
+            index.checkpointDir = dirs[i];
+
+            // The index was just recreated without it.
+            const IndexDescriptor* descriptor = index.block->getEntry()->descriptor();
+            _collection->getCatalogEntry()->setIndexBuildCheckpoint(_txn,
+                                                                    descriptor->indexName(),
+                                                                    checkpoints[i]);
+        }
+        wunit.commit();
+
+        _resumeAfter = resumeAfter;
+        log() << "resuming index build on " << ns << " after record " << _resumeAfter;
+    }
+
+    void MultiIndexBlock::removeLeftoverCheckpoints() {
+        boost::system::error_code ec;
+        boost::filesystem::remove_all(checkpointRoot(), ec);
+        if (ec) {
+            warning() << "couldn't remove index build checkpoints: " << ec.message();
+        }
+    }
+
     IndexDescriptor* MultiIndexBlock::registerIndexBuild() {
         // Register background index build so that it can be found and killed when necessary
         invariant(_collection);
@@ -213,45 +583,123 @@ namespace mongo {
 
         unsigned long long n = 0;
 
+        // A resumed build goes on from its checkpoint. Records come in RecordId order on the
+        // storage engines which save checkpoints.
         scoped_ptr<PlanExecutor> exec(InternalPlanner::collectionScan(_txn,
                                                                       _collection->ns().ns(),
-                                                                      _collection));
+                                                                      _collection,
+                                                                      InternalPlanner::FORWARD,
+                                                                      _resumeAfter));
         if (_buildInBackground) {
             invariant(_allowInterruption);
             exec->setYieldPolicy(PlanExecutor::YIELD_AUTO);
         }
 
+        bool parallelKeyGeneration = !_buildInBackground
+                                  && _indexes.size() > 1
+                                  && internalIndexBuildKeyGenerationThreads > 1;
+        for (size_t i = 0; i < _indexes.size() && parallelKeyGeneration; i++) {
+            parallelKeyGeneration = (NULL != _indexes[i].bulk);
+        }
+
+        bool checkpointing = canCheckpoint();
+        Timer sinceCheckpoint;
+
         BSONObj objToIndex;
         RecordId loc;
         PlanExecutor::ExecState state;
-        while (PlanExecutor::ADVANCED == (state = exec->getNext(&objToIndex, &loc))) {
-            {
+
+        if (parallelKeyGeneration) {
+            vector<IndexAccessMethod*> methods;
+            vector<InsertDeleteOptions> options;
+            for (size_t i = 0; i < _indexes.size(); i++) {
+                methods.push_back(_indexes[i].bulk.get());
+                options.push_back(_indexes[i].options);
+            }
+
+            // The workers index one batch while this thread reads the other.  The batches are
+            // declared first so that they outlive the generator's final wait().
+            vector<BSONObj> objs[2];
+            vector<RecordId> locs[2];
+            int filling = 0;
+            ParallelKeyGenerator generator(_txn, methods, options);
+
+            while (PlanExecutor::ADVANCED == (state = exec->getNext(&objToIndex, &loc))) {
+                if (!_resumeAfter.isNull() && loc <= _resumeAfter)
+                    continue;
+
+                objs[filling].push_back(objToIndex.getOwned());
+                locs[filling].push_back(loc);
+
+                n++;
+                progress->hit();
+
+                if (objs[filling].size() < kKeyGenerationBatchSize)
+                    continue;
+
                 if (_allowInterruption)
                     _txn->checkForInterrupt();
 
-                bool shouldCommitWUnit = true;
-                WriteUnitOfWork wunit(_txn);
-                Status ret = insert(objToIndex, loc);
-                if (!ret.isOK()) {
-                    if (dupsOut && ret.code() == ErrorCodes::DuplicateKey) {
-                        // If dupsOut is non-null, we should only fail the specific insert that
-                        // led to a DuplicateKey rather than the whole index build.
-                        dupsOut->insert(loc);
-                        shouldCommitWUnit = false;
-                    }
-                    else {
-                        return ret;
+                Status ret = generator.wait();
+                if (!ret.isOK())
+                    return ret;
+
+                // Every batch before the one about to start is indexed.
+                if (!locs[1 - filling].empty())
+                    checkpointIfDue(locs[1 - filling].back(), &sinceCheckpoint, &checkpointing);
+
+                generator.start(&objs[filling], &locs[filling]);
+
+                filling = 1 - filling;
+                objs[filling].clear();
+                locs[filling].clear();
+
+                progress->setTotalWhileRunning( _collection->numRecords(_txn) );
+            }
+
+            Status ret = generator.wait();
+            if (ret.isOK() && !objs[filling].empty()) {
+                generator.start(&objs[filling], &locs[filling]);
+                ret = generator.wait();
+            }
+            if (!ret.isOK())
+                return ret;
+        }
+        else {
+            while (PlanExecutor::ADVANCED == (state = exec->getNext(&objToIndex, &loc))) {
+                if (!_resumeAfter.isNull() && loc <= _resumeAfter)
+                    continue;
+
+                {
+                    if (_allowInterruption)
+                        _txn->checkForInterrupt();
+
+                    bool shouldCommitWUnit = true;
+                    WriteUnitOfWork wunit(_txn);
+                    Status ret = insert(objToIndex, loc);
+                    if (!ret.isOK()) {
+                        if (dupsOut && ret.code() == ErrorCodes::DuplicateKey) {
+                            // If dupsOut is non-null, we should only fail the specific insert that
+                            // led to a DuplicateKey rather than the whole index build.
+                            dupsOut->insert(loc);
+                            shouldCommitWUnit = false;
+                        }
+                        else {
+                            return ret;
+                        }
                     }
+
+                    if (shouldCommitWUnit)
+                        wunit.commit();
                 }
 
-                if (shouldCommitWUnit)
-                    wunit.commit();
-            }
+                n++;
+                progress->hit();
 
-            n++;
-            progress->hit();
+                progress->setTotalWhileRunning( _collection->numRecords(_txn) );
 
-            progress->setTotalWhileRunning( _collection->numRecords(_txn) );
+                checkpointIfDue(loc, &sinceCheckpoint, &checkpointing);
+            }
         }
 
         if (state != PlanExecutor::IS_EOF) {
@@ -303,6 +751,21 @@ namespace mongo {
         return Status::OK();
     }
 
+    Status MultiIndexBlock::drainSideWrites() {
+        for ( size_t i = 0; i < _indexes.size(); i++ ) {
+            if ( !_indexes[i].sideWrites )
+                continue;
+            Status status = _indexes[i].real->drainSideWrites( _txn,
+                                                               _collection,
+                                                               _indexes[i].options );
+            if ( !status.isOK() )
+                return status;
+            _indexes[i].sideWrites = false;
+        }
+
+        return Status::OK();
+    }
+
     void MultiIndexBlock::abortWithoutCleanup() {
         for ( size_t i = 0; i < _indexes.size(); i++ ) {
             _indexes[i].block->abortWithoutCleanup();
@@ -313,12 +776,14 @@ namespace mongo {
 
     void MultiIndexBlock::commit() {
         for ( size_t i = 0; i < _indexes.size(); i++ ) {
+            invariant(!_indexes[i].sideWrites);
             _indexes[i].block->success();
         }
 
         // this one is so operations examining the list of indexes know that the index is finished
         _collection->infoCache()->addedIndex(_txn);
 
+        _txn->recoveryUnit()->registerChange(new RemoveCheckpointsOnCommit(checkpointDirs()));
         _txn->recoveryUnit()->registerChange(new SetNeedToCleanupOnRollback(this));
         _needToCleanup = false;
     }
@@ -45,6 +45,7 @@ namespace mongo {
     class BSONObj;
     class Collection;
     class OperationContext;
+    class Timer;
 
     /**
      * Builds one or more indexes.
@@ -109,6 +110,24 @@ namespace mongo {
             return init(std::vector<BSONObj>(1, spec));
         }
 
+        /**
+         * Picks up the interrupted builds of the indexes just given to init() from the
+         * checkpoints IndexCatalog::getAndClearUnfinishedIndexes() returned along with their
+         * specs: the bulk builders start out with the keys saved so far, and
+         * insertAllDocumentsInCollection() only scans the records after the checkpoint. Unless
+         * every index has a usable checkpoint of the same point of the scan, the checkpoints are
+         * removed and the build starts over.
+         *
+         * Call right after init(). Requires holding an exclusive database lock.
+         */
+        void resumeFromCheckpoints(const std::vector<BSONObj>& checkpoints);
+
+        /**
+         * Removes whatever index build checkpoints are left on disk. Only safe once no unfinished
+         * index can refer to them, such as when every interrupted build has been restarted.
+         */
+        static void removeLeftoverCheckpoints();
+
         /**
          * Manages in-progress background index builds.
          * Call registerIndexBuild() after calling init() to record this build in the catalog's 
@@ -164,9 +183,21 @@ namespace mongo {
          */
         Status doneInserting(std::set<RecordId>* dupsOut = NULL);
 
+        /**
+         * Applies the writes which a background build kept out of its indexes while it bulk
+         * loaded them. Call after insertAllDocumentsInCollection() or doneInserting() and before
+         * commit(). Does nothing for indexes built without a side table.
+         *
+         * Should not be called inside of a WriteUnitOfWork.
+         *
+         * Requires holding an exclusive database lock.
+         */
+        Status drainSideWrites();
+
         /**
          * Marks the index ready for use. Should only be called as the last method after
-         * doneInserting() or insertAllDocumentsInCollection() return success.
+         * doneInserting() or insertAllDocumentsInCollection() and drainSideWrites() return
+         * success.
          *
          * Should be called inside of a WriteUnitOfWork. If the index building is to be logOp'd,
          * logOp() should be called from the same unit of work as commit().
@@ -195,9 +226,10 @@ namespace mongo {
 
     private:
         class SetNeedToCleanupOnRollback;
+        class RemoveCheckpointsOnCommit;
 
         struct IndexToBuild {
-            IndexToBuild() : real(NULL) {}
+            IndexToBuild() : real(NULL), sideWrites(false) {}
 
             IndexAccessMethod* forInsert() { return bulk ? bulk.get() : real; }
 
@@ -207,8 +239,42 @@ namespace mongo {
             boost::shared_ptr<IndexAccessMethod> bulk;
 
             InsertDeleteOptions options;
+
+            // Whether writes to 'real' are going to its side table until drainSideWrites().
+            bool sideWrites;
+
+            // Where 'bulk' keeps its checkpoints, under the checkpoint root. Empty until the
+            // first one.
+            std::string checkpointDir;
         };
 
+        bool canUseSideWrites(const IndexDescriptor* descriptor) const;
+
+        /**
+         * Whether this build may save checkpoints: a foreground bulk build on a durable storage
+         * engine whose catalog can hold them.
+         */
+        bool canCheckpoint() const;
+
+        /**
+         * Saves the keys of every record the scan has returned, up to and including
+         * 'lastRecord', and records them in the catalog.
+         */
+        Status checkpoint(const RecordId& lastRecord);
+
+        /**
+         * Calls checkpoint() if '*sinceCheckpoint' says one is due, and sets '*checkpointing' to
+         * false for good if it fails.
+         */
+        void checkpointIfDue(const RecordId& lastRecord,
+                             Timer* sinceCheckpoint,
+                             bool* checkpointing);
+
+        /**
+         * Returns the checkpoint directories of the indexes being built, for those which have one.
+         */
+        std::vector<std::string> checkpointDirs() const;
+
         std::vector<IndexToBuild> _indexes;
 
         boost::scoped_ptr<BackgroundOperation> _backgroundOperation;
@@ -223,6 +289,10 @@ namespace mongo {
         bool _ignoreUnique;
 
         bool _needToCleanup;
+
+        // Set by resumeFromCheckpoints(): the keys of this record and of all before it are in the
+        // bulk builders already.
+        RecordId _resumeAfter;
     };
 
 } // namespace mongo
@@ -59,6 +59,7 @@
 #include "mongo/db/lasterror.h"
 #include "mongo/db/repl/handshake_args.h"
 #include "mongo/db/repl/repl_coordinator_global.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/d_state.h"
@@ -214,9 +215,40 @@ namespace mongo {
         }
     }
 
+    // Whether secondary reads use batch boundary snapshots where the storage engine has them.
+    MONGO_EXPORT_SERVER_PARAMETER(secondaryReadsAtBatchBoundaries, bool, true);
+
+    AutoGetCollectionForRead::BatchBoundaryRead::BatchBoundaryRead(OperationContext* txn)
+            : _txn(txn),
+              _active(false) {
+
+        // Reads nested in other operations keep to the locks those hold.
+        if (!secondaryReadsAtBatchBoundaries || _txn->lockState()->isLocked()) {
+            return;
+        }
+
+        if (!repl::getGlobalReplicationCoordinator()->getCurrentMemberState().secondary()) {
+            return;
+        }
+
+        if (!_txn->recoveryUnit()->readAtBatchBoundaries()) {
+            return;
+        }
+
+        _txn->lockState()->setReadsAtBatchBoundaries(true);
+        _active = true;
+    }
+
+    AutoGetCollectionForRead::BatchBoundaryRead::~BatchBoundaryRead() {
+        if (_active) {
+            _txn->lockState()->setReadsAtBatchBoundaries(false);
+        }
+    }
+
     AutoGetCollectionForRead::AutoGetCollectionForRead(OperationContext* txn,
                                                        const std::string& ns)
             : _txn(txn),
+              _batchBoundaryRead(txn),
               _transaction(txn, MODE_IS),
               _db(_txn, nsToDatabaseSubstring(ns), MODE_IS),
               _collLock(_txn->lockState(), ns, MODE_IS),
@@ -228,6 +260,7 @@ namespace mongo {
     AutoGetCollectionForRead::AutoGetCollectionForRead(OperationContext* txn,
                                                        const NamespaceString& nss)
             : _txn(txn),
+              _batchBoundaryRead(txn),
               _transaction(txn, MODE_IS),
               _db(_txn, nss.db(), MODE_IS),
               _collLock(_txn->lockState(), nss.toString(), MODE_IS),
@@ -414,6 +447,7 @@ namespace mongo {
         keyUpdates = 0;  // unsigned, so -1 not possible
         planSummary = "";
         execStats.reset();
+        resources.reset();
         
         exceptionInfo.reset();
         
@@ -493,6 +527,12 @@ namespace mongo {
 
         if (!getGlobalEnvironment()->getGlobalStorageEngine()->supportsDocLocking())
             s << " numYields:" << curop.numYields();
+
+        if (!resources.empty()) {
+            BSONObjBuilder resourcesBuilder;
+            resources.append(&resourcesBuilder);
+            s << " resources:" << resourcesBuilder.done().toString();
+        }
         
         s << " ";
         
@@ -583,6 +623,12 @@ namespace mongo {
         if (!getGlobalEnvironment()->getGlobalStorageEngine()->supportsDocLocking())
             b.appendNumber( "numYield" , curop.numYields() );
 
+        if (!resources.empty()) {
+            BSONObjBuilder resourcesBuilder(b.subobjStart("resources"));
+            resources.append(&resourcesBuilder);
+            resourcesBuilder.done();
+        }
+
         if ( ! exceptionInfo.empty() )
             exceptionInfo.append( b , "exception" , "exceptionCode" );
 
@@ -145,11 +145,28 @@ namespace mongo {
         }
 
     private:
+        /**
+         * Lets a read on a secondary skip waiting for the replication batch being applied, when
+         * the storage engine can serve it from the data as of the last batch boundary.  Must be
+         * in effect before the locks are taken.
+         */
+        class BatchBoundaryRead {
+            MONGO_DISALLOW_COPYING(BatchBoundaryRead);
+        public:
+            explicit BatchBoundaryRead(OperationContext* txn);
+            ~BatchBoundaryRead();
+
+        private:
+            OperationContext* const _txn;
+            bool _active;
+        };
+
         void _init(const std::string& ns,
                    const StringData& coll);
 
         const Timer _timer;
         OperationContext* const _txn;
+        const BatchBoundaryRead _batchBoundaryRead;
         const ScopedTransaction _transaction;
         const AutoGetDb _db;
         const Lock::CollectionLock _collLock;
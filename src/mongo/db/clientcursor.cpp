@@ -102,7 +102,7 @@ namespace mongo {
     void ClientCursor::init() {
         invariant( _collection );
 
-        _isPinned = false;
+        _isPinned.store(0);
         _isNoTimeout = false;
 
         _idleAgeMillis = 0;
@@ -129,7 +129,7 @@ namespace mongo {
             return;
         }
 
-        invariant( !_isPinned ); // Must call unsetPinned() before invoking destructor.
+        invariant( !isPinned() ); // Must call unsetPinned() before invoking destructor.
 
         if ( _countedYet ) {
             _countedYet = false;
@@ -163,7 +163,7 @@ namespace mongo {
 
     bool ClientCursor::shouldTimeout(int millis) {
         _idleAgeMillis += millis;
-        if (_isNoTimeout || _isPinned) {
+        if (_isNoTimeout || isPinned()) {
             return false;
         }
         return _idleAgeMillis > 600000;
@@ -241,7 +241,7 @@ namespace mongo {
             deleteUnderlying();
         }
         else {
-            // Unpin the cursor under the collection cursor cache lock.
+            // Unpin the cursor through the collection cursor cache.
             _cursor->collection()->cursorCache()->unpin( _cursor );
         }
     }
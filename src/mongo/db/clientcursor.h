@@ -34,6 +34,7 @@
 #include "mongo/db/keypattern.h"
 #include "mongo/db/query/plan_executor.h"
 #include "mongo/db/record_id.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/s/collection_metadata.h"
 #include "mongo/util/background.h"
 #include "mongo/util/net/message.h"
@@ -86,17 +87,23 @@ namespace mongo {
         //
 
         /**
-         * Marks this ClientCursor as in use.  unsetPinned() must be called before the destructor of
-         * this ClientCursor is invoked.
+         * Atomically marks this ClientCursor as in use.  Returns false, without changing anything,
+         * if it was already pinned.  unsetPinned() must be called before the destructor of this
+         * ClientCursor is invoked.
          */
-        void setPinned() { _isPinned = true; }
+        bool tryPin() { return _isPinned.compareAndSwap(0, 1) == 0; }
+
+        /**
+         * Marks this ClientCursor as in use.  It must not already be pinned.
+         */
+        void setPinned() { invariant(tryPin()); }
 
         /**
          * Marks this ClientCursor as no longer in use.
          */
-        void unsetPinned() { _isPinned = false; }
+        void unsetPinned() { _isPinned.store(0); }
 
-        bool isPinned() const { return _isPinned; }
+        bool isPinned() const { return _isPinned.load() != 0; }
 
         /**
          * This is called when someone is dropping a collection or something else that
@@ -242,8 +249,9 @@ namespace mongo {
         // Note: This should *not* be set for the internal cursor used as input to an aggregation.
         bool _isAggCursor;
 
-        // Is this cursor in use?  Defaults to false.
-        bool _isPinned;
+        // Is this cursor in use?  Defaults to false.  Atomic so that pinning and unpinning
+        // only need the cursor cache's lock to find the cursor, not to change its state.
+        AtomicUInt32 _isPinned;
 
         // Is the "no timeout" flag set on this cursor?  If false, this cursor may be targeted for
         // deletion after an interval of inactivity.  Defaults to false.
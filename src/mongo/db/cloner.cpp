@@ -34,15 +34,20 @@
 
 #include "mongo/db/cloner.h"
 
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
 #include "mongo/base/status.h"
 #include "mongo/bson/util/builder.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/authorization_manager_global.h"
+#include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/auth/internal_user_auth.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/catalog/index_create.h"
+#include "mongo/db/client.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/commands/copydb.h"
 #include "mongo/db/commands/rename_collection.h"
@@ -51,16 +56,28 @@
 #include "mongo/db/index_builder.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/db/operation_context_impl.h"
 #include "mongo/db/repl/isself.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
+#include "mongo/stdx/functional.h"
 #include "mongo/util/log.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
     MONGO_EXPORT_SERVER_PARAMETER(skipCorruptDocumentsWhenCloning, bool, false);
 
+    // Number of collections a clone, such as the data phase of initial sync, copies at once from
+    // another server, each over its own connection.  1 copies them one after another.
+    MONGO_EXPORT_SERVER_PARAMETER(clonerParallelCollections, int, 1);
+
+    // When copying collections in parallel, collections larger than this are split into _id
+    // ranges of about this size, which the threads copy as if they were separate collections.
+    // 0 copies every collection over a single cursor.
+    MONGO_EXPORT_SERVER_PARAMETER(clonerCollectionSplitBytes, long long, 1024 * 1024 * 1024);
+
     BSONElement getErrField(const BSONObj& o);
 
     /* for index info object:
@@ -151,6 +168,10 @@ namespace mongo {
                     }
                 }
 
+                // Cheap enough to do for every document, so a kill or maxTimeMS stops a big
+                // clone right away.
+                txn->checkForInterrupt();
+
                 BSONObj tmp = i.nextSafe();
 
                 /* assure object is valid.  note this will slow us down a little. */
@@ -360,6 +381,276 @@ namespace mongo {
         return true;
     }
 
+    void Cloner::buildIdIndex(OperationContext* txn,
+                              const string& toDBName,
+                              const NamespaceString& to_ns,
+                              const CloneOptions& opts) {
+        Database* db = dbHolder().get(txn, toDBName);
+        uassert(18645,
+                str::stream() << "database " << toDBName << " dropped during clone",
+                db);
+
+        Collection* c = db->getCollection( txn, to_ns );
+        if ( c && !c->getIndexCatalog()->haveIdIndex( txn ) ) {
+            // We need to drop objects with duplicate _ids because we didn't do a true
+            // snapshot and this is before applying oplog operations that occur during the
+            // initial sync.
+            set<RecordId> dups;
+
+            MultiIndexBlock indexer(txn, c);
+            if (opts.mayBeInterrupted)
+                indexer.allowInterruption();
+
+            uassertStatusOK(indexer.init(c->getIndexCatalog()->getDefaultIdIndexSpec()));
+            uassertStatusOK(indexer.insertAllDocumentsInCollection(&dups));
+
+            for (set<RecordId>::const_iterator it = dups.begin(); it != dups.end(); ++it) {
+                WriteUnitOfWork wunit(txn);
+                BSONObj id;
+
+                c->deleteDocument(txn, *it, true, true, opts.logForRepl ? &id : NULL);
+                if (opts.logForRepl)
+                    repl::logOp(txn, "d", c->ns().ns().c_str(), id);
+                wunit.commit();
+            }
+
+            if (!dups.empty()) {
+                log() << "index build dropped: " << dups.size() << " dups";
+            }
+
+            WriteUnitOfWork wunit(txn);
+            indexer.commit();
+            if (opts.logForRepl) {
+                repl::logOp(txn,
+                            "i",
+                            c->ns().getSystemIndexesCollection().c_str(),
+                            c->getIndexCatalog()->getDefaultIdIndexSpec());
+            }
+            wunit.commit();
+        }
+    }
+
+    /**
+     * One unit of work for the parallel copy: the documents of 'collectionName' whose _id falls
+     * in the index range [min, max).  An empty bound leaves that side of the range open.
+     */
+    struct Cloner::CopyRange {
+        string collectionName;
+        BSONObj min;
+        BSONObj max;
+    };
+
+    struct Cloner::ParallelCopyState {
+        ParallelCopyState(const ConnectionString& source,
+                          const string& toDBName,
+                          const CloneOptions& opts)
+            : source(source),
+              toDBName(toDBName),
+              opts(opts),
+              status(Status::OK()) { }
+
+        const ConnectionString& source;
+        const string& toDBName;
+        const CloneOptions& opts;
+
+        // Guards 'remaining', 'rangesLeft' and 'status'.
+        boost::mutex mutex;
+
+        // Ranges no worker has taken yet, the next one at the back.
+        vector<CopyRange> remaining;
+
+        // Per collection, the ranges not yet copied.  Whoever copies the last one builds the
+        // _id index, once the whole collection is in.
+        map<string, int> rangesLeft;
+
+        // The first error any worker hit.  The others stop once they see it.
+        Status status;
+    };
+
+    void Cloner::parallelCopyWorker(ParallelCopyState* state, int workerId) {
+        const string threadName = str::stream() << "cloner" << workerId;
+        Client::initThread(threadName.c_str());
+        OperationContextImpl txn;
+        txn.getClient()->getAuthorizationSession()->grantInternalAuthorization();
+
+        const CloneOptions& opts = state->opts;
+        try {
+            string errmsg;
+            Cloner cloner;
+            cloner.setConnection(state->source.connect(errmsg));
+            uassert(28610,
+                    str::stream() << "cloner couldn't connect to " << state->source.toString()
+                                  << ": " << errmsg,
+                    cloner._conn.get());
+            uassert(28611,
+                    str::stream() << "cloner couldn't authenticate to "
+                                  << state->source.toString(),
+                    !getGlobalAuthorizationManager()->isAuthEnabled()
+                        || authenticateInternalUser(cloner._conn.get()));
+
+            while (true) {
+                CopyRange range;
+                {
+                    boost::lock_guard<boost::mutex> lk(state->mutex);
+                    if (!state->status.isOK() || state->remaining.empty())
+                        break;
+                    range = state->remaining.back();
+                    state->remaining.pop_back();
+                }
+
+                NamespaceString from_name(opts.fromDB, range.collectionName);
+                NamespaceString to_name(state->toDBName, range.collectionName);
+                LOG(1) << "\t\t cloning " << from_name << " -> " << to_name
+                       << " from " << range.min << " to " << range.max << endl;
+
+                Timer timer;
+                Query q;
+                if (range.min.isEmpty() && range.max.isEmpty()) {
+                    if (opts.snapshot)
+                        q.snapshot();
+                }
+                else {
+                    // Walking the _id index already returns each document at most once, which
+                    // is all snapshot would have given us.  Index bounds rather than $gte/$lt
+                    // keep _ids of every type in exactly one range.
+                    q.hint(BSON("_id" << 1));
+                    if (!range.min.isEmpty())
+                        q.minKey(range.min);
+                    if (!range.max.isEmpty())
+                        q.maxKey(range.max);
+                }
+
+                cloner.copy(&txn,
+                            state->toDBName,
+                            from_name,
+                            to_name,
+                            opts.logForRepl,
+                            false,
+                            opts.slaveOk,
+                            opts.mayYield,
+                            opts.mayBeInterrupted,
+                            q);
+
+                bool lastRange;
+                {
+                    boost::lock_guard<boost::mutex> lk(state->mutex);
+                    lastRange = --state->rangesLeft[range.collectionName] == 0;
+                }
+
+                if (lastRange) {
+                    ScopedTransaction transaction(&txn, MODE_X);
+                    Lock::GlobalWrite lk(txn.lockState());
+                    cloner.buildIdIndex(&txn, state->toDBName, to_name, opts);
+                }
+
+                log() << "cloned " << from_name << " from " << range.min << " to " << range.max
+                      << " in " << timer.seconds() << " secs";
+            }
+        }
+        catch (const DBException& ex) {
+            boost::lock_guard<boost::mutex> lk(state->mutex);
+            if (state->status.isOK())
+                state->status = ex.toStatus();
+        }
+
+        txn.getClient()->shutdown();
+    }
+
+    void Cloner::copyCollectionsInParallel(OperationContext* txn,
+                                           const ConnectionString& source,
+                                           const string& toDBName,
+                                           const vector<string>& collectionNames,
+                                           const CloneOptions& opts,
+                                           int numThreads) {
+        ParallelCopyState state(source, toDBName, opts);
+
+        bool copied = false;
+        {
+            Lock::TempRelease tempRelease(txn->lockState());
+
+            // Locks held recursively stay held, and the workers would wait on them forever.
+            if (!txn->lockState()->isLocked()) {
+                for (vector<string>::const_reverse_iterator it = collectionNames.rbegin();
+                     it != collectionNames.rend(); ++it) {
+                    vector<CopyRange> ranges;
+                    splitCollection(NamespaceString(opts.fromDB, *it), opts.slaveOk, &ranges);
+                    state.remaining.insert(state.remaining.end(), ranges.rbegin(), ranges.rend());
+                    state.rangesLeft[*it] = ranges.size();
+                }
+                numThreads = std::min(numThreads, static_cast<int>(state.remaining.size()));
+
+                log() << "cloning " << collectionNames.size() << " collections of "
+                      << opts.fromDB << " as " << state.remaining.size() << " ranges on "
+                      << numThreads << " threads";
+
+                boost::thread_group workers;
+                for (int i = 0; i < numThreads; i++) {
+                    workers.create_thread(stdx::bind(&Cloner::parallelCopyWorker, &state, i));
+                }
+                workers.join_all();
+                copied = true;
+            }
+        }
+
+        if (!copied) {
+            for (size_t i = 0; i < collectionNames.size(); i++) {
+                NamespaceString from_name(opts.fromDB, collectionNames[i]);
+                NamespaceString to_name(toDBName, collectionNames[i]);
+                Query q;
+                if (opts.snapshot)
+                    q.snapshot();
+
+                copy(txn,
+                     toDBName,
+                     from_name,
+                     to_name,
+                     opts.logForRepl,
+                     false,
+                     opts.slaveOk,
+                     opts.mayYield,
+                     opts.mayBeInterrupted,
+                     q);
+                buildIdIndex(txn, toDBName, to_name, opts);
+            }
+        }
+
+        uassertStatusOK(state.status);
+    }
+
+    void Cloner::splitCollection(const NamespaceString& from_name,
+                                 bool slaveOk,
+                                 vector<CopyRange>* ranges) {
+        CopyRange whole;
+        whole.collectionName = from_name.coll().toString();
+
+        BSONObj res;
+        if (clonerCollectionSplitBytes > 0) {
+            // splitVector leaves about half of maxChunkSizeBytes between split points.
+            BSONObj cmd = BSON("splitVector" << from_name.ns()
+                               << "keyPattern" << BSON("_id" << 1)
+                               << "maxChunkSizeBytes" << 2 * clonerCollectionSplitBytes);
+            // A failure, e.g. a collection without an _id index, just means no split.
+            if (!_conn->runCommand(from_name.db().toString(), cmd, res,
+                                   slaveOk ? QueryOption_SlaveOk : 0)) {
+                LOG(1) << "not splitting " << from_name << " for cloning: " << res;
+                res = BSONObj();
+            }
+        }
+
+        vector<BSONElement> splitKeys;
+        if (res["splitKeys"].type() == Array)
+            splitKeys = res["splitKeys"].Array();
+
+        for (size_t i = 0; i <= splitKeys.size(); i++) {
+            CopyRange range = whole;
+            if (i > 0)
+                range.min = splitKeys[i - 1].Obj().getOwned();
+            if (i < splitKeys.size())
+                range.max = splitKeys[i].Obj().getOwned();
+            ranges->push_back(range);
+        }
+    }
+
     bool Cloner::go(OperationContext* txn,
                     const std::string& toDBName,
                     const string& masterHost,
@@ -484,6 +775,13 @@ namespace mongo {
         }
 
         if ( opts.syncData ) {
+            // Only another process can be read over several connections.  The collections are
+            // all created first, then copied.
+            const bool parallelCopy = clonerParallelCollections > 1
+                                   && !masterSameProcess
+                                   && (toClone.size() > 1 || clonerCollectionSplitBytes > 0);
+            vector<string> parallelCollectionNames;
+
             for ( list<BSONObj>::iterator i=toClone.begin(); i != toClone.end(); i++ ) {
                 BSONObj collection = *i;
                 LOG(2) << "  really will clone: " << collection << endl;
@@ -519,6 +817,11 @@ namespace mongo {
                 if( opts.snapshot )
                     q.snapshot();
 
+                if (parallelCopy) {
+                    parallelCollectionNames.push_back(collectionName);
+                    continue;
+                }
+
                 copy(txn,
                      toDBName,
                      from_name,
@@ -530,49 +833,16 @@ namespace mongo {
                      opts.mayBeInterrupted,
                      q);
 
-                db = dbHolder().get(txn, toDBName);
-                uassert(18645,
-                        str::stream() << "database " << toDBName << " dropped during clone",
-                        db);
-
-                Collection* c = db->getCollection( txn, to_name );
-                if ( c && !c->getIndexCatalog()->haveIdIndex( txn ) ) {
-                    // We need to drop objects with duplicate _ids because we didn't do a true
-                    // snapshot and this is before applying oplog operations that occur during the
-                    // initial sync.
-                    set<RecordId> dups;
-
-                    MultiIndexBlock indexer(txn, c);
-                    if (opts.mayBeInterrupted)
-                        indexer.allowInterruption();
-
-                    uassertStatusOK(indexer.init(c->getIndexCatalog()->getDefaultIdIndexSpec()));
-                    uassertStatusOK(indexer.insertAllDocumentsInCollection(&dups));
-
-                    for (set<RecordId>::const_iterator it = dups.begin(); it != dups.end(); ++it) {
-                        WriteUnitOfWork wunit(txn);
-                        BSONObj id;
-
-                        c->deleteDocument(txn, *it, true, true, opts.logForRepl ? &id : NULL);
-                        if (opts.logForRepl)
-                            repl::logOp(txn, "d", c->ns().ns().c_str(), id);
-                        wunit.commit();
-                    }
-
-                    if (!dups.empty()) {
-                        log() << "index build dropped: " << dups.size() << " dups";
-                    }
+                buildIdIndex(txn, toDBName, to_name, opts);
+            }
 
-                    WriteUnitOfWork wunit(txn);
-                    indexer.commit();
-                    if (opts.logForRepl) {
-                        repl::logOp(txn,
-                                    "i",
-                                    c->ns().getSystemIndexesCollection().c_str(),
-                                    c->getIndexCatalog()->getDefaultIdIndexSpec());
-                    }
-                    wunit.commit();
-                }
+            if (!parallelCollectionNames.empty()) {
+                copyCollectionsInParallel(txn,
+                                          cs,
+                                          toDBName,
+                                          parallelCollectionNames,
+                                          opts,
+                                          clonerParallelCollections);
             }
         }
 
@@ -36,6 +36,7 @@
 namespace mongo {
 
     struct CloneOptions;
+    class ConnectionString;
     class DBClientBase;
     class NamespaceString;
     class OperationContext;
@@ -90,7 +91,45 @@ namespace mongo {
                          bool mayYield,
                          bool mayBeInterrupted);
 
+        /**
+         * Builds the _id index of the freshly copied 'to_ns' if it has none, dropping documents
+         * with duplicate _ids.  The caller must hold a write lock on the database.
+         */
+        void buildIdIndex(OperationContext* txn,
+                          const std::string& toDBName,
+                          const NamespaceString& to_ns,
+                          const CloneOptions& opts);
+
+        /**
+         * Copies the collections 'collectionNames' of opts.fromDB, which must already exist in
+         * 'toDBName', and builds their _id indexes.  Up to 'numThreads' threads work at once,
+         * each taking one collection, or one _id range of a large collection, at a time over its
+         * own connection to 'source'.
+         *
+         * The caller's locks are released meanwhile and must not be held recursively.
+         */
+        void copyCollectionsInParallel(OperationContext* txn,
+                                       const ConnectionString& source,
+                                       const std::string& toDBName,
+                                       const std::vector<std::string>& collectionNames,
+                                       const CloneOptions& opts,
+                                       int numThreads);
+
+        struct CopyRange;
+
+        /**
+         * Appends to 'ranges' the _id ranges, each of about clonerCollectionSplitBytes, that
+         * together cover 'from_name' on the source.  A collection that is small or can't be split
+         * comes back as a single unbounded range.
+         */
+        void splitCollection(const NamespaceString& from_name,
+                             bool slaveOk,
+                             std::vector<CopyRange>* ranges);
+
         struct Fun;
+        struct ParallelCopyState;
+        static void parallelCopyWorker(ParallelCopyState* state, int workerId);
+
         std::auto_ptr<DBClientBase> _conn;
     };
 
@@ -0,0 +1,151 @@
+/*    Copyright 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <string>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/collection_info_cache.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/index/index_access_method.h"
+#include "mongo/db/index/index_cursor.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/index_names.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/query/index_statistics.h"
+
+namespace mongo {
+
+    using boost::shared_ptr;
+    using std::string;
+    using std::stringstream;
+
+    /**
+     * Scans every btree and hashed index of a collection to gather the statistics the query
+     * planner uses to prune candidate plans.  The statistics are kept in memory only and are
+     * dropped whenever the collection's indexes change.
+     */
+    class AnalyzeCmd : public Command {
+    public:
+        AnalyzeCmd() : Command("analyze") { }
+
+        virtual bool isWriteCommandForConfigServer() const { return false; }
+        virtual bool slaveOk() const { return true; }
+        virtual void help(stringstream& help) const {
+            help << "gather index statistics for the query planner\n"
+                    "{ analyze : <collection_name> }";
+        }
+
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::planCacheWrite);
+            out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
+        }
+
+        virtual bool run(OperationContext* txn,
+                         const string& dbname,
+                         BSONObj& cmdObj,
+                         int,
+                         string& errmsg,
+                         BSONObjBuilder& result,
+                         bool fromRepl) {
+            const NamespaceString nss(parseNs(dbname, cmdObj));
+            if (!nss.isNormal()) {
+                errmsg = "bad namespace name";
+                return false;
+            }
+
+            AutoGetCollectionForRead ctx(txn, nss);
+            Collection* collection = ctx.getCollection();
+            if (!collection) {
+                errmsg = "collection not found";
+                return false;
+            }
+
+            const long long numRecords = collection->numRecords(txn);
+            CollectionInfoCache::IndexStatisticsMap allStats;
+            BSONObjBuilder indexesBuilder(result.subobjStart("indexes"));
+
+            IndexCatalog* catalog = collection->getIndexCatalog();
+            IndexCatalog::IndexIterator ii = catalog->getIndexIterator(txn, false);
+            while (ii.more()) {
+                IndexDescriptor* desc = ii.next();
+                const string& type = desc->getAccessMethodName();
+                if (type != IndexNames::BTREE && type != IndexNames::HASHED) {
+                    continue;
+                }
+
+                CursorOptions cursorOptions;
+                cursorOptions.direction = CursorOptions::INCREASING;
+                IndexCursor* rawCursor;
+                Status status = catalog->getIndex(desc)->newCursor(txn, cursorOptions, &rawCursor);
+                if (!status.isOK()) {
+                    return appendCommandStatus(result, status);
+                }
+                boost::scoped_ptr<IndexCursor> cursor(rawCursor);
+
+                status = cursor->seek(minKey);
+                if (!status.isOK()) {
+                    return appendCommandStatus(result, status);
+                }
+
+                shared_ptr<IndexStatistics> stats(new IndexStatistics());
+                for (; !cursor->isEOF(); cursor->next()) {
+                    stats->addKey(cursor->getKey());
+                    if (0 == stats->numKeys() % 4096) {
+                        txn->checkForInterrupt();
+                    }
+                }
+
+                BSONObjBuilder indexBuilder(indexesBuilder.subobjStart(desc->indexName()));
+                stats->appendStats(&indexBuilder);
+                indexBuilder.doneFast();
+
+                allStats[desc->keyPattern().getOwned()] = stats;
+            }
+            indexesBuilder.doneFast();
+
+            collection->infoCache()->setIndexStatistics(allStats, numRecords);
+            result.appendNumber("numRecords", numRecords);
+            return true;
+        }
+
+    } analyzeCmd;
+
+}  // namespace mongo
@@ -0,0 +1,335 @@
+// backup_cmd.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kStorage
+
+#include "mongo/platform/basic.h"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/optional.hpp>
+#include <boost/thread/mutex.hpp>
+#include <ctime>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/global_environment_experiment.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/storage/storage_engine.h"
+#include "mongo/db/storage_options.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace {
+
+    typedef StorageEngine::BackupFile BackupFile;
+
+    /**
+     * What one backup copied of each file, remembered so a later backup only lists what
+     * changed since.  Manifests are kept in memory and are lost on restart, after which the
+     * next backup has to be a full one.
+     */
+    struct BackupManifest {
+        struct File {
+            long long size;
+            time_t mtime;
+        };
+
+        OID id;
+        time_t began;
+        std::map<std::string, File> files;
+    };
+
+    /**
+     * The open backup and the manifests of the last few completed ones.
+     */
+    class BackupRegistry {
+    public:
+        static const size_t kMaxManifests = 16;
+
+        BackupRegistry() : _open(false) { }
+
+        /**
+         * Pins a backup via the storage engine and appends the files to copy to 'out'.  When
+         * 'incrementalFrom' is set, files the previous backup already holds are listed with a
+         * length of 0, and files which only grew with the offset their new bytes start at.
+         */
+        Status begin(OperationContext* txn,
+                     const boost::optional<OID>& incrementalFrom,
+                     BSONObjBuilder* out) {
+            boost::mutex::scoped_lock lk(_mutex);
+            if (_open) {
+                return Status(ErrorCodes::IllegalOperation,
+                              str::stream() << "backup " << _current.id.toString()
+                                            << " is already open, run endBackup first");
+            }
+
+            const BackupManifest* previous = NULL;
+            if (incrementalFrom) {
+                previous = _find(*incrementalFrom);
+                if (!previous) {
+                    return Status(ErrorCodes::NoSuchKey,
+                                  str::stream() << "backup " << incrementalFrom->toString()
+                                                << " is not known, take a full backup");
+                }
+            }
+
+            _current = BackupManifest();
+            _current.id = OID::gen();
+            _current.began = time(0);
+
+            StorageEngine* storageEngine = getGlobalEnvironment()->getGlobalStorageEngine();
+            std::vector<BackupFile> files;
+            Status status = storageEngine->beginBackup(txn, &files);
+            if (!status.isOK()) {
+                return status;
+            }
+
+            BSONArrayBuilder filesBuilder;
+            for (size_t i = 0; i < files.size(); i++) {
+                const boost::filesystem::path path =
+                    boost::filesystem::path(storageGlobalParams.dbpath) / files[i].name;
+                boost::system::error_code ec;
+                const long long onDisk = static_cast<long long>(
+                    boost::filesystem::file_size(path, ec));
+                BackupManifest::File file;
+                if (!ec) {
+                    file.mtime = boost::filesystem::last_write_time(path, ec);
+                }
+                if (ec) {
+                    storageEngine->endBackup(txn);
+                    return Status(ErrorCodes::FileStreamFailed,
+                                  str::stream() << "cannot stat " << path.string() << ": "
+                                                << ec.message());
+                }
+                file.size = files[i].length < 0 ? onDisk : files[i].length;
+                _current.files[files[i].name] = file;
+
+                long long offset = 0;
+                long long length = file.size;
+                if (previous) {
+                    _delta(files[i], file, *previous, &offset, &length);
+                }
+                filesBuilder.append(BSON("filename" << files[i].name
+                                         << "fileSize" << file.size
+                                         << "offset" << offset
+                                         << "length" << length));
+            }
+
+            _open = true;
+            log() << "opened backup " << _current.id << " of " << files.size() << " files"
+                  << (previous ? " since backup " + previous->id.toString() : std::string());
+
+            out->append("backupId", _current.id);
+            if (previous) {
+                out->append("incrementalFrom", previous->id);
+            }
+            out->append("dbpath", storageGlobalParams.dbpath);
+            out->append("files", filesBuilder.arr());
+            return Status::OK();
+        }
+
+        /**
+         * Releases the open backup.  Unless 'completed' is false, later backups can be taken
+         * incrementally from it.
+         */
+        Status end(OperationContext* txn, const OID& id, bool completed) {
+            boost::mutex::scoped_lock lk(_mutex);
+            if (!_open || _current.id != id) {
+                return Status(ErrorCodes::NoSuchKey,
+                              str::stream() << "backup " << id.toString() << " is not open");
+            }
+
+            getGlobalEnvironment()->getGlobalStorageEngine()->endBackup(txn);
+            _open = false;
+            if (completed) {
+                _manifests.push_back(_current);
+                if (_manifests.size() > kMaxManifests) {
+                    _manifests.pop_front();
+                }
+            }
+            log() << "closed backup " << id << (completed ? "" : ", which was abandoned");
+            return Status::OK();
+        }
+
+    private:
+        const BackupManifest* _find(const OID& id) const {
+            for (size_t i = 0; i < _manifests.size(); i++) {
+                if (_manifests[i].id == id) {
+                    return &_manifests[i];
+                }
+            }
+            return NULL;
+        }
+
+        static void _delta(const BackupFile& listed,
+                           const BackupManifest::File& file,
+                           const BackupManifest& previous,
+                           long long* offset,
+                           long long* length) {
+            std::map<std::string, BackupManifest::File>::const_iterator it =
+                previous.files.find(listed.name);
+            if (it == previous.files.end()) {
+                return;
+            }
+            const BackupManifest::File& before = it->second;
+
+            switch (listed.kind) {
+            case BackupFile::kImmutable:
+                *length = 0;
+                return;
+            case BackupFile::kAppendOnly:
+                if (file.size >= before.size) {
+                    *offset = before.size;
+                    *length = file.size - before.size;
+                }
+                return;
+            case BackupFile::kMutable:
+                // Modification times only have a granularity of a second, so a file can only be
+                // trusted to be unchanged if it was last written well before the previous backup
+                // looked at it.
+                if (file.size == before.size && file.mtime == before.mtime &&
+                        before.mtime + 1 < previous.began) {
+                    *length = 0;
+                }
+                return;
+            }
+        }
+
+        boost::mutex _mutex;
+        bool _open;
+        BackupManifest _current;
+        std::deque<BackupManifest> _manifests;
+    } backupRegistry;
+
+    void addBackupPrivileges(std::vector<Privilege>* out) {
+        ActionSet actions;
+        actions.addAction(ActionType::fsync);
+        out->push_back(Privilege(ResourcePattern::forClusterResource(), actions));
+    }
+
+    /**
+     * { beginBackup: 1, incrementalFrom: <backupId> }
+     *
+     * Pins a consistent image of the data files without blocking writes and lists the files,
+     * relative to the dbpath, with the byte range [offset, offset + length) of each to copy.  A
+     * length of 0 means the copy taken by the earlier backup is still current; files the
+     * earlier backup had which are not listed were removed.
+     */
+    class BeginBackupCmd : public Command {
+    public:
+        BeginBackupCmd() : Command("beginBackup") { }
+
+        virtual bool slaveOk() const { return true; }
+        virtual bool adminOnly() const { return true; }
+        virtual bool isWriteCommandForConfigServer() const { return false; }
+
+        virtual void help(std::stringstream& help) const {
+            help << "pins the data files for a hot backup until endBackup\n"
+                    "{ beginBackup: 1, incrementalFrom: <backupId> }";
+        }
+
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            addBackupPrivileges(out);
+        }
+
+        virtual bool run(OperationContext* txn,
+                         const std::string& dbname,
+                         BSONObj& cmdObj,
+                         int options,
+                         std::string& errmsg,
+                         BSONObjBuilder& result,
+                         bool fromRepl) {
+            boost::optional<OID> incrementalFrom;
+            BSONElement from = cmdObj["incrementalFrom"];
+            if (!from.eoo()) {
+                if (from.type() != jstOID) {
+                    errmsg = "incrementalFrom must be the backupId of an earlier backup";
+                    return false;
+                }
+                incrementalFrom = from.OID();
+            }
+            return appendCommandStatus(result, backupRegistry.begin(txn, incrementalFrom,
+                                                                    &result));
+        }
+    } beginBackupCmd;
+
+    /**
+     * { endBackup: <backupId>, abandon: <bool> }
+     *
+     * Lets the storage engine reuse the pinned files again.  A backup which is abandoned
+     * cannot be used as the base of a later incremental backup.
+     */
+    class EndBackupCmd : public Command {
+    public:
+        EndBackupCmd() : Command("endBackup") { }
+
+        virtual bool slaveOk() const { return true; }
+        virtual bool adminOnly() const { return true; }
+        virtual bool isWriteCommandForConfigServer() const { return false; }
+
+        virtual void help(std::stringstream& help) const {
+            help << "releases the files pinned by beginBackup\n"
+                    "{ endBackup: <backupId>, abandon: false }";
+        }
+
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            addBackupPrivileges(out);
+        }
+
+        virtual bool run(OperationContext* txn,
+                         const std::string& dbname,
+                         BSONObj& cmdObj,
+                         int options,
+                         std::string& errmsg,
+                         BSONObjBuilder& result,
+                         bool fromRepl) {
+            BSONElement id = cmdObj.firstElement();
+            if (id.type() != jstOID) {
+                errmsg = "endBackup takes the backupId returned by beginBackup";
+                return false;
+            }
+            return appendCommandStatus(result, backupRegistry.end(txn, id.OID(),
+                                                                  !cmdObj["abandon"].trueValue()));
+        }
+    } endBackupCmd;
+
+}  // namespace
+}  // namespace mongo
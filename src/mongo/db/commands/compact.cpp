@@ -39,6 +39,7 @@
 #include "mongo/db/background.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
+#include "mongo/db/client.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/concurrency/d_concurrency.h"
@@ -69,7 +70,11 @@ namespace mongo {
                 "{ compact : <collection_name>, [force:<bool>], [validate:<bool>],\n"
                 "  [paddingFactor:<num>], [paddingBytes:<num>] }\n"
                 "  force - allows to run on a replica set primary\n"
-                "  validate - check records are noncorrupt before adding to newly compacting extents. slower but safer (defaults to true in this version)\n";
+                "  validate - check records are noncorrupt before adding to newly compacting extents. slower but safer (defaults to true in this version)\n"
+                "{ compact : <collection_name>, online : true, [batchSize:<num>] }\n"
+                "  online - move documents out of the last extents a batch at a time, yielding\n"
+                "           between batches, and free the extents once empty. safe on primaries\n"
+                "  batchSize - documents moved per batch (default 100)\n";
         }
         CompactCmd() : Command("compact") { }
 
@@ -91,8 +96,11 @@ namespace mongo {
                 return false;
             }
 
+            const bool online = cmdObj["online"].trueValue();
+
             repl::ReplicationCoordinator* replCoord = repl::getGlobalReplicationCoordinator();
-            if (replCoord->getCurrentMemberState().primary() && !cmdObj["force"].trueValue()) {
+            if (!online &&
+                replCoord->getCurrentMemberState().primary() && !cmdObj["force"].trueValue()) {
                 errmsg = "will not run compact on an active replica set primary as this is a slow blocking operation. use force:true to force";
                 return false;
             }
@@ -110,6 +118,10 @@ namespace mongo {
                 return false;
             }
 
+            if ( online ) {
+                return runOnline(txn, ns, cmdObj, errmsg, result);
+            }
+
             CompactOptions compactOptions;
 
             if ( cmdObj["preservePadding"].trueValue() ) {
@@ -177,6 +189,61 @@ namespace mongo {
 
             return true;
         }
+
+    private:
+        /**
+         * Compacts 'ns' a batch of documents at a time, only holding the collection lock for
+         * each batch so that reads and writes can get in between them.
+         */
+        bool runOnline(OperationContext* txn,
+                       const NamespaceString& ns,
+                       const BSONObj& cmdObj,
+                       string& errmsg,
+                       BSONObjBuilder& result) {
+            int batchSize = 100;
+            if ( cmdObj.hasElement("batchSize") ) {
+                batchSize = cmdObj["batchSize"].numberInt();
+                if ( batchSize < 1 ) {
+                    errmsg = "invalid batchSize";
+                    return false;
+                }
+            }
+
+            log() << "compact " << ns << " online begin, batchSize: " << batchSize;
+
+            CompactTailStats stats;
+            while ( !stats.done ) {
+                txn->checkForInterrupt();
+
+                ScopedTransaction transaction(txn, MODE_IX);
+                AutoGetDb autoDb(txn, ns.db(), MODE_IX);
+                Lock::CollectionLock collLock(txn->lockState(), ns.ns(), MODE_X);
+                BackgroundOperation::assertNoBgOpInProgForNs(ns.ns());
+
+                Collection* collection = autoDb.getDb() ?
+                    autoDb.getDb()->getCollection(txn, ns.ns()) : NULL;
+                if ( !collection ) {
+                    errmsg = "namespace does not exist";
+                    return false;
+                }
+
+                if ( collection->isCapped() ) {
+                    errmsg = "cannot compact a capped collection";
+                    return false;
+                }
+
+                Status status = collection->compactTail(txn, batchSize, &stats);
+                if ( !status.isOK() )
+                    return appendCommandStatus( result, status );
+            }
+
+            log() << "compact " << ns << " online end, moved " << stats.recordsMoved
+                  << " documents and freed " << stats.extentsFreed << " extents";
+
+            result.appendNumber("recordsMoved", stats.recordsMoved);
+            result.appendNumber("extentsFreed", stats.extentsFreed);
+            return true;
+        }
     };
     static CompactCmd compactCmd;
 
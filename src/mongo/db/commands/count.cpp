@@ -36,6 +36,7 @@
 #include "mongo/db/commands.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/exec/count.h"
+#include "mongo/db/exec/parallel_count.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/explain.h"
 #include "mongo/db/range_preserver.h"
@@ -140,6 +141,17 @@ namespace mongo {
                 txn->getCurOp()->debug().planSummary = Explain::getPlanSummary(exec.get());
             }
 
+            // A count over a collection scan of a big collection may be split across threads.
+            long long parallelCount;
+            if (canCountInParallel(request, exec.get())
+                && tryCountInParallel(txn,
+                                      collection,
+                                      exec->getCanonicalQuery()->root(),
+                                      &parallelCount)) {
+                result.appendNumber("n", parallelCount);
+                return true;
+            }
+
             Status execPlanStatus = exec->executePlan();
             if (!execPlanStatus.isOK()) {
                 return appendCommandStatus(result, execPlanStatus);
@@ -152,9 +164,29 @@ namespace mongo {
                 static_cast<const CountStats*>(countStage->getSpecificStats());
 
             result.appendNumber("n", countStats->nCounted);
+            if (countStats->estimated) {
+                result.appendBool("estimated", true);
+            }
             return true;
         }
 
+        /**
+         * Returns true if 'exec' simply counts the results of a collection scan, so that the
+         * count can be handed to tryCountInParallel() instead of being executed.
+         */
+        static bool canCountInParallel(const CountRequest& request, PlanExecutor* exec) {
+            if (request.explain || request.skip != 0 || request.limit != 0) {
+                return false;
+            }
+
+            if (NULL == exec->getCanonicalQuery()) {
+                return false;
+            }
+
+            vector<PlanStage*> children = exec->getRootStage()->getChildren();
+            return 1 == children.size() && STAGE_COLLSCAN == children[0]->stageType();
+        }
+
         /**
          * Parses a count command object, 'cmdObj'.
          *
@@ -202,6 +234,14 @@ namespace mongo {
                 hintObj = BSON("$hint" << hint);
             }
 
+            bool estimate = false;
+            if (cmdObj["estimate"].ok()) {
+                if (Bool != cmdObj["estimate"].type()) {
+                    return Status(ErrorCodes::BadValue, "estimate value is not a boolean");
+                }
+                estimate = cmdObj["estimate"].boolean();
+            }
+
             std::string ns = parseNs(dbname, cmdObj);
 
             if (!nsIsFull(ns)) {
@@ -214,6 +254,7 @@ namespace mongo {
             request->hint = hintObj;
             request->limit = limit;
             request->skip = skip;
+            request->estimate = estimate;
 
             // By default, count requests are regular count not explain of count.
             request->explain = false;
@@ -45,6 +45,9 @@
  * Example SCons command line: 
  *
  *     scons --release --use-cpu-profiler 
+ *
+ * Every build has the sampling profiler of the profileCpu command, see
+ * sampling_profiler_cmd.cpp.
  */
 
 #include "third_party/gperftools-2.2/src/gperftools/profiler.h"
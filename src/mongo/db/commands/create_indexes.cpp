@@ -223,6 +223,8 @@ namespace mongo {
                         db->getCollection(txn, ns.ns()));
             }
 
+            uassertStatusOK(indexer.drainSideWrites());
+
             {
                 WriteUnitOfWork wunit(txn);
 
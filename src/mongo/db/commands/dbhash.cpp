@@ -32,19 +32,221 @@
 
 #include "mongo/db/commands/dbhash.h"
 
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "mongo/base/owned_pointer_vector.h"
+#include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/client.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/database_catalog_entry.h"
+#include "mongo/db/operation_context_impl.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/log.h"
 #include "mongo/util/md5.hpp"
 #include "mongo/util/timer.h"
+#include "third_party/murmurhash3/MurmurHash3.h"
 
 namespace mongo {
 
+    // Number of threads which hash collections concurrently for dbHash with
+    // hashFunction "murmur3". One or less hashes them all on the calling thread.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(dbHashThreads, int, 4);
+
     DBHashCmd dbhashCmd;
 
+namespace {
+
+    const char kMD5[] = "md5";
+    const char kMurmur3[] = "murmur3";
+
+    // How often a hashing thread checks whether it has been asked to stop.
+    const int kDocumentsBetweenStopChecks = 1024;
+
+    // How long the calling thread sleeps between checks for interruption.
+    const int kInterruptCheckPeriodMillis = 100;
+
+    boost::mutex hashPoolMutex;
+    threadpool::ThreadPool* hashPool = NULL;
+
+    threadpool::ThreadPool* getHashPool() {
+        boost::lock_guard<boost::mutex> lk(hashPoolMutex);
+        if (NULL == hashPool) {
+            hashPool = new threadpool::ThreadPool(dbHashThreads, "dbHash");
+        }
+        return hashPool;
+    }
+
+    std::string toHex(const void* data, size_t len) {
+        static const char hexDigits[] = "0123456789abcdef";
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        std::string out;
+        out.reserve(len * 2);
+        for (size_t i = 0; i < len; i++) {
+            out += hexDigits[bytes[i] >> 4];
+            out += hexDigits[bytes[i] & 0xf];
+        }
+        return out;
+    }
+
+    /**
+     * The murmur3 hash of one collection. Each document is hashed on its own and the 128-bit
+     * results are summed, so the hash does not depend on the order the documents are read in.
+     * Unlike a XOR, the sum does not cancel out a document which is stored twice.
+     */
+    struct CollectionHash {
+        CollectionHash(const std::string& shortName, const Collection* collection)
+            : shortName(shortName), collection(collection), low(0), high(0), numDocs(0) { }
+
+        void add(const BSONObj& doc) {
+            uint64_t h[2];
+            MurmurHash3_x64_128(doc.objdata(), doc.objsize(), 0, h);
+            low += h[0];
+            high += h[1];
+            ++numDocs;
+        }
+
+        std::string finish() const {
+            const uint64_t sums[3] = { low, high, numDocs };
+            uint64_t h[2];
+            MurmurHash3_x64_128(sums, sizeof(sums), 0, h);
+            return toHex(h, sizeof(h));
+        }
+
+        const std::string shortName;
+        const Collection* collection;
+        uint64_t low;
+        uint64_t high;
+        uint64_t numDocs;
+    };
+
+    /**
+     * State shared by hashCollectionsMurmur3() and the threads it schedules. Lives on the
+     * caller's stack, which does not return until 'numRunning' drops to zero.
+     */
+    struct ParallelHashState {
+        explicit ParallelHashState(const std::vector<CollectionHash*>& hashes)
+            : hashes(hashes),
+              numRunning(0),
+              status(Status::OK()) { }
+
+        const std::vector<CollectionHash*>& hashes;
+
+        // Index of the next collection to hand to a thread.
+        AtomicUInt32 nextHash;
+
+        // Set non-zero to make the threads give up early.
+        AtomicUInt32 stop;
+
+        // Guard 'numRunning' and 'status'.
+        boost::mutex mutex;
+        boost::condition_variable workerDone;
+        int numRunning;
+        Status status;
+    };
+
+    /**
+     * Hashes collections until none are left. Pool threads pass a NULL 'callerTxn' and read each
+     * collection through a private OperationContext, which takes no locks: the database lock held
+     * by the caller keeps every collection from changing or going away until all threads are done.
+     */
+    void hashWorker(ParallelHashState* state, OperationContext* callerTxn) {
+        if (!ClientBasic::getCurrent()) {
+            Client::initThreadIfNotAlready("dbHash");
+            cc().getAuthorizationSession()->grantInternalAuthorization();
+        }
+
+        try {
+            unsigned idx;
+            while (!state->stop.load()
+                   && (idx = state->nextHash.fetchAndAdd(1)) < state->hashes.size()) {
+                CollectionHash* hash = state->hashes[idx];
+                boost::scoped_ptr<OperationContextImpl> ownTxn;
+                OperationContext* txn = callerTxn;
+                if (NULL == txn) {
+                    ownTxn.reset(new OperationContextImpl());
+                    txn = ownTxn.get();
+                }
+
+                OwnedPointerVector<RecordIterator> iterators(
+                    hash->collection->getManyIterators(txn));
+
+                int sinceStopCheck = 0;
+                for (size_t i = 0; i < iterators.size() && !state->stop.load(); i++) {
+                    RecordIterator* it = iterators[i];
+                    while (!it->isEOF()) {
+                        if (++sinceStopCheck == kDocumentsBetweenStopChecks) {
+                            sinceStopCheck = 0;
+                            if (state->stop.load()) {
+                                break;
+                            }
+                        }
+
+                        RecordId loc = it->getNext();
+                        hash->add(it->dataFor(loc).toBson());
+                    }
+                }
+            }
+        }
+        catch (const DBException& ex) {
+            boost::lock_guard<boost::mutex> lk(state->mutex);
+            if (state->status.isOK()) {
+                state->status = ex.toStatus();
+            }
+            state->stop.store(1);
+        }
+
+        boost::lock_guard<boost::mutex> lk(state->mutex);
+        if (0 == --state->numRunning) {
+            state->workerDone.notify_all();
+        }
+    }
+
+    /**
+     * Fills in the murmur3 hash of every entry of 'hashes', using up to dbHashThreads threads.
+     * Throws if the operation is killed, after the threads have stopped.
+     */
+    void hashCollectionsMurmur3(OperationContext* txn, const std::vector<CollectionHash*>& hashes) {
+        ParallelHashState state(hashes);
+        const size_t numWorkers = std::min(hashes.size(),
+                                           static_cast<size_t>(std::max(dbHashThreads, 1)));
+        if (numWorkers <= 1) {
+            state.numRunning = 1;
+            hashWorker(&state, txn);
+            uassertStatusOK(state.status);
+            return;
+        }
+
+        threadpool::ThreadPool* pool = getHashPool();
+        state.numRunning = numWorkers;
+        for (size_t i = 0; i < numWorkers; ++i) {
+            pool->schedule(hashWorker, &state, static_cast<OperationContext*>(NULL));
+        }
+
+        {
+            boost::unique_lock<boost::mutex> lk(state.mutex);
+            while (state.numRunning > 0) {
+                state.workerDone.timed_wait(
+                    lk, boost::posix_time::milliseconds(kInterruptCheckPeriodMillis));
+                if (!state.stop.load() && !txn->checkForInterruptNoAssert().isOK()) {
+                    state.stop.store(1);
+                }
+            }
+        }
+
+        txn->checkForInterrupt();
+        uassertStatusOK(state.status);
+    }
+
+}  // namespace
+
 
     void logOpForDbHash(const char* ns) {
         dbhashCmd.wipeCacheForCollection( ns );
@@ -146,6 +348,19 @@ namespace mongo {
             }
         }
 
+        std::string hashFunction = kMD5;
+        if (cmdObj["hashFunction"].ok()) {
+            if (cmdObj["hashFunction"].type() != String) {
+                errmsg = "hashFunction has to be a string";
+                return false;
+            }
+            hashFunction = cmdObj["hashFunction"].String();
+            if (hashFunction != kMD5 && hashFunction != kMurmur3) {
+                errmsg = str::stream() << "unknown hashFunction: " << hashFunction;
+                return false;
+            }
+        }
+
         list<string> colls;
         const string ns = parseNs(dbname, cmdObj);
 
@@ -162,12 +377,7 @@ namespace mongo {
         result.appendNumber( "numCollections" , (long long)colls.size() );
         result.append( "host" , prettyHostName() );
 
-        md5_state_t globalState;
-        md5_init(&globalState);
-
-        vector<string> cached;
-
-        BSONObjBuilder bb( result.subobjStart( "collections" ) );
+        vector<string> toHash;
         for ( list<string>::iterator i=colls.begin(); i != colls.end(); i++ ) {
             string fullCollectionName = *i;
             if ( fullCollectionName.size() -1 <= dbname.size() ) {
@@ -183,6 +393,48 @@ namespace mongo {
                  desiredCollections.count( shortCollectionName ) == 0 )
                 continue;
 
+            toHash.push_back( fullCollectionName );
+        }
+
+        if (hashFunction == kMurmur3) {
+            OwnedPointerVector<CollectionHash> hashes;
+            for (size_t i = 0; i < toHash.size(); i++) {
+                const Collection* collection = db->getCollection(txn, toHash[i]);
+                if (!collection)
+                    continue;
+                hashes.push_back(new CollectionHash(toHash[i].substr(dbname.size() + 1),
+                                                    collection));
+            }
+
+            hashCollectionsMurmur3(txn, hashes.vector());
+
+            std::string allHashes;
+            BSONObjBuilder bb( result.subobjStart( "collections" ) );
+            for (size_t i = 0; i < hashes.size(); i++) {
+                const std::string hash = hashes[i]->finish();
+                bb.append(hashes[i]->shortName, hash);
+                allHashes += hash;
+            }
+            bb.done();
+
+            uint64_t h[2];
+            MurmurHash3_x64_128(allHashes.data(), allHashes.size(), 0, h);
+            result.append( "hashFunction", kMurmur3 );
+            result.append( "hash", toHex(h, sizeof(h)) );
+            result.appendNumber( "timeMillis", timer.millis() );
+            return 1;
+        }
+
+        md5_state_t globalState;
+        md5_init(&globalState);
+
+        vector<string> cached;
+
+        BSONObjBuilder bb( result.subobjStart( "collections" ) );
+        for ( vector<string>::iterator i=toHash.begin(); i != toHash.end(); i++ ) {
+            const string& fullCollectionName = *i;
+            string shortCollectionName = fullCollectionName.substr( dbname.size() + 1 );
+
             bool fromCache = false;
             string hash = hashCollection( txn, db, fullCollectionName, &fromCache );
 
@@ -28,6 +28,7 @@
 *    it in the license file.
 */
 
+#include <boost/functional/hash.hpp>
 #include <string>
 #include <vector>
 
@@ -42,10 +43,72 @@
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/query_planner_common.h"
 #include "mongo/db/query/explain.h"
+#include "mongo/platform/unordered_set.h"
 #include "mongo/util/timer.h"
 
 namespace mongo {
 
+namespace {
+
+    /**
+     * Adds 'e' to 'seed' such that elements which are equal under woCompare(e, false) add the
+     * same thing.  Numbers are squashed to 64 bit integers the way BSONElementHasher does, but
+     * without the cost of an MD5 per value.
+     */
+    void hashElement(const BSONElement& e, bool includeFieldName, size_t* seed) {
+        boost::hash_combine(*seed, e.canonicalType());
+
+        if (includeFieldName) {
+            boost::hash_combine(*seed, StringData::Hasher()(e.fieldNameStringData()));
+        }
+
+        if (!e.mayEncapsulate()) {
+            if (e.isNumber()) {
+                boost::hash_combine(*seed, e.safeNumberLong());
+            }
+            else {
+                boost::hash_combine(*seed,
+                                    StringData::Hasher()(StringData(e.value(), e.valuesize())));
+            }
+            return;
+        }
+
+        BSONObj obj;
+        if (e.type() == CodeWScope) {
+            boost::hash_combine(*seed, StringData::Hasher()(StringData(e.codeWScopeCode(),
+                                                                       e.codeWScopeCodeLen())));
+            obj = e.codeWScopeObject();
+        }
+        else {
+            obj = e.embeddedObject();
+        }
+
+        // Embedded objects compare with their field names.
+        BSONObjIterator it(obj);
+        while (it.more()) {
+            hashElement(it.next(), true, seed);
+        }
+    }
+
+    struct ElementHasher {
+        size_t operator()(const BSONElement& e) const {
+            size_t seed = 0;
+            hashElement(e, false, &seed);
+            return seed;
+        }
+    };
+
+    struct ElementEq {
+        bool operator()(const BSONElement& l, const BSONElement& r) const {
+            return l.woCompare(r, false) == 0;
+        }
+    };
+
+    // The distinct values seen so far, which point into the reply being built.
+    typedef unordered_set<BSONElement, ElementHasher, ElementEq> ElementHashSet;
+
+}  // namespace
+
     class DistinctCommand : public Command {
     public:
         DistinctCommand() : Command("distinct") {}
@@ -95,7 +158,7 @@ namespace mongo {
             char * start = bb.buf();
 
             BSONArrayBuilder arr( bb );
-            BSONElementSet values;
+            ElementHashSet values;
 
             const string ns = parseNs(dbname, cmdObj);
             AutoGetCollectionForRead ctx(txn, ns);
@@ -124,6 +124,95 @@ namespace mongo {
             return b.obj();
         }
 
+        namespace {
+
+            /**
+             * Minimal tokenizer used to recognize reduce functions with a native equivalent.
+             */
+            class CodeMatcher {
+            public:
+                explicit CodeMatcher( const std::string& code ) : _code( code ), _pos( 0 ) {}
+
+                bool token( const char* expected ) {
+                    _skipSpace();
+                    const size_t len = strlen( expected );
+                    if ( _code.compare( _pos, len, expected ) != 0 )
+                        return false;
+                    if ( _isIdentChar( expected[len - 1] ) && _pos + len < _code.size() &&
+                         _isIdentChar( _code[_pos + len] ) )
+                        return false;
+                    _pos += len;
+                    return true;
+                }
+
+                bool identifier( std::string* out ) {
+                    _skipSpace();
+                    const size_t start = _pos;
+                    while ( _pos < _code.size() && _isIdentChar( _code[_pos] ) )
+                        _pos++;
+                    if ( _pos == start || isdigit( static_cast<unsigned char>( _code[start] ) ) )
+                        return false;
+                    *out = _code.substr( start, _pos - start );
+                    return true;
+                }
+
+                bool atEnd() {
+                    _skipSpace();
+                    return _pos == _code.size();
+                }
+
+            private:
+                static bool _isIdentChar( char c ) {
+                    return isalnum( static_cast<unsigned char>( c ) ) || c == '_' || c == '$';
+                }
+
+                void _skipSpace() {
+                    while ( _pos < _code.size() &&
+                            isspace( static_cast<unsigned char>( _code[_pos] ) ) )
+                        _pos++;
+                }
+
+                const std::string& _code;
+                size_t _pos;
+            };
+
+        } // namespace
+
+        bool JSReducer::isArraySumReducer( const BSONElement& code ) {
+            // CodeWScope could shadow Array, so only plain code is recognized.
+            if ( code.type() != Code && code.type() != String )
+                return false;
+
+            const std::string source = code._asCode();
+            CodeMatcher m( source );
+            std::string key;
+            std::string values;
+            std::string summed;
+            if ( !m.token( "function" ) || !m.token( "(" ) || !m.identifier( &key ) ||
+                 !m.token( "," ) || !m.identifier( &values ) || !m.token( ")" ) ||
+                 !m.token( "{" ) || !m.token( "return" ) || !m.token( "Array" ) ||
+                 !m.token( "." ) || !m.token( "sum" ) || !m.token( "(" ) ||
+                 !m.identifier( &summed ) || !m.token( ")" ) )
+                return false;
+            m.token( ";" );
+            return m.token( "}" ) && m.atEnd() && summed == values && key != values;
+        }
+
+        bool JSReducer::_sumValues( const BSONList& tuples , double* sum ) {
+            *sum = 0;
+            for ( size_t i = 0; i < tuples.size(); i++ ) {
+                BSONObjIterator it( tuples[i] );
+                it.next();
+                const BSONElement value = it.next();
+                // NumberLong becomes a NumberLong object in JS, for which + concatenates.
+                if ( value.type() != NumberDouble && value.type() != NumberInt )
+                    return false;
+                // Same left-to-right double arithmetic as Array.sum().
+                *sum = ( i == 0 ) ? value.number() : *sum + value.number();
+            }
+            return true;
+        }
+
         void JSReducer::init( State * state ) {
             _func.init( state );
         }
@@ -134,6 +223,16 @@ namespace mongo {
         BSONObj JSReducer::reduce( const BSONList& tuples ) {
             if (tuples.size() <= 1)
                 return tuples[0];
+
+            double sum;
+            if ( _nativeSum && _sumValues( tuples , &sum ) ) {
+                ++numReduces;
+                BSONObjBuilder b;
+                b.appendAs( tuples[0].firstElement() , "0" );
+                b.append( "1" , sum );
+                return b.obj();
+            }
+
             BSONObj key;
             int endSizeEstimate = 16;
             _reduce( tuples , key , endSizeEstimate );
@@ -163,13 +262,23 @@ namespace mongo {
                 res = b.obj();
             }
             else {
-                // need to reduce
-                int endSizeEstimate = 16;
-                _reduce( tuples , key , endSizeEstimate );
-                BSONObjBuilder b(endSizeEstimate);
-                b.appendAs( key.firstElement() , "_id" );
-                _func.scope()->append( b , "value" , "__returnValue" );
-                res = b.obj();
+                double sum;
+                if ( _nativeSum && _sumValues( tuples , &sum ) ) {
+                    ++numReduces;
+                    BSONObjBuilder b;
+                    b.appendAs( tuples[0].firstElement() , "_id" );
+                    b.append( "value" , sum );
+                    res = b.obj();
+                }
+                else {
+                    // need to reduce
+                    int endSizeEstimate = 16;
+                    _reduce( tuples , key , endSizeEstimate );
+                    BSONObjBuilder b(endSizeEstimate);
+                    b.appendAs( key.firstElement() , "_id" );
+                    _func.scope()->append( b , "value" , "__returnValue" );
+                    res = b.obj();
+                }
             }
 
             if ( finalizer ) {
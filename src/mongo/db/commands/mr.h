@@ -128,14 +128,27 @@ namespace mongo {
 
         class JSReducer : public Reducer {
         public:
-            JSReducer( const BSONElement& code ) : _func( "_reduce" , code ) {}
+            JSReducer( const BSONElement& code )
+                : _func( "_reduce" , code ), _nativeSum( isArraySumReducer( code ) ) {}
             virtual void init( State * state );
 
             virtual BSONObj reduce( const BSONList& tuples );
             virtual BSONObj finalReduce( const BSONList& tuples , Finalizer * finalizer );
 
+            /**
+             * Returns true if 'code' is the common "return Array.sum(values)" reducer, which can
+             * be evaluated natively without calling into the JS engine.
+             */
+            static bool isArraySumReducer( const BSONElement& code );
+
         private:
 
+            /**
+             * Sums the values of 'tuples' the way Array.sum() would in JS.  Returns false, leaving
+             * 'sum' unspecified, if any value is not a number that JS represents as a double.
+             */
+            static bool _sumValues( const BSONList& tuples , double* sum );
+
             /**
              * result in "__returnValue"
              * @param key OUT
@@ -144,6 +157,7 @@ namespace mongo {
             void _reduce( const BSONList& values , BSONObj& key , int& endSizeEstimate );
 
             JSFunction _func;
+            const bool _nativeSum;
         };
 
         class JSFinalizer : public Finalizer  {
@@ -158,4 +158,37 @@ namespace {
                                       "mydb2", "", "", false, mr::Config::INMEMORY);
     }
 
+    /**
+     * Tests for mr::JSReducer::isArraySumReducer.
+     */
+
+    bool _isArraySumReducer(const std::string& code) {
+        BSONObjBuilder b;
+        b.appendCode("reduce", code);
+        return mr::JSReducer::isArraySumReducer(b.obj().firstElement());
+    }
+
+    TEST(JSReducerTest, RecognizesArraySumReducer) {
+        ASSERT_TRUE(_isArraySumReducer("function(key, values) { return Array.sum(values); }"));
+        ASSERT_TRUE(_isArraySumReducer("function(k,v){return Array.sum(v)}"));
+        ASSERT_TRUE(_isArraySumReducer(
+            "  function ( k , $v )\n{\n  return Array . sum( $v ) ;\n}\n"));
+    }
+
+    TEST(JSReducerTest, RejectsOtherReducers) {
+        // Sums the key rather than the values.
+        ASSERT_FALSE(_isArraySumReducer("function(k, v) { return Array.sum(k); }"));
+        ASSERT_FALSE(_isArraySumReducer("function(v, v) { return Array.sum(v); }"));
+        // Not a return statement.
+        ASSERT_FALSE(_isArraySumReducer("function(k, v) { returnArray.sum(v); }"));
+        ASSERT_FALSE(_isArraySumReducer("function(k, v) { return Array.sum(v) + 1; }"));
+        ASSERT_FALSE(_isArraySumReducer("function(k, v) { return Array.avg(v); }"));
+        ASSERT_FALSE(_isArraySumReducer("function(k, v) { return Array.sum(v); } x"));
+
+        // Code with scope may redefine Array.
+        BSONObjBuilder b;
+        b.appendCodeWScope("reduce", "function(k, v) { return Array.sum(v); }", BSONObj());
+        ASSERT_FALSE(mr::JSReducer::isArraySumReducer(b.obj().firstElement()));
+    }
+
 }  // namespace
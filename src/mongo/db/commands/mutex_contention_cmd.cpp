@@ -0,0 +1,150 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <string>
+#include <vector>
+
+#include "mongo/bson/util/bson_extract.h"
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/concurrency/mutex_contention.h"
+
+namespace mongo {
+namespace {
+
+    /**
+     * Turns contention profiling of the named mutexes on and off, at startup or at runtime.
+     */
+    class MutexContentionProfilingParameter : public ServerParameter {
+    public:
+        MutexContentionProfilingParameter() :
+            ServerParameter(ServerParameterSet::getGlobal(), "mutexContentionProfiling",
+                            true, // allowedToChangeAtStartup
+                            true // allowedToChangeAtRuntime
+                            ) {}
+
+        virtual void append(OperationContext* txn, BSONObjBuilder& b, const std::string& name) {
+            b << name << MutexContentionStats::enabled();
+        }
+
+        virtual Status set(const BSONElement& newValueElement) {
+            if (!newValueElement.isBoolean() && !newValueElement.isNumber()) {
+                return Status(ErrorCodes::BadValue,
+                              "mutexContentionProfiling must be a boolean");
+            }
+            MutexContentionStats::setEnabled(newValueElement.trueValue());
+            return Status::OK();
+        }
+
+        virtual Status setFromString(const std::string& str) {
+            if (str == "true" || str == "1") {
+                MutexContentionStats::setEnabled(true);
+            }
+            else if (str == "false" || str == "0") {
+                MutexContentionStats::setEnabled(false);
+            }
+            else {
+                return Status(ErrorCodes::BadValue,
+                              "mutexContentionProfiling must be true or false, not " + str);
+            }
+            return Status::OK();
+        }
+    } mutexContentionProfilingParameter;
+
+    /**
+     * { mutexContention: 1, limit: <n>, callSites: <n>, reset: <bool> }
+     *
+     * Reports the named mutexes which waited longest while mutexContentionProfiling was on,
+     * with the call sites which waited longest for each.
+     */
+    class MutexContentionCmd : public Command {
+    public:
+        MutexContentionCmd() : Command("mutexContention") { }
+
+        virtual bool slaveOk() const { return true; }
+        virtual bool adminOnly() const { return true; }
+        virtual bool isWriteCommandForConfigServer() const { return false; }
+
+        virtual void help(std::stringstream& help) const {
+            help << "contention of the server's internal mutexes, which is only gathered while "
+                    "the mutexContentionProfiling parameter is true\n"
+                    "{ mutexContention: 1, limit: 20, callSites: 5, reset: false }\n"
+                    "limit or callSites 0 reports all";
+        }
+
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::serverStatus);
+            out->push_back(Privilege(ResourcePattern::forClusterResource(), actions));
+        }
+
+        virtual bool run(OperationContext* txn,
+                         const std::string& dbname,
+                         BSONObj& cmdObj,
+                         int options,
+                         std::string& errmsg,
+                         BSONObjBuilder& result,
+                         bool fromRepl) {
+            long long limit;
+            Status status = bsonExtractIntegerFieldWithDefault(cmdObj, "limit", 20, &limit);
+            if (!status.isOK()) {
+                return appendCommandStatus(result, status);
+            }
+
+            long long callSites;
+            status = bsonExtractIntegerFieldWithDefault(cmdObj, "callSites", 5, &callSites);
+            if (!status.isOK()) {
+                return appendCommandStatus(result, status);
+            }
+
+            if (limit < 0 || callSites < 0) {
+                errmsg = "limit and callSites must not be negative";
+                return false;
+            }
+
+            result.append("enabled", MutexContentionStats::enabled());
+            BSONArrayBuilder mutexes(result.subarrayStart("mutexes"));
+            MutexContentionStats::appendTop(limit, callSites, &mutexes);
+            mutexes.done();
+
+            if (cmdObj["reset"].trueValue()) {
+                MutexContentionStats::resetAll();
+            }
+            return true;
+        }
+    } mutexContentionCmd;
+
+}  // namespace
+}  // namespace mongo
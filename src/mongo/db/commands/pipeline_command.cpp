@@ -47,9 +47,12 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/pipeline_d.h"
 #include "mongo/db/pipeline/pipeline.h"
+#include "mongo/db/pipeline/pipeline_result_cache.h"
 #include "mongo/db/query/find_constants.h"
 #include "mongo/db/query/get_executor.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage_options.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
@@ -163,6 +166,60 @@ namespace mongo {
     }
 
 
+    /**
+     * Describes what an aggregation returns for the result cache: the optimized pipeline, and
+     * the cursor options since a cursor's first batch depends on them.
+     */
+    static BSONObj makeResultCacheKey(const intrusive_ptr<Pipeline>& pipeline,
+                                      const BSONObj& cmdObj) {
+        BSONObjBuilder key;
+        key.append("pipeline", pipeline->serialize().toBson());
+        if (cmdObj.hasField("cursor"))
+            key.append(cmdObj["cursor"]);
+        return key.obj();
+    }
+
+    /**
+     * Appends 'cached' results in the form the command asked for, as a cursor which is already
+     * exhausted or as an inline array.
+     */
+    static void appendCachedResults(const string& ns,
+                                    const BSONObj& cmdObj,
+                                    const BSONObj& cached,
+                                    BSONObjBuilder& result) {
+        if (isCursorCommand(cmdObj)) {
+            BSONObjBuilder cursorObj(result.subobjStart("cursor"));
+            cursorObj.append("id", 0LL);
+            cursorObj.append("ns", ns);
+            cursorObj.appendArray("firstBatch", cached);
+            cursorObj.done();
+        }
+        else {
+            result.appendArray("result", cached);
+        }
+    }
+
+    /**
+     * Caches the results just appended to 'result', unless they are only the first batch of a
+     * cursor with more to come.
+     */
+    static void cacheResults(const string& ns,
+                             const BSONObj& key,
+                             unsigned long long writeGeneration,
+                             BSONObjBuilder& result) {
+        const BSONObj reply = result.asTempObj();
+        BSONElement results = reply["result"];
+        if (results.eoo()) {
+            const BSONObj cursor = reply["cursor"].Obj();
+            if (cursor["id"].numberLong() != 0)
+                return;
+            results = cursor["firstBatch"];
+        }
+
+        PipelineResultCache::get().insert(ns, key, writeGeneration, curTimeMillis64(),
+                                          results.Obj());
+    }
+
     class PipelineCommand :
         public Command {
     public:
@@ -176,6 +233,7 @@ namespace mongo {
             help << "{ pipeline: [ { $operator: {...}}, ... ]"
                  << ", explain: <bool>"
                  << ", allowDiskUse: <bool>"
+                 << ", snapshotRead: <bool>"
                  << ", cursor: {batchSize: <number>}"
                  << " }"
                  << endl
@@ -220,6 +278,24 @@ namespace mongo {
             }
 #endif
 
+            // Dashboards rerun identical pipelines over unchanged data, which the result cache
+            // answers without executing them.
+            const bool useResultCache = PipelineResultCache::enabled()
+                                        && !pPipeline->isExplain()
+                                        && !pCtx->inShard
+                                        && pPipeline->canCacheResults();
+            BSONObj resultCacheKey;
+            unsigned long long writeGeneration = 0;
+            if (useResultCache)
+                resultCacheKey = makeResultCacheKey(pPipeline, cmdObj);
+
+            // Pinned before anything is read. The RecoveryUnit, and with it the snapshot, goes
+            // into the cursor between getMores.
+            if (pCtx->snapshotRead) {
+                uassert(28668, "snapshotRead is not supported by this storage engine",
+                        txn->recoveryUnit()->pinSnapshot(internalQuerySnapshotReadMaxSecs));
+            }
+
             PlanExecutor* exec = NULL;
             scoped_ptr<ClientCursorPin> pin; // either this OR the execHolder will be non-null
             auto_ptr<PlanExecutor> execHolder;
@@ -234,6 +310,20 @@ namespace mongo {
 
                 Collection* collection = ctx.getCollection();
 
+                if (useResultCache && collection) {
+                    // Taken before reading anything, so that writes committing meanwhile make
+                    // the entry we store outdated.
+                    writeGeneration = collection->getWriteGeneration();
+
+                    BSONObj cached;
+                    if (PipelineResultCache::get().lookup(nss.ns(), resultCacheKey,
+                                                          writeGeneration, curTimeMillis64(),
+                                                          &cached)) {
+                        appendCachedResults(nss.ns(), cmdObj, cached, result);
+                        return true;
+                    }
+                }
+
                 // This does mongod-specific stuff like creating the input PlanExecutor and adding
                 // it to the front of the pipeline if needed.
                 boost::shared_ptr<PlanExecutor> input = PipelineD::prepareCursorSource(txn,
@@ -301,6 +391,9 @@ namespace mongo {
                     pPipeline->run(result);
                 }
 
+                if (useResultCache && pin)
+                    cacheResults(nss.ns(), resultCacheKey, writeGeneration, result);
+
                 if (!keepCursor && pin) pin->deleteUnderlying();
             }
             catch (...) {
@@ -0,0 +1,131 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <string>
+#include <vector>
+
+#include "mongo/bson/util/bson_extract.h"
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/query/query_shape_stats.h"
+
+namespace mongo {
+namespace {
+
+    /**
+     * { queryShapeStats: 1, sortBy: <field>, limit: <n>, ns: <namespace>, clear: <bool> }
+     *
+     * Reports the query shapes which used the most of a resource on this mongod.
+     */
+    class QueryShapeStatsCmd : public Command {
+    public:
+        QueryShapeStatsCmd() : Command("queryShapeStats") { }
+
+        virtual bool slaveOk() const { return true; }
+        virtual bool adminOnly() const { return true; }
+        virtual bool isWriteCommandForConfigServer() const { return false; }
+
+        virtual void help(std::stringstream& help) const {
+            help << "the query shapes that used the most time or did the most work\n"
+                    "{ queryShapeStats: 1, sortBy: 'totalMicros', limit: 10, ns: <ns>, "
+                    "clear: false }\n"
+                    "sortBy: count, totalMicros, averageMicros, maxMicros, keysExamined, "
+                    "docsExamined or nreturned; limit 0 reports every shape";
+        }
+
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::top);
+            out->push_back(Privilege(ResourcePattern::forClusterResource(), actions));
+        }
+
+        virtual bool run(OperationContext* txn,
+                         const std::string& dbname,
+                         BSONObj& cmdObj,
+                         int options,
+                         std::string& errmsg,
+                         BSONObjBuilder& result,
+                         bool fromRepl) {
+            std::string sortBy;
+            Status status = bsonExtractStringFieldWithDefault(cmdObj, "sortBy", "totalMicros",
+                                                              &sortBy);
+            if (!status.isOK()) {
+                return appendCommandStatus(result, status);
+            }
+
+            long long limit;
+            status = bsonExtractIntegerFieldWithDefault(cmdObj, "limit", 10, &limit);
+            if (!status.isOK()) {
+                return appendCommandStatus(result, status);
+            }
+            if (limit < 0) {
+                errmsg = "limit must not be negative";
+                return false;
+            }
+
+            std::string ns;
+            status = bsonExtractStringFieldWithDefault(cmdObj, "ns", "", &ns);
+            if (!status.isOK()) {
+                return appendCommandStatus(result, status);
+            }
+
+            std::vector<BSONObj> shapes;
+            QueryShapeStats::global.getShapes(&shapes);
+            if (!ns.empty()) {
+                std::vector<BSONObj> matching;
+                for (size_t i = 0; i < shapes.size(); i++) {
+                    if (shapes[i]["ns"].str() == ns) {
+                        matching.push_back(shapes[i]);
+                    }
+                }
+                shapes.swap(matching);
+            }
+
+            BSONArrayBuilder shapesBuilder(result.subarrayStart("shapes"));
+            status = QueryShapeStats::appendTop(shapes, sortBy, limit, &shapesBuilder);
+            shapesBuilder.done();
+            if (!status.isOK()) {
+                return appendCommandStatus(result, status);
+            }
+            result.appendNumber("numShapes", static_cast<long long>(shapes.size()));
+
+            if (cmdObj["clear"].trueValue()) {
+                QueryShapeStats::global.clear();
+            }
+            return true;
+        }
+    } queryShapeStatsCmd;
+
+}  // namespace
+}  // namespace mongo
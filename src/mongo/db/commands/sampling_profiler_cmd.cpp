@@ -0,0 +1,125 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <string>
+#include <vector>
+
+#include "mongo/bson/util/bson_extract.h"
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/commands.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/sampling_profiler.h"
+
+namespace mongo {
+namespace {
+
+    /**
+     * { profileCpu: "start", hz: <samples per second> }
+     * { profileCpu: "stop" }
+     * { profileCpu: "status" }
+     *
+     * Runs the built-in sampling CPU profiler.  "stop" returns the profile as folded stacks,
+     * which flamegraph.pl turns into a flame graph:
+     *
+     *     var res = db.adminCommand({ profileCpu: "stop" });
+     *     writeFile("mongod.folded", res.folded.join("\n"));   // or print() and redirect
+     *
+     * and the operations, by opid, that ran on the CPU the most.
+     */
+    class ProfileCpuCmd : public Command {
+    public:
+        ProfileCpuCmd() : Command("profileCpu") { }
+
+        virtual bool slaveOk() const { return true; }
+        virtual bool adminOnly() const { return true; }
+        virtual bool isWriteCommandForConfigServer() const { return false; }
+
+        virtual void help(std::stringstream& help) const {
+            help << "sampling CPU profiler\n"
+                    "{ profileCpu: 'start', hz: 100 } starts sampling\n"
+                    "{ profileCpu: 'stop' } stops and returns the profile as folded stacks\n"
+                    "{ profileCpu: 'status' }";
+        }
+
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::cpuProfiler);
+            out->push_back(Privilege(ResourcePattern::forClusterResource(), actions));
+        }
+
+        virtual bool run(OperationContext* txn,
+                         const std::string& dbname,
+                         BSONObj& cmdObj,
+                         int options,
+                         std::string& errmsg,
+                         BSONObjBuilder& result,
+                         bool fromRepl) {
+            const std::string action = cmdObj.firstElement().str();
+
+            if (action == "start") {
+                long long hz;
+                Status status = bsonExtractIntegerFieldWithDefault(cmdObj, "hz", 100, &hz);
+                if (!status.isOK()) {
+                    return appendCommandStatus(result, status);
+                }
+                if (hz < 1 || hz > SamplingProfiler::kMaxHz) {
+                    errmsg = str::stream() << "hz must be between 1 and "
+                                           << SamplingProfiler::kMaxHz;
+                    return false;
+                }
+                return appendCommandStatus(result, SamplingProfiler::start(hz));
+            }
+
+            if (action == "stop") {
+                SamplingProfiler::Results results;
+                Status status = SamplingProfiler::stop(&results);
+                if (!status.isOK()) {
+                    return appendCommandStatus(result, status);
+                }
+                results.append(&result);
+                return true;
+            }
+
+            if (action == "status") {
+                result.append("running", SamplingProfiler::isRunning());
+                return true;
+            }
+
+            errmsg = "profileCpu must be \"start\", \"stop\" or \"status\"";
+            return false;
+        }
+    } profileCpuCmd;
+
+}  // namespace
+}  // namespace mongo
@@ -47,6 +47,7 @@
 #include "mongo/util/log.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/net/ssl_manager.h"
+#include "mongo/util/numa.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/ramlog.h"
 #include "mongo/util/version.h"
@@ -235,6 +236,20 @@ namespace mongo {
 
         } extraInfo;
 
+        class Numa : public ServerStatusSection {
+        public:
+            Numa() : ServerStatusSection( "numa" ){}
+            virtual bool includeByDefault() const { return NumaPlacement::nodeCount() > 1; }
+
+            BSONObj generateSection(OperationContext* txn,
+                                    const BSONElement& configElement) const {
+                BSONObjBuilder bb;
+                NumaPlacement::appendStats(&bb);
+                return bb.obj();
+            }
+
+        } numa;
+
 
         class Asserts : public ServerStatusSection {
         public:
@@ -279,12 +294,15 @@ namespace mongo {
 
             BSONObj generateSection(OperationContext* txn,
                                     const BSONElement& configElement) const {
-                BSONObj result;
+                BSONObjBuilder result;
                 if (getSSLManager()) {
-                    result = getSSLManager()->getSSLConfiguration().getServerStatusBSON();
+                    result.appendElements(
+                        getSSLManager()->getSSLConfiguration().getServerStatusBSON());
+                    result.append("SSLHandshakes",
+                                  getSSLManager()->getHandshakeStats().toBSON());
                 }
 
-                return result;
+                return result.obj();
             }
         } security;
 #endif
@@ -32,12 +32,18 @@
 
 #include "mongo/db/commands/write_commands/batch_executor.h"
 
+#include <algorithm>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <map>
 #include <memory>
 
+#include "mongo/base/counter.h"
 #include "mongo/base/error_codes.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/global_environment_experiment.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/introspect.h"
@@ -100,6 +106,19 @@ namespace mongo {
     // TODO: Determine queueing behavior we want here
     MONGO_EXPORT_SERVER_PARAMETER( queueForMigrationCommit, bool, true );
 
+    // Maximum number of documents of an insert batch written in one WriteUnitOfWork.  Values
+    // below 2 insert every document in its own unit of work.
+    MONGO_EXPORT_SERVER_PARAMETER( internalInsertMaxBatchSize, int, 64 );
+
+    // How long a single-document insert waits for single-document inserts from other clients into
+    // the same collection, so that they are all written in one WriteUnitOfWork under one lock
+    // acquisition.  0 turns combining off.
+    MONGO_EXPORT_SERVER_PARAMETER( internalInsertCombineWindowMicros, int, 0 );
+
+    static Counter64 combinedInsertsCounter;
+    static ServerStatusMetricField<Counter64> displayCombinedInserts( "insert.combined",
+                                                                      &combinedInsertsCounter );
+
     using mongoutils::str::stream;
 
     WriteBatchExecutor::WriteBatchExecutor( OperationContext* txn,
@@ -734,6 +753,10 @@ namespace mongo {
         // index both.
         std::vector<StatusWith<BSONObj> > normalizedInserts;
 
+        // Inserts before this index are executed one at a time, because inserting them as a
+        // group already failed once.
+        size_t ungroupedEnd;
+
     private:
         bool _lockAndCheckImpl(WriteOpResult* result, bool intentLock=true);
 
@@ -844,9 +867,26 @@ namespace mongo {
         // particularly on operation interruption.  These kinds of errors necessarily prevent
         // further insertOne calls, and stop the batch.  As a result, the only expected source of
         // such exceptions are interruptions.
+        //
+        // Before falling back to insertOne(), each iteration first tries execInsertGroup(), which
+        // writes a run of valid documents in one WriteUnitOfWork and advances state.currIndex
+        // past them.  If the group fails, it is rolled back and its documents are inserted one at
+        // a time, so that every document gets its own error.
+        //
+        // A batch of a single insert may instead be handed to execCombinedInsert(), which writes
+        // it together with the single inserts of other clients.
         ExecInsertsState state(_txn, &request);
         normalizeInserts(request, &state.normalizedInserts);
 
+        WriteErrorDetail* combinedError = NULL;
+        if (execCombinedInsert(&state, &combinedError)) {
+            if (combinedError) {
+                errors->push_back(combinedError);
+                combinedError->setIndex(0);
+            }
+            return;
+        }
+
         // Yield frequency is based on the same constants used by PlanYieldPolicy.
         ElapsedTracker elapsedTracker(internalQueryExecYieldIterations,
                                       internalQueryExecYieldPeriodMS);
@@ -871,6 +911,12 @@ namespace mongo {
                 elapsedTracker.resetLastTime();
             }
 
+            const size_t numGrouped = execInsertGroup(&state);
+            if (numGrouped > 0) {
+                state.currIndex += numGrouped - 1;
+                continue;
+            }
+
             WriteErrorDetail* error = NULL;
             execOneInsert(&state, &error);
             if (error) {
@@ -945,6 +991,7 @@ namespace mongo {
         txn(txn),
         request(aRequest),
         currIndex(0),
+        ungroupedEnd(0),
         _transaction(txn, MODE_IX),
         _collection(NULL) {
     }
@@ -1091,6 +1138,289 @@ namespace mongo {
         }
     }
 
+    size_t WriteBatchExecutor::execInsertGroup(ExecInsertsState* state) {
+        if (state->request->isInsertIndexRequest() || state->currIndex < state->ungroupedEnd)
+            return 0;
+
+        const size_t maxGroupSize = std::max(internalInsertMaxBatchSize, 1);
+        const size_t begin = state->currIndex;
+
+        std::vector<BSONObj> docs;
+        for (size_t i = begin;
+             i < state->normalizedInserts.size() && docs.size() < maxGroupSize;
+             ++i) {
+            const StatusWith<BSONObj>& normalizedInsert(state->normalizedInserts[i]);
+            if (!normalizedInsert.isOK())
+                break;
+            docs.push_back(normalizedInsert.getValue().isEmpty() ?
+                           state->request->getInsertRequest()->getDocumentsAt(i) :
+                           normalizedInsert.getValue());
+        }
+
+        if (docs.size() < 2)
+            return 0;
+
+        BatchItemRef firstItem(state->request, begin);
+        scoped_ptr<CurOp> currentOp(beginCurrentOp(_txn->getClient(), firstItem));
+
+        try {
+            // Errors are reported by the one-at-a-time path, which takes the locks again
+            WriteOpResult lockResult;
+            if (!state->lockAndCheck(&lockResult))
+                return 0;
+
+            Collection* collection = state->getCollection();
+            if (collection->isCapped()) {
+                state->ungroupedEnd = state->normalizedInserts.size();
+                return 0;
+            }
+
+            const string& insertNS = collection->ns().ns();
+            _txn->lockState()->assertWriteLocked(insertNS);
+
+            WriteUnitOfWork wunit(_txn);
+            if (!collection->insertDocuments(_txn, docs, true).isOK()) {
+                state->ungroupedEnd = begin + docs.size();
+                return 0;
+            }
+
+            repl::logOps(_txn, "i", insertNS.c_str(), docs);
+            wunit.commit();
+        }
+        catch (const DBException& ex) {
+            if (ErrorCodes::isInterruption(ex.toStatus().code()))
+                throw;
+            state->ungroupedEnd = begin + docs.size();
+            return 0;
+        }
+
+        WriteOpStats stats;
+        stats.n = 1;
+        for (size_t i = 0; i < docs.size(); ++i) {
+            BatchItemRef currInsertItem(state->request, begin + i);
+            incOpStats(currInsertItem);
+            incWriteStats(currInsertItem, stats, NULL, currentOp.get());
+        }
+        finishCurrentOp(_txn, currentOp.get(), NULL);
+
+        return docs.size();
+    }
+
+    namespace {
+
+        /**
+         * Gathers the single-document inserts which clients issue against the same collection at
+         * about the same time.  The first client to arrive leads a group: it waits for up to
+         * internalInsertCombineWindowMicros for others to join, then writes every document of the
+         * group under its own locks.  The clients which joined wait for the leader and report the
+         * result it left for their document as their own.
+         */
+        class InsertCombiner {
+            MONGO_DISALLOW_COPYING(InsertCombiner);
+        public:
+            struct Group {
+                Group() : done(false) {}
+
+                std::vector<BSONObj> docs;
+                // Parallel to "docs".  The first result belongs to the leader.
+                std::vector<WriteOpResult*> results;
+
+                // Set by the leader once every result is filled in.
+                bool done;
+                OpTime lastOp;
+            };
+
+            InsertCombiner() {}
+
+            /**
+             * Adds "doc" to the open group on "ns" and waits for its leader to write it.  Returns
+             * NULL once "result" is filled in.  If there is no open group on "ns", opens one, waits
+             * out the combining window and returns the group, which the caller must execute and
+             * pass to finish().
+             */
+            boost::shared_ptr<Group> join(const std::string& ns,
+                                          const BSONObj& doc,
+                                          WriteOpResult* result,
+                                          OpTime* lastOp) {
+                const size_t maxGroupSize = std::max(internalInsertMaxBatchSize, 1);
+
+                boost::unique_lock<boost::mutex> lk(_mutex);
+                GroupMap::iterator it = _openGroups.find(ns);
+                if (it != _openGroups.end()) {
+                    boost::shared_ptr<Group> group = it->second;
+                    group->docs.push_back(doc);
+                    group->results.push_back(result);
+                    if (group->docs.size() >= maxGroupSize) {
+                        _openGroups.erase(it);
+                        _groupFull.notify_all();
+                    }
+
+                    while (!group->done) {
+                        _groupDone.wait(lk);
+                    }
+                    *lastOp = group->lastOp;
+                    return boost::shared_ptr<Group>();
+                }
+
+                boost::shared_ptr<Group> group(new Group);
+                group->docs.push_back(doc);
+                group->results.push_back(result);
+                _openGroups[ns] = group;
+
+                const boost::system_time deadline = boost::get_system_time()
+                    + boost::posix_time::microseconds(internalInsertCombineWindowMicros);
+                while (group->docs.size() < maxGroupSize && _groupFull.timed_wait(lk, deadline)) {
+                }
+
+                it = _openGroups.find(ns);
+                if (it != _openGroups.end() && it->second == group)
+                    _openGroups.erase(it);
+                return group;
+            }
+
+            /**
+             * Wakes the clients waiting on "group", whose results the leader has filled in.
+             */
+            void finish(Group* group, const OpTime& lastOp) {
+                boost::lock_guard<boost::mutex> lk(_mutex);
+                group->lastOp = lastOp;
+                group->done = true;
+                _groupDone.notify_all();
+            }
+
+        private:
+            typedef std::map<std::string, boost::shared_ptr<Group> > GroupMap;
+
+            boost::mutex _mutex;
+            boost::condition_variable _groupFull;
+            boost::condition_variable _groupDone;
+
+            // Groups still accepting documents, by namespace.
+            GroupMap _openGroups;
+        };
+
+        InsertCombiner insertCombiner;
+
+        /**
+         * Writes every document of "group" under the locks of "state", filling in the result of
+         * each.  The documents go in as one WriteUnitOfWork if they can, and else one at a time.
+         */
+        void insertCombinedGroup(WriteBatchExecutor::ExecInsertsState* state,
+                                 InsertCombiner::Group* group) {
+            OperationContext* txn = state->txn;
+
+            WriteOpResult lockResult;
+            if (!state->lockAndCheck(&lockResult)) {
+                for (size_t i = 0; i < group->results.size(); ++i) {
+                    WriteErrorDetail* error = new WriteErrorDetail;
+                    lockResult.getError()->cloneTo(error);
+                    group->results[i]->setError(error);
+                }
+                return;
+            }
+
+            Collection* collection = state->getCollection();
+            const string& insertNS = collection->ns().ns();
+
+            if (group->docs.size() > 1 && !collection->isCapped()) {
+                try {
+                    WriteUnitOfWork wunit(txn);
+                    if (collection->insertDocuments(txn, group->docs, true).isOK()) {
+                        repl::logOps(txn, "i", insertNS.c_str(), group->docs);
+                        wunit.commit();
+
+                        for (size_t i = 0; i < group->results.size(); ++i) {
+                            group->results[i]->getStats().n = 1;
+                        }
+                        combinedInsertsCounter.increment(group->docs.size() - 1);
+                        return;
+                    }
+                }
+                catch (const DBException& ex) {
+                    if (ErrorCodes::isInterruption(ex.toStatus().code()))
+                        throw;
+                }
+            }
+
+            bool failed = false;
+            for (size_t i = 0; i < group->docs.size(); ++i) {
+                try {
+                    singleInsert(txn, group->docs[i], collection, group->results[i]);
+                }
+                catch (const DBException& ex) {
+                    Status status(ex.toStatus());
+                    if (ErrorCodes::isInterruption(status.code()))
+                        throw;
+                    group->results[i]->setError(toWriteError(status));
+                }
+                failed = failed || group->results[i]->getError();
+            }
+
+            // Errors release the write lock, as a matter of policy.
+            if (failed) {
+                txn->recoveryUnit()->commitAndRestart();
+                state->unlock();
+            }
+        }
+
+    }  // namespace
+
+    bool WriteBatchExecutor::execCombinedInsert(ExecInsertsState* state, WriteErrorDetail** error) {
+        // Only plain unsharded inserts are combined, as the leader checks the shard version and
+        // the write concern of its own request only.
+        if (internalInsertCombineWindowMicros <= 0 ||
+            state->request->sizeWriteOps() != 1 ||
+            state->request->isInsertIndexRequest() ||
+            state->normalizedInserts.empty() ||
+            !state->normalizedInserts[0].isOK() ||
+            shardingState.enabled()) {
+            return false;
+        }
+
+        const StatusWith<BSONObj>& normalizedInsert(state->normalizedInserts[0]);
+        const BSONObj& insertDoc = normalizedInsert.getValue().isEmpty() ?
+            state->request->getInsertRequest()->getDocumentsAt(0) :
+            normalizedInsert.getValue();
+
+        BatchItemRef insertItem(state->request, 0);
+        scoped_ptr<CurOp> currentOp(beginCurrentOp(_txn->getClient(), insertItem));
+        incOpStats(insertItem);
+
+        WriteOpResult result;
+        OpTime lastOp;
+        boost::shared_ptr<InsertCombiner::Group> group =
+            insertCombiner.join(state->request->getTargetingNS(), insertDoc, &result, &lastOp);
+
+        if (group) {
+            try {
+                insertCombinedGroup(state, group.get());
+            }
+            catch (const DBException& ex) {
+                // The leader was interrupted.  The documents it did not get to are not written.
+                for (size_t i = 1; i < group->results.size(); ++i) {
+                    WriteOpResult* other = group->results[i];
+                    if (!other->getError() && other->getStats().n == 0)
+                        other->setError(toWriteError(ex.toStatus()));
+                }
+                insertCombiner.finish(group.get(), _txn->getClient()->getLastOp());
+                throw;
+            }
+            insertCombiner.finish(group.get(), _txn->getClient()->getLastOp());
+        }
+        else if (result.getStats().n > 0 && lastOp > _txn->getClient()->getLastOp()) {
+            // Write concern waits for the oplog entry the leader wrote for this document.
+            _txn->getClient()->setLastOp(lastOp);
+        }
+
+        incWriteStats(insertItem, result.getStats(), result.getError(), currentOp.get());
+        finishCurrentOp(_txn, currentOp.get(), result.getError());
+
+        if (result.getError()) {
+            *error = result.releaseError();
+        }
+        return true;
+    }
+
     /**
      * Perform a single insert into a collection.  Requires the insert be preprocessed and the
      * collection already has been created.
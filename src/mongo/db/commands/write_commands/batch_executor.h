@@ -103,6 +103,23 @@ namespace mongo {
          */
         void execOneInsert( ExecInsertsState* state, WriteErrorDetail** error );
 
+        /**
+         * Executes the run of valid inserts starting at the current insert of "state" in a single
+         * WriteUnitOfWork, up to internalInsertMaxBatchSize of them.  Returns the number of
+         * inserts executed, or 0 if the run was not inserted as a group.  In that case nothing
+         * was written and the inserts must be executed one at a time so that each gets its own
+         * result.
+         */
+        size_t execInsertGroup( ExecInsertsState* state );
+
+        /**
+         * Executes a batch holding a single insert together with the single inserts other clients
+         * issue against the same collection at about the same time, when
+         * internalInsertCombineWindowMicros is set.  Returns false, having done nothing, if the
+         * batch cannot be combined.
+         */
+        bool execCombinedInsert( ExecInsertsState* state, WriteErrorDetail** error );
+
         /**
          * Executes an update item (which may update many documents or upsert), and returns the
          * upserted _id on upsert or error on failure.
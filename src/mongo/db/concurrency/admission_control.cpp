@@ -0,0 +1,288 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kDefault
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/concurrency/admission_control.h"
+
+#include <cmath>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/background.h"
+#include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+namespace {
+
+    // Weight of a new latency sample when it is above the baseline. Lets the baseline recover
+    // after the workload changes, over a few minutes.
+    const double kBaselineDecay = 0.01;
+
+    // Fraction of the computed change applied each interval.
+    const double kSmoothing = 0.2;
+
+    const int kSizingIntervalMillis = 1000;
+
+    /**
+     * A ticket pool together with the hold time statistics feeding its adaptive sizing.
+     */
+    struct TicketPool {
+        TicketPool(const char* poolName) : name(poolName), holder(0) {}
+
+        const char* const name;
+        TicketHolder holder;
+        AtomicInt64 completed;
+        AtomicInt64 totalHoldMicros;
+    };
+
+    TicketPool readPool("read");
+    TicketPool writePool("write");
+
+    int admissionControlReadTickets = 0;
+    int admissionControlWriteTickets = 0;
+
+    /**
+     * Resizes the underlying pool whenever the parameter is set, so the ticket counts can be
+     * changed at runtime. A value of 0 disables throttling for that pool.
+     */
+    class ExportedTicketsParameter : public ExportedServerParameter<int> {
+    public:
+        ExportedTicketsParameter(const std::string& name, int* value, TicketPool* pool) :
+            ExportedServerParameter<int>(ServerParameterSet::getGlobal(), name, value, true, true),
+            _pool(pool) {}
+
+        virtual Status validate(const int& potentialNewValue) {
+            if (potentialNewValue < 0) {
+                return Status(ErrorCodes::BadValue,
+                              str::stream() << name() << " must be greater than or equal to 0");
+            }
+            return Status::OK();
+        }
+
+        // Without this the compiler complains that defining set(const int&)
+        // hides set(const BSONElement&)
+        using ExportedServerParameter<int>::set;
+
+        virtual Status set(const int& newValue) {
+            Status status = ExportedServerParameter<int>::set(newValue);
+            if (status.isOK() && newValue > 0) {
+                _pool->holder.resize(newValue);
+            }
+            return status;
+        }
+
+    private:
+        TicketPool* const _pool;
+    };
+
+    ExportedTicketsParameter readTicketsParam("admissionControlReadTickets",
+                                              &admissionControlReadTickets,
+                                              &readPool);
+    ExportedTicketsParameter writeTicketsParam("admissionControlWriteTickets",
+                                               &admissionControlWriteTickets,
+                                               &writePool);
+
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(admissionControlAdaptive, bool, false);
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(admissionControlMinTickets, int, 8);
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(admissionControlMaxTickets, int, 1024);
+
+    /**
+     * Periodically feeds each enabled pool's hold time statistics through its sizer.
+     */
+    class AdaptiveTicketSizingJob : public BackgroundJob {
+    public:
+        AdaptiveTicketSizingJob() : BackgroundJob(false /* selfDelete */) {}
+
+        virtual std::string name() const { return "AdaptiveTicketSizer"; }
+
+        virtual void run() {
+            PoolState read(&readPool, &admissionControlReadTickets);
+            PoolState write(&writePool, &admissionControlWriteTickets);
+
+            while (!inShutdown()) {
+                sleepmillis(kSizingIntervalMillis);
+                read.adjust();
+                write.adjust();
+            }
+        }
+
+    private:
+        struct PoolState {
+            PoolState(TicketPool* inPool, const int* inConfigured)
+                : pool(inPool),
+                  configured(inConfigured),
+                  sizer(admissionControlMinTickets, admissionControlMaxTickets),
+                  lastCompleted(inPool->completed.load()),
+                  lastHoldMicros(inPool->totalHoldMicros.load()) {}
+
+            void adjust() {
+                const long long completed = pool->completed.load();
+                const long long holdMicros = pool->totalHoldMicros.load();
+                const long long deltaCompleted = completed - lastCompleted;
+                const long long deltaMicros = holdMicros - lastHoldMicros;
+                lastCompleted = completed;
+                lastHoldMicros = holdMicros;
+
+                if (*configured <= 0 || deltaCompleted <= 0) {
+                    return;
+                }
+
+                const int current = pool->holder.outof();
+                const int next = sizer.nextSize(current,
+                                                deltaCompleted,
+                                                static_cast<double>(deltaMicros) / deltaCompleted,
+                                                pool->holder.queueDepth());
+                if (next != current) {
+                    LOG(1) << "resizing " << pool->name << " admission tickets from " << current
+                           << " to " << next;
+                    pool->holder.resize(next);
+                }
+            }
+
+            TicketPool* const pool;
+            const int* const configured;
+            AdaptiveTicketSizer sizer;
+            long long lastCompleted;
+            long long lastHoldMicros;
+        };
+    };
+
+    AdaptiveTicketSizingJob adaptiveTicketSizingJob;
+
+    void appendPoolStats(const TicketPool& pool, bool enabled, BSONObjBuilder* builder) {
+        BSONObjBuilder b(builder->subobjStart(pool.name));
+        b.append("enabled", enabled);
+        b.append("out", pool.holder.used());
+        b.append("available", pool.holder.available());
+        b.append("totalTickets", pool.holder.outof());
+        b.append("queueDepth", pool.holder.queueDepth());
+
+        const TicketHolder::Stats stats = pool.holder.getStats();
+        b.appendNumber("acquired", stats.acquired);
+        b.appendNumber("waited", stats.waited);
+        b.appendNumber("totalWaitMicros", stats.totalWaitMicros);
+        b.appendNumber("completed", pool.completed.load());
+        b.appendNumber("totalHoldMicros", pool.totalHoldMicros.load());
+
+        {
+            BSONObjBuilder hist(b.subobjStart("waitMicrosHistogram"));
+            for (int i = 0; i < TicketHolder::kNumWaitHistogramBuckets; i++) {
+                const std::string bound = (i < TicketHolder::kNumWaitHistogramBuckets - 1) ?
+                    BSONObjBuilder::numStr(
+                        static_cast<int>(TicketHolder::kWaitHistogramBucketMicros[i])) :
+                    std::string("inf");
+                hist.appendNumber(bound, stats.waitHistogram[i]);
+            }
+            hist.done();
+        }
+
+        b.done();
+    }
+
+} // namespace
+
+    // static
+    TicketHolder* AdmissionControl::getTicketHolder(LockMode mode) {
+        switch (mode) {
+        case MODE_IS:
+            return admissionControlReadTickets > 0 ? &readPool.holder : NULL;
+        case MODE_IX:
+            return admissionControlWriteTickets > 0 ? &writePool.holder : NULL;
+        default:
+            return NULL;
+        }
+    }
+
+    // static
+    void AdmissionControl::recordTicketHold(TicketHolder* holder, long long micros) {
+        TicketPool* pool = (holder == &readPool.holder) ? &readPool : &writePool;
+        pool->completed.fetchAndAdd(1);
+        pool->totalHoldMicros.fetchAndAdd(micros);
+    }
+
+    // static
+    void AdmissionControl::startAdaptiveSizing() {
+        if (!admissionControlAdaptive) {
+            return;
+        }
+
+        if (admissionControlReadTickets <= 0 && admissionControlWriteTickets <= 0) {
+            warning() << "admissionControlAdaptive has no effect unless "
+                      << "admissionControlReadTickets or admissionControlWriteTickets is set";
+            return;
+        }
+
+        adaptiveTicketSizingJob.go();
+    }
+
+    // static
+    void AdmissionControl::appendStats(BSONObjBuilder* builder) {
+        builder->append("adaptive", admissionControlAdaptive);
+        appendPoolStats(readPool, admissionControlReadTickets > 0, builder);
+        appendPoolStats(writePool, admissionControlWriteTickets > 0, builder);
+    }
+
+
+    AdaptiveTicketSizer::AdaptiveTicketSizer(int minTickets, int maxTickets)
+        : _minTickets(std::max(1, minTickets)),
+          _maxTickets(std::max(_minTickets, maxTickets)),
+          _baselineMicros(0) {
+    }
+
+    int AdaptiveTicketSizer::nextSize(int currentSize,
+                                      long long completed,
+                                      double meanLatencyMicros,
+                                      int queueDepth) {
+        if (completed <= 0 || meanLatencyMicros <= 0) {
+            return currentSize;
+        }
+
+        if (_baselineMicros == 0 || meanLatencyMicros < _baselineMicros) {
+            _baselineMicros = meanLatencyMicros;
+        }
+        else {
+            _baselineMicros += (meanLatencyMicros - _baselineMicros) * kBaselineDecay;
+        }
+
+        const double gradient = std::max(0.5, std::min(1.0, _baselineMicros / meanLatencyMicros));
+        const double headroom = queueDepth > 0 ? std::sqrt(static_cast<double>(currentSize)) : 0;
+        const double target = currentSize * gradient + headroom;
+        const double next = currentSize * (1 - kSmoothing) + target * kSmoothing;
+
+        const int rounded = static_cast<int>(next + 0.5);
+        return std::max(_minTickets, std::min(_maxTickets, rounded));
+    }
+
+} // namespace mongo
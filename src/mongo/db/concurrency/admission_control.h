@@ -0,0 +1,100 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/db/concurrency/lock_mgr_defs.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+    class TicketHolder;
+
+    /**
+     * Optional admission control for operations entering the storage engine.
+     *
+     * When enabled (admissionControlReadTickets / admissionControlWriteTickets greater than
+     * zero), an operation must take a read ticket before it first acquires the global lock in
+     * MODE_IS and a write ticket before it first acquires it in MODE_IX. The ticket is returned
+     * when the global lock is released, including when the operation yields. Global S and X
+     * acquisitions are never throttled.
+     *
+     * With admissionControlAdaptive set, a background thread resizes both ticket pools once a
+     * second from the observed latency of ticketed operations (see AdaptiveTicketSizer).
+     */
+    class AdmissionControl {
+    public:
+        /**
+         * Returns the pool to take a ticket from for a global lock request in "mode", or NULL if
+         * such requests are not throttled.
+         */
+        static TicketHolder* getTicketHolder(LockMode mode);
+
+        /**
+         * Reports that a ticket taken from "holder" has been returned after "micros".
+         */
+        static void recordTicketHold(TicketHolder* holder, long long micros);
+
+        /**
+         * Starts the thread which adjusts the pool sizes, if adaptive sizing is enabled.
+         */
+        static void startAdaptiveSizing();
+
+        static void appendStats(BSONObjBuilder* builder);
+    };
+
+    /**
+     * Feedback rule used for adaptive ticket pool sizing.
+     *
+     * Keeps a slowly decaying estimate of the best latency seen (the "baseline"). Each interval
+     * the pool is scaled by baseline/latency, so it shrinks when operations slow down because of
+     * contention inside the engine, and it grows by roughly sqrt(size) while requests are queued
+     * and latency stays at the baseline. Changes are smoothed and clamped to [min, max].
+     */
+    class AdaptiveTicketSizer {
+    public:
+        AdaptiveTicketSizer(int minTickets, int maxTickets);
+
+        /**
+         * Returns the pool size to use next, given the size in effect during the last interval,
+         * the number of tickets returned and their mean hold time, and the current queue depth.
+         */
+        int nextSize(int currentSize,
+                     long long completed,
+                     double meanLatencyMicros,
+                     int queueDepth);
+
+        double baselineLatencyMicros() const { return _baselineMicros; }
+
+    private:
+        const int _minTickets;
+        const int _maxTickets;
+        double _baselineMicros; // 0 until the first sample
+    };
+
+} // namespace mongo
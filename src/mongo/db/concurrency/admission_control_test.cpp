@@ -0,0 +1,80 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/concurrency/admission_control.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+    TEST(AdaptiveTicketSizer, NoCompletionsKeepsSize) {
+        AdaptiveTicketSizer sizer(8, 128);
+        ASSERT_EQUALS(32, sizer.nextSize(32, 0, 0, 10));
+    }
+
+    TEST(AdaptiveTicketSizer, SteadyLatencyWithoutQueueKeepsSize) {
+        AdaptiveTicketSizer sizer(8, 128);
+        for (int i = 0; i < 10; i++) {
+            ASSERT_EQUALS(32, sizer.nextSize(32, 1000, 500, 0));
+        }
+    }
+
+    TEST(AdaptiveTicketSizer, GrowsWhileQueuedAtBaselineLatency) {
+        AdaptiveTicketSizer sizer(8, 128);
+        int size = 16;
+        for (int i = 0; i < 20; i++) {
+            const int next = sizer.nextSize(size, 1000, 500, 50);
+            ASSERT_GREATER_THAN(next, size);
+            size = next;
+        }
+    }
+
+    TEST(AdaptiveTicketSizer, ShrinksWhenLatencyRises) {
+        AdaptiveTicketSizer sizer(8, 128);
+        ASSERT_EQUALS(64, sizer.nextSize(64, 1000, 100, 0));
+        ASSERT_LESS_THAN(sizer.nextSize(64, 1000, 400, 10), 64);
+    }
+
+    TEST(AdaptiveTicketSizer, ClampsToBounds) {
+        AdaptiveTicketSizer sizer(8, 20);
+        int size = 20;
+        for (int i = 0; i < 10; i++) {
+            size = sizer.nextSize(size, 1000, 100, 1000);
+        }
+        ASSERT_EQUALS(20, size);
+
+        for (int i = 0; i < 50; i++) {
+            size = sizer.nextSize(size, 1000, 100000, 0);
+        }
+        ASSERT_EQUALS(8, size);
+    }
+
+} // namespace
+} // namespace mongo
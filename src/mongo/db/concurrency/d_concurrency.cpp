@@ -79,7 +79,7 @@ namespace mongo {
     Lock::ScopedLock::ScopedLock(Locker* lockState)
         : _lockState(lockState) {
 
-        if (!_lockState->isBatchWriter()) {
+        if (!_lockState->isBatchWriter() && !_lockState->readsAtBatchBoundaries()) {
             AcquiringParallelWriter a(_lockState);
             _pbws_lk.reset(new RWLockRecursive::Shared(ParallelBatchWriterMode::_batchLock));
         }
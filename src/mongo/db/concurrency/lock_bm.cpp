@@ -0,0 +1,91 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <vector>
+
+#include "mongo/db/concurrency/lock_mgr_test_help.h"
+#include "mongo/unittest/benchmark.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace {
+
+    std::vector<ResourceId> makeCollectionResources(long long count) {
+        std::vector<ResourceId> resources;
+        for (long long i = 0; i < count; i++) {
+            resources.push_back(ResourceId(RESOURCE_COLLECTION,
+                                           std::string(str::stream() << "TestDB.coll" << i)));
+        }
+        return resources;
+    }
+
+    MONGO_BENCHMARK(LockManagerLockUnlock) {
+        LockManager lockMgr;
+        const ResourceId resId(RESOURCE_COLLECTION, std::string("TestDB.collection"));
+
+        DefaultLockerImpl locker(1);
+        TrackingLockGrantNotification notify;
+        LockRequest request;
+        request.initNew(&locker, &notify);
+
+        while (state.keepRunning()) {
+            lockMgr.lock(resId, &request, MODE_S);
+            lockMgr.unlock(&request);
+        }
+    }
+
+    // A locker taking the global lock and then 'arg' collection locks, as an operation touching
+    // that many collections would.
+    MONGO_BENCHMARK_WITH_ARGS(LockerLockCollections, "1,4,16") {
+        const std::vector<ResourceId> resources = makeCollectionResources(state.arg());
+        DefaultLockerImpl locker(1);
+
+        while (state.keepRunning()) {
+            locker.lockGlobal(MODE_IX);
+            for (size_t i = 0; i < resources.size(); i++) {
+                locker.lock(resources[i], MODE_IX);
+            }
+            locker.unlockAll();
+        }
+    }
+
+    MONGO_BENCHMARK(MMAPV1LockerLockCollection) {
+        const ResourceId resId(RESOURCE_COLLECTION, std::string("TestDB.collection"));
+        MMAPV1LockerImpl locker(1);
+
+        while (state.keepRunning()) {
+            locker.lockGlobal(MODE_IX);
+            locker.lock(resId, MODE_IX);
+            locker.unlockAll();
+        }
+    }
+
+}  // namespace
+}  // namespace mongo
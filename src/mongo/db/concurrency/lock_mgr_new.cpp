@@ -657,6 +657,20 @@ namespace {
         _onLockModeChanged(lock, true);
     }
 
+    bool LockManager::hasConflictingWaiters(ResourceId resId, LockMode mode) const {
+        LockBucket* bucket = _getBucket(resId);
+        SimpleMutex::scoped_lock scopedLock(bucket->mutex);
+
+        LockBucket::Map::const_iterator it = bucket->data.find(resId);
+        if (it == bucket->data.end()) {
+            return false;
+        }
+
+        // A blocked conversion is waiting for every other holder, whatever their mode.
+        const LockHead* lock = it->second;
+        return conflicts(mode, lock->conflictModes) || lock->conversionsCount > 0;
+    }
+
     void LockManager::cleanupUnusedLocks() {
         for (unsigned i = 0; i < _numLockBuckets; i++) {
             LockBucket* bucket = &_lockBuckets[i];
@@ -109,6 +109,13 @@ namespace mongo {
          */
         void downgrade(LockRequest* request, LockMode newMode);
 
+        /**
+         * Returns true if some request for 'resId' is queued in a mode which conflicts with
+         * 'mode', or is waiting to convert.  Lets a holder in 'mode' find out whether giving the
+         * lock up for a while would let anyone in.
+         */
+        bool hasConflictingWaiters(ResourceId resId, LockMode mode) const;
+
         /**
          * Iterates through all buckets and deletes all locks, which have no requests on them. This
          * call is kind of expensive and should only be used for reducing the memory footprint of
@@ -128,26 +135,38 @@ namespace mongo {
         // The lockheads need access to the partitions
         friend struct LockHead;
 
+        // Every lock and unlock of a hot resource (global, flush, database) touches the mutex of
+        // its bucket or partition. These are allocated as arrays, so without padding neighbouring
+        // entries would share cache lines and threads working on unrelated resources or in
+        // different partitions would still bounce those lines between CPUs. Leaving at least a
+        // full cache line between the members of adjacent entries avoids this regardless of the
+        // alignment of the array returned by operator new[].
+        enum { kCacheLineSize = 64 };
+
         // These types describe the locks hash table
 
         struct LockBucket {
-            LockBucket() : mutex("LockManager") { }
+            LockBucket() : mutex("LockManager.bucket") { }
             SimpleMutex mutex;
             typedef unordered_map<ResourceId, LockHead*> Map;
             Map data;
             LockHead* findOrInsert(ResourceId resId);
+
+            char _cacheLinePadding[kCacheLineSize];
         };
 
         // Each locker maps to a partition that is used for resources acquired in intent modes
         // modes and potentially other modes that don't conflict with themselves. This avoids
         // contention on the regular LockHead in the lock manager.
         struct Partition {
-            Partition() : mutex("LockManager") { }
+            Partition() : mutex("LockManager.partition") { }
             PartitionedLockHead* find(ResourceId resId);
             PartitionedLockHead* findOrInsert(ResourceId resId);
             typedef unordered_map<ResourceId, PartitionedLockHead*> Map;
             SimpleMutex mutex;
             Map data;
+
+            char _cacheLinePadding[kCacheLineSize];
         };
 
         /**
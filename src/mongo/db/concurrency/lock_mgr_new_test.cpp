@@ -349,6 +349,54 @@ namespace mongo {
         }
     }
 
+    TEST(LockManager, IntentLocksMigrateOnConflict) {
+        LockManager lockMgr;
+        const ResourceId resId(RESOURCE_GLOBAL, 1ULL);
+
+        // Use distinct locker ids, so the intent requests land in different partitions
+        MMAPV1LockerImpl locker1(1);
+        MMAPV1LockerImpl locker2(2);
+        MMAPV1LockerImpl locker3(3);
+        MMAPV1LockerImpl lockerX(4);
+
+        LockRequestCombo request1(&locker1);
+        LockRequestCombo request2(&locker2);
+        LockRequestCombo request3(&locker3);
+        LockRequestCombo requestX(&lockerX);
+
+        // Intent requests do not conflict with each other
+        ASSERT(LOCK_OK == lockMgr.lock(resId, &request1, MODE_IX));
+        ASSERT(LOCK_OK == lockMgr.lock(resId, &request2, MODE_IS));
+        ASSERT(LOCK_OK == lockMgr.lock(resId, &request3, MODE_IX));
+
+        // The exclusive request must see the partitioned intent requests and block on them
+        ASSERT(LOCK_WAITING == lockMgr.lock(resId, &requestX, MODE_X));
+        ASSERT(requestX.numNotifies == 0);
+
+        ASSERT(lockMgr.unlock(&request1));
+        ASSERT(lockMgr.unlock(&request2));
+        ASSERT(requestX.numNotifies == 0);
+
+        ASSERT(lockMgr.unlock(&request3));
+        ASSERT(requestX.numNotifies == 1);
+        ASSERT(requestX.lastResult == LOCK_OK);
+
+        // Intent requests must wait behind the exclusive holder and get granted after it leaves
+        LockRequestCombo request1Again(&locker1);
+        ASSERT(LOCK_WAITING == lockMgr.lock(resId, &request1Again, MODE_IS));
+
+        ASSERT(lockMgr.unlock(&requestX));
+        ASSERT(request1Again.numNotifies == 1);
+        ASSERT(request1Again.lastResult == LOCK_OK);
+
+        // Once no conflicting modes are left, new intent requests can be partitioned again
+        LockRequestCombo request2Again(&locker2);
+        ASSERT(LOCK_OK == lockMgr.lock(resId, &request2Again, MODE_IX));
+
+        ASSERT(lockMgr.unlock(&request1Again));
+        ASSERT(lockMgr.unlock(&request2Again));
+    }
+
     TEST(LockManager, ConflictCancelWaiting) {
         LockManager lockMgr;
         const ResourceId resId(RESOURCE_COLLECTION, std::string("TestDB.collection"));
@@ -33,9 +33,11 @@
 #include "mongo/db/concurrency/lock_state.h"
 
 #include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/concurrency/admission_control.h"
 #include "mongo/db/global_environment_experiment.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/util/log.h"
+#include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/stacktrace.h"
 
@@ -264,8 +266,11 @@ namespace {
     LockerImpl<IsForMMAPV1>::LockerImpl(LockerId id)
         : _id(id),
           _wuowNestingLevel(0),
+          _ticketHolder(NULL),
+          _resourceStats(NULL),
           _batchWriter(false),
-          _lockPendingParallelWriter(false) {
+          _lockPendingParallelWriter(false),
+          _readsAtBatchBoundaries(false) {
 
     }
 
@@ -329,6 +334,11 @@ namespace {
 
     template<bool IsForMMAPV1>
     LockResult LockerImpl<IsForMMAPV1>::lockGlobalBegin(LockMode mode) {
+        // Admission is decided once per operation, before it first enters the global lock
+        if (!_requests.find(resourceIdGlobal)) {
+            _acquireTicket(mode);
+        }
+
         const LockResult result = lockBegin(resourceIdGlobal, mode);
 
         if (result == LOCK_OK) return LOCK_OK;
@@ -510,6 +520,26 @@ namespace {
         return ResourceId();
     }
 
+    template<bool IsForMMAPV1>
+    bool LockerImpl<IsForMMAPV1>::hasConflictingWaiters() const {
+        if (_ticketHolder && _ticketHolder->queueDepth() > 0) {
+            return true;
+        }
+
+        // Only the owning thread changes _requests, so it can read them without the spin lock.
+        LockRequestsMap::ConstIterator it = _requests.begin();
+        while (!it.finished()) {
+            if (it->status == LockRequest::STATUS_GRANTED &&
+                    globalLockManager.hasConflictingWaiters(it.key(), it->mode)) {
+                return true;
+            }
+
+            it.next();
+        }
+
+        return false;
+    }
+
     template<bool IsForMMAPV1>
     void LockerImpl<IsForMMAPV1>::getLockerInfo(LockerInfo* lockerInfo) const {
         invariant(lockerInfo);
@@ -695,12 +725,21 @@ namespace {
             }
         }
 
+        if (_resourceStats) {
+            _resourceStats->lockWaits++;
+            _resourceStats->lockWaitMicros += timer.micros();
+        }
+
         // Cleanup the state, since this is an unused lock now
         if (result != LOCK_OK) {
             LockRequestsMap::Iterator it = _requests.find(resId);
             if (globalLockManager.unlock(it.objAddr())) {
                 scoped_spinlock scopedLock(_lock);
                 it.remove();
+
+                if (resId == resourceIdGlobal) {
+                    _releaseTicket();
+                }
             }
         }
 
@@ -721,8 +760,15 @@ namespace {
         }
 
         if (globalLockManager.unlock(it.objAddr())) {
-            scoped_spinlock scopedLock(_lock);
-            it.remove();
+            const bool isGlobal = (it.key() == resourceIdGlobal);
+            {
+                scoped_spinlock scopedLock(_lock);
+                it.remove();
+            }
+
+            if (isGlobal) {
+                _releaseTicket();
+            }
 
             return true;
         }
@@ -730,6 +776,38 @@ namespace {
         return false;
     }
 
+    template<bool IsForMMAPV1>
+    void LockerImpl<IsForMMAPV1>::_acquireTicket(LockMode mode) {
+        invariant(!_ticketHolder);
+
+        TicketHolder* holder = AdmissionControl::getTicketHolder(mode);
+        if (!holder) {
+            return;
+        }
+
+        if (!holder->tryAcquire()) {
+            Timer waitTimer;
+            holder->waitForTicket();
+            if (_resourceStats) {
+                _resourceStats->ticketWaits++;
+                _resourceStats->ticketWaitMicros += waitTimer.micros();
+            }
+        }
+        _ticketHolder = holder;
+        _ticketTimer.reset();
+    }
+
+    template<bool IsForMMAPV1>
+    void LockerImpl<IsForMMAPV1>::_releaseTicket() {
+        if (!_ticketHolder) {
+            return;
+        }
+
+        AdmissionControl::recordTicketHold(_ticketHolder, _ticketTimer.micros());
+        _ticketHolder->release();
+        _ticketHolder = NULL;
+    }
+
     template<bool IsForMMAPV1>
     LockMode LockerImpl<IsForMMAPV1>::_getModeForMMAPV1FlushLock() const {
         invariant(IsForMMAPV1);
@@ -36,6 +36,8 @@
 
 namespace mongo {
 
+    class TicketHolder;
+
     /**
      * Notfication callback, which stores the last notification result and signals a condition
      * variable, which can be waited on.
@@ -123,12 +125,16 @@ namespace mongo {
 
         virtual ResourceId getWaitingResource() const;
 
+        virtual bool hasConflictingWaiters() const;
+
         virtual void getLockerInfo(LockerInfo* lockerInfo) const;
 
         virtual bool saveLockStateAndUnlock(LockSnapshot* stateOut);
 
         virtual void restoreLockState(const LockSnapshot& stateToRestore);
 
+        virtual void setResourceStats(OperationResourceStats* stats) { _resourceStats = stats; }
+
         /**
          * Allows for lock requests to be requested in a non-blocking way. There can be only one
          * outstanding pending lock request per locker object.
@@ -176,6 +182,17 @@ namespace mongo {
          */
         LockMode _getModeForMMAPV1FlushLock() const;
 
+        /**
+         * Takes an admission ticket for a new global lock request in "mode", if operations in
+         * that mode are throttled. See AdmissionControl.
+         */
+        void _acquireTicket(LockMode mode);
+
+        /**
+         * Returns the admission ticket, if any, once the global lock has been released.
+         */
+        void _releaseTicket();
+
 
         // Used to disambiguate different lockers
         const LockerId _id;
@@ -200,6 +217,13 @@ namespace mongo {
         // For maintaining locking timing statistics
         Timer _timer;
 
+        // Admission ticket pool the ticket held for the current global lock came from, or NULL
+        TicketHolder* _ticketHolder;
+        Timer _ticketTimer;
+
+        // Where lock and ticket waits are accounted, or NULL
+        OperationResourceStats* _resourceStats;
+
 
         //////////////////////////////////////////////////////////////////////////////////////////
         //
@@ -229,10 +253,16 @@ namespace mongo {
             _lockPendingParallelWriter = newValue;
         }
 
+        virtual void setReadsAtBatchBoundaries(bool newValue) {
+            _readsAtBatchBoundaries = newValue;
+        }
+        virtual bool readsAtBatchBoundaries() const { return _readsAtBatchBoundaries; }
+
     private:
 
         bool _batchWriter;
         bool _lockPendingParallelWriter;
+        bool _readsAtBatchBoundaries;
     };
 
     typedef LockerImpl<false> DefaultLockerImpl;
@@ -114,6 +114,56 @@ namespace {
         locker2.unlockAll();
     }
 
+    TEST(LockerImpl, HasConflictingWaiters) {
+        const ResourceId resId(RESOURCE_COLLECTION, std::string("TestDB.collection"));
+
+        MMAPV1LockerImpl locker1(1);
+        ASSERT(LOCK_OK == locker1.lockGlobal(MODE_IX));
+        ASSERT(LOCK_OK == locker1.lock(resId, MODE_S));
+        ASSERT_FALSE(locker1.hasConflictingWaiters());
+
+        // A compatible request is granted and so does not count.
+        MMAPV1LockerImpl locker2(2);
+        ASSERT(LOCK_OK == locker2.lockGlobal(MODE_IX));
+        ASSERT(LOCK_OK == locker2.lock(resId, MODE_IS));
+        ASSERT_FALSE(locker1.hasConflictingWaiters());
+
+        MMAPV1LockerImpl locker3(3);
+        ASSERT(LOCK_OK == locker3.lockGlobal(MODE_IX));
+        ASSERT(LOCK_WAITING == locker3.lockBegin(resId, MODE_X));
+        ASSERT(locker1.hasConflictingWaiters());
+        ASSERT(locker2.hasConflictingWaiters());
+        ASSERT_FALSE(locker3.hasConflictingWaiters());
+
+        ASSERT(locker3.unlock(resId));
+        ASSERT_FALSE(locker1.hasConflictingWaiters());
+
+        ASSERT(locker1.unlockAll());
+        ASSERT(locker2.unlockAll());
+        ASSERT(locker3.unlockAll());
+    }
+
+    TEST(LockerImpl, AccountsLockWaits) {
+        const ResourceId resId(RESOURCE_COLLECTION, std::string("TestDB.collection"));
+
+        MMAPV1LockerImpl locker1(1);
+        ASSERT(LOCK_OK == locker1.lockGlobal(MODE_IX));
+        ASSERT(LOCK_OK == locker1.lock(resId, MODE_X));
+
+        OperationResourceStats stats;
+        MMAPV1LockerImpl locker2(2);
+        locker2.setResourceStats(&stats);
+        ASSERT(LOCK_OK == locker2.lockGlobal(MODE_IX));
+        ASSERT_EQUALS(0, stats.lockWaits);
+
+        ASSERT(LOCK_TIMEOUT == locker2.lock(resId, MODE_S, 10));
+        ASSERT_EQUALS(1, stats.lockWaits);
+        ASSERT_GREATER_THAN_OR_EQUALS(stats.lockWaitMicros, 10 * 1000);
+
+        ASSERT(locker1.unlockAll());
+        ASSERT(locker2.unlockAll());
+    }
+
     TEST(LockerImpl, ReadTransaction) {
         MMAPV1LockerImpl locker(1);
 
@@ -34,6 +34,7 @@
 #include "mongo/base/disallow_copying.h"
 #include "mongo/bson/bsonobj.h"
 #include "mongo/db/concurrency/lock_mgr_new.h"
+#include "mongo/db/operation_resource_stats.h"
 
 namespace mongo {
     
@@ -180,6 +181,13 @@ namespace mongo {
          */
         virtual ResourceId getWaitingResource() const = 0;
 
+        /**
+         * Returns true if another locker is queued for one of the resources this one holds, in a
+         * mode which conflicts with the one held, or if operations are queued for the admission
+         * ticket this one holds.  Queries use it to yield only when someone would benefit.
+         */
+        virtual bool hasConflictingWaiters() const = 0;
+
         /**
          * Describes a single lock acquisition for reporting/serialization purposes.
          */
@@ -244,6 +252,12 @@ namespace mongo {
          */
         virtual void restoreLockState(const LockSnapshot& stateToRestore) = 0;
 
+        /**
+         * Time spent queued for locks and admission tickets is added to 'stats', which must
+         * outlive this Locker.  NULL, the default, stops the accounting.
+         */
+        virtual void setResourceStats(OperationResourceStats* stats) = 0;
+
         //
         // These methods are legacy from LockerImpl and will eventually go away or be converted to
         // calls into the Locker methods
@@ -272,6 +286,11 @@ namespace mongo {
         virtual bool isBatchWriter() const = 0;
         virtual void setLockPendingParallelWriter(bool newValue) = 0;
 
+        // Used for reads whose recovery unit only sees replication batch boundaries, which need
+        // not wait for the parallel batch writer either
+        virtual void setReadsAtBatchBoundaries(bool newValue) = 0;
+        virtual bool readsAtBatchBoundaries() const = 0;
+
     protected:
         Locker() { }
     };
@@ -0,0 +1,416 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kDefault
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/concurrency/tenant_scheduler.h"
+
+#include <algorithm>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/json.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+namespace {
+
+    // Charged to a tenant's virtual time for every operation it starts, before its measured cost
+    // is known, so that a tenant of cheap operations cannot start an unbounded number of them.
+    const double kBaseCostMicros = 100;
+
+    // Longest a waiting operation sleeps before checking again for interruption.
+    const long long kMaxWaitMicros = 100 * 1000;
+
+    TenantScheduler globalTenantScheduler;
+
+    int tenantSchedulerConcurrentOps = 0;
+
+    class ConcurrentOpsParameter : public ExportedServerParameter<int> {
+    public:
+        ConcurrentOpsParameter() :
+            ExportedServerParameter<int>(ServerParameterSet::getGlobal(),
+                                         "tenantSchedulerConcurrentOps",
+                                         &tenantSchedulerConcurrentOps,
+                                         true,
+                                         true) {}
+
+        virtual Status validate(const int& potentialNewValue) {
+            if (potentialNewValue < 0) {
+                return Status(ErrorCodes::BadValue,
+                              str::stream() << name() << " must be greater than or equal to 0");
+            }
+            return Status::OK();
+        }
+
+        using ExportedServerParameter<int>::set;
+
+        virtual Status set(const int& newValue) {
+            Status status = ExportedServerParameter<int>::set(newValue);
+            if (status.isOK()) {
+                globalTenantScheduler.setConcurrentOps(newValue);
+            }
+            return status;
+        }
+    } concurrentOpsParameter;
+
+    Status parseLimits(const BSONObj& obj, TenantScheduler::Limits* limits) {
+        BSONForEach(field, obj) {
+            const StringData name = field.fieldNameStringData();
+            if (!field.isNumber()) {
+                return Status(ErrorCodes::BadValue,
+                              str::stream() << "tenant quota " << name << " must be a number");
+            }
+            if (name == "weight") {
+                limits->weight = field.numberDouble();
+                if (!(limits->weight > 0)) {
+                    return Status(ErrorCodes::BadValue, "tenant weight must be positive");
+                }
+            }
+            else if (name == "maxConcurrentOps") {
+                limits->maxConcurrentOps = field.numberInt();
+            }
+            else if (name == "maxOpsPerSec") {
+                limits->maxOpsPerSec = field.numberDouble();
+            }
+            else {
+                return Status(ErrorCodes::BadValue,
+                              str::stream() << "unknown tenant quota " << name);
+            }
+            if (field.numberDouble() < 0) {
+                return Status(ErrorCodes::BadValue,
+                              str::stream() << "tenant quota " << name << " must not be negative");
+            }
+        }
+        return Status::OK();
+    }
+
+    /**
+     * Takes the quotas of all the tenants at once, as { <db>: { weight: <number>,
+     * maxConcurrentOps: <number>, maxOpsPerSec: <number> }, ... }.
+     */
+    class TenantQuotasParameter : public ServerParameter {
+    public:
+        TenantQuotasParameter() :
+            ServerParameter(ServerParameterSet::getGlobal(), "tenantQuotas", true, true) {}
+
+        virtual void append(OperationContext* txn, BSONObjBuilder& b, const std::string& name) {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            b.append(name, _quotas);
+        }
+
+        virtual Status set(const BSONElement& newValueElement) {
+            if (newValueElement.type() != Object) {
+                return Status(ErrorCodes::BadValue, "tenantQuotas must be an object");
+            }
+            return _set(newValueElement.Obj());
+        }
+
+        virtual Status setFromString(const std::string& str) {
+            try {
+                return _set(fromjson(str));
+            }
+            catch (const DBException& e) {
+                return e.toStatus();
+            }
+        }
+
+    private:
+        Status _set(const BSONObj& quotas) {
+            std::map<std::string, TenantScheduler::Limits> limits;
+            BSONForEach(tenant, quotas) {
+                if (tenant.type() != Object) {
+                    return Status(ErrorCodes::BadValue,
+                                  str::stream() << "the quotas of " << tenant.fieldName()
+                                                << " must be an object");
+                }
+                Status status = parseLimits(tenant.Obj(), &limits[tenant.fieldName()]);
+                if (!status.isOK()) {
+                    return status;
+                }
+            }
+
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            _quotas = quotas.getOwned();
+            globalTenantScheduler.setLimits(limits);
+            return Status::OK();
+        }
+
+        boost::mutex _mutex;
+        BSONObj _quotas;
+    } tenantQuotasParameter;
+
+} // namespace
+
+    TenantScheduler::Admission::~Admission() {
+        if (_scheduler) {
+            _scheduler->_release(_tenant, _costMicros);
+        }
+    }
+
+    TenantScheduler::TenantScheduler(int concurrentOps)
+        : _concurrentOps(concurrentOps),
+          _inFlight(0),
+          _virtualTime(0),
+          _enabled(concurrentOps > 0) {}
+
+    TenantScheduler* TenantScheduler::get() {
+        return &globalTenantScheduler;
+    }
+
+    bool TenantScheduler::isExempt(const StringData& db) {
+        return db.empty() || db == "admin" || db == "local" || db == "config";
+    }
+
+    void TenantScheduler::setConcurrentOps(int concurrentOps) {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        _concurrentOps = concurrentOps;
+        _enabled = _concurrentOps > 0 || !_limits.empty();
+        _released.notify_all();
+    }
+
+    void TenantScheduler::setLimits(const std::map<std::string, Limits>& limits) {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        _limits = limits;
+        for (TenantMap::iterator it = _tenants.begin(); it != _tenants.end(); ++it) {
+            std::map<std::string, Limits>::const_iterator found = _limits.find(it->first);
+            it->second.limits = found == _limits.end() ? Limits() : found->second;
+        }
+        _enabled = _concurrentOps > 0 || !_limits.empty();
+        _released.notify_all();
+    }
+
+    void TenantScheduler::admit(OperationContext* txn,
+                                const StringData& tenant,
+                                Admission* admission) {
+        invariant(!admission->admitted());
+        if (!_enabled) {
+            return;
+        }
+
+        boost::unique_lock<boost::mutex> lk(_mutex);
+        Tenant* state = _tenant_inlock(tenant);
+        if (_concurrentOps <= 0 && !_limited_inlock(*state)) {
+            return;
+        }
+
+        long long now = curTimeMicros64();
+        if (_tryAdmit_inlock(state, now)) {
+            _fill_inlock(tenant, admission);
+            return;
+        }
+
+        const long long start = now;
+        bool throttled = false;
+        state->waiting++;
+        while (true) {
+            throttled = throttled || !_eligible_inlock(state, now);
+
+            long long waitMicros = std::min(kMaxWaitMicros, _microsUntilToken_inlock(*state));
+            _released.timed_wait(lk, boost::posix_time::microseconds(std::max(waitMicros, 1LL)));
+
+            now = curTimeMicros64();
+            if (_tryAdmit_inlock(state, now)) {
+                _fill_inlock(tenant, admission);
+                break;
+            }
+            if (txn && !txn->checkForInterruptNoAssert().isOK()) {
+                // Let the operation go on without a slot; it fails on its own interruption check.
+                break;
+            }
+        }
+        state->waiting--;
+        state->waited++;
+        state->totalWaitMicros += now - start;
+        if (throttled) {
+            state->throttled++;
+        }
+
+        // Someone else may be next.
+        _released.notify_all();
+    }
+
+    bool TenantScheduler::tryAdmit(const StringData& tenant,
+                                   long long nowMicros,
+                                   Admission* admission) {
+        invariant(!admission->admitted());
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        if (!_tryAdmit_inlock(_tenant_inlock(tenant), nowMicros)) {
+            return false;
+        }
+        _fill_inlock(tenant, admission);
+        return true;
+    }
+
+    void TenantScheduler::appendStats(BSONObjBuilder* builder) const {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        builder->append("concurrentOps", _concurrentOps);
+        builder->append("inFlight", _inFlight);
+        builder->append("virtualTime", _virtualTime);
+
+        BSONObjBuilder tenants(builder->subobjStart("tenants"));
+        for (TenantMap::const_iterator it = _tenants.begin(); it != _tenants.end(); ++it) {
+            const Tenant& tenant = it->second;
+            BSONObjBuilder b(tenants.subobjStart(it->first));
+            b.append("weight", tenant.limits.weight);
+            b.append("inFlight", tenant.inFlight);
+            b.append("waiting", tenant.waiting);
+            b.appendNumber("admitted", tenant.admitted);
+            b.appendNumber("waited", tenant.waited);
+            b.appendNumber("throttled", tenant.throttled);
+            b.appendNumber("totalWaitMicros", tenant.totalWaitMicros);
+            b.appendNumber("totalCostMicros", tenant.totalCostMicros);
+            b.append("virtualTime", tenant.virtualTime);
+            b.doneFast();
+        }
+        tenants.doneFast();
+    }
+
+    TenantScheduler::Tenant* TenantScheduler::_tenant_inlock(const StringData& name) {
+        std::pair<TenantMap::iterator, bool> inserted =
+            _tenants.insert(std::make_pair(name.toString(), Tenant()));
+        Tenant* tenant = &inserted.first->second;
+        if (inserted.second) {
+            std::map<std::string, Limits>::const_iterator found = _limits.find(name.toString());
+            if (found != _limits.end()) {
+                tenant->limits = found->second;
+            }
+        }
+
+        if (tenant->inFlight == 0 && tenant->waiting == 0) {
+            // Becoming active: an idle tenant does not bank time to spend in a burst later, so it
+            // starts level with the least served of the active ones.
+            bool active = false;
+            double least = 0;
+            for (TenantMap::const_iterator it = _tenants.begin(); it != _tenants.end(); ++it) {
+                const Tenant& other = it->second;
+                if ((other.inFlight > 0 || other.waiting > 0) &&
+                        (!active || other.virtualTime < least)) {
+                    active = true;
+                    least = other.virtualTime;
+                }
+            }
+            if (active) {
+                _virtualTime = std::max(_virtualTime, least);
+            }
+            tenant->virtualTime = std::max(tenant->virtualTime, _virtualTime);
+        }
+        return tenant;
+    }
+
+    bool TenantScheduler::_limited_inlock(const Tenant& tenant) const {
+        return tenant.limits.maxConcurrentOps > 0 || tenant.limits.maxOpsPerSec > 0;
+    }
+
+    bool TenantScheduler::_eligible_inlock(Tenant* tenant, long long nowMicros) {
+        const Limits& limits = tenant->limits;
+        if (limits.maxConcurrentOps > 0 && tenant->inFlight >= limits.maxConcurrentOps) {
+            return false;
+        }
+
+        if (limits.maxOpsPerSec > 0) {
+            const double burst = std::max(1.0, limits.maxOpsPerSec);
+            if (tenant->lastRefillMicros == 0) {
+                tenant->tokens = burst;
+            }
+            else if (nowMicros > tenant->lastRefillMicros) {
+                tenant->tokens = std::min(burst,
+                                          tenant->tokens +
+                                              (nowMicros - tenant->lastRefillMicros) *
+                                                  limits.maxOpsPerSec / 1000000);
+            }
+            tenant->lastRefillMicros = std::max(tenant->lastRefillMicros, nowMicros);
+            if (tenant->tokens < 1) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool TenantScheduler::_tryAdmit_inlock(Tenant* tenant, long long nowMicros) {
+        if (!_eligible_inlock(tenant, nowMicros)) {
+            return false;
+        }
+
+        if (_concurrentOps > 0) {
+            if (_inFlight >= _concurrentOps) {
+                return false;
+            }
+
+            // The slot goes to the waiting tenant which has had the least service for its weight.
+            for (TenantMap::iterator it = _tenants.begin(); it != _tenants.end(); ++it) {
+                Tenant* other = &it->second;
+                if (other != tenant && other->waiting > 0 &&
+                        other->virtualTime < tenant->virtualTime &&
+                        _eligible_inlock(other, nowMicros)) {
+                    return false;
+                }
+            }
+        }
+
+        if (tenant->limits.maxOpsPerSec > 0) {
+            tenant->tokens -= 1;
+        }
+        tenant->virtualTime += kBaseCostMicros / tenant->limits.weight;
+        tenant->inFlight++;
+        tenant->admitted++;
+        _inFlight++;
+        return true;
+    }
+
+    void TenantScheduler::_fill_inlock(const StringData& tenant, Admission* admission) {
+        admission->_scheduler = this;
+        admission->_tenant = tenant.toString();
+        admission->_costMicros = 0;
+    }
+
+    long long TenantScheduler::_microsUntilToken_inlock(const Tenant& tenant) const {
+        if (tenant.limits.maxOpsPerSec <= 0 || tenant.tokens >= 1) {
+            return kMaxWaitMicros;
+        }
+        return static_cast<long long>((1 - tenant.tokens) * 1000000 / tenant.limits.maxOpsPerSec);
+    }
+
+    void TenantScheduler::_release(const std::string& tenant, long long costMicros) {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        TenantMap::iterator it = _tenants.find(tenant);
+        invariant(it != _tenants.end());
+        Tenant& state = it->second;
+        state.inFlight--;
+        state.totalCostMicros += std::max(0LL, costMicros);
+        state.virtualTime += std::max(0LL, costMicros) / state.limits.weight;
+        _inFlight--;
+        _released.notify_all();
+    }
+
+} // namespace mongo
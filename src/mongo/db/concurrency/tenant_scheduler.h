@@ -0,0 +1,188 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <map>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+    class OperationContext;
+
+    /**
+     * Optional per-database admission on top of AdmissionControl, so that the workload of one
+     * database cannot take all of a shared server's capacity.
+     *
+     * Every database (the "tenant") may be given a weight, a limit on its operations in progress
+     * and a limit on the operations it starts per second (see the tenantQuotas server parameter).
+     * With tenantSchedulerConcurrentOps set, no more than that many operations run at once in
+     * all, and when they are all taken the waiting tenants are let in by weighted fair queuing:
+     * each tenant has a virtual time which grows by the cost of its operations divided by its
+     * weight, and the waiting tenant with the lowest virtual time goes next.  The cost of an
+     * operation is the CPU and storage time it used, so a tenant with expensive operations gets
+     * fewer of them.
+     */
+    class TenantScheduler {
+        MONGO_DISALLOW_COPYING(TenantScheduler);
+    public:
+        struct Limits {
+            Limits() : weight(1), maxConcurrentOps(0), maxOpsPerSec(0) {}
+
+            double weight;          // share of the server slots when they are contended
+            int maxConcurrentOps;   // 0 for no limit
+            double maxOpsPerSec;    // 0 for no limit
+        };
+
+        /**
+         * An operation admitted by admit(), returned to the scheduler on destruction.
+         */
+        class Admission {
+            MONGO_DISALLOW_COPYING(Admission);
+        public:
+            Admission() : _scheduler(NULL), _costMicros(0) {}
+            ~Admission();
+
+            bool admitted() const { return _scheduler != NULL; }
+
+            /**
+             * Sets the cost charged to the tenant when the admission ends.
+             */
+            void setCost(long long micros) { _costMicros = micros; }
+
+        private:
+            friend class TenantScheduler;
+
+            TenantScheduler* _scheduler;
+            std::string _tenant;
+            long long _costMicros;
+        };
+
+        explicit TenantScheduler(int concurrentOps = 0);
+
+        /**
+         * The scheduler used by the server, configured by the tenantQuotas and
+         * tenantSchedulerConcurrentOps server parameters.
+         */
+        static TenantScheduler* get();
+
+        /**
+         * Returns true if operations on 'db' are exempt from scheduling.
+         */
+        static bool isExempt(const StringData& db);
+
+        /**
+         * Limits operations running at once across all tenants. 0 for no limit.
+         */
+        void setConcurrentOps(int concurrentOps);
+
+        /**
+         * Replaces the limits of every tenant.  Tenants which are not in 'limits' get the
+         * defaults.
+         */
+        void setLimits(const std::map<std::string, Limits>& limits);
+
+        /**
+         * Waits until an operation of 'tenant' may start, and fills in 'admission' for it.  Gives
+         * up, leaving 'admission' empty, if 'txn' is interrupted first; 'txn' may be NULL.
+         * Returns immediately when nothing limits the tenant.
+         */
+        void admit(OperationContext* txn, const StringData& tenant, Admission* admission);
+
+        /**
+         * Returns true and fills in 'admission' if an operation of 'tenant' may start at
+         * 'nowMicros' without waiting.
+         */
+        bool tryAdmit(const StringData& tenant, long long nowMicros, Admission* admission);
+
+        void appendStats(BSONObjBuilder* builder) const;
+
+    private:
+        struct Tenant {
+            Tenant()
+                : inFlight(0),
+                  waiting(0),
+                  virtualTime(0),
+                  tokens(0),
+                  lastRefillMicros(0),
+                  admitted(0),
+                  waited(0),
+                  throttled(0),
+                  totalWaitMicros(0),
+                  totalCostMicros(0) {}
+
+            Limits limits;
+            int inFlight;
+            int waiting;
+            double virtualTime;
+
+            // Token bucket for limits.maxOpsPerSec
+            double tokens;
+            long long lastRefillMicros;
+
+            long long admitted;
+            long long waited;
+            long long throttled;
+            long long totalWaitMicros;
+            long long totalCostMicros;
+        };
+
+        typedef std::map<std::string, Tenant> TenantMap;
+
+        Tenant* _tenant_inlock(const StringData& name);
+        bool _limited_inlock(const Tenant& tenant) const;
+        bool _eligible_inlock(Tenant* tenant, long long nowMicros);
+        bool _tryAdmit_inlock(Tenant* tenant, long long nowMicros);
+        void _fill_inlock(const StringData& tenant, Admission* admission);
+        long long _microsUntilToken_inlock(const Tenant& tenant) const;
+
+        void _release(const std::string& tenant, long long costMicros);
+
+        mutable boost::mutex _mutex;
+        boost::condition_variable _released;
+
+        int _concurrentOps;
+        int _inFlight;
+        std::map<std::string, Limits> _limits;
+        TenantMap _tenants;
+
+        // Lowest virtual time of the active tenants when one last became active; tenants becoming
+        // active start here so that being idle gives them no credit.
+        double _virtualTime;
+
+        // True while there is anything to enforce, read without the mutex as a fast path
+        volatile bool _enabled;
+    };
+
+} // namespace mongo
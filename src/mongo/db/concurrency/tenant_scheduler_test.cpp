@@ -0,0 +1,159 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/concurrency/tenant_scheduler.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+    typedef std::map<std::string, TenantScheduler::Limits> LimitsMap;
+
+    BSONObj tenantStats(const TenantScheduler& scheduler, const std::string& tenant) {
+        BSONObjBuilder builder;
+        scheduler.appendStats(&builder);
+        return builder.obj()["tenants"].Obj()[tenant].Obj().getOwned();
+    }
+
+    TEST(TenantScheduler, UnlimitedTenantsAreNotTracked) {
+        TenantScheduler scheduler;
+        TenantScheduler::Admission admission;
+        scheduler.admit(NULL, "test", &admission);
+        ASSERT_FALSE(admission.admitted());
+    }
+
+    TEST(TenantScheduler, ExemptsInternalDatabases) {
+        ASSERT_TRUE(TenantScheduler::isExempt("admin"));
+        ASSERT_TRUE(TenantScheduler::isExempt("local"));
+        ASSERT_TRUE(TenantScheduler::isExempt("config"));
+        ASSERT_FALSE(TenantScheduler::isExempt("test"));
+    }
+
+    TEST(TenantScheduler, LimitsConcurrentOpsOfTenant) {
+        TenantScheduler scheduler;
+        LimitsMap limits;
+        limits["a"].maxConcurrentOps = 2;
+        scheduler.setLimits(limits);
+
+        TenantScheduler::Admission first;
+        ASSERT_TRUE(scheduler.tryAdmit("a", 1, &first));
+        {
+            TenantScheduler::Admission second, third;
+            ASSERT_TRUE(scheduler.tryAdmit("a", 1, &second));
+            ASSERT_FALSE(scheduler.tryAdmit("a", 1, &third));
+            ASSERT_FALSE(third.admitted());
+
+            TenantScheduler::Admission other;
+            ASSERT_TRUE(scheduler.tryAdmit("b", 1, &other));
+        }
+
+        TenantScheduler::Admission again;
+        ASSERT_TRUE(scheduler.tryAdmit("a", 1, &again));
+        ASSERT_EQUALS(2, tenantStats(scheduler, "a")["inFlight"].numberInt());
+    }
+
+    TEST(TenantScheduler, LimitsOpsPerSecOfTenant) {
+        TenantScheduler scheduler;
+        LimitsMap limits;
+        limits["a"].maxOpsPerSec = 2;
+        scheduler.setLimits(limits);
+
+        const long long start = 1000 * 1000;
+        for (int i = 0; i < 2; i++) {
+            TenantScheduler::Admission admission;
+            ASSERT_TRUE(scheduler.tryAdmit("a", start, &admission));
+        }
+        TenantScheduler::Admission throttled;
+        ASSERT_FALSE(scheduler.tryAdmit("a", start, &throttled));
+        ASSERT_FALSE(scheduler.tryAdmit("a", start + 400 * 1000, &throttled));
+        ASSERT_TRUE(scheduler.tryAdmit("a", start + 600 * 1000, &throttled));
+    }
+
+    TEST(TenantScheduler, LimitsConcurrentOpsOfServer) {
+        TenantScheduler scheduler(2);
+        TenantScheduler::Admission first, second, third;
+        ASSERT_TRUE(scheduler.tryAdmit("a", 1, &first));
+        ASSERT_TRUE(scheduler.tryAdmit("b", 1, &second));
+        ASSERT_FALSE(scheduler.tryAdmit("c", 1, &third));
+
+        scheduler.setConcurrentOps(0);
+        ASSERT_TRUE(scheduler.tryAdmit("c", 1, &third));
+    }
+
+    TEST(TenantScheduler, ChargesCostByWeight) {
+        TenantScheduler scheduler(4);
+        LimitsMap limits;
+        limits["heavy"].weight = 4;
+        scheduler.setLimits(limits);
+
+        // Keep both tenants active throughout.
+        TenantScheduler::Admission lightHeld, heavyHeld;
+        ASSERT_TRUE(scheduler.tryAdmit("light", 1, &lightHeld));
+        ASSERT_TRUE(scheduler.tryAdmit("heavy", 1, &heavyHeld));
+        const double lightStart = tenantStats(scheduler, "light")["virtualTime"].numberDouble();
+        const double heavyStart = tenantStats(scheduler, "heavy")["virtualTime"].numberDouble();
+
+        for (int i = 0; i < 10; i++) {
+            TenantScheduler::Admission light, heavy;
+            ASSERT_TRUE(scheduler.tryAdmit("light", 1, &light));
+            ASSERT_TRUE(scheduler.tryAdmit("heavy", 1, &heavy));
+            light.setCost(1000);
+            heavy.setCost(1000);
+        }
+
+        const BSONObj light = tenantStats(scheduler, "light");
+        const BSONObj heavy = tenantStats(scheduler, "heavy");
+        ASSERT_EQUALS(10000, light["totalCostMicros"].numberLong());
+        ASSERT_EQUALS(10000, heavy["totalCostMicros"].numberLong());
+        ASSERT_APPROX_EQUAL(light["virtualTime"].numberDouble() - lightStart,
+                            4 * (heavy["virtualTime"].numberDouble() - heavyStart),
+                            0.001);
+    }
+
+    TEST(TenantScheduler, IdleTenantStartsLevelWithActiveOnes) {
+        TenantScheduler scheduler(4);
+        TenantScheduler::Admission busy;
+        ASSERT_TRUE(scheduler.tryAdmit("busy", 1, &busy));
+        for (int i = 0; i < 10; i++) {
+            TenantScheduler::Admission admission;
+            ASSERT_TRUE(scheduler.tryAdmit("busy", 1, &admission));
+            admission.setCost(1000);
+        }
+
+        TenantScheduler::Admission idle;
+        ASSERT_TRUE(scheduler.tryAdmit("idle", 1, &idle));
+        ASSERT_GREATER_THAN(tenantStats(scheduler, "idle")["virtualTime"].numberDouble(),
+                            10000.0);
+    }
+
+} // namespace
+} // namespace mongo
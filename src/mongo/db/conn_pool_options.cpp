@@ -28,6 +28,8 @@
 
 #include "mongo/db/conn_pool_options.h"
 
+#include <limits>
+
 #include "mongo/base/init.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/client/connpool.h"
@@ -37,6 +39,8 @@ namespace mongo {
 
     int ConnPoolOptions::maxConnsPerHost(200);
     int ConnPoolOptions::maxShardedConnsPerHost(200);
+    int ConnPoolOptions::maxInUseConnsPerHost(std::numeric_limits<int>::max());
+    int ConnPoolOptions::maxShardedInUseConnsPerHost(std::numeric_limits<int>::max());
 
     namespace {
 
@@ -54,6 +58,20 @@ namespace mongo {
                                         true,
                                         false /* can't change at runtime */);
 
+        ExportedServerParameter<int> //
+        maxInUseConnsPerHostParameter(ServerParameterSet::getGlobal(),
+                                      "connPoolMaxInUseConnsPerHost",
+                                      &ConnPoolOptions::maxInUseConnsPerHost,
+                                      true,
+                                      false /* can't change at runtime */);
+
+        ExportedServerParameter<int> //
+        maxShardedInUseConnsPerHostParameter(ServerParameterSet::getGlobal(),
+                                             "connPoolMaxShardedInUseConnsPerHost",
+                                             &ConnPoolOptions::maxShardedInUseConnsPerHost,
+                                             true,
+                                             false /* can't change at runtime */);
+
         MONGO_INITIALIZER(InitializeConnectionPools)(InitializerContext* context) {
 
             // Initialize the sharded and unsharded outgoing connection pools
@@ -64,9 +82,11 @@ namespace mongo {
 
             pool.setName("connection pool");
             pool.setMaxPoolSize(ConnPoolOptions::maxConnsPerHost);
+            pool.setMaxInUse(ConnPoolOptions::maxInUseConnsPerHost);
 
             shardConnectionPool.setName("sharded connection pool");
             shardConnectionPool.setMaxPoolSize(ConnPoolOptions::maxShardedConnsPerHost);
+            shardConnectionPool.setMaxInUse(ConnPoolOptions::maxShardedInUseConnsPerHost);
 
             return Status::OK();
         }
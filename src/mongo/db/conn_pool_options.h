@@ -49,6 +49,16 @@ namespace mongo {
          * Maximum connections per host the sharded conn pool should use
          */
         static int maxShardedConnsPerHost;
+
+        /**
+         * Maximum connections per host the connection pool should have in use at once
+         */
+        static int maxInUseConnsPerHost;
+
+        /**
+         * Maximum connections per host the sharded conn pool should have in use at once
+         */
+        static int maxShardedInUseConnsPerHost;
     };
 
 }
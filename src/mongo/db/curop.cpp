@@ -32,6 +32,8 @@
 
 #include "mongo/db/curop.h"
 
+#include <limits>
+
 #include "mongo/base/counter.h"
 #include "mongo/db/client.h"
 #include "mongo/db/commands/server_status_metric.h"
@@ -40,6 +42,7 @@
 #include "mongo/db/stats/top.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
+#include "mongo/util/sampling_profiler.h"
 
 namespace mongo {
 
@@ -101,6 +104,7 @@ namespace mongo {
             _remote = remote;
         }
         _op = op;
+        _tagProfilerSamples();
     }
 
     ProgressMeter& CurOp::setMessage(const char * msg,
@@ -126,6 +130,10 @@ namespace mongo {
         if ( _wrapped ) {
             boost::mutex::scoped_lock clientLock(Client::clientsMutex);
             _client->_curOp = _wrapped;
+            _wrapped->_tagProfilerSamples();
+        }
+        else {
+            SamplingProfiler::clearCurrentThreadTag();
         }
         _client = 0;
     }
@@ -133,6 +141,15 @@ namespace mongo {
     void CurOp::setNS( const StringData& ns ) {
         // _ns copies the data in the null-terminated ptr it's given
         _ns = ns;
+        _tagProfilerSamples();
+    }
+
+    void CurOp::_tagProfilerSamples() const {
+        if (SamplingProfiler::isRunning()) {
+            SamplingProfiler::tagCurrentThread(_opNum,
+                                               _isCommand ? "command" : opToString(_op),
+                                               _ns.toString());
+        }
     }
 
     void CurOp::ensureStarted() {
@@ -152,6 +169,7 @@ namespace mongo {
         ensureStarted();
         _ns = ns;
         _dbprofile = std::max(dbProfileLevel, _dbprofile);
+        _tagProfilerSamples();
     }
 
     void CurOp::recordGlobalTime(bool isWriteLocked, long long micros) const {
@@ -322,7 +340,7 @@ namespace mongo {
     void CurOp::MaxTimeTracker::reset() {
         _enabled = false;
         _targetEpochMicros = 0;
-        _approxTargetServerMillis = 0;
+        _approxTargetMillis = std::numeric_limits<long long>::max();
     }
 
     void CurOp::MaxTimeTracker::setTimeLimit(uint64_t startEpochMicros, uint64_t durationMicros) {
@@ -332,36 +350,34 @@ namespace mongo {
 
         _targetEpochMicros = startEpochMicros + durationMicros;
 
+        // The approximate time source only moves while its thread runs.
+        CoarseClock::start();
+
         uint64_t now = curTimeMicros64();
         // If our accurate time source thinks time is not up yet, calculate the next target for
         // our approximate time source.
         if (_targetEpochMicros > now) {
-            _approxTargetServerMillis = Listener::getElapsedTimeMillis() +
-                                        static_cast<int64_t>((_targetEpochMicros - now) / 1000);
+            _approxTargetMillis = CoarseClock::millis() +
+                                  static_cast<long long>((_targetEpochMicros - now) / 1000);
         }
         // Otherwise, set our approximate time source target such that it thinks time is already
         // up.
         else {
-            _approxTargetServerMillis = Listener::getElapsedTimeMillis();
+            _approxTargetMillis = CoarseClock::millis();
         }
     }
 
-    bool CurOp::MaxTimeTracker::checkTimeLimit() {
+    bool CurOp::MaxTimeTracker::_checkTimeLimitAccurately() {
         if (!_enabled) {
             return false;
         }
 
-        // Does our approximate time source think time is not up yet?  If so, return early.
-        if (_approxTargetServerMillis > Listener::getElapsedTimeMillis()) {
-            return false;
-        }
-
         uint64_t now = curTimeMicros64();
         // Does our accurate time source think time is not up yet?  If so, readjust the target for
         // our approximate time source and return early.
         if (_targetEpochMicros > now) {
-            _approxTargetServerMillis = Listener::getElapsedTimeMillis() +
-                                        static_cast<int64_t>((_targetEpochMicros - now) / 1000);
+            _approxTargetMillis = CoarseClock::millis() +
+                                  static_cast<long long>((_targetEpochMicros - now) / 1000);
             return false;
         }
 
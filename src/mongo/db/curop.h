@@ -32,8 +32,10 @@
 #pragma once
 
 #include "mongo/db/client.h"
+#include "mongo/db/operation_resource_stats.h"
 #include "mongo/db/server_options.h"
 #include "mongo/platform/atomic_word.h"
+#include "mongo/util/coarse_clock.h"
 #include "mongo/util/concurrency/spin_lock.h"
 #include "mongo/util/net/hostandport.h"
 #include "mongo/util/progress_meter.h"
@@ -171,6 +173,9 @@ namespace mongo {
         // TODO: should this really be an opaque BSONObj?  Not sure.
         CachedBSONObj<4096> execStats;
 
+        // Lock, ticket and storage waits and CPU time of this operation
+        OperationResourceStats resources;
+
         // error handling
         ExceptionInfo exceptionInfo;
         
@@ -315,6 +320,9 @@ namespace mongo {
         friend class Client;
         void _reset();
 
+        // Tags the current thread's samples in the sampling profiler with this operation.
+        void _tagProfilerSamples() const;
+
         static AtomicUInt32 _nextOpNum;
         Client * _client;
         CurOp * _wrapped;
@@ -367,8 +375,16 @@ namespace mongo {
             /**
              * Checks whether the time limit has been hit.  Returns false if not, or if time
              * tracking is disabled.
+             *
+             * Until the coarse clock gets near the time limit this is a couple of plain loads,
+             * so it is cheap enough to call on every iteration of a loop.
              */
-            bool checkTimeLimit();
+            bool checkTimeLimit() {
+                if (_approxTargetMillis > CoarseClock::millis()) {
+                    return false;
+                }
+                return _checkTimeLimitAccurately();
+            }
 
             /**
              * Returns the number of microseconds remaining for the time limit, or the special
@@ -379,6 +395,8 @@ namespace mongo {
              */
             uint64_t getRemainingMicros() const;
         private:
+            bool _checkTimeLimitAccurately();
+
             // Whether or not time tracking is enabled for this operation.
             bool _enabled;
 
@@ -386,9 +404,9 @@ namespace mongo {
             // epoch.
             uint64_t _targetEpochMicros;
 
-            // Approximate point in time at which the time limit is hit.   Units of milliseconds
-            // since the server process was started.
-            int64_t _approxTargetServerMillis;
+            // Approximate point in time at which the time limit is hit, as a reading of
+            // CoarseClock.  The largest value there is when time tracking is disabled.
+            long long _approxTargetMillis;
         } _maxTimeTracker;
 
     };
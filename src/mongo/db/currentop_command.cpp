@@ -126,6 +126,14 @@ namespace {
                     opCtx->getCurOp()->reportState(&infoBuilder);
                 }
 
+                // Waits so far
+                const OperationResourceStats* resources = opCtx->resourceStats();
+                if (!resources->empty()) {
+                    BSONObjBuilder resourcesBuilder(infoBuilder.subobjStart("resources"));
+                    resources->append(&resourcesBuilder);
+                    resourcesBuilder.done();
+                }
+
                 // LockState
                 Locker::LockerInfo lockerInfo;
                 client->getOperationContext()->lockState()->getLockerInfo(&lockerInfo);
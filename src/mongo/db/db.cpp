@@ -44,6 +44,7 @@
 #include "mongo/db/auth/auth_index_d.h"
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/authorization_manager_global.h"
+#include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/auth/authz_manager_external_state_d.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
@@ -52,6 +53,7 @@
 #include "mongo/db/catalog/index_key_validate.h"
 #include "mongo/db/client.h"
 #include "mongo/db/clientcursor.h"
+#include "mongo/db/concurrency/admission_control.h"
 #include "mongo/db/concurrency/d_concurrency.h"
 #include "mongo/db/db.h"
 #include "mongo/db/dbdirectclient.h"
@@ -87,11 +89,13 @@
 #include "mongo/db/storage/storage_engine.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/ttl.h"
+#include "mongo/db/warmup.h"
 #include "mongo/platform/process_id.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/cmdline_utils/censor_cmdline.h"
 #include "mongo/util/concurrency/task.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/concurrency/thread_name.h"
 #include "mongo/util/exception_filter_win32.h"
 #include "mongo/util/exit.h"
@@ -130,6 +134,14 @@ namespace mongo {
     };
 #endif
 
+    // Number of threads the range deleter removes queued ranges on, e.g. the chunks this shard
+    // has migrated away.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(rangeDeleterWorkerThreads, int, 1);
+
+    // Number of threads which open databases and resume interrupted index builds at startup.
+    // Each works on one database at a time, under that database's lock.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(startupRecoveryThreads, int, 1);
+
     Timer startupSrandTimer;
 
     QueryResult::View emptyMoreResult(long long);
@@ -229,6 +241,52 @@ namespace mongo {
             if( c ) c->shutdown();
         }
 
+        virtual bool supportsConnectionHandoff() const { return true; }
+
+        virtual void* suspendConnection( AbstractMessagingPort* p ) {
+            return currentClient.release();
+        }
+
+        virtual void resumeConnection( AbstractMessagingPort* p, void* state ) {
+            invariant( currentClient.get() == NULL );
+            currentClient.reset( static_cast<Client*>( state ) );
+        }
+
+        virtual void destroyConnection( void* state ) {
+            delete static_cast<Client*>( state );
+        }
+
+        virtual void* forkConnection( AbstractMessagingPort* p, const Message& m ) {
+            if ( m.operation() != dbQuery || m.singleData().dataLen() < 4 )
+                return NULL;
+            const int queryOptions = ConstDataView( m.singleData().data() ).readLE<int32_t>();
+            if ( ! ( queryOptions & QueryOption_Pipelined ) )
+                return NULL;
+
+            // The request gets a Client of its own, logged in as the same users.
+            Client* connClient = currentClient.release();
+            Client::initThread( "conn", p );
+            try {
+                OperationContextImpl txn;
+                AuthorizationSession* authSession = cc().getAuthorizationSession();
+                UserNameIterator it =
+                    connClient->getAuthorizationSession()->getAuthenticatedUserNames();
+                while ( it.more() ) {
+                    uassertStatusOK( authSession->addAndAuthorizeUser( &txn, it.next() ) );
+                }
+            }
+            catch ( const DBException& e ) {
+                LOG(1) << "running pipelined request in order: " << e << endl;
+                cc().shutdown();
+                destroyConnection( currentClient.release() );
+                currentClient.reset( connClient );
+                return NULL;
+            }
+
+            Client* forked = currentClient.release();
+            currentClient.reset( connClient );
+            return forked;
+        }
     };
 
     static void logStartup() {
@@ -321,103 +379,195 @@ namespace mongo {
         return 0;
     }
 
-    static void repairDatabasesAndCheckVersion() {
-        LOG(1) << "enter repairDatabases (to check pdfile version #)" << endl;
+    /**
+     * Opens 'dbName', checks its files and index specifications, and clears its temporary
+     * collections if 'shouldClearNonLocalTmpCollections' is set or it is "local". Returns false
+     * if its files need an upgrade this version cannot do. The caller holds the database's
+     * lock in MODE_X.
+     */
+    static bool recoverDatabase(OperationContext* txn,
+                                const string& dbName,
+                                bool shouldClearNonLocalTmpCollections) {
+        LOG(1) << "    Recovering database: " << dbName << endl;
+
+        Database* db = dbHolder().openDb(txn, dbName);
+        invariant(db);
+
+        // First thing after opening the database is to check for file compatibility,
+        // otherwise we might crash if this is a deprecated format.
+        if (!db->getDatabaseCatalogEntry()->currentFilesCompatible(txn)) {
+            return false;
+        }
 
-        OperationContextImpl txn;
-        ScopedTransaction transaction(&txn, MODE_X);
-        Lock::GlobalWrite lk(txn.lockState());
+        // Major versions match, check indexes
+        const string systemIndexes = db->name() + ".system.indexes";
 
-        vector<string> dbNames;
+        Collection* coll = db->getCollection( txn, systemIndexes );
+        auto_ptr<PlanExecutor> exec(
+            InternalPlanner::collectionScan(txn, systemIndexes, coll));
 
-        StorageEngine* storageEngine = getGlobalEnvironment()->getGlobalStorageEngine();
-        storageEngine->listDatabases( &dbNames );
+        BSONObj index;
+        PlanExecutor::ExecState state;
+        while (PlanExecutor::ADVANCED == (state = exec->getNext(&index, NULL))) {
+            const BSONObj key = index.getObjectField("key");
+            const string plugin = IndexNames::findPluginName(key);
 
-        // Repair all databases first, so that we do not try to open them if they are in bad shape
-        if (storageGlobalParams.repair) {
-            for (vector<string>::const_iterator i = dbNames.begin(); i != dbNames.end(); ++i) {
-                const string dbName = *i;
-                LOG(1) << "    Repairing database: " << dbName << endl;
+            if (db->getDatabaseCatalogEntry()->isOlderThan24(txn)) {
+                if (IndexNames::existedBefore24(plugin)) {
+                    continue;
+                }
 
-                fassert(18506, repairDatabase(&txn, storageEngine, dbName));
+                log() << "Index " << index << " claims to be of type '" << plugin << "', "
+                        << "which is either invalid or did not exist before v2.4. "
+                        << "See the upgrade section: "
+                        << "http://dochub.mongodb.org/core/upgrade-2.4"
+                        << startupWarningsLog;
             }
-        }
 
-        const repl::ReplSettings& replSettings =
-            repl::getGlobalReplicationCoordinator()->getSettings();
-
-        // On replica set members we only clear temp collections on DBs other than "local" during
-        // promotion to primary. On pure slaves, they are only cleared when the oplog tells them
-        // to. The local DB is special because it is not replicated.  See SERVER-10927 for more
-        // details.
-        const bool shouldClearNonLocalTmpCollections = !(checkIfReplMissingFromCommandLine(&txn)
-                                                    || replSettings.usingReplSets()
-                                                    || replSettings.slave == repl::SimpleSlave);
-
-        for (vector<string>::const_iterator i = dbNames.begin(); i != dbNames.end(); ++i) {
-            const string dbName = *i;
-            LOG(1) << "    Recovering database: " << dbName << endl;
-
-            Database* db = dbHolder().openDb(&txn, dbName);
-            invariant(db);
-
-            // First thing after opening the database is to check for file compatibility,
-            // otherwise we might crash if this is a deprecated format.
-            if (!db->getDatabaseCatalogEntry()->currentFilesCompatible(&txn)) {
-                log() << "****";
-                log() << "cannot do this upgrade without an upgrade in the middle";
-                log() << "please do a --repair with 2.6 and then start this version";
-                dbexit(EXIT_NEED_UPGRADE);
-                return;
+            const Status keyStatus = validateKeyPattern(key);
+            if (!keyStatus.isOK()) {
+                log() << "Problem with index " << index << ": " << keyStatus.reason()
+                        << " This index can still be used however it cannot be rebuilt."
+                        << " For more info see"
+                        << " http://dochub.mongodb.org/core/index-validation"
+                        << startupWarningsLog;
             }
+        }
 
-            // Major versions match, check indexes
-            const string systemIndexes = db->name() + ".system.indexes";
+        if (PlanExecutor::IS_EOF != state) {
+            warning() << "Internal error while reading collection " << systemIndexes;
+        }
 
-            Collection* coll = db->getCollection( &txn, systemIndexes );
-            auto_ptr<PlanExecutor> exec(
-                InternalPlanner::collectionScan(&txn, systemIndexes, coll));
+        if (repl::getGlobalReplicationCoordinator()->getSettings().usingReplSets()) {
+            // We only care about the _id index if we are in a replset
+            checkForIdIndexes(txn, db);
+        }
 
-            BSONObj index;
-            PlanExecutor::ExecState state;
-            while (PlanExecutor::ADVANCED == (state = exec->getNext(&index, NULL))) {
-                const BSONObj key = index.getObjectField("key");
-                const string plugin = IndexNames::findPluginName(key);
+        if (shouldClearNonLocalTmpCollections || dbName == "local") {
+            db->clearTmpCollections(txn);
+        }
 
-                if (db->getDatabaseCatalogEntry()->isOlderThan24(&txn)) {
-                    if (IndexNames::existedBefore24(plugin)) {
-                        continue;
-                    }
+        return true;
+    }
 
-                    log() << "Index " << index << " claims to be of type '" << plugin << "', "
-                            << "which is either invalid or did not exist before v2.4. "
-                            << "See the upgrade section: "
-                            << "http://dochub.mongodb.org/core/upgrade-2.4"
-                            << startupWarningsLog;
+    namespace {
+        // Databases between startup progress messages.
+        const size_t kRecoveryProgressInterval = 1000;
+
+        struct RecoveryProgress {
+            RecoveryProgress() : numDatabases(0) { }
+
+            void databaseDone() {
+                const size_t done = numDone.addAndFetch(1);
+                if (done % kRecoveryProgressInterval == 0) {
+                    log() << "opened " << done << " of " << numDatabases << " databases";
                 }
+            }
+
+            size_t numDatabases;
+            AtomicUInt32 numDone;
+            AtomicUInt32 numIncompatible;
+        };
 
-                const Status keyStatus = validateKeyPattern(key);
-                if (!keyStatus.isOK()) {
-                    log() << "Problem with index " << index << ": " << keyStatus.reason()
-                            << " This index can still be used however it cannot be rebuilt."
-                            << " For more info see"
-                            << " http://dochub.mongodb.org/core/index-validation"
-                            << startupWarningsLog;
+        // Runs recoverDatabase() on a startupRecoveryThreads worker, under its own database lock.
+        void recoverDatabaseInWorker(const string& dbName,
+                                     bool shouldClearNonLocalTmpCollections,
+                                     RecoveryProgress* progress) {
+            Client::initThreadIfNotAlready();
+
+            try {
+                OperationContextImpl txn;
+                ScopedTransaction transaction(&txn, MODE_IX);
+                Lock::DBLock dbLock(txn.lockState(), dbName, MODE_X);
+
+                if (!recoverDatabase(&txn, dbName, shouldClearNonLocalTmpCollections)) {
+                    log() << "files of database " << dbName << " need an upgrade";
+                    progress->numIncompatible.fetchAndAdd(1);
+                    return;
                 }
             }
+            catch (const DBException& e) {
+                error() << "failed to open database " << dbName << " at startup: " << e.toString();
+                fassertFailedNoTrace(28645);
+            }
+
+            progress->databaseDone();
+        }
+    }
+
+    static void repairDatabasesAndCheckVersion() {
+        LOG(1) << "enter repairDatabases (to check pdfile version #)" << endl;
 
-            if (PlanExecutor::IS_EOF != state) {
-                warning() << "Internal error while reading collection " << systemIndexes;
+        OperationContextImpl txn;
+        vector<string> dbNames;
+        bool shouldClearNonLocalTmpCollections;
+        RecoveryProgress progress;
+        const int numThreads = std::max(1, startupRecoveryThreads);
+        bool parallel;
+
+        {
+            ScopedTransaction transaction(&txn, MODE_X);
+            Lock::GlobalWrite lk(txn.lockState());
+
+            StorageEngine* storageEngine = getGlobalEnvironment()->getGlobalStorageEngine();
+            storageEngine->listDatabases( &dbNames );
+            progress.numDatabases = dbNames.size();
+
+            // Repair all databases first, so that we do not try to open them if they are in bad
+            // shape
+            if (storageGlobalParams.repair) {
+                for (vector<string>::const_iterator i = dbNames.begin(); i != dbNames.end(); ++i) {
+                    const string dbName = *i;
+                    LOG(1) << "    Repairing database: " << dbName << endl;
+
+                    fassert(18506, repairDatabase(&txn, storageEngine, dbName));
+                }
             }
 
-            if (replSettings.usingReplSets()) {
-                // We only care about the _id index if we are in a replset
-                checkForIdIndexes(&txn, db);
+            const repl::ReplSettings& replSettings =
+                repl::getGlobalReplicationCoordinator()->getSettings();
+
+            // On replica set members we only clear temp collections on DBs other than "local"
+            // during promotion to primary. On pure slaves, they are only cleared when the oplog
+            // tells them to. The local DB is special because it is not replicated.  See
+            // SERVER-10927 for more details.
+            shouldClearNonLocalTmpCollections = !(checkIfReplMissingFromCommandLine(&txn)
+                                                  || replSettings.usingReplSets()
+                                                  || replSettings.slave == repl::SimpleSlave);
+
+            parallel = numThreads > 1 && dbNames.size() > 1;
+            if (!parallel) {
+                for (vector<string>::const_iterator i = dbNames.begin(); i != dbNames.end(); ++i) {
+                    if (!recoverDatabase(&txn, *i, shouldClearNonLocalTmpCollections)) {
+                        progress.numIncompatible.fetchAndAdd(1);
+                        break;
+                    }
+                    progress.databaseDone();
+                }
             }
+        }
 
-            if (shouldClearNonLocalTmpCollections || dbName == "local") {
-                db->clearTmpCollections(&txn);
+        if (parallel) {
+            // Each database takes only its own lock from here on, so several open at once.
+            log() << "opening " << dbNames.size() << " databases on " << numThreads
+                  << " threads";
+
+            ThreadPool pool(numThreads, "startupRecovery");
+            for (vector<string>::const_iterator i = dbNames.begin(); i != dbNames.end(); ++i) {
+                pool.schedule(recoverDatabaseInWorker,
+                              *i,
+                              shouldClearNonLocalTmpCollections,
+                              &progress);
             }
+            pool.join();
+        }
+
+        if (progress.numIncompatible.load()) {
+            log() << "****";
+            log() << "cannot do this upgrade without an upgrade in the middle";
+            log() << "please do a --repair with 2.6 and then start this version";
+            dbexit(EXIT_NEED_UPGRADE);
+            return;
         }
 
         LOG(1) << "done repairDatabases" << endl;
@@ -580,9 +730,13 @@ namespace mongo {
                 exitCleanly(EXIT_NEED_UPGRADE);
             }
 
-            getDeleter()->startWorkers();
+            getDeleter()->startWorkers(std::max(1, rangeDeleterWorkerThreads));
+
+            restartInProgressIndexesFromLastShutdown(&txn, std::max(1, startupRecoveryThreads));
 
-            restartInProgressIndexesFromLastShutdown(&txn);
+            initProfileRingBuffer();
+
+            startWarmupBackgroundJob();
 
             repl::getGlobalReplicationCoordinator()->startReplication(&txn);
 
@@ -607,6 +761,8 @@ namespace mongo {
 
         startClientCursorMonitor();
 
+        AdmissionControl::startAdaptiveSizing();
+
         PeriodicTask::startRunningPeriodicTasks();
 
         logStartup();
@@ -37,6 +37,7 @@
 #include "mongo/base/disallow_copying.h"
 #include "mongo/base/init.h"
 #include "mongo/base/status.h"
+#include "mongo/bson/util/bson_extract.h"
 #include "mongo/bson/util/builder.h"
 #include "mongo/db/audit.h"
 #include "mongo/db/auth/action_set.h"
@@ -57,6 +58,7 @@
 #include "mongo/db/dbdirectclient.h"
 #include "mongo/db/dbhelpers.h"
 #include "mongo/db/global_environment_d.h"
+#include "mongo/db/index/index_access_method.h"
 #include "mongo/db/index_builder.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/introspect.h"
@@ -65,6 +67,7 @@
 #include "mongo/db/lasterror.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/ops/insert.h"
+#include "mongo/db/profile_ring_buffer.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/query/query_planner.h"
@@ -305,9 +308,10 @@ namespace mongo {
 
         virtual void help( stringstream& help ) const {
             help << "enable or disable performance profiling\n";
-            help << "{ profile : <n> }\n";
+            help << "{ profile : <n>, slowms : <ms>, sampleRate : <fraction> }\n";
             help << "0=off 1=log slow ops 2=log all\n";
             help << "-1 to get current values\n";
+            help << "sampleRate: fraction of the qualifying ops that are profiled\n";
             help << "http://docs.mongodb.org/manual/reference/command/profile/#dbcmd.profile";
         }
 
@@ -318,7 +322,8 @@ namespace mongo {
                                            const BSONObj& cmdObj) {
             AuthorizationSession* authzSession = client->getAuthorizationSession();
 
-            if (cmdObj.firstElement().numberInt() == -1 && !cmdObj.hasField("slowms")) {
+            if (cmdObj.firstElement().numberInt() == -1 && !cmdObj.hasField("slowms") &&
+                    !cmdObj.hasField("sampleRate")) {
                 // If you just want to get the current profiling level you can do so with just
                 // read access to system.profile, even if you can't change the profiling level.
                 if (authzSession->isAuthorizedForActionsOnResource(
@@ -352,6 +357,7 @@ namespace mongo {
             BSONElement e = cmdObj.firstElement();
             result.append("was", ctx.db()->getProfilingLevel());
             result.append("slowms", serverGlobalParams.slowMS);
+            result.append("sampleRate", getProfileSampleRate());
 
             int p = (int) e.number();
             bool ok = false;
@@ -367,10 +373,95 @@ namespace mongo {
                 serverGlobalParams.slowMS = slow.numberInt();
             }
 
+            BSONElement sampleRate = cmdObj["sampleRate"];
+            if (!sampleRate.eoo()) {
+                Status status = sampleRate.isNumber() ?
+                    setProfileSampleRate(sampleRate.numberDouble()) :
+                    Status(ErrorCodes::BadValue, "sampleRate must be a number");
+                if (!status.isOK()) {
+                    return appendCommandStatus(result, status);
+                }
+            }
+
             return ok;
         }
     } cmdProfile;
 
+    class CmdProfileBuffer : public Command {
+    public:
+        CmdProfileBuffer() : Command("profileBuffer") { }
+
+        virtual bool slaveOk() const { return true; }
+        virtual bool isWriteCommandForConfigServer() const { return false; }
+
+        virtual void help( stringstream& help ) const {
+            help << "reads the in-memory log of profiled operations on this database, kept "
+                    "when mongod runs with profileRingBufferSize set\n";
+            help << "{ profileBuffer : 1, since : <seq>, limit : <n> }\n";
+            help << "since: the nextSeq of the previous call, to read only newer entries\n";
+        }
+
+        virtual Status checkAuthForCommand(ClientBasic* client,
+                                           const std::string& dbname,
+                                           const BSONObj& cmdObj) {
+            // The same as reading system.profile.
+            AuthorizationSession* authzSession = client->getAuthorizationSession();
+            if (authzSession->isAuthorizedForActionsOnResource(
+                    ResourcePattern::forExactNamespace(NamespaceString(dbname, "system.profile")),
+                    ActionType::find)) {
+                return Status::OK();
+            }
+            return Status(ErrorCodes::Unauthorized, "unauthorized");
+        }
+
+        bool run(OperationContext* txn, const string& dbname, BSONObj& cmdObj, int,
+                 string& errmsg, BSONObjBuilder& result, bool fromRepl) {
+            ProfileRingBuffer* buffer = profileRingBuffer();
+            if (!buffer) {
+                errmsg = "the profile ring buffer is off; start mongod with "
+                         "--setParameter profileRingBufferSize=<entries>";
+                return false;
+            }
+
+            long long since = 0;
+            Status status = bsonExtractIntegerFieldWithDefault(cmdObj, "since", 0, &since);
+            if (!status.isOK()) {
+                return appendCommandStatus(result, status);
+            }
+            long long limit = 0;
+            status = bsonExtractIntegerFieldWithDefault(cmdObj, "limit", 1000, &limit);
+            if (!status.isOK()) {
+                return appendCommandStatus(result, status);
+            }
+            if (since < 0 || limit <= 0) {
+                errmsg = "since must not be negative and limit must be positive";
+                return false;
+            }
+
+            std::vector<ProfileRingBuffer::Entry> entries;
+            unsigned long long overwritten = 0;
+            unsigned long long nextSeq = buffer->read(since, dbname, limit, &entries,
+                                                      &overwritten);
+
+            // Leave room in the reply for the fields after the entries.
+            const int maxEntriesSize = BSONObjMaxUserSize - 1024;
+            BSONArrayBuilder entriesBuilder(result.subarrayStart("entries"));
+            for (size_t i = 0; i < entries.size(); i++) {
+                if (entriesBuilder.len() + entries[i].obj.objsize() > maxEntriesSize) {
+                    nextSeq = entries[i].seq;
+                    break;
+                }
+                entriesBuilder.append(entries[i].obj);
+            }
+            entriesBuilder.done();
+
+            result.append("nextSeq", static_cast<long long>(nextSeq));
+            result.append("overwritten", static_cast<long long>(overwritten));
+            result.append("capacity", static_cast<long long>(buffer->capacity()));
+            return true;
+        }
+    } cmdProfileBuffer;
+
     class CmdDiagLogging : public Command {
     public:
         virtual bool slaveOk() const {
@@ -883,7 +974,9 @@ namespace mongo {
         virtual bool isWriteCommandForConfigServer() const { return false; }
         virtual void help( stringstream &help ) const {
             help << "{ collStats:\"blog.posts\" , scale : 1 } scale divides sizes e.g. for KB use 1024\n"
-                    "    avgObjSize - in bytes";
+                    "    avgObjSize - in bytes\n"
+                    "    cacheStats : true adds the storage engine's cache statistics for the\n"
+                    "    collection (cache) and each of its indexes (indexCache)";
         }
 
         virtual void addRequiredPrivileges(const std::string& dbname,
@@ -952,9 +1045,35 @@ namespace mongo {
             result.appendNumber("totalIndexSize", indexSize / scale);
             result.append("indexSizes", indexSizes.obj());
 
+            if (jsobj["cacheStats"].trueValue()) {
+                appendCacheStats(txn, collection, scale, &result);
+            }
+
             return true;
         }
 
+    private:
+        static void appendCacheStats(OperationContext* txn,
+                                     Collection* collection,
+                                     int scale,
+                                     BSONObjBuilder* result) {
+            BSONObjBuilder cache;
+            if (collection->getRecordStore()->appendCacheStats(txn, &cache, scale)) {
+                result->append("cache", cache.obj());
+            }
+
+            BSONObjBuilder indexCache(result->subobjStart("indexCache"));
+            IndexCatalog::IndexIterator ii =
+                collection->getIndexCatalog()->getIndexIterator(txn, false);
+            while (ii.more()) {
+                IndexDescriptor* desc = ii.next();
+                const IndexAccessMethod* iam = collection->getIndexCatalog()->getIndex(desc);
+                BSONObjBuilder one;
+                if (iam->appendCacheStats(txn, &one, scale)) {
+                    indexCache.append(desc->indexName(), one.obj());
+                }
+            }
+        }
     } cmdCollectionStats;
 
     class CollectionModCommand : public Command {
@@ -1062,6 +1181,28 @@ namespace mongo {
                         result.appendAs( newExpireSecs , "expireAfterSeconds_new" );
                     }
                 }
+                else if ( str::equals( "addPartition", e.fieldName() ) ) {
+                    if ( e.type() != Date ) {
+                        errmsg = "addPartition has to be a date";
+                        ok = false;
+                        continue;
+                    }
+                    Status s = coll->addPartition( txn, e.date() );
+                    if ( !s.isOK() )
+                        return appendCommandStatus( result, s );
+                }
+                else if ( str::equals( "dropPartitionsBefore", e.fieldName() ) ) {
+                    if ( e.type() != Date ) {
+                        errmsg = "dropPartitionsBefore has to be a date";
+                        ok = false;
+                        continue;
+                    }
+                    int numDropped = 0;
+                    Status s = coll->dropPartitionsBefore( txn, e.date(), &numDropped );
+                    if ( !s.isOK() )
+                        return appendCommandStatus( result, s );
+                    result.append( "partitionsDropped", numDropped );
+                }
                 else {
                     Status s = coll->getRecordStore()->setCustomOption( txn, e, &result );
                     if ( s.isOK() ) {
@@ -55,6 +55,7 @@
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/repl_coordinator_global.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/write_concern.h"
 #include "mongo/db/write_concern_options.h"
 #include "mongo/db/operation_context_impl.h"
@@ -70,6 +71,14 @@ namespace mongo {
 
     const BSONObj reverseNaturalObj = BSON( "$natural" << -1 );
 
+    // Number of documents Helpers::removeRange() deletes per acquisition of the write lock, and
+    // per wait for secondaries when a write concern is given.
+    MONGO_EXPORT_SERVER_PARAMETER(rangeDeleterBatchSize, int, 128);
+
+    // Upper bound on the bytes of documents per second Helpers::removeRange() deletes, so that
+    // orphan cleanup leaves the disk to user operations.  0 means no limit.
+    MONGO_EXPORT_SERVER_PARAMETER(rangeDeleterMaxBytesPerSec, long long, 0);
+
     void Helpers::ensureIndex(OperationContext* txn,
                               Collection* collection,
                               BSONObj keyPattern,
@@ -366,12 +375,15 @@ namespace mongo {
                << " with write concern: " << writeConcern.toBSON() << endl;
 
         long long numDeleted = 0;
+        long long bytesDeleted = 0;
         
         long long millisWaitingForReplication = 0;
 
         while ( 1 ) {
             // Scoping for write lock.
             {
+                txn->checkForInterrupt();
+
                 Client::WriteContext ctx(txn, ns);
                 Collection* collection = ctx.getCollection();
                 if ( !collection )
@@ -381,29 +393,37 @@ namespace mongo {
                     collection->getIndexCatalog()->findIndexByKeyPattern( txn,
                                                                           indexKeyPattern.toBSON() );
 
+                // The scan doesn't yield, so the documents it hands out stay put until the whole
+                // batch has been deleted under this lock.
                 auto_ptr<PlanExecutor> exec(InternalPlanner::indexScan(txn, collection, desc,
                                                                        min, max,
                                                                        maxInclusive,
                                                                        InternalPlanner::FORWARD,
                                                                        InternalPlanner::IXSCAN_FETCH));
-                exec->setYieldPolicy(PlanExecutor::YIELD_AUTO);
 
+                const size_t batchSize = std::max(1, rangeDeleterBatchSize);
+                vector<RecordId> locs;
+                vector<BSONObj> objs;
                 RecordId rloc;
                 BSONObj obj;
-                PlanExecutor::ExecState state;
-                // This may yield so we cannot touch nsd after this.
-                state = exec->getNext(&obj, &rloc);
-                exec.reset();
-                if (PlanExecutor::IS_EOF == state) { break; }
-
-                if (PlanExecutor::DEAD == state) {
-                    warning(LogComponent::kSharding) << "cursor died: aborting deletion for "
-                              << min << " to " << max << " in " << ns
-                              << endl;
-                    break;
+                PlanExecutor::ExecState state = PlanExecutor::IS_EOF;
+                while ( locs.size() < batchSize &&
+                        PlanExecutor::ADVANCED == ( state = exec->getNext(&obj, &rloc) ) ) {
+                    locs.push_back( rloc );
+                    objs.push_back( obj );
                 }
 
-                if (PlanExecutor::FAILURE == state) {
+                if ( locs.empty() ) {
+                    if (PlanExecutor::IS_EOF == state) { break; }
+
+                    if (PlanExecutor::DEAD == state) {
+                        warning(LogComponent::kSharding) << "cursor died: aborting deletion for "
+                                  << min << " to " << max << " in " << ns
+                                  << endl;
+                        break;
+                    }
+
+                    verify(PlanExecutor::FAILURE == state);
                     warning(LogComponent::kSharding) << "cursor error while trying to delete "
                               << min << " to " << max
                               << " in " << ns << ": "
@@ -411,50 +431,60 @@ namespace mongo {
                     break;
                 }
 
-                verify(PlanExecutor::ADVANCED == state);
-
-                WriteUnitOfWork wuow(txn);
-
+                // In write lock, so will be the most up-to-date version
+                CollectionMetadataPtr metadataNow;
                 if ( onlyRemoveOrphanedDocs ) {
-                    // Do a final check in the write lock to make absolutely sure that our
-                    // collection hasn't been modified in a way that invalidates our migration
-                    // cleanup.
-
                     // We should never be able to turn off the sharding state once enabled, but
                     // in the future we might want to.
                     verify(shardingState.enabled());
+                    metadataNow = shardingState.getCollectionMetadata( ns );
+                }
 
-                    // In write lock, so will be the most up-to-date version
-                    CollectionMetadataPtr metadataNow = shardingState.getCollectionMetadata( ns );
-
-                    bool docIsOrphan;
-                    if ( metadataNow ) {
-                        ShardKeyPattern kp( metadataNow->getKeyPattern() );
-                        BSONObj key = kp.extractShardKeyFromDoc(obj);
-                        docIsOrphan = !metadataNow->keyBelongsToMe( key )
-                            && !metadataNow->keyIsPending( key );
-                    }
-                    else {
-                        docIsOrphan = false;
+                bool collectionChanged = false;
+                for ( size_t i = 0; i < locs.size(); i++ ) {
+                    WriteUnitOfWork wuow(txn);
+
+                    if ( onlyRemoveOrphanedDocs ) {
+                        // Do a final check in the write lock to make absolutely sure that our
+                        // collection hasn't been modified in a way that invalidates our migration
+                        // cleanup.
+                        bool docIsOrphan;
+                        if ( metadataNow ) {
+                            ShardKeyPattern kp( metadataNow->getKeyPattern() );
+                            BSONObj key = kp.extractShardKeyFromDoc(objs[i]);
+                            docIsOrphan = !metadataNow->keyBelongsToMe( key )
+                                && !metadataNow->keyIsPending( key );
+                        }
+                        else {
+                            docIsOrphan = false;
+                        }
+
+                        if ( !docIsOrphan ) {
+                            warning(LogComponent::kSharding)
+                                    << "aborting migration cleanup for chunk " << min
+                                    << " to " << max
+                                    << ( metadataNow ? " at document " + objs[i].toString()
+                                                     : string() )
+                                    << ", collection " << ns << " has changed " << endl;
+                            collectionChanged = true;
+                            break;
+                        }
                     }
+                    if ( callback )
+                        callback->goingToDelete( objs[i] );
 
-                    if ( !docIsOrphan ) {
-                        warning(LogComponent::kSharding)
-                                  << "aborting migration cleanup for chunk " << min << " to " << max
-                                  << ( metadataNow ? (string) " at document " + obj.toString() : "" )
-                                  << ", collection " << ns << " has changed " << endl;
-                        break;
-                    }
+                    bytesDeleted += objs[i].objsize();
+
+                    BSONObj deletedId;
+                    collection->deleteDocument( txn, locs[i], false, false, &deletedId );
+                    // The above throws on failure, and so is not logged
+                    repl::logOp(txn, "d", ns.c_str(), deletedId, 0, 0, fromMigrate);
+                    wuow.commit();
+                    numDeleted++;
                 }
-                if ( callback )
-                    callback->goingToDelete( obj );
-
-                BSONObj deletedId;
-                collection->deleteDocument( txn, rloc, false, false, &deletedId );
-                // The above throws on failure, and so is not logged
-                repl::logOp(txn, "d", ns.c_str(), deletedId, 0, 0, fromMigrate);
-                wuow.commit();
-                numDeleted++;
+
+                if ( collectionChanged )
+                    break;
             }
 
             // TODO remove once the yielding below that references this timer has been removed
@@ -475,6 +505,14 @@ namespace mongo {
                 }
                 millisWaitingForReplication += replStatus.duration.total_milliseconds();
             }
+
+            // Spread the deletes out so they don't take more than their share of the disk.
+            if (rangeDeleterMaxBytesPerSec > 0) {
+                const long long dueMillis = bytesDeleted * 1000 / rangeDeleterMaxBytesPerSec;
+                const long long aheadMillis = dueMillis - rangeRemoveTimer.millis();
+                if (aheadMillis > 0)
+                    sleepmillis(aheadMillis);
+            }
         }
         
         if (writeConcern.shouldWaitForOtherNodes())
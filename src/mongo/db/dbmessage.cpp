@@ -188,6 +188,41 @@ namespace mongo {
         p->reply(requestMsg, resp, requestMsg.header().getId());
     }
 
+    namespace {
+        // Below this size copying the body behind the header is cheaper than a second buffer,
+        // and keeps the reply eligible for piggybacking.
+        const int kMinReplyBytesToSendInPlace = 16 * 1024;
+    }
+
+    void replyToQuery(int queryResultFlags,
+                      AbstractMessagingPort* p, Message& requestMsg,
+                      BufBuilder& data,
+                      int nReturned, int startingFrom,
+                      long long cursorId) {
+        if (data.len() < kMinReplyBytesToSendInPlace) {
+            replyToQuery(queryResultFlags, p, requestMsg, data.buf(), data.len(),
+                         nReturned, startingFrom, cursorId);
+            return;
+        }
+
+        BufBuilder b(sizeof(QueryResult::Value));
+        b.skip(sizeof(QueryResult::Value));
+        QueryResult::View qr = b.buf();
+        qr.setResultFlags(queryResultFlags);
+        qr.msgdata().setLen(b.len());
+        qr.msgdata().setOperation(opReply);
+        qr.setCursorId(cursorId);
+        qr.setStartingFrom(startingFrom);
+        qr.setNReturned(nReturned);
+        b.decouple();
+
+        // Both buffers now belong to 'resp', which frees them once sent.
+        Message resp(qr.view2ptr(), true);
+        resp.appendData(data.buf(), data.len());
+        data.decouple();
+        p->reply(requestMsg, resp, requestMsg.header().getId());
+    }
+
     void replyToQuery(int queryResultFlags,
                       AbstractMessagingPort* p, Message& requestMsg,
                       const BSONObj& responseObj) {
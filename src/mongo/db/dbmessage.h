@@ -323,6 +323,17 @@ namespace mongo {
                       long long cursorId = 0
                       );
 
+    /**
+     * Like the replyToQuery() above, but takes over the buffer of 'data' rather than copying it.
+     * A large reply goes out as a separate header and body in one scatter/gather write, which
+     * saves copying batches of up to 16MB.  'data' must not be used afterwards.
+     */
+    void replyToQuery(int queryResultFlags,
+                      AbstractMessagingPort* p, Message& requestMsg,
+                      BufBuilder& data,
+                      int nReturned, int startingFrom = 0,
+                      long long cursorId = 0);
+
 
     /* object reply helper. */
     void replyToQuery(int queryResultFlags,
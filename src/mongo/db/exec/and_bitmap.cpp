@@ -0,0 +1,411 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/and_bitmap.h"
+
+#include "mongo/db/exec/filter.h"
+#include "mongo/db/exec/scoped_timer.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace {
+
+    // Upper limit for the bitmaps.
+    // Stage execution will fail once they use more memory than this threshold.
+    const size_t kDefaultMaxMemUsageBytes = 32 * 1024 * 1024;
+
+} // namespace
+
+namespace mongo {
+
+    using std::auto_ptr;
+    using std::vector;
+
+    const size_t AndBitmapStage::kLookAheadWorks = 10;
+
+    // static
+    const char* AndBitmapStage::kStageType = "AND_BITMAP";
+
+    AndBitmapStage::AndBitmapStage(WorkingSet* ws,
+                                   const MatchExpression* filter,
+                                   const Collection* collection)
+        : _collection(collection),
+          _ws(ws),
+          _filter(filter),
+          _buildingBitmap(true),
+          _currentChild(0),
+          _commonStats(kStageType),
+          _maxMemUsage(kDefaultMaxMemUsageBytes) {}
+
+    AndBitmapStage::AndBitmapStage(WorkingSet* ws,
+                                   const MatchExpression* filter,
+                                   const Collection* collection,
+                                   size_t maxMemUsage)
+        : _collection(collection),
+          _ws(ws),
+          _filter(filter),
+          _buildingBitmap(true),
+          _currentChild(0),
+          _commonStats(kStageType),
+          _maxMemUsage(maxMemUsage) {}
+
+    AndBitmapStage::~AndBitmapStage() {
+        for (size_t i = 0; i < _children.size(); ++i) { delete _children[i]; }
+    }
+
+    void AndBitmapStage::addChild(PlanStage* child) { _children.push_back(child); }
+
+    size_t AndBitmapStage::getMemUsage() const {
+        return _bitmap.getMemUsage() + _seenByCurrentChild.getMemUsage();
+    }
+
+    bool AndBitmapStage::isEOF() {
+        // This is empty before calling work() and not-empty after.
+        if (_lookAheadResults.empty()) { return false; }
+
+        // Either we're busy building the bitmap, in which case we're not done yet.
+        if (_buildingBitmap) { return false; }
+
+        // Or we're streaming in results from the last child.
+
+        // If there's nothing to probe against, we're EOF.
+        if (_bitmap.empty()) { return true; }
+
+        // Otherwise, we're done when the last child is done.
+        invariant(_children.size() >= 2);
+        return (WorkingSet::INVALID_ID == _lookAheadResults[_children.size() - 1])
+               && _children[_children.size() - 1]->isEOF();
+    }
+
+    PlanStage::StageState AndBitmapStage::work(WorkingSetID* out) {
+        ++_commonStats.works;
+
+        // Adds the amount of time taken by work() to executionTimeMillis.
+        ScopedTimer timer(&_commonStats);
+
+        if (isEOF()) { return PlanStage::IS_EOF; }
+
+        // Fast-path for one of our children being EOF immediately.  We work each child a few times.
+        // If it hits EOF, the AND cannot output anything.  If it produces a result, we stash that
+        // result in _lookAheadResults.
+        if (_lookAheadResults.empty()) {
+            // INVALID_ID means that the child didn't produce a valid result.
+            _lookAheadResults.resize(_children.size());
+            for (size_t i = 0; i < _children.size(); ++i) {
+                _lookAheadResults[i] = WorkingSet::INVALID_ID;
+            }
+
+            for (size_t i = 0; i < _children.size(); ++i) {
+                PlanStage* child = _children[i];
+                for (size_t j = 0; j < kLookAheadWorks; ++j) {
+                    StageState childStatus = child->work(&_lookAheadResults[i]);
+
+                    if (PlanStage::IS_EOF == childStatus || PlanStage::DEAD == childStatus) {
+                        // A child went right to EOF.  Bail out.
+                        _buildingBitmap = false;
+                        _bitmap.clear();
+                        return PlanStage::IS_EOF;
+                    }
+                    else if (PlanStage::ADVANCED == childStatus) {
+                        // We have a result cached in _lookAheadResults[i].  Stop looking at this
+                        // child.
+                        break;
+                    }
+                    else if (PlanStage::FAILURE == childStatus) {
+                        // Propage error to parent.
+                        *out = _lookAheadResults[i];
+                        // If a stage fails, it may create a status WSM to indicate why it
+                        // failed, in which case 'id' is valid.  If ID is invalid, we
+                        // create our own error message.
+                        if (WorkingSet::INVALID_ID == *out) {
+                            mongoutils::str::stream ss;
+                            ss << "bitmap AND stage failed to read in look ahead results "
+                               << "from child " << i;
+                            Status status(ErrorCodes::InternalError, ss);
+                            *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+                        }
+
+                        _buildingBitmap = false;
+                        _bitmap.clear();
+                        return PlanStage::FAILURE;
+                    }
+                    // We ignore NEED_TIME. TODO: what do we want to do if we get NEED_FETCH here?
+                }
+            }
+
+            // We did a bunch of work above, return NEED_TIME to be fair.
+            return PlanStage::NEED_TIME;
+        }
+
+        if (_buildingBitmap) {
+            if (getMemUsage() > _maxMemUsage) {
+                mongoutils::str::stream ss;
+                ss << "bitmap AND stage buffered data usage of " << getMemUsage()
+                   << " bytes exceeds internal limit of " << _maxMemUsage << " bytes";
+                Status status(ErrorCodes::Overflow, ss);
+                *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+                return PlanStage::FAILURE;
+            }
+
+            return readChildIntoBitmap(out);
+        }
+
+        // Returning results.  We read from the last child and return the results that are in our
+        // bitmap.
+
+        // We should be EOF if we're not building the bitmap and it is empty.
+        verify(!_bitmap.empty());
+        verify(_currentChild == _children.size() - 1);
+
+        StageState childStatus = workChild(_children.size() - 1, out);
+        if (PlanStage::ADVANCED != childStatus) {
+            return childStatus;
+        }
+
+        WorkingSetMember* member = _ws->get(*out);
+
+        // Maybe the child had an invalidation.  We intersect RecordId(s) so we can't do anything
+        // with this WSM.
+        if (!member->hasLoc()) {
+            _ws->flagForReview(*out);
+            return PlanStage::NEED_TIME;
+        }
+
+        // Removing the RecordId as we go means that we can tell we are done as soon as every
+        // RecordId in the intersection has been returned.
+        if (!_bitmap.remove(member->loc)) {
+            // Child's output wasn't in every previous child.  Throw it out.
+            _ws->free(*out);
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+
+        if (Filter::passes(member, _filter)) {
+            ++_commonStats.advanced;
+            return PlanStage::ADVANCED;
+        }
+
+        _ws->free(*out);
+        ++_commonStats.needTime;
+        return PlanStage::NEED_TIME;
+    }
+
+    PlanStage::StageState AndBitmapStage::workChild(size_t childNo, WorkingSetID* out) {
+        if (WorkingSet::INVALID_ID != _lookAheadResults[childNo]) {
+            *out = _lookAheadResults[childNo];
+            _lookAheadResults[childNo] = WorkingSet::INVALID_ID;
+            return PlanStage::ADVANCED;
+        }
+        else {
+            return _children[childNo]->work(out);
+        }
+    }
+
+    PlanStage::StageState AndBitmapStage::readChildIntoBitmap(WorkingSetID* out) {
+        verify(_currentChild < _children.size() - 1);
+
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        StageState childStatus = workChild(_currentChild, &id);
+
+        if (PlanStage::ADVANCED == childStatus) {
+            WorkingSetMember* member = _ws->get(id);
+
+            // Maybe the child had an invalidation.  We intersect RecordId(s) so we can't do
+            // anything with this WSM.
+            if (!member->hasLoc()) {
+                _ws->flagForReview(id);
+                return PlanStage::NEED_TIME;
+            }
+
+            if (0 == _currentChild) {
+                _bitmap.add(member->loc);
+            }
+            else if (_bitmap.contains(member->loc)) {
+                _seenByCurrentChild.add(member->loc);
+            }
+
+            // Only the RecordId is kept.
+            _ws->free(id);
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+        else if (PlanStage::IS_EOF == childStatus) {
+            // Finished with a child.  The bitmap is now the intersection of the first
+            // _currentChild + 1 children.
+            if (_currentChild > 0) {
+                _bitmap.swap(_seenByCurrentChild);
+                _seenByCurrentChild.clear();
+            }
+            ++_currentChild;
+
+            _specificStats.bitmapAfterChild.push_back(_bitmap.size());
+
+            // If we have nothing to AND with after finishing any child, stop.
+            if (_bitmap.empty()) {
+                _buildingBitmap = false;
+                return PlanStage::IS_EOF;
+            }
+
+            // Only the last child is left.  Probe with it from the next call to work().
+            if (_currentChild == _children.size() - 1) {
+                _buildingBitmap = false;
+            }
+
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+        else if (PlanStage::FAILURE == childStatus) {
+            *out = id;
+            // If a stage fails, it may create a status WSM to indicate why it
+            // failed, in which case 'id' is valid.  If ID is invalid, we
+            // create our own error message.
+            if (WorkingSet::INVALID_ID == id) {
+                mongoutils::str::stream ss;
+                ss << "bitmap AND stage failed to read in results from child " << _currentChild;
+                Status status(ErrorCodes::InternalError, ss);
+                *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+            }
+            return childStatus;
+        }
+        else {
+            if (PlanStage::NEED_TIME == childStatus) {
+                ++_commonStats.needTime;
+            }
+            else if (PlanStage::NEED_FETCH == childStatus) {
+                ++_commonStats.needFetch;
+                *out = id;
+            }
+
+            return childStatus;
+        }
+    }
+
+    void AndBitmapStage::saveState() {
+        ++_commonStats.yields;
+
+        for (size_t i = 0; i < _children.size(); ++i) {
+            _children[i]->saveState();
+        }
+    }
+
+    void AndBitmapStage::restoreState(OperationContext* opCtx) {
+        ++_commonStats.unyields;
+
+        for (size_t i = 0; i < _children.size(); ++i) {
+            _children[i]->restoreState(opCtx);
+        }
+    }
+
+    void AndBitmapStage::invalidate(OperationContext* txn,
+                                    const RecordId& dl,
+                                    InvalidationType type) {
+        ++_commonStats.invalidates;
+
+        if (isEOF()) { return; }
+
+        for (size_t i = 0; i < _children.size(); ++i) {
+            _children[i]->invalidate(txn, dl, type);
+        }
+
+        // Invalidation can happen to our warmup results.  If that occurs just
+        // flag it and forget about it.
+        for (size_t i = 0; i < _lookAheadResults.size(); ++i) {
+            if (WorkingSet::INVALID_ID != _lookAheadResults[i]) {
+                WorkingSetMember* member = _ws->get(_lookAheadResults[i]);
+                if (member->hasLoc() && member->loc == dl) {
+                    WorkingSetCommon::fetchAndInvalidateLoc(txn, member, _collection);
+                    _ws->flagForReview(_lookAheadResults[i]);
+                    _lookAheadResults[i] = WorkingSet::INVALID_ID;
+                }
+            }
+        }
+
+        // If it's a deletion, we have to forget about the RecordId, and since the AND-ing is by
+        // RecordId we can't continue processing it even with the object.
+        //
+        // If it's a mutation the predicates implied by the AND-ing may no longer be true.
+        //
+        // So, we flag and try to pick it up later.  We hold no WSM for the RecordId, so we make
+        // one to hold the fetched document.
+        if (_bitmap.remove(dl)) {
+            _seenByCurrentChild.remove(dl);
+
+            if (_buildingBitmap) {
+                ++_specificStats.flaggedInProgress;
+            }
+            else {
+                ++_specificStats.flaggedButPassed;
+            }
+
+            WorkingSetID id = _ws->allocate();
+            WorkingSetMember* member = _ws->get(id);
+            member->loc = dl;
+            member->state = WorkingSetMember::LOC_AND_IDX;
+            WorkingSetCommon::fetchAndInvalidateLoc(txn, member, _collection);
+            _ws->flagForReview(id);
+        }
+    }
+
+    vector<PlanStage*> AndBitmapStage::getChildren() const {
+        return _children;
+    }
+
+    PlanStageStats* AndBitmapStage::getStats() {
+        _commonStats.isEOF = isEOF();
+
+        _specificStats.memLimit = _maxMemUsage;
+        _specificStats.memUsage = getMemUsage();
+
+        // Add a BSON representation of the filter to the stats tree, if there is one.
+        if (NULL != _filter) {
+            BSONObjBuilder bob;
+            _filter->toBSON(&bob);
+            _commonStats.filter = bob.obj();
+        }
+
+        auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, STAGE_AND_BITMAP));
+        ret->specific.reset(new AndBitmapStats(_specificStats));
+        for (size_t i = 0; i < _children.size(); ++i) {
+            ret->children.push_back(_children[i]->getStats());
+        }
+
+        return ret.release();
+    }
+
+    const CommonStats* AndBitmapStage::getCommonStats() {
+        return &_commonStats;
+    }
+
+    const SpecificStats* AndBitmapStage::getSpecificStats() {
+        return &_specificStats;
+    }
+
+}  // namespace mongo
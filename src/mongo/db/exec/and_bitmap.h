@@ -0,0 +1,146 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/record_id_bitmap.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/record_id.h"
+
+namespace mongo {
+
+    /**
+     * Reads from N children, each of which must have a valid RecordId, and outputs the results of
+     * the last child whose RecordIds were also produced by every other child.
+     *
+     * Unlike AndHashStage, this stage keeps no WorkingSetMembers from the first N-1 children:
+     * it only collects their RecordIds, into a compressed RecordIdBitmap, and frees each result
+     * as soon as it has been read.  That makes the intersection cheap in memory even for large
+     * inputs and many children, but the results carry only the last child's index key data, so
+     * a FETCH is usually needed above this stage.
+     *
+     * Preconditions: Valid RecordId.  More than one child.
+     *
+     * Any RecordId in the bitmap that is invalidated before we are able to return it is fetched
+     * and added to the WorkingSet as "flagged for further review."  Because this stage operates
+     * with RecordIds, we are unable to evaluate the AND for the invalidated RecordId, and it
+     * must be fully matched later.
+     */
+    class AndBitmapStage : public PlanStage {
+    public:
+        AndBitmapStage(WorkingSet* ws,
+                       const MatchExpression* filter,
+                       const Collection* collection);
+
+        /**
+         * For testing only. Allows tests to set memory usage threshold.
+         */
+        AndBitmapStage(WorkingSet* ws,
+                       const MatchExpression* filter,
+                       const Collection* collection,
+                       size_t maxMemUsage);
+
+        virtual ~AndBitmapStage();
+
+        void addChild(PlanStage* child);
+
+        /**
+         * Returns memory usage.
+         * For testing only.
+         */
+        size_t getMemUsage() const;
+
+        virtual StageState work(WorkingSetID* out);
+        virtual bool isEOF();
+
+        virtual void saveState();
+        virtual void restoreState(OperationContext* opCtx);
+        virtual void invalidate(OperationContext* txn, const RecordId& dl, InvalidationType type);
+
+        virtual std::vector<PlanStage*> getChildren() const;
+
+        virtual StageType stageType() const { return STAGE_AND_BITMAP; }
+
+        virtual PlanStageStats* getStats();
+
+        virtual const CommonStats* getCommonStats();
+
+        virtual const SpecificStats* getSpecificStats();
+
+        static const char* kStageType;
+
+    private:
+        static const size_t kLookAheadWorks;
+
+        StageState readChildIntoBitmap(WorkingSetID* out);
+        StageState workChild(size_t childNo, WorkingSetID* out);
+
+        // Not owned by us.
+        const Collection* _collection;
+
+        // Not owned by us.
+        WorkingSet* _ws;
+
+        // Not owned by us.
+        const MatchExpression* _filter;
+
+        // The stages we read from.  Owned by us.
+        std::vector<PlanStage*> _children;
+
+        // We want to see if any of our children are EOF immediately.  This requires working them a
+        // few times to see if they hit EOF or if they produce a result.  If they produce a result,
+        // we place that result here.
+        std::vector<WorkingSetID> _lookAheadResults;
+
+        // The RecordIds produced by every child read so far.  Filled out by the first child,
+        // narrowed by each subsequent child but the last, and probed by the last child.
+        RecordIdBitmap _bitmap;
+
+        // The RecordIds of '_bitmap' which the child currently being read has produced.  Only
+        // used while reading children after the first.
+        RecordIdBitmap _seenByCurrentChild;
+
+        // True if we're still reading _children[0..._children.size()-2] into the bitmap.
+        bool _buildingBitmap;
+
+        // Which child are we currently working on?
+        size_t _currentChild;
+
+        // Stats
+        CommonStats _commonStats;
+        AndBitmapStats _specificStats;
+
+        // Upper limit for the memory used by the bitmaps.
+        // Defaults to 32 MB (See kDefaultMaxMemUsageBytes in and_bitmap.cpp).
+        size_t _maxMemUsage;
+    };
+
+}  // namespace mongo
@@ -56,6 +56,7 @@ namespace mongo {
           _filter(filter),
           _params(params),
           _isDead(false),
+          _advancePending(false),
           _wsidForFetch(_workingSet->allocate()),
           _commonStats(kStageType) {
         // Explain reports the direction of the collection scan.
@@ -72,8 +73,35 @@ namespace mongo {
         ++_commonStats.works;
 
         // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        ScopedTimer timer(&_commonStats);
 
+        return doWork(out);
+    }
+
+    PlanStage::StageState CollectionScan::workBatch(size_t maxWorks,
+                                                    std::vector<WorkingSetID>* out,
+                                                    WorkingSetID* id) {
+        // One timer for the whole batch rather than one per document.
+        ScopedTimer timer(&_commonStats);
+
+        for (size_t i = 0; i < maxWorks; ++i) {
+            ++_commonStats.works;
+
+            WorkingSetID next = WorkingSet::INVALID_ID;
+            StageState state = doWork(&next);
+            if (PlanStage::ADVANCED == state) {
+                out->push_back(next);
+            }
+            else if (PlanStage::NEED_TIME != state) {
+                *id = next;
+                return state;
+            }
+        }
+
+        return PlanStage::NEED_TIME;
+    }
+
+    PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
         if (_isDead) { return PlanStage::DEAD; }
 
         // Do some init if we haven't already.
@@ -98,6 +126,7 @@ namespace mongo {
                 // Advance _iter past where we were last time. If it returns something else, mark us
                 // as dead since we want to signal an error rather than silently dropping data from
                 // the stream. This is related to the _lastSeenLock handling in invalidate.
+                ++_commonStats.storageCursorOps;
                 if (_iter->getNext() != _lastSeenLoc) {
                     _isDead = true;
                     return PlanStage::DEAD;
@@ -108,6 +137,8 @@ namespace mongo {
             return PlanStage::NEED_TIME;
         }
 
+        finishAdvance();
+
         // Should we try getNext() on the underlying _iter?
         if (isEOF())
             return PlanStage::IS_EOF;
@@ -143,15 +174,33 @@ namespace mongo {
         WorkingSetID id = _workingSet->allocate();
         WorkingSetMember* member = _workingSet->get(id);
         member->loc = curr;
-        member->obj = _iter->dataFor(member->loc).releaseToBson();
+        ++_commonStats.storageCursorOps;
         member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+        if (_params.borrowRecords) {
+            // Moving the iterator could free the data, so it stays put until we are next called.
+            member->obj = _iter->currData().releaseToBson();
+            _advancePending = true;
+        }
+        else {
+            member->obj = _iter->dataFor(member->loc).releaseToBson();
 
-        // Advance the iterator.
-        invariant(_iter->getNext() == curr);
+            // Advance the iterator.
+            ++_commonStats.storageCursorOps;
+            invariant(_iter->getNext() == curr);
+        }
 
         return returnIfMatches(member, id, out);
     }
 
+    void CollectionScan::finishAdvance() {
+        if (!_advancePending) {
+            return;
+        }
+        _advancePending = false;
+        ++_commonStats.storageCursorOps;
+        invariant(_iter->getNext() == _lastSeenLoc);
+    }
+
     PlanStage::StageState CollectionScan::returnIfMatches(WorkingSetMember* member,
                                                           WorkingSetID memberID,
                                                           WorkingSetID* out) {
@@ -176,6 +225,7 @@ namespace mongo {
         if (_isDead) { return true; }
         if (NULL == _iter) { return false; }
         if (_params.tailable) { return false; } // tailable cursors can return data later.
+        finishAdvance();
         return _iter->isEOF();
     }
 
@@ -208,6 +258,7 @@ namespace mongo {
         _txn = NULL;
         ++_commonStats.yields;
         if (NULL != _iter) {
+            finishAdvance();
             _iter->saveState();
         }
     }
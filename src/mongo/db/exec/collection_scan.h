@@ -53,6 +53,11 @@ namespace mongo {
                        const MatchExpression* filter);
 
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks,
+                                     std::vector<WorkingSetID>* out,
+                                     WorkingSetID* id);
+        // A batch would hold on to borrowed documents past the next cursor movement.
+        virtual bool supportsBatch() const { return !_params.borrowRecords; }
         virtual bool isEOF();
 
         virtual void invalidate(OperationContext* txn, const RecordId& dl, InvalidationType type);
@@ -72,6 +77,12 @@ namespace mongo {
         static const char* kStageType;
 
     private:
+        /**
+         * Does one unit of work without touching the 'works' counter or the execution timer,
+         * which work() and workBatch() account for themselves.
+         */
+        StageState doWork(WorkingSetID* out);
+
         /**
          * If the member (with id memberID) passes our filter, set *out to memberID and return that
          * ADVANCED.  Otherwise, free memberID and return NEED_TIME.
@@ -80,6 +91,12 @@ namespace mongo {
                                    WorkingSetID memberID,
                                    WorkingSetID* out);
 
+        /**
+         * Moves _iter past the document we last returned, if we left it there so that the
+         * document could be borrowed.
+         */
+        void finishAdvance();
+
         // transactional context for read locks. Not owned by us
         OperationContext* _txn;
 
@@ -97,6 +114,9 @@ namespace mongo {
 
         RecordId _lastSeenLoc;
 
+        // True if _iter still points at _lastSeenLoc, whose data we lent out.
+        bool _advancePending;
+
         // We allocate a working set member with this id on construction of the stage. It gets
         // used for all fetch requests, changing the RecordId as appropriate.
         const WorkingSetID _wsidForFetch;
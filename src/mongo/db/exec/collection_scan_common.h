@@ -44,7 +44,8 @@ namespace mongo {
                                  start(RecordId()),
                                  direction(FORWARD),
                                  tailable(false),
-                                 maxScan(0) { }
+                                 maxScan(0),
+                                 borrowRecords(false) { }
 
         // What collection?
         // not owned
@@ -61,6 +62,11 @@ namespace mongo {
 
         // If non-zero, how many documents will we look at?
         size_t maxScan;
+
+        // If true, the documents we return may point at memory the storage engine owns, which
+        // is only valid until we are next worked, asked isEOF() or saved.  Everything above us
+        // must be done with each document by then.
+        bool borrowRecords;
     };
 
 }  // namespace mongo
@@ -31,6 +31,7 @@
 #include "mongo/db/exec/count.h"
 
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/exec/count_scan.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
 
@@ -48,6 +49,7 @@ namespace mongo {
           _collection(collection),
           _request(request),
           _leftToSkip(request.skip),
+          _triedEstimate(false),
           _ws(ws),
           _child(child),
           _commonStats(kStageType) { }
@@ -55,7 +57,7 @@ namespace mongo {
     CountStage::~CountStage() { }
 
     bool CountStage::isEOF() {
-        if (_specificStats.trivialCount) {
+        if (_specificStats.trivialCount || _specificStats.estimated) {
             return true;
         }
 
@@ -68,7 +70,28 @@ namespace mongo {
 
     void CountStage::trivialCount() {
         invariant(_collection);
-        long long nCounted = _collection->numRecords(_txn);
+        setCount(_collection->numRecords(_txn));
+        _specificStats.trivialCount = true;
+    }
+
+    bool CountStage::estimateCount() {
+        _triedEstimate = true;
+        if (NULL == _child.get() || STAGE_COUNT_SCAN != _child->stageType()) {
+            return false;
+        }
+
+        long long total;
+        if (!static_cast<CountScan*>(_child.get())->estimateCount(&total)) {
+            return false;
+        }
+
+        setCount(total);
+        _specificStats.estimated = true;
+        return true;
+    }
+
+    void CountStage::setCount(long long total) {
+        long long nCounted = total;
 
         if (0 != _request.skip) {
             nCounted -= _request.skip;
@@ -88,14 +111,13 @@ namespace mongo {
 
         _specificStats.nCounted = nCounted;
         _specificStats.nSkipped = _request.skip;
-        _specificStats.trivialCount = true;
     }
 
     PlanStage::StageState CountStage::work(WorkingSetID* out) {
         ++_commonStats.works;
 
         // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        ScopedTimer timer(&_commonStats);
 
         // This stage never returns a working set member.
         *out = WorkingSet::INVALID_ID;
@@ -107,6 +129,11 @@ namespace mongo {
             return PlanStage::IS_EOF;
         }
 
+        if (_request.estimate && !_triedEstimate && estimateCount()) {
+            _commonStats.isEOF = true;
+            return PlanStage::IS_EOF;
+        }
+
         if (isEOF()) {
             _commonStats.isEOF = true;
             return PlanStage::IS_EOF;
@@ -36,6 +36,8 @@ namespace mongo {
      * A description of a request for a count operation. Copyable.
      */
     struct CountRequest {
+        CountRequest() : limit(0), skip(0), explain(false), estimate(false) { }
+
         // Namespace to operate on (e.g. "foo.bar").
         std::string ns;
 
@@ -60,6 +62,10 @@ namespace mongo {
 
         // Whether this is an explain of a count.
         bool explain;
+
+        // Whether an estimate from the storage engine is good enough. Counts over an index range
+        // are then answered without walking the keys, if the index can estimate its ranges.
+        bool estimate;
     };
 
     /**
@@ -109,6 +115,19 @@ namespace mongo {
          */
         void trivialCount();
 
+        /**
+         * Answers the count with an estimate from the index being counted over, if 'estimate' was
+         * requested and the child is a count scan whose index can estimate the range. Returns
+         * false if the count must be computed by walking the child instead.
+         */
+        bool estimateCount();
+
+        /**
+         * Applies the skip and limit to 'total', the number of results before skipping, and
+         * stores the result in '_specificStats'.
+         */
+        void setCount(long long total);
+
         // Transactional context for read locks. Not owned by us.
         OperationContext* _txn;
 
@@ -120,6 +139,9 @@ namespace mongo {
         // The number of documents that we still need to skip.
         long long _leftToSkip;
 
+        // Whether we have already asked the child for an estimated count.
+        bool _triedEstimate;
+
         // The working set used to pass intermediate results between stages. Not owned
         // by us.
         WorkingSet* _ws;
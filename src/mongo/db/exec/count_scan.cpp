@@ -68,6 +68,7 @@ namespace mongo {
 
         // _btreeCursor points at our start position.  We move it forward until it hits a cursor
         // that points at the end.
+        ++_commonStats.storageCursorOps;
         _btreeCursor->seek(_params.startKey, !_params.startKeyInclusive);
 
         ++_specificStats.keysExamined;
@@ -81,6 +82,7 @@ namespace mongo {
         _endCursor.reset(static_cast<BtreeIndexCursor*>(endCursor));
 
         // If the end key is inclusive we want to point *past* it since that's the end.
+        ++_commonStats.storageCursorOps;
         _endCursor->seek(_params.endKey, _params.endKeyInclusive);
 
         ++_specificStats.keysExamined;
@@ -106,7 +108,7 @@ namespace mongo {
         ++_commonStats.works;
 
         // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        ScopedTimer timer(&_commonStats);
 
         if (NULL == _btreeCursor.get()) {
             // First call to work().  Perform cursor init.
@@ -119,6 +121,7 @@ namespace mongo {
         if (isEOF()) { return PlanStage::IS_EOF; }
 
         RecordId loc = _btreeCursor->getValue();
+        ++_commonStats.storageCursorOps;
         _btreeCursor->next();
         checkEnd();
 
@@ -163,6 +166,7 @@ namespace mongo {
         ++_commonStats.unyields;
         if (_hitEnd || (NULL == _btreeCursor.get())) { return; }
 
+        ++_commonStats.storageCursorOps;
         if (!_btreeCursor->restorePosition( opCtx ).isOK()) {
             _hitEnd = true;
             return;
@@ -181,6 +185,7 @@ namespace mongo {
             return;
         }
 
+        ++_commonStats.storageCursorOps;
         if (!_endCursor->restorePosition( opCtx ).isOK()) {
             _hitEnd = true;
             return;
@@ -196,6 +201,7 @@ namespace mongo {
         // need to relocate the endCursor to point at them as the "end key" of our count.
         //
         // If we weren't EOF our end position might have moved around.  Relocate it.
+        ++_commonStats.storageCursorOps;
         _endCursor->seek(_params.endKey, _params.endKeyInclusive);
 
         // This can change during yielding.
@@ -221,6 +227,19 @@ namespace mongo {
         }
     }
 
+    bool CountScan::estimateCount(long long* countOut) const {
+        if (_descriptor->isMultikey(_txn)) {
+            return false;
+        }
+
+        return _iam->estimateNumKeysInRange(_txn,
+                                            _params.startKey,
+                                            _params.startKeyInclusive,
+                                            _params.endKey,
+                                            _params.endKeyInclusive,
+                                            countOut);
+    }
+
     vector<PlanStage*> CountScan::getChildren() const {
         vector<PlanStage*> empty;
         return empty;
@@ -87,6 +87,13 @@ namespace mongo {
 
         virtual const SpecificStats* getSpecificStats();
 
+        /**
+         * Asks the index for an estimate of the number of keys between the start and end keys,
+         * without walking them. Returns false if the index cannot estimate the range, or if it is
+         * multikey so that the keys would have to be deduplicated.
+         */
+        bool estimateCount(long long* countOut) const;
+
         static const char* kStageType;
 
     private:
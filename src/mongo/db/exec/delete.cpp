@@ -32,9 +32,12 @@
 
 #include "mongo/db/exec/delete.h"
 
+#include <algorithm>
+
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/repl_coordinator_global.h"
 #include "mongo/util/log.h"
@@ -72,7 +75,7 @@ namespace mongo {
         ++_commonStats.works;
 
         // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        ScopedTimer timer(&_commonStats);
 
         if (isEOF()) { return PlanStage::IS_EOF; }
         invariant(_collection); // If isEOF() returns false, we must have a collection.
@@ -81,47 +84,39 @@ namespace mongo {
         StageState status = _child->work(&id);
 
         if (PlanStage::ADVANCED == status) {
-            WorkingSetMember* member = _ws->get(id);
-            if (!member->hasLoc()) {
+            const size_t batchSize =
+                _params.isMulti ? std::max(1, internalQueryExecDeleteBatchSize) : 1;
+
+            // Gather consecutive results from the child. Nothing yields in between, so none of
+            // them can be invalidated before they are deleted below. Stop at the first state
+            // other than ADVANCED, which is handled once the batch has been deleted.
+            _locsToDelete.clear();
+            while (PlanStage::ADVANCED == status) {
+                WorkingSetMember* member = _ws->get(id);
+                if (!member->hasLoc()) {
+                    _ws->free(id);
+                    const std::string errmsg =
+                        "delete stage failed to read member w/ loc from child";
+                    *out = WorkingSetCommon::allocateStatusMember(
+                        _ws, Status(ErrorCodes::InternalError, errmsg));
+                    return PlanStage::FAILURE;
+                }
+                _locsToDelete.push_back(member->loc);
                 _ws->free(id);
-                const std::string errmsg = "delete stage failed to read member w/ loc from child";
-                *out = WorkingSetCommon::allocateStatusMember(_ws, Status(ErrorCodes::InternalError,
-                                                                          errmsg));
-                return PlanStage::FAILURE;
-            }
-            RecordId rloc = member->loc;
-            _ws->free(id);
 
-            BSONObj deletedDoc;
+                if (_locsToDelete.size() >= batchSize) {
+                    break;
+                }
+
+                id = WorkingSet::INVALID_ID;
+                status = _child->work(&id);
+            }
 
-            // TODO: Do we want to buffer docs and delete them in a group rather than
-            // saving/restoring state repeatedly?
             _child->saveState();
 
             {
                 WriteUnitOfWork wunit(_txn);
-
-                const bool deleteCappedOK = false;
-                const bool deleteNoWarn = false;
-
-                // Do the write, unless this is an explain.
-                if (!_params.isExplain) {
-                    _collection->deleteDocument(_txn, rloc, deleteCappedOK, deleteNoWarn,
-                                                _params.shouldCallLogOp ? &deletedDoc : NULL);
-
-                    if (_params.shouldCallLogOp) {
-                        if (deletedDoc.isEmpty()) {
-                            log() << "Deleted object without id in collection " << _collection->ns()
-                            << ", not logging.";
-                        }
-                        else {
-                            bool replJustOne = true;
-                            repl::logOp(_txn, "d", _collection->ns().ns().c_str(), deletedDoc, 0,
-                                        &replJustOne, _params.fromMigrate);
-                        }
-                    }
-                }
-
+                deleteBatch();
                 wunit.commit();
             }
 
@@ -130,12 +125,17 @@ namespace mongo {
             //  transaction, make sure to restore the state outside of the WritUnitOfWork.
             _child->restoreState(_txn);
 
-            ++_specificStats.docsDeleted;
+            _specificStats.docsDeleted += _locsToDelete.size();
 
-            ++_commonStats.needTime;
-            return PlanStage::NEED_TIME;
+            if (PlanStage::ADVANCED == status || PlanStage::NEED_TIME == status) {
+                ++_commonStats.needTime;
+                return PlanStage::NEED_TIME;
+            }
+
+            // Fall through to report the state which ended the batch.
         }
-        else if (PlanStage::FAILURE == status) {
+
+        if (PlanStage::FAILURE == status) {
             *out = id;
             // If a stage fails, it may create a status WSM to indicate why it failed, in which case
             // 'id' is valid.  If ID is invalid, we create our own error message.
@@ -158,6 +158,34 @@ namespace mongo {
         return status;
     }
 
+    void DeleteStage::deleteBatch() {
+        // Don't actually do the writes if this is an explain.
+        if (_params.isExplain) {
+            return;
+        }
+
+        const bool deleteCappedOK = false;
+        const bool deleteNoWarn = false;
+
+        for (size_t i = 0; i < _locsToDelete.size(); ++i) {
+            BSONObj deletedDoc;
+            _collection->deleteDocument(_txn, _locsToDelete[i], deleteCappedOK, deleteNoWarn,
+                                        _params.shouldCallLogOp ? &deletedDoc : NULL);
+
+            if (_params.shouldCallLogOp) {
+                if (deletedDoc.isEmpty()) {
+                    log() << "Deleted object without id in collection " << _collection->ns()
+                    << ", not logging.";
+                }
+                else {
+                    bool replJustOne = true;
+                    repl::logOp(_txn, "d", _collection->ns().ns().c_str(), deletedDoc, 0,
+                                &replJustOne, _params.fromMigrate);
+                }
+            }
+        }
+    }
+
     void DeleteStage::saveState() {
         _txn = NULL;
         ++_commonStats.yields;
@@ -30,6 +30,7 @@
 
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/record_id.h"
 
 namespace mongo {
 
@@ -62,6 +63,11 @@ namespace mongo {
      * This stage delete documents by RecordId that are returned from its child.  NEED_TIME
      * is returned after deleting a document.
      *
+     * A multi-delete gathers up to internalQueryExecDeleteBatchSize consecutive results from
+     * its child within a single work() call, then deletes them (and writes their oplog entries)
+     * in one WriteUnitOfWork, saving and restoring the child once per batch instead of once per
+     * document.
+     *
      * Callers of work() must be holding a write lock (and, for shouldCallLogOp=true deletes,
      * callers must have had the replication coordinator approve the write).
      */
@@ -102,6 +108,11 @@ namespace mongo {
         static long long getNumDeleted(PlanExecutor* exec);
 
     private:
+        /**
+         * Deletes the documents in _locsToDelete, within the current WriteUnitOfWork.
+         */
+        void deleteBatch();
+
         // Transactional context.  Not owned by us.
         OperationContext* _txn;
 
@@ -117,6 +128,9 @@ namespace mongo {
 
         scoped_ptr<PlanStage> _child;
 
+        // The batch being deleted by work().  A member so that its storage is reused.
+        std::vector<RecordId> _locsToDelete;
+
         // Stats
         CommonStats _commonStats;
         DeleteStats _specificStats;
@@ -40,7 +40,10 @@ namespace mongo {
     // static
     const char* DistinctScan::kStageType = "DISTINCT";
 
-    DistinctScan::DistinctScan(OperationContext* txn, const DistinctParams& params, WorkingSet* workingSet)
+    DistinctScan::DistinctScan(OperationContext* txn,
+                               const DistinctParams& params,
+                               WorkingSet* workingSet,
+                               const MatchExpression* filter)
         : _txn(txn),
           _workingSet(workingSet),
           _descriptor(params.descriptor),
@@ -48,6 +51,7 @@ namespace mongo {
           _btreeCursor(NULL),
           _scanState(INITIALIZING),
           _params(params),
+          _filter(filter),
           _commonStats(kStageType) {
         _specificStats.keyPattern = _params.descriptor->keyPattern();
         _specificStats.indexName = _params.descriptor->indexName();
@@ -88,6 +92,7 @@ namespace mongo {
         key.resize(nFields);
         inc.resize(nFields);
         if (_checker->getStartKey(&key, &inc)) {
+            ++_commonStats.storageCursorOps;
             _btreeCursor->seek(key, inc);
             _keyElts.resize(nFields);
             _keyEltsInc.resize(nFields);
@@ -109,7 +114,7 @@ namespace mongo {
         ++_commonStats.works;
 
         // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        ScopedTimer timer(&_commonStats);
 
         if (INITIALIZING == _scanState) {
             invariant(NULL == _btreeCursor.get());
@@ -130,12 +135,22 @@ namespace mongo {
             BSONObj ownedKeyObj = _btreeCursor->getKey().getOwned();
             RecordId loc = _btreeCursor->getValue();
 
+            if (!Filter::passes(ownedKeyObj, _descriptor->keyPattern(), _filter)) {
+                // Another key with this value may pass, so move on by a single key.
+                ++_commonStats.storageCursorOps;
+                _btreeCursor->next();
+                _scanState = CHECKING_END;
+                ++_commonStats.needTime;
+                return PlanStage::NEED_TIME;
+            }
+
             // The underlying IndexCursor points at the *next* thing we want to return.  We do this
             // so that if we're scanning an index looking for docs to delete we don't continually
             // clobber the thing we're pointing at.
 
             // We skip to the next value of the _params.fieldNo-th field in the index key pattern.
             // This is the field we're distinct-ing over.
+            ++_commonStats.storageCursorOps;
             _btreeCursor->skip(_btreeCursor->getKey(),
                                _params.fieldNo + 1,
                                true,
@@ -193,6 +208,7 @@ namespace mongo {
 
         // We can have a valid position before we check isEOF(), restore the position, and then be
         // EOF upon restore.
+        ++_commonStats.storageCursorOps;
         if (!_btreeCursor->restorePosition( opCtx ).isOK() || _btreeCursor->isEOF()) {
             _scanState = HIT_END;
             return;
@@ -236,6 +252,7 @@ namespace mongo {
         }
 
         verify(IndexBoundsChecker::MUST_ADVANCE == keyState);
+        ++_commonStats.storageCursorOps;
         _btreeCursor->skip(_btreeCursor->getKey(), _keyEltsToUse, _movePastKeyElts,
                            _keyElts, _keyEltsInc);
 
@@ -252,6 +269,14 @@ namespace mongo {
 
     PlanStageStats* DistinctScan::getStats() {
         _commonStats.isEOF = isEOF();
+
+        // Add a BSON representation of the filter to the stats tree, if there is one.
+        if (NULL != _filter) {
+            BSONObjBuilder bob;
+            _filter->toBSON(&bob);
+            _commonStats.filter = bob.obj();
+        }
+
         auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, STAGE_DISTINCT));
         ret->specific.reset(new DistinctScanStats(_specificStats));
         return ret.release();
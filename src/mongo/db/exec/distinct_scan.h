@@ -75,6 +75,10 @@ namespace mongo {
      * for that field, so there is no point in examining all keys with the same value for that
      * field.
      *
+     * A filter over the index key may be given.  Keys which fail it are stepped over one at a
+     * time, since a later key with the same value may pass, and the skip only happens once a
+     * value has produced a key that passes.
+     *
      * Only created through the getExecutorDistinct path.  See db/query/get_executor.cpp
      */
     class DistinctScan : public PlanStage {
@@ -97,7 +101,10 @@ namespace mongo {
             HIT_END
         };
 
-        DistinctScan(OperationContext* txn, const DistinctParams& params, WorkingSet* workingSet);
+        DistinctScan(OperationContext* txn,
+                     const DistinctParams& params,
+                     WorkingSet* workingSet,
+                     const MatchExpression* filter = NULL);
         virtual ~DistinctScan() { }
 
         virtual StageState work(WorkingSetID* out);
@@ -149,6 +156,9 @@ namespace mongo {
 
         DistinctParams _params;
 
+        // Applied to each key within the bounds.  Not owned by us, may be NULL.
+        const MatchExpression* _filter;
+
         // _checker gives us our start key and ensures we stay in bounds.
         boost::scoped_ptr<IndexBoundsChecker> _checker;
         int _keyEltsToUse;
@@ -32,6 +32,7 @@
 #include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage/record_fetcher.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/mongoutils/str.h"
@@ -52,6 +53,8 @@ namespace mongo {
           _child(child),
           _filter(filter),
           _idBeingPagedIn(WorkingSet::INVALID_ID),
+          _pendingChildState(PlanStage::NEED_TIME),
+          _pendingChildId(WorkingSet::INVALID_ID),
           _commonStats(kStageType) { }
 
     FetchStage::~FetchStage() { }
@@ -63,6 +66,11 @@ namespace mongo {
             return false;
         }
 
+        if (!_pendingResults.empty() || PlanStage::NEED_TIME != _pendingChildState) {
+            // Part of a batch from our child is still waiting to be processed.
+            return false;
+        }
+
         return _child->isEOF();
     }
 
@@ -70,7 +78,7 @@ namespace mongo {
         ++_commonStats.works;
 
         // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        ScopedTimer timer(&_commonStats);
 
         if (isEOF()) { return PlanStage::IS_EOF; }
 
@@ -80,54 +88,152 @@ namespace mongo {
             _idBeingPagedIn = WorkingSet::INVALID_ID;
             WorkingSetMember* member = _ws->get(id);
 
+            ++_commonStats.storageCursorOps;
             WorkingSetCommon::completeFetch(_txn, member, _collection);
 
             return returnIfMatches(member, id, out);
         }
 
+        // A page-in request in the middle of a batch can leave child results behind. They are
+        // returned, in order, before we go back to the child.
+        if (!_pendingResults.empty()) {
+            WorkingSetID id = _pendingResults.front();
+            _pendingResults.pop_front();
+            return fetchOrRequestPageIn(id, out);
+        }
+
+        if (PlanStage::NEED_TIME != _pendingChildState) {
+            StageState status = _pendingChildState;
+            _pendingChildState = PlanStage::NEED_TIME;
+            return handleChildState(status, _pendingChildId, out);
+        }
+
         // If we're here, we're not waiting for a RecordId to be fetched.  Get another to-be-fetched
         // result from our child.
         WorkingSetID id = WorkingSet::INVALID_ID;
         StageState status = _child->work(&id);
 
         if (PlanStage::ADVANCED == status) {
-            WorkingSetMember* member = _ws->get(id);
+            return fetchOrRequestPageIn(id, out);
+        }
+
+        return handleChildState(status, id, out);
+    }
 
-            // If there's an obj there, there is no fetching to perform.
-            if (member->hasObj()) {
-                ++_specificStats.alreadyHasObj;
+    PlanStage::StageState FetchStage::workBatch(size_t maxWorks,
+                                                std::vector<WorkingSetID>* out,
+                                                WorkingSetID* id) {
+        if (WorkingSet::INVALID_ID != _idBeingPagedIn
+            || !_pendingResults.empty()
+            || PlanStage::NEED_TIME != _pendingChildState) {
+            // Finish off what is left of the previous batch one result at a time.
+            return PlanStage::workBatch(maxWorks, out, id);
+        }
+
+        // Adds the amount of time taken by the batch to executionTimeMillis.
+        ScopedTimer timer(&_commonStats);
+
+        if (_child->isEOF()) {
+            ++_commonStats.works;
+            return PlanStage::IS_EOF;
+        }
+
+        const size_t childWorksBefore = _child->getCommonStats()->works;
+        _childResults.clear();
+        StageState status = _child->workBatch(maxWorks, &_childResults, id);
+        _commonStats.works += _child->getCommonStats()->works - childWorksBefore;
+
+        for (size_t i = 0; i < _childResults.size(); ++i) {
+            WorkingSetID result = WorkingSet::INVALID_ID;
+            StageState state = fetchOrRequestPageIn(_childResults[i], &result);
+            if (PlanStage::ADVANCED == state) {
+                out->push_back(result);
             }
-            else {
-                // We need a valid loc to fetch from and this is the only state that has one.
-                verify(WorkingSetMember::LOC_AND_IDX == member->state);
-                verify(member->hasLoc());
-
-                // We might need to retrieve 'nextLoc' from secondary storage, in which case we send
-                // a NEED_FETCH request up to the PlanExecutor.
-                if (!member->loc.isNull()) {
-                    std::auto_ptr<RecordFetcher> fetcher(
-                        _collection->documentNeedsFetch(_txn, member->loc));
-                    if (NULL != fetcher.get()) {
-                        // There's something to fetch. Hand the fetcher off to the WSM, and pass up
-                        // a fetch request.
-                        _idBeingPagedIn = id;
-                        member->setFetcher(fetcher.release());
-                        *out = id;
-                        _commonStats.needFetch++;
-                        return NEED_FETCH;
-                    }
+            else if (PlanStage::NEED_FETCH == state) {
+                // Hold on to the rest of the batch, and to whatever stopped our child, until the
+                // page-in has been done.
+                _pendingResults.insert(_pendingResults.end(),
+                                       _childResults.begin() + i + 1,
+                                       _childResults.end());
+                _pendingChildState = status;
+                _pendingChildId = *id;
+                _childResults.clear();
+                if (internalQueryExecFetchPrefetch) {
+                    prefetchPendingResults();
                 }
+                *id = result;
+                return PlanStage::NEED_FETCH;
+            }
+        }
+        _childResults.clear();
+
+        return handleChildState(status, *id, id);
+    }
 
-                // The doc is already in memory, so go ahead and grab it. Now we have a RecordId
-                // as well as an unowned object
-                member->obj = _collection->docFor(_txn, member->loc);
-                member->keyData.clear();
-                member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+    PlanStage::StageState FetchStage::fetchOrRequestPageIn(WorkingSetID id, WorkingSetID* out) {
+        WorkingSetMember* member = _ws->get(id);
+
+        // If there's an obj there, there is no fetching to perform.
+        if (member->hasObj()) {
+            ++_specificStats.alreadyHasObj;
+        }
+        else {
+            // We need a valid loc to fetch from and this is the only state that has one.
+            verify(WorkingSetMember::LOC_AND_IDX == member->state);
+            verify(member->hasLoc());
+
+            // We might need to retrieve 'nextLoc' from secondary storage, in which case we send
+            // a NEED_FETCH request up to the PlanExecutor.
+            if (!member->loc.isNull()) {
+                std::auto_ptr<RecordFetcher> fetcher(
+                    _collection->documentNeedsFetch(_txn, member->loc));
+                if (NULL != fetcher.get()) {
+                    // There's something to fetch. Hand the fetcher off to the WSM, and pass up
+                    // a fetch request.
+                    _idBeingPagedIn = id;
+                    member->setFetcher(fetcher.release());
+                    *out = id;
+                    _commonStats.needFetch++;
+                    return NEED_FETCH;
+                }
             }
 
-            return returnIfMatches(member, id, out);
+            // The doc is already in memory, so go ahead and grab it. Now we have a RecordId
+            // as well as an unowned object
+            ++_commonStats.storageCursorOps;
+            member->obj = _collection->docFor(_txn, member->loc);
+            member->keyData.clear();
+            member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+        }
+
+        return returnIfMatches(member, id, out);
+    }
+
+    void FetchStage::prefetchPendingResults() {
+        std::vector<RecordId> locs;
+        locs.reserve(_pendingResults.size() + 1);
+        locs.push_back(_ws->get(_idBeingPagedIn)->loc);
+        for (std::deque<WorkingSetID>::const_iterator it = _pendingResults.begin();
+             it != _pendingResults.end(); ++it) {
+            WorkingSetMember* member = _ws->get(*it);
+            if (!member->hasObj() && member->hasLoc() && !member->loc.isNull()) {
+                locs.push_back(member->loc);
+            }
         }
-        else if (PlanStage::FAILURE == status) {
+
+        if (locs.size() < 2) {
+            // Only the document being paged in, which the page-in request touches anyway.
+            return;
+        }
+
+        _collection->prefetchDocuments(_txn, locs);
+        _specificStats.docsPrefetched += locs.size();
+    }
+
+    PlanStage::StageState FetchStage::handleChildState(StageState status,
+                                                       WorkingSetID id,
+                                                       WorkingSetID* out) {
+        if (PlanStage::FAILURE == status) {
             *out = id;
             // If a stage fails, it may create a status WSM to indicate why it
             // failed, in which case 'id' is valid.  If ID is invalid, we
@@ -178,6 +284,15 @@ namespace mongo {
                 WorkingSetCommon::fetchAndInvalidateLoc(txn, member, _collection);
             }
         }
+
+        // The same goes for child results held back behind a page-in request.
+        for (std::deque<WorkingSetID>::const_iterator it = _pendingResults.begin();
+             it != _pendingResults.end(); ++it) {
+            WorkingSetMember* member = _ws->get(*it);
+            if (member->hasLoc() && (member->loc == dl)) {
+                WorkingSetCommon::fetchAndInvalidateLoc(txn, member, _collection);
+            }
+        }
     }
 
     PlanStage::StageState FetchStage::returnIfMatches(WorkingSetMember* member,
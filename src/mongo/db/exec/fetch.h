@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <deque>
+
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
@@ -55,6 +57,10 @@ namespace mongo {
 
         virtual bool isEOF();
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks,
+                                     std::vector<WorkingSetID>* out,
+                                     WorkingSetID* id);
+        virtual bool supportsBatch() const { return true; }
 
         virtual void saveState();
         virtual void restoreState(OperationContext* opCtx);
@@ -74,6 +80,17 @@ namespace mongo {
 
     private:
 
+        /**
+         * Fetches the document for the child result 'id' and applies our filter to it, or, if
+         * the document is not in memory, sets up a page-in request and returns NEED_FETCH.
+         */
+        StageState fetchOrRequestPageIn(WorkingSetID id, WorkingSetID* out);
+
+        /**
+         * Handles a non-ADVANCED state returned by our child, filling in *out as needed.
+         */
+        StageState handleChildState(StageState status, WorkingSetID id, WorkingSetID* out);
+
         /**
          * If the member (with id memberID) passes our filter, set *out to memberID and return that
          * ADVANCED.  Otherwise, free memberID and return NEED_TIME.
@@ -81,6 +98,12 @@ namespace mongo {
         StageState returnIfMatches(WorkingSetMember* member, WorkingSetID memberID,
                                    WorkingSetID* out);
 
+        /**
+         * Hints to the storage engine that the documents of the results held in
+         * '_pendingResults', and of the one being paged in, are about to be read.
+         */
+        void prefetchPendingResults();
+
         OperationContext* _txn;
 
         // Collection which is used by this stage. Used to resolve record ids retrieved by child
@@ -108,6 +131,16 @@ namespace mongo {
         // CollectionScan for when '_idBeingPagedIn' is invalidated before it can be returned.
         WorkingSetID _idBeingPagedIn;
 
+        // A page-in request can interrupt the processing of a batch of results from our child.
+        // The unprocessed results wait here, and the state that ended the child's batch waits in
+        // '_pendingChildState' (NEED_TIME if there is none), until work() gets to them.
+        std::deque<WorkingSetID> _pendingResults;
+        StageState _pendingChildState;
+        WorkingSetID _pendingChildId;
+
+        // Scratch space for the results of _child->workBatch().
+        std::vector<WorkingSetID> _childResults;
+
         // Stats
         CommonStats _commonStats;
         FetchStats _specificStats;
@@ -55,7 +55,7 @@ namespace mongo {
             // BSONElementIterator does some interesting things with arrays that I don't think
             // SimpleArrayElementIterator does.
             if (_wsm->hasObj()) {
-                return new BSONElementIterator(path, _wsm->obj);
+                return new BSONElementIterator(path, _wsm->obj, _wsm->fieldIndex());
             }
 
             // NOTE: This (kind of) duplicates code in WorkingSetMember::getFieldDotted.
@@ -271,6 +271,39 @@ namespace mongo {
         return fullBounds;
     }
 
+    // The number of results we aim for each annulus to buffer.
+    static const double kTargetResultsPerInterval = 450;
+
+    /**
+     * Returns the width to give the next annulus, which starts where the last one, from
+     * 'lastInner' to 'lastOuter', ended.  That annulus was 'lastIncrement' wide and buffered
+     * 'lastResults' results.
+     *
+     * Assuming the density seen in the last annulus holds, picks the width whose area should
+     * buffer about kTargetResultsPerInterval results.  This takes sparse regions in a few large
+     * steps instead of doubling every pass, and shrinks quickly in dense ones.  The width at
+     * most halves or quadruples per annulus, so one unusual annulus can't swing it too far.
+     */
+    static double nextBoundsIncrement(double lastIncrement,
+                                      double lastInner,
+                                      double lastOuter,
+                                      long long lastResults) {
+        const double minIncrement = lastIncrement / 2;
+        const double maxIncrement = lastIncrement * 4;
+
+        if (lastResults <= 0) {
+            return maxIncrement;
+        }
+
+        // Annulus areas are proportional to outer^2 - inner^2; the constant factor cancels.
+        const double inner = max(0.0, lastInner);
+        const double lastArea = lastOuter * lastOuter - inner * inner;
+        const double nextArea = lastArea * (kTargetResultsPerInterval / lastResults);
+        const double nextOuter = sqrt(lastOuter * lastOuter + nextArea);
+
+        return min(maxIncrement, max(minIncrement, nextOuter - lastOuter));
+    }
+
     class GeoNear2DStage::DensityEstimator {
     public:
         DensityEstimator(const IndexDescriptor* twoDindex, const GeoNearParams* nearParams) :
@@ -653,10 +686,10 @@ namespace mongo {
             const IntervalStats& lastIntervalStats = stats->intervalStats.back();
 
             // TODO: Generally we want small numbers of results fast, then larger numbers later
-            if (lastIntervalStats.numResultsBuffered < 300)
-                _boundsIncrement *= 2;
-            else if (lastIntervalStats.numResultsBuffered > 600)
-                _boundsIncrement /= 2;
+            _boundsIncrement = nextBoundsIncrement(_boundsIncrement,
+                                                   _currBounds.getInner(),
+                                                   _currBounds.getOuter(),
+                                                   lastIntervalStats.numResultsBuffered);
         }
 
         _boundsIncrement = max(_boundsIncrement,
@@ -1114,10 +1147,10 @@ namespace mongo {
             const IntervalStats& lastIntervalStats = stats->intervalStats.back();
 
             // TODO: Generally we want small numbers of results fast, then larger numbers later
-            if (lastIntervalStats.numResultsBuffered < 300)
-                _boundsIncrement *= 2;
-            else if (lastIntervalStats.numResultsBuffered > 600)
-                _boundsIncrement /= 2;
+            _boundsIncrement = nextBoundsIncrement(_boundsIncrement,
+                                                   _currBounds.getInner(),
+                                                   _currBounds.getOuter(),
+                                                   lastIntervalStats.numResultsBuffered);
         }
 
         invariant(_boundsIncrement > 0.0);
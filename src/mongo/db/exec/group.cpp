@@ -35,6 +35,7 @@
 #include "mongo/db/client_basic.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/query/query_knobs.h"
 
 namespace mongo {
 
@@ -119,6 +120,28 @@ namespace mongo {
         }
     }
 
+    void GroupStage::switchToScripting() {
+        invariant(_nativeReducer);
+        initGroupScripting();
+        _scope->setObject("$seed", BSON("groups" << nativeResults()), false);
+        _scope->exec("$arr = $seed.groups; $seed = null;", "$group native seed", false, true,
+                     true, 100);
+
+        _nativeReducer.reset();
+        _nativeKeys.clear();
+        _nativeStates.clear();
+    }
+
+    BSONArray GroupStage::nativeResults() const {
+        BSONArrayBuilder results;
+        for (size_t i = 0; i < _nativeKeys.size(); i++) {
+            BSONObjBuilder group(results.subobjStart());
+            _nativeReducer->appendResult(_nativeKeys[i], _nativeStates[i], &group);
+            group.doneFast();
+        }
+        return results.arr();
+    }
+
     Status GroupStage::processObject(const BSONObj& obj) {
         BSONObj key;
         Status getKeyStatus = getKey(obj, _request.keyPattern, _keyFunction, _scope.get(),
@@ -127,16 +150,33 @@ namespace mongo {
             return getKeyStatus;
         }
 
+        if (_nativeReducer && !NativeGroupReducer::canRenderKey(key)) {
+            switchToScripting();
+        }
+
         int& n = _groupMap[key];
         if (n == 0) {
             n = _groupMap.size();
-            _scope->setObject("$key", key, true);
+            if (_nativeReducer) {
+                _nativeKeys.push_back(key);
+                _nativeStates.push_back(_nativeReducer->initialState());
+            }
+            else {
+                _scope->setObject("$key", key, true);
+            }
             if (n > 20000) {
                 return Status(ErrorCodes::BadValue,
                               "group() can't handle more than 20000 unique keys");
             }
         }
 
+        if (_nativeReducer) {
+            if (_nativeReducer->process(obj, &_nativeStates[n - 1])) {
+                return Status::OK();
+            }
+            switchToScripting();
+        }
+
         _scope->setObject("obj", obj, true);
         _scope->setNumber("n", n - 1);
         if (_scope->invoke(_reduceFunction, 0, 0, 0, true)) {
@@ -148,6 +188,16 @@ namespace mongo {
     }
 
     BSONObj GroupStage::finalizeResults() {
+        _specificStats.nGroups = _groupMap.size();
+
+        if (_nativeReducer) {
+            _specificStats.reducedNatively = true;
+            if (_request.finalize.empty()) {
+                return nativeResults();
+            }
+            switchToScripting();
+        }
+
         if (!_request.finalize.empty()) {
             _scope->exec("$finalize = " + _request.finalize, "$group finalize define", false,
                          true, true, 100);
@@ -162,8 +212,6 @@ namespace mongo {
             _scope->invoke(finalizeFunction, 0, 0, 0, true);
         }
 
-        _specificStats.nGroups = _groupMap.size();
-
         BSONObj results = _scope->getObject("$arr").getOwned();
 
         _scope->exec("$arr = [];", "$group reduce setup 2", false, true, true, 100);
@@ -175,13 +223,20 @@ namespace mongo {
     PlanStage::StageState GroupStage::work(WorkingSetID* out) {
         ++_commonStats.works;
 
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        ScopedTimer timer(&_commonStats);
 
         if (isEOF()) { return PlanStage::IS_EOF; }
 
-        // On the first call to work(), call initGroupScripting().
+        // On the first call to work(), set up the native reducer or, failing that, call
+        // initGroupScripting().
         if (_groupState == GroupState_Initializing) {
-            initGroupScripting();
+            if (internalQueryGroupNativeReduce && _request.keyFunctionCode.empty()) {
+                _nativeReducer.reset(NativeGroupReducer::parse(_request.reduceCode,
+                                                               _request.initial));
+            }
+            if (!_nativeReducer) {
+                initGroupScripting();
+            }
             _groupState = GroupState_ReadingFromChild;
             ++_commonStats.needTime;
             return PlanStage::NEED_TIME;
@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include "mongo/db/exec/group_native_reduce.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/scripting/engine.h"
 
@@ -76,6 +77,10 @@ namespace mongo {
      * the entire group result, then returns EOF.
      *
      * Only created through the getExecutorGroup path.
+     *
+     * Reduce functions which NativeGroupReducer recognizes run without JavaScript.  Should a
+     * document come up which it cannot handle as JavaScript would, or a finalize function need
+     * running, the groups so far are handed to a JavaScript scope and the rest carries on there.
      */
     class GroupStage: public PlanStage {
         MONGO_DISALLOW_COPYING(GroupStage);
@@ -123,6 +128,12 @@ namespace mongo {
         // Initializes _scope, _reduceFunction and _keyFunction using the global scripting engine.
         void initGroupScripting();
 
+        // Moves the groups reduced natively so far into "$arr" and continues in JavaScript.
+        void switchToScripting();
+
+        // Returns the groups reduced natively so far, as an array in group index order.
+        BSONArray nativeResults() const;
+
         // Updates _groupMap and _scope to account for the group key associated with this object.
         // Returns an error status if an error occurred, else Status::OK().
         Status processObject(const BSONObj& obj);
@@ -162,6 +173,12 @@ namespace mongo {
         // Map from group key => group index.  The group index is used to index into "$arr", a
         // variable owned by _scope which contains the group data for this key.
         std::map<BSONObj, int, BSONObjCmp> _groupMap;
+
+        // Set while the reduce function runs natively, in which case there is no _scope yet and
+        // the keys and states of the groups are kept here by group index instead of in "$arr".
+        scoped_ptr<NativeGroupReducer> _nativeReducer;
+        std::vector<BSONObj> _nativeKeys;
+        std::vector<std::vector<double> > _nativeStates;
     };
 
 }  // namespace mongo
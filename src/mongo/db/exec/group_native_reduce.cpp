@@ -0,0 +1,440 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/group_native_reduce.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <set>
+
+namespace mongo {
+namespace {
+
+    struct Token {
+        enum Kind { kIdent, kNumber, kPunct };
+
+        Kind kind;
+        std::string text;
+    };
+
+    bool isIdentStart(char c) {
+        return isalpha(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+    }
+
+    bool isIdentChar(char c) {
+        return isIdentStart(c) || isdigit(static_cast<unsigned char>(c));
+    }
+
+    /**
+     * Splits 'code' into the few kinds of token the recognized functions are made of.  Returns
+     * false on anything else, such as string literals.
+     */
+    bool tokenize(const std::string& code, std::vector<Token>* tokens) {
+        size_t i = 0;
+        while (i < code.size()) {
+            const char c = code[i];
+            if (isspace(static_cast<unsigned char>(c))) {
+                i++;
+            }
+            else if (code.compare(i, 2, "//") == 0) {
+                i = code.find('\n', i);
+                if (i == std::string::npos) {
+                    i = code.size();
+                }
+            }
+            else if (code.compare(i, 2, "/*") == 0) {
+                i = code.find("*/", i + 2);
+                if (i == std::string::npos) {
+                    return false;
+                }
+                i += 2;
+            }
+            else if (isIdentStart(c)) {
+                const size_t start = i;
+                while (i < code.size() && isIdentChar(code[i])) {
+                    i++;
+                }
+                Token t = { Token::kIdent, code.substr(start, i - start) };
+                tokens->push_back(t);
+            }
+            else if (isdigit(static_cast<unsigned char>(c))) {
+                const size_t start = i;
+                while (i < code.size() &&
+                       (isdigit(static_cast<unsigned char>(code[i])) || code[i] == '.')) {
+                    i++;
+                }
+                Token t = { Token::kNumber, code.substr(start, i - start) };
+                tokens->push_back(t);
+            }
+            else if (code.compare(i, 2, "++") == 0 || code.compare(i, 2, "+=") == 0) {
+                Token t = { Token::kPunct, code.substr(i, 2) };
+                tokens->push_back(t);
+                i += 2;
+            }
+            else if (strchr("+=.,;(){}", c)) {
+                Token t = { Token::kPunct, std::string(1, c) };
+                tokens->push_back(t);
+                i++;
+            }
+            else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    class Parser {
+    public:
+        explicit Parser(const std::vector<Token>& tokens) : _tokens(tokens), _pos(0) {}
+
+        bool done() const { return _pos == _tokens.size(); }
+
+        bool punct(const char* text) {
+            if (_pos < _tokens.size() && _tokens[_pos].kind == Token::kPunct &&
+                    _tokens[_pos].text == text) {
+                _pos++;
+                return true;
+            }
+            return false;
+        }
+
+        bool ident(std::string* out) {
+            if (_pos < _tokens.size() && _tokens[_pos].kind == Token::kIdent) {
+                *out = _tokens[_pos++].text;
+                return true;
+            }
+            return false;
+        }
+
+        bool keyword(const char* text) {
+            if (_pos < _tokens.size() && _tokens[_pos].kind == Token::kIdent &&
+                    _tokens[_pos].text == text) {
+                _pos++;
+                return true;
+            }
+            return false;
+        }
+
+        bool number(double* out) {
+            if (_pos >= _tokens.size() || _tokens[_pos].kind != Token::kNumber) {
+                return false;
+            }
+            const std::string& text = _tokens[_pos].text;
+            char* end = NULL;
+            *out = strtod(text.c_str(), &end);
+            if (end != text.c_str() + text.size()) {
+                return false;
+            }
+            _pos++;
+            return true;
+        }
+
+        /**
+         * Parses "<object>.<field>".
+         */
+        bool member(const std::string& object, std::string* field) {
+            const size_t start = _pos;
+            if (keyword(object.c_str()) && punct(".") && ident(field)) {
+                return true;
+            }
+            _pos = start;
+            return false;
+        }
+
+        size_t pos() const { return _pos; }
+        void reset(size_t pos) { _pos = pos; }
+
+    private:
+        const std::vector<Token>& _tokens;
+        size_t _pos;
+    };
+
+    bool isJsNumber(const BSONElement& elem) {
+        return elem.type() == NumberInt || elem.type() == NumberDouble ||
+            elem.type() == NumberLong;
+    }
+
+    /**
+     * Types which come back from a round trip through a JavaScript object as they went in,
+     * apart from numbers becoming doubles.
+     */
+    bool isPlainValue(const BSONElement& elem) {
+        switch (elem.type()) {
+        case NumberInt:
+        case NumberDouble:
+        case NumberLong:
+        case String:
+        case Bool:
+        case Date:
+        case jstOID:
+        case jstNULL:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    double jsMin(double a, double b) {
+        return (a != a || b != b) ? std::numeric_limits<double>::quiet_NaN() : std::min(a, b);
+    }
+
+    double jsMax(double a, double b) {
+        return (a != a || b != b) ? std::numeric_limits<double>::quiet_NaN() : std::max(a, b);
+    }
+
+} // namespace
+
+    // static
+    NativeGroupReducer* NativeGroupReducer::parse(const std::string& reduceCode,
+                                                  const BSONObj& initial) {
+        std::vector<Token> tokens;
+        if (!tokenize(reduceCode, &tokens)) {
+            return NULL;
+        }
+
+        Parser p(tokens);
+        std::string name;
+        std::string obj;
+        std::string prev;
+        if (!p.keyword("function")) {
+            return NULL;
+        }
+        p.ident(&name);
+        if (!p.punct("(") || !p.ident(&obj) || !p.punct(",") || !p.ident(&prev) ||
+                !p.punct(")") || !p.punct("{") || obj == prev) {
+            return NULL;
+        }
+
+        std::auto_ptr<NativeGroupReducer> reducer(new NativeGroupReducer(initial));
+        std::set<std::string> fields;
+        while (!p.punct("}")) {
+            Step step;
+            step.op = Step::kAdd;
+            step.constant = 0;
+
+            std::string other;
+            if (p.punct("++")) {
+                if (!p.member(prev, &step.field)) {
+                    return NULL;
+                }
+                step.constant = 1;
+            }
+            else if (!p.member(prev, &step.field)) {
+                return NULL;
+            }
+            else if (p.punct("++")) {
+                step.constant = 1;
+            }
+            else if (p.punct("+=")) {
+                if (!p.member(obj, &step.input) && !p.number(&step.constant)) {
+                    return NULL;
+                }
+            }
+            else if (!p.punct("=")) {
+                return NULL;
+            }
+            else if (p.keyword("Math")) {
+                std::string fn;
+                if (!p.punct(".") || !p.ident(&fn) || (fn != "min" && fn != "max") ||
+                        !p.punct("(")) {
+                    return NULL;
+                }
+                step.op = fn == "min" ? Step::kMin : Step::kMax;
+                const bool ok = p.member(prev, &other)
+                    ? p.punct(",") && p.member(obj, &step.input)
+                    : p.member(obj, &step.input) && p.punct(",") && p.member(prev, &other);
+                if (!ok || !p.punct(")") || other != step.field) {
+                    return NULL;
+                }
+            }
+            else if (p.member(prev, &other)) {
+                // prev.f = prev.f + <operand>
+                if (other != step.field || !p.punct("+") ||
+                        (!p.member(obj, &step.input) && !p.number(&step.constant))) {
+                    return NULL;
+                }
+            }
+            else {
+                // prev.f = <operand> + prev.f
+                if ((!p.member(obj, &step.input) && !p.number(&step.constant)) ||
+                        !p.punct("+") || !p.member(prev, &other) || other != step.field) {
+                    return NULL;
+                }
+            }
+
+            if (!fields.insert(step.field).second || !isJsNumber(initial[step.field])) {
+                return NULL;
+            }
+            reducer->_steps.push_back(step);
+
+            while (p.punct(";")) {
+            }
+        }
+
+        if (!p.done() || reducer->_steps.empty()) {
+            return NULL;
+        }
+
+        BSONForEach(elem, initial) {
+            if (!isPlainValue(elem)) {
+                return NULL;
+            }
+        }
+        return reducer.release();
+    }
+
+    // static
+    bool NativeGroupReducer::canRenderKey(const BSONObj& key) {
+        BSONForEach(elem, key) {
+            if (!isPlainValue(elem)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<double> NativeGroupReducer::initialState() const {
+        std::vector<double> state;
+        for (size_t i = 0; i < _steps.size(); i++) {
+            state.push_back(_initial[_steps[i].field].numberDouble());
+        }
+        return state;
+    }
+
+    bool NativeGroupReducer::process(const BSONObj& doc, std::vector<double>* state) const {
+        // Work out every input before changing anything, so that a refused document leaves the
+        // state as it was.
+        double inputs[16];
+        std::vector<double> moreInputs;
+        double* values = inputs;
+        if (_steps.size() > sizeof(inputs) / sizeof(inputs[0])) {
+            moreInputs.resize(_steps.size());
+            values = &moreInputs[0];
+        }
+
+        for (size_t i = 0; i < _steps.size(); i++) {
+            const Step& step = _steps[i];
+            if (step.input.empty()) {
+                values[i] = step.constant;
+                continue;
+            }
+
+            const BSONElement elem = doc[step.input];
+            switch (elem.type()) {
+            case EOO:
+            case Undefined:
+                values[i] = std::numeric_limits<double>::quiet_NaN();
+                break;
+            case jstNULL:
+                values[i] = 0;
+                break;
+            case Bool:
+                values[i] = elem.boolean() ? 1 : 0;
+                break;
+            case NumberInt:
+            case NumberDouble:
+            case NumberLong:
+                values[i] = elem.numberDouble();
+                break;
+            default:
+                return false;
+            }
+        }
+
+        for (size_t i = 0; i < _steps.size(); i++) {
+            double& value = (*state)[i];
+            switch (_steps[i].op) {
+            case Step::kAdd: value += values[i]; break;
+            case Step::kMin: value = jsMin(value, values[i]); break;
+            case Step::kMax: value = jsMax(value, values[i]); break;
+            }
+        }
+        return true;
+    }
+
+    void NativeGroupReducer::appendResult(const BSONObj& key,
+                                          const std::vector<double>& state,
+                                          BSONObjBuilder* builder) const {
+        // As Object.extend(next, $key) followed by Object.extend(next, $initial): the initial
+        // object's fields replace those of the key in place, and come after them otherwise.
+        BSONForEach(elem, key) {
+            const StringData name = elem.fieldNameStringData();
+            const int step = _stepFor(name);
+            if (step >= 0) {
+                builder->append(name, state[step]);
+            }
+            else if (_initial.hasField(name)) {
+                _appendJsValue(_initial[name], name, builder);
+            }
+            else {
+                _appendJsValue(elem, name, builder);
+            }
+        }
+
+        BSONForEach(elem, _initial) {
+            const StringData name = elem.fieldNameStringData();
+            if (key.hasField(name)) {
+                continue;
+            }
+            const int step = _stepFor(name);
+            if (step >= 0) {
+                builder->append(name, state[step]);
+            }
+            else {
+                _appendJsValue(elem, name, builder);
+            }
+        }
+    }
+
+    int NativeGroupReducer::_stepFor(const StringData& field) const {
+        for (size_t i = 0; i < _steps.size(); i++) {
+            if (_steps[i].field == field) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    // static
+    void NativeGroupReducer::_appendJsValue(const BSONElement& elem,
+                                            const StringData& name,
+                                            BSONObjBuilder* builder) {
+        if (elem.type() == NumberInt || elem.type() == NumberDouble) {
+            builder->append(name, elem.numberDouble());
+        }
+        else {
+            builder->appendAs(elem, name);
+        }
+    }
+
+} // namespace mongo
@@ -0,0 +1,115 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    /**
+     * A group command reduce function simple enough to be run without JavaScript, such as
+     *
+     *     function(obj, prev) { prev.count++; prev.total += obj.qty; }
+     *
+     * Each statement of the function updates its own numeric field of 'prev' from a constant or
+     * from a top level field of 'obj', in one of these forms:
+     *
+     *     prev.f++   ++prev.f   prev.f += <n|obj.g>   prev.f = prev.f + <n|obj.g>
+     *     prev.f = <n|obj.g> + prev.f   prev.f = Math.min(prev.f, obj.g)   (or max, either order)
+     *
+     * The results are the ones the JavaScript function would give: numbers are doubles, a
+     * missing input makes the field NaN and null counts as 0.  Inputs for which JavaScript would
+     * do something else, such as concatenating strings, are refused by process() so that the
+     * caller can go on in JavaScript from the state accumulated so far.
+     */
+    class NativeGroupReducer {
+        MONGO_DISALLOW_COPYING(NativeGroupReducer);
+    public:
+        /**
+         * Returns a reducer for 'reduceCode', or NULL if the function is not of a recognized form
+         * or 'initial' does not give a number to start each field it updates from.  The caller
+         * owns the result.
+         */
+        static NativeGroupReducer* parse(const std::string& reduceCode, const BSONObj& initial);
+
+        /**
+         * Returns true if a group with 'key' can be output as JavaScript would.
+         */
+        static bool canRenderKey(const BSONObj& key);
+
+        /**
+         * The state of a new group.
+         */
+        std::vector<double> initialState() const;
+
+        /**
+         * Adds 'doc' to 'state'.  Returns false, leaving 'state' as it was, if 'doc' has an input
+         * of a type the reducer cannot treat as JavaScript would.
+         */
+        bool process(const BSONObj& doc, std::vector<double>* state) const;
+
+        /**
+         * Appends the result of the group to 'builder': the key fields then those of the initial
+         * object, the updated fields taking their values from 'state'.
+         */
+        void appendResult(const BSONObj& key,
+                          const std::vector<double>& state,
+                          BSONObjBuilder* builder) const;
+
+    private:
+        struct Step {
+            enum Op { kAdd, kMin, kMax };
+
+            Op op;
+
+            // Field of the group result updated by this step
+            std::string field;
+
+            // Field of the input document, or empty to add 'constant' instead
+            std::string input;
+            double constant;
+        };
+
+        explicit NativeGroupReducer(const BSONObj& initial) : _initial(initial.getOwned()) {}
+
+        int _stepFor(const StringData& field) const;
+
+        static void _appendJsValue(const BSONElement& elem,
+                                   const StringData& name,
+                                   BSONObjBuilder* builder);
+
+        std::vector<Step> _steps;
+        BSONObj _initial;
+    };
+
+} // namespace mongo
@@ -0,0 +1,165 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/group_native_reduce.h"
+
+#include <boost/scoped_ptr.hpp>
+
+#include "mongo/db/json.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+    using boost::scoped_ptr;
+
+    BSONObj reduceAll(const std::string& code,
+                      const BSONObj& initial,
+                      const BSONObj& key,
+                      const std::vector<BSONObj>& docs) {
+        scoped_ptr<NativeGroupReducer> reducer(NativeGroupReducer::parse(code, initial));
+        ASSERT(reducer);
+        std::vector<double> state = reducer->initialState();
+        for (size_t i = 0; i < docs.size(); i++) {
+            ASSERT(reducer->process(docs[i], &state));
+        }
+        BSONObjBuilder result;
+        reducer->appendResult(key, state, &result);
+        return result.obj();
+    }
+
+    TEST(NativeGroupReducer, RecognizesCommonReducers) {
+        const BSONObj initial = BSON("n" << 0 << "total" << 0 << "lo" << 1e9 << "hi" << -1e9);
+        const char* reducers[] = {
+            "function(obj, prev) { prev.n++; }",
+            "function (doc, out) { ++out.n; out.total += doc.qty }",
+            "function f(o, p) {\n  p.n += 1;\n  p.total = p.total + o.qty;\n}",
+            "function(o, p) { p.total = o.qty + p.total; // sum\n }",
+            "function(o, p) { p.lo = Math.min(p.lo, o.qty); p.hi = Math.max(o.qty, p.hi); }",
+        };
+        for (size_t i = 0; i < sizeof(reducers) / sizeof(reducers[0]); i++) {
+            scoped_ptr<NativeGroupReducer> reducer(NativeGroupReducer::parse(reducers[i],
+                                                                             initial));
+            ASSERT(reducer);
+        }
+    }
+
+    TEST(NativeGroupReducer, RefusesOtherFunctions) {
+        const BSONObj initial = BSON("n" << 0 << "s" << "x" << "total" << 0);
+        const char* reducers[] = {
+            "function(obj, prev) { prev.n++; prev.n++; }",
+            "function(obj, prev) { prev.missing++; }",
+            "function(obj, prev) { prev.s++; }",
+            "function(obj, prev) { prev.total += obj.a.b; }",
+            "function(obj, prev) { prev.total += prev.n; }",
+            "function(obj, prev) { prev.total = obj.qty; }",
+            "function(obj, prev) { if (obj.qty) prev.n++; }",
+            "function(obj, prev) { prev.n += 'a'; }",
+            "function(obj, obj) { obj.n++; }",
+            "function(obj, prev) { }",
+            "function(obj, prev) { prev.n++; } x",
+        };
+        for (size_t i = 0; i < sizeof(reducers) / sizeof(reducers[0]); i++) {
+            scoped_ptr<NativeGroupReducer> reducer(NativeGroupReducer::parse(reducers[i],
+                                                                             initial));
+            ASSERT(!reducer);
+        }
+
+        // The result must come back from JavaScript the same way.
+        scoped_ptr<NativeGroupReducer> reducer(
+            NativeGroupReducer::parse("function(obj, prev) { prev.n++; }",
+                                      BSON("n" << 0 << "tags" << BSONArray())));
+        ASSERT(!reducer);
+    }
+
+    TEST(NativeGroupReducer, ResultsMatchJavaScript) {
+        std::vector<BSONObj> docs;
+        docs.push_back(fromjson("{a: 1, qty: 5}"));
+        docs.push_back(fromjson("{a: 1, qty: 2.5}"));
+        docs.push_back(fromjson("{a: 1, qty: null}"));
+        docs.push_back(fromjson("{a: 1, qty: true}"));
+
+        const BSONObj result = reduceAll(
+            "function(obj, prev) { prev.count++; prev.total += obj.qty; "
+            "prev.lo = Math.min(prev.lo, obj.qty); }",
+            BSON("count" << 0 << "total" << 0 << "lo" << 100 << "label" << "x"
+                         << "big" << 7LL),
+            BSON("a" << 1),
+            docs);
+
+        // Key fields first, numbers as doubles.
+        ASSERT_EQUALS(fromjson("{a: 1.0, count: 4.0, total: 8.5, lo: 0.0, label: 'x', big: 7}"),
+                      result);
+        ASSERT_EQUALS(NumberDouble, result["a"].type());
+        ASSERT_EQUALS(NumberDouble, result["count"].type());
+        ASSERT_EQUALS(NumberLong, result["big"].type());
+    }
+
+    TEST(NativeGroupReducer, MissingInputIsNaN) {
+        std::vector<BSONObj> docs;
+        docs.push_back(fromjson("{qty: 1}"));
+        docs.push_back(fromjson("{other: 1}"));
+        docs.push_back(fromjson("{qty: 1}"));
+
+        const BSONObj result = reduceAll("function(obj, prev) { prev.total += obj.qty; }",
+                                         BSON("total" << 0),
+                                         BSONObj(),
+                                         docs);
+        const double total = result["total"].numberDouble();
+        ASSERT(total != total);
+    }
+
+    TEST(NativeGroupReducer, RefusesInputsJavaScriptTreatsDifferently) {
+        scoped_ptr<NativeGroupReducer> reducer(
+            NativeGroupReducer::parse("function(obj, prev) { prev.n++; prev.total += obj.qty; }",
+                                      BSON("n" << 0 << "total" << 0)));
+        ASSERT(reducer);
+        std::vector<double> state = reducer->initialState();
+        ASSERT(reducer->process(BSON("qty" << 2), &state));
+        ASSERT_FALSE(reducer->process(BSON("qty" << "3"), &state));
+
+        // The refused document changed nothing.
+        ASSERT_EQUALS(1.0, state[0]);
+        ASSERT_EQUALS(2.0, state[1]);
+
+        ASSERT(NativeGroupReducer::canRenderKey(BSON("a" << "x" << "b" << 1)));
+        ASSERT_FALSE(NativeGroupReducer::canRenderKey(BSON("a" << BSON("b" << 1))));
+    }
+
+    TEST(NativeGroupReducer, InitialFieldsReplaceKeyFields) {
+        const BSONObj result = reduceAll("function(obj, prev) { prev.n++; }",
+                                         BSON("n" << 10 << "a" << "initial"),
+                                         BSON("a" << "key" << "n" << 99 << "b" << 2),
+                                         std::vector<BSONObj>(1, BSONObj()));
+        ASSERT_EQUALS(BSON("a" << "initial" << "n" << 11.0 << "b" << 2.0), result);
+    }
+
+} // namespace
+} // namespace mongo
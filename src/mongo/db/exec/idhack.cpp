@@ -88,7 +88,7 @@ namespace mongo {
         ++_commonStats.works;
 
         // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        ScopedTimer timer(&_commonStats);
 
         if (_done) { return PlanStage::IS_EOF; }
 
@@ -97,6 +97,7 @@ namespace mongo {
             _idBeingPagedIn = WorkingSet::INVALID_ID;
             WorkingSetMember* member = _workingSet->get(id);
 
+            ++_commonStats.storageCursorOps;
             WorkingSetCommon::completeFetch(_txn, member, _collection);
 
             return advance(id, member, out);
@@ -117,6 +118,7 @@ namespace mongo {
             static_cast<const BtreeBasedAccessMethod*>(catalog->getIndex(idDesc));
 
         // Look up the key by going directly to the Btree.
+        ++_commonStats.storageCursorOps;
         RecordId loc = accessMethod->findSingle(_txn, _key);
 
         // Key not found.
@@ -147,6 +149,7 @@ namespace mongo {
         }
 
         // The doc was already in memory, so we go ahead and return it.
+        ++_commonStats.storageCursorOps;
         member->obj = _collection->docFor(_txn, member->loc);
         return advance(id, member, out);
     }
@@ -30,6 +30,9 @@
 
 #include "mongo/db/exec/index_scan.h"
 
+#include <algorithm>
+#include <functional>
+
 #include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_computed_data.h"
@@ -65,6 +68,7 @@ namespace mongo {
           _shouldDedup(true),
           _params(params),
           _btreeCursor(NULL),
+          _nextPoint(0),
           _commonStats(kStageType) {
         _iam = _params.descriptor->getIndexCatalog()->getIndex(_params.descriptor);
         _keyPattern = _params.descriptor->keyPattern().getOwned();
@@ -89,6 +93,14 @@ namespace mongo {
             _shouldDedup = _params.descriptor->isMultikey(_txn);
         }
 
+        // A single point which the index can look up without a cursor, such as an equality on a
+        // hashed index held in a hash table, needs neither a cursor nor deduping: the index has
+        // at most one entry for each RecordId under one key.
+        if (lookUpPoint()) {
+            _scanState = RETURNING_POINTS;
+            return;
+        }
+
         // Set up the index cursor.
         CursorOptions cursorOptions;
 
@@ -106,6 +118,7 @@ namespace mongo {
 
         if (_params.bounds.isSimpleRange) {
             // Start at one key, end at another.
+            ++_commonStats.storageCursorOps;
             Status status = _indexCursor->seek(_params.bounds.startKey);
             if (!status.isOK()) {
                 warning() << "IndexCursor seek failed: " << status.toString();
@@ -128,6 +141,7 @@ namespace mongo {
             key.resize(nFields);
             inc.resize(nFields);
             if (_checker->getStartKey(&key, &inc)) {
+                ++_commonStats.storageCursorOps;
                 _btreeCursor->seek(key, inc);
                 _keyElts.resize(nFields);
                 _keyEltsInc.resize(nFields);
@@ -150,8 +164,35 @@ namespace mongo {
         ++_commonStats.works;
 
         // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        ScopedTimer timer(&_commonStats);
+
+        return doWork(out);
+    }
+
+    PlanStage::StageState IndexScan::workBatch(size_t maxWorks,
+                                               std::vector<WorkingSetID>* out,
+                                               WorkingSetID* id) {
+        // One timer for the whole batch rather than one per key.
+        ScopedTimer timer(&_commonStats);
 
+        for (size_t i = 0; i < maxWorks; ++i) {
+            ++_commonStats.works;
+
+            WorkingSetID next = WorkingSet::INVALID_ID;
+            StageState state = doWork(&next);
+            if (PlanStage::ADVANCED == state) {
+                out->push_back(next);
+            }
+            else if (PlanStage::NEED_TIME != state) {
+                *id = next;
+                return state;
+            }
+        }
+
+        return PlanStage::NEED_TIME;
+    }
+
+    PlanStage::StageState IndexScan::doWork(WorkingSetID* out) {
         if (INITIALIZING == _scanState) {
             invariant(NULL == _indexCursor.get());
             initIndexScan();
@@ -166,28 +207,38 @@ namespace mongo {
             return PlanStage::IS_EOF;
         }
 
+        if (RETURNING_POINTS == _scanState) {
+            return returnPoint(out);
+        }
+
         if (GETTING_NEXT == _scanState) {
             // Grab the next (key, value) from the index.
             BSONObj keyObj = _indexCursor->getKey();
             RecordId loc = _indexCursor->getValue();
 
             bool filterPasses = Filter::passes(keyObj, _keyPattern, _filter);
+            WorkingSetID id = WorkingSet::INVALID_ID;
             if ( filterPasses ) {
                 // We must make a copy of the on-disk data since it can mutate during the execution
-                // of this query.
-                keyObj = keyObj.getOwned();
+                // of this query.  The copy goes into the key buffer of the member we will return.
+                id = _workingSet->allocate();
+                keyObj = _workingSet->get(id)->copyKey(keyObj);
             }
 
             // Move to the next result.
             // The underlying IndexCursor points at the *next* thing we want to return.  We do this
             // so that if we're scanning an index looking for docs to delete we don't continually
             // clobber the thing we're pointing at.
+            ++_commonStats.storageCursorOps;
             _indexCursor->next();
             _scanState = CHECKING_END;
 
             if (_shouldDedup) {
                 ++_specificStats.dupsTested;
                 if (_returned.end() != _returned.find(loc)) {
+                    if (WorkingSet::INVALID_ID != id) {
+                        _workingSet->free(id);
+                    }
                     ++_specificStats.dupsDropped;
                     ++_commonStats.needTime;
                     return PlanStage::NEED_TIME;
@@ -203,7 +254,6 @@ namespace mongo {
                 }
 
                 // Fill out the WSM.
-                WorkingSetID id = _workingSet->allocate();
                 WorkingSetMember* member = _workingSet->get(id);
                 member->loc = loc;
                 member->keyData.push_back(IndexKeyDatum(_keyPattern, keyObj));
@@ -238,14 +288,80 @@ namespace mongo {
             }
         }
 
+        if (RETURNING_POINTS == _scanState) {
+            return _nextPoint >= _pointLocs.size();
+        }
+
         return HIT_END == _scanState || _indexCursor->isEOF();
     }
 
+    bool IndexScan::lookUpPoint() {
+        if (_params.bounds.isSimpleRange || _params.bounds.fields.empty()) {
+            return false;
+        }
+
+        BSONObjBuilder keyBob;
+        for (size_t i = 0; i < _params.bounds.fields.size(); ++i) {
+            const vector<Interval>& intervals = _params.bounds.fields[i].intervals;
+            if (1 != intervals.size() || !intervals[0].isPoint()) {
+                return false;
+            }
+            keyBob.appendAs(intervals[0].start, "");
+        }
+
+        BSONObj key = keyBob.obj();
+        vector<RecordId> locs;
+        if (!_iam->findExactKey(_txn, key, &locs)) {
+            return false;
+        }
+
+        if (-1 == _params.direction) {
+            std::reverse(locs.begin(), locs.end());
+        }
+
+        _pointKey = key;
+        _pointLocs.swap(locs);
+        _nextPoint = 0;
+        return true;
+    }
+
+    PlanStage::StageState IndexScan::returnPoint(WorkingSetID* out) {
+        const RecordId loc = _pointLocs[_nextPoint++];
+        ++_specificStats.keysExamined;
+
+        if (!Filter::passes(_pointKey, _keyPattern, _filter)) {
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+
+        if (NULL != _filter) {
+            ++_specificStats.matchTested;
+        }
+
+        // _pointKey is owned and never changes, so every member can share it.
+        WorkingSetID id = _workingSet->allocate();
+        WorkingSetMember* member = _workingSet->get(id);
+        member->loc = loc;
+        member->keyData.push_back(IndexKeyDatum(_keyPattern, _pointKey));
+        member->state = WorkingSetMember::LOC_AND_IDX;
+
+        if (_params.addKeyMetadata) {
+            BSONObjBuilder bob;
+            bob.appendKeys(_keyPattern, _pointKey);
+            member->addComputed(new IndexKeyComputedData(bob.obj()));
+        }
+
+        *out = id;
+        ++_commonStats.advanced;
+        return PlanStage::ADVANCED;
+    }
+
     void IndexScan::saveState() {
         _txn = NULL;
         ++_commonStats.yields;
 
         if (HIT_END == _scanState || INITIALIZING == _scanState) { return; }
+        if (RETURNING_POINTS == _scanState) { return; }
         if (!_indexCursor->isEOF()) {
             _savedKey = _indexCursor->getKey().getOwned();
             _savedLoc = _indexCursor->getValue();
@@ -260,8 +376,36 @@ namespace mongo {
 
         if (HIT_END == _scanState || INITIALIZING == _scanState) { return; }
 
+        if (RETURNING_POINTS == _scanState) {
+            // The point's entries may have changed while we yielded, including by deletions of
+            // RecordIds we still hold. Look it up again and go on after the last one returned.
+            vector<RecordId> locs;
+            const bool found = _iam->findExactKey(_txn, _pointKey, &locs);
+            invariant(found);
+
+            if (1 == _params.direction) {
+                if (_nextPoint > 0) {
+                    locs.erase(locs.begin(), std::upper_bound(locs.begin(), locs.end(),
+                                                              _pointLocs[_nextPoint - 1]));
+                }
+            }
+            else {
+                std::reverse(locs.begin(), locs.end());
+                if (_nextPoint > 0) {
+                    locs.erase(locs.begin(), std::upper_bound(locs.begin(), locs.end(),
+                                                              _pointLocs[_nextPoint - 1],
+                                                              std::greater<RecordId>()));
+                }
+            }
+
+            _pointLocs.swap(locs);
+            _nextPoint = 0;
+            return;
+        }
+
         // We can have a valid position before we check isEOF(), restore the position, and then be
         // EOF upon restore.
+        ++_commonStats.storageCursorOps;
         if (!_indexCursor->restorePosition( opCtx ).isOK() || _indexCursor->isEOF()) {
             _scanState = HIT_END;
             return;
@@ -347,6 +491,7 @@ namespace mongo {
             }
 
             verify(IndexBoundsChecker::MUST_ADVANCE == keyState);
+            ++_commonStats.storageCursorOps;
             _btreeCursor->skip(_indexCursor->getKey(), _keyEltsToUse, _movePastKeyElts,
                                _keyElts, _keyEltsInc);
 
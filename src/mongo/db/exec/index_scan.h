@@ -95,6 +95,9 @@ namespace mongo {
             // Retrieving the next key, and applying the filter if necessary.
             GETTING_NEXT,
 
+            // Returning the RecordIds which the index found for a single point, without a cursor.
+            RETURNING_POINTS,
+
             // The index scan is finished.
             HIT_END
         };
@@ -107,6 +110,10 @@ namespace mongo {
         virtual ~IndexScan() { }
 
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks,
+                                     std::vector<WorkingSetID>* out,
+                                     WorkingSetID* id);
+        virtual bool supportsBatch() const { return true; }
         virtual bool isEOF();
         virtual void saveState();
         virtual void restoreState(OperationContext* opCtx);
@@ -125,6 +132,12 @@ namespace mongo {
         static const char* kStageType;
 
     private:
+        /**
+         * Does one unit of work without touching the 'works' counter or the execution timer,
+         * which work() and workBatch() account for themselves.
+         */
+        StageState doWork(WorkingSetID* out);
+
         /**
          * Initialize the underlying IndexCursor, grab information from the catalog for stats.
          */
@@ -133,6 +146,15 @@ namespace mongo {
         /** See if the cursor is pointing at or past _endKey, if _endKey is non-empty. */
         void checkEnd();
 
+        /**
+         * If the bounds are a single point and the index can look it up directly, fetch its
+         * RecordIds into _pointLocs in scan order and return true.
+         */
+        bool lookUpPoint();
+
+        /** Return the next RecordId of _pointLocs. */
+        StageState returnPoint(WorkingSetID* out);
+
         // transactional context for read locks. Not owned by us
         OperationContext* _txn;
 
@@ -170,6 +192,11 @@ namespace mongo {
         std::vector<const BSONElement*> _keyElts;
         std::vector<bool> _keyEltsInc;
 
+        // For RETURNING_POINTS: the point the bounds are, and what the index holds for it.
+        BSONObj _pointKey;
+        std::vector<RecordId> _pointLocs;
+        size_t _nextPoint;
+
         // Stats
         CommonStats _commonStats;
         IndexScanStats _specificStats;
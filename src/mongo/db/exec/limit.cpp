@@ -28,6 +28,8 @@
 
 #include "mongo/db/exec/limit.h"
 
+#include <algorithm>
+
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/util/mongoutils/str.h"
@@ -48,7 +50,7 @@ namespace mongo {
         ++_commonStats.works;
 
         // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        ScopedTimer timer(&_commonStats);
 
         if (0 == _numToReturn) {
             // We've returned as many results as we're limited to.
@@ -88,6 +90,51 @@ namespace mongo {
         return status;
     }
 
+    PlanStage::StageState LimitStage::workBatch(size_t maxWorks,
+                                                std::vector<WorkingSetID>* out,
+                                                WorkingSetID* id) {
+        // Adds the amount of time taken by the batch to executionTimeMillis.
+        ScopedTimer timer(&_commonStats);
+
+        if (0 == _numToReturn) {
+            // We've returned as many results as we're limited to.
+            ++_commonStats.works;
+            return PlanStage::IS_EOF;
+        }
+
+        // Never let the child produce more results than we may return.
+        const size_t childWorks = std::min(maxWorks, static_cast<size_t>(_numToReturn));
+
+        const size_t childWorksBefore = _child->getCommonStats()->works;
+        const size_t firstResult = out->size();
+        StageState status = _child->workBatch(childWorks, out, id);
+        _commonStats.works += _child->getCommonStats()->works - childWorksBefore;
+
+        const size_t numAdvanced = out->size() - firstResult;
+        _numToReturn -= numAdvanced;
+        _commonStats.advanced += numAdvanced;
+
+        if (PlanStage::FAILURE == status) {
+            // If a stage fails, it may create a status WSM to indicate why it
+            // failed, in which case 'id' is valid.  If ID is invalid, we
+            // create our own error message.
+            if (WorkingSet::INVALID_ID == *id) {
+                mongoutils::str::stream ss;
+                ss << "limit stage failed to read in results from child";
+                Status status(ErrorCodes::InternalError, ss);
+                *id = WorkingSetCommon::allocateStatusMember( _ws, status);
+            }
+        }
+        else if (PlanStage::NEED_TIME == status) {
+            ++_commonStats.needTime;
+        }
+        else if (PlanStage::NEED_FETCH == status) {
+            ++_commonStats.needFetch;
+        }
+
+        return status;
+    }
+
     void LimitStage::saveState() {
         ++_commonStats.yields;
         _child->saveState();
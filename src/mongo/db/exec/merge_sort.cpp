@@ -69,7 +69,7 @@ namespace mongo {
         ++_commonStats.works;
 
         // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        ScopedTimer timer(&_commonStats);
 
         if (isEOF()) { return PlanStage::IS_EOF; }
 
@@ -93,7 +93,8 @@ namespace mongo {
                     else {
                         ++_specificStats.dupsTested;
                         // ...and there's a diskloc and and we've seen the RecordId before
-                        if (_seen.end() != _seen.find(member->loc)) {
+                        // (otherwise we note now that we've seen it)...
+                        if (!_seen.add(member->loc)) {
                             // ...drop it.
                             _ws->free(id);
                             ++_commonStats.needTime;
@@ -101,8 +102,6 @@ namespace mongo {
                             return PlanStage::NEED_TIME;
                         }
                         else {
-                            // Otherwise, note that we've seen it.
-                            _seen.insert(member->loc);
                             // We're going to use the result from the child, so we remove it from
                             // the queue of children without a result.
                             _noResultToMerge.pop();
@@ -223,7 +222,7 @@ namespace mongo {
 
         // If we see DL again it is not the same record as it once was so we still want to
         // return it.
-        if (_dedup) { _seen.erase(dl); }
+        if (_dedup) { _seen.remove(dl); }
     }
 
     // Is lhs less than rhs?  Note that priority_queue is a max heap by default so we invert
@@ -33,6 +33,7 @@
 #include <vector>
 
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/record_id_bitmap.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/record_id.h"
@@ -94,8 +95,9 @@ namespace mongo {
         // Are we deduplicating on RecordId?
         bool _dedup;
 
-        // Which RecordIds have we seen?
-        unordered_set<RecordId, RecordId::Hasher> _seen;
+        // Which RecordIds have we seen?  A compressed bitmap, since a wide merge can return
+        // millions of them.
+        RecordIdBitmap _seen;
 
         // Owned by us.  All the children we're reading from.
         std::vector<PlanStage*> _children;
@@ -35,13 +35,17 @@
 
 namespace mongo {
 
+    // static
+    const char* MultiIteratorStage::kStageType = "MULTI_ITERATOR";
+
     MultiIteratorStage::MultiIteratorStage(OperationContext* txn,
                                            WorkingSet* ws,
                                            Collection* collection)
         : _txn(txn),
           _collection(collection),
           _ws(ws),
-          _wsidForFetch(_ws->allocate()) {
+          _wsidForFetch(_ws->allocate()),
+          _commonStats(kStageType) {
         // We pre-allocate a WSM and use it to pass up fetch requests. This should never be used
         // for anything other than passing up NEED_FETCH. We use the loc and unowned obj state, but
         // the loc isn't really pointing at any obj. The obj field of the WSM should never be used.
@@ -54,6 +58,7 @@ namespace mongo {
     }
 
     PlanStage::StageState MultiIteratorStage::work(WorkingSetID* out) {
+        ++_commonStats.works;
         if ( _collection == NULL )
             return PlanStage::DEAD;
 
@@ -69,6 +74,7 @@ namespace mongo {
                     // Pass the RecordFetcher off to the WSM on which we're performing the fetch.
                     member->setFetcher(fetcher.release());
                     *out = _wsidForFetch;
+                    ++_commonStats.needFetch;
                     return NEED_FETCH;
                 }
             }
@@ -83,6 +89,7 @@ namespace mongo {
         member->loc = next;
         member->obj = _collection->docFor(_txn, next);
         member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+        ++_commonStats.advanced;
         return PlanStage::ADVANCED;
     }
 
@@ -96,6 +103,7 @@ namespace mongo {
     }
 
     void MultiIteratorStage::saveState() {
+        ++_commonStats.yields;
         _txn = NULL;
         for (size_t i = 0; i < _iterators.size(); i++) {
             _iterators[i]->saveState();
@@ -104,6 +112,7 @@ namespace mongo {
 
     void MultiIteratorStage::restoreState(OperationContext* opCtx) {
         invariant(_txn == NULL);
+        ++_commonStats.unyields;
         _txn = opCtx;
         for (size_t i = 0; i < _iterators.size(); i++) {
             if (!_iterators[i]->restoreState(opCtx)) {
@@ -115,6 +124,7 @@ namespace mongo {
     void MultiIteratorStage::invalidate(OperationContext* txn,
                                         const RecordId& dl,
                                         InvalidationType type) {
+        ++_commonStats.invalidates;
         switch ( type ) {
         case INVALIDATION_DELETION:
             for (size_t i = 0; i < _iterators.size(); i++) {
@@ -132,6 +142,15 @@ namespace mongo {
         return empty;
     }
 
+    PlanStageStats* MultiIteratorStage::getStats() {
+        _commonStats.isEOF = isEOF();
+        return new PlanStageStats(_commonStats, STAGE_MULTI_ITERATOR);
+    }
+
+    const CommonStats* MultiIteratorStage::getCommonStats() {
+        return &_commonStats;
+    }
+
     RecordId MultiIteratorStage::_advance() {
         while (!_iterators.empty()) {
             RecordId out = _iterators.back()->getNext();
@@ -64,18 +64,18 @@ namespace mongo {
 
         virtual void invalidate(OperationContext* txn, const RecordId& dl, InvalidationType type);
 
-        //
-        // These should not be used.
-        //
-
-        virtual PlanStageStats* getStats() { return NULL; }
-        virtual CommonStats* getCommonStats() { return NULL; }
-        virtual SpecificStats* getSpecificStats() { return NULL; }
+        // Returns only the common stats, for explaining the aggregations which read through
+        // this stage.
+        virtual PlanStageStats* getStats();
+        virtual const CommonStats* getCommonStats();
+        virtual const SpecificStats* getSpecificStats() { return NULL; }
 
         virtual std::vector<PlanStage*> getChildren() const;
 
         virtual StageType stageType() const { return STAGE_MULTI_ITERATOR; }
 
+        static const char* kStageType;
+
     private:
 
         /**
@@ -93,6 +93,8 @@ namespace mongo {
         // We allocate a working set member with this id on construction of the stage. It gets
         // used for all fetch requests, changing the RecordId as appropriate.
         const WorkingSetID _wsidForFetch;
+
+        CommonStats _commonStats;
     };
 
 } // namespace mongo
@@ -0,0 +1,372 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/oplog_scan.h"
+
+#include <cstring>
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/exec/filter.h"
+#include "mongo/db/exec/scoped_timer.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/db/storage/record_fetcher.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+
+    using std::auto_ptr;
+    using std::string;
+    using std::vector;
+
+    // static
+    const char* OplogScan::kStageType = "OPLOG_SCAN";
+
+    // static
+    const size_t OplogScan::kMaxSkippedPerWork;
+
+    OplogScan::OplogScan(OperationContext* txn,
+                         const CollectionScanParams& params,
+                         WorkingSet* workingSet,
+                         const MatchExpression* filter)
+        : _txn(txn),
+          _workingSet(workingSet),
+          _filter(filter),
+          _params(params),
+          _isDead(false),
+          _wsidForFetch(_workingSet->allocate()),
+          _commonStats(kStageType) {
+        invariant(CollectionScanParams::FORWARD == params.direction);
+
+        WorkingSetMember* member = _workingSet->get(_wsidForFetch);
+        member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+
+        if (NULL != _filter) {
+            RawFieldFilter rawFilter;
+            if (MatchExpression::AND == _filter->matchType()) {
+                for (size_t i = 0; i < _filter->numChildren(); ++i) {
+                    if (extractRawFieldFilter(_filter->getChild(i), &rawFilter)) {
+                        _rawFilters.push_back(rawFilter);
+                    }
+                }
+            }
+            else if (extractRawFieldFilter(_filter, &rawFilter)) {
+                _rawFilters.push_back(rawFilter);
+            }
+        }
+    }
+
+    // static
+    bool OplogScan::extractRawFieldFilter(const MatchExpression* expr, RawFieldFilter* out) {
+        const MatchExpression::MatchType type = expr->matchType();
+        if (MatchExpression::EQ != type && MatchExpression::MATCH_IN != type)
+            return false;
+
+        const StringData path = static_cast<const LeafMatchExpression*>(expr)->path();
+        if (path != "ns" && path != "op")
+            return false;
+
+        out->field = path.toString();
+        out->values.clear();
+
+        if (MatchExpression::EQ == type) {
+            const BSONElement& rhs = static_cast<const EqualityMatchExpression*>(expr)->getData();
+            if (String != rhs.type())
+                return false;
+            out->values.push_back(rhs.String());
+            return true;
+        }
+
+        // A $in matching null also matches a missing field, and a regex any string.
+        const ArrayFilterEntries& entries =
+            static_cast<const InMatchExpression*>(expr)->getData();
+        if (entries.numRegexes() > 0 || entries.hasNull())
+            return false;
+
+        for (BSONElementSet::const_iterator it = entries.equalities().begin();
+             it != entries.equalities().end();
+             ++it) {
+            if (String != it->type())
+                return false;
+            out->values.push_back(it->String());
+        }
+        return !out->values.empty();
+    }
+
+    bool OplogScan::passesRawFilters(const char* data) const {
+        if (_rawFilters.empty())
+            return true;
+
+        // Only the first occurrence of a field is matched, as by BSONObj::getField().
+        std::vector<bool> seen(_rawFilters.size(), false);
+        size_t numSeen = 0;
+
+        BSONObjIterator it((BSONObj(data)));
+        while (it.more() && numSeen < _rawFilters.size()) {
+            const BSONElement elem = it.next();
+            for (size_t i = 0; i < _rawFilters.size(); ++i) {
+                const RawFieldFilter& filter = _rawFilters[i];
+                if (seen[i] || filter.field != elem.fieldName())
+                    continue;
+
+                seen[i] = true;
+                ++numSeen;
+
+                // Anything but a plain string is left to the full filter.
+                if (String != elem.type())
+                    continue;
+
+                const size_t len = elem.valuestrsize() - 1;
+                bool matches = false;
+                for (size_t j = 0; j < filter.values.size() && !matches; ++j) {
+                    matches = filter.values[j].size() == len
+                        && 0 == memcmp(filter.values[j].data(), elem.valuestr(), len);
+                }
+                if (!matches)
+                    return false;
+            }
+        }
+
+        // A missing field can't equal a string.
+        return numSeen == _rawFilters.size();
+    }
+
+    PlanStage::StageState OplogScan::work(WorkingSetID* out) {
+        ++_commonStats.works;
+
+        // Adds the amount of time taken by work() to executionTimeMillis.
+        ScopedTimer timer(&_commonStats);
+
+        return doWork(out);
+    }
+
+    PlanStage::StageState OplogScan::workBatch(size_t maxWorks,
+                                               std::vector<WorkingSetID>* out,
+                                               WorkingSetID* id) {
+        // One timer for the whole batch rather than one per entry.
+        ScopedTimer timer(&_commonStats);
+
+        for (size_t i = 0; i < maxWorks; ++i) {
+            ++_commonStats.works;
+
+            WorkingSetID next = WorkingSet::INVALID_ID;
+            StageState state = doWork(&next);
+            if (PlanStage::ADVANCED == state) {
+                out->push_back(next);
+            }
+            else if (PlanStage::NEED_TIME != state) {
+                *id = next;
+                return state;
+            }
+        }
+
+        return PlanStage::NEED_TIME;
+    }
+
+    PlanStage::StageState OplogScan::doWork(WorkingSetID* out) {
+        if (_isDead) { return PlanStage::DEAD; }
+
+        // Do some init if we haven't already.
+        if (NULL == _iter) {
+            if ( _params.collection == NULL ) {
+                _isDead = true;
+                return PlanStage::DEAD;
+            }
+
+            if (_lastSeenLoc.isNull()) {
+                _iter.reset( _params.collection->getIterator( _txn,
+                                                              _params.start,
+                                                              _params.direction ) );
+            }
+            else {
+                invariant(_params.tailable);
+
+                _iter.reset( _params.collection->getIterator( _txn,
+                                                              _lastSeenLoc,
+                                                              _params.direction ) );
+
+                // Advance _iter past where we were last time, or die as CollectionScan does if
+                // the last entry seen has gone.
+                if (_iter->getNext() != _lastSeenLoc) {
+                    _isDead = true;
+                    return PlanStage::DEAD;
+                }
+            }
+
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+
+        for (size_t skipped = 0; ; ) {
+            if (isEOF())
+                return PlanStage::IS_EOF;
+
+            const RecordId curr = _iter->curr();
+            if (curr.isNull()) {
+                // We just hit EOF
+                if (_params.tailable)
+                    _iter.reset(); // pick up where we left off on the next call to work()
+                return PlanStage::IS_EOF;
+            }
+
+            _lastSeenLoc = curr;
+
+            // See if the entry we're about to access is in memory. If not, pass a fetch request
+            // up, having skipped nothing we can't pick up again.
+            {
+                std::auto_ptr<RecordFetcher> fetcher(
+                    _params.collection->documentNeedsFetch(_txn, curr));
+                if (NULL != fetcher.get()) {
+                    WorkingSetMember* member = _workingSet->get(_wsidForFetch);
+                    member->loc = curr;
+                    // Pass the RecordFetcher off to the WSM.
+                    member->setFetcher(fetcher.release());
+                    *out = _wsidForFetch;
+                    _commonStats.needFetch++;
+                    return NEED_FETCH;
+                }
+            }
+
+            RecordData data = _iter->dataFor(curr);
+            if (!passesRawFilters(data.data())) {
+                ++_specificStats.docsSkipped;
+                invariant(_iter->getNext() == curr);
+                if (++skipped < kMaxSkippedPerWork)
+                    continue;
+
+                // Give the executor a chance to yield.
+                ++_commonStats.needTime;
+                return PlanStage::NEED_TIME;
+            }
+
+            WorkingSetID id = _workingSet->allocate();
+            WorkingSetMember* member = _workingSet->get(id);
+            member->loc = curr;
+            member->obj = data.releaseToBson();
+            member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+
+            // Advance the iterator.
+            invariant(_iter->getNext() == curr);
+
+            ++_specificStats.docsTested;
+            if (Filter::passes(member, _filter)) {
+                *out = id;
+                ++_commonStats.advanced;
+                return PlanStage::ADVANCED;
+            }
+
+            _workingSet->free(id);
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+    }
+
+    bool OplogScan::isEOF() {
+        if ((0 != _params.maxScan)
+                && (_specificStats.docsTested + _specificStats.docsSkipped >= _params.maxScan)) {
+            return true;
+        }
+        if (_isDead) { return true; }
+        if (NULL == _iter) { return false; }
+        if (_params.tailable) { return false; } // tailable cursors can return data later.
+        return _iter->isEOF();
+    }
+
+    void OplogScan::invalidate(OperationContext* txn, const RecordId& dl, InvalidationType type) {
+        ++_commonStats.invalidates;
+
+        // We don't care about mutations since we apply any filters to the result when we
+        // (possibly) return it.
+        if (INVALIDATION_DELETION != type) {
+            return;
+        }
+
+        // Deletions can harm the underlying RecordIterator so we must pass them down.
+        if (NULL != _iter) {
+            _iter->invalidate(dl);
+        }
+
+        if (_params.tailable && dl == _lastSeenLoc) {
+            // Deletes have caught up to the reader, which must not silently miss entries.
+            _isDead = true;
+        }
+    }
+
+    void OplogScan::saveState() {
+        _txn = NULL;
+        ++_commonStats.yields;
+        if (NULL != _iter) {
+            _iter->saveState();
+        }
+    }
+
+    void OplogScan::restoreState(OperationContext* opCtx) {
+        invariant(_txn == NULL);
+        _txn = opCtx;
+        ++_commonStats.unyields;
+        if (NULL != _iter) {
+            if (!_iter->restoreState(opCtx)) {
+                warning() << "Collection dropped or state deleted during yield of OplogScan";
+                _isDead = true;
+            }
+        }
+    }
+
+    vector<PlanStage*> OplogScan::getChildren() const {
+        vector<PlanStage*> empty;
+        return empty;
+    }
+
+    PlanStageStats* OplogScan::getStats() {
+        _commonStats.isEOF = isEOF();
+
+        // Add a BSON representation of the filter to the stats tree, if there is one.
+        if (NULL != _filter) {
+            BSONObjBuilder bob;
+            _filter->toBSON(&bob);
+            _commonStats.filter = bob.obj();
+        }
+
+        auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, STAGE_OPLOG_SCAN));
+        ret->specific.reset(new OplogScanStats(_specificStats));
+        return ret.release();
+    }
+
+    const CommonStats* OplogScan::getCommonStats() {
+        return &_commonStats;
+    }
+
+    const SpecificStats* OplogScan::getSpecificStats() {
+        return &_specificStats;
+    }
+
+}  // namespace mongo
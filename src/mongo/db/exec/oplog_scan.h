@@ -0,0 +1,143 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/db/exec/collection_scan_common.h"
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/record_id.h"
+
+namespace mongo {
+
+    class RecordIterator;
+    class WorkingSet;
+    class OperationContext;
+
+    /**
+     * Reads an oplog forwards from the RecordId provided in params, for oplogReplay queries whose
+     * starting point has already been found by the oplogStartHack or the OplogStart stage.
+     *
+     * Unlike a CollectionScan it looks at the raw bytes of each entry before building a
+     * WorkingSetMember.  If the filter requires the top-level "ns" or "op" field to equal one of a
+     * set of strings, an entry holding some other string there is skipped without being matched,
+     * and up to kMaxSkippedPerWork such entries are skipped per call to work().  A reader tailing
+     * a few namespaces thus moves through the rest of the oplog in large strides.  Entries passing
+     * this pre-filter are still tested against the full filter.
+     *
+     * Preconditions: Valid RecordId, forward direction.
+     */
+    class OplogScan : public PlanStage {
+    public:
+        OplogScan(OperationContext* txn,
+                  const CollectionScanParams& params,
+                  WorkingSet* workingSet,
+                  const MatchExpression* filter);
+
+        virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks,
+                                     std::vector<WorkingSetID>* out,
+                                     WorkingSetID* id);
+        virtual bool supportsBatch() const { return true; }
+        virtual bool isEOF();
+
+        virtual void invalidate(OperationContext* txn, const RecordId& dl, InvalidationType type);
+        virtual void saveState();
+        virtual void restoreState(OperationContext* opCtx);
+
+        virtual std::vector<PlanStage*> getChildren() const;
+
+        virtual StageType stageType() const { return STAGE_OPLOG_SCAN; }
+
+        virtual PlanStageStats* getStats();
+
+        virtual const CommonStats* getCommonStats();
+
+        virtual const SpecificStats* getSpecificStats();
+
+        static const char* kStageType;
+
+        static const size_t kMaxSkippedPerWork = 1000;
+
+    private:
+        /**
+         * A top-level field which the filter requires to be one of 'values'.
+         */
+        struct RawFieldFilter {
+            std::string field;
+            std::vector<std::string> values;
+        };
+
+        /**
+         * If 'expr' requires the top-level "ns" or "op" field to equal one of a set of strings,
+         * fills out '*out' and returns true.
+         */
+        static bool extractRawFieldFilter(const MatchExpression* expr, RawFieldFilter* out);
+
+        /**
+         * Returns false if the BSON entry at 'data' certainly fails the filter.
+         */
+        bool passesRawFilters(const char* data) const;
+
+        /**
+         * Does one unit of work without touching the 'works' counter or the execution timer,
+         * which work() and workBatch() account for themselves.
+         */
+        StageState doWork(WorkingSetID* out);
+
+        // transactional context for read locks. Not owned by us
+        OperationContext* _txn;
+
+        // WorkingSet is not owned by us.
+        WorkingSet* _workingSet;
+
+        // The filter is not owned by us.
+        const MatchExpression* _filter;
+
+        std::vector<RawFieldFilter> _rawFilters;
+
+        scoped_ptr<RecordIterator> _iter;
+
+        CollectionScanParams _params;
+
+        bool _isDead;
+
+        RecordId _lastSeenLoc;
+
+        // Used for all fetch requests, as in CollectionScan.
+        const WorkingSetID _wsidForFetch;
+
+        // Stats
+        CommonStats _commonStats;
+        OplogScanStats _specificStats;
+    };
+
+}  // namespace mongo
@@ -28,6 +28,8 @@
 
 #include "mongo/db/exec/or.h"
 
+#include <algorithm>
+
 #include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
@@ -39,7 +41,28 @@ namespace mongo {
     const char* OrStage::kStageType = "OR";
 
     OrStage::OrStage(WorkingSet* ws, bool dedup, const MatchExpression* filter)
-        : _ws(ws), _filter(filter), _currentChild(0), _dedup(dedup), _commonStats(kStageType) { }
+        : _ws(ws),
+          _collection(NULL),
+          _filter(filter),
+          _currentChild(0),
+          _dedup(dedup),
+          _mergeByRecordId(false),
+          _commonStats(kStageType) { }
+
+    OrStage::OrStage(WorkingSet* ws,
+                     bool dedup,
+                     const MatchExpression* filter,
+                     const Collection* collection,
+                     bool mergeByRecordId)
+        : _ws(ws),
+          _collection(collection),
+          _filter(filter),
+          _currentChild(0),
+          _dedup(dedup),
+          _mergeByRecordId(mergeByRecordId),
+          _commonStats(kStageType) {
+        _specificStats.mergeByRecordId = mergeByRecordId;
+    }
 
     OrStage::~OrStage() {
         for (size_t i = 0; i < _children.size(); ++i) {
@@ -47,15 +70,25 @@ namespace mongo {
         }
     }
 
-    void OrStage::addChild(PlanStage* child) { _children.push_back(child); }
+    void OrStage::addChild(PlanStage* child) {
+        if (_mergeByRecordId) {
+            _noResultToMerge.push(_children.size());
+        }
+        _children.push_back(child);
+    }
 
-    bool OrStage::isEOF() { return _currentChild >= _children.size(); }
+    bool OrStage::isEOF() {
+        if (_mergeByRecordId) {
+            return _merging.empty() && _noResultToMerge.empty();
+        }
+        return _currentChild >= _children.size();
+    }
 
     PlanStage::StageState OrStage::work(WorkingSetID* out) {
         ++_commonStats.works;
 
         // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        ScopedTimer timer(&_commonStats);
 
         if (isEOF()) { return PlanStage::IS_EOF; }
 
@@ -63,6 +96,10 @@ namespace mongo {
             _specificStats.matchTested = vector<size_t>(_children.size(), 0);
         }
 
+        if (_mergeByRecordId) {
+            return workMerging(out);
+        }
+
         WorkingSetID id = WorkingSet::INVALID_ID;
         StageState childStatus = _children[_currentChild]->work(&id);
 
@@ -73,18 +110,14 @@ namespace mongo {
             if (_dedup && member->hasLoc()) {
                 ++_specificStats.dupsTested;
 
-                // ...and we've seen the RecordId before
-                if (_seen.end() != _seen.find(member->loc)) {
-                    // ...drop it.
+                // ...and we've seen the RecordId before, drop it.  Otherwise, note that we've
+                // seen it.
+                if (!_seen.add(member->loc)) {
                     ++_specificStats.dupsDropped;
                     _ws->free(id);
                     ++_commonStats.needTime;
                     return PlanStage::NEED_TIME;
                 }
-                else {
-                    // Otherwise, note that we've seen it.
-                    _seen.insert(member->loc);
-                }
             }
 
             if (Filter::passes(member, _filter)) {
@@ -117,17 +150,7 @@ namespace mongo {
             }
         }
         else if (PlanStage::FAILURE == childStatus) {
-            *out = id;
-            // If a stage fails, it may create a status WSM to indicate why it
-            // failed, in which case 'id' is valid.  If ID is invalid, we
-            // create our own error message.
-            if (WorkingSet::INVALID_ID == id) {
-                mongoutils::str::stream ss;
-                ss << "OR stage failed to read in results from child " << _currentChild;
-                Status status(ErrorCodes::InternalError, ss);
-                *out = WorkingSetCommon::allocateStatusMember( _ws, status);
-            }
-            return childStatus;
+            return childFailed(_currentChild, id, out);
         }
         else if (PlanStage::NEED_TIME == childStatus) {
             ++_commonStats.needTime;
@@ -141,6 +164,97 @@ namespace mongo {
         return childStatus;
     }
 
+    PlanStage::StageState OrStage::workMerging(WorkingSetID* out) {
+        if (!_noResultToMerge.empty()) {
+            // Each child which isn't EOF must have a result in the heap before we can pick the
+            // smallest.  Work the next child which doesn't.
+            const size_t childIndex = _noResultToMerge.front();
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            StageState childStatus = _children[childIndex]->work(&id);
+
+            if (PlanStage::ADVANCED == childStatus) {
+                WorkingSetMember* member = _ws->get(id);
+                // The planner only merges children which produce RecordIds.
+                invariant(member->hasLoc());
+                _noResultToMerge.pop();
+                _merging.push_back(MergeEntry(member->loc, childIndex, id));
+                std::push_heap(_merging.begin(), _merging.end(), MergeEntryGreater());
+                ++_commonStats.needTime;
+                return PlanStage::NEED_TIME;
+            }
+            else if (PlanStage::IS_EOF == childStatus) {
+                _noResultToMerge.pop();
+                if (isEOF()) {
+                    return PlanStage::IS_EOF;
+                }
+                ++_commonStats.needTime;
+                return PlanStage::NEED_TIME;
+            }
+            else if (PlanStage::FAILURE == childStatus) {
+                return childFailed(childIndex, id, out);
+            }
+            else if (PlanStage::NEED_TIME == childStatus) {
+                ++_commonStats.needTime;
+            }
+            else if (PlanStage::NEED_FETCH == childStatus) {
+                ++_commonStats.needFetch;
+                *out = id;
+            }
+
+            return childStatus;
+        }
+
+        // Every child has given us a result or is EOF.  Take the smallest, and ask its child for
+        // the next one.
+        std::pop_heap(_merging.begin(), _merging.end(), MergeEntryGreater());
+        const MergeEntry next = _merging.back();
+        _merging.pop_back();
+        _noResultToMerge.push(next.child);
+
+        if (_dedup) {
+            ++_specificStats.dupsTested;
+            // Children produce increasing RecordIds, so any other copy of a result is merged
+            // right after it.
+            if (!_lastMerged.isNull() && next.loc == _lastMerged) {
+                ++_specificStats.dupsDropped;
+                _ws->free(next.id);
+                ++_commonStats.needTime;
+                return PlanStage::NEED_TIME;
+            }
+            _lastMerged = next.loc;
+        }
+
+        WorkingSetMember* member = _ws->get(next.id);
+        if (Filter::passes(member, _filter)) {
+            if (NULL != _filter) {
+                ++_specificStats.matchTested[next.child];
+            }
+            *out = next.id;
+            ++_commonStats.advanced;
+            return PlanStage::ADVANCED;
+        }
+
+        _ws->free(next.id);
+        ++_commonStats.needTime;
+        return PlanStage::NEED_TIME;
+    }
+
+    PlanStage::StageState OrStage::childFailed(size_t childIndex,
+                                               WorkingSetID id,
+                                               WorkingSetID* out) {
+        *out = id;
+        // If a stage fails, it may create a status WSM to indicate why it
+        // failed, in which case 'id' is valid.  If ID is invalid, we
+        // create our own error message.
+        if (WorkingSet::INVALID_ID == id) {
+            mongoutils::str::stream ss;
+            ss << "OR stage failed to read in results from child " << childIndex;
+            Status status(ErrorCodes::InternalError, ss);
+            *out = WorkingSetCommon::allocateStatusMember( _ws, status);
+        }
+        return PlanStage::FAILURE;
+    }
+
     void OrStage::saveState() {
         ++_commonStats.yields;
         for (size_t i = 0; i < _children.size(); ++i) {
@@ -164,13 +278,30 @@ namespace mongo {
             _children[i]->invalidate(txn, dl, type);
         }
 
+        if (_mergeByRecordId) {
+            // A result waiting to be merged may no longer be in the collection, or may no longer
+            // match.  Fetch it so that it is still returned in order, but flag it for review.
+            for (size_t i = 0; i < _merging.size(); ++i) {
+                WorkingSetMember* member = _ws->get(_merging[i].id);
+                if (member->hasLoc() && dl == member->loc) {
+                    WorkingSetCommon::fetchAndInvalidateLoc(txn, member, _collection);
+                    _ws->flagForReview(_merging[i].id);
+                    ++_specificStats.forcedFetches;
+                }
+            }
+        }
+
         // If we see DL again it is not the same record as it once was so we still want to
         // return it.
         if (_dedup && INVALIDATION_DELETION == type) {
-            unordered_set<RecordId, RecordId::Hasher>::iterator it = _seen.find(dl);
-            if (_seen.end() != it) {
+            if (_mergeByRecordId) {
+                if (dl == _lastMerged) {
+                    ++_specificStats.locsForgotten;
+                    _lastMerged = RecordId();
+                }
+            }
+            else if (_seen.remove(dl)) {
                 ++_specificStats.locsForgotten;
-                _seen.erase(dl);
             }
         }
     }
@@ -28,17 +28,28 @@
 
 #pragma once
 
+#include <queue>
+#include <vector>
+
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/record_id_bitmap.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/record_id.h"
-#include "mongo/platform/unordered_set.h"
 
 namespace mongo {
 
+    class Collection;
+
     /**
      * This stage outputs the union of its children.  It optionally deduplicates on RecordId.
      *
+     * By default the children are read one after the other, and the RecordIds returned so far
+     * are kept in a compressed bitmap for deduping.  When every child produces its results in
+     * RecordId order, as point index scans do, the children can instead be merged by RecordId.
+     * The output is then in RecordId order too, and a duplicate is always the result returned
+     * just before it, so deduping takes no memory.
+     *
      * Preconditions: Valid RecordId.
      *
      * If we're deduping, we may fail to dedup any invalidated RecordId properly.
@@ -46,6 +57,17 @@ namespace mongo {
     class OrStage : public PlanStage {
     public:
         OrStage(WorkingSet* ws, bool dedup, const MatchExpression* filter);
+
+        /**
+         * If 'mergeByRecordId' is true, every child must produce its results in increasing
+         * RecordId order.  'collection' is used to fetch results which are invalidated while
+         * they wait to be merged.
+         */
+        OrStage(WorkingSet* ws,
+                bool dedup,
+                const MatchExpression* filter,
+                const Collection* collection,
+                bool mergeByRecordId);
         virtual ~OrStage();
 
         void addChild(PlanStage* child);
@@ -71,9 +93,17 @@ namespace mongo {
         static const char* kStageType;
 
     private:
+        StageState workMerging(WorkingSetID* out);
+
+        // Passes up the failure of child 'childIndex'.
+        StageState childFailed(size_t childIndex, WorkingSetID id, WorkingSetID* out);
+
         // Not owned by us.
         WorkingSet* _ws;
 
+        // Not owned by us.  Only set when merging by RecordId.
+        const Collection* _collection;
+
         // The filter is not owned by us.
         const MatchExpression* _filter;
 
@@ -86,8 +116,42 @@ namespace mongo {
         // True if we dedup on RecordId, false otherwise.
         bool _dedup;
 
-        // Which RecordIds have we returned?
-        unordered_set<RecordId, RecordId::Hasher> _seen;
+        // Which RecordIds have we returned?  Not used when merging by RecordId.
+        RecordIdBitmap _seen;
+
+        //
+        // Merging by RecordId.
+        //
+
+        bool _mergeByRecordId;
+
+        // A result which a child has produced and which hasn't been merged yet.
+        struct MergeEntry {
+            MergeEntry(const RecordId& loc, size_t child, WorkingSetID id)
+                : loc(loc), child(child), id(id) { }
+
+            // Kept apart from the member, which loses its RecordId if it is invalidated.
+            RecordId loc;
+            size_t child;
+            WorkingSetID id;
+        };
+
+        // Orders the heap below by smallest RecordId first.
+        struct MergeEntryGreater {
+            bool operator()(const MergeEntry& lhs, const MergeEntry& rhs) const {
+                return lhs.loc > rhs.loc;
+            }
+        };
+
+        // A min heap of the next result from each child which isn't EOF and has produced one.
+        // A vector rather than a priority_queue, so that invalidate() can look through it.
+        std::vector<MergeEntry> _merging;
+
+        // The children which need to produce a result before the smallest can be picked.
+        std::queue<size_t> _noResultToMerge;
+
+        // The RecordId of the last merged result, which is null before the first one.
+        RecordId _lastMerged;
 
         // Stats
         CommonStats _commonStats;
@@ -0,0 +1,224 @@
+/*    Copyright 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/parallel_count.h"
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "mongo/base/owned_pointer_vector.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/thread_pool.h"
+
+namespace mongo {
+
+    using boost::scoped_ptr;
+    using std::vector;
+
+    namespace {
+
+        // Below this many documents the cost of handing out the work outweighs the gain.
+        const uint64_t kMinRecordsForParallelCount = 100 * 1000;
+
+        // How often a worker checks whether it has been asked to stop.
+        const int kDocumentsBetweenStopChecks = 1024;
+
+        // How long the calling thread sleeps between checks for interruption.
+        const int kInterruptCheckPeriodMillis = 100;
+
+        boost::mutex countPoolMutex;
+        threadpool::ThreadPool* countPool = NULL;
+
+        threadpool::ThreadPool* getCountPool() {
+            boost::lock_guard<boost::mutex> lk(countPoolMutex);
+            if (NULL == countPool) {
+                countPool = new threadpool::ThreadPool(internalQueryExecParallelCountThreads,
+                                                       "parallelCount");
+            }
+            return countPool;
+        }
+
+        /**
+         * $where runs in the calling thread's JS scope, and $text and $near are evaluated by
+         * their stages rather than by the matcher, so none of them can be matched by a worker.
+         */
+        bool canMatchInWorker(const MatchExpression* expr) {
+            switch (expr->matchType()) {
+            case MatchExpression::WHERE:
+            case MatchExpression::TEXT:
+            case MatchExpression::GEO_NEAR:
+                return false;
+            default:
+                break;
+            }
+
+            for (size_t i = 0; i < expr->numChildren(); ++i) {
+                if (!canMatchInWorker(expr->getChild(i))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * State shared by a call to tryCountInParallel() and the workers it schedules.  Lives on
+         * the caller's stack, which does not return until 'numRunning' drops to zero.
+         */
+        struct ParallelCountState {
+            explicit ParallelCountState(const vector<RecordIterator*>& iterators)
+                : iterators(iterators),
+                  numRunning(0),
+                  status(Status::OK()) { }
+
+            const vector<RecordIterator*>& iterators;
+
+            // Index of the next iterator to hand to a worker.
+            AtomicUInt32 nextIterator;
+
+            // Set non-zero to make the workers give up early.
+            AtomicUInt32 stop;
+
+            AtomicInt64 count;
+
+            // Guard 'numRunning' and 'status'.
+            boost::mutex mutex;
+            boost::condition_variable workerDone;
+            int numRunning;
+            Status status;
+        };
+
+        /**
+         * Body of one worker: drains iterators until none are left.  Takes ownership of 'filter',
+         * which is this worker's private copy (or NULL to count everything).
+         */
+        void countWorker(ParallelCountState* state, MatchExpression* filter) {
+            scoped_ptr<MatchExpression> ownedFilter(filter);
+            long long counted = 0;
+
+            try {
+                unsigned idx;
+                while ((idx = state->nextIterator.fetchAndAdd(1)) < state->iterators.size()) {
+                    RecordIterator* it = state->iterators[idx];
+                    int sinceStopCheck = 0;
+                    while (!it->isEOF()) {
+                        if (++sinceStopCheck == kDocumentsBetweenStopChecks) {
+                            sinceStopCheck = 0;
+                            if (state->stop.load()) {
+                                break;
+                            }
+                        }
+
+                        RecordId loc = it->getNext();
+                        if (NULL == filter || filter->matchesBSON(it->dataFor(loc).toBson())) {
+                            ++counted;
+                        }
+                    }
+                }
+            }
+            catch (const DBException& ex) {
+                boost::lock_guard<boost::mutex> lk(state->mutex);
+                if (state->status.isOK()) {
+                    state->status = ex.toStatus();
+                }
+                state->stop.store(1);
+            }
+
+            state->count.fetchAndAdd(counted);
+
+            boost::lock_guard<boost::mutex> lk(state->mutex);
+            if (0 == --state->numRunning) {
+                state->workerDone.notify_all();
+            }
+        }
+
+    }  // namespace
+
+    bool tryCountInParallel(OperationContext* txn,
+                            const Collection* collection,
+                            const MatchExpression* filter,
+                            long long* out) {
+        if (internalQueryExecParallelCountThreads <= 1) {
+            return false;
+        }
+
+        if (NULL != filter && !canMatchInWorker(filter)) {
+            return false;
+        }
+
+        if (collection->numRecords(txn) < kMinRecordsForParallelCount) {
+            return false;
+        }
+
+        OwnedPointerVector<RecordIterator> iterators(collection->getManyIterators(txn));
+        if (iterators.size() < 2) {
+            return false;
+        }
+
+        ParallelCountState state(iterators.vector());
+        const size_t numWorkers = std::min(iterators.size(),
+                                           static_cast<size_t>(
+                                               internalQueryExecParallelCountThreads));
+
+        // Clone the filters up front so that a failure here leaves no worker running.
+        OwnedPointerVector<MatchExpression> filters;
+        for (size_t i = 0; i < numWorkers; ++i) {
+            filters.push_back(NULL == filter ? NULL : filter->shallowClone());
+        }
+
+        threadpool::ThreadPool* pool = getCountPool();
+        state.numRunning = numWorkers;
+        for (size_t i = 0; i < numWorkers; ++i) {
+            pool->schedule(countWorker, &state, filters.releaseAt(i));
+        }
+
+        {
+            boost::unique_lock<boost::mutex> lk(state.mutex);
+            while (state.numRunning > 0) {
+                state.workerDone.timed_wait(
+                    lk, boost::posix_time::milliseconds(kInterruptCheckPeriodMillis));
+                if (!state.stop.load() && !txn->checkForInterruptNoAssert().isOK()) {
+                    state.stop.store(1);
+                }
+            }
+        }
+
+        txn->checkForInterrupt();
+        uassertStatusOK(state.status);
+
+        *out = state.count.load();
+        return true;
+    }
+
+}  // namespace mongo
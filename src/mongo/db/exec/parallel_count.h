@@ -0,0 +1,55 @@
+/*    Copyright 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+namespace mongo {
+
+    class Collection;
+    class MatchExpression;
+    class OperationContext;
+
+    /**
+     * Counts the documents of 'collection' matching 'filter' (NULL matches everything) by
+     * scanning the iterators of Collection::getManyIterators() on a pool of worker threads, each
+     * matching with its own copy of 'filter'.
+     *
+     * Returns false without doing any work if the count should be done serially instead: the
+     * internalQueryExecParallelCountThreads knob is off, the collection is small, its record store
+     * does not split into several iterators, or 'filter' cannot be evaluated off the calling
+     * thread ($where, $text, $near).  Otherwise stores the count in *out and returns true.
+     *
+     * The scan does not yield, so the caller must hold a lock that keeps the collection from
+     * changing for the whole call.  Throws if the operation is killed, after the workers have
+     * stopped.
+     */
+    bool tryCountInParallel(OperationContext* txn,
+                            const Collection* collection,
+                            const MatchExpression* filter,
+                            long long* out);
+
+}  // namespace mongo
@@ -171,6 +171,41 @@ namespace mongo {
          */
         virtual StageState work(WorkingSetID* out) = 0;
 
+        /**
+         * Perform up to 'maxWorks' units of work, appending the id of every ADVANCED result to
+         * 'out' in the order the results were produced.
+         *
+         * Stops early at the first state other than ADVANCED or NEED_TIME, which is returned with
+         * *id set as work() would have set it.  The results already appended to 'out' come before
+         * that state.  Returns NEED_TIME if all 'maxWorks' units were done.
+         *
+         * The default implementation simply calls work() in a loop.  Stages which return true from
+         * supportsBatch() override this with a tight loop that amortizes the per-call overhead of
+         * work() (timing, virtual dispatch down the tree) over the whole batch.
+         */
+        virtual StageState workBatch(size_t maxWorks,
+                                     std::vector<WorkingSetID>* out,
+                                     WorkingSetID* id) {
+            for (size_t i = 0; i < maxWorks; ++i) {
+                WorkingSetID next = WorkingSet::INVALID_ID;
+                StageState state = work(&next);
+                if (ADVANCED == state) {
+                    out->push_back(next);
+                }
+                else if (NEED_TIME != state) {
+                    *id = next;
+                    return state;
+                }
+            }
+            return NEED_TIME;
+        }
+
+        /**
+         * Returns true if this stage implements workBatch() natively.  The PlanExecutor only
+         * drives a tree with workBatch() when every stage in it supports batching.
+         */
+        virtual bool supportsBatch() const { return false; }
+
         /**
          * Returns true if no more work can be done on the query / out of results.
          */
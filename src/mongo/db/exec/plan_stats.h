@@ -66,6 +66,10 @@ namespace mongo {
                         needTime(0),
                         needFetch(0),
                         executionTimeMillis(0),
+                        hasDetailedStats(false),
+                        executionTimeNanos(0),
+                        allocatedBytes(0),
+                        storageCursorOps(0),
                         isEOF(false) { }
         // String giving the type of the stage. Not owned.
         const char* stageTypeStr;
@@ -88,6 +92,16 @@ namespace mongo {
         // Time elapsed while working inside this stage.
         long long executionTimeMillis;
 
+        // Only measured while the stage runs for explain, see ScopedTimer::DetailedScope.  Like
+        // the estimate above these include the stage's children.
+        bool hasDetailedStats;
+        long long executionTimeNanos;
+        long long allocatedBytes;
+
+        // Calls this stage made on storage engine cursors and record stores, not counting the
+        // calls of its children.
+        size_t storageCursorOps;
+
         // TODO: have some way of tracking WSM sizes (or really any series of #s).  We can measure
         // the size of our inputs and the size of our outputs.  We can do a lot with the WS here.
 
@@ -178,6 +192,37 @@ namespace mongo {
         size_t memLimit;
     };
 
+    struct AndBitmapStats : public SpecificStats {
+        AndBitmapStats() : flaggedButPassed(0),
+                           flaggedInProgress(0),
+                           memUsage(0),
+                           memLimit(0) { }
+
+        virtual ~AndBitmapStats() { }
+
+        virtual SpecificStats* clone() const {
+            AndBitmapStats* specific = new AndBitmapStats(*this);
+            return specific;
+        }
+
+        // Invalidation counters.
+        // How many results had the AND fully evaluated but were invalidated?
+        size_t flaggedButPassed;
+
+        // How many results were mid-AND but got flagged?
+        size_t flaggedInProgress;
+
+        // How many RecordIds are in the bitmap after each child?  The last child is probed against
+        // the bitmap rather than added to it, so it has no entry.
+        std::vector<size_t> bitmapAfterChild;
+
+        // What's our current memory usage?
+        size_t memUsage;
+
+        // What's our memory limit?
+        size_t memLimit;
+    };
+
     struct AndSortedStats : public SpecificStats {
         AndSortedStats() : flagged(0),
                            matchTested(0) { }
@@ -224,7 +269,7 @@ namespace mongo {
     };
 
     struct CountStats : public SpecificStats {
-        CountStats() : nCounted(0), nSkipped(0), trivialCount(false) { }
+        CountStats() : nCounted(0), nSkipped(0), trivialCount(false), estimated(false) { }
 
         virtual SpecificStats* clone() const {
             CountStats* specific = new CountStats(*this);
@@ -240,6 +285,9 @@ namespace mongo {
         // A "trivial count" is one that we can answer by calling numRecords() on the
         // collection, without actually going through any query logic.
         bool trivialCount;
+
+        // Whether the count is an estimate from the index rather than the result of walking it.
+        bool estimated;
     };
 
     struct CountScanStats : public SpecificStats {
@@ -296,7 +344,8 @@ namespace mongo {
         FetchStats() : alreadyHasObj(0),
                        forcedFetches(0),
                        matchTested(0),
-                       docsExamined(0) { }
+                       docsExamined(0),
+                       docsPrefetched(0) { }
 
         virtual ~FetchStats() { }
 
@@ -320,10 +369,13 @@ namespace mongo {
 
         // The total number of full documents touched by the fetch stage.
         size_t docsExamined;
+
+        // How many documents were hinted to the storage engine ahead of being fetched.
+        size_t docsPrefetched;
     };
 
     struct GroupStats : public SpecificStats {
-        GroupStats() : nGroups(0) { }
+        GroupStats() : nGroups(0), reducedNatively(false) { }
 
         virtual ~GroupStats() { }
 
@@ -334,6 +386,9 @@ namespace mongo {
 
         // The total number of groups.
         size_t nGroups;
+
+        // Whether every document was reduced without running the JavaScript reduce function.
+        bool reducedNatively;
     };
 
     struct IDHackStats : public SpecificStats {
@@ -435,10 +490,26 @@ namespace mongo {
         }
     };
 
+    struct OplogScanStats : public SpecificStats {
+        OplogScanStats() : docsTested(0), docsSkipped(0) { }
+
+        virtual SpecificStats* clone() const {
+            return new OplogScanStats(*this);
+        }
+
+        // How many entries did we check against our filter?
+        size_t docsTested;
+
+        // How many entries were rejected from their raw bytes, without checking the filter?
+        size_t docsSkipped;
+    };
+
     struct OrStats : public SpecificStats {
-        OrStats() : dupsTested(0),
+        OrStats() : mergeByRecordId(false),
+                    dupsTested(0),
                     dupsDropped(0),
-                    locsForgotten(0) { }
+                    locsForgotten(0),
+                    forcedFetches(0) { }
 
         virtual ~OrStats() { }
 
@@ -447,12 +518,18 @@ namespace mongo {
             return specific;
         }
 
+        // Are the children merged by RecordId rather than read one after the other?
+        bool mergeByRecordId;
+
         size_t dupsTested;
         size_t dupsDropped;
 
         // How many calls to invalidate(...) actually removed a RecordId from our deduping map?
         size_t locsForgotten;
 
+        // How many results waiting to be merged were fetched because they were invalidated?
+        size_t forcedFetches;
+
         // We know how many passed (it's the # of advanced) and therefore how many failed.
         std::vector<size_t> matchTested;
     };
@@ -470,7 +547,7 @@ namespace mongo {
     };
 
     struct SortStats : public SpecificStats {
-        SortStats() : forcedFetches(0), memUsage(0), memLimit(0) { }
+        SortStats() : forcedFetches(0), memUsage(0), memLimit(0), usedDisk(false) { }
 
         virtual ~SortStats() { }
 
@@ -493,6 +570,9 @@ namespace mongo {
 
         // The pattern according to which we are sorting.
         BSONObj sortPattern;
+
+        // Did we spill to disk?
+        bool usedDisk;
     };
 
     struct MergeSortStats : public SpecificStats {
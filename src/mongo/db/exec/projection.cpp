@@ -202,7 +202,7 @@ namespace mongo {
         ++_commonStats.works;
 
         // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        ScopedTimer timer(&_commonStats);
 
         WorkingSetID id = WorkingSet::INVALID_ID;
         StageState status = _child->work(&id);
@@ -246,6 +246,54 @@ namespace mongo {
         return status;
     }
 
+    PlanStage::StageState ProjectionStage::workBatch(size_t maxWorks,
+                                                     std::vector<WorkingSetID>* out,
+                                                     WorkingSetID* id) {
+        // Adds the amount of time taken by the batch to executionTimeMillis.
+        ScopedTimer timer(&_commonStats);
+
+        const size_t childWorksBefore = _child->getCommonStats()->works;
+        const size_t firstResult = out->size();
+        StageState status = _child->workBatch(maxWorks, out, id);
+        _commonStats.works += _child->getCommonStats()->works - childWorksBefore;
+
+        // Project the child's results in place.
+        for (size_t i = firstResult; i < out->size(); ++i) {
+            Status projStatus = transform(_ws->get((*out)[i]));
+            if (!projStatus.isOK()) {
+                warning() << "Couldn't execute projection, status = "
+                          << projStatus.toString() << endl;
+                for (size_t j = i; j < out->size(); ++j) {
+                    _ws->free((*out)[j]);
+                }
+                out->resize(i);
+                *id = WorkingSetCommon::allocateStatusMember(_ws, projStatus);
+                return PlanStage::FAILURE;
+            }
+            ++_commonStats.advanced;
+        }
+
+        if (PlanStage::FAILURE == status) {
+            // If a stage fails, it may create a status WSM to indicate why it
+            // failed, in which case 'id' is valid.  If ID is invalid, we
+            // create our own error message.
+            if (WorkingSet::INVALID_ID == *id) {
+                mongoutils::str::stream ss;
+                ss << "projection stage failed to read in results from child";
+                Status status(ErrorCodes::InternalError, ss);
+                *id = WorkingSetCommon::allocateStatusMember( _ws, status);
+            }
+        }
+        else if (PlanStage::NEED_TIME == status) {
+            _commonStats.needTime++;
+        }
+        else if (PlanStage::NEED_FETCH == status) {
+            _commonStats.needFetch++;
+        }
+
+        return status;
+    }
+
     void ProjectionStage::saveState() {
         ++_commonStats.yields;
         _child->saveState();
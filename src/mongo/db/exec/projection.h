@@ -82,6 +82,10 @@ namespace mongo {
 
         virtual bool isEOF();
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks,
+                                     std::vector<WorkingSetID>* out,
+                                     WorkingSetID* id);
+        virtual bool supportsBatch() const { return true; }
 
         virtual void saveState();
         virtual void restoreState(OperationContext* opCtx);
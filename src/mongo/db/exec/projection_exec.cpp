@@ -29,6 +29,7 @@
 #include "mongo/db/exec/projection_exec.h"
 
 #include "mongo/db/exec/working_set_computed_data.h"
+#include "mongo/db/field_ref_table.h"
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/query/lite_parsed_query.h"
@@ -187,47 +188,61 @@ namespace mongo {
         }
     }
 
-    void ProjectionExec::add(const string& field, bool include) {
-        if (field.empty()) { // this is the field the user referred to
-            _include = include;
+    namespace {
+
+        /**
+         * Returns the number of parts of 'path' a projection of it descends through. A trailing
+         * '.' does not name a field of its own.
+         */
+        size_t projectedParts(const FieldRef& path) {
+            const size_t numParts = path.numParts();
+            if (numParts > 0 && path.getPart(numParts - 1).empty()) {
+                return numParts - 1;
+            }
+            return numParts;
         }
-        else {
-            _include = !include;
 
-            const size_t dot = field.find('.');
-            const string subfield = field.substr(0,dot);
-            const string rest = (dot == string::npos ? "" : field.substr(dot + 1, string::npos));
+    } // namespace
 
-            ProjectionExec*& fm = _fields[subfield.c_str()];
+    void ProjectionExec::add(const string& field, bool include) {
+        // Projections of the same shape name the same paths, so they share the split paths.
+        const boost::shared_ptr<const FieldRef> path = FieldRefTable::intern(field);
+        const size_t numParts = projectedParts(*path);
+
+        ProjectionExec* node = this;
+        for (size_t i = 0; i < numParts; i++) {
+            node->_include = !include;
 
+            ProjectionExec*& fm = node->_fields[path->getPart(i)];
             if (NULL == fm) {
                 fm = new ProjectionExec();
             }
-
-            fm->add(rest, include);
+            node = fm;
         }
+
+        // this is the field the user referred to
+        node->_include = include;
     }
 
     void ProjectionExec::add(const string& field, int skip, int limit) {
-        _special = true; // can't include or exclude whole object
-
-        if (field.empty()) { // this is the field the user referred to
-            _skip = skip;
-            _limit = limit;
-        }
-        else {
-            const size_t dot = field.find('.');
-            const string subfield = field.substr(0,dot);
-            const string rest = (dot == string::npos ? "" : field.substr(dot + 1, string::npos));
+        const boost::shared_ptr<const FieldRef> path = FieldRefTable::intern(field);
+        const size_t numParts = projectedParts(*path);
 
-            ProjectionExec*& fm = _fields[subfield.c_str()];
+        ProjectionExec* node = this;
+        for (size_t i = 0; i < numParts; i++) {
+            node->_special = true; // can't include or exclude whole object
 
+            ProjectionExec*& fm = node->_fields[path->getPart(i)];
             if (NULL == fm) {
                 fm = new ProjectionExec();
             }
-
-            fm->add(rest, skip, limit);
+            node = fm;
         }
+
+        // this is the field the user referred to
+        node->_special = true;
+        node->_skip = skip;
+        node->_limit = limit;
     }
 
     //
@@ -0,0 +1,211 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/record_id_bitmap.h"
+
+#include <algorithm>
+
+namespace {
+
+    // A container switches from a sorted array to a bitmap once the array would be larger than
+    // the bitmap: 4096 16-bit values take as much memory as 65536 bits.
+    const size_t kMaxArraySize = 4096;
+
+    const size_t kBitmapWords = 65536 / 64;
+
+} // namespace
+
+namespace mongo {
+
+    bool RecordIdBitmap::Container::add(uint16_t low) {
+        if (bits.empty()) {
+            std::vector<uint16_t>::iterator it = std::lower_bound(array.begin(), array.end(), low);
+            if (it != array.end() && *it == low) {
+                return false;
+            }
+            if (array.size() < kMaxArraySize) {
+                array.insert(it, low);
+                ++cardinality;
+                return true;
+            }
+            convertToBits();
+        }
+
+        uint64_t& word = bits[low / 64];
+        const uint64_t mask = uint64_t(1) << (low % 64);
+        if (word & mask) {
+            return false;
+        }
+        word |= mask;
+        ++cardinality;
+        return true;
+    }
+
+    bool RecordIdBitmap::Container::remove(uint16_t low) {
+        if (bits.empty()) {
+            std::vector<uint16_t>::iterator it = std::lower_bound(array.begin(), array.end(), low);
+            if (it == array.end() || *it != low) {
+                return false;
+            }
+            array.erase(it);
+            --cardinality;
+            return true;
+        }
+
+        uint64_t& word = bits[low / 64];
+        const uint64_t mask = uint64_t(1) << (low % 64);
+        if (!(word & mask)) {
+            return false;
+        }
+        word &= ~mask;
+        --cardinality;
+        return true;
+    }
+
+    bool RecordIdBitmap::Container::contains(uint16_t low) const {
+        if (bits.empty()) {
+            return std::binary_search(array.begin(), array.end(), low);
+        }
+        return bits[low / 64] & (uint64_t(1) << (low % 64));
+    }
+
+    void RecordIdBitmap::Container::convertToBits() {
+        bits.assign(kBitmapWords, 0);
+        for (size_t i = 0; i < array.size(); ++i) {
+            bits[array[i] / 64] |= uint64_t(1) << (array[i] % 64);
+        }
+        // Release the array's memory, which clear() would not do.
+        std::vector<uint16_t>().swap(array);
+    }
+
+    RecordIdBitmap::RecordIdBitmap() : _size(0) { }
+
+    bool RecordIdBitmap::add(const RecordId& loc) {
+        if (!_containers[highBits(loc)].add(lowBits(loc))) {
+            return false;
+        }
+        ++_size;
+        return true;
+    }
+
+    bool RecordIdBitmap::remove(const RecordId& loc) {
+        ContainerMap::iterator it = _containers.find(highBits(loc));
+        if (_containers.end() == it || !it->second.remove(lowBits(loc))) {
+            return false;
+        }
+        if (0 == it->second.cardinality) {
+            _containers.erase(it);
+        }
+        --_size;
+        return true;
+    }
+
+    bool RecordIdBitmap::contains(const RecordId& loc) const {
+        ContainerMap::const_iterator it = _containers.find(highBits(loc));
+        return _containers.end() != it && it->second.contains(lowBits(loc));
+    }
+
+    void RecordIdBitmap::intersectWith(const RecordIdBitmap& other) {
+        _size = 0;
+        ContainerMap::iterator it = _containers.begin();
+        while (it != _containers.end()) {
+            ContainerMap::const_iterator otherIt = other._containers.find(it->first);
+            if (other._containers.end() == otherIt) {
+                _containers.erase(it++);
+                continue;
+            }
+
+            Container& mine = it->second;
+            const Container& theirs = otherIt->second;
+            if (!mine.bits.empty() && !theirs.bits.empty()) {
+                mine.cardinality = 0;
+                for (size_t i = 0; i < kBitmapWords; ++i) {
+                    mine.bits[i] &= theirs.bits[i];
+                    uint64_t word = mine.bits[i];
+                    while (word) {
+                        word &= word - 1;
+                        ++mine.cardinality;
+                    }
+                }
+            }
+            else if (!mine.bits.empty()) {
+                // Only ids in their array can survive, so we end up with an array as well.
+                std::vector<uint16_t> kept;
+                for (size_t i = 0; i < theirs.array.size(); ++i) {
+                    if (mine.contains(theirs.array[i])) {
+                        kept.push_back(theirs.array[i]);
+                    }
+                }
+                std::vector<uint64_t>().swap(mine.bits);
+                mine.array.swap(kept);
+                mine.cardinality = mine.array.size();
+            }
+            else {
+                std::vector<uint16_t>::iterator out = mine.array.begin();
+                for (size_t i = 0; i < mine.array.size(); ++i) {
+                    if (theirs.contains(mine.array[i])) {
+                        *out++ = mine.array[i];
+                    }
+                }
+                mine.array.erase(out, mine.array.end());
+                mine.cardinality = mine.array.size();
+            }
+
+            if (0 == mine.cardinality) {
+                _containers.erase(it++);
+                continue;
+            }
+            _size += mine.cardinality;
+            ++it;
+        }
+    }
+
+    void RecordIdBitmap::clear() {
+        _containers.clear();
+        _size = 0;
+    }
+
+    void RecordIdBitmap::swap(RecordIdBitmap& other) {
+        _containers.swap(other._containers);
+        std::swap(_size, other._size);
+    }
+
+    size_t RecordIdBitmap::getMemUsage() const {
+        size_t usage = sizeof(*this);
+        for (ContainerMap::const_iterator it = _containers.begin(); it != _containers.end(); ++it) {
+            // Count the map node's own overhead (three pointers and a color) as well.
+            usage += sizeof(ContainerMap::value_type) + 4 * sizeof(void*);
+            usage += it->second.array.capacity() * sizeof(uint16_t);
+            usage += it->second.bits.capacity() * sizeof(uint64_t);
+        }
+        return usage;
+    }
+
+}  // namespace mongo
@@ -0,0 +1,119 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include "mongo/db/record_id.h"
+#include "mongo/platform/cstdint.h"
+
+namespace mongo {
+
+    /**
+     * A compressed set of RecordIds, organized like a roaring bitmap.
+     *
+     * A RecordId is split into its high 48 bits, which select a container, and its low 16 bits,
+     * which are stored in that container.  A container starts out as a sorted array of 16-bit
+     * values and turns into a 65536-bit bitmap once it holds more ids than the array can hold
+     * more cheaply.  RecordIds handed out by a storage engine are mostly dense, so a set of
+     * millions of ids costs a few bits to a few bytes per id, rather than the tens of bytes a
+     * hash table entry costs.
+     *
+     * Not thread safe.
+     */
+    class RecordIdBitmap {
+    public:
+        RecordIdBitmap();
+
+        /**
+         * Adds 'loc' to the set.  Returns false if it was already there.
+         */
+        bool add(const RecordId& loc);
+
+        /**
+         * Removes 'loc' from the set.  Returns false if it wasn't there.
+         */
+        bool remove(const RecordId& loc);
+
+        bool contains(const RecordId& loc) const;
+
+        /**
+         * Removes every id that is not also in 'other'.
+         */
+        void intersectWith(const RecordIdBitmap& other);
+
+        size_t size() const { return _size; }
+
+        bool empty() const { return 0 == _size; }
+
+        void clear();
+
+        void swap(RecordIdBitmap& other);
+
+        /**
+         * Approximate number of bytes held by the set.
+         */
+        size_t getMemUsage() const;
+
+    private:
+        /**
+         * The low 16 bits of the ids sharing one set of high 48 bits.  Exactly one of 'array' and
+         * 'bits' is in use: 'array' (sorted) while 'bits' is empty.
+         */
+        struct Container {
+            Container() : cardinality(0) { }
+
+            bool add(uint16_t low);
+            bool remove(uint16_t low);
+            bool contains(uint16_t low) const;
+            void convertToBits();
+
+            std::vector<uint16_t> array;
+            std::vector<uint64_t> bits;
+            size_t cardinality;
+        };
+
+        typedef std::map<uint64_t, Container> ContainerMap;
+
+        static uint64_t highBits(const RecordId& loc) {
+            return static_cast<uint64_t>(loc.repr()) >> 16;
+        }
+
+        static uint16_t lowBits(const RecordId& loc) {
+            return static_cast<uint16_t>(static_cast<uint64_t>(loc.repr()) & 0xFFFF);
+        }
+
+        ContainerMap _containers;
+
+        // Number of ids in the set.
+        size_t _size;
+    };
+
+}  // namespace mongo
@@ -0,0 +1,131 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file contains tests for mongo/db/exec/record_id_bitmap.cpp
+ */
+
+#include "mongo/db/exec/record_id_bitmap.h"
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+    TEST(RecordIdBitmapTest, AddContainsRemove) {
+        RecordIdBitmap bitmap;
+        ASSERT_TRUE(bitmap.empty());
+
+        ASSERT_TRUE(bitmap.add(RecordId(5)));
+        ASSERT_TRUE(bitmap.add(RecordId(1, 8)));
+        ASSERT_FALSE(bitmap.add(RecordId(5)));
+        ASSERT_EQUALS(2U, bitmap.size());
+
+        ASSERT_TRUE(bitmap.contains(RecordId(5)));
+        ASSERT_TRUE(bitmap.contains(RecordId(1, 8)));
+        ASSERT_FALSE(bitmap.contains(RecordId(6)));
+        ASSERT_FALSE(bitmap.contains(RecordId(2, 8)));
+        ASSERT_FALSE(bitmap.contains(RecordId(5 + 65536)));
+
+        ASSERT_TRUE(bitmap.remove(RecordId(5)));
+        ASSERT_FALSE(bitmap.remove(RecordId(5)));
+        ASSERT_FALSE(bitmap.contains(RecordId(5)));
+        ASSERT_EQUALS(1U, bitmap.size());
+
+        bitmap.clear();
+        ASSERT_TRUE(bitmap.empty());
+        ASSERT_FALSE(bitmap.contains(RecordId(1, 8)));
+    }
+
+    // Fill one container far past the point where it turns into a bitmap.
+    TEST(RecordIdBitmapTest, DenseContainer) {
+        RecordIdBitmap bitmap;
+        for (int64_t i = 65535; i >= 0; i -= 3) {
+            ASSERT_TRUE(bitmap.add(RecordId(i)));
+        }
+        ASSERT_EQUALS(21846U, bitmap.size());
+
+        for (int64_t i = 0; i < 65536; ++i) {
+            ASSERT_EQUALS(0 == (65535 - i) % 3, bitmap.contains(RecordId(i)));
+        }
+
+        ASSERT_TRUE(bitmap.remove(RecordId(65535)));
+        ASSERT_FALSE(bitmap.contains(RecordId(65535)));
+        ASSERT_FALSE(bitmap.add(RecordId(0)));
+        ASSERT_EQUALS(21845U, bitmap.size());
+
+        // A bitmap container costs 8KB, far less than a hash table of the same ids.
+        ASSERT_LESS_THAN(bitmap.getMemUsage(), 10 * 1024U);
+    }
+
+    TEST(RecordIdBitmapTest, IntersectArraysAndBitmaps) {
+        RecordIdBitmap dense;
+        RecordIdBitmap sparse;
+        for (int64_t i = 0; i < 3 * 65536; ++i) {
+            dense.add(RecordId(i));
+            if (0 == i % 1000) {
+                sparse.add(RecordId(i));
+            }
+        }
+        // Only in 'sparse'; its container has no counterpart in 'dense'.
+        sparse.add(RecordId(10, 0));
+
+        // Bitmap containers intersected with array containers.
+        RecordIdBitmap result;
+        result.swap(dense);
+        result.intersectWith(sparse);
+        ASSERT_EQUALS(197U, result.size());
+        ASSERT_TRUE(result.contains(RecordId(0)));
+        ASSERT_TRUE(result.contains(RecordId(196000)));
+        ASSERT_FALSE(result.contains(RecordId(1)));
+        ASSERT_FALSE(result.contains(RecordId(10, 0)));
+
+        // Array containers intersected with bitmap containers.
+        RecordIdBitmap evens;
+        for (int64_t i = 0; i < 2 * 65536; i += 2) {
+            evens.add(RecordId(i));
+        }
+        sparse.intersectWith(evens);
+        ASSERT_EQUALS(132U, sparse.size());
+        ASSERT_TRUE(sparse.contains(RecordId(131000)));
+        ASSERT_FALSE(sparse.contains(RecordId(132000)));
+        ASSERT_FALSE(sparse.contains(RecordId(10, 0)));
+
+        // Bitmap containers intersected with bitmap containers.
+        RecordIdBitmap threes;
+        for (int64_t i = 0; i < 65536; i += 3) {
+            threes.add(RecordId(i));
+        }
+        evens.intersectWith(threes);
+        ASSERT_EQUALS(10923U, evens.size());
+        ASSERT_TRUE(evens.contains(RecordId(6)));
+        ASSERT_FALSE(evens.contains(RecordId(4)));
+        ASSERT_FALSE(evens.contains(RecordId(65536)));
+    }
+
+}  // namespace
@@ -30,18 +30,134 @@
 
 #include "mongo/db/exec/scoped_timer.h"
 
+#include <boost/thread/mutex.hpp>
+
+#include "mongo/db/exec/plan_stats.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/threadlocal.h"
 #include "mongo/util/net/listen.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
-    ScopedTimer::ScopedTimer(long long* counter) :
-        _counter(counter),
-        _start(Listener::getElapsedTimeMillis()) {
+    namespace {
+
+        // Allocation hooks run inside malloc, so the counter must be a plain thread local which
+        // never allocates.  Without one, only the other detailed stats are available.
+#if defined(MONGO_HAVE___THREAD)
+        __thread bool threadDetailed = false;
+        __thread long long threadAllocatedBytes = 0;
+#define MONGO_SCOPED_TIMER_COUNTS_ALLOCATIONS
+#elif defined(MONGO_HAVE___DECLSPEC_THREAD)
+        __declspec( thread ) bool threadDetailed = false;
+        __declspec( thread ) long long threadAllocatedBytes = 0;
+#define MONGO_SCOPED_TIMER_COUNTS_ALLOCATIONS
+#else
+        ThreadLocalValue<bool> threadDetailedValue;
+#endif
+
+        bool isDetailed() {
+#if defined(MONGO_SCOPED_TIMER_COUNTS_ALLOCATIONS)
+            return threadDetailed;
+#else
+            return threadDetailedValue.get();
+#endif
+        }
+
+        void setDetailed(bool detailed) {
+#if defined(MONGO_SCOPED_TIMER_COUNTS_ALLOCATIONS)
+            threadDetailed = detailed;
+#else
+            threadDetailedValue.set(detailed);
+#endif
+        }
+
+        long long allocatedBytes() {
+#if defined(MONGO_SCOPED_TIMER_COUNTS_ALLOCATIONS)
+            return threadAllocatedBytes;
+#else
+            return 0;
+#endif
+        }
+
+        ScopedTimer::AllocationHookInstaller allocationHookInstaller = NULL;
+
+        // The hook is only installed while some thread has detailed stats on, so that nothing
+        // else pays for it.
+        boost::mutex allocationHookMutex;
+        int threadsNeedingAllocationHook = 0;
+
+        void needAllocationHook(bool need) {
+            if (!ScopedTimer::measuresAllocations())
+                return;
+
+            boost::mutex::scoped_lock lk(allocationHookMutex);
+            if (need) {
+                if (threadsNeedingAllocationHook++ == 0)
+                    allocationHookInstaller(true);
+            }
+            else {
+                invariant(threadsNeedingAllocationHook > 0);
+                if (--threadsNeedingAllocationHook == 0)
+                    allocationHookInstaller(false);
+            }
+        }
+
+    } // namespace
+
+    ScopedTimer::ScopedTimer(CommonStats* stats) :
+        _stats(stats),
+        _start(Listener::getElapsedTimeMillis()),
+        _detailed(isDetailed()),
+        _startNanos(_detailed ? Timer::nowNanos() : 0),
+        _startAllocatedBytes(_detailed ? allocatedBytes() : 0) {
     }
 
     ScopedTimer::~ScopedTimer() {
         long long elapsed = Listener::getElapsedTimeMillis() - _start;
-        *_counter += elapsed;
+        _stats->executionTimeMillis += elapsed;
+
+        if (!_detailed)
+            return;
+
+        _stats->hasDetailedStats = true;
+        _stats->executionTimeNanos += Timer::nowNanos() - _startNanos;
+        _stats->allocatedBytes += allocatedBytes() - _startAllocatedBytes;
+    }
+
+    ScopedTimer::DetailedScope::DetailedScope() : _wasDetailed(isDetailed()) {
+        if (_wasDetailed)
+            return;
+        needAllocationHook(true);
+        setDetailed(true);
+    }
+
+    ScopedTimer::DetailedScope::~DetailedScope() {
+        if (_wasDetailed)
+            return;
+        setDetailed(false);
+        needAllocationHook(false);
+    }
+
+    // static
+    void ScopedTimer::setAllocationHookInstaller(AllocationHookInstaller installer) {
+        allocationHookInstaller = installer;
+    }
+
+    // static
+    void ScopedTimer::recordAllocation(size_t bytes) {
+#if defined(MONGO_SCOPED_TIMER_COUNTS_ALLOCATIONS)
+        threadAllocatedBytes += bytes;
+#endif
+    }
+
+    // static
+    bool ScopedTimer::measuresAllocations() {
+#if defined(MONGO_SCOPED_TIMER_COUNTS_ALLOCATIONS)
+        return allocationHookInstaller != NULL;
+#else
+        return false;
+#endif
     }
 
 }  // namespace mongo
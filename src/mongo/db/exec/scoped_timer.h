@@ -28,30 +28,74 @@
 
 #pragma once
 
+#include <cstddef>
+
 #include "mongo/base/disallow_copying.h"
 
 namespace mongo {
 
+    struct CommonStats;
+
     /**
-     * This class increments a counter by a rough estimate of the time elapsed since its
-     * construction when it goes out of scope.
+     * This class increments a stage's time counter by a rough estimate of the time elapsed since
+     * its construction when it goes out of scope.
+     *
+     * While a DetailedScope is alive on the current thread it also adds the elapsed nanoseconds
+     * and the bytes the thread allocated meanwhile to the stage's stats.  Since stages call their
+     * children from inside work(), both include the children, like the millisecond estimate.
      */
     class ScopedTimer {
         MONGO_DISALLOW_COPYING(ScopedTimer);
     public:
-        ScopedTimer(long long* counter);
+        ScopedTimer(CommonStats* stats);
 
         ~ScopedTimer();
 
+        /**
+         * Turns on detailed stats for the ScopedTimers of this thread, such as those of a plan
+         * being run for explain.  Scopes may nest.
+         */
+        class DetailedScope {
+            MONGO_DISALLOW_COPYING(DetailedScope);
+        public:
+            DetailedScope();
+            ~DetailedScope();
+
+        private:
+            const bool _wasDetailed;
+        };
+
+        /**
+         * Installs or removes a hook which reports each allocation to recordAllocation().  Set
+         * at startup by the allocator integration; without one allocated bytes are not measured.
+         */
+        typedef void (*AllocationHookInstaller)(bool install);
+        static void setAllocationHookInstaller(AllocationHookInstaller installer);
+
+        /**
+         * Called by the allocation hook, on the allocating thread.
+         */
+        static void recordAllocation(size_t bytes);
+
+        /**
+         * Whether allocated bytes are measured, which needs an allocation hook.
+         */
+        static bool measuresAllocations();
+
     private:
         // Default constructor disallowed.
         ScopedTimer();
 
-        // Reference to the counter that we are incrementing with the elapsed time.
-        long long* _counter;
+        // The stats that we are incrementing with the elapsed time.
+        CommonStats* _stats;
 
         // Time at which the timer was constructed.
         long long _start;
+
+        // Only set if detailed stats were on at construction.
+        bool _detailed;
+        long long _startNanos;
+        long long _startAllocatedBytes;
     };
 
 }  // namespace mongo
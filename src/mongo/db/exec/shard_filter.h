@@ -36,6 +36,8 @@
 
 namespace mongo {
 
+    class ShardKeyPattern;
+
     /**
      * This stage drops documents that didn't belong to the shard we're executing on at the time of
      * construction. This matches the contract for sharded cursorids which guarantees that a
@@ -68,8 +70,9 @@ namespace mongo {
      *
      * END NOTE FROM GREG
      *
-     * Preconditions: Child must be fetched.  TODO: when covering analysis is in just build doc
-     * and check that against shard key.  See SERVER-5022.
+     * Preconditions: Child must be fetched, or provide every shard key field in its index keys -
+     * the planner places this stage below the FETCH when it can, so that orphans are dropped
+     * before they are fetched.
      */
     class ShardFilterStage : public PlanStage {
     public:
@@ -106,6 +109,9 @@ namespace mongo {
         // Note: it is important that this is the metadata from the time this stage is constructed.
         // See class comment for details.
         const CollectionMetadataPtr _metadata;
+
+        // Parsed once from the metadata's key pattern; NULL if there is no metadata
+        scoped_ptr<ShardKeyPattern> _shardKeyPattern;
     };
 
 }  // namespace mongo
@@ -40,11 +40,55 @@
 #include "mongo/db/query/qlog.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
+#include "mongo/db/storage_options.h"
 
 namespace mongo {
 
     using std::vector;
 
+    namespace {
+
+        /**
+         * Orders the keys of the external sorter.  Each is a normalized key as BinData, or
+         * undefined if the item has none, followed by an object holding the sort key with the
+         * RecordId appended as a trailing field.  The sort pattern has no direction for that
+         * field, so RecordIds compare ascending, just as WorkingSetComparator breaks ties.
+         */
+        class SpillComparator {
+        public:
+            explicit SpillComparator(const BSONObj& pattern) : _pattern(pattern) { }
+
+            typedef std::pair<BSONObj, BSONObj> Data;
+
+            int operator()(const Data& lhs, const Data& rhs) const {
+                BSONObjIterator lhsIt(lhs.first);
+                BSONObjIterator rhsIt(rhs.first);
+                const BSONElement lhsNormalized = lhsIt.next();
+                const BSONElement rhsNormalized = rhsIt.next();
+                if (BinData == lhsNormalized.type() && BinData == rhsNormalized.type()) {
+                    int lhsLen;
+                    int rhsLen;
+                    const char* lhsData = lhsNormalized.binData(lhsLen);
+                    const char* rhsData = rhsNormalized.binData(rhsLen);
+                    const int common = std::min(lhsLen, rhsLen);
+                    if (int cmp = memcmp(lhsData, rhsData, common)) {
+                        return cmp;
+                    }
+                    return lhsLen == rhsLen ? 0 : lhsLen < rhsLen ? -1 : 1;
+                }
+
+                // False means ignore field names.
+                return lhsIt.next().embeddedObject().woCompare(rhsIt.next().embeddedObject(),
+                                                               _pattern,
+                                                               false);
+            }
+
+        private:
+            BSONObj _pattern;
+        };
+
+    }  // namespace
+
     // static
     const char* SortStage::kStageType = "SORT";
 
@@ -271,6 +315,11 @@ namespace mongo {
     SortStage::WorkingSetComparator::WorkingSetComparator(BSONObj p) : pattern(p) { }
 
     bool SortStage::WorkingSetComparator::operator()(const SortableDataItem& lhs, const SortableDataItem& rhs) const {
+        // The normalized keys include the RecordId.
+        if (lhs.hasNormalizedKey && rhs.hasNormalizedKey) {
+            return lhs.normalizedKey.compare(rhs.normalizedKey) < 0;
+        }
+
         // False means ignore field names.
         int result = lhs.sortKey.woCompare(rhs.sortKey, pattern, false);
         if (0 != result) {
@@ -289,8 +338,10 @@ namespace mongo {
           _pattern(params.pattern),
           _query(params.query),
           _limit(params.limit),
+          _allowDiskUse(params.allowDiskUse),
           _sorted(false),
           _resultIterator(_data.end()),
+          _hasComputedData(false),
           _commonStats(kStageType),
           _memUsage(0) {
     }
@@ -300,6 +351,9 @@ namespace mongo {
     bool SortStage::isEOF() {
         // We're done when our child has no more results, we've sorted the child's results, and
         // we've returned all sorted results.
+        if (_spillIt) {
+            return _child->isEOF() && _sorted && !_spillIt->more();
+        }
         return _child->isEOF() && _sorted && (_data.end() == _resultIterator);
     }
 
@@ -307,12 +361,17 @@ namespace mongo {
         ++_commonStats.works;
 
         // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        ScopedTimer timer(&_commonStats);
 
         if (NULL == _sortKeyGen) {
             // This is heavy and should be done as part of work().
             _sortKeyGen.reset(new SortStageKeyGenerator(_collection, _pattern, _query));
             _sortKeyComparator.reset(new WorkingSetComparator(_sortKeyGen->getSortComparator()));
+            // An Ordering holds at most 32 fields.
+            if (_sortKeyGen->getSortComparator().nFields() <= 32) {
+                _keyOrdering.reset(
+                    new Ordering(Ordering::make(_sortKeyGen->getSortComparator())));
+            }
             // If limit > 1, we need to initialize _dataSet here to maintain ordered
             // set of data items while fetching from the child stage.
             if (_limit > 1) {
@@ -323,6 +382,10 @@ namespace mongo {
         }
 
         const size_t maxBytes = static_cast<size_t>(internalQueryExecMaxBlockingSortBytes);
+        if (_memUsage > maxBytes && canSpill()) {
+            spillBuffer();
+        }
+
         if (_memUsage > maxBytes) {
             mongoutils::str::stream ss;
             ss << "sort stage buffered data usage of " << _memUsage
@@ -348,6 +411,14 @@ namespace mongo {
                 // Planner must put a fetch before we get here.
                 verify(member->hasObj());
 
+                if (_allowDiskUse && !_hasComputedData) {
+                    for (int i = 0; i < WSM_COMPUTED_NUM_TYPES; ++i) {
+                        if (member->hasComputed(static_cast<WorkingSetComputedDataType>(i))) {
+                            _hasComputedData = true;
+                        }
+                    }
+                }
+
                 // We might be sorting something that was invalidated at some point.
                 if (member->hasLoc()) {
                     _wsidByDiskLoc[member->loc] = id;
@@ -365,8 +436,17 @@ namespace mongo {
                     // The RecordId breaks ties when sorting two WSMs with the same sort key.
                     item.loc = member->loc;
                 }
+                if (_keyOrdering && KeyString::comparesLikeWoCompare(item.sortKey)) {
+                    item.normalizedKey.resetToKey(item.sortKey, *_keyOrdering, item.loc);
+                    item.hasNormalizedKey = true;
+                }
 
-                addToBuffer(item);
+                if (_spillSorter) {
+                    addToSpillSorter(item);
+                }
+                else {
+                    addToBuffer(item);
+                }
 
                 ++_commonStats.needTime;
                 return PlanStage::NEED_TIME;
@@ -374,8 +454,14 @@ namespace mongo {
             else if (PlanStage::IS_EOF == code) {
                 // TODO: We don't need the lock for this.  We could ask for a yield and do this work
                 // unlocked.  Also, this is performing a lot of work for one call to work(...)
-                sortBuffer();
-                _resultIterator = _data.begin();
+                if (_spillSorter) {
+                    _spillIt.reset(_spillSorter->done());
+                    _spillSorter.reset();
+                }
+                else {
+                    sortBuffer();
+                    _resultIterator = _data.begin();
+                }
                 _sorted = true;
                 ++_commonStats.needTime;
                 return PlanStage::NEED_TIME;
@@ -405,6 +491,20 @@ namespace mongo {
         }
 
         // Returning results.
+        if (_spillIt) {
+            verify(_sorted);
+            SpillSorter::Data next = _spillIt->next();
+
+            WorkingSetID id = _ws->allocate();
+            WorkingSetMember* member = _ws->get(id);
+            member->obj = next.second.getOwned();
+            member->state = WorkingSetMember::OWNED_OBJ;
+
+            *out = id;
+            ++_commonStats.advanced;
+            return PlanStage::ADVANCED;
+        }
+
         verify(_resultIterator != _data.end());
         verify(_sorted);
         *out = _resultIterator->wsid;
@@ -469,6 +569,7 @@ namespace mongo {
         const size_t maxBytes = static_cast<size_t>(internalQueryExecMaxBlockingSortBytes);
         _specificStats.memLimit = maxBytes;
         _specificStats.memUsage = _memUsage;
+        _specificStats.usedDisk = (NULL != _spillSorter.get()) || (NULL != _spillIt.get());
         _specificStats.limit = _limit;
         _specificStats.sortPattern = _pattern.getOwned();
 
@@ -588,4 +689,55 @@ namespace mongo {
         }
     }
 
+    bool SortStage::canSpill() const {
+        return _allowDiskUse && _limit == 0 && !_hasComputedData;
+    }
+
+    void SortStage::addToSpillSorter(const SortableDataItem& item) {
+        if (!_spillSorter) {
+            const size_t maxBytes = static_cast<size_t>(internalQueryExecMaxBlockingSortBytes);
+            SortOptions opts = SortOptions().TempDir(storageGlobalParams.dbpath + "/_tmp")
+                                            .ExtSortAllowed()
+                                            .MaxMemoryUsageBytes(maxBytes);
+            SpillComparator cmp(_sortKeyGen->getSortComparator());
+            _spillSorter.reset(SpillSorter::make(opts, cmp));
+        }
+
+        BSONObjBuilder keyBob;
+        if (item.hasNormalizedKey) {
+            keyBob.appendBinData("", item.normalizedKey.getSize(), BinDataGeneral,
+                                 item.normalizedKey.getBuffer());
+        }
+        else {
+            keyBob.appendUndefined("");
+        }
+        BSONObjBuilder sortKeyBob(keyBob.subobjStart(""));
+        sortKeyBob.appendElements(item.sortKey);
+        sortKeyBob.append("", static_cast<long long>(item.loc.repr()));
+        sortKeyBob.done();
+
+        WorkingSetMember* member = _ws->get(item.wsid);
+        _spillSorter->add(keyBob.obj(), member->obj.getOwned());
+
+        if (member->hasLoc()) {
+            _wsidByDiskLoc.erase(member->loc);
+        }
+        _ws->free(item.wsid);
+    }
+
+    void SortStage::spillBuffer() {
+        invariant(_limit == 0);
+
+        for (size_t i = 0; i < _data.size(); ++i) {
+            addToSpillSorter(_data[i]);
+        }
+        vector<SortableDataItem> empty;
+        _data.swap(empty);
+        _resultIterator = _data.end();
+        _memUsage = 0;
+    }
+
 }  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+// Explicit instantiation unneeded since we aren't exposing Sorter outside of this file.
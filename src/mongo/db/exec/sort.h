@@ -37,6 +37,8 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/query/index_bounds.h"
 #include "mongo/db/record_id.h"
+#include "mongo/db/sorter/sorter.h"
+#include "mongo/db/storage/key_string.h"
 #include "mongo/platform/unordered_map.h"
 
 
@@ -47,7 +49,7 @@ namespace mongo {
     // Parameters that must be provided to a SortStage
     class SortStageParams {
     public:
-        SortStageParams() : collection(NULL), limit(0) { }
+        SortStageParams() : collection(NULL), limit(0), allowDiskUse(false) { }
 
         // Used for resolving RecordIds to BSON
         const Collection* collection;
@@ -60,6 +62,10 @@ namespace mongo {
 
         // Equal to 0 for no limit.
         size_t limit;
+
+        // If true, a sort without a limit spills to disk instead of failing when its buffered
+        // data outgrows internalQueryExecMaxBlockingSortBytes.
+        bool allowDiskUse;
     };
 
     /**
@@ -139,6 +145,10 @@ namespace mongo {
      *
      * Preconditions: For each field in 'pattern', all inputs in the child must handle a
      * getFieldDotted for that field.
+     *
+     * With allowDiskUse and no limit, once the buffered data outgrows the memory limit the
+     * buffer and all further input go to an external Sorter keyed on (sort key, RecordId).
+     * Results which came back from the Sorter are owned objects without a RecordId.
      */
     class SortStage : public PlanStage {
     public:
@@ -191,6 +201,9 @@ namespace mongo {
         // Equal to 0 for no limit.
         size_t _limit;
 
+        // May we spill to disk?  See SortStageParams.
+        bool _allowDiskUse;
+
         //
         // Sort key generation
         //
@@ -206,18 +219,26 @@ namespace mongo {
 
         // Collection of working set members to sort with their respective sort key.
         struct SortableDataItem {
+            SortableDataItem() : hasNormalizedKey(false) { }
+
             WorkingSetID wsid;
             BSONObj sortKey;
             // Since we must replicate the behavior of a covered sort as much as possible we use the
             // RecordId to break sortKey ties.
             // See sorta.js.
             RecordId loc;
+
+            // (sortKey, loc) encoded for the sort pattern, if KeyString::comparesLikeWoCompare()
+            // says that comparing encodings gives the same answer.
+            bool hasNormalizedKey;
+            KeyString normalizedKey;
         };
 
         // Comparison object for data buffers (vector and set).
         // Items are compared on (sortKey, loc). This is also how the items are
         // ordered in the indices.
-        // Keys are compared using BSONObj::woCompare() with RecordId as a tie-breaker.
+        // Two items which both have normalized keys are compared with memcmp.  Otherwise keys are
+        // compared using BSONObj::woCompare() with RecordId as a tie-breaker.
         struct WorkingSetComparator {
             explicit WorkingSetComparator(BSONObj p);
 
@@ -240,10 +261,31 @@ namespace mongo {
          */
         void sortBuffer();
 
+        /**
+         * Can we hand the buffered data over to the external sorter?  Members carrying computed
+         * data (text scores, geo distances, index keys) can't go through the sorter without
+         * losing it.
+         */
+        bool canSpill() const;
+
+        /**
+         * Adds 'item' to the external sorter, creating it if needed, and frees its WSM.
+         */
+        void addToSpillSorter(const SortableDataItem& item);
+
+        /**
+         * Moves everything buffered in '_data' into the external sorter.
+         */
+        void spillBuffer();
+
         // Comparator for data buffer
         // Initialization follows sort key generator
         scoped_ptr<WorkingSetComparator> _sortKeyComparator;
 
+        // The Ordering normalized keys are encoded for.  NULL if the sort pattern has too many
+        // fields for an Ordering, in which case no item gets a normalized key.
+        scoped_ptr<Ordering> _keyOrdering;
+
         // The data we buffer and sort.
         // _data will contain sorted data when all data is gathered
         // and sorted.
@@ -262,6 +304,17 @@ namespace mongo {
         typedef unordered_map<RecordId, WorkingSetID, RecordId::Hasher> DataMap;
         DataMap _wsidByDiskLoc;
 
+        // Once we spill, every input goes to '_spillSorter' as a (key, owned document) pair until
+        // the child hits EOF, and then the results come out of '_spillIt'.  The key holds the
+        // normalized key, or undefined, followed by the sort key with the RecordId appended.
+        // Data in the sorter is owned, so invalidations don't concern it.
+        typedef Sorter<BSONObj, BSONObj> SpillSorter;
+        boost::scoped_ptr<SpillSorter> _spillSorter;
+        boost::scoped_ptr<SpillSorter::Iterator> _spillIt;
+
+        // Did some buffered member carry computed data?  See canSpill().
+        bool _hasComputedData;
+
         //
         // Stats
         //
@@ -69,7 +69,7 @@ namespace mongo {
         ++_commonStats.works;
 
         // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        ScopedTimer timer(&_commonStats);
 
         if (isEOF()) { return PlanStage::IS_EOF; }
         invariant(_internalState != DONE);
@@ -146,6 +146,13 @@ namespace mongo {
             }
             _scores.erase(scoreIt);
         }
+
+        for (TopResults::iterator it = _topResults.begin(); it != _topResults.end(); ++it) {
+            if (it->second == dl) {
+                _topResults.erase(it);
+                break;
+            }
+        }
     }
 
     vector<PlanStage*> TextStage::getChildren() const {
@@ -206,6 +213,10 @@ namespace mongo {
             return PlanStage::IS_EOF;
         }
 
+        if (_params.limit > 0) {
+            _termScoreBounds.assign(_scanners.size(), MAX_WEIGHT);
+        }
+
         // Transition to the next state.
         _internalState = READING_TERMS;
         return PlanStage::NEED_TIME;
@@ -224,11 +235,40 @@ namespace mongo {
             invariant(1 == wsm->keyData.size());
             invariant(wsm->hasLoc());
             IndexKeyDatum& keyDatum = wsm->keyData.back();
-            addTerm(keyDatum.keyData, wsm->loc);
+            if (_params.limit > 0) {
+                addTermTopK(keyDatum.keyData, wsm->loc);
+            }
+            else {
+                addTerm(keyDatum.keyData, wsm->loc);
+            }
             _ws->free(id);
+
+            if (_params.limit > 0) {
+                if (haveTopK()) {
+                    doneReadingTerms();
+                    return PlanStage::NEED_TIME;
+                }
+
+                // Take the terms in turn, so that all their bounds come down together.
+                _currentIndexScanner = (_currentIndexScanner + 1) % _scanners.size();
+            }
             return PlanStage::NEED_TIME;
         }
         else if (PlanStage::IS_EOF == childState) {
+            if (_params.limit > 0) {
+                // Drop the exhausted scan, and its bound, and go on with the next one.
+                _scanners.erase(_scanners.begin() + _currentIndexScanner);
+                _termScoreBounds.erase(_termScoreBounds.begin() + _currentIndexScanner);
+
+                if (_scanners.empty() || haveTopK()) {
+                    doneReadingTerms();
+                    return PlanStage::NEED_TIME;
+                }
+
+                _currentIndexScanner %= _scanners.size();
+                return PlanStage::NEED_TIME;
+            }
+
             // Done with this scan.
             ++_currentIndexScanner;
 
@@ -238,11 +278,7 @@ namespace mongo {
             }
 
             // If we're here we are done reading results.  Move to the next state.
-            _scoreIterator = _scores.begin();
-            _internalState = RETURNING_RESULTS;
-
-            // Don't need to keep these around.
-            _scanners.clear();
+            doneReadingTerms();
             return PlanStage::NEED_TIME;
         }
         else {
@@ -263,6 +299,26 @@ namespace mongo {
         }
     }
 
+    void TextStage::doneReadingTerms() {
+        if (_params.limit > 0) {
+            // Everything else we've scored can't make the cut.
+            _scores.clear();
+            for (TopResults::const_iterator it = _topResults.begin();
+                 it != _topResults.end();
+                 ++it) {
+                _scores[it->second] = it->first;
+            }
+            _topResults.clear();
+            _termScoreBounds.clear();
+        }
+
+        _scoreIterator = _scores.begin();
+        _internalState = RETURNING_RESULTS;
+
+        // Don't need to keep these around.
+        _scanners.clear();
+    }
+
     PlanStage::StageState TextStage::returnResults(WorkingSetID* out) {
         if (_scoreIterator == _scores.end()) {
             _internalState = DONE;
@@ -279,8 +335,9 @@ namespace mongo {
             return PlanStage::NEED_TIME;
         }
 
-        // Filter for phrases and negated terms
-        if (_params.query.hasNonTermPieces()) {
+        // Filter for phrases and negated terms.  Already done when the document was scored if
+        // there is a limit.
+        if (_params.query.hasNonTermPieces() && 0 == _params.limit) {
             if (!_ftsMatcher.matchesNonTerm(_params.index->getCollection()->docFor(_txn, loc))) {
                 return PlanStage::NEED_TIME;
             }
@@ -405,4 +462,91 @@ namespace mongo {
         *documentAggregateScore += documentTermScore;
     }
 
+    void TextStage::addTermTopK(const BSONObj& key, const RecordId& loc) {
+        ++_specificStats.keysExamined;
+
+        // Locate score within possibly compound key: {prefix,term,score,suffix}.
+        BSONObjIterator keyIt(key);
+        for (unsigned i = 0; i < _params.spec.numExtraBefore(); i++) {
+            keyIt.next();
+        }
+
+        keyIt.next(); // Skip past 'term'.
+
+        BSONElement scoreElement = keyIt.next();
+        _termScoreBounds[_currentIndexScanner] = scoreElement.number();
+
+        if (_scores.end() != _scores.find(loc)) {
+            // Already scored or rejected, through another term.
+            return;
+        }
+
+        const Collection* collection = _params.index->getCollection();
+
+        if (_filter) {
+            bool fetched = false;
+            TextMatchableDocument tdoc(_txn,
+                                       _params.index->keyPattern(),
+                                       key,
+                                       loc,
+                                       collection,
+                                       &fetched);
+
+            if (!_filter->matches(&tdoc)) {
+                if (fetched) {
+                    ++_specificStats.fetches;
+                }
+                _scores[loc] = -1;
+                return;
+            }
+        }
+
+        // Score the whole document now rather than summing its terms' keys as we come across
+        // them, since we stop before reading them all.
+        ++_specificStats.fetches;
+        BSONObj obj = collection->docFor(_txn, loc);
+
+        if (_params.query.hasNonTermPieces() && !_ftsMatcher.matchesNonTerm(obj)) {
+            _scores[loc] = -1;
+            return;
+        }
+
+        fts::TermFrequencyMap termFrequencies;
+        _params.spec.scoreDocument(obj, &termFrequencies);
+
+        double score = 0;
+        const vector<string>& terms = _params.query.getTerms();
+        for (size_t i = 0; i < terms.size(); i++) {
+            fts::TermFrequencyMap::const_iterator it = termFrequencies.find(terms[i]);
+            if (it != termFrequencies.end()) {
+                score += it->second;
+            }
+        }
+
+        _scores[loc] = score;
+
+        if (_topResults.size() < _params.limit) {
+            _topResults.insert(std::make_pair(score, loc));
+        }
+        else if (score > _topResults.begin()->first) {
+            _topResults.erase(_topResults.begin());
+            _topResults.insert(std::make_pair(score, loc));
+        }
+    }
+
+    bool TextStage::haveTopK() const {
+        if (_topResults.size() < _params.limit) {
+            return false;
+        }
+
+        // A document we haven't seen yet can at best have the highest remaining score in each
+        // term's postings.
+        double unseenBound = 0;
+        for (size_t i = 0; i < _termScoreBounds.size(); i++) {
+            unseenBound += _termScoreBounds[i];
+        }
+
+        return _topResults.begin()->first >= unseenBound;
+    }
+
 }  // namespace mongo
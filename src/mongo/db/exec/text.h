@@ -55,7 +55,7 @@ namespace mongo {
     class OperationContext;
 
     struct TextStageParams {
-        TextStageParams(const FTSSpec& s) : spec(s) {}
+        TextStageParams(const FTSSpec& s) : spec(s), limit(0) {}
 
         // Text index descriptor.  IndexCatalog owns this.
         IndexDescriptor* index;
@@ -68,11 +68,23 @@ namespace mongo {
 
         // The text query.
         FTSQuery query;
+
+        // If non-zero, only the 'limit' highest scoring results are wanted: the planner sets
+        // this when the stage feeds a sort on the text score with a limit.  The stage may then
+        // stop reading the index early, and returns at most 'limit' results.
+        size_t limit;
     };
 
     /**
      * Implements a blocking stage that returns text search results.
      *
+     * Without a limit every posting of every term is read before any result is returned.  With
+     * one, the stage runs the threshold algorithm: the terms' postings, which the index keeps in
+     * descending score order, are read in turn; the first time a document is seen it is fetched
+     * and its full score computed; reading stops once 'limit' documents score at least the sum
+     * of the scores last read from each term, which bounds the score of any document not yet
+     * seen.
+     *
      * Prerequisites: None; is a leaf node.
      * Output type: LOC_AND_OBJ_UNOWNED.
      *
@@ -143,6 +155,24 @@ namespace mongo {
          */
         void addTerm(const BSONObj& key, const RecordId& loc);
 
+        /**
+         * Helper called from readFromSubScanners in place of addTerm when there is a limit.
+         * Scores the document the first time it is seen and keeps the 'limit' best in
+         * _topResults.
+         */
+        void addTermTopK(const BSONObj& key, const RecordId& loc);
+
+        /**
+         * With a limit, returns true once no document that hasn't been seen yet can score higher
+         * than the lowest of the current _topResults.
+         */
+        bool haveTopK() const;
+
+        /**
+         * Moves to RETURNING_RESULTS once all the scores needed are known.
+         */
+        void doneReadingTerms();
+
         /**
          * Possibly return a result.  FYI, this may perform a fetch directly if it is needed to
          * evaluate all filters.
@@ -178,9 +208,19 @@ namespace mongo {
         // Which _scanners are we currently reading from?
         size_t _currentIndexScanner;
 
+        // Used in READING_TERMS when there is a limit.  The score of the last key read from each
+        // of _scanners, or 0 once it is exhausted; no key left in a scanner scores higher.
+        std::vector<double> _termScoreBounds;
+
+        // Used in READING_TERMS when there is a limit.  The best scoring documents seen so far,
+        // at most params.limit of them.
+        typedef std::multimap<double, RecordId> TopResults;
+        TopResults _topResults;
+
         // Temporary score data filled out by sub-scans.  Used in READING_TERMS and
         // RETURNING_RESULTS.
-        // Maps from diskloc -> aggregate score for doc.
+        // Maps from diskloc -> aggregate score for doc.  With a limit, only _topResults are
+        // kept for RETURNING_RESULTS.
         typedef unordered_map<RecordId, double, RecordId::Hasher> ScoreMap;
         ScoreMap _scores;
         ScoreMap::const_iterator _scoreIterator;
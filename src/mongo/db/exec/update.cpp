@@ -493,6 +493,27 @@ namespace mongo {
             }
         }
 
+        // Damages which append to the document grow the record, which the record store may
+        // not be able to do in place. If so, fall back to writing out the whole document.
+        if (inPlace && !_damages.empty()) {
+            invariant(_collection);
+            const size_t newSize = mutablebson::getDamagedSize(oldObj.objsize(), _damages);
+            if (newSize > static_cast<size_t>(oldObj.objsize()) &&
+                (newSize > static_cast<size_t>(BSONObjMaxUserSize) ||
+                 !_collection->getRecordStore()->updateWithDamagesCanGrow(_txn, loc, newSize))) {
+                inPlace = false;
+            }
+        }
+
+        // A record store which places documents by their contents may have to move this one.
+        if (inPlace && !_damages.empty()) {
+            const RecordData oldRec(oldObj.objdata(), oldObj.objsize());
+            if (_collection->getRecordStore()->updateWithDamagesMovesRecord(_txn, loc, oldRec,
+                                                                            source, _damages)) {
+                inPlace = false;
+            }
+        }
+
         {
             WriteUnitOfWork wunit(_txn);
 
@@ -525,11 +546,16 @@ namespace mongo {
                 // Don't actually do the write if this is an explain.
                 if (!request->isExplain()) {
                     invariant(_collection);
+                    // A replacement does not report which fields it changed, so every index
+                    // must be checked.
+                    const FieldRefSet* changedFields =
+                        driver->isDocReplacement() ? NULL : &updatedFields;
                     StatusWith<RecordId> res = _collection->updateDocument(_txn,
                                                                           loc,
                                                                           newObj,
                                                                           true,
-                                                                          _params.opDebug);
+                                                                          _params.opDebug,
+                                                                          changedFields);
                     uassertStatusOK(res.getStatus());
                     RecordId newLoc = res.getValue();
 
@@ -687,7 +713,7 @@ namespace mongo {
         ++_commonStats.works;
 
         // Adds the amount of time taken by work() to executionTimeMillis.
-        ScopedTimer timer(&_commonStats.executionTimeMillis);
+        ScopedTimer timer(&_commonStats);
 
         if (isEOF()) { return PlanStage::IS_EOF; }
 
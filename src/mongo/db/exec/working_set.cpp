@@ -28,6 +28,8 @@
 
 #include "mongo/db/exec/working_set.h"
 
+#include <algorithm>
+
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/storage/record_fetcher.h"
 
@@ -39,8 +41,8 @@ namespace mongo {
     WorkingSet::WorkingSet() : _freeList(INVALID_ID) { }
 
     WorkingSet::~WorkingSet() {
-        for (size_t i = 0; i < _data.size(); i++) {
-            delete _data[i].member;
+        for (size_t i = 0; i < _memberChunks.size(); i++) {
+            delete [] _memberChunks[i];
         }
     }
 
@@ -50,9 +52,12 @@ namespace mongo {
             // vector::resize being amortized O(1) for efficient allocation. Note that the free list
             // remains empty until something is returned by a call to free().
             WorkingSetID id = _data.size();
+            if (0 == id % kMembersPerChunk) {
+                _memberChunks.push_back(new WorkingSetMember[kMembersPerChunk]);
+            }
             _data.resize(_data.size() + 1);
             _data.back().nextFreeOrSelf = id;
-            _data.back().member = new WorkingSetMember();
+            _data.back().member = &_memberChunks.back()[id % kMembersPerChunk];
             return id;
         }
 
@@ -90,9 +95,10 @@ namespace mongo {
     }
 
     void WorkingSet::clear() {
-        for (size_t i = 0; i < _data.size(); i++) {
-            delete _data[i].member;
+        for (size_t i = 0; i < _memberChunks.size(); i++) {
+            delete [] _memberChunks[i];
         }
+        _memberChunks.clear();
         _data.clear();
 
         // Since working set is now empty, the free list pointer should
@@ -102,7 +108,7 @@ namespace mongo {
         _flagged.clear();
     }
 
-    WorkingSetMember::WorkingSetMember() : state(WorkingSetMember::INVALID) { }
+    WorkingSetMember::WorkingSetMember() : state(WorkingSetMember::INVALID), _keyBufferBytes(0) { }
 
     WorkingSetMember::~WorkingSetMember() { }
 
@@ -114,6 +120,7 @@ namespace mongo {
         keyData.clear();
         obj = BSONObj();
         state = WorkingSetMember::INVALID;
+        _fieldIndex.clear();
     }
 
     bool WorkingSetMember::hasLoc() const {
@@ -161,7 +168,18 @@ namespace mongo {
     bool WorkingSetMember::getFieldDotted(const string& field, BSONElement* out) const {
         // If our state is such that we have an object, use it.
         if (hasObj()) {
-            *out = obj.getFieldDotted(field);
+            // Same as obj.getFieldDotted(field), with the top-level lookups done by the index.
+            *out = _fieldIndex.getField(obj, field);
+            if (out->eoo()) {
+                const size_t dot = field.find('.');
+                if (dot != string::npos) {
+                    const BSONElement sub =
+                        _fieldIndex.getField(obj, StringData(field).substr(0, dot));
+                    if (Object == sub.type() || Array == sub.type()) {
+                        *out = sub.embeddedObject().getFieldDotted(field.substr(dot + 1));
+                    }
+                }
+            }
             return true;
         }
 
@@ -185,6 +203,19 @@ namespace mongo {
         return false;
     }
 
+    BSONObj WorkingSetMember::copyKey(const BSONObj& key) {
+        const size_t keyBytes = key.objsize();
+
+        // The buffer can only be overwritten if the key copied into it last time is gone.
+        if (_keyBuffer.isShared() || NULL == _keyBuffer.get() || keyBytes > _keyBufferBytes) {
+            _keyBufferBytes = std::max(keyBytes, static_cast<size_t>(kMinKeyBufferBytes));
+            _keyBuffer = SharedBuffer::allocate(_keyBufferBytes);
+        }
+
+        memcpy(_keyBuffer.get(), key.objdata(), keyBytes);
+        return BSONObj(_keyBuffer.get(), _keyBuffer);
+    }
+
     size_t WorkingSetMember::getMemUsage() const {
         size_t memUsage = 0;
 
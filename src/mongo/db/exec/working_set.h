@@ -32,9 +32,11 @@
 #include <vector>
 
 #include "mongo/base/disallow_copying.h"
+#include "mongo/bson/bson_field_index.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/record_id.h"
 #include "mongo/platform/unordered_set.h"
+#include "mongo/util/shared_buffer.h"
 
 namespace mongo {
 
@@ -116,14 +118,21 @@ namespace mongo {
             // Free list link if freed. Points to self if in use.
             WorkingSetID nextFreeOrSelf;
 
-            // Owning pointer
+            // Points into one of the chunks in _memberChunks.
             WorkingSetMember* member;
         };
 
+        // Members are allocated this many at a time rather than one by one.
+        enum { kMembersPerChunk = 64 };
+
         // All WorkingSetIDs are indexes into this, except for INVALID_ID.
         // Elements are added to _freeList rather than removed when freed.
         std::vector<MemberHolder> _data;
 
+        // Owns the members pointed to by '_data'. Member i lives at
+        // _memberChunks[i / kMembersPerChunk][i % kMembersPerChunk].
+        std::vector<WorkingSetMember*> _memberChunks;
+
         // Index into _data, forming a linked-list using MemberHolder::nextFreeOrSelf as the next
         // link. INVALID_ID is the list terminator since 0 is a valid index.
         // If _freeList == INVALID_ID, the free list is empty and all elements in _data are in use.
@@ -264,15 +273,41 @@ namespace mongo {
          */
         bool getFieldDotted(const std::string& field, BSONElement* out) const;
 
+        /**
+         * Index over the top-level fields of 'obj', shared by everything that looks up fields of
+         * this member: the filters of each stage, and the sort and projection stages through
+         * getFieldDotted.  It notices when 'obj' is replaced and is emptied by clear().
+         */
+        BSONFieldIndex* fieldIndex() const { return &_fieldIndex; }
+
         /**
          * Returns expected memory usage of working set member.
          */
         size_t getMemUsage() const;
 
+        /**
+         * Returns an owned copy of the index key 'key', suitable for 'keyData'.
+         *
+         * The copy is made in a buffer which the member keeps when it is freed and reuses the
+         * next time it is allocated, as long as nothing else still refers to the previous key and
+         * the new key fits.  Index scans over small keys therefore stop allocating once their
+         * members have been recycled.
+         */
+        BSONObj copyKey(const BSONObj& key);
+
     private:
+        // Key buffers are never smaller than this, which fits the common one to three field keys.
+        enum { kMinKeyBufferBytes = 64 };
+
         boost::scoped_ptr<WorkingSetComputedData> _computed[WSM_COMPUTED_NUM_TYPES];
 
+        // Backs the key returned by the last call to copyKey().
+        SharedBuffer _keyBuffer;
+        size_t _keyBufferBytes;
+
         std::auto_ptr<RecordFetcher> _fetcher;
+
+        mutable BSONFieldIndex _fieldIndex;
     };
 
 }  // namespace mongo
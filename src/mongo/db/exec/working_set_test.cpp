@@ -147,4 +147,57 @@ namespace {
         ASSERT_FALSE(member->getFieldDotted("y", &elt));
     }
 
+    TEST_F(WorkingSetFixture, copyKeyReusesBuffer) {
+        BSONObj first = member->copyKey(BSON("" << 1 << "" << 2));
+        ASSERT(first.isOwned());
+        ASSERT_EQUALS(first, BSON("" << 1 << "" << 2));
+        const char* buffer = first.objdata();
+
+        // While 'first' is alive the buffer may not be overwritten.
+        BSONObj second = member->copyKey(BSON("" << 3));
+        ASSERT_NOT_EQUALS(static_cast<const void*>(buffer),
+                          static_cast<const void*>(second.objdata()));
+        ASSERT_EQUALS(first, BSON("" << 1 << "" << 2));
+        ASSERT_EQUALS(second, BSON("" << 3));
+
+        // Once the key is gone, a key that fits is copied into the same buffer.
+        buffer = second.objdata();
+        second = BSONObj();
+        BSONObj third = member->copyKey(BSON("" << 4));
+        ASSERT_EQUALS(static_cast<const void*>(buffer),
+                      static_cast<const void*>(third.objdata()));
+        ASSERT_EQUALS(third, BSON("" << 4));
+    }
+
+    TEST_F(WorkingSetFixture, copyKeyGrowsBuffer) {
+        BSONObjBuilder bob;
+        for (int i = 0; i < 100; i++) {
+            bob.append("", i);
+        }
+        BSONObj bigKey = bob.obj();
+
+        BSONObj copy = member->copyKey(bigKey);
+        ASSERT_EQUALS(copy, bigKey);
+    }
+
+    TEST(WorkingSetTest, manyMembers) {
+        WorkingSet ws;
+        std::vector<WorkingSetID> ids;
+        for (int i = 0; i < 1000; i++) {
+            WorkingSetID id = ws.allocate();
+            ws.get(id)->obj = BSON("x" << i);
+            ws.get(id)->state = WorkingSetMember::OWNED_OBJ;
+            ids.push_back(id);
+        }
+
+        for (int i = 0; i < 1000; i++) {
+            ASSERT_EQUALS(ws.get(ids[i])->obj["x"].numberInt(), i);
+        }
+
+        // Freed members are handed out again before new ones are made.
+        ws.free(ids[500]);
+        ASSERT_EQUALS(ws.allocate(), ids[500]);
+        ASSERT_EQUALS(WorkingSetMember::INVALID, ws.get(ids[500])->state);
+    }
+
 }  // namespace
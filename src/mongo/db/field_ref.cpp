@@ -30,6 +30,7 @@
 
 #include <algorithm> // for min
 
+#include "mongo/db/field_ref_table.h"
 #include "mongo/util/assert_util.h"
 
 namespace mongo {
@@ -87,6 +88,25 @@ namespace mongo {
         }
     }
 
+    void FieldRef::parseInterned(const StringData& path) {
+        if (path.size() == 0) {
+            return;
+        }
+
+        if (_size != 0) {
+            clear();
+        }
+
+        // The interned FieldRef is never modified, so its parts stay valid while we hold it.
+        _interned = FieldRefTable::intern(path);
+        _dotted.clear();
+
+        const size_t numParts = _interned->numParts();
+        for (size_t i = 0; i < numParts; i++) {
+            appendPart(_interned->getPart(i));
+        }
+    }
+
     void FieldRef::setPart(size_t i, const StringData& part) {
         dassert(i < _size);
 
@@ -146,8 +166,9 @@ namespace mongo {
             }
         }
 
-        // Drop any replacements
+        // Drop any replacements, and the interned parts we no longer point to
         _replacements.clear();
+        _interned.reset();
     }
 
     StringData FieldRef::getPart(size_t i) const {
@@ -206,7 +227,7 @@ namespace mongo {
             reserialize();
         dassert(_replacements.empty());
 
-        StringData result(_dotted);
+        StringData result(_interned ? _interned->_dotted : _dotted);
 
         // Fast-path if we want the whole thing
         if (startPart == 0 && endPart == numParts())
@@ -280,6 +301,7 @@ namespace mongo {
         _variable.clear();
         _dotted.clear();
         _replacements.clear();
+        _interned.reset();
     }
 
     std::ostream& operator<<(std::ostream& stream, const FieldRef& field) {
@@ -29,6 +29,7 @@
 #pragma once
 
 #include <boost/scoped_array.hpp>
+#include <boost/shared_ptr.hpp>
 #include <iosfwd>
 #include <string>
 #include <vector>
@@ -66,6 +67,13 @@ namespace mongo {
          */
         void parse(const StringData& dottedField);
 
+        /**
+         * Same as parse(), except that the field parts are shared with the copy of
+         * 'dottedField' interned in the FieldRefTable instead of being copied and split again.
+         * The first setPart() call after that gives this FieldRef parts of its own.
+         */
+        void parseInterned(const StringData& dottedField);
+
         /**
          * Sets the 'i-th' field part to point to 'part'. Assumes i < size(). Behavior is
          * undefined otherwise.
@@ -171,6 +179,10 @@ namespace mongo {
 
         // back memory added with the setPart call pointed to by _fized and _variable
         mutable std::vector<std::string> _replacements;
+
+        // the interned FieldRef whose _dotted backs the parts, when set by parseInterned(), in
+        // which case _dotted is empty
+        mutable boost::shared_ptr<const FieldRef> _interned;
     };
 
     inline bool operator==(const FieldRef& lhs, const FieldRef& rhs) {
@@ -0,0 +1,106 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/field_ref_table.h"
+
+#include "mongo/platform/unordered_map.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    using boost::shared_ptr;
+
+    namespace {
+
+        const size_t kPartitions = 16;
+        const size_t kMaxPathsPerPartition = FieldRefTable::kMaxPaths / kPartitions;
+
+        // The keys point into the dotted field of the FieldRef they map to, which is never
+        // reserialized since the FieldRef is never modified.
+        typedef unordered_map<StringData, shared_ptr<const FieldRef>, StringData::Hasher> PathMap;
+
+        struct Partition {
+            Partition() : mutex("fieldRefTable") {}
+
+            SimpleMutex mutex;
+            PathMap paths;
+        };
+
+        Partition partitions[kPartitions];
+
+        Partition& partitionFor(const StringData& path) {
+            return partitions[StringData::Hasher()(path) % kPartitions];
+        }
+
+    } // namespace
+
+    // static
+    shared_ptr<const FieldRef> FieldRefTable::intern(const StringData& path) {
+        Partition& partition = partitionFor(path);
+        {
+            SimpleMutex::scoped_lock lk(partition.mutex);
+            PathMap::const_iterator it = partition.paths.find(path);
+            if (it != partition.paths.end()) {
+                return it->second;
+            }
+        }
+
+        // Parse outside of the lock. Should another thread intern the same path in the
+        // meantime, its copy wins and this one is dropped.
+        shared_ptr<const FieldRef> parsed(new FieldRef(path));
+
+        SimpleMutex::scoped_lock lk(partition.mutex);
+        if (partition.paths.size() >= kMaxPathsPerPartition) {
+            partition.paths.clear();
+        }
+        std::pair<PathMap::iterator, bool> inserted =
+            partition.paths.insert(std::make_pair(parsed->dottedField(), parsed));
+        return inserted.first->second;
+    }
+
+    // static
+    size_t FieldRefTable::size() {
+        size_t total = 0;
+        for (size_t i = 0; i < kPartitions; i++) {
+            SimpleMutex::scoped_lock lk(partitions[i].mutex);
+            total += partitions[i].paths.size();
+        }
+        return total;
+    }
+
+    // static
+    void FieldRefTable::clear() {
+        for (size_t i = 0; i < kPartitions; i++) {
+            SimpleMutex::scoped_lock lk(partitions[i].mutex);
+            partitions[i].paths.clear();
+        }
+    }
+
+} // namespace mongo
@@ -0,0 +1,74 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/shared_ptr.hpp>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/db/field_ref.h"
+
+namespace mongo {
+
+    /**
+     * A process-wide table of parsed dotted paths. Queries, updates and projections of the same
+     * shape name the same paths over and over; interning them lets every operation share one
+     * immutable, already split FieldRef per path rather than copying and splitting the path
+     * again (see FieldRef::parseInterned()).
+     *
+     * The table is bounded. It is split into partitions by path hash, and a partition that
+     * fills up is emptied. FieldRefs handed out earlier stay valid for as long as their holders
+     * keep them.
+     *
+     * The class is thread safe.
+     */
+    class FieldRefTable {
+        MONGO_DISALLOW_COPYING(FieldRefTable);
+    public:
+        // The most paths the table holds at any time.
+        static const size_t kMaxPaths = 16 * 1024;
+
+        /**
+         * Returns the interned, parsed copy of 'path'. The returned FieldRef must not be
+         * modified.
+         */
+        static boost::shared_ptr<const FieldRef> intern(const StringData& path);
+
+        /**
+         * Returns the number of paths held by the table.
+         */
+        static size_t size();
+
+        /**
+         * Drops every path held by the table. For testing.
+         */
+        static void clear();
+    };
+
+} // namespace mongo
@@ -0,0 +1,103 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/field_ref_table.h"
+
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace {
+
+    using boost::shared_ptr;
+    using mongo::FieldRef;
+    using mongo::FieldRefTable;
+    using mongoutils::str::stream;
+
+    TEST(FieldRefTable, SamePathSharesOneFieldRef) {
+        FieldRefTable::clear();
+        shared_ptr<const FieldRef> first = FieldRefTable::intern("a.b.c");
+        shared_ptr<const FieldRef> second = FieldRefTable::intern(std::string("a.b.c"));
+        ASSERT_EQUALS(first.get(), second.get());
+        ASSERT_EQUALS(3U, first->numParts());
+        ASSERT_EQUALS("a.b.c", first->dottedField());
+
+        ASSERT_NOT_EQUALS(first.get(), FieldRefTable::intern("a.b").get());
+        ASSERT_EQUALS(2U, FieldRefTable::size());
+    }
+
+    TEST(FieldRefTable, IsBounded) {
+        FieldRefTable::clear();
+        shared_ptr<const FieldRef> kept = FieldRefTable::intern("kept.path");
+        for (size_t i = 0; i < 2 * FieldRefTable::kMaxPaths; i++) {
+            FieldRefTable::intern(std::string(stream() << "p" << i << ".x"));
+        }
+        ASSERT_LESS_THAN_OR_EQUALS(FieldRefTable::size(), FieldRefTable::kMaxPaths);
+
+        // A path dropped from the table stays valid for its holders.
+        ASSERT_EQUALS("kept.path", kept->dottedField());
+        ASSERT_EQUALS("path", kept->getPart(1));
+    }
+
+    TEST(ParseInterned, SameAsParse) {
+        const char* paths[] = { "a", "a.b", "a..b", "a.", "a.b.c.d.e.f", "$.a.$" };
+        for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); i++) {
+            FieldRef parsed(paths[i]);
+            FieldRef interned;
+            interned.parseInterned(paths[i]);
+            ASSERT_EQUALS(parsed, interned);
+            ASSERT_EQUALS(parsed.numParts(), interned.numParts());
+            ASSERT_EQUALS(parsed.dottedField(), interned.dottedField());
+            ASSERT_EQUALS(parsed.dottedSubstring(1, parsed.numParts()),
+                          interned.dottedSubstring(1, interned.numParts()));
+        }
+    }
+
+    TEST(ParseInterned, ReplacingAPartLeavesTheInternedPathAlone) {
+        FieldRef first;
+        first.parseInterned("a.$.c.d.e.$");
+        first.setPart(1, "0");
+        first.setPart(5, "12");
+        ASSERT_EQUALS("a.0.c.d.e.12", first.dottedField());
+
+        FieldRef second;
+        second.parseInterned("a.$.c.d.e.$");
+        ASSERT_EQUALS("a.$.c.d.e.$", second.dottedField());
+        ASSERT_EQUALS("a.$.c.d.e.$", FieldRefTable::intern("a.$.c.d.e.$")->dottedField());
+
+        // Parsing again drops the replacements.
+        first.parseInterned("x.y");
+        ASSERT_EQUALS("x.y", first.dottedField());
+        first.parse("a.b");
+        ASSERT_EQUALS("a.b", first.dottedField());
+        first.clear();
+        ASSERT_EQUALS(0U, first.numParts());
+    }
+
+} // namespace
@@ -118,7 +118,7 @@ namespace mongo {
             string word = tolowerString( term );
             if ( sw->isStopWord( word ) )
                 return;
-            word = stemmer.stem( word );
+            word = stemmer.stem( word ).toString();
             if ( negated )
                 _negatedTerms.insert( word );
             else
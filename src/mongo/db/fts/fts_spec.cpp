@@ -165,8 +165,9 @@ namespace mongo {
 
             while ( it.more() ) {
                 FTSIteratorValue val = it.next();
-                Stemmer stemmer( *val._language );
-                Tools tools( *val._language, &stemmer, StopWords::getStopWords( *val._language ) );
+                Tools tools( *val._language,
+                             &Stemmer::forCurrentThread( *val._language ),
+                             StopWords::getStopWords( *val._language ) );
                 _scoreStringV2( tools, val._text, term_freqs, val._weight );
             }
         }
@@ -180,18 +181,22 @@ namespace mongo {
 
             unsigned numTokens = 0;
 
+            // Reused for every token, so that only the first occurrence of a term allocates.
+            string term;
+
             Tokenizer i( tools.language, raw );
             while ( i.more() ) {
                 Token t = i.next();
                 if ( t.type != Token::TEXT )
                     continue;
 
-                string term = t.data.toString();
+                term.assign( t.data.rawData(), t.data.size() );
                 makeLower( &term );
                 if ( tools.stopwords->isStopWord( term ) ) {
                     continue;
                 }
-                term = tools.stemmer->stem( term );
+                const StringData stemmed = tools.stemmer->stem( term );
+                term.assign( stemmed.rawData(), stemmed.size() );
 
                 ScoreHelperStruct& data = terms[term];
 
@@ -70,17 +70,21 @@ namespace mongo {
 
             unsigned numTokens = 0;
 
+            // Reused for every token, so that only the first occurrence of a term allocates.
+            string term;
+
             Tokenizer i( tools.language, raw );
             while ( i.more() ) {
                 Token t = i.next();
                 if ( t.type != Token::TEXT )
                     continue;
 
-                string term = t.data.toString();
+                term.assign( t.data.rawData(), t.data.size() );
                 makeLower( &term );
                 if ( tools.stopwords->isStopWord( term ) )
                     continue;
-                term = tools.stemmer->stem( term );
+                const StringData stemmed = tools.stemmer->stem( term );
+                term.assign( stemmed.rawData(), stemmed.size() );
 
                 ScoreHelperStruct& data = terms[term];
 
@@ -160,8 +164,9 @@ namespace mongo {
 
             const FTSLanguage& language = _getLanguageToUseV1( obj );
 
-            Stemmer stemmer(language);
-            Tools tools(language, &stemmer, StopWords::getStopWords( language ));
+            Tools tools(language,
+                        &Stemmer::forCurrentThread( language ),
+                        StopWords::getStopWords( language ));
 
             if ( wildcard() ) {
                 // if * is specified for weight, we can recurse over all fields.
@@ -51,11 +51,16 @@ namespace mongo {
 
         /**
          * destructive!
+         * Only folds ASCII, as tolower() does in the "C" locale the server runs in, but without
+         * a call per character.
          */
         inline void makeLower( std::string* s ) {
             std::string::size_type sz = s->size();
-            for ( std::string::size_type i = 0; i < sz; i++ )
-                (*s)[i] = (char)tolower( (int)(*s)[i] );
+            for ( std::string::size_type i = 0; i < sz; i++ ) {
+                char c = (*s)[i];
+                if ( c >= 'A' && c <= 'Z' )
+                    (*s)[i] = c + ( 'a' - 'A' );
+            }
         }
 
         struct _be_hash {
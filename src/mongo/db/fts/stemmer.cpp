@@ -29,13 +29,43 @@
 */
 
 #include <cstdlib>
+#include <map>
 #include <string>
 
 #include "mongo/db/fts/stemmer.h"
+#include "mongo/util/concurrency/threadlocal.h"
 #include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
 
+    namespace fts {
+        namespace {
+            // Owns one thread's stemmers, keyed by language.  FTSLanguage instances are
+            // registered once at startup, so their addresses are stable keys.
+            class ThreadStemmers {
+            public:
+                ~ThreadStemmers() {
+                    for ( Map::iterator i = _stemmers.begin(); i != _stemmers.end(); ++i )
+                        delete i->second;
+                }
+
+                const Stemmer& get( const FTSLanguage& language ) {
+                    Stemmer*& stemmer = _stemmers[&language];
+                    if ( !stemmer )
+                        stemmer = new Stemmer( language );
+                    return *stemmer;
+                }
+
+            private:
+                typedef std::map<const FTSLanguage*, Stemmer*> Map;
+                Map _stemmers;
+            };
+        }
+    }
+
+    TSP_DECLARE(fts::ThreadStemmers, threadStemmers);
+    TSP_DEFINE(fts::ThreadStemmers, threadStemmers);
+
     namespace fts {
 
         Stemmer::Stemmer( const FTSLanguage& language ) {
@@ -51,9 +81,9 @@ namespace mongo {
             }
         }
 
-        string Stemmer::stem( const StringData& word ) const {
+        StringData Stemmer::stem( const StringData& word ) const {
             if ( !_stemmer )
-                return word.toString();
+                return word;
 
             const sb_symbol* sb_sym = sb_stemmer_stem( _stemmer,
                                                        (const sb_symbol*)word.rawData(),
@@ -64,7 +94,11 @@ namespace mongo {
                 abort();
             }
 
-            return string( (const char*)(sb_sym), sb_stemmer_length( _stemmer ) );
+            return StringData( (const char*)(sb_sym), sb_stemmer_length( _stemmer ) );
+        }
+
+        const Stemmer& Stemmer::forCurrentThread( const FTSLanguage& language ) {
+            return threadStemmers.getMake()->get( language );
         }
 
     }
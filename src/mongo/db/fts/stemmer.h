@@ -33,6 +33,7 @@
 
 #include <string>
 
+#include "mongo/base/disallow_copying.h"
 #include "mongo/base/string_data.h"
 #include "mongo/db/fts/fts_language.h"
 #include "third_party/libstemmer_c/include/libstemmer.h"
@@ -47,11 +48,24 @@ namespace mongo {
          * running/Running -> run/Run
          */
         class Stemmer {
+            MONGO_DISALLOW_COPYING( Stemmer );
         public:
             Stemmer( const FTSLanguage& language );
             ~Stemmer();
 
-            std::string stem( const StringData& word ) const;
+            /**
+             * The result points into this stemmer's own buffer (or at 'word', if the language
+             * doesn't stem), so it is only valid until the next call to stem().
+             */
+            StringData stem( const StringData& word ) const;
+
+            /**
+             * Returns the calling thread's stemmer for 'language', creating it the first time.
+             * Creating a stemmer allocates libstemmer's working buffers, which is too costly to
+             * do for every string scored.
+             */
+            static const Stemmer& forCurrentThread( const FTSLanguage& language );
+
         private:
             struct sb_stemmer* _stemmer;
         };
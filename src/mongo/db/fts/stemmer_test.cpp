@@ -49,5 +49,12 @@ namespace mongo {
             ASSERT_EQUALS( "Unite", s.stem( "United" ) );
         }
 
+        TEST( English, ThreadStemmerReused ) {
+            const Stemmer& s = Stemmer::forCurrentThread( languageEnglishV2 );
+            ASSERT_EQUALS( &s, &Stemmer::forCurrentThread( languageEnglishV2 ) );
+            ASSERT_NOT_EQUALS( &s, &Stemmer::forCurrentThread( languagePorterV1 ) );
+            ASSERT_EQUALS( "run", s.stem( "running" ) );
+        }
+
     }
 }
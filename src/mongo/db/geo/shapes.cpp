@@ -30,6 +30,10 @@
 #include "mongo/db/geo/shapes.h"
 #include "mongo/util/mongoutils/str.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 // So we can get at the str namespace.
 using namespace mongoutils;
 
@@ -578,6 +582,39 @@ namespace mongo {
         return sqrt((a * a) + (b * b));
     }
 
+    void distancesWithin(const Point& center, double maxDistance,
+                         const double* xs, const double* ys, size_t n, bool* within) {
+        size_t i = 0;
+#if defined(__SSE2__)
+        // The same steps as distance(), two points at a time.
+        const __m128d cx = _mm_set1_pd(center.x);
+        const __m128d cy = _mm_set1_pd(center.y);
+        const __m128d max = _mm_set1_pd(maxDistance);
+        const __m128d zero = _mm_setzero_pd();
+        const __m128d signBit = _mm_set1_pd(-0.0);
+        for (; i + 2 <= n; i += 2) {
+            const __m128d a = _mm_sub_pd(cx, _mm_loadu_pd(xs + i));
+            const __m128d b = _mm_sub_pd(cy, _mm_loadu_pd(ys + i));
+            __m128d d = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(a, a), _mm_mul_pd(b, b)));
+
+            // Where b is 0 the distance is |a|, and where a is 0 it is |b|.
+            const __m128d bZero = _mm_cmpeq_pd(b, zero);
+            d = _mm_or_pd(_mm_and_pd(bZero, _mm_andnot_pd(signBit, a)), _mm_andnot_pd(bZero, d));
+            const __m128d aZero = _mm_cmpeq_pd(a, zero);
+            d = _mm_or_pd(_mm_and_pd(aZero, _mm_andnot_pd(signBit, b)), _mm_andnot_pd(aZero, d));
+
+            // "not greater than" rather than "less or equal", so NaN counts as within, as it
+            // does when comparing with distance().
+            const int mask = _mm_movemask_pd(_mm_cmpngt_pd(d, max));
+            within[i] = mask & 1;
+            within[i + 1] = mask & 2;
+        }
+#endif
+        for (; i < n; i++) {
+            within[i] = !(distance(center, Point(xs[i], ys[i])) > maxDistance);
+        }
+    }
+
     static inline Vector2_d toVector2(const Point& p) {
         return Vector2_d(p.x, p.y);
     }
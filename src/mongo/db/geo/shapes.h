@@ -79,6 +79,15 @@ namespace mongo {
     double distance(const Point& p1, const Point &p2);
     bool distanceWithin(const Point &p1, const Point &p2, double radius);
     double distanceCompare(const Point &p1, const Point &p2, double radius);
+
+    /**
+     * Sets within[i] to whether the point (xs[i], ys[i]) is no further than maxDistance from
+     * center, for each i < n.  This gives the same answers as comparing with distance() one
+     * point at a time.  The coordinates are in separate contiguous arrays so the loop can
+     * handle two points at a time with SSE2.
+     */
+    void distancesWithin(const Point& center, double maxDistance,
+                         const double* xs, const double* ys, size_t n, bool* within);
     // Still needed for non-wrapping $nearSphere
     double spheredist_rad(const Point& p1, const Point& p2);
     double spheredist_deg(const Point& p1, const Point& p2);
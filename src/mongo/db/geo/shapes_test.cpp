@@ -0,0 +1,93 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/geo/shapes.h"
+
+#include <limits>
+#include <vector>
+
+#include "mongo/platform/random.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+    using namespace mongo;
+    using std::vector;
+
+    // Checks distancesWithin() against distance() for every point.
+    void assertSameAsDistance(const Point& center, double maxDistance,
+                              const vector<double>& xs, const vector<double>& ys) {
+        vector<char> within(xs.size() + 1, 2);
+        distancesWithin(center, maxDistance, &xs[0], &ys[0], xs.size(),
+                        reinterpret_cast<bool*>(&within[0]));
+        for (size_t i = 0; i < xs.size(); i++) {
+            const bool expected = !(mongo::distance(center, Point(xs[i], ys[i])) > maxDistance);
+            ASSERT_EQUALS(expected, static_cast<bool>(within[i]));
+        }
+
+        // Nothing is written past the last point.
+        ASSERT_EQUALS(2, within[xs.size()]);
+    }
+
+    TEST(DistancesWithin, MatchesDistance) {
+        PseudoRandom random(123);
+        const Point center(10.5, -3.25);
+
+        for (size_t n = 1; n < 40; n++) {
+            vector<double> xs, ys;
+            for (size_t i = 0; i < n; i++) {
+                xs.push_back(center.x + (random.nextInt32(2000) - 1000) / 100.0);
+                ys.push_back(center.y + (random.nextInt32(2000) - 1000) / 100.0);
+            }
+            assertSameAsDistance(center, 5.0, xs, ys);
+        }
+    }
+
+    TEST(DistancesWithin, Boundaries) {
+        const Point center(1, 1);
+        vector<double> xs, ys;
+
+        // Exactly on the circle, along the axes, where distance() doesn't take a square root.
+        xs.push_back(1); ys.push_back(1.1);
+        xs.push_back(1.1); ys.push_back(1);
+        xs.push_back(1); ys.push_back(0.9);
+        xs.push_back(0.9); ys.push_back(1);
+
+        // The center itself, and a 3-4-5 triangle.
+        xs.push_back(1); ys.push_back(1);
+        xs.push_back(1.3); ys.push_back(1.4);
+
+        // NaN compares as within, the same as distance() does.
+        xs.push_back(std::numeric_limits<double>::quiet_NaN()); ys.push_back(1);
+
+        assertSameAsDistance(center, 0.1, xs, ys);
+        assertSameAsDistance(center, 0.5, xs, ys);
+        assertSameAsDistance(center, 0, xs, ys);
+    }
+
+} // namespace
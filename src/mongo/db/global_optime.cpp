@@ -29,6 +29,7 @@
 #define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kDefault
 
 #include "mongo/db/global_optime.h"
+#include "mongo/util/assert_util.h"
 #include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/log.h"
 
@@ -59,22 +60,29 @@ namespace mongo {
     }
 
     OpTime getNextGlobalOptime() {
+        return getNextGlobalOptimes(1);
+    }
+
+    OpTime getNextGlobalOptimes(unsigned count) {
+        invariant(count > 0);
         mutex::scoped_lock lk(globalOptimeMutex);
 
         const unsigned now = (unsigned) time(0);
         const unsigned globalSecs = globalOpTime.getSecs();
+        OpTime first;
         if ( globalSecs == now ) {
-            globalOpTime = OpTime(globalSecs, globalOpTime.getInc() + 1);
+            first = OpTime(globalSecs, globalOpTime.getInc() + 1);
         }
         else if ( now < globalSecs ) {
-            globalOpTime = OpTime(globalSecs, globalOpTime.getInc() + 1);
+            first = OpTime(globalSecs, globalOpTime.getInc() + 1);
             // separate function to keep out of the hot code path
-            fassert(17449, !skewed(globalOpTime));
+            fassert(17449, !skewed(OpTime(globalSecs, first.getInc() + count - 1)));
         }
         else {
-            globalOpTime = OpTime(now, 1);
+            first = OpTime(now, 1);
         }
 
-        return globalOpTime;
+        globalOpTime = OpTime(first.getSecs(), first.getInc() + count - 1);
+        return first;
     }
 }
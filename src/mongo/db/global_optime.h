@@ -42,4 +42,10 @@ namespace mongo {
      * Generates a new and unique OpTime.
      */
     OpTime getNextGlobalOptime();
+
+    /**
+     * Reserves 'count' new and unique OpTimes, which share their seconds and have consecutive
+     * increments, and returns the first of them.  getLastSetOptime() then returns the last.
+     */
+    OpTime getNextGlobalOptimes(unsigned count);
 }
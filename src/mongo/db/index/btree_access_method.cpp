@@ -52,10 +52,10 @@ namespace mongo {
             fixed.push_back(BSONElement());
         }
 
-        if (0 == _descriptor->version()) {
+        if (0 == _descriptor->keyFormatVersion()) {
             _keyGenerator.reset(new BtreeKeyGeneratorV0(fieldNames, fixed,
                 _descriptor->isSparse()));
-        } else if (1 == _descriptor->version()) {
+        } else if (1 == _descriptor->keyFormatVersion()) {
             _keyGenerator.reset(new BtreeKeyGeneratorV1(fieldNames, fixed,
                 _descriptor->isSparse()));
         } else {
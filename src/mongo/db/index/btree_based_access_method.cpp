@@ -30,10 +30,15 @@
 
 #include "mongo/db/index/btree_access_method.h"
 
+#include <map>
 #include <vector>
 
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
 #include "mongo/base/error_codes.h"
 #include "mongo/base/status.h"
+#include "mongo/db/catalog/collection.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/index/btree_based_bulk_access_method.h"
 #include "mongo/db/index/btree_index_cursor.h"
@@ -56,14 +61,48 @@ namespace mongo {
 
     BtreeBasedAccessMethod::InvalidateCursorsNotification BtreeBasedAccessMethod::invalidateCursors;
 
+    /**
+     * The keys which writes touched, by document, while the index was being bulk built. Writers
+     * record into it concurrently, each holding only an intent lock.
+     */
+    class BtreeBasedAccessMethod::SideWrites {
+    public:
+        typedef std::map<RecordId, BSONObjSet> KeysByLoc;
+
+        void record(const BSONObjSet& keys, const RecordId& loc) {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            BSONObjSet& recorded = _keysByLoc[loc];
+            for (BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i) {
+                recorded.insert(i->getOwned());
+            }
+        }
+
+        void record(const std::vector<BSONObj*>& keys, const RecordId& loc) {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            BSONObjSet& recorded = _keysByLoc[loc];
+            for (size_t i = 0; i < keys.size(); ++i) {
+                recorded.insert(keys[i]->getOwned());
+            }
+        }
+
+        // Only called once no writer can record any more.
+        const KeysByLoc& keysByLoc() const { return _keysByLoc; }
+
+    private:
+        boost::mutex _mutex;
+        KeysByLoc _keysByLoc;
+    };
+
     BtreeBasedAccessMethod::BtreeBasedAccessMethod(IndexCatalogEntry* btreeState,
                                                    SortedDataInterface* btree)
         : _btreeState(btreeState),
           _descriptor(btreeState->descriptor()),
           _newInterface(btree) {
-        verify(0 == _descriptor->version() || 1 == _descriptor->version());
+        verify(0 == _descriptor->keyFormatVersion() || 1 == _descriptor->keyFormatVersion());
     }
 
+    BtreeBasedAccessMethod::~BtreeBasedAccessMethod() { }
+
     bool BtreeBasedAccessMethod::ignoreKeyTooLong(OperationContext *txn) {
         // Ignore this error if we're on a secondary or if the user requested it
         return !txn->isPrimaryFor(_btreeState->ns()) || !failIndexKeyTooLong;
@@ -81,6 +120,15 @@ namespace mongo {
         // Delegate to the subclass.
         getKeys(obj, &keys);
 
+        if (_sideWrites) {
+            _sideWrites->record(keys, loc);
+            *numInserted = keys.size();
+            if (*numInserted > 1) {
+                _btreeState->setMultikey( txn );
+            }
+            return Status::OK();
+        }
+
         Status ret = Status::OK();
         for (BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i) {
             Status status = _newInterface->insert(txn, *i, loc, options.dupsAllowed);
@@ -154,6 +202,12 @@ namespace mongo {
         getKeys(obj, &keys);
         *numDeleted = 0;
 
+        if (_sideWrites) {
+            _sideWrites->record(keys, loc);
+            *numDeleted = keys.size();
+            return Status::OK();
+        }
+
         for (BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i) {
             removeOneKey(txn, *i, loc, options.dupsAllowed);
             ++*numDeleted;
@@ -235,6 +289,32 @@ namespace mongo {
         return _newInterface->getSpaceUsedBytes( txn );
     }
 
+    bool BtreeBasedAccessMethod::appendCacheStats(OperationContext* txn,
+                                                  BSONObjBuilder* result,
+                                                  double scale) const {
+        return _newInterface->appendCacheStats(txn, result, scale);
+    }
+
+    bool BtreeBasedAccessMethod::estimateNumKeysInRange(OperationContext* txn,
+                                                        const BSONObj& startKey,
+                                                        bool startKeyInclusive,
+                                                        const BSONObj& endKey,
+                                                        bool endKeyInclusive,
+                                                        long long* numKeysOut) const {
+        return _newInterface->estimateNumEntriesInRange(txn,
+                                                        startKey,
+                                                        startKeyInclusive,
+                                                        endKey,
+                                                        endKeyInclusive,
+                                                        numKeysOut);
+    }
+
+    bool BtreeBasedAccessMethod::findExactKey(OperationContext* txn,
+                                              const BSONObj& key,
+                                              std::vector<RecordId>* locsOut) const {
+        return _newInterface->findExactKey(txn, key, locsOut);
+    }
+
     Status BtreeBasedAccessMethod::validateUpdate(OperationContext* txn,
                                                   const BSONObj &from,
                                                   const BSONObj &to,
@@ -272,6 +352,13 @@ namespace mongo {
             _btreeState->setMultikey( txn );
         }
 
+        if (_sideWrites) {
+            _sideWrites->record(data->removed, data->loc);
+            _sideWrites->record(data->added, data->loc);
+            *numUpdated = data->added.size();
+            return Status::OK();
+        }
+
         for (size_t i = 0; i < data->removed.size(); ++i) {
             _newInterface->unindex(txn,
                                    *data->removed[i],
@@ -320,4 +407,70 @@ namespace mongo {
         return bulk->commit(dupsToDrop, mayInterrupt, dupsAllowed);
     }
 
+    Status BtreeBasedAccessMethod::checkpointBulk(IndexAccessMethod* bulkRaw,
+                                                  const std::string& dir,
+                                                  BSONObjBuilder* checkpoint) {
+        BtreeBasedBulkAccessMethod* bulk = static_cast<BtreeBasedBulkAccessMethod*>(bulkRaw);
+        return bulk->checkpoint(dir, checkpoint);
+    }
+
+    IndexAccessMethod* BtreeBasedAccessMethod::resumeBulk(OperationContext* txn,
+                                                          const std::string& dir,
+                                                          const BSONObj& checkpoint) {
+        // Same as initiateBulk(): the keys only go in the index when the bulk build commits.
+        if (!_newInterface->isEmpty(txn)) {
+            return NULL;
+        }
+
+        return BtreeBasedBulkAccessMethod::resume(txn,
+                                                  this,
+                                                  _newInterface.get(),
+                                                  _descriptor,
+                                                  dir,
+                                                  checkpoint);
+    }
+
+    Status BtreeBasedAccessMethod::beginSideWrites() {
+        invariant(!_sideWrites);
+        _sideWrites.reset(new SideWrites());
+        return Status::OK();
+    }
+
+    Status BtreeBasedAccessMethod::drainSideWrites(OperationContext* txn,
+                                                   const Collection* collection,
+                                                   const InsertDeleteOptions& options) {
+        invariant(_sideWrites);
+        scoped_ptr<SideWrites> sideWrites;
+        sideWrites.swap(_sideWrites);
+
+        const SideWrites::KeysByLoc& keysByLoc = sideWrites->keysByLoc();
+        LOG(1) << "\t applying side writes of " << keysByLoc.size() << " documents to index "
+               << _descriptor->indexName();
+
+        for (SideWrites::KeysByLoc::const_iterator it = keysByLoc.begin();
+             it != keysByLoc.end();
+             ++it) {
+            WriteUnitOfWork wunit(txn);
+
+            const BSONObjSet& keys = it->second;
+            for (BSONObjSet::const_iterator i = keys.begin(); i != keys.end(); ++i) {
+                removeOneKey(txn, *i, it->first, options.dupsAllowed);
+            }
+
+            // Keys which the bulk build also inserted are skipped as already indexed.
+            BSONObj doc;
+            if (collection->findDoc(txn, it->first, &doc)) {
+                int64_t unused;
+                Status status = insert(txn, doc, it->first, options, &unused);
+                if (!status.isOK()) {
+                    return status;
+                }
+            }
+
+            wunit.commit();
+        }
+
+        return Status::OK();
+    }
+
 }  // namespace mongo
@@ -60,7 +60,7 @@ namespace mongo {
         BtreeBasedAccessMethod( IndexCatalogEntry* btreeState,
                                 SortedDataInterface* btree );
 
-        virtual ~BtreeBasedAccessMethod() { }
+        virtual ~BtreeBasedAccessMethod();
 
         virtual Status insert(OperationContext* txn,
                               const BSONObj& obj,
@@ -98,6 +98,20 @@ namespace mongo {
                                    bool dupsAllowed,
                                    std::set<RecordId>* dups );
 
+        virtual Status checkpointBulk( IndexAccessMethod* bulk,
+                                       const std::string& dir,
+                                       BSONObjBuilder* checkpoint );
+
+        virtual IndexAccessMethod* resumeBulk( OperationContext* txn,
+                                               const std::string& dir,
+                                               const BSONObj& checkpoint );
+
+        virtual Status beginSideWrites();
+
+        virtual Status drainSideWrites(OperationContext* txn,
+                                       const Collection* collection,
+                                       const InsertDeleteOptions& options);
+
         virtual Status touch(OperationContext* txn, const BSONObj& obj);
 
         virtual Status touch(OperationContext* txn) const;
@@ -107,6 +121,21 @@ namespace mongo {
 
         virtual long long getSpaceUsedBytes( OperationContext* txn ) const;
 
+        virtual bool appendCacheStats(OperationContext* txn,
+                                      BSONObjBuilder* result,
+                                      double scale) const;
+
+        virtual bool estimateNumKeysInRange(OperationContext* txn,
+                                            const BSONObj& startKey,
+                                            bool startKeyInclusive,
+                                            const BSONObj& endKey,
+                                            bool endKeyInclusive,
+                                            long long* numKeysOut) const;
+
+        virtual bool findExactKey(OperationContext* txn,
+                                  const BSONObj& key,
+                                  std::vector<RecordId>* locsOut) const;
+
         // XXX: consider migrating callers to use IndexCursor instead
         virtual RecordId findSingle( OperationContext* txn, const BSONObj& key ) const;
 
@@ -142,6 +171,12 @@ namespace mongo {
                           bool dupsAllowed);
 
         scoped_ptr<SortedDataInterface> _newInterface;
+
+        class SideWrites;
+
+        // Between beginSideWrites() and drainSideWrites(), writes record their keys here instead
+        // of changing '_newInterface'. Only set and cleared under an exclusive collection lock.
+        scoped_ptr<SideWrites> _sideWrites;
     };
 
     /**
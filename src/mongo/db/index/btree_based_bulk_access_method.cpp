@@ -32,14 +32,24 @@
 
 #include "mongo/db/index/btree_based_bulk_access_method.h"
 
+#include <boost/filesystem/operations.hpp>
+
 #include "mongo/db/curop.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
+#include "mongo/util/file.h"
 #include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/paths.h"
 #include "mongo/util/progress_meter.h"
 
 namespace mongo {
 
+    // Number of sorted runs an index build may write to disk in the background while it goes on
+    // extracting keys. 0 writes each run on the building thread.
+    MONGO_EXPORT_SERVER_PARAMETER(internalIndexBuildSortSpillThreads, int, 0);
+
     //
     // Comparison for external sorter interface
     //
@@ -83,10 +93,78 @@ namespace mongo {
         _isMultiKey = false;
 
         _sorter.reset(BSONObjExternalSorter::make(
-                    SortOptions().TempDir(storageGlobalParams.dbpath + "/_tmp")
-                                 .ExtSortAllowed()
-                                 .MaxMemoryUsageBytes(100*1024*1024),
-                    BtreeExternalSortComparison(descriptor->keyPattern(), descriptor->version())));
+                    makeSortOptions(),
+                    BtreeExternalSortComparison(descriptor->keyPattern(),
+                                                descriptor->keyFormatVersion())));
+    }
+
+    BtreeBasedBulkAccessMethod::BtreeBasedBulkAccessMethod(OperationContext* txn,
+                                                           BtreeBasedAccessMethod* real,
+                                                           SortedDataInterface* interface,
+                                                           BSONObjExternalSorter* sorter) {
+        _real = real;
+        _interface = interface;
+        _txn = txn;
+
+        _docsInserted = 0;
+        _keysInserted = 0;
+        _isMultiKey = false;
+
+        _sorter.reset(sorter);
+    }
+
+    SortOptions BtreeBasedBulkAccessMethod::makeSortOptions() {
+        return SortOptions().TempDir(storageGlobalParams.dbpath + "/_tmp")
+                            .ExtSortAllowed()
+                            .MaxMemoryUsageBytes(100*1024*1024)
+                            .SpillThreads(std::max(internalIndexBuildSortSpillThreads, 0));
+    }
+
+    BtreeBasedBulkAccessMethod* BtreeBasedBulkAccessMethod::resume(
+            OperationContext* txn,
+            BtreeBasedAccessMethod* real,
+            SortedDataInterface* interface,
+            const IndexDescriptor* descriptor,
+            const std::string& dir,
+            const BSONObj& checkpoint) {
+
+        if (!checkpoint["runs"].isABSONObj()) {
+            return NULL;
+        }
+
+        std::vector<std::string> runs;
+        std::vector<std::string> fileNames;
+        BSONForEach(run, checkpoint["runs"].Obj()) {
+            if (run.type() != String) {
+                return NULL;
+            }
+
+            const boost::filesystem::path fileName = boost::filesystem::path(dir) / run.String();
+            if (!boost::filesystem::exists(fileName)) {
+                warning() << "sorted run " << fileName.string() << " of the checkpoint of index "
+                          << descriptor->indexName() << " is missing";
+                return NULL;
+            }
+
+            runs.push_back(run.String());
+            fileNames.push_back(fileName.string());
+        }
+
+        BtreeBasedBulkAccessMethod* bulk = new BtreeBasedBulkAccessMethod(
+            txn,
+            real,
+            interface,
+            BSONObjExternalSorter::makeFromExistingRuns(
+                fileNames,
+                makeSortOptions(),
+                BtreeExternalSortComparison(descriptor->keyPattern(),
+                                            descriptor->keyFormatVersion())));
+
+        bulk->_checkpointedRuns = runs;
+        bulk->_isMultiKey = checkpoint["multikey"].trueValue();
+        bulk->_keysInserted = checkpoint["keys"].numberLong();
+        bulk->_docsInserted = checkpoint["docs"].numberLong();
+        return bulk;
     }
 
     Status BtreeBasedBulkAccessMethod::insert(OperationContext* txn,
@@ -114,6 +192,60 @@ namespace mongo {
         return Status::OK();
     }
 
+    Status BtreeBasedBulkAccessMethod::checkpoint(const std::string& dir,
+                                                  BSONObjBuilder* checkpoint) {
+        std::vector<std::string> newRuns;
+        _sorter->spillAll(&newRuns);
+
+        try {
+            boost::filesystem::create_directories(dir);
+            for (size_t i = 0; i < newRuns.size(); i++) {
+                const std::string name = str::stream() << "run." << _checkpointedRuns.size();
+                const boost::filesystem::path kept = boost::filesystem::path(dir) / name;
+
+                // Left over if an earlier checkpoint failed before it was recorded.
+                boost::filesystem::remove(kept);
+
+                boost::system::error_code ec;
+                boost::filesystem::create_hard_link(newRuns[i], kept, ec);
+                if (ec) {
+                    // The temporary directory may be on another file system.
+                    boost::filesystem::copy_file(newRuns[i], kept);
+                }
+
+                File file;
+                file.open(kept.string().c_str());
+                if (file.bad()) {
+                    return Status(ErrorCodes::FileNotOpen,
+                                  str::stream() << "couldn't open " << kept.string());
+                }
+                file.fsync();
+
+                _checkpointedRuns.push_back(name);
+                if (i == newRuns.size() - 1) {
+                    flushMyDirectory(kept);
+                }
+            }
+            flushMyDirectory(dir);
+        }
+        catch (const boost::filesystem::filesystem_error& e) {
+            return Status(ErrorCodes::FileStreamFailed,
+                          str::stream() << "couldn't keep the sorted runs of an index build in "
+                                        << dir << ": " << e.what());
+        }
+
+        BSONArrayBuilder runs(checkpoint->subarrayStart("runs"));
+        for (size_t i = 0; i < _checkpointedRuns.size(); i++) {
+            runs.append(_checkpointedRuns[i]);
+        }
+        runs.done();
+
+        checkpoint->appendBool("multikey", _isMultiKey);
+        checkpoint->append("keys", static_cast<long long>(_keysInserted));
+        checkpoint->append("docs", static_cast<long long>(_docsInserted));
+        return Status::OK();
+    }
+
     Status BtreeBasedBulkAccessMethod::commit(set<RecordId>* dupsToDrop,
                                               bool mayInterrupt,
                                               bool dupsAllowed) {
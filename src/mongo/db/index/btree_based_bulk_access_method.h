@@ -27,6 +27,7 @@
 */
 
 #include <set>
+#include <string>
 #include <vector>
 
 #include "mongo/base/error_codes.h"
@@ -51,6 +52,17 @@ namespace mongo {
                                    SortedDataInterface* interface,
                                    const IndexDescriptor* descriptor);
 
+        /**
+         * Returns a bulk builder which starts out with the keys saved by checkpoint() under 'dir',
+         * or NULL if any of the files 'checkpoint' names is missing.
+         */
+        static BtreeBasedBulkAccessMethod* resume(OperationContext* txn,
+                                                  BtreeBasedAccessMethod* real,
+                                                  SortedDataInterface* interface,
+                                                  const IndexDescriptor* descriptor,
+                                                  const std::string& dir,
+                                                  const BSONObj& checkpoint);
+
         ~BtreeBasedBulkAccessMethod() {}
 
         virtual Status insert(OperationContext* txn,
@@ -61,6 +73,12 @@ namespace mongo {
 
         Status commit(std::set<RecordId>* dupsToDrop, bool mayInterrupt, bool dupsAllowed);
 
+        /**
+         * Writes out the keys inserted so far and keeps another link to each sorted run under
+         * 'dir', synced to disk, since the sorter removes its own files when it is done.
+         */
+        Status checkpoint(const std::string& dir, BSONObjBuilder* checkpoint);
+
         // Exposed for testing.
         static ExternalSortComparison* getComparison(int version, const BSONObj& keyPattern);
 
@@ -76,6 +94,18 @@ namespace mongo {
             return Status::OK();
         }
 
+        virtual Status checkpointBulk(IndexAccessMethod* bulk,
+                                      const std::string& dir,
+                                      BSONObjBuilder* checkpoint) {
+            return _notAllowed();
+        }
+
+        virtual IndexAccessMethod* resumeBulk(OperationContext* txn,
+                                              const std::string& dir,
+                                              const BSONObj& checkpoint) {
+            return NULL;
+        }
+
         virtual Status touch(OperationContext* txn, const BSONObj& obj) {
             return _notAllowed();
         }
@@ -109,6 +139,27 @@ namespace mongo {
             return -1;
         }
 
+        virtual bool appendCacheStats(OperationContext* txn,
+                                      BSONObjBuilder* result,
+                                      double scale) const {
+            return false;
+        }
+
+        virtual bool estimateNumKeysInRange(OperationContext* txn,
+                                            const BSONObj& startKey,
+                                            bool startKeyInclusive,
+                                            const BSONObj& endKey,
+                                            bool endKeyInclusive,
+                                            long long* numKeysOut) const {
+            return false;
+        }
+
+        virtual bool findExactKey(OperationContext* txn,
+                                  const BSONObj& key,
+                                  std::vector<RecordId>* locsOut) const {
+            return false;
+        }
+
         virtual Status update(OperationContext* txn,
                               const UpdateTicket& ticket,
                               int64_t* numUpdated) {
@@ -129,11 +180,28 @@ namespace mongo {
             return NULL;
         }
 
+        virtual Status beginSideWrites() {
+            return _notAllowed();
+        }
+
+        virtual Status drainSideWrites(OperationContext* txn,
+                                       const Collection* collection,
+                                       const InsertDeleteOptions& options) {
+            return _notAllowed();
+        }
+
         OperationContext* getOperationContext() { return _txn; }
 
     private:
         typedef Sorter<BSONObj, RecordId> BSONObjExternalSorter;
 
+        BtreeBasedBulkAccessMethod(OperationContext* txn,
+                                   BtreeBasedAccessMethod* real,
+                                   SortedDataInterface* interface,
+                                   BSONObjExternalSorter* sorter);
+
+        static SortOptions makeSortOptions();
+
         Status _notAllowed() const {
             return Status(ErrorCodes::InternalError, "cannot use bulk for this yet");
         }
@@ -156,6 +224,9 @@ namespace mongo {
         // Does any document have >1 key?
         bool _isMultiKey;
 
+        // Names, within the checkpoint directory, of the runs kept by checkpoint() so far.
+        std::vector<std::string> _checkpointedRuns;
+
         OperationContext* _txn;
     };
 
@@ -51,10 +51,12 @@ namespace mongo {
     }
 
     void BtreeKeyGenerator::getKeys(const BSONObj &obj, BSONObjSet *keys) const {
-        // These are mutated as part of the getKeys call.  :|
-        vector<const char*> fieldNames(_fieldNames);
-        vector<BSONElement> fixed(_fixed);
-        getKeysImpl(fieldNames, fixed, obj, keys);
+        if (!getKeysWithoutArrays(obj, keys)) {
+            // These are mutated as part of the getKeys call.  :|
+            vector<const char*> fieldNames(_fieldNames);
+            vector<BSONElement> fixed(_fixed);
+            getKeysImpl(fieldNames, fixed, obj, keys);
+        }
         if (keys->empty() && ! _isSparse) {
             keys->insert(_nullKey);
         }
@@ -249,6 +251,68 @@ namespace mongo {
                              arrObjElt.embeddedObject());
     }
 
+namespace {
+
+    /**
+     * Returns the element at the dotted path 'field' of 'obj', or EOO if there is none, or the
+     * first array along the path.  Unlike getFieldDottedOrArray() it builds no strings.
+     */
+    BSONElement getFieldDottedStopAtArray(const BSONObj& obj, const char* field) {
+        const char* dot = strchr(field, '.');
+        BSONElement e = obj.getField(dot ? StringData(field, dot - field) : StringData(field));
+        while (dot && e.type() == Object) {
+            field = dot + 1;
+            dot = strchr(field, '.');
+            e = e.embeddedObject().getField(dot ? StringData(field, dot - field)
+                                                : StringData(field));
+        }
+        if (e.type() == Array) {
+            return e;
+        }
+        if (dot) {
+            // the path continues through a scalar
+            return BSONElement();
+        }
+        return e;
+    }
+
+}  // namespace
+
+    bool BtreeKeyGeneratorV1::getKeysWithoutArrays(const BSONObj& obj, BSONObjSet* keys) const {
+        const size_t numFields = _fieldNames.size();
+        if (numFields > kMaxFieldsWithoutArrays) {
+            return false;
+        }
+
+        BSONElement elts[kMaxFieldsWithoutArrays];
+        size_t numNotFound = 0;
+        for (size_t i = 0; i < numFields; ++i) {
+            if (*_fieldNames[i] == '\0') {
+                return false;
+            }
+
+            elts[i] = getFieldDottedStopAtArray(obj, _fieldNames[i]);
+            if (elts[i].type() == Array) {
+                return false;
+            }
+            if (elts[i].eoo()) {
+                elts[i] = _nullElt;
+                numNotFound++;
+            }
+        }
+
+        if (_isSparse && numNotFound == numFields) {
+            return true;
+        }
+
+        BSONObjBuilder b(_sizeTracker);
+        for (size_t i = 0; i < numFields; ++i) {
+            b.appendAs(elts[i], "");
+        }
+        keys->insert(b.obj());
+        return true;
+    }
+
     void BtreeKeyGeneratorV1::getKeysImpl(vector<const char*> fieldNames, vector<BSONElement> fixed,
                                           const BSONObj &obj, BSONObjSet *keys) const {
         getKeysImplWithArray(fieldNames, fixed, obj, keys, 0, BSONObj());
@@ -56,6 +56,15 @@ namespace mongo {
         BSONElement _nullElt; // jstNull
         BSONSizeTracker _sizeTracker;
     private:
+        /**
+         * Adds the keys of 'obj' to 'keys' and returns true if 'obj' has no array along any of
+         * the indexed paths, so that it has at most one key.  Otherwise returns false, leaving
+         * 'keys' alone, and getKeysImpl() does the work.
+         */
+        virtual bool getKeysWithoutArrays(const BSONObj& obj, BSONObjSet* keys) const {
+            return false;
+        }
+
         // We have V0 and V1.  Sigh.
         virtual void getKeysImpl(vector<const char*> fieldNames, vector<BSONElement> fixed,
                                  const BSONObj &obj, BSONObjSet *keys) const = 0;
@@ -80,6 +89,14 @@ namespace mongo {
         virtual ~BtreeKeyGeneratorV1() { }
 
     private:
+        // Indexes with more fields always go through getKeysImpl().
+        static const size_t kMaxFieldsWithoutArrays = 8;
+
+        /**
+         * Looks up each indexed path without copying the field names or building strings.
+         */
+        virtual bool getKeysWithoutArrays(const BSONObj& obj, BSONObjSet* keys) const;
+
         /**
          * @param fieldNames - fields to index, may be postfixes in recursive calls
          * @param fixed - values that have already been identified for their index fields
@@ -586,4 +586,26 @@ namespace {
         ASSERT(testKeygen(keyPattern, genKeysFrom, expectedKeys));
     }
 
+    TEST(BtreeKeyGeneratorTest, GetKeysDottedThroughScalar) {
+        BSONObj keyPattern = fromjson("{'a.b': 1, 'c.d': 1}");
+        BSONObj genKeysFrom = fromjson("{a: 5, c: {d: {e: 1}}}");
+        BSONObjSet expectedKeys;
+        expectedKeys.insert(fromjson("{'': null, '': {e: 1}}"));
+        ASSERT(testKeygen(keyPattern, genKeysFrom, expectedKeys));
+        ASSERT(testKeygen(keyPattern, genKeysFrom, expectedKeys, true));
+
+        BSONObjSet noKeys;
+        ASSERT(testKeygen(keyPattern, fromjson("{a: 5, c: 6}"), noKeys, true));
+    }
+
+    TEST(BtreeKeyGeneratorTest, GetKeysManyFields) {
+        BSONObj keyPattern = fromjson(
+            "{a: 1, b: 1, c: 1, d: 1, e: 1, f: 1, g: 1, h: 1, 'i.j': 1}");
+        BSONObj genKeysFrom = fromjson("{a: 1, c: 3, e: 5, g: 7, i: {j: 9}}");
+        BSONObjSet expectedKeys;
+        expectedKeys.insert(fromjson(
+            "{'': 1, '': null, '': 3, '': null, '': 5, '': null, '': 7, '': null, '': 9}"));
+        ASSERT(testKeygen(keyPattern, genKeysFrom, expectedKeys));
+    }
+
 } // namespace
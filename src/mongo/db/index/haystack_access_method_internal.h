@@ -59,16 +59,20 @@ namespace mongo {
               _geoField(geoField) { }
 
         // Consider the point in loc, and keep it if it's within _maxDistance (and we have space for
-        // it)
+        // it).  Points are checked a batch at a time, so the decision may wait for a later
+        // consider() or for appendResultsTo().
         void consider(const RecordId& loc) {
             if (limitReached()) return;
             Point p(_collection->docFor(_txn, loc).getFieldDotted(_geoField));
-            if (distance(_near, p) > _maxDistance)
-                return;
-            _locs.push_back(loc);
+            _pendingLocs.push_back(loc);
+            _pendingXs.push_back(p.x);
+            _pendingYs.push_back(p.y);
+            if (_pendingLocs.size() == kBatchSize)
+                flush();
         }
 
         int appendResultsTo(BSONArrayBuilder* b) {
+            flush();
             for (unsigned i = 0; i <_locs.size(); i++)
                 b->append(_collection->docFor(_txn, _locs[i]));
             return _locs.size();
@@ -79,6 +83,26 @@ namespace mongo {
             return _locs.size() >= _limit;
         }
     private:
+        static const size_t kBatchSize = 64;
+
+        // Keeps the pending points which are within _maxDistance, in the order they came,
+        // until the limit is reached.
+        void flush() {
+            if (_pendingLocs.empty())
+                return;
+
+            bool within[kBatchSize];
+            distancesWithin(_near, _maxDistance,
+                            &_pendingXs[0], &_pendingYs[0], _pendingLocs.size(), within);
+            for (size_t i = 0; i < _pendingLocs.size() && !limitReached(); i++) {
+                if (within[i])
+                    _locs.push_back(_pendingLocs[i]);
+            }
+            _pendingLocs.clear();
+            _pendingXs.clear();
+            _pendingYs.clear();
+        }
+
         OperationContext* _txn;
         const Collection* _collection;
 
@@ -87,6 +111,11 @@ namespace mongo {
         unsigned _limit;
         const std::string _geoField;
         std::vector<RecordId> _locs;
+
+        // Points waiting for flush(), with their coordinates laid out for distancesWithin().
+        std::vector<RecordId> _pendingLocs;
+        std::vector<double> _pendingXs;
+        std::vector<double> _pendingYs;
     };
 
 }  // namespace mongo
@@ -37,6 +37,7 @@
 namespace mongo {
 
     class BSONObjBuilder;
+    class Collection;
     class UpdateTicket;
     struct InsertDeleteOptions;
 
@@ -161,6 +162,40 @@ namespace mongo {
          */
         virtual long long getSpaceUsedBytes( OperationContext* txn ) const = 0;
 
+        /**
+         * Appends the storage engine's cache statistics for this index. Returns false if it
+         * keeps none.
+         *
+         * @see SortedDataInterface::appendCacheStats
+         */
+        virtual bool appendCacheStats(OperationContext* txn,
+                                      BSONObjBuilder* result,
+                                      double scale) const = 0;
+
+        /**
+         * Estimates the number of keys between 'startKey' and 'endKey' without walking them.
+         * Returns false if the storage engine cannot estimate the range.
+         *
+         * @see SortedDataInterface::estimateNumEntriesInRange
+         */
+        virtual bool estimateNumKeysInRange(OperationContext* txn,
+                                            const BSONObj& startKey,
+                                            bool startKeyInclusive,
+                                            const BSONObj& endKey,
+                                            bool endKeyInclusive,
+                                            long long* numKeysOut) const = 0;
+
+        /**
+         * Appends the RecordId of every entry whose key is exactly 'key' to 'locsOut', in
+         * ascending RecordId order. Returns false, leaving 'locsOut' untouched, if the storage
+         * engine can only find the key by seeking a cursor to it.
+         *
+         * @see SortedDataInterface::findExactKey
+         */
+        virtual bool findExactKey(OperationContext* txn,
+                                  const BSONObj& key,
+                                  std::vector<RecordId>* locsOut) const = 0;
+
         //
         // Bulk operations support
         //
@@ -197,6 +232,46 @@ namespace mongo {
                                    bool mayInterrupt,
                                    bool dupsAllowed,
                                    std::set<RecordId>* dups ) = 0;
+
+        /**
+         * Makes the keys given to 'bulk' so far durable, in files under the directory 'dir', and
+         * appends to 'checkpoint' what resumeBulk() needs to start from them after a restart.
+         * 'bulk' is used as before afterwards. The files are left for the caller to remove.
+         */
+        virtual Status checkpointBulk( IndexAccessMethod* bulk,
+                                       const std::string& dir,
+                                       BSONObjBuilder* checkpoint ) = 0;
+
+        /**
+         * Like initiateBulk(), but the returned IndexAccessMethod starts out with the keys which
+         * checkpointBulk() saved under 'dir' and described in 'checkpoint'. Returns NULL if they
+         * cannot be used.
+         */
+        virtual IndexAccessMethod* resumeBulk( OperationContext* txn,
+                                               const std::string& dir,
+                                               const BSONObj& checkpoint ) = 0;
+
+        /**
+         * Makes writes to this index record the keys they touch in a side table instead of
+         * changing the index, so that the empty index can be bulk built while the collection is
+         * written to. Must be followed by drainSideWrites() before the index is used.
+         *
+         * Requires holding an exclusive lock on the collection.
+         */
+        virtual Status beginSideWrites() = 0;
+
+        /**
+         * Stops recording side writes and applies them to the index: every key recorded for a
+         * document is removed, then the keys of the document as it is now, if it still exists,
+         * are inserted. The result does not depend on the order of the recorded writes, nor on
+         * whether they were later rolled back.
+         *
+         * Requires holding an exclusive lock on the collection. Should not be called inside of a
+         * WriteUnitOfWork.
+         */
+        virtual Status drainSideWrites(OperationContext* txn,
+                                       const Collection* collection,
+                                       const InsertDeleteOptions& options) = 0;
     };
 
     /**
@@ -48,6 +48,8 @@ namespace mongo {
                      fieldName == "ns" ||
                      fieldName == "name" ||
                      fieldName == "v" ||
+                     fieldName == "btreeBucketSize" || // storage layout only
+                     fieldName == "fillFactor" || // this is a build time option only
                      fieldName == "background" || // this is a creation time option only
                      fieldName == "dropDups" || // this is now ignored
                      fieldName == "sparse" || // checked specially
@@ -60,6 +62,18 @@ namespace mongo {
         }
     }
 
+    const int IndexDescriptor::DefaultBtreeBucketSize;
+
+    int IndexDescriptor::btreeBucketSize() const {
+        BSONElement e = _infoObj["btreeBucketSize"];
+        return e.isNumber() ? e.numberInt() : DefaultBtreeBucketSize;
+    }
+
+    int IndexDescriptor::fillFactor() const {
+        BSONElement e = _infoObj["fillFactor"];
+        return e.isNumber() ? e.numberInt() : 100;
+    }
+
     bool IndexDescriptor::areIndexOptionsEquivalent( const IndexDescriptor* other ) const {
 
         if ( isSparse() != other->isSparse() ) {
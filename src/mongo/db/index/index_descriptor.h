@@ -120,6 +120,18 @@ namespace mongo {
         // Return what version of index this is.
         int version() const { return _version; }
 
+        // Return the version of the key format.  Version 2 indexes share it with version 1, and
+        // differ only in the size of their mmapv1 btree buckets.
+        int keyFormatVersion() const { return _version == 2 ? 1 : _version; }
+
+        // Return the size of the btree buckets of a version 2 index in mmapv1.  Other storage
+        // engines ignore it.
+        int btreeBucketSize() const;
+
+        // Return the percentage of each btree bucket a bulk build of this index fills in mmapv1,
+        // leaving the rest for later inserts.  Other storage engines ignore it.
+        int fillFactor() const;
+
         // May each key only occur once?
         bool unique() const { return _unique; }
 
@@ -170,6 +182,17 @@ namespace mongo {
              return i.next().eoo();
         }
 
+        static bool isValidBtreeBucketSize( int size ) {
+            return size == 16 * 1024 || size == 32 * 1024 || size == 64 * 1024;
+        }
+
+        // Bucket size of a version 2 index created without "btreeBucketSize".
+        static const int DefaultBtreeBucketSize = 32 * 1024;
+
+        static bool isValidFillFactor( int fillFactor ) {
+            return fillFactor >= 10 && fillFactor <= 100;
+        }
+
         static std::string makeIndexNamespace( const StringData& ns,
                                           const StringData& name ) {
             return ns.toString() + ".$" + name.toString();
@@ -134,6 +134,10 @@ namespace mongo {
                 if (allowBackgroundBuilding) {
                     dbLock->relockWithMode(MODE_X);
                 }
+                status = indexer.drainSideWrites();
+            }
+
+            if (status.isOK()) {
                 WriteUnitOfWork wunit(txn);
                 indexer.commit();
                 wunit.commit();
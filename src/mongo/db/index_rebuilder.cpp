@@ -34,6 +34,7 @@
 
 #include <list>
 #include <string>
+#include <vector>
 
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/auth/user_name.h"
@@ -46,6 +47,7 @@
 #include "mongo/db/instance.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/storage/storage_engine.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/log.h"
 #include "mongo/util/scopeguard.h"
 
@@ -85,7 +87,9 @@ namespace {
 
             {
                 WriteUnitOfWork wunit(txn);
-                vector<BSONObj> indexesToBuild = indexCatalog->getAndClearUnfinishedIndexes(txn);
+                vector<BSONObj> checkpoints;
+                vector<BSONObj> indexesToBuild =
+                    indexCatalog->getAndClearUnfinishedIndexes(txn, &checkpoints);
 
                 // The indexes have now been removed from system.indexes, so the only record is
                 // in-memory. If there is a journal commit between now and when insert() rewrites
@@ -114,6 +118,7 @@ namespace {
                 }
 
                 uassertStatusOK(indexer.init(indexesToBuild));
+                indexer.resumeFromCheckpoints(checkpoints);
 
                 wunit.commit();
             }
@@ -141,9 +146,24 @@ namespace {
             }
         }
     }
+
+    // Runs checkNS() over one database's collections on an index rebuilding worker thread.
+    void checkNSInWorker(const std::list<std::string>* nsToCheck) {
+        Client::initThreadIfNotAlready();
+        cc().getAuthorizationSession()->grantInternalAuthorization();
+
+        OperationContextImpl txn;
+        try {
+            checkNS(&txn, *nsToCheck);
+        }
+        catch (const DBException& e) {
+            error() << "Index verification did not complete: " << e.toString();
+            fassertFailedNoTrace(18643);
+        }
+    }
 } // namespace
 
-    void restartInProgressIndexesFromLastShutdown(OperationContext* txn) {
+    void restartInProgressIndexesFromLastShutdown(OperationContext* txn, int numThreads) {
         txn->getClient()->getAuthorizationSession()->grantInternalAuthorization();
 
         std::vector<std::string> dbNames;
@@ -152,18 +172,38 @@ namespace {
         storageEngine->listDatabases( &dbNames );
 
         try {
-            std::list<std::string> collNames;
-            for (std::vector<std::string>::const_iterator dbName = dbNames.begin();
-                 dbName < dbNames.end();
-                 ++dbName) {
-
+            std::vector<std::list<std::string> > collNamesByDb(dbNames.size());
+            for (size_t i = 0; i < dbNames.size(); i++) {
                 ScopedTransaction scopedXact(txn, MODE_IS);
-                AutoGetDb autoDb(txn, *dbName, MODE_S);
+                AutoGetDb autoDb(txn, dbNames[i], MODE_S);
 
                 Database* db = autoDb.getDb();
-                db->getDatabaseCatalogEntry()->getCollectionNamespaces(&collNames);
+                db->getDatabaseCatalogEntry()->getCollectionNamespaces(&collNamesByDb[i]);
+            }
+
+            if (numThreads <= 1 || dbNames.size() <= 1) {
+                std::list<std::string> collNames;
+                for (size_t i = 0; i < collNamesByDb.size(); i++) {
+                    collNames.splice(collNames.end(), collNamesByDb[i]);
+                }
+                checkNS(txn, collNames);
+            }
+            else {
+                // Each database's collections are checked, and their indexes rebuilt, on one
+                // worker at a time, so builds in different databases go on concurrently.
+                LOG(1) << "checking " << dbNames.size() << " databases on " << numThreads
+                       << " threads";
+                ThreadPool pool(numThreads, "indexRebuilder");
+                for (size_t i = 0; i < collNamesByDb.size(); i++) {
+                    pool.schedule(checkNSInWorker, &collNamesByDb[i]);
+                }
+                pool.join();
+            }
+
+            // Every interrupted build has been redone, so no index refers to a checkpoint anymore.
+            if (serverGlobalParams.indexBuildRetry) {
+                MultiIndexBlock::removeLeftoverCheckpoints();
             }
-            checkNS(txn, collNames);
         }
         catch (const DBException& e) {
             error() << "Index verification did not complete: " << e.toString();
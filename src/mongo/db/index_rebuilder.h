@@ -35,6 +35,8 @@ namespace mongo {
     /**
      * Restarts building indexes that were in progress during shutdown.
      * Only call this at startup before taking requests.
+     * With more than one thread, the databases are checked and their indexes rebuilt
+     * concurrently, one database per thread at a time.
      */
-    void restartInProgressIndexesFromLastShutdown(OperationContext* txn);
+    void restartInProgressIndexesFromLastShutdown(OperationContext* txn, int numThreads = 1);
 }
@@ -48,6 +48,9 @@
 #include "mongo/db/auth/internal_user_auth.h"
 #include "mongo/db/auth/security_key.h"
 #include "mongo/db/server_options.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/logger/async_file_appender.h"
+#include "mongo/logger/async_log_queue.h"
 #include "mongo/logger/logger.h"
 #include "mongo/logger/console_appender.h"
 #include "mongo/logger/message_event.h"
@@ -191,11 +194,35 @@ namespace mongo {
             quickExit(EXIT_FAILURE);
     }
 
+    // With asyncLogWrites, threads that log into --logpath queue formatted messages for a
+    // background thread to write, instead of writing to the file themselves.  When the queue of
+    // asyncLogQueueSize messages fills, asyncLogOverflowPolicy "block" makes them wait for room,
+    // and "drop" discards the message and counts it in the log.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(asyncLogWrites, bool, false);
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(asyncLogQueueSize, int, 8192);
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(asyncLogOverflowPolicy, std::string, "block");
+
+    static StatusWith<logger::AsyncLogQueue::OverflowPolicy> parseAsyncLogOverflowPolicy() {
+        if (asyncLogOverflowPolicy == "block") {
+            return StatusWith<logger::AsyncLogQueue::OverflowPolicy>(
+                    logger::AsyncLogQueue::kBlockWhenFull);
+        }
+        if (asyncLogOverflowPolicy == "drop") {
+            return StatusWith<logger::AsyncLogQueue::OverflowPolicy>(
+                    logger::AsyncLogQueue::kDropWhenFull);
+        }
+        return StatusWith<logger::AsyncLogQueue::OverflowPolicy>(
+                ErrorCodes::BadValue,
+                "asyncLogOverflowPolicy must be \"block\" or \"drop\", not \"" +
+                asyncLogOverflowPolicy + "\"");
+    }
+
     MONGO_INITIALIZER_GENERAL(ServerLogRedirection,
                               ("GlobalLogManager", "EndStartupOptionHandling", "ForkServer"),
                               ("default"))(
             InitializerContext*) {
 
+        using logger::AsyncFileAppender;
         using logger::LogManager;
         using logger::MessageEventEphemeral;
         using logger::MessageEventDetailsEncoder;
@@ -276,14 +303,39 @@ namespace mongo {
 
             LogManager* manager = logger::globalLogManager();
             manager->getGlobalDomain()->clearAppenders();
-            manager->getGlobalDomain()->attachAppender(
-                    MessageLogDomain::AppenderAutoPtr(
-                            new RotatableFileAppender<MessageEventEphemeral>(
-                                    new MessageEventDetailsEncoder, writer.getValue())));
-            manager->getNamedDomain("javascriptOutput")->attachAppender(
-                    MessageLogDomain::AppenderAutoPtr(
-                            new RotatableFileAppender<MessageEventEphemeral>(
-                                    new MessageEventDetailsEncoder, writer.getValue())));
+            if (asyncLogWrites) {
+                StatusWith<logger::AsyncLogQueue::OverflowPolicy> policy =
+                    parseAsyncLogOverflowPolicy();
+                if (!policy.isOK()) {
+                    return policy.getStatus();
+                }
+                if (asyncLogQueueSize <= 0) {
+                    return Status(ErrorCodes::BadValue,
+                                  "asyncLogQueueSize must be greater than 0");
+                }
+
+                // Like the file writer, the queue lives until the process exits.
+                logger::AsyncLogQueue* queue = new logger::AsyncLogQueue(
+                        writer.getValue(), asyncLogQueueSize, policy.getValue());
+                manager->getGlobalDomain()->attachAppender(
+                        MessageLogDomain::AppenderAutoPtr(
+                                new AsyncFileAppender<MessageEventEphemeral>(
+                                        new MessageEventDetailsEncoder, queue)));
+                manager->getNamedDomain("javascriptOutput")->attachAppender(
+                        MessageLogDomain::AppenderAutoPtr(
+                                new AsyncFileAppender<MessageEventEphemeral>(
+                                        new MessageEventDetailsEncoder, queue)));
+            }
+            else {
+                manager->getGlobalDomain()->attachAppender(
+                        MessageLogDomain::AppenderAutoPtr(
+                                new RotatableFileAppender<MessageEventEphemeral>(
+                                        new MessageEventDetailsEncoder, writer.getValue())));
+                manager->getNamedDomain("javascriptOutput")->attachAppender(
+                        MessageLogDomain::AppenderAutoPtr(
+                                new RotatableFileAppender<MessageEventEphemeral>(
+                                        new MessageEventDetailsEncoder, writer.getValue())));
+            }
 
             if (serverGlobalParams.logAppend && exists) {
                 log() << "***** SERVER RESTARTED *****" << endl;
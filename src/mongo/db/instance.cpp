@@ -41,11 +41,13 @@
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/background.h"
+#include "mongo/db/catalog/capped_insert_notifier.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/commands/fsync.h"
 #include "mongo/db/concurrency/d_concurrency.h"
 #include "mongo/db/concurrency/lock_state.h"
+#include "mongo/db/concurrency/tenant_scheduler.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/currentop_command.h"
 #include "mongo/db/db.h"
@@ -79,6 +81,7 @@
 #include "mongo/db/repl/repl_coordinator_global.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/db/storage_options.h"
+#include "mongo/logger/async_log_queue.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/platform/process_id.h"
 #include "mongo/s/d_state.h"
@@ -387,6 +390,23 @@ namespace {
         OpDebug& debug = currentOp.debug();
         debug.op = op;
 
+        // Client requests on the data of a database wait their tenant's turn here, before taking
+        // any locks or tickets.  Commands and nested operations are left alone.
+        TenantScheduler::Admission tenantAdmission;
+        if (!fromDBDirectClient && !nestedOp && !txn->isGod() && !isCommand &&
+                (op == dbQuery || op == dbGetMore || op == dbInsert || op == dbUpdate ||
+                 op == dbDelete)) {
+            const StringData db = nsToDatabaseSubstring(dbmsg.getns());
+            if (!TenantScheduler::isExempt(db)) {
+                TenantScheduler::get()->admit(txn, db, &tenantAdmission);
+            }
+        }
+
+        // Nested operations run on their parent's OperationContext, so only the difference
+        // from here on is theirs.
+        const OperationResourceStats resourcesAtStart = *txn->resourceStats();
+        const long long cpuMicrosAtStart = OperationResourceStats::threadCpuMicros();
+
         long long logThreshold = serverGlobalParams.slowMS;
         bool shouldLog = logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(1));
 
@@ -481,6 +501,13 @@ namespace {
         currentOp.done();
         debug.executionTime = currentOp.totalTimeMillis();
 
+        debug.resources = txn->resourceStats()->since(resourcesAtStart);
+        if (cpuMicrosAtStart >= 0) {
+            debug.resources.cpuMicros =
+                OperationResourceStats::threadCpuMicros() - cpuMicrosAtStart;
+        }
+        tenantAdmission.setCost(debug.resources.cpuMicros + debug.resources.storageWaitMicros);
+
         logThreshold += currentOp.getExpectedLatencyMs();
 
         if ( shouldLog || debug.executionTime > logThreshold ) {
@@ -490,7 +517,11 @@ namespace {
 
         if ( currentOp.shouldDBProfile( debug.executionTime ) ) {
             // performance profiling is on
-            if (txn->lockState()->hasAnyReadLock()) {
+            if ( profileRingBuffer() ) {
+                // takes no locks
+                profile(txn, c, op, currentOp);
+            }
+            else if (txn->lockState()->hasAnyReadLock()) {
                 MONGO_LOG_COMPONENT(1, logComponentForOp(op))
                         << "note: not profiling because recursive read lock" << endl;
             }
@@ -740,6 +771,8 @@ namespace {
         bool exhaust = false;
         QueryResult::View msgdata = 0;
         OpTime last;
+        boost::shared_ptr<CappedInsertNotifier> cappedNotifier;
+        uint64_t cappedNotifierVersion = 0;
         while( 1 ) {
             bool isCursorAuthorized = false;
             try {
@@ -759,7 +792,7 @@ namespace {
                     if (pass == 0) {
                         last = getLastSetOptime();
                     }
-                    else {
+                    else if (!cappedNotifier) {
                         repl::waitUpToOneSecondForOptimeChange(last);
                     }
                 }
@@ -772,7 +805,9 @@ namespace {
                                   pass,
                                   exhaust,
                                   &isCursorAuthorized,
-                                  fromDBDirectClient);
+                                  fromDBDirectClient,
+                                  &cappedNotifier,
+                                  &cappedNotifierVersion);
             }
             catch ( AssertionException& e ) {
                 if ( isCursorAuthorized ) {
@@ -803,7 +838,14 @@ namespace {
                     }
                 }
                 pass++;
-                if (debug)
+                if (cappedNotifier) {
+                    // Sleep until an insert into the collection commits, or the 4 seconds
+                    // are up.
+                    const long long remainingMillis = 4000 - timer->millis();
+                    cappedNotifier->waitForInsert(cappedNotifierVersion,
+                                                  std::max(0LL, remainingMillis));
+                }
+                else if (debug)
                     sleepmillis(20);
                 else
                     sleepmillis(2);
@@ -1136,6 +1178,7 @@ namespace {
         audit::logShutdown(currentClient.get());
 
         log() << "dbexit: " << why << " rc: " << rc;
+        logger::AsyncLogQueue::flushAll();
 
 #ifdef _WIN32
         // Windows Service Controller wants to be told when we are down,
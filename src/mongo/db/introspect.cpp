@@ -38,16 +38,67 @@
 #include "mongo/db/auth/user_set.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/catalog/database_holder.h"
+#include "mongo/db/commands/fsync.h"
 #include "mongo/db/introspect.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/profile_ring_buffer.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/util/background.h"
+#include "mongo/util/coarse_clock.h"
 #include "mongo/util/goodies.h"
 #include "mongo/util/log.h"
 
 namespace mongo {
 
+    // Number of profiled operations kept in memory instead of being inserted into
+    // system.profile.  0 inserts each one into system.profile as it completes.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(profileRingBufferSize, int, 0);
+
+    // How often the profile ring buffer is copied into system.profile.  0 leaves the entries in
+    // memory only, to be read with the profileBuffer command.
+    MONGO_EXPORT_SERVER_PARAMETER(profileRingBufferFlushIntervalMillis, int, 0);
+
 namespace {
+
+    double profileSampleRate = 1.0;
+
+    class ExportedProfileSampleRateParameter : public ExportedServerParameter<double> {
+    public:
+        ExportedProfileSampleRateParameter()
+            : ExportedServerParameter<double>(ServerParameterSet::getGlobal(),
+                                              "profileSampleRate",
+                                              &profileSampleRate,
+                                              true,
+                                              true) { }
+
+        virtual Status validate(const double& potentialNewValue) {
+            if (!(potentialNewValue > 0 && potentialNewValue <= 1)) {
+                return Status(ErrorCodes::BadValue,
+                              "profileSampleRate must be greater than 0 and at most 1");
+            }
+            return Status::OK();
+        }
+    } exportedProfileSampleRateParameter;
+
+    ProfileRingBuffer* ringBuffer = NULL;
+
+    /**
+     * Whether the operation numbered 'opNum' is in the sample.  Hashing the operation number
+     * rather than drawing a random number keeps this free of shared state.
+     */
+    bool isSampled(unsigned int opNum) {
+        const double rate = profileSampleRate;
+        if (rate >= 1) {
+            return true;
+        }
+        // Knuth's multiplicative hash spreads consecutive operation numbers over [0, 2^32).
+        const unsigned int hash = opNum * 2654435761U;
+        return hash < rate * 4294967296.0;
+    }
+
     void _appendUserInfo(const CurOp& c,
                          BSONObjBuilder& builder,
                          AuthorizationSession* authSession) {
@@ -77,6 +128,16 @@ namespace {
     }
 } // namespace
 
+    static void _buildProfileEntry(const Client& c, CurOp& currentOp, BSONObjBuilder& b) {
+        currentOp.debug().append(currentOp, b);
+
+        b.appendDate("ts", Date_t(CoarseClock::wallMillis()));
+        b.append("client", c.clientAddress());
+
+        AuthorizationSession * authSession = c.getAuthorizationSession();
+        _appendUserInfo(currentOp, b, authSession);
+    }
+
     /**
      * @return if collection existed or was created
      */
@@ -89,15 +150,7 @@ namespace {
 
         // build object
         BSONObjBuilder b(profileBufBuilder);
-
-        currentOp.debug().append(currentOp, b);
-
-        b.appendDate("ts", jsTime());
-        b.append("client", c.clientAddress());
-
-        AuthorizationSession * authSession = c.getAuthorizationSession();
-        _appendUserInfo(currentOp, b, authSession);
-
+        _buildProfileEntry(c, currentOp, b);
         BSONObj p = b.done();
 
         WriteUnitOfWork wunit(txn);
@@ -114,6 +167,18 @@ namespace {
     }
 
     void profile(OperationContext* txn, const Client& c, int op, CurOp& currentOp) {
+        if (!isSampled(currentOp.opNum())) {
+            return;
+        }
+
+        if (ringBuffer) {
+            BSONObjBuilder b;
+            _buildProfileEntry(c, currentOp, b);
+            const std::string ns = currentOp.getNS();
+            ringBuffer->append(nsToDatabaseSubstring(ns), b.obj());
+            return;
+        }
+
         bool tryAgain = false;
         while ( 1 ) {
             try {
@@ -161,6 +226,126 @@ namespace {
         }
     }
 
+namespace {
+
+    /**
+     * Copies the entries of the profile ring buffer into the system.profile collection of their
+     * database, every profileRingBufferFlushIntervalMillis.
+     */
+    class ProfileRingBufferFlusher : public BackgroundJob {
+    public:
+        ProfileRingBufferFlusher() : _nextSeq(0) { }
+
+        virtual std::string name() const { return "ProfileRingBufferFlusher"; }
+
+        virtual void run() {
+            Client::initThread(name().c_str());
+
+            while (!inShutdown()) {
+                const int intervalMillis = profileRingBufferFlushIntervalMillis;
+                sleepmillis(intervalMillis > 0 ? intervalMillis : 1000);
+
+                if (intervalMillis <= 0 || lockedForWriting()) {
+                    continue;
+                }
+
+                try {
+                    _flush();
+                }
+                catch (const DBException& e) {
+                    warning() << "could not flush the profile ring buffer: " << e.toString();
+                }
+            }
+
+            cc().shutdown();
+        }
+
+    private:
+        void _flush() {
+            std::vector<ProfileRingBuffer::Entry> entries;
+            unsigned long long overwritten = 0;
+            _nextSeq = ringBuffer->read(_nextSeq, "", ringBuffer->capacity(), &entries,
+                                        &overwritten);
+            if (overwritten) {
+                LOG(1) << "profile ring buffer overwrote " << overwritten
+                       << " entries before they were flushed";
+            }
+
+            std::map<std::string, std::vector<BSONObj> > byDb;
+            for (size_t i = 0; i < entries.size(); i++) {
+                byDb[entries[i].db].push_back(entries[i].obj);
+            }
+
+            for (std::map<std::string, std::vector<BSONObj> >::const_iterator it = byDb.begin();
+                 it != byDb.end(); ++it) {
+                // Creating system.profile needs the database locked exclusively.
+                if (!_insert(it->first, it->second, MODE_IX)) {
+                    _insert(it->first, it->second, MODE_X);
+                }
+            }
+        }
+
+        /**
+         * Returns false if system.profile does not exist and could not be created in 'mode'.
+         */
+        bool _insert(const std::string& dbname,
+                     const std::vector<BSONObj>& objs,
+                     LockMode mode) {
+            OperationContextImpl txn;
+            ScopedTransaction transaction(&txn, MODE_IX);
+            Lock::DBLock dbLock(txn.lockState(), dbname, mode);
+
+            Database* db = dbHolder().get(&txn, dbname);
+            if (!db) {
+                // Dropped since; its entries go with it.
+                return true;
+            }
+
+            Lock::CollectionLock collLock(txn.lockState(), db->getProfilingNS(), MODE_X);
+            Client::Context cx(&txn, db->getProfilingNS(), db);
+
+            WriteUnitOfWork wunit(&txn);
+            Collection* profileCollection = getOrCreateProfileCollection(&txn, db);
+            if (!profileCollection) {
+                return mode == MODE_X;
+            }
+            for (size_t i = 0; i < objs.size(); i++) {
+                profileCollection->insertDocument(&txn, objs[i], false);
+            }
+            wunit.commit();
+            return true;
+        }
+
+        unsigned long long _nextSeq;
+    };
+
+} // namespace
+
+    ProfileRingBuffer* profileRingBuffer() {
+        return ringBuffer;
+    }
+
+    void initProfileRingBuffer() {
+        invariant(!ringBuffer);
+        if (profileRingBufferSize <= 0) {
+            return;
+        }
+
+        log() << "keeping the last " << profileRingBufferSize << " profiled operations in memory";
+        ringBuffer = new ProfileRingBuffer(profileRingBufferSize);
+
+        ProfileRingBufferFlusher* flusher = new ProfileRingBufferFlusher();
+        flusher->go();
+    }
+
+    double getProfileSampleRate() {
+        return profileSampleRate;
+    }
+
+    Status setProfileSampleRate(double rate) {
+        return exportedProfileSampleRateParameter.set(rate);
+    }
+
     Collection* getOrCreateProfileCollection(OperationContext* txn,
                                              Database *db,
                                              bool force,
@@ -41,13 +41,37 @@ namespace mongo {
     class Collection;
     class Database;
     class OperationContext;
+    class ProfileRingBuffer;
 
     /* --- profiling --------------------------------------------
        do when database->profile is set
     */
 
+    /**
+     * Records 'currentOp' if it falls in the profileSampleRate sample: in the profile ring
+     * buffer when there is one, which takes no locks, and otherwise in system.profile.
+     */
     void profile(OperationContext* txn, const Client& c, int op, CurOp& currentOp);
 
+    /**
+     * The in-memory log of profiled operations, or NULL if they go straight to system.profile.
+     * Set up at startup by initProfileRingBuffer() when profileRingBufferSize is positive.
+     */
+    ProfileRingBuffer* profileRingBuffer();
+
+    /**
+     * Creates the profile ring buffer of profileRingBufferSize entries, if that is positive,
+     * and starts the job which copies its entries to system.profile every
+     * profileRingBufferFlushIntervalMillis.
+     */
+    void initProfileRingBuffer();
+
+    /**
+     * The fraction, in (0, 1], of the operations qualifying for profiling that are profiled.
+     */
+    double getProfileSampleRate();
+    Status setProfileSampleRate(double rate);
+
     /**
      * Get (or create) the profile collection
      *
@@ -29,6 +29,10 @@
 
 #include "mongo/db/json.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "mongo/base/parse_number.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/platform/cstdint.h"
@@ -58,8 +62,7 @@ namespace mongo {
         ID_RESERVE_SIZE = 64,
         PAT_RESERVE_SIZE = 4096,
         OPT_RESERVE_SIZE = 64,
-        FIELD_RESERVE_SIZE = 4096,
-        STRINGVAL_RESERVE_SIZE = 4096,
+        FIELD_RESERVE_SIZE = 64,
         BINDATA_RESERVE_SIZE = 4096,
         BINDATATYPE_RESERVE_SIZE = 4096,
         NS_RESERVE_SIZE = 64,
@@ -80,6 +83,40 @@ namespace mongo {
                  *SINGLEQUOTE = "'",
                  *DOUBLEQUOTE = "\"";
 
+namespace {
+    inline bool isPlainChar(char c, char terminal) {
+        return static_cast<unsigned char>(c) > 0x1F && c != '\\' && c != terminal;
+    }
+
+    /**
+     * Returns the end of the run starting at 'q' of characters which chars() copies as they are:
+     * anything but a control character, a backslash or 'terminal'.
+     */
+    const char* plainRunEnd(const char* q, const char* end, char terminal) {
+#if defined(__SSE2__)
+        const __m128i terminals = _mm_set1_epi8(terminal);
+        const __m128i backslashes = _mm_set1_epi8('\\');
+        const __m128i lastControl = _mm_set1_epi8(0x1F);
+        while (end - q >= 16) {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q));
+            // A byte is a control character when its unsigned max with 0x1F is 0x1F.
+            const __m128i special =
+                _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, terminals),
+                                          _mm_cmpeq_epi8(chunk, backslashes)),
+                             _mm_cmpeq_epi8(_mm_max_epu8(chunk, lastControl), lastControl));
+            if (_mm_movemask_epi8(special) != 0) {
+                break;
+            }
+            q += 16;
+        }
+#endif
+        while (q < end && isPlainChar(*q, terminal)) {
+            ++q;
+        }
+        return q;
+    }
+} // namespace
+
     JParse::JParse(const StringData& str)
         : _buf(str.rawData())
         , _input(_buf)
@@ -98,6 +135,31 @@ namespace mongo {
 
     Status JParse::value(const StringData& fieldName, BSONObjBuilder& builder) {
         MONGO_JSON_DEBUG("fieldName: " << fieldName);
+
+        // Strings and plain numbers are by far the most common values, so look for them before
+        // trying each of the other tokens in turn.
+        const char* next = _input;
+        while (next < _input_end && isspace(*reinterpret_cast<const unsigned char*>(next))) {
+            ++next;
+        }
+        if (next < _input_end) {
+            if (*next == '"' || *next == '\'') {
+                std::string scratch;
+                StringData valueString;
+                Status ret = quotedString(&valueString, &scratch);
+                if (ret != Status::OK()) {
+                    return ret;
+                }
+                builder.append(fieldName, valueString);
+                return Status::OK();
+            }
+            if (isdigit(*reinterpret_cast<const unsigned char*>(next)) ||
+                (*next == '-' && next + 1 < _input_end &&
+                 isdigit(*reinterpret_cast<const unsigned char*>(next + 1)))) {
+                return number(fieldName, builder);
+            }
+        }
+
         if (peekToken(LBRACE)) {
             Status ret = object(fieldName, builder);
             if (ret != Status::OK()) {
@@ -158,15 +220,6 @@ namespace mongo {
                 return ret;
             }
         }
-        else if (peekToken(DOUBLEQUOTE) || peekToken(SINGLEQUOTE)) {
-            std::string valueString;
-            valueString.reserve(STRINGVAL_RESERVE_SIZE);
-            Status ret = quotedString(&valueString);
-            if (ret != Status::OK()) {
-                return ret;
-            }
-            builder.append(fieldName, valueString);
-        }
         else if (readToken("true")) {
             builder.append(fieldName, true);
         }
@@ -217,9 +270,9 @@ namespace mongo {
         }
 
         // Special object
-        std::string firstField;
-        firstField.reserve(FIELD_RESERVE_SIZE);
-        Status ret = field(&firstField);
+        std::string firstFieldScratch;
+        StringData firstField;
+        Status ret = field(&firstField, &firstFieldScratch);
         if (ret != Status::OK()) {
             return ret;
         }
@@ -332,10 +385,10 @@ namespace mongo {
             if (valueRet != Status::OK()) {
                 return valueRet;
             }
+            std::string fieldNameScratch;
             while (readToken(COMMA)) {
-                std::string fieldName;
-                fieldName.reserve(FIELD_RESERVE_SIZE);
-                Status fieldRet = field(&fieldName);
+                StringData fieldName;
+                Status fieldRet = field(&fieldName, &fieldNameScratch);
                 if (fieldRet != Status::OK()) {
                     return fieldRet;
                 }
@@ -973,6 +1026,41 @@ namespace mongo {
     }
 
     Status JParse::number(const StringData& fieldName, BSONObjBuilder& builder) {
+        // Integers of up to 18 digits cannot overflow a long long, so those need neither strtod
+        // nor strtoll unless a character which could continue a double follows them.
+        const char* p = _input;
+        while (p < _input_end && isspace(*reinterpret_cast<const unsigned char*>(p))) {
+            ++p;
+        }
+        const bool negative = p < _input_end && *p == '-';
+        if (negative) {
+            ++p;
+        }
+        const char* const digits = p;
+        long long fastll = 0;
+        while (p < _input_end && p - digits < 18 && '0' <= *p && *p <= '9') {
+            fastll = fastll * 10 + (*p++ - '0');
+        }
+        if (p != digits &&
+            !(p < _input_end && *p != '\0' && strchr(DIGIT ".eExX", *p) != NULL)) {
+            if (negative) {
+                fastll = -fastll;
+            }
+            if (fastll == static_cast<int>(fastll)) {
+                MONGO_JSON_DEBUG("Type: 32 bit int");
+                builder.append(fieldName, static_cast<int>(fastll));
+            }
+            else {
+                MONGO_JSON_DEBUG("Type: 64 bit int");
+                builder.append(fieldName, fastll);
+            }
+            _input = p;
+            if (_input >= _input_end) {
+                return parseError("Trailing number at end of input");
+            }
+            return Status::OK();
+        }
+
         char* endptrll;
         char* endptrd;
         long long retll;
@@ -1044,6 +1132,50 @@ namespace mongo {
         }
     }
 
+    Status JParse::field(StringData* result, std::string* scratch) {
+        if (readUnescapedString(result)) {
+            return Status::OK();
+        }
+        scratch->clear();
+        Status ret = field(scratch);
+        if (ret != Status::OK()) {
+            return ret;
+        }
+        *result = *scratch;
+        return Status::OK();
+    }
+
+    Status JParse::quotedString(StringData* result, std::string* scratch) {
+        if (readUnescapedString(result)) {
+            return Status::OK();
+        }
+        scratch->clear();
+        Status ret = quotedString(scratch);
+        if (ret != Status::OK()) {
+            return ret;
+        }
+        *result = *scratch;
+        return Status::OK();
+    }
+
+    bool JParse::readUnescapedString(StringData* result) {
+        const char* q = _input;
+        while (q < _input_end && isspace(*reinterpret_cast<const unsigned char*>(q))) {
+            ++q;
+        }
+        if (q >= _input_end || (*q != '"' && *q != '\'')) {
+            return false;
+        }
+        const char quote = *q++;
+        const char* const end = plainRunEnd(q, _input_end, quote);
+        if (end >= _input_end || *end != quote) {
+            return false;
+        }
+        *result = StringData(q, end - q);
+        _input = end + 1;
+        return true;
+    }
+
     Status JParse::quotedString(std::string* result) {
         MONGO_JSON_DEBUG("");
         if (readToken(DOUBLEQUOTE)) {
@@ -1080,9 +1212,18 @@ namespace mongo {
         if (_input >= _input_end) {
             return parseError("Unexpected end of input");
         }
+        // Quoted strings end at a single character; copy the runs between escapes at once.
+        const bool copyRuns = allowedSet == NULL && terminalSet[0] != '\0' &&
+                              terminalSet[1] == '\0';
         const char* q = _input;
         while (q < _input_end && !match(*q, terminalSet)) {
             MONGO_JSON_DEBUG("q: " << q);
+            if (copyRuns && isPlainChar(*q, terminalSet[0])) {
+                const char* const run = q;
+                q = plainRunEnd(q, _input_end, terminalSet[0]);
+                result->append(run, q);
+                continue;
+            }
             if (allowedSet != NULL) {
                 if (!match(*q, allowedSet)) {
                     _input = q;
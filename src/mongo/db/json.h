@@ -370,6 +370,20 @@ namespace mongo {
              */
             Status quotedString(std::string* result);
 
+            /*
+             * Parse a field name or quoted string into '*result'. When it holds no escape
+             * sequences '*result' points into the input; otherwise it is unescaped into
+             * '*scratch', which '*result' then points to.
+             */
+            Status field(StringData* result, std::string* scratch);
+            Status quotedString(StringData* result, std::string* scratch);
+
+            /**
+             * @return true if the next token is a quoted string with no escape sequences, after
+             * setting '*result' to its contents in the input and advancing past it.
+             */
+            bool readUnescapedString(StringData* result);
+
             /*
              * CHARS :
              *     CHAR
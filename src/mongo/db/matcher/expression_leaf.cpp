@@ -77,6 +77,7 @@ namespace mongo {
 
     Status ComparisonMatchExpression::init( const StringData& path, const BSONElement& rhs ) {
         _rhs = rhs;
+        _rhsIsNaN = rhs.type() == NumberDouble && isNaN( rhs._numberDouble() );
 
         if ( rhs.eoo() ) {
             return Status( ErrorCodes::BadValue, "need a real operand" );
@@ -105,10 +106,11 @@ namespace mongo {
         //log() << "\t ComparisonMatchExpression e: " << e << " _rhs: " << _rhs << "\n"
         //<< toString() << std::endl;
 
-        if ( e.canonicalType() != _rhs.canonicalType() ) {
+        const int eCanonicalType = e.canonicalType();
+        if ( eCanonicalType != _rhs.canonicalType() ) {
             // some special cases
             //  jstNULL and undefined are treated the same
-            if ( e.canonicalType() + _rhs.canonicalType() == 5 ) {
+            if ( eCanonicalType + _rhs.canonicalType() == 5 ) {
                 return matchType() == EQ || matchType() == LTE || matchType() == GTE;
             }
 
@@ -120,9 +122,10 @@ namespace mongo {
         }
 
         // Special case handling for NaN. NaN is equal to NaN but
-        // otherwise always compares to false.
-        if (isNaN(e.numberDouble()) || isNaN(_rhs.numberDouble())) {
-            bool bothNaN = isNaN(e.numberDouble()) && isNaN(_rhs.numberDouble());
+        // otherwise always compares to false.  Only doubles can be NaN.
+        const bool eIsNaN = e.type() == NumberDouble && isNaN(e._numberDouble());
+        if (eIsNaN || _rhsIsNaN) {
+            bool bothNaN = eIsNaN && _rhsIsNaN;
             switch ( matchType() ) {
             case LT:
                 return false;
@@ -82,7 +82,8 @@ namespace mongo {
      */
     class ComparisonMatchExpression : public LeafMatchExpression {
     public:
-        ComparisonMatchExpression( MatchType type ) : LeafMatchExpression( type ){}
+        ComparisonMatchExpression( MatchType type )
+            : LeafMatchExpression( type ), _rhsIsNaN( false ) {}
 
         Status init( const StringData& path, const BSONElement& rhs );
 
@@ -102,6 +103,10 @@ namespace mongo {
 
     protected:
         BSONElement _rhs;
+
+    private:
+        // Worked out once by init() rather than for every document.
+        bool _rhsIsNaN;
     };
 
     //
@@ -30,6 +30,8 @@
 
 #include "mongo/db/matcher/expression_tree.h"
 
+#include <algorithm>
+
 #include "mongo/bson/bsonobj.h"
 #include "mongo/bson/bsonmisc.h"
 #include "mongo/bson/bsonobjbuilder.h"
@@ -37,6 +39,53 @@
 
 namespace mongo {
 
+    namespace {
+
+        /**
+         * A rough rank of how expensive 'expr' is to evaluate against one document.  Lists cost
+         * as much as their most expensive child.
+         */
+        int evaluationCost( const MatchExpression* expr ) {
+            switch ( expr->matchType() ) {
+            case MatchExpression::AND:
+            case MatchExpression::OR:
+            case MatchExpression::NOR:
+            case MatchExpression::NOT: {
+                int cost = 0;
+                for ( size_t i = 0; i < expr->numChildren(); i++ )
+                    cost = std::max( cost, evaluationCost( expr->getChild( i ) ) );
+                return cost;
+            }
+            case MatchExpression::MATCH_IN:
+            case MatchExpression::NIN:
+                return 1;
+            case MatchExpression::ELEM_MATCH_OBJECT:
+            case MatchExpression::ELEM_MATCH_VALUE:
+                return 2;
+            case MatchExpression::REGEX:
+                return 3;
+            case MatchExpression::GEO:
+            case MatchExpression::GEO_NEAR:
+            case MatchExpression::TEXT:
+            case MatchExpression::INTERNAL_2DSPHERE_KEY_IN_REGION:
+            case MatchExpression::INTERNAL_2D_KEY_IN_REGION:
+            case MatchExpression::INTERNAL_2D_POINT_IN_ANNULUS:
+                return 4;
+            case MatchExpression::WHERE:
+                return 5;
+            default:
+                return 0;
+            }
+        }
+
+        struct CostLess {
+            explicit CostLess( const std::vector<int>& costs ) : costs( costs ) {}
+            bool operator()( size_t lhs, size_t rhs ) const { return costs[lhs] < costs[rhs]; }
+            const std::vector<int>& costs;
+        };
+
+    }  // namespace
+
     ListOfMatchExpression::~ListOfMatchExpression() {
         for ( unsigned i = 0; i < _expressions.size(); i++ )
             delete _expressions[i];
@@ -46,6 +95,19 @@ namespace mongo {
     void ListOfMatchExpression::add( MatchExpression* e ) {
         verify( e );
         _expressions.push_back( e );
+        _evaluationOrder.clear();
+    }
+
+    void ListOfMatchExpression::_computeEvaluationOrder() const {
+        std::vector<int> costs( _expressions.size() );
+        _evaluationOrder.resize( _expressions.size() );
+        for ( size_t i = 0; i < _expressions.size(); i++ ) {
+            costs[i] = evaluationCost( _expressions[i] );
+            _evaluationOrder[i] = i;
+        }
+
+        // Stable, so predicates of equal cost keep the order they were written in.
+        std::stable_sort( _evaluationOrder.begin(), _evaluationOrder.end(), CostLess( costs ) );
     }
 
 
@@ -82,8 +144,12 @@ namespace mongo {
     // -----
 
     bool AndMatchExpression::matches( const MatchableDocument* doc, MatchDetails* details ) const {
+        // Which array position is recorded in 'details' depends on the order the children
+        // match in, so keep the order they were written in when one is wanted.
+        const bool inOrder = details && details->needRecord();
         for ( size_t i = 0; i < numChildren(); i++ ) {
-            if ( !getChild(i)->matches( doc, details ) ) {
+            const MatchExpression* child = inOrder ? getChild(i) : getChildToEvaluate(i);
+            if ( !child->matches( doc, details ) ) {
                 if ( details )
                     details->resetOutput();
                 return false;
@@ -94,7 +160,7 @@ namespace mongo {
 
     bool AndMatchExpression::matchesSingleElement( const BSONElement& e ) const {
         for ( size_t i = 0; i < numChildren(); i++ ) {
-            if ( !getChild(i)->matchesSingleElement( e ) ) {
+            if ( !getChildToEvaluate(i)->matchesSingleElement( e ) ) {
                 return false;
             }
         }
@@ -117,7 +183,7 @@ namespace mongo {
 
     bool OrMatchExpression::matches( const MatchableDocument* doc, MatchDetails* details ) const {
         for ( size_t i = 0; i < numChildren(); i++ ) {
-            if ( getChild(i)->matches( doc, NULL ) ) {
+            if ( getChildToEvaluate(i)->matches( doc, NULL ) ) {
                 return true;
             }
         }
@@ -126,7 +192,7 @@ namespace mongo {
 
     bool OrMatchExpression::matchesSingleElement( const BSONElement& e ) const {
         for ( size_t i = 0; i < numChildren(); i++ ) {
-            if ( getChild(i)->matchesSingleElement( e ) ) {
+            if ( getChildToEvaluate(i)->matchesSingleElement( e ) ) {
                 return true;
             }
         }
@@ -149,7 +215,7 @@ namespace mongo {
 
     bool NorMatchExpression::matches( const MatchableDocument* doc, MatchDetails* details ) const {
         for ( size_t i = 0; i < numChildren(); i++ ) {
-            if ( getChild(i)->matches( doc, NULL ) ) {
+            if ( getChildToEvaluate(i)->matches( doc, NULL ) ) {
                 return false;
             }
         }
@@ -158,7 +224,7 @@ namespace mongo {
 
     bool NorMatchExpression::matchesSingleElement( const BSONElement& e ) const {
         for ( size_t i = 0; i < numChildren(); i++ ) {
-            if ( getChild(i)->matchesSingleElement( e ) ) {
+            if ( getChildToEvaluate(i)->matchesSingleElement( e ) ) {
                 return false;
             }
         }
@@ -54,13 +54,17 @@ namespace mongo {
          * clears all the thingsd we own, and does NOT delete
          * someone else has taken ownership
          */
-        void clearAndRelease() { _expressions.clear(); }
+        void clearAndRelease() { _expressions.clear(); _evaluationOrder.clear(); }
 
         virtual size_t numChildren() const { return _expressions.size(); }
 
         virtual MatchExpression* getChild( size_t i ) const { return _expressions[i]; }
 
-        virtual std::vector<MatchExpression*>* getChildVector() { return &_expressions; }
+        virtual std::vector<MatchExpression*>* getChildVector() {
+            // The caller may rearrange the children.
+            _evaluationOrder.clear();
+            return &_expressions;
+        }
 
         bool equivalent( const MatchExpression* other ) const;
 
@@ -69,8 +73,25 @@ namespace mongo {
 
         void _listToBSON(BSONArrayBuilder* out) const;
 
+        /**
+         * Returns the i-th child to evaluate.  The children are visited cheapest first, so
+         * that a short-circuiting list rarely evaluates a $regex or $where when a plain
+         * comparison decides the result.  The order is worked out on first use.
+         */
+        MatchExpression* getChildToEvaluate( size_t i ) const {
+            if ( _evaluationOrder.size() != _expressions.size() )
+                _computeEvaluationOrder();
+            return _expressions[_evaluationOrder[i]];
+        }
+
     private:
+        void _computeEvaluationOrder() const;
+
         std::vector< MatchExpression* > _expressions;
+
+        // Positions in _expressions, ordered by evaluation cost.  Emptied by anything that can
+        // change the children.
+        mutable std::vector< size_t > _evaluationOrder;
     };
 
     class AndMatchExpression : public ListOfMatchExpression {
@@ -206,6 +206,56 @@ namespace mongo {
         ASSERT_EQUALS( "1", details.elemMatchKey() );
     }
 
+    TEST( AndOp, RegexClauseFirst ) {
+        auto_ptr<RegexMatchExpression> sub1( new RegexMatchExpression() );
+        ASSERT( sub1->init( "a", "^x", "" ).isOK() );
+
+        BSONObj baseOperand2 = BSON( "b" << 2 );
+        auto_ptr<ComparisonMatchExpression> sub2( new EqualityMatchExpression() );
+        ASSERT( sub2->init( "b", baseOperand2[ "b" ] ).isOK() );
+
+        AndMatchExpression andOp;
+        andOp.add( sub1.release() );
+        andOp.add( sub2.release() );
+
+        ASSERT( andOp.matchesBSON( BSON( "a" << "xy" << "b" << 2 ), NULL ) );
+        ASSERT( !andOp.matchesBSON( BSON( "a" << "yx" << "b" << 2 ), NULL ) );
+        ASSERT( !andOp.matchesBSON( BSON( "a" << "xy" << "b" << 3 ), NULL ) );
+
+        // The clauses may be evaluated cheapest first, but the elem match key is still the one
+        // of the last clause as written.
+        MatchDetails details;
+        details.requestElemMatchKey();
+        ASSERT( andOp.matchesBSON( BSON( "a" << BSON_ARRAY( "xy" << "z" ) <<
+                                         "b" << BSON_ARRAY( 1 << 2 << 3 ) ),
+                                   &details ) );
+        ASSERT( details.hasElemMatchKey() );
+        ASSERT_EQUALS( "1", details.elemMatchKey() );
+    }
+
+    TEST( AndOp, ChildReplacedAfterMatching ) {
+        BSONObj baseOperand = BSON( "a" << 1 << "b" << 2 );
+        auto_ptr<ComparisonMatchExpression> sub1( new EqualityMatchExpression() );
+        ASSERT( sub1->init( "a", baseOperand[ "a" ] ).isOK() );
+        auto_ptr<RegexMatchExpression> sub2( new RegexMatchExpression() );
+        ASSERT( sub2->init( "c", "^x", "" ).isOK() );
+
+        AndMatchExpression andOp;
+        andOp.add( sub1.release() );
+        andOp.add( sub2.release() );
+        ASSERT( !andOp.matchesBSON( BSON( "a" << 1 << "b" << 2 ), NULL ) );
+
+        // Swap the regex for another cheap clause.
+        auto_ptr<ComparisonMatchExpression> sub3( new EqualityMatchExpression() );
+        ASSERT( sub3->init( "b", baseOperand[ "b" ] ).isOK() );
+        std::vector<MatchExpression*>* children = andOp.getChildVector();
+        delete (*children)[1];
+        (*children)[1] = sub3.release();
+
+        ASSERT( andOp.matchesBSON( BSON( "a" << 1 << "b" << 2 ), NULL ) );
+        ASSERT( !andOp.matchesBSON( BSON( "a" << 1 << "b" << 3 ), NULL ) );
+    }
+
     /**
     TEST( AndOp, MatchesIndexKeyWithoutUnknown ) {
         BSONObj baseOperand1 = BSON( "$gt" << 1 );
@@ -30,6 +30,7 @@
 
 #pragma once
 
+#include "mongo/bson/bson_field_index.h"
 #include "mongo/bson/bsonobj.h"
 #include "mongo/db/field_ref.h"
 #include "mongo/db/matcher/path.h"
@@ -82,9 +83,9 @@ namespace mongo {
 
         virtual ElementIterator* allocateIterator( const ElementPath* path ) const {
             if ( _iteratorUsed )
-                return new BSONElementIterator( path, _obj );
+                return new BSONElementIterator( path, _obj, &_fieldIndex );
             _iteratorUsed = true;
-            _iterator.reset( path, _obj );
+            _iterator.reset( path, _obj, &_fieldIndex );
             return &_iterator;
         }
 
@@ -101,5 +102,9 @@ namespace mongo {
         BSONObj _obj;
         mutable BSONElementIterator _iterator;
         mutable bool _iteratorUsed;
+
+        // Shared by the iterators of every leaf, so a wide document is scanned once however
+        // many fields the expression looks at.
+        mutable BSONFieldIndex _fieldIndex;
     };
 }
@@ -36,6 +36,13 @@
 namespace mongo {
 
     Status ElementPath::init( const StringData& path ) {
+        _shouldTraverseNonleafArrays = true;
+        _shouldTraverseLeafArray = true;
+        _fieldRef.parseInterned( path );
+        return Status::OK();
+    }
+
+    Status ElementPath::initUninterned( const StringData& path ) {
         _shouldTraverseNonleafArrays = true;
         _shouldTraverseLeafArray = true;
         _fieldRef.parse( path );
@@ -88,10 +95,13 @@ namespace mongo {
     // ------
     BSONElementIterator::BSONElementIterator() {
         _path = NULL;
+        _fieldIndex = NULL;
     }
 
-    BSONElementIterator::BSONElementIterator( const ElementPath* path, const BSONObj& context )
-        : _path( path ), _context( context ) {
+    BSONElementIterator::BSONElementIterator( const ElementPath* path,
+                                              const BSONObj& context,
+                                              BSONFieldIndex* fieldIndex )
+        : _path( path ), _context( context ), _fieldIndex( fieldIndex ) {
         _state = BEGIN;
         //log() << "path: " << path.fieldRef().dottedField() << " context: " << context << endl;
     }
@@ -99,9 +109,12 @@ namespace mongo {
     BSONElementIterator::~BSONElementIterator() {
     }
 
-    void BSONElementIterator::reset( const ElementPath* path, const BSONObj& context ) {
+    void BSONElementIterator::reset( const ElementPath* path,
+                                     const BSONObj& context,
+                                     BSONFieldIndex* fieldIndex ) {
         _path = path;
         _context = context;
+        _fieldIndex = fieldIndex;
         _state = BEGIN;
         _next.reset();
 
@@ -168,7 +181,7 @@ namespace mongo {
                 }
 
                 _subCursorPath.reset( new ElementPath() );
-                _subCursorPath->init( _arrayIterationState.restOfPath.substr( _arrayIterationState.nextPieceOfPath.size() + 1 ) );
+                _subCursorPath->initUninterned( _arrayIterationState.restOfPath.substr( _arrayIterationState.nextPieceOfPath.size() + 1 ) );
                 _subCursorPath->setTraverseLeafArray( _path->shouldTraverseLeafArray() );
 
                 // If we're here, we must be able to traverse nonleaf arrays.
@@ -200,7 +213,8 @@ namespace mongo {
 
         if ( _state == BEGIN ) {
             size_t idxPath = 0;
-            BSONElement e = getFieldDottedOrArray( _context, _path->fieldRef(), &idxPath );
+            BSONElement e = getFieldDottedOrArray( _context, _path->fieldRef(), &idxPath,
+                                                   _fieldIndex );
 
             if ( e.type() != Array ) {
                 _next.reset( e, BSONElement(), false );
@@ -250,7 +264,7 @@ namespace mongo {
                     // The current array element is a subdocument.  See if the subdocument generates
                     // any elements matching the remaining subpath.
                     _subCursorPath.reset( new ElementPath() );
-                    _subCursorPath->init( _arrayIterationState.restOfPath );
+                    _subCursorPath->initUninterned( _arrayIterationState.restOfPath );
                     _subCursorPath->setTraverseLeafArray( _path->shouldTraverseLeafArray() );
 
                     _subCursor.reset( new BSONElementIterator( _subCursorPath.get(),
@@ -277,7 +291,7 @@ namespace mongo {
                         // The current array element is itself an array.  See if the nested array
                         // has any elements matching the remainihng.
                         _subCursorPath.reset( new ElementPath() );
-                        _subCursorPath->init( _arrayIterationState.restOfPath.substr( _arrayIterationState.nextPieceOfPath.size() + 1 ) );
+                        _subCursorPath->initUninterned( _arrayIterationState.restOfPath.substr( _arrayIterationState.nextPieceOfPath.size() + 1 ) );
                         _subCursorPath->setTraverseLeafArray( _path->shouldTraverseLeafArray() );
                         BSONElementIterator* real =
                             new BSONElementIterator( _subCursorPath.get(),
@@ -34,6 +34,7 @@
 
 #include "mongo/base/status.h"
 #include "mongo/base/string_data.h"
+#include "mongo/bson/bson_field_index.h"
 #include "mongo/bson/bsonobj.h"
 #include "mongo/bson/bsonobjiterator.h"
 #include "mongo/db/field_ref.h"
@@ -42,8 +43,17 @@ namespace mongo {
 
     class ElementPath {
     public:
+        /**
+         * Initializes from 'path', which is shared with the FieldRefTable.
+         */
         Status init( const StringData& path );
 
+        /**
+         * Same as init(), for the paths of array sub-cursors. Those are built while iterating
+         * over documents, where splitting a short path beats a lookup in the shared table.
+         */
+        Status initUninterned( const StringData& path );
+
         void setTraverseNonleafArrays( bool b ) { _shouldTraverseNonleafArrays = b; }
         void setTraverseLeafArray( bool b ) { _shouldTraverseLeafArray = b; }
 
@@ -119,11 +129,20 @@ namespace mongo {
     class BSONElementIterator : public ElementIterator {
     public:
         BSONElementIterator();
-        BSONElementIterator( const ElementPath* path, const BSONObj& context );
+
+        /**
+         * If 'fieldIndex' is not NULL, the top-level field of 'path' is looked up through it.
+         * It must outlive this iterator and may be shared with other iterators over 'context'.
+         */
+        BSONElementIterator( const ElementPath* path,
+                             const BSONObj& context,
+                             BSONFieldIndex* fieldIndex = NULL );
 
         virtual ~BSONElementIterator();
 
-        void reset( const ElementPath* path, const BSONObj& context );
+        void reset( const ElementPath* path,
+                    const BSONObj& context,
+                    BSONFieldIndex* fieldIndex = NULL );
 
         bool more();
         Context next();
@@ -137,6 +156,7 @@ namespace mongo {
 
         const ElementPath* _path;
         BSONObj _context;
+        BSONFieldIndex* _fieldIndex; // not owned, may be NULL
 
         enum State { BEGIN, IN_ARRAY, DONE } _state;
         Context _next;
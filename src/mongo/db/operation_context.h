@@ -34,6 +34,7 @@
 #include "mongo/db/storage/recovery_unit.h"
 #include "mongo/db/concurrency/locker.h"
 #include "mongo/db/concurrency/d_concurrency.h"
+#include "mongo/db/operation_resource_stats.h"
 
 namespace mongo {
 
@@ -133,8 +134,18 @@ namespace mongo {
          */
         virtual bool isPrimaryFor( const StringData& ns ) = 0;
 
+        /**
+         * Where this operation's time went: lock, ticket and storage waits, and CPU time.  Only
+         * the thread running the operation may change it.
+         */
+        OperationResourceStats* resourceStats() { return &_resourceStats; }
+        const OperationResourceStats* resourceStats() const { return &_resourceStats; }
+
     protected:
         OperationContext() { }
+
+    private:
+        OperationResourceStats _resourceStats;
     };
 
     class WriteUnitOfWork {
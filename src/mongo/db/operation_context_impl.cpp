@@ -62,6 +62,7 @@ namespace {
         else {
             _locker.reset(new LockerImpl<false>(idCounter.addAndFetch(1)));
         }
+        _locker->setResourceStats(resourceStats());
 
         _client->setOperationContext(this);
     }
@@ -0,0 +1,95 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/operation_resource_stats.h"
+
+#if !defined(_WIN32)
+#include <time.h>
+#endif
+
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    OperationResourceStats OperationResourceStats::since(
+            const OperationResourceStats& start) const {
+        OperationResourceStats delta;
+        delta.lockWaits = lockWaits - start.lockWaits;
+        delta.lockWaitMicros = lockWaitMicros - start.lockWaitMicros;
+        delta.ticketWaits = ticketWaits - start.ticketWaits;
+        delta.ticketWaitMicros = ticketWaitMicros - start.ticketWaitMicros;
+        delta.storageWaits = storageWaits - start.storageWaits;
+        delta.storageWaitMicros = storageWaitMicros - start.storageWaitMicros;
+        delta.cpuMicros = cpuMicros - start.cpuMicros;
+        return delta;
+    }
+
+    bool OperationResourceStats::empty() const {
+        return lockWaits == 0 && ticketWaits == 0 && storageWaits == 0 && cpuMicros == 0;
+    }
+
+#define RESOURCE_STATS_APPEND(x) if ( x > 0 ) builder->appendNumber( #x , (x) )
+    void OperationResourceStats::append(BSONObjBuilder* builder) const {
+        RESOURCE_STATS_APPEND( cpuMicros );
+        RESOURCE_STATS_APPEND( lockWaits );
+        RESOURCE_STATS_APPEND( lockWaitMicros );
+        RESOURCE_STATS_APPEND( ticketWaits );
+        RESOURCE_STATS_APPEND( ticketWaitMicros );
+        RESOURCE_STATS_APPEND( storageWaits );
+        RESOURCE_STATS_APPEND( storageWaitMicros );
+    }
+#undef RESOURCE_STATS_APPEND
+
+    // static
+    long long OperationResourceStats::threadCpuMicros() {
+#if defined(_WIN32)
+        FILETIME creation, exit, kernel, user;
+        if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+            return -1;
+        }
+        // FILETIMEs count 100ns intervals
+        ULARGE_INTEGER k, u;
+        k.LowPart = kernel.dwLowDateTime;
+        k.HighPart = kernel.dwHighDateTime;
+        u.LowPart = user.dwLowDateTime;
+        u.HighPart = user.dwHighDateTime;
+        return static_cast<long long>((k.QuadPart + u.QuadPart) / 10);
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+        struct timespec t;
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t) != 0) {
+            return -1;
+        }
+        return static_cast<long long>(t.tv_sec) * 1000 * 1000 + t.tv_nsec / 1000;
+#else
+        return -1;
+#endif
+    }
+
+}  // namespace mongo
@@ -0,0 +1,95 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+namespace mongo {
+
+    class BSONObjBuilder;
+
+    /**
+     * Where the time of one operation went, beyond the counts OpDebug already keeps.
+     *
+     * Each OperationContext owns one.  Only the operation's own thread adds to it: the Locker
+     * for lock and admission ticket waits, query yielding for storage engine page-ins, and
+     * assembleResponse() for the thread's CPU time.  currentOp reads it without synchronization,
+     * as it does numYields, so a report taken while the operation runs may be slightly stale.
+     *
+     * Nothing here is measured on the fast paths: lock and ticket waits are only timed when the
+     * request actually queues, so an operation which never waits pays nothing.
+     */
+    struct OperationResourceStats {
+        OperationResourceStats() { reset(); }
+
+        void reset() {
+            lockWaits = 0;
+            lockWaitMicros = 0;
+            ticketWaits = 0;
+            ticketWaitMicros = 0;
+            storageWaits = 0;
+            storageWaitMicros = 0;
+            cpuMicros = 0;
+        }
+
+        /**
+         * The counts accumulated since 'start', an earlier copy of these stats.  Nested
+         * operations, such as those of DBDirectClient, share their parent's OperationContext and
+         * use this to report only their own share.
+         */
+        OperationResourceStats since(const OperationResourceStats& start) const;
+
+        bool empty() const;
+
+        /**
+         * Appends the non-zero counts to 'builder'.
+         */
+        void append(BSONObjBuilder* builder) const;
+
+        /**
+         * CPU time, in microseconds, that the calling thread has used so far, or -1 if the
+         * platform cannot tell.
+         */
+        static long long threadCpuMicros();
+
+        // Lock manager requests which had to queue, and the time spent queued
+        long long lockWaits;
+        long long lockWaitMicros;
+
+        // Global lock requests which had to queue for an admission ticket
+        long long ticketWaits;
+        long long ticketWaitMicros;
+
+        // Yields to let the storage engine bring a record into memory, and their duration
+        long long storageWaits;
+        long long storageWaitMicros;
+
+        // CPU time of the operation's thread, set when the operation completes
+        long long cpuMicros;
+    };
+
+}  // namespace mongo
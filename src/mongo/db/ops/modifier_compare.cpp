@@ -68,7 +68,7 @@ namespace mongo {
     Status ModifierCompare::init(const BSONElement& modExpr, const Options& opts,
                                  bool* positional) {
 
-        _updatePath.parse(modExpr.fieldName());
+        _updatePath.parseInterned(modExpr.fieldName());
         Status status = fieldchecker::isUpdatable(_updatePath);
         if (!status.isOK()) {
             return status;
@@ -180,7 +180,7 @@ namespace {
 
         ASSERT_OK(mod.apply());
         ASSERT_EQUALS(fromjson("{a : 0}"), doc);
-        ASSERT_FALSE(doc.isInPlaceModeEnabled());
+        ASSERT_TRUE(doc.isInPlaceModeEnabled());
 
         Document logDoc;
         LogBuilder logBuilder(logDoc.root());
@@ -218,7 +218,7 @@ namespace {
 
         ASSERT_OK(mod.apply());
         ASSERT_EQUALS(fromjson("{a : 0}"), doc);
-        ASSERT_FALSE(doc.isInPlaceModeEnabled());
+        ASSERT_TRUE(doc.isInPlaceModeEnabled());
 
         Document logDoc;
         LogBuilder logBuilder(logDoc.root());
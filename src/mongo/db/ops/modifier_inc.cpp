@@ -86,7 +86,7 @@ namespace mongo {
         //
 
         // Perform standard field name and updateable checks.
-        _fieldRef.parse(modExpr.fieldName());
+        _fieldRef.parseInterned(modExpr.fieldName());
         Status status = fieldchecker::isUpdatable(_fieldRef);
         if (! status.isOK()) {
             return status;
@@ -168,7 +168,7 @@ namespace {
         ASSERT_FALSE(execInfo.noOp);
 
         ASSERT_OK(incMod.apply());
-        ASSERT_FALSE(doc.isInPlaceModeEnabled());
+        ASSERT_TRUE(doc.isInPlaceModeEnabled());
         ASSERT_EQUALS(fromjson("{ a : 1 }"), doc);
 
         Document logDoc;
@@ -461,7 +461,7 @@ namespace {
         ASSERT_FALSE(execInfo.noOp);
 
         ASSERT_OK(incMod.apply());
-        ASSERT_FALSE(doc.isInPlaceModeEnabled());
+        ASSERT_TRUE(doc.isInPlaceModeEnabled());
         ASSERT_EQUALS(fromjson("{ a : 0, b : 0 }"), doc);
 
         Document logDoc;
@@ -482,7 +482,7 @@ namespace {
         ASSERT_FALSE(execInfo.noOp);
 
         ASSERT_OK(incMod.apply());
-        ASSERT_FALSE(doc.isInPlaceModeEnabled());
+        ASSERT_TRUE(doc.isInPlaceModeEnabled());
         ASSERT_EQUALS(BSON("a" << int_zero << "b" << int_zero), doc);
         ASSERT_EQUALS(mongo::NumberInt, doc.root().rightChild().getType());
     }
@@ -499,7 +499,7 @@ namespace {
         ASSERT_FALSE(execInfo.noOp);
 
         ASSERT_OK(incMod.apply());
-        ASSERT_FALSE(doc.isInPlaceModeEnabled());
+        ASSERT_TRUE(doc.isInPlaceModeEnabled());
         ASSERT_EQUALS(BSON("a" << ll_zero << "b" << ll_zero), doc);
         ASSERT_EQUALS(mongo::NumberLong, doc.root().rightChild().getType());
     }
@@ -516,7 +516,7 @@ namespace {
         ASSERT_FALSE(execInfo.noOp);
 
         ASSERT_OK(incMod.apply());
-        ASSERT_FALSE(doc.isInPlaceModeEnabled());
+        ASSERT_TRUE(doc.isInPlaceModeEnabled());
         ASSERT_EQUALS(BSON("a" << double_zero << "b" << 0), doc);
         ASSERT_EQUALS(mongo::NumberDouble, doc.root().rightChild().getType());
     }
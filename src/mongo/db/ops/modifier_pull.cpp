@@ -84,7 +84,7 @@ namespace mongo {
     Status ModifierPull::init(const BSONElement& modExpr, const Options& opts,
                               bool* positional) {
         // Perform standard field name and updateable checks.
-        _fieldRef.parse(modExpr.fieldName());
+        _fieldRef.parseInterned(modExpr.fieldName());
         Status status = fieldchecker::isUpdatable(_fieldRef);
         if (! status.isOK()) {
             return status;
@@ -96,7 +96,7 @@ namespace mongo {
 
         // Break down the field name into its 'dotted' components (aka parts) and check that
         // there are no empty parts.
-        _fieldRef.parse(modExpr.fieldName());
+        _fieldRef.parseInterned(modExpr.fieldName());
         Status status = fieldchecker::isUpdatable(_fieldRef);
         if (! status.isOK()) {
             return status;
@@ -211,7 +211,7 @@ namespace mongo {
 
         // Break down the field name into its 'dotted' components (aka parts) and check that
         // the field is fit for updates.
-        _fieldRef.parse(modExpr.fieldName());
+        _fieldRef.parseInterned(modExpr.fieldName());
         Status status = fieldchecker::isUpdatable(_fieldRef);
         if (! status.isOK()) {
             return status;
@@ -525,6 +525,99 @@ namespace mongo {
                 return fromElem.addSiblingRight(elem);
             }
         }
+
+        bool isSorted(std::vector<mb::Element>::const_iterator begin,
+                      std::vector<mb::Element>::const_iterator end,
+                      const PatternElementCmp& sort) {
+            if (begin == end)
+                return true;
+            for (std::vector<mb::Element>::const_iterator next = begin + 1; next != end; ++next) {
+                if (sort(*next, *begin))
+                    return false;
+                begin = next;
+            }
+            return true;
+        }
+
+        /**
+         * Sorts the children of 'arrayElem' by 'sort' and keeps the first 'slice' of them, or
+         * the last if 'slice' is negative, or all of them if there is no slice.  The 'numPushed'
+         * children from 'pushedPos' on are the ones just added.
+         *
+         * Arrays kept sorted by earlier pushes are common, so when the other children are
+         * already in order only the pushed ones are sorted and then merged in.  Otherwise, when
+         * the slice keeps a few children, only those are put in order.  Either way only children
+         * out of place are moved.
+         */
+        Status sortAndSlice(mb::Element arrayElem,
+                            size_t pushedPos,
+                            size_t numPushed,
+                            const PatternElementCmp& sort,
+                            bool slicePresent,
+                            int64_t slice) {
+            std::vector<mb::Element> children;
+            std::vector<mb::Element> pushed;
+            size_t index = 0;
+            for (mb::Element curr = arrayElem.leftChild(); curr.ok(); curr = curr.rightSibling()) {
+                if (index >= pushedPos && index < pushedPos + numPushed) {
+                    pushed.push_back(curr);
+                }
+                else {
+                    children.push_back(curr);
+                }
+                index++;
+            }
+            const size_t numOld = children.size();
+            children.insert(children.end(), pushed.begin(), pushed.end());
+
+            const size_t total = children.size();
+            const size_t sliceSize = static_cast<size_t>(slice < 0 ? -slice : slice);
+            const size_t numKept = slicePresent ? std::min(sliceSize, total) : total;
+            const std::vector<mb::Element>::iterator begin = children.begin();
+            const std::vector<mb::Element>::iterator end = children.end();
+
+            if (isSorted(begin, begin + numOld, sort)) {
+                std::sort(begin + numOld, end, sort);
+                std::inplace_merge(begin, begin + numOld, end, sort);
+            }
+            else if (numKept < total && slice > 0) {
+                std::partial_sort(begin, begin + numKept, end, sort);
+            }
+            else if (numKept < total) {
+                std::nth_element(begin, end - numKept, end, sort);
+                std::sort(end - numKept, end, sort);
+            }
+            else {
+                std::sort(begin, end, sort);
+            }
+
+            const size_t firstKept = slice < 0 ? total - numKept : 0;
+            for (size_t i = 0; i < total; i++) {
+                if (i >= firstKept && i < firstKept + numKept)
+                    continue;
+                Status status = children[i].remove();
+                if (!status.isOK())
+                    return status;
+            }
+
+            // The children before 'next' are the ones kept so far, in order.
+            mb::Element next = arrayElem.leftChild();
+            for (size_t i = firstKept; i < firstKept + numKept; i++) {
+                if (next.ok() && next == children[i]) {
+                    next = next.rightSibling();
+                    continue;
+                }
+
+                Status status = children[i].remove();
+                if (status.isOK()) {
+                    status = next.ok() ? next.addSiblingLeft(children[i])
+                                       : arrayElem.pushBack(children[i]);
+                }
+                if (!status.isOK())
+                    return status;
+            }
+            return Status::OK();
+        }
     } //unamed namespace
 
     Status ModifierPush::apply() const {
@@ -631,9 +724,16 @@ namespace mongo {
                                     elem);
         }
 
-        // 3. Sort the resulting array, if $sort was requested.
+        // 3. Sort the resulting array, if $sort was requested, and trim it according to
+        // $slice, if present, in one go.
         if (_sortPresent) {
-            sortChildren(_preparedState->elemFound, _sort);
+            const size_t arraySize = countChildren(_preparedState->elemFound);
+            return sortAndSlice(_preparedState->elemFound,
+                                std::min(_startPosition, _preparedState->arrayPreModSize),
+                                arraySize - _preparedState->arrayPreModSize,
+                                _sort,
+                                _slicePresent,
+                                _slice);
         }
 
         // 4. Trim the resulting array according to $slice, if present.
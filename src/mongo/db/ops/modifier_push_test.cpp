@@ -1281,6 +1281,66 @@ namespace {
         }
     }
 
+    /**
+     * Sort and slice both ways, whether or not the array was in order before the push.
+     */
+    void checkSortSlice(const char* docJson, const char* modJson, const char* expectedJson) {
+        Document doc(fromjson(docJson));
+        Mod pushMod(fromjson(modJson));
+
+        ModifierInterface::ExecInfo execInfo;
+        ASSERT_OK(pushMod.prepare(doc.root(), "", &execInfo));
+        ASSERT_OK(pushMod.apply());
+        ASSERT_EQUALS(fromjson(expectedJson), doc);
+
+        Document logDoc;
+        LogBuilder logBuilder(logDoc.root());
+        ASSERT_OK(pushMod.log(&logBuilder));
+        ASSERT_EQUALS(BSON("$set" << fromjson(expectedJson)), logDoc);
+    }
+
+    TEST(SortSlicePushEach, AlreadySorted) {
+        checkSortSlice("{a: [1, 3, 5, 7]}",
+                       "{$push: {a: {$each: [4, 0, 9], $sort: 1}}}",
+                       "{a: [0, 1, 3, 4, 5, 7, 9]}");
+        checkSortSlice("{a: [1, 3, 5, 7]}",
+                       "{$push: {a: {$each: [4], $sort: 1, $slice: 3}}}",
+                       "{a: [1, 3, 4]}");
+        checkSortSlice("{a: [1, 3, 5, 7]}",
+                       "{$push: {a: {$each: [4], $sort: 1, $slice: -3}}}",
+                       "{a: [4, 5, 7]}");
+        checkSortSlice("{a: [7, 5, 3, 1]}",
+                       "{$push: {a: {$each: [6, 2], $sort: -1, $slice: 5}}}",
+                       "{a: [7, 6, 5, 3, 2]}");
+        checkSortSlice("{a: [{b: 1}, {b: 3}]}",
+                       "{$push: {a: {$each: [{b: 2}], $sort: {b: 1}, $slice: 2}}}",
+                       "{a: [{b: 1}, {b: 2}]}");
+    }
+
+    TEST(SortSlicePushEach, Unsorted) {
+        checkSortSlice("{a: [5, 1, 7, 3]}",
+                       "{$push: {a: {$each: [4, 0], $sort: 1, $slice: 2}}}",
+                       "{a: [0, 1]}");
+        checkSortSlice("{a: [5, 1, 7, 3]}",
+                       "{$push: {a: {$each: [4, 0], $sort: 1, $slice: -2}}}",
+                       "{a: [5, 7]}");
+        checkSortSlice("{a: [5, 1, 7, 3]}",
+                       "{$push: {a: {$each: [4], $sort: 1, $slice: 10}}}",
+                       "{a: [1, 3, 4, 5, 7]}");
+        checkSortSlice("{a: [5, 1, 7, 3]}",
+                       "{$push: {a: {$each: [], $sort: 1, $slice: 0}}}",
+                       "{a: []}");
+    }
+
+    TEST(SortSlicePushEach, ToPosition) {
+        checkSortSlice("{a: [1, 3, 5, 7]}",
+                       "{$push: {a: {$each: [10, 2], $position: 1, $sort: 1, $slice: 4}}}",
+                       "{a: [1, 2, 3, 5]}");
+        checkSortSlice("{a: [3, 1, 7, 5]}",
+                       "{$push: {a: {$each: [0], $position: 0, $sort: 1, $slice: -2}}}",
+                       "{a: [5, 7]}");
+    }
+
     // Push to position tests
 
     TEST(ToPosition, BadInputs) {
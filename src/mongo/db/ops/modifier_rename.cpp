@@ -86,12 +86,12 @@ namespace mongo {
 
         // Extract the field names from the mod expression
 
-        _fromFieldRef.parse(modExpr.fieldName());
+        _fromFieldRef.parseInterned(modExpr.fieldName());
         Status status = fieldchecker::isUpdatable(_fromFieldRef);
         if (!status.isOK())
             return status;
 
-        _toFieldRef.parse(modExpr.String());
+        _toFieldRef.parseInterned(modExpr.String());
         status = fieldchecker::isUpdatable(_toFieldRef);
         if (!status.isOK())
             return status;
@@ -141,7 +141,7 @@ namespace {
         ASSERT_FALSE(execInfo.noOp);
 
         ASSERT_OK(setMod.apply());
-        ASSERT_FALSE(doc.isInPlaceModeEnabled());
+        ASSERT_TRUE(doc.isInPlaceModeEnabled());
         ASSERT_EQUALS(fromjson("{a: 2}"), doc);
     }
 
@@ -201,7 +201,7 @@ namespace {
         ASSERT_FALSE(execInfo.noOp);
 
         ASSERT_OK(setMod.apply());
-        ASSERT_FALSE(doc.isInPlaceModeEnabled());
+        ASSERT_TRUE(doc.isInPlaceModeEnabled());
         ASSERT_EQUALS(fromjson("{b: 1, a: 2}"), doc);
     }
 
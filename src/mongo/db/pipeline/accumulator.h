@@ -88,6 +88,38 @@ namespace mongo {
     };
 
 
+    /**
+     * Estimates the number of distinct values with a HyperLogLog sketch, so that its memory stays
+     * bounded no matter how many distinct values it sees. Small inputs are counted exactly until
+     * kMaxExactHashes distinct hashes have been seen.
+     */
+    class AccumulatorApproxCountDistinct : public Accumulator {
+    public:
+        virtual void processInternal(const Value& input, bool merging);
+        virtual Value getValue(bool toBeMerged) const;
+        virtual const char* getOpName() const;
+        virtual void reset();
+
+        static intrusive_ptr<Accumulator> create();
+
+        static const int kPrecision = 14;
+        static const size_t kNumRegisters = 1 << kPrecision;
+        static const size_t kMaxExactHashes = 256;
+
+    private:
+        AccumulatorApproxCountDistinct();
+
+        void addHash(unsigned long long hash);
+        void addToRegisters(unsigned long long hash);
+        void switchToRegisters();
+        long long estimate() const;
+
+        typedef boost::unordered_set<unsigned long long> HashSet;
+        HashSet _hashes;
+        std::vector<unsigned char> _registers; // empty until we stop counting exactly
+    };
+
+
     class AccumulatorFirst : public Accumulator {
     public:
         virtual void processInternal(const Value& input, bool merging);
@@ -156,6 +188,49 @@ namespace mongo {
     };
 
 
+    /**
+     * Estimates a percentile of the numeric inputs with a merging t-digest. The operand evaluates
+     * to a document {input: <value>, p: <fraction in [0, 1]>}, so a constant 'p' is spelled
+     * {$percentile: {input: "$x", p: {$literal: 0.95}}}.
+     */
+    class AccumulatorPercentile : public Accumulator {
+    public:
+        virtual void processInternal(const Value& input, bool merging);
+        virtual Value getValue(bool toBeMerged) const;
+        virtual const char* getOpName() const;
+        virtual void reset();
+
+        static intrusive_ptr<Accumulator> create();
+
+        /// Bounds the number of centroids kept, trading memory for accuracy.
+        static const int kCompression = 100;
+        static const size_t kBufferSize = 500;
+
+        struct Centroid {
+            Centroid(double m, double w) : mean(m), weight(w) {}
+            bool operator<(const Centroid& other) const { return mean < other.mean; }
+            double mean;
+            double weight;
+        };
+
+    private:
+        AccumulatorPercentile();
+
+        void setPercentile(const Value& p);
+        void add(double mean, double weight);
+        void compress();
+        std::vector<Centroid> compressed() const;
+        double quantile(const std::vector<Centroid>& centroids) const;
+
+        double _p; // negative until the first input is seen
+        std::vector<Centroid> _centroids; // sorted by mean
+        std::vector<Centroid> _buffer; // not yet merged into _centroids
+        double _totalWeight;
+        double _min;
+        double _max;
+    };
+
+
     class AccumulatorPush : public Accumulator {
     public:
         virtual void processInternal(const Value& input, bool merging);
@@ -0,0 +1,185 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include <cmath>
+
+#include "mongo/db/pipeline/accumulator.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/pipeline/value.h"
+#include "mongo/platform/bits.h"
+
+namespace mongo {
+
+namespace {
+    const char hashesName[] = "hashes";
+    const char registersName[] = "registers";
+
+    // The finalizer of MurmurHash3, which spreads the bits of the Value hash across all 64 bits.
+    unsigned long long fmix64(unsigned long long k) {
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        k *= 0xc4ceb9fe1a85ec53ULL;
+        k ^= k >> 33;
+        return k;
+    }
+
+    // Values which compare equal hash equally, so 1 and 1.0 are counted once as with $addToSet.
+    unsigned long long hashValue(const Value& value) {
+        size_t low = 0;
+        value.hash_combine(low);
+        size_t high = 0x9e3779b9;
+        value.hash_combine(high);
+        return fmix64(static_cast<unsigned long long>(low) ^ fmix64(high));
+    }
+}
+
+    void AccumulatorApproxCountDistinct::processInternal(const Value& input, bool merging) {
+        if (!merging) {
+            if (!input.missing())
+                addHash(hashValue(input));
+            return;
+        }
+
+        // We expect what getValue(true) produced below: either the exact hashes or the registers.
+        verify(input.getType() == Object);
+        Value hashes = input[hashesName];
+        if (!hashes.missing()) {
+            const vector<Value>& array = hashes.getArray();
+            for (size_t i = 0; i < array.size(); i++) {
+                addHash(static_cast<unsigned long long>(array[i].getLong()));
+            }
+            return;
+        }
+
+        const BSONBinData registers = input[registersName].getBinData();
+        verify(registers.length == static_cast<int>(kNumRegisters));
+        const unsigned char* ranks = static_cast<const unsigned char*>(registers.data);
+        switchToRegisters();
+        for (size_t i = 0; i < kNumRegisters; i++) {
+            _registers[i] = std::max(_registers[i], ranks[i]);
+        }
+    }
+
+    void AccumulatorApproxCountDistinct::addHash(unsigned long long hash) {
+        if (!_registers.empty()) {
+            addToRegisters(hash);
+            return;
+        }
+
+        if (_hashes.insert(hash).second) {
+            _memUsageBytes += sizeof(hash) * 2; // the hash and its bucket
+            if (_hashes.size() > kMaxExactHashes)
+                switchToRegisters();
+        }
+    }
+
+    void AccumulatorApproxCountDistinct::addToRegisters(unsigned long long hash) {
+        // The low bits pick a register, which keeps the longest run of trailing zeros seen in the
+        // rest of the hash.
+        const size_t index = hash & (kNumRegisters - 1);
+        const unsigned long long rest = hash >> kPrecision;
+        const unsigned char rank = rest ? firstBitSet(rest) : 64 - kPrecision + 1;
+        _registers[index] = std::max(_registers[index], rank);
+    }
+
+    void AccumulatorApproxCountDistinct::switchToRegisters() {
+        if (!_registers.empty())
+            return;
+
+        _registers.resize(kNumRegisters, 0);
+        for (HashSet::const_iterator it = _hashes.begin(); it != _hashes.end(); ++it) {
+            addToRegisters(*it);
+        }
+        HashSet().swap(_hashes);
+        _memUsageBytes = sizeof(*this) + kNumRegisters;
+    }
+
+    long long AccumulatorApproxCountDistinct::estimate() const {
+        if (_registers.empty())
+            return _hashes.size();
+
+        const double m = kNumRegisters;
+        double sum = 0;
+        size_t zeros = 0;
+        for (size_t i = 0; i < kNumRegisters; i++) {
+            sum += std::ldexp(1.0, -_registers[i]);
+            if (_registers[i] == 0)
+                zeros++;
+        }
+
+        const double alpha = 0.7213 / (1 + 1.079 / m);
+        double estimate = alpha * m * m / sum;
+
+        // The raw estimate is biased for small cardinalities, where linear counting of the empty
+        // registers does better.
+        if (estimate <= 2.5 * m && zeros != 0)
+            estimate = m * std::log(m / zeros);
+
+        return static_cast<long long>(estimate + 0.5);
+    }
+
+    Value AccumulatorApproxCountDistinct::getValue(bool toBeMerged) const {
+        if (!toBeMerged)
+            return Value(estimate());
+
+        if (_registers.empty()) {
+            vector<Value> hashes;
+            hashes.reserve(_hashes.size());
+            for (HashSet::const_iterator it = _hashes.begin(); it != _hashes.end(); ++it) {
+                hashes.push_back(Value(static_cast<long long>(*it)));
+            }
+            return Value(DOC(hashesName << Value::consume(hashes)));
+        }
+
+        return Value(DOC(registersName << BSONBinData(&_registers[0],
+                                                       kNumRegisters,
+                                                       BinDataGeneral)));
+    }
+
+    AccumulatorApproxCountDistinct::AccumulatorApproxCountDistinct() {
+        _memUsageBytes = sizeof(*this);
+    }
+
+    void AccumulatorApproxCountDistinct::reset() {
+        HashSet().swap(_hashes);
+        std::vector<unsigned char>().swap(_registers);
+        _memUsageBytes = sizeof(*this);
+    }
+
+    intrusive_ptr<Accumulator> AccumulatorApproxCountDistinct::create() {
+        return new AccumulatorApproxCountDistinct();
+    }
+
+    const char *AccumulatorApproxCountDistinct::getOpName() const {
+        return "$approxCountDistinct";
+    }
+}
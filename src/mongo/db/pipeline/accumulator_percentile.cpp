@@ -0,0 +1,245 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mongo/db/pipeline/accumulator.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/pipeline/value.h"
+
+namespace mongo {
+
+namespace {
+    const char inputName[] = "input";
+    const char pName[] = "p";
+    const char centroidsName[] = "centroids";
+    const char minName[] = "min";
+    const char maxName[] = "max";
+
+    const double kPi = 3.14159265358979323846;
+
+    // The k1 scale function of the t-digest, which keeps centroids small near the tails.
+    double scale(double q) {
+        return AccumulatorPercentile::kCompression / (2 * kPi) * std::asin(2 * q - 1);
+    }
+
+    double inverseScale(double k) {
+        if (k >= AccumulatorPercentile::kCompression / 4.0)
+            return 1;
+        return (std::sin(k * 2 * kPi / AccumulatorPercentile::kCompression) + 1) / 2;
+    }
+}
+
+    void AccumulatorPercentile::processInternal(const Value& input, bool merging) {
+        if (!merging) {
+            uassert(28633, "$percentile requires an object with 'input' and 'p' fields",
+                    input.getType() == Object);
+            setPercentile(input[pName]);
+
+            // non numeric types have no impact on the percentile
+            const Value value = input[inputName];
+            if (!value.numeric())
+                return;
+
+            const double x = value.getDouble();
+            if (isNaN(x))
+                return;
+
+            add(x, 1);
+            return;
+        }
+
+        // We expect what getValue(true) produced below. A shard which saw no input has no 'p'.
+        verify(input.getType() == Object);
+        if (!input[pName].missing())
+            setPercentile(input[pName]);
+
+        const vector<Value>& centroids = input[centroidsName].getArray();
+        if (centroids.empty())
+            return;
+
+        for (size_t i = 0; i < centroids.size(); i++) {
+            const vector<Value>& centroid = centroids[i].getArray();
+            add(centroid[0].getDouble(), centroid[1].getDouble());
+        }
+        _min = std::min(_min, input[minName].getDouble());
+        _max = std::max(_max, input[maxName].getDouble());
+    }
+
+    void AccumulatorPercentile::setPercentile(const Value& p) {
+        uassert(28634, "$percentile's 'p' must be a number between 0 and 1",
+                p.numeric() && p.getDouble() >= 0 && p.getDouble() <= 1);
+
+        if (_p < 0) {
+            _p = p.getDouble();
+            return;
+        }
+
+        uassert(28635, "$percentile's 'p' must be the same for every document",
+                p.getDouble() == _p);
+    }
+
+    void AccumulatorPercentile::add(double mean, double weight) {
+        if (_totalWeight == 0) {
+            _min = mean;
+            _max = mean;
+        }
+        else {
+            _min = std::min(_min, mean);
+            _max = std::max(_max, mean);
+        }
+
+        _totalWeight += weight;
+        _buffer.push_back(Centroid(mean, weight));
+        if (_buffer.size() >= kBufferSize)
+            compress();
+    }
+
+    void AccumulatorPercentile::compress() {
+        _centroids = compressed();
+        _buffer.clear();
+        _memUsageBytes = sizeof(*this)
+                       + (_centroids.capacity() + _buffer.capacity()) * sizeof(Centroid);
+    }
+
+    vector<AccumulatorPercentile::Centroid> AccumulatorPercentile::compressed() const {
+        vector<Centroid> all(_centroids);
+        all.insert(all.end(), _buffer.begin(), _buffer.end());
+        std::sort(all.begin(), all.end());
+
+        vector<Centroid> out;
+        if (all.empty())
+            return out;
+
+        // Fold each centroid into the previous one while the result stays within one unit of the
+        // scale function, so that the tails keep small centroids and the middle large ones.
+        Centroid current = all[0];
+        double weightSoFar = 0;
+        double limit = inverseScale(scale(0) + 1);
+        for (size_t i = 1; i < all.size(); i++) {
+            const double proposed = weightSoFar + current.weight + all[i].weight;
+            if (proposed / _totalWeight <= limit) {
+                current.weight += all[i].weight;
+                current.mean += (all[i].mean - current.mean) * all[i].weight / current.weight;
+            }
+            else {
+                weightSoFar += current.weight;
+                out.push_back(current);
+                limit = inverseScale(scale(weightSoFar / _totalWeight) + 1);
+                current = all[i];
+            }
+        }
+        out.push_back(current);
+        return out;
+    }
+
+    double AccumulatorPercentile::quantile(const vector<Centroid>& centroids) const {
+        // Each centroid's mean sits at the middle of its weight; interpolate linearly between
+        // those points, with the minimum and maximum at either end.
+        const double target = _p * _totalWeight;
+        double prevPosition = 0;
+        double prevValue = _min;
+        double weightSoFar = 0;
+        for (size_t i = 0; i < centroids.size(); i++) {
+            const double position = weightSoFar + centroids[i].weight / 2;
+            if (target < position) {
+                const double fraction = (target - prevPosition) / (position - prevPosition);
+                return prevValue + (centroids[i].mean - prevValue) * fraction;
+            }
+            prevPosition = position;
+            prevValue = centroids[i].mean;
+            weightSoFar += centroids[i].weight;
+        }
+
+        if (_totalWeight == prevPosition)
+            return _max;
+        const double fraction = (target - prevPosition) / (_totalWeight - prevPosition);
+        return prevValue + (_max - prevValue) * fraction;
+    }
+
+    Value AccumulatorPercentile::getValue(bool toBeMerged) const {
+        const vector<Centroid> centroids = compressed();
+
+        if (!toBeMerged) {
+            if (_totalWeight == 0)
+                return Value(BSONNULL);
+
+            return Value(quantile(centroids));
+        }
+
+        vector<Value> centroidValues;
+        centroidValues.reserve(centroids.size());
+        for (size_t i = 0; i < centroids.size(); i++) {
+            vector<Value> pair;
+            pair.push_back(Value(centroids[i].mean));
+            pair.push_back(Value(centroids[i].weight));
+            centroidValues.push_back(Value::consume(pair));
+        }
+
+        MutableDocument out;
+        if (_p >= 0)
+            out.addField(pName, Value(_p));
+        out.addField(centroidsName, Value::consume(centroidValues));
+        if (_totalWeight != 0) {
+            out.addField(minName, Value(_min));
+            out.addField(maxName, Value(_max));
+        }
+        return out.freezeToValue();
+    }
+
+    AccumulatorPercentile::AccumulatorPercentile()
+        : _p(-1)
+        , _totalWeight(0)
+        , _min(0)
+        , _max(0)
+    {
+        _memUsageBytes = sizeof(*this);
+    }
+
+    void AccumulatorPercentile::reset() {
+        _p = -1;
+        vector<Centroid>().swap(_centroids);
+        vector<Centroid>().swap(_buffer);
+        _totalWeight = 0;
+        _min = 0;
+        _max = 0;
+        _memUsageBytes = sizeof(*this);
+    }
+
+    intrusive_ptr<Accumulator> AccumulatorPercentile::create() {
+        return new AccumulatorPercentile();
+    }
+
+    const char *AccumulatorPercentile::getOpName() const {
+        return "$percentile";
+    }
+}
@@ -142,13 +142,16 @@ namespace mongo {
         uassert(16490, "Tried to make oversized document",
                 capacity <= size_t(BufferMaxSize));
 
-        boost::scoped_array<char> oldBuf(_buffer);
+        // An inline buffer is freed along with this.
+        boost::scoped_array<char> oldBuf(_bufferIsInline ? NULL : _buffer);
+        const char* const oldBufStart = _buffer;
         _buffer = new char[capacity];
         _bufferEnd = _buffer + capacity - hashTabBytes();
+        _bufferIsInline = false;
 
         if (!firstAlloc) {
             // This just copies the elements
-            memcpy(_buffer, oldBuf.get(), _usedBytes);
+            memcpy(_buffer, oldBufStart, _usedBytes);
 
             if (_numFields >= HASH_TAB_MIN) {
                 // if we were hashing, deal with the hash table
@@ -157,19 +160,16 @@ namespace mongo {
                 }
                 else {
                     // no rehash needed so just slide table down to new position
-                    memcpy(_hashTab, oldBuf.get() + oldCapacity, hashTabBytes());
+                    memcpy(_hashTab, oldBufStart + oldCapacity, hashTabBytes());
                 }
             }
         }
     }
 
-    void DocumentStorage::reserveFields(size_t expectedFields) {
-        fassert(16487, !_buffer);
-
+    DocumentStorage* DocumentStorage::withReservedFields(size_t expectedFields) {
         unsigned buckets = HASH_TAB_INIT_SIZE;
         while (buckets < expectedFields)
             buckets *= 2;
-        _hashTabMask = buckets - 1;
 
         // Using expectedFields+1 to allow space for long field names
         const size_t newSize = (expectedFields+1) * ValueElement::align(sizeof(ValueElement));
@@ -177,19 +177,33 @@ namespace mongo {
         uassert(16491, "Tried to make oversized document",
                 newSize <= size_t(BufferMaxSize));
 
-        _buffer = new char[newSize + hashTabBytes()];
-        _bufferEnd = _buffer + newSize;
+#pragma warning(push)
+#pragma warning(disable : 4291)
+        DocumentStorage* storage =
+            new (newSize + buckets * sizeof(Position)) DocumentStorage(); // custom operator new
+#pragma warning(pop)
+
+        storage->_hashTabMask = buckets - 1;
+        storage->_buffer = storage->inlineBuffer();
+        storage->_bufferEnd = storage->_buffer + newSize;
+        storage->_bufferIsInline = true;
+        return storage;
     }
 
     intrusive_ptr<DocumentStorage> DocumentStorage::clone() const {
-        intrusive_ptr<DocumentStorage> out (new DocumentStorage());
-
-        // Make a copy of the buffer.
+        // Make a copy of the buffer, allocated together with the copy.
         // It is very important that the positions of each field are the same after cloning.
-        const size_t bufferBytes = (_bufferEnd + hashTabBytes()) - _buffer;
-        out->_buffer = new char[bufferBytes];
-        out->_bufferEnd = out->_buffer + (_bufferEnd - _buffer);
-        memcpy(out->_buffer, _buffer, bufferBytes);
+        const size_t bufferBytes = !_buffer ? 0 : (_bufferEnd + hashTabBytes()) - _buffer;
+#pragma warning(push)
+#pragma warning(disable : 4291)
+        intrusive_ptr<DocumentStorage> out (new (bufferBytes) DocumentStorage());
+#pragma warning(pop)
+        if (_buffer) {
+            out->_buffer = out->inlineBuffer();
+            out->_bufferEnd = out->_buffer + (_bufferEnd - _buffer);
+            out->_bufferIsInline = true;
+            memcpy(out->_buffer, _buffer, bufferBytes);
+        }
 
         // Copy remaining fields
         out->_usedBytes = _usedBytes;
@@ -207,7 +221,7 @@ namespace mongo {
     }
 
     DocumentStorage::~DocumentStorage() {
-        boost::scoped_array<char> deleteBufferAtScopeEnd (_buffer);
+        boost::scoped_array<char> deleteBufferAtScopeEnd (_bufferIsInline ? NULL : _buffer);
 
         for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance()) {
             it->val.~Value(); // explicit destructor call
@@ -280,7 +294,7 @@ namespace mongo {
         , _storage(_storageHolder)
     {
         if (expectedFields) {
-            storage().reserveFields(expectedFields);
+            reset(DocumentStorage::withReservedFields(expectedFields));
         }
     }
 
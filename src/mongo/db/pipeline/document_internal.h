@@ -166,11 +166,22 @@ namespace mongo {
                           , _usedBytes(0)
                           , _numFields(0)
                           , _hashTabMask(0)
+                          , _bufferIsInline(false)
                           , _hasTextScore(false)
                           , _textScore(0)
         {}
         ~DocumentStorage();
 
+        /**
+         * Returns new storage with space for "expectedFields" fields, allocated together with
+         * the storage itself so that building a document of known size costs one allocation.
+         * The buffer is only separately allocated if the document outgrows it.
+         */
+        static DocumentStorage* withReservedFields(size_t expectedFields);
+
+        void* operator new (size_t objSize) { return mongoMalloc(objSize); }
+        void operator delete (void* ptr) { free(ptr); }
+
         static const DocumentStorage& emptyDoc() {
             static const char emptyBytes[sizeof(DocumentStorage)] = {0};
             return *reinterpret_cast<const DocumentStorage*>(emptyBytes);
@@ -217,11 +228,6 @@ namespace mongo {
         /// Adds a new field with missing Value at the end of the document
         Value& appendField(StringData name);
 
-        /** Preallocates space for fields. Use this to attempt to prevent buffer growth.
-         *  This is only valid to call before anything is added to the document.
-         */
-        void reserveFields(size_t expectedFields);
-
         /// This skips missing values
         DocumentStorageIterator iterator() const {
             return DocumentStorageIterator(_firstElement, end(), false);
@@ -258,6 +264,17 @@ namespace mongo {
 
     private:
 
+        // Allocates "extraBytes" past the end of the object for an inline buffer.
+        // MSVC: C4291, see RCString for why there is no matching operator delete.
+#pragma warning(push)
+#pragma warning(disable : 4291)
+        void* operator new (size_t objSize, size_t extraBytes) {
+            return mongoMalloc(objSize + extraBytes);
+        }
+#pragma warning(pop)
+
+        char* inlineBuffer() { return reinterpret_cast<char*>(this) + sizeof(DocumentStorage); }
+
         /// Same as lastElement->next() or firstElement() if empty.
         const ValueElement* end() const { return _firstElement->plusBytes(_usedBytes); }
 
@@ -325,6 +342,7 @@ namespace mongo {
         unsigned _numFields; // this includes removed fields
         unsigned _hashTabMask; // equal to hashTabBuckets()-1 but used more often
 
+        bool _bufferIsInline; // _buffer was allocated with this, by withReservedFields or clone
         bool _hasTextScore; // When adding more metadata fields, this should become a bitvector
         double _textScore;
         // When adding a field, make sure to update clone() method
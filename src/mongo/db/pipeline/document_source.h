@@ -43,6 +43,8 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/value.h"
 #include "mongo/db/sorter/sorter.h"
+#include "mongo/db/storage/key_string.h"
+#include "mongo/platform/random.h"
 #include "mongo/s/shard.h"
 #include "mongo/s/strategy.h"
 #include "mongo/util/intrusive_counter.h"
@@ -228,6 +230,25 @@ namespace mongo {
 
             virtual bool isCapped(const NamespaceString& ns) = 0;
 
+            /**
+             * Inserts all of 'objs' into 'ns' directly through its Collection, under a single
+             * lock and in a single unit of work, and logs them for replication.  Adds missing
+             * _ids.  Throws on failure.
+             */
+            virtual void insert(const NamespaceString& ns, const std::vector<BSONObj>& objs) = 0;
+
+            /**
+             * Builds the indexes described by 'indexSpecs' on 'ns', skipping any which already
+             * exist, in a single pass over its documents.  Throws on failure.
+             */
+            virtual void buildIndexes(const NamespaceString& ns,
+                                      const std::vector<BSONObj>& indexSpecs) = 0;
+
+            /**
+             * Returns true if 'ns' has a usable index whose key pattern starts with 'field'.
+             */
+            virtual bool hasIndexOnField(const NamespaceString& ns, const std::string& field) = 0;
+
             // Add new methods as needed.
         };
 
@@ -463,6 +484,32 @@ namespace mongo {
         /// Tell this source if it is doing a merge from shards. Defaults to false.
         void setDoingMerge(bool doingMerge) { _doingMerge = doingMerge; }
 
+        /**
+         * Returns the paths of the input fields the group key is made of, or an empty vector if
+         * any part of the key is not an input field.
+         */
+        std::vector<std::string> getIdFieldPaths() const;
+
+        /**
+         * Tell this source if its input is sorted on the group key. If so, it returns each group
+         * as soon as the key changes rather than hashing all of its input first. Defaults to
+         * false.
+         */
+        void setStreaming(bool streaming) { _streaming = streaming; }
+        bool isStreaming() const { return _streaming; }
+
+        /**
+         * Tell this source to output the mergeable partial state of each accumulator, as it does
+         * in a shard, rather than its final value. Defaults to false.
+         */
+        void setMergeableOutput(bool mergeableOutput) { _mergeableOutput = mergeableOutput; }
+
+        /// The names of the output fields other than _id, in the order of makeAccumulators().
+        const std::vector<std::string>& getFieldNames() const { return vFieldName; }
+
+        /// Returns a fresh accumulator for each output field of one group.
+        std::vector<intrusive_ptr<Accumulator> > makeAccumulators() const;
+
         /**
           Create a grouping DocumentSource from BSON.
 
@@ -502,6 +549,12 @@ namespace mongo {
         void populate();
         bool populated;
 
+        /**
+         * getNext() when streaming. Accumulates the documents of one group at a time, ending the
+         * group at the first document with a different key.
+         */
+        boost::optional<Document> getNextStreaming();
+
         /**
          * Parses the raw id expression into _idExpressions and possibly _idFieldNames.
          */
@@ -520,8 +573,63 @@ namespace mongo {
 
 
         typedef std::vector<intrusive_ptr<Accumulator> > Accumulators;
-        typedef boost::unordered_map<Value, Accumulators, Value::Hash> GroupsMap;
-        GroupsMap groups;
+
+        /**
+         * Hash table from group key to the accumulators of that group, used by populate().
+         *
+         * Groups are numbered in insertion order. Their keys and hashes are kept in flat arrays
+         * indexed by group number, and the accumulators of all groups share a single flat array
+         * with a fixed-size run of numAccumulators entries per group. Lookups go through an
+         * open-addressing index of group numbers with linear probing. Adding a group therefore
+         * costs no allocations beyond the accumulators themselves and the occasional doubling of
+         * the arrays, unlike a node-based map holding a separately allocated vector per group.
+         */
+        class GroupTable {
+        public:
+            GroupTable();
+
+            /**
+             * Discards all groups and sets the number of accumulators each new group gets.
+             */
+            void reset(size_t numAccumulators);
+
+            /**
+             * Returns the number of the group for 'id', creating the group if it does not exist
+             * yet. New groups have all their accumulators set to NULL.
+             */
+            size_t findOrInsert(const Value& id, bool* inserted);
+
+            size_t size() const { return _ids.size(); }
+            bool empty() const { return _ids.empty(); }
+
+            const Value& id(size_t group) const { return _ids[group]; }
+
+            /**
+             * The numAccumulators accumulators of 'group'. Only valid until the next insert.
+             */
+            intrusive_ptr<Accumulator>* accumulators(size_t group) {
+                return _numAccumulators ? &_accumulators[group * _numAccumulators] : NULL;
+            }
+
+            /**
+             * Bytes used by the table's own arrays, i.e. everything except what the ids and the
+             * accumulators point to.
+             */
+            size_t memUsageForTable() const;
+
+        private:
+            void _growIndex();
+
+            size_t _numAccumulators;
+            std::vector<Value> _ids;
+            std::vector<size_t> _hashes;
+            std::vector<intrusive_ptr<Accumulator> > _accumulators;
+
+            // Group number + 1 for occupied slots, 0 for empty ones. Size is a power of two.
+            std::vector<uint32_t> _index;
+        };
+
+        GroupTable groups;
 
         /*
           The field names for the result documents and the accumulator
@@ -540,10 +648,14 @@ namespace mongo {
         std::vector<intrusive_ptr<Expression> > vpExpression;
 
 
-        Document makeDocument(const Value& id, const Accumulators& accums, bool mergeableOutput);
+        Document makeDocument(const Value& id,
+                              const intrusive_ptr<Accumulator>* accums,
+                              bool mergeableOutput);
 
         bool _doingMerge;
         bool _spilled;
+        bool _streaming;
+        bool _mergeableOutput;
         const bool _extSortAllowed;
         const int _maxMemoryUsageBytes;
         boost::scoped_ptr<Variables> _variables;
@@ -551,16 +663,126 @@ namespace mongo {
         std::vector<intrusive_ptr<Expression> > _idExpressions;
 
         // only used when !_spilled
-        GroupsMap::iterator groupsIterator;
+        size_t groupsIterator;
 
         // only used when _spilled
         scoped_ptr<Sorter<Value, Value>::Iterator> _sorterIterator;
         std::pair<Value, Value> _firstPartOfNextGroup;
         Value _currentId;
         Accumulators _currentAccumulators;
+
+        // only used when _streaming, along with _currentAccumulators
+        boost::optional<Document> _firstDocOfNextGroup;
     };
 
 
+    // Bytes of foreign documents a $lookup may hold in its hash table before it must spill.
+    extern int internalDocumentSourceLookupMaxMemoryBytes;
+
+    /**
+     * $lookup: {from: <collection>, localField: <path>, foreignField: <path>, as: <path>}
+     *
+     * Sets 'as' in each input document to the array of documents in 'from' whose 'foreignField'
+     * matches the input's 'localField', with the same semantics as the query
+     * {<foreignField>: {$eq: <value of localField>}}.  A missing localField matches null.
+     *
+     * If 'from' has an index on 'foreignField' each input document is looked up through it and
+     * output order is input order.  Otherwise 'from' is scanned once into a hash table.  If that
+     * table would exceed internalDocumentSourceLookupMaxMemoryBytes, and allowDiskUse is set, both
+     * sides are instead sorted on their join key with the external Sorter and merged, in which
+     * case the output comes out in join key order.
+     */
+    class DocumentSourceLookup : public DocumentSource
+                               , public SplittableDocumentSource
+                               , public DocumentSourceNeedsMongod {
+    public:
+        // virtuals from DocumentSource
+        virtual boost::optional<Document> getNext();
+        virtual const char *getSourceName() const;
+        virtual Value serialize(bool explain = false) const;
+        virtual GetDepsReturn getDependencies(DepsTracker* deps) const;
+        virtual void dispose();
+
+        // Virtuals for SplittableDocumentSource.  'from' lives on the primary shard, so the join
+        // runs on the merger.
+        virtual intrusive_ptr<DocumentSource> getShardSource() { return NULL; }
+        virtual intrusive_ptr<DocumentSource> getMergeSource() { return this; }
+
+        const NamespaceString& getFromNs() const { return _fromNs; }
+
+        static intrusive_ptr<DocumentSource> createFromBson(
+            BSONElement elem,
+            const intrusive_ptr<ExpressionContext> &pExpCtx);
+
+        static const char lookupName[];
+
+    private:
+        DocumentSourceLookup(const NamespaceString& fromNs,
+                             const std::string& as,
+                             const std::string& localField,
+                             const std::string& foreignField,
+                             const intrusive_ptr<ExpressionContext>& pExpCtx);
+
+        enum Strategy {
+            kUnstarted,
+            kIndexNestedLoop,
+            kHash,
+            kSortMerge,
+        };
+
+        // Picks the strategy, and for kHash and kSortMerge reads all of 'from'.
+        void prepare();
+
+        // Fills _hashTable from 'from'.  Returns false, leaving the table empty, if it would grow
+        // past the memory limit.
+        bool buildHashTable();
+
+        // Sorts 'from' and the input on their join keys into _foreignSorted and _localSorted.
+        void prepareSortMerge();
+
+        // Returns the next input document with 'as' set, or none, for each strategy.
+        boost::optional<Document> nextFromIndex();
+        boost::optional<Document> nextFromHash();
+        boost::optional<Document> nextFromSortMerge();
+
+        // The join key of an input document.
+        Value localKey(const Document& input) const;
+
+        // Appends to 'keys' every value under which 'foreignDoc' matches, without duplicates.
+        void foreignKeys(const BSONObj& foreignDoc, std::vector<Value>* keys) const;
+
+        Document makeOutput(const Document& input, const std::vector<Value>& matches) const;
+
+        SortOptions makeSortOptions() const;
+
+        typedef Sorter<Value, Document> MySorter;
+
+        class Comparator {
+        public:
+            int operator()(const MySorter::Data& lhs, const MySorter::Data& rhs) const {
+                return Value::compare(lhs.first, rhs.first);
+            }
+        };
+
+        typedef boost::unordered_map<Value, std::vector<Value>, Value::Hash> HashTable;
+
+        const NamespaceString _fromNs;
+        const FieldPath _as;
+        const FieldPath _localField;
+        const std::string _foreignFieldName; // validated as a FieldPath
+
+        Strategy _strategy;
+        HashTable _hashTable;
+
+        scoped_ptr<MySorter::Iterator> _foreignSorted;
+        scoped_ptr<MySorter::Iterator> _localSorted;
+        // The foreign entry read from _foreignSorted but not yet consumed, if any.
+        boost::optional<MySorter::Data> _foreignPeek;
+        // The matches for _matchesKey, which the last input document joined on.
+        boost::optional<Value> _matchesKey;
+        std::vector<Value> _matches;
+    };
+
     class DocumentSourceMatch : public DocumentSource {
     public:
         // virtuals from DocumentSource
@@ -597,6 +819,22 @@ namespace mongo {
          */
         BSONObj redactSafePortion() const;
 
+        /** Decides whether an earlier stage leaves a path read by a $match unchanged. */
+        class PathFilter {
+        public:
+            virtual ~PathFilter() {}
+            virtual bool isUnchanged(const StringData& path) const = 0;
+        };
+
+        /** Splits the query into the conjuncts that read only paths 'filter' accepts, which are
+         *  returned, and the rest, which are stored in 'remainder'.  Either may be empty.
+         *
+         *  The returned portion can be moved before the stage 'filter' describes, leaving the
+         *  remainder after it.  Conjuncts using operators that don't name the paths they read,
+         *  such as $text, are always left in the remainder.
+         */
+        BSONObj splitUnchangedPortion(const PathFilter& filter, BSONObj* remainder) const;
+
         static bool isTextQuery(const BSONObj& query);
         bool isTextQuery() const { return _isTextQuery; }
 
@@ -669,6 +907,9 @@ namespace mongo {
         Cursors::iterator _currentCursor;
 
         bool _unstarted;
+
+        // Whether start() got the first batch from every cursor.
+        bool _started;
     };
 
     class DocumentSourceOut : public DocumentSource
@@ -711,14 +952,65 @@ namespace mongo {
         // Sets _tempsNs and prepares it to receive data.
         void prepTempCollection();
 
-        void spill(DBClientBase* conn, const std::vector<BSONObj>& toInsert);
+        void spill(const std::vector<BSONObj>& toInsert);
 
         bool _done;
 
+        // The indexes of _outputNs, built on _tempNs once all the data is in.
+        std::vector<BSONObj> _indexesToBuild;
+
         NamespaceString _tempNs; // output goes here as it is being processed.
         const NamespaceString _outputNs; // output will go here after all data is processed.
     };
 
+
+    /**
+     * Keeps the results of the $group before it in a collection, merging each group into the one
+     * already stored under the same _id rather than replacing the collection as $out does. Each
+     * stored document holds the final values of the accumulators, so that readers can look the
+     * group up by _id, along with their mergeable partial states under stateName. Rerunning the
+     * pipeline over only the documents added since the last run therefore keeps the collection
+     * up to date with the whole input.
+     *
+     * Documents are read and written one group at a time, so concurrent runs into the same
+     * collection may lose each other's updates.
+     */
+    class DocumentSourceMaterialize : public DocumentSource
+                                    , public SplittableDocumentSource
+                                    , public DocumentSourceNeedsMongod {
+    public:
+        // virtuals from DocumentSource
+        virtual boost::optional<Document> getNext();
+        virtual const char *getSourceName() const;
+        virtual Value serialize(bool explain = false) const;
+        virtual GetDepsReturn getDependencies(DepsTracker* deps) const;
+        virtual void setSource(DocumentSource *pSource);
+
+        // Virtuals for SplittableDocumentSource
+        virtual intrusive_ptr<DocumentSource> getShardSource() { return NULL; }
+        virtual intrusive_ptr<DocumentSource> getMergeSource() { return this; }
+
+        const NamespaceString& getOutputNs() const { return _outputNs; }
+
+        static intrusive_ptr<DocumentSource> createFromBson(
+            BSONElement elem,
+            const intrusive_ptr<ExpressionContext> &pExpCtx);
+
+        static const char materializeName[];
+        static const char stateName[];
+
+    private:
+        DocumentSourceMaterialize(const NamespaceString& outputNs,
+                                  const intrusive_ptr<ExpressionContext> &pExpCtx);
+
+        /// Merges 'partial', a group's partial states, with what is stored for it and stores it.
+        void mergeGroup(DBClientBase* conn, const Document& partial);
+
+        bool _done;
+        DocumentSourceGroup* _group; // the source, which outputs partial states
+        const NamespaceString _outputNs;
+    };
+
     
     class DocumentSourceProject : public DocumentSource {
     public:
@@ -749,6 +1041,9 @@ namespace mongo {
         /** projection as specified by the user */
         BSONObj getRaw() const { return _raw; }
 
+        /** Returns true if the top-level field 'fieldName' is output unchanged. */
+        bool passesThroughField(const std::string& fieldName) const;
+
     private:
         DocumentSourceProject(const intrusive_ptr<ExpressionContext>& pExpCtx,
                               const intrusive_ptr<ExpressionObject>& exprObj);
@@ -787,6 +1082,119 @@ namespace mongo {
         intrusive_ptr<Expression> _expression;
     };
 
+    // Bytes of documents a $sample may hold while it picks its sample.
+    extern int internalDocumentSourceSampleMaxMemoryBytes;
+
+    /**
+     * $sample: {size: <N>}
+     *
+     * Outputs N documents chosen uniformly at random from its input, or all of them if there are
+     * fewer, in random order.  Each input document is given a random key and the N with the
+     * smallest keys are kept in a heap, so the input is read once holding only N documents.
+     *
+     * On a shard each output document carries its key in the field randValName, and the merger's
+     * $sample keeps the N smallest keys of all the shards, which is a sample of the whole.
+     *
+     * PipelineD replaces a $sample which starts the pipeline by a
+     * DocumentSourceSampleFromRandomCursor when the collection can be read through a random
+     * cursor, so that only about N documents are read.
+     */
+    class DocumentSourceSample : public DocumentSource
+                               , public SplittableDocumentSource {
+    public:
+        // virtuals from DocumentSource
+        virtual boost::optional<Document> getNext();
+        virtual const char *getSourceName() const;
+        virtual Value serialize(bool explain = false) const;
+        virtual GetDepsReturn getDependencies(DepsTracker* deps) const;
+        virtual void dispose();
+
+        // Virtuals for SplittableDocumentSource.  Each shard samples its documents and the merger
+        // samples those samples by their keys.
+        virtual intrusive_ptr<DocumentSource> getShardSource() { return this; }
+        virtual intrusive_ptr<DocumentSource> getMergeSource();
+
+        long long getSampleSize() const { return _size; }
+        bool isDoingMerge() const { return _doingMerge; }
+
+        static intrusive_ptr<DocumentSourceSample> create(
+            const intrusive_ptr<ExpressionContext>& pExpCtx,
+            long long size);
+
+        static intrusive_ptr<DocumentSource> createFromBson(
+            BSONElement elem,
+            const intrusive_ptr<ExpressionContext> &pExpCtx);
+
+        static const char sampleName[];
+
+        // The field in which a shard sends the key of each document to the merger.
+        static const char randValName[];
+
+    private:
+        DocumentSourceSample(const intrusive_ptr<ExpressionContext>& pExpCtx, long long size);
+
+        // Reads the whole input into _sample.
+        void populate();
+
+        typedef std::pair<double, Document> KeyedDocument;
+
+        struct KeyLess {
+            bool operator()(const KeyedDocument& lhs, const KeyedDocument& rhs) const {
+                return lhs.first < rhs.first;
+            }
+        };
+
+        const long long _size;
+        bool _doingMerge;
+        bool _populated;
+        PseudoRandom _random;
+
+        // A max-heap on the key while populating, then sorted by ascending key.
+        std::vector<KeyedDocument> _sample;
+        size_t _nextOutput;
+    };
+
+    /**
+     * Stands in for a $sample at the start of the pipeline when the cursor it reads from returns
+     * the collection's documents in random order, possibly repeating some (see
+     * RecordStore::getRandomIterator()).  Outputs the first 'size' documents with distinct _ids.
+     *
+     * On a shard the documents get increasing keys, drawn as the smallest of 'numRecords' uniform
+     * keys, then the next smallest and so on, so the merger's $sample can treat them as if they
+     * came from a full scan.
+     */
+    class DocumentSourceSampleFromRandomCursor : public DocumentSource {
+    public:
+        // virtuals from DocumentSource
+        virtual boost::optional<Document> getNext();
+        virtual const char *getSourceName() const;
+        virtual Value serialize(bool explain = false) const;
+        virtual GetDepsReturn getDependencies(DepsTracker* deps) const;
+        virtual void dispose();
+
+        static intrusive_ptr<DocumentSourceSampleFromRandomCursor> create(
+            const intrusive_ptr<ExpressionContext>& pExpCtx,
+            long long size,
+            long long numRecords);
+
+        static const char sampleFromRandomCursorName[];
+
+    private:
+        DocumentSourceSampleFromRandomCursor(const intrusive_ptr<ExpressionContext>& pExpCtx,
+                                             long long size,
+                                             long long numRecords);
+
+        // The next of the increasing keys given on a shard.
+        double nextRandVal();
+
+        const long long _size;
+        const long long _numRecords;
+        long long _numReturned;
+        double _randVal;
+        ValueSet _seenIds;
+        PseudoRandom _random;
+    };
+
     class DocumentSourceSort : public DocumentSource
                              , public SplittableDocumentSource {
     public:
@@ -871,18 +1279,61 @@ namespace mongo {
         void populateFromCursors(const std::vector<DBClientCursor*>& cursors);
         void populateFromBsonArrays(const std::vector<BSONArray>& arrays);
 
+        // How many results getNext() has returned, so that the getMores sent while merging
+        // cursors under a $limit ask the shards for no more than can still be used.
+        long long _numOutput;
+
         /* these two parallel each other */
         typedef std::vector<intrusive_ptr<Expression> > SortKey;
         SortKey vSortKey;
         std::vector<char> vAscending; // used like std::vector<bool> but without specialization
 
+        /**
+         * The key MySorter sorts on: the Value extractKey() made and, unless the Value holds
+         * something which Value::compare() orders differently from BSON (a document, a Timestamp,
+         * a NumberLong beyond 2^53, ...), its KeyString encoding.  Two keys which both have an
+         * encoding compare with a memcmp.
+         */
+        class NormalizedKey {
+        public:
+            NormalizedKey() : _hasEncoding(false) { }
+            /**
+             * 'compound' says whether 'value' is an array of the values of several sort fields,
+             * rather than the value of the only one.
+             */
+            NormalizedKey(const Value& value, bool compound, const Ordering* ordering);
+
+            const Value& getValue() const { return _value; }
+            bool hasEncoding() const { return _hasEncoding; }
+            const KeyString& getEncoding() const { return _encoding; }
+
+            // For Sorter
+            struct SorterDeserializeSettings {}; // unused
+            void serializeForSorter(BufBuilder& buf) const;
+            static NormalizedKey deserializeForSorter(BufReader& buf,
+                                                      const SorterDeserializeSettings&);
+            int memUsageForSorter() const;
+            NormalizedKey getOwned() const { return *this; }
+
+        private:
+            Value _value;
+            bool _hasEncoding;
+            KeyString _encoding;
+        };
+
         /// Extracts the fields in vSortKey from the Document;
-        Value extractKey(const Document& d) const;
+        NormalizedKey extractKey(const Document& d) const;
+
+        /// Compare two keys according to the specified sort key.
+        int compare(const NormalizedKey& lhs, const NormalizedKey& rhs) const;
 
         /// Compare two Values according to the specified sort key.
         int compare(const Value& lhs, const Value& rhs) const;
 
-        typedef Sorter<Value, Document> MySorter;
+        /// Sets '_keyOrdering' from vAscending.
+        void makeKeyOrdering();
+
+        typedef Sorter<NormalizedKey, Document> MySorter;
 
         // For MySorter
         class Comparator {
@@ -897,6 +1348,10 @@ namespace mongo {
 
         intrusive_ptr<DocumentSourceLimit> limitSrc;
 
+        // What NormalizedKeys are encoded for.  NULL if there are too many sort fields for an
+        // Ordering, in which case the keys have no encodings.
+        scoped_ptr<Ordering> _keyOrdering;
+
         bool _done;
         bool _mergingPresorted;
         scoped_ptr<MySorter::Iterator> _output;
@@ -1039,6 +1494,9 @@ namespace mongo {
 
         static const char unwindName[];
 
+        /** Path to the array to unwind. */
+        const FieldPath& getUnwindPath() const { return *_unwindPath; }
+
     private:
         DocumentSourceUnwind(const intrusive_ptr<ExpressionContext> &pExpCtx);
 
@@ -47,6 +47,9 @@ namespace mongo {
     boost::optional<Document> DocumentSourceGroup::getNext() {
         pExpCtx->checkForInterrupt();
 
+        if (_streaming)
+            return getNextStreaming();
+
         if (!populated)
             populate();
 
@@ -92,30 +95,94 @@ namespace mongo {
                 _firstPartOfNextGroup = _sorterIterator->next();
             }
 
-            return makeDocument(_currentId, _currentAccumulators, pExpCtx->inShard);
+            return makeDocument(_currentId,
+                                _currentAccumulators.empty() ? NULL : &_currentAccumulators[0],
+                                pExpCtx->inShard || _mergeableOutput);
 
         } else {
-            if (groups.empty())
+            if (groupsIterator == groups.size())
                 return boost::none;
 
-            Document out = makeDocument(groupsIterator->first,
-                                        groupsIterator->second,
-                                        pExpCtx->inShard);
+            Document out = makeDocument(groups.id(groupsIterator),
+                                        groups.accumulators(groupsIterator),
+                                        pExpCtx->inShard || _mergeableOutput);
 
-            if (++groupsIterator == groups.end())
+            if (++groupsIterator == groups.size())
                 dispose();
 
             return out;
         }
     }
 
+    boost::optional<Document> DocumentSourceGroup::getNextStreaming() {
+        const size_t numAccumulators = vpAccumulatorFactory.size();
+        if (!populated) {
+            // prepare current to accumulate data
+            _currentAccumulators.reserve(numAccumulators);
+            for (size_t i = 0; i < numAccumulators; i++) {
+                _currentAccumulators.push_back(vpAccumulatorFactory[i]());
+            }
+
+            _firstDocOfNextGroup = pSource->getNext();
+            populated = true;
+        }
+
+        if (!_firstDocOfNextGroup)
+            return boost::none;
+
+        for (size_t i = 0; i < numAccumulators; i++) {
+            _currentAccumulators[i]->reset(); // prep accumulators for a new group
+        }
+
+        boost::optional<Document> input = _firstDocOfNextGroup;
+        bool firstOfGroup = true;
+        while (input) {
+            _variables->setRoot(*input);
+
+            Value id = computeId(_variables.get());
+
+            /* treat missing values the same as NULL SERVER-4674 */
+            if (id.missing())
+                id = Value(BSONNULL);
+
+            if (firstOfGroup) {
+                _currentId = id;
+                firstOfGroup = false;
+            }
+            else if (id != _currentId) {
+                // 'input' starts the next group.
+                _variables->clearRoot();
+                break;
+            }
+
+            for (size_t i = 0; i < numAccumulators; i++) {
+                _currentAccumulators[i]->process(vpExpression[i]->evaluate(_variables.get()),
+                                                 _doingMerge);
+            }
+
+            // We are done with the ROOT document so release it.
+            _variables->clearRoot();
+            input = pSource->getNext();
+        }
+
+        _firstDocOfNextGroup = input;
+        Document out = makeDocument(_currentId,
+                                    _currentAccumulators.empty() ? NULL : &_currentAccumulators[0],
+                                    pExpCtx->inShard || _mergeableOutput);
+        if (!input)
+            dispose();
+
+        return out;
+    }
+
     void DocumentSourceGroup::dispose() {
         // free our resources
-        GroupsMap().swap(groups);
+        groups.reset(vpAccumulatorFactory.size());
         _sorterIterator.reset();
+        _firstDocOfNextGroup = boost::none;
 
         // make us look done
-        groupsIterator = groups.end();
+        groupsIterator = 0;
 
         // free our source's resources
         pSource->dispose();
@@ -132,6 +199,16 @@ namespace mongo {
         for (size_t i = 0; i < vFieldName.size(); i++) {
              vpExpression[i] = vpExpression[i]->optimize();
         }
+
+        // The _id and accumulator expressions are all evaluated against each input document.
+        vector<intrusive_ptr<Expression>*> roots;
+        for (size_t i = 0; i < _idExpressions.size(); i++) {
+            roots.push_back(&_idExpressions[i]);
+        }
+        for (size_t i = 0; i < vpExpression.size(); i++) {
+            roots.push_back(&vpExpression[i]);
+        }
+        Expression::eliminateCommonSubexpressions(roots);
     }
 
     Value DocumentSourceGroup::serialize(bool explain) const {
@@ -197,8 +274,11 @@ namespace mongo {
         , populated(false)
         , _doingMerge(false)
         , _spilled(false)
+        , _streaming(false)
+        , _mergeableOutput(false)
         , _extSortAllowed(pExpCtx->extSortAllowed && !pExpCtx->inRouter)
         , _maxMemoryUsageBytes(100*1024*1024)
+        , groupsIterator(0)
     {}
 
     void DocumentSourceGroup::addAccumulator(
@@ -210,6 +290,15 @@ namespace mongo {
         vpExpression.push_back(pExpression);
     }
 
+    vector<intrusive_ptr<Accumulator> > DocumentSourceGroup::makeAccumulators() const {
+        vector<intrusive_ptr<Accumulator> > accumulators;
+        accumulators.reserve(vpAccumulatorFactory.size());
+        for (size_t i = 0; i < vpAccumulatorFactory.size(); i++) {
+            accumulators.push_back(vpAccumulatorFactory[i]());
+        }
+        return accumulators;
+    }
+
 
     struct GroupOpDesc {
         const char* name;
@@ -227,11 +316,13 @@ namespace mongo {
     */
     static const GroupOpDesc GroupOpTable[] = {
         {"$addToSet", AccumulatorAddToSet::create},
+        {"$approxCountDistinct", AccumulatorApproxCountDistinct::create},
         {"$avg", AccumulatorAvg::create},
         {"$first", AccumulatorFirst::create},
         {"$last", AccumulatorLast::create},
         {"$max", AccumulatorMinMax::createMax},
         {"$min", AccumulatorMinMax::createMin},
+        {"$percentile", AccumulatorPercentile::create},
         {"$push", AccumulatorPush::create},
         {"$sum", AccumulatorSum::create},
     };
@@ -353,11 +444,17 @@ namespace mongo {
 
         // pushed to on spill()
         vector<shared_ptr<Sorter<Value, Value>::Iterator> > sortedFiles;
-        int memoryUsageBytes = 0;
+
+        // Memory used by the group keys and accumulator state. The table's own arrays are
+        // accounted for separately through memUsageForTable().
+        size_t memoryUsageBytes = 0;
+
+        groups.reset(numAccumulators);
 
         // This loop consumes all input from pSource and buckets it based on pIdExpression.
         while (boost::optional<Document> input = pSource->getNext()) {
-            if (memoryUsageBytes > _maxMemoryUsageBytes) {
+            if (memoryUsageBytes + groups.memUsageForTable() >
+                    static_cast<size_t>(_maxMemoryUsageBytes)) {
                 uassert(16945, "Exceeded memory limit for $group, but didn't allow external sort."
                                " Pass allowDiskUse:true to opt in.",
                         _extSortAllowed);
@@ -378,17 +475,16 @@ namespace mongo {
               Look for the _id value in the map; if it's not there, add a
               new entry with a blank accumulator.
             */
-            const size_t oldSize = groups.size();
-            vector<intrusive_ptr<Accumulator> >& group = groups[id];
-            const bool inserted = groups.size() != oldSize;
+            bool inserted;
+            intrusive_ptr<Accumulator>* group = groups.accumulators(groups.findOrInsert(id,
+                                                                                    &inserted));
 
             if (inserted) {
                 memoryUsageBytes += id.getApproximateSize();
 
                 // Add the accumulators
-                group.reserve(numAccumulators);
                 for (size_t i = 0; i < numAccumulators; i++) {
-                    group.push_back(vpAccumulatorFactory[i]());
+                    group[i] = vpAccumulatorFactory[i]();
                 }
             } else {
                 for (size_t i = 0; i < numAccumulators; i++) {
@@ -398,7 +494,6 @@ namespace mongo {
             }
 
             /* tickle all the accumulators for the group we found */
-            dassert(numAccumulators == group.size());
             for (size_t i = 0; i < numAccumulators; i++) {
                 group[i]->process(vpExpression[i]->evaluate(_variables.get()), _doingMerge);
                 memoryUsageBytes += group[i]->memUsageForSorter();
@@ -427,7 +522,7 @@ namespace mongo {
             }
 
             // We won't be using groups again so free its memory.
-            GroupsMap().swap(groups);
+            groups.reset(numAccumulators);
 
             _sorterIterator.reset(
                     Sorter<Value,Value>::Iterator::merge(
@@ -443,7 +538,7 @@ namespace mongo {
             _firstPartOfNextGroup = _sorterIterator->next();
         } else {
             // start the group iterator
-            groupsIterator = groups.begin();
+            groupsIterator = 0;
         }
 
         populated = true;
@@ -451,47 +546,56 @@ namespace mongo {
 
     class DocumentSourceGroup::SpillSTLComparator {
     public:
-        bool operator() (const GroupsMap::value_type* lhs, const GroupsMap::value_type* rhs) const {
-            return Value::compare(lhs->first, rhs->first) < 0;
+        explicit SpillSTLComparator(const GroupTable& groups) : _groups(groups) {}
+
+        bool operator() (size_t lhs, size_t rhs) const {
+            return Value::compare(_groups.id(lhs), _groups.id(rhs)) < 0;
         }
+
+    private:
+        const GroupTable& _groups;
     };
 
     shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
-        vector<const GroupsMap::value_type*> ptrs; // using pointers to speed sorting
-        ptrs.reserve(groups.size());
-        for (GroupsMap::const_iterator it=groups.begin(), end=groups.end(); it != end; ++it) {
-            ptrs.push_back(&*it);
+        vector<size_t> order; // sorting group numbers rather than the groups themselves
+        order.reserve(groups.size());
+        for (size_t i = 0; i < groups.size(); i++) {
+            order.push_back(i);
         }
 
-        stable_sort(ptrs.begin(), ptrs.end(), SpillSTLComparator());
+        stable_sort(order.begin(), order.end(), SpillSTLComparator(groups));
+
+        const size_t numAccumulators = vpAccumulatorFactory.size();
 
         SortedFileWriter<Value, Value> writer(SortOptions().TempDir(pExpCtx->tempDir));
-        switch (vpAccumulatorFactory.size()) { // same as ptrs[i]->second.size() for all i.
+        switch (numAccumulators) {
         case 0: // no values, essentially a distinct
-            for (size_t i=0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first, Value());
+            for (size_t i=0; i < order.size(); i++) {
+                writer.addAlreadySorted(groups.id(order[i]), Value());
             }
             break;
 
         case 1: // just one value, use optimized serialization as single Value
-            for (size_t i=0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first,
-                                        ptrs[i]->second[0]->getValue(/*toBeMerged=*/true));
+            for (size_t i=0; i < order.size(); i++) {
+                writer.addAlreadySorted(
+                    groups.id(order[i]),
+                    groups.accumulators(order[i])[0]->getValue(/*toBeMerged=*/true));
             }
             break;
 
         default: // multiple values, serialize as array-typed Value
-            for (size_t i=0; i < ptrs.size(); i++) {
+            for (size_t i=0; i < order.size(); i++) {
+                const intrusive_ptr<Accumulator>* group = groups.accumulators(order[i]);
                 vector<Value> accums;
-                for (size_t j=0; j < ptrs[i]->second.size(); j++) {
-                    accums.push_back(ptrs[i]->second[j]->getValue(/*toBeMerged=*/true));
+                for (size_t j=0; j < numAccumulators; j++) {
+                    accums.push_back(group[j]->getValue(/*toBeMerged=*/true));
                 }
-                writer.addAlreadySorted(ptrs[i]->first, Value::consume(accums));
+                writer.addAlreadySorted(groups.id(order[i]), Value::consume(accums));
             }
             break;
         }
 
-        groups.clear();
+        groups.reset(numAccumulators);
 
         return shared_ptr<Sorter<Value, Value>::Iterator>(writer.done());
     }
@@ -530,6 +634,26 @@ namespace mongo {
         }
     }
 
+    vector<string> DocumentSourceGroup::getIdFieldPaths() const {
+        vector<string> paths;
+        for (size_t i = 0; i < _idExpressions.size(); i++) {
+            Expression* expr = _idExpressions[i].get();
+            if (ExpressionCommonSubexpression* shared =
+                    dynamic_cast<ExpressionCommonSubexpression*>(expr)) {
+                expr = shared->getExpression().get();
+            }
+
+            ExpressionFieldPath* fieldPath = dynamic_cast<ExpressionFieldPath*>(expr);
+            if (!fieldPath
+                    || fieldPath->getVariableId() != Variables::ROOT_ID
+                    || fieldPath->getFieldPath().getPathLength() == 1) {
+                return vector<string>();
+            }
+            paths.push_back(fieldPath->getFieldPath().tail().getPath(false));
+        }
+        return paths;
+    }
+
     Value DocumentSourceGroup::computeId(Variables* vars) {
         // If only one expression return result directly
         if (_idExpressions.size() == 1)
@@ -564,7 +688,7 @@ namespace mongo {
     }
 
     Document DocumentSourceGroup::makeDocument(const Value& id,
-                                               const Accumulators& accums,
+                                               const intrusive_ptr<Accumulator>* accums,
                                                bool mergeableOutput) {
         const size_t n = vFieldName.size();
         MutableDocument out (1 + n);
@@ -587,6 +711,75 @@ namespace mongo {
         return out.freeze();
     }
 
+    DocumentSourceGroup::GroupTable::GroupTable() : _numAccumulators(0) {
+    }
+
+    void DocumentSourceGroup::GroupTable::reset(size_t numAccumulators) {
+        _numAccumulators = numAccumulators;
+
+        // Swap with empty containers to actually release the memory
+        std::vector<Value>().swap(_ids);
+        std::vector<size_t>().swap(_hashes);
+        std::vector<intrusive_ptr<Accumulator> >().swap(_accumulators);
+        std::vector<uint32_t>().swap(_index);
+    }
+
+    size_t DocumentSourceGroup::GroupTable::findOrInsert(const Value& id, bool* inserted) {
+        // Keep the index at most half full, so probe sequences stay short
+        if ((_ids.size() + 1) * 2 > _index.size()) {
+            _growIndex();
+        }
+
+        const size_t hash = Value::Hash()(id);
+        const size_t mask = _index.size() - 1;
+
+        size_t slot = hash & mask;
+        while (_index[slot] != 0) {
+            const size_t group = _index[slot] - 1;
+            if (_hashes[group] == hash && Value::compare(_ids[group], id) == 0) {
+                *inserted = false;
+                return group;
+            }
+            slot = (slot + 1) & mask;
+        }
+
+        const size_t group = _ids.size();
+        massert(28602, "too many groups for $group", group < 0xFFFFFFFFU);
+
+        _ids.push_back(id);
+        _hashes.push_back(hash);
+        _accumulators.resize(_accumulators.size() + _numAccumulators);
+        _index[slot] = static_cast<uint32_t>(group + 1);
+
+        *inserted = true;
+        return group;
+    }
+
+    size_t DocumentSourceGroup::GroupTable::memUsageForTable() const {
+        // The ids and accumulators account for the memory they point to, including sizeof(Value)
+        // for the ids, so only the remaining capacity of the arrays is counted here.
+        return (_ids.capacity() - _ids.size()) * sizeof(Value)
+             + _hashes.capacity() * sizeof(size_t)
+             + _accumulators.capacity() * sizeof(intrusive_ptr<Accumulator>)
+             + _index.capacity() * sizeof(uint32_t);
+    }
+
+    void DocumentSourceGroup::GroupTable::_growIndex() {
+        const size_t newSize = _index.empty() ? 16 : _index.size() * 2;
+        const size_t mask = newSize - 1;
+
+        std::vector<uint32_t> newIndex(newSize, 0);
+        for (size_t group = 0; group < _ids.size(); group++) {
+            size_t slot = _hashes[group] & mask;
+            while (newIndex[slot] != 0) {
+                slot = (slot + 1) & mask;
+            }
+            newIndex[slot] = static_cast<uint32_t>(group + 1);
+        }
+
+        _index.swap(newIndex);
+    }
+
     intrusive_ptr<DocumentSource> DocumentSourceGroup::getShardSource() {
         return this; // No modifications necessary when on shard
     }
@@ -0,0 +1,329 @@
+/*    Copyright 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include <algorithm>
+
+#include "mongo/db/pipeline/document_source.h"
+
+#include "mongo/client/dbclientinterface.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/pipeline/value.h"
+#include "mongo/db/server_parameters.h"
+
+namespace mongo {
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceLookupMaxMemoryBytes, int,
+                                  100 * 1024 * 1024);
+
+    const char DocumentSourceLookup::lookupName[] = "$lookup";
+
+    DocumentSourceLookup::DocumentSourceLookup(const NamespaceString& fromNs,
+                                               const std::string& as,
+                                               const std::string& localField,
+                                               const std::string& foreignField,
+                                               const intrusive_ptr<ExpressionContext>& pExpCtx)
+        : DocumentSource(pExpCtx)
+        , _fromNs(fromNs)
+        , _as(as)
+        , _localField(localField)
+        , _foreignFieldName(FieldPath(foreignField).getPath(false))
+        , _strategy(kUnstarted)
+    {}
+
+    const char *DocumentSourceLookup::getSourceName() const {
+        return lookupName;
+    }
+
+    boost::optional<Document> DocumentSourceLookup::getNext() {
+        pExpCtx->checkForInterrupt();
+
+        if (_strategy == kUnstarted)
+            prepare();
+
+        switch (_strategy) {
+        case kIndexNestedLoop: return nextFromIndex();
+        case kHash: return nextFromHash();
+        case kSortMerge: return nextFromSortMerge();
+        case kUnstarted: break;
+        }
+        verify(false);
+        return boost::none;
+    }
+
+    void DocumentSourceLookup::prepare() {
+        verify(_mongod);
+
+        uassert(28613, str::stream() << "namespace '" << _fromNs.ns()
+                                     << "' is sharded so it can't be used for $lookup",
+                !_mongod->isSharded(_fromNs));
+
+        if (_mongod->hasIndexOnField(_fromNs, _foreignFieldName)) {
+            _strategy = kIndexNestedLoop;
+            return;
+        }
+
+        if (buildHashTable()) {
+            _strategy = kHash;
+            return;
+        }
+
+        uassert(28614, "Exceeded memory limit for $lookup, but didn't allow external sort."
+                       " Pass allowDiskUse:true to opt in.",
+                pExpCtx->extSortAllowed && !pExpCtx->inRouter);
+        prepareSortMerge();
+        _strategy = kSortMerge;
+    }
+
+    bool DocumentSourceLookup::buildHashTable() {
+        const size_t maxMemoryUsageBytes = internalDocumentSourceLookupMaxMemoryBytes;
+        size_t memoryUsageBytes = 0;
+
+        auto_ptr<DBClientCursor> cursor = _mongod->directClient()->query(_fromNs.ns(), Query());
+        vector<Value> keys;
+        while (cursor->more()) {
+            pExpCtx->checkForInterrupt();
+
+            const BSONObj obj = cursor->nextSafe();
+            const Value doc = Value(Document(obj));
+            keys.clear();
+            foreignKeys(obj, &keys);
+
+            // Each key holds a reference to the one copy of 'doc'.
+            memoryUsageBytes += doc.getApproximateSize();
+            for (size_t i = 0; i < keys.size(); i++) {
+                memoryUsageBytes += keys[i].getApproximateSize() + sizeof(Value);
+                _hashTable[keys[i]].push_back(doc);
+            }
+
+            if (memoryUsageBytes > maxMemoryUsageBytes) {
+                _hashTable.clear();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void DocumentSourceLookup::prepareSortMerge() {
+        const SortOptions opts = makeSortOptions();
+
+        // The partial hash table was thrown away, so this is a fresh scan of 'from'.
+        scoped_ptr<MySorter> foreignSorter(MySorter::make(opts, Comparator()));
+        auto_ptr<DBClientCursor> cursor = _mongod->directClient()->query(_fromNs.ns(), Query());
+        vector<Value> keys;
+        while (cursor->more()) {
+            pExpCtx->checkForInterrupt();
+
+            const BSONObj obj = cursor->nextSafe();
+            const Document doc(obj);
+            keys.clear();
+            foreignKeys(obj, &keys);
+            for (size_t i = 0; i < keys.size(); i++) {
+                foreignSorter->add(keys[i], doc);
+            }
+        }
+        _foreignSorted.reset(foreignSorter->done());
+
+        scoped_ptr<MySorter> localSorter(MySorter::make(opts, Comparator()));
+        while (boost::optional<Document> next = pSource->getNext()) {
+            localSorter->add(localKey(*next), *next);
+        }
+        _localSorted.reset(localSorter->done());
+    }
+
+    boost::optional<Document> DocumentSourceLookup::nextFromIndex() {
+        boost::optional<Document> input = pSource->getNext();
+        if (!input)
+            return boost::none;
+
+        BSONObjBuilder eq;
+        localKey(*input).addToBsonObj(&eq, "$eq");
+        auto_ptr<DBClientCursor> cursor =
+            _mongod->directClient()->query(_fromNs.ns(),
+                                           Query(BSON(_foreignFieldName << eq.obj())));
+
+        vector<Value> matches;
+        while (cursor->more()) {
+            matches.push_back(Value(Document(cursor->nextSafe())));
+        }
+        return makeOutput(*input, matches);
+    }
+
+    boost::optional<Document> DocumentSourceLookup::nextFromHash() {
+        boost::optional<Document> input = pSource->getNext();
+        if (!input)
+            return boost::none;
+
+        HashTable::const_iterator it = _hashTable.find(localKey(*input));
+        if (it == _hashTable.end())
+            return makeOutput(*input, vector<Value>());
+        return makeOutput(*input, it->second);
+    }
+
+    boost::optional<Document> DocumentSourceLookup::nextFromSortMerge() {
+        if (!_localSorted->more())
+            return boost::none;
+
+        const MySorter::Data input = _localSorted->next();
+
+        // Runs of input documents share a key, so only advance the foreign side on a new one.
+        if (!_matchesKey || Value::compare(*_matchesKey, input.first) != 0) {
+            _matches.clear();
+            while (_foreignPeek || _foreignSorted->more()) {
+                if (!_foreignPeek)
+                    _foreignPeek = _foreignSorted->next();
+
+                const int cmp = Value::compare(_foreignPeek->first, input.first);
+                if (cmp > 0)
+                    break;
+                if (cmp == 0)
+                    _matches.push_back(Value(_foreignPeek->second));
+                _foreignPeek = boost::none;
+            }
+            _matchesKey = input.first;
+        }
+
+        return makeOutput(input.second, _matches);
+    }
+
+    Value DocumentSourceLookup::localKey(const Document& input) const {
+        // A missing field matches null, as it does in a query.
+        const Value key = input.getNestedField(_localField);
+        return key.missing() ? Value(BSONNULL) : key;
+    }
+
+    void DocumentSourceLookup::foreignKeys(const BSONObj& foreignDoc, vector<Value>* keys) const {
+        // A query {f: v} matches a document if f, or any element of an array at f, equals v.
+        BSONElementSet elems;
+        foreignDoc.getFieldsDotted(_foreignFieldName, elems, false);
+        if (elems.empty()) {
+            keys->push_back(Value(BSONNULL));
+            return;
+        }
+
+        const size_t begin = keys->size();
+        for (BSONElementSet::const_iterator it = elems.begin(); it != elems.end(); ++it) {
+            keys->push_back(Value(*it));
+            if (it->type() == Array) {
+                BSONForEach(elem, it->embeddedObject()) {
+                    keys->push_back(Value(elem));
+                }
+            }
+        }
+
+        // A document joins to each input document at most once.
+        std::sort(keys->begin() + begin, keys->end());
+        keys->erase(std::unique(keys->begin() + begin, keys->end()), keys->end());
+    }
+
+    Document DocumentSourceLookup::makeOutput(const Document& input,
+                                              const vector<Value>& matches) const {
+        MutableDocument output(input);
+        output.setNestedField(_as, Value(matches));
+        return output.freeze();
+    }
+
+    SortOptions DocumentSourceLookup::makeSortOptions() const {
+        SortOptions opts;
+        opts.maxMemoryUsageBytes = internalDocumentSourceLookupMaxMemoryBytes;
+        opts.extSortAllowed = true;
+        opts.tempDir = pExpCtx->tempDir;
+        return opts;
+    }
+
+    void DocumentSourceLookup::dispose() {
+        _hashTable.clear();
+        _foreignSorted.reset();
+        _localSorted.reset();
+        _foreignPeek = boost::none;
+        _matches.clear();
+        pSource->dispose();
+    }
+
+    Value DocumentSourceLookup::serialize(bool explain) const {
+        return Value(DOC(getSourceName() << DOC("from" << _fromNs.coll()
+                                             << "localField" << _localField.getPath(false)
+                                             << "foreignField" << _foreignFieldName
+                                             << "as" << _as.getPath(false))));
+    }
+
+    DocumentSource::GetDepsReturn DocumentSourceLookup::getDependencies(DepsTracker* deps) const {
+        deps->fields.insert(_localField.getPath(false));
+        return SEE_NEXT;
+    }
+
+    intrusive_ptr<DocumentSource> DocumentSourceLookup::createFromBson(
+            BSONElement elem,
+            const intrusive_ptr<ExpressionContext> &pExpCtx) {
+        uassert(28615, str::stream() << "the " << lookupName << " specification must be an object",
+                elem.type() == Object);
+
+        std::string from;
+        std::string as;
+        std::string localField;
+        std::string foreignField;
+        BSONForEach(argument, elem.embeddedObject()) {
+            const StringData argName = argument.fieldNameStringData();
+            uassert(28616, str::stream() << lookupName << " argument '" << argName
+                                         << "' must be a string, not " << typeName(argument.type()),
+                    argument.type() == String);
+
+            if (argName == "from") {
+                from = argument.String();
+            }
+            else if (argName == "as") {
+                as = argument.String();
+            }
+            else if (argName == "localField") {
+                localField = argument.String();
+            }
+            else if (argName == "foreignField") {
+                foreignField = argument.String();
+            }
+            else {
+                uasserted(28617, str::stream() << "unknown argument to " << lookupName << ": "
+                                               << argName);
+            }
+        }
+
+        uassert(28618, str::stream() << lookupName << " requires 'from', 'as', 'localField' and"
+                                        " 'foreignField' to be specified",
+                !from.empty() && !as.empty() && !localField.empty() && !foreignField.empty());
+
+        NamespaceString fromNs(pExpCtx->ns.db().toString() + '.' + from);
+        uassert(28619, "Can't $lookup from special collection: " + from,
+                fromNs.isValid() && !fromNs.isSpecial());
+
+        return new DocumentSourceLookup(fromNs, as, localField, foreignField, pExpCtx);
+    }
+}
+
+#include "mongo/db/sorter/sorter.cpp"
+// Explicit instantiation unneeded since we aren't exposing Sorter outside of this file.
@@ -292,6 +292,66 @@ namespace {
         return redactSafePortionTopLevel(getQuery()).toBson();
     }
 
+namespace {
+    // Returns whether 'filter' accepts every path the query clause 'clause' reads.
+    bool readsUnchangedPaths(const BSONElement& clause,
+                             const DocumentSourceMatch::PathFilter& filter) {
+        const StringData name = clause.fieldNameStringData();
+        if (!name.startsWith("$"))
+            return filter.isUnchanged(name);
+
+        if (name == "$and" || name == "$or" || name == "$nor") {
+            BSONForEach(branch, clause.Obj()) {
+                BSONForEach(branchClause, branch.Obj()) {
+                    if (!readsUnchangedPaths(branchClause, filter))
+                        return false;
+                }
+            }
+            return true;
+        }
+
+        // $text and anything else not naming its paths must stay where it is.
+        return name == "$comment";
+    }
+
+    // Appends each conjunct of 'query' to 'unchanged' or 'rest', flattening top-level $ands.
+    void splitConjuncts(const BSONObj& query,
+                        const DocumentSourceMatch::PathFilter& filter,
+                        BSONArrayBuilder* unchanged,
+                        BSONArrayBuilder* rest) {
+        BSONForEach(clause, query) {
+            if (clause.fieldNameStringData() == "$and") {
+                BSONForEach(conjunct, clause.Obj()) {
+                    splitConjuncts(conjunct.Obj(), filter, unchanged, rest);
+                }
+            }
+            else if (readsUnchangedPaths(clause, filter)) {
+                unchanged->append(clause.wrap());
+            }
+            else {
+                rest->append(clause.wrap());
+            }
+        }
+    }
+
+    BSONObj conjunction(const BSONArray& conjuncts) {
+        if (conjuncts.isEmpty())
+            return BSONObj();
+        if (conjuncts.nFields() == 1)
+            return conjuncts.firstElement().Obj().getOwned();
+        return BSON("$and" << conjuncts);
+    }
+}
+
+    BSONObj DocumentSourceMatch::splitUnchangedPortion(const PathFilter& filter,
+                                                       BSONObj* remainder) const {
+        BSONArrayBuilder unchanged;
+        BSONArrayBuilder rest;
+        splitConjuncts(getQuery(), filter, &unchanged, &rest);
+        *remainder = conjunction(rest.arr());
+        return conjunction(unchanged.arr());
+    }
+
     void DocumentSourceMatch::setSource(DocumentSource* source) {
         uassert(17313, "$match with $text is only allowed as the first pipeline stage",
                 !_isTextQuery);
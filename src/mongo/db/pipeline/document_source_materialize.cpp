@@ -0,0 +1,152 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include <algorithm>
+
+#include "mongo/db/pipeline/accumulator.h"
+#include "mongo/db/pipeline/document_source.h"
+
+namespace mongo {
+    const char DocumentSourceMaterialize::materializeName[] = "$materialize";
+    const char DocumentSourceMaterialize::stateName[] = "_state";
+
+    const char *DocumentSourceMaterialize::getSourceName() const {
+        return materializeName;
+    }
+
+    void DocumentSourceMaterialize::setSource(DocumentSource *pSource) {
+        DocumentSourceGroup* group = dynamic_cast<DocumentSourceGroup*>(pSource);
+        uassert(28636, "$materialize must follow a $group", group);
+
+        const vector<string>& fieldNames = group->getFieldNames();
+        uassert(28637, str::stream() << "$materialize can't store a group field named '"
+                                     << stateName << "'",
+                std::find(fieldNames.begin(), fieldNames.end(), stateName) == fieldNames.end());
+
+        // We need the partial states to merge with the stored ones.
+        group->setMergeableOutput(true);
+        _group = group;
+        DocumentSource::setSource(pSource);
+    }
+
+    boost::optional<Document> DocumentSourceMaterialize::getNext() {
+        pExpCtx->checkForInterrupt();
+
+        // make sure we only write out once
+        if (_done)
+            return boost::none;
+        _done = true;
+
+        verify(_mongod);
+        verify(_group);
+
+        uassert(28638, str::stream() << "namespace '" << _outputNs.ns()
+                                     << "' is sharded so it can't be used for $materialize",
+                !_mongod->isSharded(_outputNs));
+
+        uassert(28639, str::stream() << "namespace '" << _outputNs.ns()
+                                     << "' is capped so it can't be used for $materialize",
+                !_mongod->isCapped(_outputNs));
+
+        DBClientBase* conn = _mongod->directClient();
+        while (boost::optional<Document> next = pSource->getNext()) {
+            pExpCtx->checkForInterrupt();
+            mergeGroup(conn, *next);
+        }
+
+        // This "DocumentSource" doesn't produce output documents, like $out.
+        return boost::none;
+    }
+
+    void DocumentSourceMaterialize::mergeGroup(DBClientBase* conn, const Document& partial) {
+        const Value id = partial["_id"];
+        const BSONObj query = BSON("_id" << id);
+        const BSONObj stored = conn->findOne(_outputNs.ns(), Query(query));
+        const Document storedState = stored[stateName].type() == Object
+                                   ? Document(stored[stateName].Obj())
+                                   : Document();
+
+        const vector<string>& fieldNames = _group->getFieldNames();
+        vector<intrusive_ptr<Accumulator> > accumulators = _group->makeAccumulators();
+
+        MutableDocument out(fieldNames.size() + 2);
+        MutableDocument state(fieldNames.size());
+        out.addField("_id", id);
+        for (size_t i = 0; i < fieldNames.size(); i++) {
+            const Value storedValue = storedState[fieldNames[i]];
+            if (!storedValue.missing())
+                accumulators[i]->process(storedValue, true);
+            accumulators[i]->process(partial[fieldNames[i]], true);
+
+            // we store null in this case so stored documents are predictable, as $group does
+            const Value value = accumulators[i]->getValue(false);
+            out.addField(fieldNames[i], value.missing() ? Value(BSONNULL) : value);
+            state.addField(fieldNames[i], accumulators[i]->getValue(true));
+        }
+        out.addField(stateName, state.freezeToValue());
+
+        conn->update(_outputNs.ns(), Query(query), out.freeze().toBson(), /*upsert*/ true);
+        const string error = conn->getLastError();
+        uassert(28640, str::stream() << "update for $materialize failed: " << error,
+                error.empty());
+    }
+
+    DocumentSourceMaterialize::DocumentSourceMaterialize(
+            const NamespaceString& outputNs,
+            const intrusive_ptr<ExpressionContext>& pExpCtx)
+        : DocumentSource(pExpCtx)
+        , _done(false)
+        , _group(NULL)
+        , _outputNs(outputNs)
+    {}
+
+    intrusive_ptr<DocumentSource> DocumentSourceMaterialize::createFromBson(
+            BSONElement elem,
+            const intrusive_ptr<ExpressionContext> &pExpCtx) {
+        uassert(28641, str::stream() << "$materialize only supports a string argument, not "
+                                     << typeName(elem.type()),
+                elem.type() == String);
+
+        NamespaceString outputNs(pExpCtx->ns.db().toString() + '.' + elem.str());
+        uassert(28642, "Can't $materialize to special collection: " + elem.str(),
+                !outputNs.isSpecial());
+        return new DocumentSourceMaterialize(outputNs, pExpCtx);
+    }
+
+    Value DocumentSourceMaterialize::serialize(bool explain) const {
+        return Value(DOC(getSourceName() << _outputNs.coll()));
+    }
+
+    DocumentSource::GetDepsReturn DocumentSourceMaterialize::getDependencies(
+            DepsTracker* deps) const {
+        deps->needWholeDocument = true;
+        return EXHAUSTIVE_ALL;
+    }
+}
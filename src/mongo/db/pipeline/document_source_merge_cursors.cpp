@@ -26,9 +26,12 @@
  * it in the license file.
  */
 
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
 #include "mongo/pch.h"
 
 #include "mongo/db/pipeline/document_source.h"
+#include "mongo/util/log.h"
 
 
 namespace mongo {
@@ -50,6 +53,7 @@ namespace mongo {
         : DocumentSource(pExpCtx)
         , _cursorIds(cursorIds)
         , _unstarted(true)
+        , _started(false)
     {}
 
     intrusive_ptr<DocumentSource> DocumentSourceMergeCursors::create(
@@ -130,6 +134,7 @@ namespace mongo {
         }
 
         _currentCursor = _cursors.begin();
+        _started = true;
     }
 
     Document DocumentSourceMergeCursors::nextSafeFrom(DBClientCursor* cursor) {
@@ -167,6 +172,22 @@ namespace mongo {
     }
 
     void DocumentSourceMergeCursors::dispose() {
+        // Results are no longer wanted, usually because a $limit was reached, so kill what the
+        // shards still hold now rather than on the next use of each connection. A cursor whose
+        // first batch never arrived leaves a reply on its connection, which is then closed.
+        if (_started) {
+            for (Cursors::const_iterator it = _cursors.begin(); it != _cursors.end(); ++it) {
+                try {
+                    (*it)->cursor.kill();
+                    (*it)->connection.done();
+                }
+                catch (const DBException& e) {
+                    LOG(1) << "could not kill cursor " << (*it)->cursor.getCursorId()
+                           << " on " << (*it)->connection->toString() << causedBy(e);
+                }
+            }
+        }
+
         _cursors.clear();
         _currentCursor = _cursors.end();
     }
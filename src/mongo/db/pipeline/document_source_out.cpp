@@ -79,28 +79,24 @@ namespace mongo {
                     ok);
         }
 
-        // copy indexes on _outputNs to _tempNs
+        // Remember the indexes on _outputNs, to build them on _tempNs once it holds all the
+        // data: building an index in bulk is much cheaper than maintaining it on every insert.
         const std::list<BSONObj> indexes = conn->getIndexSpecs(_outputNs);
         for (std::list<BSONObj>::const_iterator it = indexes.begin(); it != indexes.end(); ++it) {
             MutableDocument index((Document(*it)));
             index.remove("_id"); // indexes shouldn't have _ids but some existing ones do
             index["ns"] = Value(_tempNs.ns());
-
-            BSONObj indexBson = index.freeze().toBson();
-            conn->insert(_tempNs.getSystemIndexesCollection(), indexBson);
-            BSONObj err = conn->getLastErrorDetailed();
-            uassert(16995, str::stream() << "copying index for $out failed."
-                                         << " index: " << indexBson
-                                         << " error: " <<  err,
-                    DBClientWithCommands::getLastErrorString(err).empty());
+            _indexesToBuild.push_back(index.freeze().toBson());
         }
     }
 
-    void DocumentSourceOut::spill(DBClientBase* conn, const vector<BSONObj>& toInsert) {
-        conn->insert(_tempNs.ns(), toInsert);
-        BSONObj err = conn->getLastErrorDetailed();
-        uassert(16996, str::stream() << "insert for $out failed: " << err,
-                DBClientWithCommands::getLastErrorString(err).empty());
+    void DocumentSourceOut::spill(const vector<BSONObj>& toInsert) {
+        try {
+            _mongod->insert(_tempNs, toInsert);
+        }
+        catch (const DBException& e) {
+            uasserted(16996, str::stream() << "insert for $out failed: " << e.toString());
+        }
     }
 
     boost::optional<Document> DocumentSourceOut::getNext() {
@@ -123,7 +119,7 @@ namespace mongo {
             BSONObj toInsert = next->toBson();
             bufferedBytes += toInsert.objsize();
             if (!bufferedObjects.empty() && bufferedBytes > BSONObjMaxUserSize) {
-                spill(conn, bufferedObjects);
+                spill(bufferedObjects);
                 bufferedObjects.clear();
                 bufferedBytes = toInsert.objsize();
             }
@@ -131,7 +127,14 @@ namespace mongo {
         }
 
         if (!bufferedObjects.empty())
-            spill(conn, bufferedObjects);
+            spill(bufferedObjects);
+
+        try {
+            _mongod->buildIndexes(_tempNs, _indexesToBuild);
+        }
+        catch (const DBException& e) {
+            uasserted(16995, str::stream() << "copying indexes for $out failed: " << e.toString());
+        }
 
         // Checking again to make sure we didn't become sharded while running.
         uassert(17018, str::stream() << "namespace '" << _outputNs.ns()
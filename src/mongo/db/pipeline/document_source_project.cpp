@@ -75,6 +75,10 @@ namespace mongo {
 
     void DocumentSourceProject::optimize() {
         intrusive_ptr<Expression> pE(pEO->optimize());
+
+        vector<intrusive_ptr<Expression>*> roots(1, &pE);
+        Expression::eliminateCommonSubexpressions(roots);
+
         pEO = dynamic_pointer_cast<ExpressionObject>(pE);
     }
 
@@ -113,6 +117,10 @@ namespace mongo {
         return pProject;
     }
 
+    bool DocumentSourceProject::passesThroughField(const string& fieldName) const {
+        return pEO->passesThroughField(fieldName);
+    }
+
     DocumentSource::GetDepsReturn DocumentSourceProject::getDependencies(DepsTracker* deps) const {
         vector<string> path; // empty == top-level
         pEO->addDependencies(deps, &path);
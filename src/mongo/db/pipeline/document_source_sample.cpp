@@ -0,0 +1,308 @@
+/*    Copyright 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+
+#include "mongo/pch.h"
+
+#include <algorithm>
+#include <boost/scoped_ptr.hpp>
+#include <cmath>
+
+#include "mongo/db/pipeline/document_source.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/pipeline/value.h"
+#include "mongo/db/server_parameters.h"
+
+namespace mongo {
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceSampleMaxMemoryBytes, int,
+                                  100 * 1024 * 1024);
+
+namespace {
+    // How many documents in a row a random cursor may repeat before we give up on it.
+    const int kMaxConsecutiveDuplicates = 100;
+
+    // A PseudoRandom starts out with only its seed word random, so its first numbers are skewed
+    // functions of the seed.  This one has had those discarded.
+    PseudoRandom makeRandom() {
+        boost::scoped_ptr<SecureRandom> secure(SecureRandom::create());
+        PseudoRandom random(secure->nextInt64());
+        for (int i = 0; i < 16; i++) {
+            random.nextInt32();
+        }
+        return random;
+    }
+
+    // Returns a double uniform in [0, 1) made of 53 random bits.  They come from two
+    // nextInt32()s since nextInt64() sign extends its low half over the high one.
+    double nextDouble(PseudoRandom* random) {
+        const uint64_t high = static_cast<uint32_t>(random->nextInt32()) >> 6;
+        const uint64_t low = static_cast<uint32_t>(random->nextInt32()) >> 5;
+        return static_cast<double>((high << 27) | low) / static_cast<double>(1ULL << 53);
+    }
+}
+
+    const char DocumentSourceSample::sampleName[] = "$sample";
+    const char DocumentSourceSample::randValName[] = "$randVal";
+
+    DocumentSourceSample::DocumentSourceSample(const intrusive_ptr<ExpressionContext>& pExpCtx,
+                                               long long size)
+        : DocumentSource(pExpCtx)
+        , _size(size)
+        , _doingMerge(false)
+        , _populated(false)
+        , _random(makeRandom())
+        , _nextOutput(0)
+    {}
+
+    const char *DocumentSourceSample::getSourceName() const {
+        return sampleName;
+    }
+
+    boost::optional<Document> DocumentSourceSample::getNext() {
+        pExpCtx->checkForInterrupt();
+
+        if (!_populated)
+            populate();
+
+        if (_nextOutput == _sample.size()) {
+            dispose();
+            return boost::none;
+        }
+
+        // Release each document as it is output.
+        KeyedDocument& next = _sample[_nextOutput++];
+        MutableDocument out(next.second);
+        next.second = Document();
+        if (pExpCtx->inShard)
+            out.setField(randValName, Value(next.first));
+        return out.freeze();
+    }
+
+    void DocumentSourceSample::populate() {
+        const size_t maxMemoryUsageBytes = internalDocumentSourceSampleMaxMemoryBytes;
+        size_t memoryUsageBytes = 0;
+
+        while (boost::optional<Document> input = pSource->getNext()) {
+            double key;
+            if (_doingMerge) {
+                const Value randVal = input->getField(randValName);
+                massert(28625, str::stream() << "a merging $sample needs the numeric field '"
+                                             << randValName << "' from the shards",
+                        randVal.numeric());
+                key = randVal.coerceToDouble();
+
+                MutableDocument stripped(*input);
+                stripped.remove(randValName);
+                input = stripped.freeze();
+            }
+            else {
+                key = nextDouble(&_random);
+            }
+
+            if (static_cast<long long>(_sample.size()) == _size) {
+                // Only keep 'input' if it beats the largest key kept so far.
+                if (key >= _sample.front().first)
+                    continue;
+
+                memoryUsageBytes -= _sample.front().second.getApproximateSize();
+                std::pop_heap(_sample.begin(), _sample.end(), KeyLess());
+                _sample.pop_back();
+            }
+
+            memoryUsageBytes += input->getApproximateSize();
+            uassert(28624, str::stream() << "$sample exceeded its memory limit of "
+                                         << maxMemoryUsageBytes << " bytes; sample fewer"
+                                         << " documents",
+                    memoryUsageBytes <= maxMemoryUsageBytes);
+
+            _sample.push_back(KeyedDocument(key, *input));
+            std::push_heap(_sample.begin(), _sample.end(), KeyLess());
+        }
+
+        std::sort_heap(_sample.begin(), _sample.end(), KeyLess());
+        _populated = true;
+    }
+
+    void DocumentSourceSample::dispose() {
+        _sample.clear();
+        _nextOutput = 0;
+        pSource->dispose();
+    }
+
+    Value DocumentSourceSample::serialize(bool explain) const {
+        MutableDocument insides;
+        insides["size"] = Value(_size);
+        if (_doingMerge)
+            insides["$doingMerge"] = Value(true);
+
+        return Value(DOC(getSourceName() << insides.freeze()));
+    }
+
+    DocumentSource::GetDepsReturn DocumentSourceSample::getDependencies(DepsTracker* deps) const {
+        // The merger reads randValName, which can't be listed as a dependency since it isn't a
+        // valid field path, so it asks for whole documents.
+        return _doingMerge ? NOT_SUPPORTED : SEE_NEXT;
+    }
+
+    intrusive_ptr<DocumentSource> DocumentSourceSample::getMergeSource() {
+        intrusive_ptr<DocumentSourceSample> merger = DocumentSourceSample::create(pExpCtx, _size);
+        merger->_doingMerge = true;
+        return merger;
+    }
+
+    intrusive_ptr<DocumentSourceSample> DocumentSourceSample::create(
+            const intrusive_ptr<ExpressionContext>& pExpCtx,
+            long long size) {
+        uassert(28626, "size argument to $sample must be positive",
+                size > 0);
+        return new DocumentSourceSample(pExpCtx, size);
+    }
+
+    intrusive_ptr<DocumentSource> DocumentSourceSample::createFromBson(
+            BSONElement elem,
+            const intrusive_ptr<ExpressionContext>& pExpCtx) {
+        uassert(28627, "the $sample stage specification must be an object",
+                elem.type() == Object);
+
+        bool doingMerge = false;
+        boost::optional<long long> size;
+        BSONForEach(argument, elem.embeddedObject()) {
+            const StringData argName = argument.fieldNameStringData();
+            if (argName == "size") {
+                uassert(28628, "size argument to $sample must be a number",
+                        argument.isNumber());
+                size = argument.numberLong();
+            }
+            else if (argName == "$doingMerge") {
+                massert(28629, "$doingMerge should be true if present",
+                        argument.Bool());
+                doingMerge = true;
+            }
+            else {
+                uasserted(28630, str::stream() << "unrecognized option to $sample: "
+                                               << argName);
+            }
+        }
+        uassert(28631, "$sample stage must specify a size", size);
+
+        intrusive_ptr<DocumentSourceSample> sample = DocumentSourceSample::create(pExpCtx, *size);
+        sample->_doingMerge = doingMerge;
+        return sample;
+    }
+
+    // --------
+
+    const char DocumentSourceSampleFromRandomCursor::sampleFromRandomCursorName[] =
+        "$sampleFromRandomCursor";
+
+    DocumentSourceSampleFromRandomCursor::DocumentSourceSampleFromRandomCursor(
+            const intrusive_ptr<ExpressionContext>& pExpCtx,
+            long long size,
+            long long numRecords)
+        : DocumentSource(pExpCtx)
+        , _size(size)
+        , _numRecords(numRecords)
+        , _numReturned(0)
+        , _randVal(0)
+        , _random(makeRandom())
+    {}
+
+    const char *DocumentSourceSampleFromRandomCursor::getSourceName() const {
+        return sampleFromRandomCursorName;
+    }
+
+    boost::optional<Document> DocumentSourceSampleFromRandomCursor::getNext() {
+        pExpCtx->checkForInterrupt();
+
+        if (_numReturned == _size) {
+            dispose();
+            return boost::none;
+        }
+
+        for (int duplicates = 0; ; duplicates++) {
+            uassert(28632, str::stream() << "$sample found no new document in "
+                                         << kMaxConsecutiveDuplicates
+                                         << " tries of its random cursor",
+                    duplicates < kMaxConsecutiveDuplicates);
+
+            boost::optional<Document> next = pSource->getNext();
+            if (!next)
+                return boost::none;
+
+            // Documents without an _id can't be told apart, so they are never duplicates.
+            const Value id = next->getField("_id");
+            if (!id.missing() && !_seenIds.insert(id).second)
+                continue;
+
+            _numReturned++;
+            if (!pExpCtx->inShard)
+                return next;
+
+            MutableDocument out(*next);
+            out.setField(DocumentSourceSample::randValName, Value(nextRandVal()));
+            return out.freeze();
+        }
+    }
+
+    double DocumentSourceSampleFromRandomCursor::nextRandVal() {
+        // The smallest of n keys uniform in [_randVal, 1) is _randVal + (1 - _randVal)(1 - U^(1/n))
+        // for U uniform in [0, 1).  Having returned _numReturned - 1 documents, n of the
+        // collection's keys remain above _randVal.
+        const double n = std::max(1.0, static_cast<double>(_numRecords - _numReturned + 1));
+        _randVal += (1 - _randVal) * (1 - std::pow(nextDouble(&_random), 1 / n));
+        return _randVal;
+    }
+
+    void DocumentSourceSampleFromRandomCursor::dispose() {
+        _seenIds.clear();
+        pSource->dispose();
+    }
+
+    Value DocumentSourceSampleFromRandomCursor::serialize(bool explain) const {
+        // Only PipelineD creates this stage, after the pipeline has been parsed and sent to the
+        // shards, so it is only serialized for explain.
+        return Value(DOC(getSourceName() << DOC("size" << _size)));
+    }
+
+    DocumentSource::GetDepsReturn DocumentSourceSampleFromRandomCursor::getDependencies(
+            DepsTracker* deps) const {
+        deps->fields.insert("_id");
+        return SEE_NEXT;
+    }
+
+    intrusive_ptr<DocumentSourceSampleFromRandomCursor>
+    DocumentSourceSampleFromRandomCursor::create(
+            const intrusive_ptr<ExpressionContext>& pExpCtx,
+            long long size,
+            long long numRecords) {
+        return new DocumentSourceSampleFromRandomCursor(pExpCtx, size, numRecords);
+    }
+}
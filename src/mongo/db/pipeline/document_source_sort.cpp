@@ -49,9 +49,17 @@ namespace mongo {
         if (!populated)
             populate();
 
-        if (!_output || !_output->more())
+        if (!_output)
             return boost::none;
 
+        if (!_output->more()) {
+            // Like $limit, let the sources go as soon as a merge under a limit is complete
+            // rather than when the pipeline is destroyed.
+            dispose();
+            return boost::none;
+        }
+
+        _numOutput++;
         return _output->next().second;
     }
 
@@ -82,6 +90,7 @@ namespace mongo {
     DocumentSourceSort::DocumentSourceSort(const intrusive_ptr<ExpressionContext> &pExpCtx)
         : DocumentSource(pExpCtx)
         , populated(false)
+        , _numOutput(0)
         , _mergingPresorted(false)
     {}
 
@@ -218,6 +227,8 @@ namespace mongo {
     }
 
     void DocumentSourceSort::populate() {
+        makeKeyOrdering();
+
         if (_mergingPresorted) {
             typedef DocumentSourceMergeCursors DSCursors;
             typedef DocumentSourceCommandShards DSCommands;
@@ -240,12 +251,27 @@ namespace mongo {
 
     class DocumentSourceSort::IteratorFromCursor : public MySorter::Iterator {
     public:
-        IteratorFromCursor(DocumentSourceSort* sorter, DBClientCursor* cursor)
+        /**
+         * If 'batchSize' is positive the getMores on 'cursor' ask for that many results at
+         * first, doubling each time, but never for more than the $limit leaves room for.
+         */
+        IteratorFromCursor(DocumentSourceSort* sorter, DBClientCursor* cursor, long long batchSize)
             : _sorter(sorter)
             , _cursor(cursor)
+            , _batchSize(batchSize)
         {}
 
-        bool more() { return _cursor->more(); }
+        bool more() {
+            if (_batchSize > 0 && !_cursor->moreInCurrentBatch()) {
+                const long long remaining = _sorter->getLimit() - _sorter->_numOutput;
+
+                // A batch size of 1 closes the cursor after the batch.
+                _cursor->setBatchSize(std::max(2LL, std::min(remaining, _batchSize)));
+                _batchSize = std::min(_batchSize * 2,
+                                      static_cast<long long>(std::numeric_limits<int>::max()));
+            }
+            return _cursor->more();
+        }
         Data next() {
             const Document doc = DocumentSourceMergeCursors::nextSafeFrom(_cursor);
             return make_pair(_sorter->extractKey(doc), doc);
@@ -253,12 +279,21 @@ namespace mongo {
     private:
         DocumentSourceSort* _sorter;
         DBClientCursor* _cursor;
+        long long _batchSize;
     };
 
     void DocumentSourceSort::populateFromCursors(const vector<DBClientCursor*>& cursors) {
+        // Under a $limit the results are most likely spread evenly over the shards, so each
+        // cursor starts by fetching twice its share and only fetches more if it keeps winning.
+        long long batchSize = 0;
+        if (limitSrc && !cursors.empty()) {
+            batchSize = std::max(2LL, 2 * getLimit() / static_cast<long long>(cursors.size()));
+        }
+
         vector<boost::shared_ptr<MySorter::Iterator> > iterators;
         for (size_t i = 0; i < cursors.size(); i++) {
-            iterators.push_back(boost::make_shared<IteratorFromCursor>(this, cursors[i]));
+            iterators.push_back(
+                boost::make_shared<IteratorFromCursor>(this, cursors[i], batchSize));
         }
 
         _output.reset(MySorter::Iterator::merge(iterators, makeSortOptions(), Comparator(*this)));
@@ -290,10 +325,10 @@ namespace mongo {
         _output.reset(MySorter::Iterator::merge(iterators, makeSortOptions(), Comparator(*this)));
     }
 
-    Value DocumentSourceSort::extractKey(const Document& d) const {
+    DocumentSourceSort::NormalizedKey DocumentSourceSort::extractKey(const Document& d) const {
         Variables vars(0, d);
         if (vSortKey.size() == 1) {
-            return vSortKey[0]->evaluate(&vars);
+            return NormalizedKey(vSortKey[0]->evaluate(&vars), false, _keyOrdering.get());
         }
 
         vector<Value> keys;
@@ -301,7 +336,138 @@ namespace mongo {
         for (size_t i=0; i < vSortKey.size(); i++) {
             keys.push_back(vSortKey[i]->evaluate(&vars));
         }
-        return Value::consume(keys);
+        return NormalizedKey(Value::consume(keys), true, _keyOrdering.get());
+    }
+
+    void DocumentSourceSort::makeKeyOrdering() {
+        // An Ordering holds at most 32 fields.
+        if (vAscending.size() > 32) {
+            _keyOrdering.reset();
+            return;
+        }
+
+        BSONObjBuilder pattern;
+        for (size_t i = 0; i < vAscending.size(); i++) {
+            pattern.append("", vAscending[i] ? 1 : -1);
+        }
+        _keyOrdering.reset(new Ordering(Ordering::make(pattern.obj())));
+    }
+
+    int DocumentSourceSort::compare(const NormalizedKey& lhs, const NormalizedKey& rhs) const {
+        if (lhs.hasEncoding() && rhs.hasEncoding()) {
+            return lhs.getEncoding().compare(rhs.getEncoding());
+        }
+        return compare(lhs.getValue(), rhs.getValue());
+    }
+
+    namespace {
+        /**
+         * Does Value::compare() order 'value' against any other such value exactly as
+         * BSONObj::woCompare() orders them as BSON, and does KeyString agree with woCompare?
+         * Document::compare() orders embedded documents by field name before value type, unlike
+         * BSON, so documents are out, as are the exceptions of KeyString::comparesLikeWoCompare.
+         */
+        bool encodesLikeValueCompare(const Value& value) {
+            const long long kMaxExactDouble = 1LL << 53;
+            switch (value.getType()) {
+            case EOO:
+            case MinKey:
+            case MaxKey:
+            case Undefined:
+            case jstNULL:
+            case NumberInt:
+            case NumberDouble:
+            case String:
+            case BinData:
+            case jstOID:
+            case Bool:
+            case Date:
+                return true;
+            case NumberLong:
+                return value.getLong() <= kMaxExactDouble && value.getLong() >= -kMaxExactDouble;
+            case Array: {
+                const vector<Value>& elems = value.getArray();
+                for (size_t i = 0; i < elems.size(); i++) {
+                    if (elems[i].missing() || !encodesLikeValueCompare(elems[i])) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            default:
+                return false;
+            }
+        }
+
+        void appendKeyValue(BSONObjBuilder* bob, const Value& value) {
+            // A missing value compares equal to undefined.
+            if (value.missing()) {
+                bob->appendUndefined("");
+            }
+            else {
+                value.addToBsonObj(bob, "");
+            }
+        }
+    }  // namespace
+
+    DocumentSourceSort::NormalizedKey::NormalizedKey(const Value& value,
+                                                     bool compound,
+                                                     const Ordering* ordering)
+        : _value(value),
+          _hasEncoding(false) {
+        if (!ordering) {
+            return;
+        }
+
+        // A compound key is an array with one element per sort field, see extractKey().
+        BSONObjBuilder bob;
+        if (compound) {
+            const vector<Value>& fields = value.getArray();
+            for (size_t i = 0; i < fields.size(); i++) {
+                if (!encodesLikeValueCompare(fields[i])) {
+                    return;
+                }
+                appendKeyValue(&bob, fields[i]);
+            }
+        }
+        else {
+            if (!encodesLikeValueCompare(value)) {
+                return;
+            }
+            appendKeyValue(&bob, value);
+        }
+
+        _encoding.resetToKey(bob.obj(), *ordering, RecordId());
+        _hasEncoding = true;
+    }
+
+    void DocumentSourceSort::NormalizedKey::serializeForSorter(BufBuilder& buf) const {
+        _value.serializeForSorter(buf);
+        if (_hasEncoding) {
+            buf.appendNum(static_cast<int>(_encoding.getSize()));
+            buf.appendBuf(_encoding.getBuffer(), _encoding.getSize());
+        }
+        else {
+            buf.appendNum(-1);
+        }
+    }
+
+    DocumentSourceSort::NormalizedKey DocumentSourceSort::NormalizedKey::deserializeForSorter(
+            BufReader& buf, const SorterDeserializeSettings&) {
+        NormalizedKey key;
+        key._value = Value::deserializeForSorter(buf, Value::SorterDeserializeSettings());
+
+        int size;
+        buf.read(size);
+        if (size >= 0) {
+            key._encoding.resetFromBuffer(static_cast<const char*>(buf.skip(size)), size);
+            key._hasEncoding = true;
+        }
+        return key;
+    }
+
+    int DocumentSourceSort::NormalizedKey::memUsageForSorter() const {
+        return _value.memUsageForSorter() + _encoding.getSize();
     }
 
     int DocumentSourceSort::compare(const Value& lhs, const Value& rhs) const {
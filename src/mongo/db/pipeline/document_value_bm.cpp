@@ -0,0 +1,99 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/value.h"
+#include "mongo/unittest/benchmark.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace {
+
+    /**
+     * An object of 'numFields' int and string fields, named "a0", "a1", ...
+     */
+    BSONObj makeObject(long long numFields) {
+        BSONObjBuilder bob;
+        for (long long i = 0; i < numFields; i++) {
+            const std::string name = str::stream() << 'a' << i;
+            if (i % 2) {
+                bob.append(name, "a string value");
+            }
+            else {
+                bob.append(name, static_cast<int>(i));
+            }
+        }
+        return bob.obj();
+    }
+
+    MONGO_BENCHMARK_WITH_ARGS(DocumentFromBson, "1,10,100") {
+        const BSONObj obj = makeObject(state.arg());
+        while (state.keepRunning()) {
+            const Document doc(obj);
+            state.doNotOptimize(doc.size());
+        }
+    }
+
+    MONGO_BENCHMARK_WITH_ARGS(DocumentGetFieldLast, "1,10,100") {
+        const Document doc(makeObject(state.arg()));
+        const std::string last = str::stream() << 'a' << (state.arg() - 1);
+        while (state.keepRunning()) {
+            state.doNotOptimize(doc.getField(last).getType());
+        }
+    }
+
+    MONGO_BENCHMARK_WITH_ARGS(DocumentToBson, "1,10,100") {
+        const Document doc(makeObject(state.arg()));
+        while (state.keepRunning()) {
+            state.doNotOptimize(doc.toBson().objsize());
+        }
+    }
+
+    MONGO_BENCHMARK_WITH_ARGS(MutableDocumentAddField, "1,10,100") {
+        const long long numFields = state.arg();
+        while (state.keepRunning()) {
+            MutableDocument doc;
+            for (long long i = 0; i < numFields; i++) {
+                doc.addField("field", Value(static_cast<int>(i)));
+            }
+            state.doNotOptimize(doc.freeze().size());
+        }
+    }
+
+    MONGO_BENCHMARK_WITH_ARGS(ValueCompareDocuments, "1,10,100") {
+        const Value lhs(makeObject(state.arg()));
+        const Value rhs(makeObject(state.arg()));
+        while (state.keepRunning()) {
+            state.doNotOptimize(Value::compare(lhs, rhs));
+        }
+    }
+
+}  // namespace
+}  // namespace mongo
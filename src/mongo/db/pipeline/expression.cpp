@@ -605,6 +605,234 @@ namespace {
         return Value(DOC(name << DOC_ARRAY(pExpression->serialize(explain))));
     }
 
+    void ExpressionCoerceToBool::visitChildren(ChildVisitor* visitor) {
+        visitor->visit(&pExpression);
+    }
+
+    /* ----------------- ExpressionCommonSubexpression --------------------- */
+
+    intrusive_ptr<ExpressionCommonSubexpression> ExpressionCommonSubexpression::create(
+            const intrusive_ptr<Expression>& expression) {
+        return new ExpressionCommonSubexpression(expression);
+    }
+
+    ExpressionCommonSubexpression::ExpressionCommonSubexpression(
+            const intrusive_ptr<Expression>& expression)
+        : _expression(expression)
+        , _haveValue(false)
+    {}
+
+    void ExpressionCommonSubexpression::addDependencies(DepsTracker* deps,
+                                                         vector<string>* path) const {
+        _expression->addDependencies(deps, path);
+    }
+
+    Value ExpressionCommonSubexpression::evaluateInternal(Variables* vars) const {
+        const Document& root = vars->getRoot();
+        if (!_haveValue || root.getPtr() != _valueRoot.getPtr()) {
+            _value = _expression->evaluateInternal(vars);
+            _valueRoot = root;
+            _haveValue = true;
+        }
+        return _value;
+    }
+
+    Value ExpressionCommonSubexpression::serialize(bool explain) const {
+        return _expression->serialize(explain);
+    }
+
+    void ExpressionCommonSubexpression::visitChildren(ChildVisitor* visitor) {
+        visitor->visit(&_expression);
+    }
+
+namespace {
+    // Each subexpression eliminateCommonSubexpressions() could share, by its serialized form.
+    // Expressions serialize to something that parses back to an equivalent expression, so
+    // subexpressions that serialize the same way always evaluate to the same Value.
+    struct SharedSubexpression {
+        SharedSubexpression() : occurrences(0) {}
+
+        int occurrences;
+        intrusive_ptr<ExpressionCommonSubexpression> shared;
+    };
+    typedef std::map<std::string, SharedSubexpression> SharedSubexpressionMap;
+    // Holding references keeps the counted nodes alive, and their addresses unique, while
+    // ReplaceSubexpressions frees the copies it replaces.
+    typedef std::map<intrusive_ptr<Expression>, SharedSubexpressionMap::iterator>
+        SubexpressionKeyMap;
+
+    std::string serializedKey(const Expression* expression) {
+        BSONObjBuilder builder;
+        expression->serialize(false).addToBsonObj(&builder, "");
+        const BSONObj obj = builder.done();
+        return std::string(obj.objdata(), obj.objsize());
+    }
+
+    /**
+     * Whether sharing 'expression' can save any work.  Constants are free to evaluate, a single
+     * field or whole variable is one lookup, and ExpressionObjects must stay visible to their
+     * parent ExpressionObject for inclusions to work.
+     */
+    bool worthSharing(const Expression* expression) {
+        if (dynamic_cast<const ExpressionConstant*>(expression)
+                || dynamic_cast<const ExpressionObject*>(expression)
+                || dynamic_cast<const ExpressionCommonSubexpression*>(expression)) {
+            return false;
+        }
+        if (const ExpressionFieldPath* fieldPath =
+                dynamic_cast<const ExpressionFieldPath*>(expression)) {
+            return fieldPath->getFieldPath().getPathLength() > 2;
+        }
+        return true;
+    }
+
+    /**
+     * Counts the occurrences of each subexpression of a tree that is worth sharing and depends on
+     * nothing but ROOT.  Subtrees referring to any other variable, including CURRENT when a $let
+     * has rebound it, may evaluate differently each time they are reached, so are left alone.
+     */
+    class CountSubexpressions : public Expression::ChildVisitor {
+    public:
+        CountSubexpressions(SharedSubexpressionMap* shared, SubexpressionKeyMap* keys)
+            : _shared(shared)
+            , _keys(keys)
+            , _onlyRoot(true)
+        {}
+
+        virtual void visit(intrusive_ptr<Expression>* child) {
+            Expression* expression = child->get();
+            if (dynamic_cast<ExpressionCommonSubexpression*>(expression)) {
+                // Already shared by an earlier pass.
+                return;
+            }
+
+            if (ExpressionFieldPath* fieldPath = dynamic_cast<ExpressionFieldPath*>(expression)) {
+                if (fieldPath->getVariableId() != Variables::ROOT_ID) {
+                    _onlyRoot = false;
+                    return;
+                }
+            }
+
+            CountSubexpressions children(_shared, _keys);
+            expression->visitChildren(&children);
+            if (!children._onlyRoot) {
+                _onlyRoot = false;
+                return;
+            }
+
+            if (worthSharing(expression)) {
+                SharedSubexpressionMap::iterator it =
+                    _shared->insert(make_pair(serializedKey(expression),
+                                              SharedSubexpression())).first;
+                it->second.occurrences++;
+                _keys->insert(make_pair(*child, it));
+            }
+        }
+
+    private:
+        SharedSubexpressionMap* const _shared;
+        SubexpressionKeyMap* const _keys;
+        bool _onlyRoot; // whether every subtree visited so far depends only on ROOT
+    };
+
+    /** Replaces each subexpression found more than once by CountSubexpressions. */
+    class ReplaceSubexpressions : public Expression::ChildVisitor {
+    public:
+        explicit ReplaceSubexpressions(const SubexpressionKeyMap& keys) : _keys(keys) {}
+
+        virtual void visit(intrusive_ptr<Expression>* child) {
+            SubexpressionKeyMap::const_iterator key = _keys.find(*child);
+            if (key == _keys.end() || key->second->second.occurrences < 2) {
+                (*child)->visitChildren(this);
+                return;
+            }
+
+            intrusive_ptr<ExpressionCommonSubexpression>& shared = key->second->second.shared;
+            if (!shared) {
+                // The first occurrence becomes the shared copy, so it is the only one whose own
+                // subexpressions are still evaluated.
+                (*child)->visitChildren(this);
+                shared = ExpressionCommonSubexpression::create(*child);
+            }
+            *child = shared;
+        }
+
+    private:
+        const SubexpressionKeyMap& _keys;
+    };
+
+    /**
+     * A subexpression found twice only inside copies of a larger shared subexpression ends up
+     * with a single remaining occurrence.  This counts the remaining occurrences of each shared
+     * subexpression so that those can be unwrapped again.
+     */
+    class CountSharedOccurrences : public Expression::ChildVisitor {
+    public:
+        typedef std::map<const Expression*, int> OccurrenceMap;
+
+        explicit CountSharedOccurrences(OccurrenceMap* occurrences) : _occurrences(occurrences) {}
+
+        virtual void visit(intrusive_ptr<Expression>* child) {
+            if (dynamic_cast<ExpressionCommonSubexpression*>(child->get())
+                    && (*_occurrences)[child->get()]++ > 0) {
+                return;
+            }
+            (*child)->visitChildren(this);
+        }
+
+    private:
+        OccurrenceMap* const _occurrences;
+    };
+
+    class UnwrapSingleOccurrences : public Expression::ChildVisitor {
+    public:
+        explicit UnwrapSingleOccurrences(const CountSharedOccurrences::OccurrenceMap& occurrences)
+            : _occurrences(occurrences)
+        {}
+
+        virtual void visit(intrusive_ptr<Expression>* child) {
+            if (ExpressionCommonSubexpression* shared =
+                    dynamic_cast<ExpressionCommonSubexpression*>(child->get())) {
+                CountSharedOccurrences::OccurrenceMap::const_iterator it =
+                    _occurrences.find(shared);
+                if (it != _occurrences.end() && it->second == 1) {
+                    *child = shared->getExpression();
+                }
+            }
+            (*child)->visitChildren(this);
+        }
+
+    private:
+        const CountSharedOccurrences::OccurrenceMap& _occurrences;
+    };
+} // namespace
+
+    void Expression::eliminateCommonSubexpressions(
+            const vector<intrusive_ptr<Expression>*>& roots) {
+        SharedSubexpressionMap shared;
+        SubexpressionKeyMap keys;
+        CountSubexpressions count(&shared, &keys);
+        for (size_t i = 0; i < roots.size(); i++) {
+            count.visit(roots[i]);
+        }
+
+        ReplaceSubexpressions replace(keys);
+        for (size_t i = 0; i < roots.size(); i++) {
+            replace.visit(roots[i]);
+        }
+
+        CountSharedOccurrences::OccurrenceMap occurrences;
+        CountSharedOccurrences countShared(&occurrences);
+        for (size_t i = 0; i < roots.size(); i++) {
+            countShared.visit(roots[i]);
+        }
+
+        UnwrapSingleOccurrences unwrap(occurrences);
+        for (size_t i = 0; i < roots.size(); i++) {
+            unwrap.visit(roots[i]);
+        }
+    }
+
     /* ----------------------- ExpressionCompare --------------------------- */
 
     REGISTER_EXPRESSION("$cmp",
@@ -986,6 +1214,10 @@ namespace {
         _date->addDependencies(deps);
     }
 
+    void ExpressionDateToString::visitChildren(ChildVisitor* visitor) {
+        visitor->visit(&_date);
+    }
+
     /* ---------------------- ExpressionDayOfMonth ------------------------- */
 
     Value ExpressionDayOfMonth::evaluateInternal(Variables* vars) const {
@@ -1118,6 +1350,14 @@ namespace {
         }
     }
 
+    void ExpressionObject::visitChildren(ChildVisitor* visitor) {
+        for (FieldMap::iterator it(_expressions.begin()); it != _expressions.end(); ++it) {
+            if (it->second) {
+                visitor->visit(&it->second);
+            }
+        }
+    }
+
     void ExpressionObject::addToDocument(
         MutableDocument& out,
         const Document& currentDoc,
@@ -1251,6 +1491,16 @@ namespace {
         }
     }
 
+    bool ExpressionObject::passesThroughField(const string& fieldName) const {
+        FieldMap::const_iterator it = _expressions.find(fieldName);
+        if (it == _expressions.end())
+            return _atRoot && !_excludeId && fieldName == "_id";
+
+        // Inclusions have a NULL expression.  Nested inclusions have an ExpressionObject, which
+        // drops the subfields not included.
+        return !it->second;
+    }
+
     size_t ExpressionObject::getSizeHint() const {
         // Note: this can overestimate, but that is better than underestimating
         return _expressions.size() + (_excludeId ? 0 : 1);
@@ -1572,6 +1822,13 @@ namespace {
         _subExpression->addDependencies(deps);
     }
 
+    void ExpressionLet::visitChildren(ChildVisitor* visitor) {
+        for (VariableMap::iterator it=_variables.begin(), end=_variables.end(); it != end; ++it) {
+            visitor->visit(&it->second.expression);
+        }
+        visitor->visit(&_subExpression);
+    }
+
 
     /* ------------------------- ExpressionMap ----------------------------- */
 
@@ -1684,6 +1941,11 @@ namespace {
         _each->addDependencies(deps);
     }
 
+    void ExpressionMap::visitChildren(ChildVisitor* visitor) {
+        visitor->visit(&_input);
+        visitor->visit(&_each);
+    }
+
     /* ------------------------- ExpressionMeta ----------------------------- */
 
     REGISTER_EXPRESSION("$meta", ExpressionMeta::parse);
@@ -1969,6 +2231,12 @@ namespace {
         }
     }
 
+    void ExpressionNary::visitChildren(ChildVisitor* visitor) {
+        for (ExpressionVector::iterator i(vpOperand.begin()); i != vpOperand.end(); ++i) {
+            visitor->visit(&*i);
+        }
+    }
+
     void ExpressionNary::addOperand(const intrusive_ptr<Expression>& pExpression) {
         vpOperand.push_back(pExpression);
     }
@@ -189,6 +189,30 @@ namespace mongo {
          */
         virtual Value serialize(bool explain) const = 0;
 
+        /**
+         * Visitor used by visitChildren().  visit() is passed the slot holding each direct
+         * subexpression and may replace the subexpression held there.
+         */
+        class ChildVisitor {
+        public:
+            virtual ~ChildVisitor() {}
+            virtual void visit(intrusive_ptr<Expression>* child) = 0;
+        };
+
+        /** Calls visitor->visit() on each direct subexpression.  Leaves have none. */
+        virtual void visitChildren(ChildVisitor* visitor) {}
+
+        /**
+         * Common subexpression elimination over the Expression trees held in 'roots', which are
+         * the expressions a single stage evaluates against each of its input documents.
+         *
+         * Every subexpression that appears more than once and depends on nothing but ROOT is
+         * replaced, in each place it appears, by one shared ExpressionCommonSubexpression that
+         * evaluates it once per document.  Should be called after optimize().
+         */
+        static void eliminateCommonSubexpressions(
+                const std::vector<intrusive_ptr<Expression>*>& roots);
+
         /// Evaluate expression with specified inputs and return result. (only used by tests)
         Value evaluate(const Document& root) const {
             Variables vars(0, root);
@@ -321,6 +345,8 @@ namespace mongo {
             BSONElement bsonExpr,
             const VariablesParseState& vps);
 
+        virtual void visitChildren(ChildVisitor* visitor);
+
     protected:
         ExpressionNary() {}
 
@@ -402,6 +428,7 @@ namespace mongo {
         virtual void addDependencies(DepsTracker* deps, std::vector<std::string>* path=NULL) const;
         virtual Value evaluateInternal(Variables* vars) const;
         virtual Value serialize(bool explain) const;
+        virtual void visitChildren(ChildVisitor* visitor);
 
         static intrusive_ptr<ExpressionCoerceToBool> create(
             const intrusive_ptr<Expression> &pExpression);
@@ -414,6 +441,38 @@ namespace mongo {
     };
 
 
+    /**
+     * Stands in for each occurrence of a subexpression that eliminateCommonSubexpressions() found
+     * more than once in a stage.  The subexpression depends only on ROOT, so it is evaluated
+     * once per ROOT document and the saved Value is returned to the other occurrences.
+     */
+    class ExpressionCommonSubexpression : public Expression {
+    public:
+        // virtuals from Expression
+        virtual void addDependencies(DepsTracker* deps, std::vector<std::string>* path=NULL) const;
+        virtual Value evaluateInternal(Variables* vars) const;
+        virtual Value serialize(bool explain) const;
+        virtual void visitChildren(ChildVisitor* visitor);
+
+        static intrusive_ptr<ExpressionCommonSubexpression> create(
+            const intrusive_ptr<Expression>& expression);
+
+        const intrusive_ptr<Expression>& getExpression() const { return _expression; }
+
+    private:
+        explicit ExpressionCommonSubexpression(const intrusive_ptr<Expression>& expression);
+
+        intrusive_ptr<Expression> _expression;
+
+        // The ROOT that _value was computed from.  Holding a reference to it keeps its storage
+        // from being reused, and shared Documents are never modified in place, so comparing
+        // storage pointers is enough to tell whether _value is still valid.
+        mutable bool _haveValue;
+        mutable Document _valueRoot;
+        mutable Value _value;
+    };
+
+
     class ExpressionCompare : public ExpressionFixedArity<ExpressionCompare, 2> {
     public:
 
@@ -501,6 +560,7 @@ namespace mongo {
         virtual Value serialize(bool explain) const;
         virtual Value evaluateInternal(Variables* vars) const;
         virtual void addDependencies(DepsTracker* deps, std::vector<std::string>* path=NULL) const;
+        virtual void visitChildren(ChildVisitor* visitor);
 
         static intrusive_ptr<Expression> parse(
             BSONElement expr,
@@ -594,6 +654,7 @@ namespace mongo {
             const VariablesParseState& vps);
 
         const FieldPath& getFieldPath() const { return _fieldPath; }
+        Variables::Id getVariableId() const { return _variable; }
 
     private:
         ExpressionFieldPath(const std::string& fieldPath, Variables::Id variable);
@@ -646,6 +707,7 @@ namespace mongo {
         virtual Value serialize(bool explain) const;
         virtual Value evaluateInternal(Variables* vars) const;
         virtual void addDependencies(DepsTracker* deps, std::vector<std::string>* path=NULL) const;
+        virtual void visitChildren(ChildVisitor* visitor);
 
         static intrusive_ptr<Expression> parse(
             BSONElement expr,
@@ -679,6 +741,7 @@ namespace mongo {
         virtual Value serialize(bool explain) const;
         virtual Value evaluateInternal(Variables* vars) const;
         virtual void addDependencies(DepsTracker* deps, std::vector<std::string>* path=NULL) const;
+        virtual void visitChildren(ChildVisitor* visitor);
 
         static intrusive_ptr<Expression> parse(
             BSONElement expr,
@@ -773,6 +836,7 @@ namespace mongo {
         /** Only evaluates non inclusion expressions.  For inclusions, use addToDocument(). */
         virtual Value evaluateInternal(Variables* vars) const;
         virtual Value serialize(bool explain) const;
+        virtual void visitChildren(ChildVisitor* visitor);
 
         /// like evaluate(), but return a Document instead of a Value-wrapped Document.
         Document evaluateDocument(Variables* vars) const;
@@ -858,6 +922,9 @@ namespace mongo {
 
         void excludeId(bool b) { _excludeId = b; }
 
+        /** Returns true if the field 'fieldName' of the input is output unchanged. */
+        bool passesThroughField(const std::string& fieldName) const;
+
     private:
         ExpressionObject(bool atRoot);
 
@@ -42,6 +42,7 @@ namespace mongo {
             : inShard(false)
             , inRouter(false)
             , extSortAllowed(false)
+            , snapshotRead(false)
             , ns(ns)
             , opCtx(opCtx)
             , interruptCounter(interruptCheckPeriod)
@@ -61,6 +62,7 @@ namespace mongo {
         bool inShard;
         bool inRouter;
         bool extSortAllowed;
+        bool snapshotRead; // every batch reads from the snapshot of the first
         NamespaceString ns;
         std::string tempDir; // Defaults to empty to prevent external sorting in mongos.
 
@@ -73,8 +73,12 @@ namespace mongo {
          DocumentSourceGroup::createFromBson},
         {DocumentSourceLimit::limitName,
          DocumentSourceLimit::createFromBson},
+        {DocumentSourceLookup::lookupName,
+         DocumentSourceLookup::createFromBson},
         {DocumentSourceMatch::matchName,
          DocumentSourceMatch::createFromBson},
+        {DocumentSourceMaterialize::materializeName,
+         DocumentSourceMaterialize::createFromBson},
         {DocumentSourceMergeCursors::name,
          DocumentSourceMergeCursors::createFromBson},
         {DocumentSourceOut::outName,
@@ -83,6 +87,8 @@ namespace mongo {
          DocumentSourceProject::createFromBson},
         {DocumentSourceRedact::redactName,
          DocumentSourceRedact::createFromBson},
+        {DocumentSourceSample::sampleName,
+         DocumentSourceSample::createFromBson},
         {DocumentSourceSkip::skipName,
          DocumentSourceSkip::createFromBson},
         {DocumentSourceSort::sortName,
@@ -156,6 +162,15 @@ namespace mongo {
                 continue;
             }
 
+            if (str::equals(pFieldName, "snapshotRead")) {
+                uassert(28666,
+                        str::stream() << "snapshotRead must be a bool, not a "
+                                      << typeName(cmdElement.type()),
+                        cmdElement.type() == Bool);
+                pCtx->snapshotRead = cmdElement.Bool();
+                continue;
+            }
+
             /* we didn't recognize a field in the command */
             ostringstream sb;
             sb << "unrecognized field '" << cmdElement.fieldName() << "'";
@@ -205,15 +220,24 @@ namespace mongo {
             if (dynamic_cast<DocumentSourceOut*>(stage.get())) {
                 uassert(16991, "$out can only be the final stage in the pipeline",
                         iStep == nSteps - 1);
+                // Its writes would end the snapshot that the reads are pinned to.
+                uassert(28667, "$out can't be used with snapshotRead", !pCtx->snapshotRead);
+            }
+
+            if (dynamic_cast<DocumentSourceMaterialize*>(stage.get())) {
+                uassert(28643, "$materialize can only be the final stage in the pipeline",
+                        iStep == nSteps - 1);
             }
         }
 
         // The order in which optimizations are applied can have significant impact on the
         // efficiency of the final pipeline. Be Careful!
         Optimizations::Local::moveMatchBeforeSort(pPipeline.get());
+        Optimizations::Local::moveMatchBeforeProjectAndUnwind(pPipeline.get());
         Optimizations::Local::moveLimitBeforeSkip(pPipeline.get());
         Optimizations::Local::coalesceAdjacent(pPipeline.get());
         Optimizations::Local::optimizeEachDocumentSource(pPipeline.get());
+        Optimizations::Local::streamGroupAfterSort(pPipeline.get());
         Optimizations::Local::duplicateMatchBeforeInitalRedact(pPipeline.get());
 
         return pPipeline;
@@ -239,6 +263,91 @@ namespace mongo {
         }
     }
 
+namespace {
+    bool isPathPrefix(const StringData& prefix, const StringData& path) {
+        return path.size() > prefix.size() && path.startsWith(prefix) && path[prefix.size()] == '.';
+    }
+
+    // Accepts the paths whose top-level field a $project includes.
+    class ProjectPathFilter : public DocumentSourceMatch::PathFilter {
+    public:
+        explicit ProjectPathFilter(const DocumentSourceProject* project) : _project(project) {}
+
+        virtual bool isUnchanged(const StringData& path) const {
+            const size_t dot = path.find('.');
+            const StringData field = dot == string::npos ? path : path.substr(0, dot);
+            return _project->passesThroughField(field.toString());
+        }
+
+    private:
+        const DocumentSourceProject* const _project;
+    };
+
+    // Accepts the paths neither leading to nor within the path an $unwind unwinds.
+    class UnwindPathFilter : public DocumentSourceMatch::PathFilter {
+    public:
+        explicit UnwindPathFilter(const DocumentSourceUnwind* unwind)
+            : _unwindPath(unwind->getUnwindPath().getPath(false)) {}
+
+        virtual bool isUnchanged(const StringData& path) const {
+            return path != _unwindPath
+                && !isPathPrefix(_unwindPath, path)
+                && !isPathPrefix(path, _unwindPath);
+        }
+
+    private:
+        const string _unwindPath;
+    };
+
+    class AllPathsFilter : public DocumentSourceMatch::PathFilter {
+    public:
+        virtual bool isUnchanged(const StringData& path) const { return true; }
+    };
+}
+
+    void Pipeline::Optimizations::Local::moveMatchBeforeProjectAndUnwind(Pipeline* pipeline) {
+        SourceContainer& sources = pipeline->sources;
+        for (size_t srci = 1; srci < sources.size(); ++srci) {
+            // Move the match at srci back one stage at a time.
+            for (size_t matchi = srci; matchi > 0; --matchi) {
+                DocumentSourceMatch* match =
+                    dynamic_cast<DocumentSourceMatch*>(sources[matchi].get());
+                if (!match || match->isTextQuery())
+                    break;
+
+                DocumentSource* previous = sources[matchi - 1].get();
+                scoped_ptr<DocumentSourceMatch::PathFilter> filter;
+                if (DocumentSourceProject* project = dynamic_cast<DocumentSourceProject*>(previous))
+                    filter.reset(new ProjectPathFilter(project));
+                else if (DocumentSourceUnwind* unwind =
+                             dynamic_cast<DocumentSourceUnwind*>(previous))
+                    filter.reset(new UnwindPathFilter(unwind));
+                else if (dynamic_cast<DocumentSourceSort*>(previous))
+                    filter.reset(new AllPathsFilter());
+                else
+                    break;
+
+                BSONObj remainder;
+                const BSONObj unchanged = match->splitUnchangedPortion(*filter, &remainder);
+                if (unchanged.isEmpty())
+                    break;
+
+                if (remainder.isEmpty()) {
+                    swap(sources[matchi], sources[matchi - 1]);
+                    continue;
+                }
+
+                // Split the match around the previous stage and keep moving the moved part.
+                sources[matchi] = DocumentSourceMatch::createFromBson(
+                    BSON("$match" << remainder).firstElement(), pipeline->pCtx);
+                sources.insert(sources.begin() + (matchi - 1),
+                               DocumentSourceMatch::createFromBson(
+                                   BSON("$match" << unchanged).firstElement(), pipeline->pCtx));
+                ++srci;
+            }
+        }
+    }
+
     void Pipeline::Optimizations::Local::moveLimitBeforeSkip(Pipeline* pipeline) {
         SourceContainer& sources = pipeline->sources;
         if (sources.empty())
@@ -304,6 +413,36 @@ namespace mongo {
         }
     }
 
+    void Pipeline::Optimizations::Local::streamGroupAfterSort(Pipeline* pipeline) {
+        SourceContainer& sources = pipeline->sources;
+        for (size_t srci = 1; srci < sources.size(); ++srci) {
+            DocumentSourceGroup* group = dynamic_cast<DocumentSourceGroup*>(sources[srci].get());
+            DocumentSourceSort* sort = dynamic_cast<DocumentSourceSort*>(sources[srci - 1].get());
+            if (!group || !sort)
+                continue;
+
+            const vector<string> idPaths = group->getIdFieldPaths();
+            const set<string> groupPaths(idPaths.begin(), idPaths.end());
+            if (groupPaths.empty())
+                continue;
+
+            // Each path of the group key must be one of the first groupPaths.size() sort fields.
+            // Their order and directions don't matter.
+            const Document sortKey = sort->serializeSortKey(/*explain*/false);
+            set<string> leadingSortPaths;
+            FieldIterator it(sortKey);
+            while (it.more() && leadingSortPaths.size() < groupPaths.size()) {
+                const Document::FieldPair field = it.next();
+                if (!field.second.numeric())
+                    break; // a computed sort key
+                leadingSortPaths.insert(field.first.toString());
+            }
+
+            if (leadingSortPaths == groupPaths)
+                group->setStreaming(true);
+        }
+    }
+
     void Pipeline::Optimizations::Local::duplicateMatchBeforeInitalRedact(Pipeline* pipeline) {
         SourceContainer& sources = pipeline->sources;
         if (sources.size() >= 2 && dynamic_cast<DocumentSourceRedact*>(sources[0].get())) {
@@ -345,6 +484,16 @@ namespace mongo {
                 actions.addAction(ActionType::insert);
                 out->push_back(Privilege(ResourcePattern::forExactNamespace(outputNs), actions));
             }
+            else if (str::equals(stage.firstElementFieldName(), "$lookup")) {
+                BSONElement spec = stage.firstElement();
+                NamespaceString fromNs(db, spec.type() == Object ? spec.Obj()["from"].str() : "");
+                uassert(28620,
+                        mongoutils::str::stream() << "Invalid $lookup namespace, " << fromNs.ns(),
+                        fromNs.isValid());
+
+                out->push_back(Privilege(ResourcePattern::forExactNamespace(fromNs),
+                                         ActionType::find));
+            }
         }
     }
 
@@ -360,6 +509,7 @@ namespace mongo {
         Optimizations::Sharded::findSplitPoint(shardPipeline.get(), this);
         Optimizations::Sharded::moveFinalUnwindFromShardsToMerger(shardPipeline.get(), this);
         Optimizations::Sharded::limitFieldsSentFromShardsToMerger(shardPipeline.get(), this);
+        Optimizations::Sharded::stopStreamingGroupsInMerger(shardPipeline.get(), this);
 
         return shardPipeline;
     }
@@ -435,6 +585,15 @@ namespace mongo {
                 shardPipe->pCtx));
     }
 
+    void Pipeline::Optimizations::Sharded::stopStreamingGroupsInMerger(Pipeline* shardPipe,
+                                                                       Pipeline* mergePipe) {
+        SourceContainer& sources = mergePipe->sources;
+        for (SourceContainer::iterator it(sources.begin()); it != sources.end(); ++it) {
+            if (DocumentSourceGroup* group = dynamic_cast<DocumentSourceGroup*>(it->get()))
+                group->setStreaming(false);
+        }
+    }
+
     BSONObj Pipeline::getInitialQuery() const {
         if (sources.empty())
             return BSONObj();
@@ -471,6 +630,10 @@ namespace mongo {
             serialized.setField("allowDiskUse", Value(true));
         }
 
+        if (pCtx->snapshotRead) {
+            serialized.setField("snapshotRead", Value(true));
+        }
+
         return serialized.freeze();
     }
 
@@ -533,8 +696,25 @@ namespace mongo {
         if (explain)
             return false;
 
-        if (!sources.empty() && dynamic_cast<DocumentSourceNeedsMongod*>(sources.back().get()))
-            return false;
+        for (SourceContainer::const_iterator it = sources.begin(); it != sources.end(); ++it) {
+            if (dynamic_cast<DocumentSourceNeedsMongod*>(it->get()))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool Pipeline::canCacheResults() const {
+        for (SourceContainer::const_iterator it = sources.begin(); it != sources.end(); ++it) {
+            // Other stages needing mongod write or read other collections, whose changes the
+            // cache can't see. $geoNear only reads this one. $sample is random.
+            DocumentSource* source = it->get();
+            if (dynamic_cast<DocumentSourceNeedsMongod*>(source)
+                    && !dynamic_cast<DocumentSourceGeoNear*>(source))
+                return false;
+            if (dynamic_cast<DocumentSourceSample*>(source))
+                return false;
+        }
 
         return true;
     }
@@ -121,6 +121,12 @@ namespace mongo {
         /// Returns true if this pipeline only uses features that work in mongos.
         bool canRunInMongos() const;
 
+        /**
+         * Returns true if running this pipeline again over the same collection data gives the
+         * same results and has no side effects, so that its results may be cached.
+         */
+        bool canCacheResults() const;
+
         /**
          * Write the pipeline's operators to a std::vector<Value>, with the
          * explain flag true (for DocumentSource::serializeToArray()).
@@ -33,11 +33,20 @@
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/index_create.h"
 #include "mongo/db/dbdirectclient.h"
+#include "mongo/db/exec/multi_iterator.h"
+#include "mongo/db/exec/shard_filter.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/index_names.h"
+#include "mongo/db/ops/insert.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/query_planner.h"
+#include "mongo/db/repl/oplog.h"
+#include "mongo/db/repl/repl_coordinator_global.h"
 #include "mongo/s/d_state.h"
 
 namespace mongo {
@@ -68,10 +77,195 @@ namespace {
             return collection && collection->isCapped();
         }
 
+        void insert(const NamespaceString& ns, const std::vector<BSONObj>& objs) {
+            OperationContext* txn = _ctx->opCtx;
+
+            std::vector<BSONObj> docs;
+            docs.reserve(objs.size());
+            for (std::vector<BSONObj>::const_iterator it = objs.begin(); it != objs.end(); ++it) {
+                StatusWith<BSONObj> fixed = fixDocumentForInsert(*it);
+                uassertStatusOK(fixed.getStatus());
+                docs.push_back(fixed.getValue().isEmpty() ? *it : fixed.getValue());
+            }
+
+            Client::WriteContext ctx(txn, ns.ns());
+            Collection* collection = lockedCollection(ctx, ns);
+
+            WriteUnitOfWork wunit(txn);
+            uassertStatusOK(collection->insertDocuments(txn, docs, true));
+            for (std::vector<BSONObj>::const_iterator it = docs.begin(); it != docs.end(); ++it) {
+                repl::logOp(txn, "i", ns.ns().c_str(), *it);
+            }
+            wunit.commit();
+        }
+
+        void buildIndexes(const NamespaceString& ns, const std::vector<BSONObj>& indexSpecs) {
+            if (indexSpecs.empty())
+                return;
+
+            OperationContext* txn = _ctx->opCtx;
+            Client::WriteContext ctx(txn, ns.ns());
+            Collection* collection = lockedCollection(ctx, ns);
+
+            std::vector<BSONObj> specs(indexSpecs);
+            MultiIndexBlock indexer(txn, collection);
+            indexer.allowInterruption();
+            indexer.removeExistingIndexes(&specs);
+            if (specs.empty())
+                return;
+
+            uassertStatusOK(indexer.init(specs));
+            uassertStatusOK(indexer.insertAllDocumentsInCollection());
+
+            WriteUnitOfWork wunit(txn);
+            indexer.commit();
+            const std::string systemIndexes = ns.getSystemIndexesCollection();
+            for (std::vector<BSONObj>::const_iterator it = specs.begin(); it != specs.end(); ++it) {
+                repl::logOp(txn, "i", systemIndexes.c_str(), *it);
+            }
+            wunit.commit();
+        }
+
+        bool hasIndexOnField(const NamespaceString& ns, const std::string& field) {
+            AutoGetCollectionForRead ctx(_ctx->opCtx, ns.ns());
+            Collection* collection = ctx.getCollection();
+            if (!collection)
+                return false;
+
+            // A sparse index can't answer equality to null, which a missing field joins on.
+            IndexCatalog::IndexIterator ii =
+                collection->getIndexCatalog()->getIndexIterator(_ctx->opCtx, false);
+            while (ii.more()) {
+                const IndexDescriptor* desc = ii.next();
+                if (!desc->isSparse()
+                        && IndexNames::findPluginName(desc->keyPattern()) == IndexNames::BTREE
+                        && desc->keyPattern().firstElementFieldName() == field) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
     private:
+        // Returns the collection 'ns' locked by 'ctx', checking that it can still be written.
+        Collection* lockedCollection(const Client::WriteContext& ctx, const NamespaceString& ns) {
+            uassert(ErrorCodes::NotMaster,
+                    str::stream() << "not master, can't write to " << ns.ns(),
+                    repl::getGlobalReplicationCoordinator()->canAcceptWritesForDatabase(ns.db()));
+
+            Collection* collection = ctx.getCollection();
+            uassert(28612,
+                    str::stream() << "collection " << ns.ns() << " was dropped",
+                    collection);
+            return collection;
+        }
+
         intrusive_ptr<ExpressionContext> _ctx;
         DBDirectClient _client;
     };
+
+    /**
+     * Returns whether an index on one of 'paths' may be multikey. Scanning such an index orders
+     * documents by their array elements rather than by the whole value.
+     */
+    bool mayBeMultikeyOn(OperationContext* txn,
+                         Collection* collection,
+                         const vector<string>& paths) {
+        if (!collection)
+            return false;
+
+        const IndexCatalog* catalog = collection->getIndexCatalog();
+        IndexCatalog::IndexIterator ii = catalog->getIndexIterator(txn, false);
+        while (ii.more()) {
+            const IndexDescriptor* desc = ii.next();
+            if (!desc->isMultikey(txn))
+                continue;
+
+            BSONForEach(keyElem, desc->keyPattern()) {
+                for (size_t i = 0; i < paths.size(); i++) {
+                    if (paths[i] == keyElem.fieldName())
+                        return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Returns true if 'collection' has a btree index holding one key per document that includes
+     * every top-level field in 'deps', so that the planner can answer the query from index keys.
+     */
+    bool someIndexCovers(OperationContext* txn,
+                         Collection* collection,
+                         const DepsTracker& deps) {
+        if (!collection || deps.needWholeDocument || deps.needTextScore || deps.fields.empty())
+            return false;
+
+        const IndexCatalog* catalog = collection->getIndexCatalog();
+        IndexCatalog::IndexIterator ii = catalog->getIndexIterator(txn, false);
+        while (ii.more()) {
+            const IndexDescriptor* desc = ii.next();
+            if (desc->getAccessMethodName() != IndexNames::BTREE
+                    || desc->isSparse()
+                    || desc->isMultikey(txn))
+                continue;
+
+            bool covers = true;
+            for (set<string>::const_iterator it = deps.fields.begin();
+                    covers && it != deps.fields.end(); ++it) {
+                covers = it->find('.') == string::npos
+                      && desc->keyPattern().hasField(it->c_str());
+            }
+            if (covers)
+                return true;
+        }
+        return false;
+    }
+
+    // A $sample of more than this part of a collection skips too many duplicates from a random
+    // cursor, so it scans the collection instead.
+    const double kMaxRandomCursorSampleRatio = 0.05;
+
+    /**
+     * Returns a PlanExecutor which reads 'collection' through its RecordStore's random iterator,
+     * for a $sample of 'sampleSize' documents, and sets 'numRecordsOut' to the collection's size.
+     * Returns NULL if the store has no random iterator or the sample is too large for one.
+     */
+    boost::shared_ptr<PlanExecutor> createRandomCursorExecutor(OperationContext* txn,
+                                                               Collection* collection,
+                                                               long long sampleSize,
+                                                               long long* numRecordsOut) {
+        if (!collection)
+            return boost::shared_ptr<PlanExecutor>();
+
+        const long long numRecords = collection->getRecordStore()->numRecords(txn);
+        if (sampleSize > kMaxRandomCursorSampleRatio * numRecords)
+            return boost::shared_ptr<PlanExecutor>();
+
+        std::auto_ptr<RecordIterator> it(collection->getRecordStore()->getRandomIterator(txn));
+        if (!it.get())
+            return boost::shared_ptr<PlanExecutor>();
+
+        std::auto_ptr<WorkingSet> ws(new WorkingSet());
+        std::auto_ptr<MultiIteratorStage> stage(new MultiIteratorStage(txn, ws.get(), collection));
+        stage->addIterator(it.release());
+
+        // Orphaned documents must be filtered out here, as a collection scan would.
+        PlanStage* root = stage.release();
+        CollectionMetadataPtr metadata = shardingState.getCollectionMetadata(collection->ns().ns());
+        if (metadata)
+            root = new ShardFilterStage(metadata, ws.get(), root);
+
+        PlanExecutor* rawExec;
+        uassertStatusOK(PlanExecutor::make(txn,
+                                           ws.release(),
+                                           root,
+                                           collection,
+                                           PlanExecutor::YIELD_AUTO,
+                                           &rawExec));
+        *numRecordsOut = numRecords;
+        return boost::shared_ptr<PlanExecutor>(rawExec);
+    }
 }
 
     shared_ptr<PlanExecutor> PipelineD::prepareCursorSource(
@@ -116,13 +310,37 @@ namespace {
             sources.pop_front();
         }
 
+        // A $sample at the start of the pipeline reads only about as many documents as it
+        // outputs if the collection has a random cursor.
+        boost::shared_ptr<PlanExecutor> exec;
+        if (queryObj.isEmpty() && !sources.empty()) {
+            DocumentSourceSample* sample =
+                dynamic_cast<DocumentSourceSample*>(sources.front().get());
+            long long numRecords = 0;
+            if (sample && !sample->isDoingMerge()) {
+                exec = createRandomCursorExecutor(txn, collection, sample->getSampleSize(),
+                                                  &numRecords);
+            }
+            if (exec.get()) {
+                const long long sampleSize = sample->getSampleSize();
+                sources.pop_front();
+                sources.push_front(DocumentSourceSampleFromRandomCursor::create(pExpCtx,
+                                                                                sampleSize,
+                                                                                numRecords));
+            }
+        }
+
         // Find the set of fields in the source documents depended on by this pipeline.
         const DepsTracker deps = pPipeline->getDependencies(queryObj);
 
         // Passing query an empty projection since it is faster to use ParsedDeps::extractFields().
-        // This will need to change to support covering indexes (SERVER-12015). There is an
-        // exception for textScore since that can only be retrieved by a query projection.
-        const BSONObj projectionForQuery = deps.needTextScore ? deps.toProjection() : BSONObj();
+        // There are two exceptions: textScore can only be retrieved by a query projection, and
+        // when an index holds every field we depend on the projection lets the planner scan that
+        // index's keys in place of the collection's documents.
+        const bool mayCover = someIndexCovers(txn, collection, deps);
+        const BSONObj projectionForQuery = (deps.needTextScore || mayCover)
+                                         ? deps.toProjection()
+                                         : BSONObj();
 
         /*
           Look for an initial sort; we'll try to add this to the
@@ -162,8 +380,8 @@ namespace {
         const size_t runnerOptions = QueryPlannerParams::DEFAULT
                                    | QueryPlannerParams::INCLUDE_SHARD_FILTER
                                    | QueryPlannerParams::NO_BLOCKING_SORT
+                                   | (mayCover ? QueryPlannerParams::COVERED_WHOLE_IXSCAN : 0)
                                    ;
-        boost::shared_ptr<PlanExecutor> exec;
         bool sortInRunner = false;
 
         const WhereCallbackReal whereCallback(pExpCtx->opCtx, pExpCtx->ns.db());
@@ -190,6 +408,16 @@ namespace {
                 sortInRunner = true;
 
                 sources.pop_front();
+
+                // A $group that streams relies on documents with equal keys being adjacent, which
+                // the index scan doesn't guarantee for arrays.
+                DocumentSourceGroup* group = sources.empty()
+                    ? NULL : dynamic_cast<DocumentSourceGroup*>(sources.front().get());
+                if (group && group->isStreaming()
+                        && mayBeMultikeyOn(txn, collection, group->getIdFieldPaths())) {
+                    group->setStreaming(false);
+                }
+
                 if (sortStage->getLimitSrc()) {
                     // need to reinsert coalesced $limit after removing $sort
                     sources.push_front(sortStage->getLimitSrc());
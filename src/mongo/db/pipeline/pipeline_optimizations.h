@@ -52,6 +52,17 @@ namespace mongo {
          */
         static void moveMatchBeforeSort(Pipeline* pipeline);
 
+        /**
+         * Moves the parts of matches that only read fields an earlier $project, $unwind or $sort
+         * leaves unchanged before that stage, as far toward the start of the pipeline as they go.
+         *
+         * A $project leaves the fields it includes unchanged and an $unwind every path but the
+         * unwound one.  The part of a match reaching the start of the pipeline becomes the query
+         * of the cursor, which can use an index.  Conditions on the unwound path stay after the
+         * $unwind, since they apply to each array element rather than to the array.
+         */
+        static void moveMatchBeforeProjectAndUnwind(Pipeline* pipeline);
+
         /**
          * Moves limits before any adjacent skip phases.
          *
@@ -80,6 +91,16 @@ namespace mongo {
          */
         static void optimizeEachDocumentSource(Pipeline* pipeline);
 
+        /**
+         * Makes a $group stream its results if it directly follows a $sort whose leading fields
+         * are the fields of the group key.
+         *
+         * The documents of each group are then adjacent, so the $group can return each group as
+         * soon as the key changes, holding a single group in memory. If the $sort is later
+         * pushed into the query, the index scan provides the order instead.
+         */
+        static void streamGroupAfterSort(Pipeline* pipeline);
+
         /**
          * Optimizes [$redact, $match] to [$match, $redact, $match] if possible.
          *
@@ -120,5 +141,11 @@ namespace mongo {
          * convert less source BSON into Documents.
          */
         static void limitFieldsSentFromShardsToMerger(Pipeline* shardPipe, Pipeline* mergePipe);
+
+        /**
+         * Stops the $groups in mergePipe from streaming. The shards may have pushed their $sort
+         * into a scan of a multikey index, whose order doesn't keep equal group keys adjacent.
+         */
+        static void stopStreamingGroupsInMerger(Pipeline* shardPipe, Pipeline* mergePipe);
     };
 } // namespace mongo
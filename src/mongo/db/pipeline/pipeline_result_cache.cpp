@@ -0,0 +1,149 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/pipeline_result_cache.h"
+
+#include "mongo/base/counter.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/server_parameters.h"
+
+namespace mongo {
+
+    MONGO_EXPORT_SERVER_PARAMETER(aggregationResultCacheSizeBytes, int, 0);
+    MONGO_EXPORT_SERVER_PARAMETER(aggregationResultCacheMaxStalenessSecs, int, 0);
+
+namespace {
+    Counter64 hitCounter;
+    Counter64 missCounter;
+    Counter64 evictionCounter;
+
+    ServerStatusMetricField<Counter64> displayHits("aggregate.resultCache.hits", &hitCounter);
+    ServerStatusMetricField<Counter64> displayMisses("aggregate.resultCache.misses",
+                                                     &missCounter);
+    ServerStatusMetricField<Counter64> displayEvictions("aggregate.resultCache.evictions",
+                                                        &evictionCounter);
+}
+
+    PipelineResultCache::PipelineResultCache() : _bytesUsed(0) {}
+
+    PipelineResultCache& PipelineResultCache::get() {
+        static PipelineResultCache cache;
+        return cache;
+    }
+
+    std::string PipelineResultCache::makeKey(const std::string& ns, const BSONObj& key) {
+        std::string out(ns);
+        out.push_back('\0'); // namespaces can't contain NUL
+        out.append(key.objdata(), key.objsize());
+        return out;
+    }
+
+    bool PipelineResultCache::lookup(const std::string& ns,
+                                     const BSONObj& key,
+                                     unsigned long long writeGeneration,
+                                     unsigned long long nowMillis,
+                                     BSONObj* results) {
+        boost::mutex::scoped_lock lk(_mutex);
+
+        EntryIndex::iterator it = _index.find(makeKey(ns, key));
+        if (it == _index.end()) {
+            missCounter.increment();
+            return false;
+        }
+
+        EntryList::iterator entry = it->second;
+        if (entry->writeGeneration != writeGeneration) {
+            const unsigned long long maxStalenessMillis =
+                static_cast<unsigned long long>(aggregationResultCacheMaxStalenessSecs) * 1000;
+            if (nowMillis - entry->insertedMillis > maxStalenessMillis) {
+                // The collection has changed since, so this entry will never be used again.
+                _remove_inlock(entry);
+                missCounter.increment();
+                return false;
+            }
+        }
+
+        _entries.splice(_entries.begin(), _entries, entry);
+        *results = entry->results;
+        hitCounter.increment();
+        return true;
+    }
+
+    void PipelineResultCache::insert(const std::string& ns,
+                                     const BSONObj& key,
+                                     unsigned long long writeGeneration,
+                                     unsigned long long nowMillis,
+                                     const BSONObj& results) {
+        Entry newEntry;
+        newEntry.key = makeKey(ns, key);
+        newEntry.writeGeneration = writeGeneration;
+        newEntry.insertedMillis = nowMillis;
+        newEntry.results = results.getOwned();
+
+        const size_t maxBytes = std::max(aggregationResultCacheSizeBytes, 0);
+
+        boost::mutex::scoped_lock lk(_mutex);
+
+        EntryIndex::iterator it = _index.find(newEntry.key);
+        if (it != _index.end())
+            _remove_inlock(it->second);
+
+        if (newEntry.size() > maxBytes)
+            return;
+
+        while (!_entries.empty() && _bytesUsed + newEntry.size() > maxBytes) {
+            _remove_inlock(--_entries.end());
+            evictionCounter.increment();
+        }
+
+        _entries.push_front(newEntry);
+        _index[newEntry.key] = _entries.begin();
+        _bytesUsed += newEntry.size();
+    }
+
+    void PipelineResultCache::clear() {
+        boost::mutex::scoped_lock lk(_mutex);
+        _entries.clear();
+        _index.clear();
+        _bytesUsed = 0;
+    }
+
+    size_t PipelineResultCache::bytesUsed() const {
+        boost::mutex::scoped_lock lk(_mutex);
+        return _bytesUsed;
+    }
+
+    void PipelineResultCache::_remove_inlock(EntryList::iterator entry) {
+        _bytesUsed -= entry->size();
+        _index.erase(entry->key);
+        _entries.erase(entry);
+    }
+
+} // namespace mongo
@@ -0,0 +1,119 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+#include <list>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    /// The most bytes of results the cache holds. 0, the default, disables it.
+    extern int aggregationResultCacheSizeBytes;
+
+    /// How long an entry may still be used after its collection has changed. Defaults to 0.
+    extern int aggregationResultCacheMaxStalenessSecs;
+
+    /**
+     * Holds the results of recent aggregations, so that rerunning a pipeline over a collection
+     * which hasn't changed since can return them without executing it again.
+     *
+     * Entries are keyed on the namespace and an object describing the pipeline, and remember the
+     * write generation of the collection they were computed from. An entry is current while the
+     * collection still has that generation. Older entries are used until they are
+     * aggregationResultCacheMaxStalenessSecs old, and dropped after that. When the results held
+     * exceed aggregationResultCacheSizeBytes the least recently used entries are evicted.
+     *
+     * This class is thread-safe.
+     */
+    class PipelineResultCache {
+        MONGO_DISALLOW_COPYING(PipelineResultCache);
+    public:
+        PipelineResultCache();
+
+        /// The cache shared by all aggregation commands.
+        static PipelineResultCache& get();
+
+        static bool enabled() { return aggregationResultCacheSizeBytes > 0; }
+
+        /**
+         * Returns true, and sets 'results' to the cached results, if there is an entry for 'key'
+         * on 'ns' which is current at 'writeGeneration' or within the allowed staleness at
+         * 'nowMillis'.
+         */
+        bool lookup(const std::string& ns,
+                    const BSONObj& key,
+                    unsigned long long writeGeneration,
+                    unsigned long long nowMillis,
+                    BSONObj* results);
+
+        /**
+         * Caches 'results' for 'key' on 'ns', as computed at 'writeGeneration', replacing any
+         * entry it already has. Results too large for the cache are not kept.
+         */
+        void insert(const std::string& ns,
+                    const BSONObj& key,
+                    unsigned long long writeGeneration,
+                    unsigned long long nowMillis,
+                    const BSONObj& results);
+
+        void clear();
+
+        /// The approximate number of bytes the entries take.
+        size_t bytesUsed() const;
+
+    private:
+        struct Entry {
+            std::string key;
+            unsigned long long writeGeneration;
+            unsigned long long insertedMillis;
+            BSONObj results;
+
+            size_t size() const { return sizeof(Entry) + key.size() + results.objsize(); }
+        };
+
+        // Most recently used first.
+        typedef std::list<Entry> EntryList;
+        typedef boost::unordered_map<std::string, EntryList::iterator> EntryIndex;
+
+        static std::string makeKey(const std::string& ns, const BSONObj& key);
+
+        void _remove_inlock(EntryList::iterator entry);
+
+        mutable boost::mutex _mutex;
+        EntryList _entries;
+        EntryIndex _index;
+        size_t _bytesUsed;
+    };
+
+} // namespace mongo
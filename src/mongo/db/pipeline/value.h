@@ -153,6 +153,7 @@ namespace mongo {
         const char* getRegexFlags() const;
         std::string getSymbol() const;
         std::string getCode() const;
+        BSONBinData getBinData() const;
         int getInt() const;
         long long getLong() const;
         const std::vector<Value>& getArray() const { return _storage.getArray(); }
@@ -341,6 +342,12 @@ namespace mongo {
         return flags;
     }
 
+    inline BSONBinData Value::getBinData() const {
+        verify(getType() == BinData);
+        const StringData data = _storage.getString();
+        return BSONBinData(data.rawData(), data.size(), _storage.binDataType());
+    }
+
     inline std::string Value::getSymbol() const {
         verify(getType() == Symbol);
         return _storage.getString().toString();
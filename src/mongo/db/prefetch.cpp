@@ -36,6 +36,7 @@
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/dbhelpers.h"
+#include "mongo/db/global_environment_experiment.h"
 #include "mongo/db/index/index_access_method.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/repl/bgsync.h"
@@ -117,11 +118,14 @@ namespace {
         }
     }
 
-    // page in the data pages for a record associated with an object
-    void prefetchRecordPages(OperationContext* txn,
+    // page in the data pages for a record associated with an object, and return the record
+    // in 'docOut' if there is one. Reading it by _id warms it on any storage engine; on mmapv1
+    // the pages are touched as well since 'docOut' points straight at them.
+    bool prefetchRecordPages(OperationContext* txn,
                              Database* db,
                              const char* ns,
-                             const BSONObj& obj) {
+                             const BSONObj& obj,
+                             BSONObj* docOut) {
 
         BSONElement _id;
         if( obj.getObjectID(_id) ) {
@@ -140,12 +144,16 @@ namespace {
                     }
                     // hit the last page, in case we missed it above
                     _dummy_char += *(result.objdata() + result.objsize() - 1);
+
+                    *docOut = result;
+                    return true;
                 }
             }
             catch(const DBException& e) {
                 LOG(2) << "ignoring exception in prefetchRecordPages(): " << e.what() << endl;
             }
         }
+        return false;
     }
 } // namespace
 
@@ -174,10 +182,11 @@ namespace {
         BSONObj obj = op.getObjectField(opField);
         const char *ns = op.getStringField("ns");
 
-        // This will have to change for engines other than MMAP V1, because they might not have
-        // means for directly prefetching pages from the collection. For this purpose, acquire S
-        // lock on the database, instead of optimizing with IS.
-        Lock::CollectionLock collLock(txn->lockState(), ns, MODE_S);
+        // Engines other than MMAP V1 are warmed by reading through the collection and its
+        // indexes, which only needs IS. MMAP V1 touches the pages of the collection directly,
+        // so it takes S.
+        Lock::CollectionLock collLock(txn->lockState(), ns,
+                                      supportsDocLocking() ? MODE_IS : MODE_S);
 
         Collection* collection = db->getCollection( txn, ns );
         if (!collection) {
@@ -197,24 +206,19 @@ namespace {
         //     will be an insert. to do that we could do the prefetchRecordPage first and if DNE
         //     then we do #1.
         // 
-        // note that on deletes 'obj' does not have all the keys we would want to prefetch on.
-        // a way to achieve that would be to prefetch the record first, and then afterwards do 
-        // this part.
+        // 'obj' of a delete, and usually 'o2' of an update, is only the _id, while applying
+        // either unindexes every key of the current document. So prefetch the record first and
+        // then the index pages for the keys of what was found.
         //
-        prefetchIndexPages(txn, collection, prefetchConfig, obj);
-
-        // do not prefetch the data for inserts; it doesn't exist yet
-        // 
-        // we should consider doing the record prefetch for the delete op case as we hit the record
-        // when we delete.  note if done we only want to touch the first page.
-        // 
-        // update: do record prefetch. 
-        if ((*opType == 'u') &&
-            // do not prefetch the data for capped collections because
-            // they typically do not have an _id index for findById() to use.
-            !collection->isCapped()) {
-            prefetchRecordPages(txn, db, ns, obj);
+        // do not prefetch the data for inserts; it doesn't exist yet.
+        // do not prefetch the data for capped collections because they typically do not have
+        // an _id index for findById() to use.
+        BSONObj doc = obj;
+        if ((*opType == 'u' || *opType == 'd') && !collection->isCapped()) {
+            prefetchRecordPages(txn, db, ns, obj, &doc);
         }
+
+        prefetchIndexPages(txn, collection, prefetchConfig, doc);
     }
 
     class ReplIndexPrefetch : public ServerParameter {
@@ -0,0 +1,113 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/profile_ring_buffer.h"
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+    ProfileRingBuffer::ProfileRingBuffer(size_t capacity)
+        : _capacity(capacity),
+          _slots(new Slot[capacity]),
+          _next(0) {
+        invariant(capacity > 0);
+    }
+
+    void ProfileRingBuffer::append(const StringData& db, const BSONObj& obj) {
+        const unsigned long long seq = _next.fetchAndAdd(1);
+        Slot& slot = _slots[seq % _capacity];
+
+        // Swap the new entry in so the old one is freed outside the spin lock.
+        std::string dbString = db.toString();
+        BSONObj objCopy = obj;
+        {
+            scoped_spinlock lk(slot.lock);
+
+            // A writer a whole buffer length ahead may have lapped this one already.
+            if (slot.filled && slot.seq > seq) {
+                return;
+            }
+
+            slot.seq = seq;
+            slot.filled = true;
+            slot.db.swap(dbString);
+            slot.obj.swap(objCopy);
+        }
+    }
+
+    unsigned long long ProfileRingBuffer::read(unsigned long long since,
+                                               const StringData& db,
+                                               size_t limit,
+                                               std::vector<Entry>* out,
+                                               unsigned long long* overwritten) const {
+        const unsigned long long next = _next.load();
+
+        unsigned long long seq = since;
+        if (next > _capacity && seq < next - _capacity) {
+            if (overwritten) {
+                *overwritten += next - _capacity - seq;
+            }
+            seq = next - _capacity;
+        }
+
+        size_t found = 0;
+        for ( ; seq < next && found < limit; seq++) {
+            const Slot& slot = _slots[seq % _capacity];
+            scoped_spinlock lk(slot.lock);
+
+            if (!slot.filled || slot.seq < seq) {
+                // Claimed, but its writer has not filled it in yet.
+                break;
+            }
+
+            if (slot.seq > seq) {
+                if (overwritten) {
+                    (*overwritten)++;
+                }
+                continue;
+            }
+
+            if (!db.empty() && db != slot.db) {
+                continue;
+            }
+
+            Entry entry;
+            entry.seq = slot.seq;
+            entry.db = slot.db;
+            entry.obj = slot.obj;
+            out->push_back(entry);
+            found++;
+        }
+
+        return seq;
+    }
+
+}  // namespace mongo
@@ -0,0 +1,111 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/scoped_array.hpp>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/spin_lock.h"
+
+namespace mongo {
+
+    /**
+     * A fixed size, in-memory log of profiled operations, which the newest entries overwrite.
+     *
+     * Writers never wait for each other or for readers on the whole buffer: each claims the
+     * next sequence number with an atomic increment and then fills its own slot, whose spin
+     * lock is only ever contended by a reader copying that slot or a writer a whole buffer
+     * length ahead.  That keeps profiling off the write path of the operation being profiled,
+     * where system.profile inserts take locks and do I/O.
+     */
+    class ProfileRingBuffer {
+        MONGO_DISALLOW_COPYING(ProfileRingBuffer);
+    public:
+        struct Entry {
+            unsigned long long seq;
+            std::string db;
+            BSONObj obj;
+        };
+
+        /**
+         * 'capacity' must be positive.
+         */
+        explicit ProfileRingBuffer(size_t capacity);
+
+        size_t capacity() const { return _capacity; }
+
+        /**
+         * Records 'obj', the profile entry of an operation on database 'db'.  'obj' must own its
+         * buffer.
+         */
+        void append(const StringData& db, const BSONObj& obj);
+
+        /**
+         * Appends to 'out', oldest first, up to 'limit' of the entries from sequence number
+         * 'since' on, restricted to database 'db' unless it is empty.  Entries which have
+         * already been overwritten are skipped and counted in 'overwritten', if not NULL.
+         *
+         * Returns the sequence number to resume from: reading stops at the first slot which a
+         * writer has claimed but not yet filled, so no entry is ever skipped by a reader which
+         * only passes back what it was given.
+         */
+        unsigned long long read(unsigned long long since,
+                                const StringData& db,
+                                size_t limit,
+                                std::vector<Entry>* out,
+                                unsigned long long* overwritten = NULL) const;
+
+        /**
+         * The sequence number the next entry will get, which is also the number of entries ever
+         * appended.
+         */
+        unsigned long long nextSeq() const { return _next.load(); }
+
+    private:
+        struct Slot {
+            Slot() : seq(0), filled(false) { }
+
+            mutable SpinLock lock;
+            unsigned long long seq;
+            bool filled;
+            std::string db;
+            BSONObj obj;
+        };
+
+        const size_t _capacity;
+        boost::scoped_array<Slot> _slots;
+        AtomicUInt64 _next;
+    };
+
+}  // namespace mongo
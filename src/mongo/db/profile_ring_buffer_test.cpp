@@ -0,0 +1,98 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/profile_ring_buffer.h"
+
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+    TEST(ProfileRingBuffer, ReadsInOrder) {
+        ProfileRingBuffer buffer(4);
+        buffer.append("a", BSON("i" << 0));
+        buffer.append("a", BSON("i" << 1));
+
+        std::vector<ProfileRingBuffer::Entry> entries;
+        ASSERT_EQUALS(2U, buffer.read(0, "", 10, &entries));
+        ASSERT_EQUALS(2U, entries.size());
+        ASSERT_EQUALS(0U, entries[0].seq);
+        ASSERT_EQUALS(BSON("i" << 1), entries[1].obj);
+
+        // Reading from where the last read stopped sees only what is new.
+        buffer.append("a", BSON("i" << 2));
+        entries.clear();
+        ASSERT_EQUALS(3U, buffer.read(2, "", 10, &entries));
+        ASSERT_EQUALS(1U, entries.size());
+        ASSERT_EQUALS(BSON("i" << 2), entries[0].obj);
+    }
+
+    TEST(ProfileRingBuffer, OverwritesOldest) {
+        ProfileRingBuffer buffer(3);
+        for (int i = 0; i < 5; i++) {
+            buffer.append("a", BSON("i" << i));
+        }
+
+        std::vector<ProfileRingBuffer::Entry> entries;
+        unsigned long long overwritten = 0;
+        ASSERT_EQUALS(5U, buffer.read(0, "", 10, &entries, &overwritten));
+        ASSERT_EQUALS(2U, overwritten);
+        ASSERT_EQUALS(3U, entries.size());
+        ASSERT_EQUALS(BSON("i" << 2), entries[0].obj);
+        ASSERT_EQUALS(BSON("i" << 4), entries[2].obj);
+    }
+
+    TEST(ProfileRingBuffer, FiltersByDatabase) {
+        ProfileRingBuffer buffer(8);
+        buffer.append("a", BSON("i" << 0));
+        buffer.append("b", BSON("i" << 1));
+        buffer.append("a", BSON("i" << 2));
+
+        std::vector<ProfileRingBuffer::Entry> entries;
+        ASSERT_EQUALS(3U, buffer.read(0, "b", 10, &entries));
+        ASSERT_EQUALS(1U, entries.size());
+        ASSERT_EQUALS("b", entries[0].db);
+    }
+
+    TEST(ProfileRingBuffer, LimitStopsEarly) {
+        ProfileRingBuffer buffer(8);
+        for (int i = 0; i < 5; i++) {
+            buffer.append("a", BSON("i" << i));
+        }
+
+        std::vector<ProfileRingBuffer::Entry> entries;
+        ASSERT_EQUALS(2U, buffer.read(0, "", 2, &entries));
+        ASSERT_EQUALS(2U, entries.size());
+        ASSERT_EQUALS(5U, buffer.read(2, "", 10, &entries));
+        ASSERT_EQUALS(5U, entries.size());
+    }
+
+}  // namespace
+}  // namespace mongo
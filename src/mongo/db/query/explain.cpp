@@ -32,6 +32,7 @@
 
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/exec/multi_plan.h"
+#include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/plan_executor.h"
 #include "mongo/db/query/query_planner.h"
@@ -148,6 +149,10 @@ namespace {
             const CollectionScanStats* spec = static_cast<const CollectionScanStats*>(specific);
             return spec->docsTested;
         }
+        else if (STAGE_OPLOG_SCAN == type) {
+            const OplogScanStats* spec = static_cast<const OplogScanStats*>(specific);
+            return spec->docsTested + spec->docsSkipped;
+        }
 
         return 0;
     }
@@ -229,10 +234,33 @@ namespace mongo {
             bob->appendNumber("restoreState", stats.common.unyields);
             bob->appendNumber("isEOF", stats.common.isEOF);
             bob->appendNumber("invalidates", stats.common.invalidates);
+            bob->appendNumber("storageCursorOps", stats.common.storageCursorOps);
+
+            if (stats.common.hasDetailedStats) {
+                bob->appendNumber("executionTimeNanos", stats.common.executionTimeNanos);
+                if (ScopedTimer::measuresAllocations()) {
+                    bob->appendNumber("allocatedBytes", stats.common.allocatedBytes);
+                }
+            }
         }
 
         // Stage-specific stats
-        if (STAGE_AND_HASH == stats.stageType) {
+        if (STAGE_AND_BITMAP == stats.stageType) {
+            AndBitmapStats* spec = static_cast<AndBitmapStats*>(stats.specific.get());
+
+            if (verbosity >= ExplainCommon::EXEC_STATS) {
+                bob->appendNumber("memUsage", spec->memUsage);
+                bob->appendNumber("memLimit", spec->memLimit);
+
+                bob->appendNumber("flaggedButPassed", spec->flaggedButPassed);
+                bob->appendNumber("flaggedInProgress", spec->flaggedInProgress);
+                for (size_t i = 0; i < spec->bitmapAfterChild.size(); ++i) {
+                    bob->appendNumber(string(stream() << "bitmapAfterChild_" << i),
+                                      spec->bitmapAfterChild[i]);
+                }
+            }
+        }
+        else if (STAGE_AND_HASH == stats.stageType) {
             AndHashStats* spec = static_cast<AndHashStats*>(stats.specific.get());
 
             if (verbosity >= ExplainCommon::EXEC_STATS) {
@@ -266,12 +294,22 @@ namespace mongo {
                 bob->appendNumber("docsExamined", spec->docsTested);
             }
         }
+        else if (STAGE_OPLOG_SCAN == stats.stageType) {
+            OplogScanStats* spec = static_cast<OplogScanStats*>(stats.specific.get());
+            if (verbosity >= ExplainCommon::EXEC_STATS) {
+                bob->appendNumber("docsExamined", spec->docsTested + spec->docsSkipped);
+                bob->appendNumber("docsSkipped", spec->docsSkipped);
+            }
+        }
         else if (STAGE_COUNT == stats.stageType) {
             CountStats* spec = static_cast<CountStats*>(stats.specific.get());
 
             if (verbosity >= ExplainCommon::EXEC_STATS) {
                 bob->appendNumber("nCounted", spec->nCounted);
                 bob->appendNumber("nSkipped", spec->nSkipped);
+                if (spec->estimated) {
+                    bob->appendBool("estimated", true);
+                }
             }
         }
         else if (STAGE_COUNT_SCAN == stats.stageType) {
@@ -297,6 +335,7 @@ namespace mongo {
             if (verbosity >= ExplainCommon::EXEC_STATS) {
                 bob->appendNumber("docsExamined", spec->docsExamined);
                 bob->appendNumber("alreadyHasObj", spec->alreadyHasObj);
+                bob->appendNumber("docsPrefetched", spec->docsPrefetched);
             }
         }
         else if (STAGE_GEO_NEAR_2D == stats.stageType
@@ -322,6 +361,7 @@ namespace mongo {
             GroupStats* spec = static_cast<GroupStats*>(stats.specific.get());
             if (verbosity >= ExplainCommon::EXEC_STATS) {
                 bob->appendNumber("nGroups", spec->nGroups);
+                bob->appendBool("reducedNatively", spec->reducedNatively);
             }
         }
         else if (STAGE_IDHACK == stats.stageType) {
@@ -357,10 +397,17 @@ namespace mongo {
         else if (STAGE_OR == stats.stageType) {
             OrStats* spec = static_cast<OrStats*>(stats.specific.get());
 
+            if (spec->mergeByRecordId) {
+                bob->appendBool("mergeByRecordId", true);
+            }
+
             if (verbosity >= ExplainCommon::EXEC_STATS) {
                 bob->appendNumber("dupsTested", spec->dupsTested);
                 bob->appendNumber("dupsDropped", spec->dupsDropped);
                 bob->appendNumber("locsForgotten", spec->locsForgotten);
+                if (spec->mergeByRecordId) {
+                    bob->appendNumber("forcedFetches", spec->forcedFetches);
+                }
                 for (size_t i = 0; i < spec->matchTested.size(); ++i) {
                     bob->appendNumber(string(stream() << "matchTested_" << i),
                                       spec->matchTested[i]);
@@ -393,6 +440,9 @@ namespace mongo {
             if (verbosity >= ExplainCommon::EXEC_STATS) {
                 bob->appendNumber("memUsage", spec->memUsage);
                 bob->appendNumber("memLimit", spec->memLimit);
+                if (spec->usedDisk) {
+                    bob->appendBool("usedDisk", true);
+                }
             }
 
             if (spec->limit > 0) {
@@ -582,6 +632,7 @@ namespace mongo {
         // If we need execution stats, then run the plan in order to gather the stats.
         Status executePlanStatus = Status::OK();
         if (verbosity >= ExplainCommon::EXEC_STATS) {
+            ScopedTimer::DetailedScope detailedStats;
             executePlanStatus = exec->executePlan();
         }
 
@@ -28,15 +28,53 @@
 
 #include "mongo/db/query/expression_index.h"
 
+#include <boost/thread/mutex.hpp>
+
 #include "third_party/s2/s2regioncoverer.h"
 
 #include "mongo/db/geo/geoconstants.h"
 #include "mongo/db/geo/hash.h"
 #include "mongo/db/geo/r2_region_coverer.h"
 #include "mongo/db/hasher.h"
+#include "mongo/db/query/expression_index_knobs.h"
+#include "mongo/db/query/lru_key_value.h"
 
 namespace mongo {
 
+namespace {
+
+    // Maps the raw bytes of {predicate, coarsestIndexedLevel} to the intervals covering it.
+    typedef LRUKeyValue<std::string, std::vector<Interval> > CoveringCache;
+
+    boost::mutex coveringCacheMutex;
+    // Created on first use, once the cache size parameter has been set.
+    CoveringCache* coveringCache = NULL;
+
+    /**
+     * Appends the interval of strings with prefix 'cell'.  Cells are added in order, so when the
+     * previous one ended where this one starts the two are merged into one interval, which is
+     * one index seek rather than two.
+     */
+    void addCellPrefixInterval(const std::string& cell, OrderedIntervalList* oil) {
+        std::string end = cell;
+        end[end.size() - 1]++;
+
+        if (!oil->intervals.empty()) {
+            const Interval& last = oil->intervals.back();
+            if (last.startInclusive && !last.endInclusive
+                && String == last.end.type() && last.end.valuestrsafe() == cell) {
+                const std::string start = last.start.String();
+                oil->intervals.back() =
+                    IndexBoundsBuilder::makeRangeInterval(start, end, true, false);
+                return;
+            }
+        }
+
+        oil->intervals.push_back(IndexBoundsBuilder::makeRangeInterval(cell, end, true, false));
+    }
+
+}  // namespace
+
     BSONObj ExpressionMapping::hash(const BSONElement& value) {
         BSONObjBuilder bob;
         bob.append("", BSONElementHasher::hash64(value, BSONElementHasher::DEFAULT_HASH_SEED));
@@ -170,10 +208,7 @@ namespace mongo {
                 exactIt++;
             }
             else {
-                std::string end = ival;
-                end[end.size() - 1]++;
-                oilOut->intervals.push_back(
-                    IndexBoundsBuilder::makeRangeInterval(ival, end, true, false));
+                addCellPrefixInterval(ival, oilOut);
                 intervalIt++;
             }
         }
@@ -188,11 +223,7 @@ namespace mongo {
         else if (intervalSet.end() != intervalIt) {
             verify(exactSet.end() == exactIt);
             do {
-                const std::string& ival = *intervalIt;
-                std::string end = ival;
-                end[end.size() - 1]++;
-                oilOut->intervals.push_back(
-                    IndexBoundsBuilder::makeRangeInterval(ival, end, true, false));
+                addCellPrefixInterval(*intervalIt, oilOut);
                 intervalIt++;
             } while (intervalSet.end() != intervalIt);
         }
@@ -205,4 +236,49 @@ namespace mongo {
         }
     }
 
+    void ExpressionMapping::cover2dsphereCached(const BSONObj& predicate,
+                                                const S2Region& region,
+                                                const BSONObj& indexInfoObj,
+                                                OrderedIntervalList* oilOut) {
+        if (internalGeoPredicateQuery2DSphereCoveringCacheSize <= 0) {
+            cover2dsphere(region, indexInfoObj, oilOut);
+            return;
+        }
+
+        BSONObjBuilder keyBuilder;
+        keyBuilder.append("predicate", predicate);
+        BSONElement coarsestIndexedLevel = indexInfoObj["coarsestIndexedLevel"];
+        if (!coarsestIndexedLevel.eoo()) {
+            keyBuilder.append(coarsestIndexedLevel);
+        }
+        const BSONObj keyObj = keyBuilder.obj();
+        const std::string key(keyObj.objdata(), keyObj.objsize());
+
+        {
+            boost::mutex::scoped_lock lk(coveringCacheMutex);
+            if (NULL == coveringCache) {
+                coveringCache =
+                    new CoveringCache(internalGeoPredicateQuery2DSphereCoveringCacheSize);
+            }
+
+            std::vector<Interval>* cached;
+            if (coveringCache->get(key, &cached).isOK()) {
+                oilOut->intervals.insert(oilOut->intervals.end(), cached->begin(), cached->end());
+                return;
+            }
+        }
+
+        OrderedIntervalList covering;
+        cover2dsphere(region, indexInfoObj, &covering);
+        oilOut->intervals.insert(oilOut->intervals.end(),
+                                 covering.intervals.begin(),
+                                 covering.intervals.end());
+
+        boost::mutex::scoped_lock lk(coveringCacheMutex);
+        if (!coveringCache->hasKey(key)) {
+            // Drops the evicted entry, if any.
+            coveringCache->add(key, new std::vector<Interval>(covering.intervals));
+        }
+    }
+
 }  // namespace mongo
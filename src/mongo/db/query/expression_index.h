@@ -55,6 +55,16 @@ namespace mongo {
         static void cover2dsphere(const S2Region& region,
                                   const BSONObj& indexInfoObj,
                                   OrderedIntervalList* oilOut);
+
+        /**
+         * As cover2dsphere, but remembers the intervals of recently used predicates.
+         * 'predicate' is the query 'region' was parsed from, and must determine it exactly: it
+         * is the cache key, along with the index's coarsest indexed level.
+         */
+        static void cover2dsphereCached(const BSONObj& predicate,
+                                        const S2Region& region,
+                                        const BSONObj& indexInfoObj,
+                                        OrderedIntervalList* oilOut);
     };
 
 }  // namespace mongo
@@ -44,4 +44,10 @@ namespace mongo {
      */
     extern int internalGeoNearQuery2DMaxCoveringCells;
 
+    /**
+     * The number of 2dsphere predicate coverings to remember, so that repeated queries with the
+     * same geometry don't recompute them.  0 disables the cache.
+     */
+    extern int internalGeoPredicateQuery2DSphereCoveringCacheSize;
+
 }  // namespace mongo
@@ -37,6 +37,7 @@
 #include "mongo/db/commands.h"
 #include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/exec/filter.h"
+#include "mongo/db/exec/oplog_scan.h"
 #include "mongo/db/exec/oplogstart.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/global_environment_experiment.h"
@@ -46,6 +47,8 @@
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/query/qlog.h"
+#include "mongo/db/query/query_shape_stats.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner_params.h"
 #include "mongo/db/repl/repl_coordinator_global.h"
 #include "mongo/db/server_options.h"
@@ -111,6 +114,27 @@ namespace {
         return static_cast<const mongo::ComparisonMatchExpression*>(me)->getData();
     }
 
+    /**
+     * Returns true if 'pq' is a plain {_id: <value>} lookup that an IDHackStage can answer from
+     * the raw filter alone, so that building a CanonicalQuery (and its MatchExpression) and
+     * planning can be skipped entirely.
+     */
+    bool isRawIdLookup(const mongo::LiteParsedQuery& pq) {
+        const mongo::LiteParsedQuery::Options& options = pq.getOptions();
+        return !pq.isExplain()
+            && pq.getProj().isEmpty()
+            && pq.getSort().isEmpty()
+            && !hasIndexSpecifier(pq)
+            && 0 == pq.getSkip()
+            && 0 == options.maxScan
+            && !options.returnKey
+            && !options.showDiskLoc
+            && !options.snapshot
+            && !options.tailable
+            && !options.oplogReplay
+            && mongo::CanonicalQuery::isSimpleIdQuery(pq.getFilter());
+    }
+
 }  // namespace
 
 namespace mongo {
@@ -118,6 +142,10 @@ namespace mongo {
     // Failpoint for checking whether we've received a getmore.
     MONGO_FP_DECLARE(failReceivedGetmore);
 
+    // How long a query with $minOpTime waits for this node to apply that operation before it
+    // fails with OpTimeNotReached, so that the client can send it to another member.
+    MONGO_EXPORT_SERVER_PARAMETER(minOpTimeReadWaitMS, int, 500);
+
     // TODO: Move this and the other command stuff in runQuery outta here and up a level.
     static bool runCommands(OperationContext* txn,
                             const char *ns,
@@ -181,7 +209,9 @@ namespace mongo {
                               int pass,
                               bool& exhaust,
                               bool* isCursorAuthorized,
-                              bool fromDBDirectClient) {
+                              bool fromDBDirectClient,
+                              boost::shared_ptr<CappedInsertNotifier>* cappedNotifierOut,
+                              uint64_t* cappedNotifierVersionOut) {
 
         // For testing, we may want to fail if we receive a getmore.
         if (MONGO_FAIL_POINT(failReceivedGetmore)) {
@@ -196,6 +226,13 @@ namespace mongo {
         Collection* collection = ctx->getCollection();
         uassert( 17356, "collection dropped between getMore calls", collection );
 
+        // Read the version before looking for results, so that no insert committed after the
+        // look can be missed by a caller awaiting data.
+        *cappedNotifierOut = collection->getCappedInsertNotifier();
+        if (*cappedNotifierOut) {
+            *cappedNotifierVersionOut = (*cappedNotifierOut)->getVersion();
+        }
+
         QLOG() << "Running getMore, cursorid: " << cursorid << endl;
 
         // This checks to make sure the operation is allowed on a replicated node.  Since we are not
@@ -259,6 +296,16 @@ namespace mongo {
                 }
                 // Swap RecoveryUnit(s) between the ClientCursor and OperationContext.
                 ruSwapper.reset(new ScopedRecoveryUnitSwapper(cc, txn));
+
+                // Reads not waiting for the replication batch must not see any part of it
+                // through the cursor's RecoveryUnit either.
+                if (txn->lockState()->readsAtBatchBoundaries()) {
+                    invariant(txn->recoveryUnit()->readAtBatchBoundaries());
+                }
+
+                uassert(28665, "the snapshot of this snapshotRead cursor was released after "
+                               "internalQuerySnapshotReadMaxSecs",
+                        !txn->recoveryUnit()->pinnedSnapshotExpired());
             }
 
             // Reset timeout timer on the cursor since the cursor is still in use.
@@ -292,6 +339,15 @@ namespace mongo {
             PlanExecutor* exec = cc->getExecutor();
             const int queryOptions = cc->queryOptions();
 
+            // Replication streams the oplog and cloned collections in bigger batches than other
+            // clients get.  Stay well under the maximum message size, as a batch can overshoot
+            // by one document.
+            const int maxBytes = (queryOptions & (QueryOption_OplogReplay | QueryOption_Exhaust))
+                ? std::max(MaxBytesToReturnToClientAtOnce,
+                           std::min(internalQueryReplicationGetMoreMaxBytes,
+                                    static_cast<int>(MaxMessageSizeBytes / 2)))
+                : MaxBytesToReturnToClientAtOnce;
+
             // Get results out of the executor.
             exec->restoreState(txn);
 
@@ -312,8 +368,7 @@ namespace mongo {
                     }
                 }
 
-                if ((ntoreturn && numResults >= ntoreturn)
-                    || bb.len() > MaxBytesToReturnToClientAtOnce) {
+                if ((ntoreturn && numResults >= ntoreturn) || bb.len() > maxBytes) {
                     break;
                 }
             }
@@ -504,7 +559,7 @@ namespace mongo {
 
         // cout << "diskloc is " << startLoc.toString() << endl;
 
-        // Build our collection scan...
+        // Build our oplog scan...
         CollectionScanParams params;
         params.collection = collection;
         params.start = *startLoc;
@@ -512,9 +567,9 @@ namespace mongo {
         params.tailable = cq->getParsed().getOptions().tailable;
 
         WorkingSet* ws = new WorkingSet();
-        CollectionScan* cs = new CollectionScan(txn, params, ws, cq->root());
-        // Takes ownership of 'ws', 'cs', and 'cq'.
-        return PlanExecutor::make(txn, ws, cs, autoCq.release(), collection,
+        OplogScan* os = new OplogScan(txn, params, ws, cq->root());
+        // Takes ownership of 'ws', 'os', and 'cq'.
+        return PlanExecutor::make(txn, ws, os, autoCq.release(), collection,
                                   PlanExecutor::YIELD_AUTO, execOut);
     }
 
@@ -568,23 +623,54 @@ namespace mongo {
             return "";
         }
 
-        // Parse the qm into a CanonicalQuery.
+        // Parse the qm into a LiteParsedQuery.  A plain _id lookup keeps it and never becomes a
+        // CanonicalQuery; everything else is canonicalized right away.
+        std::auto_ptr<LiteParsedQuery> idLookupPq;
         std::auto_ptr<CanonicalQuery> cq;
         {
-            CanonicalQuery* cqRaw;
-            Status canonStatus = CanonicalQuery::canonicalize(q,
-                                                              &cqRaw,
-                                                              WhereCallbackReal(txn, nss.db()));
-            if (!canonStatus.isOK()) {
+            LiteParsedQuery* lpqRaw;
+            Status parseStatus = LiteParsedQuery::make(q, &lpqRaw);
+            if (!parseStatus.isOK()) {
                 uasserted(17287, str::stream() << "Can't canonicalize query: "
-                                               << canonStatus.toString());
+                                               << parseStatus.toString());
+            }
+            std::auto_ptr<LiteParsedQuery> lpq(lpqRaw);
+
+            if (isRawIdLookup(*lpq)) {
+                idLookupPq = lpq;
+            }
+            else {
+                CanonicalQuery* cqRaw;
+                Status canonStatus = CanonicalQuery::canonicalize(lpq.release(),
+                                                                  &cqRaw,
+                                                                  WhereCallbackReal(txn,
+                                                                                    nss.db()));
+                if (!canonStatus.isOK()) {
+                    uasserted(17287, str::stream() << "Can't canonicalize query: "
+                                                   << canonStatus.toString());
+                }
+                cq.reset(cqRaw);
             }
-            cq.reset(cqRaw);
         }
-        invariant(cq.get());
 
-        QLOG() << "Running query:\n" << cq->toString();
-        LOG(2) << "Running query: " << cq->toStringShort();
+        if (cq.get()) {
+            QLOG() << "Running query:\n" << cq->toString();
+            LOG(2) << "Running query: " << cq->toStringShort();
+        }
+        else {
+            QLOG() << "Running _id lookup: " << idLookupPq->getFilter().toString();
+            LOG(2) << "Running _id lookup: " << idLookupPq->getFilter().toString();
+        }
+
+        // A read which must see a write made through another member waits for it here, before
+        // taking any lock which would hold up the applier.
+        const OpTime& minOpTime = cq.get() ? cq->getParsed().getMinOpTime()
+                                           : idLookupPq->getMinOpTime();
+        if (!minOpTime.isNull()) {
+            const repl::ReplicationCoordinator::Milliseconds wait(minOpTimeReadWaitMS);
+            uassertStatusOK(repl::getGlobalReplicationCoordinator()->awaitMyOptime(
+                    txn, minOpTime, wait));
+        }
 
         // Parse, canonicalize, plan, transcribe, and get a plan executor.
         PlanExecutor* rawExec = NULL;
@@ -597,6 +683,12 @@ namespace mongo {
 
         Collection* collection = ctx.getCollection();
 
+        // Each result is copied into the reply before we ask for the next one.
+        size_t plannerOptions = QueryPlannerParams::BORROW_RECORDS;
+        if (shardingState.needCollectionMetadata(nss.ns())) {
+            plannerOptions |= QueryPlannerParams::INCLUDE_SHARD_FILTER;
+        }
+
         // We'll now try to get the query executor that will execute this query for us. There
         // are a few cases in which we know upfront which executor we should get and, therefore,
         // we shortcut the selection process here.
@@ -606,19 +698,25 @@ namespace mongo {
         // (b) if the query is a replication's initial sync one, we use a specifically designed
         // stage that skips extents faster (see details in exec/oplogstart.h).
         //
+        // (c) if the query is a plain _id lookup, we build an IDHackStage straight from the raw
+        // filter, without a CanonicalQuery.
+        //
         // Otherwise we go through the selection of which executor is most suited to the
         // query + run-time context at hand.
         Status status = Status::OK();
-        if (NULL != collection && cq->getParsed().getOptions().oplogReplay) {
+        if (idLookupPq.get()) {
+            // The raw getExecutor() canonicalizes by itself if the collection cannot use the
+            // idhack after all (e.g. a capped collection without an _id index).  Either way the
+            // LiteParsedQuery stays with us, since the executor may not have a CanonicalQuery.
+            status = getExecutor(txn, collection, nss.ns(), idLookupPq->getFilter(),
+                                 PlanExecutor::YIELD_AUTO, &rawExec, plannerOptions);
+        }
+        else if (NULL != collection && cq->getParsed().getOptions().oplogReplay) {
             status = getOplogStartHack(txn, collection, cq.release(), &rawExec);
         }
         else {
-            size_t options = QueryPlannerParams::DEFAULT;
-            if (shardingState.needCollectionMetadata(nss.ns())) {
-                options |= QueryPlannerParams::INCLUDE_SHARD_FILTER;
-            }
             status = getExecutor(txn, collection, cq.release(), PlanExecutor::YIELD_AUTO, &rawExec,
-                                 options);
+                                 plannerOptions);
         }
         invariant(cq.get() == NULL); // cq has been released above.
 
@@ -629,7 +727,8 @@ namespace mongo {
         verify(NULL != rawExec);
         auto_ptr<PlanExecutor> exec(rawExec);
 
-        const LiteParsedQuery& pq = exec->getCanonicalQuery()->getParsed();
+        const LiteParsedQuery& pq = idLookupPq.get() ? *idLookupPq
+                                                     : exec->getCanonicalQuery()->getParsed();
 
         // If it's actually an explain, do the explain and return rather than falling through
         // to the normal query execution loop.
@@ -677,6 +776,15 @@ namespace mongo {
                 slaveOK);
         uassertStatusOK(status);
 
+        // Every batch reads from the snapshot that planning read from, which the RecoveryUnit
+        // stashed in the ClientCursor keeps.  A DBDirectClient shares its caller's RecoveryUnit.
+        if (pq.isSnapshotRead()) {
+            uassert(28664, "snapshotRead is not supported by this storage engine or from within "
+                           "another operation",
+                    !fromDBDirectClient
+                        && txn->recoveryUnit()->pinSnapshot(internalQuerySnapshotReadMaxSecs));
+        }
+
         // If this exists, the collection is sharded.
         // If it doesn't exist, we can assume we're not sharded.
         // If we're sharded, we might encounter data that is not consistent with our sharding state.
@@ -799,6 +907,23 @@ namespace mongo {
         curop.debug().nscannedObjects = summaryStats.totalDocsExamined;
         curop.debug().idhack = summaryStats.isIdhack;
 
+        // Count the query against its shape.  Raw _id lookups have no CanonicalQuery, and all
+        // share one shape.
+        {
+            QueryShapeExecution execution;
+            execution.micros = curop.elapsedMicros();
+            execution.keysExamined = summaryStats.totalKeysExamined;
+            execution.docsExamined = summaryStats.totalDocsExamined;
+            execution.nreturned = numResults;
+            execution.planSummary = curop.debug().planSummary.toString();
+
+            const CanonicalQuery* shapeQuery = exec->getCanonicalQuery();
+            const StringData shapeKey = shapeQuery ? StringData(shapeQuery->getPlanCacheKey())
+                                                   : StringData("idhack");
+            QueryShapeStats::global.record(nss.ns(), shapeKey, pq.getFilter(), pq.getSort(),
+                                           pq.getProj(), execution);
+        }
+
         // Set debug information for consumption by the profiler.
         if (dbProfilingLevel > 0 ||
             curop.elapsedMillis() > serverGlobalParams.slowMS ||
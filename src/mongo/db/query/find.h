@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <boost/shared_ptr.hpp>
 #include <string>
 
 #include "mongo/db/clientcursor.h"
@@ -38,6 +39,7 @@
 
 namespace mongo {
 
+    class CappedInsertNotifier;
     class OperationContext;
 
     /**
@@ -57,6 +59,10 @@ namespace mongo {
 
     /**
      * Called from the getMore entry point in ops/query.cpp.
+     *
+     * If the collection is capped, sets '*cappedNotifierOut' to its CappedInsertNotifier and
+     * '*cappedNotifierVersionOut' to the notifier's version before any results were looked for,
+     * so that a caller told to await data can wait for the next insert.
      */
     QueryResult::View getMore(OperationContext* txn,
                               const char* ns,
@@ -66,7 +72,9 @@ namespace mongo {
                               int pass,
                               bool& exhaust,
                               bool* isCursorAuthorized,
-                              bool fromDBDirectClient);
+                              bool fromDBDirectClient,
+                              boost::shared_ptr<CappedInsertNotifier>* cappedNotifierOut,
+                              uint64_t* cappedNotifierVersionOut);
 
     /**
      * Run the query 'q' and place the result in 'result'.
@@ -32,6 +32,7 @@
 
 #include "mongo/db/query/get_executor.h"
 
+#include <algorithm>
 #include <limits>
 
 #include "mongo/base/error_codes.h"
@@ -53,6 +54,7 @@
 #include "mongo/db/query/explain.h"
 #include "mongo/db/query/query_settings.h"
 #include "mongo/db/query/index_bounds_builder.h"
+#include "mongo/db/query/index_statistics.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/plan_executor.h"
@@ -103,6 +105,7 @@ namespace mongo {
     namespace {
         // The body is below in the "count hack" section but getExecutor calls it.
         bool turnIxscanIntoCount(QuerySolution* soln);
+        bool removeFetchForCount(QuerySolution* soln);
     }  // namespace
 
 
@@ -168,12 +171,125 @@ namespace mongo {
             plannerParams->options |= QueryPlannerParams::INDEX_INTERSECTION;
         }
 
+        if (internalQueryPlannerEnableSkipScan) {
+            plannerParams->options |= QueryPlannerParams::INDEX_SKIP_SCAN;
+        }
+
         plannerParams->options |= QueryPlannerParams::KEEP_MUTATIONS;
         plannerParams->options |= QueryPlannerParams::SPLIT_LIMITED_SORT;
     }
 
     namespace {
 
+        /**
+         * Estimates from the statistics gathered by 'analyze' how many index keys and documents
+         * the plan rooted at 'node' examines.  Returns false if some leaf of the plan has no
+         * statistics to estimate from.
+         */
+        bool estimateExamined(OperationContext* txn,
+                              const Collection* collection,
+                              const QuerySolutionNode* node,
+                              double* out) {
+            if (STAGE_IXSCAN == node->getType()) {
+                const IndexScanNode* ixn = static_cast<const IndexScanNode*>(node);
+                boost::shared_ptr<const IndexStatistics> stats =
+                    collection->infoCache()->getIndexStatistics(ixn->indexKeyPattern);
+                if (!stats) {
+                    return false;
+                }
+                *out = stats->estimateKeys(ixn->bounds);
+                return true;
+            }
+
+            if (STAGE_COLLSCAN == node->getType()) {
+                *out = collection->numRecords(txn);
+                return true;
+            }
+
+            if (node->children.empty()) {
+                return false;
+            }
+
+            double total = 0;
+            for (size_t i = 0; i < node->children.size(); ++i) {
+                double childExamined;
+                if (!estimateExamined(txn, collection, node->children[i], &childExamined)) {
+                    return false;
+                }
+                total += childExamined;
+            }
+            *out = total;
+            return true;
+        }
+
+        /**
+         * Deletes the candidate solutions that index statistics estimate to examine far more
+         * than the cheapest one, so fewer plans are trial-executed.  Leaves 'solutions' alone
+         * unless every candidate can be estimated.
+         *
+         * Only the cost of finding the matching documents is estimated, so queries with a sort
+         * or a limit, where a scan that is in the right order can stop early, are not pruned.
+         */
+        void pruneByStatistics(OperationContext* txn,
+                               const Collection* collection,
+                               const CanonicalQuery& canonicalQuery,
+                               vector<QuerySolution*>* solutions) {
+            if (internalQueryPlannerStatisticsPruneRatio <= 0 || solutions->size() < 2) {
+                return;
+            }
+
+            const LiteParsedQuery& parsed = canonicalQuery.getParsed();
+            if (!parsed.getSort().isEmpty() || 0 != parsed.getNumToReturn()) {
+                return;
+            }
+
+            vector<double> examined(solutions->size());
+            for (size_t i = 0; i < solutions->size(); ++i) {
+                if (!estimateExamined(txn, collection, (*solutions)[i]->root.get(),
+                                      &examined[i])) {
+                    return;
+                }
+            }
+
+            const double cheapest = *std::min_element(examined.begin(), examined.end());
+            const double limit = std::max(cheapest, 1.0) * internalQueryPlannerStatisticsPruneRatio;
+
+            vector<QuerySolution*> kept;
+            for (size_t i = 0; i < solutions->size(); ++i) {
+                if (examined[i] <= limit) {
+                    kept.push_back((*solutions)[i]);
+                }
+                else {
+                    delete (*solutions)[i];
+                }
+            }
+
+            LOG(2) << "Index statistics pruned " << solutions->size() - kept.size() << " of "
+                   << solutions->size() << " candidate plans for "
+                   << canonicalQuery.toStringShort();
+            solutions->swap(kept);
+        }
+
+        /**
+         * Lets the collection scan at the bottom of 'soln', if any, return documents owned by the
+         * storage engine when every stage above it is done with a document before asking for the
+         * next one.  Stages which buffer their child's results need copies.
+         */
+        void borrowRecordsIfStreaming(QuerySolution* soln) {
+            QuerySolutionNode* node = soln->root.get();
+            while (STAGE_PROJECTION == node->getType()
+                   || STAGE_LIMIT == node->getType()
+                   || STAGE_SKIP == node->getType()
+                   || STAGE_SHARDING_FILTER == node->getType()
+                   || STAGE_KEEP_MUTATIONS == node->getType()) {
+                node = node->children[0];
+            }
+
+            if (STAGE_COLLSCAN == node->getType()) {
+                static_cast<CollectionScanNode*>(node)->borrowRecords = true;
+            }
+        }
+
         /**
          * Build an execution tree for the query described in 'canonicalQuery'.  Does not take
          * ownership of arguments.
@@ -349,9 +465,23 @@ namespace mongo {
                         return Status::OK();
                     }
                 }
+
+                // No single-interval count scan, but a count never needs the documents, so any
+                // solution that only fetches in order to hand them to the count can count index
+                // entries instead.
+                for (size_t i = 0; i < solutions.size(); ++i) {
+                    removeFetchForCount(solutions[i]);
+                }
             }
 
+            pruneByStatistics(opCtx, collection, *canonicalQuery, &solutions);
+
             if (1 == solutions.size()) {
+                // A lone plan has no MultiPlanStage buffering its results.
+                if (plannerParams.options & QueryPlannerParams::BORROW_RECORDS) {
+                    borrowRecordsIfStreaming(solutions[0]);
+                }
+
                 // Only one possible plan.  Run it.  Build the stages from the solution.
                 verify(StageBuilder::build(opCtx, collection, *solutions[0], ws, rootOut));
 
@@ -815,6 +945,57 @@ namespace mongo {
             return true;
         }
 
+        /**
+         * Returns true if 'node' produces its results from index keys alone, i.e. it is an index
+         * scan or a combination of index scans which never looks at a document.
+         */
+        bool isIndexOnlySubtree(const QuerySolutionNode* node) {
+            switch (node->getType()) {
+            case STAGE_IXSCAN:
+                return true;
+            case STAGE_OR:
+            case STAGE_SORT_MERGE:
+            case STAGE_AND_BITMAP:
+            case STAGE_AND_HASH:
+            case STAGE_AND_SORTED:
+                for (size_t i = 0; i < node->children.size(); ++i) {
+                    if (!isIndexOnlySubtree(node->children[i])) {
+                        return false;
+                    }
+                }
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        /**
+         * Returns 'true' if the provided count solution 'soln' had a FETCH at its root which did
+         * nothing but turn index entries into documents, and removes that FETCH.  The index scans
+         * below it already apply every predicate which needs only the key (multi-interval bounds
+         * and covered filters) and dedup by RecordId, so they produce exactly the documents being
+         * counted.  Mutates the tree in 'soln->root'.
+         *
+         * Otherwise, returns 'false'.
+         */
+        bool removeFetchForCount(QuerySolution* soln) {
+            QuerySolutionNode* root = soln->root.get();
+
+            if (STAGE_FETCH != root->getType() || NULL != root->filter.get()) {
+                return false;
+            }
+
+            if (!isIndexOnlySubtree(root->children[0])) {
+                return false;
+            }
+
+            // Detach the child so that deleting the fetch doesn't delete it as well.
+            QuerySolutionNode* child = root->children[0];
+            root->children.clear();
+            soln->root.reset(child);
+            return true;
+        }
+
         /**
          * Returns true if indices contains an index that can be
          * used with DistinctNode. Sets indexOut to the array index
@@ -1015,13 +1196,6 @@ namespace mongo {
         if (STAGE_PROJECTION == root->getType() && (STAGE_IXSCAN == root->children[0]->getType())) {
             IndexScanNode* isn = static_cast<IndexScanNode*>(root->children[0]);
 
-            // An additional filter must be applied to the data in the key, so we can't just skip
-            // all the keys with a given value; we must examine every one to find the one that (may)
-            // pass the filter.
-            if (NULL != isn->filter.get()) {
-                return false;
-            }
-
             // We only set this when we have special query modifiers (.max() or .min()) or other
             // special cases.  Don't want to handle the interactions between those and distinct.
             // Don't think this will ever really be true but if it somehow is, just ignore this
@@ -1036,6 +1210,10 @@ namespace mongo {
             dn->direction = isn->direction;
             dn->bounds = isn->bounds;
 
+            // A filter over the rest of the key is applied by the distinct scan itself, which only
+            // skips ahead to the next value once a key for the current value has passed it.
+            dn->filter.swap(isn->filter);
+
             // Figure out which field we're skipping to the next value of.  TODO: We currently only
             // try to distinct-hack when there is an index prefixed by the field we're distinct-ing
             // over.  Consider removing this code if we stick with that policy.
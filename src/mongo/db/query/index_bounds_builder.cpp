@@ -580,7 +580,10 @@ namespace mongo {
             if (mongoutils::str::equals("2dsphere", elt.valuestrsafe())) {
                 verify(gme->getGeoExpression().getGeometry().hasS2Region());
                 const S2Region& region = gme->getGeoExpression().getGeometry().getS2Region();
-                ExpressionMapping::cover2dsphere(region, index.infoObj, oilOut);
+                ExpressionMapping::cover2dsphereCached(gme->getRawObj(),
+                                                       region,
+                                                       index.infoObj,
+                                                       oilOut);
                 *tightnessOut = IndexBoundsBuilder::INEXACT_FETCH;
             }
             else if (mongoutils::str::equals("2d", elt.valuestrsafe())) {
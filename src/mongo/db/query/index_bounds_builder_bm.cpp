@@ -0,0 +1,76 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/index_bounds_builder.h"
+
+#include <memory>
+
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/unittest/benchmark.h"
+
+namespace mongo {
+namespace {
+
+    /**
+     * Times translating the predicate 'query' on field "a" into bounds on the index {a: 1}.
+     */
+    void translate(const BSONObj& query, benchmark::State& state) {
+        StatusWithMatchExpression parsed = MatchExpressionParser::parse(query);
+        invariant(parsed.isOK());
+        const std::auto_ptr<MatchExpression> expr(parsed.getValue());
+        const IndexEntry index(BSON("a" << 1));
+        const BSONElement elt = query.firstElement();
+
+        while (state.keepRunning()) {
+            OrderedIntervalList oil;
+            IndexBoundsBuilder::BoundsTightness tightness;
+            IndexBoundsBuilder::translate(expr.get(), elt, index, &oil, &tightness);
+            state.doNotOptimize(oil.intervals.size());
+        }
+    }
+
+    MONGO_BENCHMARK(IndexBoundsBuilderTranslateRange) {
+        translate(BSON("a" << BSON("$gt" << 5)), state);
+    }
+
+    MONGO_BENCHMARK_WITH_ARGS(IndexBoundsBuilderTranslateIn, "1,10,1000") {
+        BSONArrayBuilder values;
+        for (long long i = 0; i < state.arg(); i++) {
+            values.append(static_cast<int>(state.arg() - i));
+        }
+        translate(BSON("a" << BSON("$in" << values.arr())), state);
+    }
+
+    MONGO_BENCHMARK(IndexBoundsBuilderTranslateRegexPrefix) {
+        translate(BSON("a" << BSONRegEx("^abc")), state);
+    }
+
+}  // namespace
+}  // namespace mongo
@@ -0,0 +1,179 @@
+/*    Copyright 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/index_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "mongo/db/hasher.h"
+
+namespace mongo {
+
+    using std::vector;
+
+    HyperLogLog::HyperLogLog() {
+        memset(_registers, 0, sizeof(_registers));
+    }
+
+    void HyperLogLog::add(unsigned long long hash) {
+        const size_t index = hash >> (64 - kPrecision);
+
+        // The rank is one more than the number of leading zeros in the remaining bits.  The
+        // sentinel bit bounds it at 64 - kPrecision + 1.
+        unsigned long long rest = (hash << kPrecision) | (1ULL << (kPrecision - 1));
+        unsigned char rank = 1;
+        while (!(rest & (1ULL << 63))) {
+            rest <<= 1;
+            ++rank;
+        }
+
+        if (rank > _registers[index]) {
+            _registers[index] = rank;
+        }
+    }
+
+    double HyperLogLog::estimate() const {
+        const double m = kNumRegisters;
+        const double alpha = 0.7213 / (1.0 + 1.079 / m);
+
+        double sum = 0;
+        int numZeros = 0;
+        for (int i = 0; i < kNumRegisters; ++i) {
+            sum += ldexp(1.0, -_registers[i]);
+            if (0 == _registers[i]) {
+                ++numZeros;
+            }
+        }
+
+        const double raw = alpha * m * m / sum;
+        if (raw <= 2.5 * m && numZeros > 0) {
+            // Small cardinalities are better estimated by counting the empty registers.
+            return m * log(m / numZeros);
+        }
+        return raw;
+    }
+
+    IndexStatistics::IndexStatistics() : _numKeys(0), _keysPerBucket(1) { }
+
+    void IndexStatistics::addKey(const BSONObj& key) {
+        const BSONElement first = key.firstElement();
+        _distinct.add(BSONElementHasher::hash64(first, BSONElementHasher::DEFAULT_HASH_SEED));
+        ++_numKeys;
+
+        if (0 != _numKeys % _keysPerBucket) {
+            return;
+        }
+
+        _boundaries.push_back(first.wrap(""));
+        if (_boundaries.size() < 2 * kMaxBuckets) {
+            return;
+        }
+
+        // Merge neighbouring buckets.  Boundary i marks key (i + 1) * _keysPerBucket, so the
+        // odd-numbered boundaries are exactly the ones that land on the doubled bucket size.
+        for (size_t i = 0; i < kMaxBuckets; ++i) {
+            _boundaries[i] = _boundaries[2 * i + 1];
+        }
+        _boundaries.resize(kMaxBuckets);
+        _keysPerBucket *= 2;
+    }
+
+    double IndexStatistics::estimateKeys(const IndexBounds& bounds) const {
+        if (bounds.isSimpleRange) {
+            return _estimateRange(bounds.startKey.firstElement(), bounds.endKey.firstElement());
+        }
+
+        if (bounds.fields.empty()) {
+            return _numKeys;
+        }
+
+        const vector<Interval>& intervals = bounds.fields[0].intervals;
+        double total = 0;
+        for (size_t i = 0; i < intervals.size(); ++i) {
+            total += estimateKeys(intervals[i]);
+        }
+        return std::min(total, static_cast<double>(_numKeys));
+    }
+
+    double IndexStatistics::estimateKeys(const Interval& interval) const {
+        if (interval.isEmpty()) {
+            return 0;
+        }
+
+        if (!interval.isPoint()) {
+            return _estimateRange(interval.start, interval.end);
+        }
+
+        // A value that is a boundary more than once covers at least that many whole buckets.
+        // Otherwise assume the values that fit within a bucket are equally common.
+        size_t numEqual = 0;
+        for (size_t i = 0; i < _boundaries.size(); ++i) {
+            if (0 == _boundaries[i].firstElement().woCompare(interval.start, false)) {
+                ++numEqual;
+            }
+        }
+        if (numEqual > 1) {
+            return std::min(static_cast<double>(numEqual * _keysPerBucket),
+                            static_cast<double>(_numKeys));
+        }
+
+        const double distinct = std::max(1.0, numDistinctFirstField());
+        return std::min(_numKeys / distinct, static_cast<double>(_keysPerBucket));
+    }
+
+    double IndexStatistics::_estimateRange(const BSONElement& low,
+                                           const BSONElement& high) const {
+        const bool reversed = low.woCompare(high, false) > 0;
+        const BSONElement& min = reversed ? high : low;
+        const BSONElement& max = reversed ? low : high;
+
+        size_t numInRange = 0;
+        for (size_t i = 0; i < _boundaries.size(); ++i) {
+            const BSONElement boundary = _boundaries[i].firstElement();
+            if (boundary.woCompare(min, false) >= 0 && boundary.woCompare(max, false) <= 0) {
+                ++numInRange;
+            }
+        }
+
+        // The range may also cover part of the buckets on either side of the boundaries it
+        // contains; charge one extra bucket for them.
+        return std::min(static_cast<double>((numInRange + 1) * _keysPerBucket),
+                        static_cast<double>(_numKeys));
+    }
+
+    void IndexStatistics::appendStats(BSONObjBuilder* builder) const {
+        builder->appendNumber("numKeys", _numKeys);
+        builder->append("distinctFirstField", numDistinctFirstField());
+        builder->appendNumber("keysPerBucket", _keysPerBucket);
+        builder->appendNumber("numBuckets", static_cast<long long>(_boundaries.size()));
+    }
+
+}  // namespace mongo
@@ -0,0 +1,112 @@
+/*    Copyright 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/query/index_bounds.h"
+
+namespace mongo {
+
+    /**
+     * A HyperLogLog sketch: estimates the number of distinct 64-bit hashes added to it in a
+     * fixed 1KB of memory, with a standard error of roughly 3%.
+     */
+    class HyperLogLog {
+    public:
+        enum { kPrecision = 10, kNumRegisters = 1 << kPrecision };
+
+        HyperLogLog();
+
+        void add(unsigned long long hash);
+
+        double estimate() const;
+
+    private:
+        unsigned char _registers[kNumRegisters];
+    };
+
+    /**
+     * Statistics about the keys of one index, gathered by scanning the whole index with the
+     * 'analyze' command and used by the planner to estimate how many keys a scan will examine.
+     *
+     * Only the first field of the key pattern is summarized: an equi-depth histogram of its
+     * values and a HyperLogLog count of its distinct values.  Estimates for compound bounds use
+     * the first field's intervals alone, which can only overestimate.
+     *
+     * Keys must be added in index order.  Once built the object is immutable and may be shared
+     * between threads.
+     */
+    class IndexStatistics {
+    public:
+        // The histogram is kept between kMaxBuckets and 2 * kMaxBuckets buckets.
+        enum { kMaxBuckets = 64 };
+
+        IndexStatistics();
+
+        /**
+         * Adds the next key of the index.  Keys are fed in the order the index stores them.
+         */
+        void addKey(const BSONObj& key);
+
+        long long numKeys() const { return _numKeys; }
+
+        double numDistinctFirstField() const { return _distinct.estimate(); }
+
+        /**
+         * Returns the estimated number of keys that an index scan over 'bounds' examines, in
+         * [0, numKeys()].
+         */
+        double estimateKeys(const IndexBounds& bounds) const;
+
+        /**
+         * Same as above for one interval over the first field.
+         */
+        double estimateKeys(const Interval& interval) const;
+
+        void appendStats(BSONObjBuilder* builder) const;
+
+    private:
+        /**
+         * Estimated number of keys whose first field falls between 'low' and 'high', which may
+         * be in either order.
+         */
+        double _estimateRange(const BSONElement& low, const BSONElement& high) const;
+
+        long long _numKeys;
+
+        HyperLogLog _distinct;
+
+        // Single-element objects holding the first field of key number (i + 1) * _keysPerBucket,
+        // in index order.
+        std::vector<BSONObj> _boundaries;
+        long long _keysPerBucket;
+    };
+
+}  // namespace mongo
@@ -0,0 +1,146 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/db/query/index_statistics.h"
+
+#include "mongo/db/hasher.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+    using mongo::BSONElementHasher;
+    using mongo::BSONObj;
+    using mongo::BSONObjBuilder;
+    using mongo::HyperLogLog;
+    using mongo::IndexBounds;
+    using mongo::IndexStatistics;
+    using mongo::Interval;
+    using mongo::OrderedIntervalList;
+
+    long long hashOf(int i) {
+        return BSONElementHasher::hash64(BSON("" << i).firstElement(),
+                                         BSONElementHasher::DEFAULT_HASH_SEED);
+    }
+
+    TEST(HyperLogLog, Empty) {
+        HyperLogLog hll;
+        ASSERT_EQUALS(0.0, hll.estimate());
+    }
+
+    TEST(HyperLogLog, EstimatesDistinctValues) {
+        HyperLogLog small;
+        HyperLogLog large;
+        for (int i = 0; i < 100000; ++i) {
+            small.add(hashOf(i % 100));
+            large.add(hashOf(i));
+        }
+        ASSERT_APPROX_EQUAL(100.0, small.estimate(), 10.0);
+        ASSERT_APPROX_EQUAL(100000.0, large.estimate(), 10000.0);
+    }
+
+    /**
+     * Statistics over keys {"": i / 10} for i in [0, 10000): 1000 distinct values, each
+     * appearing 10 times.
+     */
+    IndexStatistics buildUniform() {
+        IndexStatistics stats;
+        for (int i = 0; i < 10000; ++i) {
+            stats.addKey(BSON("" << i / 10 << "" << i));
+        }
+        return stats;
+    }
+
+    TEST(IndexStatistics, HistogramStaysBounded) {
+        IndexStatistics stats = buildUniform();
+        ASSERT_EQUALS(10000, stats.numKeys());
+        ASSERT_APPROX_EQUAL(1000.0, stats.numDistinctFirstField(), 100.0);
+
+        BSONObjBuilder bob;
+        stats.appendStats(&bob);
+        BSONObj obj = bob.obj();
+        ASSERT_LESS_THAN_OR_EQUALS(obj["numBuckets"].numberLong(),
+                                   2 * IndexStatistics::kMaxBuckets);
+        ASSERT_GREATER_THAN_OR_EQUALS(obj["numBuckets"].numberLong(),
+                                      IndexStatistics::kMaxBuckets);
+    }
+
+    TEST(IndexStatistics, EstimatePoint) {
+        IndexStatistics stats = buildUniform();
+        Interval point(BSON("" << 500 << "" << 500), true, true);
+        ASSERT_APPROX_EQUAL(10.0, stats.estimateKeys(point), 2.0);
+    }
+
+    TEST(IndexStatistics, EstimateRange) {
+        IndexStatistics stats = buildUniform();
+
+        // [100, 300) holds 2000 keys; the estimate is off by at most two buckets.
+        Interval range(BSON("" << 100 << "" << 300), true, false);
+        ASSERT_APPROX_EQUAL(2000.0, stats.estimateKeys(range), 2 * 128.0);
+
+        // Reversed intervals, as in descending scans, give the same answer.
+        Interval reversed(BSON("" << 300 << "" << 100), false, true);
+        ASSERT_EQUALS(stats.estimateKeys(range), stats.estimateKeys(reversed));
+
+        Interval all(BSON("" << mongo::MINKEY << "" << mongo::MAXKEY), true, true);
+        ASSERT_EQUALS(10000.0, stats.estimateKeys(all));
+    }
+
+    TEST(IndexStatistics, EstimateSkewedPoint) {
+        // Half of the keys share one value.
+        IndexStatistics stats;
+        for (int i = 0; i < 10000; ++i) {
+            stats.addKey(BSON("" << (i < 5000 ? 0 : i)));
+        }
+        Interval common(BSON("" << 0 << "" << 0), true, true);
+        ASSERT_APPROX_EQUAL(5000.0, stats.estimateKeys(common), 256.0);
+        Interval rare(BSON("" << 7000 << "" << 7000), true, true);
+        ASSERT_LESS_THAN(stats.estimateKeys(rare), 10.0);
+    }
+
+    TEST(IndexStatistics, EstimateBoundsUsesFirstField) {
+        IndexStatistics stats = buildUniform();
+
+        IndexBounds bounds;
+        OrderedIntervalList first("a");
+        first.intervals.push_back(Interval(BSON("" << 1 << "" << 1), true, true));
+        first.intervals.push_back(Interval(BSON("" << 2 << "" << 2), true, true));
+        bounds.fields.push_back(first);
+        OrderedIntervalList second("b");
+        second.intervals.push_back(Interval(BSON("" << 15 << "" << 15), true, true));
+        bounds.fields.push_back(second);
+        ASSERT_APPROX_EQUAL(20.0, stats.estimateKeys(bounds), 4.0);
+
+        IndexBounds simple;
+        simple.isSimpleRange = true;
+        simple.startKey = BSON("" << 0 << "" << 0);
+        simple.endKey = BSON("" << mongo::MAXKEY << "" << mongo::MAXKEY);
+        ASSERT_EQUALS(10000.0, stats.estimateKeys(simple));
+    }
+
+}  // namespace
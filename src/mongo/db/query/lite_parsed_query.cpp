@@ -281,6 +281,10 @@ namespace mongo {
             }
         }
 
+        if (_options.snapshotRead && _options.tailable) {
+            return Status(ErrorCodes::BadValue, "can't use snapshotRead with a tailable cursor");
+        }
+
         return Status::OK();
     }
 
@@ -434,6 +438,9 @@ namespace mongo {
         this->showDiskLoc = false;
         this->snapshot = false;
         this->hasReadPref = false;
+        this->allowDiskUse = false;
+        this->snapshotRead = false;
+        this->minOpTime = OpTime();
         this->tailable = false;
         this->slaveOk = false;
         this->oplogReplay = false;
@@ -543,6 +550,30 @@ namespace mongo {
 
                 out->snapshot = el.boolean();
             }
+            else if (mongoutils::str::equals(fieldName, "allowDiskUse")) {
+                Status status = checkFieldType(el, Bool);
+                if (!status.isOK()) {
+                    return status;
+                }
+
+                out->allowDiskUse = el.boolean();
+            }
+            else if (mongoutils::str::equals(fieldName, "snapshotRead")) {
+                Status status = checkFieldType(el, Bool);
+                if (!status.isOK()) {
+                    return status;
+                }
+
+                out->snapshotRead = el.boolean();
+            }
+            else if (mongoutils::str::equals(fieldName, "minOpTime")) {
+                Status status = checkFieldType(el, Timestamp);
+                if (!status.isOK()) {
+                    return status;
+                }
+
+                out->minOpTime = el._opTime();
+            }
             else if (mongoutils::str::equals(fieldName, "tailable")) {
                 Status status = checkFieldType(el, Bool);
                 if (!status.isOK()) {
@@ -758,6 +789,20 @@ namespace mongo {
                     // Won't throw.
                     _options.snapshot = e.trueValue();
                 }
+                else if (str::equals("allowDiskUse", name)) {
+                    // Won't throw.
+                    _options.allowDiskUse = e.trueValue();
+                }
+                else if (str::equals("snapshotRead", name)) {
+                    // Won't throw.
+                    _options.snapshotRead = e.trueValue();
+                }
+                else if (str::equals("minOpTime", name)) {
+                    if (e.type() != Timestamp) {
+                        return Status(ErrorCodes::BadValue, "$minOpTime must be a Timestamp");
+                    }
+                    _options.minOpTime = e._opTime();
+                }
                 else if (str::equals("min", name)) {
                     if (!e.isABSONObj()) {
                         return Status(ErrorCodes::BadValue, "$min must be a BSONObj");
@@ -97,6 +97,16 @@ namespace mongo {
             bool snapshot;
             bool hasReadPref;
 
+            // Lets a blocking sort spill to disk instead of failing at its memory limit.
+            bool allowDiskUse;
+
+            // Reads every batch from the snapshot the query started with.
+            bool snapshotRead;
+
+            // The query waits, briefly, until the node it runs on has applied this operation.
+            // Null when the query may read whatever the node has.
+            OpTime minOpTime;
+
             // Options that can be specified in the OP_QUERY 'flags' header.
             bool tailable;
             bool slaveOk;
@@ -191,6 +201,9 @@ namespace mongo {
         bool isSnapshot() const { return _options.snapshot; }
         bool returnKey() const { return _options.returnKey; }
         bool showDiskLoc() const { return _options.showDiskLoc; }
+        bool allowDiskUse() const { return _options.allowDiskUse; }
+        bool isSnapshotRead() const { return _options.snapshotRead; }
+        const OpTime& getMinOpTime() const { return _options.minOpTime; }
 
         const BSONObj& getMin() const { return _options.min; }
         const BSONObj& getMax() const { return _options.max; }
@@ -292,6 +292,22 @@ namespace {
         // Make sure the values from the command BSON are reflected in the LPQ.
         ASSERT(lpq->getOptions().showDiskLoc);
         ASSERT_EQUALS(1000, lpq->getMaxScan());
+        ASSERT_FALSE(lpq->allowDiskUse());
+    }
+
+    TEST(LiteParsedQueryTest, ParseFromCommandAllowDiskUse) {
+        BSONObj cmdObj = fromjson("{find: 'testns',"
+                                   "filter: {a: 3},"
+                                   "sort: {a: 1},"
+                                   "options: {allowDiskUse: true}}");
+
+        LiteParsedQuery* rawLpq;
+        bool isExplain = false;
+        Status status = LiteParsedQuery::make("testns", cmdObj, isExplain, &rawLpq);
+        ASSERT_OK(status);
+        scoped_ptr<LiteParsedQuery> lpq(rawLpq);
+
+        ASSERT(lpq->allowDiskUse());
     }
 
     TEST(LiteParsedQueryTest, ParseFromCommandHintAsString) {
@@ -584,6 +600,17 @@ namespace {
         ASSERT_NOT_OK(status);
     }
 
+    TEST(LiteParsedQueryTest, ParseFromCommandAllowDiskUseWrongType) {
+        BSONObj cmdObj = fromjson("{find: 'testns',"
+                                   "filter:  {a: 1},"
+                                   "options: {allowDiskUse: 3}}");
+
+        LiteParsedQuery* rawLpq;
+        bool isExplain = false;
+        Status status = LiteParsedQuery::make("testns", cmdObj, isExplain, &rawLpq);
+        ASSERT_NOT_OK(status);
+    }
+
     TEST(LiteParsedQueryTest, ParseFromCommandTailableWrongType) {
         BSONObj cmdObj = fromjson("{find: 'testns',"
                                    "filter:  {a: 1},"
@@ -734,6 +761,51 @@ namespace {
         ASSERT_NOT_OK(status);
     }
 
+    TEST(LiteParsedQueryTest, ParseFromCommandSnapshotRead) {
+        BSONObj cmdObj = fromjson("{find: 'testns',"
+                                   "filter:  {a: 1},"
+                                   "options: {snapshotRead: true}}");
+
+        LiteParsedQuery* rawLpq;
+        bool isExplain = false;
+        Status status = LiteParsedQuery::make("testns", cmdObj, isExplain, &rawLpq);
+        ASSERT_OK(status);
+        scoped_ptr<LiteParsedQuery> lpq(rawLpq);
+        ASSERT(lpq->isSnapshotRead());
+    }
+
+    TEST(LiteParsedQueryTest, ParseFromCommandMinOpTime) {
+        BSONObj cmdObj = BSON("find" << "testns" <<
+                              "options" << BSON("minOpTime" << OpTime(10, 2)));
+
+        LiteParsedQuery* rawLpq;
+        bool isExplain = false;
+        Status status = LiteParsedQuery::make("testns", cmdObj, isExplain, &rawLpq);
+        ASSERT_OK(status);
+        scoped_ptr<LiteParsedQuery> lpq(rawLpq);
+        ASSERT(OpTime(10, 2) == lpq->getMinOpTime());
+    }
+
+    TEST(LiteParsedQueryTest, ParseFromCommandMinOpTimeWrongType) {
+        BSONObj cmdObj = fromjson("{find: 'testns', options: {minOpTime: 3}}");
+
+        LiteParsedQuery* rawLpq;
+        bool isExplain = false;
+        Status status = LiteParsedQuery::make("testns", cmdObj, isExplain, &rawLpq);
+        ASSERT_NOT_OK(status);
+    }
+
+    TEST(LiteParsedQueryTest, ParseFromCommandSnapshotReadPlusTailableError) {
+        BSONObj cmdObj = fromjson("{find: 'testns',"
+                                   "filter:  {a: 1},"
+                                   "options: {snapshotRead: true, tailable: true}}");
+
+        LiteParsedQuery* rawLpq;
+        bool isExplain = false;
+        Status status = LiteParsedQuery::make("testns", cmdObj, isExplain, &rawLpq);
+        ASSERT_NOT_OK(status);
+    }
+
     TEST(LiteParsedQueryTest, ParseCommandForbidNonMetaSortOnFieldWithMetaProject) {
         Status status = Status::OK();
         BSONObj cmdObj;
@@ -36,14 +36,17 @@
 #include <math.h>
 #include <memory>
 #include "boost/thread/locks.hpp"
+#include <boost/functional/hash.hpp>
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/client/dbclientinterface.h"   // For QueryOption_foobar
 #include "mongo/db/query/plan_ranker.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/db/query/qlog.h"
 #include "mongo/db/query/query_knobs.h"
+#include "mongo/util/coarse_clock.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
@@ -135,7 +138,9 @@ namespace mongo {
     PlanCacheEntry::PlanCacheEntry(const std::vector<QuerySolution*>& solutions,
                                    PlanRankingDecision* why)
         : plannerData(solutions.size()),
-          decision(why) {
+          decision(why),
+          isStale(false),
+          replanStartedMillis(0) {
         invariant(why);
 
         // The caller of this constructor is responsible for ensuring
@@ -183,6 +188,8 @@ namespace mongo {
         }
         entry->averageScore = averageScore;
         entry->stddevScore = stddevScore;
+        entry->isStale = isStale;
+        entry->replanStartedMillis = replanStartedMillis;
         return entry;
     }
 
@@ -280,6 +287,12 @@ namespace mongo {
         case COLLSCAN_SOLN:
             ss << "(collection scan)";
             break;
+        case SKIP_IXSCAN_SOLN:
+            verify(this->tree.get());
+            ss << "(skip index scan solution: "
+               << "tree=" << this->tree->toString()
+               << ")";
+            break;
         case USE_INDEX_TAGS_SOLN:
             verify(this->tree.get());
             ss << "(index-tagged expression tree: "
@@ -293,12 +306,29 @@ namespace mongo {
     // PlanCache
     //
 
-    PlanCache::PlanCache() : _cache(internalQueryCacheSize) { }
+    PlanCache::PlanCache() {
+        _init();
+    }
 
-    PlanCache::PlanCache(const std::string& ns) : _cache(internalQueryCacheSize), _ns(ns) { }
+    PlanCache::PlanCache(const std::string& ns) : _ns(ns) {
+        _init();
+    }
 
     PlanCache::~PlanCache() { }
 
+    void PlanCache::_init() {
+        // Round up so the partitions together hold at least internalQueryCacheSize entries.
+        const size_t partitionSize =
+            (std::max(internalQueryCacheSize, 0) + kNumPartitions - 1) / kNumPartitions;
+        for (size_t i = 0; i < kNumPartitions; ++i) {
+            _partitions.push_back(new Partition(partitionSize));
+        }
+    }
+
+    PlanCache::Partition& PlanCache::_partitionFor(const PlanCacheKey& key) const {
+        return *_partitions[boost::hash<PlanCacheKey>()(key) % kNumPartitions];
+    }
+
     Status PlanCache::add(const CanonicalQuery& query,
                           const std::vector<QuerySolution*>& solns,
                           PlanRankingDecision* why) {
@@ -340,8 +370,10 @@ namespace mongo {
             }
         }
 
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        std::auto_ptr<PlanCacheEntry> evictedEntry = _cache.add(query.getPlanCacheKey(), entry);
+        Partition& partition = _partitionFor(query.getPlanCacheKey());
+        boost::lock_guard<boost::mutex> cacheLock(partition.mutex);
+        std::auto_ptr<PlanCacheEntry> evictedEntry =
+            partition.cache.add(query.getPlanCacheKey(), entry);
 
         if (NULL != evictedEntry.get()) {
             LOG(1) << _ns << ": plan cache maximum size exceeded - "
@@ -356,14 +388,26 @@ namespace mongo {
         const PlanCacheKey& key = query.getPlanCacheKey();
         verify(crOut);
 
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
+        Partition& partition = _partitionFor(key);
+        boost::lock_guard<boost::mutex> cacheLock(partition.mutex);
         PlanCacheEntry* entry;
-        Status cacheStatus = _cache.get(key, &entry);
+        Status cacheStatus = partition.cache.get(key, &entry);
         if (!cacheStatus.isOK()) {
             return cacheStatus;
         }
         invariant(entry);
 
+        if (entry->isStale) {
+            // Hand a miss to one query at a time so that it replans and replaces the entry. The
+            // lease covers a replanning query that dies or produces nothing cacheable.
+            const long long now = CoarseClock::wallMillis();
+            if (0 == entry->replanStartedMillis ||
+                now - entry->replanStartedMillis > internalQueryCacheReplanLeaseMillis) {
+                entry->replanStartedMillis = now;
+                return Status(ErrorCodes::NoSuchKey, "cached plan is stale, replanning");
+            }
+        }
+
         *crOut = new CachedSolution(key, *entry);
 
         return Status::OK();
@@ -427,21 +471,34 @@ namespace mongo {
         std::auto_ptr<PlanCacheEntryFeedback> autoFeedback(feedback);
         const PlanCacheKey& ck = cq.getPlanCacheKey();
 
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
+        Partition& partition = _partitionFor(ck);
+        boost::lock_guard<boost::mutex> cacheLock(partition.mutex);
         PlanCacheEntry* entry;
-        Status cacheStatus = _cache.get(ck, &entry);
+        Status cacheStatus = partition.cache.get(ck, &entry);
         if (!cacheStatus.isOK()) {
             return cacheStatus;
         }
         invariant(entry);
 
+        if (entry->isStale) {
+            // A replan is already due. The entry that replaces this one collects its own feedback.
+            return Status::OK();
+        }
+
         if (entry->feedback.size() >= size_t(internalQueryCacheFeedbacksStored)) {
             // If we have enough feedback, then use it to determine whether
             // we should get rid of the cached solution.
             if (hasCachedPlanPerformanceDegraded(entry, autoFeedback.get())) {
-                LOG(1) << _ns << ": removing plan cache entry " << entry->toString()
-                       << " - detected degradation in performance of cached solution.";
-                _cache.remove(ck);
+                if (internalQueryCacheServeStaleWhileReplanning) {
+                    LOG(1) << _ns << ": marking plan cache entry " << entry->toString()
+                           << " stale - detected degradation in performance of cached solution.";
+                    entry->isStale = true;
+                }
+                else {
+                    LOG(1) << _ns << ": removing plan cache entry " << entry->toString()
+                           << " - detected degradation in performance of cached solution.";
+                    partition.cache.remove(ck);
+                }
             }
         }
         else {
@@ -453,13 +510,16 @@ namespace mongo {
     }
 
     Status PlanCache::remove(const CanonicalQuery& canonicalQuery) {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        return _cache.remove(canonicalQuery.getPlanCacheKey());
+        Partition& partition = _partitionFor(canonicalQuery.getPlanCacheKey());
+        boost::lock_guard<boost::mutex> cacheLock(partition.mutex);
+        return partition.cache.remove(canonicalQuery.getPlanCacheKey());
     }
 
     void PlanCache::clear() {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        _cache.clear();
+        for (size_t i = 0; i < _partitions.size(); ++i) {
+            boost::lock_guard<boost::mutex> cacheLock(_partitions[i]->mutex);
+            _partitions[i]->cache.clear();
+        }
         _writeOperations.store(0);
     }
 
@@ -467,9 +527,10 @@ namespace mongo {
         const PlanCacheKey& key = query.getPlanCacheKey();
         verify(entryOut);
 
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
+        Partition& partition = _partitionFor(key);
+        boost::lock_guard<boost::mutex> cacheLock(partition.mutex);
         PlanCacheEntry* entry;
-        Status cacheStatus = _cache.get(key, &entry);
+        Status cacheStatus = partition.cache.get(key, &entry);
         if (!cacheStatus.isOK()) {
             return cacheStatus;
         }
@@ -481,25 +542,33 @@ namespace mongo {
     }
 
     std::vector<PlanCacheEntry*> PlanCache::getAllEntries() const {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
         std::vector<PlanCacheEntry*> entries;
         typedef std::list< std::pair<PlanCacheKey, PlanCacheEntry*> >::const_iterator ConstIterator;
-        for (ConstIterator i = _cache.begin(); i != _cache.end(); i++) {
-            PlanCacheEntry* entry = i->second;
-            entries.push_back(entry->clone());
+        for (size_t p = 0; p < _partitions.size(); ++p) {
+            const Partition& partition = *_partitions[p];
+            boost::lock_guard<boost::mutex> cacheLock(partition.mutex);
+            for (ConstIterator i = partition.cache.begin(); i != partition.cache.end(); i++) {
+                PlanCacheEntry* entry = i->second;
+                entries.push_back(entry->clone());
+            }
         }
 
         return entries;
     }
 
     bool PlanCache::contains(const CanonicalQuery& cq) const {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        return _cache.hasKey(cq.getPlanCacheKey());
+        const Partition& partition = _partitionFor(cq.getPlanCacheKey());
+        boost::lock_guard<boost::mutex> cacheLock(partition.mutex);
+        return partition.cache.hasKey(cq.getPlanCacheKey());
     }
 
     size_t PlanCache::size() const {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        return _cache.size();
+        size_t total = 0;
+        for (size_t i = 0; i < _partitions.size(); ++i) {
+            boost::lock_guard<boost::mutex> cacheLock(_partitions[i]->mutex);
+            total += _partitions[i]->cache.size();
+        }
+        return total;
     }
 
     void PlanCache::notifyOfWriteOp() {
@@ -32,6 +32,7 @@
 #include <boost/optional/optional.hpp>
 #include <boost/thread/mutex.hpp>
 
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/index_tag.h"
@@ -138,6 +139,7 @@ namespace mongo {
         // Owned here. If 'wholeIXSoln' is false, then 'tree'
         // can be used to tag an isomorphic match expression. If 'wholeIXSoln'
         // is true, then 'tree' is used to store the relevant IndexEntry.
+        // Likewise for a skip scan solution.
         // If 'collscanSoln' is true, then 'tree' should be NULL.
         scoped_ptr<PlanCacheIndexTree> tree;
 
@@ -150,6 +152,11 @@ namespace mongo {
             // The cached plan is a collection scan.
             COLLSCAN_SOLN,
 
+            // Indicates that the plan skip-scans the index
+            // stored in 'tree' because the query has no
+            // predicate over the index's first field.
+            SKIP_IXSCAN_SOLN,
+
             // Build the solution by using 'tree'
             // to tag the match expression.
             USE_INDEX_TAGS_SOLN
@@ -263,6 +270,15 @@ namespace mongo {
         // The standard deviation of the scores from stored as feedback.
         boost::optional<double> stddevScore;
 
+        // Set instead of evicting the entry when feedback shows the cached plan has degraded and
+        // internalQueryCacheServeStaleWhileReplanning is on. A stale entry keeps answering
+        // lookups until a query replans the shape and replaces it.
+        bool isStale;
+
+        // When a lookup last missed on this stale entry so that its query would replan, in
+        // milliseconds since the epoch. Zero if no replan has been started.
+        long long replanStartedMillis;
+
         // In order to justify eviction, the deviation from the mean must exceed a
         // minimum threshold.
         static const double kMinDeviation;
@@ -317,6 +333,10 @@ namespace mongo {
          *
          * If there is an entry in the cache, populates 'crOut' and returns Status::OK().  Caller
          * owns '*crOut'.
+         *
+         * If the entry is stale, the first lookup (and the first after the replan lease expires)
+         * gets an error Status so that its query replans and replaces the entry. Other lookups
+         * get the stale solution while that replan is in progress.
          */
         Status get(const CanonicalQuery& query, CachedSolution** crOut) const;
 
@@ -334,7 +354,8 @@ namespace mongo {
          * statistics about the plan.  Status::OK() is returned.
          *
          * May cause the cache entry to be removed if it is determined that the cached plan
-         * is badly performing.
+         * is badly performing, or marked stale if internalQueryCacheServeStaleWhileReplanning
+         * is set.
          */
         Status feedback(const CanonicalQuery& cq, PlanCacheEntryFeedback* feedback);
 
@@ -395,12 +416,29 @@ namespace mongo {
          */
         void _clear();
 
-        LRUKeyValue<PlanCacheKey, PlanCacheEntry> _cache;
-
         /**
-         * Protects _cache.
+         * The cache is split into partitions, each with its own LRU list and mutex, so that
+         * queries of different shapes do not contend on a single lock. A key always maps to the
+         * same partition, and least recently used entries are evicted per partition.
          */
-        mutable boost::mutex _cacheMutex;
+        struct Partition {
+            explicit Partition(size_t maxSize) : cache(maxSize) { }
+
+            LRUKeyValue<PlanCacheKey, PlanCacheEntry> cache;
+
+            /**
+             * Protects cache.
+             */
+            mutable boost::mutex mutex;
+        };
+
+        enum { kNumPartitions = 16 };
+
+        Partition& _partitionFor(const PlanCacheKey& key) const;
+
+        void _init();
+
+        OwnedPointerVector<Partition> _partitions;
 
         /**
          * Counter for write notifications since initialization or last clear() invocation.
@@ -0,0 +1,99 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/plan_cache.h"
+
+#include <memory>
+
+#include "mongo/db/query/plan_ranker.h"
+#include "mongo/db/query/query_solution.h"
+#include "mongo/unittest/benchmark.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace {
+
+    const char* const kNs = "bench.plan_cache";
+
+    CanonicalQuery* canonicalize(const BSONObj& query) {
+        CanonicalQuery* cq;
+        invariant(CanonicalQuery::canonicalize(kNs, query, &cq).isOK());
+        return cq;
+    }
+
+    // A query of shape number 'shape': an equality on field "a<shape>" and a range on "b".
+    BSONObj makeQuery(long long shape) {
+        return BSON(std::string(str::stream() << 'a' << shape) << 1 << "b" << BSON("$gt" << 2));
+    }
+
+    PlanRankingDecision* makeDecision() {
+        std::auto_ptr<PlanRankingDecision> why(new PlanRankingDecision());
+        CommonStats common("COLLSCAN");
+        std::auto_ptr<PlanStageStats> stats(new PlanStageStats(common, STAGE_COLLSCAN));
+        stats->specific.reset(new CollectionScanStats());
+        why->stats.mutableVector().push_back(stats.release());
+        why->scores.push_back(0U);
+        why->candidateOrder.push_back(0);
+        return why.release();
+    }
+
+    MONGO_BENCHMARK(CanonicalQueryCanonicalize) {
+        const BSONObj query = makeQuery(0);
+        while (state.keepRunning()) {
+            const std::auto_ptr<CanonicalQuery> cq(canonicalize(query));
+            state.doNotOptimize(cq->getPlanCacheKey().size());
+        }
+    }
+
+    // Looks up one of 'arg' cached query shapes.
+    MONGO_BENCHMARK_WITH_ARGS(PlanCacheGet, "1,100,1000") {
+        PlanCache planCache(kNs);
+        QuerySolution qs;
+        qs.cacheData.reset(new SolutionCacheData());
+        qs.cacheData->solnType = SolutionCacheData::COLLSCAN_SOLN;
+        qs.cacheData->tree.reset(new PlanCacheIndexTree());
+        std::vector<QuerySolution*> solns;
+        solns.push_back(&qs);
+
+        for (long long i = 0; i < state.arg(); i++) {
+            const std::auto_ptr<CanonicalQuery> cq(canonicalize(makeQuery(i)));
+            invariant(planCache.add(*cq, solns, makeDecision()).isOK());
+        }
+
+        const std::auto_ptr<CanonicalQuery> cq(canonicalize(makeQuery(state.arg() / 2)));
+        while (state.keepRunning()) {
+            CachedSolution* cached;
+            invariant(planCache.get(*cq, &cached).isOK());
+            delete cached;
+        }
+    }
+
+}  // namespace
+}  // namespace mongo
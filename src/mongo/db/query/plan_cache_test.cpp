@@ -45,6 +45,7 @@
 #include "mongo/db/query/query_solution.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
 
 using namespace mongo;
 
@@ -379,6 +380,86 @@ namespace {
         ASSERT_EQUALS(planCache.size(), 1U);
     }
 
+    // Entries for many distinct query shapes are spread over the cache's partitions; size(),
+    // getAllEntries() and clear() must still see all of them.
+    TEST(PlanCacheTest, AddManyShapes) {
+        PlanCache planCache;
+        QuerySolution qs;
+        qs.cacheData.reset(new SolutionCacheData());
+        qs.cacheData->tree.reset(new PlanCacheIndexTree());
+        std::vector<QuerySolution*> solns;
+        solns.push_back(&qs);
+
+        const size_t numShapes = 50;
+        OwnedPointerVector<CanonicalQuery> queries;
+        for (size_t i = 0; i < numShapes; ++i) {
+            const std::string field = mongoutils::str::stream() << "a" << i;
+            queries.push_back(canonicalize(BSON(field << 1)));
+            ASSERT_OK(planCache.add(*queries[i], solns, createDecision(1U)));
+        }
+
+        ASSERT_EQUALS(planCache.size(), numShapes);
+        for (size_t i = 0; i < numShapes; ++i) {
+            ASSERT_TRUE(planCache.contains(*queries[i]));
+        }
+
+        OwnedPointerVector<PlanCacheEntry> entries;
+        entries.mutableVector() = planCache.getAllEntries();
+        ASSERT_EQUALS(entries.size(), numShapes);
+
+        ASSERT_OK(planCache.remove(*queries[0]));
+        ASSERT_FALSE(planCache.contains(*queries[0]));
+        ASSERT_EQUALS(planCache.size(), numShapes - 1);
+
+        planCache.clear();
+        ASSERT_EQUALS(planCache.size(), 0U);
+    }
+
+    PlanCacheEntryFeedback* createFeedback(double score) {
+        PlanCacheEntryFeedback* feedback = new PlanCacheEntryFeedback();
+        feedback->stats.reset(new PlanStageStats(CommonStats("COLLSCAN"), STAGE_COLLSCAN));
+        feedback->score = score;
+        return feedback;
+    }
+
+    // With internalQueryCacheServeStaleWhileReplanning set, a degraded entry stays in the cache.
+    // Only one lookup misses so that it replans, and the rest keep using the stale plan.
+    TEST(PlanCacheTest, ServeStaleWhileReplanning) {
+        const bool oldServeStale = internalQueryCacheServeStaleWhileReplanning;
+        internalQueryCacheServeStaleWhileReplanning = true;
+
+        PlanCache planCache;
+        auto_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+        QuerySolution qs;
+        qs.cacheData.reset(new SolutionCacheData());
+        qs.cacheData->tree.reset(new PlanCacheIndexTree());
+        std::vector<QuerySolution*> solns;
+        solns.push_back(&qs);
+        ASSERT_OK(planCache.add(*cq, solns, createDecision(1U)));
+
+        for (int i = 0; i < internalQueryCacheFeedbacksStored; ++i) {
+            ASSERT_OK(planCache.feedback(*cq, createFeedback(1.0)));
+        }
+
+        // A much worse run marks the entry stale rather than evicting it.
+        ASSERT_OK(planCache.feedback(*cq, createFeedback(0.0)));
+        ASSERT_TRUE(planCache.contains(*cq));
+
+        CachedSolution* rawCS;
+        ASSERT_NOT_OK(planCache.get(*cq, &rawCS));
+        ASSERT_OK(planCache.get(*cq, &rawCS));
+        delete rawCS;
+
+        // The replan's add() replaces the stale entry.
+        ASSERT_OK(planCache.add(*cq, solns, createDecision(1U)));
+        ASSERT_OK(planCache.get(*cq, &rawCS));
+        delete rawCS;
+        ASSERT_OK(planCache.get(*cq, &rawCS));
+        delete rawCS;
+
+        internalQueryCacheServeStaleWhileReplanning = oldServeStale;
+    }
+
     TEST(PlanCacheTest, NotifyOfWriteOp) {
         PlanCache planCache;
         auto_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
@@ -37,6 +37,7 @@
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/query/plan_yield_policy.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/storage/record_fetcher.h"
 
 #include "mongo/util/stacktrace.h"
@@ -65,6 +66,24 @@ namespace mongo {
             return NULL;
         }
 
+        /**
+         * Returns true if every stage in the tree rooted at 'root' implements workBatch().
+         */
+        bool supportsBatch(PlanStage* root) {
+            if (!root->supportsBatch()) {
+                return false;
+            }
+
+            vector<PlanStage*> children = root->getChildren();
+            for (size_t i = 0; i < children.size(); i++) {
+                if (!supportsBatch(children[i])) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
     }
 
     // static
@@ -146,7 +165,11 @@ namespace mongo {
           _qs(qs),
           _root(rt),
           _ns(ns),
-          _killed(false) {
+          _killed(false),
+          _batchMode(internalQueryExecBatchWorks > 1 && supportsBatch(rt)),
+          _batchPos(0),
+          _batchEndState(PlanStage::NEED_TIME),
+          _batchEndId(WorkingSet::INVALID_ID) {
         // We may still need to initialize _ns from either _collection or _cq.
         if (!_ns.empty()) {
             // We already have an _ns set, so there's nothing more to do.
@@ -231,6 +254,15 @@ namespace mongo {
     }
 
     void PlanExecutor::saveState() {
+        if (PlanStage::NEED_FETCH == _batchEndState) {
+            // The page-in request that ended the last batch may be stale by the time we resume.
+            // Drop it; the stage that made it checks again when it is next worked.
+            WorkingSetMember* member = _workingSet->get(_batchEndId);
+            boost::scoped_ptr<RecordFetcher> fetcher(member->releaseFetcher());
+            _batchEndState = PlanStage::NEED_TIME;
+            _batchEndId = WorkingSet::INVALID_ID;
+        }
+
         if (!_killed) {
             _root->saveState();
         }
@@ -252,7 +284,38 @@ namespace mongo {
     }
 
     void PlanExecutor::invalidate(OperationContext* txn, const RecordId& dl, InvalidationType type) {
-        if (!_killed) { _root->invalidate(txn, dl, type); }
+        if (_killed) { return; }
+
+        _root->invalidate(txn, dl, type);
+
+        // Buffered results from the last batch may refer to 'dl' as well.
+        for (size_t i = _batchPos; i < _batchResults.size(); ++i) {
+            if (WorkingSet::INVALID_ID == _batchResults[i]) {
+                continue;
+            }
+            WorkingSetMember* member = _workingSet->get(_batchResults[i]);
+            if (member->hasLoc() && member->loc == dl) {
+                WorkingSetCommon::fetchAndInvalidateLoc(txn, member, _collection);
+            }
+        }
+    }
+
+    PlanStage::StageState PlanExecutor::workBatch(WorkingSetID* id) {
+        _batchResults.clear();
+        _batchPos = 0;
+
+        PlanStage::StageState code = _root->workBatch(internalQueryExecBatchWorks,
+                                                      &_batchResults,
+                                                      id);
+        if (_batchResults.empty()) {
+            return code;
+        }
+
+        _batchEndState = code;
+        _batchEndId = *id;
+
+        *id = _batchResults[_batchPos++];
+        return PlanStage::ADVANCED;
     }
 
     PlanExecutor::ExecState PlanExecutor::getNext(BSONObj* objOut, RecordId* dlOut) {
@@ -265,27 +328,43 @@ namespace mongo {
         boost::scoped_ptr<RecordFetcher> fetcher;
 
         for (;;) {
-            // There are two conditions which cause us to yield if we have an YIELD_AUTO
-            // policy:
-            //   1) The yield policy's timer elapsed, or
-            //   2) some stage requested a yield due to a document fetch (NEED_FETCH).
-            // In both cases, the actual yielding happens here.
-            if (NULL != _yieldPolicy.get() && (_yieldPolicy->shouldYield()
-                                               || NULL != fetcher.get())) {
-                // Here's where we yield.
-                _yieldPolicy->yield(fetcher.get());
-
-                if (_killed) {
-                    return PlanExecutor::DEAD;
-                }
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState code;
+
+            if (_batchPos < _batchResults.size()) {
+                // Return what is left of the last batch before working the tree again.
+                id = _batchResults[_batchPos++];
+                code = PlanStage::ADVANCED;
+            }
+            else if (PlanStage::NEED_TIME != _batchEndState) {
+                // Then act on whatever ended the batch.
+                id = _batchEndId;
+                code = _batchEndState;
+                _batchEndState = PlanStage::NEED_TIME;
+                _batchEndId = WorkingSet::INVALID_ID;
             }
+            else {
+                // There are two conditions which cause us to yield if we have an YIELD_AUTO
+                // policy:
+                //   1) The yield policy's timer elapsed, or
+                //   2) some stage requested a yield due to a document fetch (NEED_FETCH).
+                // In both cases, the actual yielding happens here.
+                if (NULL != _yieldPolicy.get() && (_yieldPolicy->shouldYield()
+                                                   || NULL != fetcher.get())) {
+                    // Here's where we yield.
+                    _yieldPolicy->yield(fetcher.get());
+
+                    if (_killed) {
+                        return PlanExecutor::DEAD;
+                    }
+                }
 
-            // We're done using the fetcher, so it should be freed. We don't want to
-            // use the same RecordFetcher twice.
-            fetcher.reset();
+                // We're done using the fetcher, so it should be freed. We don't want to
+                // use the same RecordFetcher twice.
+                fetcher.reset();
 
-            WorkingSetID id = WorkingSet::INVALID_ID;
-            PlanStage::StageState code = _root->work(&id);
+                code = _batchMode ? workBatch(&id) : _root->work(&id);
+            }
 
             if (PlanStage::ADVANCED == code) {
                 // Fast count.
@@ -361,6 +440,9 @@ namespace mongo {
     }
 
     bool PlanExecutor::isEOF() {
+        if (_batchPos < _batchResults.size() || PlanStage::NEED_TIME != _batchEndState) {
+            return _killed;
+        }
         return _killed || _root->isEOF();
     }
 
@@ -29,8 +29,10 @@
 #pragma once
 
 #include <boost/scoped_ptr.hpp>
+#include <vector>
 
 #include "mongo/base/status.h"
+#include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/invalidation_type.h"
 #include "mongo/db/query/query_solution.h"
 
@@ -372,6 +374,14 @@ namespace mongo {
          */
         Status pickBestPlan(YieldPolicy policy);
 
+        /**
+         * Asks the root stage for a batch of results with PlanStage::workBatch(). Returns the
+         * first result of the batch as ADVANCED and keeps the rest, along with the state which
+         * ended the batch, for subsequent calls to getNext(). If the batch has no results, the
+         * state which ended it is returned directly.
+         */
+        PlanStage::StageState workBatch(WorkingSetID* id);
+
         // The OperationContext that we're executing within.  We need this in order to release
         // locks.
         OperationContext* _opCtx;
@@ -395,6 +405,19 @@ namespace mongo {
         // we'll be killed.
         bool _killed;
 
+        // True if every stage in the tree supports batched execution, in which case getNext()
+        // works the tree with workBatch() rather than work().
+        const bool _batchMode;
+
+        // Results of the last batch; those from '_batchPos' on have not been returned yet.
+        std::vector<WorkingSetID> _batchResults;
+        size_t _batchPos;
+
+        // The state (and the id that came with it) which ended the last batch. It is acted on
+        // once the buffered results have been returned. NEED_TIME if there is no such state.
+        PlanStage::StageState _batchEndState;
+        WorkingSetID _batchEndId;
+
         // If the yield policy is YIELD_AUTO, this is used to enforce automatic yielding. The plan
         // may yield on any call to getNext() if this is non-NULL.
         boost::scoped_ptr<PlanYieldPolicy> _yieldPolicy;
@@ -39,10 +39,20 @@ namespace mongo {
 
     PlanYieldPolicy::PlanYieldPolicy(PlanExecutor* exec)
         : _elapsedTracker(internalQueryExecYieldIterations, internalQueryExecYieldPeriodMS),
+          _checksSinceContentionProbe(0),
           _planYielding(exec) { }
 
     bool PlanYieldPolicy::shouldYield() {
         invariant(!_planYielding->getOpCtx()->lockState()->inAWriteUnitOfWork());
+
+        if (internalQueryExecYieldOnContention && !supportsDocLocking() &&
+                ++_checksSinceContentionProbe >= internalQueryExecYieldContentionCheckIterations) {
+            _checksSinceContentionProbe = 0;
+            if (_contended()) {
+                return true;
+            }
+        }
+
         return _elapsedTracker.intervalHasElapsed();
     }
 
@@ -68,6 +78,13 @@ namespace mongo {
             return true;
         }
 
+        // Nobody is waiting for our locks, so releasing them would only cost us the save and
+        // restore. A fetch still yields, so that the page fault happens without locks.
+        if (internalQueryExecYieldOnContention && NULL == fetcher && !_contended()) {
+            _elapsedTracker.resetLastTime();
+            return true;
+        }
+
         _planYielding->saveState();
 
         // Release and reacquire locks.
@@ -78,4 +95,8 @@ namespace mongo {
         return _planYielding->restoreState(opCtx);
     }
 
+    bool PlanYieldPolicy::_contended() const {
+        return _planYielding->getOpCtx()->lockState()->hasConflictingWaiters();
+    }
+
 } // namespace mongo
@@ -44,6 +44,10 @@ namespace mongo {
          * Used by YIELD_AUTO plan executors in order to check whether it is time to yield.
          * PlanExecutors give up their locks periodically in order to be fair to other
          * threads.
+         *
+         * With internalQueryExecYieldOnContention, this also returns true as soon as another
+         * operation is found queued behind one of the executor's locks, and the periodic yields
+         * only check for interruption unless someone is waiting.
          */
         bool shouldYield();
 
@@ -64,8 +68,16 @@ namespace mongo {
         // Default constructor disallowed in order to ensure initialization of '_planYielding'.
         PlanYieldPolicy();
 
+        /**
+         * Returns true if giving up the locks would let another operation in.
+         */
+        bool _contended() const;
+
         ElapsedTracker _elapsedTracker;
 
+        // "Should yield?" checks since the lock manager was last asked about waiters.
+        int _checksSinceContentionProbe;
+
         // The plan executor which this yield policy is responsible for yielding. Must
         // not outlive the plan executor.
         PlanExecutor* _planYielding;
@@ -39,6 +39,7 @@
 #include "mongo/db/query/indexability.h"
 #include "mongo/db/query/index_bounds_builder.h"
 #include "mongo/db/query/index_tag.h"
+#include "mongo/db/query/planner_ixselect.h"
 #include "mongo/db/query/qlog.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
@@ -883,27 +884,37 @@ namespace mongo {
                 asn->children.swap(ixscanNodes);
                 andResult = asn;
             }
-            else if (internalQueryPlannerEnableHashIntersection) {
-                AndHashNode* ahn = new AndHashNode();
-                ahn->children.swap(ixscanNodes);
-                andResult = ahn;
-                // The AndHashNode provides the sort order of its last child.  If any of the
-                // possible subnodes of AndHashNode provides the sort order we care about, we put
-                // that one last.
-                for (size_t i = 0; i < ahn->children.size(); ++i) {
-                    ahn->children[i]->computeProperties();
-                    const BSONObjSet& sorts = ahn->children[i]->getSort();
+            else if (internalQueryPlannerEnableHashIntersection
+                     || internalQueryPlannerEnableBitmapIntersection) {
+                // Both the AndHashNode and the AndBitmapNode provide the sort order of their last
+                // child.  If any of the possible subnodes provides the sort order we care about,
+                // we put that one last.
+                for (size_t i = 0; i < ixscanNodes.size(); ++i) {
+                    ixscanNodes[i]->computeProperties();
+                    const BSONObjSet& sorts = ixscanNodes[i]->getSort();
                     if (sorts.end() != sorts.find(query.getParsed().getSort())) {
-                        std::swap(ahn->children[i], ahn->children.back());
+                        std::swap(ixscanNodes[i], ixscanNodes.back());
                         break;
                     }
                 }
+
+                if (internalQueryPlannerEnableHashIntersection) {
+                    AndHashNode* ahn = new AndHashNode();
+                    ahn->children.swap(ixscanNodes);
+                    andResult = ahn;
+                }
+                else {
+                    AndBitmapNode* abn = new AndBitmapNode();
+                    abn->children.swap(ixscanNodes);
+                    andResult = abn;
+                }
             }
             else {
-                // We can't use sort-based intersection, and hash-based intersection is disabled.
-                // Clean up the index scans and bail out by returning NULL.
+                // We can't use sort-based intersection, and both hash-based and bitmap-based
+                // intersection are disabled.  Clean up the index scans and bail out by returning
+                // NULL.
                 QLOG() << "Can't build index intersection solution: "
-                       << "AND_SORTED is not possible and AND_HASH is disabled.";
+                       << "AND_SORTED is not possible and AND_HASH and AND_BITMAP are disabled.";
 
                 for (size_t i = 0; i < ixscanNodes.size(); i++) {
                     delete ixscanNodes[i];
@@ -1018,6 +1029,17 @@ namespace mongo {
             }
             else {
                 OrNode* orn = new OrNode();
+                if (internalQueryPlannerEnableOrMergeByRecordId) {
+                    // Point scans produce RecordIds in order, so they can be merged and deduped
+                    // without remembering what has been returned.
+                    orn->mergeByRecordId = true;
+                    for (size_t i = 0; i < ixscanNodes.size(); ++i) {
+                        if (!ixscanNodes[i]->sortedByDiskLoc()) {
+                            orn->mergeByRecordId = false;
+                            break;
+                        }
+                    }
+                }
                 orn->children.swap(ixscanNodes);
                 orResult = orn;
             }
@@ -1175,6 +1197,91 @@ namespace mongo {
         return solnRoot;
     }
 
+    // static
+    QuerySolutionNode* QueryPlannerAccess::skipScanIndex(const IndexEntry& index,
+                                                         const CanonicalQuery& query,
+                                                         const QueryPlannerParams& params) {
+        // Only a btree index with at least two fields can be skip-scanned.
+        if (INDEX_BTREE != index.type || index.keyPattern.nFields() < 2) {
+            return NULL;
+        }
+
+        // The predicates we can build bounds from are the top-level leaves of the query.
+        MatchExpression* root = query.root();
+        vector<MatchExpression*> preds;
+        if (MatchExpression::AND == root->matchType()) {
+            for (size_t i = 0; i < root->numChildren(); ++i) {
+                preds.push_back(root->getChild(i));
+            }
+        }
+        else {
+            preds.push_back(root);
+        }
+
+        auto_ptr<IndexScanNode> isn(new IndexScanNode());
+        isn->indexKeyPattern = index.keyPattern;
+        isn->indexIsMultiKey = index.multikey;
+        isn->maxScan = query.getParsed().getMaxScan();
+        isn->addKeyMetadata = query.getParsed().returnKey();
+        isn->bounds.fields.resize(index.keyPattern.nFields());
+
+        bool hasBoundedField = false;
+        size_t pos = 0;
+        BSONObjIterator it(index.keyPattern);
+        while (it.more()) {
+            BSONElement keyElt = it.next();
+            OrderedIntervalList* oil = &isn->bounds.fields[pos];
+            oil->name = keyElt.fieldName();
+
+            bool boundsSet = false;
+            for (size_t i = 0; i < preds.size(); ++i) {
+                MatchExpression* pred = preds[i];
+                if (!pred->isLeaf() || pred->path() != keyElt.fieldName()
+                    || !QueryPlannerIXSelect::compatible(keyElt, index, pred)) {
+                    continue;
+                }
+
+                if (0 == pos) {
+                    // The regular planner already uses this index for the query.
+                    return NULL;
+                }
+
+                // We filter the whole query after the fetch, so the tightness doesn't matter.
+                IndexBoundsBuilder::BoundsTightness tightness;
+                if (!boundsSet) {
+                    IndexBoundsBuilder::translate(pred, keyElt, index, oil, &tightness);
+                    boundsSet = true;
+                }
+                else if (!index.multikey) {
+                    // Predicates over a multikey field may be satisfied by different array
+                    // elements, so their bounds can't be intersected.
+                    IndexBoundsBuilder::translateAndIntersect(pred, keyElt, index, oil,
+                                                              &tightness);
+                }
+            }
+
+            if (boundsSet) {
+                hasBoundedField = true;
+            }
+            else {
+                IndexBoundsBuilder::allValuesForField(keyElt, oil);
+            }
+            ++pos;
+        }
+
+        if (!hasBoundedField) {
+            return NULL;
+        }
+
+        // The bounds were built assuming a forward direction on every field.
+        IndexBoundsBuilder::alignBounds(&isn->bounds, index.keyPattern);
+
+        FetchNode* fetch = new FetchNode();
+        fetch->filter.reset(root->shallowClone());
+        fetch->children.push_back(isn.release());
+        return fetch;
+    }
+
     // static
     void QueryPlannerAccess::addFilterToSolutionNode(QuerySolutionNode* node,
                                                      MatchExpression* match,
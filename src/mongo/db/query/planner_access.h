@@ -203,6 +203,20 @@ namespace mongo {
                                                  const QueryPlannerParams& params,
                                                  int direction = 1);
 
+        /**
+         * Return a plan that skip-scans the provided compound index for a query with no usable
+         * predicate over the index's first field, or NULL if the query has no usable predicate
+         * over any of its later fields either.
+         *
+         * The leading fields get all-values bounds and the fields with top-level predicates get
+         * bounds from those predicates, so the index scan seeks past each distinct prefix to the
+         * keys that can match rather than examining every key.  The whole query is applied as a
+         * filter after fetching.
+         */
+        static QuerySolutionNode* skipScanIndex(const IndexEntry& index,
+                                                const CanonicalQuery& query,
+                                                const QueryPlannerParams& params);
+
         /**
          * Return a plan that scans the provided index from [startKey to endKey).
          */
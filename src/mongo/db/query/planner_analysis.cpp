@@ -455,9 +455,11 @@ namespace mongo {
         }
 
         // And build the full sort stage.
+        QuerySolutionNode* sortChild = solnRoot;
         SortNode* sort = new SortNode();
         sort->pattern = sortObj;
         sort->query = query.getParsed().getFilter();
+        sort->allowDiskUse = query.getParsed().allowDiskUse();
         sort->children.push_back(solnRoot);
         solnRoot = sort;
         // When setting the limit on the sort, we need to consider both
@@ -470,6 +472,15 @@ namespace mongo {
             sort->limit = size_t(query.getParsed().getNumToReturn()) +
                           size_t(query.getParsed().getSkip());
 
+            // A text node sorted by nothing but its score only has to produce the top results,
+            // which it can do without reading every posting.  This relies on nothing between the
+            // text node and the sort dropping results, and on the SPLIT_LIMITED_SORT hack below
+            // never applying to text.
+            if (STAGE_TEXT == sortChild->getType() && 1 == sortObj.nFields()
+                && LiteParsedQuery::isTextScoreMeta(sortObj.firstElement())) {
+                static_cast<TextNode*>(sortChild)->limit = sort->limit;
+            }
+
             // This is a SORT with a limit. The wire protocol has a single quantity
             // called "numToReturn" which could mean either limit or batchSize.
             // We have no idea what the client intended. One way to handle the ambiguity
@@ -517,6 +528,17 @@ namespace mongo {
         return solnRoot;
     }
 
+    // Returns true if 'node' provides every field of 'keyPattern' without fetching.
+    static bool providesAllFields(const QuerySolutionNode* node, const BSONObj& keyPattern) {
+        BSONObjIterator it(keyPattern);
+        while (it.more()) {
+            if (!node->hasField(it.next().fieldName())) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     // static
     QuerySolution* QueryPlannerAnalysis::analyzeDataAccess(const CanonicalQuery& query,
                                                            const QueryPlannerParams& params,
@@ -534,31 +556,28 @@ namespace mongo {
         // logically part of our shard.
         if (params.options & QueryPlannerParams::INCLUDE_SHARD_FILTER) {
 
-            if (!solnRoot->fetched()) {
-
-                // See if we need to fetch information for our shard key.
-                // NOTE: Solution nodes only list ordinary, non-transformed index keys for now
-
-                bool fetch = false;
-                BSONObjIterator it(params.shardKey);
-                while (it.more()) {
-                    BSONElement nextEl = it.next();
-                    if (!solnRoot->hasField(nextEl.fieldName())) {
-                        fetch = true;
-                        break;
-                    }
-                }
-
-                if (fetch) {
-                    FetchNode* fetch = new FetchNode();
-                    fetch->children.push_back(solnRoot);
-                    solnRoot = fetch;
-                }
+            // See if we need to fetch information for our shard key.
+            // NOTE: Solution nodes only list ordinary, non-transformed index keys for now
+            if (!solnRoot->fetched() && !providesAllFields(solnRoot, params.shardKey)) {
+                FetchNode* fetch = new FetchNode();
+                fetch->children.push_back(solnRoot);
+                solnRoot = fetch;
             }
 
             ShardingFilterNode* sfn = new ShardingFilterNode();
-            sfn->children.push_back(solnRoot);
-            solnRoot = sfn;
+            if (STAGE_FETCH == solnRoot->getType()
+                && !solnRoot->children[0]->fetched()
+                && providesAllFields(solnRoot->children[0], params.shardKey)) {
+
+                // The index keys under the fetch hold the shard key, so filter on them and never
+                // fetch documents which aren't ours.
+                sfn->children.push_back(solnRoot->children[0]);
+                solnRoot->children[0] = sfn;
+            }
+            else {
+                sfn->children.push_back(solnRoot);
+                solnRoot = sfn;
+            }
         }
 
         bool hasSortStage = false;
@@ -568,8 +587,9 @@ namespace mongo {
         if (NULL == solnRoot) { return NULL; }
 
         // A solution can be blocking if it has a blocking sort stage or
-        // a hashed AND stage.
-        bool hasAndHashStage = hasNode(solnRoot, STAGE_AND_HASH);
+        // a hashed or bitmap AND stage.
+        bool hasAndHashStage = hasNode(solnRoot, STAGE_AND_HASH)
+                               || hasNode(solnRoot, STAGE_AND_BITMAP);
         soln->hasBlockingStage = hasSortStage || hasAndHashStage;
 
         // If we can (and should), add the keep mutations stage.
@@ -46,6 +46,10 @@ namespace mongo {
 
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheWriteOpsBetweenFlush, int, 1000);
 
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheServeStaleWhileReplanning, bool, false);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheReplanLeaseMillis, int, 10 * 1000);
+
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerMaxIndexedSolutions, int, 64);
 
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryEnumerationMaxOrSolutions, int, 10);
@@ -58,14 +62,42 @@ namespace mongo {
 
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerEnableHashIntersection, bool, false);
 
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerEnableBitmapIntersection, bool, true);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerEnableOrMergeByRecordId, bool, true);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerEnableSkipScan, bool, true);
+
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanOrChildrenIndependently, bool, true);
 
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryMaxScansToExplode, int, 200);
 
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerStatisticsPruneRatio, double, 10.0);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerStatisticsMaxWriteFraction, double, 0.2);
+
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecMaxBlockingSortBytes, int, 32 * 1024 * 1024);
 
     // Yield every 128 cycles or 10ms.
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldIterations, int, 128);
     MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldPeriodMS, int, 10);
 
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldOnContention, bool, true);
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecYieldContentionCheckIterations, int, 16);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryGroupNativeReduce, bool, true);
+
+    // Each batch counts as a single cycle for the yield check above.
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecBatchWorks, int, 32);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecFetchPrefetch, bool, true);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQuerySnapshotReadMaxSecs, int, 300);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecDeleteBatchSize, int, 64);
+
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(internalQueryExecParallelCountThreads, int, 0);
+
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryReplicationGetMoreMaxBytes, int, 16 * 1024 * 1024);
+
 }  // namespace mongo
@@ -54,6 +54,16 @@ namespace mongo {
     // Do we use hash-based intersection for rooted $and queries?
     extern bool internalQueryPlannerEnableHashIntersection;
 
+    // Do we use bitmap-based intersection for rooted $and queries when hash-based intersection
+    // is off?
+    extern bool internalQueryPlannerEnableBitmapIntersection;
+
+    // Do we merge the children of an OR by RecordId when they all produce RecordIds in order?
+    extern bool internalQueryPlannerEnableOrMergeByRecordId;
+
+    // Do we consider skip scans of compound indices whose first field has no predicate?
+    extern bool internalQueryPlannerEnableSkipScan;
+
     //
     // plan cache
     //
@@ -72,6 +82,15 @@ namespace mongo {
     // How many write ops should we allow in a collection before tossing all cache entries?
     extern int internalQueryCacheWriteOpsBetweenFlush;
 
+    // If true, a cache entry whose plan has degraded is kept and marked stale instead of being
+    // evicted. One query at a time replans the stale shape while the others keep running the
+    // stale plan, so a replan does not stall every query of that shape.
+    extern bool internalQueryCacheServeStaleWhileReplanning;
+
+    // How long can a query hold the right to replan a stale cache entry before another query of
+    // the same shape may try instead?
+    extern int internalQueryCacheReplanLeaseMillis;
+
     //
     // Planning and enumeration.
     //
@@ -92,6 +111,15 @@ namespace mongo {
     // during explodeForSort?
     extern int internalQueryMaxScansToExplode;
 
+    // When every candidate plan can be costed from index statistics gathered by 'analyze', drop
+    // the candidates estimated to examine more than this many times as many keys or documents as
+    // the cheapest before trial execution. Zero or less disables pruning.
+    extern double internalQueryPlannerStatisticsPruneRatio;
+
+    // Statistics are ignored once the collection has seen more writes since 'analyze' than
+    // this fraction of the documents it had then.
+    extern double internalQueryPlannerStatisticsMaxWriteFraction;
+
     //
     // Query execution.
     //
@@ -106,4 +134,41 @@ namespace mongo {
     // to storage engines that do not support doc-level locking.
     extern int internalQueryExecYieldPeriodMS;
 
+    // When set, the periodic yield above only gives locks up if some other operation is queued
+    // for them, and a query checks for such waiters every
+    // internalQueryExecYieldContentionCheckIterations "should yield?" checks, yielding at once
+    // when it finds any. Only applies to storage engines that do not support doc-level locking.
+    extern bool internalQueryExecYieldOnContention;
+    extern int internalQueryExecYieldContentionCheckIterations;
+
+    // Whether the group command runs the reduce functions NativeGroupReducer recognizes without
+    // JavaScript.
+    extern bool internalQueryGroupNativeReduce;
+
+    // How many units of work the PlanExecutor asks for at a time when every stage in the plan
+    // supports batched execution. Zero or one disables batching.
+    extern int internalQueryExecBatchWorks;
+
+    // When a batched FETCH has to page in a document, ask the storage engine to start reading
+    // the documents for the rest of the batch too, so that their I/O overlaps.
+    extern bool internalQueryExecFetchPrefetch;
+
+    // How long a snapshotRead query or aggregation may keep reading from the snapshot it started
+    // with. Its cursor fails the first getMore after that.
+    extern int internalQuerySnapshotReadMaxSecs;
+
+    // Maximum number of documents a multi-delete removes in one storage transaction. Each batch
+    // saves and restores the plan once. One disables batching.
+    extern int internalQueryExecDeleteBatchSize;
+
+    // Number of threads the count command may use to scan a large collection whose record
+    // store splits into several iterators. Zero or one disables parallel counting.
+    extern int internalQueryExecParallelCountThreads;
+
+    // Byte limit of a getMore batch on the cursors replication streams data through: oplog
+    // replay cursors, which secondaries tail the oplog with, and exhaust cursors, which initial
+    // sync clones collections with. Larger than the usual limit to save round trips and to
+    // compress better.
+    extern int internalQueryReplicationGetMoreMaxBytes;
+
 }  // namespace mongo
@@ -99,6 +99,12 @@ namespace mongo {
         if (options & QueryPlannerParams::KEEP_MUTATIONS) {
             ss << "KEEP_MUTATIONS";
         }
+        if (options & QueryPlannerParams::COVERED_WHOLE_IXSCAN) {
+            ss << "COVERED_WHOLE_IXSCAN ";
+        }
+        if (options & QueryPlannerParams::BORROW_RECORDS) {
+            ss << "BORROW_RECORDS ";
+        }
 
         return ss;
     }
@@ -231,6 +237,28 @@ namespace mongo {
         return QueryPlannerAnalysis::analyzeDataAccess(query, params, solnRoot);
     }
 
+    QuerySolution* buildSkipScanSoln(const IndexEntry& index,
+                                     const CanonicalQuery& query,
+                                     const QueryPlannerParams& params) {
+        QuerySolutionNode* solnRoot = QueryPlannerAccess::skipScanIndex(index, query, params);
+        if (NULL == solnRoot) {
+            return NULL;
+        }
+        return QueryPlannerAnalysis::analyzeDataAccess(query, params, solnRoot);
+    }
+
+    static bool hasFetch(const QuerySolutionNode* node) {
+        if (STAGE_FETCH == node->getType()) {
+            return true;
+        }
+        for (size_t i = 0; i < node->children.size(); ++i) {
+            if (hasFetch(node->children[i])) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     bool providesSort(const CanonicalQuery& query, const BSONObj& kp) {
         return query.getParsed().getSort().isPrefixOf(kp);
     }
@@ -353,6 +381,18 @@ namespace mongo {
                 return Status::OK();
             }
         }
+        else if (SolutionCacheData::SKIP_IXSCAN_SOLN == cacheData.solnType) {
+            // The solution can be constructed by skip-scanning the index.
+            QuerySolution* soln = buildSkipScanSoln(*cacheData.tree->entry, query, params);
+            if (soln == NULL) {
+                return Status(ErrorCodes::BadValue,
+                              "plan cache error: soln that skip-scans index");
+            }
+            else {
+                *out = soln;
+                return Status::OK();
+            }
+        }
         else if (SolutionCacheData::COLLSCAN_SOLN == cacheData.solnType) {
             // The cached solution is a collection scan. We don't cache collscans
             // with tailable==true, hence the false below.
@@ -906,6 +946,72 @@ namespace mongo {
             }
         }
 
+        // With no indexed plan the query would scan the collection.  If an index holds every field
+        // of the projection it is much cheaper to scan all of its keys instead, since that never
+        // touches the documents.  Sparse and multikey indexes don't hold one key per document.
+        if ((params.options & QueryPlannerParams::COVERED_WHOLE_IXSCAN)
+            && out->empty()
+            && NULL != query.getProj()
+            && hintIndex.isEmpty()
+            && !QueryPlannerCommon::hasNode(query.root(), MatchExpression::GEO_NEAR)
+            && !QueryPlannerCommon::hasNode(query.root(), MatchExpression::TEXT)) {
+            for (size_t i = 0; i < params.indices.size(); ++i) {
+                const IndexEntry& index = params.indices[i];
+                if (index.type != INDEX_BTREE || index.sparse || index.multikey) {
+                    continue;
+                }
+
+                QuerySolution* soln = buildWholeIXSoln(index, query, params);
+                if (NULL == soln) {
+                    continue;
+                }
+                if (hasFetch(soln->root.get())) {
+                    delete soln;
+                    continue;
+                }
+
+                QLOG() << "Planner: outputting soln that scans whole covering index:" << endl
+                       << soln->toString();
+                PlanCacheIndexTree* indexTree = new PlanCacheIndexTree();
+                indexTree->setIndexEntry(index);
+                SolutionCacheData* scd = new SolutionCacheData();
+                scd->tree.reset(indexTree);
+                scd->solnType = SolutionCacheData::WHOLE_IXSCAN_SOLN;
+                scd->wholeIXSolnDir = 1;
+
+                soln->cacheData.reset(scd);
+                out->push_back(soln);
+                break;
+            }
+        }
+
+        // A compound index whose first field has no predicate can still be skip-scanned if a later
+        // field has one.  Whether that beats the other plans depends on how many distinct values
+        // the leading fields have, so we just add the candidates and leave it to plan ranking.
+        const size_t numNonSkipScanSolns = out->size();
+        if ((params.options & QueryPlannerParams::INDEX_SKIP_SCAN)
+            && !QueryPlannerCommon::hasNode(query.root(), MatchExpression::GEO_NEAR)
+            && !QueryPlannerCommon::hasNode(query.root(), MatchExpression::TEXT)) {
+            for (size_t i = 0; i < params.indices.size()
+                               && out->size() < params.maxIndexedSolutions; ++i) {
+                QuerySolution* soln = buildSkipScanSoln(params.indices[i], query, params);
+                if (NULL == soln) {
+                    continue;
+                }
+
+                QLOG() << "Planner: outputting soln that skip-scans index:" << endl
+                       << soln->toString();
+                PlanCacheIndexTree* indexTree = new PlanCacheIndexTree();
+                indexTree->setIndexEntry(params.indices[i]);
+                SolutionCacheData* scd = new SolutionCacheData();
+                scd->tree.reset(indexTree);
+                scd->solnType = SolutionCacheData::SKIP_IXSCAN_SOLN;
+
+                soln->cacheData.reset(scd);
+                out->push_back(soln);
+            }
+        }
+
         // geoNear and text queries *require* an index.
         // Also, if a hint is specified it indicates that we MUST use it.
         bool possibleToCollscan = !QueryPlannerCommon::hasNode(query.root(), MatchExpression::GEO_NEAR)
@@ -916,7 +1022,9 @@ namespace mongo {
         bool collscanRequested = (params.options & QueryPlannerParams::INCLUDE_COLLSCAN);
 
         // No indexed plans?  We must provide a collscan if possible or else we can't run the query.
-        bool collscanNeeded = (0 == out->size() && canTableScan);
+        // Skip scans don't count: they can be much worse than a collscan if the leading fields
+        // have many distinct values, so the collscan has to be there to compete with them.
+        bool collscanNeeded = (0 == numNonSkipScanSolns && canTableScan);
 
         if (possibleToCollscan && (collscanRequested || collscanNeeded)) {
             QuerySolution* collscan = buildCollscanSoln(query, false, params);
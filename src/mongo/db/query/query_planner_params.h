@@ -81,7 +81,20 @@ namespace mongo {
             // Set this if you want to handle batchSize properly with sort(). If limits on SORT
             // stages are always actually limits, then this should be left off. If they are
             // sometimes to be interpreted as batchSize, then this should be turned on.
-            SPLIT_LIMITED_SORT = 1 << 7
+            SPLIT_LIMITED_SORT = 1 << 7,
+
+            // Set this if you want skip scans of compound indices to be considered for queries
+            // which have no predicate over an index's first field but do over a later one.
+            INDEX_SKIP_SCAN = 1 << 8,
+
+            // Set this if a query which would otherwise be a collection scan should instead scan
+            // the whole of an index which covers its projection, reading no documents at all.
+            COVERED_WHOLE_IXSCAN = 1 << 9,
+
+            // Set this if the caller is done with each document getNext() gives it before calling
+            // getNext() again.  A collection scan whose documents go straight to the caller may
+            // then hand out memory owned by the storage engine instead of a copy.
+            BORROW_RECORDS = 1 << 10
         };
 
         // See Options enum above.
@@ -750,6 +750,46 @@ namespace {
                                 "{filter: null, pattern: {a: 1}}}}}]}}}}");
     }
 
+    // Point scans produce RecordIds in order, so the OR merges them instead of remembering them.
+    TEST_F(QueryPlannerTest, OrOfPointScansMergesByRecordId) {
+        addIndex(BSON("a" << 1));
+        addIndex(BSON("b" << 1));
+        runQuery(fromjson("{$or: [{a: 1}, {b: 2}]}"));
+
+        assertNumSolutions(2U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+        assertSolutionExists("{fetch: {filter: null, node: {or: {mergeByRecordId: true, nodes: ["
+                                "{ixscan: {filter: null, pattern: {a: 1}}}, "
+                                "{ixscan: {filter: null, pattern: {b: 1}}}]}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, OrOfRangeScansDoesNotMergeByRecordId) {
+        addIndex(BSON("a" << 1));
+        addIndex(BSON("b" << 1));
+        runQuery(fromjson("{$or: [{a: 1}, {b: {$gt: 2}}]}"));
+
+        assertNumSolutions(2U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+        assertSolutionExists("{fetch: {filter: null, node: {or: {mergeByRecordId: false, nodes: ["
+                                "{ixscan: {filter: null, pattern: {a: 1}}}, "
+                                "{ixscan: {filter: null, pattern: {b: 1}}}]}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, OrMergeByRecordIdDisabled) {
+        bool oldEnableOrMerge = internalQueryPlannerEnableOrMergeByRecordId;
+        internalQueryPlannerEnableOrMergeByRecordId = false;
+
+        addIndex(BSON("a" << 1));
+        addIndex(BSON("b" << 1));
+        runQuery(fromjson("{$or: [{a: 1}, {b: 2}]}"));
+
+        assertSolutionExists("{fetch: {filter: null, node: {or: {mergeByRecordId: false, nodes: ["
+                                "{ixscan: {filter: null, pattern: {a: 1}}}, "
+                                "{ixscan: {filter: null, pattern: {b: 1}}}]}}}}");
+
+        internalQueryPlannerEnableOrMergeByRecordId = oldEnableOrMerge;
+    }
+
     TEST_F(QueryPlannerTest, AndWithUnindexedOrChild) {
         addIndex(BSON("a" << 1));
         runQuery(fromjson("{a:20, $or: [{b:1}, {c:7}]}"));
@@ -4352,6 +4392,104 @@ namespace {
                                 "{filter: null, pattern: {a: 1}}}}}]}}}}");
     }
 
+    //
+    // Index skip scans.
+    //
+
+    TEST_F(QueryPlannerTest, SkipScanNonPrefixEquality) {
+        params.options = QueryPlannerParams::INDEX_SKIP_SCAN;
+        addIndex(BSON("a" << 1 << "b" << 1));
+
+        runQuery(fromjson("{b: 5}"));
+
+        assertNumSolutions(2U);
+        assertSolutionExists("{cscan: {dir: 1, filter: {b: 5}}}");
+        assertSolutionExists("{fetch: {filter: {b: 5}, node: {ixscan: {pattern: {a: 1, b: 1}, "
+                                "bounds: {a: [['MinKey','MaxKey',true,true]], "
+                                         "b: [[5,5,true,true]]}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, SkipScanIntersectsBoundsAndAlignsDescendingFields) {
+        params.options = QueryPlannerParams::INDEX_SKIP_SCAN | QueryPlannerParams::NO_TABLE_SCAN;
+        addIndex(BSON("a" << 1 << "b" << -1 << "c" << 1));
+
+        runQuery(fromjson("{b: {$gt: 1}, c: 3, d: 4, b: {$lte: 7}}"));
+
+        assertNumSolutions(1U);
+        assertSolutionExists("{fetch: {node: {ixscan: {pattern: {a: 1, b: -1, c: 1}, "
+                                "bounds: {a: [['MinKey','MaxKey',true,true]], "
+                                         "b: [[7,1,true,false]], "
+                                         "c: [[3,3,true,true]]}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, SkipScanNotUsedWithPrefixPredicate) {
+        params.options = QueryPlannerParams::INDEX_SKIP_SCAN | QueryPlannerParams::INCLUDE_COLLSCAN;
+        addIndex(BSON("a" << 1 << "b" << 1));
+
+        runQuery(fromjson("{a: 1, b: 5}"));
+
+        assertNumSolutions(2U);
+        assertSolutionExists("{cscan: {dir: 1, filter: {a: 1, b: 5}}}");
+        assertSolutionExists("{fetch: {filter: null, node: {ixscan: {pattern: {a: 1, b: 1}, "
+                                "bounds: {a: [[1,1,true,true]], b: [[5,5,true,true]]}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, SkipScanRequiresOption) {
+        addIndex(BSON("a" << 1 << "b" << 1));
+
+        runQuery(fromjson("{b: 5}"));
+
+        assertNumSolutions(1U);
+        assertSolutionExists("{cscan: {dir: 1, filter: {b: 5}}}");
+    }
+
+    //
+    // Whole index scans in place of collection scans.
+    //
+
+    TEST_F(QueryPlannerTest, CoveredWholeIndexScanReplacesCollscan) {
+        params.options = QueryPlannerParams::COVERED_WHOLE_IXSCAN;
+        addIndex(BSON("b" << 1));
+        addIndex(BSON("a" << 1 << "b" << 1));
+
+        runQuerySortProj(BSONObj(), BSONObj(), fromjson("{_id: 0, a: 1, b: 1}"));
+
+        assertNumSolutions(1U);
+        assertSolutionExists("{proj: {spec: {_id: 0, a: 1, b: 1}, node: "
+                                "{ixscan: {filter: null, pattern: {a: 1, b: 1}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, CoveredWholeIndexScanNotUsedWhenNotCovered) {
+        params.options = QueryPlannerParams::COVERED_WHOLE_IXSCAN;
+        addIndex(BSON("a" << 1));
+        addIndex(BSON("a" << 1 << "b" << 1), true);
+
+        runQuerySortProj(BSONObj(), BSONObj(), fromjson("{_id: 0, a: 1, b: 1}"));
+
+        assertNumSolutions(1U);
+        assertSolutionExists("{proj: {spec: {_id: 0, a: 1, b: 1}, node: {cscan: {dir: 1}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, CoveredWholeIndexScanNotUsedWithFilter) {
+        params.options = QueryPlannerParams::COVERED_WHOLE_IXSCAN;
+        addIndex(BSON("a" << 1 << "b" << 1));
+
+        runQuerySortProj(fromjson("{c: 1}"), BSONObj(), fromjson("{_id: 0, a: 1}"));
+
+        assertNumSolutions(1U);
+        assertSolutionExists("{proj: {spec: {_id: 0, a: 1}, node: "
+                                "{cscan: {dir: 1, filter: {c: 1}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, CoveredWholeIndexScanRequiresOption) {
+        addIndex(BSON("a" << 1));
+
+        runQuerySortProj(BSONObj(), BSONObj(), fromjson("{_id: 0, a: 1}"));
+
+        assertNumSolutions(1U);
+        assertSolutionExists("{proj: {spec: {_id: 0, a: 1}, node: {cscan: {dir: 1}}}}");
+    }
+
     //
     // Index Intersection.
     //
@@ -4530,9 +4668,11 @@ namespace {
     // Ensure that disabling AND_HASH intersection works properly.
     TEST_F(QueryPlannerTest, IntersectDisableAndHash) {
         bool oldEnableHashIntersection = internalQueryPlannerEnableHashIntersection;
+        bool oldEnableBitmapIntersection = internalQueryPlannerEnableBitmapIntersection;
 
-        // Turn index intersection on but disable hash-based intersection.
+        // Turn index intersection on but disable hash-based and bitmap-based intersection.
         internalQueryPlannerEnableHashIntersection = false;
+        internalQueryPlannerEnableBitmapIntersection = false;
         params.options = QueryPlannerParams::NO_TABLE_SCAN | QueryPlannerParams::INDEX_INTERSECTION;
 
         addIndex(BSON("a" << 1));
@@ -4555,6 +4695,28 @@ namespace {
 
         // Restore the old value of the has intersection switch.
         internalQueryPlannerEnableHashIntersection = oldEnableHashIntersection;
+        internalQueryPlannerEnableBitmapIntersection = oldEnableBitmapIntersection;
+    }
+
+    // With AND_HASH disabled, intersections which can't use AND_SORTED use AND_BITMAP.
+    TEST_F(QueryPlannerTest, IntersectAndBitmapWhenAndHashDisabled) {
+        bool oldEnableHashIntersection = internalQueryPlannerEnableHashIntersection;
+        bool oldEnableBitmapIntersection = internalQueryPlannerEnableBitmapIntersection;
+
+        internalQueryPlannerEnableHashIntersection = false;
+        internalQueryPlannerEnableBitmapIntersection = true;
+        params.options = QueryPlannerParams::NO_TABLE_SCAN | QueryPlannerParams::INDEX_INTERSECTION;
+
+        addIndex(BSON("a" << 1));
+        addIndex(BSON("b" << 1));
+        runQuery(fromjson("{a:1, b:{$gt: 1}}"));
+
+        assertSolutionExists("{fetch: {filter: null, node: {andBitmap: {nodes: ["
+                                    "{ixscan: {filter: null, pattern: {a:1}}},"
+                                    "{ixscan: {filter: null, pattern: {b:1}}}]}}}}");
+
+        internalQueryPlannerEnableHashIntersection = oldEnableHashIntersection;
+        internalQueryPlannerEnableBitmapIntersection = oldEnableBitmapIntersection;
     }
 
     //
@@ -5004,6 +5166,33 @@ namespace {
                                    "{ixscan: {pattern: {b: 1}}}}}}}}}");
     }
 
+    TEST_F(QueryPlannerTest, ShardFilterBelowFetch) {
+        params.options = QueryPlannerParams::INCLUDE_SHARD_FILTER;
+        params.shardKey = BSON("a" << 1);
+        addIndex(BSON("a" << 1 << "b" << 1));
+
+        runQuery(fromjson("{a: 1, c: 1}"));
+
+        assertNumSolutions(1U);
+        assertSolutionExists("{fetch: {filter: {c: 1}, node: "
+                               "{sharding_filter: {node: "
+                                 "{ixscan: {pattern: {a: 1, b: 1}}}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, ShardFilterBelowFetchMultikeyNotCovered) {
+        params.options = QueryPlannerParams::INCLUDE_SHARD_FILTER;
+        params.shardKey = BSON("a" << 1);
+        // Multikey
+        addIndex(BSON("a" << 1), true);
+
+        runQuery(fromjson("{a: 1, c: 1}"));
+
+        assertNumSolutions(1U);
+        assertSolutionExists("{sharding_filter: {node: "
+                               "{fetch: {filter: {c: 1}, node: "
+                                 "{ixscan: {pattern: {a: 1}}}}}}}");
+    }
+
     //
     // Test bad input to query planner helpers.
     //
@@ -93,7 +93,9 @@ namespace {
         appendIntervalBound(bob, high);
         Interval toCompare(bob.obj(), startInclusive, endInclusive);
 
-        return Interval::INTERVAL_EQUALS == trueInt.compare(toCompare);
+        // Not compare(), which needs start <= end and so can't match the reversed intervals that
+        // descending index fields are aligned to.
+        return trueInt.equals(toCompare);
     }
 
     /**
@@ -283,6 +285,17 @@ namespace mongo {
                 }
             }
 
+            BSONElement limitElt = textObj["limit"];
+            if (!limitElt.eoo()) {
+                if (!limitElt.isNumber()) {
+                    return false;
+                }
+
+                if (size_t(limitElt.numberLong()) != node->limit) {
+                    return false;
+                }
+            }
+
             BSONElement indexPrefix = textObj["prefix"];
             if (!indexPrefix.eoo()) {
                 if (!indexPrefix.isABSONObj()) {
@@ -342,8 +355,36 @@ namespace mongo {
             BSONElement el = testSoln["or"];
             if (el.eoo() || !el.isABSONObj()) { return false; }
             BSONObj orObj = el.Obj();
+
+            BSONElement mergeByRecordId = orObj["mergeByRecordId"];
+            if (!mergeByRecordId.eoo()
+                    && mergeByRecordId.trueValue() != orn->mergeByRecordId) {
+                return false;
+            }
+
             return childrenMatch(orObj, orn);
         }
+        else if (STAGE_AND_BITMAP == trueSoln->getType()) {
+            const AndBitmapNode* abn = static_cast<const AndBitmapNode*>(trueSoln);
+            BSONElement el = testSoln["andBitmap"];
+            if (el.eoo() || !el.isABSONObj()) { return false; }
+            BSONObj andBitmapObj = el.Obj();
+
+            BSONElement filter = andBitmapObj["filter"];
+            if (!filter.eoo()) {
+                if (filter.isNull()) {
+                    if (NULL != abn->filter) { return false; }
+                }
+                else if (!filter.isABSONObj()) {
+                    return false;
+                }
+                else if (!filterMatches(filter.Obj(), trueSoln)) {
+                    return false;
+                }
+            }
+
+            return childrenMatch(andBitmapObj, abn);
+        }
         else if (STAGE_AND_HASH == trueSoln->getType()) {
             const AndHashNode* ahn = static_cast<const AndHashNode*>(trueSoln);
             BSONElement el = testSoln["andHash"];
@@ -617,4 +617,33 @@ namespace {
                                           "pattern: {other: 1}}}]}}}}");
     }
 
+    // A sort on nothing but the text score passes its limit down to the text node.
+    TEST_F(QueryPlannerTest, TextScoreSortLimitPushedToText) {
+        addIndex(BSON("_fts" << "text" << "_ftsx" << 1));
+        runQuerySortProjSkipLimit(fromjson("{$text: {$search: 'blah'}}"),
+                                  fromjson("{score: {$meta: 'textScore'}}"),
+                                  fromjson("{score: {$meta: 'textScore'}}"),
+                                  2, 3);
+
+        assertNumSolutions(1U);
+        assertSolutionExists("{skip: {n: 2, node: "
+                                "{proj: {spec: {score: {$meta: 'textScore'}}, node: "
+                                    "{sort: {pattern: {score: {$meta: 'textScore'}}, limit: 5, "
+                                        "node: {text: {search: 'blah', limit: 5}}}}}}}}");
+    }
+
+    // Sorting on anything besides the text score leaves the text node unlimited.
+    TEST_F(QueryPlannerTest, OtherSortLimitNotPushedToText) {
+        addIndex(BSON("_fts" << "text" << "_ftsx" << 1));
+        runQuerySortProjSkipLimit(fromjson("{$text: {$search: 'blah'}}"),
+                                  fromjson("{score: {$meta: 'textScore'}, a: 1}"),
+                                  fromjson("{score: {$meta: 'textScore'}}"),
+                                  0, 3);
+
+        assertNumSolutions(1U);
+        assertSolutionExists("{proj: {spec: {score: {$meta: 'textScore'}}, node: "
+                                "{sort: {pattern: {score: {$meta: 'textScore'}, a: 1}, limit: 3, "
+                                    "node: {text: {search: 'blah', limit: 0}}}}}}");
+    }
+
 }  // namespace
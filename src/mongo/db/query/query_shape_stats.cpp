@@ -0,0 +1,345 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/query_shape_stats.h"
+
+#include <algorithm>
+#include <boost/functional/hash.hpp>
+#include <limits>
+#include <map>
+
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/coarse_clock.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    // How many query shapes to keep statistics for.  0 turns the statistics off.
+    MONGO_EXPORT_SERVER_PARAMETER(queryShapeStatsMaxShapes, int, 1000);
+
+    QueryShapeStats QueryShapeStats::global;
+
+namespace {
+
+    // Examples of a shape are cut down to this size, so that a few huge queries cannot make the
+    // store use much more memory than queryShapeStatsMaxShapes suggests.
+    const int kMaxExampleSize = 1024;
+
+    BSONObj exampleFor(const BSONObj& obj) {
+        if (obj.objsize() <= kMaxExampleSize) {
+            return obj.getOwned();
+        }
+        return BSON("$truncated" << obj.toString(false, false).substr(0, kMaxExampleSize));
+    }
+
+    int latencyBucketFor(long long micros) {
+        int bucket = 0;
+        while (micros >= 2 && bucket < QueryShapeStats::kNumLatencyBuckets - 1) {
+            micros >>= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+
+    long long lowerBoundMicrosOf(int bucket) {
+        return bucket == 0 ? 0 : 1LL << bucket;
+    }
+
+    void appendAverage(long long totalMicros, long long count, BSONObjBuilder* builder) {
+        builder->appendNumber("averageMicros", count > 0 ? totalMicros / count : 0);
+    }
+
+    /**
+     * The totals of one shape while merging shape documents.
+     */
+    struct MergedShape {
+        MergedShape() : count(0), totalMicros(0), maxMicros(0), keysExamined(0),
+                        docsExamined(0), nreturned(0) { }
+
+        BSONObj first;
+        Date_t firstSeen;
+        Date_t lastSeen;
+        std::string planSummary;
+        long long count;
+        long long totalMicros;
+        long long maxMicros;
+        long long keysExamined;
+        long long docsExamined;
+        long long nreturned;
+        std::map<long long, long long> histogram;
+    };
+
+    struct ShapeGreater {
+        explicit ShapeGreater(const std::string& field) : field(field) { }
+
+        bool operator()(const BSONObj& a, const BSONObj& b) const {
+            return a[field].numberLong() > b[field].numberLong();
+        }
+
+        std::string field;
+    };
+
+} // namespace
+
+    QueryShapeStats::Entry::Entry()
+        : count(0),
+          totalMicros(0),
+          maxMicros(0),
+          keysExamined(0),
+          docsExamined(0),
+          nreturned(0) {
+        std::fill(latencyHistogram, latencyHistogram + kNumLatencyBuckets, 0);
+    }
+
+    void QueryShapeStats::Entry::record(const QueryShapeExecution& execution) {
+        count++;
+        totalMicros += execution.micros;
+        maxMicros = std::max(maxMicros, execution.micros);
+        keysExamined += execution.keysExamined;
+        docsExamined += execution.docsExamined;
+        nreturned += execution.nreturned;
+        latencyHistogram[latencyBucketFor(execution.micros)]++;
+        planSummary = execution.planSummary;
+        lastSeen = Date_t(CoarseClock::wallMillis());
+    }
+
+    BSONObj QueryShapeStats::Entry::toBSON() const {
+        BSONObjBuilder builder;
+        builder.append("ns", ns);
+        builder.append("key", key);
+        builder.append("query", query);
+        builder.append("sort", sort);
+        builder.append("projection", projection);
+        builder.appendNumber("count", count);
+        builder.appendNumber("totalMicros", totalMicros);
+        appendAverage(totalMicros, count, &builder);
+        builder.appendNumber("maxMicros", maxMicros);
+        builder.appendNumber("keysExamined", keysExamined);
+        builder.appendNumber("docsExamined", docsExamined);
+        builder.appendNumber("nreturned", nreturned);
+
+        BSONArrayBuilder histogramBuilder(builder.subarrayStart("latencyHistogram"));
+        for (int i = 0; i < kNumLatencyBuckets; i++) {
+            if (latencyHistogram[i] > 0) {
+                histogramBuilder.append(BSON("lowerBoundMicros" << lowerBoundMicrosOf(i)
+                                          << "count" << latencyHistogram[i]));
+            }
+        }
+        histogramBuilder.done();
+
+        builder.append("planSummary", planSummary);
+        builder.appendDate("firstSeen", firstSeen);
+        builder.appendDate("lastSeen", lastSeen);
+        return builder.obj();
+    }
+
+    QueryShapeStats::Partition::Partition()
+        // Evictions are done by record(), so that queryShapeStatsMaxShapes applies right away.
+        : entries(std::numeric_limits<size_t>::max()) {
+    }
+
+    QueryShapeStats::QueryShapeStats() {
+        for (size_t i = 0; i < kNumPartitions; ++i) {
+            _partitions.push_back(new Partition());
+        }
+    }
+
+    QueryShapeStats::Partition& QueryShapeStats::_partitionFor(const std::string& key) const {
+        return *_partitions[boost::hash<std::string>()(key) % kNumPartitions];
+    }
+
+    void QueryShapeStats::record(const StringData& ns,
+                                 const StringData& key,
+                                 const BSONObj& query,
+                                 const BSONObj& sort,
+                                 const BSONObj& projection,
+                                 const QueryShapeExecution& execution) {
+        const int maxShapes = queryShapeStatsMaxShapes;
+        if (maxShapes <= 0) {
+            return;
+        }
+        // Round up so the partitions together hold at least maxShapes shapes.
+        const size_t partitionSize = (maxShapes + kNumPartitions - 1) / kNumPartitions;
+
+        std::string mapKey = ns.toString();
+        mapKey.push_back('\0');
+        mapKey.append(key.rawData(), key.size());
+
+        Partition& partition = _partitionFor(mapKey);
+        boost::lock_guard<boost::mutex> lk(partition.mutex);
+
+        Entry* entry;
+        if (!partition.entries.get(mapKey, &entry).isOK()) {
+            while (partition.entries.size() >= partitionSize) {
+                EntryMap::KVListConstIt oldest = partition.entries.end();
+                --oldest;
+                const std::string oldestKey = oldest->first;
+                partition.entries.remove(oldestKey);
+            }
+
+            entry = new Entry();
+            entry->ns = ns.toString();
+            entry->key = key.toString();
+            entry->query = exampleFor(query);
+            entry->sort = exampleFor(sort);
+            entry->projection = exampleFor(projection);
+            entry->firstSeen = Date_t(CoarseClock::wallMillis());
+            partition.entries.add(mapKey, entry);
+        }
+
+        entry->record(execution);
+    }
+
+    void QueryShapeStats::getShapes(std::vector<BSONObj>* out) const {
+        for (size_t i = 0; i < kNumPartitions; ++i) {
+            const Partition& partition = *_partitions[i];
+            boost::lock_guard<boost::mutex> lk(partition.mutex);
+            for (EntryMap::KVListConstIt it = partition.entries.begin();
+                 it != partition.entries.end(); ++it) {
+                out->push_back(it->second->toBSON());
+            }
+        }
+    }
+
+    size_t QueryShapeStats::size() const {
+        size_t total = 0;
+        for (size_t i = 0; i < kNumPartitions; ++i) {
+            const Partition& partition = *_partitions[i];
+            boost::lock_guard<boost::mutex> lk(partition.mutex);
+            total += partition.entries.size();
+        }
+        return total;
+    }
+
+    void QueryShapeStats::clear() {
+        for (size_t i = 0; i < kNumPartitions; ++i) {
+            Partition& partition = *_partitions[i];
+            boost::lock_guard<boost::mutex> lk(partition.mutex);
+            partition.entries.clear();
+        }
+    }
+
+    // static
+    void QueryShapeStats::merge(const std::vector<BSONObj>& shapes, std::vector<BSONObj>* out) {
+        std::map<std::pair<std::string, std::string>, MergedShape> merged;
+
+        for (size_t i = 0; i < shapes.size(); i++) {
+            const BSONObj& shape = shapes[i];
+            MergedShape& m = merged[std::make_pair(shape["ns"].str(), shape["key"].str())];
+
+            const Date_t firstSeen = shape["firstSeen"].date();
+            const Date_t lastSeen = shape["lastSeen"].date();
+            if (m.first.isEmpty() || firstSeen < m.firstSeen) {
+                m.first = shape;
+                m.firstSeen = firstSeen;
+            }
+            if (lastSeen >= m.lastSeen) {
+                m.lastSeen = lastSeen;
+                m.planSummary = shape["planSummary"].str();
+            }
+
+            m.count += shape["count"].numberLong();
+            m.totalMicros += shape["totalMicros"].numberLong();
+            m.maxMicros = std::max(m.maxMicros, shape["maxMicros"].numberLong());
+            m.keysExamined += shape["keysExamined"].numberLong();
+            m.docsExamined += shape["docsExamined"].numberLong();
+            m.nreturned += shape["nreturned"].numberLong();
+
+            BSONObjIterator buckets(shape["latencyHistogram"].Obj());
+            while (buckets.more()) {
+                const BSONObj bucket = buckets.next().Obj();
+                m.histogram[bucket["lowerBoundMicros"].numberLong()] +=
+                    bucket["count"].numberLong();
+            }
+        }
+
+        for (std::map<std::pair<std::string, std::string>, MergedShape>::const_iterator it =
+                merged.begin(); it != merged.end(); ++it) {
+            const MergedShape& m = it->second;
+
+            BSONObjBuilder builder;
+            builder.append("ns", it->first.first);
+            builder.append("key", it->first.second);
+            builder.append(m.first["query"]);
+            builder.append(m.first["sort"]);
+            builder.append(m.first["projection"]);
+            builder.appendNumber("count", m.count);
+            builder.appendNumber("totalMicros", m.totalMicros);
+            appendAverage(m.totalMicros, m.count, &builder);
+            builder.appendNumber("maxMicros", m.maxMicros);
+            builder.appendNumber("keysExamined", m.keysExamined);
+            builder.appendNumber("docsExamined", m.docsExamined);
+            builder.appendNumber("nreturned", m.nreturned);
+
+            BSONArrayBuilder histogramBuilder(builder.subarrayStart("latencyHistogram"));
+            for (std::map<long long, long long>::const_iterator bucket = m.histogram.begin();
+                 bucket != m.histogram.end(); ++bucket) {
+                histogramBuilder.append(BSON("lowerBoundMicros" << bucket->first
+                                          << "count" << bucket->second));
+            }
+            histogramBuilder.done();
+
+            builder.append("planSummary", m.planSummary);
+            builder.appendDate("firstSeen", m.firstSeen);
+            builder.appendDate("lastSeen", m.lastSeen);
+            out->push_back(builder.obj());
+        }
+    }
+
+    // static
+    Status QueryShapeStats::appendTop(const std::vector<BSONObj>& shapes,
+                                      const StringData& sortBy,
+                                      size_t limit,
+                                      BSONArrayBuilder* out) {
+        if (sortBy != "count" && sortBy != "totalMicros" && sortBy != "averageMicros" &&
+                sortBy != "maxMicros" && sortBy != "keysExamined" && sortBy != "docsExamined" &&
+                sortBy != "nreturned") {
+            return Status(ErrorCodes::BadValue,
+                          str::stream() << "can't sort query shapes by " << sortBy);
+        }
+
+        std::vector<BSONObj> sorted(shapes);
+        std::stable_sort(sorted.begin(), sorted.end(), ShapeGreater(sortBy.toString()));
+        if (limit > 0 && sorted.size() > limit) {
+            sorted.resize(limit);
+        }
+
+        // Leave room for the rest of the command reply.
+        const int maxSize = BSONObjMaxUserSize - 16 * 1024;
+        for (size_t i = 0; i < sorted.size(); i++) {
+            if (out->len() + sorted[i].objsize() > maxSize) {
+                break;
+            }
+            out->append(sorted[i]);
+        }
+        return Status::OK();
+    }
+
+}  // namespace mongo
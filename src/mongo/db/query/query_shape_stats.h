@@ -0,0 +1,157 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/thread/mutex.hpp>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/owned_pointer_vector.h"
+#include "mongo/base/status.h"
+#include "mongo/base/string_data.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/query/lru_key_value.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    /**
+     * What one execution of a query did.
+     */
+    struct QueryShapeExecution {
+        QueryShapeExecution() : micros(0), keysExamined(0), docsExamined(0), nreturned(0) { }
+
+        long long micros;
+        long long keysExamined;
+        long long docsExamined;
+        long long nreturned;
+        std::string planSummary;
+    };
+
+    /**
+     * Totals of the resources used by each query shape: queries which differ only in the values
+     * they compare against, as told apart by the PlanCacheKey.
+     *
+     * Like the plan cache, the store is split into partitions with their own mutex and least
+     * recently used list, so queries of different shapes rarely contend.  It holds at most
+     * queryShapeStatsMaxShapes shapes; the least recently run shapes are evicted first.
+     *
+     * Shapes are reported as documents, so that mongos can combine those of its shards with
+     * merge() and rank them with appendTop() just as mongod does.
+     */
+    class QueryShapeStats {
+        MONGO_DISALLOW_COPYING(QueryShapeStats);
+    public:
+        static QueryShapeStats global;
+
+        // Latency buckets: bucket 0 counts executions under 2 microseconds, bucket i > 0 those
+        // in [2^i, 2^(i+1)) microseconds, and the last one everything slower.
+        enum { kNumLatencyBuckets = 24 };
+
+        QueryShapeStats();
+
+        /**
+         * Counts one execution of the query on 'ns' whose shape is 'key'.  The query, sort and
+         * projection of the first execution seen are kept as an example of the shape.
+         */
+        void record(const StringData& ns,
+                    const StringData& key,
+                    const BSONObj& query,
+                    const BSONObj& sort,
+                    const BSONObj& projection,
+                    const QueryShapeExecution& execution);
+
+        /**
+         * Appends one document per shape to 'out', in no particular order.
+         */
+        void getShapes(std::vector<BSONObj>* out) const;
+
+        size_t size() const;
+
+        void clear();
+
+        /**
+         * Combines the documents of the same shape, such as those of different shards, into one.
+         */
+        static void merge(const std::vector<BSONObj>& shapes, std::vector<BSONObj>* out);
+
+        /**
+         * Appends to 'out' the 'limit' shapes, or all if it is 0, with the largest 'sortBy'
+         * field: count, totalMicros, averageMicros, maxMicros, keysExamined, docsExamined or
+         * nreturned.  The result stays under the maximum size of a user document.
+         */
+        static Status appendTop(const std::vector<BSONObj>& shapes,
+                                const StringData& sortBy,
+                                size_t limit,
+                                BSONArrayBuilder* out);
+
+    private:
+        struct Entry {
+            Entry();
+
+            void record(const QueryShapeExecution& execution);
+
+            BSONObj toBSON() const;
+
+            std::string ns;
+            std::string key;
+            BSONObj query;
+            BSONObj sort;
+            BSONObj projection;
+
+            long long count;
+            long long totalMicros;
+            long long maxMicros;
+            long long keysExamined;
+            long long docsExamined;
+            long long nreturned;
+            long long latencyHistogram[kNumLatencyBuckets];
+            std::string planSummary;
+            Date_t firstSeen;
+            Date_t lastSeen;
+        };
+
+        typedef LRUKeyValue<std::string, Entry> EntryMap;
+
+        struct Partition {
+            Partition();
+
+            EntryMap entries;
+            mutable boost::mutex mutex;
+        };
+
+        enum { kNumPartitions = 16 };
+
+        Partition& _partitionFor(const std::string& key) const;
+
+        OwnedPointerVector<Partition> _partitions;
+    };
+
+}  // namespace mongo
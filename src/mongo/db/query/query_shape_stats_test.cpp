@@ -0,0 +1,158 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/query_shape_stats.h"
+
+#include "mongo/db/server_parameters.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace {
+
+    QueryShapeExecution execution(long long micros, long long docsExamined) {
+        QueryShapeExecution exec;
+        exec.micros = micros;
+        exec.keysExamined = docsExamined;
+        exec.docsExamined = docsExamined;
+        exec.nreturned = 1;
+        exec.planSummary = "IXSCAN { a: 1 }";
+        return exec;
+    }
+
+    void recordShape(QueryShapeStats* stats, const std::string& key, long long micros) {
+        stats->record("test.coll", key, BSON("a" << 1), BSONObj(), BSONObj(),
+                      execution(micros, 10));
+    }
+
+    void setMaxShapes(int maxShapes) {
+        ServerParameter* param =
+            ServerParameterSet::getGlobal()->getMap().find("queryShapeStatsMaxShapes")->second;
+        ASSERT_OK(param->set(BSON("" << maxShapes).firstElement()));
+    }
+
+    TEST(QueryShapeStats, AccumulatesPerShape) {
+        QueryShapeStats stats;
+        recordShape(&stats, "eqa", 10);
+        recordShape(&stats, "eqa", 30);
+        recordShape(&stats, "eqb", 5);
+
+        std::vector<BSONObj> shapes;
+        stats.getShapes(&shapes);
+        ASSERT_EQUALS(2U, shapes.size());
+
+        BSONObj a = shapes[0]["key"].str() == "eqa" ? shapes[0] : shapes[1];
+        ASSERT_EQUALS(2, a["count"].numberLong());
+        ASSERT_EQUALS(40, a["totalMicros"].numberLong());
+        ASSERT_EQUALS(20, a["averageMicros"].numberLong());
+        ASSERT_EQUALS(30, a["maxMicros"].numberLong());
+        ASSERT_EQUALS(20, a["docsExamined"].numberLong());
+        ASSERT_EQUALS("IXSCAN { a: 1 }", a["planSummary"].str());
+
+        // 10us falls in [8, 16) and 30us in [16, 32).
+        std::vector<BSONElement> buckets = a["latencyHistogram"].Array();
+        ASSERT_EQUALS(2U, buckets.size());
+        ASSERT_EQUALS(8, buckets[0]["lowerBoundMicros"].numberLong());
+        ASSERT_EQUALS(16, buckets[1]["lowerBoundMicros"].numberLong());
+    }
+
+    TEST(QueryShapeStats, EvictsLeastRecentlyRun) {
+        // One shape per partition.
+        setMaxShapes(1);
+
+        QueryShapeStats stats;
+        for (int i = 0; i < 100; i++) {
+            recordShape(&stats, "eqa", 1);
+            recordShape(&stats, mongoutils::str::stream() << "eq" << i, 1);
+        }
+        ASSERT_LESS_THAN_OR_EQUALS(stats.size(), 16U);
+
+        setMaxShapes(0);
+        recordShape(&stats, "new", 1);
+        std::vector<BSONObj> shapes;
+        stats.getShapes(&shapes);
+        for (size_t i = 0; i < shapes.size(); i++) {
+            ASSERT_NOT_EQUALS("new", shapes[i]["key"].str());
+        }
+
+        setMaxShapes(1000);
+    }
+
+    TEST(QueryShapeStats, MergesShards) {
+        QueryShapeStats shard1;
+        QueryShapeStats shard2;
+        recordShape(&shard1, "eqa", 10);
+        recordShape(&shard2, "eqa", 1000);
+        recordShape(&shard2, "eqb", 1);
+
+        std::vector<BSONObj> all;
+        shard1.getShapes(&all);
+        shard2.getShapes(&all);
+
+        std::vector<BSONObj> merged;
+        QueryShapeStats::merge(all, &merged);
+        ASSERT_EQUALS(2U, merged.size());
+
+        BSONObj a = merged[0]["key"].str() == "eqa" ? merged[0] : merged[1];
+        ASSERT_EQUALS(2, a["count"].numberLong());
+        ASSERT_EQUALS(1010, a["totalMicros"].numberLong());
+        ASSERT_EQUALS(1000, a["maxMicros"].numberLong());
+        ASSERT_EQUALS(2U, a["latencyHistogram"].Array().size());
+    }
+
+    TEST(QueryShapeStats, AppendTop) {
+        QueryShapeStats stats;
+        recordShape(&stats, "eqa", 10);
+        recordShape(&stats, "eqb", 1000);
+        recordShape(&stats, "eqc", 100);
+        recordShape(&stats, "eqc", 100);
+
+        std::vector<BSONObj> shapes;
+        stats.getShapes(&shapes);
+
+        BSONArrayBuilder byTime;
+        ASSERT_OK(QueryShapeStats::appendTop(shapes, "totalMicros", 2, &byTime));
+        BSONArray byTimeArr = byTime.arr();
+        ASSERT_EQUALS(2, byTimeArr.nFields());
+        ASSERT_EQUALS("eqb", byTimeArr["0"]["key"].str());
+        ASSERT_EQUALS("eqc", byTimeArr["1"]["key"].str());
+
+        BSONArrayBuilder byCount;
+        ASSERT_OK(QueryShapeStats::appendTop(shapes, "count", 0, &byCount));
+        BSONArray byCountArr = byCount.arr();
+        ASSERT_EQUALS(3, byCountArr.nFields());
+        ASSERT_EQUALS("eqc", byCountArr["0"]["key"].str());
+
+        BSONArrayBuilder bad;
+        ASSERT_NOT_OK(QueryShapeStats::appendTop(shapes, "key", 0, &bad));
+    }
+
+}  // namespace
+}  // namespace mongo
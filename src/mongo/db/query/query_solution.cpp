@@ -76,6 +76,10 @@ namespace mongo {
         *ss << "language = " << language << '\n';
         addIndent(ss, indent + 1);
         *ss << "indexPrefix = " << indexPrefix.toString() << '\n';
+        if (0 != limit) {
+            addIndent(ss, indent + 1);
+            *ss << "limit = " << limit << '\n';
+        }
         if (NULL != filter) {
             addIndent(ss, indent + 1);
             *ss << " filter = " << filter->toString();
@@ -92,6 +96,7 @@ namespace mongo {
         copy->query = this->query;
         copy->language = this->language;
         copy->indexPrefix = this->indexPrefix;
+        copy->limit = this->limit;
 
         return copy;
     }
@@ -100,7 +105,10 @@ namespace mongo {
     // CollectionScanNode
     //
 
-    CollectionScanNode::CollectionScanNode() : tailable(false), direction(1), maxScan(0) { }
+    CollectionScanNode::CollectionScanNode() : tailable(false),
+                                               direction(1),
+                                               maxScan(0),
+                                               borrowRecords(false) { }
 
     void CollectionScanNode::appendToString(mongoutils::str::stream* ss, int indent) const {
         addIndent(ss, indent);
@@ -123,6 +131,39 @@ namespace mongo {
         copy->tailable = this->tailable;
         copy->direction = this->direction;
         copy->maxScan = this->maxScan;
+        copy->borrowRecords = this->borrowRecords;
+
+        return copy;
+    }
+
+    //
+    // AndBitmapNode
+    //
+
+    AndBitmapNode::AndBitmapNode() { }
+
+    AndBitmapNode::~AndBitmapNode() { }
+
+    void AndBitmapNode::appendToString(mongoutils::str::stream* ss, int indent) const {
+        addIndent(ss, indent);
+        *ss << "AND_BITMAP\n";
+        if (NULL != filter) {
+            addIndent(ss, indent + 1);
+            *ss << " filter = " << filter->toString() << '\n';
+        }
+        addCommon(ss, indent);
+        for (size_t i = 0; i < children.size(); ++i) {
+            addIndent(ss, indent + 1);
+            *ss << "Child " << i << ":\n";
+            children[i]->appendToString(ss, indent + 1);
+        }
+    }
+
+    QuerySolutionNode* AndBitmapNode::clone() const {
+        AndBitmapNode* copy = new AndBitmapNode();
+        cloneBaseData(copy);
+
+        copy->_sort = this->_sort;
 
         return copy;
     }
@@ -239,7 +280,7 @@ namespace mongo {
     // OrNode
     //
 
-    OrNode::OrNode() : dedup(true) { }
+    OrNode::OrNode() : dedup(true), mergeByRecordId(false) { }
 
     OrNode::~OrNode() { }
 
@@ -250,6 +291,10 @@ namespace mongo {
             addIndent(ss, indent + 1);
             *ss << " filter = " << filter->toString() << '\n';
         }
+        if (mergeByRecordId) {
+            addIndent(ss, indent + 1);
+            *ss << "mergeByRecordId\n";
+        }
         addCommon(ss, indent);
         for (size_t i = 0; i < children.size(); ++i) {
             addIndent(ss, indent + 1);
@@ -291,6 +336,7 @@ namespace mongo {
 
         copy->_sort = this->_sort;
         copy->dedup = this->dedup;
+        copy->mergeByRecordId = this->mergeByRecordId;
 
         return copy;
     }
@@ -613,6 +659,10 @@ namespace mongo {
         *ss << "query for bounds = " << query.toString() << '\n';
         addIndent(ss, indent + 1);
         *ss << "limit = " << limit << '\n';
+        if (allowDiskUse) {
+            addIndent(ss, indent + 1);
+            *ss << "allowDiskUse = true\n";
+        }
         addCommon(ss, indent);
         addIndent(ss, indent + 1);
         *ss << "Child:" << '\n';
@@ -627,6 +677,7 @@ namespace mongo {
         copy->pattern = this->pattern;
         copy->query = this->query;
         copy->limit = this->limit;
+        copy->allowDiskUse = this->allowDiskUse;
 
         return copy;
     }
@@ -813,6 +864,10 @@ namespace mongo {
         *ss << "direction = " << direction << '\n';
         addIndent(ss, indent + 1);
         *ss << "bounds = " << bounds.toString() << '\n';
+        if (NULL != filter) {
+            addIndent(ss, indent + 1);
+            *ss << "filter = " << filter->toString();
+        }
     }
 
     QuerySolutionNode* DistinctNode::clone() const {
@@ -216,7 +216,7 @@ namespace mongo {
     };
 
     struct TextNode : public QuerySolutionNode {
-        TextNode() { }
+        TextNode() : limit(0) { }
         virtual ~TextNode() { }
 
         virtual StageType getType() const { return STAGE_TEXT; }
@@ -241,6 +241,10 @@ namespace mongo {
         // text node while creating the text leaf node and convert them into a BSONObj index prefix
         // when we finish the text leaf node.
         BSONObj indexPrefix;
+
+        // If non-zero, only this many of the highest scoring results are needed.  Set when the
+        // node feeds straight into a sort on the text score with a limit.
+        size_t limit;
     };
 
     struct CollectionScanNode : public QuerySolutionNode {
@@ -270,6 +274,30 @@ namespace mongo {
 
         // maxScan option to .find() limits how many docs we look at.
         int maxScan;
+
+        // May the scan return documents which the storage engine owns?  See
+        // CollectionScanParams.
+        bool borrowRecords;
+    };
+
+    struct AndBitmapNode : public QuerySolutionNode {
+        AndBitmapNode();
+        virtual ~AndBitmapNode();
+
+        virtual StageType getType() const { return STAGE_AND_BITMAP; }
+
+        virtual void appendToString(mongoutils::str::stream* ss, int indent) const;
+
+        bool fetched() const { return children.back()->fetched(); }
+        bool hasField(const std::string& field) const {
+            return children.back()->hasField(field);
+        }
+        bool sortedByDiskLoc() const { return children.back()->sortedByDiskLoc(); }
+        const BSONObjSet& getSort() const { return children.back()->getSort(); }
+
+        QuerySolutionNode* clone() const;
+
+        BSONObjSet _sort;
     };
 
     struct AndHashNode : public QuerySolutionNode {
@@ -320,7 +348,7 @@ namespace mongo {
         bool hasField(const std::string& field) const;
         bool sortedByDiskLoc() const {
             // Even if our children are sorted by their diskloc or other fields, we don't maintain
-            // any order on the output.
+            // any order on the output.  Merging by diskloc does, but we only use that to dedup.
             return false;
         }
         const BSONObjSet& getSort() const { return _sort; }
@@ -330,6 +358,9 @@ namespace mongo {
         BSONObjSet _sort;
 
         bool dedup;
+
+        // Every child is sorted by diskloc, and we merge them in that order.
+        bool mergeByRecordId;
     };
 
     struct MergeSortNode : public QuerySolutionNode {
@@ -495,7 +526,7 @@ namespace mongo {
     };
 
     struct SortNode : public QuerySolutionNode {
-        SortNode() : limit(0) { }
+        SortNode() : limit(0), allowDiskUse(false) { }
         virtual ~SortNode() { }
 
         virtual StageType getType() const { return STAGE_SORT; }
@@ -526,6 +557,9 @@ namespace mongo {
 
         // Sum of both limit and skip count in the parsed query.
         size_t limit;
+
+        // May the sort spill to disk once it outgrows its memory limit?
+        bool allowDiskUse;
     };
 
     struct LimitNode : public QuerySolutionNode {
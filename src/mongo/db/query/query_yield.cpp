@@ -31,6 +31,7 @@
 #include "mongo/db/curop.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/storage/record_fetcher.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -60,7 +61,12 @@ namespace mongo {
         txn->getCurOp()->yielded();
 
         if (fetcher) {
+            Timer fetchTimer;
             fetcher->fetch();
+
+            OperationResourceStats* stats = txn->resourceStats();
+            stats->storageWaits++;
+            stats->storageWaitMicros += fetchTimer.micros();
         }
 
         locker->restoreLockState(snapshot);
@@ -31,6 +31,7 @@
 #include "mongo/db/query/stage_builder.h"
 
 #include "mongo/db/client.h"
+#include "mongo/db/exec/and_bitmap.h"
 #include "mongo/db/exec/and_hash.h"
 #include "mongo/db/exec/and_sorted.h"
 #include "mongo/db/exec/collection_scan.h"
@@ -68,6 +69,7 @@ namespace mongo {
             params.direction = (csn->direction == 1) ? CollectionScanParams::FORWARD
                                                      : CollectionScanParams::BACKWARD;
             params.maxScan = csn->maxScan;
+            params.borrowRecords = csn->borrowRecords;
             return new CollectionScan(txn, params, ws, csn->filter.get());
         }
         else if (STAGE_IXSCAN == root->getType()) {
@@ -109,6 +111,7 @@ namespace mongo {
             params.pattern = sn->pattern;
             params.query = sn->query;
             params.limit = sn->limit;
+            params.allowDiskUse = sn->allowDiskUse;
             return new SortStage(params, ws, childStage);
         }
         else if (STAGE_PROJECTION == root->getType()) {
@@ -148,6 +151,16 @@ namespace mongo {
             if (NULL == childStage) { return NULL; }
             return new SkipStage(sn->skip, ws, childStage);
         }
+        else if (STAGE_AND_BITMAP == root->getType()) {
+            const AndBitmapNode* abn = static_cast<const AndBitmapNode*>(root);
+            auto_ptr<AndBitmapStage> ret(new AndBitmapStage(ws, abn->filter.get(), collection));
+            for (size_t i = 0; i < abn->children.size(); ++i) {
+                PlanStage* childStage = buildStages(txn, collection, qsol, abn->children[i], ws);
+                if (NULL == childStage) { return NULL; }
+                ret->addChild(childStage);
+            }
+            return ret.release();
+        }
         else if (STAGE_AND_HASH == root->getType()) {
             const AndHashNode* ahn = static_cast<const AndHashNode*>(root);
             auto_ptr<AndHashStage> ret(new AndHashStage(ws, ahn->filter.get(), collection));
@@ -160,7 +173,8 @@ namespace mongo {
         }
         else if (STAGE_OR == root->getType()) {
             const OrNode * orn = static_cast<const OrNode*>(root);
-            auto_ptr<OrStage> ret(new OrStage(ws, orn->dedup, orn->filter.get()));
+            auto_ptr<OrStage> ret(new OrStage(ws, orn->dedup, orn->filter.get(), collection,
+                                              orn->mergeByRecordId));
             for (size_t i = 0; i < orn->children.size(); ++i) {
                 PlanStage* childStage = buildStages(txn, collection, qsol, orn->children[i], ws);
                 if (NULL == childStage) { return NULL; }
@@ -257,6 +271,7 @@ namespace mongo {
             params.index = index;
             params.spec = fam->getSpec();
             params.indexPrefix = node->indexPrefix;
+            params.limit = node->limit;
 
             const std::string& language = ("" == node->language
                                            ? fam->getSpec().defaultLanguage().str()
@@ -299,7 +314,7 @@ namespace mongo {
             params.direction = dn->direction;
             params.bounds = dn->bounds;
             params.fieldNo = dn->fieldNo;
-            return new DistinctScan(txn, params, ws);
+            return new DistinctScan(txn, params, ws, dn->filter.get());
         }
         else if (STAGE_COUNT_SCAN == root->getType()) {
             const CountNode* cn = static_cast<const CountNode*>(root);
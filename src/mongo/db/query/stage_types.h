@@ -34,6 +34,7 @@ namespace mongo {
      * These map to implementations of the PlanStage interface, all of which live in db/exec/
      */
     enum StageType {
+        STAGE_AND_BITMAP,
         STAGE_AND_HASH,
         STAGE_AND_SORTED,
         STAGE_CACHED_PLAN,
@@ -81,6 +82,10 @@ namespace mongo {
 
         STAGE_MULTI_PLAN,
         STAGE_OPLOG_START,
+
+        // Reads an oplog from the start found by STAGE_OPLOG_START or the oplogStartHack.
+        STAGE_OPLOG_SCAN,
+
         STAGE_OR,
         STAGE_PROJECTION,
 
@@ -190,9 +190,11 @@ namespace mongo {
 
     }
 
-    void RangeDeleter::startWorkers() {
-        if (!_worker) {
-            _worker.reset(new boost::thread(stdx::bind(&RangeDeleter::doWork, this)));
+    void RangeDeleter::startWorkers(size_t numWorkers) {
+        if (_workers.size() == 0) {
+            for (size_t i = 0; i < numWorkers; i++) {
+                _workers.create_thread(stdx::bind(&RangeDeleter::doWork, this));
+            }
         }
     }
 
@@ -202,9 +204,7 @@ namespace mongo {
             _stopRequested = true;
         }
 
-        if (_worker) {
-            _worker->join();
-        }
+        _workers.join_all();
 
         scoped_lock sl(_queueMutex);
         while (_deletesInProgress > 0) {
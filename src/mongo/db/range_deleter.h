@@ -61,8 +61,8 @@ namespace mongo {
      *
      * Threading assumptions:
      *
-     *   This class has (currently) one worker thread attacking the queue, one
-     *   job at a time. If we want an immediate deletion, that job is going to
+     *   This class has one or more worker threads attacking the queue, each
+     *   one job at a time. If we want an immediate deletion, that job is going to
      *   be performed on the thread that is requesting it.
      *
      *   All calls regarding deletion are synchronized.
@@ -97,15 +97,15 @@ namespace mongo {
         //
 
         /**
-         * Starts the background thread to work on this queue. Does nothing if the worker
-         * thread is already active.
+         * Starts 'numWorkers' background threads to work on this queue, each deleting one range
+         * at a time. Does nothing if the worker threads are already active.
          *
          * This call is _not_ thread safe and must be issued before any other call.
          */
-        void startWorkers();
+        void startWorkers(size_t numWorkers = 1);
 
         /**
-         * Stops the background thread working on this queue. This will block if there are
+         * Stops the background threads working on this queue. This will block if there are
          * tasks that are being deleted, but will leave the pending tasks in the queue.
          *
          * Steps:
@@ -187,7 +187,7 @@ namespace mongo {
 
         typedef std::set<NSMinMax*, NSMinMaxCmp> NSMinMaxSet; // owned here
 
-        /** Body of the worker thread */
+        /** Body of the worker threads */
         void doWork();
 
         /** Returns true if the range doesn't intersect with one other range */
@@ -201,8 +201,8 @@ namespace mongo {
 
         scoped_ptr<RangeDeleterEnv> _env;
 
-        // Initially not active. Must be started explicitly.
-        scoped_ptr<boost::thread> _worker;
+        // Initially empty. Must be started explicitly.
+        boost::thread_group _workers;
 
         // Protects _stopRequested.
         mutable mutex _stopMutex;
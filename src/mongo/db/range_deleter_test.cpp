@@ -404,4 +404,58 @@ namespace {
         mongo::repl::setGlobalReplicationCoordinator(NULL);
     }
 
+    // With several workers, queued deletes should be in progress at the same time.
+    TEST(QueuedDelete, ConcurrentWorkers) {
+        const string ns("test.user");
+
+        boost::scoped_ptr<mongo::repl::ReplicationCoordinatorMock> mock(
+            new mongo::repl::ReplicationCoordinatorMock(replSettings));
+
+        mongo::repl::setGlobalReplicationCoordinator(mock.get());
+
+        RangeDeleterMockEnv* env = new RangeDeleterMockEnv();
+        RangeDeleter deleter(env);
+
+        deleter.startWorkers(2);
+        env->pauseDeletes();
+
+        Notification notifyDone1;
+        ASSERT_TRUE(deleter.queueDelete(noTxn,
+                                        RangeDeleterOptions(KeyRange(ns,
+                                                                     BSON("x" << 10),
+                                                                     BSON("x" << 20),
+                                                                     BSON("x" << 1))),
+                                        &notifyDone1,
+                                        NULL /* don't care errMsg */));
+
+        Notification notifyDone2;
+        ASSERT_TRUE(deleter.queueDelete(noTxn,
+                                        RangeDeleterOptions(KeyRange(ns,
+                                                                     BSON("x" << 20),
+                                                                     BSON("x" << 30),
+                                                                     BSON("x" << 1))),
+                                        &notifyDone2,
+                                        NULL /* don't care errMsg */));
+
+        // Both deletes get paused inside the env, one on each worker.
+        env->waitForNthPausedDelete(2u);
+        ASSERT_EQUALS(0U, deleter.getPendingDeletes());
+        ASSERT_EQUALS(2U, deleter.getDeletesInProgress());
+
+        // Resume them one at a time, since a resumed delete pauses the env again.
+        env->resumeOneDelete();
+        while (deleter.getDeletesInProgress() > 1U) {
+            mongo::sleepmillis(10);
+        }
+        env->resumeOneDelete();
+
+        notifyDone1.waitToBeNotified();
+        notifyDone2.waitToBeNotified();
+        ASSERT_EQUALS(0U, deleter.getTotalDeletes());
+
+        deleter.stopWorkers();
+
+        mongo::repl::setGlobalReplicationCoordinator(NULL);
+    }
+
 } // unnamed namespace
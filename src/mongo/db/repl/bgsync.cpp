@@ -44,9 +44,11 @@
 #include "mongo/db/repl/repl_coordinator_impl.h"
 #include "mongo/db/repl/rs_rollback.h"
 #include "mongo/db/repl/rs_sync.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
 
@@ -90,6 +92,41 @@ namespace {
     static ServerStatusMetricField<int> displayBufferMaxSize( "repl.buffer.maxSizeBytes",
                                                                 &bufferMaxSizeGauge );
 
+namespace {
+    // The buffer has to be able to hold at least one full batch from the sync source
+    const int kMinBufferMaxSizeBytes = BSONObjMaxInternalSize;
+
+    class ReplBufferMaxSizeBytesParameter : public ExportedServerParameter<int> {
+    public:
+        ReplBufferMaxSizeBytesParameter() :
+            ExportedServerParameter<int>(ServerParameterSet::getGlobal(),
+                                         "replBufferMaxSizeBytes",
+                                         &bufferMaxSizeGauge,
+                                         true,
+                                         true) {}
+
+        virtual Status validate(const int& potentialNewValue) {
+            if (potentialNewValue < kMinBufferMaxSizeBytes) {
+                return Status(ErrorCodes::BadValue,
+                              str::stream() << name() << " must be at least "
+                                            << kMinBufferMaxSizeBytes);
+            }
+            return Status::OK();
+        }
+
+        // Without this the compiler complains that defining set(const int&)
+        // hides set(const BSONElement&)
+        using ExportedServerParameter<int>::set;
+
+        virtual Status set(const int& newValue) {
+            Status status = ExportedServerParameter<int>::set(newValue);
+            if (status.isOK()) {
+                BackgroundSync::setBufferMaxSizeBytes(newValue);
+            }
+            return status;
+        }
+    } replBufferMaxSizeBytesParameter;
+} // namespace
 
     BackgroundSyncInterface::~BackgroundSyncInterface() {}
 
@@ -98,7 +135,7 @@ namespace {
         return static_cast<size_t>(o.objsize());
     }
 
-    BackgroundSync::BackgroundSync() : _buffer(bufferMaxSizeGauge, &getSize),
+    BackgroundSync::BackgroundSync() : _buffer(bufferMaxSizeGauge),
                                        _lastOpTimeFetched(std::numeric_limits<int>::max(),
                                                           0),
                                        _lastAppliedHash(0),
@@ -118,6 +155,13 @@ namespace {
         return s_instance;
     }
 
+    void BackgroundSync::setBufferMaxSizeBytes(size_t maxSizeBytes) {
+        boost::unique_lock<boost::mutex> lock(s_mutex);
+        if (s_instance) {
+            s_instance->_buffer.setMaxSize(maxSizeBytes);
+        }
+    }
+
     void BackgroundSync::shutdown() {
         boost::lock_guard<boost::mutex> lock(_mutex);
 
@@ -326,9 +370,16 @@ namespace {
             }
 
             // At this point, we are guaranteed to have at least one thing to read out
-            // of the oplogreader cursor.
-            BSONObj o = _syncSourceReader.nextSafe().getOwned();
-            opsReadStats.increment();
+            // of the oplogreader cursor. Hand the rest of the current network batch to the
+            // buffer in one piece. The ops point into the cursor's reply message, which stays
+            // valid until the next call to more(), and get copied by the buffer.
+            std::vector<BSONObj> ops;
+            size_t opsSizeBytes = 0;
+            while (_syncSourceReader.moreInCurrentBatch()) {
+                ops.push_back(_syncSourceReader.nextSafe());
+                opsSizeBytes += getSize(ops.back());
+            }
+            opsReadStats.increment(ops.size());
 
             {
                 boost::unique_lock<boost::mutex> lock(_mutex);
@@ -339,14 +390,15 @@ namespace {
                 LOG(2) << "bgsync buffer has " << _buffer.size() << " bytes";
             }
 
-            bufferCountGauge.increment();
-            bufferSizeGauge.increment(getSize(o));
-            _buffer.push(o);
+            bufferCountGauge.increment(ops.size());
+            bufferSizeGauge.increment(opsSizeBytes);
+            _buffer.pushBatch(ops);
 
             {
+                const BSONObj& lastOp = ops.back();
                 boost::unique_lock<boost::mutex> lock(_mutex);
-                _lastFetchedHash = o["h"].numberLong();
-                _lastOpTimeFetched = o["ts"]._opTime();
+                _lastFetchedHash = lastOp["h"].numberLong();
+                _lastOpTimeFetched = lastOp["ts"]._opTime();
                 LOG(3) << "replSet lastOpTimeFetched: " << _lastOpTimeFetched.toStringPretty();
             }
         }
@@ -365,14 +417,14 @@ namespace {
 
 
     bool BackgroundSync::peek(BSONObj* op) {
-        return _buffer.peek(*op);
+        return _buffer.peek(op);
     }
 
     void BackgroundSync::waitForMore() {
         BSONObj op;
         // Block for one second before timing out.
         // Ignore the value of the op we peeked at.
-        _buffer.blockingPeek(op, 1);
+        _buffer.blockingPeek(&op, 1);
     }
 
     void BackgroundSync::consume() {
@@ -30,7 +30,7 @@
 
 #include <boost/thread/mutex.hpp>
 
-#include "mongo/util/queue.h"
+#include "mongo/db/repl/oplog_buffer.h"
 #include "mongo/db/repl/oplogreader.h"
 #include "mongo/db/jsobj.h"
 
@@ -75,6 +75,9 @@ namespace repl {
 
         static BackgroundSync* get();
 
+        // Changes the byte budget of the fetched ops buffer, if the producer already exists
+        static void setBufferMaxSizeBytes(size_t maxSizeBytes);
+
         // stop syncing (when this node becomes a primary, e.g.)
         void stop();
 
@@ -122,7 +125,7 @@ namespace repl {
         static boost::mutex s_mutex;
 
         // Production thread
-        BlockingQueue<BSONObj> _buffer;
+        OplogBuffer _buffer;
         OplogReader _syncSourceReader;
 
         // _mutex protects all of the class variables except _syncSourceReader and _buffer
@@ -31,23 +31,105 @@
 #include "mongo/platform/basic.h"
 
 #include "mongo/db/repl/multicmd.h"
-#include "mongo/db/repl/scoped_conn.h"
 
+#include <map>
+#include <set>
+#include <vector>
+
+#include "mongo/base/owned_pointer_vector.h"
+#include "mongo/db/query/lite_parsed_query.h"
+#include "mongo/db/repl/scoped_conn.h"
+#include "mongo/s/bson_serializable.h"
+#include "mongo/s/dbclient_multi_command.h"
 #include "mongo/util/log.h"
 
 namespace mongo {
 
 namespace repl {
 
-    void _MultiCommandJob::run() {
-        try {
-            ScopedConn c(d.toHost);
-            LOG(1) << "multiCommand running on host " << d.toHost;
-            d.ok = c.runCommand("admin", cmd, d.result);
+    void multiCommand(BSONObj cmd, std::list<Target>& L) {
+        // Commands to the same host share its connection and come back in order.  The map also
+        // locks the connections in a fixed order, so concurrent calls can't deadlock.
+        typedef std::map<ConnectionString, std::vector<Target*> > TargetsByHost;
+        TargetsByHost targets;
+        std::map<std::string, ConnectionString> endpoints;
+        for (std::list<Target>::iterator i = L.begin(); i != L.end(); i++) {
+            try {
+                std::map<std::string, ConnectionString>::iterator found =
+                    endpoints.find(i->toHost);
+                if (found == endpoints.end()) {
+                    found = endpoints.insert(
+                        std::make_pair(i->toHost, ConnectionString(HostAndPort(i->toHost)))).first;
+                }
+                targets[found->second].push_back(&*i);
+            }
+            catch (const DBException& e) {
+                LOG(1) << "dev caught " << e.what() << " on multiCommand to " << i->toHost;
+            }
+        }
+
+        DBClientMultiCommand dispatcher;
+        StatusWith<int> maxTimeMS = LiteParsedQuery::parseMaxTimeMSCommand(cmd);
+        if (maxTimeMS.isOK()) {
+            dispatcher.setMaxTimeMillis(maxTimeMS.getValue());
+        }
+
+        // ScopedConns hold their connection until destroyed, after every response is read.
+        OwnedPointerVector<ScopedConn> conns;
+        std::map<ConnectionString, ScopedConn*> connsByHost;
+        for (TargetsByHost::const_iterator it = targets.begin(); it != targets.end(); ++it) {
+            const std::string& host = it->second.front()->toHost;
+            try {
+                conns.push_back(new ScopedConn(host));
+            }
+            catch (const DBException& e) {
+                LOG(1) << "dev caught " << e.what() << " on multiCommand to " << host;
+                continue;
+            }
+
+            connsByHost[it->first] = conns.vector().back();
+            LOG(1) << "multiCommand running on host " << host;
+            for (size_t j = 0; j < it->second.size(); j++) {
+                dispatcher.addCommand(it->first,
+                                      "admin",
+                                      RawBSONSerializable(cmd),
+                                      conns.vector().back()->get());
+            }
+        }
+        dispatcher.sendAll();
+
+        std::map<ConnectionString, size_t> numReceived;
+        std::set<ConnectionString> abandoned;
+        while (dispatcher.numPending() > 0) {
+            ConnectionString endpoint;
+            RawBSONSerializable response;
+            Status status = dispatcher.recvAny(&endpoint, &response);
+            Target& d = *targets[endpoint][numReceived[endpoint]++];
+
+            if (!status.isOK()) {
+                LOG(1) << "dev caught " << status.toString() << " on multiCommand to "
+                       << d.toHost;
+
+                if (status.code() == ErrorCodes::ExceededTimeLimit) {
+                    abandoned.insert(endpoint);
+                }
+                continue;
+            }
+
+            d.result = response.toBSON();
+            d.ok = d.result["ok"].trueValue();
             LOG(1) << "multiCommand response: " << d.result;
         }
-        catch (const DBException& e) {
-            LOG(1) << "dev caught " << e.what() << " on multiCommand to " << d.toHost;
+
+        // An abandoned response leaves the connection shut down, so replace it for next time.
+        for (std::set<ConnectionString>::const_iterator it = abandoned.begin();
+             it != abandoned.end(); ++it) {
+            try {
+                connsByHost[*it]->reconnect();
+            }
+            catch (const DBException& e) {
+                LOG(1) << "could not reconnect to " << it->toString() << causedBy(e);
+            }
         }
     }
 
@@ -33,7 +33,6 @@
 #include <list>
 
 #include "mongo/db/jsobj.h"
-#include "mongo/util/background.h"
 
 namespace mongo {
 namespace repl {
@@ -47,37 +46,13 @@ namespace repl {
     };
 
     /** send a command to several servers in parallel.  waits for all to complete before 
-        returning.  
+        returning.  the requests all go out first and the responses are read as they arrive,
+        without a thread per server.  a maxTimeMS in 'cmd' bounds the wait as a whole.
         
         in: Target::toHost
         out: Target::result and Target::ok
     */
     void multiCommand(BSONObj cmd, std::list<Target>& L);
 
-    class _MultiCommandJob : public BackgroundJob {
-    public:
-        BSONObj& cmd;
-        Target& d;
-        _MultiCommandJob(BSONObj& _cmd, Target& _d) : cmd(_cmd), d(_d) { }
-
-    private:
-        std::string name() const { return "MultiCommandJob"; }
-        void run();
-    };
-
-    inline void multiCommand(BSONObj cmd, std::list<Target>& L) {
-        std::list< shared_ptr<BackgroundJob> > jobs;
-
-        for( std::list<Target>::iterator i = L.begin(); i != L.end(); i++ ) {
-            Target& d = *i;
-            _MultiCommandJob *j = new _MultiCommandJob(cmd, d);
-            jobs.push_back( shared_ptr<BackgroundJob>(j) );
-            j->go();
-        }
-
-        for( std::list< shared_ptr<BackgroundJob> >::iterator i = jobs.begin(); i != jobs.end(); i++ ) {
-            (*i)->wait();
-        }
-    }
 } // namespace repl
 } // namespace mongo
@@ -42,6 +42,7 @@
 #include "mongo/db/concurrency/d_concurrency.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/repl/scoped_conn.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/platform/unordered_map.h"
 #include "mongo/stdx/functional.h"
 #include "mongo/stdx/list.h"
@@ -60,6 +61,9 @@ namespace {
     const Seconds kMaxIdleThreadAge(30);
     const Seconds kMaxConnectionAge(30);
 
+    // Requests run concurrently against one remote node; 0 means no limit.
+    MONGO_EXPORT_SERVER_PARAMETER(replNetworkMaxRequestsPerHost, int, 4);
+
 }  // namespace
 
     /**
@@ -475,9 +479,53 @@ namespace {
         LOG(1) << "thread shutting down";
     }
 
+    NetworkInterfaceImpl::CommandDataList::iterator
+    NetworkInterfaceImpl::_getNextRunnableRequest_inlock(const Date_t nowDate,
+                                                         Date_t* nextExpiration) {
+        const int maxPerHost = replNetworkMaxRequestsPerHost;
+        CommandDataList::iterator iter;
+        for (iter = _pending.begin(); iter != _pending.end(); ++iter) {
+            if (maxPerHost <= 0) {
+                break;
+            }
+            const HostRequestCountMap::const_iterator active =
+                _numActiveRequestsByTarget.find(iter->request.target);
+            if (active == _numActiveRequestsByTarget.end() ||
+                    active->second < static_cast<size_t>(maxPerHost)) {
+                break;
+            }
+            const Date_t expDate = iter->request.expirationDate;
+            if (expDate == ReplicationExecutor::kNoExpirationDate) {
+                continue;
+            }
+            if (expDate <= nowDate) {
+                break;
+            }
+            if (*nextExpiration == ReplicationExecutor::kNoExpirationDate ||
+                    expDate < *nextExpiration) {
+                *nextExpiration = expDate;
+            }
+        }
+        return iter;
+    }
+
     void NetworkInterfaceImpl::_consumeNetworkRequests() {
         boost::unique_lock<boost::mutex> lk(_mutex);
         while (!_inShutdown) {
+            Date_t nextExpiration = ReplicationExecutor::kNoExpirationDate;
+            const CommandDataList::iterator next =
+                _getNextRunnableRequest_inlock(now(), &nextExpiration);
+            if (next == _pending.end() && !_pending.empty()) {
+                // Every pending request targets a node that is already at its limit; wait for
+                // one of those requests to finish or for a waiting one to expire.
+                if (nextExpiration == ReplicationExecutor::kNoExpirationDate) {
+                    _hasPending.timed_wait(lk, kMaxIdleThreadAge);
+                }
+                else {
+                    _hasPending.timed_wait(lk, Milliseconds(nextExpiration - now()));
+                }
+                continue;
+            }
             if (_pending.empty()) {
                 if (_threads.size() > kMinThreads) {
                     const Date_t nowDate = now();
@@ -491,9 +539,10 @@ namespace {
                 _hasPending.timed_wait(lk, kMaxIdleThreadAge);
                 continue;
             }
-            CommandData todo = _pending.front();
-            _pending.pop_front();
+            CommandData todo = *next;
+            _pending.erase(next);
             ++_numActiveNetworkRequests;
+            ++_numActiveRequestsByTarget[todo.request.target];
             --_numIdleThreads;
             lk.unlock();
             ResponseStatus result = _runCommand(todo.request);
@@ -502,6 +551,15 @@ namespace {
             todo.onFinish(result);
             lk.lock();
             --_numActiveNetworkRequests;
+            const HostRequestCountMap::iterator active =
+                _numActiveRequestsByTarget.find(todo.request.target);
+            if (--active->second == 0) {
+                _numActiveRequestsByTarget.erase(active);
+            }
+            if (!_pending.empty()) {
+                // A request held back by this node's limit may be able to run now.
+                _hasPending.notify_one();
+            }
             ++_numIdleThreads;
             _signalWorkAvailable_inlock();
         }
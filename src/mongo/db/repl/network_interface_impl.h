@@ -37,6 +37,7 @@
 #include <vector>
 
 #include "mongo/db/repl/replication_executor.h"
+#include "mongo/platform/unordered_map.h"
 #include "mongo/stdx/list.h"
 
 namespace mongo {
@@ -65,6 +66,11 @@ namespace repl {
      * The implementation also manages a pool of network connections to recently contacted remote
      * nodes.  The size of this pool is not bounded, but connections are retired unconditionally
      * after they have been connected for a certain maximum period.
+     *
+     * At most replNetworkMaxRequestsPerHost requests run against any one remote node at a time,
+     * so that a few slow or unreachable nodes cannot occupy every worker thread and delay the
+     * heartbeats to all the others.  Requests to a node at its limit wait in _pending, except
+     * that a request whose expiration date has passed is run right away to fail it promptly.
      */
     class NetworkInterfaceImpl : public ReplicationExecutor::NetworkInterface {
     public:
@@ -99,6 +105,7 @@ namespace repl {
             RemoteCommandCompletionFn onFinish;
         };
         typedef stdx::list<CommandData> CommandDataList;
+        typedef unordered_map<HostAndPort, size_t> HostRequestCountMap;
         typedef std::vector<boost::shared_ptr<boost::thread> > ThreadList;
 
         /**
@@ -113,6 +120,14 @@ namespace repl {
          */
         void _consumeNetworkRequests();
 
+        /**
+         * Returns the first request in _pending which may run now, or _pending.end() if none may.
+         * If none may, sets "nextExpiration" to the earliest expiration date of the waiting
+         * requests, or leaves it alone if none of them expire.
+         */
+        CommandDataList::iterator _getNextRunnableRequest_inlock(Date_t nowDate,
+                                                                 Date_t* nextExpiration);
+
         /**
          * Synchronously invokes the command described by "request".
          */
@@ -167,6 +182,9 @@ namespace repl {
 
         // Number of active network requests
         size_t _numActiveNetworkRequests;
+
+        // Number of active network requests to each remote node, without zero entries.
+        HostRequestCountMap _numActiveRequestsByTarget;
     };
 
 }  // namespace repl
@@ -97,52 +97,65 @@ namespace repl {
     }
 
     // so we can fail the same way
-    void checkOplogInsert( StatusWith<RecordId> result ) {
+    void checkOplogInsert( const Status& status ) {
         massert( 17322,
-                 str::stream() << "write to oplog failed: " << result.getStatus().toString(),
-                 result.isOK() );
+                 str::stream() << "write to oplog failed: " << status.toString(),
+                 status.isOK() );
+    }
+
+    void checkOplogInsert( StatusWith<RecordId> result ) {
+        checkOplogInsert( result.getStatus() );
     }
 
 
     /**
-     * @param hashNewOut optional - set to a new hash value if needed
+     * Reserves 'count' consecutive OpTimes for 'opstr' entries on 'ns' and appends each, with
+     * the hash of its entry, to 'slots'.  newOpMutex is taken once for the whole range.
      */
-    std::pair<OpTime,long long> getNextOpTime(OperationContext* txn,
-                                              Collection* oplog,
-                                              const char* ns,
-                                              ReplicationCoordinator* replCoord,
-                                              const char* opstr ) {
+    static void getNextOpTimes(OperationContext* txn,
+                               Collection* oplog,
+                               const char* ns,
+                               ReplicationCoordinator* replCoord,
+                               const char* opstr,
+                               unsigned count,
+                               std::vector<std::pair<OpTime,long long> >* slots) {
         mutex::scoped_lock lk(newOpMutex);
-        OpTime ts = getNextGlobalOptime();
+        const OpTime first = getNextGlobalOptimes(count);
         newOptimeNotifier.notify_all();
 
-        fassert(28560, oplog->getRecordStore()->oplogDiskLocRegister(txn, ts));
+        long long hashNew = replCoord ? BackgroundSync::get()->getLastAppliedHash() : 0;
 
-        long long hashNew;
-
-        if (replCoord) {
-
-            hashNew = BackgroundSync::get()->getLastAppliedHash();
+        // Check to make sure logOp() is legal at this point.
+        if (replCoord && *opstr == 'n') {
+            // 'n' operations are always logged
+            invariant(*ns == '\0');
+        }
 
-            // Check to make sure logOp() is legal at this point.
-            if (*opstr == 'n') {
-                // 'n' operations are always logged
-                invariant(*ns == '\0');
+        for (unsigned i = 0; i < count; i++) {
+            const OpTime ts(first.getSecs(), first.getInc() + i);
+            fassert(28560, oplog->getRecordStore()->oplogDiskLocRegister(txn, ts));
 
-                // 'n' operations do not advance the hash, since they are not rolled back
-            }
-            else {
-                // Advance the hash
+            // 'n' operations do not advance the hash, since they are not rolled back
+            if (replCoord && *opstr != 'n') {
                 hashNew = (hashNew * 131 + ts.asLL()) * 17 + replCoord->getMyId();
-
-                BackgroundSync::get()->setLastAppliedHash(hashNew);
             }
+
+            slots->push_back(std::pair<OpTime,long long>(ts, hashNew));
         }
-        else {
-            hashNew = 0;
+
+        if (replCoord && *opstr != 'n') {
+            BackgroundSync::get()->setLastAppliedHash(hashNew);
         }
+    }
 
-        return std::pair<OpTime,long long>(ts, hashNew);
+    std::pair<OpTime,long long> getNextOpTime(OperationContext* txn,
+                                              Collection* oplog,
+                                              const char* ns,
+                                              ReplicationCoordinator* replCoord,
+                                              const char* opstr ) {
+        std::vector<std::pair<OpTime,long long> > slots;
+        getNextOpTimes(txn, oplog, ns, replCoord, opstr, 1, &slots);
+        return slots[0];
     }
 
     /** write an op to the oplog that is already built.
@@ -323,6 +336,71 @@ namespace repl {
 
     }
 
+    /**
+     * Writes one oplog entry per element of 'objs', all of type 'opstr' on 'ns', with
+     * consecutive OpTimes reserved together and a single multi-record insert.  Unlike
+     * _logOpRS() each entry is built whole before it is written, as the batch insert takes
+     * complete records.
+     */
+    static void _logOpsRS(OperationContext* txn,
+                          const char *opstr,
+                          const char *ns,
+                          const std::vector<BSONObj>& objs,
+                          bool fromMigrate) {
+        if ( strncmp(ns, "local.", 6) == 0 ) {
+            return;
+        }
+
+        ScopedTransaction transaction(txn, MODE_IX);
+        Lock::DBLock lk(txn->lockState(), "local", MODE_IX);
+        Lock::CollectionLock lk2(txn->lockState(), rsoplog, MODE_IX);
+
+        if ( localOplogRSCollection == 0 ) {
+            Client::Context ctx(txn, rsoplog);
+            localDB = ctx.db();
+            invariant( localDB );
+            localOplogRSCollection = localDB->getCollection( txn, rsoplog );
+            massert(13347,
+                    "local.oplog.rs missing. did you drop it? if so restart server",
+                    localOplogRSCollection);
+        }
+
+        ReplicationCoordinator* replCoord = getGlobalReplicationCoordinator();
+        if (ns[0] && !replCoord->canAcceptWritesForDatabase(nsToDatabaseSubstring(ns))) {
+            severe() << "replSet error : logOp() but can't accept write to collection " << ns;
+            fassertFailed(17405);
+        }
+
+        Client::Context ctx(txn, rsoplog, localDB);
+        WriteUnitOfWork wunit(txn);
+
+        std::vector<std::pair<OpTime,long long> > slots;
+        slots.reserve(objs.size());
+        getNextOpTimes(txn, localOplogRSCollection, ns, replCoord, opstr, objs.size(), &slots);
+
+        std::vector<BSONObj> entries;
+        entries.reserve(objs.size());
+        for (size_t i = 0; i < objs.size(); i++) {
+            BSONObjBuilder b(256 + objs[i].objsize());
+            b.appendTimestamp("ts", slots[i].first.asDate());
+            b.append("h", slots[i].second);
+            b.append("v", OPLOG_VERSION);
+            b.append("op", opstr);
+            b.append("ns", ns);
+            if (fromMigrate)
+                b.appendBool("fromMigrate", true);
+            b.append("o", objs[i]);
+            entries.push_back(b.obj());
+        }
+
+        checkOplogInsert( localOplogRSCollection->insertDocuments( txn, entries, false ) );
+
+        ctx.getClient()->setLastOp( slots.back().first );
+        replCoord->setMyLastOptime(slots.back().first);
+
+        wunit.commit();
+    }
+
     static void _logOpOld(OperationContext* txn,
                           const char *opstr,
                           const char *ns,
@@ -461,6 +539,61 @@ namespace repl {
         }
     }
 
+    void logOps(OperationContext* txn,
+                const char* opstr,
+                const char* ns,
+                const std::vector<BSONObj>& objs,
+                bool fromMigrate) {
+        if (objs.empty()) {
+            return;
+        }
+
+        // Master/slave, and a single op, take the regular path.
+        if (objs.size() == 1 || _logOp != _logOpRS ||
+                !getGlobalReplicationCoordinator()->isReplEnabled()) {
+            for (size_t i = 0; i < objs.size(); i++) {
+                logOp(txn, opstr, ns, objs[i], NULL, NULL, fromMigrate);
+            }
+            return;
+        }
+
+        try {
+            // TODO SERVER-15192 remove this once all listeners are rollback-safe.
+            class RollbackPreventer : public RecoveryUnit::Change {
+                virtual void commit() {}
+                virtual void rollback() {
+                    severe() << "Rollback of logOp not currently allowed (SERVER-15192)";
+                    fassertFailed(18805);
+                }
+            };
+            txn->recoveryUnit()->registerChange(new RollbackPreventer());
+
+            _logOpsRS(txn, opstr, ns, objs, fromMigrate);
+
+            for (size_t i = 0; i < objs.size(); i++) {
+                logOpForSharding(txn, opstr, ns, objs[i], NULL, fromMigrate);
+                logOpForDbHash(ns);
+                getGlobalAuthorizationManager()->logOp(opstr, ns, objs[i], NULL, NULL);
+            }
+
+            if ( strstr( ns, ".system.js" ) ) {
+                Scope::storedFuncMod(); // this is terrible
+            }
+        }
+        catch (const DBException& ex) {
+            severe() << "Fatal DBException in logOps(): " << ex.toString();
+            std::terminate();
+        }
+        catch (const std::exception& ex) {
+            severe() << "Fatal std::exception in logOps(): " << ex.what();
+            std::terminate();
+        }
+        catch (...) {
+            severe() << "Fatal error in logOps()";
+            std::terminate();
+        }
+    }
+
     void createOplog(OperationContext* txn) {
         ScopedTransaction transaction(txn, MODE_X);
         Lock::GlobalWrite lk(txn->lockState());
@@ -30,6 +30,7 @@
 
 #include <cstddef>
 #include <string>
+#include <vector>
 
 namespace mongo {
     class BSONObj;
@@ -79,6 +80,17 @@ namespace repl {
                 bool *b = NULL,
                 bool fromMigrate = false);
 
+    /**
+     * Logs one 'opstr' operation on 'ns' for each element of 'objs', in order, as logOp() would
+     * with no 'patt' or 'b'.  On a replica set the entries get consecutive OpTimes, reserved
+     * together, and are written to the oplog with a single insert.
+     */
+    void logOps(OperationContext* txn,
+                const char* opstr,
+                const char* ns,
+                const std::vector<BSONObj>& objs,
+                bool fromMigrate = false);
+
     // Log an empty no-op operation to the local oplog
     void logKeepalive(OperationContext* txn);
 
@@ -0,0 +1,169 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/repl/oplog_buffer.h"
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/thread_time.hpp>
+#include <cstring>
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+namespace repl {
+
+    OplogBuffer::OplogBuffer(size_t maxSizeBytes) : _maxSizeBytes(maxSizeBytes),
+                                                    _sizeBytes(0),
+                                                    _count(0) {
+    }
+
+    void OplogBuffer::pushBatch(const std::vector<BSONObj>& ops) {
+        if (ops.empty()) {
+            return;
+        }
+
+        size_t sizeBytes = 0;
+        for (std::vector<BSONObj>::const_iterator it = ops.begin(); it != ops.end(); ++it) {
+            sizeBytes += static_cast<size_t>(it->objsize());
+        }
+
+        // Copy outside of the mutex so the applier is not held up by it
+        Batch batch;
+        batch.data = SharedBuffer::allocate(sizeBytes);
+        batch.sizeBytes = sizeBytes;
+        batch.headOffset = 0;
+        batch.remaining = ops.size();
+
+        char* dest = batch.data.get();
+        for (std::vector<BSONObj>::const_iterator it = ops.begin(); it != ops.end(); ++it) {
+            memcpy(dest, it->objdata(), it->objsize());
+            dest += it->objsize();
+        }
+
+        UniqueLock lk(_mutex);
+        while (!_batches.empty() && (_sizeBytes + sizeBytes > _maxSizeBytes)) {
+            _notFull.wait(lk);
+        }
+
+        _batches.push_back(batch);
+        _sizeBytes += sizeBytes;
+        _count += ops.size();
+        _notEmpty.notify_one();
+    }
+
+    bool OplogBuffer::peek(BSONObj* op) const {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        if (_batches.empty()) {
+            return false;
+        }
+
+        *op = _head_inlock();
+        return true;
+    }
+
+    bool OplogBuffer::blockingPeek(BSONObj* op, int maxSecondsToWait) const {
+        const boost::system_time deadline =
+            boost::get_system_time() + boost::posix_time::seconds(maxSecondsToWait);
+
+        UniqueLock lk(_mutex);
+        while (_batches.empty()) {
+            if (!_notEmpty.timed_wait(lk, deadline)) {
+                return false;
+            }
+        }
+
+        *op = _head_inlock();
+        return true;
+    }
+
+    BSONObj OplogBuffer::blockingPop() {
+        UniqueLock lk(_mutex);
+        while (_batches.empty()) {
+            _notEmpty.wait(lk);
+        }
+
+        const BSONObj op = _head_inlock();
+        _count--;
+
+        Batch& head = _batches.front();
+        head.headOffset += op.objsize();
+        head.remaining--;
+
+        if (head.remaining == 0) {
+            invariant(head.headOffset == head.sizeBytes);
+            _sizeBytes -= head.sizeBytes;
+            _batches.pop_front();
+            _notFull.notify_one();
+        }
+
+        return op;
+    }
+
+    void OplogBuffer::clear() {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        _batches.clear();
+        _sizeBytes = 0;
+        _count = 0;
+        _notFull.notify_one();
+    }
+
+    bool OplogBuffer::empty() const {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        return _batches.empty();
+    }
+
+    size_t OplogBuffer::size() const {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        return _sizeBytes;
+    }
+
+    size_t OplogBuffer::count() const {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        return _count;
+    }
+
+    size_t OplogBuffer::maxSize() const {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        return _maxSizeBytes;
+    }
+
+    void OplogBuffer::setMaxSize(size_t maxSizeBytes) {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        _maxSizeBytes = maxSizeBytes;
+        _notFull.notify_one();
+    }
+
+    BSONObj OplogBuffer::_head_inlock() const {
+        const Batch& head = _batches.front();
+        return BSONObj(head.data.get() + head.headOffset, head.data);
+    }
+
+} // namespace repl
+} // namespace mongo
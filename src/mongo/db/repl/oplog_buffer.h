@@ -0,0 +1,134 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <deque>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/util/shared_buffer.h"
+
+namespace mongo {
+namespace repl {
+
+    /**
+     * Byte-bounded queue of oplog entries between the BackgroundSync producer and the SyncTail
+     * applier.
+     *
+     * Entries are stored as the batches in which they were received from the sync source. Each
+     * batch is copied once into a single SharedBuffer, and the BSONObjs handed out to the applier
+     * point into that buffer and share its ownership, so no per-op allocation or copy happens
+     * between the network and the applier. A batch's memory is released once all of its ops have
+     * been popped and the last BSONObj referencing it goes away.
+     *
+     * Supports one producer and one consumer.
+     */
+    class OplogBuffer {
+        MONGO_DISALLOW_COPYING(OplogBuffer);
+    public:
+        explicit OplogBuffer(size_t maxSizeBytes);
+
+        /**
+         * Appends the given ops as one batch, blocking while the buffer is over its byte budget.
+         * A batch is always accepted into an empty buffer, so one batch larger than the budget
+         * cannot stall the producer forever. The ops do not need to be owned, since they are
+         * copied before this returns.
+         */
+        void pushBatch(const std::vector<BSONObj>& ops);
+
+        /**
+         * Returns the op at the head of the buffer without removing it, or false if the buffer
+         * is empty.
+         */
+        bool peek(BSONObj* op) const;
+
+        /**
+         * Like peek(), but waits up to maxSecondsToWait for an op to show up.
+         */
+        bool blockingPeek(BSONObj* op, int maxSecondsToWait) const;
+
+        /**
+         * Removes and returns the op at the head of the buffer, waiting for one if necessary.
+         */
+        BSONObj blockingPop();
+
+        /**
+         * Drops all buffered ops.
+         */
+        void clear();
+
+        bool empty() const;
+
+        /**
+         * Bytes of BSON held by the buffered batches, including ops of the head batch which have
+         * already been popped but whose memory is still held by the batch.
+         */
+        size_t size() const;
+
+        /**
+         * Number of ops which have not been popped yet.
+         */
+        size_t count() const;
+
+        size_t maxSize() const;
+
+        /**
+         * Changes the byte budget. Takes effect immediately for a producer waiting for space.
+         */
+        void setMaxSize(size_t maxSizeBytes);
+
+    private:
+        struct Batch {
+            SharedBuffer data;
+            size_t sizeBytes;
+
+            // Offset of the next op to be popped and number of ops starting there
+            size_t headOffset;
+            size_t remaining;
+        };
+
+        typedef boost::unique_lock<boost::mutex> UniqueLock;
+
+        BSONObj _head_inlock() const;
+
+        mutable boost::mutex _mutex;
+        mutable boost::condition_variable _notEmpty;
+        boost::condition_variable _notFull;
+
+        std::deque<Batch> _batches;
+        size_t _maxSizeBytes;
+        size_t _sizeBytes;
+        size_t _count;
+    };
+
+} // namespace repl
+} // namespace mongo
@@ -0,0 +1,164 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <boost/thread/thread.hpp>
+
+#include "mongo/db/repl/oplog_buffer.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/time_support.h"
+
+namespace {
+
+    using mongo::BSONObj;
+    using mongo::repl::OplogBuffer;
+
+    std::vector<BSONObj> makeBatch(int first, int count) {
+        std::vector<BSONObj> batch;
+        for (int i = first; i < first + count; i++) {
+            batch.push_back(BSON("ts" << i << "o" << BSON("_id" << i)));
+        }
+        return batch;
+    }
+
+    size_t batchSize(const std::vector<BSONObj>& batch) {
+        size_t size = 0;
+        for (size_t i = 0; i < batch.size(); i++) {
+            size += batch[i].objsize();
+        }
+        return size;
+    }
+
+    TEST(OplogBuffer, PopsOpsInOrderAcrossBatches) {
+        OplogBuffer buffer(1024 * 1024);
+        ASSERT_TRUE(buffer.empty());
+
+        buffer.pushBatch(makeBatch(0, 3));
+        buffer.pushBatch(makeBatch(3, 2));
+        ASSERT_EQUALS(5U, buffer.count());
+
+        for (int i = 0; i < 5; i++) {
+            BSONObj peeked;
+            ASSERT_TRUE(buffer.peek(&peeked));
+            ASSERT_EQUALS(i, peeked["ts"].numberInt());
+
+            BSONObj popped = buffer.blockingPop();
+            ASSERT_EQUALS(peeked, popped);
+        }
+
+        ASSERT_TRUE(buffer.empty());
+        ASSERT_EQUALS(0U, buffer.count());
+        ASSERT_EQUALS(0U, buffer.size());
+
+        BSONObj none;
+        ASSERT_FALSE(buffer.peek(&none));
+    }
+
+    TEST(OplogBuffer, BatchMemoryIsReleasedWhenFullyPopped) {
+        OplogBuffer buffer(1024 * 1024);
+
+        const std::vector<BSONObj> first = makeBatch(0, 2);
+        const std::vector<BSONObj> second = makeBatch(2, 2);
+        buffer.pushBatch(first);
+        buffer.pushBatch(second);
+        ASSERT_EQUALS(batchSize(first) + batchSize(second), buffer.size());
+
+        buffer.blockingPop();
+        ASSERT_EQUALS(batchSize(first) + batchSize(second), buffer.size());
+
+        buffer.blockingPop();
+        ASSERT_EQUALS(batchSize(second), buffer.size());
+    }
+
+    TEST(OplogBuffer, PoppedOpsOutliveTheBuffer) {
+        BSONObj op;
+        {
+            OplogBuffer buffer(1024 * 1024);
+            buffer.pushBatch(makeBatch(7, 2));
+            op = buffer.blockingPop();
+            ASSERT_TRUE(op.isOwned());
+        }
+
+        ASSERT_EQUALS(7, op["ts"].numberInt());
+        ASSERT_EQUALS(7, op.getOwned()["o"]["_id"].numberInt());
+    }
+
+    TEST(OplogBuffer, AcceptsOversizedBatchWhenEmpty) {
+        OplogBuffer buffer(1);
+        buffer.pushBatch(makeBatch(0, 10));
+        ASSERT_EQUALS(10U, buffer.count());
+    }
+
+    TEST(OplogBuffer, BlockingPeekTimesOut) {
+        OplogBuffer buffer(1024);
+        BSONObj op;
+        ASSERT_FALSE(buffer.blockingPeek(&op, 0));
+    }
+
+    void pushBatch(OplogBuffer* buffer, std::vector<BSONObj> batch) {
+        buffer->pushBatch(batch);
+    }
+
+    TEST(OplogBuffer, ProducerWaitsForSpace) {
+        const std::vector<BSONObj> first = makeBatch(0, 4);
+        OplogBuffer buffer(batchSize(first));
+        buffer.pushBatch(first);
+
+        boost::thread producer(mongo::stdx::bind(&pushBatch, &buffer, makeBatch(4, 1)));
+
+        // The second batch does not fit until the first one is gone
+        mongo::sleepmillis(50);
+        ASSERT_EQUALS(4U, buffer.count());
+
+        for (int i = 0; i < 4; i++) {
+            buffer.blockingPop();
+        }
+
+        producer.join();
+        ASSERT_EQUALS(1U, buffer.count());
+        ASSERT_EQUALS(4, buffer.blockingPop()["ts"].numberInt());
+    }
+
+    TEST(OplogBuffer, RaisingMaxSizeWakesProducer) {
+        const std::vector<BSONObj> first = makeBatch(0, 4);
+        OplogBuffer buffer(batchSize(first));
+        buffer.pushBatch(first);
+
+        boost::thread producer(mongo::stdx::bind(&pushBatch, &buffer, makeBatch(4, 1)));
+
+        mongo::sleepmillis(50);
+        ASSERT_EQUALS(4U, buffer.count());
+
+        buffer.setMaxSize(1024 * 1024);
+        producer.join();
+        ASSERT_EQUALS(5U, buffer.count());
+    }
+
+} // namespace
@@ -251,6 +251,16 @@ namespace repl {
          */
         virtual OpTime getMyLastOptime() const = 0;
 
+        /**
+         * Blocks for up to 'timeout' until this node has applied the operation with OpTime 'ts',
+         * so that a read which follows a write made through another member can see it. Returns
+         * ErrorCodes::OpTimeNotReached if the node is still behind 'ts' after 'timeout', or
+         * the interruption status if the operation was killed or the node is shutting down.
+         */
+        virtual Status awaitMyOptime(OperationContext* txn,
+                                     const OpTime& ts,
+                                     const Milliseconds& timeout) = 0;
+
         /**
          * Retrieves and returns the current election id, which is a unique id that is local to
          * this node and changes every time we become primary.
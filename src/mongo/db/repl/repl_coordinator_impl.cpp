@@ -702,6 +702,7 @@ namespace {
             boost::unique_lock<boost::mutex>* lock, const OpTime& ts) {
         invariant(lock->owns_lock());
         _updateSlaveInfoOptime_inlock(&_slaveInfo[_getMyIndexInSlaveInfo_inlock()], ts);
+        _myLastOptimeChanged.notify_all();
 
         if (_getReplicationMode_inlock() != modeReplSet) {
             return;
@@ -722,6 +723,41 @@ namespace {
         return _slaveInfo[_getMyIndexInSlaveInfo_inlock()].opTime;
     }
 
+    Status ReplicationCoordinatorImpl::awaitMyOptime(OperationContext* txn,
+                                                     const OpTime& ts,
+                                                     const Milliseconds& timeout) {
+        const Timer timer;
+        boost::unique_lock<boost::mutex> lock(_mutex);
+        if (_getReplicationMode_inlock() == modeNone) {
+            // Every write made to a standalone node is already visible on it.
+            return Status::OK();
+        }
+
+        while (_getMyLastOptime_inlock() < ts) {
+            Status interruptedStatus = txn->checkForInterruptNoAssert();
+            if (!interruptedStatus.isOK()) {
+                return interruptedStatus;
+            }
+
+            if (_inShutdown) {
+                return Status(ErrorCodes::ShutdownInProgress, "Replication is being shut down");
+            }
+
+            const long long remaining = timeout.total_milliseconds() - timer.millis();
+            if (remaining <= 0) {
+                return Status(ErrorCodes::OpTimeNotReached,
+                              str::stream() << "this node has applied operations up to "
+                                            << _getMyLastOptime_inlock().toStringPretty()
+                                            << " but not " << ts.toStringPretty());
+            }
+
+            try {
+                _myLastOptimeChanged.timed_wait(lock, Milliseconds(remaining));
+            } catch (const boost::thread_interrupted&) {}
+        }
+        return Status::OK();
+    }
+
     Status ReplicationCoordinatorImpl::setLastOptime_forTest(const OID& rid, const OpTime& ts) {
         boost::lock_guard<boost::mutex> lock(_mutex);
         invariant(_getReplicationMode_inlock() == modeReplSet);
@@ -139,6 +139,10 @@ namespace repl {
 
         virtual OpTime getMyLastOptime() const;
 
+        virtual Status awaitMyOptime(OperationContext* txn,
+                                     const OpTime& ts,
+                                     const Milliseconds& timeout);
+
         virtual OID getElectionId();
 
         virtual OID getMyRID() const;
@@ -810,6 +814,9 @@ namespace repl {
         // True if we are waiting for the applier to finish draining.
         bool _isWaitingForDrainToComplete;                                                // (M)
 
+        // Used to signal threads in awaitMyOptime() that this node has applied more operations.
+        boost::condition_variable _myLastOptimeChanged;                                   // (M)
+
         // Used to signal threads waiting for changes to _rsConfigState.
         boost::condition_variable _rsConfigStateChange;                                   // (M)
 
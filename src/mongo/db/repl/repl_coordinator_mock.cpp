@@ -131,6 +131,12 @@ namespace repl {
         return OpTime();
     }
 
+    Status ReplicationCoordinatorMock::awaitMyOptime(OperationContext* txn,
+                                                     const OpTime& ts,
+                                                     const Milliseconds& timeout) {
+        return Status::OK();
+    }
+
 
     OID ReplicationCoordinatorMock::getElectionId() {
         // TODO
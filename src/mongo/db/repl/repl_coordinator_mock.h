@@ -97,6 +97,10 @@ namespace repl {
 
         virtual OpTime getMyLastOptime() const;
 
+        virtual Status awaitMyOptime(OperationContext* txn,
+                                     const OpTime& ts,
+                                     const Milliseconds& timeout);
+
         virtual OID getElectionId();
 
         virtual OID getMyRID() const;
@@ -52,6 +52,7 @@
 #include "mongo/db/repl/repl_coordinator.h"
 #include "mongo/db/repl/repl_coordinator_impl.h"
 #include "mongo/db/repl/rslog.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/log.h"
 
 /* Scenarios
@@ -140,6 +141,82 @@ namespace {
     };
 
 
+    // Most documents rollback refetches from the sync source with one query.
+    MONGO_EXPORT_SERVER_PARAMETER(rollbackFetchBatchSize, int, 1000);
+
+    // Most rolled back data, in MB, refetched from the sync source and held in memory.
+    MONGO_EXPORT_SERVER_PARAMETER(rollbackMaxDataSizeMB, int, 300);
+
+    // Keeps the $in query for a batch well below the maximum BSON size.
+    const int kMaxFetchBatchIdBytes = 4 * 1024 * 1024;
+
+    void addGoodVersion(const DocID& doc,
+                        const BSONObj& good,
+                        list<pair<DocID, BSONObj> >* goodVersions,
+                        unsigned long long* totalSize) {
+        *totalSize += good.objsize();
+        uassert(13410, "replSet too much data to roll back",
+                *totalSize < static_cast<unsigned long long>(rollbackMaxDataSizeMB) * 1024 * 1024);
+
+        // note good might be eoo, indicating we should delete it
+        goodVersions->push_back(pair<DocID, BSONObj>(doc, good));
+    }
+
+    /**
+     * Fetches the sync source's current version of each document in 'batch', which are all
+     * in one namespace, and appends them to 'goodVersions' in order.
+     */
+    void refetchBatch(DBClientConnection* them,
+                      const vector<DocID>& batch,
+                      list<pair<DocID, BSONObj> >* goodVersions,
+                      unsigned long long* totalSize) {
+        const char* ns = batch.front().ns;
+
+        // an $in over regexes would match by pattern rather than by value
+        bool canUseIn = batch.size() > 1;
+        for (size_t i = 0; canUseIn && i < batch.size(); i++) {
+            canUseIn = batch[i]._id.type() != RegEx;
+        }
+
+        if (!canUseIn) {
+            for (size_t i = 0; i < batch.size(); i++) {
+                BSONObj good = them->findOne(ns, batch[i]._id.wrap(),
+                                             NULL, QueryOption_SlaveOk).getOwned();
+                addGoodVersion(batch[i], good, goodVersions, totalSize);
+            }
+            return;
+        }
+
+        BSONArrayBuilder ids;
+        for (size_t i = 0; i < batch.size(); i++) {
+            ids.append(batch[i]._id);
+        }
+
+        auto_ptr<DBClientCursor> cursor = them->query(ns,
+                                                      BSON("_id" << BSON("$in" << ids.arr())),
+                                                      0,
+                                                      0,
+                                                      NULL,
+                                                      QueryOption_SlaveOk);
+        uassert(28647, str::stream() << "rollback couldn't query " << ns, cursor.get());
+
+        // keyed by elements of the mapped documents, which own them
+        typedef map<BSONElement, BSONObj, BSONElementCmpWithoutField> FetchedDocs;
+        FetchedDocs fetched;
+        while (cursor->more()) {
+            BSONObj good = cursor->nextSafe().getOwned();
+            fetched[good["_id"]] = good;
+        }
+
+        for (size_t i = 0; i < batch.size(); i++) {
+            FetchedDocs::const_iterator found = fetched.find(batch[i]._id);
+            addGoodVersion(batch[i],
+                           found == fetched.end() ? BSONObj() : found->second,
+                           goodVersions,
+                           totalSize);
+        }
+    }
+
     /** helper to get rollback id from another server. */
     int getRBID(DBClientConnection *c) {
         bo info;
@@ -386,25 +463,26 @@ namespace {
         DocID doc;
         unsigned long long numFetched = 0;
         try {
-            for (set<DocID>::iterator it = fixUpInfo.toRefetch.begin();
-                    it != fixUpInfo.toRefetch.end();
-                    it++) {
+            // toRefetch is ordered by namespace, so consecutive documents of one collection
+            // are fetched together by one $in query
+            set<DocID>::const_iterator it = fixUpInfo.toRefetch.begin();
+            while (it != fixUpInfo.toRefetch.end()) {
                 doc = *it;
 
-                verify(!doc._id.eoo());
-
-                {
-                    // TODO : slow.  lots of round trips.
-                    numFetched++;
-                    BSONObj good = them->findOne(doc.ns, doc._id.wrap(),
-                                                     NULL, QueryOption_SlaveOk).getOwned();
-                    totalSize += good.objsize();
-                    uassert(13410, "replSet too much data to roll back",
-                            totalSize < 300 * 1024 * 1024);
-
-                    // note good might be eoo, indicating we should delete it
-                    goodVersions.push_back(pair<DocID, BSONObj>(doc,good));
+                vector<DocID> batch;
+                int batchIdBytes = 0;
+                while (it != fixUpInfo.toRefetch.end()
+                        && strcmp(it->ns, doc.ns) == 0
+                        && batch.size() < static_cast<size_t>(std::max(1, rollbackFetchBatchSize))
+                        && batchIdBytes < kMaxFetchBatchIdBytes) {
+                    verify(!it->_id.eoo());
+                    batch.push_back(*it);
+                    batchIdBytes += it->_id.size();
+                    ++it;
                 }
+
+                numFetched += batch.size();
+                refetchBatch(them, batch, &goodVersions, &totalSize);
             }
             newMinValid = oplogreader->getLastOp(rsoplog);
             if (newMinValid.isEmpty()) {
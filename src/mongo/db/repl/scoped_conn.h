@@ -91,6 +91,12 @@ namespace repl {
             return conn()->findOne(ns, q, fieldsToReturn, queryOptions);
         }
 
+        /* The connection itself, for DBClientMultiCommand, which sends one command over it and
+           reads the single reply.  Only valid while this ScopedConn lives. */
+        DBClientConnection* get() {
+            return conn().get();
+        }
+
     private:
         std::auto_ptr<scoped_lock> connLock;
         static mongo::mutex mapMutex;
@@ -39,11 +39,14 @@
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/auth/internal_user_auth.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/dbhelpers.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/repl/bgsync.h"
 #include "mongo/db/repl/repl_coordinator_global.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/stats/timer_stats.h"
 #include "mongo/util/log.h"
 #include "mongo/util/net/hostandport.h"
 
@@ -54,6 +57,21 @@ namespace repl {
     // used in replAuthenticate
     static const BSONObj userReplQuery = fromjson("{\"user\":\"repl\"}");
 
+    // How long to let position changes accumulate before reporting them upstream, so that
+    // several batches applied in quick succession are reported together.  0 reports at once.
+    MONGO_EXPORT_SERVER_PARAMETER(syncSourceFeedbackCoalesceMillis, int, 0);
+
+    //The number and round trip time of position updates sent upstream
+    static TimerStats updatePositionStats;
+    static ServerStatusMetricField<TimerStats> displayUpdatePositions(
+                                                    "repl.network.updatePosition",
+                                                    &updatePositionStats );
+    //The position updates not sent because upstream already had them
+    static Counter64 updatePositionSkippedStats;
+    static ServerStatusMetricField<Counter64> displayUpdatePositionsSkipped(
+                                                    "repl.network.updatePositionSkipped",
+                                                    &updatePositionSkippedStats );
+
     SyncSourceFeedback::SyncSourceFeedback() : _positionChanged(false),
                                                _handshakeNeeded(false),
                                                _shutdownSignaled(false) {}
@@ -62,6 +80,7 @@ namespace repl {
     void SyncSourceFeedback::_resetConnection() {
         LOG(1) << "resetting connection in sync source feedback";
         _connection.reset();
+        _lastPositionSent = BSONObj();
     }
 
     bool SyncSourceFeedback::replAuthenticate() {
@@ -207,11 +226,18 @@ namespace repl {
             }
             replCoord->prepareReplSetUpdatePositionCommand(&cmd);
         }
+        const BSONObj cmdObj = cmd.obj();
+        if (cmdObj.binaryEqual(_lastPositionSent)) {
+            // woken by a change that left every position we report where it was
+            updatePositionSkippedStats.increment();
+            return Status::OK();
+        }
         BSONObj res;
 
-        LOG(2) << "Sending slave oplog progress to upstream updater: " << cmd.done();
+        LOG(2) << "Sending slave oplog progress to upstream updater: " << cmdObj;
         try {
-            _connection->runCommand("admin", cmd.obj(), res);
+            TimerHolder updateTimer(&updatePositionStats);
+            _connection->runCommand("admin", cmdObj, res);
         }
         catch (const DBException& e) {
             log() << "SyncSourceFeedback error sending update: " << e.what() << endl;
@@ -231,7 +257,9 @@ namespace repl {
                                            Date_t(curTimeMillis64() + 500));
             BackgroundSync::get()->clearSyncTarget();
             _resetConnection();
+            return status;
         }
+        _lastPositionSent = cmdObj;
         return status;
     }
 
@@ -255,6 +283,19 @@ namespace repl {
                     _cond.wait(lock);
                 }
 
+                const int coalesceMillis = syncSourceFeedbackCoalesceMillis;
+                if (coalesceMillis > 0 && !_handshakeNeeded) {
+                    // let further position changes join this update
+                    const Date_t deadline = curTimeMillis64() + coalesceMillis;
+                    while (!_handshakeNeeded && !_shutdownSignaled) {
+                        const Date_t nowDate = curTimeMillis64();
+                        if (nowDate >= deadline) {
+                            break;
+                        }
+                        _cond.timed_wait(lock, Milliseconds(deadline - nowDate));
+                    }
+                }
+
                 if (_shutdownSignaled) {
                     break;
                 }
@@ -289,6 +330,7 @@ namespace repl {
             }
             if (handshakeNeeded) {
                 positionChanged = true;
+                _lastPositionSent = BSONObj();
                 if (!replHandshake(&txn)) {
                     boost::unique_lock<boost::mutex> lock(_mtx);
                     _handshakeNeeded = true;
@@ -103,6 +103,8 @@ namespace repl {
         HostAndPort _syncTarget;
         // our connection to our sync target
         boost::scoped_ptr<DBClientConnection> _connection;
+        // the last replSetUpdatePosition our sync target accepted over _connection, if any
+        BSONObj _lastPositionSent;
         // protects cond, _shutdownSignaled, and the indicator bools.
         boost::mutex _mtx;
         // used to alert our thread of changes which need to be passed up the chain
@@ -33,8 +33,8 @@
 
 #include "mongo/db/repl/sync_tail.h"
 
+#include <algorithm>
 #include <boost/functional/hash.hpp>
-#include <boost/ref.hpp>
 #include "third_party/murmurhash3/MurmurHash3.h"
 
 #include "mongo/base/counter.h"
@@ -51,11 +51,15 @@
 #include "mongo/db/repl/minvalid.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/repl_coordinator_global.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/timer_stats.h"
+#include "mongo/db/storage/storage_engine.h"
 #include "mongo/db/operation_context_impl.h"
+#include "mongo/platform/unordered_map.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -70,6 +74,17 @@ namespace repl {
 #error need to include something that defines MONGO_PLATFORM_XX
 #endif
 
+    // Number of writer vectors to aim for per writer thread. Having several smaller vectors per
+    // thread lets threads which finish early pick up the remaining work, while keeping the
+    // per-vector overhead (an OperationContext each) amortized over a reasonable number of ops.
+    const size_t replWriterVectorsPerThread = 8;
+
+    // Whether to prefetch each batch on storage engines which manage their own cache. Warming
+    // the documents and index keys a batch touches costs an extra lookup for each when they are
+    // already in the cache, but saves a cold secondary from faulting them in one at a time under
+    // the batch write lock.
+    MONGO_EXPORT_SERVER_PARAMETER(replPrefetchAllStorageEngines, bool, true);
+
     static Counter64 opsAppliedStats;
 
     //The oplog entries applied
@@ -197,6 +212,24 @@ namespace repl {
             return hash;
         }
 
+        typedef std::vector< std::vector<BSONObj> > WriterVectors;
+
+        /**
+         * Orders conflict groups by decreasing number of ops, so that the longest serial chains
+         * get started first and the small groups fill in the gaps at the end of the batch.
+         */
+        class GroupSizeGreater {
+        public:
+            explicit GroupSizeGreater(const WriterVectors& groups) : _groups(groups) { }
+
+            bool operator()(size_t lhs, size_t rhs) const {
+                return _groups[lhs].size() > _groups[rhs].size();
+            }
+
+        private:
+            const WriterVectors& _groups;
+        };
+
     }
 
     SyncTail::SyncTail(BackgroundSyncInterface *q, MultiSyncApplyFunc func) :
@@ -324,36 +357,59 @@ namespace repl {
 
     // Doles out all the work to the reader pool threads and waits for them to complete
     void SyncTail::prefetchOps(const std::deque<BSONObj>& ops) {
+        threadpool::TaskGroup prefetches(&_prefetcherPool);
         for (std::deque<BSONObj>::const_iterator it = ops.begin();
              it != ops.end();
              ++it) {
-            _prefetcherPool.schedule(&prefetchOp, *it);
+            prefetches.schedule(&prefetchOp, *it);
         }
-        _prefetcherPool.join();
+        prefetches.join();
     }
     
     // Doles out all the work to the writer pool threads and waits for them to complete
     void SyncTail::applyOps(const std::vector< std::vector<BSONObj> >& writerVectors) {
         TimerHolder timer(&applyBatchStats);
-        for (std::vector< std::vector<BSONObj> >::const_iterator it = writerVectors.begin();
-             it != writerVectors.end();
-             ++it) {
-            if (!it->empty()) {
-                _writerPool.schedule(_applyFunc, boost::cref(*it), this);
+
+        // Writer vectors are not bound to threads up front. Instead each writer claims the next
+        // unapplied vector as soon as it is done with the previous one, so a vector containing
+        // slow ops only holds up the thread applying it and not the ones queued behind it.
+        AtomicUInt32 nextWriterVector;
+        const size_t numWriters =
+            std::min(writerVectors.size(), static_cast<size_t>(replWriterThreadCount));
+        threadpool::TaskGroup writers(&_writerPool);
+        for (size_t i = 0; i < numWriters; i++) {
+            writers.schedule(&SyncTail::_applyWriterVectors,
+                             this,
+                             &writerVectors,
+                             &nextWriterVector);
+        }
+        writers.join();
+    }
+
+    void SyncTail::_applyWriterVectors(const std::vector< std::vector<BSONObj> >* writerVectors,
+                                       AtomicUInt32* nextWriterVector) {
+        while (true) {
+            const size_t i = nextWriterVector->fetchAndAdd(1);
+            if (i >= writerVectors->size()) {
+                return;
             }
+
+            _applyFunc((*writerVectors)[i], this);
         }
-        _writerPool.join();
     }
 
     // Doles out all the work to the writer pool threads and waits for them to complete
     OpTime SyncTail::multiApply(OperationContext* txn, std::deque<BSONObj>& ops) {
 
-        if (getGlobalEnvironment()->getGlobalStorageEngine()->isMmapV1()) {
+        // The prefetch has to finish before the batch is applied, since applying it excludes
+        // every reader for the whole batch.
+        if (getGlobalEnvironment()->getGlobalStorageEngine()->isMmapV1() ||
+            replPrefetchAllStorageEngines) {
             // Use a ThreadPool to prefetch all the operations in a batch.
             prefetchOps(ops);
         }
         
-        std::vector< std::vector<BSONObj> > writerVectors(replWriterThreadCount);
+        std::vector< std::vector<BSONObj> > writerVectors;
         fillWriterVectors(ops, &writerVectors);
         LOG(2) << "replication batch size is " << ops.size() << endl;
         // We must grab this because we're going to grab write locks later.
@@ -361,7 +417,12 @@ namespace repl {
         // because all readers are blocked anyway.
         SimpleMutex::scoped_lock fsynclk(filesLockedFsync);
 
-        // stop all readers until we're done
+        // Readers at batch boundaries see the data as it is now until the batch is done.
+        StorageEngine* storageEngine = getGlobalEnvironment()->getGlobalStorageEngine();
+        storageEngine->beginReplicationBatch();
+        ON_BLOCK_EXIT_OBJ(*storageEngine, &StorageEngine::endReplicationBatch);
+
+        // stop all other readers until we're done
         Lock::ParallelBatchWriterMode pbwm;
 
         ReplicationCoordinator* replCoord = getGlobalReplicationCoordinator();
@@ -379,6 +440,15 @@ namespace repl {
 
     void SyncTail::fillWriterVectors(const std::deque<BSONObj>& ops,
                                      std::vector< std::vector<BSONObj> >* writerVectors) {
+        const bool supportsDocLocking =
+            getGlobalEnvironment()->getGlobalStorageEngine()->supportsDocLocking();
+
+        // First group the ops by the key they may conflict on: the namespace and, for CRUD ops
+        // on storage engines with document-level locking, the _id of the document. Keys are
+        // hashes, so a collision may only cause unrelated ops to be applied serially.
+        typedef unordered_map<uint64_t, size_t> GroupIndex;
+        GroupIndex groupIndex;
+        WriterVectors groups;
 
         for (std::deque<BSONObj>::const_iterator it = ops.begin();
              it != ops.end();
@@ -390,10 +460,11 @@ namespace repl {
             uint32_t hash = 0;
             MurmurHash3_x86_32( ns, len, 0, &hash);
 
+            uint32_t docHash = 0;
+
             const char* opType = it->getField( "op" ).valuestrsafe();
 
-            if (getGlobalEnvironment()->getGlobalStorageEngine()->supportsDocLocking() &&
-                isCrudOpType(opType)) {
+            if (supportsDocLocking && isCrudOpType(opType)) {
                 BSONElement id;
                 switch (opType[0]) {
                 case 'u':
@@ -406,10 +477,47 @@ namespace repl {
                 }
 
                 const size_t idHash = hashBSONElement( id );
-                MurmurHash3_x86_32(&idHash, sizeof(idHash), hash, &hash);
+                MurmurHash3_x86_32(&idHash, sizeof(idHash), hash, &docHash);
+            }
+
+            const uint64_t key = (static_cast<uint64_t>(hash) << 32) | docHash;
+
+            std::pair<GroupIndex::iterator, bool> inserted =
+                groupIndex.insert(std::make_pair(key, groups.size()));
+            if (inserted.second) {
+                groups.push_back(std::vector<BSONObj>());
             }
 
-            (*writerVectors)[hash % writerVectors->size()].push_back(*it);
+            groups[inserted.first->second].push_back(*it);
+        }
+
+        // Then pack the groups into writer vectors, largest first. Large groups are a serial
+        // chain of ops and get a vector on their own, while small groups are combined so that a
+        // batch of many independent ops is not split into one vector per op.
+        std::vector<size_t> order(groups.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), GroupSizeGreater(groups));
+
+        const size_t opsPerVector = std::max(static_cast<size_t>(1),
+            ops.size() / (replWriterThreadCount * replWriterVectorsPerThread));
+
+        writerVectors->clear();
+        writerVectors->reserve(order.size());
+
+        for (std::vector<size_t>::const_iterator it = order.begin(); it != order.end(); ++it) {
+            std::vector<BSONObj>& group = groups[*it];
+
+            if (writerVectors->empty() || writerVectors->back().size() >= opsPerVector) {
+                writerVectors->push_back(std::vector<BSONObj>());
+                writerVectors->back().swap(group);
+            }
+            else {
+                writerVectors->back().insert(writerVectors->back().end(),
+                                             group.begin(),
+                                             group.end());
+            }
         }
     }
     void SyncTail::oplogApplication(OperationContext* txn, const OpTime& endOpTime) {
@@ -32,6 +32,7 @@
 
 #include "mongo/db/storage/mmap_v1/dur.h"
 #include "mongo/db/repl/sync.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/concurrency/thread_pool.h"
 
 namespace mongo {
@@ -131,6 +132,13 @@ namespace repl {
         // Doles out all the work to the writer pool threads and waits for them to complete
         void applyOps(const std::vector< std::vector<BSONObj> >& writerVectors);
 
+        // Run by each writer pool thread; claims and applies writer vectors until none are left
+        void _applyWriterVectors(const std::vector< std::vector<BSONObj> >* writerVectors,
+                                 AtomicUInt32* nextWriterVector);
+
+        // Splits a batch into writer vectors, which can be applied in parallel and in any order
+        // with respect to each other. Ops which may conflict always end up in the same vector
+        // and in their original oplog order.
         void fillWriterVectors(const std::deque<BSONObj>& ops, 
                                std::vector< std::vector<BSONObj> >* writerVectors);
         void handleSlaveDelay(const BSONObj& op);
@@ -47,7 +47,9 @@
 
 #include "mongo/db/sorter/sorter.h"
 
+#include <boost/bind.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <boost/thread/thread.hpp>
 #include <snappy.h>
 
 #include "mongo/base/string_data.h"
@@ -257,7 +259,15 @@ namespace mongo {
             std::ifstream _file;
         };
 
-        /** Merge-sorts results from 0 or more FileIterators */
+        /**
+         * Merge-sorts results from 0 or more FileIterators.
+         *
+         * The streams are merged with a loser tree (tournament tree). Each internal node of the
+         * tree holds the stream that lost the match played at that node, and node 0 holds the
+         * overall winner. Replacing the winner with the next value from its stream only replays
+         * the matches on the path from its leaf to the root, which costs one comparison per
+         * level rather than the two per level a binary heap needs.
+         */
         template <typename Key, typename Value, typename Comparator>
         class MergeIterator : public SortIteratorInterface<Key, Value> {
         public:
@@ -271,34 +281,35 @@ namespace mongo {
                 : _opts(opts)
                 , _remaining(opts.limit ? opts.limit : numeric_limits<unsigned long long>::max())
                 , _first(true)
-                , _greater(comp)
+                , _numLive(0)
+                , _comp(comp)
             {
                 for (size_t i = 0; i < iters.size(); i++) {
                     if (iters[i]->more()) {
-                        _heap.push_back(
+                        _streams.push_back(
                             boost::make_shared<Stream>(i, iters[i]->next(), iters[i]));
                     }
                 }
 
-                if (_heap.empty()) {
+                _numLive = _streams.size();
+                if (_streams.empty()) {
                     _remaining = 0;
                     return;
                 }
 
-                std::make_heap(_heap.begin(), _heap.end(), _greater);
-                std::pop_heap(_heap.begin(), _heap.end(), _greater);
-                _current = _heap.back();
-                _heap.pop_back();
+                _tree.resize(_streams.size());
+                _tree[0] = playMatches(1);
             }
 
             bool more() {
-                if (_remaining > 0 && (_first || !_heap.empty() || _current->more()))
+                if (_remaining > 0 && (_first || _numLive > 1 || winner().more()))
                     return true;
 
                 // We are done so clean up resources.
                 // Can't do this in next() due to lifetime guarantees of unowned Data.
-                _heap.clear();
-                _current.reset();
+                _streams.clear();
+                _tree.clear();
+                _numLive = 0;
                 _remaining = 0;
 
                 return false;
@@ -311,22 +322,28 @@ namespace mongo {
 
                 if (_first) {
                     _first = false;
-                    return _current->current();
+                    return winner().current();
                 }
 
-                if (!_current->advance()) {
-                    verify(!_heap.empty());
+                // The value returned last time came from the winner, so that is the only stream
+                // to move forward. It is done here rather than at the end of the previous call
+                // because the data returned then may be unowned.
+                size_t contender = _tree[0];
+                if (!_streams[contender]->advance()) {
+                    verify(_numLive > 1);
+                    _streams[contender]->exhausted = true;
+                    _numLive--;
+                }
 
-                    std::pop_heap(_heap.begin(), _heap.end(), _greater);
-                    _current = _heap.back();
-                    _heap.pop_back();
-                } else if (!_heap.empty() && _greater(_current, _heap.front())) {
-                    std::pop_heap(_heap.begin(), _heap.end(), _greater);
-                    std::swap(_current, _heap.back());
-                    std::push_heap(_heap.begin(), _heap.end(), _greater);
+                // Replay the matches from the contender's leaf up to the root.
+                for (size_t node = (contender + _streams.size()) / 2; node > 0; node /= 2) {
+                    if (beats(_tree[node], contender)) {
+                        std::swap(_tree[node], contender);
+                    }
                 }
+                _tree[0] = contender;
 
-                return _current->current();
+                return winner().current();
             }
 
 
@@ -335,6 +352,7 @@ namespace mongo {
             public:
                 Stream(size_t fileNum, const Data& first, boost::shared_ptr<Input> rest)
                     : fileNum(fileNum)
+                    , exhausted(false)
                     , _current(first)
                     , _rest(rest)
                 {}
@@ -350,34 +368,59 @@ namespace mongo {
                 }
 
                 const size_t fileNum;
+                bool exhausted; // An exhausted stream loses every match.
             private:
                 Data _current;
                 boost::shared_ptr<Input> _rest;
             };
 
-            class STLComparator { // uses greater rather than less-than to maintain a MinHeap
-            public:
-                explicit STLComparator(const Comparator& comp) : _comp(comp) {}
-                bool operator () (ptr<const Stream> lhs, ptr<const Stream> rhs) const {
-                    // first compare data
-                    dassertCompIsSane(_comp, lhs->current(), rhs->current());
-                    int ret = _comp(lhs->current(), rhs->current());
-                    if (ret)
-                        return ret > 0;
+            Stream& winner() { return *_streams[_tree[0]]; }
+
+            /**
+             * Returns true if the current value of stream 'lhs' should be returned before that of
+             * stream 'rhs'.
+             */
+            bool beats(size_t lhs, size_t rhs) const {
+                const Stream& left = *_streams[lhs];
+                const Stream& right = *_streams[rhs];
+                if (left.exhausted || right.exhausted)
+                    return !left.exhausted;
+
+                // first compare data
+                dassertCompIsSane(_comp, left.current(), right.current());
+                int ret = _comp(left.current(), right.current());
+                if (ret)
+                    return ret < 0;
+
+                // then compare fileNums to ensure stability
+                return left.fileNum < right.fileNum;
+            }
 
-                    // then compare fileNums to ensure stability
-                    return lhs->fileNum > rhs->fileNum;
+            /**
+             * Plays all the matches in the subtree rooted at 'node', recording the loser of each
+             * in _tree, and returns the winner. The leaves are nodes _streams.size() and up.
+             */
+            size_t playMatches(size_t node) {
+                if (node >= _streams.size())
+                    return node - _streams.size();
+
+                const size_t left = playMatches(2 * node);
+                const size_t right = playMatches(2 * node + 1);
+                if (beats(left, right)) {
+                    _tree[node] = right;
+                    return left;
                 }
-            private:
-                const Comparator _comp;
-            };
+                _tree[node] = left;
+                return right;
+            }
 
             SortOptions _opts;
             unsigned long long _remaining;
             bool _first;
-            boost::shared_ptr<Stream> _current;
-            std::vector<boost::shared_ptr<Stream> > _heap; // MinHeap
-            STLComparator _greater; // named so calls make sense
+            size_t _numLive; // Number of streams that are not exhausted.
+            std::vector<boost::shared_ptr<Stream> > _streams;
+            std::vector<size_t> _tree; // _tree[0] is the winner, _tree[1..] the losers.
+            const Comparator _comp;
         };
 
         template <typename Key, typename Value, typename Comparator>
@@ -396,33 +439,146 @@ namespace mongo {
                 , _settings(settings)
                 , _opts(opts)
                 , _memUsed(0)
+                // Every run in flight holds on to its data, so they share the memory budget.
+                , _spillThresholdBytes(opts.maxMemoryUsageBytes / (opts.spillThreads + 1))
             { verify(_opts.limit == 0); }
 
+            /// Starts out with the runs in 'fileNames', which are left in place when it is done.
+            NoLimitSorter(const std::vector<std::string>& fileNames,
+                          const SortOptions& opts,
+                          const Comparator& comp,
+                          const Settings& settings = Settings())
+                : _comp(comp)
+                , _settings(settings)
+                , _opts(opts)
+                , _memUsed(0)
+                , _spillThresholdBytes(opts.maxMemoryUsageBytes / (opts.spillThreads + 1))
+            {
+                verify(_opts.limit == 0);
+                for (size_t i = 0; i < fileNames.size(); i++) {
+                    _iters.push_back(boost::make_shared<FileIterator<Key, Value> >(
+                        fileNames[i], _settings, boost::shared_ptr<FileDeleter>()));
+                }
+            }
+
             void add(const Key& key, const Value& val) {
                 _data.push_back(std::make_pair(key, val));
 
                 _memUsed += key.memUsageForSorter();
                 _memUsed += val.memUsageForSorter();
 
-                if (_memUsed > _opts.maxMemoryUsageBytes)
+                if (_memUsed > _spillThresholdBytes)
                     spill();
             }
 
             Iterator* done() {
-                if (_iters.empty()) {
+                if (_iters.empty() && _spillJobs.empty()) {
                     sort();
                     return new InMemIterator<Key, Value>(_data);
                 }
 
                 spill();
+                while (!_spillJobs.empty()) {
+                    finishOldestSpill();
+                }
                 return Iterator::merge(_iters, _opts, _comp);
             }
 
+            void spillAll(std::vector<std::string>* fileNames) {
+                spill();
+                while (!_spillJobs.empty()) {
+                    finishOldestSpill();
+                }
+                fileNames->insert(fileNames->end(), _newRunFiles.begin(), _newRunFiles.end());
+                _newRunFiles.clear();
+            }
+
             // TEMP these are here for compatibility. Will be replaced with a general stats API
-            int numFiles() const { return _iters.size(); }
+            int numFiles() const { return _iters.size() + _spillJobs.size(); }
             size_t memUsed() const { return _memUsed; }
 
         private:
+            /**
+             * Sorts a run and writes it to a file on a thread of its own, so that the Sorter can
+             * go on accepting data while the run is being spilled.
+             */
+            class SpillJob {
+                MONGO_DISALLOW_COPYING(SpillJob);
+            public:
+                /// Takes the contents of 'data', leaving it empty.
+                SpillJob(std::deque<Data>* data,
+                         const Comparator& comp,
+                         const SortOptions& opts,
+                         const Settings& settings)
+                    : _comp(comp)
+                    , _opts(opts)
+                    , _settings(settings)
+                    , _failed(false)
+                    , _failedWithDBException(false)
+                    , _errorCode(0)
+                {
+                    _data.swap(*data);
+                    _thread.reset(new boost::thread(boost::bind(&SpillJob::run, this)));
+                }
+
+                ~SpillJob() {
+                    if (_thread) {
+                        DESTRUCTOR_GUARD(
+                            _thread->join();
+                        )
+                    }
+                }
+
+                /// Waits for the run to be on disk. Rethrows any error hit while writing it.
+                boost::shared_ptr<Iterator> finish() {
+                    _thread->join();
+                    _thread.reset();
+
+                    if (_failedWithDBException) {
+                        msgasserted(_errorCode, _errorMessage);
+                    }
+                    if (_failed) {
+                        msgasserted(28603, str::stream() << "error spilling sort data to disk: "
+                                                         << _errorMessage);
+                    }
+                    return _iter;
+                }
+
+                /// The file the run was written to. Only valid once finish() has returned.
+                const std::string& fileName() const { return _fileName; }
+
+            private:
+                void run() {
+                    try {
+                        _iter.reset(sortAndWrite(&_data, _comp, _opts, _settings, &_fileName));
+                    }
+                    catch (const DBException& e) {
+                        _failedWithDBException = true;
+                        _errorCode = e.getCode();
+                        _errorMessage = e.what();
+                    }
+                    catch (const std::exception& e) {
+                        _failed = true;
+                        _errorMessage = e.what();
+                    }
+                }
+
+                const Comparator _comp;
+                const SortOptions _opts;
+                const Settings _settings;
+                std::deque<Data> _data;
+
+                // Set by run(), only read after the thread has been joined.
+                boost::shared_ptr<Iterator> _iter;
+                std::string _fileName;
+                bool _failed;
+                bool _failedWithDBException;
+                int _errorCode;
+                std::string _errorMessage;
+
+                boost::scoped_ptr<boost::thread> _thread; // Must be the last member.
+            };
+
             class STLComparator {
             public:
                 explicit STLComparator(const Comparator& comp) : _comp(comp) {}
@@ -435,8 +591,12 @@ namespace mongo {
             };
 
             void sort() {
-                STLComparator less(_comp);
-                std::stable_sort(_data.begin(), _data.end(), less);
+                sortData(&_data, _comp);
+            }
+
+            static void sortData(std::deque<Data>* data, const Comparator& comp) {
+                STLComparator less(comp);
+                std::stable_sort(data->begin(), data->end(), less);
 
                 // Does 2x more compares than stable_sort
                 // TODO test on windows
@@ -459,24 +619,60 @@ namespace mongo {
                         );
                 }
 
-                sort();
-
-                SortedFileWriter<Key, Value> writer(_opts, _settings);
-                for ( ; !_data.empty(); _data.pop_front()) {
-                    writer.addAlreadySorted(_data.front().first, _data.front().second);
+                if (0 == _opts.spillThreads) {
+                    std::string fileName;
+                    _iters.push_back(boost::shared_ptr<Iterator>(
+                        sortAndWrite(&_data, _comp, _opts, _settings, &fileName)));
+                    _newRunFiles.push_back(fileName);
+                }
+                else {
+                    // Runs are collected in the order they were started, which the merge relies
+                    // on for stability.
+                    if (_spillJobs.size() >= _opts.spillThreads) {
+                        finishOldestSpill();
+                    }
+                    _spillJobs.push_back(
+                        boost::make_shared<SpillJob>(&_data, _comp, _opts, _settings));
                 }
-
-                _iters.push_back(boost::shared_ptr<Iterator>(writer.done()));
 
                 _memUsed = 0;
             }
 
+            void finishOldestSpill() {
+                _iters.push_back(_spillJobs.front()->finish());
+                _newRunFiles.push_back(_spillJobs.front()->fileName());
+                _spillJobs.pop_front();
+            }
+
+            /**
+             * Sorts 'data' and writes it to a new file, emptying 'data' as it goes. The name of
+             * the file goes in 'fileName'.
+             */
+            static Iterator* sortAndWrite(std::deque<Data>* data,
+                                          const Comparator& comp,
+                                          const SortOptions& opts,
+                                          const Settings& settings,
+                                          std::string* fileName) {
+                sortData(data, comp);
+
+                SortedFileWriter<Key, Value> writer(opts, settings);
+                for ( ; !data->empty(); data->pop_front()) {
+                    writer.addAlreadySorted(data->front().first, data->front().second);
+                }
+
+                *fileName = writer.getFileName();
+                return writer.done();
+            }
+
             const Comparator _comp;
             const Settings _settings;
             SortOptions _opts;
             size_t _memUsed;
+            const size_t _spillThresholdBytes;
             std::deque<Data> _data; // the "current" data
             std::vector<boost::shared_ptr<Iterator> > _iters; // data that has already been spilled
+            std::deque<boost::shared_ptr<SpillJob> > _spillJobs; // runs still being spilled
+            std::vector<std::string> _newRunFiles; // runs spilled since the last spillAll()
         };
 
         template <typename Key, typename Value, typename Comparator>
@@ -514,6 +710,10 @@ namespace mongo {
                 }
             }
 
+            void spillAll(std::vector<std::string>* fileNames) {
+                msgasserted(28652, "a Sorter with a limit of 1 cannot spill on request");
+            }
+
             // TEMP these are here for compatibility. Will be replaced with a general stats API
             int numFiles() const { return 0; }
             size_t memUsed() const { return _best.first.memUsageForSorter()
@@ -609,6 +809,10 @@ namespace mongo {
                 return Iterator::merge(_iters, _opts, _comp);
             }
 
+            void spillAll(std::vector<std::string>* fileNames) {
+                msgasserted(28653, "a Sorter with a limit cannot spill on request");
+            }
+
             // TEMP these are here for compatibility. Will be replaced with a general stats API
             int numFiles() const { return _iters.size(); }
             size_t memUsed() const { return _memUsed; }
@@ -884,4 +1088,21 @@ namespace mongo {
             default: return new sorter::TopKSorter<Key, Value, Comparator>(opts, comp, settings);
         }
     }
+
+    template <typename Key, typename Value>
+    template <typename Comparator>
+    Sorter<Key, Value>* Sorter<Key, Value>::makeFromExistingRuns(
+            const std::vector<std::string>& fileNames,
+            const SortOptions& opts,
+            const Comparator& comp,
+            const Settings& settings) {
+
+        massert(28654, "Attempting to use external sort from mongos. This is not allowed.",
+                !isMongos());
+
+        massert(28655, "Only a Sorter without a limit can start from existing runs",
+                opts.limit == 0);
+
+        return new sorter::NoLimitSorter<Key, Value, Comparator>(fileNames, opts, comp, settings);
+    }
 }
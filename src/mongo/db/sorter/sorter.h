@@ -98,11 +98,15 @@ namespace mongo {
         bool extSortAllowed; /// If false, uassert if more mem needed than allowed.
         std::string tempDir; /// Directory to directly place files in.
                              /// Must be explicitly set if extSortAllowed is true.
+        size_t spillThreads; /// Max number of runs sorted and written in the background at once.
+                             /// 0 spills on the calling thread. Only used when there is no limit.
+                             /// maxMemoryUsageBytes is shared between all of the runs.
 
         SortOptions()
             : limit(0)
             , maxMemoryUsageBytes(64*1024*1024)
             , extSortAllowed(false)
+            , spillThreads(0)
         {}
 
         /// Fluent API to support expressions like SortOptions().Limit(1000).ExtSortAllowed(true)
@@ -126,6 +130,11 @@ namespace mongo {
             tempDir = newTempDir;
             return *this;
         }
+
+        SortOptions& SpillThreads(size_t newSpillThreads) {
+            spillThreads = newSpillThreads;
+            return *this;
+        }
     };
 
     /// This is the output from the sorting framework
@@ -168,9 +177,26 @@ namespace mongo {
                             const Comparator& comp,
                             const Settings& settings = Settings());
 
+        /**
+         * Makes a Sorter without a limit which starts out with the sorted runs in 'fileNames',
+         * as reported by spillAll(). The Sorter only reads those files; it never removes them.
+         */
+        template <typename Comparator>
+        static Sorter* makeFromExistingRuns(const std::vector<std::string>& fileNames,
+                                            const SortOptions& opts,
+                                            const Comparator& comp,
+                                            const Settings& settings = Settings());
+
         virtual void add(const Key&, const Value&) =0;
         virtual Iterator* done() =0; /// Can't add more data after calling done()
 
+        /**
+         * Writes everything added so far to sorted runs on disk, and appends to 'fileNames' the
+         * files holding the runs written since the last call. The Sorter still removes those
+         * files when it is done with them. Only supported without a limit.
+         */
+        virtual void spillAll(std::vector<std::string>* fileNames) =0;
+
         virtual ~Sorter() {}
 
         // TEMP these are here for compatibility. Will be replaced with a general stats API
@@ -197,6 +223,8 @@ namespace mongo {
         void addAlreadySorted(const Key&, const Value&);
         Iterator* done(); /// Can't add more data after calling done()
 
+        const std::string& getFileName() const { return _fileName; }
+
     private:
         void spill();
 
@@ -232,6 +260,12 @@ namespace mongo {
                     const Comparator& comp); \
     template ::mongo::Sorter<Key, Value>* \
                 ::mongo::Sorter<Key, Value>::make<Comparator>( \
+                    const SortOptions& opts, \
+                    const Comparator& comp, \
+                    const Settings& settings); \
+    template ::mongo::Sorter<Key, Value>* \
+                ::mongo::Sorter<Key, Value>::makeFromExistingRuns<Comparator>( \
+                    const std::vector<std::string>& fileNames, \
                     const SortOptions& opts, \
                     const Comparator& comp, \
                     const Settings& settings);
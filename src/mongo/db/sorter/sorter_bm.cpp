@@ -0,0 +1,114 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/sorter/sorter.h"
+
+#include <boost/scoped_ptr.hpp>
+#include <vector>
+
+#include "mongo/platform/random.h"
+#include "mongo/unittest/benchmark.h"
+
+// Instantiates the Sorter for the types below.
+#include "mongo/db/sorter/sorter.cpp"
+
+namespace mongo {
+namespace {
+
+    class IntWrapper {
+    public:
+        IntWrapper(int i=0) :_i(i) {}
+        operator const int& () const { return _i; }
+
+        /// members for Sorter
+        struct SorterDeserializeSettings {}; // unused
+        void serializeForSorter(BufBuilder& buf) const { buf.appendNum(_i); }
+        static IntWrapper deserializeForSorter(BufReader& buf, const SorterDeserializeSettings&) {
+            return buf.read<int>();
+        }
+        int memUsageForSorter() const { return sizeof(IntWrapper); }
+        IntWrapper getOwned() const { return *this; }
+    private:
+        int _i;
+    };
+
+    typedef std::pair<IntWrapper, IntWrapper> IWPair;
+    typedef Sorter<IntWrapper, IntWrapper> IWSorter;
+
+    class IWComparator {
+    public:
+        int operator() (const IWPair& lhs, const IWPair& rhs) const {
+            if (lhs.first == rhs.first) return 0;
+            return lhs.first < rhs.first ? -1 : 1;
+        }
+    };
+
+    std::vector<int> makeKeys(long long count) {
+        PseudoRandom random(1);
+        std::vector<int> keys;
+        for (long long i = 0; i < count; i++) {
+            keys.push_back(random.nextInt32());
+        }
+        return keys;
+    }
+
+    /**
+     * Adds 'keys' to a sorter made with 'opts' and reads back the sorted output.
+     */
+    void sortKeys(const std::vector<int>& keys, const SortOptions& opts, benchmark::State& state) {
+        boost::scoped_ptr<IWSorter> sorter(IWSorter::make(opts, IWComparator()));
+        for (size_t i = 0; i < keys.size(); i++) {
+            sorter->add(keys[i], keys[i]);
+        }
+
+        boost::scoped_ptr<IWSorter::Iterator> it(sorter->done());
+        int last = 0;
+        while (it->more()) {
+            last = it->next().first;
+        }
+        state.doNotOptimize(last);
+    }
+
+    MONGO_BENCHMARK_WITH_ARGS(SorterInMemory, "1000,100000") {
+        const std::vector<int> keys = makeKeys(state.arg());
+        while (state.keepRunning()) {
+            sortKeys(keys, SortOptions(), state);
+        }
+    }
+
+    MONGO_BENCHMARK_WITH_ARGS(SorterTopTen, "1000,100000") {
+        const std::vector<int> keys = makeKeys(state.arg());
+        while (state.keepRunning()) {
+            sortKeys(keys, SortOptions().Limit(10), state);
+        }
+    }
+
+}  // namespace
+}  // namespace mongo
@@ -291,6 +291,21 @@ namespace mongo {
                 ASSERT_ITERATORS_EQUIVALENT(mergeIterators(iterators, DESC),
                                             make_shared<IntIterator>(30,0,-1));
             }
+            { // test an odd number of sources of different lengths
+                boost::shared_ptr<IWIterator> iterators[] =
+                    { make_shared<IntIterator>(0, 70, 7) // 0, 7, ... 63
+                    , make_shared<IntIterator>(1, 35, 7) // 1, 8, ... 29
+                    , make_shared<IntIterator>(2, 70, 7) // 2, 9, ... 65
+                    , make_shared<IntIterator>(3, 70, 7)
+                    , make_shared<IntIterator>(4, 70, 7)
+                    , make_shared<IntIterator>(5, 70, 7)
+                    , make_shared<IntIterator>(6, 70, 7)
+                    , make_shared<IntIterator>(36, 70, 7) // 36, 43, ... 64
+                    };
+
+                ASSERT_ITERATORS_EQUIVALENT(mergeIterators(iterators, ASC),
+                                            make_shared<IntIterator>(0,70,1));
+            }
             { // test Limit
                 boost::shared_ptr<IWIterator> iterators[] =
                     { make_shared<IntIterator>(1, 20, 2) // 1, 3, ... 19
@@ -498,6 +513,14 @@ namespace mongo {
         };
 
 
+        template <bool Random=true>
+        class LotsOfDataSpillThreads : public LotsOfDataLittleMemory<Random> {
+            typedef LotsOfDataLittleMemory<Random> Parent;
+            SortOptions adjustSortOptions(SortOptions opts) {
+                return Parent::adjustSortOptions(opts).SpillThreads(3);
+            }
+        };
+
         template <long long Limit, bool Random=true>
         class LotsOfDataWithLimit : public LotsOfDataLittleMemory<Random> {
             typedef LotsOfDataLittleMemory<Random> Parent;
@@ -521,6 +544,67 @@ namespace mongo {
             }
             enum { MEM_LIMIT = 32*1024 };
         };
+
+        // Keeps the runs of a Sorter that has only been given part of the data, and finishes
+        // the sort with a new Sorter started from them.
+        template <int SpillThreads>
+        class ResumeFromExistingRuns {
+        public:
+            void run() {
+                unittest::TempDir tempDir("sorterTests");
+                unittest::TempDir keptDir("sorterTestsKept");
+                const SortOptions opts = SortOptions().TempDir(tempDir.path())
+                                                      .MaxMemoryUsageBytes(MEM_LIMIT)
+                                                      .ExtSortAllowed()
+                                                      .SpillThreads(SpillThreads);
+
+                std::vector<std::string> kept;
+                {
+                    boost::shared_ptr<IWSorter> sorter(IWSorter::make(opts, IWComparator(ASC)));
+                    for (int i = 0; i < NUM_ITEMS; i += 2) {
+                        sorter->add(i, -i);
+                    }
+
+                    std::vector<std::string> runs;
+                    sorter->spillAll(&runs);
+                    ASSERT_EQUALS(static_cast<size_t>(sorter->numFiles()), runs.size());
+                    ASSERT_GREATER_THAN(runs.size(), 1U);
+
+                    sorter->add(-1, 1); // not part of the kept runs
+                    sorter->spillAll(&runs);
+                    ASSERT_EQUALS(static_cast<size_t>(sorter->numFiles()), runs.size());
+
+                    // Everything but the run holding -1.
+                    runs.pop_back();
+                    for (size_t i = 0; i < runs.size(); i++) {
+                        const std::string name = mongoutils::str::stream() << keptDir.path()
+                                                                           << "/run." << i;
+                        boost::filesystem::create_hard_link(runs[i], name);
+                        kept.push_back(name);
+                    }
+                }
+                ASSERT(boost::filesystem::is_empty(tempDir.path()));
+
+                {
+                    boost::shared_ptr<IWSorter> sorter(
+                        IWSorter::makeFromExistingRuns(kept, opts, IWComparator(ASC)));
+                    for (int i = 1; i < NUM_ITEMS; i += 2) {
+                        sorter->add(i, -i);
+                    }
+                    ASSERT_ITERATORS_EQUIVALENT(boost::shared_ptr<IWIterator>(sorter->done()),
+                                                make_shared<IntIterator>(0, NUM_ITEMS));
+                }
+                ASSERT(boost::filesystem::is_empty(tempDir.path()));
+                for (size_t i = 0; i < kept.size(); i++) {
+                    ASSERT(boost::filesystem::exists(kept[i]));
+                }
+            }
+
+            enum Constants {
+                NUM_ITEMS = 100*1000,
+                MEM_LIMIT = 64*1024,
+            };
+        };
     }
 
     class SorterSuite : public mongo::unittest::Suite {
@@ -538,12 +622,16 @@ namespace mongo {
             add<SorterTests::Dupes>();
             add<SorterTests::LotsOfDataLittleMemory</*random=*/false> >();
             add<SorterTests::LotsOfDataLittleMemory</*random=*/true> >();
+            add<SorterTests::LotsOfDataSpillThreads</*random=*/false> >();
+            add<SorterTests::LotsOfDataSpillThreads</*random=*/true> >();
             add<SorterTests::LotsOfDataWithLimit<1,/*random=*/false> >(); // limit=1 is special case
             add<SorterTests::LotsOfDataWithLimit<1,/*random=*/true> >();  // limit=1 is special case
             add<SorterTests::LotsOfDataWithLimit<100,/*random=*/false> >(); // fits in mem
             add<SorterTests::LotsOfDataWithLimit<100,/*random=*/true> >();  // fits in mem
             add<SorterTests::LotsOfDataWithLimit<5000,/*random=*/false> >(); // spills
             add<SorterTests::LotsOfDataWithLimit<5000,/*random=*/true> >(); // spills
+            add<SorterTests::ResumeFromExistingRuns</*spillThreads=*/0> >();
+            add<SorterTests::ResumeFromExistingRuns</*spillThreads=*/3> >();
         }
     };
 
@@ -41,6 +41,7 @@
 #include "mongo/db/startup_warnings_common.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/util/log.h"
+#include "mongo/util/numa.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/version.h"
 
@@ -90,7 +91,11 @@ namespace mongo {
                   << "Failed to probe \"" << e.path1().string() << "\": " << e.code().message()
                   << startupWarningsLog;
         }
-        if (hasMultipleNumaNodes) {
+        if (hasMultipleNumaNodes && NumaPlacement::enabled()) {
+            log() << "placing connection threads and storage engine sessions on "
+                  << NumaPlacement::nodeCount() << " NUMA nodes";
+        }
+        else if (hasMultipleNumaNodes) {
             // We are on a box with a NUMA enabled kernel and more than 1 numa node (they start at
             // node0)
             // Now we look at the first line of /proc/self/numa_maps
@@ -131,6 +136,8 @@ namespace mongo {
                               << "performance problems:" << startupWarningsLog;
                         log() << "**              numactl --interleave=all mongod [other options]"
                               << startupWarningsLog;
+                        log() << "**          or to let mongod place its threads by node with "
+                              << "--setParameter numaPlacement=true" << startupWarningsLog;
                         warned = true;
                     }
                 }
@@ -35,43 +35,37 @@
 
 #include "mongo/db/jsobj.h"
 #include "mongo/util/log.h"
+#include "mongo/util/net/message_compressor.h"
 
 namespace mongo {
     OpCounters::OpCounters() {}
 
     void OpCounters::incInsertInWriteLock(int n) {
-        RARELY _checkWrap();
-        _insert.fetchAndAdd(n);
+        _insert.add(n);
     }
 
     void OpCounters::gotInsert() {
-        RARELY _checkWrap();
-        _insert.fetchAndAdd(1);
+        _insert.increment();
     }
 
     void OpCounters::gotQuery() {
-        RARELY _checkWrap();
-        _query.fetchAndAdd(1);
+        _query.increment();
     }
 
     void OpCounters::gotUpdate() {
-        RARELY _checkWrap();
-        _update.fetchAndAdd(1);
+        _update.increment();
     }
 
     void OpCounters::gotDelete() {
-        RARELY _checkWrap();
-        _delete.fetchAndAdd(1);
+        _delete.increment();
     }
 
     void OpCounters::gotGetMore() {
-        RARELY _checkWrap();
-        _getmore.fetchAndAdd(1);
+        _getmore.increment();
     }
 
     void OpCounters::gotCommand() {
-        RARELY _checkWrap();
-        _command.fetchAndAdd(1);
+        _command.increment();
     }
 
     void OpCounters::gotOp( int op , bool isCommand ) {
@@ -95,67 +89,28 @@ namespace mongo {
         }
     }
 
-    void OpCounters::_checkWrap() {
-        const unsigned MAX = 1 << 30;
-        
-        bool wrap =
-            _insert.loadRelaxed() > MAX ||
-            _query.loadRelaxed() > MAX ||
-            _update.loadRelaxed() > MAX ||
-            _delete.loadRelaxed() > MAX ||
-            _getmore.loadRelaxed() > MAX ||
-            _command.loadRelaxed() > MAX;
-        
-        if ( wrap ) {
-            _insert.store(0);
-            _query.store(0);
-            _update.store(0);
-            _delete.store(0);
-            _getmore.store(0);
-            _command.store(0);
-        }
-    }
-
     BSONObj OpCounters::getObj() const {
         BSONObjBuilder b;
-        b.append( "insert" , _insert.loadRelaxed() );
-        b.append( "query" , _query.loadRelaxed() );
-        b.append( "update" , _update.loadRelaxed() );
-        b.append( "delete" , _delete.loadRelaxed() );
-        b.append( "getmore" , _getmore.loadRelaxed() );
-        b.append( "command" , _command.loadRelaxed() );
+        b.appendNumber( "insert" , _insert.load() );
+        b.appendNumber( "query" , _query.load() );
+        b.appendNumber( "update" , _update.load() );
+        b.appendNumber( "delete" , _delete.load() );
+        b.appendNumber( "getmore" , _getmore.load() );
+        b.appendNumber( "command" , _command.load() );
         return b.obj();
     }
 
     void NetworkCounter::hit( long long bytesIn , long long bytesOut ) {
-        const long long MAX = 1ULL << 60;
-
-        // don't care about the race as its just a counter
-        bool overflow = _bytesIn > MAX || _bytesOut > MAX;
-
-        if ( overflow ) {
-            _lock.lock();
-            _overflows++;
-            _bytesIn = bytesIn;
-            _bytesOut = bytesOut;
-            _requests = 1;
-            _lock.unlock();
-        }
-        else {
-            _lock.lock();
-            _bytesIn += bytesIn;
-            _bytesOut += bytesOut;
-            _requests++;
-            _lock.unlock();
-        }
+        _bytesIn.add( bytesIn );
+        _bytesOut.add( bytesOut );
+        _requests.increment();
     }
 
     void NetworkCounter::append( BSONObjBuilder& b ) {
-        _lock.lock();
-        b.appendNumber( "bytesIn" , _bytesIn );
-        b.appendNumber( "bytesOut" , _bytesOut );
-        b.appendNumber( "numRequests" , _requests );
-        _lock.unlock();
+        b.appendNumber( "bytesIn" , _bytesIn.load() );
+        b.appendNumber( "bytesOut" , _bytesOut.load() );
+        b.appendNumber( "numRequests" , _requests.load() );
+        appendMessageCompressionStats( &b );
     }
 
 
@@ -34,13 +34,14 @@
 #include "mongo/platform/atomic_word.h"
 #include "mongo/util/net/message.h"
 #include "mongo/util/processinfo.h"
-#include "mongo/util/concurrency/spin_lock.h"
+#include "mongo/util/concurrency/sharded_counter.h"
 
 namespace mongo {
 
     /**
      * for storing operation counters
-     * note: not thread safe.  ok with that for speed
+     * each counter is sharded across cache lines, so bumping them from many threads is cheap
+     * and reading them (serverStatus) sums the shards
      */
     class OpCounters {
     public:
@@ -59,24 +60,20 @@ namespace mongo {
         BSONObj getObj() const;
         
         // thse are used by snmp, and other things, do not remove
-        const AtomicUInt32 * getInsert() const { return &_insert; }
-        const AtomicUInt32 * getQuery() const { return &_query; }
-        const AtomicUInt32 * getUpdate() const { return &_update; }
-        const AtomicUInt32 * getDelete() const { return &_delete; }
-        const AtomicUInt32 * getGetMore() const { return &_getmore; }
-        const AtomicUInt32 * getCommand() const { return &_command; }
+        const ShardedCounter * getInsert() const { return &_insert; }
+        const ShardedCounter * getQuery() const { return &_query; }
+        const ShardedCounter * getUpdate() const { return &_update; }
+        const ShardedCounter * getDelete() const { return &_delete; }
+        const ShardedCounter * getGetMore() const { return &_getmore; }
+        const ShardedCounter * getCommand() const { return &_command; }
 
     private:
-        void _checkWrap();
-        
-        // todo: there will be a lot of cache line contention on these.  need to do something 
-        //       else eventually.
-        AtomicUInt32 _insert;
-        AtomicUInt32 _query;
-        AtomicUInt32 _update;
-        AtomicUInt32 _delete;
-        AtomicUInt32 _getmore;
-        AtomicUInt32 _command;
+        ShardedCounter _insert;
+        ShardedCounter _query;
+        ShardedCounter _update;
+        ShardedCounter _delete;
+        ShardedCounter _getmore;
+        ShardedCounter _command;
     };
 
     extern OpCounters globalOpCounters;
@@ -84,17 +81,13 @@ namespace mongo {
 
     class NetworkCounter {
     public:
-        NetworkCounter() : _bytesIn(0), _bytesOut(0), _requests(0), _overflows(0) {}
+        NetworkCounter() {}
         void hit( long long bytesIn , long long bytesOut );
         void append( BSONObjBuilder& b );
     private:
-        long long _bytesIn;
-        long long _bytesOut;
-        long long _requests;
-
-        long long _overflows;
-
-        SpinLock _lock;
+        ShardedCounter _bytesIn;
+        ShardedCounter _bytesOut;
+        ShardedCounter _requests;
     };
 
     extern NetworkCounter networkCounter;
@@ -30,6 +30,8 @@
 
 #include "mongo/db/client.h"
 #include "mongo/db/commands/server_status.h"
+#include "mongo/db/concurrency/admission_control.h"
+#include "mongo/db/concurrency/tenant_scheduler.h"
 #include "mongo/db/operation_context.h"
 
 namespace mongo {
@@ -125,6 +127,38 @@ namespace mongo {
     } globalLockServerStatusSection;
 
 
+    class AdmissionControlServerStatusSection : public ServerStatusSection {
+    public:
+        AdmissionControlServerStatusSection() : ServerStatusSection("admissionControl") {}
+
+        virtual bool includeByDefault() const { return true; }
+
+        virtual BSONObj generateSection(OperationContext* txn,
+                                        const BSONElement& configElement) const {
+            BSONObjBuilder ret;
+            AdmissionControl::appendStats(&ret);
+            return ret.obj();
+        }
+
+    } admissionControlServerStatusSection;
+
+
+    class TenantSchedulerServerStatusSection : public ServerStatusSection {
+    public:
+        TenantSchedulerServerStatusSection() : ServerStatusSection("tenantScheduler") {}
+
+        virtual bool includeByDefault() const { return true; }
+
+        virtual BSONObj generateSection(OperationContext* txn,
+                                        const BSONElement& configElement) const {
+            BSONObjBuilder ret;
+            TenantScheduler::get()->appendStats(&ret);
+            return ret.obj();
+        }
+
+    } tenantSchedulerServerStatusSection;
+
+
     class LockStatsServerStatusSection : public ServerStatusSection {
     public:
         LockStatsServerStatusSection() : ServerStatusSection("locks"){}
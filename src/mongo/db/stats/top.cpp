@@ -62,19 +62,36 @@ namespace mongo {
 
     }
 
+    void Top::CollectionData::add( const CollectionData& other ) {
+        total.add( other.total );
+        readLock.add( other.readLock );
+        writeLock.add( other.writeLock );
+        queries.add( other.queries );
+        getmore.add( other.getmore );
+        insert.add( other.insert );
+        update.add( other.update );
+        remove.add( other.remove );
+        commands.add( other.commands );
+    }
+
+    Top::Shard& Top::_myShard() {
+        return _shards[ ShardedCounter::currentThreadCell() % kNumShards ];
+    }
+
     void Top::record( const StringData& ns, int op, int lockType, long long micros, bool command ) {
         if ( ns[0] == '?' )
             return;
 
         //cout << "record: " << ns << "\t" << op << "\t" << command << endl;
-        SimpleMutex::scoped_lock lk(_lock);
+        Shard& shard = _myShard();
+        SimpleMutex::scoped_lock lk(shard.lock);
 
-        if ( ( command || op == dbQuery ) && ns == _lastDropped ) {
-            _lastDropped = "";
+        if ( ( command || op == dbQuery ) && ns == shard.lastDropped ) {
+            shard.lastDropped = "";
             return;
         }
 
-        CollectionData& coll = _usage[ns];
+        CollectionData& coll = shard.usage[ns];
         _record( coll, op, lockType, micros, command );
     }
 
@@ -121,19 +138,32 @@ namespace mongo {
     }
 
     void Top::collectionDropped( const StringData& ns ) {
-        SimpleMutex::scoped_lock lk(_lock);
-        _usage.erase(ns);
-        _lastDropped = ns.toString();
+        for ( int i = 0; i < kNumShards; i++ ) {
+            SimpleMutex::scoped_lock lk(_shards[i].lock);
+            _shards[i].usage.erase(ns);
+        }
+
+        // The drop command itself is recorded next, by this thread
+        Shard& shard = _myShard();
+        SimpleMutex::scoped_lock lk(shard.lock);
+        shard.lastDropped = ns.toString();
     }
 
     void Top::cloneMap(Top::UsageMap& out) const {
-        SimpleMutex::scoped_lock lk(_lock);
-        out = _usage;
+        out = UsageMap();
+        for ( int i = 0; i < kNumShards; i++ ) {
+            SimpleMutex::scoped_lock lk(_shards[i].lock);
+            const UsageMap& usage = _shards[i].usage;
+            for ( UsageMap::const_iterator it = usage.begin(); it != usage.end(); ++it ) {
+                out[it->first].add( it->second );
+            }
+        }
     }
 
     void Top::append( BSONObjBuilder& b ) {
-        SimpleMutex::scoped_lock lk( _lock );
-        _appendToUsageMap( b, _usage );
+        UsageMap merged;
+        cloneMap( merged );
+        _appendToUsageMap( b, merged );
     }
 
     void Top::_appendToUsageMap( BSONObjBuilder& b, const UsageMap& map ) const {
@@ -32,17 +32,22 @@
 #include <boost/date_time/posix_time/posix_time.hpp>
 
 #include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/concurrency/sharded_counter.h"
 #include "mongo/util/string_map.h"
 
 namespace mongo {
 
     /**
      * tracks usage by collection
+     *
+     * Usage is recorded into one of several independently locked shards, picked by the
+     * recording thread, so that concurrent operations rarely contend on a lock.  Readers merge
+     * the shards.
      */
     class Top {
 
     public:
-        Top() : _lock("Top") { }
+        Top() { }
 
         struct UsageData {
             UsageData() : time(0), count(0) {}
@@ -54,6 +59,11 @@ namespace mongo {
                 count++;
                 time += micros;
             }
+
+            void add( const UsageData& other ) {
+                count += other.count;
+                time += other.time;
+            }
         };
 
         struct CollectionData {
@@ -74,6 +84,8 @@ namespace mongo {
             UsageData update;
             UsageData remove;
             UsageData commands;
+
+            void add( const CollectionData& other );
         };
 
         typedef StringMap<CollectionData> UsageMap;
@@ -92,9 +104,21 @@ namespace mongo {
         void _appendStatsEntry( BSONObjBuilder& b, const char * statsName, const UsageData& map ) const;
         void _record( CollectionData& c, int op, int lockType, long long micros, bool command );
 
-        mutable SimpleMutex _lock;
-        UsageMap _usage;
-        std::string _lastDropped;
+        struct Shard {
+            Shard() : lock("Top") { }
+
+            mutable SimpleMutex lock;
+            UsageMap usage;
+
+            // collection most recently dropped by a thread recording into this shard
+            std::string lastDropped;
+        };
+
+        enum { kNumShards = 16 };
+
+        Shard& _myShard();
+
+        Shard _shards[kNumShards];
     };
 
 } // namespace mongo
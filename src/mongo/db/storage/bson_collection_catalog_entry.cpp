@@ -104,6 +104,16 @@ namespace mongo {
         return md.indexes[offset].ready;
     }
 
+    BSONObj BSONCollectionCatalogEntry::getIndexBuildCheckpoint(
+            OperationContext* txn,
+            const StringData& indexName ) const {
+        MetaData md = _getMetaData( txn );
+
+        int offset = md.findIndexOffset( indexName );
+        invariant( offset >= 0 );
+        return md.indexes[offset].buildCheckpoint;
+    }
+
     // --------------------------
 
     void BSONCollectionCatalogEntry::IndexMetaData::updateTTLSetting( long long newExpireSeconds ) {
@@ -163,6 +173,8 @@ namespace mongo {
                 sub.appendBool( "ready", indexes[i].ready );
                 sub.appendBool( "multikey", indexes[i].multikey );
                 sub.append( "head", static_cast<long long>(indexes[i].head.repr()) );
+                if ( !indexes[i].buildCheckpoint.isEmpty() )
+                    sub.append( "buildCheckpoint", indexes[i].buildCheckpoint );
                 sub.done();
             }
             arr.done();
@@ -193,6 +205,8 @@ namespace mongo {
                                          idx["head_b"].Int() );
                 }
                 imd.multikey = idx["multikey"].trueValue();
+                if ( idx["buildCheckpoint"].isABSONObj() )
+                    imd.buildCheckpoint = idx["buildCheckpoint"].Obj().getOwned();
                 indexes.push_back( imd );
             }
         }
@@ -68,6 +68,9 @@ namespace mongo {
         virtual bool isIndexReady( OperationContext* txn,
                                    const StringData& indexName ) const;
 
+        virtual BSONObj getIndexBuildCheckpoint( OperationContext* txn,
+                                                 const StringData& indexName ) const;
+
         // ------ for implementors
 
         struct IndexMetaData {
@@ -83,6 +86,7 @@ namespace mongo {
             bool ready;
             RecordId head;
             bool multikey;
+            BSONObj buildCheckpoint; // Only while the index is not ready. See MultiIndexBlock.
         };
 
         struct MetaData {
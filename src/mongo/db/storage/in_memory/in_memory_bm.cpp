@@ -0,0 +1,137 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "mongo/db/operation_context_noop.h"
+#include "mongo/db/storage/in_memory/in_memory_btree_impl.h"
+#include "mongo/db/storage/in_memory/in_memory_record_store.h"
+#include "mongo/db/storage/in_memory/in_memory_recovery_unit.h"
+#include "mongo/unittest/benchmark.h"
+
+namespace mongo {
+namespace {
+
+    /**
+     * Storage engine cursor operations, timed against the in-memory engine so that the cost of
+     * the cursor and record store interfaces is measured rather than that of I/O.
+     */
+
+    OperationContextNoop* newOperationContext() {
+        return new OperationContextNoop(new InMemoryRecoveryUnit());
+    }
+
+    /**
+     * Fills 'rs' with 'count' small documents, returning their RecordIds.
+     */
+    std::vector<RecordId> fillRecordStore(OperationContext* txn, RecordStore* rs, long long count) {
+        std::vector<RecordId> locs;
+        WriteUnitOfWork wuow(txn);
+        for (long long i = 0; i < count; i++) {
+            const BSONObj doc = BSON("_id" << i << "x" << "a string value");
+            StatusWith<RecordId> loc = rs->insertRecord(txn, doc.objdata(), doc.objsize(), false);
+            invariant(loc.isOK());
+            locs.push_back(loc.getValue());
+        }
+        wuow.commit();
+        return locs;
+    }
+
+    MONGO_BENCHMARK_WITH_ARGS(RecordStoreScan, "100,10000") {
+        boost::shared_ptr<void> data;
+        InMemoryRecordStore rs("bench.records", &data);
+        const boost::scoped_ptr<OperationContextNoop> txn(newOperationContext());
+        fillRecordStore(txn.get(), &rs, state.arg());
+
+        while (state.keepRunning()) {
+            boost::scoped_ptr<RecordIterator> it(
+                rs.getIterator(txn.get(), RecordId(), CollectionScanParams::FORWARD));
+            int size = 0;
+            while (!it->isEOF()) {
+                size += it->dataFor(it->getNext()).size();
+            }
+            state.doNotOptimize(size);
+        }
+    }
+
+    MONGO_BENCHMARK_WITH_ARGS(RecordStoreFindRecord, "100,10000") {
+        boost::shared_ptr<void> data;
+        InMemoryRecordStore rs("bench.records", &data);
+        const boost::scoped_ptr<OperationContextNoop> txn(newOperationContext());
+        const std::vector<RecordId> locs = fillRecordStore(txn.get(), &rs, state.arg());
+
+        size_t next = 0;
+        while (state.keepRunning()) {
+            RecordData rd;
+            state.doNotOptimize(rs.findRecord(txn.get(), locs[next], &rd));
+            next = (next + 1) % locs.size();
+        }
+    }
+
+    MONGO_BENCHMARK(RecordStoreInsert) {
+        boost::shared_ptr<void> data;
+        InMemoryRecordStore rs("bench.records", &data);
+        const boost::scoped_ptr<OperationContextNoop> txn(newOperationContext());
+        const BSONObj doc = BSON("_id" << 1 << "x" << "a string value");
+
+        while (state.keepRunning()) {
+            WriteUnitOfWork wuow(txn.get());
+            state.doNotOptimize(rs.insertRecord(txn.get(), doc.objdata(), doc.objsize(), false));
+            wuow.commit();
+        }
+    }
+
+    // Seeks an index cursor to one of 'arg' keys and reads the entry there.
+    MONGO_BENCHMARK_WITH_ARGS(SortedDataCursorLocate, "100,10000") {
+        boost::shared_ptr<void> data;
+        const boost::scoped_ptr<SortedDataInterface> index(
+            getInMemoryBtreeImpl(Ordering::make(BSON("a" << 1)), &data));
+        const boost::scoped_ptr<OperationContextNoop> txn(newOperationContext());
+        {
+            WriteUnitOfWork wuow(txn.get());
+            for (long long i = 0; i < state.arg(); i++) {
+                invariant(index->insert(txn.get(), BSON("" << i), RecordId(1, i), true).isOK());
+            }
+            wuow.commit();
+        }
+
+        const boost::scoped_ptr<SortedDataInterface::Cursor> cursor(
+            index->newCursor(txn.get(), 1));
+        long long next = 0;
+        while (state.keepRunning()) {
+            cursor->locate(BSON("" << next), RecordId(1, next));
+            state.doNotOptimize(cursor->getRecordId());
+            next = (next + 7) % state.arg();
+        }
+    }
+
+}  // namespace
+}  // namespace mongo
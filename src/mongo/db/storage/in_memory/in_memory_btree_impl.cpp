@@ -32,11 +32,14 @@
 
 #include "mongo/db/storage/in_memory/in_memory_btree_impl.h"
 
-#include <set>
+#include <algorithm>
+#include <boost/scoped_ptr.hpp>
 
 #include "mongo/db/catalog/index_catalog_entry.h"
 #include "mongo/db/storage/index_entry_comparison.h"
+#include "mongo/db/storage/in_memory/in_memory_index_tree.h"
 #include "mongo/db/storage/in_memory/in_memory_recovery_unit.h"
+#include "mongo/platform/unordered_map.h"
 #include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
@@ -63,7 +66,87 @@ namespace {
         return bb.obj();
     }
 
-    typedef std::set<IndexKeyEntry, IndexEntryComparison> IndexSet;
+    typedef InMemoryIndexTree IndexSet;
+
+    /**
+     * The RecordIds of each key of a hashed index, so that equality lookups on the hash don't
+     * have to descend the tree. Every key a hashed index generates is a single NumberLong; other
+     * keys are only kept in the tree.
+     */
+    class PointMap {
+    public:
+        static bool isPoint(const BSONObj& key, long long* pointOut) {
+            BSONObjIterator it(key);
+            if (!it.more())
+                return false;
+            const BSONElement e = it.next();
+            if (it.more() || e.type() != NumberLong)
+                return false;
+            *pointOut = e._numberLong();
+            return true;
+        }
+
+        void insert(const IndexKeyEntry& entry) {
+            long long point;
+            if (!isPoint(entry.key, &point))
+                return;
+            std::vector<RecordId>& locs = _locs[point];
+            locs.insert(std::lower_bound(locs.begin(), locs.end(), entry.loc), entry.loc);
+        }
+
+        void erase(const IndexKeyEntry& entry) {
+            long long point;
+            if (!isPoint(entry.key, &point))
+                return;
+            Map::iterator it = _locs.find(point);
+            invariant(it != _locs.end());
+            std::vector<RecordId>& locs = it->second;
+            std::vector<RecordId>::iterator loc = std::lower_bound(locs.begin(), locs.end(),
+                                                                   entry.loc);
+            invariant(loc != locs.end() && *loc == entry.loc);
+            locs.erase(loc);
+            if (locs.empty())
+                _locs.erase(it);
+        }
+
+        void find(long long point, std::vector<RecordId>* locsOut) const {
+            Map::const_iterator it = _locs.find(point);
+            if (it != _locs.end())
+                locsOut->insert(locsOut->end(), it->second.begin(), it->second.end());
+        }
+
+    private:
+        typedef unordered_map<long long, std::vector<RecordId> > Map;
+        Map _locs;
+    };
+
+    /**
+     * What getInMemoryBtreeImpl() keeps in its 'dataInOut' for each index.
+     */
+    struct IndexData {
+        IndexData(const Ordering& ordering, bool hashed)
+            : tree(ordering),
+              points(hashed ? new PointMap() : NULL) {
+        }
+
+        bool insert(const IndexKeyEntry& entry) {
+            if (!tree.insert(entry))
+                return false;
+            if (points)
+                points->insert(entry);
+            return true;
+        }
+
+        size_t erase(const IndexKeyEntry& entry) {
+            const size_t numDeleted = tree.erase(entry);
+            if (numDeleted && points)
+                points->erase(entry);
+            return numDeleted;
+        }
+
+        IndexSet tree;
+        const boost::scoped_ptr<PointMap> points; // NULL unless the index is hashed
+    };
 
     // taken from btree_logic.cpp
     Status dupKeyError(const BSONObj& key) {
@@ -75,22 +158,25 @@ namespace {
     }
 
     bool isDup(const IndexSet& data, const BSONObj& key, RecordId loc) {
-        const IndexSet::const_iterator it = data.find(IndexKeyEntry(key, RecordId()));
-        if (it == data.end())
+        // A null RecordId compares equal to every entry with this key.
+        const IndexKeyEntry query(key, RecordId());
+        const IndexSet::Position pos = data.lowerBound(query);
+        if (pos.isEnd() || data.comparator().compare(data.get(pos), query) != 0)
             return false;
 
         // Not a dup if the entry is for the same loc.
-        return it->loc != loc;
+        return data.get(pos).loc != loc;
     }
 
     class InMemoryBtreeBuilderImpl : public SortedDataBuilderInterface {
     public:
-        InMemoryBtreeBuilderImpl(IndexSet* data, long long* currentKeySize, bool dupsAllowed)
+        InMemoryBtreeBuilderImpl(IndexData* data, long long* currentKeySize, bool dupsAllowed)
                 : _data(data),
                   _currentKeySize( currentKeySize ),
                   _dupsAllowed(dupsAllowed),
-                  _comparator(_data->key_comp()) {
-            invariant(_data->empty());
+                  _comparator(_data->tree.comparator()),
+                  _last(BSONObj(), RecordId()) {
+            invariant(_data->tree.empty());
         }
 
         Status addKey(const BSONObj& key, const RecordId& loc) {
@@ -103,37 +189,37 @@ namespace {
             invariant(loc.isNormal());
             invariant(!hasFieldNames(key));
 
-            if (!_data->empty()) {
+            if (!_data->tree.empty()) {
                 // Compare specified key with last inserted key, ignoring its RecordId
-                int cmp = _comparator.compare(IndexKeyEntry(key, RecordId()), *_last);
-                if (cmp < 0 || (_dupsAllowed && cmp == 0 && loc < _last->loc)) {
+                int cmp = _comparator.compare(IndexKeyEntry(key, RecordId()), _last);
+                if (cmp < 0 || (_dupsAllowed && cmp == 0 && loc < _last.loc)) {
                     return Status(ErrorCodes::InternalError,
                                   "expected ascending (key, RecordId) order in bulk builder");
                 }
-                else if (!_dupsAllowed && cmp == 0 && loc != _last->loc) {
+                else if (!_dupsAllowed && cmp == 0 && loc != _last.loc) {
                     return dupKeyError(key);
                 }
             }
 
-            BSONObj owned = key.getOwned();
-            _last = _data->insert(_data->end(), IndexKeyEntry(owned, loc));
-            *_currentKeySize += key.objsize();
+            _last = IndexKeyEntry(key.getOwned(), loc);
+            if (_data->insert(_last))
+                *_currentKeySize += key.objsize();
 
             return Status::OK();
         }
 
     private:
-        IndexSet* const _data;
+        IndexData* const _data;
         long long* _currentKeySize;
         const bool _dupsAllowed;
 
         IndexEntryComparison _comparator;  // used by the bulk builder to detect duplicate keys
-        IndexSet::const_iterator _last;    // or (key, RecordId) ordering violations
+        IndexKeyEntry _last;               // or (key, RecordId) ordering violations
     };
 
     class InMemoryBtreeImpl : public SortedDataInterface {
     public:
-        InMemoryBtreeImpl(IndexSet* data)
+        InMemoryBtreeImpl(IndexData* data)
             : _data(data) {
             _currentKeySize = 0;
         }
@@ -159,11 +245,11 @@ namespace {
             }
 
             // TODO optimization: save the iterator from the dup-check to speed up insert
-            if (!dupsAllowed && isDup(*_data, key, loc))
+            if (!dupsAllowed && isDup(_data->tree, key, loc))
                 return dupKeyError(key);
 
             IndexKeyEntry entry(key.getOwned(), loc);
-            if ( _data->insert(entry).second ) {
+            if ( _data->insert(entry) ) {
                 _currentKeySize += key.objsize();
                 txn->recoveryUnit()->registerChange(new IndexChange(_data, entry, true));
             }
@@ -189,22 +275,22 @@ namespace {
         virtual void fullValidate(OperationContext* txn, bool full, long long *numKeysOut,
                                   BSONObjBuilder* output) const {
             // TODO check invariants?
-            *numKeysOut = _data->size();
+            *numKeysOut = _data->tree.size();
         }
 
         virtual long long getSpaceUsedBytes( OperationContext* txn ) const {
-            return _currentKeySize + ( sizeof(IndexKeyEntry) * _data->size() );
+            return _currentKeySize + ( sizeof(IndexKeyEntry) * _data->tree.size() );
         }
 
         virtual Status dupKeyCheck(OperationContext* txn, const BSONObj& key, const RecordId& loc) {
             invariant(!hasFieldNames(key));
-            if (isDup(*_data, key, loc))
+            if (isDup(_data->tree, key, loc))
                 return dupKeyError(key);
             return Status::OK();
         }
 
         virtual bool isEmpty(OperationContext* txn) {
-            return _data->empty();
+            return _data->tree.empty();
         }
 
         virtual Status touch(OperationContext* txn) const{
@@ -212,24 +298,30 @@ namespace {
             return Status::OK();
         }
 
-        class ForwardCursor : public SortedDataInterface::Cursor {
+        class Cursor : public SortedDataInterface::Cursor {
         public:
-            ForwardCursor(const IndexSet& data, OperationContext* txn)
+            Cursor(const IndexSet& data, OperationContext* txn, int direction)
                 : _txn(txn),
                   _data(data),
-                  _it(data.end())
+                  _direction(direction),
+                  _version(data.version()),
+                  _current(BSONObj(), RecordId())
             {}
 
-            virtual int getDirection() const { return 1; }
+            virtual int getDirection() const { return _direction; }
 
             virtual bool isEOF() const {
-                return _it == _data.end();
+                return _pos.isEnd();
             }
 
             virtual bool pointsToSamePlaceAs(const SortedDataInterface::Cursor& otherBase) const {
-                const ForwardCursor& other = static_cast<const ForwardCursor&>(otherBase);
+                const Cursor& other = static_cast<const Cursor&>(otherBase);
                 invariant(&_data == &other._data); // iterators over same index
-                return _it == other._it;
+                if (isEOF() || other.isEOF())
+                    return isEOF() == other.isEOF();
+
+                // Entries are unique, so equal ones are the same place.
+                return _data.comparator().compare(_current, other._current) == 0;
             }
 
             virtual void aboutToDeleteBucket(const RecordId& bucket) {
@@ -238,16 +330,16 @@ namespace {
 
             virtual bool locate(const BSONObj& keyRaw, const RecordId& loc) {
                 const BSONObj key = stripFieldNames(keyRaw);
-                _it = _data.lower_bound(IndexKeyEntry(key, loc)); // lower_bound is >= key
-                if ( _it == _data.end() ) {
+                seek(IndexKeyEntry(key, loc));
+                if ( isEOF() ) {
                     return false;
                 }
 
-                if ( _it->key != key ) {
+                if ( _current.key != key ) {
                     return false;
                 }
 
-                return _it->loc == loc;
+                return _current.loc == loc;
             }
 
             virtual void customLocate(const BSONObj& keyBegin,
@@ -256,14 +348,13 @@ namespace {
                                       const vector<const BSONElement*>& keyEnd,
                                       const vector<bool>& keyEndInclusive) {
                 // makeQueryObject handles stripping of fieldnames for us.
-                _it = _data.lower_bound(IndexKeyEntry(IndexEntryComparison::makeQueryObject(
-                                                        keyBegin,
-                                                        keyBeginLen,
-                                                        afterKey,
-                                                        keyEnd,
-                                                        keyEndInclusive,
-                                                        1), // forward
-                                                   RecordId()));
+                seek(IndexKeyEntry(IndexEntryComparison::makeQueryObject(keyBegin,
+                                                                         keyBeginLen,
+                                                                         afterKey,
+                                                                         keyEnd,
+                                                                         keyEndInclusive,
+                                                                         _direction),
+                                   RecordId()));
             }
 
             void advanceTo(const BSONObj &keyBegin,
@@ -271,149 +362,64 @@ namespace {
                            bool afterKey,
                            const vector<const BSONElement*>& keyEnd,
                            const vector<bool>& keyEndInclusive) {
-                // XXX I think these do the same thing????
-                customLocate(keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive);
+                // Scans usually skip only a little way, so look near the current entry first.
+                seek(IndexKeyEntry(IndexEntryComparison::makeQueryObject(keyBegin,
+                                                                         keyBeginLen,
+                                                                         afterKey,
+                                                                         keyEnd,
+                                                                         keyEndInclusive,
+                                                                         _direction),
+                                   RecordId()),
+                     true);
             }
 
             virtual BSONObj getKey() const {
-                return _it->key;
+                return _current.key;
             }
 
             virtual RecordId getRecordId() const {
-                return _it->loc;
+                return _current.loc;
             }
 
             virtual void advance() {
-                if (_it != _data.end())
-                    ++_it;
-            }
+                if (isEOF())
+                    return;
 
-            virtual void savePosition() {
-                if (_it == _data.end()) {
-                    _savedAtEnd = true;
+                if (_version != _data.version()) {
+                    // The index changed under us, so _pos may be gone. Step from _current.
+                    if (_direction == 1) {
+                        setPosition(_data.upperBound(_current));
+                    }
+                    else {
+                        setPosition(beforeLowerBound(_current));
+                    }
                     return;
                 }
 
-                _savedAtEnd = false;
-                _savedKey = _it->key.getOwned();
-                _savedLoc = _it->loc;
-            }
-
-            virtual void restorePosition(OperationContext* txn) {
-                if (_savedAtEnd) {
-                    _it = _data.end();
+                IndexSet::Position pos = _pos;
+                if (_direction == 1) {
+                    _data.next(&pos);
                 }
                 else {
-                    locate(_savedKey, _savedLoc);
-                }
-            }
-
-        private:
-
-            OperationContext* _txn; // not owned
-            const IndexSet& _data;
-            IndexSet::const_iterator _it;
-
-            // For save/restorePosition since _it may be invalidated durring a yield.
-            bool _savedAtEnd;
-            BSONObj _savedKey;
-            RecordId _savedLoc;
-
-        };
-
-        // TODO see if this can share any code with ForwardIterator
-        class ReverseCursor : public SortedDataInterface::Cursor {
-        public:
-            ReverseCursor(const IndexSet& data, OperationContext* txn)
-                : _txn(txn),
-                  _data(data),
-                  _it(data.rend())
-            {}
-
-            virtual int getDirection() const { return -1; }
-
-            virtual bool isEOF() const {
-                return _it == _data.rend();
-            }
-
-            virtual bool pointsToSamePlaceAs(const SortedDataInterface::Cursor& otherBase) const {
-                const ReverseCursor& other = static_cast<const ReverseCursor&>(otherBase);
-                invariant(&_data == &other._data); // iterators over same index
-                return _it == other._it;
-            }
-
-            virtual void aboutToDeleteBucket(const RecordId& bucket) {
-                invariant(!"aboutToDeleteBucket should not be called");
-            }
-
-            virtual bool locate(const BSONObj& keyRaw, const RecordId& loc) {
-                const BSONObj key = stripFieldNames(keyRaw);
-                _it = lower_bound(IndexKeyEntry(key, loc)); // lower_bound is <= query
-
-                if ( _it == _data.rend() ) {
-                    return false;
+                    _data.prev(&pos);
                 }
-
-
-                if ( _it->key != key ) {
-                    return false;
-                }
-
-                return _it->loc == loc;
-            }
-
-            virtual void customLocate(const BSONObj& keyBegin,
-                                      int keyBeginLen,
-                                      bool afterKey,
-                                      const vector<const BSONElement*>& keyEnd,
-                                      const vector<bool>& keyEndInclusive) {
-                // makeQueryObject handles stripping of fieldnames for us.
-                _it = lower_bound(IndexKeyEntry(IndexEntryComparison::makeQueryObject(
-                                                  keyBegin,
-                                                  keyBeginLen,
-                                                  afterKey,
-                                                  keyEnd,
-                                                  keyEndInclusive,
-                                                  -1), // reverse
-                                             RecordId()));
-            }
-
-            void advanceTo(const BSONObj &keyBegin,
-                           int keyBeginLen,
-                           bool afterKey,
-                           const vector<const BSONElement*>& keyEnd,
-                           const vector<bool>& keyEndInclusive) {
-                // XXX I think these do the same thing????
-                customLocate(keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive);
-            }
-
-            virtual BSONObj getKey() const {
-                return _it->key;
-            }
-
-            virtual RecordId getRecordId() const {
-                return _it->loc;
-            }
-
-            virtual void advance() {
-                if (_it != _data.rend())
-                    ++_it;
+                setPosition(pos);
             }
 
             virtual void savePosition() {
-                if (_it == _data.rend()) {
+                if (isEOF()) {
                     _savedAtEnd = true;
                     return;
                 }
 
                 _savedAtEnd = false;
-                _savedKey = _it->key.getOwned();
-                _savedLoc = _it->loc;
+                _savedKey = _current.key.getOwned();
+                _savedLoc = _current.loc;
             }
 
             virtual void restorePosition(OperationContext* txn) {
                 if (_savedAtEnd) {
-                    _it = _data.rend();
+                    setPosition(IndexSet::Position());
                 }
                 else {
                     locate(_savedKey, _savedLoc);
@@ -422,36 +428,74 @@ namespace {
 
         private:
             /**
-             * Returns the first entry <= query. This is equivalent to ForwardCursors use of
-             * _data.lower_bound which returns the first entry >= query.
+             * Positions on the first entry >= query going forward, or the last entry <= query
+             * going in reverse.  If 'fromCurrent' the search starts at the current position,
+             * when it is still valid.
              */
-            IndexSet::const_reverse_iterator lower_bound(const IndexKeyEntry& query) const {
-                // using upper_bound since we want to the right-most entry matching the query.
-                IndexSet::const_iterator it = _data.upper_bound(query);
-
-                // upper_bound returns the entry to the right of the one we want. Helpfully,
-                // converting to a reverse_iterator moves one to the left. This also correctly
-                // handles the case where upper_bound returns end() by converting to rbegin(),
-                // meaning that all data is to the right of the query.
-                return IndexSet::const_reverse_iterator(it);
+            void seek(const IndexKeyEntry& query, bool fromCurrent = false) {
+                const IndexSet::Position hint = fromCurrent && _version == _data.version()
+                                              ? _pos
+                                              : IndexSet::Position();
+                if (_direction == 1) {
+                    setPosition(_data.lowerBound(query, hint));
+                }
+                else {
+                    // The right-most entry matching the query is just left of upperBound.
+                    IndexSet::Position pos = _data.upperBound(query, hint);
+                    if (pos.isEnd()) {
+                        pos = _data.last();
+                    }
+                    else {
+                        _data.prev(&pos);
+                    }
+                    setPosition(pos);
+                }
+            }
+
+            // The last entry < query.
+            IndexSet::Position beforeLowerBound(const IndexKeyEntry& query) const {
+                IndexSet::Position pos = _data.lowerBound(query);
+                if (pos.isEnd())
+                    return _data.last();
+                _data.prev(&pos);
+                return pos;
+            }
+
+            // Caches the entry at 'pos' so it can still be read after the index changes.
+            void setPosition(const IndexSet::Position& pos) {
+                _pos = pos;
+                _version = _data.version();
+                if (!_pos.isEnd())
+                    _current = _data.get(_pos);
             }
 
             OperationContext* _txn; // not owned
             const IndexSet& _data;
-            IndexSet::const_reverse_iterator _it;
+            const int _direction;
+
+            IndexSet::Position _pos;
+            unsigned long long _version; // of _data when _pos was set
+            IndexKeyEntry _current;      // the entry at _pos
 
-            // For save/restorePosition since _it may be invalidated durring a yield.
+            // For save/restorePosition since _pos may be invalidated durring a yield.
             bool _savedAtEnd;
             BSONObj _savedKey;
             RecordId _savedLoc;
         };
 
         virtual SortedDataInterface::Cursor* newCursor(OperationContext* txn, int direction) const {
-            if (direction == 1)
-                return new ForwardCursor(*_data, txn);
+            invariant(direction == 1 || direction == -1);
+            return new Cursor(_data->tree, txn, direction);
+        }
 
-            invariant(direction == -1);
-            return new ReverseCursor(*_data, txn);
+        virtual bool findExactKey(OperationContext* txn,
+                                  const BSONObj& key,
+                                  std::vector<RecordId>* locsOut) const {
+            long long point;
+            if (!_data->points || !PointMap::isPoint(key, &point))
+                return false;
+            _data->points->find(point, locsOut);
+            return true;
         }
 
         virtual Status initAsEmpty(OperationContext* txn) {
@@ -462,7 +506,7 @@ namespace {
     private:
         class IndexChange : public RecoveryUnit::Change {
         public:
-            IndexChange(IndexSet* data, const IndexKeyEntry& entry, bool insert)
+            IndexChange(IndexData* data, const IndexKeyEntry& entry, bool insert)
                 : _data(data), _entry(entry), _insert(insert)
             {}
 
@@ -475,12 +519,12 @@ namespace {
             }
 
         private:
-            IndexSet* _data;
+            IndexData* _data;
             const IndexKeyEntry _entry;
             const bool _insert;
         };
 
-        IndexSet* _data;
+        IndexData* _data;
         long long _currentKeySize;
     };
 } // namespace
@@ -488,12 +532,13 @@ namespace {
     // IndexCatalogEntry argument taken by non-const pointer for consistency with other Btree
     // factories. We don't actually modify it.
     SortedDataInterface* getInMemoryBtreeImpl(const Ordering& ordering,
-                                              boost::shared_ptr<void>* dataInOut) {
+                                              boost::shared_ptr<void>* dataInOut,
+                                              bool hashed) {
         invariant(dataInOut);
         if (!*dataInOut) {
-            *dataInOut = boost::make_shared<IndexSet>(IndexEntryComparison(ordering));
+            *dataInOut = boost::make_shared<IndexData>(ordering, hashed);
         }
-        return new InMemoryBtreeImpl(static_cast<IndexSet*>(dataInOut->get()));
+        return new InMemoryBtreeImpl(static_cast<IndexData*>(dataInOut->get()));
     }
 
 }  // namespace mongo
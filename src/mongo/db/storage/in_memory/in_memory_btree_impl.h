@@ -41,8 +41,13 @@ namespace mongo {
     /**
      * Caller takes ownership.
      * All permanent data will be stored and fetch from dataInOut.
+     *
+     * When 'hashed' is set, the index also keeps a hash table from each NumberLong key to its
+     * RecordIds, which answers findExactKey() without a tree descent. 'hashed' only matters the
+     * first time an index's data is created.
      */
     SortedDataInterface* getInMemoryBtreeImpl(const Ordering& ordering,
-                                              boost::shared_ptr<void>* dataInOut);
+                                              boost::shared_ptr<void>* dataInOut,
+                                              bool hashed = false);
 
 }  // namespace mongo
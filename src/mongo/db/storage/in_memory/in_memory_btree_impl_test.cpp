@@ -37,12 +37,13 @@ namespace mongo {
 
     class InMemoryHarnessHelper : public HarnessHelper {
     public:
-        InMemoryHarnessHelper()
-            : _order( Ordering::make( BSONObj() ) ) {
+        explicit InMemoryHarnessHelper( bool hashed = false )
+            : _order( Ordering::make( BSONObj() ) ),
+              _hashed( hashed ) {
         }
 
         virtual SortedDataInterface* newSortedDataInterface( bool unique ) {
-            return getInMemoryBtreeImpl(_order, &_data);
+            return getInMemoryBtreeImpl(_order, &_data, _hashed);
         }
 
         virtual RecoveryUnit* newRecoveryUnit() {
@@ -52,10 +53,105 @@ namespace mongo {
     private:
         shared_ptr<void> _data; // used by InMemoryBtreeImpl
         Ordering _order;
+        bool _hashed;
     };
 
     HarnessHelper* newHarnessHelper() {
         return new InMemoryHarnessHelper();
     }
 
+    namespace {
+
+        std::vector<RecordId> findExact( SortedDataInterface* sorted,
+                                         OperationContext* txn,
+                                         long long point ) {
+            std::vector<RecordId> locs;
+            ASSERT( sorted->findExactKey( txn, BSON( "" << point ), &locs ) );
+            return locs;
+        }
+
+    } // namespace
+
+    // Only hashed indexes answer findExactKey().
+    TEST( InMemoryBtreeImpl, FindExactKeyNeedsHash ) {
+        InMemoryHarnessHelper harnessHelper;
+        scoped_ptr<SortedDataInterface> sorted( harnessHelper.newSortedDataInterface( false ) );
+        scoped_ptr<OperationContext> opCtx( harnessHelper.newOperationContext() );
+
+        std::vector<RecordId> locs;
+        ASSERT( !sorted->findExactKey( opCtx.get(), BSON( "" << 1LL ), &locs ) );
+        ASSERT( locs.empty() );
+    }
+
+    // The hash follows inserts, unindexes and rolled back writes, and never answers for keys
+    // which aren't a single NumberLong.
+    TEST( InMemoryBtreeImpl, FindExactKeyHashed ) {
+        InMemoryHarnessHelper harnessHelper( true );
+        scoped_ptr<SortedDataInterface> sorted( harnessHelper.newSortedDataInterface( false ) );
+
+        {
+            scoped_ptr<OperationContext> opCtx( harnessHelper.newOperationContext() );
+            WriteUnitOfWork uow( opCtx.get() );
+            ASSERT_OK( sorted->insert( opCtx.get(), BSON( "" << 7LL ), RecordId( 1, 3 ), true ) );
+            ASSERT_OK( sorted->insert( opCtx.get(), BSON( "" << 7LL ), RecordId( 1, 1 ), true ) );
+            ASSERT_OK( sorted->insert( opCtx.get(), BSON( "" << 8LL ), RecordId( 1, 2 ), true ) );
+            uow.commit();
+        }
+
+        {
+            // Not committed, so rolled back.
+            scoped_ptr<OperationContext> opCtx( harnessHelper.newOperationContext() );
+            WriteUnitOfWork uow( opCtx.get() );
+            ASSERT_OK( sorted->insert( opCtx.get(), BSON( "" << 7LL ), RecordId( 1, 2 ), true ) );
+            sorted->unindex( opCtx.get(), BSON( "" << 8LL ), RecordId( 1, 2 ), true );
+        }
+
+        {
+            scoped_ptr<OperationContext> opCtx( harnessHelper.newOperationContext() );
+            std::vector<RecordId> locs = findExact( sorted.get(), opCtx.get(), 7 );
+            ASSERT_EQUALS( 2U, locs.size() );
+            ASSERT_EQUALS( RecordId( 1, 1 ), locs[0] );
+            ASSERT_EQUALS( RecordId( 1, 3 ), locs[1] );
+            ASSERT_EQUALS( 1U, findExact( sorted.get(), opCtx.get(), 8 ).size() );
+            ASSERT( findExact( sorted.get(), opCtx.get(), 9 ).empty() );
+
+            std::vector<RecordId> unused;
+            ASSERT( !sorted->findExactKey( opCtx.get(), BSON( "" << 7 ), &unused ) );
+        }
+
+        {
+            scoped_ptr<OperationContext> opCtx( harnessHelper.newOperationContext() );
+            WriteUnitOfWork uow( opCtx.get() );
+            sorted->unindex( opCtx.get(), BSON( "" << 7LL ), RecordId( 1, 1 ), true );
+            sorted->unindex( opCtx.get(), BSON( "" << 8LL ), RecordId( 1, 2 ), true );
+            uow.commit();
+        }
+
+        {
+            scoped_ptr<OperationContext> opCtx( harnessHelper.newOperationContext() );
+            std::vector<RecordId> locs = findExact( sorted.get(), opCtx.get(), 7 );
+            ASSERT_EQUALS( 1U, locs.size() );
+            ASSERT_EQUALS( RecordId( 1, 3 ), locs[0] );
+            ASSERT( findExact( sorted.get(), opCtx.get(), 8 ).empty() );
+        }
+    }
+
+    // A bulk built index is hashed as well.
+    TEST( InMemoryBtreeImpl, FindExactKeyBulkBuilt ) {
+        InMemoryHarnessHelper harnessHelper( true );
+        scoped_ptr<SortedDataInterface> sorted( harnessHelper.newSortedDataInterface( false ) );
+        scoped_ptr<OperationContext> opCtx( harnessHelper.newOperationContext() );
+
+        {
+            scoped_ptr<SortedDataBuilderInterface> builder(
+                sorted->getBulkBuilder( opCtx.get(), true ) );
+            ASSERT_OK( builder->addKey( BSON( "" << 5LL ), RecordId( 1, 1 ) ) );
+            ASSERT_OK( builder->addKey( BSON( "" << 5LL ), RecordId( 1, 2 ) ) );
+            ASSERT_OK( builder->addKey( BSON( "" << 6LL ), RecordId( 1, 3 ) ) );
+        }
+
+        ASSERT_EQUALS( 2U, findExact( sorted.get(), opCtx.get(), 5 ).size() );
+        ASSERT_EQUALS( 1U, findExact( sorted.get(), opCtx.get(), 6 ).size() );
+    }
+
 }
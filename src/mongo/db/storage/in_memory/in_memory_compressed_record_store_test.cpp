@@ -0,0 +1,165 @@
+// in_memory_compressed_record_store_test.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/storage/in_memory/in_memory_record_store.h"
+
+#include <boost/scoped_ptr.hpp>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/storage/in_memory/in_memory_recovery_unit.h"
+#include "mongo/db/storage/record_store_test_harness.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+
+    using boost::scoped_ptr;
+
+    // Runs the record store tests against stores which compress field names.
+    class InMemoryCompressedHarnessHelper : public HarnessHelper {
+    public:
+        InMemoryCompressedHarnessHelper() {
+        }
+
+        virtual RecordStore* newNonCappedRecordStore() {
+            return new InMemoryRecordStore( "a.b", &data, false, -1, -1, NULL, true );
+        }
+
+        virtual RecoveryUnit* newRecoveryUnit() {
+            return new InMemoryRecoveryUnit();
+        }
+
+        boost::shared_ptr<void> data;
+    };
+
+    HarnessHelper* newHarnessHelper() {
+        return new InMemoryCompressedHarnessHelper();
+    }
+
+namespace {
+
+    BSONObj makeDoc(int i) {
+        return BSON("_id" << i << "customerName" << "someone" << "shippingAddress"
+                    << BSON("streetAddress" << "1 Main St" << "postalCode" << 12345));
+    }
+
+    std::vector<RecordId> insertDocs(OperationContext* txn, RecordStore* rs, int n) {
+        std::vector<RecordId> locs;
+        WriteUnitOfWork uow(txn);
+        for (int i = 0; i < n; i++) {
+            const BSONObj doc = makeDoc(i);
+            StatusWith<RecordId> res = rs->insertRecord(txn, doc.objdata(), doc.objsize(), false);
+            ASSERT_OK(res.getStatus());
+            locs.push_back(res.getValue());
+        }
+        uow.commit();
+        return locs;
+    }
+
+    TEST(InMemoryCompressedRecordStore, StoresDocumentsInLessSpace) {
+        scoped_ptr<HarnessHelper> harnessHelper(newHarnessHelper());
+        scoped_ptr<RecordStore> rs(harnessHelper->newNonCappedRecordStore());
+        scoped_ptr<OperationContext> opCtx(harnessHelper->newOperationContext());
+        const std::vector<RecordId> locs = insertDocs(opCtx.get(), rs.get(), 100);
+
+        boost::shared_ptr<void> plainData;
+        InMemoryRecordStore plain("a.c", &plainData);
+        insertDocs(opCtx.get(), &plain, 100);
+
+        // dataSize() counts the documents' BSON, storageSize() what is held for them.
+        ASSERT_EQUALS(plain.dataSize(opCtx.get()), rs->dataSize(opCtx.get()));
+        ASSERT_LESS_THAN(rs->storageSize(opCtx.get()), plain.storageSize(opCtx.get()));
+
+        for (int i = 0; i < 100; i++) {
+            ASSERT_EQUALS(makeDoc(i), rs->dataFor(opCtx.get(), locs[i]).toBson());
+        }
+
+        BSONObjBuilder stats;
+        rs->appendCustomStats(opCtx.get(), &stats, 1);
+        ASSERT_EQUALS(BSON("capped" << false << "compressFieldNames" << true
+                           << "fieldNames" << 5LL),
+                      stats.obj());
+    }
+
+    TEST(InMemoryCompressedRecordStore, UpdatesDocuments) {
+        scoped_ptr<HarnessHelper> harnessHelper(newHarnessHelper());
+        scoped_ptr<RecordStore> rs(harnessHelper->newNonCappedRecordStore());
+        scoped_ptr<OperationContext> opCtx(harnessHelper->newOperationContext());
+        const RecordId loc = insertDocs(opCtx.get(), rs.get(), 1)[0];
+
+        const BSONObj replacement = makeDoc(7);
+        {
+            WriteUnitOfWork uow(opCtx.get());
+            ASSERT_OK(rs->updateRecord(opCtx.get(), loc, replacement.objdata(),
+                                       replacement.objsize(), false, NULL).getStatus());
+            uow.commit();
+        }
+        ASSERT_EQUALS(replacement, rs->dataFor(opCtx.get(), loc).toBson());
+
+        // Overwrite the 7 of the _id in place.
+        const RecordData oldRec = rs->dataFor(opCtx.get(), loc);
+        const BSONElement id = oldRec.toBson()["_id"];
+        const int newId = 9;
+        mutablebson::DamageVector damages(1);
+        damages[0].sourceOffset = 0;
+        damages[0].targetOffset = id.value() - oldRec.data();
+        damages[0].size = sizeof(newId);
+        {
+            WriteUnitOfWork uow(opCtx.get());
+            ASSERT_OK(rs->updateWithDamages(opCtx.get(), loc, oldRec,
+                                            reinterpret_cast<const char*>(&newId), damages));
+            uow.commit();
+        }
+        ASSERT_EQUALS(makeDoc(9), rs->dataFor(opCtx.get(), loc).toBson());
+
+        // An update which is rolled back leaves the old document.
+        {
+            WriteUnitOfWork uow(opCtx.get());
+            const BSONObj doc = makeDoc(11);
+            ASSERT_OK(rs->updateRecord(opCtx.get(), loc, doc.objdata(), doc.objsize(),
+                                       false, NULL).getStatus());
+        }
+        ASSERT_EQUALS(makeDoc(9), rs->dataFor(opCtx.get(), loc).toBson());
+    }
+
+    TEST(InMemoryCompressedRecordStore, ParseOptions) {
+        bool compressFieldNames;
+        ASSERT_OK(InMemoryRecordStore::parseOptions(BSONObj(), &compressFieldNames));
+        ASSERT_FALSE(compressFieldNames);
+        ASSERT_OK(InMemoryRecordStore::parseOptions(BSON("compressFieldNames" << true),
+                                                    &compressFieldNames));
+        ASSERT_TRUE(compressFieldNames);
+        ASSERT_NOT_OK(InMemoryRecordStore::parseOptions(BSON("compressFieldNames" << 1),
+                                                        &compressFieldNames));
+        ASSERT_NOT_OK(InMemoryRecordStore::parseOptions(BSON("other" << true),
+                                                        &compressFieldNames));
+    }
+
+} // namespace
+} // namespace mongo
@@ -31,12 +31,15 @@
 #include "mongo/db/storage/in_memory/in_memory_engine.h"
 
 #include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/index_names.h"
 #include "mongo/db/storage/in_memory/in_memory_btree_impl.h"
 #include "mongo/db/storage/in_memory/in_memory_record_store.h"
 #include "mongo/db/storage/in_memory/in_memory_recovery_unit.h"
 
 namespace mongo {
 
+    const std::string kInMemoryEngineName = "inMemoryExperiment";
+
     RecoveryUnit* InMemoryEngine::newRecoveryUnit() {
         return new InMemoryRecoveryUnit();
     }
@@ -53,16 +56,29 @@ namespace mongo {
                                              const StringData& ns,
                                              const StringData& ident,
                                              const CollectionOptions& options) {
+        bool compressFieldNames;
+        const Status status = InMemoryRecordStore::parseOptions(
+            options.storageEngine.getObjectField(kInMemoryEngineName), &compressFieldNames);
+        invariant(status.isOK()); // checked when the collection was created
+
         boost::mutex::scoped_lock lk(_mutex);
         if (options.capped) {
             return new InMemoryRecordStore(ns,
                                            &_dataMap[ident],
                                            true,
                                            options.cappedSize ? options.cappedSize : 4096,
-                                           options.cappedMaxDocs ? options.cappedMaxDocs : -1);
+                                           options.cappedMaxDocs ? options.cappedMaxDocs : -1,
+                                           NULL,
+                                           compressFieldNames);
         }
         else {
-            return new InMemoryRecordStore(ns, &_dataMap[ident]);
+            return new InMemoryRecordStore(ns,
+                                           &_dataMap[ident],
+                                           false,
+                                           -1,
+                                           -1,
+                                           NULL,
+                                           compressFieldNames);
         }
     }
 
@@ -78,7 +94,9 @@ namespace mongo {
                                                              const StringData& ident,
                                                              const IndexDescriptor* desc) {
         boost::mutex::scoped_lock lk(_mutex);
-        return getInMemoryBtreeImpl(Ordering::make(desc->keyPattern()), &_dataMap[ident]);
+        return getInMemoryBtreeImpl(Ordering::make(desc->keyPattern()),
+                                    &_dataMap[ident],
+                                    desc->getAccessMethodName() == IndexNames::HASHED);
     }
 
     Status InMemoryEngine::dropIdent(OperationContext* opCtx,
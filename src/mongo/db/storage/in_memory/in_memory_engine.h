@@ -38,6 +38,8 @@
 
 namespace mongo {
 
+    extern const std::string kInMemoryEngineName;
+
     class InMemoryEngine : public KVEngine {
     public:
         virtual RecoveryUnit* newRecoveryUnit();
@@ -0,0 +1,163 @@
+// in_memory_field_name_dictionary.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/in_memory/in_memory_field_name_dictionary.h"
+
+#include <cstring>
+
+#include "mongo/base/data_view.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+namespace {
+    void appendVarint(uint32_t value, BufBuilder* out) {
+        while (value >= 0x80) {
+            out->appendUChar(static_cast<unsigned char>(value | 0x80));
+            value >>= 7;
+        }
+        out->appendUChar(static_cast<unsigned char>(value));
+    }
+
+    const char* readVarint(const char* in, uint32_t* value) {
+        *value = 0;
+        for (int shift = 0; ; shift += 7) {
+            const unsigned char byte = static_cast<unsigned char>(*in++);
+            *value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return in;
+        }
+    }
+}
+
+    FieldNameDictionary::FieldNameDictionary(size_t maxNames) : _maxNames(maxNames) {}
+
+    void FieldNameDictionary::encode(const BSONObj& obj, BufBuilder* out) {
+        appendVarint(obj.objsize(), out);
+        encodeObject(obj, out);
+    }
+
+    void FieldNameDictionary::encodeObject(const BSONObj& obj, BufBuilder* out) {
+        BSONObjIterator it(obj);
+        while (it.more()) {
+            const BSONElement elem = it.next();
+            encodeName(elem.fieldNameStringData(), out);
+            out->appendChar(elem.type());
+
+            if (elem.type() == Object || elem.type() == Array) {
+                encodeObject(elem.embeddedObject(), out);
+            }
+            else {
+                out->appendChar('\0');
+                out->appendBuf(elem.value(), elem.valuesize());
+            }
+        }
+        appendVarint(kEndToken, out);
+    }
+
+    void FieldNameDictionary::encodeName(const StringData& name, BufBuilder* out) {
+        const std::string key = name.toString();
+        TokenMap::const_iterator it = _tokens.find(key);
+        if (it != _tokens.end()) {
+            appendVarint(it->second, out);
+            return;
+        }
+
+        if (_names.size() >= _maxNames) {
+            appendVarint(kInlineNameToken, out);
+            out->appendStr(name);
+            return;
+        }
+
+        const uint32_t token = kFirstNameToken + _names.size();
+        _names.push_back(key);
+        _tokens[key] = token;
+        appendVarint(token, out);
+    }
+
+    SharedBuffer FieldNameDictionary::decode(const char* data, int* bsonSize) const {
+        uint32_t size;
+        const char* in = readVarint(data, &size);
+
+        SharedBuffer buffer = SharedBuffer::allocate(size);
+        char* out = buffer.get();
+        decodeObject(in, &out);
+        invariant(out == buffer.get() + size);
+
+        *bsonSize = size;
+        return buffer.moveFrom();
+    }
+
+    const char* FieldNameDictionary::decodeObject(const char* in, char** out) const {
+        char* const start = *out;
+        *out += sizeof(int); // filled in once we know the object's size
+
+        while (true) {
+            uint32_t token;
+            in = readVarint(in, &token);
+            if (token == kEndToken)
+                break;
+
+            StringData name;
+            if (token == kInlineNameToken) {
+                name = StringData(in);
+                in += name.size() + 1;
+            }
+            else {
+                name = _names[token - kFirstNameToken];
+            }
+
+            const char type = *in++;
+            *(*out)++ = type;
+            memcpy(*out, name.rawData(), name.size());
+            *out += name.size();
+            *(*out)++ = '\0';
+
+            if (type == Object || type == Array) {
+                in = decodeObject(in, out);
+                continue;
+            }
+
+            // The type we just read starts an element with an empty name holding the value.
+            const BSONElement elem(in - 1, 1, BSONElement::FieldNameSizeTag());
+            memcpy(*out, elem.value(), elem.valuesize());
+            *out += elem.valuesize();
+            in = elem.rawdata() + elem.size();
+        }
+
+        *(*out)++ = EOO;
+        DataView(start).writeLE<int>(*out - start);
+        return in;
+    }
+
+} // namespace mongo
@@ -0,0 +1,94 @@
+// in_memory_field_name_dictionary.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/bson/util/builder.h"
+#include "mongo/platform/unordered_map.h"
+#include "mongo/util/shared_buffer.h"
+
+namespace mongo {
+
+    class BSONObj;
+
+    /**
+     * Encodes BSON objects with each field name replaced by a short token naming an entry in a
+     * dictionary shared by all the records of a collection, so that documents with the same
+     * shape don't each store the same names.
+     *
+     * Each element is encoded as its name's token, its type byte, and then either its value as a
+     * BSON element with an empty name or, for objects and arrays, their encoded elements followed
+     * by an end token.  Once the dictionary is full, new names are stored inline.
+     *
+     * Not thread safe: callers must not encode while anyone else encodes or decodes.
+     */
+    class FieldNameDictionary {
+    public:
+        static const size_t kDefaultMaxNames = 1 << 16;
+
+        explicit FieldNameDictionary(size_t maxNames = kDefaultMaxNames);
+
+        /**
+         * Appends the encoding of 'obj' to 'out', adding any of its field names which aren't in
+         * the dictionary yet.
+         */
+        void encode(const BSONObj& obj, BufBuilder* out);
+
+        /**
+         * Returns a buffer holding the BSON object which encode() wrote at 'data', and sets
+         * 'bsonSize' to its size.
+         */
+        SharedBuffer decode(const char* data, int* bsonSize) const;
+
+        size_t numNames() const { return _names.size(); }
+
+    private:
+        enum Token {
+            kEndToken = 0,        // ends an object
+            kInlineNameToken = 1, // followed by the name as a C string
+            kFirstNameToken = 2,
+        };
+
+        void encodeObject(const BSONObj& obj, BufBuilder* out);
+        void encodeName(const StringData& name, BufBuilder* out);
+
+        const char* decodeObject(const char* in, char** out) const;
+
+        typedef unordered_map<std::string, uint32_t> TokenMap;
+
+        const size_t _maxNames;
+        TokenMap _tokens;
+        std::vector<std::string> _names; // the name of token t is _names[t - kFirstNameToken]
+    };
+
+} // namespace mongo
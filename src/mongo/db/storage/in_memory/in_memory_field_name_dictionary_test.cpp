@@ -0,0 +1,103 @@
+// in_memory_field_name_dictionary_test.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/storage/in_memory/in_memory_field_name_dictionary.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+    BSONObj roundTrip(FieldNameDictionary* dictionary, const BSONObj& obj, int* encodedSize) {
+        BufBuilder encoded;
+        dictionary->encode(obj, &encoded);
+        *encodedSize = encoded.len();
+
+        int size;
+        SharedBuffer bson = dictionary->decode(encoded.buf(), &size);
+        ASSERT_EQUALS(obj.objsize(), size);
+        return BSONObj(bson.moveFrom());
+    }
+
+    TEST(FieldNameDictionary, RoundTripsNestedDocuments) {
+        FieldNameDictionary dictionary;
+        const BSONObj obj = fromjson("{_id: 1, name: 'abc', nested: {inner: [1, {deep: null}, []],"
+                                     " empty: {}}, when: {$date: 5}, re: /x/i, n: 2.5}");
+        int encodedSize;
+        const BSONObj decoded = roundTrip(&dictionary, obj, &encodedSize);
+        ASSERT_EQUALS(0, memcmp(obj.objdata(), decoded.objdata(), obj.objsize()));
+        ASSERT(decoded.valid());
+    }
+
+    TEST(FieldNameDictionary, SharesNamesBetweenDocuments) {
+        FieldNameDictionary dictionary;
+        const BSONObj first = BSON("longFieldName" << 1 << "anotherLongFieldName" << "a");
+        const BSONObj second = BSON("longFieldName" << 2 << "anotherLongFieldName" << "b");
+
+        int firstSize;
+        roundTrip(&dictionary, first, &firstSize);
+        ASSERT_EQUALS(2U, dictionary.numNames());
+
+        int secondSize;
+        ASSERT_EQUALS(second, roundTrip(&dictionary, second, &secondSize));
+        ASSERT_EQUALS(2U, dictionary.numNames());
+        ASSERT_LESS_THAN(secondSize, second.objsize() / 2);
+    }
+
+    TEST(FieldNameDictionary, StoresNamesInlineOnceFull) {
+        FieldNameDictionary dictionary(1);
+        const BSONObj obj = BSON("a" << 1 << "b" << BSON("c" << 2));
+
+        int encodedSize;
+        ASSERT_EQUALS(obj, roundTrip(&dictionary, obj, &encodedSize));
+        ASSERT_EQUALS(1U, dictionary.numNames());
+
+        // Names that went inline still decode after more documents are encoded.
+        const BSONObj other = BSON("b" << 3 << "a" << 4);
+        ASSERT_EQUALS(other, roundTrip(&dictionary, other, &encodedSize));
+    }
+
+    TEST(FieldNameDictionary, ManyNames) {
+        FieldNameDictionary dictionary;
+        BSONObjBuilder builder;
+        for (int i = 0; i < 1000; i++) {
+            builder.append(BSONObjBuilder::numStr(i) + "field", i);
+        }
+        const BSONObj obj = builder.obj();
+
+        int encodedSize;
+        ASSERT_EQUALS(obj, roundTrip(&dictionary, obj, &encodedSize));
+        ASSERT_EQUALS(1000U, dictionary.numNames());
+    }
+
+} // namespace
+} // namespace mongo
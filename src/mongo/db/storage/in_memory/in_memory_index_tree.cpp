@@ -0,0 +1,403 @@
+// in_memory_index_tree.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/in_memory/in_memory_index_tree.h"
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+    class InMemoryIndexTree::Node {
+    public:
+        explicit Node(bool isLeaf) : isLeaf(isLeaf) {}
+
+        const bool isLeaf;
+    };
+
+    class InMemoryIndexTree::Leaf : public Node {
+    public:
+        Leaf() : Node(true), prev(NULL), next(NULL) {
+            entries.reserve(kLeafCapacity + 1);
+            keys.reserve(kLeafCapacity + 1);
+        }
+
+        std::vector<IndexKeyEntry> entries;
+        std::vector<KeyString> keys; // keys[i] encodes entries[i]
+        Leaf* prev;
+        Leaf* next;
+    };
+
+    // Child i holds the entries in [separators[i - 1], separators[i]).
+    class InMemoryIndexTree::Internal : public Node {
+    public:
+        Internal() : Node(false) {
+            separators.reserve(kInternalCapacity);
+            children.reserve(kInternalCapacity + 1);
+        }
+
+        std::vector<KeyString> separators;
+        std::vector<Node*> children;
+    };
+
+    InMemoryIndexTree::InMemoryIndexTree(const Ordering& ordering)
+        : _ordering(ordering),
+          _comparator(ordering),
+          _root(new Leaf()),
+          _size(0),
+          _version(0) {
+    }
+
+    InMemoryIndexTree::~InMemoryIndexTree() {
+        deleteTree(_root);
+    }
+
+    void InMemoryIndexTree::deleteTree(Node* node) {
+        if (!node->isLeaf) {
+            Internal* internal = static_cast<Internal*>(node);
+            for (size_t i = 0; i < internal->children.size(); i++) {
+                deleteTree(internal->children[i]);
+            }
+            delete internal;
+        }
+        else {
+            delete static_cast<Leaf*>(node);
+        }
+    }
+
+    size_t InMemoryIndexTree::search(const std::vector<KeyString>& sorted,
+                                     const KeyString& query,
+                                     bool afterEqual) {
+        size_t low = 0;
+        size_t high = sorted.size();
+        while (low < high) {
+            const size_t mid = low + (high - low) / 2;
+            const int cmp = sorted[mid].compare(query);
+            if (cmp < 0 || (afterEqual && cmp == 0)) {
+                low = mid + 1;
+            }
+            else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+    InMemoryIndexTree::Position InMemoryIndexTree::seek(const KeyString& query,
+                                                        bool afterEqual) const {
+        // Everything left of the child taken is < 'query' (or <= it), so the answer is in that
+        // child or is the first entry after it.
+        Node* node = _root;
+        while (!node->isLeaf) {
+            const Internal* internal = static_cast<const Internal*>(node);
+            node = internal->children[search(internal->separators, query, afterEqual)];
+        }
+
+        Leaf* leaf = static_cast<Leaf*>(node);
+        const size_t index = search(leaf->keys, query, afterEqual);
+        if (index < leaf->keys.size())
+            return Position(leaf, index);
+
+        // Only the root leaf can be empty.
+        return leaf->next ? Position(leaf->next, 0) : Position();
+    }
+
+    bool InMemoryIndexTree::seekInLeaf(Leaf* leaf,
+                                       const KeyString& query,
+                                       bool afterEqual,
+                                       Position* out,
+                                       bool* goRight) {
+        const size_t index = search(leaf->keys, query, afterEqual);
+        if (index < leaf->keys.size()) {
+            // Everything in the previous leaf is before 'index', unless the whole of this leaf
+            // satisfies the query; then the answer may be further left.
+            const bool answerIsLeft = index == 0 && leaf->prev
+                && search(leaf->prev->keys, query, afterEqual) < leaf->prev->keys.size();
+            if (answerIsLeft) {
+                *goRight = false;
+                return false;
+            }
+            *out = Position(leaf, index);
+            return true;
+        }
+
+        if (!leaf->next) {
+            *out = Position();
+            return true;
+        }
+        if (0 == search(leaf->next->keys, query, afterEqual)) {
+            *out = Position(leaf->next, 0);
+            return true;
+        }
+        *goRight = true;
+        return false;
+    }
+
+    InMemoryIndexTree::Position InMemoryIndexTree::seekFrom(const Position& hint,
+                                                            const KeyString& query,
+                                                            bool afterEqual) const {
+        if (hint.isEnd())
+            return seek(query, afterEqual);
+
+        Position out;
+        bool goRight = false;
+        if (seekInLeaf(hint._leaf, query, afterEqual, &out, &goRight))
+            return out;
+
+        Leaf* neighbour = goRight ? hint._leaf->next : hint._leaf->prev;
+        bool goRightAgain = false;
+        if (seekInLeaf(neighbour, query, afterEqual, &out, &goRightAgain))
+            return out;
+
+        return seek(query, afterEqual);
+    }
+
+    InMemoryIndexTree::Position InMemoryIndexTree::lowerBound(const IndexKeyEntry& query,
+                                                              const Position& hint) const {
+        return seekFrom(hint,
+                        KeyString(query.key, _ordering, query.loc, KeyString::kExclusiveBefore),
+                        false);
+    }
+
+    InMemoryIndexTree::Position InMemoryIndexTree::upperBound(const IndexKeyEntry& query,
+                                                              const Position& hint) const {
+        return seekFrom(hint,
+                        KeyString(query.key, _ordering, query.loc, KeyString::kExclusiveAfter),
+                        true);
+    }
+
+    InMemoryIndexTree::Position InMemoryIndexTree::lowerBound(const IndexKeyEntry& query) const {
+        // A null RecordId equals every entry with the key, so they are all >= the query.
+        return seek(KeyString(query.key, _ordering, query.loc, KeyString::kExclusiveBefore),
+                    false);
+    }
+
+    InMemoryIndexTree::Position InMemoryIndexTree::upperBound(const IndexKeyEntry& query) const {
+        // ... and none of them is > it.
+        return seek(KeyString(query.key, _ordering, query.loc, KeyString::kExclusiveAfter),
+                    true);
+    }
+
+    InMemoryIndexTree::Position InMemoryIndexTree::first() const {
+        Node* node = _root;
+        while (!node->isLeaf) {
+            node = static_cast<const Internal*>(node)->children.front();
+        }
+        Leaf* leaf = static_cast<Leaf*>(node);
+        return leaf->entries.empty() ? Position() : Position(leaf, 0);
+    }
+
+    InMemoryIndexTree::Position InMemoryIndexTree::last() const {
+        Node* node = _root;
+        while (!node->isLeaf) {
+            node = static_cast<const Internal*>(node)->children.back();
+        }
+        Leaf* leaf = static_cast<Leaf*>(node);
+        return leaf->entries.empty() ? Position() : Position(leaf, leaf->entries.size() - 1);
+    }
+
+    void InMemoryIndexTree::next(Position* pos) const {
+        invariant(!pos->isEnd());
+        if (++pos->_index < pos->_leaf->entries.size())
+            return;
+
+        *pos = pos->_leaf->next ? Position(pos->_leaf->next, 0) : Position();
+    }
+
+    void InMemoryIndexTree::prev(Position* pos) const {
+        invariant(!pos->isEnd());
+        if (pos->_index > 0) {
+            --pos->_index;
+            return;
+        }
+
+        Leaf* prevLeaf = pos->_leaf->prev;
+        *pos = prevLeaf ? Position(prevLeaf, prevLeaf->entries.size() - 1) : Position();
+    }
+
+    const IndexKeyEntry& InMemoryIndexTree::get(const Position& pos) const {
+        invariant(!pos.isEnd());
+        return pos._leaf->entries[pos._index];
+    }
+
+    bool InMemoryIndexTree::insert(const IndexKeyEntry& entry) {
+        Node* split = NULL;
+        KeyString separator;
+        if (!insertInto(_root, entry, KeyString(entry.key, _ordering, entry.loc), &split,
+                        &separator)) {
+            return false;
+        }
+
+        if (split) {
+            Internal* root = new Internal();
+            root->children.push_back(_root);
+            root->children.push_back(split);
+            root->separators.push_back(separator);
+            _root = root;
+        }
+
+        _size++;
+        _version++;
+        return true;
+    }
+
+    bool InMemoryIndexTree::insertInto(Node* node,
+                                       const IndexKeyEntry& entry,
+                                       const KeyString& key,
+                                       Node** split,
+                                       KeyString* separator) {
+        if (node->isLeaf) {
+            Leaf* leaf = static_cast<Leaf*>(node);
+            const size_t index = search(leaf->keys, key, false);
+            if (index < leaf->keys.size() && leaf->keys[index] == key)
+                return false;
+            leaf->entries.insert(leaf->entries.begin() + index, entry);
+            leaf->keys.insert(leaf->keys.begin() + index, key);
+
+            if (leaf->entries.size() > kLeafCapacity) {
+                Leaf* right = new Leaf();
+                const size_t half = leaf->entries.size() / 2;
+                right->entries.assign(leaf->entries.begin() + half, leaf->entries.end());
+                right->keys.assign(leaf->keys.begin() + half, leaf->keys.end());
+                leaf->entries.erase(leaf->entries.begin() + half, leaf->entries.end());
+                leaf->keys.erase(leaf->keys.begin() + half, leaf->keys.end());
+
+                right->next = leaf->next;
+                right->prev = leaf;
+                if (leaf->next)
+                    leaf->next->prev = right;
+                leaf->next = right;
+
+                *split = right;
+                *separator = right->keys.front();
+            }
+            return true;
+        }
+
+        // An entry equal to a separator belongs to its right.
+        Internal* internal = static_cast<Internal*>(node);
+        const size_t child = search(internal->separators, key, true);
+
+        Node* childSplit = NULL;
+        KeyString childSeparator;
+        if (!insertInto(internal->children[child], entry, key, &childSplit, &childSeparator))
+            return false;
+
+        if (childSplit) {
+            internal->separators.insert(internal->separators.begin() + child, childSeparator);
+            internal->children.insert(internal->children.begin() + child + 1, childSplit);
+
+            if (internal->children.size() > kInternalCapacity) {
+                // The separator between the halves moves up rather than into either of them.
+                Internal* right = new Internal();
+                const size_t half = internal->children.size() / 2;
+                right->children.assign(internal->children.begin() + half,
+                                       internal->children.end());
+                right->separators.assign(internal->separators.begin() + half,
+                                         internal->separators.end());
+                *separator = internal->separators[half - 1];
+
+                internal->children.erase(internal->children.begin() + half,
+                                         internal->children.end());
+                internal->separators.erase(internal->separators.begin() + half - 1,
+                                           internal->separators.end());
+                *split = right;
+            }
+        }
+        return true;
+    }
+
+    size_t InMemoryIndexTree::erase(const IndexKeyEntry& entry) {
+        const KeyString key(entry.key, _ordering, entry.loc);
+
+        std::vector<std::pair<Internal*, size_t> > path;
+        Node* node = _root;
+        while (!node->isLeaf) {
+            Internal* internal = static_cast<Internal*>(node);
+            const size_t child = search(internal->separators, key, true);
+            path.push_back(std::make_pair(internal, child));
+            node = internal->children[child];
+        }
+
+        Leaf* leaf = static_cast<Leaf*>(node);
+        const size_t index = search(leaf->keys, key, false);
+        if (index == leaf->keys.size() || !(leaf->keys[index] == key))
+            return 0;
+
+        leaf->entries.erase(leaf->entries.begin() + index);
+        leaf->keys.erase(leaf->keys.begin() + index);
+        if (leaf->entries.empty() && leaf != _root)
+            removeLeaf(leaf, path);
+
+        _size--;
+        _version++;
+        return 1;
+    }
+
+    void InMemoryIndexTree::removeLeaf(Leaf* leaf,
+                                       const std::vector<std::pair<Internal*, size_t> >& path) {
+        invariant(!path.empty());
+
+        if (leaf->prev)
+            leaf->prev->next = leaf->next;
+        if (leaf->next)
+            leaf->next->prev = leaf->prev;
+        delete leaf;
+
+        // Unhook from the parent, and from any ancestor which that leaves empty.  Since another
+        // leaf exists the root keeps at least one child.  Dropping child i with the separator on
+        // its left (or child 0 with the one on its right) keeps every remaining range correct.
+        for (size_t level = path.size(); level-- > 0;) {
+            Internal* parent = path[level].first;
+            const size_t child = path[level].second;
+
+            parent->children.erase(parent->children.begin() + child);
+            if (!parent->separators.empty()) {
+                const size_t separator = child > 0 ? child - 1 : 0;
+                parent->separators.erase(parent->separators.begin() + separator);
+            }
+
+            if (!parent->children.empty())
+                break;
+
+            invariant(parent != _root);
+            delete parent;
+        }
+
+        // Collapse a root with a single child.
+        while (!_root->isLeaf && static_cast<Internal*>(_root)->children.size() == 1) {
+            Internal* oldRoot = static_cast<Internal*>(_root);
+            _root = oldRoot->children.front();
+            delete oldRoot;
+        }
+    }
+
+} // namespace mongo
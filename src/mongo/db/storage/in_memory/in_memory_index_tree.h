@@ -0,0 +1,168 @@
+// in_memory_index_tree.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/storage/index_entry_comparison.h"
+#include "mongo/db/storage/key_string.h"
+
+namespace mongo {
+
+    /**
+     * An ordered set of IndexKeyEntry, laid out as a B+tree.
+     *
+     * Entries live in contiguous sorted arrays of up to kLeafCapacity per leaf, and leaves are
+     * doubly linked, so a scan walks arrays rather than chasing a pointer per entry and a seek
+     * touches about log_kInternalCapacity(n) nodes.  Ordering is that of the IndexEntryComparison,
+     * so queries built by IndexEntryComparison::makeQueryObject() and keys with a null RecordId
+     * (which compare equal to every entry with that key) may be passed as search bounds.
+     *
+     * Each entry is stored with its KeyString, and separators are KeyStrings alone, so searches
+     * compare with memcmp rather than BSONObj::woCompare.
+     *
+     * Leaves are freed once empty but under-full nodes are not merged.
+     *
+     * Every insert or erase bumps version() and may invalidate any Position.
+     */
+    class InMemoryIndexTree {
+        MONGO_DISALLOW_COPYING(InMemoryIndexTree);
+    public:
+        enum {
+            kLeafCapacity = 64,
+            kInternalCapacity = 64,
+        };
+
+        class Leaf;
+
+        /**
+         * An entry of the tree, or the end.  Only valid until the tree is next modified.
+         */
+        class Position {
+        public:
+            Position() : _leaf(NULL), _index(0) {}
+
+            bool isEnd() const { return !_leaf; }
+
+            bool operator==(const Position& other) const {
+                return _leaf == other._leaf && _index == other._index;
+            }
+
+        private:
+            friend class InMemoryIndexTree;
+            Position(Leaf* leaf, size_t index) : _leaf(leaf), _index(index) {}
+
+            Leaf* _leaf;
+            size_t _index;
+        };
+
+        explicit InMemoryIndexTree(const Ordering& ordering);
+        ~InMemoryIndexTree();
+
+        /**
+         * Adds 'entry' unless an equal one is present.  Returns true if it was added.
+         */
+        bool insert(const IndexKeyEntry& entry);
+
+        /**
+         * Removes the entry equal to 'entry', if any.  Returns the number removed.
+         */
+        size_t erase(const IndexKeyEntry& entry);
+
+        /** The first entry >= 'query', or the end. */
+        Position lowerBound(const IndexKeyEntry& query) const;
+
+        /** The first entry > 'query', or the end. */
+        Position upperBound(const IndexKeyEntry& query) const;
+
+        /**
+         * As above, but searching from 'hint' first.  When the answer is in the leaf of 'hint' or
+         * in one next to it, as it is when a scan skips ahead a little, no internal node is read.
+         */
+        Position lowerBound(const IndexKeyEntry& query, const Position& hint) const;
+        Position upperBound(const IndexKeyEntry& query, const Position& hint) const;
+
+        Position first() const;
+        Position last() const;
+
+        /** Moves 'pos' to the following entry, or to the end after the last one. */
+        void next(Position* pos) const;
+
+        /** Moves 'pos' to the preceding entry, or to the end before the first one. */
+        void prev(Position* pos) const;
+
+        const IndexKeyEntry& get(const Position& pos) const;
+
+        size_t size() const { return _size; }
+        bool empty() const { return _size == 0; }
+        unsigned long long version() const { return _version; }
+        const IndexEntryComparison& comparator() const { return _comparator; }
+
+    private:
+        class Node;
+        class Internal;
+
+        // Index of the first element of 'sorted' which is >= 'query', or > it if 'afterEqual'.
+        static size_t search(const std::vector<KeyString>& sorted,
+                             const KeyString& query,
+                             bool afterEqual);
+
+        // The first entry >= 'query', or > it if 'afterEqual'.
+        Position seek(const KeyString& query, bool afterEqual) const;
+
+        // Like seek(), looking in the leaf of 'hint' and its neighbours before the root.
+        Position seekFrom(const Position& hint, const KeyString& query, bool afterEqual) const;
+
+        // Sets '*out' and returns true if the answer to seek() is in 'leaf' or is the first entry
+        // after it.  Otherwise sets '*goRight' to whether the answer is further right.
+        static bool seekInLeaf(Leaf* leaf, const KeyString& query, bool afterEqual,
+                               Position* out, bool* goRight);
+
+        // Inserts into the subtree at 'node'.  If it had to split, sets '*split' to the new right
+        // sibling and '*separator' to the smallest key in it.
+        bool insertInto(Node* node, const IndexKeyEntry& entry, const KeyString& key,
+                        Node** split, KeyString* separator);
+
+        // Frees 'leaf', now empty, and any ancestors left without children.  'path' holds each
+        // ancestor and the index of the child taken from it, root first.
+        void removeLeaf(Leaf* leaf, const std::vector<std::pair<Internal*, size_t> >& path);
+
+        static void deleteTree(Node* node);
+
+        const Ordering _ordering;
+        const IndexEntryComparison _comparator;
+        Node* _root;
+        size_t _size;
+        unsigned long long _version;
+    };
+
+} // namespace mongo
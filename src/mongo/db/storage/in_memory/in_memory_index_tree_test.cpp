@@ -0,0 +1,186 @@
+// in_memory_index_tree_test.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/in_memory/in_memory_index_tree.h"
+
+#include <set>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/random.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+    typedef std::set<IndexKeyEntry, IndexEntryComparison> ReferenceSet;
+
+    IndexKeyEntry makeEntry(int key, int loc) {
+        return IndexKeyEntry(BSON("" << key), RecordId(1, loc));
+    }
+
+    // Checks that iterating 'tree' both ways and seeking it agree with 'reference'.
+    void assertSameContents(const InMemoryIndexTree& tree, const ReferenceSet& reference) {
+        ASSERT_EQUALS(reference.size(), tree.size());
+
+        InMemoryIndexTree::Position pos = tree.first();
+        for (ReferenceSet::const_iterator it = reference.begin(); it != reference.end(); ++it) {
+            ASSERT(!pos.isEnd());
+            ASSERT_EQUALS(0, tree.comparator().compare(*it, tree.get(pos)));
+            tree.next(&pos);
+        }
+        ASSERT(pos.isEnd());
+
+        pos = tree.last();
+        for (ReferenceSet::const_reverse_iterator it = reference.rbegin();
+                it != reference.rend(); ++it) {
+            ASSERT(!pos.isEnd());
+            ASSERT_EQUALS(0, tree.comparator().compare(*it, tree.get(pos)));
+            tree.prev(&pos);
+        }
+        ASSERT(pos.isEnd());
+    }
+
+    TEST(InMemoryIndexTree, Empty) {
+        InMemoryIndexTree tree(Ordering::make(BSONObj()));
+        ASSERT(tree.empty());
+        ASSERT(tree.first().isEnd());
+        ASSERT(tree.last().isEnd());
+        ASSERT(tree.lowerBound(makeEntry(1, 1)).isEnd());
+        ASSERT_EQUALS(0U, tree.erase(makeEntry(1, 1)));
+    }
+
+    TEST(InMemoryIndexTree, InsertRejectsDuplicateEntry) {
+        InMemoryIndexTree tree(Ordering::make(BSONObj()));
+        ASSERT(tree.insert(makeEntry(1, 1)));
+        ASSERT(!tree.insert(makeEntry(1, 1)));
+        ASSERT(tree.insert(makeEntry(1, 2)));
+        ASSERT_EQUALS(2U, tree.size());
+    }
+
+    // A null RecordId compares equal to every entry with its key, so it bounds a run of them.
+    TEST(InMemoryIndexTree, NullRecordIdBoundsSpanLeaves) {
+        InMemoryIndexTree tree(Ordering::make(BSONObj()));
+        for (int loc = 1; loc <= 1000; loc++) {
+            tree.insert(makeEntry(loc % 3, loc));
+        }
+
+        const IndexKeyEntry anyOne(BSON("" << 1), RecordId());
+        InMemoryIndexTree::Position pos = tree.lowerBound(anyOne);
+        ASSERT_EQUALS(0, tree.comparator().compare(makeEntry(1, 1), tree.get(pos)));
+
+        pos = tree.upperBound(anyOne);
+        ASSERT_EQUALS(0, tree.comparator().compare(makeEntry(2, 2), tree.get(pos)));
+        tree.prev(&pos);
+        ASSERT_EQUALS(0, tree.comparator().compare(makeEntry(1, 1000), tree.get(pos)));
+    }
+
+    TEST(InMemoryIndexTree, DescendingOrdering) {
+        InMemoryIndexTree tree(Ordering::make(BSON("a" << -1)));
+        ReferenceSet reference(tree.comparator());
+        for (int i = 0; i < 500; i++) {
+            tree.insert(makeEntry(i, i + 1));
+            reference.insert(makeEntry(i, i + 1));
+        }
+        assertSameContents(tree, reference);
+        ASSERT_EQUALS(0, tree.comparator().compare(makeEntry(499, 500), tree.get(tree.first())));
+    }
+
+    // Random inserts and erases, enough to split and then empty many nodes, against std::set.
+    TEST(InMemoryIndexTree, MatchesStdSet) {
+        InMemoryIndexTree tree(Ordering::make(BSONObj()));
+        ReferenceSet reference(tree.comparator());
+        PseudoRandom random(12345);
+
+        for (int round = 0; round < 4; round++) {
+            // Grow, then shrink to nearly empty, so leaves and internal nodes are freed.
+            const int insertPercent = round % 2 == 0 ? 80 : 15;
+            for (int i = 0; i < 20000; i++) {
+                const IndexKeyEntry entry = makeEntry(random.nextInt32(2000),
+                                                      1 + random.nextInt32(8));
+                if (random.nextInt32(100) < insertPercent) {
+                    ASSERT_EQUALS(reference.insert(entry).second, tree.insert(entry));
+                }
+                else {
+                    ASSERT_EQUALS(reference.erase(entry), tree.erase(entry));
+                }
+            }
+            assertSameContents(tree, reference);
+
+            for (int i = 0; i < 500; i++) {
+                const IndexKeyEntry query(BSON("" << random.nextInt32(2100)), RecordId());
+
+                ReferenceSet::const_iterator expected = reference.lower_bound(query);
+                InMemoryIndexTree::Position pos = tree.lowerBound(query);
+                ASSERT_EQUALS(expected == reference.end(), pos.isEnd());
+                if (!pos.isEnd())
+                    ASSERT_EQUALS(0, tree.comparator().compare(*expected, tree.get(pos)));
+
+                expected = reference.upper_bound(query);
+                pos = tree.upperBound(query);
+                ASSERT_EQUALS(expected == reference.end(), pos.isEnd());
+                if (!pos.isEnd())
+                    ASSERT_EQUALS(0, tree.comparator().compare(*expected, tree.get(pos)));
+            }
+        }
+    }
+
+    // Searching from a hint finds the same entry as searching from the root, however near or far
+    // the hint is and whichever side of the answer it is on.
+    TEST(InMemoryIndexTree, HintedBoundsMatchUnhinted) {
+        InMemoryIndexTree tree(Ordering::make(BSONObj()));
+        for (int loc = 1; loc <= 3000; loc++) {
+            tree.insert(makeEntry(loc / 4, loc));
+        }
+
+        PseudoRandom random(6789);
+        for (int i = 0; i < 2000; i++) {
+            InMemoryIndexTree::Position hint = tree.lowerBound(makeEntry(random.nextInt32(800),
+                                                                         1));
+            const int start = hint.isEnd() ? 750 : tree.get(hint).key.firstElement().numberInt();
+
+            // Mostly short skips either way, sometimes long ones.
+            const int skip = random.nextInt32(10) == 0 ? random.nextInt32(800)
+                                                       : start - 20 + random.nextInt32(40);
+            const IndexKeyEntry query(BSON("" << skip), RecordId());
+
+            InMemoryIndexTree::Position expected = tree.lowerBound(query);
+            InMemoryIndexTree::Position actual = tree.lowerBound(query, hint);
+            ASSERT(expected == actual);
+
+            expected = tree.upperBound(query);
+            actual = tree.upperBound(query, hint);
+            ASSERT(expected == actual);
+        }
+    }
+
+} // namespace
+} // namespace mongo
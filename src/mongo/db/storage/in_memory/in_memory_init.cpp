@@ -32,6 +32,7 @@
 #include "mongo/base/init.h"
 #include "mongo/db/global_environment_experiment.h"
 #include "mongo/db/storage/in_memory/in_memory_engine.h"
+#include "mongo/db/storage/in_memory/in_memory_record_store.h"
 #include "mongo/db/storage/kv/kv_storage_engine.h"
 #include "mongo/db/storage_options.h"
 
@@ -50,12 +51,12 @@ namespace mongo {
             }
 
             virtual StringData getCanonicalName() const {
-                return "inMemoryExperiment";
+                return kInMemoryEngineName;
             }
 
-            virtual Status validateCollectionStorageOptions(const BSONObj& options) const
-            {
-                return Status::OK();
+            virtual Status validateCollectionStorageOptions(const BSONObj& options) const {
+                bool compressFieldNames;
+                return InMemoryRecordStore::parseOptions(options, &compressFieldNames);
             }
 
             virtual Status validateIndexStorageOptions(const BSONObj& options) const {
@@ -69,7 +70,7 @@ namespace mongo {
                                          ("SetGlobalEnvironment"))
                                          (InitializerContext* context) {
 
-        getGlobalEnvironment()->registerStorageEngine("inMemoryExperiment", new InMemoryFactory());
+        getGlobalEnvironment()->registerStorageEngine(kInMemoryEngineName, new InMemoryFactory());
         return Status::OK();
     }
 
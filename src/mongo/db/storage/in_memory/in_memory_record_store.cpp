@@ -33,6 +33,9 @@
 
 #include "mongo/db/storage/in_memory/in_memory_record_store.h"
 
+#include <boost/scoped_ptr.hpp>
+
+#include "mongo/bson/bson_validate.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/storage/oplog_hack.h"
@@ -113,14 +116,15 @@ namespace mongo {
                                              bool isCapped,
                                              int64_t cappedMaxSize,
                                              int64_t cappedMaxDocs,
-                                             CappedDocumentDeleteCallback* cappedDeleteCallback)
+                                             CappedDocumentDeleteCallback* cappedDeleteCallback,
+                                             bool compressFieldNames)
             : RecordStore(ns),
               _isCapped(isCapped),
               _cappedMaxSize(cappedMaxSize),
               _cappedMaxDocs(cappedMaxDocs),
               _cappedDeleteCallback(cappedDeleteCallback),
               _data(*dataInOut ? static_cast<Data*>(dataInOut->get())
-                               : new Data(NamespaceString::oplog(ns))) {
+                               : new Data(NamespaceString::oplog(ns), compressFieldNames)) {
         if (!*dataInOut) {
             dataInOut->reset(_data); // takes ownership
         }
@@ -135,10 +139,54 @@ namespace mongo {
         }
     }
 
+    Status InMemoryRecordStore::parseOptions(const BSONObj& options, bool* compressFieldNames) {
+        *compressFieldNames = false;
+        BSONForEach(elem, options) {
+            if (elem.fieldNameStringData() == "compressFieldNames") {
+                if (!elem.isBoolean()) {
+                    return Status(ErrorCodes::BadValue,
+                                  "compressFieldNames must be a boolean");
+                }
+                *compressFieldNames = elem.boolean();
+                continue;
+            }
+
+            return Status(ErrorCodes::InvalidOptions,
+                          mongoutils::str::stream()
+                          << "unknown collection option to InMemoryRecordStore: "
+                          << elem.fieldName());
+        }
+        return Status::OK();
+    }
+
     const char* InMemoryRecordStore::name() const { return "InMemory"; }
 
     RecordData InMemoryRecordStore::dataFor( OperationContext* txn, const RecordId& loc ) const {
-        return recordFor(loc)->toRecordData();
+        return recordDataFor(*recordFor(loc));
+    }
+
+    RecordData InMemoryRecordStore::recordDataFor(const InMemoryRecord& rec) const {
+        if (!rec.encodedSize)
+            return rec.toRecordData();
+
+        int size;
+        SharedBuffer bson = _data->fieldNames->decode(rec.data.get(), &size);
+        invariant(size == rec.size);
+        return RecordData(bson.moveFrom(), size);
+    }
+
+    void InMemoryRecordStore::encodeRecord(InMemoryRecord* rec) {
+        if (!_data->fieldNames || !validateBSON(rec->data.get(), rec->size).isOK())
+            return;
+
+        BufBuilder encoded;
+        _data->fieldNames->encode(BSONObj(rec->data.get()), &encoded);
+        if (encoded.len() >= rec->size)
+            return;
+
+        rec->encodedSize = encoded.len();
+        rec->data.reset(new char[encoded.len()]);
+        memcpy(rec->data.get(), encoded.buf(), encoded.len());
     }
 
     const InMemoryRecordStore::InMemoryRecord* InMemoryRecordStore::recordFor(
@@ -168,7 +216,7 @@ namespace mongo {
         if ( it == _data->records.end() ) {
             return false;
         }
-        *rd = it->second.toRecordData();
+        *rd = recordDataFor(it->second);
         return true;
     }
 
@@ -242,6 +290,8 @@ namespace mongo {
             loc = allocateLoc();
         }
 
+        encodeRecord(&rec);
+
         txn->recoveryUnit()->registerChange(new InsertChange(_data, loc));
         _data->dataSize += len;
         _data->records[loc] = rec;
@@ -276,6 +326,8 @@ namespace mongo {
             loc = allocateLoc();
         }
 
+        encodeRecord(&rec);
+
         txn->recoveryUnit()->registerChange(new InsertChange(_data, loc));
         _data->dataSize += len;
         _data->records[loc] = rec;
@@ -302,6 +354,7 @@ namespace mongo {
 
         InMemoryRecord newRecord(len);
         memcpy(newRecord.data.get(), data, len);
+        encodeRecord(&newRecord);
 
         txn->recoveryUnit()->registerChange(new RemoveChange(_data, loc, *oldRecord));
         _data->dataSize += len - oldLen;
@@ -319,14 +372,10 @@ namespace mongo {
                                                    const mutablebson::DamageVector& damages ) {
         InMemoryRecord* oldRecord = recordFor( loc );
         const int len = oldRecord->size;
+        const int newLen = mutablebson::getDamagedSize(len, damages);
 
-        InMemoryRecord newRecord(len);
-        memcpy(newRecord.data.get(), oldRecord->data.get(), len);
-
-        txn->recoveryUnit()->registerChange(new RemoveChange(_data, loc, *oldRecord));
-        *oldRecord = newRecord;
-
-        cappedDeleteAsNeeded(txn);
+        InMemoryRecord newRecord(newLen);
+        memcpy(newRecord.data.get(), recordDataFor(*oldRecord).data(), len);
 
         char* root = newRecord.data.get();
         mutablebson::DamageVector::const_iterator where = damages.begin();
@@ -336,12 +385,23 @@ namespace mongo {
             char* targetPtr = root + where->targetOffset;
             std::memcpy(targetPtr, sourcePtr, where->size);
         }
+        encodeRecord(&newRecord);
 
+        txn->recoveryUnit()->registerChange(new RemoveChange(_data, loc, *oldRecord));
+        _data->dataSize += newLen - len;
         *oldRecord = newRecord;
 
+        cappedDeleteAsNeeded(txn);
+
         return Status::OK();
     }
 
+    bool InMemoryRecordStore::updateWithDamagesCanGrow( OperationContext* txn,
+                                                       const RecordId& loc,
+                                                       int newSize ) const {
+        return !_isCapped;
+    }
+
     RecordIterator* InMemoryRecordStore::getIterator(
             OperationContext* txn,
             const RecordId& start,
@@ -368,6 +428,10 @@ namespace mongo {
         return out;
     }
 
+    RecordIterator* InMemoryRecordStore::getRandomIterator(OperationContext* txn) const {
+        return new InMemoryRecordRandomIterator(txn, _data->records, *this);
+    }
+
     Status InMemoryRecordStore::truncate(OperationContext* txn) {
         // Unlike other changes, TruncateChange mutates _data on construction to perform the
         // truncate
@@ -410,7 +474,7 @@ namespace mongo {
                         it != _data->records.end(); ++it) {
                 const InMemoryRecord& rec = it->second;
                 size_t dataSize;
-                const Status status = adaptor->validate(rec.toRecordData(), &dataSize);
+                const Status status = adaptor->validate(recordDataFor(rec), &dataSize);
                 if (!status.isOK()) {
                     results->valid = false;
                     results->errors.push_back("invalid object detected (see logs)");
@@ -433,6 +497,11 @@ namespace mongo {
             result->appendIntOrLL( "max", _cappedMaxDocs );
             result->appendIntOrLL( "maxSize", _cappedMaxSize );
         }
+        result->appendBool( "compressFieldNames", _data->fieldNames.get() != NULL );
+        if ( _data->fieldNames ) {
+            result->appendNumber( "fieldNames",
+                                  static_cast<long long>( _data->fieldNames->numNames() ) );
+        }
     }
 
     Status InMemoryRecordStore::touch(OperationContext* txn, BSONObjBuilder* output) const {
@@ -468,7 +537,16 @@ namespace mongo {
                                              int infoLevel) const {
         // Note: not making use of extraInfo or infoLevel since we don't have extents
         const int64_t recordOverhead = numRecords(txn) * sizeof(InMemoryRecord);
-        return _data->dataSize + recordOverhead;
+        if (!_data->fieldNames)
+            return _data->dataSize + recordOverhead;
+
+        int64_t storedSize = 0;
+        for (Records::const_iterator it = _data->records.begin();
+                it != _data->records.end(); ++it) {
+            const InMemoryRecord& rec = it->second;
+            storedSize += rec.encodedSize ? rec.encodedSize : rec.size;
+        }
+        return storedSize + recordOverhead;
     }
 
     RecordId InMemoryRecordStore::allocateLoc() {
@@ -587,6 +665,78 @@ namespace mongo {
         return _rs.dataFor(_txn, loc);
     }
 
+    //
+    // Random Iterator
+    //
+
+    namespace {
+        // Discards the first numbers, which are skewed functions of the seed.
+        PseudoRandom makeRandom() {
+            boost::scoped_ptr<SecureRandom> secure(SecureRandom::create());
+            PseudoRandom random(secure->nextInt64());
+            for (int i = 0; i < 16; i++) {
+                random.nextInt32();
+            }
+            return random;
+        }
+    }
+
+    InMemoryRecordRandomIterator::InMemoryRecordRandomIterator(
+            OperationContext* txn,
+            const InMemoryRecordStore::Records& records,
+            const InMemoryRecordStore& rs) : _txn(txn),
+                                             _random(makeRandom()),
+                                             _records(records),
+                                             _rs(rs) {
+        advance();
+    }
+
+    void InMemoryRecordRandomIterator::advance() {
+        if (_records.empty()) {
+            _loc = RecordId();
+            return;
+        }
+
+        const int64_t first = _records.begin()->first.repr();
+        const int64_t last = _records.rbegin()->first.repr();
+        // Not nextInt64(), which sign extends its low half over the high one.
+        const uint64_t high = static_cast<uint32_t>(_random.nextInt32());
+        const uint64_t bits = (high << 32) | static_cast<uint32_t>(_random.nextInt32());
+        const uint64_t offset = bits % (static_cast<uint64_t>(last - first) + 1);
+        _loc = _records.lower_bound(RecordId(first + static_cast<int64_t>(offset)))->first;
+    }
+
+    bool InMemoryRecordRandomIterator::isEOF() {
+        return _loc.isNull();
+    }
+
+    RecordId InMemoryRecordRandomIterator::curr() {
+        return _loc;
+    }
+
+    RecordId InMemoryRecordRandomIterator::getNext() {
+        const RecordId out = _loc;
+        advance();
+        return out;
+    }
+
+    void InMemoryRecordRandomIterator::invalidate(const RecordId& loc) {
+    }
+
+    void InMemoryRecordRandomIterator::saveState() {
+    }
+
+    bool InMemoryRecordRandomIterator::restoreState(OperationContext* txn) {
+        _txn = txn;
+        // _loc may have been deleted while we were saved.
+        advance();
+        return true;
+    }
+
+    RecordData InMemoryRecordRandomIterator::dataFor(const RecordId& loc) const {
+        return _rs.dataFor(_txn, loc);
+    }
+
     //
     // Reverse Iterator
     //
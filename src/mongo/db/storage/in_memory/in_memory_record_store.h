@@ -30,12 +30,15 @@
 
 #pragma once
 
+#include <boost/scoped_ptr.hpp>
 #include <boost/shared_array.hpp>
 #include <boost/shared_ptr.hpp>
 #include <map>
 
 #include "mongo/db/storage/capped_callback.h"
+#include "mongo/db/storage/in_memory/in_memory_field_name_dictionary.h"
 #include "mongo/db/storage/record_store.h"
+#include "mongo/platform/random.h"
 
 namespace mongo {
 
@@ -45,6 +48,8 @@ namespace mongo {
      * A RecordStore that stores all data in-memory.
      *
      * @param cappedMaxSize - required if isCapped. limit uses dataSize() in this impl.
+     * @param compressFieldNames - store BSON records with a FieldNameDictionary. Only takes
+     *                             effect when 'dataInOut' is empty.
      */
     class InMemoryRecordStore : public RecordStore {
     public:
@@ -53,7 +58,13 @@ namespace mongo {
                                      bool isCapped = false,
                                      int64_t cappedMaxSize = -1,
                                      int64_t cappedMaxDocs = -1,
-                                     CappedDocumentDeleteCallback* cappedDeleteCallback = NULL);
+                                     CappedDocumentDeleteCallback* cappedDeleteCallback = NULL,
+                                     bool compressFieldNames = false);
+
+        /**
+         * Parses the storageEngine.inMemoryExperiment options of a collection.
+         */
+        static Status parseOptions(const BSONObj& options, bool* compressFieldNames);
 
         virtual const char* name() const;
 
@@ -85,6 +96,10 @@ namespace mongo {
                                           const char* damageSource,
                                           const mutablebson::DamageVector& damages );
 
+        virtual bool updateWithDamagesCanGrow( OperationContext* txn,
+                                               const RecordId& loc,
+                                               int newSize ) const;
+
         virtual RecordIterator* getIterator( OperationContext* txn,
                                              const RecordId& start,
                                              const CollectionScanParams::Direction& dir) const;
@@ -93,6 +108,8 @@ namespace mongo {
 
         virtual std::vector<RecordIterator*> getManyIterators( OperationContext* txn ) const;
 
+        virtual RecordIterator* getRandomIterator( OperationContext* txn ) const;
+
         virtual Status truncate( OperationContext* txn );
 
         virtual void temp_cappedTruncateAfter( OperationContext* txn, RecordId end, bool inclusive );
@@ -136,12 +153,13 @@ namespace mongo {
 
     protected:
         struct InMemoryRecord {
-            InMemoryRecord() :size(0) {}
-            InMemoryRecord(int size) :size(size), data(new char[size]) {}
+            InMemoryRecord() :size(0), encodedSize(0) {}
+            InMemoryRecord(int size) :size(size), encodedSize(0), data(new char[size]) {}
 
             RecordData toRecordData() const { return RecordData(data.get(), size); }
 
             int size;
+            int encodedSize; // if non-zero, data holds this many bytes encoding 'size' of BSON
             boost::shared_array<char> data;
         };
 
@@ -169,6 +187,14 @@ namespace mongo {
 
         StatusWith<RecordId> extractAndCheckLocForOplog(const char* data, int len) const;
 
+        /**
+         * Replaces the data of a BSON record with its encoding if this store compresses field
+         * names and that saves space.
+         */
+        void encodeRecord(InMemoryRecord* rec);
+
+        RecordData recordDataFor(const InMemoryRecord& rec) const;
+
         RecordId allocateLoc();
         bool cappedAndNeedDelete(OperationContext* txn) const;
         void cappedDeleteAsNeeded(OperationContext* txn);
@@ -181,12 +207,18 @@ namespace mongo {
 
         // This is the "persistent" data.
         struct Data {
-            Data(bool isOplog) :dataSize(0), nextId(1), isOplog(isOplog) {}
+            Data(bool isOplog, bool compressFieldNames)
+                : dataSize(0),
+                  nextId(1),
+                  isOplog(isOplog),
+                  fieldNames(compressFieldNames ? new FieldNameDictionary() : NULL) {
+            }
 
             int64_t dataSize;
             Records records;
             int64_t nextId;
             const bool isOplog;
+            boost::scoped_ptr<FieldNameDictionary> fieldNames; // NULL unless compressing
         };
 
         Data* const _data;
@@ -256,4 +288,39 @@ namespace mongo {
         const InMemoryRecordStore& _rs;
     };
 
+    /**
+     * Jumps to the first record at or after a uniformly chosen RecordId between the first and the
+     * last, so records following gaps left by deletes come up more often.
+     */
+    class InMemoryRecordRandomIterator : public RecordIterator {
+    public:
+        InMemoryRecordRandomIterator(OperationContext* txn,
+                                     const InMemoryRecordStore::Records& records,
+                                     const InMemoryRecordStore& rs);
+
+        virtual bool isEOF();
+
+        virtual RecordId curr();
+
+        virtual RecordId getNext();
+
+        virtual void invalidate(const RecordId& dl);
+
+        virtual void saveState();
+
+        virtual bool restoreState(OperationContext* txn);
+
+        virtual RecordData dataFor( const RecordId& loc ) const;
+
+    private:
+        void advance();
+
+        OperationContext* _txn; // not owned
+        PseudoRandom _random;
+        RecordId _loc; // isNull if EOF
+
+        const InMemoryRecordStore::Records& _records;
+        const InMemoryRecordStore& _rs;
+    };
+
 } // namespace mongo
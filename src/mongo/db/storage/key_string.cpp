@@ -0,0 +1,362 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/key_string.h"
+
+#include <cstring>
+
+#include "mongo/platform/float_utils.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/hex.h"
+
+namespace mongo {
+namespace {
+
+    // Type bytes, in canonicalizeBSONType() order.  Inverted for descending fields they stay
+    // within [kMinKey, ~kMinKey], clear of the discriminators below.
+    const unsigned char kMinKey = 10;
+    const unsigned char kUndefined = 15;
+    const unsigned char kNull = 20;
+    const unsigned char kNumeric = 30;
+    const unsigned char kString = 40;
+    const unsigned char kObject = 50;
+    const unsigned char kArray = 60;
+    const unsigned char kBinData = 70;
+    const unsigned char kOID = 80;
+    const unsigned char kBool = 90;
+    const unsigned char kDate = 100;
+    const unsigned char kRegEx = 110;
+    const unsigned char kDBRef = 120;
+    const unsigned char kCode = 130;
+    const unsigned char kCodeWScope = 140;
+    const unsigned char kMaxKey = 240;
+
+    // Ends a key, or an embedded object's elements, and sorts before any element.
+    const unsigned char kEnd = 4;
+    // Follow a key to place it before or after every entry which shares it.
+    const unsigned char kLess = 1;
+    const unsigned char kGreater = 254;
+
+    // Follow a number's double: whether it is exact or, for a NumberLong the double can't hold,
+    // whether the NumberLong is below or above it.
+    const unsigned char kNumberBelow = 0;
+    const unsigned char kNumberExact = 1;
+    const unsigned char kNumberAbove = 2;
+
+    // Sub-types of kDate.
+    const unsigned char kDateIsDate = 0;
+    const unsigned char kDateIsTimestamp = 1;
+
+    // The markers makeQueryObject() puts in the first byte of exclusive fields' names.  See
+    // index_entry_comparison.cpp.
+    const char kQueryLess = 'l';
+    const char kQueryGreater = 'g';
+
+    const unsigned long long kSignBit = 1ULL << 63;
+
+    unsigned char typeByte(BSONType type) {
+        switch (type) {
+        case MinKey: return kMinKey;
+        case EOO:
+        case Undefined: return kUndefined;
+        case jstNULL: return kNull;
+        case NumberDouble:
+        case NumberInt:
+        case NumberLong: return kNumeric;
+        case String:
+        case Symbol: return kString;
+        case Object: return kObject;
+        case Array: return kArray;
+        case BinData: return kBinData;
+        case jstOID: return kOID;
+        case Bool: return kBool;
+        case Date:
+        case Timestamp: return kDate;
+        case RegEx: return kRegEx;
+        case DBRef: return kDBRef;
+        case Code: return kCode;
+        case CodeWScope: return kCodeWScope;
+        case MaxKey: return kMaxKey;
+        }
+        invariant(false);
+        return 0;
+    }
+
+} // namespace
+
+    void KeyString::resetToKey(const BSONObj& key,
+                               Ordering ord,
+                               RecordId loc,
+                               Discriminator discriminator) {
+        _buffer.clear();
+
+        unsigned mask = 1;
+        BSONForEach(elem, key) {
+            appendElement(elem, ord.descending(mask));
+            mask <<= 1;
+
+            // An exclusive field decides any comparison it ties, so nothing after it matters.
+            const char behavior = elem.fieldName()[0];
+            if (behavior == kQueryLess) {
+                _buffer.push_back(kLess);
+                return;
+            }
+            if (behavior == kQueryGreater) {
+                _buffer.push_back(kGreater);
+                return;
+            }
+        }
+
+        if (!loc.isNull()) {
+            _buffer.push_back(kEnd);
+            appendRecordId(loc);
+            return;
+        }
+
+        switch (discriminator) {
+        case kInclusive: _buffer.push_back(kEnd); return;
+        case kExclusiveBefore: _buffer.push_back(kLess); return;
+        case kExclusiveAfter: _buffer.push_back(kGreater); return;
+        }
+    }
+
+    // static
+    bool KeyString::comparesLikeWoCompare(const BSONObj& key) {
+        const long long kMaxExactDouble = 1LL << 53;
+        BSONForEach(elem, key) {
+            switch (elem.type()) {
+            case NumberLong: {
+                const long long number = elem._numberLong();
+                if (number > kMaxExactDouble || number < -kMaxExactDouble)
+                    return false;
+                break;
+            }
+            case Timestamp:
+                return false;
+            case Object:
+            case Array:
+                if (!comparesLikeWoCompare(elem.embeddedObject()))
+                    return false;
+                break;
+            default:
+                break;
+            }
+        }
+        return true;
+    }
+
+    int KeyString::compare(const KeyString& other) const {
+        const size_t common = std::min(getSize(), other.getSize());
+        if (int cmp = memcmp(getBuffer(), other.getBuffer(), common))
+            return cmp;
+        return getSize() == other.getSize() ? 0 : getSize() < other.getSize() ? -1 : 1;
+    }
+
+    std::string KeyString::toString() const {
+        return toHex(getBuffer(), getSize());
+    }
+
+    void KeyString::appendElement(const BSONElement& elem, bool invert) {
+        const size_t start = _buffer.size();
+        appendTypeAndValue(elem, false);
+
+        // Every value encoding is self-delimiting, so inverting it reverses its order.
+        if (invert) {
+            for (size_t i = start; i < _buffer.size(); i++) {
+                _buffer[i] = ~_buffer[i];
+            }
+        }
+    }
+
+    void KeyString::appendTypeAndValue(const BSONElement& elem, bool withFieldName) {
+        // woCompare orders embedded elements by type, then field name, then value.
+        _buffer.push_back(typeByte(elem.type()));
+        if (withFieldName)
+            _buffer.append(elem.fieldName(), elem.fieldNameSize());
+
+        switch (elem.type()) {
+        case MinKey:
+        case MaxKey:
+        case EOO:
+        case Undefined:
+        case jstNULL:
+            return;
+
+        case NumberDouble:
+        case NumberInt:
+        case NumberLong:
+            appendNumber(elem);
+            return;
+
+        case String:
+        case Symbol:
+        case Code:
+            appendEscapedString(elem.valuestr(), elem.valuestrsize() - 1);
+            return;
+
+        case Object:
+            appendObjectContents(elem.embeddedObject(), true);
+            return;
+
+        case Array:
+            // Array field names are positions, so they never decide a comparison.
+            appendObjectContents(elem.embeddedObject(), false);
+            return;
+
+        case BinData: {
+            // Compared by length, then subtype and bytes.
+            const int len = elem.objsize();
+            appendBigEndian32(len);
+            _buffer.append(elem.value() + 4, len + 1);
+            return;
+        }
+
+        case jstOID:
+            _buffer.append(elem.value(), OID::kOIDSize);
+            return;
+
+        case Bool:
+            _buffer.push_back(*elem.value());
+            return;
+
+        case Date:
+            _buffer.push_back(kDateIsDate);
+            appendBigEndian64(static_cast<unsigned long long>(elem.Date().millis) ^ kSignBit);
+            return;
+
+        case Timestamp:
+            _buffer.push_back(kDateIsTimestamp);
+            appendBigEndian64(elem.date().millis);
+            return;
+
+        case RegEx:
+            _buffer.append(elem.regex(), strlen(elem.regex()) + 1);
+            _buffer.append(elem.regexFlags(), strlen(elem.regexFlags()) + 1);
+            return;
+
+        case DBRef:
+            appendBigEndian32(elem.valuesize());
+            _buffer.append(elem.value(), elem.valuesize());
+            return;
+
+        case CodeWScope: {
+            // Compared with strcmp, so only up to the first NUL of each part counts.
+            const char* code = elem.codeWScopeCode();
+            const char* scope = elem.codeWScopeScopeDataUnsafe();
+            _buffer.append(code, strlen(code) + 1);
+            _buffer.append(scope, strlen(scope) + 1);
+            return;
+        }
+        }
+        invariant(false);
+    }
+
+    void KeyString::appendObjectContents(const BSONObj& obj, bool withFieldNames) {
+        BSONForEach(elem, obj) {
+            appendTypeAndValue(elem, withFieldNames);
+        }
+        _buffer.push_back(kEnd);
+    }
+
+    void KeyString::appendNumber(const BSONElement& elem) {
+        // All numeric types compare by value, so each is encoded as the double it compares as.
+        double value;
+        long long delta = 0; // how far a NumberLong is above that double
+        switch (elem.type()) {
+        case NumberInt:
+            value = elem._numberInt();
+            break;
+        case NumberLong: {
+            const long long number = elem._numberLong();
+            value = static_cast<double>(number);
+            if (value >= 9223372036854775808.0) {
+                // Rounded up to 2^63, which no long long reaches.
+                delta = (number - LLONG_MAX) - 1;
+            }
+            else {
+                delta = number - static_cast<long long>(value);
+            }
+            break;
+        }
+        default:
+            value = elem._numberDouble();
+        }
+
+        // NaN sorts before every other number, and -0 equals 0.
+        unsigned long long bits = 0;
+        if (!isNaN(value)) {
+            if (value == 0)
+                value = 0;
+            memcpy(&bits, &value, sizeof(bits));
+            bits = (bits & kSignBit) ? ~bits : (bits | kSignBit);
+        }
+        appendBigEndian64(bits);
+
+        if (delta == 0) {
+            _buffer.push_back(kNumberExact);
+            return;
+        }
+
+        // The rounding error of a double near a long long is well under 2^15.
+        _buffer.push_back(delta < 0 ? kNumberBelow : kNumberAbove);
+        const unsigned biased = static_cast<unsigned>(delta + 0x8000);
+        _buffer.push_back(static_cast<char>(biased >> 8));
+        _buffer.push_back(static_cast<char>(biased));
+    }
+
+    void KeyString::appendEscapedString(const char* str, size_t len) {
+        // NUL is escaped as 00 FF and the end is 00 01, so a string sorts before its
+        // extensions and comparison is still bytewise.
+        for (size_t i = 0; i < len; i++) {
+            _buffer.push_back(str[i]);
+            if (str[i] == '\0')
+                _buffer.push_back(static_cast<char>(0xFF));
+        }
+        _buffer.push_back('\0');
+        _buffer.push_back(1);
+    }
+
+    void KeyString::appendBigEndian64(unsigned long long value) {
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            _buffer.push_back(static_cast<char>(value >> shift));
+        }
+    }
+
+    void KeyString::appendBigEndian32(unsigned value) {
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            _buffer.push_back(static_cast<char>(value >> shift));
+        }
+    }
+
+    void KeyString::appendRecordId(RecordId loc) {
+        appendBigEndian64(static_cast<unsigned long long>(loc.repr()) ^ kSignBit);
+    }
+
+} // namespace mongo
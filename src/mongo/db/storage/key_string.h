@@ -0,0 +1,132 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "mongo/bson/bsonobj.h"
+#include "mongo/bson/ordering.h"
+#include "mongo/db/record_id.h"
+
+namespace mongo {
+
+    /**
+     * An index key and RecordId encoded so that comparing two encodings with memcmp, and then by
+     * length, orders them the way IndexEntryComparison orders the entries they came from.
+     * Storage engines can then compare keys with their native byte comparators and apply their
+     * own prefix compression.
+     *
+     * The encoding can't be decoded back to the key: equal numbers of different types (1, 1.0 and
+     * NumberLong(1)) encode identically, as they compare equal.  Keep the BSON key to return it.
+     *
+     * It matches IndexEntryComparison for every pair of keys but two:
+     *   - woCompare compares NumberLongs beyond 2^53 with doubles as doubles, which isn't a total
+     *     order.  Here such a NumberLong sorts next to, but not equal to, the nearest double.
+     *   - Dates sort before Timestamps rather than being compared with them by value.
+     *
+     * Each key element is a type byte, ordered as canonicalizeBSONType() orders types, followed
+     * by a self-delimiting encoding of its value.  An element whose field is descending in the
+     * Ordering has all its bytes inverted.  The key is followed by a discriminator byte and, for
+     * a stored entry, the RecordId.
+     */
+    class KeyString {
+    public:
+        /**
+         * Where a key with a null RecordId sorts relative to the entries with that key.
+         */
+        enum Discriminator {
+            kInclusive,       // no RecordId: a prefix of, so before, every entry with the key
+            kExclusiveBefore, // before every entry with the key
+            kExclusiveAfter,  // after every entry with the key
+        };
+
+        KeyString() {}
+
+        /**
+         * Encodes 'key' and 'loc' for 'ord'.  'key' may be a query object made by
+         * IndexEntryComparison::makeQueryObject(), whose exclusive fields are honored.  If 'loc'
+         * is null, 'discriminator' says where the encoding sorts among entries equal to 'key'.
+         */
+        KeyString(const BSONObj& key,
+                  Ordering ord,
+                  RecordId loc,
+                  Discriminator discriminator = kInclusive) {
+            resetToKey(key, ord, loc, discriminator);
+        }
+
+        void resetToKey(const BSONObj& key,
+                        Ordering ord,
+                        RecordId loc,
+                        Discriminator discriminator = kInclusive);
+
+        /**
+         * Makes this a copy of an encoding previously read out with getBuffer() and getSize().
+         */
+        void resetFromBuffer(const char* buffer, size_t size) { _buffer.assign(buffer, size); }
+
+        /**
+         * Returns false if 'key' holds a value, at any depth, for which comparing encodings may
+         * disagree with BSONObj::woCompare: a NumberLong beyond 2^53 or a Timestamp.  Sorts use
+         * this to tell which keys they may compare by their encodings.
+         */
+        static bool comparesLikeWoCompare(const BSONObj& key);
+
+        const char* getBuffer() const { return _buffer.data(); }
+        size_t getSize() const { return _buffer.size(); }
+
+        /**
+         * Returns <0, 0 or >0 as this sorts before, with, or after 'other'.
+         */
+        int compare(const KeyString& other) const;
+
+        /** Hex of the encoding, for debugging. */
+        std::string toString() const;
+
+    private:
+        void appendElement(const BSONElement& elem, bool invert);
+        void appendTypeAndValue(const BSONElement& elem, bool withFieldName);
+        void appendObjectContents(const BSONObj& obj, bool withFieldNames);
+        void appendNumber(const BSONElement& elem);
+        void appendEscapedString(const char* str, size_t len);
+        void appendBigEndian64(unsigned long long value);
+        void appendBigEndian32(unsigned value);
+        void appendRecordId(RecordId loc);
+
+        std::string _buffer;
+    };
+
+    inline bool operator<(const KeyString& lhs, const KeyString& rhs) {
+        return lhs.compare(rhs) < 0;
+    }
+
+    inline bool operator==(const KeyString& lhs, const KeyString& rhs) {
+        return lhs.compare(rhs) == 0;
+    }
+
+} // namespace mongo
@@ -0,0 +1,246 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/key_string.h"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/storage/index_entry_comparison.h"
+#include "mongo/platform/random.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+    int sign(int cmp) {
+        return cmp < 0 ? -1 : cmp > 0 ? 1 : 0;
+    }
+
+    // Asserts that comparing the encodings agrees with IndexEntryComparison.
+    void assertSameOrder(const IndexKeyEntry& lhs, const IndexKeyEntry& rhs, Ordering ord) {
+        const int expected = sign(IndexEntryComparison(ord).compare(lhs, rhs));
+        const KeyString lhsString(lhs.key, ord, lhs.loc);
+        const KeyString rhsString(rhs.key, ord, rhs.loc);
+        ASSERT_EQUALS(expected, sign(lhsString.compare(rhsString)))
+            << lhs.key << ' ' << lhs.loc << " vs " << rhs.key << ' ' << rhs.loc;
+    }
+
+    // Appends a random value, occasionally nested, drawn from a small pool so ties are common.
+    void appendRandomValue(BSONObjBuilder* bob, const StringData& name, PseudoRandom& random,
+                           int depth) {
+        static const char* const strings[] = {"", "a", "ab", "b", "a\0b"};
+        static const double doubles[] = {
+            -std::numeric_limits<double>::infinity(), -1.5, -0.0, 0.0, 0.5, 1.0, 2.0,
+            std::numeric_limits<double>::infinity(), std::numeric_limits<double>::quiet_NaN()};
+        static const long long longs[] = {
+            -2, 0, 1, 2, (1LL << 53) + 1, (1LL << 62) + 1, (1LL << 62) + 3,
+            std::numeric_limits<long long>::max(), std::numeric_limits<long long>::min()};
+
+        switch (random.nextInt32(depth < 2 ? 16 : 13)) {
+        case 0: bob->appendMinKey(name); break;
+        case 1: bob->appendMaxKey(name); break;
+        case 2: bob->appendNull(name); break;
+        case 3: bob->appendUndefined(name); break;
+        case 4: bob->append(name, static_cast<int>(random.nextInt32(5)) - 2); break;
+        case 5: bob->append(name, doubles[random.nextInt32(9)]); break;
+        case 6: bob->append(name, longs[random.nextInt32(9)]); break;
+        case 7: {
+            const int which = random.nextInt32(5);
+            bob->append(name, StringData(strings[which], which == 4 ? 3 : strlen(strings[which])));
+            break;
+        }
+        case 8: bob->appendSymbol(name, strings[random.nextInt32(4)]); break;
+        case 9: bob->appendBool(name, random.nextInt32(2)); break;
+        case 10: bob->appendDate(name, Date_t(random.nextInt32(3))); break;
+        case 11: {
+            const char data[] = {1, 2, 3};
+            bob->appendBinData(name, random.nextInt32(4), BinDataGeneral, data);
+            break;
+        }
+        case 12: bob->appendRegex(name, strings[1 + random.nextInt32(3)],
+                                  random.nextInt32(2) ? "i" : ""); break;
+        case 13:
+        case 14: {
+            BSONObjBuilder sub(bob->subobjStart(name));
+            const int n = random.nextInt32(3);
+            for (int i = 0; i < n; i++) {
+                appendRandomValue(&sub, random.nextInt32(2) ? "x" : "y", random, depth + 1);
+            }
+            sub.done();
+            break;
+        }
+        case 15: {
+            BSONObjBuilder sub(bob->subarrayStart(name));
+            const int n = random.nextInt32(3);
+            for (int i = 0; i < n; i++) {
+                appendRandomValue(&sub, BSONObjBuilder::numStr(i), random, depth + 1);
+            }
+            sub.done();
+            break;
+        }
+        }
+    }
+
+    BSONObj randomKey(PseudoRandom& random, int numFields) {
+        BSONObjBuilder bob;
+        for (int i = 0; i < numFields; i++) {
+            appendRandomValue(&bob, "", random, 0);
+        }
+        return bob.obj();
+    }
+
+    TEST(KeyStringTest, MatchesIndexEntryComparison) {
+        PseudoRandom random(7);
+        const BSONObj patterns[] = {
+            BSON("a" << 1 << "b" << 1),
+            BSON("a" << -1 << "b" << 1),
+            BSON("a" << 1 << "b" << -1),
+            BSON("a" << -1 << "b" << -1),
+        };
+
+        for (size_t p = 0; p < sizeof(patterns) / sizeof(patterns[0]); p++) {
+            const Ordering ord = Ordering::make(patterns[p]);
+
+            std::vector<IndexKeyEntry> entries;
+            for (int i = 0; i < 300; i++) {
+                entries.push_back(IndexKeyEntry(randomKey(random, 2),
+                                                RecordId(1 + random.nextInt32(3))));
+            }
+
+            for (size_t i = 0; i < entries.size(); i++) {
+                for (size_t j = 0; j < entries.size(); j++) {
+                    assertSameOrder(entries[i], entries[j], ord);
+                }
+            }
+        }
+    }
+
+    TEST(KeyStringTest, NumericTypesCompareByValue) {
+        const Ordering ord = Ordering::make(BSON("a" << 1));
+        ASSERT_EQUALS(0, KeyString(BSON("" << 1), ord, RecordId(1)).compare(
+                             KeyString(BSON("" << 1.0), ord, RecordId(1))));
+        ASSERT_EQUALS(0, KeyString(BSON("" << 1), ord, RecordId(1)).compare(
+                             KeyString(BSON("" << 1LL), ord, RecordId(1))));
+        ASSERT_EQUALS(0, KeyString(BSON("" << 0.0), ord, RecordId(1)).compare(
+                             KeyString(BSON("" << -0.0), ord, RecordId(1))));
+
+        // NumberLongs a double can't tell apart still sort among themselves.
+        const long long big = (1LL << 60) + 1;
+        ASSERT_LESS_THAN(KeyString(BSON("" << big), ord, RecordId(1)).compare(
+                             KeyString(BSON("" << big + 1), ord, RecordId(1))), 0);
+    }
+
+    // Queries from makeQueryObject and null RecordIds encode seek bounds.
+    TEST(KeyStringTest, QueryBounds) {
+        PseudoRandom random(11);
+        const Ordering ord = Ordering::make(BSON("a" << 1 << "b" << -1));
+
+        for (int i = 0; i < 2000; i++) {
+            const BSONObj stored = randomKey(random, 2);
+            const BSONObj bound = randomKey(random, 2);
+
+            const BSONElement startElem = bound.firstElement();
+            std::vector<const BSONElement*> suffix(2, &startElem);
+            suffix[1] = NULL;
+            BSONObjIterator it(bound);
+            it.next();
+            const BSONElement endElem = it.next();
+            suffix[1] = &endElem;
+
+            std::vector<bool> inclusive(2, true);
+            inclusive[random.nextInt32(2)] = random.nextInt32(2);
+            const int prefixLen = random.nextInt32(2);
+            const bool prefixExclusive = prefixLen > 0 && random.nextInt32(2);
+            const int direction = random.nextInt32(2) ? 1 : -1;
+
+            const IndexKeyEntry query(IndexEntryComparison::makeQueryObject(bound,
+                                                                           prefixLen,
+                                                                           prefixExclusive,
+                                                                           suffix,
+                                                                           inclusive,
+                                                                           direction),
+                                     RecordId());
+            const IndexKeyEntry entry(stored, RecordId(1 + random.nextInt32(3)));
+            const int expected = sign(IndexEntryComparison(ord).compare(entry, query));
+            if (expected == 0) {
+                // Equal to an inclusive bound: the bound sorts before the entries it equals.
+                ASSERT_LESS_THAN(KeyString(query.key, ord, query.loc).compare(
+                                     KeyString(entry.key, ord, entry.loc)), 0);
+                ASSERT_GREATER_THAN(
+                    KeyString(query.key, ord, query.loc, KeyString::kExclusiveAfter).compare(
+                        KeyString(entry.key, ord, entry.loc)), 0);
+            }
+            else {
+                ASSERT_EQUALS(expected, sign(KeyString(entry.key, ord, entry.loc).compare(
+                                                 KeyString(query.key, ord, query.loc))))
+                    << entry.key << " vs " << query.key;
+            }
+        }
+    }
+
+    TEST(KeyStringTest, TimestampsSortAfterDates) {
+        const Ordering ord = Ordering::make(BSON("a" << 1));
+        BSONObjBuilder date;
+        date.appendDate("", Date_t(5));
+        BSONObjBuilder ts;
+        ts.appendTimestamp("", 1);
+        ASSERT_LESS_THAN(KeyString(date.obj(), ord, RecordId(1)).compare(
+                             KeyString(ts.obj(), ord, RecordId(1))), 0);
+    }
+
+    TEST(KeyStringTest, ComparesLikeWoCompare) {
+        ASSERT(KeyString::comparesLikeWoCompare(BSON("" << 1 << "" << "abc")));
+        ASSERT(KeyString::comparesLikeWoCompare(BSON("" << (1LL << 53))));
+        ASSERT(KeyString::comparesLikeWoCompare(BSON("" << BSON_ARRAY(1 << BSON("a" << 2)))));
+
+        ASSERT_FALSE(KeyString::comparesLikeWoCompare(BSON("" << (1LL << 53) + 1)));
+        ASSERT_FALSE(KeyString::comparesLikeWoCompare(BSON("" << -(1LL << 60))));
+        ASSERT_FALSE(KeyString::comparesLikeWoCompare(
+                         BSON("" << 1 << "" << BSON("a" << BSON_ARRAY((1LL << 60))))));
+
+        BSONObjBuilder ts;
+        ts.appendTimestamp("", 1);
+        ASSERT_FALSE(KeyString::comparesLikeWoCompare(ts.obj()));
+    }
+
+    TEST(KeyStringTest, ResetFromBuffer) {
+        const Ordering ord = Ordering::make(BSON("a" << 1 << "b" << -1));
+        const KeyString original(BSON("" << "x" << "" << 2.5), ord, RecordId(7));
+        KeyString copy;
+        copy.resetFromBuffer(original.getBuffer(), original.getSize());
+        ASSERT_EQUALS(0, original.compare(copy));
+        ASSERT_EQUALS(original.toString(), copy.toString());
+    }
+
+} // namespace
+} // namespace mongo
@@ -85,6 +85,57 @@ namespace {
         const Entry _entry;
     };
 
+    /**
+     * Publishes the catalog document a unit of work wrote once it commits, and drops it if the
+     * unit of work rolls back.
+     */
+    class KVCatalog::CachedEntryChange : public RecoveryUnit::Change {
+    public:
+        CachedEntryChange(KVCatalog* catalog,
+                          const StringData& ns,
+                          const RecordId& loc,
+                          const RecoveryUnit* owner,
+                          const CachedEntryPtr& cached)
+            :_catalog(catalog), _ns(ns.toString()), _loc(loc), _owner(owner), _cached(cached)
+        {}
+
+        virtual void commit() {
+            boost::mutex::scoped_lock lk(_catalog->_identsLock);
+            NSToIdentMap::iterator it = _catalog->_idents.find(_ns);
+            if (it == _catalog->_idents.end() || it->second.storedLoc != _loc)
+                return;
+
+            it->second.committed = _cached;
+            if (it->second.pendingOwner == _owner && it->second.pending == _cached) {
+                // This is the last document the unit of work wrote.
+                it->second.pending.reset();
+                it->second.pendingOwner = NULL;
+            }
+        }
+
+        virtual void rollback() {
+            boost::mutex::scoped_lock lk(_catalog->_identsLock);
+            NSToIdentMap::iterator it = _catalog->_idents.find(_ns);
+            if (it == _catalog->_idents.end() || it->second.pendingOwner != _owner)
+                return;
+
+            it->second.pending.reset();
+            it->second.pendingOwner = NULL;
+        }
+
+        KVCatalog* const _catalog;
+        const std::string _ns;
+        const RecordId _loc;
+        const RecoveryUnit* const _owner;
+        const CachedEntryPtr _cached;
+    };
+
+    KVCatalog::CachedEntry::CachedEntry( const BSONObj& o )
+        : obj( o ) {
+        if ( obj["md"].isABSONObj() )
+            md.parse( obj["md"].Obj() );
+    }
+
     KVCatalog::KVCatalog( RecordStore* rs,
                           bool isRsThreadSafe,
                           bool directoryPerDb,
@@ -138,7 +189,9 @@ namespace {
             // No rollback since this is just loading already committed data.
             string ns = obj["ns"].String();
             string ident = obj["ident"].String();
-            _idents[ns] = Entry( ident, loc );
+            Entry& entry = _idents[ns];
+            entry = Entry( ident, loc );
+            entry.committed.reset( new CachedEntry( obj.getOwned() ) );
         }
 
         // In the unlikely event that we have used this _rand before generate a new one.
@@ -194,6 +247,7 @@ namespace {
             return res.getStatus();
 
         old = Entry( ident, res.getValue() );
+        _setPendingEntry( opCtx, ns, &old, obj );
         LOG(1) << "stored meta data for " << ns << " @ " << res.getValue();
         return Status::OK();
     }
@@ -217,6 +271,11 @@ namespace {
                                    const StringData& ns,
                                    RecordId* out ) const {
 
+        // The cache is guarded by _identsLock, so only the record store needs the resource lock.
+        CachedEntryPtr cached = _findCachedEntry( opCtx, ns, out );
+        if ( cached )
+            return cached->obj;
+
         boost::scoped_ptr<Lock::ResourceLock> rLk;
         if (!_isRsThreadSafe && opCtx->lockState()) {
             rLk.reset(new Lock::ResourceLock(opCtx->lockState(),
@@ -247,8 +306,45 @@ namespace {
         return data.releaseToBson().getOwned();
     }
 
+    KVCatalog::CachedEntryPtr KVCatalog::_findCachedEntry( OperationContext* opCtx,
+                                                           const StringData& ns,
+                                                           RecordId* out ) const {
+        boost::mutex::scoped_lock lk( _identsLock );
+        NSToIdentMap::const_iterator it = _idents.find( ns.toString() );
+        invariant( it != _idents.end() );
+
+        const Entry& entry = it->second;
+        CachedEntryPtr cached;
+        if ( !entry.pendingOwner )
+            cached = entry.committed;
+        else if ( entry.pendingOwner == opCtx->recoveryUnit() )
+            cached = entry.pending;
+
+        if ( cached && out )
+            *out = entry.storedLoc;
+        return cached;
+    }
+
+    void KVCatalog::_setPendingEntry( OperationContext* opCtx,
+                                      const StringData& ns,
+                                      Entry* entry,
+                                      const BSONObj& obj ) {
+        CachedEntryPtr cached( new CachedEntry( obj.getOwned() ) );
+        entry->pending = cached;
+        entry->pendingOwner = opCtx->recoveryUnit();
+        opCtx->recoveryUnit()->registerChange( new CachedEntryChange( this,
+                                                                      ns,
+                                                                      entry->storedLoc,
+                                                                      entry->pendingOwner,
+                                                                      cached ) );
+    }
+
     const BSONCollectionCatalogEntry::MetaData KVCatalog::getMetaData( OperationContext* opCtx,
                                                                        const StringData& ns ) {
+        CachedEntryPtr cached = _findCachedEntry( opCtx, ns );
+        if ( cached )
+            return cached->md;
+
         BSONObj obj = _findEntry( opCtx, ns );
         LOG(3) << " fetched CCE metadata: " << obj;
         BSONCollectionCatalogEntry::MetaData md;
@@ -276,29 +372,55 @@ namespace {
             BSONObjBuilder b;
             b.append( "md", md.toBSON() );
 
-            BSONObjBuilder newIdentMap;
             BSONObj oldIdentMap;
             if ( obj["idxIdent"].isABSONObj() )
                 oldIdentMap = obj["idxIdent"].Obj();
-
-            // fix ident map
-            for ( size_t i = 0; i < md.indexes.size(); i++ ) {
-                string name = md.indexes[i].name();
-                BSONElement e = oldIdentMap[name];
-                if ( e.type() == String ) {
-                    newIdentMap.append( e );
-                    continue;
+            b.append( "idxIdent", _fixIndexIdents( ns, md, oldIdentMap ) );
+
+            // every partition has its own idents for the indexes
+            if ( obj["partitions"].isABSONObj() ) {
+                BSONArrayBuilder partitions( b.subarrayStart( "partitions" ) );
+                BSONObjIterator it( obj["partitions"].Obj() );
+                while ( it.more() ) {
+                    BSONObj partition = it.next().Obj();
+                    BSONObjBuilder pb( partitions.subobjStart() );
+                    pb.append( "idxIdent", _fixIndexIdents( ns, md,
+                                                            partition["idxIdent"].Obj() ) );
+                    pb.appendElementsUnique( partition );
+                    pb.done();
                 }
-                // missing, create new
-                newIdentMap.append( name, _newUniqueIdent(ns, "index") );
+                partitions.done();
             }
-            b.append( "idxIdent", newIdentMap.obj() );
 
             // add whatever is left
             b.appendElementsUnique( obj );
             obj = b.obj();
         }
 
+        _updateEntry( opCtx, ns, loc, obj );
+    }
+
+    BSONObj KVCatalog::_fixIndexIdents( const StringData& ns,
+                                        const BSONCollectionCatalogEntry::MetaData& md,
+                                        const BSONObj& idxIdent ) {
+        BSONObjBuilder newIdentMap;
+        for ( size_t i = 0; i < md.indexes.size(); i++ ) {
+            string name = md.indexes[i].name();
+            BSONElement e = idxIdent[name];
+            if ( e.type() == String ) {
+                newIdentMap.append( e );
+                continue;
+            }
+            // missing, create new
+            newIdentMap.append( name, _newUniqueIdent(ns, "index") );
+        }
+        return newIdentMap.obj();
+    }
+
+    void KVCatalog::_updateEntry( OperationContext* opCtx,
+                                  const StringData& ns,
+                                  const RecordId& loc,
+                                  const BSONObj& obj ) {
         StatusWith<RecordId> status = _rs->updateRecord( opCtx,
                                                         loc,
                                                         obj.objdata(),
@@ -307,6 +429,11 @@ namespace {
                                                         NULL );
         fassert( 28521, status.getStatus() );
         invariant( status.getValue() == loc );
+
+        boost::mutex::scoped_lock lk( _identsLock );
+        const NSToIdentMap::iterator it = _idents.find( ns.toString() );
+        invariant( it != _idents.end() );
+        _setPendingEntry( opCtx, ns, &it->second, obj );
     }
 
     Status KVCatalog::renameCollection( OperationContext* opCtx,
@@ -323,6 +450,7 @@ namespace {
 
         RecordId loc;
         BSONObj old = _findEntry( opCtx, fromNS, &loc ).getOwned();
+        BSONObj obj;
         {
             BSONObjBuilder b;
 
@@ -337,7 +465,7 @@ namespace {
 
             b.appendElementsUnique( old );
 
-            BSONObj obj = b.obj();
+            obj = b.obj();
             StatusWith<RecordId> status = _rs->updateRecord( opCtx,
                                                             loc,
                                                             obj.objdata(),
@@ -356,7 +484,9 @@ namespace {
         opCtx->recoveryUnit()->registerChange(new AddIdentChange(this, toNS));
 
         _idents.erase(fromIt);
-        _idents[toNS.toString()] = Entry( old["ident"].String(), loc );
+        Entry& entry = _idents[toNS.toString()];
+        entry = Entry( old["ident"].String(), loc );
+        _setPendingEntry( opCtx, toNS, &entry, obj );
 
         return Status::OK();
     }
@@ -387,6 +517,99 @@ namespace {
         return Status::OK();
     }
 
+    std::vector<KVPartition> KVCatalog::getPartitions( OperationContext* opCtx,
+                                                       const StringData& ns ) const {
+        BSONObj obj = _findEntry( opCtx, ns );
+
+        std::vector<KVPartition> partitions( 1 );
+        partitions[0].ident = obj["ident"].String();
+        if ( obj["idxIdent"].isABSONObj() )
+            partitions[0].idxIdent = obj["idxIdent"].Obj().getOwned();
+
+        if ( !obj["partitions"].isABSONObj() )
+            return partitions;
+
+        BSONObjIterator it( obj["partitions"].Obj() );
+        while ( it.more() ) {
+            BSONObj p = it.next().Obj();
+            KVPartition partition;
+            partition.number = p["n"].numberInt();
+            partition.start = p["start"].date();
+            partition.ident = p["ident"].String();
+            partition.idxIdent = p["idxIdent"].Obj().getOwned();
+            partitions.push_back( partition );
+        }
+        return partitions;
+    }
+
+    KVPartition KVCatalog::addPartition( OperationContext* opCtx,
+                                         const StringData& ns,
+                                         Date_t start ) {
+        boost::scoped_ptr<Lock::ResourceLock> rLk;
+        if (!_isRsThreadSafe && opCtx->lockState()) {
+            rLk.reset(new Lock::ResourceLock(opCtx->lockState(),
+                                             resourceIdCatalogMetadata,
+                                             MODE_X));
+        }
+
+        RecordId loc;
+        BSONObj obj = _findEntry( opCtx, ns, &loc );
+        BSONCollectionCatalogEntry::MetaData md;
+        md.parse( obj["md"].Obj() );
+
+        BSONArrayBuilder partitions;
+        KVPartition partition;
+        partition.number = 1;
+        if ( obj["partitions"].isABSONObj() ) {
+            BSONObjIterator it( obj["partitions"].Obj() );
+            while ( it.more() ) {
+                BSONElement e = it.next();
+                partition.number = std::max( partition.number, e["n"].numberInt() + 1 );
+                partitions.append( e );
+            }
+        }
+        partition.start = start;
+        partition.ident = _newUniqueIdent( ns, "collection" );
+        partition.idxIdent = _fixIndexIdents( ns, md, BSONObj() );
+        partitions.append( BSON( "n" << partition.number
+                                 << "start" << start
+                                 << "ident" << partition.ident
+                                 << "idxIdent" << partition.idxIdent ) );
+
+        BSONObjBuilder b;
+        b.append( "partitions", partitions.arr() );
+        b.appendElementsUnique( obj );
+        _updateEntry( opCtx, ns, loc, b.obj() );
+        return partition;
+    }
+
+    void KVCatalog::removePartition( OperationContext* opCtx,
+                                     const StringData& ns,
+                                     int number ) {
+        boost::scoped_ptr<Lock::ResourceLock> rLk;
+        if (!_isRsThreadSafe && opCtx->lockState()) {
+            rLk.reset(new Lock::ResourceLock(opCtx->lockState(),
+                                             resourceIdCatalogMetadata,
+                                             MODE_X));
+        }
+
+        RecordId loc;
+        BSONObj obj = _findEntry( opCtx, ns, &loc );
+
+        BSONArrayBuilder partitions;
+        BSONObjIterator it( obj["partitions"].Obj() );
+        while ( it.more() ) {
+            BSONElement e = it.next();
+            if ( e["n"].numberInt() != number )
+                partitions.append( e );
+        }
+
+        BSONObjBuilder b;
+        b.append( "partitions", partitions.arr() );
+        b.appendElementsUnique( obj );
+        _updateEntry( opCtx, ns, loc, b.obj() );
+    }
+
     std::vector<std::string> KVCatalog::getAllIdentsForDB( const StringData& db ) const {
         std::vector<std::string> v;
 
@@ -414,14 +637,24 @@ namespace {
             v.push_back( obj["ident"].String() );
 
             BSONElement e = obj["idxIdent"];
+            if ( e.isABSONObj() ) {
+                BSONObjIterator sub( e.Obj() );
+                while ( sub.more() ) {
+                    v.push_back( sub.next().String() );
+                }
+            }
+
+            e = obj["partitions"];
             if ( !e.isABSONObj() )
                 continue;
-            BSONObj idxIdent = e.Obj();
-
-            BSONObjIterator sub( idxIdent );
-            while ( sub.more() ) {
-                BSONElement e = sub.next();
-                v.push_back( e.String() );
+            BSONObjIterator partitions( e.Obj() );
+            while ( partitions.more() ) {
+                BSONObj partition = partitions.next().Obj();
+                v.push_back( partition["ident"].String() );
+                BSONObjIterator sub( partition["idxIdent"].Obj() );
+                while ( sub.more() ) {
+                    v.push_back( sub.next().String() );
+                }
             }
         }
 
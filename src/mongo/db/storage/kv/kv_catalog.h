@@ -34,17 +34,20 @@
 #include <string>
 
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 
 #include "mongo/base/string_data.h"
 #include "mongo/db/catalog/collection_options.h"
 #include "mongo/db/record_id.h"
 #include "mongo/db/storage/bson_collection_catalog_entry.h"
+#include "mongo/db/storage/kv/kv_partition_layout.h"
 
 namespace mongo {
 
     class OperationContext;
     class RecordStore;
+    class RecoveryUnit;
 
     class KVCatalog {
     public:
@@ -88,6 +91,28 @@ namespace mongo {
         Status dropCollection( OperationContext* opCtx,
                                const StringData& ns );
 
+        /**
+         * The partitions of a collection, starting with the default one which uses the idents of
+         * the collection itself. Only partitioned collections have more than that one.
+         */
+        std::vector<KVPartition> getPartitions( OperationContext* opCtx,
+                                                const StringData& ns ) const;
+
+        /**
+         * Records a new partition of "ns" for the range starting at "start", with new idents for
+         * its records and for each index. Creating those is up to the caller.
+         */
+        KVPartition addPartition( OperationContext* opCtx,
+                                  const StringData& ns,
+                                  Date_t start );
+
+        /**
+         * Removes partition "number" of "ns". Dropping its idents is up to the caller.
+         */
+        void removePartition( OperationContext* opCtx,
+                              const StringData& ns,
+                              int number );
+
         std::vector<std::string> getAllIdentsForDB( const StringData& db ) const;
         std::vector<std::string> getAllIdents( OperationContext* opCtx ) const;
 
@@ -95,11 +120,43 @@ namespace mongo {
     private:
         class AddIdentChange;
         class RemoveIdentChange;
+        class CachedEntryChange;
+
+        /**
+         * A catalog document along with its parsed metadata.  Never modified once shared, so
+         * writers swap in a new one instead.
+         */
+        struct CachedEntry {
+            explicit CachedEntry( const BSONObj& o );
+            BSONObj obj;
+            BSONCollectionCatalogEntry::MetaData md;
+        };
+        typedef boost::shared_ptr<const CachedEntry> CachedEntryPtr;
+
+        struct Entry;
 
         BSONObj _findEntry( OperationContext* opCtx,
                             const StringData& ns,
                             RecordId* out=NULL ) const;
 
+        /**
+         * Returns the cached catalog document for "ns" as seen by "opCtx", or NULL if it must be
+         * read from the record store because another unit of work has changed it and not yet
+         * committed.
+         */
+        CachedEntryPtr _findCachedEntry( OperationContext* opCtx,
+                                         const StringData& ns,
+                                         RecordId* out=NULL ) const;
+
+        /**
+         * Records "obj" as the catalog document "opCtx" wrote for "ns", to be seen by others once
+         * the unit of work commits.  Must be called with _identsLock held.
+         */
+        void _setPendingEntry( OperationContext* opCtx,
+                               const StringData& ns,
+                               Entry* entry,
+                               const BSONObj& obj );
+
         /**
          * Generates a new unique identifier for a new "thing".
          * @param ns - the containing ns
@@ -107,6 +164,22 @@ namespace mongo {
          */
         std::string _newUniqueIdent(const StringData& ns, const char* kind);
 
+        /**
+         * Returns "idxIdent" with an entry for each index of "md" only, generating idents for
+         * new ones.
+         */
+        BSONObj _fixIndexIdents( const StringData& ns,
+                                 const BSONCollectionCatalogEntry::MetaData& md,
+                                 const BSONObj& idxIdent );
+
+        /**
+         * Replaces the catalog document for "ns" stored at "loc" with "obj".
+         */
+        void _updateEntry( OperationContext* opCtx,
+                           const StringData& ns,
+                           const RecordId& loc,
+                           const BSONObj& obj );
+
         // Helpers only used by constructor and init(). Don't call from elsewhere.
         static std::string _newRand();
         bool _hasEntryCollidingWithRand() const;
@@ -121,11 +194,18 @@ namespace mongo {
         AtomicUInt64 _next;
 
         struct Entry {
-            Entry(){}
+            Entry() : pendingOwner( NULL ) {}
             Entry( std::string i, RecordId l )
-                : ident(i), storedLoc( l ) {}
+                : ident(i), storedLoc( l ), pendingOwner( NULL ) {}
             std::string ident;
             RecordId storedLoc;
+
+            // The document as of the last commit, which is what every other unit of work sees.
+            CachedEntryPtr committed;
+
+            // The document written by the uncommitted unit of work of pendingOwner, if any.
+            CachedEntryPtr pending;
+            const RecoveryUnit* pendingOwner;
         };
         typedef std::map<std::string,Entry> NSToIdentMap;
         NSToIdentMap _idents;
@@ -31,13 +31,15 @@
 #include "mongo/db/storage/kv/kv_collection_catalog_entry.h"
 
 #include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/index_names.h"
 #include "mongo/db/storage/kv/kv_catalog.h"
 #include "mongo/db/storage/kv/kv_engine.h"
+#include "mongo/db/storage/kv/partitioned_record_store.h"
 
 namespace mongo {
-    class KVCollectionCatalogEntry::AddIndexChange : public RecoveryUnit::Change {
+    class KVCollectionCatalogEntry::AddIdentChange : public RecoveryUnit::Change {
     public:
-        AddIndexChange(OperationContext* opCtx, KVCollectionCatalogEntry* cce,
+        AddIdentChange(OperationContext* opCtx, KVCollectionCatalogEntry* cce,
                        const StringData& ident)
             : _opCtx(opCtx)
             , _cce(cce)
@@ -55,9 +57,9 @@ namespace mongo {
         const std::string _ident;
     };
 
-    class KVCollectionCatalogEntry::RemoveIndexChange : public RecoveryUnit::Change {
+    class KVCollectionCatalogEntry::RemoveIdentChange : public RecoveryUnit::Change {
     public:
-        RemoveIndexChange(OperationContext* opCtx, KVCollectionCatalogEntry* cce,
+        RemoveIdentChange(OperationContext* opCtx, KVCollectionCatalogEntry* cce,
                           const StringData& ident)
             : _opCtx(opCtx)
             , _cce(cce)
@@ -67,7 +69,7 @@ namespace mongo {
         virtual void rollback() {}
         virtual void commit() {
             // Intentionally ignoring failure here. Since we've removed the metadata pointing to the
-            // index, we should never see it again anyway.
+            // ident, we should never see it again anyway.
             _cce->_engine->dropIdent(_opCtx, _ident);
         }
 
@@ -86,7 +88,8 @@ namespace mongo {
           _engine( engine ),
           _catalog( catalog ),
           _ident( ident.toString() ),
-          _recordStore( rs ) {
+          _recordStore( rs ),
+          _partitionedRecordStore( dynamic_cast<PartitionedRecordStore*>( rs ) ) {
     }
 
     KVCollectionCatalogEntry::~KVCollectionCatalogEntry() {
@@ -116,16 +119,39 @@ namespace mongo {
         _catalog->putMetaData( txn,  ns().toString(), md );
     }
 
+    void KVCollectionCatalogEntry::setIndexBuildCheckpoint( OperationContext* txn,
+                                                            const StringData& indexName,
+                                                            const BSONObj& checkpoint ) {
+        MetaData md = _getMetaData( txn );
+        int offset = md.findIndexOffset( indexName );
+        invariant( offset >= 0 );
+        invariant( !md.indexes[offset].ready );
+        md.indexes[offset].buildCheckpoint = checkpoint.getOwned();
+        _catalog->putMetaData( txn, ns().toString(), md );
+    }
+
     Status KVCollectionCatalogEntry::removeIndex( OperationContext* txn,
                                                   const StringData& indexName ) {
-        string ident = _catalog->getIndexIdent( txn, ns().ns(), indexName );
+        std::vector<string> idents;
+        idents.push_back( _catalog->getIndexIdent( txn, ns().ns(), indexName ) );
+        if ( _partitionedRecordStore ) {
+            const std::vector<KVPartition> partitions = _catalog->getPartitions( txn, ns().ns() );
+            for ( size_t i = 1; i < partitions.size(); i++ ) {
+                idents.push_back( partitions[i].idxIdent[indexName].String() );
+            }
+        }
 
         MetaData md = _getMetaData( txn );
         md.eraseIndex( indexName );
         _catalog->putMetaData( txn, ns().toString(), md );
 
+        if ( _partitionedRecordStore )
+            _refreshPartitions( txn );
+
         // Lazily remove to isolate underlying engine from rollback.
-        txn->recoveryUnit()->registerChange(new RemoveIndexChange(txn, this, ident));
+        for ( size_t i = 0; i < idents.size(); i++ ) {
+            txn->recoveryUnit()->registerChange(new RemoveIdentChange(txn, this, idents[i]));
+        }
         return Status::OK();
     }
 
@@ -137,12 +163,26 @@ namespace mongo {
 
         string ident = _catalog->getIndexIdent( txn, ns().ns(), spec->indexName() );
 
-        const Status status = _engine->createSortedDataInterface( txn, ident, spec );
+        Status status = _engine->createSortedDataInterface( txn, ident, spec );
         if (status.isOK()) {
-            txn->recoveryUnit()->registerChange(new AddIndexChange(txn, this, ident));
+            txn->recoveryUnit()->registerChange(new AddIdentChange(txn, this, ident));
         }
 
-        return status;
+        if ( !status.isOK() || !_partitionedRecordStore )
+            return status;
+
+        // Every partition gets an index of its own.
+        const std::vector<KVPartition> partitions = _catalog->getPartitions( txn, ns().ns() );
+        for ( size_t i = 1; i < partitions.size(); i++ ) {
+            const string partitionIdent = partitions[i].idxIdent[spec->indexName()].String();
+            status = _engine->createSortedDataInterface( txn, partitionIdent, spec );
+            if ( !status.isOK() )
+                return status;
+            txn->recoveryUnit()->registerChange(new AddIdentChange(txn, this, partitionIdent));
+        }
+        _refreshPartitions( txn );
+
+        return Status::OK();
     }
 
     void KVCollectionCatalogEntry::indexBuildSuccess( OperationContext* txn,
@@ -151,6 +191,7 @@ namespace mongo {
         int offset = md.findIndexOffset( indexName );
         invariant( offset >= 0 );
         md.indexes[offset].ready = true;
+        md.indexes[offset].buildCheckpoint = BSONObj();
         _catalog->putMetaData( txn, ns().toString(), md );
     }
 
@@ -164,6 +205,87 @@ namespace mongo {
         _catalog->putMetaData( txn, ns().toString(), md );
     }
 
+    Status KVCollectionCatalogEntry::addPartition( OperationContext* txn, Date_t when ) {
+        if ( !_partitionedRecordStore )
+            return BSONCollectionCatalogEntry::addPartition( txn, when );
+
+        const Date_t start = _partitionedRecordStore->layout()->rangeStartFor( when );
+        if ( _partitionedRecordStore->layout()->numberForStart( start ) != 0 )
+            return Status::OK();
+
+        const KVPartition partition = _catalog->addPartition( txn, ns().ns(), start );
+        const MetaData md = _getMetaData( txn );
+
+        Status status = _engine->createRecordStore( txn, ns().ns(), partition.ident, md.options );
+        if ( !status.isOK() )
+            return status;
+        txn->recoveryUnit()->registerChange(new AddIdentChange(txn, this, partition.ident));
+
+        for ( size_t i = 0; i < md.indexes.size(); i++ ) {
+            const BSONObj& spec = md.indexes[i].spec;
+            const IndexDescriptor desc( NULL,
+                                        IndexNames::findPluginName( spec.getObjectField( "key" ) ),
+                                        spec );
+            const string ident = partition.idxIdent[desc.indexName()].String();
+            status = _engine->createSortedDataInterface( txn, ident, &desc );
+            if ( !status.isOK() )
+                return status;
+            txn->recoveryUnit()->registerChange(new AddIdentChange(txn, this, ident));
+        }
+
+        _refreshPartitions( txn );
+        return Status::OK();
+    }
+
+    Status KVCollectionCatalogEntry::dropPartitionsBefore( OperationContext* txn,
+                                                           Date_t before,
+                                                           int* numDropped,
+                                                           std::vector<RecordId>* strays ) {
+        if ( !_partitionedRecordStore ) {
+            return BSONCollectionCatalogEntry::dropPartitionsBefore( txn, before, numDropped,
+                                                                     strays );
+        }
+
+        boost::shared_ptr<const KVPartitionLayout> layout = _partitionedRecordStore->layout();
+        const Date_t cutoff = layout->rangeStartFor( before );
+
+        std::vector<string> idents;
+        const std::vector<KVPartition> partitions = _catalog->getPartitions( txn, ns().ns() );
+        for ( size_t i = 1; i < partitions.size(); i++ ) {
+            if ( partitions[i].start.asInt64() >= cutoff.asInt64() )
+                continue;
+            _catalog->removePartition( txn, ns().ns(), partitions[i].number );
+            idents.push_back( partitions[i].ident );
+            BSONObjIterator it( partitions[i].idxIdent );
+            while ( it.more() ) {
+                idents.push_back( it.next().String() );
+            }
+            (*numDropped)++;
+        }
+
+        // Like removeIndex(), only drop the idents once the unit of work commits.
+        if ( *numDropped )
+            _refreshPartitions( txn );
+        for ( size_t i = 0; i < idents.size(); i++ ) {
+            txn->recoveryUnit()->registerChange(new RemoveIdentChange(txn, this, idents[i]));
+        }
+
+        // Documents inserted before their partition was added stay in the default one.
+        boost::scoped_ptr<RecordIterator> it( _partitionedRecordStore->getPartitionIterator( txn,
+                                                                                             0 ) );
+        while ( !it->isEOF() ) {
+            const RecordId loc = it->getNext();
+            BSONElement e = it->dataFor( loc ).toBson().getFieldDotted( layout->key() );
+            if ( e.type() == mongo::Date && e.date().asInt64() < cutoff.asInt64() )
+                strays->push_back( loc );
+        }
+        return Status::OK();
+    }
+
+    void KVCollectionCatalogEntry::_refreshPartitions( OperationContext* txn ) {
+        _partitionedRecordStore->setPartitions( txn, _catalog->getPartitions( txn, ns().ns() ) );
+    }
+
     BSONCollectionCatalogEntry::MetaData KVCollectionCatalogEntry::_getMetaData( OperationContext* txn ) const {
         return _catalog->getMetaData( txn, ns().toString() );
     }
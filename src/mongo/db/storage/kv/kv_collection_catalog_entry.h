@@ -38,6 +38,7 @@ namespace mongo {
 
     class KVCatalog;
     class KVEngine;
+    class PartitionedRecordStore;
 
     class KVCollectionCatalogEntry : public BSONCollectionCatalogEntry {
     public:
@@ -59,6 +60,10 @@ namespace mongo {
                                    const StringData& indexName,
                                    const RecordId& newHead );
 
+        virtual void setIndexBuildCheckpoint( OperationContext* txn,
+                                              const StringData& indexName,
+                                              const BSONObj& checkpoint );
+
         virtual Status removeIndex( OperationContext* txn,
                                     const StringData& indexName );
 
@@ -76,6 +81,13 @@ namespace mongo {
                                        const StringData& idxName,
                                        long long newExpireSeconds );
 
+        virtual Status addPartition( OperationContext* txn, Date_t when );
+
+        virtual Status dropPartitionsBefore( OperationContext* txn,
+                                             Date_t before,
+                                             int* numDropped,
+                                             std::vector<RecordId>* strays );
+
         RecordStore* getRecordStore() { return _recordStore.get(); }
         const RecordStore* getRecordStore() const { return _recordStore.get(); }
 
@@ -83,13 +95,22 @@ namespace mongo {
         virtual MetaData _getMetaData( OperationContext* txn ) const;
 
     private:
-        class AddIndexChange;
-        class RemoveIndexChange;
+        class AddIdentChange;
+        class RemoveIdentChange;
+
+        /**
+         * Hands the partitions the catalog now lists to the record store, and through it to the
+         * indexes.
+         */
+        void _refreshPartitions( OperationContext* txn );
 
         KVEngine* _engine; // not owned
         KVCatalog* _catalog; // not owned
         std::string _ident;
         boost::scoped_ptr<RecordStore> _recordStore; // owned
+
+        // _recordStore if the collection is partitioned, NULL otherwise.
+        PartitionedRecordStore* _partitionedRecordStore;
     };
 
 }
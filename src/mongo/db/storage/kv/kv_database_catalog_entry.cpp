@@ -34,6 +34,7 @@
 #include "mongo/db/storage/kv/kv_collection_catalog_entry.h"
 #include "mongo/db/storage/kv/kv_engine.h"
 #include "mongo/db/storage/kv/kv_storage_engine.h"
+#include "mongo/db/storage/kv/partitioned_record_store.h"
 #include "mongo/db/storage/recovery_unit.h"
 
 namespace mongo {
@@ -94,6 +95,9 @@ namespace mongo {
         }
 
         virtual void rollback() {
+            // The changes for the other partitions of a collection have no entry.
+            if (!_entry)
+                return;
             boost::mutex::scoped_lock lk(_dce->_collectionsLock);
             _dce->_collections[_collection] = _entry;
         }
@@ -137,14 +141,15 @@ namespace mongo {
                 continue;
             size += coll->getRecordStore()->storageSize( opCtx );
 
-            vector<string> indexNames;
-            coll->getAllIndexes( opCtx, &indexNames );
-
-            for ( size_t i = 0; i < indexNames.size(); i++ ) {
-                string ident = _engine->getCatalog()->getIndexIdent( opCtx,
-                                                                     coll->ns().ns(),
-                                                                     indexNames[i] );
-                size += _engine->getEngine()->getIdentSize( opCtx, ident );
+            // The default partition has the indexes of an unpartitioned collection.
+            const std::vector<KVPartition> partitions =
+                _engine->getCatalog()->getPartitions( opCtx, coll->ns().ns() );
+            for ( size_t i = 0; i < partitions.size(); i++ ) {
+                BSONObjIterator idxIdents( partitions[i].idxIdent );
+                while ( idxIdents.more() ) {
+                    const string ident = idxIdents.next().String();
+                    size += _engine->getEngine()->getIdentSize( opCtx, ident );
+                }
             }
         }
 
@@ -168,6 +173,20 @@ namespace mongo {
         }
     }
 
+    RecordStore* KVDatabaseCatalogEntry::_openRecordStore( OperationContext* txn,
+                                                           const StringData& ns,
+                                                           const StringData& ident,
+                                                           const CollectionOptions& options ) {
+        if ( !options.isPartitioned() )
+            return _engine->getEngine()->getRecordStore( txn, ns, ident, options );
+
+        return new PartitionedRecordStore( txn,
+                                           _engine->getEngine(),
+                                           ns,
+                                           options,
+                                           _engine->getCatalog()->getPartitions( txn, ns ) );
+    }
+
     CollectionCatalogEntry* KVDatabaseCatalogEntry::getCollectionCatalogEntry( OperationContext* txn,
                                                                                const StringData& ns ) const {
         boost::mutex::scoped_lock lk( _collectionsLock );
@@ -216,7 +235,7 @@ namespace mongo {
         if ( !status.isOK() )
             return status;
 
-        RecordStore* rs = _engine->getEngine()->getRecordStore( txn, ns, ident, options );
+        RecordStore* rs = _openRecordStore( txn, ns, ident, options );
         invariant( rs );
         boost::mutex::scoped_lock lk( _collectionsLock );
         txn->recoveryUnit()->registerChange(new AddCollectionChange(txn, this, ns, ident, true));
@@ -232,7 +251,7 @@ namespace mongo {
         string ident = _engine->getCatalog()->getCollectionIdent( ns );
         BSONCollectionCatalogEntry::MetaData md = _engine->getCatalog()->getMetaData( opCtx, ns );
 
-        RecordStore* rs = _engine->getEngine()->getRecordStore( opCtx, ns, ident, md.options );
+        RecordStore* rs = _openRecordStore( opCtx, ns, ident, md.options );
         invariant( rs );
 
         boost::mutex::scoped_lock lk( _collectionsLock );
@@ -266,7 +285,11 @@ namespace mongo {
 
         const std::string identFrom = _engine->getCatalog()->getCollectionIdent( fromNS );
 
-        Status status = _engine->getEngine()->okToRename( txn, fromNS, toNS, identFrom, originalRS );
+        const PartitionedRecordStore* partitionedRS =
+            dynamic_cast<const PartitionedRecordStore*>( originalRS );
+        Status status = partitionedRS
+            ? partitionedRS->okToRename( txn, toNS )
+            : _engine->getEngine()->okToRename( txn, fromNS, toNS, identFrom, originalRS );
         if ( !status.isOK() )
             return status;
 
@@ -279,7 +302,7 @@ namespace mongo {
         invariant( identFrom == identTo );
 
         BSONCollectionCatalogEntry::MetaData md = _engine->getCatalog()->getMetaData( txn, toNS );
-        RecordStore* rs = _engine->getEngine()->getRecordStore( txn, toNS, identTo, md.options );
+        RecordStore* rs = _openRecordStore( txn, toNS, identTo, md.options );
 
         boost::mutex::scoped_lock lk( _collectionsLock );
         const CollectionMap::iterator itFrom = _collections.find(fromNS.toString());
@@ -319,6 +342,8 @@ namespace mongo {
         invariant( entry->getTotalIndexCount( opCtx ) == 0 );
 
         string ident = _engine->getCatalog()->getCollectionIdent( ns );
+        const std::vector<KVPartition> partitions = _engine->getCatalog()->getPartitions( opCtx,
+                                                                                          ns );
 
         boost::mutex::scoped_lock lk( _collectionsLock );
 
@@ -335,6 +360,13 @@ namespace mongo {
         opCtx->recoveryUnit()->registerChange(new RemoveCollectionChange(opCtx, this, ns, ident,
                                                                          it->second, true));
 
+        // The other partitions are dropped along with it. Their indexes went with removeIndex().
+        for ( size_t i = 1; i < partitions.size(); i++ ) {
+            opCtx->recoveryUnit()->registerChange(new RemoveCollectionChange(opCtx, this, ns,
+                                                                             partitions[i].ident,
+                                                                             NULL, true));
+        }
+
         _collections.erase( ns.toString() );
 
         return Status::OK();
@@ -96,6 +96,15 @@ namespace mongo {
         class AddCollectionChange;
         class RemoveCollectionChange;
 
+        /**
+         * Opens the record store of "ns", which for a partitioned collection is made of one per
+         * partition.
+         */
+        RecordStore* _openRecordStore( OperationContext* txn,
+                                       const StringData& ns,
+                                       const StringData& ident,
+                                       const CollectionOptions& options );
+
         KVStorageEngine* _engine; // not owned here
 
         typedef std::map<std::string,KVCollectionCatalogEntry*> CollectionMap;
@@ -44,6 +44,8 @@
 #include "mongo/db/storage/kv/kv_collection_catalog_entry.h"
 #include "mongo/db/storage/kv/kv_engine.h"
 #include "mongo/db/storage/kv/kv_storage_engine.h"
+#include "mongo/db/storage/kv/partitioned_record_store.h"
+#include "mongo/db/storage/kv/partitioned_sorted_data_interface.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
 
@@ -56,12 +58,21 @@ namespace mongo {
 
         const string& type = desc->getAccessMethodName();
 
-        string ident = _engine->getCatalog()->getIndexIdent( txn,
-                                                             collection->ns().ns(),
-                                                             desc->indexName() );
-
-        SortedDataInterface* sdi =
-            _engine->getEngine()->getSortedDataInterface( txn, ident, desc );
+        const PartitionedRecordStore* partitionedRS = dynamic_cast<const PartitionedRecordStore*>(
+            static_cast<const KVCollectionCatalogEntry*>( collection )->getRecordStore() );
+
+        SortedDataInterface* sdi;
+        if ( partitionedRS ) {
+            sdi = new PartitionedSortedDataInterface( _engine->getEngine(),
+                                                      desc,
+                                                      partitionedRS->layout() );
+        }
+        else {
+            string ident = _engine->getCatalog()->getIndexIdent( txn,
+                                                                 collection->ns().ns(),
+                                                                 desc->indexName() );
+            sdi = _engine->getEngine()->getSortedDataInterface( txn, ident, desc );
+        }
 
         if ("" == type)
             return new BtreeAccessMethod( index, sdi );
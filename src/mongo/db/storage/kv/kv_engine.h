@@ -36,6 +36,7 @@
 #include "mongo/base/status.h"
 #include "mongo/base/string_data.h"
 #include "mongo/db/catalog/collection_options.h"
+#include "mongo/db/storage/storage_engine.h"
 
 namespace mongo {
 
@@ -102,6 +103,22 @@ namespace mongo {
          */
         virtual bool supportsDocLocking() const = 0;
 
+        /**
+         * See StorageEngine::beginReplicationBatch.
+         */
+        virtual void beginReplicationBatch() {}
+        virtual void endReplicationBatch() {}
+
+        /**
+         * See StorageEngine::beginBackup.
+         */
+        virtual Status beginBackup(OperationContext* opCtx,
+                                   std::vector<StorageEngine::BackupFile>* files) {
+            return Status(ErrorCodes::CommandNotSupported,
+                          "this storage engine does not support hot backups");
+        }
+        virtual void endBackup(OperationContext* opCtx) {}
+
         virtual Status okToRename( OperationContext* opCtx,
                                    const StringData& fromNS,
                                    const StringData& toNS,
@@ -404,5 +404,66 @@ namespace mongo {
 
     }
 
+    TEST( KVCatalogTest, MetaDataRollback1 ) {
+        scoped_ptr<KVHarnessHelper> helper( KVHarnessHelper::create() );
+        KVEngine* engine = helper->getEngine();
+
+        scoped_ptr<RecordStore> rs;
+        scoped_ptr<KVCatalog> catalog;
+        {
+            MyOperationContext opCtx( engine );
+            WriteUnitOfWork uow( &opCtx );
+            ASSERT_OK( engine->createRecordStore( &opCtx, "catalog", "catalog", CollectionOptions() ) );
+            rs.reset( engine->getRecordStore( &opCtx, "catalog", "catalog", CollectionOptions() ) );
+            catalog.reset( new KVCatalog( rs.get(), true, false, false) );
+            ASSERT_OK( catalog->newCollection( &opCtx, "a.b", CollectionOptions() ) );
+            uow.commit();
+        }
+
+        BSONCollectionCatalogEntry::MetaData md;
+        md.ns ="a.b";
+        md.indexes.push_back( BSONCollectionCatalogEntry::IndexMetaData( BSON( "name" << "foo" ),
+                                                                         false,
+                                                                         RecordId(),
+                                                                         false ) );
+
+        { // the writer sees its own change before it commits
+            MyOperationContext opCtx( engine );
+            WriteUnitOfWork uow( &opCtx );
+            catalog->putMetaData( &opCtx, "a.b", md );
+            ASSERT_EQUALS( 1U, catalog->getMetaData( &opCtx, "a.b" ).indexes.size() );
+        }
+
+        {
+            MyOperationContext opCtx( engine );
+            ASSERT_EQUALS( 0U, catalog->getMetaData( &opCtx, "a.b" ).indexes.size() );
+        }
+
+        {
+            MyOperationContext opCtx( engine );
+            WriteUnitOfWork uow( &opCtx );
+            catalog->putMetaData( &opCtx, "a.b", md );
+            md.indexes[0].multikey = true;
+            catalog->putMetaData( &opCtx, "a.b", md );
+            uow.commit();
+        }
+
+        {
+            MyOperationContext opCtx( engine );
+            BSONCollectionCatalogEntry::MetaData found = catalog->getMetaData( &opCtx, "a.b" );
+            ASSERT_EQUALS( 1U, found.indexes.size() );
+            ASSERT_TRUE( found.indexes[0].multikey );
+        }
+
+        { // what is cached matches what a fresh catalog reads back
+            MyOperationContext opCtx( engine );
+            string idxIdent = catalog->getIndexIdent( &opCtx, "a.b", "foo" );
+            catalog.reset( new KVCatalog( rs.get(), true, false, false) );
+            catalog->init( &opCtx );
+            ASSERT_EQUALS( idxIdent, catalog->getIndexIdent( &opCtx, "a.b", "foo" ) );
+            ASSERT_TRUE( catalog->getMetaData( &opCtx, "a.b" ).indexes[0].multikey );
+        }
+    }
+
 
 }
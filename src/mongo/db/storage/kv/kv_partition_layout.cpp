@@ -0,0 +1,72 @@
+// kv_partition_layout.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/storage/kv/kv_partition_layout.h"
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+    KVPartitionLayout::KVPartitionLayout( const std::string& key, long long spanSecs )
+        : _key( key ), _spanMillis( spanSecs * 1000 ), _version( 0 ) {
+        invariant( _spanMillis > 0 );
+    }
+
+    Date_t KVPartitionLayout::rangeStartFor( Date_t when ) const {
+        const long long millis = when.asInt64();
+        const long long offset = ( ( millis % _spanMillis ) + _spanMillis ) % _spanMillis;
+        return Date_t( static_cast<unsigned long long>( millis - offset ) );
+    }
+
+    void KVPartitionLayout::set( const std::vector<KVPartition>& partitions ) {
+        invariant( !partitions.empty() && partitions[0].number == 0 );
+        _partitions = partitions;
+        _numberByStart.clear();
+        for ( size_t i = 1; i < _partitions.size(); i++ ) {
+            _numberByStart[_partitions[i].start.asInt64()] = _partitions[i].number;
+        }
+        _version++;
+    }
+
+    int KVPartitionLayout::partitionFor( const BSONObj& doc ) const {
+        if ( _numberByStart.empty() )
+            return 0;
+        BSONElement e = doc.getFieldDotted( _key );
+        if ( e.type() != mongo::Date )
+            return 0;
+        return numberForStart( rangeStartFor( e.date() ) );
+    }
+
+    int KVPartitionLayout::numberForStart( Date_t start ) const {
+        std::map<long long, int>::const_iterator it = _numberByStart.find( start.asInt64() );
+        return it == _numberByStart.end() ? 0 : it->second;
+    }
+
+}
@@ -0,0 +1,135 @@
+// kv_partition_layout.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/record_id.h"
+
+namespace mongo {
+
+    /**
+     * One of the record stores, with an index of its own per index of the collection, that a
+     * partitioned collection keeps its documents in.
+     */
+    struct KVPartition {
+        KVPartition() : number( 0 ) {}
+
+        // 0 for the default partition, which holds the documents that fall in no other.
+        int number;
+
+        // The first date of the range of a numbered partition.
+        Date_t start;
+
+        std::string ident;
+
+        // Index name to ident. Owned.
+        BSONObj idxIdent;
+    };
+
+    /**
+     * Where the documents of a partitioned collection go. A RecordId of such a collection packs
+     * the number of its partition above the id the partition's record store gave it, so the
+     * default partition keeps the ids its record store hands out.
+     *
+     * Only changes while the collection's database is locked in MODE_X.
+     */
+    class KVPartitionLayout {
+    public:
+        KVPartitionLayout( const std::string& key, long long spanSecs );
+
+        const std::string& key() const { return _key; }
+
+        /**
+         * The start of the range "when" falls in.
+         */
+        Date_t rangeStartFor( Date_t when ) const;
+
+        /**
+         * Replaces the partitions, which have to include the default one.
+         */
+        void set( const std::vector<KVPartition>& partitions );
+
+        const std::vector<KVPartition>& partitions() const { return _partitions; }
+
+        /**
+         * Bumped by every set().
+         */
+        unsigned long long version() const { return _version; }
+
+        /**
+         * Returns the number of the partition "doc" belongs in.
+         */
+        int partitionFor( const BSONObj& doc ) const;
+
+        /**
+         * Returns the number of the partition starting at "start", or 0 if there is none.
+         */
+        int numberForStart( Date_t start ) const;
+
+        static const int kNumberShift = 40;
+
+        static int numberOf( const RecordId& loc ) {
+            return loc.isNormal() ? static_cast<int>( loc.repr() >> kNumberShift ) : 0;
+        }
+
+        static RecordId toChild( const RecordId& loc ) {
+            if ( !loc.isNormal() )
+                return loc;
+            return RecordId( loc.repr() & ( ( 1LL << kNumberShift ) - 1 ) );
+        }
+
+        static RecordId fromChild( int number, const RecordId& childLoc ) {
+            if ( !childLoc.isNormal() )
+                return childLoc;
+            return RecordId( ( static_cast<int64_t>( number ) << kNumberShift ) |
+                             childLoc.repr() );
+        }
+
+        /**
+         * Whether "childLoc" is small enough to be packed by fromChild().
+         */
+        static bool fitsChild( const RecordId& childLoc ) {
+            return childLoc.repr() < ( 1LL << kNumberShift );
+        }
+
+    private:
+        const std::string _key;
+        const long long _spanMillis;
+        std::vector<KVPartition> _partitions;
+        std::map<long long, int> _numberByStart;
+        unsigned long long _version;
+    };
+
+}
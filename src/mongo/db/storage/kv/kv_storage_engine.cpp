@@ -258,7 +258,30 @@ namespace mongo {
         return _engine->isDurable();
     }
 
+    void KVStorageEngine::beginReplicationBatch() {
+        _engine->beginReplicationBatch();
+    }
+
+    void KVStorageEngine::endReplicationBatch() {
+        _engine->endReplicationBatch();
+    }
+
+    Status KVStorageEngine::beginBackup(OperationContext* txn, std::vector<BackupFile>* files) {
+        return _engine->beginBackup(txn, files);
+    }
+
+    void KVStorageEngine::endBackup(OperationContext* txn) {
+        _engine->endBackup(txn);
+    }
+
     Status KVStorageEngine::repairRecordStore(OperationContext* txn, const std::string& ns) {
-        return _engine->repairIdent(txn, _catalog->getCollectionIdent(ns));
+        // The first partition is the collection itself.
+        const std::vector<KVPartition> partitions = _catalog->getPartitions(txn, ns);
+        for (size_t i = 0; i < partitions.size(); i++) {
+            Status status = _engine->repairIdent(txn, partitions[i].ident);
+            if (!status.isOK())
+                return status;
+        }
+        return Status::OK();
     }
 }
@@ -77,12 +77,18 @@ namespace mongo {
 
         virtual bool supportsDocLocking() const { return _supportsDocLocking; }
 
+        virtual void beginReplicationBatch();
+        virtual void endReplicationBatch();
+
         virtual Status closeDatabase( OperationContext* txn, const StringData& db );
 
         virtual Status dropDatabase( OperationContext* txn, const StringData& db );
 
         virtual int flushAllFiles( bool sync );
 
+        virtual Status beginBackup(OperationContext* txn, std::vector<BackupFile>* files);
+        virtual void endBackup(OperationContext* txn);
+
         virtual bool isDurable() const;
 
         virtual Status repairRecordStore(OperationContext* txn, const std::string& ns);
@@ -0,0 +1,520 @@
+// partitioned_record_store.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/kv/partitioned_record_store.h"
+
+#include <boost/scoped_array.hpp>
+
+#include "mongo/db/operation_context.h"
+#include "mongo/db/storage/kv/kv_engine.h"
+#include "mongo/db/storage/recovery_unit.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+namespace {
+
+    /**
+     * Walks the records of the partitions one partition after the other, in number order
+     * forward and in reverse order backward.
+     */
+    class PartitionedRecordIterator : public RecordIterator {
+    public:
+        typedef std::vector<std::pair<int, RecordIterator*> > Children;
+
+        /**
+         * Takes ownership of the iterators in "children".
+         */
+        explicit PartitionedRecordIterator( const Children& children )
+            : _children( children ), _pos( 0 ) {
+            _skipEOF();
+        }
+
+        virtual ~PartitionedRecordIterator() {
+            for ( size_t i = 0; i < _children.size(); i++ ) {
+                delete _children[i].second;
+            }
+        }
+
+        virtual bool isEOF() {
+            _skipEOF();
+            return _pos == _children.size();
+        }
+
+        virtual RecordId curr() {
+            if ( isEOF() )
+                return RecordId();
+            return KVPartitionLayout::fromChild( _children[_pos].first,
+                                                 _children[_pos].second->curr() );
+        }
+
+        virtual RecordId getNext() {
+            if ( isEOF() )
+                return RecordId();
+            return KVPartitionLayout::fromChild( _children[_pos].first,
+                                                 _children[_pos].second->getNext() );
+        }
+
+        virtual void invalidate( const RecordId& dl ) {
+            RecordIterator* child = _childFor( dl );
+            if ( child )
+                child->invalidate( KVPartitionLayout::toChild( dl ) );
+        }
+
+        virtual void saveState() {
+            for ( size_t i = _pos; i < _children.size(); i++ ) {
+                _children[i].second->saveState();
+            }
+        }
+
+        virtual bool restoreState( OperationContext* txn ) {
+            bool ok = true;
+            for ( size_t i = _pos; i < _children.size(); i++ ) {
+                ok = _children[i].second->restoreState( txn ) && ok;
+            }
+            return ok;
+        }
+
+        virtual RecordData dataFor( const RecordId& loc ) const {
+            RecordIterator* child = _childFor( loc );
+            invariant( child );
+            return child->dataFor( KVPartitionLayout::toChild( loc ) );
+        }
+
+    private:
+        void _skipEOF() {
+            while ( _pos < _children.size() && _children[_pos].second->isEOF() ) {
+                _pos++;
+            }
+        }
+
+        RecordIterator* _childFor( const RecordId& loc ) const {
+            const int number = KVPartitionLayout::numberOf( loc );
+            for ( size_t i = 0; i < _children.size(); i++ ) {
+                if ( _children[i].first == number )
+                    return _children[i].second;
+            }
+            return NULL;
+        }
+
+        const Children _children;
+        size_t _pos;
+    };
+
+}
+
+    /**
+     * Puts back the partitions replaced by setPartitions() if the unit of work rolls back.
+     */
+    class PartitionedRecordStore::SetPartitionsChange : public RecoveryUnit::Change {
+    public:
+        SetPartitionsChange( PartitionedRecordStore* rs )
+            : _rs( rs ), _children( rs->_children ), _partitions( rs->_layout->partitions() ) {}
+
+        virtual void commit() {}
+        virtual void rollback() {
+            _rs->_children = _children;
+            _rs->_layout->set( _partitions );
+        }
+
+        PartitionedRecordStore* const _rs;
+        const Children _children;
+        const std::vector<KVPartition> _partitions;
+    };
+
+    PartitionedRecordStore::PartitionedRecordStore( OperationContext* txn,
+                                                    KVEngine* engine,
+                                                    const StringData& ns,
+                                                    const CollectionOptions& options,
+                                                    const std::vector<KVPartition>& partitions )
+        : RecordStore( ns ),
+          _engine( engine ),
+          _options( options ),
+          _layout( new KVPartitionLayout( options.partitionKey, options.partitionSpanSecs ) ) {
+        invariant( !options.capped );
+        for ( size_t i = 0; i < partitions.size(); i++ ) {
+            RecordStore* rs = _engine->getRecordStore( txn, ns, partitions[i].ident, _options );
+            invariant( rs );
+            _children[partitions[i].number].reset( rs );
+        }
+        _layout->set( partitions );
+    }
+
+    PartitionedRecordStore::~PartitionedRecordStore() {
+    }
+
+    void PartitionedRecordStore::setPartitions( OperationContext* txn,
+                                                const std::vector<KVPartition>& partitions ) {
+        txn->recoveryUnit()->registerChange( new SetPartitionsChange( this ) );
+
+        Children children;
+        for ( size_t i = 0; i < partitions.size(); i++ ) {
+            const int number = partitions[i].number;
+            Children::const_iterator it = _children.find( number );
+            if ( it != _children.end() ) {
+                children[number] = it->second;
+                continue;
+            }
+            RecordStore* rs = _engine->getRecordStore( txn, ns(), partitions[i].ident, _options );
+            invariant( rs );
+            children[number].reset( rs );
+        }
+        _children.swap( children );
+        _layout->set( partitions );
+    }
+
+    RecordStore* PartitionedRecordStore::_child( const RecordId& loc ) const {
+        Children::const_iterator it = _children.find( KVPartitionLayout::numberOf( loc ) );
+        invariant( it != _children.end() );
+        return it->second.get();
+    }
+
+    RecordIterator* PartitionedRecordStore::getPartitionIterator( OperationContext* txn,
+                                                                  int number ) const {
+        Children::const_iterator it = _children.find( number );
+        invariant( it != _children.end() );
+        PartitionedRecordIterator::Children children;
+        children.push_back( std::make_pair( number, it->second->getIterator( txn ) ) );
+        return new PartitionedRecordIterator( children );
+    }
+
+    Status PartitionedRecordStore::okToRename( OperationContext* txn,
+                                               const StringData& toNS ) const {
+        const std::vector<KVPartition>& partitions = _layout->partitions();
+        for ( size_t i = 0; i < partitions.size(); i++ ) {
+            const RecordStore* rs = _children.find( partitions[i].number )->second.get();
+            Status status = _engine->okToRename( txn, ns(), toNS, partitions[i].ident, rs );
+            if ( !status.isOK() )
+                return status;
+        }
+        return Status::OK();
+    }
+
+    const char* PartitionedRecordStore::name() const {
+        return _children.find( 0 )->second->name();
+    }
+
+    long long PartitionedRecordStore::dataSize( OperationContext* txn ) const {
+        long long size = 0;
+        for ( Children::const_iterator it = _children.begin(); it != _children.end(); ++it ) {
+            size += it->second->dataSize( txn );
+        }
+        return size;
+    }
+
+    long long PartitionedRecordStore::numRecords( OperationContext* txn ) const {
+        long long num = 0;
+        for ( Children::const_iterator it = _children.begin(); it != _children.end(); ++it ) {
+            num += it->second->numRecords( txn );
+        }
+        return num;
+    }
+
+    int64_t PartitionedRecordStore::storageSize( OperationContext* txn,
+                                                 BSONObjBuilder* extraInfo,
+                                                 int infoLevel ) const {
+        int64_t size = 0;
+        for ( Children::const_iterator it = _children.begin(); it != _children.end(); ++it ) {
+            size += it->second->storageSize( txn, it->first == 0 ? extraInfo : NULL, infoLevel );
+        }
+        return size;
+    }
+
+    RecordData PartitionedRecordStore::dataFor( OperationContext* txn,
+                                                const RecordId& loc ) const {
+        return _child( loc )->dataFor( txn, KVPartitionLayout::toChild( loc ) );
+    }
+
+    bool PartitionedRecordStore::findRecord( OperationContext* txn,
+                                             const RecordId& loc,
+                                             RecordData* out ) const {
+        Children::const_iterator it = _children.find( KVPartitionLayout::numberOf( loc ) );
+        if ( it == _children.end() )
+            return false;
+        return it->second->findRecord( txn, KVPartitionLayout::toChild( loc ), out );
+    }
+
+    void PartitionedRecordStore::deleteRecord( OperationContext* txn, const RecordId& dl ) {
+        _child( dl )->deleteRecord( txn, KVPartitionLayout::toChild( dl ) );
+    }
+
+    StatusWith<RecordId> PartitionedRecordStore::_insertInto( OperationContext* txn,
+                                                              int number,
+                                                              const char* data,
+                                                              int len,
+                                                              bool enforceQuota ) {
+        Children::const_iterator it = _children.find( number );
+        invariant( it != _children.end() );
+        StatusWith<RecordId> loc = it->second->insertRecord( txn, data, len, enforceQuota );
+        if ( !loc.isOK() )
+            return loc;
+        if ( !KVPartitionLayout::fitsChild( loc.getValue() ) ) {
+            return StatusWith<RecordId>( ErrorCodes::InternalError,
+                                         str::stream() << "partition " << number << " of "
+                                                       << ns() << " ran out of record ids" );
+        }
+        return StatusWith<RecordId>( KVPartitionLayout::fromChild( number, loc.getValue() ) );
+    }
+
+    StatusWith<RecordId> PartitionedRecordStore::insertRecord( OperationContext* txn,
+                                                               const char* data,
+                                                               int len,
+                                                               bool enforceQuota ) {
+        return _insertInto( txn, _layout->partitionFor( BSONObj( data ) ), data, len,
+                            enforceQuota );
+    }
+
+    StatusWith<RecordId> PartitionedRecordStore::insertRecord( OperationContext* txn,
+                                                               const DocWriter* doc,
+                                                               bool enforceQuota ) {
+        // The document has to be written out to find its partition.
+        const int len = doc->documentSize();
+        boost::scoped_array<char> buf( new char[len] );
+        doc->writeDocument( buf.get() );
+        return insertRecord( txn, buf.get(), len, enforceQuota );
+    }
+
+    StatusWith<RecordId> PartitionedRecordStore::updateRecord( OperationContext* txn,
+                                                               const RecordId& oldLocation,
+                                                               const char* data,
+                                                               int len,
+                                                               bool enforceQuota,
+                                                               UpdateMoveNotifier* notifier ) {
+        const int oldNumber = KVPartitionLayout::numberOf( oldLocation );
+        const int newNumber = _layout->partitionFor( BSONObj( data ) );
+        RecordStore* oldChild = _child( oldLocation );
+        const RecordId oldChildLoc = KVPartitionLayout::toChild( oldLocation );
+
+        if ( oldNumber == newNumber ) {
+            StatusWith<RecordId> loc = oldChild->updateRecord( txn, oldChildLoc, data, len,
+                                                               enforceQuota, notifier );
+            if ( !loc.isOK() )
+                return loc;
+            return StatusWith<RecordId>( KVPartitionLayout::fromChild( oldNumber,
+                                                                       loc.getValue() ) );
+        }
+
+        // The key moved the document to another partition.
+        StatusWith<RecordId> loc = _insertInto( txn, newNumber, data, len, enforceQuota );
+        if ( !loc.isOK() )
+            return loc;
+
+        if ( notifier ) {
+            RecordData old = oldChild->dataFor( txn, oldChildLoc );
+            Status status = notifier->recordStoreGoingToMove( txn, oldLocation, old.data(),
+                                                              old.size() );
+            if ( !status.isOK() )
+                return StatusWith<RecordId>( status );
+        }
+
+        oldChild->deleteRecord( txn, oldChildLoc );
+        return loc;
+    }
+
+    Status PartitionedRecordStore::updateWithDamages( OperationContext* txn,
+                                                      const RecordId& loc,
+                                                      const RecordData& oldRec,
+                                                      const char* damageSource,
+                                                      const mutablebson::DamageVector& damages ) {
+        return _child( loc )->updateWithDamages( txn, KVPartitionLayout::toChild( loc ), oldRec,
+                                                 damageSource, damages );
+    }
+
+    bool PartitionedRecordStore::updateWithDamagesCanGrow( OperationContext* txn,
+                                                           const RecordId& loc,
+                                                           int newSize ) const {
+        return _child( loc )->updateWithDamagesCanGrow( txn, KVPartitionLayout::toChild( loc ),
+                                                        newSize );
+    }
+
+    bool PartitionedRecordStore::updateWithDamagesMovesRecord(
+            OperationContext* txn,
+            const RecordId& loc,
+            const RecordData& oldRec,
+            const char* damageSource,
+            const mutablebson::DamageVector& damages ) const {
+        const size_t newSize = mutablebson::getDamagedSize( oldRec.size(), damages );
+        boost::scoped_array<char> buf( new char[newSize] );
+        std::memcpy( buf.get(), oldRec.data(), oldRec.size() );
+
+        mutablebson::DamageVector::const_iterator where = damages.begin();
+        const mutablebson::DamageVector::const_iterator end = damages.end();
+        for( ; where != end; ++where ) {
+            std::memcpy( buf.get() + where->targetOffset,
+                         damageSource + where->sourceOffset,
+                         where->size );
+        }
+
+        return _layout->partitionFor( BSONObj( buf.get() ) ) != KVPartitionLayout::numberOf( loc );
+    }
+
+    RecordFetcher* PartitionedRecordStore::recordNeedsFetch( OperationContext* txn,
+                                                            const RecordId& loc ) const {
+        return _child( loc )->recordNeedsFetch( txn, KVPartitionLayout::toChild( loc ) );
+    }
+
+    RecordIterator* PartitionedRecordStore::getIterator(
+            OperationContext* txn,
+            const RecordId& start,
+            const CollectionScanParams::Direction& dir ) const {
+        const bool forward = dir == CollectionScanParams::FORWARD;
+        const int startNumber = KVPartitionLayout::numberOf( start );
+
+        PartitionedRecordIterator::Children children;
+        for ( Children::const_iterator it = _children.begin(); it != _children.end(); ++it ) {
+            if ( !start.isNormal() || it->first == startNumber ) {
+                children.push_back(
+                    std::make_pair( it->first,
+                                    it->second->getIterator(
+                                        txn, KVPartitionLayout::toChild( start ), dir ) ) );
+            }
+            else if ( forward ? it->first > startNumber : it->first < startNumber ) {
+                children.push_back( std::make_pair( it->first,
+                                                    it->second->getIterator( txn,
+                                                                             RecordId(),
+                                                                             dir ) ) );
+            }
+        }
+        if ( !forward )
+            std::reverse( children.begin(), children.end() );
+        return new PartitionedRecordIterator( children );
+    }
+
+    std::vector<RecordIterator*> PartitionedRecordStore::getManyIterators(
+            OperationContext* txn ) const {
+        std::vector<RecordIterator*> out;
+        for ( Children::const_iterator it = _children.begin(); it != _children.end(); ++it ) {
+            std::vector<RecordIterator*> many = it->second->getManyIterators( txn );
+            for ( size_t i = 0; i < many.size(); i++ ) {
+                PartitionedRecordIterator::Children children;
+                children.push_back( std::make_pair( it->first, many[i] ) );
+                out.push_back( new PartitionedRecordIterator( children ) );
+            }
+        }
+        return out;
+    }
+
+    Status PartitionedRecordStore::truncate( OperationContext* txn ) {
+        for ( Children::const_iterator it = _children.begin(); it != _children.end(); ++it ) {
+            Status status = it->second->truncate( txn );
+            if ( !status.isOK() )
+                return status;
+        }
+        return Status::OK();
+    }
+
+    void PartitionedRecordStore::temp_cappedTruncateAfter( OperationContext* txn,
+                                                           RecordId end,
+                                                           bool inclusive ) {
+        invariant( !"a partitioned collection is never capped" );
+    }
+
+    Status PartitionedRecordStore::compact( OperationContext* txn,
+                                            RecordStoreCompactAdaptor* adaptor,
+                                            const CompactOptions* options,
+                                            CompactStats* stats ) {
+        return Status( ErrorCodes::CommandNotSupported,
+                       "a partitioned collection can't be compacted" );
+    }
+
+    Status PartitionedRecordStore::validate( OperationContext* txn,
+                                             bool full,
+                                             bool scanData,
+                                             ValidateAdaptor* adaptor,
+                                             ValidateResults* results,
+                                             BSONObjBuilder* output ) const {
+        long long nrecords = 0;
+        BSONArrayBuilder partitions( output->subarrayStart( "partitions" ) );
+        for ( Children::const_iterator it = _children.begin(); it != _children.end(); ++it ) {
+            BSONObjBuilder partition( partitions.subobjStart() );
+            partition.append( "n", it->first );
+            Status status = it->second->validate( txn, full, scanData, adaptor, results,
+                                                  &partition );
+            if ( !status.isOK() )
+                return status;
+            nrecords += it->second->numRecords( txn );
+            partition.done();
+        }
+        partitions.done();
+        output->appendNumber( "nrecords", nrecords );
+        return Status::OK();
+    }
+
+    void PartitionedRecordStore::appendCustomStats( OperationContext* txn,
+                                                    BSONObjBuilder* result,
+                                                    double scale ) const {
+        _children.find( 0 )->second->appendCustomStats( txn, result, scale );
+
+        const std::vector<KVPartition>& partitions = _layout->partitions();
+        BSONArrayBuilder b( result->subarrayStart( "partitions" ) );
+        for ( size_t i = 0; i < partitions.size(); i++ ) {
+            const RecordStore* rs = _children.find( partitions[i].number )->second.get();
+            BSONObjBuilder partition( b.subobjStart() );
+            partition.append( "n", partitions[i].number );
+            if ( partitions[i].number != 0 )
+                partition.appendDate( "start", partitions[i].start );
+            partition.appendNumber( "count", rs->numRecords( txn ) );
+            partition.appendNumber( "size", rs->dataSize( txn ) / scale );
+            partition.done();
+        }
+        b.done();
+    }
+
+    bool PartitionedRecordStore::appendCacheStats( OperationContext* txn,
+                                                   BSONObjBuilder* result,
+                                                   double scale ) const {
+        return _children.find( 0 )->second->appendCacheStats( txn, result, scale );
+    }
+
+    Status PartitionedRecordStore::touch( OperationContext* txn, BSONObjBuilder* output ) const {
+        for ( Children::const_iterator it = _children.begin(); it != _children.end(); ++it ) {
+            Status status = it->second->touch( txn, it->first == 0 ? output : NULL );
+            if ( !status.isOK() )
+                return status;
+        }
+        return Status::OK();
+    }
+
+    Status PartitionedRecordStore::setCustomOption( OperationContext* txn,
+                                                    const BSONElement& option,
+                                                    BSONObjBuilder* info ) {
+        for ( Children::const_iterator it = _children.begin(); it != _children.end(); ++it ) {
+            Status status = it->second->setCustomOption( txn, option,
+                                                         it->first == 0 ? info : NULL );
+            if ( !status.isOK() )
+                return status;
+        }
+        return Status::OK();
+    }
+
+}
@@ -0,0 +1,196 @@
+// partitioned_record_store.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <map>
+
+#include <boost/shared_ptr.hpp>
+
+#include "mongo/db/catalog/collection_options.h"
+#include "mongo/db/storage/kv/kv_partition_layout.h"
+#include "mongo/db/storage/record_store.h"
+
+namespace mongo {
+
+    class KVEngine;
+
+    /**
+     * The records of a partitioned collection, kept in one record store per partition of its
+     * layout. Documents go to the partition their key puts them in, and move to another when an
+     * update changes the key.
+     */
+    class PartitionedRecordStore : public RecordStore {
+    public:
+        PartitionedRecordStore( OperationContext* txn,
+                                KVEngine* engine,
+                                const StringData& ns,
+                                const CollectionOptions& options,
+                                const std::vector<KVPartition>& partitions );
+
+        virtual ~PartitionedRecordStore();
+
+        /**
+         * Shared with the indexes of the collection.
+         */
+        boost::shared_ptr<const KVPartitionLayout> layout() const { return _layout; }
+
+        /**
+         * Opens the record stores of new partitions and closes those of partitions no longer
+         * listed. Undone if the unit of work rolls back. The database has to be locked in MODE_X.
+         */
+        void setPartitions( OperationContext* txn, const std::vector<KVPartition>& partitions );
+
+        /**
+         * Iterates over the records of partition "number" only.
+         */
+        RecordIterator* getPartitionIterator( OperationContext* txn, int number ) const;
+
+        /**
+         * Asks the engine whether the record store of each partition can be renamed.
+         */
+        Status okToRename( OperationContext* txn, const StringData& toNS ) const;
+
+        virtual const char* name() const;
+
+        virtual long long dataSize( OperationContext* txn ) const;
+
+        virtual long long numRecords( OperationContext* txn ) const;
+
+        virtual bool isCapped() const { return false; }
+
+        virtual int64_t storageSize( OperationContext* txn,
+                                     BSONObjBuilder* extraInfo = NULL,
+                                     int infoLevel = 0 ) const;
+
+        virtual RecordData dataFor( OperationContext* txn, const RecordId& loc ) const;
+
+        virtual bool findRecord( OperationContext* txn,
+                                 const RecordId& loc,
+                                 RecordData* out ) const;
+
+        virtual void deleteRecord( OperationContext* txn, const RecordId& dl );
+
+        virtual StatusWith<RecordId> insertRecord( OperationContext* txn,
+                                                  const char* data,
+                                                  int len,
+                                                  bool enforceQuota );
+
+        virtual StatusWith<RecordId> insertRecord( OperationContext* txn,
+                                                  const DocWriter* doc,
+                                                  bool enforceQuota );
+
+        virtual StatusWith<RecordId> updateRecord( OperationContext* txn,
+                                                  const RecordId& oldLocation,
+                                                  const char* data,
+                                                  int len,
+                                                  bool enforceQuota,
+                                                  UpdateMoveNotifier* notifier );
+
+        virtual Status updateWithDamages( OperationContext* txn,
+                                          const RecordId& loc,
+                                          const RecordData& oldRec,
+                                          const char* damageSource,
+                                          const mutablebson::DamageVector& damages );
+
+        virtual bool updateWithDamagesCanGrow( OperationContext* txn,
+                                               const RecordId& loc,
+                                               int newSize ) const;
+
+        virtual bool updateWithDamagesMovesRecord( OperationContext* txn,
+                                                   const RecordId& loc,
+                                                   const RecordData& oldRec,
+                                                   const char* damageSource,
+                                                   const mutablebson::DamageVector& damages ) const;
+
+        virtual RecordFetcher* recordNeedsFetch( OperationContext* txn,
+                                                 const RecordId& loc ) const;
+
+        virtual RecordIterator* getIterator( OperationContext* txn,
+                                             const RecordId& start = RecordId(),
+                                             const CollectionScanParams::Direction& dir =
+                                                     CollectionScanParams::FORWARD ) const;
+
+        virtual std::vector<RecordIterator*> getManyIterators( OperationContext* txn ) const;
+
+        virtual Status truncate( OperationContext* txn );
+
+        virtual void temp_cappedTruncateAfter( OperationContext* txn,
+                                               RecordId end,
+                                               bool inclusive );
+
+        virtual bool compactSupported() const { return false; }
+
+        virtual Status compact( OperationContext* txn,
+                                RecordStoreCompactAdaptor* adaptor,
+                                const CompactOptions* options,
+                                CompactStats* stats );
+
+        virtual Status validate( OperationContext* txn,
+                                 bool full,
+                                 bool scanData,
+                                 ValidateAdaptor* adaptor,
+                                 ValidateResults* results,
+                                 BSONObjBuilder* output ) const;
+
+        virtual void appendCustomStats( OperationContext* txn,
+                                        BSONObjBuilder* result,
+                                        double scale ) const;
+
+        virtual bool appendCacheStats( OperationContext* txn,
+                                       BSONObjBuilder* result,
+                                       double scale ) const;
+
+        virtual Status touch( OperationContext* txn, BSONObjBuilder* output ) const;
+
+        virtual Status setCustomOption( OperationContext* txn,
+                                        const BSONElement& option,
+                                        BSONObjBuilder* info = NULL );
+
+    private:
+        class SetPartitionsChange;
+
+        typedef std::map<int, boost::shared_ptr<RecordStore> > Children;
+
+        RecordStore* _child( const RecordId& loc ) const;
+
+        StatusWith<RecordId> _insertInto( OperationContext* txn,
+                                          int number,
+                                          const char* data,
+                                          int len,
+                                          bool enforceQuota );
+
+        KVEngine* const _engine; // not owned
+        const CollectionOptions _options;
+        const boost::shared_ptr<KVPartitionLayout> _layout;
+        Children _children;
+    };
+
+}
@@ -0,0 +1,248 @@
+// partitioned_record_store_test.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/kv/partitioned_record_store.h"
+
+#include <boost/scoped_ptr.hpp>
+
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/json.h"
+#include "mongo/db/operation_context_noop.h"
+#include "mongo/db/storage/in_memory/in_memory_engine.h"
+#include "mongo/db/storage/kv/partitioned_sorted_data_interface.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+
+namespace {
+
+    using boost::scoped_ptr;
+
+    const long long kSpanSecs = 3600;
+    const long long kHour = 1000 * kSpanSecs;
+
+    class MyOperationContext : public OperationContextNoop {
+    public:
+        MyOperationContext( KVEngine* engine )
+            : OperationContextNoop( engine->newRecoveryUnit() ) {
+        }
+    };
+
+    class CountingNotifier : public UpdateMoveNotifier {
+    public:
+        CountingNotifier() : moves( 0 ) {}
+        virtual Status recordStoreGoingToMove( OperationContext* txn,
+                                               const RecordId& oldLocation,
+                                               const char* oldBuffer,
+                                               size_t oldSize ) {
+            moves++;
+            return Status::OK();
+        }
+        int moves;
+    };
+
+    /**
+     * A collection partitioned by hour on "ts" with the default partition and those of the
+     * first two hours of the epoch, and an index on "a".
+     */
+    class PartitionedFixture {
+    public:
+        PartitionedFixture()
+            : desc( NULL, "", fromjson( "{ns: 'a.b', name: 'a_1', key: {a: 1}, unique: true}" ) ) {
+            options.partitionKey = "ts";
+            options.partitionSpanSecs = kSpanSecs;
+
+            MyOperationContext txn( &engine );
+            for ( int i = 0; i < 3; i++ ) {
+                KVPartition partition;
+                partition.number = i;
+                partition.start = Date_t( ( i - 1 ) * kHour );
+                partition.ident = str::stream() << "collection-" << i;
+                const std::string indexIdent = str::stream() << "index-" << i;
+                partition.idxIdent = BSON( "a_1" << indexIdent );
+                ASSERT_OK( engine.createRecordStore( &txn, "a.b", partition.ident, options ) );
+                ASSERT_OK( engine.createSortedDataInterface(
+                               &txn, partition.idxIdent["a_1"].String(), &desc ) );
+                partitions.push_back( partition );
+            }
+
+            rs.reset( new PartitionedRecordStore( &txn, &engine, "a.b", options, partitions ) );
+            index.reset( new PartitionedSortedDataInterface( &engine, &desc, rs->layout() ) );
+        }
+
+        RecordId insert( const BSONObj& doc ) {
+            MyOperationContext txn( &engine );
+            WriteUnitOfWork uow( &txn );
+            StatusWith<RecordId> loc = rs->insertRecord( &txn, doc.objdata(), doc.objsize(),
+                                                         false );
+            ASSERT_OK( loc.getStatus() );
+            ASSERT_OK( index->insert( &txn, BSON( "" << doc["a"] ), loc.getValue(), false ) );
+            uow.commit();
+            return loc.getValue();
+        }
+
+        InMemoryEngine engine;
+        CollectionOptions options;
+        IndexDescriptor desc;
+        std::vector<KVPartition> partitions;
+        scoped_ptr<PartitionedRecordStore> rs;
+        scoped_ptr<PartitionedSortedDataInterface> index;
+    };
+
+    BSONObj doc( int a, long long millis ) {
+        return BSON( "a" << a << "ts" << Date_t( millis ) );
+    }
+
+    TEST( PartitionedRecordStore, InsertRoutesByKey ) {
+        PartitionedFixture f;
+        const RecordId first = f.insert( doc( 1, 10 ) );
+        const RecordId second = f.insert( doc( 2, kHour + 10 ) );
+        const RecordId later = f.insert( doc( 3, 5 * kHour ) );
+        const RecordId missing = f.insert( BSON( "a" << 4 ) );
+
+        ASSERT_EQUALS( 1, KVPartitionLayout::numberOf( first ) );
+        ASSERT_EQUALS( 2, KVPartitionLayout::numberOf( second ) );
+        ASSERT_EQUALS( 0, KVPartitionLayout::numberOf( later ) );
+        ASSERT_EQUALS( 0, KVPartitionLayout::numberOf( missing ) );
+
+        MyOperationContext txn( &f.engine );
+        ASSERT_EQUALS( 4, f.rs->numRecords( &txn ) );
+        ASSERT_EQUALS( 2, f.rs->dataFor( &txn, second ).toBson()["a"].numberInt() );
+
+        // A forward scan goes through the partitions in number order.
+        std::vector<RecordId> seen;
+        scoped_ptr<RecordIterator> it( f.rs->getIterator( &txn ) );
+        while ( !it->isEOF() ) {
+            seen.push_back( it->getNext() );
+        }
+        ASSERT_EQUALS( 4U, seen.size() );
+        ASSERT( seen[0] == later );
+        ASSERT( seen[1] == missing );
+        ASSERT( seen[2] == first );
+        ASSERT( seen[3] == second );
+
+        // Starting from a record skips the partitions before its own.
+        it.reset( f.rs->getIterator( &txn, first ) );
+        ASSERT( it->getNext() == first );
+        ASSERT( it->getNext() == second );
+        ASSERT( it->isEOF() );
+    }
+
+    TEST( PartitionedRecordStore, UpdateMovesAcrossPartitions ) {
+        PartitionedFixture f;
+        const RecordId loc = f.insert( doc( 1, 10 ) );
+
+        MyOperationContext txn( &f.engine );
+        WriteUnitOfWork uow( &txn );
+        CountingNotifier notifier;
+        const BSONObj same = doc( 1, 20 );
+        StatusWith<RecordId> res = f.rs->updateRecord( &txn, loc, same.objdata(), same.objsize(),
+                                                       false, &notifier );
+        ASSERT_OK( res.getStatus() );
+        ASSERT( res.getValue() == loc );
+        ASSERT_EQUALS( 0, notifier.moves );
+
+        const BSONObj moved = doc( 1, kHour + 20 );
+        res = f.rs->updateRecord( &txn, loc, moved.objdata(), moved.objsize(), false, &notifier );
+        ASSERT_OK( res.getStatus() );
+        ASSERT_EQUALS( 2, KVPartitionLayout::numberOf( res.getValue() ) );
+        ASSERT_EQUALS( 1, notifier.moves );
+        uow.commit();
+
+        RecordData data;
+        ASSERT_FALSE( f.rs->findRecord( &txn, loc, &data ) );
+        ASSERT_EQUALS( 1, f.rs->numRecords( &txn ) );
+    }
+
+    TEST( PartitionedRecordStore, IndexMergesPartitions ) {
+        PartitionedFixture f;
+        f.insert( doc( 3, 10 ) );
+        f.insert( doc( 1, kHour + 10 ) );
+        f.insert( BSON( "a" << 2 ) );
+
+        MyOperationContext txn( &f.engine );
+        ASSERT_EQUALS( 3, f.index->numEntries( &txn ) );
+
+        scoped_ptr<SortedDataInterface::Cursor> cursor( f.index->newCursor( &txn, 1 ) );
+        cursor->locate( BSON( "" << 0 ), RecordId::min() );
+        for ( int a = 1; a <= 3; a++ ) {
+            ASSERT_FALSE( cursor->isEOF() );
+            ASSERT_EQUALS( a, cursor->getKey().firstElement().numberInt() );
+            ASSERT_EQUALS( a, f.rs->dataFor( &txn, cursor->getRecordId() )
+                                  .toBson()["a"].numberInt() );
+            cursor->advance();
+        }
+        ASSERT( cursor->isEOF() );
+
+        cursor.reset( f.index->newCursor( &txn, -1 ) );
+        cursor->locate( BSON( "" << 10 ), RecordId::max() );
+        ASSERT_EQUALS( 3, cursor->getKey().firstElement().numberInt() );
+
+        // The index is unique across partitions.
+        const BSONObj dup = doc( 1, 10 );
+        WriteUnitOfWork uow( &txn );
+        StatusWith<RecordId> loc = f.rs->insertRecord( &txn, dup.objdata(), dup.objsize(), false );
+        ASSERT_OK( loc.getStatus() );
+        ASSERT_EQUALS( ErrorCodes::DuplicateKey,
+                       f.index->insert( &txn, BSON( "" << 1 ), loc.getValue(), false ).code() );
+    }
+
+    TEST( PartitionedRecordStore, SetPartitionsRollsBack ) {
+        PartitionedFixture f;
+        const RecordId loc = f.insert( doc( 1, kHour + 10 ) );
+
+        MyOperationContext txn( &f.engine );
+        {
+            WriteUnitOfWork uow( &txn );
+            std::vector<KVPartition> fewer( f.partitions.begin(), f.partitions.begin() + 2 );
+            f.rs->setPartitions( &txn, fewer );
+            ASSERT_EQUALS( 0, f.rs->numRecords( &txn ) );
+            ASSERT_EQUALS( 0, f.index->numEntries( &txn ) );
+            ASSERT_EQUALS( 0, f.rs->layout()->partitionFor( doc( 1, kHour + 10 ) ) );
+        }
+
+        ASSERT_EQUALS( 1, f.rs->numRecords( &txn ) );
+        ASSERT_EQUALS( 1, f.index->numEntries( &txn ) );
+        ASSERT_EQUALS( 1, f.rs->dataFor( &txn, loc ).toBson()["a"].numberInt() );
+    }
+
+    TEST( KVPartitionLayout, RangeStartFor ) {
+        KVPartitionLayout layout( "ts", kSpanSecs );
+        ASSERT_EQUALS( 0LL, layout.rangeStartFor( Date_t( 0 ) ).asInt64() );
+        ASSERT_EQUALS( 0LL, layout.rangeStartFor( Date_t( kHour - 1 ) ).asInt64() );
+        ASSERT_EQUALS( 2 * kHour, layout.rangeStartFor( Date_t( 2 * kHour + 5 ) ).asInt64() );
+        ASSERT_EQUALS( -kHour, layout.rangeStartFor( Date_t( -1LL ) ).asInt64() );
+    }
+
+}
+
+}
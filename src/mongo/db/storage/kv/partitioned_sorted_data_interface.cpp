@@ -0,0 +1,485 @@
+// partitioned_sorted_data_interface.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/kv/partitioned_sorted_data_interface.h"
+
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/storage/kv/kv_engine.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+namespace {
+
+    typedef PartitionedSortedDataInterface::Children Children;
+
+    Status dupKeyError( const BSONObj& key ) {
+        StringBuilder sb;
+        sb << "E11000 duplicate key error ";
+        sb << "dup key: " << key;
+        return Status( ErrorCodes::DuplicateKey, sb.str() );
+    }
+
+    /**
+     * Hands each key to the bulk builder of the partition of its record. The keys come sorted,
+     * so a key equal to the one before is a duplicate whichever partitions they are in.
+     */
+    class PartitionedBulkBuilder : public SortedDataBuilderInterface {
+    public:
+        PartitionedBulkBuilder( OperationContext* txn,
+                                const boost::shared_ptr<const Children>& children,
+                                bool dupsAllowed,
+                                const Ordering& ordering )
+            : _txn( txn ),
+              _children( children ),
+              _dupsAllowed( dupsAllowed ),
+              _ordering( ordering ) {}
+
+        virtual Status addKey( const BSONObj& key, const RecordId& loc ) {
+            if ( !_dupsAllowed && !_lastKey.isEmpty() &&
+                 key.woCompare( _lastKey, _ordering, false ) == 0 ) {
+                return dupKeyError( key );
+            }
+
+            const int number = KVPartitionLayout::numberOf( loc );
+            boost::shared_ptr<SortedDataBuilderInterface>& builder = _builders[number];
+            if ( !builder ) {
+                Children::const_iterator it = _children->find( number );
+                invariant( it != _children->end() );
+                builder.reset( it->second->getBulkBuilder( _txn, _dupsAllowed ) );
+            }
+
+            Status status = builder->addKey( key, KVPartitionLayout::toChild( loc ) );
+            if ( !status.isOK() )
+                return status;
+            _lastKey = key.getOwned();
+            return Status::OK();
+        }
+
+        virtual void commit( bool mayInterrupt ) {
+            for ( Builders::const_iterator it = _builders.begin(); it != _builders.end(); ++it ) {
+                it->second->commit( mayInterrupt );
+            }
+        }
+
+    private:
+        typedef std::map<int, boost::shared_ptr<SortedDataBuilderInterface> > Builders;
+
+        OperationContext* const _txn;
+        const boost::shared_ptr<const Children> _children;
+        const bool _dupsAllowed;
+        const Ordering _ordering;
+        Builders _builders;
+        BSONObj _lastKey;
+    };
+
+    /**
+     * Merges cursors over the index of every partition, returning the smallest of their keys,
+     * or the largest going backward. Equal keys come in RecordId order, which is partition
+     * order.
+     */
+    class PartitionedCursor : public SortedDataInterface::Cursor {
+    public:
+        PartitionedCursor( OperationContext* txn,
+                           const boost::shared_ptr<const Children>& children,
+                           int direction,
+                           const Ordering& ordering )
+            : _index( children ), _direction( direction ), _ordering( ordering ), _current( -1 ) {
+            for ( Children::const_iterator it = children->begin(); it != children->end(); ++it ) {
+                Child child;
+                child.number = it->first;
+                child.cursor.reset( it->second->newCursor( txn, direction ) );
+                _children.push_back( child );
+            }
+            _refreshAll();
+        }
+
+        virtual int getDirection() const { return _direction; }
+
+        virtual bool isEOF() const { return _current < 0; }
+
+        virtual bool pointsToSamePlaceAs( const SortedDataInterface::Cursor& otherBase ) const {
+            const PartitionedCursor& other = static_cast<const PartitionedCursor&>( otherBase );
+            if ( isEOF() || other.isEOF() )
+                return isEOF() && other.isEOF();
+            return getRecordId() == other.getRecordId() && getKey().binaryEqual( other.getKey() );
+        }
+
+        virtual void aboutToDeleteBucket( const RecordId& bucket ) {
+            for ( size_t i = 0; i < _children.size(); i++ ) {
+                _children[i].cursor->aboutToDeleteBucket( bucket );
+            }
+        }
+
+        virtual bool locate( const BSONObj& key, const RecordId& loc ) {
+            // Entries with an equal key sort by RecordId, so those of the partitions before
+            // that of "loc" come first and those of the partitions after it come last.
+            const int number = KVPartitionLayout::numberOf( loc );
+            bool found = false;
+            for ( size_t i = 0; i < _children.size(); i++ ) {
+                Child& child = _children[i];
+                RecordId childLoc;
+                if ( !loc.isNormal() || child.number == number )
+                    childLoc = KVPartitionLayout::toChild( loc );
+                else if ( child.number < number )
+                    childLoc = RecordId::max();
+                else
+                    childLoc = RecordId::min();
+                found = child.cursor->locate( key, childLoc ) || found;
+            }
+            _refreshAll();
+            return found;
+        }
+
+        virtual void advanceTo( const BSONObj& keyPrefix,
+                                int prefixLen,
+                                bool prefixExclusive,
+                                const vector<const BSONElement*>& keySuffix,
+                                const vector<bool>& suffixInclusive ) {
+            for ( size_t i = 0; i < _children.size(); i++ ) {
+                _children[i].cursor->advanceTo( keyPrefix, prefixLen, prefixExclusive,
+                                                keySuffix, suffixInclusive );
+            }
+            _refreshAll();
+        }
+
+        virtual void customLocate( const BSONObj& keyPrefix,
+                                   int prefixLen,
+                                   bool prefixExclusive,
+                                   const vector<const BSONElement*>& keySuffix,
+                                   const vector<bool>& suffixInclusive ) {
+            for ( size_t i = 0; i < _children.size(); i++ ) {
+                _children[i].cursor->customLocate( keyPrefix, prefixLen, prefixExclusive,
+                                                   keySuffix, suffixInclusive );
+            }
+            _refreshAll();
+        }
+
+        virtual BSONObj getKey() const {
+            invariant( !isEOF() );
+            return _children[_current].key;
+        }
+
+        virtual RecordId getRecordId() const {
+            invariant( !isEOF() );
+            const Child& child = _children[_current];
+            return KVPartitionLayout::fromChild( child.number, child.loc );
+        }
+
+        virtual void advance() {
+            if ( isEOF() )
+                return;
+            _children[_current].cursor->advance();
+            _refresh( &_children[_current] );
+            _pick();
+        }
+
+        virtual void savePosition() {
+            for ( size_t i = 0; i < _children.size(); i++ ) {
+                _children[i].cursor->savePosition();
+            }
+        }
+
+        virtual void restorePosition( OperationContext* txn ) {
+            for ( size_t i = 0; i < _children.size(); i++ ) {
+                _children[i].cursor->restorePosition( txn );
+            }
+            _refreshAll();
+        }
+
+    private:
+        struct Child {
+            int number;
+            boost::shared_ptr<SortedDataInterface::Cursor> cursor;
+
+            // Where the cursor is, unless it is at EOF.
+            BSONObj key;
+            RecordId loc;
+        };
+
+        void _refresh( Child* child ) {
+            if ( child->cursor->isEOF() ) {
+                child->key = BSONObj();
+                return;
+            }
+            child->key = child->cursor->getKey().getOwned();
+            child->loc = child->cursor->getRecordId();
+        }
+
+        void _refreshAll() {
+            for ( size_t i = 0; i < _children.size(); i++ ) {
+                _refresh( &_children[i] );
+            }
+            _pick();
+        }
+
+        void _pick() {
+            _current = -1;
+            for ( size_t i = 0; i < _children.size(); i++ ) {
+                const Child& child = _children[i];
+                if ( child.cursor->isEOF() )
+                    continue;
+                if ( _current < 0 || _compare( child, _children[_current] ) < 0 )
+                    _current = i;
+            }
+        }
+
+        /**
+         * Compares the positions of two children in the direction of the cursor.
+         */
+        int _compare( const Child& a, const Child& b ) const {
+            int cmp = a.key.woCompare( b.key, _ordering, false );
+            if ( cmp == 0 )
+                cmp = a.number < b.number ? -1 : a.number > b.number ? 1 : 0;
+            return cmp * _direction;
+        }
+
+        // Keeps the indexes of the partitions open.
+        const boost::shared_ptr<const Children> _index;
+        const int _direction;
+        const Ordering _ordering;
+        std::vector<Child> _children;
+        int _current;
+    };
+
+}
+
+    PartitionedSortedDataInterface::PartitionedSortedDataInterface(
+            KVEngine* engine,
+            const IndexDescriptor* desc,
+            const boost::shared_ptr<const KVPartitionLayout>& layout )
+        : _engine( engine ),
+          _desc( desc ),
+          _ordering( Ordering::make( desc->keyPattern() ) ),
+          _layout( layout ),
+          _syncedVersion( 0 ) {
+    }
+
+    PartitionedSortedDataInterface::ChildrenPtr PartitionedSortedDataInterface::_sync(
+            OperationContext* txn ) const {
+        boost::mutex::scoped_lock lk( _mutex );
+        if ( _children && _syncedVersion == _layout->version() )
+            return _children;
+
+        // A number can come back with another ident once the partition it had is rolled back.
+        boost::shared_ptr<Children> children( new Children() );
+        IdentMap byIdent;
+        const std::vector<KVPartition>& partitions = _layout->partitions();
+        for ( size_t i = 0; i < partitions.size(); i++ ) {
+            BSONElement e = partitions[i].idxIdent[_desc->indexName()];
+            if ( e.type() != String )
+                continue; // the index is being dropped
+            const std::string ident = e.String();
+
+            boost::shared_ptr<SortedDataInterface>& child = byIdent[ident];
+            IdentMap::const_iterator it = _byIdent.find( ident );
+            if ( it != _byIdent.end() )
+                child = it->second;
+            else
+                child.reset( _engine->getSortedDataInterface( txn, ident, _desc ) );
+            (*children)[partitions[i].number] = child;
+        }
+
+        _children = children;
+        _byIdent.swap( byIdent );
+        _syncedVersion = _layout->version();
+        return _children;
+    }
+
+    SortedDataBuilderInterface* PartitionedSortedDataInterface::getBulkBuilder(
+            OperationContext* txn,
+            bool dupsAllowed ) {
+        return new PartitionedBulkBuilder( txn, _sync( txn ), dupsAllowed, _ordering );
+    }
+
+    Status PartitionedSortedDataInterface::insert( OperationContext* txn,
+                                                   const BSONObj& key,
+                                                   const RecordId& loc,
+                                                   bool dupsAllowed ) {
+        ChildrenPtr children = _sync( txn );
+        const int number = KVPartitionLayout::numberOf( loc );
+        if ( !dupsAllowed ) {
+            for ( Children::const_iterator it = children->begin(); it != children->end(); ++it ) {
+                if ( it->first == number )
+                    continue;
+                Status status = it->second->dupKeyCheck( txn, key, RecordId() );
+                if ( !status.isOK() )
+                    return status;
+            }
+        }
+
+        Children::const_iterator it = children->find( number );
+        invariant( it != children->end() );
+        return it->second->insert( txn, key, KVPartitionLayout::toChild( loc ), dupsAllowed );
+    }
+
+    void PartitionedSortedDataInterface::unindex( OperationContext* txn,
+                                                  const BSONObj& key,
+                                                  const RecordId& loc,
+                                                  bool dupsAllowed ) {
+        ChildrenPtr children = _sync( txn );
+        Children::const_iterator it = children->find( KVPartitionLayout::numberOf( loc ) );
+        if ( it == children->end() )
+            return; // dropped along with its partition
+        it->second->unindex( txn, key, KVPartitionLayout::toChild( loc ), dupsAllowed );
+    }
+
+    Status PartitionedSortedDataInterface::dupKeyCheck( OperationContext* txn,
+                                                        const BSONObj& key,
+                                                        const RecordId& loc ) {
+        ChildrenPtr children = _sync( txn );
+        const int number = KVPartitionLayout::numberOf( loc );
+        for ( Children::const_iterator it = children->begin(); it != children->end(); ++it ) {
+            const RecordId childLoc = it->first == number ? KVPartitionLayout::toChild( loc )
+                                                          : RecordId();
+            Status status = it->second->dupKeyCheck( txn, key, childLoc );
+            if ( !status.isOK() )
+                return status;
+        }
+        return Status::OK();
+    }
+
+    void PartitionedSortedDataInterface::fullValidate( OperationContext* txn,
+                                                       bool full,
+                                                       long long* numKeysOut,
+                                                       BSONObjBuilder* output ) const {
+        ChildrenPtr children = _sync( txn );
+        long long numKeys = 0;
+        for ( Children::const_iterator it = children->begin(); it != children->end(); ++it ) {
+            long long childKeys = 0;
+            it->second->fullValidate( txn, full, &childKeys, it->first == 0 ? output : NULL );
+            numKeys += childKeys;
+        }
+        if ( numKeysOut )
+            *numKeysOut = numKeys;
+    }
+
+    long long PartitionedSortedDataInterface::getSpaceUsedBytes( OperationContext* txn ) const {
+        ChildrenPtr children = _sync( txn );
+        long long size = 0;
+        for ( Children::const_iterator it = children->begin(); it != children->end(); ++it ) {
+            size += it->second->getSpaceUsedBytes( txn );
+        }
+        return size;
+    }
+
+    bool PartitionedSortedDataInterface::appendCacheStats( OperationContext* txn,
+                                                           BSONObjBuilder* result,
+                                                           double scale ) const {
+        ChildrenPtr children = _sync( txn );
+        Children::const_iterator it = children->find( 0 );
+        return it != children->end() && it->second->appendCacheStats( txn, result, scale );
+    }
+
+    bool PartitionedSortedDataInterface::isEmpty( OperationContext* txn ) {
+        ChildrenPtr children = _sync( txn );
+        for ( Children::const_iterator it = children->begin(); it != children->end(); ++it ) {
+            if ( !it->second->isEmpty( txn ) )
+                return false;
+        }
+        return true;
+    }
+
+    Status PartitionedSortedDataInterface::touch( OperationContext* txn ) const {
+        ChildrenPtr children = _sync( txn );
+        for ( Children::const_iterator it = children->begin(); it != children->end(); ++it ) {
+            Status status = it->second->touch( txn );
+            if ( !status.isOK() )
+                return status;
+        }
+        return Status::OK();
+    }
+
+    long long PartitionedSortedDataInterface::numEntries( OperationContext* txn ) const {
+        ChildrenPtr children = _sync( txn );
+        long long num = 0;
+        for ( Children::const_iterator it = children->begin(); it != children->end(); ++it ) {
+            num += it->second->numEntries( txn );
+        }
+        return num;
+    }
+
+    bool PartitionedSortedDataInterface::estimateNumEntriesInRange(
+            OperationContext* txn,
+            const BSONObj& startKey,
+            bool startKeyInclusive,
+            const BSONObj& endKey,
+            bool endKeyInclusive,
+            long long* numEntriesOut ) const {
+        ChildrenPtr children = _sync( txn );
+        long long num = 0;
+        for ( Children::const_iterator it = children->begin(); it != children->end(); ++it ) {
+            long long childEntries = 0;
+            if ( !it->second->estimateNumEntriesInRange( txn, startKey, startKeyInclusive,
+                                                         endKey, endKeyInclusive,
+                                                         &childEntries ) ) {
+                return false;
+            }
+            num += childEntries;
+        }
+        *numEntriesOut = num;
+        return true;
+    }
+
+    bool PartitionedSortedDataInterface::findExactKey( OperationContext* txn,
+                                                       const BSONObj& key,
+                                                       std::vector<RecordId>* locsOut ) const {
+        ChildrenPtr children = _sync( txn );
+        std::vector<RecordId> locs;
+        for ( Children::const_iterator it = children->begin(); it != children->end(); ++it ) {
+            std::vector<RecordId> childLocs;
+            if ( !it->second->findExactKey( txn, key, &childLocs ) )
+                return false;
+            for ( size_t i = 0; i < childLocs.size(); i++ ) {
+                locs.push_back( KVPartitionLayout::fromChild( it->first, childLocs[i] ) );
+            }
+        }
+        locsOut->insert( locsOut->end(), locs.begin(), locs.end() );
+        return true;
+    }
+
+    SortedDataInterface::Cursor* PartitionedSortedDataInterface::newCursor( OperationContext* txn,
+                                                                            int direction ) const {
+        return new PartitionedCursor( txn, _sync( txn ), direction, _ordering );
+    }
+
+    Status PartitionedSortedDataInterface::initAsEmpty( OperationContext* txn ) {
+        ChildrenPtr children = _sync( txn );
+        for ( Children::const_iterator it = children->begin(); it != children->end(); ++it ) {
+            Status status = it->second->initAsEmpty( txn );
+            if ( !status.isOK() )
+                return status;
+        }
+        return Status::OK();
+    }
+
+}
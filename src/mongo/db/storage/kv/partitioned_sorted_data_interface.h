@@ -0,0 +1,132 @@
+// partitioned_sorted_data_interface.h
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "mongo/bson/ordering.h"
+#include "mongo/db/storage/kv/kv_partition_layout.h"
+#include "mongo/db/storage/sorted_data_interface.h"
+
+namespace mongo {
+
+    class IndexDescriptor;
+    class KVEngine;
+
+    /**
+     * An index of a partitioned collection, kept as one index per partition. Cursors merge the
+     * keys of all of them, and a unique index checks every partition for duplicates.
+     */
+    class PartitionedSortedDataInterface : public SortedDataInterface {
+    public:
+        typedef std::map<int, boost::shared_ptr<SortedDataInterface> > Children;
+
+        PartitionedSortedDataInterface( KVEngine* engine,
+                                        const IndexDescriptor* desc,
+                                        const boost::shared_ptr<const KVPartitionLayout>& layout );
+
+        virtual SortedDataBuilderInterface* getBulkBuilder( OperationContext* txn,
+                                                            bool dupsAllowed );
+
+        virtual Status insert( OperationContext* txn,
+                               const BSONObj& key,
+                               const RecordId& loc,
+                               bool dupsAllowed );
+
+        virtual void unindex( OperationContext* txn,
+                              const BSONObj& key,
+                              const RecordId& loc,
+                              bool dupsAllowed );
+
+        virtual Status dupKeyCheck( OperationContext* txn,
+                                    const BSONObj& key,
+                                    const RecordId& loc );
+
+        virtual void fullValidate( OperationContext* txn,
+                                   bool full,
+                                   long long* numKeysOut,
+                                   BSONObjBuilder* output ) const;
+
+        virtual long long getSpaceUsedBytes( OperationContext* txn ) const;
+
+        virtual bool appendCacheStats( OperationContext* txn,
+                                       BSONObjBuilder* result,
+                                       double scale ) const;
+
+        virtual bool isEmpty( OperationContext* txn );
+
+        virtual Status touch( OperationContext* txn ) const;
+
+        virtual long long numEntries( OperationContext* txn ) const;
+
+        virtual bool estimateNumEntriesInRange( OperationContext* txn,
+                                                const BSONObj& startKey,
+                                                bool startKeyInclusive,
+                                                const BSONObj& endKey,
+                                                bool endKeyInclusive,
+                                                long long* numEntriesOut ) const;
+
+        virtual bool findExactKey( OperationContext* txn,
+                                   const BSONObj& key,
+                                   std::vector<RecordId>* locsOut ) const;
+
+        virtual Cursor* newCursor( OperationContext* txn, int direction ) const;
+
+        virtual Status initAsEmpty( OperationContext* txn );
+
+    private:
+        typedef boost::shared_ptr<const Children> ChildrenPtr;
+
+        /**
+         * Returns the indexes of the partitions, opening those of partitions added since the
+         * last call.
+         */
+        ChildrenPtr _sync( OperationContext* txn ) const;
+
+        KVEngine* const _engine; // not owned
+        const IndexDescriptor* const _desc; // not owned
+        const Ordering _ordering;
+        const boost::shared_ptr<const KVPartitionLayout> _layout;
+
+        typedef std::map<std::string, boost::shared_ptr<SortedDataInterface> > IdentMap;
+
+        // Guards _children, _byIdent and _syncedVersion.
+        mutable boost::mutex _mutex;
+        mutable ChildrenPtr _children;
+        mutable IdentMap _byIdent;
+        mutable unsigned long long _syncedVersion;
+    };
+
+}
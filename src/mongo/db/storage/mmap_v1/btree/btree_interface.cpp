@@ -59,7 +59,9 @@ namespace mongo {
                                 RecordStore* recordStore,
                                 const Ordering& ordering,
                                 const string& indexName,
-                                BucketDeletionNotification* bucketDeletionNotification) {
+                                int bulkFillFactor,
+                                BucketDeletionNotification* bucketDeletionNotification)
+            : _bulkFillFactor(bulkFillFactor) {
 
             _btree.reset(new BtreeLogic<OnDiskFormat>(headManager,
                                                       recordStore,
@@ -74,7 +76,7 @@ namespace mongo {
                                                            bool dupsAllowed) {
 
             return new BtreeBuilderInterfaceImpl<OnDiskFormat>(
-                txn, _btree->newBuilder(txn, dupsAllowed));
+                txn, _btree->newBuilder(txn, dupsAllowed, _bulkFillFactor));
         }
 
         virtual Status insert(OperationContext* txn,
@@ -116,6 +118,12 @@ namespace mongo {
             return _btree->touch(txn);
         }
 
+        virtual bool appendCacheStats(OperationContext* txn,
+                                      BSONObjBuilder* result,
+                                      double scale) const {
+            return _btree->getRecordStore()->appendCacheStats(txn, result, scale);
+        }
+
         class Cursor : public SortedDataInterface::Cursor {
         public:
             Cursor(OperationContext* txn,
@@ -244,6 +252,9 @@ namespace mongo {
 
     private:
         scoped_ptr<BtreeLogic<OnDiskFormat> > _btree;
+
+        // Percentage of each bucket the bulk builder fills.
+        const int _bulkFillFactor;
     };
 
     SortedDataInterface* getMMAPV1Interface(HeadManager* headManager,
@@ -251,6 +262,8 @@ namespace mongo {
                                             const Ordering& ordering,
                                             const string& indexName,
                                             int version,
+                                            int bucketSize,
+                                            int bulkFillFactor,
                                             BucketDeletionNotification* bucketDeletion) {
 
         if (0 == version) {
@@ -258,16 +271,43 @@ namespace mongo {
                                                          recordStore,
                                                          ordering,
                                                          indexName,
+                                                         bulkFillFactor,
                                                          bucketDeletion);
         }
-        else {
-            invariant(1 == version);
+        else if (1 == version) {
             return new BtreeInterfaceImpl<BtreeLayoutV1>(headManager,
                                                          recordStore,
                                                          ordering,
                                                          indexName,
+                                                         bulkFillFactor,
                                                          bucketDeletion);
         }
+
+        invariant(2 == version);
+        switch (bucketSize) {
+        case 16 * 1024:
+            return new BtreeInterfaceImpl<BtreeLayoutV2<16 * 1024> >(headManager,
+                                                                     recordStore,
+                                                                     ordering,
+                                                                     indexName,
+                                                                     bulkFillFactor,
+                                                                     bucketDeletion);
+        case 64 * 1024:
+            return new BtreeInterfaceImpl<BtreeLayoutV2<64 * 1024> >(headManager,
+                                                                     recordStore,
+                                                                     ordering,
+                                                                     indexName,
+                                                                     bulkFillFactor,
+                                                                     bucketDeletion);
+        default:
+            invariant(32 * 1024 == bucketSize);
+            return new BtreeInterfaceImpl<BtreeLayoutV2<32 * 1024> >(headManager,
+                                                                     recordStore,
+                                                                     ordering,
+                                                                     indexName,
+                                                                     bulkFillFactor,
+                                                                     bucketDeletion);
+        }
     }
 
 }  // namespace mongo
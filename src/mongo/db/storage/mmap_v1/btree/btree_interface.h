@@ -45,6 +45,8 @@ namespace mongo {
                                             const Ordering& ordering,
                                             const string& indexName,
                                             int version,
+                                            int bucketSize,
+                                            int bulkFillFactor,
                                             BucketDeletionNotification* bucketDeletion);
 
 }  // namespace mongo
@@ -48,6 +48,8 @@ namespace mongo {
                                                                       _order,
                                                                       "a_1",
                                                                       1,
+                                                                      0,
+                                                                      100,
                                                                       &_deletionNotification ) );
             OperationContextNoop op;
             massertStatusOK( sorted->initAsEmpty( &op ) );
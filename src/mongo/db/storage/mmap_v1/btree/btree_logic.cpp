@@ -61,18 +61,22 @@ namespace mongo {
 
     template <class BtreeLayout>
     typename BtreeLogic<BtreeLayout>::Builder*
-    BtreeLogic<BtreeLayout>::newBuilder(OperationContext* txn, bool dupsAllowed) {
-        return new Builder(this, txn, dupsAllowed);
+    BtreeLogic<BtreeLayout>::newBuilder(OperationContext* txn, bool dupsAllowed, int fillFactor) {
+        return new Builder(this, txn, dupsAllowed, fillFactor);
     }
 
     template <class BtreeLayout>
     BtreeLogic<BtreeLayout>::Builder::Builder(BtreeLogic* logic,
                                               OperationContext* txn,
-                                              bool dupsAllowed)
+                                              bool dupsAllowed,
+                                              int fillFactor)
         : _logic(logic),
           _dupsAllowed(dupsAllowed),
+          _fillLimit(BtreeLayout::BucketBodySize * fillFactor / 100),
           _txn(txn) {
 
+        invariant(fillFactor > 0 && fillFactor <= 100);
+
         // The normal bulk building path calls initAsEmpty, so we already have an empty root bucket.
         // This isn't the case in some unit tests that use the Builder directly rather than going
         // through an IndexAccessMethod.
@@ -129,7 +133,7 @@ namespace mongo {
         }
         
         BucketType* rightLeaf = _getModifiableBucket(_rightLeafLoc);
-        if (!_logic->pushBack(rightLeaf, loc, *key, DiskLoc())) {
+        if (!_pushBack(rightLeaf, loc, *key, DiskLoc())) {
             // bucket was full, so split and try with the new node.
             _txn->recoveryUnit()->registerChange(new SetRightLeafLocChange(this, _rightLeafLoc));
             _rightLeafLoc = newBucket(rightLeaf, _rightLeafLoc);
@@ -174,7 +178,7 @@ namespace mongo {
         KeyDataType key;
         DiskLoc val;
         _logic->popBack(leftSib, &val, &key);
-        if (!_logic->pushBack(parent, val, key, leftSibLoc)) {
+        if (!_pushBack(parent, val, key, leftSibLoc)) {
             // parent is full, so split it.
             parentLoc = newBucket(parent, parentLoc);
             parent = _getModifiableBucket(parentLoc);
@@ -191,6 +195,19 @@ namespace mongo {
         return newBucketLoc;
     }
 
+    template <class BtreeLayout>
+    bool BtreeLogic<BtreeLayout>::Builder::_pushBack(BucketType* bucket,
+                                                     const DiskLoc recordLoc,
+                                                     const KeyDataType& key,
+                                                     const DiskLoc prevChild) {
+        const int used = BtreeLayout::BucketBodySize - bucket->emptySize;
+        const int bytesNeeded = key.dataSize() + sizeof(KeyHeaderType);
+        if (bucket->n >= 2 && used + bytesNeeded > _fillLimit) {
+            return false;
+        }
+        return _logic->pushBack(bucket, recordLoc, key, prevChild);
+    }
+
     template <class BtreeLayout>
     typename BtreeLogic<BtreeLayout>::BucketType*
     BtreeLogic<BtreeLayout>::Builder::_getModifiableBucket(DiskLoc loc) {
@@ -241,7 +258,7 @@ namespace mongo {
     }
 
     template <class BtreeLayout>
-    char* BtreeLogic<BtreeLayout>::dataAt(BucketType* bucket, short ofs) {
+    char* BtreeLogic<BtreeLayout>::dataAt(BucketType* bucket, int ofs) {
         return bucket->data + ofs;
     }
 
@@ -400,8 +417,8 @@ namespace mongo {
         KeyHeaderType& kn = getKeyHeader(bucket, bucket->n++);
         kn.prevChildBucket = prevChild;
         kn.recordLoc = recordLoc;
-        kn.setKeyDataOfs((short)_alloc(bucket, key.dataSize()));
-        short ofs = kn.keyDataOfs();
+        kn.setKeyDataOfs(_alloc(bucket, key.dataSize()));
+        int ofs = kn.keyDataOfs();
         char *p = dataAt(bucket, ofs);
         memcpy(p, key.data(), key.dataSize());
         return true;
@@ -426,7 +443,8 @@ namespace mongo {
                                               int& keypos,
                                               const KeyDataType& key,
                                               const DiskLoc recordLoc) {
-        invariant(bucket->n < 1024);
+        invariant(bucket->n < BtreeLayout::BucketBodySize /
+                              static_cast<int>(sizeof(KeyHeaderType)));
         invariant(keypos >= 0 && keypos <= bucket->n);
 
         int bytesNeeded = key.dataSize() + sizeof(KeyHeaderType);
@@ -463,7 +481,7 @@ namespace mongo {
         KeyHeaderType& kn = getKeyHeader(bucket, keypos);
         kn.prevChildBucket.Null();
         kn.recordLoc = recordLoc;
-        kn.setKeyDataOfs((short) _alloc(bucket, key.dataSize()));
+        kn.setKeyDataOfs(_alloc(bucket, key.dataSize()));
         char *p = dataAt(bucket, kn.keyDataOfs());
         txn->recoveryUnit()->writingPtr(p, key.dataSize());
         memcpy(p, key.data(), key.dataSize());
@@ -547,7 +565,7 @@ namespace mongo {
                 getKeyHeader(bucket, i) = getKeyHeader(bucket, j);
             }
 
-            short ofsold = getKeyHeader(bucket, i).keyDataOfs();
+            int ofsold = getKeyHeader(bucket, i).keyDataOfs();
             int sz = getFullKey(bucket, i).data.dataSize();
             ofs -= sz;
             bucket->topSize += sz;
@@ -645,7 +663,7 @@ namespace mongo {
         KeyHeaderType &kn = getKeyHeader(bucket, i);
         kn.recordLoc = recordLoc;
         kn.prevChildBucket = prevChildBucket;
-        short ofs = (short) _alloc(bucket, key.dataSize());
+        int ofs = _alloc(bucket, key.dataSize());
         kn.setKeyDataOfs(ofs);
         char *p = dataAt(bucket, ofs);
         memcpy(p, key.data(), key.dataSize());
@@ -2529,4 +2547,9 @@ namespace mongo {
     template struct FixedWidthKey<DiskLoc56Bit>;
     template class BtreeLogic<BtreeLayoutV1>;
 
+    // V2 format, in each of the bucket sizes an index may be created with.
+    template class BtreeLogic<BtreeLayoutV2<16 * 1024> >;
+    template class BtreeLogic<BtreeLayoutV2<32 * 1024> >;
+    template class BtreeLogic<BtreeLayoutV2<64 * 1024> >;
+
 }  // namespace mongo
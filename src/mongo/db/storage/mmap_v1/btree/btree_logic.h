@@ -104,7 +104,17 @@ namespace mongo {
 
             class SetRightLeafLocChange;
 
-            Builder(BtreeLogic* logic, OperationContext* txn, bool dupsAllowed);
+            Builder(BtreeLogic* logic, OperationContext* txn, bool dupsAllowed, int fillFactor);
+
+            /**
+             * Appends a key to the right end of 'bucket' unless that would fill more of it than
+             * the fill factor allows.  A bucket always takes at least two keys, so that it can be
+             * split.
+             */
+            bool _pushBack(BucketType* bucket,
+                           const DiskLoc recordLoc,
+                           const KeyDataType& key,
+                           const DiskLoc prevChild);
 
             /**
              * Creates and returns a new empty bucket to the right of leftSib, maintaining the
@@ -121,6 +131,9 @@ namespace mongo {
 
             DiskLoc _rightLeafLoc; // DiskLoc of right-most (highest) leaf bucket.
             bool _dupsAllowed;
+
+            // How many bytes of a bucket's body may be used before starting the next bucket.
+            const int _fillLimit;
             auto_ptr<KeyDataOwnedType> _keyLast;
 
             // Not owned.
@@ -130,8 +143,10 @@ namespace mongo {
         /**
          * Caller owns the returned pointer.
          * 'this' must outlive the returned pointer.
+         *
+         * The builder fills each bucket up to 'fillFactor' percent of its body.
          */
-        Builder* newBuilder(OperationContext* txn, bool dupsAllowed);
+        Builder* newBuilder(OperationContext* txn, bool dupsAllowed, int fillFactor);
 
         Status dupKeyCheck(OperationContext* txn,
                            const BSONObj& key,
@@ -283,7 +298,7 @@ namespace mongo {
 
         static const KeyHeaderType& getKeyHeader(const BucketType* bucket, int i);
 
-        static char* dataAt(BucketType* bucket, short ofs);
+        static char* dataAt(BucketType* bucket, int ofs);
 
         static void markUnused(BucketType* bucket, int keypos);
 
@@ -2219,6 +2219,131 @@ namespace mongo {
     // TEST SUITE DEFINITION
     //
 
+    /**
+     * Fills three quarters of a single bucket, so that in the larger bucket sizes the keys are
+     * stored past the 32KB offset.
+     */
+    template<class OnDiskFormat>
+    class FillOneBucket : public BtreeLogicTestBase<OnDiskFormat> {
+    public:
+        void run() {
+            OperationContextNoop txn;
+            this->_helper.btree.initAsEmpty(&txn);
+
+            typedef typename BtreeLogicTestBase<OnDiskFormat>::KeyDataOwnedType KeyDataOwnedType;
+            typedef typename OnDiskFormat::FixedWidthKeyType FixedWidthKeyType;
+
+            vector<BSONObj> keys;
+            int size = 0;
+            while (size < OnDiskFormat::BucketBodySize * 3 / 4) {
+                BSONObj key = BSON("a" << bigNumString(keys.size(), 100));
+                size += KeyDataOwnedType(key).dataSize() + sizeof(FixedWidthKeyType);
+                keys.push_back(key);
+            }
+
+            // Insert in reverse so that every key goes in at the front of the bucket.
+            for (int i = keys.size() - 1; i >= 0; --i) {
+                ASSERT_OK(this->insert(keys[i], this->_helper.dummyDiskLoc));
+            }
+
+            this->checkValidNumKeys(keys.size());
+            ASSERT_EQUALS(static_cast<int>(keys.size()), this->head()->n);
+            ASSERT(this->head()->nextChild.isNull());
+
+            const RecordId headLoc = this->_helper.headManager.getHead(&txn);
+            for (size_t i = 0; i < keys.size(); ++i) {
+                this->locate(keys[i], i, true, headLoc, 1);
+            }
+        }
+    };
+
+    /**
+     * Grows a tree of many buckets out of keys of different lengths inserted in no particular
+     * order, then removes them all again.  Unlike most of the tests above, this does not depend on
+     * how many keys fit in a bucket, so it runs against every bucket size.
+     */
+    template<class OnDiskFormat>
+    class GrowAndShrink : public BtreeLogicTestBase<OnDiskFormat> {
+    public:
+        void run() {
+            OperationContextNoop txn;
+            this->_helper.btree.initAsEmpty(&txn);
+
+            // About 20 buckets worth of keys, and a prime stride to shuffle them.
+            const int nKeys = 20 * OnDiskFormat::BucketSize / 150;
+            const int stride = 7919;
+
+            for (int i = 0; i < nKeys; ++i) {
+                ASSERT_OK(this->insert(key((i * stride) % nKeys), this->_helper.dummyDiskLoc));
+            }
+            this->checkValidNumKeys(nKeys);
+            ASSERT_FALSE(this->head()->nextChild.isNull());
+
+            for (int i = 0; i < nKeys; ++i) {
+                int pos;
+                DiskLoc loc;
+                ASSERT(this->_helper.btree.locate(&txn, key(i), this->_helper.dummyDiskLoc, 1,
+                                                  &pos, &loc));
+            }
+
+            for (int i = 0; i < nKeys; i += 2) {
+                ASSERT(this->unindex(key((i * stride) % nKeys)));
+            }
+            this->checkValidNumKeys(nKeys / 2);
+
+            for (int i = 1; i < nKeys; i += 2) {
+                ASSERT(this->unindex(key((i * stride) % nKeys)));
+            }
+            this->checkValidNumKeys(0);
+        }
+
+    private:
+        static BSONObj key(int i) {
+            return BSON("a" << bigNumString(i, 16 + (i % 7) * 40));
+        }
+    };
+
+    /**
+     * Bulk builds the same sorted keys into a full and a half full tree.  The half full one takes
+     * about twice as many buckets and both hold every key.
+     */
+    template<class OnDiskFormat>
+    class BuilderFillFactor : public BtreeLogicTestBase<OnDiskFormat> {
+    public:
+        void run() {
+            BtreeLogicTestHelper<OnDiskFormat> halfFull(BSON("a" << 1));
+
+            const int nKeys = 40 * OnDiskFormat::BucketSize / 150;
+            build(&this->_helper, nKeys, 100);
+            build(&halfFull, nKeys, 50);
+
+            const long long fullBuckets = this->_helper.recordStore.numRecords(NULL);
+            const long long halfFullBuckets = halfFull.recordStore.numRecords(NULL);
+            ASSERT_GREATER_THAN(halfFullBuckets, fullBuckets * 3 / 2);
+            ASSERT_LESS_THAN(halfFullBuckets, fullBuckets * 3);
+
+            // Inserting into the half full tree has room to spare before it splits.
+            OperationContextNoop txn;
+            ASSERT_OK(halfFull.btree.insert(&txn, BSON("a" << bigNumString(1, 100) + "x"),
+                                            halfFull.dummyDiskLoc, true));
+            ASSERT_EQUALS(halfFullBuckets, halfFull.recordStore.numRecords(NULL));
+        }
+
+    private:
+        static void build(BtreeLogicTestHelper<OnDiskFormat>* helper, int nKeys, int fillFactor) {
+            OperationContextNoop txn;
+            scoped_ptr<typename BtreeLogic<OnDiskFormat>::Builder> builder(
+                helper->btree.newBuilder(&txn, false, fillFactor));
+
+            for (int i = 0; i < nKeys; ++i) {
+                ASSERT_OK(builder->addKey(BSON("a" << bigNumString(i, 100)),
+                                          helper->dummyDiskLoc));
+            }
+
+            ASSERT_EQUALS(nKeys, helper->btree.fullValidate(&txn, NULL, true, false, 0));
+        }
+    };
+
     template<class OnDiskFormat>
     class BtreeLogicTestSuite : public unittest::Suite {
     public:
@@ -2313,13 +2438,48 @@ namespace mongo {
             add< LocateEmptyReverse<OnDiskFormat> >();
 
             add< DuplicateKeys<OnDiskFormat> >();
+
+            add< FillOneBucket<OnDiskFormat> >();
+            add< GrowAndShrink<OnDiskFormat> >();
+            add< BuilderFillFactor<OnDiskFormat> >();
+        }
+    };
+
+    /**
+     * Most of the tests above are built around how many keys fit in an 8KB bucket, so the larger
+     * V2 buckets only run the ones which do not depend on it.
+     */
+    template<class OnDiskFormat>
+    class BtreeLogicV2TestSuite : public unittest::Suite {
+    public:
+        BtreeLogicV2TestSuite(const std::string& name) : Suite(name) {
+
+        }
+
+        void setupTests() {
+            add< SimpleCreate<OnDiskFormat> >();
+            add< SimpleInsertDelete<OnDiskFormat> >();
+            add< MissingLocate<OnDiskFormat> >();
+            add< LocateEmptyForward<OnDiskFormat> >();
+            add< LocateEmptyReverse<OnDiskFormat> >();
+            add< DuplicateKeys<OnDiskFormat> >();
+
+            add< FillOneBucket<OnDiskFormat> >();
+            add< GrowAndShrink<OnDiskFormat> >();
+            add< BuilderFillFactor<OnDiskFormat> >();
         }
     };
 
-    // Test suite for both V0 and V1
+    // Test suite for V0, V1 and the smallest and largest V2 buckets
     static unittest::SuiteInstance< BtreeLogicTestSuite<BtreeLayoutV0> > SUITE_V0(
         "BTreeLogicTests_V0");
 
     static unittest::SuiteInstance< BtreeLogicTestSuite<BtreeLayoutV1> > SUITE_V1(
         "BTreeLogicTests_V1");
+
+    static unittest::SuiteInstance< BtreeLogicV2TestSuite<BtreeLayoutV2<16 * 1024> > >
+        SUITE_V2_16K("BTreeLogicTests_V2_16K");
+
+    static unittest::SuiteInstance< BtreeLogicV2TestSuite<BtreeLayoutV2<64 * 1024> > >
+        SUITE_V2_64K("BTreeLogicTests_V2_64K");
 }
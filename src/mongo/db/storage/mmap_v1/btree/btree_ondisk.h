@@ -75,16 +75,16 @@ namespace mongo {
         // Accessors / mutators
         //
 
-        short keyDataOfs() const {
-            return static_cast<short>(_kdo);
+        int keyDataOfs() const {
+            return _kdo;
         }
 
-        void setKeyDataOfs(short s) {
+        void setKeyDataOfs(int s) {
+            invariant(s >= 0 && s <= 0xffff);
             _kdo = s;
-            invariant(s>=0);
         }
 
-        void setKeyDataOfsSavingUse(short s) {
+        void setKeyDataOfsSavingUse(int s) {
             // XXX kill this func
             setKeyDataOfs(s);
         }
@@ -366,6 +366,34 @@ namespace mongo {
         static void initBucket(BucketType* bucket) { }
     };
 
+    /**
+     * The V2 format keeps the V1 keys and bucket layout in larger buckets.  FullBucketSize is what
+     * the index was created with, and must be at most 64KB so that the 16-bit offsets and sizes
+     * of the bucket header still reach every byte of the bucket.
+     */
+    template <int FullBucketSize>
+    struct BtreeLayoutV2 {
+        typedef FixedWidthKey<DiskLoc56Bit> FixedWidthKeyType;
+        typedef KeyV1 KeyType;
+        typedef KeyV1Owned KeyOwnedType;
+        typedef DiskLoc56Bit LocType;
+        typedef BtreeBucketV1 BucketType;
+
+        enum { BucketSize = FullBucketSize - 16,  // The -16 is to leave room for the Record header
+               BucketBodySize = BucketSize - BucketType::HeaderSize
+        };
+
+        BOOST_STATIC_ASSERT(FullBucketSize <= 64 * 1024);
+
+        // The same as for V1, so that the same keys fit either way.
+        static const int KeyMax = 1024;
+
+        // A sentinel value sometimes used to identify a deallocated bucket.
+        static const unsigned short INVALID_N_SENTINEL = 0xffff;
+
+        static void initBucket(BucketType* bucket) { }
+    };
+
 #pragma pack()
 
 }  // namespace mongo
@@ -244,4 +244,10 @@ namespace mongo {
     // V1 format.
     template struct BtreeLogicTestHelper<BtreeLayoutV1>;
     template class ArtificialTreeBuilder<BtreeLayoutV1>;
+
+    // V2 format.
+    template struct BtreeLogicTestHelper<BtreeLayoutV2<16 * 1024> >;
+    template class ArtificialTreeBuilder<BtreeLayoutV2<16 * 1024> >;
+    template struct BtreeLogicTestHelper<BtreeLayoutV2<64 * 1024> >;
+    template class ArtificialTreeBuilder<BtreeLayoutV2<64 * 1024> >;
 }
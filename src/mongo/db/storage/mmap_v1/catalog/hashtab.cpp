@@ -38,6 +38,80 @@
 
 namespace mongo {
 
+    /** Forgets a new namespace's node if the unit of work which added it rolls back. */
+    class NamespaceHashTable::NodeInsertion : public RecoveryUnit::Change {
+    public:
+        NodeInsertion(NamespaceHashTable* table, const std::string& ns)
+            : _table(table), _ns(ns) { }
+
+        virtual void commit() { }
+        virtual void rollback() {
+            _table->_nodeIndex.erase(_ns);
+        }
+
+    private:
+        NamespaceHashTable* const _table;
+        const std::string _ns;
+    };
+
+    /** Restores a killed namespace's node if the unit of work which killed it rolls back. */
+    class NamespaceHashTable::NodeRemoval : public RecoveryUnit::Change {
+    public:
+        NodeRemoval(NamespaceHashTable* table, const std::string& ns, int node)
+            : _table(table), _ns(ns), _node(node) { }
+
+        virtual void commit() { }
+        virtual void rollback() {
+            _table->_nodeIndex[_ns] = _node;
+        }
+
+    private:
+        NamespaceHashTable* const _table;
+        const std::string _ns;
+        const int _node;
+    };
+
+    void NamespaceHashTable::kill(OperationContext* txn, const Key& k) {
+        const std::string ns = k.toString();
+        NodeIndexMap::iterator it = _nodeIndex.find(ns);
+        if ( it == _nodeIndex.end() )
+            return;
+
+        const int i = it->second;
+        Node* n = txn->recoveryUnit()->writing(&nodes(i));
+        n->k.kill();
+        n->setUnused();
+
+        _nodeIndex.erase(it);
+        txn->recoveryUnit()->registerChange(new NodeRemoval(this, ns, i));
+    }
+
+    bool NamespaceHashTable::put(OperationContext* txn, const Key& k, const Type& value) {
+        const std::string ns = k.toString();
+        NodeIndexMap::const_iterator it = _nodeIndex.find(ns);
+        if ( it != _nodeIndex.end() ) {
+            Node* n = txn->recoveryUnit()->writing(&nodes(it->second));
+            verify( n->hash == k.hash() );
+            n->value = value;
+            return true;
+        }
+
+        bool found;
+        int i = _find(k, found);
+        if ( i < 0 )
+            return false;
+        verify( !found );
+
+        Node* n = txn->recoveryUnit()->writing( &nodes(i) );
+        n->k = k;
+        n->hash = k.hash();
+        n->value = value;
+
+        _nodeIndex[ns] = i;
+        txn->recoveryUnit()->registerChange(new NodeInsertion(this, ns));
+        return true;
+    }
+
     int NamespaceHashTable::_find(const Key& k, bool& found) {
         found = false;
         int h = k.hash();
@@ -91,5 +165,9 @@ namespace mongo {
             verify( sizeof(Node) == 628 );
         }
 
+        for ( int i = 0; i < n; i++ ) {
+            if ( nodes(i).inUse() )
+                _nodeIndex[nodes(i).k.toString()] = i;
+        }
     }
 }  // namespace mongo
@@ -40,6 +40,7 @@
 #include "mongo/db/storage/mmap_v1/catalog/namespace_details.h"
 #include "mongo/db/storage/mmap_v1/dur.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/platform/unordered_map.h"
 #include "mongo/stdx/functional.h"
 
 namespace mongo {
@@ -80,46 +81,32 @@ namespace mongo {
 
         int _find(const Key& k, bool& found);
 
+        class NodeInsertion;
+        class NodeRemoval;
+
+        /* The node of every namespace in use, built by scanning the table once when it is
+           opened, so that lookups never probe the mapped file.  The probe sequence is still
+           used to place new namespaces, which keeps the file readable by older versions.
+        */
+        typedef unordered_map<std::string, int> NodeIndexMap;
+        NodeIndexMap _nodeIndex;
+
     public:
         /* buf must be all zeroes on initialization. */
         NamespaceHashTable(void* buf, int buflen, const char *_name);
 
         Type* get(const Key& k) {
-            bool found;
-            int i = _find(k, found);
-            if ( found )
-                return &nodes(i).value;
-            return 0;
+            NodeIndexMap::const_iterator it = _nodeIndex.find(k.toString());
+            if ( it == _nodeIndex.end() )
+                return 0;
+            dassert( nodes(it->second).k == k );
+            return &nodes(it->second).value;
         }
 
-        void kill(OperationContext* txn, const Key& k) {
-            bool found;
-            int i = _find(k, found);
-            if ( i >= 0 && found ) {
-                Node* n = &nodes(i);
-                n = txn->recoveryUnit()->writing(n);
-                n->k.kill();
-                n->setUnused();
-            }
-        }
+        void kill(OperationContext* txn, const Key& k);
 
         /** returns false if too full */
-        bool put(OperationContext* txn, const Key& k, const Type& value) {
-            bool found;
-            int i = _find(k, found);
-            if ( i < 0 )
-                return false;
-            Node* n = txn->recoveryUnit()->writing( &nodes(i) );
-            if ( !found ) {
-                n->k = k;
-                n->hash = k.hash();
-            }
-            else {
-                verify( n->hash == k.hash() );
-            }
-            n->value = value;
-            return true;
-        }
+        bool put(OperationContext* txn, const Key& k, const Type& value);
 
         typedef stdx::function< void ( const Key& k , Type& v ) > IteratorCallback;
         void iterAll( IteratorCallback callback ) {
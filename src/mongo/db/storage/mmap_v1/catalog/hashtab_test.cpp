@@ -0,0 +1,119 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <vector>
+
+#include "mongo/db/operation_context_noop.h"
+#include "mongo/db/storage/mmap_v1/catalog/hashtab.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    namespace {
+        const int kBufLen = 1024 * 1024;
+
+        NamespaceDetails detailsWithStats(long long nrecords) {
+            NamespaceDetails details(DiskLoc(), false);
+            details.stats.nrecords = nrecords;
+            return details;
+        }
+
+        Namespace collection(int i) {
+            return Namespace(std::string(str::stream() << "db.c" << i));
+        }
+    }
+
+    TEST(NamespaceHashTableTest, PutGetKill) {
+        std::vector<char> buf(kBufLen, 0);
+        NamespaceHashTable table(&buf[0], kBufLen, "test");
+        OperationContextNoop txn;
+
+        ASSERT_EQUALS(static_cast<NamespaceDetails*>(NULL), table.get(Namespace("db.a")));
+
+        ASSERT(table.put(&txn, Namespace("db.a"), detailsWithStats(1)));
+        ASSERT(table.put(&txn, Namespace("db.b"), detailsWithStats(2)));
+        ASSERT_EQUALS(1, table.get(Namespace("db.a"))->stats.nrecords);
+        ASSERT_EQUALS(2, table.get(Namespace("db.b"))->stats.nrecords);
+
+        // Putting an existing namespace replaces its details in place.
+        NamespaceDetails* before = table.get(Namespace("db.a"));
+        ASSERT(table.put(&txn, Namespace("db.a"), detailsWithStats(3)));
+        ASSERT_EQUALS(before, table.get(Namespace("db.a")));
+        ASSERT_EQUALS(3, table.get(Namespace("db.a"))->stats.nrecords);
+
+        table.kill(&txn, Namespace("db.a"));
+        ASSERT_EQUALS(static_cast<NamespaceDetails*>(NULL), table.get(Namespace("db.a")));
+        ASSERT_EQUALS(2, table.get(Namespace("db.b"))->stats.nrecords);
+
+        // Killing a missing namespace is a no-op.
+        table.kill(&txn, Namespace("db.a"));
+    }
+
+    TEST(NamespaceHashTableTest, ReopenFindsExistingNamespaces) {
+        std::vector<char> buf(kBufLen, 0);
+        OperationContextNoop txn;
+        {
+            NamespaceHashTable table(&buf[0], kBufLen, "test");
+            for (int i = 0; i < 100; i++) {
+                ASSERT(table.put(&txn, collection(i), detailsWithStats(i)));
+            }
+            table.kill(&txn, Namespace("db.c7"));
+        }
+
+        NamespaceHashTable table(&buf[0], kBufLen, "test");
+        for (int i = 0; i < 100; i++) {
+            NamespaceDetails* details = table.get(collection(i));
+            if (i == 7) {
+                ASSERT_EQUALS(static_cast<NamespaceDetails*>(NULL), details);
+                continue;
+            }
+            ASSERT(details);
+            ASSERT_EQUALS(i, details->stats.nrecords);
+        }
+    }
+
+    TEST(NamespaceHashTableTest, PutFailsWhenFull) {
+        const int bufLen = 16 * sizeof(NamespaceHashTable::Node);
+        std::vector<char> buf(bufLen, 0);
+        NamespaceHashTable table(&buf[0], bufLen, "test");
+        OperationContextNoop txn;
+
+        int added = 0;
+        while (table.put(&txn, collection(added), detailsWithStats(0))) {
+            added++;
+            ASSERT_LESS_THAN_OR_EQUALS(added, table.n);
+        }
+        for (int i = 0; i < added; i++) {
+            ASSERT(table.get(collection(i)));
+        }
+    }
+
+} // namespace mongo
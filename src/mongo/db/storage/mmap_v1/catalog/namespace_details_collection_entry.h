@@ -87,6 +87,16 @@ namespace mongo {
         virtual bool isIndexReady( OperationContext* txn,
                                    const StringData& indexName ) const;
 
+        virtual BSONObj getIndexBuildCheckpoint( OperationContext* txn,
+                                                 const StringData& indexName ) const {
+            return BSONObj();
+        }
+
+        // IndexDetails has no room for a checkpoint.
+        virtual void setIndexBuildCheckpoint( OperationContext* txn,
+                                              const StringData& indexName,
+                                              const BSONObj& checkpoint ) {}
+
         virtual Status removeIndex( OperationContext* txn,
                                     const StringData& indexName );
 
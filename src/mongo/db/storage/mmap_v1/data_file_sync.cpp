@@ -32,9 +32,11 @@
 
 #include "mongo/db/storage/mmap_v1/data_file_sync.h"
 
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/global_environment_experiment.h"
 #include "mongo/db/instance.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/mmap_v1/mmap_v1_options.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/util/log.h"
@@ -42,13 +44,22 @@
 
 namespace mongo {
 
+namespace {
+    // Syncing every data file at once each syncdelay writes everything dirtied since the last
+    // sync in one burst, which can hold up reads for seconds.  When this is positive the files
+    // are instead synced this many megabytes at a time, spread out over the syncdelay.
+    MONGO_EXPORT_SERVER_PARAMETER(dataFileSyncChunkMB, int, 0);
+}
+
     DataFileSync dataFileSync;
 
     DataFileSync::DataFileSync()
         : ServerStatusSection( "backgroundFlushing" ),
           _total_time( 0 ),
           _flushes( 0 ),
-          _last() {
+          _last(),
+          _chunks( 0 ),
+          _last_pass_time( 0 ) {
 
     }
 
@@ -73,6 +84,12 @@ namespace mongo {
                 continue;
             }
 
+            const int chunkMB = dataFileSyncChunkMB;
+            if (chunkMB > 0) {
+                _flushIncrementally(static_cast<unsigned long long>(chunkMB) * 1024 * 1024);
+                continue;
+            }
+
             sleepmillis((long long) std::max(0.0, (mmapv1GlobalOptions.syncdelay * 1000) - time_flushing));
 
             if ( inShutdown() ) {
@@ -93,6 +110,48 @@ namespace mongo {
         }
     }
 
+    void DataFileSync::_flushIncrementally(unsigned long long chunkBytes) {
+        const long long delayMillis = static_cast<long long>(mmapv1GlobalOptions.syncdelay * 1000);
+        const Date_t start = jsTime();
+
+        // Everything written before this point is on disk once every piece has been synced.
+        const unsigned long long preFlushToken = MongoFile::notifyPreFlush();
+
+        OwnedPointerVector<MongoFile::Flushable> chunks;
+        MongoFile::prepareFlushChunks(chunkBytes, &chunks);
+
+        long long time_flushing = 0;
+        for (size_t i = 0; i < chunks.size(); i++) {
+            const Date_t chunkStart = jsTime();
+            chunks[i]->flush();
+            time_flushing += jsTime() - chunkStart;
+            _chunks++;
+
+            // Hold each piece back until its share of the syncdelay has passed.
+            const long long due = delayMillis * static_cast<long long>(i + 1) / chunks.size();
+            const long long elapsed = jsTime() - start;
+            if (due > elapsed)
+                sleepmillis(due - elapsed);
+
+            if ( inShutdown() ) {
+                // shutdown syncs the files itself
+                return;
+            }
+        }
+
+        if (chunks.empty())
+            sleepmillis(delayMillis);
+
+        MongoFile::notifyPostFlush(preFlushToken);
+        _flushed(static_cast<int>(time_flushing));
+        _last_pass_time = jsTime() - start;
+
+        if( logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(1)) ) {
+            log() << "flushing mmaps took " << time_flushing << "ms in " << chunks.size()
+                  << " pieces over " << _last_pass_time << "ms" << endl;
+        }
+    }
+
     BSONObj DataFileSync::generateSection(OperationContext* txn,
                                           const BSONElement& configElement) const {
         BSONObjBuilder b;
@@ -101,6 +160,10 @@ namespace mongo {
         b.appendNumber( "average_ms" , (_flushes ? (_total_time / double(_flushes)) : 0.0) );
         b.appendNumber( "last_ms" , _last_time );
         b.append("last_finished", _last);
+        if (_chunks) {
+            b.appendNumber( "chunks", _chunks );
+            b.appendNumber( "last_pass_ms" , _last_pass_time );
+        }
         return b.obj();
     }
 
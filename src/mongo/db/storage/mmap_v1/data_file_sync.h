@@ -51,11 +51,20 @@ namespace mongo {
     private:
         void _flushed(int ms);
 
+        /**
+         * Syncs every data file 'chunkBytes' at a time, spreading the pieces over the syncdelay.
+         */
+        void _flushIncrementally(unsigned long long chunkBytes);
+
         long long _total_time;
         long long _flushes;
         int _last_time;
         Date_t _last;
 
+        // Set by _flushIncrementally.  A pass's length is how stale the data files can get.
+        long long _chunks;
+        long long _last_pass_time;
+
     };
 
     extern DataFileSync dataFileSync;
@@ -40,6 +40,7 @@
 
 #include "mongo/base/init.h"
 #include "mongo/db/client.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/mmap_v1/dur_journalformat.h"
 #include "mongo/db/storage/mmap_v1/dur_journalimpl.h"
 #include "mongo/db/storage/mmap_v1/dur_stats.h"
@@ -50,6 +51,7 @@
 #include "mongo/util/alignedbuilder.h"
 #include "mongo/util/checksum.h"
 #include "mongo/util/compress.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/file.h"
 #include "mongo/util/hex.h"
 #include "mongo/util/log.h"
@@ -57,6 +59,7 @@
 #include "mongo/util/mmap.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/net/listen.h" // getelapsedtimemillis
+#include "mongo/util/processinfo.h"
 #include "mongo/util/progress_meter.h"
 #include "mongo/util/timer.h"
 
@@ -191,9 +194,9 @@ namespace mongo {
             _nextFileNumber = 0;
             _curLogFile = 0;
             _curFileId = 0;
-            _preFlushTime = 0;
             _lastFlushTime = 0;
             _writeToLSNNeeded = false;
+            _compressionPool = 0;
         }
 
         boost::filesystem::path Journal::getFilePathFor(int filenumber) const {
@@ -641,12 +644,15 @@ namespace mongo {
             }
         }
 
-        void Journal::preFlush() {
-            j._preFlushTime = Listener::getElapsedTimeMillis();
+        unsigned long long Journal::preFlush() {
+            return Listener::getElapsedTimeMillis();
         }
 
-        void Journal::postFlush() {
-            j._lastFlushTime = j._preFlushTime;
+        void Journal::postFlush(unsigned long long preFlushTime) {
+            // A flush which began earlier may finish after a later one.
+            if ( preFlushTime > j._lastFlushTime ) {
+                j._lastFlushTime = preFlushTime;
+            }
             j._writeToLSNNeeded = true;
         }
 
@@ -728,6 +734,31 @@ namespace mongo {
             j.journal(h, uncompressed);
             stats.curr->_writeToJournalMicros += t.micros();
         }
+        // Number of threads compressing large journal sections.  1 compresses every section on
+        // the durability thread.
+        MONGO_EXPORT_STARTUP_SERVER_PARAMETER(journalCompressionThreads, int, 4);
+
+        // Sections are split into pieces of this size for parallel compression, and sections
+        // smaller than two pieces are compressed on the durability thread.
+        static const size_t CompressionChunkSize = 1024 * 1024;
+
+        void Journal::_compress(const AlignedBuilder& in, char* out, size_t* outLength) {
+            const size_t len = in.len();
+            if ( journalCompressionThreads <= 1 || len < 2 * CompressionChunkSize ) {
+                rawCompress(in.buf(), len, out, outLength);
+                return;
+            }
+
+            if ( !_compressionPool ) {
+                const int numCores = static_cast<int>(ProcessInfo().getNumCores());
+                const int nThreads = std::min(journalCompressionThreads, std::max(1, numCores));
+                _compressionPool = new ThreadPool(nThreads, "journalCompress");
+            }
+
+            // same bytes as rawCompress(), so recovery reads the section as usual
+            rawCompressParallel(in.buf(), len, out, outLength, _compressionPool, CompressionChunkSize);
+        }
+
         void Journal::journal(const JSectHeader& h, const AlignedBuilder& uncompressed) {
             static AlignedBuilder b(32*1024*1024);
             /* buffer to journal will be
@@ -745,7 +776,7 @@ namespace mongo {
             }
 
             size_t compressedLength = 0;
-            rawCompress(uncompressed.buf(), uncompressed.len(), b.cur(), &compressedLength);
+            _compress(uncompressed, b.cur(), &compressedLength);
             verify( compressedLength < 0xffffffff );
             verify( compressedLength < max );
             b.skip(compressedLength);
@@ -34,6 +34,11 @@
 #include "mongo/util/logfile.h"
 
 namespace mongo {
+
+    namespace threadpool {
+        class ThreadPool;
+    }
+
     namespace dur {
 
         /** the writeahead journal for durability */
@@ -83,6 +88,9 @@ namespace mongo {
             void closeCurrentJournalFile();
             void removeUnneededJournalFiles();
 
+            /** compresses 'in' into 'out', spreading large sections over _compressionPool */
+            void _compress(const AlignedBuilder& in, char* out, size_t* outLength);
+
             unsigned long long _written; // bytes written so far to the current journal (log) file
             unsigned _nextFileNumber;
 
@@ -100,10 +108,12 @@ namespace mongo {
             // ordered oldest to newest
             std::list<JFile> _oldJournalFiles; // use _curLogFileMutex
 
+            // created on first use by the durability thread and never freed
+            threadpool::ThreadPool* _compressionPool;
+
             // lsn related
-            static void preFlush();
-            static void postFlush();
-            unsigned long long _preFlushTime;
+            static unsigned long long preFlush();
+            static void postFlush(unsigned long long preFlushTime);
             unsigned long long _lastFlushTime; // data < this time is fsynced in the datafiles (unless hard drive controller is caching)
             bool _writeToLSNNeeded;
             void updateLSNFile();
@@ -43,6 +43,7 @@
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/db.h"
 #include "mongo/db/operation_context_impl.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/storage_engine.h"
 #include "mongo/db/storage/mmap_v1/catalog/namespace.h"
 #include "mongo/db/storage/mmap_v1/dur.h"
@@ -59,6 +60,7 @@
 #include "mongo/util/compress.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/startup_test.h"
 
 using namespace mongoutils;
@@ -76,6 +78,10 @@ namespace mongo {
 
     namespace dur {
 
+        // Threads which apply the journal at startup. With more than one, the next section is
+        // parsed while the current one is applied, and writes to different files go in parallel.
+        MONGO_EXPORT_STARTUP_SERVER_PARAMETER(journalRecoveryThreads, int, 4);
+
         struct ParsedJournalEntry { /*copyable*/
             ParsedJournalEntry() : e(0) { }
 
@@ -216,6 +222,71 @@ namespace mongo {
 
         };
 
+        struct RecoveryJob::PreparedSection : boost::noncopyable {
+            PreparedSection()
+                : h(0), p(0), len(0), f(0), skip(false), corrupt(false), error(Status::OK()) { }
+
+            void reset() {
+                skip = false;
+                corrupt = false;
+                error = Status::OK();
+                iterator.reset();
+                entries.clear();
+            }
+
+            /** rethrows what prepareSectionInWorker recorded */
+            void throwIfFailed() const {
+                if (corrupt)
+                    throw JournalSectionCorruptException();
+                uassertStatusOK(error);
+            }
+
+            const JSectHeader* h;
+            const void* p; // data between header and footer
+            unsigned len;
+            const JSectFooter* f;
+
+            bool skip; // already synced to the data files before the crash
+            bool corrupt;
+            Status error;
+
+            boost::scoped_ptr<JournalSectionIterator> iterator; // owns what entries point into
+            vector<ParsedJournalEntry> entries;
+        };
+
+        namespace {
+            /** a run of basic writes which go to one data file, in journal order */
+            struct FileWrites {
+                FileWrites() : mmf(0), bytes(0) { }
+
+                DurableMappedFile* mmf;
+                vector<const JEntry*> writes;
+                unsigned long long bytes; // written, for the journal stats
+            };
+
+            void applyFileWrites(FileWrites* fileWrites, AtomicUInt32* failures) {
+                try {
+                    DurableMappedFile* mmf = fileWrites->mmf;
+                    for (size_t i = 0; i < fileWrites->writes.size(); i++) {
+                        const JEntry* e = fileWrites->writes[i];
+                        // as in RecoveryJob::write, writes past the end of the file are skipped
+                        if (e->ofs + e->len > mmf->length())
+                            continue;
+
+                        verify(mmf->view_write());
+                        verify(e->srcData());
+                        char* dest = static_cast<char*>(mmf->view_write()) + e->ofs;
+                        memcpy(dest, e->srcData(), e->len);
+                        fileWrites->bytes += e->len;
+                    }
+                }
+                catch (const std::exception& ex) {
+                    log() << "journal recovery failed to apply writes: " << ex.what();
+                    failures->fetchAndAdd(1);
+                }
+            }
+        } // namespace
+
         static string fileName(const char* dbName, int fileNo) {
             stringstream ss;
             ss << dbName << '.';
@@ -376,6 +447,27 @@ namespace mongo {
             if( dump )
                 log() << "BEGIN section" << endl;
 
+            if (apply && !dump && _writePool) {
+                // DurOps act on whole files, so only the basic writes between them are spread
+                // over the pool
+                size_t i = 0;
+                while (i < entries.size()) {
+                    if (!entries[i].e) {
+                        Last last;
+                        applyEntry(last, entries[i], apply, dump);
+                        i++;
+                        continue;
+                    }
+
+                    size_t end = i;
+                    while (end < entries.size() && entries[end].e)
+                        end++;
+                    applyWritesInParallel(entries, i, end);
+                    i = end;
+                }
+                return;
+            }
+
             Last last;
             for( vector<ParsedJournalEntry>::const_iterator i = entries.begin(); i != entries.end(); ++i ) {
                 applyEntry(last, *i, apply, dump);
@@ -385,20 +477,129 @@ namespace mongo {
                 log() << "END section" << endl;
         }
 
+        void RecoveryJob::applyWritesInParallel(const vector<ParsedJournalEntry>& entries,
+                                                size_t begin,
+                                                size_t end) {
+            // Opening files isn't thread safe, so resolve every write's file here first.
+            // Writes to one file stay in journal order on one thread, as later writes may
+            // overlap earlier ones.
+            vector<FileWrites> files;
+            map<DurableMappedFile*, size_t> fileIndexes;
+            Last last;
+            for (size_t i = begin; i < end; i++) {
+                const ParsedJournalEntry& entry = entries[i];
+                verify(entry.dbName);
+                verify(strnlen(entry.dbName, MaxDatabaseNameLen) < MaxDatabaseNameLen);
+
+                DurableMappedFile* mmf = last.newEntry(entry, *this);
+                map<DurableMappedFile*, size_t>::const_iterator it = fileIndexes.find(mmf);
+                if (it == fileIndexes.end()) {
+                    it = fileIndexes.insert(make_pair(mmf, files.size())).first;
+                    files.push_back(FileWrites());
+                    files.back().mmf = mmf;
+                }
+                files[it->second].writes.push_back(entry.e);
+            }
+
+            AtomicUInt32 failures;
+            if (files.size() == 1) {
+                applyFileWrites(&files[0], &failures);
+            }
+            else {
+                for (size_t i = 0; i < files.size(); i++) {
+                    _writePool->schedule(applyFileWrites, &files[i], &failures);
+                }
+                _writePool->join();
+            }
+            massert(28646, "journal recovery failed to apply writes", failures.load() == 0);
+
+            for (size_t i = 0; i < files.size(); i++) {
+                stats.curr->_writeToDataFilesBytes += files[i].bytes;
+            }
+        }
+
         void RecoveryJob::processSection(const JSectHeader *h, const void *p, unsigned len, const JSectFooter *f) {
             LockMongoFilesShared lkFiles; // for RecoveryJob::Last
             scoped_lock lk(_mx);
 
+            // we use a static so that we don't have to reallocate every time through.  occasionally we 
+            // go back to a small allocation so that if there were a spiky growth it won't stick forever.
+            static PreparedSection section;
+            section.reset();
+/** TEMP uncomment
+            RARELY OCCASIONALLY {
+                if( section.entries.capacity() > 2048 ) {
+                    section.entries.shrink_to_fit();
+                    section.entries.reserve(2048);
+                }
+            }
+*/
+            section.h = h;
+            section.p = p;
+            section.len = len;
+            section.f = f;
+
+            prepareSection(&section);
+            applySection(section);
+            section.reset();
+        }
+
+        void RecoveryJob::prepareSection(PreparedSection* section) {
+            const JSectHeader* h = section->h;
+
             // Check the footer checksum before doing anything else.
             if (_recovering) {
-                verify( ((const char *)h) + sizeof(JSectHeader) == p );
-                if (!f->checkHash(h, len + sizeof(JSectHeader))) {
+                verify( ((const char *)h) + sizeof(JSectHeader) == section->p );
+                if (!section->f->checkHash(h, section->len + sizeof(JSectHeader))) {
                     log() << "journal section checksum doesn't match";
                     throw JournalSectionCorruptException();
                 }
             }
 
             if( _recovering && _lastDataSyncedFromLastRun > h->seqNumber + ExtraKeepTimeMs ) {
+                section->skip = true;
+                return;
+            }
+
+            if( _recovering ) {
+                section->iterator.reset(new JournalSectionIterator(*h, section->p, section->len,
+                                                                   _recovering));
+            }
+            else { 
+                section->iterator.reset(new JournalSectionIterator(*h, /*after header*/section->p,
+                                                                   /*w/out header*/section->len));
+            }
+
+            // first read all entries to make sure this section is valid
+            ParsedJournalEntry e;
+            while( !section->iterator->atEof() ) {
+                section->iterator->next(e);
+                section->entries.push_back(e);
+            }
+        }
+
+        void RecoveryJob::prepareSectionInWorker(RecoveryJob* job, PreparedSection* section) {
+            try {
+                job->prepareSection(section);
+            }
+            catch (const JournalSectionCorruptException&) {
+                section->corrupt = true;
+            }
+            catch (const BufReader::eof&) {
+                // a premature end of section, which processFileBuffer treats as corruption
+                section->corrupt = true;
+            }
+            catch (const DBException& e) {
+                section->error = e.toStatus();
+            }
+            catch (const std::exception& e) {
+                section->error = Status(ErrorCodes::InternalError, e.what());
+            }
+        }
+
+        void RecoveryJob::applySection(const PreparedSection& section) {
+            const JSectHeader* h = section.h;
+            if( section.skip ) {
                 if( h->seqNumber != _lastSeqMentionedInConsoleLog ) {
                     static int n;
                     if( ++n < 10 ) {
@@ -412,36 +613,8 @@ namespace mongo {
                 return;
             }
 
-            auto_ptr<JournalSectionIterator> i;
-            if( _recovering ) {
-                i = auto_ptr<JournalSectionIterator>(new JournalSectionIterator(*h, p, len, _recovering));
-            }
-            else { 
-                i = auto_ptr<JournalSectionIterator>(new JournalSectionIterator(*h, /*after header*/p, /*w/out header*/len));
-            }
-
-            // we use a static so that we don't have to reallocate every time through.  occasionally we 
-            // go back to a small allocation so that if there were a spiky growth it won't stick forever.
-            static vector<ParsedJournalEntry> entries;
-            entries.clear();
-/** TEMP uncomment
-            RARELY OCCASIONALLY {
-                if( entries.capacity() > 2048 ) {
-                    entries.shrink_to_fit();
-                    entries.reserve(2048);
-                }
-            }
-*/
-
-            // first read all entries to make sure this section is valid
-            ParsedJournalEntry e;
-            while( !i->atEof() ) {
-                i->next(e);
-                entries.push_back(e);
-            }
-
             // got all the entries for one group commit.  apply them:
-            applyEntries(entries);
+            applyEntries(section.entries);
         }
 
         /** apply a specific journal file, that is already mmap'd
@@ -449,6 +622,9 @@ namespace mongo {
             @return true if this is detected to be the last file (ends abruptly)
         */
         bool RecoveryJob::processFileBuffer(const void *p, unsigned len) {
+            // With _preparePool, the section parsed last time through the loop below, which is
+            // applied while the next one is parsed.
+            boost::scoped_ptr<PreparedSection> parsed;
             try {
                 unsigned long long fileId;
                 BufReader br(p,len);
@@ -491,6 +667,7 @@ namespace mongo {
                             log() << "Ending processFileBuffer at differing fileId want:" << fileId << " got:" << h.fileId << endl;
                             log() << "  sect len:" << h.sectionLen() << " seqnum:" << h.seqNumber << endl;
                         }
+                        applyParsedSection(&parsed);
                         return true;
                     }
                     unsigned slen = h.sectionLen();
@@ -498,18 +675,45 @@ namespace mongo {
                     const char *hdr = (const char *) br.skip(h.sectionLenWithPadding());
                     const char *data = hdr + sizeof(JSectHeader);
                     const char *footer = data + dataLen;
-                    processSection((const JSectHeader*) hdr, data, dataLen, (const JSectFooter*) footer);
+                    if (!_preparePool) {
+                        processSection((const JSectHeader*) hdr, data, dataLen,
+                                       (const JSectFooter*) footer);
+                    }
+                    else {
+                        boost::scoped_ptr<PreparedSection> next(new PreparedSection());
+                        next->h = (const JSectHeader*) hdr;
+                        next->p = data;
+                        next->len = dataLen;
+                        next->f = (const JSectFooter*) footer;
+                        _preparePool->schedule(prepareSectionInWorker, this, next.get());
+
+                        try {
+                            applyParsedSection(&parsed);
+                        }
+                        catch (...) {
+                            _preparePool->join(); // 'next' is still in use
+                            throw;
+                        }
+                        _preparePool->join();
+
+                        // sections after a corrupt one are never applied
+                        next->throwIfFailed();
+                        parsed.swap(next);
+                    }
 
                     // ctrl c check
                     uassert(ErrorCodes::Interrupted, "interrupted during journal recovery", !inShutdown());
                 }
+                applyParsedSection(&parsed);
             }
             catch (const BufReader::eof&) {
+                applyParsedSection(&parsed);
                 if (mmapv1GlobalOptions.journalOptions & MMAPV1Options::JournalDumpJournal)
                     log() << "ABRUPT END" << endl;
                 return true; // abrupt end
             }
             catch (const JournalSectionCorruptException&) {
+                applyParsedSection(&parsed);
                 if (mmapv1GlobalOptions.journalOptions & MMAPV1Options::JournalDumpJournal)
                     log() << "ABRUPT END" << endl;
                 return true; // abrupt end
@@ -518,6 +722,19 @@ namespace mongo {
             return false; // non-abrupt end
         }
 
+        void RecoveryJob::applyParsedSection(boost::scoped_ptr<PreparedSection>* parsed) {
+            if (!parsed->get())
+                return;
+
+            // reset first, so that a section is applied at most once even if this throws
+            boost::scoped_ptr<PreparedSection> section;
+            section.swap(*parsed);
+
+            LockMongoFilesShared lkFiles; // for RecoveryJob::Last
+            scoped_lock lk(_mx);
+            applySection(*section);
+        }
+
         /** apply a specific journal file */
         bool RecoveryJob::processFile(boost::filesystem::path journalfile) {
             log() << "recover " << journalfile.string() << endl;
@@ -548,6 +765,12 @@ namespace mongo {
             _lastDataSyncedFromLastRun = journalReadLSN();
             log() << "recover lsn: " << _lastDataSyncedFromLastRun << endl;
 
+            if (journalRecoveryThreads > 1) {
+                _preparePool.reset(new ThreadPool(1, "journalRecoveryParse"));
+                _writePool.reset(new ThreadPool(journalRecoveryThreads, "journalRecoveryWrite"));
+            }
+            ON_BLOCK_EXIT(&RecoveryJob::stopRecoveryThreads, this);
+
             for( unsigned i = 0; i != files.size(); ++i ) {
                 bool abruptEnd = processFile(files[i]);
                 if( abruptEnd && i+1 < files.size() ) {
@@ -572,6 +795,11 @@ namespace mongo {
             _recovering = false;
         }
 
+        void RecoveryJob::stopRecoveryThreads() {
+            _preparePool.reset();
+            _writePool.reset();
+        }
+
         void _recover() {
             verify(storageGlobalParams.dur);
 
@@ -31,10 +31,12 @@
 #pragma once
 
 #include <boost/filesystem/operations.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <list>
 
 #include "mongo/db/storage/mmap_v1/dur_journalformat.h"
 #include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/file.h"
 
 namespace mongo {
@@ -68,9 +70,28 @@ namespace mongo {
 
             static RecoveryJob & get() { return _instance; }
         private:
+            struct PreparedSection;
+
             void write(Last& last, const ParsedJournalEntry& entry); // actually writes to the file
             void applyEntry(Last& last, const ParsedJournalEntry& entry, bool apply, bool dump);
             void applyEntries(const std::vector<ParsedJournalEntry> &entries);
+
+            /** with _writePool, applies the basic writes [begin, end) one data file per thread */
+            void applyWritesInParallel(const std::vector<ParsedJournalEntry>& entries,
+                                       size_t begin,
+                                       size_t end);
+
+            /** checks the section's checksum and parses its entries. throws if corrupt */
+            void prepareSection(PreparedSection* section);
+            void applySection(const PreparedSection& section); // caller locks as processSection
+
+            /** runs prepareSection on _preparePool, recording rather than throwing failures */
+            static void prepareSectionInWorker(RecoveryJob* job, PreparedSection* section);
+
+            /** applies and clears '*parsed', if set, under the locks processSection takes */
+            void applyParsedSection(boost::scoped_ptr<PreparedSection>* parsed);
+
+            void stopRecoveryThreads();
             bool processFileBuffer(const void *, unsigned len);
             bool processFile(boost::filesystem::path journalfile);
             void _close(); // doesn't lock
@@ -85,6 +106,12 @@ namespace mongo {
         private:
             bool _recovering; // are we in recovery or WRITETODATAFILES
 
+            // While recovering with journalRecoveryThreads > 1, the next section is parsed on
+            // _preparePool while the current one is applied, and writes to different data files
+            // are applied on _writePool.
+            boost::scoped_ptr<ThreadPool> _preparePool;
+            boost::scoped_ptr<ThreadPool> _writePool;
+
             static RecoveryJob &_instance;
         };
 
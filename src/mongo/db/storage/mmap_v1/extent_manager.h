@@ -118,6 +118,12 @@ namespace mongo {
          */
         virtual RecordFetcher* recordNeedsFetch( const DiskLoc& loc ) const = 0;
 
+        /**
+         * Asks the system to start reading in the pages which hold the records at 'locs',
+         * without waiting for them.  The default does nothing.
+         */
+        virtual void prefetchRecords( const std::vector<DiskLoc>& locs ) const { }
+
         /**
          * @param loc - has to be for a specific Record (not an Extent)
          * Note(erh) see comment on recordFor
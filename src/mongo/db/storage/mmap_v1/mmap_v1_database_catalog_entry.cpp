@@ -604,6 +604,11 @@ namespace mongo {
                            str::stream() << "namespace already exists: " << ns );
         }
 
+        if ( options.isPartitioned() ) {
+            return Status( ErrorCodes::InvalidOptions,
+                           "mmapv1 does not support partitioned collections" );
+        }
+
         BSONObj optionsAsBSON = options.toBSON();
         _addNamespaceToNamespaceCollection( txn, ns, &optionsAsBSON );
 
@@ -772,6 +777,8 @@ namespace mongo {
                                entry->ordering(),
                                entry->descriptor()->indexNamespace(),
                                entry->descriptor()->version(),
+                               entry->descriptor()->btreeBucketSize(),
+                               entry->descriptor()->fillFactor(),
                                &BtreeBasedAccessMethod::invalidateCursors));
 
         if (IndexNames::HASHED == type)
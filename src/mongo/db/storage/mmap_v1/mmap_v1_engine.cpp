@@ -43,6 +43,7 @@
 #endif
 
 #include "mongo/db/mongod_options.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/mmap_v1/data_file_sync.h"
 #include "mongo/db/storage/mmap_v1/dur.h"
 #include "mongo/db/storage/mmap_v1/dur_commitjob.h"
@@ -60,6 +61,10 @@
 
 namespace mongo {
 
+    // Number of FileAllocator threads, so that files of several databases can be allocated at
+    // once when they have to be filled with zeroes.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(fileAllocatorThreads, int, 1);
+
 namespace {
 #ifdef _WIN32
     HANDLE lockFileHandle;
@@ -294,7 +299,8 @@ namespace {
 
         acquirePathLock(this, storageGlobalParams.repair);
 
-        FileAllocator::get()->start();
+        uassert(28644, "fileAllocatorThreads must be at least 1", fileAllocatorThreads >= 1);
+        FileAllocator::get()->start(fileAllocatorThreads);
 
         MONGO_ASSERT_ON_EXCEPTION_WITH_MSG( clearTmpFiles(), "clear tmp files" );
     }
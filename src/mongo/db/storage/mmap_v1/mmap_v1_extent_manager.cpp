@@ -30,13 +30,19 @@
 
 #define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kStorage
 
+#include <algorithm>
 #include <boost/filesystem/operations.hpp>
 
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
 #include "mongo/db/storage/mmap_v1/mmap_v1_extent_manager.h"
 
 #include "mongo/base/counter.h"
 #include "mongo/db/audit.h"
 #include "mongo/db/client.h"
+#include "mongo/db/commands/server_status.h"
 #include "mongo/db/storage/mmap_v1/dur.h"
 #include "mongo/db/storage/mmap_v1/data_file.h"
 #include "mongo/db/storage/mmap_v1/record.h"
@@ -45,10 +51,13 @@
 #include "mongo/db/storage/mmap_v1/mmap_v1_options.h"
 #include "mongo/db/storage/record_fetcher.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/file.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mmap.h"
+#include "mongo/util/processinfo.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
@@ -59,6 +68,28 @@ namespace mongo {
     static Counter64 needsFetchFailCounter;
     MONGO_FP_DECLARE(recordNeedsFetchFail);
 
+    // How many data files to request from the FileAllocator ahead of the one in use while new
+    // files are needed within kQuickFillMillis of each other. Otherwise only the next one is.
+    MONGO_EXPORT_SERVER_PARAMETER(mmapv1PreallocateFilesAhead, int, 2);
+    static const unsigned long long kQuickFillMillis = 60 * 1000;
+
+    namespace {
+        // Reports how often the RecordAccessTrackers guessed right about page residency.
+        class RecordAccessTrackerServerStatusSection : public ServerStatusSection {
+        public:
+            RecordAccessTrackerServerStatusSection()
+                : ServerStatusSection("recordAccessTracker") { }
+            bool includeByDefault() const { return false; }
+
+            BSONObj generateSection(OperationContext* txn,
+                                    const BSONElement& configElement) const {
+                BSONObjBuilder result;
+                RecordAccessTracker::appendStats(&result);
+                return result.obj();
+            }
+        } recordAccessTrackerServerStatusSection;
+    }
+
     // Used to make sure the compiler doesn't get too smart on us when we're
     // trying to touch records.
     volatile int __record_touch_dummy = 1;
@@ -105,7 +136,8 @@ namespace mongo {
         : _dbname(dbname.toString()),
           _path(path.toString()),
           _directoryPerDB(directoryPerDB),
-          _rid(RESOURCE_METADATA, dbname) {
+          _rid(RESOURCE_METADATA, dbname),
+          _lastFileAddedMillis(0) {
 
     }
 
@@ -224,10 +256,27 @@ namespace mongo {
 
         // Preallocate is asynchronous
         if (preallocateNextFile) {
-            auto_ptr<DataFile> nextFile(new DataFile(allocFileId + 1));
-            const string nextFileName = fileName(allocFileId + 1).string();
+            // Look further ahead while files are being filled quickly, so that a burst of
+            // inserts finds its next files already allocated instead of waiting on them.
+            const unsigned long long now = curTimeMillis64();
+            int filesAhead = 1;
+            if (_lastFileAddedMillis && now - _lastFileAddedMillis < kQuickFillMillis) {
+                filesAhead = std::max(1, mmapv1PreallocateFilesAhead);
+            }
+            _lastFileAddedMillis = now;
 
-            nextFile->open(txn, nextFileName.c_str(), minSize, false);
+            for (int i = 1; i <= filesAhead; i++) {
+                const int nextFileId = allocFileId + i;
+                if (nextFileId >= DiskLoc::MaxFiles)
+                    break;
+                if (mmapv1GlobalOptions.quota && nextFileId > mmapv1GlobalOptions.quotaFiles)
+                    break;
+
+                auto_ptr<DataFile> nextFile(new DataFile(nextFileId));
+                const string nextFileName = fileName(nextFileId).string();
+
+                nextFile->open(txn, nextFileName.c_str(), minSize, true);
+            }
         }
 
         // Returns the last file added
@@ -275,13 +324,60 @@ namespace mongo {
             }
         }
 
-        if ( !_recordAccessTracker.checkAccessedAndMark( record ) ) {
+        const DataFile* df = _getOpenFile( loc.a() );
+        if ( !_recordAccessTracker.checkAccessedAndMark( record,
+                                                         df->p(),
+                                                         df->p() + df->length() ) ) {
             return new MmapV1RecordFetcher( record );
         }
 
         return NULL;
     }
 
+    void MmapV1ExtentManager::prefetchRecords( const std::vector<DiskLoc>& locs ) const {
+#if !defined(_WIN32)
+        if ( locs.empty() ) {
+            return;
+        }
+
+        std::vector<DiskLoc> sorted( locs );
+        std::sort( sorted.begin(), sorted.end() );
+
+        // Computing the address of a record doesn't touch it, so none of this can page fault.
+        const size_t pageSize = ProcessInfo::getPageSize();
+        size_t runBegin = 0;
+        size_t runEnd = 0;
+        for ( size_t i = 0; i < sorted.size(); i++ ) {
+            if ( sorted[i].isNull() ) {
+                continue;
+            }
+
+            const size_t page =
+                reinterpret_cast<size_t>( _recordForV1( sorted[i] ) ) & ~( pageSize - 1 );
+            if ( runEnd != 0 && page >= runBegin && page <= runEnd ) {
+                if ( page == runEnd ) {
+                    runEnd += pageSize;
+                }
+                continue;
+            }
+
+            if ( runEnd != 0 ) {
+                posix_madvise( reinterpret_cast<void*>( runBegin ),
+                               runEnd - runBegin,
+                               POSIX_MADV_WILLNEED );
+            }
+            runBegin = page;
+            runEnd = page + pageSize;
+        }
+
+        if ( runEnd != 0 ) {
+            posix_madvise( reinterpret_cast<void*>( runBegin ),
+                           runEnd - runBegin,
+                           POSIX_MADV_WILLNEED );
+        }
+#endif
+    }
+
     DiskLoc MmapV1ExtentManager::extentLocForV1( const DiskLoc& loc ) const {
         Record* record = recordForV1( loc );
         return DiskLoc( loc.a(), record->extentOfs() );
@@ -365,7 +461,7 @@ namespace mongo {
         // no space in an existing file
         // allocate files until we either get one big enough or hit maxSize
         for ( int i = 0; i < 8; i++ ) {
-            DataFile* f = _addAFile( txn, size, false );
+            DataFile* f = _addAFile( txn, size, true );
 
             if ( f->getHeader()->unusedLength >= size ) {
                 return _createExtentInFile( txn, numFiles() - 1, f, size, enforceQuota );
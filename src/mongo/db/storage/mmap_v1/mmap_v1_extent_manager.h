@@ -126,6 +126,13 @@ namespace mongo {
 
         RecordFetcher* recordNeedsFetch( const DiskLoc& loc ) const;
 
+        /**
+         * Sorts 'locs' by file and offset and issues one readahead hint per run of adjacent
+         * pages.  Only the page holding the start of each record is hinted, since the length of
+         * a record can't be known without touching it.
+         */
+        void prefetchRecords( const std::vector<DiskLoc>& locs ) const;
+
         /**
          * @param loc - has to be for a specific Record (not an Extent)
          * Note(erh) see comment on recordFor
@@ -198,6 +205,9 @@ namespace mongo {
         const ResourceId _rid;
         mutable RecordAccessTracker _recordAccessTracker;
 
+        // When _addAFile last ran, to tell how quickly files are filling up. Guarded by _rid.
+        unsigned long long _lastFileAddedMillis;
+
         /**
          * Simple wrapper around an array object to allow append-only modification of the array,
          * as well as concurrent read-accesses. This class has a minimal interface to keep
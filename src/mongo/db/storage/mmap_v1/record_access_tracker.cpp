@@ -30,20 +30,46 @@
 
 #include "mongo/db/storage/mmap_v1/record_access_tracker.h"
 
+#include <algorithm>
 #include <cstring>
+#include <vector>
 
 #include "mongo/base/init.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/mmap_v1/record.h"
 #include "mongo/platform/bits.h"
+#include "mongo/util/concurrency/sharded_counter.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/processinfo.h"
 
 namespace mongo {
 
+    // Every this many hits, a thread asks the system whether the page really is resident, to
+    // measure the false-positive rate.  0 disables the sampling.
+    MONGO_EXPORT_SERVER_PARAMETER(recordAccessTrackerSampleInterval, int, 1024);
+
+    // Whether a miss that falls back to the system checks the record's whole region at once.
+    MONGO_EXPORT_SERVER_PARAMETER(recordAccessTrackerBulkResidencyCheck, bool, false);
+
     namespace {
 
         static bool blockSupported = false;
 
+        // Counts for all trackers, reported by appendStats().
+        ShardedCounter pointerTableHits;
+        ShardedCounter rollingTableHits;
+        ShardedCounter misses;
+        ShardedCounter systemChecks;
+        ShardedCounter systemChecksResident;
+        ShardedCounter bulkChecks;
+        ShardedCounter sampledHits;
+        ShardedCounter sampledHitsNotResident;
+
+        // The tracker's notion of a page, which need not be the system's.
+        const size_t kPageShift = 12;
+        const size_t kPagesPerRegionShift = 6;
+
         MONGO_INITIALIZER_WITH_PREREQUISITES(RecordBlockSupported,
                                              ("SystemInfo"))(InitializerContext* cx) {
             blockSupported = ProcessInfo::blockCheckSupported();
@@ -89,6 +115,7 @@ namespace mongo {
                  */
                 size_t _table[buckets][bucketSize];
                 long long _lastReset; // time in millis
+                unsigned _hitsSinceSample; // not cleared by reset()
             };
 
             void reset(Data* data) {
@@ -168,8 +195,13 @@ namespace mongo {
     }
 
     void RecordAccessTracker::Slice::reset() {
-        memset(_data, 0, sizeof(_data));
-        _lastReset = time(0);
+        // Clear each value before its region, so that a region claiming the entry afterwards
+        // keeps all of its bits.  A put() which found the old region before the reset and sets
+        // its bit afterwards leaves that bit for the next claimant: a rare false positive.
+        for (int i = 0; i < SliceSize; i++) {
+            _data[i].value.store(0);
+            _data[i].region.store(0);
+        }
     }
 
     RecordAccessTracker::State RecordAccessTracker::Slice::get(int regionHash,
@@ -181,7 +213,7 @@ namespace mongo {
         if (!e)
             return Unk;
 
-        return (e->value & ( 1ULL << offset ) ) ? In : Out;
+        return (e->value.load() & ( 1ULL << offset ) ) ? In : Out;
     }
 
     bool RecordAccessTracker::Slice::put(int regionHash, size_t region, short offset) {
@@ -191,29 +223,35 @@ namespace mongo {
         if (!e)
             return false;
 
-        e->value |= 1ULL << offset;
+        const unsigned long long bit = 1ULL << offset;
+        unsigned long long old = e->value.load();
+        while (!(old & bit)) {
+            const unsigned long long seen = e->value.compareAndSwap(old, old | bit);
+            if (seen == old)
+                break;
+            old = seen;
+        }
         return true;
     }
 
-    time_t RecordAccessTracker::Slice::lastReset() const {
-        return _lastReset;
-    }
-
     RecordAccessTracker::Entry* RecordAccessTracker::Slice::_get(int start,
                                                                  size_t region,
                                                                  bool add) {
         for (int i = 0; i < MaxChain; i++) {
             int bucket = (start + i) % SliceSize;
 
-            if (_data[bucket].region == 0) {
+            unsigned long long current = _data[bucket].region.load();
+            if (current == 0) {
                 if (!add)
                     return NULL;
 
-                _data[bucket].region = region;
-                return &_data[bucket];
+                current = _data[bucket].region.compareAndSwap(0, region);
+                if (current == 0)
+                    return &_data[bucket];
+                // Another thread claimed it first, maybe for 'region' too.
             }
 
-            if (_data[bucket].region == region) {
+            if (current == region) {
                 return &_data[bucket];
             }
         }
@@ -226,27 +264,24 @@ namespace mongo {
     //
 
     RecordAccessTracker::Rolling::Rolling()
-        : _lock( "ps::Rolling" ){
-        _curSlice = 0;
-        _lastRotate = Listener::getElapsedTimeMillis();
+        : _curSlice(0),
+          _lastRotate(Listener::getElapsedTimeMillis()) {
     }
 
     bool RecordAccessTracker::Rolling::access(size_t region, short offset, bool doHalf) {
         int regionHash = hash(region);
 
-        SimpleMutex::scoped_lock lk(_lock);
-
-        static int rarelyCount = 0;
-        if (rarelyCount++ % (2048 / BigHashSize) == 0) {
-            long long now = Listener::getElapsedTimeMillis();
-
-            if (now - _lastRotate > (1000 * RotateTimeSecs)) {
-                _rotate();
-            }
+        // Only the thread which moves _lastRotate on rotates for the passage of time.
+        const long long now = Listener::getElapsedTimeMillis();
+        const long long lastRotate = _lastRotate.load();
+        if (now - lastRotate > (1000 * RotateTimeSecs)
+                && _lastRotate.compareAndSwap(lastRotate, now) == lastRotate) {
+            _rotate(_curSlice.load());
         }
 
+        const int curSlice = _curSlice.load();
         for (int i = 0; i < NumSlices / (doHalf ? 2 : 1); i++) {
-            int pos = (_curSlice + i) % NumSlices;
+            int pos = (curSlice + i) % NumSlices;
             State s = _slices[pos].get(regionHash, region, offset);
 
             if (s == In)
@@ -260,17 +295,20 @@ namespace mongo {
 
         // we weren't in any slice
         // so add to cur
-        if (!_slices[_curSlice].put(regionHash, region, offset)) {
-            _rotate();
-            _slices[_curSlice].put(regionHash, region, offset);
+        if (!_slices[curSlice].put(regionHash, region, offset)) {
+            _rotate(curSlice);
+            _slices[_curSlice.load()].put(regionHash, region, offset);
         }
         return false;
     }
 
-    void RecordAccessTracker::Rolling::_rotate() {
-        _curSlice = (_curSlice + 1) % NumSlices;
-        _slices[_curSlice].reset();
-        _lastRotate = Listener::getElapsedTimeMillis();
+    void RecordAccessTracker::Rolling::_rotate(int fromSlice) {
+        const int next = (fromSlice + 1) % NumSlices;
+        if (_curSlice.compareAndSwap(fromSlice, next) != fromSlice)
+            return;
+
+        _slices[next].reset();
+        _lastRotate.store(Listener::getElapsedTimeMillis());
     }
 
     // These need to be outside the ps namespace due to the way they are defined
@@ -305,9 +343,20 @@ namespace mongo {
         _rollingTable.reset(new Rolling[BigHashSize]);
     }
 
+    void RecordAccessTracker::appendStats(BSONObjBuilder* builder) {
+        builder->appendNumber("pointerTableHits", pointerTableHits.load());
+        builder->appendNumber("rollingTableHits", rollingTableHits.load());
+        builder->appendNumber("misses", misses.load());
+        builder->appendNumber("systemChecks", systemChecks.load());
+        builder->appendNumber("systemChecksResident", systemChecksResident.load());
+        builder->appendNumber("bulkChecks", bulkChecks.load());
+        builder->appendNumber("sampledHits", sampledHits.load());
+        builder->appendNumber("sampledHitsNotResident", sampledHitsNotResident.load());
+    }
+
     void RecordAccessTracker::markAccessed(const void* record) {
-        const size_t page = reinterpret_cast<size_t>(record) >> 12;
-        const size_t region = page >> 6;
+        const size_t page = reinterpret_cast<size_t>(record) >> kPageShift;
+        const size_t region = page >> kPagesPerRegionShift;
         const size_t offset = page & 0x3f;
 
         const bool seen = PointerTable::seen(PointerTable::getData(),
@@ -318,20 +367,38 @@ namespace mongo {
     }
 
 
-    bool RecordAccessTracker::checkAccessedAndMark(const void* record) {
-        const size_t page = reinterpret_cast<size_t>(record) >> 12;
-        const size_t region = page >> 6;
+    bool RecordAccessTracker::checkAccessedAndMark(const void* record,
+                                                   const void* mappingBegin,
+                                                   const void* mappingEnd) {
+        const size_t page = reinterpret_cast<size_t>(record) >> kPageShift;
+        const size_t region = page >> kPagesPerRegionShift;
         const size_t offset = page & 0x3f;
 
         // This is like the "L1 cache". If we're a miss then we fall through and check the
         // "L2 cache". If we're still a miss, then we defer to a system-specific system
         // call (or give up and return false if deferring to the system call is not enabled).
-        if (PointerTable::seen(PointerTable::getData(), reinterpret_cast<size_t>(record))) {
-            return true;
+        PointerTable::Data* data = PointerTable::getData();
+        bool hit = false;
+        if (PointerTable::seen(data, reinterpret_cast<size_t>(record))) {
+            pointerTableHits.increment();
+            hit = true;
+        }
+        else if (_rollingTable[bigHash(region)].access(region, offset, false)) {
+            // We were a miss in the PointerTable but found 'record' in the Rolling table.
+            rollingTableHits.increment();
+            hit = true;
         }
 
-        // We were a miss in the PointerTable. See if we can find 'record' in the Rolling table.
-        if (_rollingTable[bigHash(region)].access(region, offset, false)) {
+        if (hit) {
+            const int sampleInterval = recordAccessTrackerSampleInterval;
+            if (_blockSupported && sampleInterval > 0
+                    && ++data->_hitsSinceSample >= static_cast<unsigned>(sampleInterval)) {
+                data->_hitsSinceSample = 0;
+                sampledHits.increment();
+                if (!ProcessInfo::blockInMemory(const_cast<void*>(record))) {
+                    sampledHitsNotResident.increment();
+                }
+            }
             return true;
         }
 
@@ -339,10 +406,60 @@ namespace mongo {
             // This means we don't fall back to a system call. Instead we assume things aren't
             // in memory. This could mean that we yield too much, but this is much better
             // than the alternative of not yielding through a page fault.
+            misses.increment();
+            return false;
+        }
+
+        systemChecks.increment();
+        const bool resident =
+            (recordAccessTrackerBulkResidencyCheck && mappingBegin && mappingEnd)
+            ? _checkRegionResident(region, offset, mappingBegin, mappingEnd)
+            : ProcessInfo::blockInMemory(const_cast<void*>(record));
+        if (resident) {
+            systemChecksResident.increment();
+        }
+        else {
+            misses.increment();
+        }
+        return resident;
+    }
+
+    bool RecordAccessTracker::_checkRegionResident(size_t region,
+                                                   size_t offset,
+                                                   const void* mappingBegin,
+                                                   const void* mappingEnd) {
+        // Pages of the tracker and of the system must coincide for the answer to be usable.
+        if (ProcessInfo::getPageSize() != (1ULL << kPageShift)) {
+            const size_t page = (region << kPagesPerRegionShift) + offset;
+            return ProcessInfo::blockInMemory(reinterpret_cast<void*>(page << kPageShift));
+        }
+
+        const size_t firstPage = region << kPagesPerRegionShift;
+        const size_t mappingFirstPage = reinterpret_cast<size_t>(mappingBegin) >> kPageShift;
+        const size_t mappingEndPage =
+            ((reinterpret_cast<size_t>(mappingEnd) - 1) >> kPageShift) + 1;
+        const size_t beginPage = std::max(firstPage, mappingFirstPage);
+        const size_t endPage = std::min(firstPage + (1 << kPagesPerRegionShift), mappingEndPage);
+        const size_t page = firstPage + offset;
+        if (page < beginPage || page >= endPage) {
+            return ProcessInfo::blockInMemory(reinterpret_cast<void*>(page << kPageShift));
+        }
+
+        bulkChecks.increment();
+        std::vector<char> resident;
+        if (!ProcessInfo::pagesInMemory(reinterpret_cast<void*>(beginPage << kPageShift),
+                                        endPage - beginPage,
+                                        &resident)) {
             return false;
         }
 
-        return ProcessInfo::blockInMemory(const_cast<void*>(record));
+        Rolling& rolling = _rollingTable[bigHash(region)];
+        for (size_t i = 0; i < resident.size(); i++) {
+            if (resident[i]) {
+                rolling.access(region, (beginPage + i) & 0x3f, true);
+            }
+        }
+        return resident[page - beginPage];
     }
 
     void RecordAccessTracker::disableSystemBlockInMemCheck() {
@@ -30,10 +30,12 @@
 
 #include <boost/scoped_array.hpp>
 
-#include "mongo/util/concurrency/mutex.h"
+#include "mongo/base/disallow_copying.h"
+#include "mongo/platform/atomic_word.h"
 
 namespace mongo {
 
+    class BSONObjBuilder;
     class Record;
 
     /**
@@ -42,6 +44,11 @@ namespace mongo {
      * page fault. The RecordAccessTracker is used to guess at which records are in memory,
      * so that a yield can be requested unless we're sure that the record has been
      * recently accessed.
+     *
+     * Lookups take no locks. The slices of the Rolling tables are open-addressed arrays of
+     * atomic words whose entries are claimed with compare-and-swap. A lookup that races with
+     * the rotation of a slice may get a stale answer. The cost of a wrong answer is at worst
+     * one unneeded yield, or one page fault taken while holding the lock.
      */
     class RecordAccessTracker {
         MONGO_DISALLOW_COPYING(RecordAccessTracker);
@@ -66,14 +73,27 @@ namespace mongo {
          * of true means that 'record' is likely in physical memory.
          *
          * Also has the side effect of marking 'record' as accessed.
+         *
+         * The caller may pass the bounds of the mapping that holds 'record'. If the
+         * recordAccessTrackerBulkResidencyCheck parameter is also set, a miss that falls back
+         * to the system asks about every page of the record's region inside
+         * [mappingBegin, mappingEnd) in one call and marks the resident ones. Then
+         * neighbouring records don't each need their own system call.
          */
-        bool checkAccessedAndMark(const void* record);
+        bool checkAccessedAndMark(const void* record,
+                                  const void* mappingBegin = NULL,
+                                  const void* mappingEnd = NULL);
 
         /**
          * Clears out any history of record accesses.
          */
         void reset();
 
+        /**
+         * Appends the hit, miss and sampled false-positive counts of every tracker in the process.
+         */
+        static void appendStats(BSONObjBuilder* builder);
+
         //
         // For testing.
         //
@@ -91,8 +111,8 @@ namespace mongo {
         };
 
         struct Entry {
-            size_t region;
-            unsigned long long value;
+            AtomicUInt64 region; // 0 if the entry is free
+            AtomicUInt64 value;  // bitmap of the pages of 'region' seen in this slice
         };
 
         /**
@@ -113,13 +133,14 @@ namespace mongo {
              */
             bool put(int regionHash, size_t region, short offset);
 
-            time_t lastReset() const;
-
         private:
+            /**
+             * The entry for 'region', or NULL if there is none. If 'add' and there is none, the
+             * first free entry in the chain is claimed for 'region'.
+             */
             Entry* _get(int start, size_t region, bool add);
 
             Entry _data[SliceSize];
-            time_t _lastReset;
         };
 
         /**
@@ -141,15 +162,25 @@ namespace mongo {
             bool access(size_t region, short offset, bool doHalf);
 
         private:
-            void _rotate();
+            /**
+             * Moves on from 'fromSlice' and clears the new current slice, unless another thread
+             * already got there first.
+             */
+            void _rotate(int fromSlice);
 
-            int _curSlice;
-            long long _lastRotate;
+            AtomicInt32 _curSlice;
+            AtomicInt64 _lastRotate;
             Slice _slices[NumSlices];
-
-            SimpleMutex _lock;
         };
 
+        /**
+         * Asks the system whether the pages of 'region' inside [mappingBegin, mappingEnd) are
+         * resident, and marks the resident ones as accessed. Returns whether the page at
+         * 'offset' is resident, or false if the system call fails.
+         */
+        bool _checkRegionResident(size_t region, size_t offset,
+                                  const void* mappingBegin, const void* mappingEnd);
+
         // Should this record tracker fallback to making a system call?
         bool _blockSupported;
 
@@ -28,6 +28,10 @@
 
 #include "mongo/db/storage/mmap_v1/record_access_tracker.h"
 
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "mongo/db/jsobj.h"
 #include "mongo/db/storage/mmap_v1/record.h"
 #include "mongo/unittest/unittest.h"
 
@@ -39,6 +43,22 @@ namespace {
         return reinterpret_cast<const void*>(data);
     }
 
+    BSONObj stats() {
+        BSONObjBuilder builder;
+        RecordAccessTracker::appendStats(&builder);
+        return builder.obj();
+    }
+
+    long long statDelta(const BSONObj& before, const BSONObj& after, const char* name) {
+        return after[name].numberLong() - before[name].numberLong();
+    }
+
+    void markSuperpages(RecordAccessTracker* tracker, int first, int step, int count) {
+        for (int i = 0; i < count; i++) {
+            tracker->markAccessed(pointerOf((first + i * step) * 0x10000));
+        }
+    }
+
     TEST(RecordAccessTrackerTest, TouchRecordTwice) {
         RecordAccessTracker tracker;
         tracker.disableSystemBlockInMemCheck();
@@ -139,4 +159,42 @@ namespace {
         }
     }
 
+    TEST(RecordAccessTrackerTest, StatsCountHitsAndMisses) {
+        RecordAccessTracker tracker;
+        tracker.disableSystemBlockInMemCheck();
+
+        const BSONObj before = stats();
+        ASSERT_FALSE(tracker.checkAccessedAndMark(pointerOf(0x40000)));
+        ASSERT_TRUE(tracker.checkAccessedAndMark(pointerOf(0x40010)));
+        const BSONObj after = stats();
+
+        ASSERT_EQUALS(1, statDelta(before, after, "misses"));
+        ASSERT_EQUALS(1, statDelta(before, after, "pointerTableHits"));
+        ASSERT_EQUALS(0, statDelta(before, after, "systemChecks"));
+    }
+
+    // Marks made by other threads only reach this thread through the shared Rolling tables,
+    // since the PointerTable is per thread.  Region 0 marks a free entry in those tables, so
+    // the superpages start past it.
+    TEST(RecordAccessTrackerTest, ConcurrentMarksAreSeenByOtherThreads) {
+        RecordAccessTracker tracker;
+        tracker.disableSystemBlockInMemCheck();
+
+        const int kThreads = 8;
+        const int kSuperpagesPerThread = 100;
+        boost::thread_group threads;
+        for (int i = 0; i < kThreads; i++) {
+            threads.create_thread(boost::bind(markSuperpages, &tracker, i + 4, kThreads,
+                                              kSuperpagesPerThread));
+        }
+        threads.join_all();
+
+        const BSONObj before = stats();
+        for (int i = 4; i < 4 + kThreads * kSuperpagesPerThread; i++) {
+            ASSERT_TRUE(tracker.checkAccessedAndMark(pointerOf(i * 0x10000 + 0xA)));
+        }
+        ASSERT_EQUALS(kThreads * kSuperpagesPerThread,
+                      statDelta(before, stats(), "rollingTableHits"));
+    }
+
 }  // namespace
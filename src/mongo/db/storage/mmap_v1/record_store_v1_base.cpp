@@ -32,6 +32,8 @@
 
 #include "mongo/db/storage/mmap_v1/record_store_v1_base.h"
 
+#include <algorithm>
+
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/storage/mmap_v1/extent.h"
@@ -39,6 +41,7 @@
 #include "mongo/db/storage/mmap_v1/record.h"
 #include "mongo/db/storage/mmap_v1/record_store_v1_repair_iterator.h"
 #include "mongo/util/log.h"
+#include "mongo/util/processinfo.h"
 #include "mongo/util/progress_meter.h"
 #include "mongo/util/timer.h"
 #include "mongo/util/touch_pages.h"
@@ -242,6 +245,16 @@ namespace mongo {
         return _extentManager->recordNeedsFetch( DiskLoc::fromRecordId(loc) );
     }
 
+    void RecordStoreV1Base::prefetchRecords( OperationContext* txn,
+                                             const std::vector<RecordId>& locs ) const {
+        std::vector<DiskLoc> diskLocs;
+        diskLocs.reserve( locs.size() );
+        for ( size_t i = 0; i < locs.size(); i++ ) {
+            diskLocs.push_back( DiskLoc::fromRecordId(locs[i]) );
+        }
+        _extentManager->prefetchRecords( diskLocs );
+    }
+
 
     StatusWith<RecordId> RecordStoreV1Base::insertRecord( OperationContext* txn,
                                                           const DocWriter* doc,
@@ -382,11 +395,16 @@ namespace mongo {
         return Status::OK();
     }
 
-    void RecordStoreV1Base::deleteRecord( OperationContext* txn, const RecordId& rid ) {
-        const DiskLoc dl = DiskLoc::fromRecordId(rid);
+    bool RecordStoreV1Base::updateWithDamagesCanGrow( OperationContext* txn,
+                                                      const RecordId& loc,
+                                                      int newSize ) const {
+        // Capped records never grow.  Otherwise the damage can use the record's padding.
+        return !isCapped() && recordFor( DiskLoc::fromRecordId(loc) )->netLength() >= newSize;
+    }
 
+    void RecordStoreV1Base::_removeRecordFromRecListInExtent( OperationContext* txn,
+                                                              const DiskLoc& dl ) {
         Record* todelete = recordFor( dl );
-        invariant( todelete->netLength() >= 4 ); // this is required for defensive code
 
         /* remove ourself from the record next/prev chain */
         {
@@ -422,6 +440,15 @@ namespace mongo {
                     e->lastRecord.set(dl.a(), todelete->prevOfs() );
             }
         }
+    }
+
+    void RecordStoreV1Base::deleteRecord( OperationContext* txn, const RecordId& rid ) {
+        const DiskLoc dl = DiskLoc::fromRecordId(rid);
+
+        Record* todelete = recordFor( dl );
+        invariant( todelete->netLength() >= 4 ); // this is required for defensive code
+
+        _removeRecordFromRecListInExtent( txn, dl );
 
         /* add to the free list */
         {
@@ -736,11 +763,13 @@ namespace mongo {
             int ndel = 0;
             long long delSize = 0;
             BSONArrayBuilder delBucketSizes;
+            BSONArrayBuilder delBuckets;
             int incorrect = 0;
             for ( int i = 0; i < Buckets; i++ ) {
                 DiskLoc loc = _details->deletedListEntry(i);
                 try {
                     int k = 0;
+                    long long bucketBytes = 0;
                     while ( !loc.isNull() ) {
                         if ( recs.count(loc) )
                             incorrect++;
@@ -765,11 +794,18 @@ namespace mongo {
 
                         const DeletedRecord* d = deletedRecordFor(loc);
                         delSize += d->lengthWithHeaders();
+                        bucketBytes += d->lengthWithHeaders();
                         loc = d->nextDeleted();
                         k++;
                         txn->checkForInterrupt();
                     }
                     delBucketSizes << k;
+                    if ( k && !isCapped() ) {
+                        // Free space by size class, to show how fragmented the free lists are.
+                        delBuckets << BSON( "minSize" << ( i ? bucketSizes[i - 1] : 0 )
+                                            << "count" << k
+                                            << "bytes" << bucketBytes );
+                    }
                 }
                 catch (...) {
                     results->errors.push_back( (string)"exception in deleted chain for bucket " +
@@ -779,6 +815,7 @@ namespace mongo {
             }
             output->appendNumber("deletedCount", ndel);
             output->appendNumber("deletedSize", delSize);
+            output->append( "deletedBuckets", delBuckets.arr() );
             if ( full ) {
                 output->append( "delBucketSizes", delBucketSizes.arr() );
             }
@@ -815,6 +852,42 @@ namespace mongo {
     }
 
 
+    bool RecordStoreV1Base::appendCacheStats(OperationContext* txn,
+                                             BSONObjBuilder* result,
+                                             double scale) const {
+        if (!ProcessInfo::blockCheckSupported()) {
+            return false;
+        }
+
+        // Pages asked about per call, which bounds the residency vector.
+        const size_t kPagesPerCheck = 4096;
+        const size_t pageSize = ProcessInfo::getPageSize();
+
+        long long bytesInCache = 0;
+        std::vector<char> resident;
+        for (DiskLoc extLoc = _details->firstExtent(txn); !extLoc.isNull();) {
+            const Extent* ext = _getExtent(txn, extLoc);
+            const char* start =
+                static_cast<const char*>(ProcessInfo::alignToStartOfPage(ext));
+            const char* end = reinterpret_cast<const char*>(ext) + ext->length;
+            const size_t numPages = (end - start + pageSize - 1) / pageSize;
+
+            for (size_t page = 0; page < numPages; page += kPagesPerCheck) {
+                const size_t count = std::min(kPagesPerCheck, numPages - page);
+                if (!ProcessInfo::pagesInMemory(start + page * pageSize, count, &resident)) {
+                    return false;
+                }
+                bytesInCache += std::count(resident.begin(), resident.end(), 1) * pageSize;
+            }
+
+            txn->checkForInterrupt();
+            extLoc = ext->xnext;
+        }
+
+        result->appendNumber("bytesInCache", static_cast<long long>(bytesInCache / scale));
+        return true;
+    }
+
     namespace {
         struct touch_location {
             const char* root;
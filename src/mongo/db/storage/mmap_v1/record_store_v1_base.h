@@ -142,6 +142,9 @@ namespace mongo {
         virtual RecordFetcher* recordNeedsFetch( OperationContext* txn,
                                                  const RecordId& loc ) const;
 
+        virtual void prefetchRecords( OperationContext* txn,
+                                      const std::vector<RecordId>& locs ) const;
+
         StatusWith<RecordId> insertRecord( OperationContext* txn,
                                            const char* data,
                                            int len,
@@ -164,6 +167,10 @@ namespace mongo {
                                           const char* damageSource,
                                           const mutablebson::DamageVector& damages );
 
+        virtual bool updateWithDamagesCanGrow( OperationContext* txn,
+                                               const RecordId& loc,
+                                               int newSize ) const;
+
         virtual RecordIterator* getIteratorForRepair( OperationContext* txn ) const;
 
         void increaseStorageSize( OperationContext* txn, int size, bool enforceQuota );
@@ -177,6 +184,14 @@ namespace mongo {
                                         BSONObjBuilder* result,
                                         double scale ) const;
 
+        /**
+         * Estimates the bytes of this record store's extents which are resident, by asking the
+         * operating system which of their pages are in memory.
+         */
+        virtual bool appendCacheStats(OperationContext* txn,
+                                      BSONObjBuilder* result,
+                                      double scale) const;
+
         virtual Status touch( OperationContext* txn, BSONObjBuilder* output ) const;
 
         const RecordStoreV1MetaData* details() const { return _details.get(); }
@@ -244,6 +259,11 @@ namespace mongo {
         */
         void _addRecordToRecListInExtent(OperationContext* txn, Record* r, DiskLoc loc);
 
+        /** remove the record at 'dl' from the linked list chain within its extent.
+            the space is not added to a deleted list.
+        */
+        void _removeRecordFromRecListInExtent(OperationContext* txn, const DiskLoc& dl);
+
         /**
          * internal
          * doesn't check inputs or change padding
@@ -65,6 +65,9 @@ namespace mongo {
     static ServerStatusMetricField<Counter64> dFreelist3( "storage.freelist.search.scanned",
                                                           &freelistIterations );
 
+    // How many free records inside an excluded extent allocation will pass over in one bucket.
+    static const int kMaxExcludedPerBucket = 64;
+
     SimpleRecordStoreV1::SimpleRecordStoreV1( OperationContext* txn,
                                               const StringData& ns,
                                               RecordStoreV1MetaData* details,
@@ -74,13 +77,18 @@ namespace mongo {
 
         invariant( !details->isCapped() );
         _normalCollection = NamespaceString::normal( ns );
+
+        for ( int i = 0; i < Buckets; i++ ) {
+            _headLengths[i].length = 0;
+        }
     }
 
     SimpleRecordStoreV1::~SimpleRecordStoreV1() {
     }
 
     DiskLoc SimpleRecordStoreV1::_allocFromExistingExtents( OperationContext* txn,
-                                                            int lenToAllocRaw ) {
+                                                            int lenToAllocRaw,
+                                                            const DiskLoc& excludedExtent ) {
 
         // Slowly drain the deletedListLegacyGrabBag by popping one record off and putting it in the
         // correct deleted list each time we try to allocate a new record. This ensures we won't
@@ -102,26 +110,56 @@ namespace mongo {
         DiskLoc loc;
         DeletedRecord* dr = NULL;
         {
+            // When not null, the entry before 'dr' in its deleted list.
+            DeletedRecord* prev = NULL;
 
             int myBucket;
             for (myBucket = bucket(lenToAlloc); myBucket < Buckets; myBucket++) {
                 // Only look at the first entry in each bucket. This works because we are either
                 // quantizing or allocating fixed-size blocks.
-                const DiskLoc head = _details->deletedListEntry(myBucket);
+                DiskLoc head = _details->deletedListEntry(myBucket);
                 if (head.isNull()) continue;
+
+                // Unless that entry is in the excluded extent, in which case we look a little
+                // further down the list for the first one that is not.
+                for (int skipped = 0;
+                     !excludedExtent.isNull() && !head.isNull()
+                         && DiskLoc(head.a(), drec(head)->extentOfs()) == excludedExtent;
+                     skipped++) {
+                    if (skipped == kMaxExcludedPerBucket) {
+                        head = DiskLoc();
+                        break;
+                    }
+                    prev = drec(head);
+                    head = prev->nextDeleted();
+                }
+                if (head.isNull()) {
+                    prev = NULL;
+                    continue;
+                }
+
+                if (!prev && _headLength(myBucket, head) < lenToAlloc) continue;
                 DeletedRecord* const candidate = drec(head);
                 if (candidate->lengthWithHeaders() >= lenToAlloc) {
                     loc = head;
                     dr = candidate;
                     break;
                 }
+                if (!prev) {
+                    // The cached length was stale.
+                    _headLengths[myBucket].length = candidate->lengthWithHeaders();
+                }
+                prev = NULL;
             }
 
             if (!dr)
                 return DiskLoc(); // no space
 
             // Unlink ourself from the deleted list
-            _details->setDeletedListEntry(txn, myBucket, dr->nextDeleted());
+            if (prev)
+                *txn->recoveryUnit()->writing(&prev->nextDeleted()) = dr->nextDeleted();
+            else
+                _details->setDeletedListEntry(txn, myBucket, dr->nextDeleted());
             *txn->recoveryUnit()->writing(&dr->nextDeleted()) = DiskLoc().setInvalid(); // defensive
         }
 
@@ -226,6 +264,108 @@ namespace mongo {
         return Status::OK();
     }
 
+    Status SimpleRecordStoreV1::compactTail( OperationContext* txn,
+                                             int maxRecords,
+                                             UpdateMoveNotifier* notifier,
+                                             RecordStoreCompactAdaptor* adaptor,
+                                             CompactTailStats* stats ) {
+        const DiskLoc tailLoc = _details->lastExtent(txn);
+        if ( tailLoc.isNull() || tailLoc == _details->firstExtent(txn) ) {
+            // Nothing to give back: the first extent is never freed.
+            stats->done = true;
+            return Status::OK();
+        }
+
+        Extent* const tail = _getExtent(txn, tailLoc);
+        for ( int i = 0; i < maxRecords && !tail->firstRecord.isNull(); i++ ) {
+            const DiskLoc oldLoc = tail->firstRecord;
+            Record* const oldRecord = recordFor(oldLoc);
+            const RecordData oldData = oldRecord->toRecordData();
+
+            const int lenWHdr = adaptor->dataSize(oldData) + Record::HeaderSize;
+            const int lenToAlloc = shouldPadInserts() ? quantizeAllocationSpace(lenWHdr)
+                                                      : lenWHdr;
+
+            const DiskLoc newLoc = _allocFromExistingExtents(txn, lenToAlloc, tailLoc);
+            if ( newLoc.isNull() ) {
+                // No room for it without growing the collection, which would defeat the point.
+                stats->done = true;
+                return Status::OK();
+            }
+
+            Record* newRecord = recordFor(newLoc);
+            fassert( 28621, newRecord->lengthWithHeaders() >= lenWHdr );
+            newRecord = reinterpret_cast<Record*>(
+                txn->recoveryUnit()->writingPtr(newRecord, lenWHdr) );
+            memcpy( newRecord->data(), oldData.data(), lenWHdr - Record::HeaderSize );
+            _addRecordToRecListInExtent(txn, newRecord, newLoc);
+            _details->incrementStats( txn, newRecord->netLength(), 1 );
+
+            Status status = notifier->recordStoreGoingToMove( txn,
+                                                              oldLoc.toRecordId(),
+                                                              oldRecord->data(),
+                                                              oldRecord->netLength() );
+            if ( !status.isOK() )
+                return status;
+
+            // The old space stays out of the deleted lists so that nothing is allocated in the
+            // extent we are trying to empty.
+            _removeRecordFromRecListInExtent(txn, oldLoc);
+            _details->incrementStats( txn, -1 * oldRecord->netLength(), -1 );
+
+            adaptor->inserted( newRecord->toRecordData(), newLoc.toRecordId() );
+            stats->recordsMoved++;
+        }
+
+        if ( tail->firstRecord.isNull() ) {
+            _freeEmptyLastExtent(txn);
+            stats->extentsFreed++;
+        }
+
+        return Status::OK();
+    }
+
+    void SimpleRecordStoreV1::_freeEmptyLastExtent( OperationContext* txn ) {
+        const DiskLoc extLoc = _details->lastExtent(txn);
+        Extent* const ext = _getExtent(txn, extLoc);
+        invariant( ext->firstRecord.isNull() );
+
+        const DiskLoc prevLoc = ext->xprev;
+        invariant( !prevLoc.isNull() );
+        Extent* const prevExt = _getExtent(txn, prevLoc);
+
+        // Drop the extent's free space from the deleted lists, including the legacy grab bag.
+        for ( int b = -1; b < Buckets; b++ ) {
+            DeletedRecord* prev = NULL;
+            DiskLoc loc = b < 0 ? _details->deletedListLegacyGrabBag()
+                                : _details->deletedListEntry(b);
+            while ( !loc.isNull() ) {
+                DeletedRecord* const d = drec(loc);
+                const DiskLoc next = d->nextDeleted();
+                if ( DiskLoc(loc.a(), d->extentOfs()) != extLoc ) {
+                    prev = d;
+                }
+                else if ( prev ) {
+                    *txn->recoveryUnit()->writing(&prev->nextDeleted()) = next;
+                }
+                else if ( b < 0 ) {
+                    _details->setDeletedListLegacyGrabBag(txn, next);
+                }
+                else {
+                    _details->setDeletedListEntry(txn, b, next);
+                }
+                loc = next;
+                txn->checkForInterrupt();
+            }
+        }
+
+        *txn->recoveryUnit()->writing(&prevExt->xnext) = DiskLoc();
+        _details->setLastExtent(txn, prevLoc);
+        _details->setLastExtentSize(txn, prevExt->length);
+
+        _extentManager->freeExtent(txn, extLoc);
+    }
+
     void SimpleRecordStoreV1::addDeletedRec( OperationContext* txn, const DiskLoc& dloc ) {
         DeletedRecord* d = drec( dloc );
 
@@ -234,6 +374,19 @@ namespace mongo {
         int b = bucket(d->lengthWithHeaders());
         *txn->recoveryUnit()->writing(&d->nextDeleted()) = _details->deletedListEntry(b);
         _details->setDeletedListEntry(txn, b, dloc);
+
+        _headLengths[b].loc = dloc;
+        _headLengths[b].length = d->lengthWithHeaders();
+    }
+
+    int SimpleRecordStoreV1::_headLength( int b, const DiskLoc& head ) {
+        HeadLength& cached = _headLengths[b];
+        if ( cached.loc != head ) {
+            freelistIterations.increment();
+            cached.loc = head;
+            cached.length = drec(head)->lengthWithHeaders();
+        }
+        return cached.length;
     }
 
     RecordIterator* SimpleRecordStoreV1::getIterator( OperationContext* txn,
@@ -67,6 +67,17 @@ namespace mongo {
                                 const CompactOptions* options,
                                 CompactStats* stats );
 
+        /**
+         * Moves records out of the last extent into free space in the others, and frees the
+         * last extent once it is empty.  The space moved records leave behind is not reused in
+         * the meantime, so it is only reclaimed once the whole extent is freed.
+         */
+        virtual Status compactTail( OperationContext* txn,
+                                    int maxRecords,
+                                    UpdateMoveNotifier* notifier,
+                                    RecordStoreCompactAdaptor* adaptor,
+                                    CompactTailStats* stats );
+
     protected:
         virtual bool isCapped() const { return false; }
         virtual bool shouldPadInserts() const { return !_details->isUserFlagSet(Flag_NoPadding); }
@@ -78,8 +89,19 @@ namespace mongo {
         virtual void addDeletedRec(OperationContext* txn,
                                    const DiskLoc& dloc);
     private:
+        /**
+         * Takes space for a record from the deleted lists.  Free space inside 'excludedExtent',
+         * if it is not null, is passed over.
+         */
         DiskLoc _allocFromExistingExtents( OperationContext* txn,
-                                           int lengthWithHeaders );
+                                           int lengthWithHeaders,
+                                           const DiskLoc& excludedExtent = DiskLoc() );
+
+        /**
+         * Unlinks the empty last extent from this record store, drops its free space from the
+         * deleted lists and gives it back to the ExtentManager.
+         */
+        void _freeEmptyLastExtent( OperationContext* txn );
 
         void _compactExtent(OperationContext* txn,
                             const DiskLoc diskloc,
@@ -88,8 +110,26 @@ namespace mongo {
                             const CompactOptions* compactOptions,
                             CompactStats* stats );
 
+        /**
+         * Returns the length of the DeletedRecord at 'head', the current head of bucket 'b',
+         * reading it from _headLengths when the cached entry is for the same location.
+         */
+        int _headLength(int b, const DiskLoc& head);
+
         bool _normalCollection;
 
+        /**
+         * The head of each deleted list and its length, as last seen by this store.  Allocation
+         * uses it to pass over heads which are too small without paging in their records.  An
+         * entry is only trusted when its location matches the on-disk head, and the record that
+         * is finally chosen is always checked on disk, so stale entries can only cost a read.
+         */
+        struct HeadLength {
+            DiskLoc loc;
+            int length;
+        };
+        HeadLength _headLengths[Buckets];
+
         friend class SimpleRecordStoreV1Iterator;
     };
 
@@ -30,6 +30,7 @@
 
 #include "mongo/db/storage/mmap_v1/record_store_v1_simple.h"
 
+#include "mongo/db/catalog/collection.h"
 #include "mongo/db/operation_context_noop.h"
 #include "mongo/db/storage/mmap_v1/extent.h"
 #include "mongo/db/storage/mmap_v1/record.h"
@@ -370,6 +371,45 @@ namespace {
         }
     }
 
+    /**
+     * alloc() with non quantized size passes over a bucket whose head is too small, and keeps
+     * using the free lists correctly as their heads change.
+     */
+    TEST(SimpleRecordStoreV1, AllocNonQuantizedSkipsTooSmallHead) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        {
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 1000), 260},
+                {DiskLoc(0, 2000), 600},
+                {}
+            };
+            initializeV1RS(&txn, NULL, drecs, NULL, &em, md);
+        }
+
+        BsonDocWriter docWriter(docForRecordSize( 300 ), false);
+        StatusWith<RecordId> first = rs.insertRecord(&txn, &docWriter, false);
+        ASSERT_OK( first.getStatus() );
+        StatusWith<RecordId> second = rs.insertRecord(&txn, &docWriter, false);
+        ASSERT_OK( second.getStatus() );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 2000), 300},
+                {DiskLoc(0, 2300), 300},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 1000), 260},
+                {}
+            };
+            assertStateV1RS(&txn, recs, drecs, NULL, &em, md);
+        }
+    }
+
     /**
      * alloc() will use from the legacy grab bag if it can.
      */
@@ -561,4 +601,123 @@ namespace {
             assertStateV1RS(&txn, recs, drecs, NULL, &em, md);
         }
     }
+
+    // -----------------
+
+    class CompactTailSpy : public UpdateMoveNotifier, public RecordStoreCompactAdaptor {
+    public:
+        virtual Status recordStoreGoingToMove( OperationContext* txn,
+                                               const RecordId& oldLocation,
+                                               const char* oldBuffer,
+                                               size_t oldSize ) {
+            moved.push_back( DiskLoc::fromRecordId( oldLocation ) );
+            return Status::OK();
+        }
+
+        virtual bool isDataValid( const RecordData& recData ) { return true; }
+        virtual size_t dataSize( const RecordData& recData ) { return recData.size(); }
+
+        virtual void inserted( const RecordData& recData, const RecordId& newLocation ) {
+            newLocations.push_back( DiskLoc::fromRecordId( newLocation ) );
+        }
+
+        std::vector<DiskLoc> moved;
+        std::vector<DiskLoc> newLocations;
+    };
+
+    /**
+     * compactTail() moves the last extent's records into free space in the other extents, never
+     * into the last extent's own free space, and frees the last extent once it is empty.
+     */
+    TEST( SimpleRecordStoreV1, CompactTailFreesLastExtent ) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 100},
+                {DiskLoc(1, 1000), 100},
+                {DiskLoc(1, 1100), 100},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(1, 1200), 500},
+                {DiskLoc(0, 1100), 1000},
+                {}
+            };
+            initializeV1RS(&txn, recs, drecs, NULL, &em, md);
+        }
+
+        CompactTailSpy spy;
+        CompactTailStats stats;
+
+        // One record per step: the extent is only freed by the step that empties it.
+        ASSERT_OK( rs.compactTail( &txn, 1, &spy, &spy, &stats ) );
+        ASSERT_EQUALS( 1, stats.recordsMoved );
+        ASSERT_EQUALS( 0, stats.extentsFreed );
+        ASSERT_OK( rs.compactTail( &txn, 1, &spy, &spy, &stats ) );
+        ASSERT_EQUALS( 2, stats.recordsMoved );
+        ASSERT_EQUALS( 1, stats.extentsFreed );
+        ASSERT_FALSE( stats.done );
+
+        ASSERT_OK( rs.compactTail( &txn, 1, &spy, &spy, &stats ) );
+        ASSERT_TRUE( stats.done );
+
+        ASSERT_EQUALS( 2U, spy.moved.size() );
+        ASSERT_EQUALS( DiskLoc(1, 1000), spy.moved[0] );
+        ASSERT_EQUALS( DiskLoc(1, 1100), spy.moved[1] );
+        ASSERT_EQUALS( 2U, spy.newLocations.size() );
+        ASSERT_EQUALS( DiskLoc(0, 1100), spy.newLocations[0] );
+        ASSERT_EQUALS( DiskLoc(0, 1228), spy.newLocations[1] );
+        ASSERT_EQUALS( 3, md->numRecords() );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 100},
+                {DiskLoc(0, 1100), 128},
+                {DiskLoc(0, 1228), 128},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 1356), 744},
+                {}
+            };
+            assertStateV1RS(&txn, recs, drecs, NULL, &em, md);
+            ASSERT_EQUALS( DiskLoc(0, 0), md->lastExtent(&txn) );
+        }
+    }
+
+    /**
+     * compactTail() stops, leaving everything in place, when there is no room outside the last
+     * extent.
+     */
+    TEST( SimpleRecordStoreV1, CompactTailStopsWithoutRoom ) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        LocAndSize recs[] = {
+            {DiskLoc(0, 1000), 100},
+            {DiskLoc(1, 1000), 100},
+            {}
+        };
+        LocAndSize drecs[] = {
+            {DiskLoc(0, 1100), 100},
+            {DiskLoc(1, 1100), 1000},
+            {}
+        };
+        initializeV1RS(&txn, recs, drecs, NULL, &em, md);
+
+        CompactTailSpy spy;
+        CompactTailStats stats;
+        ASSERT_OK( rs.compactTail( &txn, 10, &spy, &spy, &stats ) );
+        ASSERT_TRUE( stats.done );
+        ASSERT_EQUALS( 0, stats.recordsMoved );
+        ASSERT_TRUE( spy.moved.empty() );
+
+        assertStateV1RS(&txn, recs, drecs, NULL, &em, md);
+    }
 }
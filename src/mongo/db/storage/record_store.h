@@ -44,6 +44,7 @@ namespace mongo {
     class Collection;
     struct CompactOptions;
     struct CompactStats;
+    struct CompactTailStats;
     class DocWriter;
     class MAdvise;
     class NamespaceDetails;
@@ -113,6 +114,11 @@ namespace mongo {
         // normally this will just go back to the RecordStore and convert
         // but this gives the iterator an oppurtnity to optimize
         virtual RecordData dataFor( const RecordId& loc ) const = 0;
+
+        // Like dataFor(curr()), but the data may be memory which the storage engine owns rather
+        // than a copy of it.  Unless the result isOwned(), it is only valid until the iterator
+        // next moves, saves its state or is destroyed.
+        virtual RecordData currData() { return dataFor(curr()); }
     };
 
 
@@ -169,6 +175,31 @@ namespace mongo {
                                                   const DocWriter* doc,
                                                   bool enforceQuota ) = 0;
 
+        /**
+         * Inserts every record in 'records', appending their locations to 'locsOut' in the same
+         * order.  On failure, the records already inserted are left for the caller's
+         * WriteUnitOfWork to roll back.
+         *
+         * The default implementation calls insertRecord() once per record.  Engines which can
+         * amortize the per-insert overhead over a batch (one cursor, a reserved range of
+         * RecordIds) override this.
+         */
+        virtual Status insertRecords( OperationContext* txn,
+                                      const std::vector<RecordData>& records,
+                                      bool enforceQuota,
+                                      std::vector<RecordId>* locsOut ) {
+            for ( size_t i = 0; i < records.size(); i++ ) {
+                StatusWith<RecordId> loc = insertRecord( txn,
+                                                         records[i].data(),
+                                                         records[i].size(),
+                                                         enforceQuota );
+                if ( !loc.isOK() )
+                    return loc.getStatus();
+                locsOut->push_back( loc.getValue() );
+            }
+            return Status::OK();
+        }
+
         /**
          * @param notifier - this is called if the document is moved
          *                   it is to be called after the document has been written to new
@@ -188,6 +219,31 @@ namespace mongo {
                                           const char* damageSource,
                                           const mutablebson::DamageVector& damages ) = 0;
 
+        /**
+         * Returns true if updateWithDamages() can apply damages which grow the record at 'loc'
+         * to 'newSize' bytes, as appending a field to a document does.  Callers must not pass
+         * damages extending past the end of a record unless this returned true.
+         */
+        virtual bool updateWithDamagesCanGrow( OperationContext* txn,
+                                               const RecordId& loc,
+                                               int newSize ) const {
+            return false;
+        }
+
+        /**
+         * Returns true if applying 'damages' to the record at 'loc' would leave a document that
+         * belongs somewhere else in this record store, as a partitioned one decides from the
+         * document. Callers then have to write out the whole document with updateRecord().
+         */
+        virtual bool updateWithDamagesMovesRecord(
+                OperationContext* txn,
+                const RecordId& loc,
+                const RecordData& oldRec,
+                const char* damageSource,
+                const mutablebson::DamageVector& damages ) const {
+            return false;
+        }
+
         /**
          * Storage engines which do not support document-level locking hold locks at
          * collection or database granularity. As an optimization, these locks can be yielded
@@ -206,6 +262,16 @@ namespace mongo {
         virtual RecordFetcher* recordNeedsFetch( OperationContext* txn,
                                                  const RecordId& loc ) const { return NULL; }
 
+        /**
+         * Hints that the records at 'locs' are about to be read, so that a storage engine which
+         * reads from secondary storage can start bringing them in, in whatever order suits its
+         * layout, before they are asked for one at a time.  Must not block on the reads.
+         *
+         * Storage engines which do not benefit from the hint need not implement this.
+         */
+        virtual void prefetchRecords( OperationContext* txn,
+                                      const std::vector<RecordId>& locs ) const { }
+
         /**
          * returned iterator owned by caller
          * Default arguments return all items in record store.
@@ -231,6 +297,15 @@ namespace mongo {
          */
         virtual std::vector<RecordIterator*> getManyIterators( OperationContext* txn ) const = 0;
 
+        /**
+         * Returns an iterator which, instead of walking the store in order, jumps to a
+         * pseudo-randomly chosen record on each getNext().  It may return the same record more than
+         * once and is only EOF when the store is empty.  Returns NULL if not supported.
+         */
+        virtual RecordIterator* getRandomIterator( OperationContext* txn ) const {
+            return NULL;
+        }
+
         // higher level
 
 
@@ -257,6 +332,27 @@ namespace mongo {
                                 const CompactOptions* options,
                                 CompactStats* stats ) = 0;
 
+        /**
+         * Does one step of an online compaction: moves up to 'maxRecords' records out of the
+         * storage at the end of the record store into free space elsewhere in it, and gives that
+         * storage back once nothing is left in it.  Unlike compact(), this is meant to be called
+         * repeatedly, one short write unit of work at a time, while the collection stays in use.
+         *
+         * 'notifier' is told before each record moves and adaptor->inserted() is called once it
+         * is at its new location.  stats->done is set when there is nothing more to do.
+         *
+         * If the underlying storage engine does not support the operation,
+         * returns ErrorCodes::CommandNotSupported
+         */
+        virtual Status compactTail( OperationContext* txn,
+                                    int maxRecords,
+                                    UpdateMoveNotifier* notifier,
+                                    RecordStoreCompactAdaptor* adaptor,
+                                    CompactTailStats* stats ) {
+            return Status(ErrorCodes::CommandNotSupported,
+                          "this storage engine does not support online compaction");
+        }
+
         /**
          * @param full - does more checks
          * @param scanData - scans each document
@@ -277,6 +373,20 @@ namespace mongo {
                                         BSONObjBuilder* result,
                                         double scale ) const = 0;
 
+        /**
+         * Appends what the storage engine knows about how this record store uses its cache:
+         * bytes resident, bytes and pages read into and written from the cache, evictions and
+         * cursor operation counts, as far as the engine keeps them. Byte counts are divided by
+         * 'scale'.
+         *
+         * Returns false, appending nothing, if the storage engine keeps no such statistics.
+         */
+        virtual bool appendCacheStats(OperationContext* txn,
+                                      BSONObjBuilder* result,
+                                      double scale) const {
+            return false;
+        }
+
         /**
          * Load all data into cache.
          * What cache depends on implementation.
@@ -0,0 +1,355 @@
+// record_store_bm.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "mongo/bson/mutable/damage_vector.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/db/storage/record_store_test_harness.h"
+#include "mongo/platform/random.h"
+#include "mongo/unittest/benchmark.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+namespace {
+
+    /**
+     * Record store operations, timed against whichever engine's newHarnessHelper() the benchmark
+     * program is linked with, so that the engines can be compared on the same workloads.  Every
+     * operation's latency is recorded for the percentiles.
+     */
+
+    const int kRecordSize = 128;
+
+    /**
+     * A record store and the records it was filled with.  Filling a large store takes much
+     * longer than a sample, so fixtures are built once and shared by the samples and the
+     * benchmarks that don't change the number of records.
+     */
+    struct Fixture {
+        boost::scoped_ptr<HarnessHelper> harness;
+        boost::scoped_ptr<RecordStore> rs;
+        std::vector<RecordId> locs;
+
+        // Stands in for the collection lock on engines without document level locking, which
+        // leave it to their callers to keep writers apart.
+        boost::shared_mutex collectionLock;
+        bool docLocking;
+    };
+
+    class FixtureRegistry {
+    public:
+        ~FixtureRegistry() {
+            for (std::map<std::string, Fixture*>::iterator it = _fixtures.begin();
+                    it != _fixtures.end(); ++it) {
+                delete it->second;
+            }
+        }
+
+        Fixture* get(const std::string& name, long long numRecords, int recordSize) {
+            Fixture*& fixture = _fixtures[name];
+            if (!fixture) {
+                fixture = new Fixture();
+                fixture->harness.reset(newHarnessHelper());
+                fixture->rs.reset(fixture->harness->newNonCappedRecordStore());
+                fixture->docLocking = fixture->harness->supportsDocLocking();
+                fill(fixture, numRecords, recordSize);
+            }
+            return fixture;
+        }
+
+    private:
+        static void fill(Fixture* fixture, long long numRecords, int recordSize) {
+            const boost::scoped_ptr<OperationContext> txn(fixture->harness->newOperationContext());
+            const std::string record(recordSize, 'r');
+            const long long kBatch = 1000;
+            for (long long i = 0; i < numRecords; i += kBatch) {
+                WriteUnitOfWork wuow(txn.get());
+                for (long long j = i; j < std::min(numRecords, i + kBatch); j++) {
+                    StatusWith<RecordId> loc =
+                        fixture->rs->insertRecord(txn.get(), record.c_str(), recordSize, false);
+                    invariant(loc.isOK());
+                    fixture->locs.push_back(loc.getValue());
+                }
+                wuow.commit();
+            }
+        }
+
+        std::map<std::string, Fixture*> _fixtures;
+    } fixtures;
+
+    Fixture* getFixture(const char* benchmark, long long numRecords) {
+        return fixtures.get(str::stream() << benchmark << '/' << numRecords,
+                            numRecords,
+                            kRecordSize);
+    }
+
+    size_t pick(PseudoRandom& random, size_t n) {
+        return static_cast<uint32_t>(random.nextInt32()) % n;
+    }
+
+    /**
+     * Takes the fixture's collection lock, shared for readers, unless the engine locks
+     * documents itself.
+     */
+    class CollectionLock {
+    public:
+        CollectionLock(Fixture* fixture, bool write)
+            : _lock(fixture->docLocking ? NULL : &fixture->collectionLock),
+              _write(write) {
+            if (!_lock) {
+                return;
+            }
+            if (_write) {
+                _lock->lock();
+            }
+            else {
+                _lock->lock_shared();
+            }
+        }
+
+        ~CollectionLock() {
+            if (!_lock) {
+                return;
+            }
+            if (_write) {
+                _lock->unlock();
+            }
+            else {
+                _lock->unlock_shared();
+            }
+        }
+
+    private:
+        boost::shared_mutex* const _lock;
+        const bool _write;
+    };
+
+    void findRecord(OperationContext* txn, Fixture* fixture, const RecordId& loc) {
+        CollectionLock lk(fixture, false);
+        RecordData rd;
+        invariant(fixture->rs->findRecord(txn, loc, &rd));
+        invariant(rd.size() > 0);
+        // Let go of the snapshot, as the end of a query would.
+        txn->recoveryUnit()->commitAndRestart();
+    }
+
+    void insertRecord(OperationContext* txn, Fixture* fixture, const std::string& record) {
+        CollectionLock lk(fixture, true);
+        for (;;) {
+            try {
+                WriteUnitOfWork wuow(txn);
+                invariant(fixture->rs->insertRecord(txn, record.c_str(), record.size(),
+                                                    false).isOK());
+                wuow.commit();
+                return;
+            }
+            catch (const WriteConflictException&) {
+            }
+        }
+    }
+
+    /**
+     * Overwrites the first 8 bytes of the record at 'loc' in place, retrying on write
+     * conflicts as the update path does.
+     */
+    void updateRecordInPlace(OperationContext* txn, Fixture* fixture, const RecordId& loc,
+                             long long value) {
+        mutablebson::DamageVector damages(1);
+        damages[0].sourceOffset = 0;
+        damages[0].targetOffset = 0;
+        damages[0].size = sizeof(value);
+
+        CollectionLock lk(fixture, true);
+        for (;;) {
+            try {
+                WriteUnitOfWork wuow(txn);
+                const RecordData old = fixture->rs->dataFor(txn, loc);
+                invariant(fixture->rs->updateWithDamages(txn, loc, old,
+                                                         reinterpret_cast<const char*>(&value),
+                                                         damages).isOK());
+                wuow.commit();
+                return;
+            }
+            catch (const WriteConflictException&) {
+            }
+        }
+    }
+
+    MONGO_BENCHMARK_WITH_ARGS(RecordStoreInsert, "128,1024,16384") {
+        Fixture* fixture = fixtures.get(str::stream() << "insert/" << state.arg(), 0, 0);
+        const boost::scoped_ptr<OperationContext> txn(fixture->harness->newOperationContext());
+        const std::string record(state.arg(), 'i');
+
+        while (state.keepRunning()) {
+            const long long start = Timer::nowNanos();
+            insertRecord(txn.get(), fixture, record);
+            state.recordLatency(Timer::nowNanos() - start);
+        }
+    }
+
+    MONGO_BENCHMARK_WITH_ARGS(RecordStoreFindRecord, "1000,100000") {
+        Fixture* fixture = getFixture("records", state.arg());
+        const boost::scoped_ptr<OperationContext> txn(fixture->harness->newOperationContext());
+        PseudoRandom random(1);
+
+        while (state.keepRunning()) {
+            const RecordId& loc = fixture->locs[pick(random, fixture->locs.size())];
+            const long long start = Timer::nowNanos();
+            findRecord(txn.get(), fixture, loc);
+            state.recordLatency(Timer::nowNanos() - start);
+        }
+    }
+
+    // Reads 'arg' records in order from a random start in a store of 100000.
+    MONGO_BENCHMARK_WITH_ARGS(RecordStoreRangeScan, "10,1000") {
+        Fixture* fixture = getFixture("records", 100000);
+        const boost::scoped_ptr<OperationContext> txn(fixture->harness->newOperationContext());
+        PseudoRandom random(1);
+        state.setItemsPerIteration(state.arg());
+
+        while (state.keepRunning()) {
+            const RecordId& loc = fixture->locs[pick(random, fixture->locs.size() - state.arg())];
+            const long long start = Timer::nowNanos();
+            {
+                CollectionLock lk(fixture, false);
+                const boost::scoped_ptr<RecordIterator> it(fixture->rs->getIterator(txn.get(),
+                                                                                    loc));
+                for (long long i = 0; i < state.arg() && !it->isEOF(); i++) {
+                    state.doNotOptimize(it->dataFor(it->getNext()).size());
+                }
+            }
+            txn->recoveryUnit()->commitAndRestart();
+            state.recordLatency(Timer::nowNanos() - start);
+        }
+    }
+
+    MONGO_BENCHMARK_WITH_ARGS(RecordStoreUpdateWithDamages, "1000,100000") {
+        Fixture* fixture = getFixture("records", state.arg());
+        const boost::scoped_ptr<OperationContext> txn(fixture->harness->newOperationContext());
+        PseudoRandom random(1);
+
+        long long value = 0;
+        while (state.keepRunning()) {
+            const RecordId& loc = fixture->locs[pick(random, fixture->locs.size())];
+            const long long start = Timer::nowNanos();
+            updateRecordInPlace(txn.get(), fixture, loc, value++);
+            state.recordLatency(Timer::nowNanos() - start);
+        }
+    }
+
+    // Yields a collection scan between every record, as a query does between batches.
+    MONGO_BENCHMARK_WITH_ARGS(RecordStoreSaveRestore, "1000,100000") {
+        Fixture* fixture = getFixture("records", state.arg());
+        const boost::scoped_ptr<OperationContext> txn(fixture->harness->newOperationContext());
+        boost::scoped_ptr<RecordIterator> it(fixture->rs->getIterator(txn.get()));
+
+        while (state.keepRunning()) {
+            const long long start = Timer::nowNanos();
+            it->saveState();
+            txn->recoveryUnit()->commitAndRestart();
+            invariant(it->restoreState(txn.get()));
+            if (it->isEOF()) {
+                it.reset(fixture->rs->getIterator(txn.get()));
+            }
+            state.doNotOptimize(it->getNext());
+            state.recordLatency(Timer::nowNanos() - start);
+        }
+    }
+
+    const int kMixedOpsPerThread = 100;
+
+    /**
+     * One thread's share of an iteration of RecordStoreMixedWorkload: 80% point lookups, 10%
+     * in place updates and 10% inserts.
+     */
+    void runMixedOps(Fixture* fixture, int32_t seed, std::vector<long long>* latencyNanos) {
+        const boost::scoped_ptr<OperationContext> txn(fixture->harness->newOperationContext());
+        const std::string record(kRecordSize, 'm');
+        PseudoRandom random(seed);
+
+        for (int i = 0; i < kMixedOpsPerThread; i++) {
+            const int op = pick(random, 10);
+            const RecordId& loc = fixture->locs[pick(random, fixture->locs.size())];
+            const long long start = Timer::nowNanos();
+            if (op < 8) {
+                findRecord(txn.get(), fixture, loc);
+            }
+            else if (op == 8) {
+                updateRecordInPlace(txn.get(), fixture, loc, i);
+            }
+            else {
+                insertRecord(txn.get(), fixture, record);
+            }
+            latencyNanos->push_back(Timer::nowNanos() - start);
+        }
+    }
+
+    // 'arg' threads each run kMixedOpsPerThread operations against a store of 10000 records.
+    // Starting the threads is part of the time, which is small next to their operations.
+    MONGO_BENCHMARK_WITH_ARGS(RecordStoreMixedWorkload, "1,4,16") {
+        Fixture* fixture = getFixture("mixed", 10000);
+        const int numThreads = static_cast<int>(state.arg());
+        state.setItemsPerIteration(numThreads * kMixedOpsPerThread);
+
+        int32_t seed = 0;
+        while (state.keepRunning()) {
+            std::vector<std::vector<long long> > latencyNanos(numThreads);
+            boost::thread_group threads;
+            for (int i = 0; i < numThreads; i++) {
+                threads.create_thread(boost::bind(&runMixedOps, fixture, ++seed,
+                                                  &latencyNanos[i]));
+            }
+            threads.join_all();
+
+            state.pauseTiming();
+            for (int i = 0; i < numThreads; i++) {
+                for (size_t j = 0; j < latencyNanos[i].size(); j++) {
+                    state.recordLatency(latencyNanos[i][j]);
+                }
+            }
+            state.resumeTiming();
+        }
+    }
+
+}  // namespace
+}  // namespace mongo
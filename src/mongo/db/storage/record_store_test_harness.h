@@ -48,6 +48,13 @@ namespace mongo {
         virtual OperationContext* newOperationContext() {
             return new OperationContextNoop( newRecoveryUnit() );
         }
+
+        /**
+         * Whether record stores of this engine can be written by several threads at once, which
+         * StorageEngine::supportsDocLocking() promises.  Otherwise callers have to serialize
+         * writes as the collection lock would.
+         */
+        virtual bool supportsDocLocking() { return false; }
     };
 
     HarnessHelper* newHarnessHelper();
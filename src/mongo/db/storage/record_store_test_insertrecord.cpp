@@ -179,4 +179,43 @@ namespace mongo {
         }
     }
 
+    // Insert a batch of records with insertRecords() and verify that each one can be read back
+    // from the location reported for it.
+    TEST( RecordStoreTestHarness, InsertRecords ) {
+        scoped_ptr<HarnessHelper> harnessHelper( newHarnessHelper() );
+        scoped_ptr<RecordStore> rs( harnessHelper->newNonCappedRecordStore() );
+
+        const int nToInsert = 10;
+        std::vector<string> datas;
+        std::vector<RecordData> records;
+        for ( int i = 0; i < nToInsert; i++ ) {
+            stringstream ss;
+            ss << "record " << i;
+            datas.push_back( ss.str() );
+        }
+        for ( int i = 0; i < nToInsert; i++ ) {
+            records.push_back( RecordData( datas[i].c_str(), datas[i].size() + 1 ) );
+        }
+
+        std::vector<RecordId> locs;
+        {
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            {
+                WriteUnitOfWork uow( opCtx.get() );
+                ASSERT_OK( rs->insertRecords( opCtx.get(), records, false, &locs ) );
+                uow.commit();
+            }
+        }
+
+        ASSERT_EQUALS( static_cast<size_t>( nToInsert ), locs.size() );
+
+        {
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            ASSERT_EQUALS( nToInsert, rs->numRecords( opCtx.get() ) );
+            for ( int i = 0; i < nToInsert; i++ ) {
+                ASSERT_EQUALS( datas[i], rs->dataFor( opCtx.get(), locs[i] ).data() );
+            }
+        }
+    }
+
 } // namespace mongo
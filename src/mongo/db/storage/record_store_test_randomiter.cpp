@@ -0,0 +1,112 @@
+// record_store_test_randomiter.cpp
+
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/storage/record_store_test_harness.h"
+
+#include "mongo/db/record_id.h"
+#include "mongo/db/storage/record_data.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/unittest/unittest.h"
+
+using std::set;
+using std::string;
+using std::stringstream;
+
+namespace mongo {
+
+    // A random iterator over an empty record store is EOF immediately.
+    TEST( RecordStoreTestHarness, GetRandomIteratorEmpty ) {
+        scoped_ptr<HarnessHelper> harnessHelper( newHarnessHelper() );
+        scoped_ptr<RecordStore> rs( harnessHelper->newNonCappedRecordStore() );
+
+        {
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            scoped_ptr<RecordIterator> it( rs->getRandomIterator( opCtx.get() ) );
+
+            // returns NULL if getRandomIterator is not supported
+            if ( !it ) {
+                return;
+            }
+            ASSERT( it->isEOF() );
+            ASSERT_EQUALS( RecordId(), it->curr() );
+            ASSERT_EQUALS( RecordId(), it->getNext() );
+        }
+    }
+
+    // Insert multiple records and check that a random iterator only returns those, never becomes
+    // EOF, and keeps working across saveState() and restoreState().
+    TEST( RecordStoreTestHarness, GetRandomIteratorNonEmpty ) {
+        scoped_ptr<HarnessHelper> harnessHelper( newHarnessHelper() );
+        scoped_ptr<RecordStore> rs( harnessHelper->newNonCappedRecordStore() );
+
+        const int nToInsert = 10;
+        set<RecordId> locs;
+        for ( int i = 0; i < nToInsert; i++ ) {
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            {
+                stringstream ss;
+                ss << "record " << i;
+                string data = ss.str();
+
+                WriteUnitOfWork uow( opCtx.get() );
+                StatusWith<RecordId> res = rs->insertRecord( opCtx.get(),
+                                                            data.c_str(),
+                                                            data.size() + 1,
+                                                            false );
+                ASSERT_OK( res.getStatus() );
+                locs.insert( res.getValue() );
+                uow.commit();
+            }
+        }
+
+        {
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            scoped_ptr<RecordIterator> it( rs->getRandomIterator( opCtx.get() ) );
+            // returns NULL if getRandomIterator is not supported
+            if ( !it ) {
+                return;
+            }
+
+            for ( int i = 0; i < 10 * nToInsert; i++ ) {
+                if ( i % nToInsert == 0 ) {
+                    it->saveState();
+                    ASSERT( it->restoreState( opCtx.get() ) );
+                }
+
+                ASSERT( !it->isEOF() );
+                RecordId loc = it->getNext();
+                ASSERT( locs.count( loc ) );
+                ASSERT_EQUALS( string( "record " ),
+                               string( it->dataFor( loc ).data() ).substr( 0, 7 ) );
+            }
+        }
+    }
+
+} // namespace mongo
@@ -274,4 +274,61 @@ namespace mongo {
         }
     }
 
+    // Insert a record and, if the record store supports it, grow it with damages which write
+    // past its end.
+    TEST( RecordStoreTestHarness, UpdateWithDamagesGrowsRecord ) {
+        scoped_ptr<HarnessHelper> harnessHelper( newHarnessHelper() );
+        scoped_ptr<RecordStore> rs( harnessHelper->newNonCappedRecordStore() );
+
+        string data = "0001";
+        RecordId loc;
+        const RecordData rec(data.c_str(), data.size() + 1);
+        {
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            {
+                WriteUnitOfWork uow( opCtx.get() );
+                StatusWith<RecordId> res = rs->insertRecord( opCtx.get(),
+                                                            rec.data(),
+                                                            rec.size(),
+                                                            false );
+                ASSERT_OK( res.getStatus() );
+                loc = res.getValue();
+                uow.commit();
+            }
+        }
+
+        const string source = "1100";
+        const int newSize = rec.size() + 3;
+        {
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            if ( !rs->updateWithDamagesCanGrow( opCtx.get(), loc, newSize ) )
+                return;
+
+            const long long dataSize = rs->dataSize( opCtx.get() );
+
+            // Overwrite the terminating NUL with "100" and write a new one after it.
+            mutablebson::DamageVector dv( 1 );
+            dv[0].sourceOffset = 1;
+            dv[0].targetOffset = rec.size() - 1;
+            dv[0].size = source.size();
+            ASSERT_EQUALS( static_cast<size_t>( newSize ),
+                           mutablebson::getDamagedSize( rec.size(), dv ) );
+
+            {
+                WriteUnitOfWork uow( opCtx.get() );
+                ASSERT_OK( rs->updateWithDamages( opCtx.get(), loc, rec, source.c_str(), dv ) );
+                uow.commit();
+            }
+
+            // Stores which grow into the record's padding do not change their data size.
+            ASSERT_GREATER_THAN_OR_EQUALS( rs->dataSize( opCtx.get() ), dataSize );
+        }
+
+        {
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            RecordData record = rs->dataFor( opCtx.get(), loc );
+            ASSERT_EQUALS( "0001100", string( record.data() ) );
+        }
+    }
+
 } // namespace mongo
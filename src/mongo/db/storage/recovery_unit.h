@@ -97,6 +97,25 @@ namespace mongo {
          */
         virtual void commitAndRestart() = 0;
 
+        /**
+         * Asks that every snapshot this unit takes from now on show the data as of a boundary
+         * between replication batches, so that its reads needn't wait for the batch being
+         * applied; see StorageEngine::beginReplicationBatch.  Snapshots already held are kept.
+         * Returns false if the storage engine can't do this or the unit is writing.
+         */
+        virtual bool readAtBatchBoundaries() { return false; }
+
+        /**
+         * Asks that the unit keep reading from the snapshot it holds, or takes next, rather than
+         * move on at commitAndRestart() or when stashed between getMores.  Once 'maxSeconds' have
+         * passed the snapshot is let go the next time the unit is stashed or brought back, and
+         * pinnedSnapshotExpired() becomes true.  Beginning a unit of work also unpins it.
+         * Returns false if the storage engine can't do this or the unit is writing.
+         */
+        virtual bool pinSnapshot(int maxSeconds) { return false; }
+
+        virtual bool pinnedSnapshotExpired() const { return false; }
+
         /**
          * A Change is an action that is registerChange()'d while a WriteUnitOfWork exists. The
          * change is either rollback()'d or commit()'d when the WriteUnitOfWork goes out of scope.
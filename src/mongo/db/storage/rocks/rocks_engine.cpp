@@ -37,19 +37,26 @@
 #include <boost/make_shared.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include <rocksdb/cache.h>
 #include <rocksdb/comparator.h>
 #include <rocksdb/db.h>
+#include <rocksdb/filter_policy.h>
+#include <rocksdb/rate_limiter.h>
 #include <rocksdb/slice.h>
 #include <rocksdb/options.h>
+#include <rocksdb/statistics.h>
+#include <rocksdb/table.h>
 #include <rocksdb/utilities/write_batch_with_index.h>
 
 #include "mongo/db/catalog/collection_options.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/rocks/rocks_record_store.h"
 #include "mongo/db/storage/rocks/rocks_recovery_unit.h"
 #include "mongo/db/storage/rocks/rocks_sorted_data_impl.h"
 #include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
 
 #define ROCKS_TRACE log()
 
@@ -58,17 +65,93 @@
 
 namespace mongo {
 
+    const std::string kRocksEngineName("rocksExperiment");
+
+    // Size of the block cache shared by all column families.  0 keeps RocksDB's default of a
+    // small cache per column family.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(rocksdbBlockCacheSizeMB, int, 0);
+
+    // Caps the disk write rate of flushes and compactions.  0 means no limit.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(rocksdbCompactionRateLimitMBPerSec, int, 0);
+
+    // "level" or "universal", for column families which do not choose one themselves.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(rocksdbCompactionStyle, std::string, "level");
+
+    namespace {
+        // Bloom filter bits per key for record stores.  Their keys are fixed-size RecordIds, so
+        // equal keys are always equal bytes.  Indexes default to no filter: their comparator
+        // treats some different byte strings (1 and 1.0) as equal keys.
+        const int kDefaultCollectionBloomBitsPerKey = 10;
+
+        Status validateCompactionStyle(const std::string& style) {
+            if (style != "level" && style != "universal") {
+                return Status(ErrorCodes::InvalidOptions, str::stream()
+                              << "compactionStyle must be \"level\" or \"universal\", not \""
+                              << style << '"');
+            }
+            return Status::OK();
+        }
+    }
+
+    // static
+    Status RocksIdentOptions::parse(const BSONObj& options, RocksIdentOptions* out) {
+        RocksIdentOptions parsed;
+        BSONForEach(elem, options) {
+            const StringData name = elem.fieldNameStringData();
+            if (name == "bloomBitsPerKey" || name == "blockCacheSizeMB") {
+                if (!elem.isNumber() || elem.numberInt() < 0) {
+                    return Status(ErrorCodes::InvalidOptions, str::stream()
+                                  << name << " must be a non-negative number, not " << elem);
+                }
+                if (name == "bloomBitsPerKey") {
+                    parsed.bloomBitsPerKey = elem.numberInt();
+                }
+                else {
+                    parsed.blockCacheSizeMB = elem.numberInt();
+                }
+            }
+            else if (name == "compactionStyle") {
+                if (elem.type() != String) {
+                    return Status(ErrorCodes::InvalidOptions,
+                                  "compactionStyle must be a string");
+                }
+                Status status = validateCompactionStyle(elem.String());
+                if (!status.isOK()) {
+                    return status;
+                }
+                parsed.compactionStyle = elem.String();
+            }
+            else {
+                return Status(ErrorCodes::InvalidOptions, str::stream()
+                              << '\'' << name << '\'' << " is not a supported option in "
+                              << "storageEngine." << kRocksEngineName);
+            }
+        }
+        *out = parsed;
+        return Status::OK();
+    }
+
     const std::string RocksEngine::kOrderingPrefix("indexordering-");
     const std::string RocksEngine::kCollectionPrefix("collection-");
+    const std::string RocksEngine::kIdentOptionsPrefix("identoptions-");
 
     RocksEngine::RocksEngine(const std::string& path, bool durable)
         : _path(path),
           _collectionComparator(RocksRecordStore::newRocksCollectionComparator()),
-          _durable(durable) {
+          _durable(durable),
+          _backupOpen(false) {
+
+        uassertStatusOK(validateCompactionStyle(rocksdbCompactionStyle));
+        if (rocksdbBlockCacheSizeMB > 0) {
+            _blockCache = rocksdb::NewLRUCache(static_cast<size_t>(rocksdbBlockCacheSizeMB) << 20);
+        }
+        _statistics = rocksdb::CreateDBStatistics();
 
         auto columnFamilyNames = _loadColumnFamilies();       // vector of column family names
         std::unordered_map<std::string, Ordering> orderings;  // column family name -> Ordering
         std::set<std::string> collections;                    // set of collection names
+        // column family name -> its options, for those created with any
+        std::unordered_map<std::string, RocksIdentOptions> identOptions;
 
         if (columnFamilyNames.empty()) {  // new DB
             columnFamilyNames.push_back(rocksdb::kDefaultColumnFamilyName);
@@ -80,6 +163,7 @@ namespace mongo {
             auto itr = dbReadOnly->NewIterator(rocksdb::ReadOptions());
             orderings = _loadOrderingMetaData(itr);
             collections = _loadCollections(itr);
+            identOptions = _loadIdentOptions(itr);
             delete itr;
             delete dbReadOnly;
         }
@@ -97,16 +181,19 @@ namespace mongo {
             bool isIndex = orderings_iter != orderings.end();
             bool isCollection = collections_iter != collections.end();
             invariant(!isIndex || !isCollection);
+            auto options_iter = identOptions.find(cf);
+            const RocksIdentOptions options = options_iter != identOptions.end()
+                ? options_iter->second : RocksIdentOptions();
             if (isIndex) {
-                columnFamilies.emplace_back(cf, _indexOptions(orderings_iter->second));
+                columnFamilies.emplace_back(cf, _indexOptions(orderings_iter->second, options));
             } else if (isCollection) {
-                columnFamilies.emplace_back(cf, _collectionOptions());
+                columnFamilies.emplace_back(cf, _collectionOptions(options));
             } else {
                 // TODO support this from inside of rocksdb, by using
                 // Options::drop_unopened_column_families.
                 // This can happen because write and createColumnFamily are not atomic
                 toDropColumnFamily.insert(cf);
-                columnFamilies.emplace_back(cf, _collectionOptions());
+                columnFamilies.emplace_back(cf, _collectionOptions(options));
             }
         }
 
@@ -142,8 +229,14 @@ namespace mongo {
         if (_existsColumnFamily(ident)) {
             return Status::OK();
         }
+        RocksIdentOptions identOptions;
+        Status status = _storeIdentOptions(
+            ident, options.storageEngine.getObjectField(kRocksEngineName), &identOptions);
+        if (!status.isOK()) {
+            return status;
+        }
         _db->Put(rocksdb::WriteOptions(), kCollectionPrefix + ident.toString(), rocksdb::Slice());
-        return _createColumnFamily(_collectionOptions(), ident);
+        return _createColumnFamily(_collectionOptions(identOptions), ident);
     }
 
     RecordStore* RocksEngine::getRecordStore(OperationContext* opCtx, const StringData& ns,
@@ -167,9 +260,20 @@ namespace mongo {
         }
         auto keyPattern = desc->keyPattern();
 
+        const BSONElement storageEngine = desc->getInfoElement("storageEngine");
+        RocksIdentOptions identOptions;
+        Status status = _storeIdentOptions(
+            ident,
+            storageEngine.isABSONObj() ? storageEngine.Obj().getObjectField(kRocksEngineName)
+                                       : BSONObj(),
+            &identOptions);
+        if (!status.isOK()) {
+            return status;
+        }
         _db->Put(rocksdb::WriteOptions(), kOrderingPrefix + ident.toString(),
                  rocksdb::Slice(keyPattern.objdata(), keyPattern.objsize()));
-        return _createColumnFamily(_indexOptions(Ordering::make(keyPattern)), ident);
+        return _createColumnFamily(_indexOptions(Ordering::make(keyPattern), identOptions),
+                                   ident);
     }
 
     SortedDataInterface* RocksEngine::getSortedDataInterface(OperationContext* opCtx,
@@ -184,6 +288,7 @@ namespace mongo {
         // TODO is there a more efficient way?
         wb.Delete(kOrderingPrefix + ident.toString());
         wb.Delete(kCollectionPrefix + ident.toString());
+        wb.Delete(kIdentOptionsPrefix + ident.toString());
         auto s = _db->Write(rocksdb::WriteOptions(), &wb);
         if (!s.ok()) {
             return toMongoStatus(s);
@@ -199,6 +304,99 @@ namespace mongo {
         return indents;
     }
 
+    Status RocksEngine::beginBackup(OperationContext* opCtx,
+                                    std::vector<StorageEngine::BackupFile>* files) {
+        boost::mutex::scoped_lock lk(_backupMutex);
+        if (_backupOpen) {
+            return Status(ErrorCodes::IllegalOperation, "a backup is already open");
+        }
+
+        // Compactions keep running, but the files they replace stay on disk until endBackup().
+        auto s = _db->DisableFileDeletions();
+        if (!s.ok()) {
+            return toMongoStatus(s);
+        }
+
+        // Flushing the memtables first means the listed files hold every write, and the write
+        // ahead log is not needed.
+        std::vector<std::string> live;
+        uint64_t manifestSize = 0;
+        s = _db->GetLiveFiles(live, &manifestSize, true);
+        if (!s.ok()) {
+            _db->EnableFileDeletions(false);
+            return toMongoStatus(s);
+        }
+
+        std::vector<StorageEngine::BackupFile> listed;
+        for (auto& file : live) {
+            // Names are relative to the DB directory, which is the dbpath.
+            const std::string name = file[0] == '/' ? file.substr(1) : file;
+            if (StringData(name).endsWith(".sst")) {
+                listed.emplace_back(name, StorageEngine::BackupFile::kImmutable);
+            } else if (StringData(name).startsWith("MANIFEST-")) {
+                // Only the manifest's first manifestSize bytes describe the listed files.
+                listed.emplace_back(name, StorageEngine::BackupFile::kAppendOnly,
+                                    static_cast<long long>(manifestSize));
+            } else {
+                listed.emplace_back(name, StorageEngine::BackupFile::kMutable);
+            }
+        }
+
+        files->swap(listed);
+        _backupOpen = true;
+        return Status::OK();
+    }
+
+    void RocksEngine::endBackup(OperationContext* opCtx) {
+        boost::mutex::scoped_lock lk(_backupMutex);
+        if (!_backupOpen) {
+            return;
+        }
+        _db->EnableFileDeletions(false);
+        _backupOpen = false;
+    }
+
+    void RocksEngine::appendStats(BSONObjBuilder* builder) const {
+        static const struct {
+            rocksdb::Tickers ticker;
+            const char* name;
+        } kTickers[] = {
+            {rocksdb::BLOCK_CACHE_HIT, "blockCacheHits"},
+            {rocksdb::BLOCK_CACHE_MISS, "blockCacheMisses"},
+            {rocksdb::BLOOM_FILTER_USEFUL, "bloomFilterUseful"},
+            {rocksdb::NUMBER_KEYS_WRITTEN, "keysWritten"},
+            {rocksdb::NUMBER_KEYS_READ, "keysRead"},
+            {rocksdb::BYTES_WRITTEN, "bytesWritten"},
+            {rocksdb::BYTES_READ, "bytesRead"},
+            {rocksdb::COMPACT_READ_BYTES, "compactionBytesRead"},
+            {rocksdb::COMPACT_WRITE_BYTES, "compactionBytesWritten"},
+            {rocksdb::STALL_MICROS, "writeStallMicros"},
+        };
+        for (const auto& entry : kTickers) {
+            builder->appendNumber(entry.name, static_cast<long long>(
+                _statistics->getTickerCount(entry.ticker)));
+        }
+
+        static const char* const kProperties[] = {
+            "rocksdb.num-immutable-mem-table",
+            "rocksdb.mem-table-flush-pending",
+            "rocksdb.compaction-pending",
+            "rocksdb.background-errors",
+        };
+        BSONObjBuilder properties(builder->subobjStart("properties"));
+        for (const char* property : kProperties) {
+            std::string value;
+            if (_db->GetProperty(property, &value)) {
+                properties.append(property, value);
+            }
+        }
+        properties.done();
+
+        builder->append("blockCacheSizeMB", rocksdbBlockCacheSizeMB);
+        builder->append("compactionRateLimitMBPerSec", rocksdbCompactionRateLimitMBPerSec);
+        builder->append("compactionStyle", rocksdbCompactionStyle);
+    }
+
     // non public api
 
     rocksdb::ReadOptions RocksEngine::readOptionsWithSnapshot( OperationContext* opCtx ) {
@@ -279,6 +477,36 @@ namespace mongo {
         return collections;
     }
 
+    std::unordered_map<std::string, RocksIdentOptions> RocksEngine::_loadIdentOptions(
+        rocksdb::Iterator* itr) {
+        std::unordered_map<std::string, RocksIdentOptions> identOptions;
+        for (itr->Seek(kIdentOptionsPrefix); itr->Valid(); itr->Next()) {
+            rocksdb::Slice key(itr->key());
+            if (!key.starts_with(kIdentOptionsPrefix)) {
+                break;
+            }
+            key.remove_prefix(kIdentOptionsPrefix.size());
+            std::string value(itr->value().ToString());
+            RocksIdentOptions options;
+            // These were validated before they were stored.
+            invariant(RocksIdentOptions::parse(BSONObj(value.c_str()), &options).isOK());
+            identOptions.insert({key.ToString(), options});
+        }
+        ROCKS_STATUS_OK(itr->status());
+        return identOptions;
+    }
+
+    Status RocksEngine::_storeIdentOptions(const StringData& ident, const BSONObj& options,
+                                           RocksIdentOptions* parsed) {
+        Status status = RocksIdentOptions::parse(options, parsed);
+        if (!status.isOK() || options.isEmpty()) {
+            return status;
+        }
+        auto s = _db->Put(rocksdb::WriteOptions(), kIdentOptionsPrefix + ident.toString(),
+                          rocksdb::Slice(options.objdata(), options.objsize()));
+        return toMongoStatus(s);
+    }
+
     std::vector<std::string> RocksEngine::_loadColumnFamilies() {
         std::vector<std::string> names;
         if (boost::filesystem::exists(_path)) {
@@ -308,6 +536,12 @@ namespace mongo {
         options.wal_dir = _path + "/journal";
         options.max_total_wal_size = 1 << 30;  // 1GB
 
+        if (rocksdbCompactionRateLimitMBPerSec > 0) {
+            options.rate_limiter.reset(rocksdb::NewGenericRateLimiter(
+                static_cast<int64_t>(rocksdbCompactionRateLimitMBPerSec) << 20));
+        }
+        options.statistics = _statistics;
+
         return options;
     }
 
@@ -317,20 +551,52 @@ namespace mongo {
         return options;
     }
 
-    rocksdb::ColumnFamilyOptions RocksEngine::_collectionOptions() const {
+    rocksdb::ColumnFamilyOptions RocksEngine::_collectionOptions(
+        const RocksIdentOptions& identOptions) const {
         rocksdb::ColumnFamilyOptions options;
         invariant( _collectionComparator.get() );
         options.comparator = _collectionComparator.get();
+        _applyIdentOptions(identOptions, kDefaultCollectionBloomBitsPerKey, &options);
         return options;
     }
 
-    rocksdb::ColumnFamilyOptions RocksEngine::_indexOptions(const Ordering& order) const {
+    rocksdb::ColumnFamilyOptions RocksEngine::_indexOptions(
+        const Ordering& order, const RocksIdentOptions& identOptions) const {
         rocksdb::ColumnFamilyOptions options;
         invariant( _collectionComparator.get() );
         options.comparator = RocksSortedDataImpl::newRocksComparator(order);
+        _applyIdentOptions(identOptions, 0, &options);
         return options;
     }
 
+    void RocksEngine::_applyIdentOptions(const RocksIdentOptions& identOptions,
+                                         int defaultBloomBitsPerKey,
+                                         rocksdb::ColumnFamilyOptions* options) const {
+        const std::string& compactionStyle = identOptions.compactionStyle.empty()
+            ? rocksdbCompactionStyle : identOptions.compactionStyle;
+        // Only the style is set; the Optimize*StyleCompaction() helpers size the memtables for a
+        // single column family, which would add up badly over one per collection and index.
+        options->compaction_style = compactionStyle == "universal"
+            ? rocksdb::kCompactionStyleUniversal : rocksdb::kCompactionStyleLevel;
+
+        rocksdb::BlockBasedTableOptions tableOptions;
+        if (identOptions.blockCacheSizeMB > 0) {
+            tableOptions.block_cache =
+                rocksdb::NewLRUCache(static_cast<size_t>(identOptions.blockCacheSizeMB) << 20);
+        } else if (_blockCache) {
+            tableOptions.block_cache = _blockCache;
+        }
+
+        const int bloomBitsPerKey = identOptions.bloomBitsPerKey >= 0
+            ? identOptions.bloomBitsPerKey : defaultBloomBitsPerKey;
+        if (bloomBitsPerKey > 0) {
+            tableOptions.filter_policy.reset(rocksdb::NewBloomFilterPolicy(bloomBitsPerKey));
+            tableOptions.whole_key_filtering = true;
+        }
+
+        options->table_factory.reset(rocksdb::NewBlockBasedTableFactory(tableOptions));
+    }
+
     Status toMongoStatus( rocksdb::Status s ) {
         if ( s.ok() )
             return Status::OK();
@@ -50,6 +50,7 @@
 #include "mongo/util/string_map.h"
 
 namespace rocksdb {
+    class Cache;
     class ColumnFamilyHandle;
     struct ColumnFamilyDescriptor;
     struct ColumnFamilyOptions;
@@ -58,12 +59,42 @@ namespace rocksdb {
     class Iterator;
     struct Options;
     struct ReadOptions;
+    class Statistics;
 }
 
 namespace mongo {
 
     struct CollectionOptions;
 
+    extern const std::string kRocksEngineName;
+
+    /**
+     * Tuning for a single record store or index, taken from the kRocksEngineName field of the
+     * storageEngine document it was created with.  It is stored next to the ident's other
+     * metadata so the column family is reopened with the same options.
+     *
+     * { bloomBitsPerKey: <int>, blockCacheSizeMB: <int>, compactionStyle: "level"|"universal" }
+     */
+    struct RocksIdentOptions {
+        RocksIdentOptions() : bloomBitsPerKey(-1), blockCacheSizeMB(0) {}
+
+        /**
+         * Returns InvalidOptions for unknown fields or bad values.  An empty document gives the
+         * defaults.
+         */
+        static Status parse(const BSONObj& options, RocksIdentOptions* out);
+
+        // Bits per key of the whole-key bloom filter used by point lookups.  0 disables it and
+        // -1 means the default, which is on for record stores and off for indexes.
+        int bloomBitsPerKey;
+
+        // Size of a block cache of the ident's own.  0 means the engine's shared cache.
+        int blockCacheSizeMB;
+
+        // Empty for the engine default (rocksdbCompactionStyle).
+        std::string compactionStyle;
+    };
+
     class RocksEngine : public KVEngine {
         MONGO_DISALLOW_COPYING( RocksEngine );
     public:
@@ -101,6 +132,19 @@ namespace mongo {
 
         virtual bool isDurable() const override { return _durable; }
 
+        virtual void beginReplicationBatch() override {
+            _transactionEngine.pinBatchBoundarySnapshot(_db.get());
+        }
+
+        virtual void endReplicationBatch() override {
+            _transactionEngine.unpinBatchBoundarySnapshot();
+        }
+
+        virtual Status beginBackup(OperationContext* opCtx,
+                                   std::vector<StorageEngine::BackupFile>* files) override;
+
+        virtual void endBackup(OperationContext* opCtx) override;
+
         virtual int64_t getIdentSize(OperationContext* opCtx,
                                       const StringData& ident) {
           // TODO: return correct size.
@@ -124,6 +168,12 @@ namespace mongo {
          */
         static rocksdb::ReadOptions readOptionsWithSnapshot( OperationContext* opCtx );
 
+        /**
+         * Appends the engine's counters (block cache, bloom filters, compaction I/O) and a
+         * few DB properties, for serverStatus.
+         */
+        void appendStats(BSONObjBuilder* builder) const;
+
     private:
         bool _existsColumnFamily(const StringData& ident);
         Status _createColumnFamily(const rocksdb::ColumnFamilyOptions& options,
@@ -133,10 +183,22 @@ namespace mongo {
 
         std::unordered_map<std::string, Ordering> _loadOrderingMetaData(rocksdb::Iterator* itr);
         std::set<std::string> _loadCollections(rocksdb::Iterator* itr);
+        std::unordered_map<std::string, RocksIdentOptions> _loadIdentOptions(
+            rocksdb::Iterator* itr);
         std::vector<std::string> _loadColumnFamilies();
 
-        rocksdb::ColumnFamilyOptions _collectionOptions() const;
-        rocksdb::ColumnFamilyOptions _indexOptions(const Ordering& order) const;
+        /**
+         * Validates 'options' and stores them as the ident's metadata in the default column
+         * family.  Nothing is stored for an empty document.
+         */
+        Status _storeIdentOptions(const StringData& ident, const BSONObj& options,
+                                  RocksIdentOptions* parsed);
+
+        rocksdb::ColumnFamilyOptions _collectionOptions(const RocksIdentOptions& options) const;
+        rocksdb::ColumnFamilyOptions _indexOptions(const Ordering& order,
+                                                   const RocksIdentOptions& options) const;
+        void _applyIdentOptions(const RocksIdentOptions& options, int defaultBloomBitsPerKey,
+                                rocksdb::ColumnFamilyOptions* cfOptions) const;
 
         rocksdb::Options _dbOptions() const;
 
@@ -146,6 +208,11 @@ namespace mongo {
         boost::scoped_ptr<rocksdb::DB> _db;
         boost::scoped_ptr<rocksdb::Comparator> _collectionComparator;
 
+        // Shared by every column family without a blockCacheSizeMB of its own.  Null when
+        // rocksdbBlockCacheSizeMB is 0, in which case RocksDB's default is used.
+        std::shared_ptr<rocksdb::Cache> _blockCache;
+        std::shared_ptr<rocksdb::Statistics> _statistics;
+
         const bool _durable;
 
         // Default column family is owned by the rocksdb::DB instance.
@@ -158,8 +225,13 @@ namespace mongo {
         // This is for concurrency control
         RocksTransactionEngine _transactionEngine;
 
+        // Set while a backup has file deletions disabled.
+        boost::mutex _backupMutex;
+        bool _backupOpen;
+
         static const std::string kOrderingPrefix;
         static const std::string kCollectionPrefix;
+        static const std::string kIdentOptionsPrefix;
     };
 
     Status toMongoStatus( rocksdb::Status s );
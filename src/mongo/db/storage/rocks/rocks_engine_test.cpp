@@ -40,6 +40,7 @@
 #include "mongo/db/storage/kv/kv_engine_test_harness.h"
 #include "mongo/db/storage/rocks/rocks_engine.h"
 #include "mongo/unittest/temp_dir.h"
+#include "mongo/unittest/unittest.h"
 
 namespace mongo {
     class RocksEngineHarnessHelper : public KVHarnessHelper {
@@ -66,4 +67,37 @@ namespace mongo {
     };
 
     KVHarnessHelper* KVHarnessHelper::create() { return new RocksEngineHarnessHelper(); }
+
+    TEST(RocksIdentOptions, EmptyGivesDefaults) {
+        RocksIdentOptions options;
+        ASSERT_OK(RocksIdentOptions::parse(BSONObj(), &options));
+        ASSERT_EQUALS(-1, options.bloomBitsPerKey);
+        ASSERT_EQUALS(0, options.blockCacheSizeMB);
+        ASSERT_TRUE(options.compactionStyle.empty());
+    }
+
+    TEST(RocksIdentOptions, ParsesAllFields) {
+        RocksIdentOptions options;
+        ASSERT_OK(RocksIdentOptions::parse(
+            BSON("bloomBitsPerKey" << 12 << "blockCacheSizeMB" << 64
+                 << "compactionStyle" << "universal"),
+            &options));
+        ASSERT_EQUALS(12, options.bloomBitsPerKey);
+        ASSERT_EQUALS(64, options.blockCacheSizeMB);
+        ASSERT_EQUALS("universal", options.compactionStyle);
+    }
+
+    TEST(RocksIdentOptions, RejectsBadValues) {
+        RocksIdentOptions options;
+        ASSERT_EQUALS(ErrorCodes::InvalidOptions,
+                      RocksIdentOptions::parse(BSON("unknownField" << 1), &options).code());
+        ASSERT_EQUALS(ErrorCodes::InvalidOptions,
+                      RocksIdentOptions::parse(BSON("bloomBitsPerKey" << -1), &options).code());
+        ASSERT_EQUALS(ErrorCodes::InvalidOptions,
+                      RocksIdentOptions::parse(BSON("blockCacheSizeMB" << "big"),
+                                               &options).code());
+        ASSERT_EQUALS(ErrorCodes::InvalidOptions,
+                      RocksIdentOptions::parse(BSON("compactionStyle" << "fifo"),
+                                               &options).code());
+    }
 }
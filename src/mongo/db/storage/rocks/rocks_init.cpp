@@ -32,6 +32,7 @@
 #include "mongo/db/storage/rocks/rocks_engine.h"
 
 #include "mongo/base/init.h"
+#include "mongo/db/commands/server_status.h"
 #include "mongo/db/global_environment_experiment.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/storage/kv/kv_storage_engine.h"
@@ -39,26 +40,54 @@
 namespace mongo {
 
     namespace {
+        /**
+         * Adds kRocksEngineName to the results of db.serverStatus().
+         */
+        class RocksServerStatusSection : public ServerStatusSection {
+        public:
+            RocksServerStatusSection(RocksEngine* engine)
+                : ServerStatusSection(kRocksEngineName),
+                  _engine(engine) { }
+
+            virtual bool includeByDefault() const { return true; }
+
+            virtual BSONObj generateSection(OperationContext* txn,
+                                            const BSONElement& configElement) const {
+                BSONObjBuilder bob;
+                _engine->appendStats(&bob);
+                return bob.obj();
+            }
+
+        private:
+            RocksEngine* _engine;
+        };
+
         class RocksFactory : public StorageEngine::Factory {
         public:
             virtual ~RocksFactory(){}
             virtual StorageEngine* create( const StorageGlobalParams& params ) const {
+                RocksEngine* engine = new RocksEngine(params.dbpath, params.dur);
+                // Intentionally leaked.
+                new RocksServerStatusSection(engine);
+
                 KVStorageEngineOptions options;
                 options.directoryPerDB = params.directoryperdb;
                 options.forRepair = params.repair;
-                return new KVStorageEngine(new RocksEngine(params.dbpath, params.dur), options);
+                return new KVStorageEngine(engine, options);
             }
 
             virtual StringData getCanonicalName() const {
-                return "rocksExperiment";
+                return kRocksEngineName;
             }
 
             virtual Status validateCollectionStorageOptions(const BSONObj& options) const {
-                return Status::OK();
+                RocksIdentOptions parsed;
+                return RocksIdentOptions::parse(options, &parsed);
             }
 
             virtual Status validateIndexStorageOptions(const BSONObj& options) const {
-                return Status::OK();
+                RocksIdentOptions parsed;
+                return RocksIdentOptions::parse(options, &parsed);
             }
         };
     } // namespace
@@ -67,7 +96,7 @@ namespace mongo {
                                          ("SetGlobalEnvironment"))
                                          (InitializerContext* context) {
 
-        getGlobalEnvironment()->registerStorageEngine("rocksExperiment", new RocksFactory());
+        getGlobalEnvironment()->registerStorageEngine(kRocksEngineName, new RocksFactory());
         return Status::OK();
     }
 
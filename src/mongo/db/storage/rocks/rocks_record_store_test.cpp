@@ -85,6 +85,11 @@ namespace mongo {
             return new RocksRecoveryUnit(&_transactionEngine, _db.get(), true);
         }
 
+        virtual bool supportsDocLocking() { return true; }
+
+        rocksdb::DB* db() { return _db.get(); }
+        RocksTransactionEngine* transactionEngine() { return &_transactionEngine; }
+
     private:
         string _testNamespace = "mongo-rocks-record-store-test";
         unittest::TempDir _tempDir;
@@ -146,6 +151,57 @@ namespace mongo {
         }
     }
 
+    TEST(RocksRecordStoreTest, BatchBoundarySnapshot) {
+        RocksRecordStoreHarnessHelper harnessHelper;
+        scoped_ptr<RecordStore> rs(harnessHelper.newNonCappedRecordStore());
+
+        RecordId loc1;
+        RecordId loc2;
+
+        {
+            scoped_ptr<OperationContext> opCtx(harnessHelper.newOperationContext());
+            WriteUnitOfWork uow(opCtx.get());
+            StatusWith<RecordId> res = rs->insertRecord(opCtx.get(), "a", 2, false);
+            ASSERT_OK(res.getStatus());
+            loc1 = res.getValue();
+            uow.commit();
+        }
+
+        harnessHelper.transactionEngine()->pinBatchBoundarySnapshot(harnessHelper.db());
+
+        {
+            scoped_ptr<OperationContext> opCtx(harnessHelper.newOperationContext());
+            WriteUnitOfWork uow(opCtx.get());
+            StatusWith<RecordId> res = rs->insertRecord(opCtx.get(), "b", 2, false);
+            ASSERT_OK(res.getStatus());
+            loc2 = res.getValue();
+            uow.commit();
+        }
+
+        RecordData data;
+        {
+            // a boundary reader sees the data as of the pin
+            scoped_ptr<OperationContext> opCtx(harnessHelper.newOperationContext());
+            ASSERT(opCtx->recoveryUnit()->readAtBatchBoundaries());
+            ASSERT(rs->findRecord(opCtx.get(), loc1, &data));
+            ASSERT(!rs->findRecord(opCtx.get(), loc2, &data));
+        }
+
+        {
+            // other readers see the latest data
+            scoped_ptr<OperationContext> opCtx(harnessHelper.newOperationContext());
+            ASSERT(rs->findRecord(opCtx.get(), loc2, &data));
+        }
+
+        harnessHelper.transactionEngine()->unpinBatchBoundarySnapshot();
+
+        {
+            scoped_ptr<OperationContext> opCtx(harnessHelper.newOperationContext());
+            ASSERT(opCtx->recoveryUnit()->readAtBatchBoundaries());
+            ASSERT(rs->findRecord(opCtx.get(), loc2, &data));
+        }
+    }
+
     TEST(RocksRecordStoreTest, Isolation2 ) {
         scoped_ptr<HarnessHelper> harnessHelper( newHarnessHelper() );
         scoped_ptr<RecordStore> rs( harnessHelper->newNonCappedRecordStore() );
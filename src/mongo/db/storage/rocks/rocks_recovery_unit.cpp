@@ -54,8 +54,11 @@ namespace mongo {
           _durable(durable),
           _transaction(transactionEngine),
           _writeBatch(),
-          _snapshot(NULL),
-          _depth(0) {}
+          _depth(0),
+          _readAtBatchBoundaries(false),
+          _snapshotPinned(false),
+          _pinnedSnapshotExpired(false),
+          _pinMaxSeconds(0) {}
 
     RocksRecoveryUnit::~RocksRecoveryUnit() {
         _abort();
@@ -63,6 +66,7 @@ namespace mongo {
 
     void RocksRecoveryUnit::beginUnitOfWork() {
         _depth++;
+        _snapshotPinned = false;
     }
 
     void RocksRecoveryUnit::commitUnitOfWork() {
@@ -96,6 +100,10 @@ namespace mongo {
 
     void RocksRecoveryUnit::commitAndRestart() {
         invariant( _depth == 0 );
+        if (_snapshotPinned) {
+            // nothing has been written since the snapshot was pinned
+            return;
+        }
         commitUnitOfWork();
     }
 
@@ -116,11 +124,46 @@ namespace mongo {
 
     void RocksRecoveryUnit::registerChange(Change* change) { _changes.push_back(change); }
 
-    void RocksRecoveryUnit::_releaseSnapshot() {
-        if (_snapshot) {
-            _db->ReleaseSnapshot(_snapshot);
-            _snapshot = nullptr;
+    bool RocksRecoveryUnit::readAtBatchBoundaries() {
+        if (_depth > 0 || _writeBatch) {
+            // a boundary snapshot may be older than what this unit has already written
+            return false;
         }
+        _readAtBatchBoundaries = true;
+        return true;
+    }
+
+    bool RocksRecoveryUnit::pinSnapshot(int maxSeconds) {
+        if (_depth > 0 || _writeBatch) {
+            return false;
+        }
+        _snapshotPinned = true;
+        _pinnedSnapshotExpired = false;
+        _pinMaxSeconds = maxSeconds;
+        _pinTimer.reset();
+        return true;
+    }
+
+    void RocksRecoveryUnit::beingReleasedFromOperationContext() {
+        _expirePinnedSnapshot();
+    }
+
+    void RocksRecoveryUnit::beingSetOnOperationContext() {
+        _expirePinnedSnapshot();
+    }
+
+    void RocksRecoveryUnit::_expirePinnedSnapshot() {
+        if (!_snapshotPinned || _pinTimer.seconds() < _pinMaxSeconds) {
+            return;
+        }
+        LOG(1) << "releasing a snapshot pinned for " << _pinTimer.seconds() << " seconds";
+        _snapshotPinned = false;
+        _pinnedSnapshotExpired = true;
+        _releaseSnapshot();
+    }
+
+    void RocksRecoveryUnit::_releaseSnapshot() {
+        _snapshot.reset();
     }
 
     void RocksRecoveryUnit::_commit() {
@@ -167,13 +210,12 @@ namespace mongo {
 
     const rocksdb::Snapshot* RocksRecoveryUnit::snapshot() {
         if ( !_snapshot ) {
-            // Order of operations here is important. It needs to be synchronized with
-            // _db->Write() and _transaction.commit()
-            _transaction.recordSnapshotId();
-            _snapshot = _db->GetSnapshot();
+            _snapshot = _readAtBatchBoundaries ? _transactionEngine->getBatchBoundarySnapshot(_db)
+                                               : _transactionEngine->getSnapshot(_db);
+            _transaction.recordSnapshotId(*_snapshot);
         }
 
-        return _snapshot;
+        return _snapshot->get();
     }
 
     rocksdb::Status RocksRecoveryUnit::Get(rocksdb::ColumnFamilyHandle* columnFamily,
@@ -45,6 +45,7 @@
 #include "mongo/db/record_id.h"
 #include "mongo/db/storage/recovery_unit.h"
 #include "mongo/db/storage/rocks/rocks_transaction.h"
+#include "mongo/util/timer.h"
 
 namespace rocksdb {
     class DB;
@@ -80,12 +81,20 @@ namespace mongo {
 
         virtual void registerChange(Change* change);
 
+        virtual bool readAtBatchBoundaries();
+
+        virtual bool pinSnapshot(int maxSeconds);
+        virtual bool pinnedSnapshotExpired() const { return _pinnedSnapshotExpired; }
+
+        virtual void beingReleasedFromOperationContext();
+        virtual void beingSetOnOperationContext();
+
         // local api
 
         rocksdb::WriteBatchWithIndex* writeBatch();
 
         const rocksdb::Snapshot* snapshot();
-        bool hasSnapshot() { return _snapshot != nullptr; }
+        bool hasSnapshot() { return _snapshot.get() != nullptr; }
 
         RocksTransaction* transaction() { return &_transaction; }
 
@@ -123,6 +132,10 @@ namespace mongo {
         void _commit();
 
         void _abort();
+
+        // Lets go of a pinned snapshot which has outlived its time
+        void _expirePinnedSnapshot();
+
         RocksTransactionEngine* _transactionEngine;  // not owned
         rocksdb::DB* _db; // not owned
 
@@ -132,8 +145,8 @@ namespace mongo {
 
         boost::scoped_ptr<rocksdb::WriteBatchWithIndex> _writeBatch; // owned
 
-        // bare because we need to call ReleaseSnapshot when we're done with this
-        const rocksdb::Snapshot* _snapshot; // owned
+        // Possibly shared with other recovery units; see RocksTransactionEngine::getSnapshot
+        boost::shared_ptr<RocksTransactionEngine::Snapshot> _snapshot;
 
         CounterMap _deltaCounters;
 
@@ -142,6 +155,14 @@ namespace mongo {
 
         int _depth;
 
+        // Whether snapshots come from RocksTransactionEngine::getBatchBoundarySnapshot
+        bool _readAtBatchBoundaries;
+
+        bool _snapshotPinned;
+        bool _pinnedSnapshotExpired;
+        int _pinMaxSeconds;
+        Timer _pinTimer;
+
         RecordId _oplogReadTill;
     };
 
@@ -32,6 +32,7 @@
 
 #include "mongo/db/storage/rocks/rocks_sorted_data_impl.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <string>
 
@@ -547,6 +548,41 @@ namespace mongo {
             ru->getDeltaCounter(_numEntriesKey);
     }
 
+    bool RocksSortedDataImpl::estimateNumEntriesInRange(OperationContext* txn,
+                                                        const BSONObj& startKey,
+                                                        bool startKeyInclusive,
+                                                        const BSONObj& endKey,
+                                                        bool endKeyInclusive,
+                                                        long long* numEntriesOut) const {
+        // GetApproximateSizes() only sees data which has been flushed to table files, so scale the
+        // exact number of entries by the share of the flushed bytes which the range covers.
+        std::vector<rocksdb::LiveFileMetaData> metadata;
+        _db->GetLiveFilesMetaData(&metadata);
+        uint64_t flushedBytes = 0;
+        for (const auto& m : metadata) {
+            if (m.column_family_name == _ident) {
+                flushedBytes += m.size;
+            }
+        }
+
+        if (flushedBytes == 0) {
+            return false;
+        }
+
+        const string start = makeString(stripFieldNames(startKey),
+                                        startKeyInclusive ? RecordId::min() : RecordId::max());
+        const string end = makeString(stripFieldNames(endKey),
+                                      endKeyInclusive ? RecordId::max() : RecordId::min());
+        rocksdb::Range range(start, end);
+        uint64_t rangeBytes;
+        _db->GetApproximateSizes(_columnFamily.get(), &range, 1, &rangeBytes);
+
+        const long long total = numEntries(txn);
+        const double fraction = std::min(1.0, static_cast<double>(rangeBytes) / flushedBytes);
+        *numEntriesOut = static_cast<long long>(total * fraction);
+        return true;
+    }
+
     SortedDataInterface::Cursor* RocksSortedDataImpl::newCursor(OperationContext* txn,
                                                                 int direction) const {
         invariant( ( direction == 1 || direction == -1 ) && "invalid value for direction" );
@@ -89,6 +89,13 @@ namespace mongo {
 
         virtual long long numEntries(OperationContext* txn) const;
 
+        virtual bool estimateNumEntriesInRange(OperationContext* txn,
+                                               const BSONObj& startKey,
+                                               bool startKeyInclusive,
+                                               const BSONObj& endKey,
+                                               bool endKeyInclusive,
+                                               long long* numEntriesOut) const;
+
         virtual Cursor* newCursor(OperationContext* txn, int direction) const;
 
         virtual Status initAsEmpty(OperationContext* txn);
@@ -35,12 +35,66 @@
 #include <memory>
 #include <string>
 
+#include <boost/make_shared.hpp>
+#include <rocksdb/db.h>
+
 // for invariant()
 #include "mongo/util/assert_util.h"
 
 namespace mongo {
     RocksTransactionEngine::RocksTransactionEngine() : _latestSeqId(1), _nextTransactionId(1) {}
 
+    RocksTransactionEngine::Snapshot::Snapshot(rocksdb::DB* db, uint64_t snapshotSeqId)
+        : _db(db),
+          _snapshotSeqId(snapshotSeqId),
+          _dbSequenceNumber(db->GetLatestSequenceNumber()),
+          _snapshot(db->GetSnapshot()) {}
+
+    RocksTransactionEngine::Snapshot::~Snapshot() {
+        _db->ReleaseSnapshot(_snapshot);
+    }
+
+    boost::shared_ptr<RocksTransactionEngine::Snapshot> RocksTransactionEngine::getSnapshot(
+        rocksdb::DB* db) {
+        const uint64_t dbSequenceNumber = db->GetLatestSequenceNumber();
+        boost::mutex::scoped_lock lk(_snapshotLock);
+        return _getSnapshot_inlock(db, dbSequenceNumber);
+    }
+
+    boost::shared_ptr<RocksTransactionEngine::Snapshot>
+    RocksTransactionEngine::_getSnapshot_inlock(rocksdb::DB* db, uint64_t dbSequenceNumber) {
+        if (!_lastSnapshot || _lastSnapshot->_db != db ||
+            _lastSnapshot->_dbSequenceNumber != dbSequenceNumber) {
+            // Order of operations here is important. The seq id has to be read before the
+            // snapshot is taken, to be synchronized with _db->Write() and commit()
+            _lastSnapshot = boost::make_shared<Snapshot>(db, getLatestSeqId());
+        }
+        return _lastSnapshot;
+    }
+
+    void RocksTransactionEngine::pinBatchBoundarySnapshot(rocksdb::DB* db) {
+        const uint64_t dbSequenceNumber = db->GetLatestSequenceNumber();
+        boost::mutex::scoped_lock lk(_snapshotLock);
+        _batchBoundarySnapshot = _getSnapshot_inlock(db, dbSequenceNumber);
+    }
+
+    void RocksTransactionEngine::unpinBatchBoundarySnapshot() {
+        boost::mutex::scoped_lock lk(_snapshotLock);
+        _batchBoundarySnapshot.reset();
+    }
+
+    boost::shared_ptr<RocksTransactionEngine::Snapshot>
+    RocksTransactionEngine::getBatchBoundarySnapshot(rocksdb::DB* db) {
+        const uint64_t dbSequenceNumber = db->GetLatestSequenceNumber();
+        boost::mutex::scoped_lock lk(_snapshotLock);
+        // Taking the snapshot under the same lock as pinning orders it before the batch's
+        // first write whenever no batch is pinned.
+        if (_batchBoundarySnapshot && _batchBoundarySnapshot->_db == db) {
+            return _batchBoundarySnapshot;
+        }
+        return _getSnapshot_inlock(db, dbSequenceNumber);
+    }
+
     void RocksTransaction::commit() {
         if (_writeShards.empty()) {
             return;
@@ -100,4 +154,8 @@ namespace mongo {
     void RocksTransaction::recordSnapshotId() {
         _snapshotSeqId = _transactionEngine->getLatestSeqId();
     }
+
+    void RocksTransaction::recordSnapshotId(const RocksTransactionEngine::Snapshot& snapshot) {
+        _snapshotSeqId = snapshot.snapshotSeqId();
+    }
 }
@@ -36,8 +36,16 @@
 #include <memory>
 #include <string>
 
+#include <boost/shared_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 
+#include "mongo/base/disallow_copying.h"
+
+namespace rocksdb {
+    class DB;
+    class Snapshot;
+}
+
 namespace mongo {
     class RocksTransaction;
 
@@ -49,7 +57,52 @@ namespace mongo {
             return _latestSeqId.load(std::memory_order::memory_order_acquire);
         }
 
+        /**
+         * A rocksdb snapshot, and the seq id recorded just before it was taken.  The snapshot is
+         * released when the last holder lets go of it.
+         */
+        class Snapshot {
+            MONGO_DISALLOW_COPYING(Snapshot);
+        public:
+            Snapshot(rocksdb::DB* db, uint64_t snapshotSeqId);
+            ~Snapshot();
+
+            const rocksdb::Snapshot* get() const { return _snapshot; }
+            uint64_t snapshotSeqId() const { return _snapshotSeqId; }
+
+        private:
+            friend class RocksTransactionEngine;
+            rocksdb::DB* const _db;
+            const uint64_t _snapshotSeqId;
+            // rocksdb's sequence number, read before the snapshot was taken
+            const uint64_t _dbSequenceNumber;
+            const rocksdb::Snapshot* const _snapshot;
+        };
+
+        /**
+         * Returns a snapshot of the current state of 'db'.  Callers which ask while nothing has
+         * been written to 'db' since the last snapshot was taken share it: that snapshot is
+         * the current state, and sharing it spares each read-only unit of work from taking the
+         * DB mutex to get and release one of its own.
+         */
+        boost::shared_ptr<Snapshot> getSnapshot(rocksdb::DB* db);
+
+        /**
+         * Between these calls, getBatchBoundarySnapshot() returns the snapshot of 'db' taken by
+         * pinBatchBoundarySnapshot() instead of the current state.
+         */
+        void pinBatchBoundarySnapshot(rocksdb::DB* db);
+        void unpinBatchBoundarySnapshot();
+
+        /**
+         * Returns the pinned snapshot if there is one, or else the same as getSnapshot().
+         */
+        boost::shared_ptr<Snapshot> getBatchBoundarySnapshot(rocksdb::DB* db);
+
     private:
+        boost::shared_ptr<Snapshot> _getSnapshot_inlock(rocksdb::DB* db,
+                                                        uint64_t dbSequenceNumber);
+
         uint64_t nextTransactionId() {
           return _nextTransactionId.fetch_add(1);
         }
@@ -63,6 +116,11 @@ namespace mongo {
         // Slots to store latest update SeqID for documents.
         std::unordered_map<std::string, uint64_t> _seqId;
         std::unordered_map<std::string, uint64_t> _uncommittedTransactionId;
+
+        // Protects _lastSnapshot and _batchBoundarySnapshot
+        boost::mutex _snapshotLock;
+        boost::shared_ptr<Snapshot> _lastSnapshot;
+        boost::shared_ptr<Snapshot> _batchBoundarySnapshot; // NULL unless pinned
     };
 
     class RocksTransaction {
@@ -84,6 +142,9 @@ namespace mongo {
 
         void recordSnapshotId();
 
+        // Uses the seq id recorded with 'snapshot' instead of the latest one.
+        void recordSnapshotId(const RocksTransactionEngine::Snapshot& snapshot);
+
     private:
         friend class RocksTransactionEngine;
         uint64_t _snapshotSeqId;
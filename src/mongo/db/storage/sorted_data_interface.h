@@ -144,6 +144,17 @@ namespace mongo {
          */
         virtual long long getSpaceUsedBytes( OperationContext* txn ) const = 0;
 
+        /**
+         * Append the storage engine's statistics on how this index uses its cache, in the same
+         * form as RecordStore::appendCacheStats. Returns false, appending nothing, if the engine
+         * keeps none.
+         */
+        virtual bool appendCacheStats(OperationContext* txn,
+                                      BSONObjBuilder* result,
+                                      double scale) const {
+            return false;
+        }
+
         /**
          * Return true if 'this' index is empty, and false otherwise.
          */
@@ -174,6 +185,36 @@ namespace mongo {
             return x;
         }
 
+        /**
+         * Estimate the number of entries whose keys fall between 'startKey' and 'endKey' without
+         * visiting them. The keys are compared as a cursor seeking to them would compare them.
+         *
+         * Returns false, leaving 'numEntriesOut' untouched, if the storage engine cannot produce
+         * an estimate for this index right now. Callers must then walk the range to count it.
+         */
+        virtual bool estimateNumEntriesInRange(OperationContext* txn,
+                                               const BSONObj& startKey,
+                                               bool startKeyInclusive,
+                                               const BSONObj& endKey,
+                                               bool endKeyInclusive,
+                                               long long* numEntriesOut) const {
+            return false;
+        }
+
+        /**
+         * Append the RecordId of every entry whose key is exactly 'key' to 'locsOut', in
+         * ascending RecordId order, without positioning a cursor. Storage engines which keep a
+         * hash of an index's keys can answer this in constant time.
+         *
+         * Returns false, leaving 'locsOut' untouched, if the storage engine cannot look up 'key'
+         * this way. Callers must then seek a cursor to it.
+         */
+        virtual bool findExactKey(OperationContext* txn,
+                                  const BSONObj& key,
+                                  std::vector<RecordId>* locsOut) const {
+            return false;
+        }
+
         /**
          * Navigation
          *
@@ -231,6 +272,10 @@ namespace mongo {
              * (previous) occurrence of a particular key or immediately after
              * (or immediately before).
              *
+             * Index scans call this once per interval of a query with many point intervals, such
+             * as a large $in, and the target is usually close ahead.  Implementations should look
+             * near the current position before searching from the root.
+             *
              * @see SortedDataInterface::customLocate
              */
             virtual void advanceTo(const BSONObj &keyPrefix,
@@ -139,6 +139,14 @@ namespace mongo {
          */
         virtual bool isMmapV1() const { return false; }
 
+        /**
+         * Called by replication before it applies a batch of oplog entries and after the whole
+         * batch is applied.  In between, recovery units reading at batch boundaries see the data
+         * as of beginReplicationBatch().
+         */
+        virtual void beginReplicationBatch() {}
+        virtual void endReplicationBatch() {}
+
         /**
          * Closes all file handles associated with a database.
          */
@@ -154,6 +162,42 @@ namespace mongo {
          */
         virtual int flushAllFiles( bool sync ) = 0;
 
+        /**
+         * A file which has to be copied to back up the data, named relative to the dbpath.
+         */
+        struct BackupFile {
+            enum Kind {
+                kMutable,       // rewritten in place; compare size and modification time
+                kAppendOnly,    // only ever grows; bytes already copied do not change
+                kImmutable      // never changes once it is listed
+            };
+
+            BackupFile(const std::string& name, Kind kind, long long length = -1)
+                : name(name), kind(kind), length(length) {}
+
+            std::string name;
+            Kind kind;
+            // Number of bytes which belong to the backup, or -1 for the whole file.
+            long long length;
+        };
+
+        /**
+         * Pins a consistent on disk image of the data and lists the files it is made of.  The
+         * files can be copied while writes continue, until endBackup() is called.  At most one
+         * backup is open at a time.
+         *
+         * Engines which cannot do this return CommandNotSupported; use fsync+lock instead.
+         */
+        virtual Status beginBackup(OperationContext* txn, std::vector<BackupFile>* files) {
+            return Status(ErrorCodes::CommandNotSupported,
+                          "this storage engine does not support hot backups");
+        }
+
+        /**
+         * Releases what beginBackup() pinned.  Only called after beginBackup() succeeded.
+         */
+        virtual void endBackup(OperationContext* txn) {}
+
         /**
          * Recover as much data as possible from a potentially corrupt RecordStore.
          * This only recovers the record data, not indexes or anything else.
@@ -429,6 +429,14 @@ namespace {
                                                                      _uri ) );
     }
 
+    bool WiredTigerIndex::appendCacheStats(OperationContext* txn,
+                                           BSONObjBuilder* result,
+                                           double scale) const {
+        WiredTigerSession* session = WiredTigerRecoveryUnit::get(txn)->getSession();
+        return WiredTigerUtil::appendCacheStats(session->getSession(), _uri, result,
+                                                scale).isOK();
+    }
+
     bool WiredTigerIndex::isDup(WT_CURSOR *c, const BSONObj& key, const RecordId& loc ) {
         invariant( unique() );
         // First check whether the key exists.
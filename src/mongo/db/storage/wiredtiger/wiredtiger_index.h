@@ -101,6 +101,10 @@ namespace mongo {
 
         virtual long long getSpaceUsedBytes( OperationContext* txn ) const;
 
+        virtual bool appendCacheStats(OperationContext* txn,
+                                      BSONObjBuilder* result,
+                                      double scale) const;
+
         bool isDup(WT_CURSOR *c, const BSONObj& key, const RecordId& loc );
 
         virtual SortedDataInterface::Cursor* newCursor(
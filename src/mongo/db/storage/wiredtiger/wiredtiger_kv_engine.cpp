@@ -184,6 +184,11 @@ namespace mongo {
         log() << "WiredTigerKVEngine shutting down";
         syncSizeInfo(true);
         if (_conn) {
+            {
+                boost::mutex::scoped_lock lk(_backupMutex);
+                _backupSession.reset();
+            }
+
             // this must be the last thing we do before _conn->close();
             _sessionCache->shuttingDown();
 
@@ -255,6 +260,56 @@ namespace mongo {
         return 1;
     }
 
+    Status WiredTigerKVEngine::beginBackup( OperationContext* opCtx,
+                                            std::vector<StorageEngine::BackupFile>* files ) {
+        boost::mutex::scoped_lock lk(_backupMutex);
+        if ( _backupSession ) {
+            return Status( ErrorCodes::IllegalOperation, "a backup is already open" );
+        }
+
+        syncSizeInfo(true);
+
+        boost::scoped_ptr<WiredTigerSession> session( new WiredTigerSession( _conn, -1 ) );
+        WT_SESSION* s = session->getSession();
+
+        // The backup cursor lists the files of the last checkpoint and keeps its blocks from
+        // being reused until it is closed.
+        int ret = s->checkpoint(s, NULL);
+        if ( ret != 0 )
+            return wtRCToStatus( ret );
+
+        WT_CURSOR* c = NULL;
+        ret = s->open_cursor(s, "backup:", NULL, NULL, &c);
+        if ( ret != 0 )
+            return wtRCToStatus( ret );
+
+        std::vector<StorageEngine::BackupFile> listed;
+        while ( ( ret = c->next(c) ) == 0 ) {
+            const char* name;
+            invariantWTOK( c->get_key(c, &name) );
+            string file = name;
+            if ( file.find( "WiredTigerLog." ) == 0 ) {
+                // Log files are preallocated and written in place, so they cannot be compared
+                // by size alone.
+                file = "journal/" + file;
+            }
+            listed.push_back( StorageEngine::BackupFile( file,
+                                                         StorageEngine::BackupFile::kMutable ) );
+        }
+        if ( ret != WT_NOTFOUND )
+            return wtRCToStatus( ret );
+
+        files->swap( listed );
+        _backupSession.swap( session );
+        return Status::OK();
+    }
+
+    void WiredTigerKVEngine::endBackup( OperationContext* opCtx ) {
+        boost::mutex::scoped_lock lk(_backupMutex);
+        // Closing the session closes the backup cursor.
+        _backupSession.reset();
+    }
+
     void WiredTigerKVEngine::syncSizeInfo( bool sync ) const {
         if ( !_sizeStorer )
             return;
@@ -465,7 +520,7 @@ namespace mongo {
                 continue;
 
             StringData ident = key.substr(idx+1);
-            if ( ident == "sizeStorer" )
+            if ( ident == "sizeStorer" || ident == WiredTigerRecoveryUnit::kGroupCommitIdent )
                 continue;
 
             all.push_back( ident.toString() );
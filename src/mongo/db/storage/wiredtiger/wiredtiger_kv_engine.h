@@ -94,6 +94,11 @@ namespace mongo {
 
         virtual int flushAllFiles( bool sync );
 
+        virtual Status beginBackup( OperationContext* opCtx,
+                                    std::vector<StorageEngine::BackupFile>* files );
+
+        virtual void endBackup( OperationContext* opCtx );
+
         virtual int64_t getIdentSize( OperationContext* opCtx,
                                       const StringData& ident );
 
@@ -112,6 +117,7 @@ namespace mongo {
         int reconfigure(const char* str);
 
         WT_CONNECTION* getConnection() { return _conn; }
+        WiredTigerSessionCache* getSessionCache() { return _sessionCache.get(); }
         void dropAllQueued();
         bool haveDropsQueued() const;
 
@@ -143,6 +149,10 @@ namespace mongo {
 
         int _epoch; // this is how we keep track of if a session is too old
 
+        // Holds the "backup:" cursor, which pins the checkpoint, while a backup is open.
+        boost::scoped_ptr<WiredTigerSession> _backupSession;
+        boost::mutex _backupMutex;
+
         scoped_ptr<WiredTigerSizeStorer> _sizeStorer;
         string _sizeStorerUri;
         mutable ElapsedTracker _sizeStorerSyncTracker;
@@ -35,11 +35,17 @@
 
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store.h"
 
+#include <algorithm>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/thread.hpp>
+#include <deque>
 #include <wiredtiger.h>
 
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/operation_context_noop.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/oplog_hack.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
@@ -48,7 +54,9 @@
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/stdx/functional.h"
 #include "mongo/util/scopeguard.h"
+#include "mongo/util/time_support.h"
 
 //#define RS_ITERATOR_TRACE(x) log() << "WTRS::Iterator " << x
 #define RS_ITERATOR_TRACE(x)
@@ -97,6 +105,346 @@ namespace {
 
     const std::string kWiredTigerEngineName = "wiredTiger";
 
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(wiredTigerOplogStones, bool, true);
+
+    /**
+     * Splits the oplog into "stones", each covering about minBytesPerStone of consecutive
+     * entries up to and including its lastRecord.  Committed inserts add to the current stone,
+     * which is closed off once it is big enough.  While the oplog is over its maximum size, a
+     * background thread truncates everything up to the end of the oldest stone with a single
+     * WT_SESSION::truncate, so inserts never pay for deleting old entries.
+     *
+     * The oplog has no indexes and WiredTiger doesn't need cursor invalidations, so skipping
+     * the per-document CappedDocumentDeleteCallback loses nothing.
+     */
+    class WiredTigerRecordStore::OplogStones {
+    public:
+        struct Stone {
+            Stone(int64_t records_, int64_t bytes_, const RecordId& lastRecord_)
+                : records(records_), bytes(bytes_), lastRecord(lastRecord_) {}
+
+            int64_t records;
+            int64_t bytes;
+            RecordId lastRecord;
+        };
+
+        OplogStones(OperationContext* txn, WiredTigerRecordStore* rs);
+
+        ~OplogStones();
+
+        /**
+         * Adds committed inserts to the current stone, and starts a new one once it holds
+         * minBytesPerStone.
+         */
+        void updateCurrentStoneAfterInsertOnCommit(OperationContext* txn,
+                                                   int64_t bytesInserted,
+                                                   const RecordId& highestInserted,
+                                                   int64_t countInserted);
+
+        void clearStonesOnCommit(OperationContext* txn);
+
+        /**
+         * Drops the stones which end after 'end', once everything after it has been deleted,
+         * and folds what is left of them into the current stone.
+         */
+        void updateStonesAfterCappedTruncateAfter(int64_t recordsRemoved,
+                                                  int64_t bytesRemoved,
+                                                  const RecordId& end);
+
+    private:
+        class InsertChange;
+        class ClearChange;
+
+        static const int64_t kMinStonesToKeep = 10;
+        static const int64_t kMaxStonesToKeep = 100;
+        static const int kRandomSamplesPerStone = 10;
+
+        void _calculateStones(OperationContext* txn);
+        void _calculateStonesByScanning(OperationContext* txn);
+        void _calculateStonesBySampling(OperationContext* txn, int64_t estimatedStones);
+
+        void _addCommitted(int64_t records, int64_t bytes, const RecordId& highest);
+        bool _hasExcessStones_inlock() const;
+        void _reclaimThread();
+        bool _reclaimOldestStone();
+
+        WiredTigerRecordStore* const _rs;
+        WiredTigerSessionCache* const _sessionCache;
+        int64_t _minBytesPerStone;
+
+        boost::mutex _mutex;
+        boost::condition_variable _hasExcessStones;
+        bool _shuttingDown;
+        std::deque<Stone> _stones; // oldest first
+        int64_t _currentRecords;
+        int64_t _currentBytes;
+
+        boost::thread _thread;
+    };
+
+    const int64_t WiredTigerRecordStore::OplogStones::kMinStonesToKeep;
+    const int64_t WiredTigerRecordStore::OplogStones::kMaxStonesToKeep;
+    const int WiredTigerRecordStore::OplogStones::kRandomSamplesPerStone;
+
+    class WiredTigerRecordStore::OplogStones::InsertChange : public RecoveryUnit::Change {
+    public:
+        InsertChange(OplogStones* stones,
+                     int64_t bytesInserted,
+                     const RecordId& highestInserted,
+                     int64_t countInserted)
+            : _stones(stones),
+              _bytesInserted(bytesInserted),
+              _highestInserted(highestInserted),
+              _countInserted(countInserted) {}
+
+        virtual void commit() {
+            _stones->_addCommitted(_countInserted, _bytesInserted, _highestInserted);
+        }
+
+        virtual void rollback() {}
+
+    private:
+        OplogStones* const _stones;
+        const int64_t _bytesInserted;
+        const RecordId _highestInserted;
+        const int64_t _countInserted;
+    };
+
+    class WiredTigerRecordStore::OplogStones::ClearChange : public RecoveryUnit::Change {
+    public:
+        explicit ClearChange(OplogStones* stones) : _stones(stones) {}
+
+        virtual void commit() {
+            boost::mutex::scoped_lock lk(_stones->_mutex);
+            _stones->_stones.clear();
+            _stones->_currentRecords = 0;
+            _stones->_currentBytes = 0;
+        }
+
+        virtual void rollback() {}
+
+    private:
+        OplogStones* const _stones;
+    };
+
+    WiredTigerRecordStore::OplogStones::OplogStones(OperationContext* txn,
+                                                    WiredTigerRecordStore* rs)
+        : _rs(rs),
+          _sessionCache(_getRecoveryUnit(txn)->getSessionCache()),
+          _shuttingDown(false),
+          _currentRecords(0),
+          _currentBytes(0) {
+
+        const int64_t numStones = std::min(kMaxStonesToKeep,
+                                           std::max(kMinStonesToKeep,
+                                                    rs->_cappedMaxSize / BSONObjMaxInternalSize));
+        _minBytesPerStone = std::max(int64_t(1), rs->_cappedMaxSize / numStones);
+
+        _calculateStones(txn);
+
+        _thread = boost::thread(stdx::bind(&OplogStones::_reclaimThread, this));
+    }
+
+    WiredTigerRecordStore::OplogStones::~OplogStones() {
+        {
+            boost::mutex::scoped_lock lk(_mutex);
+            _shuttingDown = true;
+            _hasExcessStones.notify_one();
+        }
+        _thread.join();
+    }
+
+    void WiredTigerRecordStore::OplogStones::updateCurrentStoneAfterInsertOnCommit(
+            OperationContext* txn,
+            int64_t bytesInserted,
+            const RecordId& highestInserted,
+            int64_t countInserted) {
+        txn->recoveryUnit()->registerChange(
+            new InsertChange(this, bytesInserted, highestInserted, countInserted));
+    }
+
+    void WiredTigerRecordStore::OplogStones::clearStonesOnCommit(OperationContext* txn) {
+        txn->recoveryUnit()->registerChange(new ClearChange(this));
+    }
+
+    void WiredTigerRecordStore::OplogStones::updateStonesAfterCappedTruncateAfter(
+            int64_t recordsRemoved,
+            int64_t bytesRemoved,
+            const RecordId& end) {
+        boost::mutex::scoped_lock lk(_mutex);
+
+        int64_t records = _currentRecords;
+        int64_t bytes = _currentBytes;
+        while (!_stones.empty() && _stones.back().lastRecord > end) {
+            records += _stones.back().records;
+            bytes += _stones.back().bytes;
+            _stones.pop_back();
+        }
+
+        _currentRecords = std::max(int64_t(0), records - recordsRemoved);
+        _currentBytes = std::max(int64_t(0), bytes - bytesRemoved);
+    }
+
+    void WiredTigerRecordStore::OplogStones::_calculateStones(OperationContext* txn) {
+        const int64_t numRecords = _rs->_numRecords.load();
+        const int64_t dataSize = _rs->_dataSize.load();
+        if (numRecords <= 0 || dataSize <= 0) {
+            return;
+        }
+
+        const int64_t estimatedStones = dataSize / _minBytesPerStone;
+        if (estimatedStones == 0) {
+            _currentRecords = numRecords;
+            _currentBytes = dataSize;
+            return;
+        }
+
+        // Scanning a small oplog is cheaper than sampling it.
+        if (numRecords < kRandomSamplesPerStone * estimatedStones) {
+            _calculateStonesByScanning(txn);
+        }
+        else {
+            _calculateStonesBySampling(txn, estimatedStones);
+        }
+
+        LOG(1) << "oplog " << _rs->ns() << " starts with " << _stones.size() << " stones of "
+               << _minBytesPerStone << " bytes";
+    }
+
+    void WiredTigerRecordStore::OplogStones::_calculateStonesByScanning(OperationContext* txn) {
+        scoped_ptr<RecordIterator> iterator(_rs->getIterator(txn));
+        while (!iterator->isEOF()) {
+            const RecordId loc = iterator->getNext();
+            _currentRecords++;
+            _currentBytes += iterator->dataFor(loc).size();
+            if (_currentBytes >= _minBytesPerStone) {
+                _stones.push_back(Stone(_currentRecords, _currentBytes, loc));
+                _currentRecords = 0;
+                _currentBytes = 0;
+            }
+        }
+    }
+
+    void WiredTigerRecordStore::OplogStones::_calculateStonesBySampling(OperationContext* txn,
+                                                                        int64_t estimatedStones) {
+        // Every stone gets the same estimated share, with its boundary at every
+        // kRandomSamplesPerStone-th of the sorted random samples.
+        const int64_t numRecords = _rs->_numRecords.load();
+        const int64_t dataSize = _rs->_dataSize.load();
+        const int64_t avgRecordSize = std::max(int64_t(1), dataSize / numRecords);
+        const int64_t recordsPerStone = std::max(int64_t(1), _minBytesPerStone / avgRecordSize);
+        const int64_t bytesPerStone = recordsPerStone * avgRecordSize;
+
+        std::vector<RecordId> samples;
+        samples.reserve(kRandomSamplesPerStone * estimatedStones);
+        scoped_ptr<RecordIterator> iterator(_rs->getRandomIterator(txn));
+        while (!iterator->isEOF() &&
+               samples.size() < static_cast<size_t>(kRandomSamplesPerStone * estimatedStones)) {
+            samples.push_back(iterator->getNext());
+        }
+        std::sort(samples.begin(), samples.end());
+
+        for (size_t i = kRandomSamplesPerStone; i <= samples.size(); i += kRandomSamplesPerStone) {
+            _stones.push_back(Stone(recordsPerStone, bytesPerStone, samples[i - 1]));
+        }
+
+        const int64_t numStones = _stones.size();
+        _currentRecords = std::max(int64_t(0), numRecords - recordsPerStone * numStones);
+        _currentBytes = std::max(int64_t(0), dataSize - bytesPerStone * numStones);
+    }
+
+    void WiredTigerRecordStore::OplogStones::_addCommitted(int64_t records,
+                                                           int64_t bytes,
+                                                           const RecordId& highest) {
+        boost::mutex::scoped_lock lk(_mutex);
+        _currentRecords += records;
+        _currentBytes += bytes;
+        if (_currentBytes < _minBytesPerStone) {
+            return;
+        }
+
+        // Oplog transactions may commit out of order, so a stone never ends before the last one.
+        RecordId lastRecord = highest;
+        if (!_stones.empty() && _stones.back().lastRecord > lastRecord) {
+            lastRecord = _stones.back().lastRecord;
+        }
+        _stones.push_back(Stone(_currentRecords, _currentBytes, lastRecord));
+        _currentRecords = 0;
+        _currentBytes = 0;
+
+        if (_hasExcessStones_inlock()) {
+            _hasExcessStones.notify_one();
+        }
+    }
+
+    bool WiredTigerRecordStore::OplogStones::_hasExcessStones_inlock() const {
+        return !_stones.empty() && _rs->_dataSize.load() > _rs->_cappedMaxSize;
+    }
+
+    void WiredTigerRecordStore::OplogStones::_reclaimThread() {
+        while (true) {
+            {
+                boost::mutex::scoped_lock lk(_mutex);
+                while (!_shuttingDown && !_hasExcessStones_inlock()) {
+                    _hasExcessStones.wait(lk);
+                }
+                if (_shuttingDown) {
+                    return;
+                }
+            }
+
+            if (!_reclaimOldestStone()) {
+                // Lost to a conflicting transaction; let it finish before trying again.
+                sleepmillis(10);
+            }
+        }
+    }
+
+    bool WiredTigerRecordStore::OplogStones::_reclaimOldestStone() {
+        Stone stone(0, 0, RecordId());
+        {
+            boost::mutex::scoped_lock lk(_mutex);
+            if (_stones.empty()) {
+                return true;
+            }
+            stone = _stones.front();
+        }
+
+        OperationContextNoop txn(new WiredTigerRecoveryUnit(_sessionCache));
+        try {
+            WriteUnitOfWork wuow(&txn);
+
+            WiredTigerCursor stop(_rs->_uri, _rs->_instanceId, &txn);
+            WT_CURSOR* c = stop.get();
+            c->set_key(c, _makeKey(stone.lastRecord));
+
+            // A NULL start cursor truncates from the beginning of the table.
+            WT_SESSION* session = stop.getWTSession();
+            uassertStatusOK(wtRCToStatus(session->truncate(session, NULL, NULL, c, NULL),
+                                         "WiredTigerRecordStore::OplogStones"));
+
+            _rs->_addNumRecords(&txn, -stone.records);
+            _rs->_increaseDataSize(&txn, -stone.bytes);
+
+            wuow.commit();
+        }
+        catch (const WriteConflictException&) {
+            LOG(1) << "got conflict truncating oplog " << _rs->ns() << ", retrying";
+            return false;
+        }
+        catch (const DBException& e) {
+            error() << "failed to truncate oplog " << _rs->ns() << ", retrying: " << e.what();
+            return false;
+        }
+
+        boost::mutex::scoped_lock lk(_mutex);
+        // The stones may have been cleared or truncated while the lock was released.
+        if (!_stones.empty() && _stones.front().lastRecord == stone.lastRecord) {
+            _stones.pop_front();
+        }
+        return true;
+    }
+
     // static
     StatusWith<std::string> WiredTigerRecordStore::generateCreateString(
         const StringData& ns,
@@ -170,8 +518,7 @@ namespace {
               _cappedMaxDocs( cappedMaxDocs ),
               _cappedDeleteCallback( cappedDeleteCallback ),
               _useOplogHack(shouldUseOplogHack(ctx, _uri)),
-              _sizeStorer( sizeStorer ),
-              _sizeStorerCounter(0)
+              _sizeStorer( sizeStorer )
     {
 
         if (_isCapped) {
@@ -218,8 +565,8 @@ namespace {
                 while( !iterator->isEOF() ) {
                     RecordId loc = iterator->getNext();
                     RecordData data = iterator->dataFor( loc );
-                    _numRecords.fetchAndAdd(1);
-                    _dataSize.fetchAndAdd(data.size());
+                    _numRecords.increment();
+                    _dataSize.add(data.size());
                 }
 
                 if ( _sizeStorer ) {
@@ -229,10 +576,15 @@ namespace {
 
         }
 
+        if ( _isOplog && _isCapped && wiredTigerOplogStones ) {
+            _oplogStones.reset( new OplogStones( ctx, this ) );
+        }
     }
 
     WiredTigerRecordStore::~WiredTigerRecordStore() {
         LOG(1) << "~WiredTigerRecordStore for: " << ns();
+        // Stop truncating before the sizes are saved.
+        _oplogStones.reset();
         if ( _sizeStorer ) {
             _sizeStorer->onDestroy( this );
             _sizeStorer->store( _uri, _numRecords.load(), _dataSize.load() );
@@ -363,6 +715,11 @@ namespace {
     void WiredTigerRecordStore::cappedDeleteAsNeeded(OperationContext* txn,
                                                      const RecordId& justInserted ) {
 
+        if ( _oplogStones ) {
+            // Whole stones get truncated in the background instead.
+            return;
+        }
+
         if ( _isOplog ) {
             if ( oplogCounter++ % 100 > 0 )
                 return;
@@ -493,6 +850,10 @@ namespace {
         _changeNumRecords( txn, true );
         _increaseDataSize( txn, len );
 
+        if ( _oplogStones ) {
+            _oplogStones->updateCurrentStoneAfterInsertOnCommit( txn, len, loc, 1 );
+        }
+
         cappedDeleteAsNeeded(txn, loc);
 
         return StatusWith<RecordId>( loc );
@@ -526,6 +887,119 @@ namespace {
         return insertRecord( txn, buf.get(), len, enforceQuota );
     }
 
+    Status WiredTigerRecordStore::insertRecords( OperationContext* txn,
+                                                 const std::vector<RecordData>& records,
+                                                 bool enforceQuota,
+                                                 std::vector<RecordId>* locsOut ) {
+        if ( records.empty() )
+            return Status::OK();
+
+        if ( _useOplogHack )
+            return _insertOplogRecords( txn, records, locsOut );
+
+        if ( _isCapped ) {
+            // Capped inserts hide and delete as they go, one record at a time.
+            return RecordStore::insertRecords( txn, records, enforceQuota, locsOut );
+        }
+
+        // Reserve the whole range up front, so the batch gets contiguous increasing keys which
+        // all land at the end of the table, and the counter is only touched once.
+        const int64_t first = _nextIdNum.fetchAndAdd( records.size() );
+        invariant( RecordId( first ).isNormal() );
+        invariant( RecordId( first + records.size() - 1 ).isNormal() );
+
+        WiredTigerCursor curwrap( _uri, _instanceId, txn);
+        curwrap.assertInActiveTxn();
+        WT_CURSOR *c = curwrap.get();
+        invariant( c );
+
+        Status status = Status::OK();
+        size_t nInserted = 0;
+        int64_t totalLength = 0;
+        for ( ; nInserted < records.size(); nInserted++ ) {
+            const RecordId loc( first + nInserted );
+            c->set_key(c, _makeKey(loc));
+            WiredTigerItem value(records[nInserted].data(), records[nInserted].size());
+            c->set_value(c, value.Get());
+            int ret = c->insert(c);
+            if ( ret ) {
+                status = wtRCToStatus( ret, "WiredTigerRecordStore::insertRecords" );
+                break;
+            }
+            locsOut->push_back( loc );
+            totalLength += records[nInserted].size();
+        }
+
+        if ( nInserted > 0 ) {
+            _addNumRecords( txn, nInserted );
+            _increaseDataSize( txn, totalLength );
+        }
+
+        return status;
+    }
+
+    Status WiredTigerRecordStore::_insertOplogRecords( OperationContext* txn,
+                                                       const std::vector<RecordData>& records,
+                                                       std::vector<RecordId>* locsOut ) {
+        // The keys come from the entries' timestamps, which the caller registered as
+        // uncommitted, so the batch only needs one cursor and one capped delete pass.
+        std::vector<RecordId> locs;
+        locs.reserve( records.size() );
+        for ( size_t i = 0; i < records.size(); i++ ) {
+            if ( records[i].size() > _cappedMaxSize ) {
+                return Status( ErrorCodes::BadValue, "object to insert exceeds cappedMaxSize" );
+            }
+
+            StatusWith<RecordId> status = extractAndCheckLocForOplog( records[i].data(),
+                                                                      records[i].size() );
+            if ( !status.isOK() )
+                return status.getStatus();
+            locs.push_back( status.getValue() );
+        }
+
+        {
+            boost::mutex::scoped_lock lk( _uncommittedDiskLocsMutex );
+            for ( size_t i = 0; i < locs.size(); i++ ) {
+                if ( locs[i] > _oplog_highestSeen )
+                    _oplog_highestSeen = locs[i];
+            }
+        }
+
+        WiredTigerCursor curwrap( _uri, _instanceId, txn);
+        curwrap.assertInActiveTxn();
+        WT_CURSOR *c = curwrap.get();
+        invariant( c );
+
+        Status status = Status::OK();
+        size_t nInserted = 0;
+        int64_t totalLength = 0;
+        for ( ; nInserted < records.size(); nInserted++ ) {
+            c->set_key(c, _makeKey(locs[nInserted]));
+            WiredTigerItem value(records[nInserted].data(), records[nInserted].size());
+            c->set_value(c, value.Get());
+            int ret = c->insert(c);
+            if ( ret ) {
+                status = wtRCToStatus( ret, "WiredTigerRecordStore::insertRecords" );
+                break;
+            }
+            locsOut->push_back( locs[nInserted] );
+            totalLength += records[nInserted].size();
+        }
+
+        if ( nInserted > 0 ) {
+            _addNumRecords( txn, nInserted );
+            _increaseDataSize( txn, totalLength );
+            if ( _oplogStones ) {
+                _oplogStones->updateCurrentStoneAfterInsertOnCommit( txn, totalLength,
+                                                                     locs[nInserted - 1],
+                                                                     nInserted );
+            }
+            cappedDeleteAsNeeded( txn, locs[nInserted - 1] );
+        }
+
+        return status;
+    }
+
     StatusWith<RecordId> WiredTigerRecordStore::updateRecord( OperationContext* txn,
                                                               const RecordId& loc,
                                                               const char* data,
@@ -565,9 +1039,11 @@ namespace {
                                                      const char* damageSource,
                                                      const mutablebson::DamageVector& damages ) {
 
-        // apply changes to our copy
+        // apply changes to our copy, which damages that append to the record make larger
 
+        const int newSize = mutablebson::getDamagedSize(oldRec.size(), damages);
         std::string data(reinterpret_cast<const char *>(oldRec.data()), oldRec.size());
+        data.resize(newSize);
 
         char* root = const_cast<char*>( data.c_str() );
         for( size_t i = 0; i < damages.size(); i++ ) {
@@ -590,9 +1066,21 @@ namespace {
         int ret = c->update(c);
         invariantWTOK(ret);
 
+        if (newSize != oldRec.size()) {
+            _increaseDataSize(txn, newSize - oldRec.size());
+        }
+
         return Status::OK();
     }
 
+    bool WiredTigerRecordStore::updateWithDamagesCanGrow( OperationContext* txn,
+                                                         const RecordId& loc,
+                                                         int newSize ) const {
+        // Every update rewrites the whole value, so only capped collections, whose records
+        // may not grow, are excluded.
+        return !_isCapped;
+    }
+
     void WiredTigerRecordStore::_oplogSetStartHack( WiredTigerRecoveryUnit* wru ) const {
         boost::mutex::scoped_lock lk( _uncommittedDiskLocsMutex );
         if ( _uncommittedDiskLocs.empty() ) {
@@ -640,6 +1128,10 @@ namespace {
             deleteRecord( txn, loc );
         }
 
+        if ( _oplogStones ) {
+            _oplogStones->clearStonesOnCommit( txn );
+        }
+
         // WiredTigerRecoveryUnit* ru = _getRecoveryUnit( txn );
 
         return Status::OK();
@@ -718,6 +1210,14 @@ namespace {
         }
     }
 
+    bool WiredTigerRecordStore::appendCacheStats(OperationContext* txn,
+                                                 BSONObjBuilder* result,
+                                                 double scale) const {
+        WiredTigerSession* session = WiredTigerRecoveryUnit::get(txn)->getSession();
+        return WiredTigerUtil::appendCacheStats(session->getSession(), GetURI(), result,
+                                                scale).isOK();
+    }
+
     Status WiredTigerRecordStore::touch( OperationContext* txn, BSONObjBuilder* output ) const {
         if (output) {
             output->append("numRanges", 1);
@@ -826,30 +1326,34 @@ namespace {
 
     class WiredTigerRecordStore::NumRecordsChange : public RecoveryUnit::Change {
     public:
-        NumRecordsChange(WiredTigerRecordStore* rs, bool insert) :_rs(rs), _insert(insert) {}
+        NumRecordsChange(WiredTigerRecordStore* rs, int64_t diff) :_rs(rs), _diff(diff) {}
         virtual void commit() {}
         virtual void rollback() {
-            _rs->_numRecords.fetchAndAdd(_insert ? -1 : 1);
+            _rs->_numRecords.add(-_diff);
+            _rs->_markSizeChanged();
         }
 
     private:
         WiredTigerRecordStore* _rs;
-        bool _insert;
+        int64_t _diff;
     };
 
     void WiredTigerRecordStore::_changeNumRecords( OperationContext* txn, bool insert ) {
-        txn->recoveryUnit()->registerChange(new NumRecordsChange(this, insert));
-        if ( _numRecords.fetchAndAdd(insert ? 1 : -1) < 0 ) {
-            if ( insert )
-                _numRecords.store( 1 );
-            else
-                _numRecords.store( 0 );
+        _addNumRecords( txn, insert ? 1 : -1 );
+    }
+
+    void WiredTigerRecordStore::_addNumRecords( OperationContext* txn, int64_t diff ) {
+        txn->recoveryUnit()->registerChange(new NumRecordsChange(this, diff));
+        _numRecords.add(diff);
+        if ( diff < 0 && _numRecords.load() < 0 ) {
+            _numRecords.store( 0 );
         }
+        _markSizeChanged();
     }
 
     class WiredTigerRecordStore::DataSizeChange : public RecoveryUnit::Change {
     public:
-        DataSizeChange(WiredTigerRecordStore* rs, int amount) :_rs(rs), _amount(amount) {}
+        DataSizeChange(WiredTigerRecordStore* rs, int64_t amount) :_rs(rs), _amount(amount) {}
         virtual void commit() {}
         virtual void rollback() {
             _rs->_increaseDataSize( NULL, -_amount );
@@ -857,24 +1361,25 @@ namespace {
 
     private:
         WiredTigerRecordStore* _rs;
-        bool _amount;
+        int64_t _amount;
     };
 
-    void WiredTigerRecordStore::_increaseDataSize( OperationContext* txn, int amount ) {
+    void WiredTigerRecordStore::_increaseDataSize( OperationContext* txn, int64_t amount ) {
         if ( txn )
             txn->recoveryUnit()->registerChange(new DataSizeChange(this, amount));
 
-        if ( _dataSize.fetchAndAdd(amount) < 0 ) {
-            if ( amount > 0 ) {
-                _dataSize.store( amount );
-            }
-            else {
-                _dataSize.store( 0 );
-            }
+        _dataSize.add(amount);
+        if ( amount < 0 && _dataSize.load() < 0 ) {
+            _dataSize.store( 0 );
         }
+        _markSizeChanged();
+    }
 
-        if ( _sizeStorer && _sizeStorerCounter++ % 1000 == 0 ) {
-            _sizeStorer->store( _uri, _numRecords.load(), _dataSize.load() );
+    void WiredTigerRecordStore::_markSizeChanged() {
+        // Only the first change since the size storer last looked costs more than a load, so
+        // the storer only visits record stores which changed.
+        if ( _sizeStorer && _sizeChanged.load() == 0 && _sizeChanged.compareAndSwap( 0, 1 ) == 0 ) {
+            _sizeStorer->onSizeChange( this );
         }
     }
 
@@ -1092,6 +1597,18 @@ namespace {
         return true;
     }
 
+    RecordData WiredTigerRecordStore::Iterator::currData() {
+        // Hand out the cursor's own copy of the value, which WiredTiger keeps until the cursor
+        // is next moved or reset.
+        invariant(!_eof);
+        dassert(_loc == _curr());
+        WT_CURSOR* c = _cursor->get();
+        WT_ITEM value;
+        int ret = c->get_value(c, &value);
+        invariantWTOK(ret);
+        return RecordData(static_cast<const char*>(value.data), value.size);
+    }
+
     RecordData WiredTigerRecordStore::Iterator::dataFor( const RecordId& loc ) const {
         // Retrieve the data if the iterator is already positioned at loc, otherwise
         // open a new cursor and find the data to avoid upsetting the iterators
@@ -1105,17 +1622,152 @@ namespace {
         }
     }
 
+    // --------
+
+    /**
+     * Positions a "next_random" cursor on a random record for each getNext().  The cursor
+     * doesn't come from the session's cache since those are opened without that config, and
+     * it is closed across yields since it has no position worth keeping.
+     */
+    class WiredTigerRecordStore::RandomIterator : public RecordIterator {
+    public:
+        RandomIterator( const WiredTigerRecordStore& rs, OperationContext* txn );
+
+        virtual ~RandomIterator();
+
+        virtual bool isEOF();
+        virtual RecordId curr();
+        virtual RecordId getNext();
+        virtual void invalidate(const RecordId& dl);
+        virtual void saveState();
+        virtual bool restoreState(OperationContext *txn);
+        virtual RecordData dataFor( const RecordId& loc ) const;
+
+    private:
+        void _openCursor();
+        void _closeCursor();
+        void _advance();
+
+        const WiredTigerRecordStore& _rs;
+        OperationContext* _txn;
+        WT_CURSOR* _cursor; // owned, NULL while saved
+        bool _eof;
+        RecordId _loc;
+    };
+
+    WiredTigerRecordStore::RandomIterator::RandomIterator( const WiredTigerRecordStore& rs,
+                                                           OperationContext* txn )
+        : _rs( rs ),
+          _txn( txn ),
+          _cursor( NULL ),
+          _eof( false ) {
+        _openCursor();
+        _advance();
+    }
+
+    WiredTigerRecordStore::RandomIterator::~RandomIterator() {
+        _closeCursor();
+    }
+
+    void WiredTigerRecordStore::RandomIterator::_openCursor() {
+        invariant( !_cursor );
+        WT_SESSION* session = WiredTigerRecoveryUnit::get( _txn )->getSession()->getSession();
+        invariantWTOK( session->open_cursor( session, _rs.GetURI().c_str(), NULL,
+                                             "next_random=true", &_cursor ) );
+    }
+
+    void WiredTigerRecordStore::RandomIterator::_closeCursor() {
+        if ( _cursor ) {
+            invariantWTOK( _cursor->close( _cursor ) );
+            _cursor = NULL;
+        }
+    }
+
+    void WiredTigerRecordStore::RandomIterator::_advance() {
+        if ( _eof )
+            return;
+
+        while ( true ) {
+            int ret = _cursor->next( _cursor );
+            if ( ret == WT_NOTFOUND ) {
+                // Only an empty table has no random record.
+                _eof = true;
+                _loc = RecordId();
+                return;
+            }
+            invariantWTOK( ret );
+
+            int64_t key;
+            invariantWTOK( _cursor->get_key( _cursor, &key ) );
+            _loc = _fromKey( key );
+            if ( !_rs._isCapped || !_rs.isCappedHidden( _loc ) )
+                return;
+        }
+    }
+
+    bool WiredTigerRecordStore::RandomIterator::isEOF() {
+        return _eof;
+    }
+
+    RecordId WiredTigerRecordStore::RandomIterator::curr() {
+        return _loc;
+    }
+
+    RecordId WiredTigerRecordStore::RandomIterator::getNext() {
+        const RecordId toReturn = _loc;
+        _advance();
+        return toReturn;
+    }
+
+    void WiredTigerRecordStore::RandomIterator::invalidate( const RecordId& dl ) {
+        // Like Iterator, WiredTiger never asks for invalidations.
+    }
+
+    void WiredTigerRecordStore::RandomIterator::saveState() {
+        _closeCursor();
+        _txn = NULL;
+    }
+
+    bool WiredTigerRecordStore::RandomIterator::restoreState( OperationContext *txn ) {
+        _txn = txn;
+        if ( !_eof ) {
+            // The record at _loc may be gone, so jump somewhere new.
+            _openCursor();
+            _advance();
+        }
+        return true;
+    }
+
+    RecordData WiredTigerRecordStore::RandomIterator::dataFor( const RecordId& loc ) const {
+        return _rs.dataFor( _txn, loc );
+    }
+
+    RecordIterator* WiredTigerRecordStore::getRandomIterator( OperationContext* txn ) const {
+        return new RandomIterator(*this, txn);
+    }
+
     void WiredTigerRecordStore::temp_cappedTruncateAfter( OperationContext* txn,
                                                           RecordId end,
                                                           bool inclusive ) {
         WriteUnitOfWork wuow(txn);
         boost::scoped_ptr<RecordIterator> iter( getIterator( txn, end ) );
+        int64_t recordsRemoved = 0;
+        int64_t bytesRemoved = 0;
         while( !iter->isEOF() ) {
             RecordId loc = iter->getNext();
             if ( end < loc || ( inclusive && end == loc ) ) {
+                if ( _oplogStones ) {
+                    recordsRemoved++;
+                    bytesRemoved += iter->dataFor( loc ).size();
+                }
                 deleteRecord( txn, loc );
             }
         }
         wuow.commit();
+
+        if ( _oplogStones ) {
+            _oplogStones->updateStonesAfterCappedTruncateAfter( recordsRemoved, bytesRemoved,
+                                                                end );
+        }
     }
 }
@@ -34,12 +34,14 @@
 #include <set>
 #include <string>
 
+#include <boost/scoped_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 
 #include "mongo/db/catalog/collection_options.h"
 #include "mongo/db/storage/record_store.h"
 #include "mongo/db/storage/capped_callback.h"
 #include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/sharded_counter.h"
 
 namespace mongo {
 
@@ -109,6 +111,11 @@ namespace mongo {
                                                   const DocWriter* doc,
                                                   bool enforceQuota );
 
+        virtual Status insertRecords( OperationContext* txn,
+                                      const std::vector<RecordData>& records,
+                                      bool enforceQuota,
+                                      std::vector<RecordId>* locsOut );
+
         virtual StatusWith<RecordId> updateRecord( OperationContext* txn,
                                                   const RecordId& oldLocation,
                                                   const char* data,
@@ -122,6 +129,10 @@ namespace mongo {
                                           const char* damageSource,
                                           const mutablebson::DamageVector& damages );
 
+        virtual bool updateWithDamagesCanGrow( OperationContext* txn,
+                                               const RecordId& loc,
+                                               int newSize ) const;
+
         virtual RecordIterator* getIterator( OperationContext* txn,
                                              const RecordId& start = RecordId(),
                                              const CollectionScanParams::Direction& dir =
@@ -129,6 +140,8 @@ namespace mongo {
 
         virtual std::vector<RecordIterator*> getManyIterators( OperationContext* txn ) const;
 
+        virtual RecordIterator* getRandomIterator( OperationContext* txn ) const;
+
         virtual Status truncate( OperationContext* txn );
 
         virtual bool compactSupported() const { return true; }
@@ -149,6 +162,10 @@ namespace mongo {
                                         BSONObjBuilder* result,
                                         double scale ) const;
 
+        virtual bool appendCacheStats(OperationContext* txn,
+                                      BSONObjBuilder* result,
+                                      double scale) const;
+
         virtual Status touch( OperationContext* txn, BSONObjBuilder* output ) const;
 
         virtual Status setCustomOption( OperationContext* txn,
@@ -179,6 +196,12 @@ namespace mongo {
 
         void setSizeStorer( WiredTigerSizeStorer* ss ) { _sizeStorer = ss; }
 
+        /**
+         * Called by the size storer before it reads numRecords() and dataSize(), so that the next
+         * change to either tells it again that there is something to store.
+         */
+        void clearSizeChanged() { _sizeChanged.store( 0 ); }
+
         void dealtWithCappedLoc( const RecordId& loc );
         bool isCappedHidden( const RecordId& loc ) const;
 
@@ -201,6 +224,7 @@ namespace mongo {
             virtual void saveState();
             virtual bool restoreState(OperationContext *txn);
             virtual RecordData dataFor( const RecordId& loc ) const;
+            virtual RecordData currData();
 
         private:
             void _getNext();
@@ -220,6 +244,8 @@ namespace mongo {
             RecordId _lastLoc; // the last thing returned from getNext()
         };
 
+        class RandomIterator;
+        class OplogStones;
         class CappedInsertChange;
         class NumRecordsChange;
         class DataSizeChange;
@@ -236,9 +262,14 @@ namespace mongo {
         bool cappedAndNeedDelete() const;
         void cappedDeleteAsNeeded(OperationContext* txn, const RecordId& justInserted );
         void _changeNumRecords(OperationContext* txn, bool insert);
-        void _increaseDataSize(OperationContext* txn, int amount);
+        void _addNumRecords(OperationContext* txn, int64_t diff);
+        void _increaseDataSize(OperationContext* txn, int64_t amount);
+        void _markSizeChanged();
         RecordData _getData( const WiredTigerCursor& cursor) const;
         StatusWith<RecordId> extractAndCheckLocForOplog(const char* data, int len);
+        Status _insertOplogRecords(OperationContext* txn,
+                                   const std::vector<RecordData>& records,
+                                   std::vector<RecordId>* locsOut);
         void _oplogSetStartHack( WiredTigerRecoveryUnit* wru ) const;
 
         const std::string _uri;
@@ -261,10 +292,17 @@ namespace mongo {
         mutable boost::mutex _uncommittedDiskLocsMutex;
 
         AtomicInt64 _nextIdNum;
-        AtomicInt64 _dataSize;
-        AtomicInt64 _numRecords;
+
+        // Every insert and delete changes these, so they are sharded across threads rather than
+        // making writers on different cores fight over one cache line.
+        ShardedCounter _dataSize;
+        ShardedCounter _numRecords;
 
         WiredTigerSizeStorer* _sizeStorer; // not owned, can be NULL
-        int _sizeStorerCounter;
+        AtomicUInt32 _sizeChanged; // 1 once the size storer has been told of a change
+
+        // Set for the oplog, which reclaims space by truncating whole stones in the background
+        // instead of deleting its oldest entries as it inserts.
+        boost::scoped_ptr<OplogStones> _oplogStones;
     };
 }
@@ -30,6 +30,9 @@
 
 #include "mongo/platform/basic.h"
 
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <set>
 #include <sstream>
 #include <string>
 
@@ -133,6 +136,8 @@ namespace mongo {
         virtual RecoveryUnit* newRecoveryUnit() {
             return new WiredTigerRecoveryUnit( _sessionCache );
         }
+
+        virtual bool supportsDocLocking() { return true; }
     private:
         unittest::TempDir _dbpath;
         WT_CONNECTION* _conn;
@@ -347,6 +352,72 @@ namespace mongo {
         rs.reset( NULL ); // this has to be deleted before ss
     }
 
+    namespace {
+        // Has 'ss' store into a new table 'tableUri', and returns the uris written there.
+        std::set<std::string> storeSizes( HarnessHelper* harnessHelper,
+                                          WiredTigerSizeStorer* ss,
+                                          const std::string& tableUri ) {
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            WiredTigerSession* session = WiredTigerRecoveryUnit::get( opCtx.get() )->getSession();
+            {
+                WriteUnitOfWork uow( opCtx.get() );
+                ss->storeInto( session, tableUri );
+                uow.commit();
+            }
+
+            std::set<std::string> uris;
+            WT_SESSION* s = session->getSession();
+            WT_CURSOR* c = NULL;
+            invariantWTOK( s->open_cursor( s, tableUri.c_str(), NULL, NULL, &c ) );
+            while ( c->next(c) == 0 ) {
+                WT_ITEM key;
+                invariantWTOK( c->get_key( c, &key ) );
+                uris.insert( std::string( static_cast<const char*>( key.data ), key.size ) );
+            }
+            invariantWTOK( c->close(c) );
+            return uris;
+        }
+    }
+
+    TEST(WiredTigerRecordStoreTest, SizeStorerStoresOnlyChanges ) {
+        scoped_ptr<HarnessHelper> harnessHelper( newHarnessHelper() );
+        scoped_ptr<RecordStore> rs( harnessHelper->newNonCappedRecordStore() );
+        const string uri = dynamic_cast<WiredTigerRecordStore*>( rs.get() )->GetURI();
+
+        WiredTigerSizeStorer ss;
+        {
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            rs.reset( new WiredTigerRecordStore( opCtx.get(), "a.b", uri,
+                                                 false, -1, -1, NULL, &ss ) );
+        }
+        ss.store( "table:other", 5, 50 );
+
+        std::set<std::string> stored = storeSizes( harnessHelper.get(), &ss, "table:sizes1" );
+        ASSERT_EQUALS( 2U, stored.size() );
+        ASSERT_EQUALS( 1U, stored.count( uri ) );
+
+        ASSERT( storeSizes( harnessHelper.get(), &ss, "table:sizes2" ).empty() );
+
+        {
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            WriteUnitOfWork uow( opCtx.get() );
+            ASSERT_OK( rs->insertRecord( opCtx.get(), "a", 2, false ).getStatus() );
+            uow.commit();
+        }
+
+        stored = storeSizes( harnessHelper.get(), &ss, "table:sizes3" );
+        ASSERT_EQUALS( 1U, stored.size() );
+        ASSERT_EQUALS( 1U, stored.count( uri ) );
+
+        long long numRecords;
+        long long dataSize;
+        ss.load( uri, &numRecords, &dataSize );
+        ASSERT_EQUALS( 1, numRecords );
+        ASSERT_EQUALS( 2, dataSize );
+
+        rs.reset( NULL ); // this has to be deleted before ss
+    }
+
     StatusWith<RecordId> insertBSON(scoped_ptr<OperationContext>& opCtx,
                                    scoped_ptr<RecordStore>& rs,
                                    const OpTime& opTime) {
@@ -623,6 +694,85 @@ namespace mongo {
         }
     }
 
+    TEST(WiredTigerRecordStoreTest, OplogStonesTruncateInBackground) {
+        scoped_ptr<WiredTigerHarnessHelper> harnessHelper( new WiredTigerHarnessHelper() );
+        const int64_t cappedMaxSize = 10000;
+        scoped_ptr<RecordStore> rs(harnessHelper->newCappedRecordStore("local.oplog.stones",
+                                                                       cappedMaxSize,
+                                                                       -1));
+        WiredTigerRecordStore* wrs = dynamic_cast<WiredTigerRecordStore*>(rs.get());
+        ASSERT( wrs->usingOplogHack() );
+
+        const std::string filler( 400, 'x' );
+        for ( int i = 1; i <= 100; i++ ) {
+            scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+            WriteUnitOfWork uow( opCtx.get() );
+            const OpTime opTime( 1, i );
+            ASSERT_OK( wrs->oplogDiskLocRegister( opCtx.get(), opTime ) );
+            BSONObj obj = BSON( "ts" << opTime << "o" << filler );
+            ASSERT_OK( rs->insertRecord( opCtx.get(), obj.objdata(), obj.objsize(),
+                                         false ).getStatus() );
+            uow.commit();
+        }
+
+        scoped_ptr<OperationContext> opCtx( harnessHelper->newOperationContext() );
+        for ( int i = 0; i < 1000 && rs->dataSize( opCtx.get() ) > cappedMaxSize; i++ ) {
+            sleepmillis( 10 );
+        }
+        ASSERT_LESS_THAN_OR_EQUALS( rs->dataSize( opCtx.get() ), cappedMaxSize );
+
+        // Only whole stones went, which are a tenth of the maximum size here.
+        ASSERT_GREATER_THAN( rs->dataSize( opCtx.get() ), cappedMaxSize * 3 / 4 );
+
+        long long count = 0;
+        long long size = 0;
+        scoped_ptr<RecordIterator> it( rs->getIterator( opCtx.get() ) );
+        ASSERT_NOT_EQUALS( RecordId( 1, 1 ), it->curr() );
+        RecordId last;
+        while ( !it->isEOF() ) {
+            last = it->getNext();
+            count++;
+            size += it->dataFor( last ).size();
+        }
+        ASSERT_EQUALS( RecordId( 1, 100 ), last );
+        ASSERT_EQUALS( count, rs->numRecords( opCtx.get() ) );
+        ASSERT_EQUALS( size, rs->dataSize( opCtx.get() ) );
+    }
+
+    namespace {
+        void insertAndAwaitCommit(HarnessHelper* harnessHelper, RecordStore* rs, int numInserts) {
+            for (int i = 0; i < numInserts; i++) {
+                scoped_ptr<OperationContext> opCtx(harnessHelper->newOperationContext());
+                {
+                    WriteUnitOfWork uow(opCtx.get());
+                    ASSERT_OK(rs->insertRecord(opCtx.get(), "a", 2, false).getStatus());
+                    uow.commit();
+                }
+                ASSERT_TRUE(opCtx->recoveryUnit()->awaitCommit());
+            }
+        }
+    }
+
+    TEST(WiredTigerRecordStoreTest, AwaitCommitSharedBetweenWriters) {
+        WiredTigerHarnessHelper harnessHelper("log=(enabled)");
+        scoped_ptr<RecordStore> rs(harnessHelper.newNonCappedRecordStore("a.b"));
+
+        const int numThreads = 4;
+        const int numInsertsPerThread = 10;
+
+        boost::thread_group threads;
+        for (int i = 0; i < numThreads; i++) {
+            threads.create_thread(boost::bind(insertAndAwaitCommit,
+                                              &harnessHelper,
+                                              rs.get(),
+                                              numInsertsPerThread));
+        }
+        threads.join_all();
+
+        scoped_ptr<OperationContext> opCtx(harnessHelper.newOperationContext());
+        ASSERT_EQUALS(numThreads * numInsertsPerThread, rs->numRecords(opCtx.get()));
+    }
+
     TEST(WiredTigerRecordStoreTest, StorageSizeStatisticsDisabled) {
         WiredTigerHarnessHelper harnessHelper("statistics=(none)");
         scoped_ptr<RecordStore> rs(harnessHelper.newNonCappedRecordStore("a.b"));
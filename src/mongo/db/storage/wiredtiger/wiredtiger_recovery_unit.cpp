@@ -34,43 +34,104 @@
 #include <boost/thread/mutex.hpp>
 
 #include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
 #include "mongo/util/log.h"
 #include "mongo/util/stacktrace.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
+    // Longest time, in ms, that the flush started on behalf of a j:true writer waits for other
+    // writers to commit so that they can all share it.  0 flushes as soon as the previous flush
+    // finishes; writers that commit meanwhile still share the next one.
+    MONGO_EXPORT_SERVER_PARAMETER(wiredTigerJournalCommitDelayMillis, int, 0);
+
+    const char WiredTigerRecoveryUnit::kGroupCommitIdent[] = "groupCommit";
+
     namespace {
-        struct AwaitCommitData {
-            AwaitCommitData() :
-                numWaitingForSync(0),
-                lastSyncTime(0) {
+        /**
+         * Makes commits durable for writers waiting on the journal, sharing one log sync between
+         * all the writers that committed before it started.
+         *
+         * One waiting writer at a time becomes the flusher.  It writes a record to a small table
+         * in a "sync=true" transaction, which syncs the log up to and including every commit that
+         * finished before the flush began, then wakes every writer that the flush covered.
+         */
+        class GroupCommit {
+        public:
+            GroupCommit() :
+                _numRequested(0),
+                _numFlushed(0),
+                _flushing(false) {
             }
 
-            void syncHappend() {
-                boost::mutex::scoped_lock lk( mutex );
-                lastSyncTime++;
-                condvar.notify_all();
+            void waitUntilDurable(WiredTigerSessionCache* sessionCache) {
+                boost::mutex::scoped_lock lk(_mutex);
+
+                // Our writes are already committed, so any flush started from now on covers them
+                const long long ticket = ++_numRequested;
+
+                while (_numFlushed < ticket) {
+                    if (_flushing) {
+                        _flushed.wait(lk);
+                        continue;
+                    }
+
+                    _flushing = true;
+                    const int delayMillis = wiredTigerJournalCommitDelayMillis;
+                    if (delayMillis > 0) {
+                        lk.unlock();
+                        sleepmillis(delayMillis);
+                        lk.lock();
+                    }
+
+                    const long long covered = _numRequested;
+                    lk.unlock();
+                    _flush(sessionCache, covered);
+                    lk.lock();
+
+                    _flushing = false;
+                    _numFlushed = covered;
+                    _flushed.notify_all();
+                }
             }
 
-            // return true if happened
-            bool awaitCommit() {
-                boost::mutex::scoped_lock lk( mutex );
-                long long start = lastSyncTime;
-                numWaitingForSync.fetchAndAdd(1);
-                condvar.timed_wait(lk,boost::posix_time::milliseconds(50));
-                numWaitingForSync.fetchAndAdd(-1);
-                return lastSyncTime > start;
+        private:
+            // Only called by the one thread that set _flushing
+            void _flush(WiredTigerSessionCache* sessionCache, long long flushNumber) {
+                const std::string uri =
+                    std::string("table:") + WiredTigerRecoveryUnit::kGroupCommitIdent;
+
+                WiredTigerSession* session = sessionCache->getSession();
+                WT_SESSION* s = session->getSession();
+
+                WT_CURSOR* c = NULL;
+                int ret = s->open_cursor(s, uri.c_str(), NULL, NULL, &c);
+                if (ret == ENOENT) {
+                    invariantWTOK(s->create(s, uri.c_str(), "key_format=S,value_format=q"));
+                    ret = s->open_cursor(s, uri.c_str(), NULL, NULL, &c);
+                }
+                invariantWTOK(ret);
+                invariantWTOK(s->begin_transaction(s, "sync=true"));
+                c->set_key(c, "lastFlush");
+                c->set_value(c, static_cast<int64_t>(flushNumber));
+                invariantWTOK(c->insert(c));
+                invariantWTOK(s->commit_transaction(s, NULL));
+                invariantWTOK(c->close(c));
+
+                sessionCache->releaseSession(session);
+                LOG(2) << "WT group commit flushed " << flushNumber << " requests";
             }
 
-            AtomicUInt32 numWaitingForSync;
-
-            boost::mutex mutex; // this just protects lastSyncTime
-            boost::condition condvar;
-            long long lastSyncTime;
-        } awaitCommitData;
+            boost::mutex _mutex; // guards everything below
+            boost::condition _flushed;
+            long long _numRequested;
+            long long _numFlushed;
+            bool _flushing;
+        } groupCommit;
     }
 
     WiredTigerRecoveryUnit::WiredTigerRecoveryUnit(WiredTigerSessionCache* sc) :
@@ -80,7 +141,9 @@ namespace mongo {
         _active( false ),
         _everStartedWrite( false ),
         _currentlySquirreled( false ),
-        _syncing( false ) {
+        _snapshotPinned( false ),
+        _pinnedSnapshotExpired( false ),
+        _pinMaxSeconds( 0 ) {
     }
 
     WiredTigerRecoveryUnit::~WiredTigerRecoveryUnit() {
@@ -98,6 +161,8 @@ namespace mongo {
         b->append( "wt_everStartedWrite", _everStartedWrite );
         if ( _active )
             b->append( "wt_millisSinceCommit", _timer.millis() );
+        if ( _snapshotPinned )
+            b->append( "wt_snapshotPinned", true );
     }
 
     void WiredTigerRecoveryUnit::_commit() {
@@ -127,6 +192,7 @@ namespace mongo {
         invariant( !_currentlySquirreled );
         _depth++;
         _everStartedWrite = true;
+        _snapshotPinned = false;
     }
 
     void WiredTigerRecoveryUnit::commitUnitOfWork() {
@@ -142,21 +208,8 @@ namespace mongo {
         }
     }
 
-    void WiredTigerRecoveryUnit::goingToAwaitCommit() {
-        if ( _active ) {
-            // too late, can't change config
-            return;
-        }
-        // yay, we've configured ourselves for sync
-        _syncing = true;
-    }
-
     bool WiredTigerRecoveryUnit::awaitCommit() {
-        if ( _syncing && _everStartedWrite ) {
-            // we did a sync, so we're good
-            return true;
-        }
-        awaitCommitData.awaitCommit();
+        groupCommit.waitUntilDurable( _sessionCache );
         return true;
     }
 
@@ -187,11 +240,33 @@ namespace mongo {
 
     void WiredTigerRecoveryUnit::commitAndRestart() {
         invariant( _depth == 0 );
-        if ( _active ) {
+        if ( _active && !_snapshotPinned ) {
             _txnClose( true );
         }
     }
 
+    bool WiredTigerRecoveryUnit::pinSnapshot( int maxSeconds ) {
+        if ( _depth > 0 )
+            return false;
+        // The transaction open now, if any, is the one kept; it has only read.
+        _snapshotPinned = true;
+        _pinnedSnapshotExpired = false;
+        _pinMaxSeconds = maxSeconds;
+        _pinTimer.reset();
+        return true;
+    }
+
+    bool WiredTigerRecoveryUnit::_keepPinnedSnapshot() {
+        if ( !_snapshotPinned )
+            return false;
+        if ( _pinTimer.seconds() < _pinMaxSeconds )
+            return true;
+        LOG(1) << "WT releasing a snapshot pinned for " << _pinTimer.seconds() << " seconds";
+        _snapshotPinned = false;
+        _pinnedSnapshotExpired = true;
+        return false;
+    }
+
     void WiredTigerRecoveryUnit::setOplogReadTill( const RecordId& loc ) {
         _oplogReadTill = loc;
     }
@@ -202,8 +277,6 @@ namespace mongo {
         if ( commit ) {
             invariantWTOK( s->commit_transaction(s, NULL) );
             LOG(2) << "WT commit_transaction";
-            if ( _syncing )
-                awaitCommitData.syncHappend();
         }
         else {
             invariantWTOK( s->rollback_transaction(s, NULL) );
@@ -215,8 +288,7 @@ namespace mongo {
     void WiredTigerRecoveryUnit::_txnOpen() {
         invariant( !_active );
         WT_SESSION *s = _session->getSession();
-        _syncing = _syncing || awaitCommitData.numWaitingForSync.load() > 0;
-        invariantWTOK( s->begin_transaction(s, _syncing ? "sync=true" : NULL) );
+        invariantWTOK( s->begin_transaction(s, NULL) );
         LOG(2) << "WT begin_transaction";
         _timer.reset();
         _active = true;
@@ -225,13 +297,16 @@ namespace mongo {
     void WiredTigerRecoveryUnit::beingReleasedFromOperationContext() {
         LOG(2) << "WiredTigerRecoveryUnit::beingReleased";
         _currentlySquirreled = true;
-        if ( !wt_keeptxnopen() ) {
+        if ( !wt_keeptxnopen() && !_keepPinnedSnapshot() ) {
             _commit();
         }
     }
     void WiredTigerRecoveryUnit::beingSetOnOperationContext() {
         LOG(2) << "WiredTigerRecoveryUnit::broughtBack";
         _currentlySquirreled = false;
+        if ( _snapshotPinned && !_keepPinnedSnapshot() ) {
+            _commit();
+        }
     }
 
 
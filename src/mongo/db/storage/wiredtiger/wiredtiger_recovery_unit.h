@@ -63,7 +63,6 @@ namespace mongo {
         virtual void endUnitOfWork();
 
         virtual bool awaitCommit();
-        virtual void goingToAwaitCommit();
 
         virtual void registerChange(Change *);
 
@@ -72,6 +71,9 @@ namespace mongo {
 
         virtual void commitAndRestart();
 
+        virtual bool pinSnapshot(int maxSeconds);
+        virtual bool pinnedSnapshotExpired() const { return _pinnedSnapshotExpired; }
+
         // un-used API
         virtual void* writingPtr(void* data, size_t len) { invariant(!"don't call writingPtr"); }
         virtual void syncDataAndTruncateJournal() {}
@@ -91,6 +93,9 @@ namespace mongo {
 
         static WiredTigerRecoveryUnit* get(OperationContext *txn);
 
+        // Ident of the table written by the flushes that make journaled commits durable
+        static const char kGroupCommitIdent[];
+
     private:
 
         void _abort();
@@ -99,6 +104,9 @@ namespace mongo {
         void _txnClose( bool commit );
         void _txnOpen();
 
+        // Whether the open transaction should outlive this release or reattachment of the unit
+        bool _keepPinnedSnapshot();
+
         WiredTigerSessionCache* _sessionCache; // not owned
         WiredTigerSession* _session; // owned, but from pool
         bool _defaultCommit;
@@ -107,9 +115,13 @@ namespace mongo {
         bool _everStartedWrite;
         Timer _timer;
         bool _currentlySquirreled;
-        bool _syncing;
         RecordId _oplogReadTill;
 
+        bool _snapshotPinned;
+        bool _pinnedSnapshotExpired;
+        int _pinMaxSeconds;
+        Timer _pinTimer;
+
         typedef OwnedPointerVector<Change> Changes;
         Changes _changes;
     };
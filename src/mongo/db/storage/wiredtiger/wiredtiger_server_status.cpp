@@ -77,6 +77,12 @@ namespace mongo {
             bob.append("reason", status.reason());
         }
 
+        {
+            BSONObjBuilder sessionCache(bob.subobjStart("sessionCache"));
+            _engine->getSessionCache()->appendStats(&sessionCache);
+            sessionCache.done();
+        }
+
         return bob.obj();
     }
 
@@ -33,9 +33,15 @@
 
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
 
+#include <algorithm>
+#include <boost/thread/thread.hpp>
+
+#include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_kv_engine.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
 #include "mongo/util/log.h"
+#include "mongo/util/numa.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
@@ -124,25 +130,33 @@ namespace mongo {
     }
 
     void WiredTigerSessionCache::shuttingDown() {
-        if (_shuttingDown.load()) return;
-        _shuttingDown.store(1);
-
-        {
-            // This ensures that any calls, which are currently inside of getSession/releaseSession
-            // will be able to complete before we start cleaning up the pool. Any others, which are
-            // about to enter will return immediately because of _shuttingDown == true.
-            boost::lock_guard<boost::shared_mutex> lk(_shutdownLock);
+        // swap() is a full barrier, pairing with the increment of Shard::active in
+        // getSession/releaseSession: either they see the flag or we see them as active.
+        if (_shuttingDown.swap(1)) return;
+
+        // This ensures that any calls, which are currently inside of getSession/releaseSession
+        // will be able to complete before we start cleaning up the pool. Any others, which are
+        // about to enter will return immediately because of _shuttingDown == true.
+        for (int i = 0; i < kNumShards; i++) {
+            while (_shards[i].active.load() != 0) {
+                sleepmillis(1);
+            }
         }
 
         closeAll();
-        invariant(_sessionPool.empty());
     }
 
     void WiredTigerSessionCache::closeAll() {
         SessionPool swapPool;
         {
-            boost::mutex::scoped_lock lk(_sessionLock);
-            _sessionPool.swap(swapPool);
+            boost::mutex::scoped_lock lk(_overflowLock);
+            _overflow.swap(swapPool);
+        }
+
+        for (int i = 0; i < kNumShards; i++) {
+            while (WiredTigerSession* session = _takeFrom(_shards[i])) {
+                swapPool.push_back(session);
+            }
         }
 
         // New sessions will be created if need be outside of the lock
@@ -153,37 +167,102 @@ namespace mongo {
         swapPool.clear();
     }
 
+    // static
+    size_t WiredTigerSessionCache::_myShardIndex() {
+        // Thread ids hash to (aligned) addresses, so mix the bits before picking a shard.
+        const uint64_t h = hash_value(boost::this_thread::get_id());
+        const size_t mixed = static_cast<size_t>((h * 0x9E3779B97F4A7C15ULL) >> 32);
+        if (!NumaPlacement::enabled()) {
+            return mixed % kNumShards;
+        }
+
+        // Each node has a run of shards of its own, so that sessions, and the memory WiredTiger
+        // keeps with them, are reused on the node they were created on.  Stealing looks at the
+        // neighbouring shards first, which are mostly the same node's.
+        const size_t nodes = std::min(static_cast<size_t>(NumaPlacement::nodeCount()),
+                                      static_cast<size_t>(kNumShards));
+        const size_t shardsPerNode = kNumShards / nodes;
+        const size_t node = NumaPlacement::currentNode() % nodes;
+        return node * shardsPerNode + mixed % shardsPerNode;
+    }
+
+    // static
+    WiredTigerSession* WiredTigerSessionCache::_takeFrom( Shard& shard ) {
+        for (int i = 0; i < kSlotsPerShard; i++) {
+            AtomicUInt64& slot = shard.slots[i];
+            if (slot.loadRelaxed() == 0)
+                continue;
+            uint64_t value = slot.swap(0);
+            if (value != 0)
+                return reinterpret_cast<WiredTigerSession*>(static_cast<uintptr_t>(value));
+        }
+        return NULL;
+    }
+
+    // static
+    bool WiredTigerSessionCache::_putInto( Shard& shard, WiredTigerSession* session ) {
+        const uint64_t value = reinterpret_cast<uintptr_t>(session);
+        for (int i = 0; i < kSlotsPerShard; i++) {
+            AtomicUInt64& slot = shard.slots[i];
+            if (slot.loadRelaxed() == 0 && slot.compareAndSwap(0, value) == 0)
+                return true;
+        }
+        return false;
+    }
+
     WiredTigerSession* WiredTigerSessionCache::getSession() {
-        boost::shared_lock<boost::shared_mutex> shutdownLock(_shutdownLock);
+        const size_t homeIndex = _myShardIndex();
+        Shard& home = _shards[homeIndex];
+        home.active.fetchAndAdd(1);
 
         // We should never be able to get here after _shuttingDown is set, because no new
         // operations should be allowed to start.
-        invariant(!_shuttingDown.loadRelaxed());
+        invariant(!_shuttingDown.load());
 
-        {
-            boost::mutex::scoped_lock lk( _sessionLock );
+        WiredTigerSession* session = _takeFrom(home);
+        if (session) {
+            home.hits.fetchAndAdd(1);
+            home.active.fetchAndSubtract(1);
+            return session;
+        }
 
-            if (!_sessionPool.empty()) {
-                WiredTigerSession* cachedSession = _sessionPool.back();
-                _sessionPool.pop_back();
+        for (size_t i = 1; i < kNumShards && !session; i++) {
+            session = _takeFrom(_shards[(homeIndex + i) % kNumShards]);
+        }
 
-                return cachedSession;
+        if (!session) {
+            boost::mutex::scoped_lock lk(_overflowLock);
+            if (!_overflow.empty()) {
+                session = _overflow.back();
+                _overflow.pop_back();
             }
         }
 
-        return new WiredTigerSession( _conn, _engine ? _engine->currentEpoch() : -1 );
+        if (session) {
+            home.steals.fetchAndAdd(1);
+        }
+        else {
+            home.misses.fetchAndAdd(1);
+            session = new WiredTigerSession( _conn, _engine ? _engine->currentEpoch() : -1 );
+        }
+
+        home.active.fetchAndSubtract(1);
+        return session;
     }
 
     void WiredTigerSessionCache::releaseSession( WiredTigerSession* session ) {
         invariant( session );
         invariant(session->cursorsOut() == 0);
 
-        boost::shared_lock<boost::shared_mutex> shutdownLock(_shutdownLock);
-        if (_shuttingDown.loadRelaxed()) {
+        Shard& home = _shards[_myShardIndex()];
+        home.active.fetchAndAdd(1);
+
+        if (_shuttingDown.load()) {
             // Leak the session in order to avoid race condition with clean shutdown, where the
             // storage engine is ripped from underneath transactions, which are not "active"
             // (i.e., do not have any locks), but are just about to delete the recovery unit.
             // See SERVER-16031 for more information.
+            home.active.fetchAndSubtract(1);
             return;
         }
 
@@ -199,11 +278,42 @@ namespace mongo {
         if (_engine && _engine->haveDropsQueued() && session->epoch() < _engine->currentEpoch()) {
             delete session;
             _engine->dropAllQueued();
+            home.active.fetchAndSubtract(1);
             return;
         }
 
-        boost::mutex::scoped_lock lk(_sessionLock);
-        _sessionPool.push_back( session );
+        if (!_putInto(home, session)) {
+            boost::mutex::scoped_lock lk(_overflowLock);
+            _overflow.push_back( session );
+        }
+
+        home.active.fetchAndSubtract(1);
+    }
+
+    void WiredTigerSessionCache::appendStats( BSONObjBuilder* builder ) const {
+        long long hits = 0;
+        long long steals = 0;
+        long long misses = 0;
+        long long cached = 0;
+        for (int i = 0; i < kNumShards; i++) {
+            const Shard& shard = _shards[i];
+            hits += shard.hits.loadRelaxed();
+            steals += shard.steals.loadRelaxed();
+            misses += shard.misses.loadRelaxed();
+            for (int j = 0; j < kSlotsPerShard; j++) {
+                if (shard.slots[j].loadRelaxed() != 0)
+                    cached++;
+            }
+        }
+        {
+            boost::mutex::scoped_lock lk(_overflowLock);
+            cached += _overflow.size();
+        }
+
+        builder->appendNumber("hits", hits);
+        builder->appendNumber("steals", steals);
+        builder->appendNumber("misses", misses);
+        builder->appendNumber("cached", cached);
     }
 
     bool WiredTigerSessionCache::_shouldBeClosed( WiredTigerSession* session ) const {
@@ -36,7 +36,6 @@
 #include <vector>
 
 #include <boost/thread/mutex.hpp>
-#include <boost/thread/shared_mutex.hpp>
 
 #include <wiredtiger.h>
 
@@ -44,6 +43,7 @@
 
 namespace mongo {
 
+    class BSONObjBuilder;
     class WiredTigerKVEngine;
 
     /**
@@ -83,6 +83,15 @@ namespace mongo {
         int _cursorsOut;
     };
 
+    /**
+     * A pool of idle WiredTigerSessions.
+     *
+     * Idle sessions are kept in a fixed number of shards, each an array of slots that are
+     * claimed and filled with atomic exchanges, so the common get/release path takes no locks.
+     * A thread prefers the shard picked by hashing its id, among those of its NUMA node when
+     * NUMA placement is enabled, and steals from the other shards before opening a new session.
+     * Sessions released while every slot is full go to a mutex protected overflow list.
+     */
     class WiredTigerSessionCache {
     public:
 
@@ -97,9 +106,37 @@ namespace mongo {
 
         void shuttingDown();
 
+        /**
+         * Reports how getSession() requests were satisfied: "hits" from the calling thread's
+         * shard, "steals" from another shard or the overflow list, and "misses" which opened a
+         * new session.
+         */
+        void appendStats( BSONObjBuilder* builder ) const;
+
     private:
         typedef std::vector<WiredTigerSession*> SessionPool;
 
+        enum { kNumShards = 16 };
+        enum { kSlotsPerShard = 16 };
+
+        struct Shard {
+            // Each slot holds a WiredTigerSession* (0 when empty).
+            AtomicUInt64 slots[kSlotsPerShard];
+
+            // Number of calls currently inside getSession/releaseSession using this shard.
+            AtomicUInt32 active;
+
+            AtomicUInt64 hits;
+            AtomicUInt64 steals;
+            AtomicUInt64 misses;
+
+            char pad[64]; // keep neighbouring shards off this shard's cache lines
+        };
+
+        static size_t _myShardIndex();
+
+        static WiredTigerSession* _takeFrom( Shard& shard );
+        static bool _putInto( Shard& shard, WiredTigerSession* session );
 
         bool _shouldBeClosed( WiredTigerSession* session ) const;
 
@@ -107,14 +144,15 @@ namespace mongo {
         WiredTigerKVEngine* _engine; // not owned, might be NULL
         WT_CONNECTION* _conn; // not owned
 
-        // Session pool and protection around the get/return/cleanup methods
-        mutable boost::mutex _sessionLock;
-        SessionPool _sessionPool;
+        Shard _shards[kNumShards];
+
+        // Sessions which did not fit in any shard, and protection around them
+        mutable boost::mutex _overflowLock;
+        SessionPool _overflow;
 
-        // Regular operations take it in shared mode. Shutdown sets the _shuttingDown flag and
-        // then takes it in exclusive mode. This ensures that all threads, which would return
-        // sessions to the cache would leak them.
-        boost::shared_mutex _shutdownLock;
+        // Set once on shutdown, after which sessions are no longer cached. Shutdown waits for
+        // every shard's active count to drain before cleaning up, so that no thread is left
+        // returning a session into a pool which is being destroyed.
         AtomicUInt32 _shuttingDown; // Used as boolean - 0 = false, 1 = true
     };
 
@@ -70,7 +70,7 @@ namespace mongo {
         entry.rs = rs;
         entry.numRecords = numRecords;
         entry.dataSize = dataSize;
-        entry.dirty = true;
+        _dirty.insert( rs->GetURI() );
     }
 
     void WiredTigerSizeStorer::onDestroy( WiredTigerRecordStore* rs ) {
@@ -79,8 +79,14 @@ namespace mongo {
         Entry& entry = _entries[rs->GetURI()];
         entry.numRecords = rs->numRecords( NULL );
         entry.dataSize = rs->dataSize( NULL );
-        entry.dirty = true;
         entry.rs = NULL;
+        _dirty.insert( rs->GetURI() );
+    }
+
+    void WiredTigerSizeStorer::onSizeChange( WiredTigerRecordStore* rs ) {
+        _checkMagic();
+        boost::mutex::scoped_lock lk( _entriesMutex );
+        _dirty.insert( rs->GetURI() );
     }
 
 
@@ -91,7 +97,7 @@ namespace mongo {
         Entry& entry = _entries[uri.toString()];
         entry.numRecords = numRecords;
         entry.dataSize = dataSize;
-        entry.dirty = true;
+        _dirty.insert( uri.toString() );
     }
 
     void WiredTigerSizeStorer::load( const StringData& uri,
@@ -136,7 +142,6 @@ namespace mongo {
                 Entry& e = m[uriKey];
                 e.numRecords = data["numRecords"].safeNumberLong();
                 e.dataSize = data["dataSize"].safeNumberLong();
-                e.dirty = false;
                 e.rs = NULL;
             }
             invariantWTOK( c->close(c) );
@@ -144,67 +149,76 @@ namespace mongo {
 
         boost::mutex::scoped_lock lk( _entriesMutex );
         _entries = m;
+        _dirty.clear();
     }
 
     void WiredTigerSizeStorer::storeInto( WiredTigerSession* session,
                                           const std::string& uri ) {
         Map myMap;
         {
+            std::set<std::string> dirty;
             boost::mutex::scoped_lock lk( _entriesMutex );
-            for ( Map::iterator it = _entries.begin(); it != _entries.end(); ++it ) {
-                std::string uriKey = it->first;
-                Entry& entry = it->second;
+            dirty.swap( _dirty );
+            for ( std::set<std::string>::const_iterator it = dirty.begin();
+                  it != dirty.end(); ++it ) {
+                Map::iterator entryIt = _entries.find( *it );
+                if ( entryIt == _entries.end() )
+                    continue;
+
+                Entry& entry = entryIt->second;
                 if ( entry.rs ) {
-                    if ( entry.dataSize != entry.rs->dataSize( NULL ) ) {
-                        entry.dataSize = entry.rs->dataSize( NULL );
-                        entry.dirty = true;
-                    }
-                    if ( entry.numRecords != entry.rs->numRecords( NULL ) ) {
-                        entry.numRecords = entry.rs->numRecords( NULL );
-                        entry.dirty = true;
-                    }
+                    // Clear first, so that any change from here on marks the entry dirty again.
+                    entry.rs->clearSizeChanged();
+                    entry.dataSize = entry.rs->dataSize( NULL );
+                    entry.numRecords = entry.rs->numRecords( NULL );
                 }
-
-                if ( !entry.dirty )
-                    continue;
-                myMap[uriKey] = entry;
+                myMap[*it] = entry;
             }
         }
 
-        WT_SESSION* s = session->getSession();
-        WT_CURSOR* c = NULL;
-        int ret = s->open_cursor( s, uri.c_str(), NULL, NULL, &c );
-        if ( ret == ENOENT ) {
-            invariantWTOK( s->create( s, uri.c_str(), "" ) );
-            ret = s->open_cursor( s, uri.c_str(), NULL, NULL, &c );
-        }
-        invariantWTOK( ret );
-
-        for ( Map::iterator it = myMap.begin(); it != myMap.end(); ++it ) {
-            string uriKey = it->first;
-            Entry& entry = it->second;
-
-            BSONObj data;
-            {
-                BSONObjBuilder b;
-                b.append( "numRecords", entry.numRecords );
-                b.append( "dataSize", entry.dataSize );
-                data = b.obj();
+        try {
+            WT_SESSION* s = session->getSession();
+            WT_CURSOR* c = NULL;
+            int ret = s->open_cursor( s, uri.c_str(), NULL, NULL, &c );
+            if ( ret == ENOENT ) {
+                invariantWTOK( s->create( s, uri.c_str(), "" ) );
+                ret = s->open_cursor( s, uri.c_str(), NULL, NULL, &c );
             }
+            invariantWTOK( ret );
 
-            LOG(2) << "WiredTigerSizeStorer::storeInto " << uriKey << " -> " << data;
+            for ( Map::iterator it = myMap.begin(); it != myMap.end(); ++it ) {
+                string uriKey = it->first;
+                Entry& entry = it->second;
 
-            WiredTigerItem key( uriKey.c_str(), uriKey.size() );
-            WiredTigerItem value( data.objdata(), data.objsize() );
-            c->set_key( c, key.Get() );
-            c->set_value( c, value.Get() );
-            invariantWTOK( c->insert(c) );
-            entry.dirty = false;
+                BSONObj data;
+                {
+                    BSONObjBuilder b;
+                    b.append( "numRecords", entry.numRecords );
+                    b.append( "dataSize", entry.dataSize );
+                    data = b.obj();
+                }
 
-            c->reset(c);
-        }
+                LOG(2) << "WiredTigerSizeStorer::storeInto " << uriKey << " -> " << data;
+
+                WiredTigerItem key( uriKey.c_str(), uriKey.size() );
+                WiredTigerItem value( data.objdata(), data.objsize() );
+                c->set_key( c, key.Get() );
+                c->set_value( c, value.Get() );
+                invariantWTOK( c->insert(c) );
 
-        invariantWTOK( c->close(c) );
+                c->reset(c);
+            }
+
+            invariantWTOK( c->close(c) );
+        }
+        catch ( ... ) {
+            // Nothing was stored, so these need to go out with the next attempt.
+            boost::mutex::scoped_lock lk( _entriesMutex );
+            for ( Map::const_iterator it = myMap.begin(); it != myMap.end(); ++it ) {
+                _dirty.insert( it->first );
+            }
+            throw;
+        }
 
     }
 
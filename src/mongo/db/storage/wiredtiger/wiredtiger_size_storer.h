@@ -32,6 +32,7 @@
 #pragma once
 
 #include <map>
+#include <set>
 #include <string>
 
 #include <boost/thread/mutex.hpp>
@@ -43,6 +44,11 @@ namespace mongo {
     class WiredTigerRecordStore;
     class WiredTigerSession;
 
+    /**
+     * Keeps numRecords and dataSize for every record store, and periodically persists the ones
+     * which changed.  A record store calls onSizeChange() for the first change after each
+     * storeInto(), so neither its inserts nor storeInto() have to visit unchanged collections.
+     */
     class WiredTigerSizeStorer {
     public:
         WiredTigerSizeStorer();
@@ -50,6 +56,7 @@ namespace mongo {
 
         void onCreate( WiredTigerRecordStore* rs, long long nr, long long ds );
         void onDestroy( WiredTigerRecordStore* rs );
+        void onSizeChange( WiredTigerRecordStore* rs );
 
         void store( const StringData& uri,
                     long long numRecords, long long dataSize );
@@ -64,10 +71,9 @@ namespace mongo {
         void _checkMagic() const;
 
         struct Entry {
-            Entry() : numRecords(0), dataSize(0), dirty(false), rs(NULL){}
+            Entry() : numRecords(0), dataSize(0), rs(NULL){}
             long long numRecords;
             long long dataSize;
-            bool dirty;
             WiredTigerRecordStore* rs; // not owned
         };
 
@@ -75,6 +81,7 @@ namespace mongo {
 
         typedef std::map<std::string,Entry> Map;
         Map _entries;
+        std::set<std::string> _dirty; // uris whose entries changed since the last storeInto()
         mutable boost::mutex _entriesMutex;
     };
 
@@ -35,6 +35,7 @@
 
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
 
+#include <algorithm>
 #include <limits>
 
 #include "mongo/bson/bsonobjbuilder.h"
@@ -108,6 +109,86 @@ namespace mongo {
         return StatusWith<uint64_t>(value);
     }
 
+    namespace {
+        struct CacheStat {
+            const char* name;
+            int key;
+            bool isBytes;
+        };
+
+        const CacheStat cacheStats[] = {
+            { "bytesReadIntoCache", WT_STAT_DSRC_CACHE_BYTES_READ, true },
+            { "bytesWrittenFromCache", WT_STAT_DSRC_CACHE_BYTES_WRITE, true },
+            { "pagesReadIntoCache", WT_STAT_DSRC_CACHE_READ, false },
+            { "pagesWrittenFromCache", WT_STAT_DSRC_CACHE_WRITE, false },
+            { "unmodifiedPagesEvicted", WT_STAT_DSRC_CACHE_EVICTION_CLEAN, false },
+            { "modifiedPagesEvicted", WT_STAT_DSRC_CACHE_EVICTION_DIRTY, false },
+        };
+
+        const CacheStat cursorStats[] = {
+            { "inserts", WT_STAT_DSRC_CURSOR_INSERT, false },
+            { "removes", WT_STAT_DSRC_CURSOR_REMOVE, false },
+            { "searches", WT_STAT_DSRC_CURSOR_SEARCH, false },
+            { "searchNears", WT_STAT_DSRC_CURSOR_SEARCH_NEAR, false },
+            { "nexts", WT_STAT_DSRC_CURSOR_NEXT, false },
+            { "prevs", WT_STAT_DSRC_CURSOR_PREV, false },
+        };
+
+        Status appendStats(WT_CURSOR* cursor,
+                           const CacheStat* stats,
+                           size_t numStats,
+                           double scale,
+                           BSONObjBuilder* bob) {
+            for (size_t i = 0; i < numStats; i++) {
+                cursor->set_key(cursor, stats[i].key);
+                int ret = cursor->search(cursor);
+                uint64_t value;
+                if (ret == 0) {
+                    ret = cursor->get_value(cursor, NULL, NULL, &value);
+                }
+                if (ret != 0) {
+                    return Status(ErrorCodes::NoSuchKey, str::stream()
+                        << "unable to read statistic " << stats[i].key
+                        << ". reason: " << wiredtiger_strerror(ret));
+                }
+
+                const long long capped = static_cast<long long>(
+                    std::min(value, static_cast<uint64_t>(std::numeric_limits<long long>::max())));
+                bob->appendNumber(stats[i].name,
+                                  stats[i].isBytes ? static_cast<long long>(capped / scale)
+                                                   : capped);
+            }
+            return Status::OK();
+        }
+    }  // namespace
+
+    Status WiredTigerUtil::appendCacheStats(WT_SESSION* s,
+                                            const std::string& uri,
+                                            BSONObjBuilder* bob,
+                                            double scale) {
+        invariant(s);
+        const std::string statsUri = "statistics:" + uri;
+        WT_CURSOR* cursor = NULL;
+        int ret = s->open_cursor(s, statsUri.c_str(), NULL, "statistics=(fast)", &cursor);
+        if (ret != 0) {
+            return Status(ErrorCodes::CursorNotFound, str::stream()
+                << "unable to open cursor at URI " << statsUri
+                << ". reason: " << wiredtiger_strerror(ret));
+        }
+        invariant(cursor);
+        ON_BLOCK_EXIT(cursor->close, cursor);
+
+        Status status = appendStats(cursor, cacheStats,
+                                    sizeof(cacheStats) / sizeof(cacheStats[0]), scale, bob);
+        if (!status.isOK()) {
+            return status;
+        }
+
+        BSONObjBuilder cursorBob(bob->subobjStart("cursor"));
+        return appendStats(cursor, cursorStats,
+                           sizeof(cursorStats) / sizeof(cursorStats[0]), scale, &cursorBob);
+    }
+
     int64_t WiredTigerUtil::getIdentSize(WT_SESSION* s,
                                          const std::string& uri ) {
         StatusWith<int64_t> result = WiredTigerUtil::getStatisticsValueAs<int64_t>(
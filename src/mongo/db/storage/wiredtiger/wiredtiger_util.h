@@ -129,6 +129,16 @@ namespace mongo {
         static int64_t getIdentSize(WT_SESSION* s,
                                     const std::string& uri );
 
+        /**
+         * Appends the cache and cursor statistics of the table at 'uri' to 'bob' in the form
+         * RecordStore::appendCacheStats describes. WiredTiger does not count the bytes of each
+         * table resident in its cache, only what moved in and out of it.
+         */
+        static Status appendCacheStats(WT_SESSION* s,
+                                       const std::string& uri,
+                                       BSONObjBuilder* bob,
+                                       double scale);
+
     private:
         /**
          * Casts unsigned 64-bit statistics value to T.
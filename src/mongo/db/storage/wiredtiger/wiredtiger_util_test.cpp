@@ -34,6 +34,7 @@
 #include <string>
 
 #include "mongo/base/string_data.h"
+#include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
@@ -164,4 +165,41 @@ namespace mongo {
         ASSERT_EQUALS(static_cast<uint8_t>(100), resultInt16.getValue());
     }
 
+    TEST(WiredTigerUtilTest, AppendCacheStatsMissingTable) {
+        WiredTigerUtilHarnessHelper harnessHelper("statistics=(all)");
+        WiredTigerRecoveryUnit recoveryUnit(harnessHelper.getSessionCache());
+        WiredTigerSession* session = recoveryUnit.getSession();
+        BSONObjBuilder bob;
+        Status status = WiredTigerUtil::appendCacheStats(session->getSession(),
+                                                         "table:no_such_table", &bob, 1);
+        ASSERT_EQUALS(ErrorCodes::CursorNotFound, status.code());
+    }
+
+    TEST(WiredTigerUtilTest, AppendCacheStats) {
+        WiredTigerUtilHarnessHelper harnessHelper("statistics=(all)");
+        WiredTigerRecoveryUnit recoveryUnit(harnessHelper.getSessionCache());
+        WiredTigerSession* session = recoveryUnit.getSession();
+        WT_SESSION* wtSession = session->getSession();
+        ASSERT_OK(wtRCToStatus(wtSession->create(wtSession, "table:mytable",
+                                                 "key_format=S,value_format=S")));
+
+        WT_CURSOR* cursor;
+        ASSERT_OK(wtRCToStatus(wtSession->open_cursor(wtSession, "table:mytable", NULL, NULL,
+                                                      &cursor)));
+        cursor->set_key(cursor, "a");
+        cursor->set_value(cursor, "b");
+        ASSERT_OK(wtRCToStatus(cursor->insert(cursor)));
+        cursor->set_key(cursor, "a");
+        ASSERT_OK(wtRCToStatus(cursor->search(cursor)));
+        ASSERT_OK(wtRCToStatus(cursor->close(cursor)));
+
+        BSONObjBuilder bob;
+        ASSERT_OK(WiredTigerUtil::appendCacheStats(wtSession, "table:mytable", &bob, 1));
+        BSONObj stats = bob.obj();
+        ASSERT(stats.hasField("bytesReadIntoCache"));
+        ASSERT(stats.hasField("modifiedPagesEvicted"));
+        ASSERT_EQUALS(1, stats["cursor"]["inserts"].numberLong());
+        ASSERT_EQUALS(1, stats["cursor"]["searches"].numberLong());
+    }
+
 }  // namespace mongo
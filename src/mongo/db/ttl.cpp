@@ -34,23 +34,31 @@
 
 #include "mongo/db/ttl.h"
 
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
 #include "mongo/base/counter.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/auth/user_name.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/client.h"
 #include "mongo/db/commands/fsync.h"
+#include "mongo/db/commands/server_status.h"
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/catalog/collection_catalog_entry.h"
 #include "mongo/db/catalog/database_catalog_entry.h"
 #include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/dbdirectclient.h"
 #include "mongo/db/operation_context_impl.h"
-#include "mongo/db/ops/delete.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/query/internal_plans.h"
+#include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/repl_coordinator_global.h"
 #include "mongo/db/server_parameters.h"
+#include "mongo/stdx/functional.h"
 #include "mongo/util/background.h"
 #include "mongo/util/log.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -62,6 +70,169 @@ namespace mongo {
 
     MONGO_EXPORT_SERVER_PARAMETER( ttlMonitorEnabled, bool, true );
 
+    // Seconds the TTLMonitor sleeps between passes over the TTL indexes.
+    MONGO_EXPORT_SERVER_PARAMETER( ttlMonitorSleepSecs, int, 60 );
+
+    // Number of collections whose expired documents a pass removes at once.
+    MONGO_EXPORT_SERVER_PARAMETER( ttlMonitorWorkerThreads, int, 1 );
+
+    // Expired documents removed per acquisition of the collection lock.
+    MONGO_EXPORT_SERVER_PARAMETER( ttlMonitorBatchSize, int, 128 );
+
+    // Upper bound on the expired documents removed per second, over all collections.  0 means
+    // no limit.
+    MONGO_EXPORT_SERVER_PARAMETER( ttlMonitorMaxDocsPerSec, int, 0 );
+
+    namespace {
+
+        /**
+         * What the last pass over one TTL index did, for serverStatus.
+         */
+        struct TTLIndexStats {
+            TTLIndexStats() : deletedDocuments(0),
+                              lastPassDeleted(0),
+                              lastPassMillis(0),
+                              lagSecs(0) { }
+
+            long long deletedDocuments;
+            long long lastPassDeleted;
+            long long lastPassMillis;
+
+            // How long past its expiry the oldest document the last pass found was.
+            long long lagSecs;
+            Date_t lastPassEnd;
+        };
+
+        /**
+         * Per TTL index statistics, keyed by "<ns>.$<index name>".
+         */
+        class TTLStats {
+        public:
+            void record(const string& indexNs, long long deleted, long long millis,
+                        long long lagSecs) {
+                boost::lock_guard<boost::mutex> lk(_mutex);
+                TTLIndexStats& stats = _stats[indexNs];
+                stats.deletedDocuments += deleted;
+                stats.lastPassDeleted = deleted;
+                stats.lastPassMillis = millis;
+                stats.lagSecs = lagSecs;
+                stats.lastPassEnd = jsTime();
+            }
+
+            /** Forgets the indexes not in 'indexNss', which have been dropped. */
+            void retain(const set<string>& indexNss) {
+                boost::lock_guard<boost::mutex> lk(_mutex);
+                map<string, TTLIndexStats>::iterator it = _stats.begin();
+                while (it != _stats.end()) {
+                    if (indexNss.count(it->first))
+                        ++it;
+                    else
+                        _stats.erase(it++);
+                }
+            }
+
+            void append(BSONObjBuilder* b) const {
+                boost::lock_guard<boost::mutex> lk(_mutex);
+                for (map<string, TTLIndexStats>::const_iterator it = _stats.begin();
+                     it != _stats.end(); ++it) {
+                    const TTLIndexStats& stats = it->second;
+                    BSONObjBuilder indexBuilder(b->subobjStart(it->first));
+                    indexBuilder.appendNumber("deletedDocuments", stats.deletedDocuments);
+                    indexBuilder.appendNumber("lastPassDeleted", stats.lastPassDeleted);
+                    indexBuilder.appendNumber("lastPassMillis", stats.lastPassMillis);
+                    indexBuilder.appendNumber("lastPassDeletesPerSec",
+                                              stats.lastPassMillis > 0
+                                                  ? stats.lastPassDeleted * 1000
+                                                        / stats.lastPassMillis
+                                                  : stats.lastPassDeleted);
+                    indexBuilder.appendNumber("lagSecs", stats.lagSecs);
+                    indexBuilder.appendDate("lastPassEnd", stats.lastPassEnd);
+                    indexBuilder.done();
+                }
+            }
+
+        private:
+            mutable boost::mutex _mutex;
+            map<string, TTLIndexStats> _stats;
+        } ttlStats;
+
+        /**
+         * Server status section for the TTL indexes.
+         *
+         * Sample format:
+         *
+         * ttl: {
+         *   "test.sessions.$lastUse_1": {
+         *     deletedDocuments: 1200,
+         *     lastPassDeleted: 100,
+         *     lastPassMillis: 20,
+         *     lastPassDeletesPerSec: 5000,
+         *     lagSecs: 61,
+         *     lastPassEnd: ISODate("2015-03-11T22:45:30.221Z")
+         *   }
+         * }
+         */
+        class TTLServerStatusSection : public ServerStatusSection {
+        public:
+            TTLServerStatusSection() : ServerStatusSection("ttl") { }
+            bool includeByDefault() const { return false; }
+
+            BSONObj generateSection(OperationContext* txn,
+                                    const BSONElement& configElement) const {
+                BSONObjBuilder result;
+                ttlStats.append(&result);
+                return result.obj();
+            }
+        } ttlServerStatusSection;
+
+        /**
+         * Paces the deletes of all the TTL workers to ttlMonitorMaxDocsPerSec.
+         */
+        class TTLRateLimiter {
+        public:
+            TTLRateLimiter() : _nextMillis(0) { }
+
+            /** Sleeps as long as deleting 'n' more documents needs to stay within the rate. */
+            void deleted(long long n) {
+                const long long maxDocsPerSec = ttlMonitorMaxDocsPerSec;
+                if (maxDocsPerSec <= 0 || n <= 0)
+                    return;
+
+                long long sleepMillis;
+                {
+                    boost::lock_guard<boost::mutex> lk(_mutex);
+                    const long long now = curTimeMillis64();
+                    _nextMillis = std::max(_nextMillis, now) + n * 1000 / maxDocsPerSec;
+                    sleepMillis = _nextMillis - now;
+                }
+                if (sleepMillis > 0)
+                    sleepmillis(sleepMillis);
+            }
+
+        private:
+            boost::mutex _mutex;
+            long long _nextMillis;
+        } ttlRateLimiter;
+
+        /**
+         * Returns true if any value of 'field' in 'doc' is a date before 'cutoff', the same
+         * documents the query { field: { $lt: cutoff } } matches.
+         */
+        bool isExpired(const BSONObj& doc, const StringData& field, Date_t cutoff) {
+            BSONElementSet values;
+            doc.getFieldsDotted(field, values);
+            for (BSONElementSet::const_iterator it = values.begin(); it != values.end(); ++it) {
+                // dates compare signed, as in queries
+                if (it->type() == mongo::Date &&
+                        static_cast<long long>(it->date().millis)
+                            < static_cast<long long>(cutoff.millis))
+                    return true;
+            }
+            return false;
+        }
+
+    }  // namespace
+
     class TTLMonitor : public BackgroundJob {
     public:
         TTLMonitor(){}
@@ -76,7 +247,7 @@ namespace mongo {
             cc().getAuthorizationSession()->grantInternalAuthorization();
 
             while ( ! inShutdown() ) {
-                sleepsecs( 60 );
+                sleepsecs( std::max( 1, static_cast<int>( ttlMonitorSleepSecs ) ) );
 
                 LOG(3) << "TTLMonitor thread awake" << endl;
 
@@ -103,6 +274,9 @@ namespace mongo {
 
                 ttlPasses.increment();
 
+                // The TTL indexes of each collection, in the order the databases were listed.
+                TTLPass pass;
+                set<string> indexNss;
                 for ( set<string>::const_iterator i=dbs.begin(); i!=dbs.end(); ++i ) {
                     string db = *i;
 
@@ -114,17 +288,107 @@ namespace mongo {
 
                     for ( vector<BSONObj>::const_iterator it = indexes.begin();
                           it != indexes.end(); ++it ) {
+                        const string ns = (*it)["ns"].String();
+                        if ( pass.collections.empty() ||
+                             pass.collections.back().back()["ns"].String() != ns ) {
+                            pass.collections.push_back( vector<BSONObj>() );
+                        }
+                        pass.collections.back().push_back( *it );
+                        indexNss.insert( indexStatsNs( *it ) );
+                    }
+                }
+                ttlStats.retain( indexNss );
+
+                const int maxWorkers = std::max( 1, static_cast<int>( ttlMonitorWorkerThreads ) );
+                const size_t numWorkers = std::min( pass.collections.size(),
+                                                    static_cast<size_t>( maxWorkers ) );
+                if ( numWorkers <= 1 ) {
+                    doTTLPass( &pass );
+                }
+                else {
+                    boost::thread_group workers;
+                    for ( size_t i = 0; i < numWorkers; i++ ) {
+                        workers.create_thread( stdx::bind( &TTLMonitor::workerThread, &pass, i ) );
+                    }
+                    workers.join_all();
+                }
 
+                for ( set<string>::const_iterator i=dbs.begin(); i!=dbs.end(); ++i ) {
+                    try {
+                        doPartitionsForDB( *i );
+                    }
+                    catch ( const DBException& e ) {
+                        error() << "Error maintaining partitions of " << *i << " -- "
+                                << e.toString();
+                    }
+                }
+            }
+        }
+
+    private:
+        /**
+         * The work of one pass, shared by its worker threads.
+         */
+        struct TTLPass {
+            TTLPass() : next(0) { }
+
+            // The TTL index specs of one collection per entry.
+            vector<vector<BSONObj> > collections;
+
+            // Guards 'next'.
+            boost::mutex mutex;
+
+            // The first entry of 'collections' no worker has taken yet.
+            size_t next;
+        };
+
+        static string indexStatsNs( const BSONObj& idx ) {
+            return idx["ns"].String() + ".$" + idx["name"].String();
+        }
+
+        static void workerThread( TTLPass* pass, size_t workerId ) {
+            const string threadName = str::stream() << "TTLMonitorWorker" << workerId;
+            Client::initThread( threadName.c_str() );
+            cc().getAuthorizationSession()->grantInternalAuthorization();
+
+            doTTLPass( pass );
+
+            cc().shutdown();
+        }
+
+        /**
+         * Takes collections off 'pass' one at a time, removing the expired documents of each of
+         * their TTL indexes in turn, until 'pass' has none left.
+         */
+        static void doTTLPass( TTLPass* pass ) {
+            while ( !inShutdown() ) {
+                const vector<BSONObj>* indexes;
+                {
+                    boost::lock_guard<boost::mutex> lk( pass->mutex );
+                    if ( pass->next == pass->collections.size() )
+                        return;
+                    indexes = &pass->collections[pass->next++];
+                }
+
+                for ( vector<BSONObj>::const_iterator it = indexes->begin();
+                      it != indexes->end(); ++it ) {
+                    const string dbName = nsToDatabase( (*it)["ns"].String() );
+
+                    try {
                         OperationContextImpl txn;
-                        if ( !doTTLForIndex( &txn, db, *it ) ) {
-                            break;  // stop processing TTL indexes on this database
+                        if ( !doTTLForIndex( &txn, dbName, *it ) ) {
+                            break;  // stop processing TTL indexes on this collection
                         }
                     }
+                    catch ( const DBException& e ) {
+                        error() << "Error processing ttl index: " << *it << " -- "
+                                << e.toString();
+                        break;
+                    }
                 }
             }
         }
 
-    private:
         /**
          * Acquire an IS-mode lock on the specified database and for each
          * collection in the database, append the specification of all
@@ -133,8 +397,8 @@ namespace mongo {
          * The index specifications are grouped by the collection to which
          * they belong.
          */
-        void getTTLIndexesForDB( OperationContext* txn, const string& dbName,
-                                 vector<BSONObj>* indexes ) {
+        static void getTTLIndexesForDB( OperationContext* txn, const string& dbName,
+                                        vector<BSONObj>* indexes ) {
 
             invariant( indexes && indexes->empty() );
             ScopedTransaction transaction( txn, MODE_IS );
@@ -174,15 +438,98 @@ namespace mongo {
             }
         }
 
+        /**
+         * On a primary, adds the partitions of the current and of the next range to each
+         * partitioned collection of "dbName", and drops those past partitionExpireAfterSecs.
+         * This goes through collMod so that secondaries partition the same way. Done once per
+         * range.
+         */
+        static void doPartitionsForDB( const string& dbName ) {
+            vector<pair<string, CollectionOptions> > partitioned;
+            {
+                OperationContextImpl txn;
+                ScopedTransaction transaction( &txn, MODE_IS );
+                Lock::DBLock dbLock( txn.lockState(), dbName, MODE_IS );
+
+                Database* db = dbHolder().get( &txn, dbName );
+                if ( !db ) {
+                    return;  // skip since database no longer exists
+                }
+
+                const DatabaseCatalogEntry* dbEntry = db->getDatabaseCatalogEntry();
+                list<string> namespaces;
+                dbEntry->getCollectionNamespaces( &namespaces );
+                for ( list<string>::const_iterator it = namespaces.begin();
+                      it != namespaces.end(); ++it ) {
+                    Lock::CollectionLock collLock( txn.lockState(), *it, MODE_IS );
+                    CollectionCatalogEntry* coll = dbEntry->getCollectionCatalogEntry( &txn, *it );
+                    if ( !coll ) {
+                        continue;  // skip since collection not found in catalog
+                    }
+                    CollectionOptions options = coll->getCollectionOptions( &txn );
+                    if ( options.isPartitioned() ) {
+                        partitioned.push_back( make_pair( *it, options ) );
+                    }
+                }
+            }
+
+            for ( size_t i = 0; i < partitioned.size(); i++ ) {
+                if ( !repl::getGlobalReplicationCoordinator()->canAcceptWritesForDatabase(
+                         dbName ) ) {
+                    return;  // only the primary adds and drops partitions
+                }
+
+                const string& ns = partitioned[i].first;
+                const CollectionOptions& options = partitioned[i].second;
+                const long long spanMs = 1000 * options.partitionSpanSecs;
+                const long long now = curTimeMillis64();
+                const long long rangeStart = now - now % spanMs;
+
+                // Only touched by the TTLMonitor thread.
+                static std::map<string, long long> lastRangeStart;
+                if ( lastRangeStart[ns] == rangeStart ) {
+                    continue;
+                }
+
+                BSONObjBuilder cmd;
+                cmd.append( "collMod", nsToCollectionSubstring( ns ) );
+                cmd.appendDate( "addPartition", Date_t( now + spanMs ) );
+                if ( options.partitionExpireAfterSecs ) {
+                    cmd.appendDate( "dropPartitionsBefore",
+                                    Date_t( now - 1000 * options.partitionExpireAfterSecs ) );
+                }
+
+                OperationContextImpl txn;
+                DBDirectClient client( &txn );
+                BSONObj info;
+                if ( !client.runCommand( dbName,
+                                         BSON( "collMod" << nsToCollectionSubstring( ns )
+                                               << "addPartition" << Date_t( now ) ),
+                                         info ) ||
+                     !client.runCommand( dbName, cmd.obj(), info ) ) {
+                    error() << "failed to maintain the partitions of " << ns << ": " << info;
+                    continue;
+                }
+
+                LOG( info["partitionsDropped"].numberInt() ? 0 : 1 )
+                    << "maintained the partitions of " << ns << ": " << info;
+                lastRangeStart[ns] = rangeStart;
+            }
+        }
+
         /**
          * Remove documents from the collection using the specified TTL index
          * after a sufficient amount of time has passed according to its expiry
          * specification.
          *
+         * The expired documents are found by scanning the index itself, and removed in batches
+         * of ttlMonitorBatchSize, each under one acquisition of the collection lock.
+         *
          * @return true if caller should continue processing TTL indexes of collections
          *         on the specified database, and false otherwise
          */
-        bool doTTLForIndex( OperationContext* txn, const string& dbName, const BSONObj& idx ) {
+        static bool doTTLForIndex( OperationContext* txn, const string& dbName,
+                                   const BSONObj& idx ) {
             BSONObj key = idx["key"].Obj();
             if ( key.nFields() != 1 ) {
                 error() << "key for ttl index can only have 1 field" << endl;
@@ -195,51 +542,129 @@ namespace mongo {
                 return true;
             }
 
-            BSONObj query;
+            const long long expireMs = 1000 * idx[secondsExpireField].numberLong();
+            const Date_t cutoff( curTimeMillis64() - expireMs );
+            const StringData field( key.firstElement().fieldName() );
+
+            // Every date before the cutoff, in increasing order whichever way the index goes.
+            BSONObj startKey;
+            {
+                BSONObjBuilder b;
+                b.appendMinForType( "", mongo::Date );
+                startKey = b.obj();
+            }
+            BSONObj endKey;
             {
                 BSONObjBuilder b;
-                long long expireMs = 1000 * idx[secondsExpireField].numberLong();
-                b.appendDate( "$lt", curTimeMillis64() - expireMs );
-                query = BSON( key.firstElement().fieldName() << b.obj() );
+                b.appendDate( "", cutoff );
+                endKey = b.obj();
             }
+            const InternalPlanner::Direction direction = key.firstElement().number() < 0
+                ? InternalPlanner::BACKWARD
+                : InternalPlanner::FORWARD;
 
-            LOG(1) << "TTL: " << key << " \t " << query << endl;
+            LOG(1) << "TTL: " << key << " \t deleting before " << dateToISOStringUTC( cutoff )
+                   << endl;
 
+            const string ns = idx["ns"].String();
+            const size_t batchSize = std::max( 1, static_cast<int>( ttlMonitorBatchSize ) );
+
+            Timer timer;
             long long n = 0;
-            {
-                const string ns = idx["ns"].String();
+            long long lagSecs = 0;
+            while ( !inShutdown() ) {
+                long long deleted = 0;
+                bool exhausted = false;
+                {
+                    ScopedTransaction scopedXact(txn, MODE_IX);
+                    AutoGetDb autoDb(txn, dbName, MODE_IX);
+                    Database* db = autoDb.getDb();
+                    if (!db) {
+                        return false;
+                    }
 
-                ScopedTransaction scopedXact(txn, MODE_IX);
-                AutoGetDb autoDb(txn, dbName, MODE_IX);
-                Database* db = autoDb.getDb();
-                if (!db) {
-                    return false;
-                }
+                    Lock::CollectionLock collLock( txn->lockState(), ns, MODE_IX );
 
-                Lock::CollectionLock collLock( txn->lockState(), ns, MODE_IX );
+                    Collection* collection = db->getCollection( txn, ns );
+                    if ( !collection ) {
+                        // collection was dropped
+                        return true;
+                    }
 
-                Collection* collection = db->getCollection( txn, ns );
-                if ( !collection ) {
-                    // collection was dropped
-                    return true;
-                }
+                    if (!repl::getGlobalReplicationCoordinator()->
+                            canAcceptWritesForDatabase(dbName)) {
+                        // we've stepped down since we started this function,
+                        // so we should stop working as we only do deletes on the primary
+                        return false;
+                    }
 
-                if (!repl::getGlobalReplicationCoordinator()->canAcceptWritesForDatabase(dbName)) {
-                    // we've stepped down since we started this function,
-                    // so we should stop working as we only do deletes on the primary
-                    return false;
-                }
+                    IndexDescriptor* desc =
+                        collection->getIndexCatalog()->findIndexByKeyPattern( txn, key );
+                    if ( desc == NULL ) {
+                        // index not finished yet
+                        LOG(1) << " skipping index because not finished";
+                        return true;
+                    }
 
-                if ( collection->getIndexCatalog()->findIndexByKeyPattern( txn, key ) == NULL ) {
-                    // index not finished yet
-                    LOG(1) << " skipping index because not finished";
-                    return true;
+                    // The scan doesn't yield, so the whole batch is gathered under this lock.
+                    auto_ptr<PlanExecutor> exec(
+                        InternalPlanner::indexScan( txn, collection, desc, startKey, endKey,
+                                                    false, direction,
+                                                    InternalPlanner::IXSCAN_FETCH ) );
+
+                    vector<RecordId> locs;
+                    RecordId loc;
+                    BSONObj obj;
+                    PlanExecutor::ExecState state = PlanExecutor::IS_EOF;
+                    while ( locs.size() < batchSize &&
+                            PlanExecutor::ADVANCED == ( state = exec->getNext( &obj, &loc ) ) ) {
+                        if ( n == 0 && locs.empty() ) {
+                            BSONElement oldest = obj.getFieldDotted( field );
+                            if ( oldest.type() == mongo::Date ) {
+                                lagSecs = ( static_cast<long long>( cutoff.millis ) -
+                                            static_cast<long long>( oldest.date().millis ) )
+                                          / 1000;
+                            }
+                        }
+                        locs.push_back( loc );
+                    }
+                    if ( state == PlanExecutor::FAILURE || state == PlanExecutor::DEAD ) {
+                        warning() << "TTL scan of " << key << " on " << ns << " stopped: "
+                                  << WorkingSetCommon::toStatusString( obj );
+                    }
+                    exhausted = locs.size() < batchSize;
+                    exec.reset();
+
+                    for ( size_t i = 0; i < locs.size(); i++ ) {
+                        WriteUnitOfWork wunit( txn );
+
+                        // Look again in this unit of work, in case the document changed since
+                        // the scan read it.
+                        BSONObj doc;
+                        if ( !collection->findDoc( txn, locs[i], &doc ) ||
+                             !isExpired( doc, field, cutoff ) ) {
+                            continue;
+                        }
+
+                        BSONObj deletedId;
+                        collection->deleteDocument( txn, locs[i], false, true, &deletedId );
+                        repl::logOp( txn, "d", ns.c_str(), deletedId );
+                        wunit.commit();
+                        deleted++;
+                    }
                 }
 
-                n = deleteObjects( txn, db, ns, query, PlanExecutor::YIELD_AUTO, false, true );
-                ttlDeletedDocuments.increment( n );
+                n += deleted;
+                ttlDeletedDocuments.increment( deleted );
+                ttlRateLimiter.deleted( deleted );
+
+                // A batch of documents that all changed under us would only be found again.
+                if ( exhausted || deleted == 0 )
+                    break;
             }
 
+            ttlStats.record( indexStatsNs( idx ), n, timer.millis(), lagSecs );
+
             LOG(1) << "\tTTL deleted: " << n << endl;
             return true;
         }
@@ -0,0 +1,377 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kStorage
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/warmup.h"
+
+#include <algorithm>
+#include <boost/filesystem/operations.hpp>
+#include <boost/thread/mutex.hpp>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <vector>
+
+#include "mongo/base/data_view.h"
+#include "mongo/bson/bson_validate.h"
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/client.h"
+#include "mongo/db/global_environment_experiment.h"
+#include "mongo/db/index/index_access_method.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/storage_engine.h"
+#include "mongo/db/storage_options.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/background.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/concurrency/threadlocal.h"
+#include "mongo/util/log.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+    // Seconds between saves of the sampled working set. 0 stops sampling and saving it.
+    MONGO_EXPORT_SERVER_PARAMETER(warmupSaveIntervalSecs, int, 300);
+
+    // Each thread samples one in this many documents it fetches.
+    MONGO_EXPORT_SERVER_PARAMETER(warmupSampleRate, int, 64);
+
+    // Documents per second, across all its threads, which warming at startup reads back.
+    // 0 skips warming.
+    MONGO_EXPORT_SERVER_PARAMETER(warmupDocsPerSecond, int, 2000);
+
+    // Namespaces warmed in parallel at startup.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(warmupThreads, int, 4);
+
+    // Fetches left before a thread samples its next one.
+    struct WarmupFetchCountdown {
+        WarmupFetchCountdown() : left(0) { }
+        int left;
+    };
+
+    TSP_DECLARE(WarmupFetchCountdown, warmupFetchCountdown)
+    TSP_DEFINE(WarmupFetchCountdown, warmupFetchCountdown)
+
+namespace {
+
+    // The most recent samples kept, and so the most documents one save can hold.
+    const size_t kMaxSamples = 64 * 1024;
+
+    // Documents warmed per acquisition of the collection lock.
+    const size_t kWarmBatchSize = 128;
+
+    const char kFileName[] = "warmup.bson";
+
+    typedef std::map<std::string, std::vector<RecordId> > LocsByNs;
+
+    // Set once at startup, for storage engines which take part.
+    AtomicUInt32 samplingEnabled;
+
+    /**
+     * Ring of the last kMaxSamples sampled fetches.
+     */
+    class SampleRing {
+    public:
+        SampleRing() : _next(0) { }
+
+        void add(const StringData& ns, const RecordId& loc) {
+            boost::mutex::scoped_lock lk(_mutex);
+            if (_samples.size() < kMaxSamples) {
+                _samples.push_back(Sample());
+            }
+            Sample& sample = _samples[_next];
+            sample.ns.assign(ns.rawData(), ns.size());
+            sample.loc = loc;
+            _next = (_next + 1) % kMaxSamples;
+        }
+
+        /**
+         * Fills 'out' with the distinct RecordIds sampled for each namespace, in ascending order
+         * so that warming reads them in the order they are stored.
+         */
+        void snapshot(LocsByNs* out) {
+            {
+                boost::mutex::scoped_lock lk(_mutex);
+                for (size_t i = 0; i < _samples.size(); i++) {
+                    (*out)[_samples[i].ns].push_back(_samples[i].loc);
+                }
+            }
+
+            for (LocsByNs::iterator it = out->begin(); it != out->end(); ++it) {
+                std::vector<RecordId>& locs = it->second;
+                std::sort(locs.begin(), locs.end());
+                locs.erase(std::unique(locs.begin(), locs.end()), locs.end());
+            }
+        }
+
+    private:
+        struct Sample {
+            std::string ns;
+            RecordId loc;
+        };
+
+        boost::mutex _mutex;
+        std::vector<Sample> _samples;
+        size_t _next; // the slot the next sample replaces once the ring is full
+    };
+
+    SampleRing sampleRing;
+
+    std::string filePath() {
+        return (boost::filesystem::path(storageGlobalParams.dbpath) / kFileName).string();
+    }
+
+    /**
+     * The file is one BSON object, { collections: [ { ns: <string>, locs: <BinData> } ] }, where
+     * 'locs' packs each RecordId's repr as a little endian 64 bit integer.
+     */
+    void save(const LocsByNs& locsByNs) {
+        BSONObjBuilder bob;
+        BSONArrayBuilder collections(bob.subarrayStart("collections"));
+        size_t numLocs = 0;
+        for (LocsByNs::const_iterator it = locsByNs.begin(); it != locsByNs.end(); ++it) {
+            const std::vector<RecordId>& locs = it->second;
+            std::vector<char> packed(locs.size() * sizeof(int64_t));
+            for (size_t i = 0; i < locs.size(); i++) {
+                DataView(&packed[0]).writeLE<int64_t>(locs[i].repr(), i * sizeof(int64_t));
+            }
+
+            BSONObjBuilder collection(collections.subobjStart());
+            collection.append("ns", it->first);
+            collection.appendBinData("locs", packed.size(), BinDataGeneral, &packed[0]);
+            collection.doneFast();
+            numLocs += locs.size();
+        }
+        collections.doneFast();
+        const BSONObj obj = bob.obj();
+
+        // Write a new file and then move it over the old one, so a crash never leaves half of
+        // one behind.
+        const std::string path = filePath();
+        const std::string tmpPath = path + ".tmp";
+        try {
+            {
+                std::ofstream out(tmpPath.c_str(), std::ios::binary | std::ios::trunc);
+                out.write(obj.objdata(), obj.objsize());
+                if (!out) {
+                    warning() << "could not write " << tmpPath << " to save the working set";
+                    return;
+                }
+            }
+            boost::filesystem::rename(tmpPath, path);
+        }
+        catch (const boost::filesystem::filesystem_error& e) {
+            warning() << "could not save the working set to " << path << ": " << e.what();
+            return;
+        }
+
+        LOG(1) << "saved " << numLocs << " documents of " << locsByNs.size()
+               << " collections to warm at restart";
+    }
+
+    bool load(LocsByNs* out) {
+        const std::string path = filePath();
+        std::ifstream in(path.c_str(), std::ios::binary);
+        if (!in) {
+            return false;
+        }
+
+        const std::string data((std::istreambuf_iterator<char>(in)),
+                               std::istreambuf_iterator<char>());
+        if (data.size() > static_cast<size_t>(BSONObjMaxInternalSize) ||
+            !validateBSON(data.data(), data.size()).isOK()) {
+            warning() << "ignoring " << path << ", which is not a valid saved working set";
+            return false;
+        }
+
+        const BSONObj obj(data.data());
+        if (obj["collections"].type() != Array) {
+            warning() << "ignoring " << path << ", which is not a valid saved working set";
+            return false;
+        }
+
+        BSONForEach(collection, obj["collections"].Obj()) {
+            if (collection.type() != Object) {
+                continue;
+            }
+            const BSONObj spec = collection.Obj();
+            const BSONElement locs = spec["locs"];
+            if (spec["ns"].type() != String || locs.type() != BinData) {
+                continue;
+            }
+
+            int len;
+            const char* packed = locs.binData(len);
+            std::vector<RecordId>& nsLocs = (*out)[spec["ns"].String()];
+            for (int i = 0; i + static_cast<int>(sizeof(int64_t)) <= len; i += sizeof(int64_t)) {
+                nsLocs.push_back(RecordId(ConstDataView(packed).readLE<int64_t>(i)));
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Reads 'locs' of 'ns' and their index keys, at most 'docsPerSecond' a second. RecordIds
+     * which no longer exist are skipped.
+     */
+    void warmCollection(const std::string& ns,
+                        const std::vector<RecordId>* locs,
+                        double docsPerSecond) {
+        Client::initThreadIfNotAlready("warmup");
+        cc().getAuthorizationSession()->grantInternalAuthorization();
+
+        OperationContextImpl txn;
+        for (size_t start = 0; start < locs->size() && !inShutdown(); start += kWarmBatchSize) {
+            Timer timer;
+            const size_t end = std::min(locs->size(), start + kWarmBatchSize);
+            try {
+                AutoGetCollectionForRead ctx(&txn, ns);
+                Collection* collection = ctx.getCollection();
+                if (!collection) {
+                    return;
+                }
+
+                for (size_t i = start; i < end; i++) {
+                    RecordData record;
+                    if (!collection->getRecordStore()->findRecord(&txn, (*locs)[i], &record)) {
+                        continue;
+                    }
+
+                    const BSONObj doc = record.releaseToBson();
+                    IndexCatalog::IndexIterator ii =
+                        collection->getIndexCatalog()->getIndexIterator(&txn, false);
+                    while (ii.more()) {
+                        IndexDescriptor* desc = ii.next();
+                        collection->getIndexCatalog()->getIndex(desc)->touch(&txn, doc);
+                    }
+                }
+            }
+            catch (const DBException& e) {
+                LOG(1) << "stopped warming " << ns << ": " << e.what();
+                return;
+            }
+
+            const long long budgetMillis =
+                static_cast<long long>((end - start) * 1000 / docsPerSecond);
+            if (timer.millis() < budgetMillis) {
+                sleepmillis(budgetMillis - timer.millis());
+            }
+        }
+    }
+
+    void warm() {
+        const int docsPerSecond = warmupDocsPerSecond;
+        if (docsPerSecond <= 0) {
+            return;
+        }
+
+        LocsByNs locsByNs;
+        if (!load(&locsByNs)) {
+            return;
+        }
+
+        size_t numLocs = 0;
+        for (LocsByNs::const_iterator it = locsByNs.begin(); it != locsByNs.end(); ++it) {
+            numLocs += it->second.size();
+        }
+        log() << "warming " << numLocs << " documents of " << locsByNs.size()
+              << " collections saved before the last shutdown";
+
+        Timer timer;
+        const int numThreads = std::max(1, static_cast<int>(warmupThreads));
+        {
+            ThreadPool pool(numThreads, "warmup worker ");
+            for (LocsByNs::const_iterator it = locsByNs.begin(); it != locsByNs.end(); ++it) {
+                pool.schedule(&warmCollection,
+                              it->first,
+                              &it->second,
+                              static_cast<double>(docsPerSecond) / numThreads);
+            }
+            pool.join();
+        }
+        log() << "done warming the working set in " << timer.millis() << "ms";
+    }
+
+    class WarmupJob : public BackgroundJob {
+    public:
+        WarmupJob() : BackgroundJob(true /* selfDelete */) { }
+
+        virtual std::string name() const { return "WarmupJob"; }
+
+        virtual void run() {
+            Client::initThread(name().c_str());
+
+            warm();
+
+            while (!inShutdown()) {
+                sleepsecs(std::max(1, static_cast<int>(warmupSaveIntervalSecs)));
+                if (warmupSaveIntervalSecs <= 0 || inShutdown()) {
+                    continue;
+                }
+
+                // An idle node keeps what it saved while it was busy.
+                LocsByNs locsByNs;
+                sampleRing.snapshot(&locsByNs);
+                if (!locsByNs.empty()) {
+                    save(locsByNs);
+                }
+            }
+        }
+    };
+
+}  // namespace
+
+    void noteDocumentFetched(const StringData& ns, const RecordId& loc) {
+        if (!samplingEnabled.loadRelaxed() || warmupSaveIntervalSecs <= 0) {
+            return;
+        }
+
+        WarmupFetchCountdown* countdown = warmupFetchCountdown.getMake();
+        if (--countdown->left > 0) {
+            return;
+        }
+        countdown->left = std::max(1, static_cast<int>(warmupSampleRate));
+        sampleRing.add(ns, loc);
+    }
+
+    void startWarmupBackgroundJob() {
+        const StorageEngine* engine = getGlobalEnvironment()->getGlobalStorageEngine();
+        if (engine->isMmapV1() || !engine->isDurable()) {
+            return;
+        }
+
+        samplingEnabled.store(1);
+        (new WarmupJob())->go();
+    }
+
+}  // namespace mongo
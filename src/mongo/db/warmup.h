@@ -0,0 +1,58 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+namespace mongo {
+
+    class RecordId;
+    class StringData;
+
+    /**
+     * Working set warmup: mongod keeps a sample of the documents which are fetched by RecordId
+     * and periodically saves the distinct ones, by namespace, to a file in the dbpath. After a
+     * restart it reads those documents and their index keys back into the storage engine's cache
+     * in the background, at a limited rate, before the clients which made them hot come back.
+     *
+     * Only storage engines which manage their own cache take part. The mmapv1 data files stay in
+     * the operating system's page cache across a restart of mongod.
+     */
+
+    /**
+     * Called with every document fetched by its RecordId. Samples one in warmupSampleRate on
+     * each thread; otherwise it costs a thread local counter.
+     */
+    void noteDocumentFetched(const StringData& ns, const RecordId& loc);
+
+    /**
+     * Warms the documents saved before the last shutdown, then saves the sample every
+     * warmupSaveIntervalSecs. Call once at startup, after the catalog is loaded.
+     */
+    void startWarmupBackgroundJob();
+
+}  // namespace mongo
@@ -837,6 +837,226 @@ namespace AccumulatorTests {
         
     } // namespace Sum
 
+    namespace ApproxCountDistinct {
+
+        class Base : public AccumulatorTests::Base {
+        protected:
+            void createAccumulator() {
+                _accumulator = AccumulatorApproxCountDistinct::create();
+                ASSERT_EQUALS(string("$approxCountDistinct"), _accumulator->getOpName());
+            }
+            Accumulator *accumulator() { return _accumulator.get(); }
+            /** Asserts that the estimate is within 'tolerance' of 'expected', as a fraction. */
+            void assertEstimate(long long expected, double tolerance) {
+                Value result = accumulator()->getValue(false);
+                ASSERT_EQUALS(NumberLong, result.getType());
+                ASSERT_LESS_THAN_OR_EQUALS(std::abs(result.getLong() - expected),
+                                           expected * tolerance);
+            }
+        private:
+            intrusive_ptr<Accumulator> _accumulator;
+        };
+
+        /** No documents evaluated. */
+        class None : public Base {
+        public:
+            void run() {
+                createAccumulator();
+                assertBinaryEqual(BSON("" << 0LL), fromValue(accumulator()->getValue(false)));
+            }
+        };
+
+        /** Few distinct values are counted exactly, with equal numbers and missing values. */
+        class Exact : public Base {
+        public:
+            void run() {
+                createAccumulator();
+                accumulator()->process(Value(1), false);
+                accumulator()->process(Value(1.0), false);
+                accumulator()->process(Value(2LL), false);
+                accumulator()->process(Value("a"), false);
+                accumulator()->process(Value(), false);
+                accumulator()->process(Value("a"), false);
+                assertBinaryEqual(BSON("" << 3LL), fromValue(accumulator()->getValue(false)));
+            }
+        };
+
+        /** Many distinct values are estimated within a few percent in bounded memory. */
+        class Large : public Base {
+        public:
+            void run() {
+                createAccumulator();
+                for (int i = 0; i < 100000; i++) {
+                    accumulator()->process(Value(i), false);
+                    accumulator()->process(Value(i), false);
+                }
+                assertEstimate(100000, 0.03);
+                ASSERT_LESS_THAN(accumulator()->memUsageForSorter(), 20 * 1024);
+            }
+        };
+
+        /** Duplicated small sets are counted exactly. */
+        class Small : public Base {
+        public:
+            void run() {
+                createAccumulator();
+                for (int n = 0; n < 3; n++) {
+                    for (int i = 0; i < 200; i++) {
+                        accumulator()->process(Value(i), false);
+                    }
+                }
+                assertBinaryEqual(BSON("" << 200LL), fromValue(accumulator()->getValue(false)));
+            }
+        };
+
+        /** Overlapping shards merge exactly while small, and approximately when large. */
+        class ShardAndRouter : public Base {
+        public:
+            void run() {
+                merge(100, 50, 0);
+                merge(50000, 25000, 0.03);
+                merge(100, 40000, 0.03);
+            }
+        private:
+            /**
+             * Merges one shard which saw [0, 'n') with another which saw ['offset', 'offset' + 'n')
+             * and asserts that the merged estimate is close enough to the distinct count.
+             */
+            void merge(int n, int offset, double tolerance) {
+                intrusive_ptr<Accumulator> first = AccumulatorApproxCountDistinct::create();
+                intrusive_ptr<Accumulator> second = AccumulatorApproxCountDistinct::create();
+                for (int i = 0; i < n; i++) {
+                    first->process(Value(i), false);
+                    second->process(Value(offset + i), false);
+                }
+                createAccumulator();
+                accumulator()->process(first->getValue(true), true);
+                accumulator()->process(second->getValue(true), true);
+                assertEstimate(n + std::min(n, offset), tolerance);
+            }
+        };
+
+    } // namespace ApproxCountDistinct
+
+    namespace Percentile {
+
+        class Base : public AccumulatorTests::Base {
+        protected:
+            void createAccumulator() {
+                _accumulator = AccumulatorPercentile::create();
+                ASSERT_EQUALS(string("$percentile"), _accumulator->getOpName());
+            }
+            Accumulator *accumulator() { return _accumulator.get(); }
+            void process(const Value& input, double p) {
+                accumulator()->process(Value(DOC("input" << input << "p" << p)), false);
+            }
+            /** Asserts that the estimate is within 'tolerance' of 'expected'. */
+            void assertEstimate(double expected, double tolerance) {
+                Value result = accumulator()->getValue(false);
+                ASSERT_EQUALS(NumberDouble, result.getType());
+                ASSERT_APPROX_EQUAL(expected, result.getDouble(), tolerance);
+            }
+        private:
+            intrusive_ptr<Accumulator> _accumulator;
+        };
+
+        /** No documents evaluated. */
+        class None : public Base {
+        public:
+            void run() {
+                createAccumulator();
+                ASSERT_EQUALS(jstNULL, accumulator()->getValue(false).getType());
+            }
+        };
+
+        /** Non numeric and missing inputs have no effect. */
+        class NonNumeric : public Base {
+        public:
+            void run() {
+                createAccumulator();
+                process(Value("a"), 0.5);
+                process(Value(), 0.5);
+                ASSERT_EQUALS(jstNULL, accumulator()->getValue(false).getType());
+                process(Value(7), 0.5);
+                process(Value("b"), 0.5);
+                assertEstimate(7, 0);
+            }
+        };
+
+        /** The extreme percentiles are the minimum and maximum. */
+        class Extremes : public Base {
+        public:
+            void run() {
+                createAccumulator();
+                for (int i = 0; i < 10000; i++) {
+                    process(Value((i * 7919) % 10000), 0);
+                }
+                assertEstimate(0, 0);
+
+                createAccumulator();
+                for (int i = 0; i < 10000; i++) {
+                    process(Value((i * 7919) % 10000), 1);
+                }
+                assertEstimate(9999, 0);
+            }
+        };
+
+        /** The median and tail percentiles of many values are within 0.1% in bounded memory. */
+        class Large : public Base {
+        public:
+            void run() {
+                estimate(0.5, 100);
+                estimate(0.99, 100);
+                estimate(0.01, 100);
+            }
+        private:
+            void estimate(double p, double tolerance) {
+                createAccumulator();
+                for (int i = 0; i < 100000; i++) {
+                    process(Value((i * 7919) % 100000), p);
+                }
+                assertEstimate(p * 100000, tolerance);
+                ASSERT_LESS_THAN(accumulator()->memUsageForSorter(), 32 * 1024);
+            }
+        };
+
+        /** Shards' digests merge into an estimate of the percentile of all their inputs. */
+        class ShardAndRouter : public Base {
+        public:
+            void run() {
+                intrusive_ptr<Accumulator> empty = AccumulatorPercentile::create();
+                intrusive_ptr<Accumulator> low = AccumulatorPercentile::create();
+                intrusive_ptr<Accumulator> high = AccumulatorPercentile::create();
+                for (int i = 0; i < 50000; i++) {
+                    low->process(Value(DOC("input" << i << "p" << 0.9)), false);
+                    high->process(Value(DOC("input" << 50000 + i << "p" << 0.9)), false);
+                }
+                createAccumulator();
+                accumulator()->process(empty->getValue(true), true);
+                accumulator()->process(high->getValue(true), true);
+                accumulator()->process(low->getValue(true), true);
+                assertEstimate(90000, 200);
+            }
+        };
+
+        /** 'p' must be a number in [0, 1] and the same for every input. */
+        class BadPercentile : public Base {
+        public:
+            void run() {
+                createAccumulator();
+                ASSERT_THROWS(accumulator()->process(Value(1), false), UserException);
+                ASSERT_THROWS(process(Value(1), -0.1), UserException);
+                ASSERT_THROWS(process(Value(1), 1.5), UserException);
+                ASSERT_THROWS(accumulator()->process(Value(DOC("input" << 1 << "p" << "a")),
+                                                     false),
+                              UserException);
+                process(Value(1), 0.5);
+                ASSERT_THROWS(process(Value(1), 0.6), UserException);
+            }
+        };
+
+    } // namespace Percentile
+
     class All : public Suite {
     public:
         All() : Suite( "accumulator" ) {
@@ -913,6 +1133,19 @@ namespace AccumulatorTests {
             add<Sum::IntNull>();
             add<Sum::IntUndefined>();
             add<Sum::NoOverflowBeforeDouble>();
+
+            add<ApproxCountDistinct::None>();
+            add<ApproxCountDistinct::Exact>();
+            add<ApproxCountDistinct::Large>();
+            add<ApproxCountDistinct::Small>();
+            add<ApproxCountDistinct::ShardAndRouter>();
+
+            add<Percentile::None>();
+            add<Percentile::NonNumeric>();
+            add<Percentile::Extremes>();
+            add<Percentile::Large>();
+            add<Percentile::ShardAndRouter>();
+            add<Percentile::BadPercentile>();
         }
     };
 
@@ -33,8 +33,11 @@
 
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/dbtests/dbtests.h"
+#include "mongo/platform/random.h"
 #include "mongo/util/base64.h"
 #include "mongo/util/compress.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/mongoutils/str.h"
 #include "mongo/util/paths.h"
 #include "mongo/util/queue.h"
 #include "mongo/util/stringutils.h"
@@ -535,6 +538,35 @@ namespace BasicTests {
         }
     } ctest1;
 
+    struct CompressionParallel {
+        void run() {
+            // Partly compressible input spanning several snappy blocks and an uneven tail
+            std::string input;
+            PseudoRandom random(1);
+            while (input.size() < 700 * 1000) {
+                input += str::stream() << "document " << random.nextInt32(1000) << ' ';
+            }
+
+            std::vector<char> serial(maxCompressedLength(input.size()));
+            size_t serialLength = 0;
+            rawCompress(input.data(), input.size(), &serial[0], &serialLength);
+
+            ThreadPool pool(3);
+            // 100000 is rounded up to two 64KB blocks
+            std::vector<char> parallel(maxCompressedLength(input.size()));
+            size_t parallelLength = 0;
+            rawCompressParallel(input.data(), input.size(), &parallel[0], &parallelLength,
+                                &pool, 100000);
+
+            ASSERT_EQUALS(serialLength, parallelLength);
+            ASSERT_EQUALS(0, memcmp(&serial[0], &parallel[0], serialLength));
+
+            std::string out;
+            ASSERT(uncompress(&parallel[0], parallelLength, &out));
+            ASSERT_EQUALS(input, out);
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "basic" ) {
@@ -568,6 +600,7 @@ namespace BasicTests {
             add< RelativePathTest >();
 
             add< CompressionTest1 >();
+            add< CompressionParallel >();
 
         }
     };
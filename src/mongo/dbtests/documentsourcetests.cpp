@@ -744,6 +744,28 @@ namespace DocumentSourceTests {
             virtual string expectedResultSetString() { return "[{_id:0,a:[1]},{_id:1,a:[2]}]"; }
         };
         
+        /** A $group with enough distinct keys to grow the group table several times. */
+        class ManyKeys : public CheckResultsBase {
+            void populateData() {
+                for ( int i = 0; i < 4 * nKeys; ++i ) {
+                    client.insert( ns, BSON( "id" << i % nKeys << "a" << i ) );
+                }
+            }
+            virtual BSONObj groupSpec() {
+                return BSON( "_id" << "$id"
+                             << "count" << BSON( "$sum" << 1 )
+                             << "first" << BSON( "$min" << "$a" ) );
+            }
+            virtual BSONObj expectedResultSet() {
+                BSONArrayBuilder expected;
+                for ( int i = 0; i < nKeys; ++i ) {
+                    expected << BSON( "_id" << i << "count" << 4 << "first" << i );
+                }
+                return expected.arr();
+            }
+            static const int nKeys = 1000;
+        };
+
         /** A $group performed on two values with two keys each. */
         class FourValuesTwoKeys : public CheckResultsBase {
             void populateData() {
@@ -898,6 +920,83 @@ namespace DocumentSourceTests {
             string expectedResultSetString() { return "[{_id:[1,2,3],a:[[4,5,6]]}]"; }
         };
 
+        /** A streaming $group returns the groups of its input in the order of the input. */
+        class StreamingBase : public Base {
+        public:
+            virtual ~StreamingBase() {
+            }
+            void run() {
+                BSONObj sourceData = fromjson( string( "{'':" ) + inputString() + "}" );
+                intrusive_ptr<DocumentSourceBsonArray> source =
+                        DocumentSourceBsonArray::create( sourceData.firstElement().Obj(), ctx() );
+                createGroup( groupSpec() );
+                static_cast<DocumentSourceGroup*>( group() )->setStreaming( true );
+                group()->setSource( source.get() );
+
+                BSONArrayBuilder results;
+                while (boost::optional<Document> current = group()->getNext()) {
+                    results << current->toBson();
+                }
+                assertExhausted( group() );
+                BSONObj expected = fromjson( string( "{'':" ) + expectedString() + "}" );
+                ASSERT_EQUALS( expected[""].embeddedObject(), results.arr() );
+            }
+        protected:
+            virtual string inputString() = 0;
+            virtual BSONObj groupSpec() = 0;
+            virtual string expectedString() = 0;
+        };
+
+        /** Missing and null keys form one group. */
+        class StreamingFieldPath : public StreamingBase {
+            string inputString() { return "[{y:4},{x:null,y:5},{x:1,y:1},{x:1,y:2},{x:2,y:3}]"; }
+            BSONObj groupSpec() { return fromjson( "{_id:'$x',total:{$sum:'$y'}}" ); }
+            string expectedString() {
+                return "[{_id:null,total:9},{_id:1,total:3},{_id:2,total:3}]";
+            }
+        };
+
+        class StreamingCompoundId : public StreamingBase {
+            string inputString() { return "[{a:1,b:1},{a:1,b:1},{a:1,b:2},{a:2,b:2}]"; }
+            BSONObj groupSpec() { return fromjson( "{_id:{a:'$a',b:'$b'},n:{$sum:1}}" ); }
+            string expectedString() {
+                return "[{_id:{a:1,b:1},n:2},{_id:{a:1,b:2},n:1},{_id:{a:2,b:2},n:1}]";
+            }
+        };
+
+        class StreamingEmptyInput : public StreamingBase {
+            string inputString() { return "[]"; }
+            BSONObj groupSpec() { return fromjson( "{_id:'$x',n:{$sum:1}}" ); }
+            string expectedString() { return "[]"; }
+        };
+
+        /** The input fields a group key is made of. */
+        class IdFieldPaths : public Base {
+        public:
+            void run() {
+                assertIdFieldPaths( "{_id:'$x'}", "['x']" );
+                assertIdFieldPaths( "{_id:'$x.y'}", "['x.y']" );
+                assertIdFieldPaths( "{_id:{a:'$x.y',b:'$z'}}", "['x.y','z']" );
+                assertIdFieldPaths( "{_id:'$$ROOT.x'}", "['x']" );
+                assertIdFieldPaths( "{_id:'$$ROOT'}", "[]" );
+                assertIdFieldPaths( "{_id:1}", "[]" );
+                assertIdFieldPaths( "{_id:{$add:['$x',1]}}", "[]" );
+                assertIdFieldPaths( "{_id:{a:'$x',b:{$add:['$y',1]}}}", "[]" );
+            }
+        private:
+            void assertIdFieldPaths( const string& spec, const string& expected ) {
+                createGroup( fromjson( spec ) );
+                vector<string> paths =
+                        static_cast<DocumentSourceGroup*>( group() )->getIdFieldPaths();
+                BSONArrayBuilder pathsBuilder;
+                for ( size_t i = 0; i < paths.size(); i++ ) {
+                    pathsBuilder << paths[i];
+                }
+                BSONObj expectedObj = fromjson( "{'':" + expected + "}" );
+                ASSERT_EQUALS( expectedObj[""].embeddedObject(), pathsBuilder.arr() );
+            }
+        };
+
     } // namespace DocumentSourceGroup
 
     namespace DocumentSourceProject {
@@ -1669,6 +1768,391 @@ namespace DocumentSourceTests {
         };
     } // namespace DocumentSourceGeoNear
 
+    namespace DocumentSourceLookup {
+        using mongo::DocumentSourceLookup;
+
+        static const char* const foreignNs = "unittests.documentsourcetests_foreign";
+
+        /** Serves the MongodInterface calls $lookup makes through the test's client. */
+        class TestMongodInterface : public DocumentSourceNeedsMongod::MongodInterface {
+        public:
+            explicit TestMongodInterface(DBDirectClient* client) : _client(client) {}
+
+            DBClientBase* directClient() { return _client; }
+            bool isSharded(const NamespaceString& ns) { return false; }
+            bool isCapped(const NamespaceString& ns) { return false; }
+            void insert(const NamespaceString& ns, const std::vector<BSONObj>& objs) {
+                _client->insert(ns.ns(), objs);
+            }
+            void buildIndexes(const NamespaceString& ns, const std::vector<BSONObj>& specs) {
+                verify(false);
+            }
+            bool hasIndexOnField(const NamespaceString& ns, const std::string& field) {
+                list<BSONObj> specs = _client->getIndexSpecs(ns.ns());
+                for (list<BSONObj>::const_iterator it = specs.begin(); it != specs.end(); ++it) {
+                    if (it->getObjectField("key").firstElementFieldName() == field)
+                        return true;
+                }
+                return false;
+            }
+
+        private:
+            DBDirectClient* _client;
+        };
+
+        class Base : public DocumentSourceCursor::Base {
+        public:
+            ~Base() {
+                client.dropCollection(foreignNs);
+            }
+
+        protected:
+            void populateData() {
+                client.insert(ns, BSON("_id" << 0 << "a" << 2));
+                client.insert(ns, BSON("_id" << 1 << "a" << 1));
+                client.insert(ns, BSON("_id" << 2));
+
+                client.insert(foreignNs, BSON("_id" << 10 << "b" << 1));
+                client.insert(foreignNs, BSON("_id" << 11 << "b" << BSON_ARRAY(1 << 2 << 1)));
+                client.insert(foreignNs, BSON("_id" << 12 << "b" << BSONNULL));
+                client.insert(foreignNs, BSON("_id" << 13));
+                client.insert(foreignNs, BSON("_id" << 14 << "b" << 3));
+            }
+
+            /** Runs the join, returning {<input _id>: [<sorted matched _ids>]} in output order. */
+            BSONObj runLookup() {
+                BSONObj spec = BSON("$lookup" << BSON("from" << "documentsourcetests_foreign"
+                                                      << "localField" << "a"
+                                                      << "foreignField" << "b"
+                                                      << "as" << "joined"));
+                intrusive_ptr<DocumentSource> lookup =
+                    DocumentSourceLookup::createFromBson(spec.firstElement(), ctx());
+                ASSERT_EQUALS(spec, toBson(lookup));
+                dynamic_cast<DocumentSourceNeedsMongod*>(lookup.get())->injectMongodInterface(
+                    boost::make_shared<TestMongodInterface>(&client));
+
+                createSource();
+                lookup->setSource(source());
+
+                BSONObjBuilder result;
+                while (boost::optional<Document> next = lookup->getNext()) {
+                    vector<int> ids;
+                    const vector<Value>& joined = next->getField("joined").getArray();
+                    for (size_t i = 0; i < joined.size(); i++) {
+                        ids.push_back(joined[i].getDocument().getField("_id").getInt());
+                    }
+                    std::sort(ids.begin(), ids.end());
+
+                    BSONArrayBuilder idsBuilder(result.subarrayStart(
+                        next->getField("_id").coerceToString()));
+                    for (size_t i = 0; i < ids.size(); i++) {
+                        idsBuilder << ids[i];
+                    }
+                    idsBuilder.done();
+                }
+                ASSERT(!lookup->getNext());
+                return result.obj();
+            }
+        };
+
+        /** Without an index on 'b', the foreign side is hashed and output keeps input order. */
+        class HashJoin : public Base {
+        public:
+            void run() {
+                populateData();
+                ASSERT_EQUALS(BSON("0" << BSON_ARRAY(11)
+                                << "1" << BSON_ARRAY(10 << 11)
+                                << "2" << BSON_ARRAY(12 << 13)),
+                              runLookup());
+            }
+        };
+
+        /** With an index on 'b', each input is looked up through it with the same results. */
+        class IndexNestedLoopJoin : public Base {
+        public:
+            void run() {
+                populateData();
+                client.ensureIndex(foreignNs, BSON("b" << 1));
+                ASSERT_EQUALS(BSON("0" << BSON_ARRAY(11)
+                                << "1" << BSON_ARRAY(10 << 11)
+                                << "2" << BSON_ARRAY(12 << 13)),
+                              runLookup());
+            }
+        };
+
+        /** Sets the $lookup memory limit for the lifetime of the object. */
+        class MemoryLimitGuard {
+        public:
+            explicit MemoryLimitGuard(int bytes)
+                : _old(internalDocumentSourceLookupMaxMemoryBytes) {
+                internalDocumentSourceLookupMaxMemoryBytes = bytes;
+            }
+            ~MemoryLimitGuard() {
+                internalDocumentSourceLookupMaxMemoryBytes = _old;
+            }
+        private:
+            const int _old;
+        };
+
+        /** Past the memory limit both sides are sorted and merged, so output is in key order. */
+        class SortMergeJoin : public Base {
+        public:
+            void run() {
+                populateData();
+                MemoryLimitGuard guard(1);
+                ctx()->extSortAllowed = true;
+                ASSERT_EQUALS(BSON("2" << BSON_ARRAY(12 << 13)
+                                << "1" << BSON_ARRAY(10 << 11)
+                                << "0" << BSON_ARRAY(11)),
+                              runLookup());
+            }
+        };
+
+        /** Past the memory limit without allowDiskUse, the join fails. */
+        class MemoryLimitWithoutDisk : public Base {
+        public:
+            void run() {
+                populateData();
+                MemoryLimitGuard guard(1);
+                ASSERT_THROWS(runLookup(), UserException);
+            }
+        };
+
+        /** Unknown and missing arguments are rejected. */
+        class BadSpec : public Base {
+        public:
+            void run() {
+                ASSERT_THROWS(createLookup(BSON("from" << "x" << "localField" << "a"
+                                                << "foreignField" << "b")),
+                              UserException);
+                ASSERT_THROWS(createLookup(BSON("from" << "x" << "localField" << "a"
+                                                << "foreignField" << "b" << "as" << "c"
+                                                << "bogus" << "d")),
+                              UserException);
+                ASSERT_THROWS(createLookup(BSON("from" << 1 << "localField" << "a"
+                                                << "foreignField" << "b" << "as" << "c")),
+                              UserException);
+            }
+        private:
+            void createLookup(const BSONObj& args) {
+                DocumentSourceLookup::createFromBson(BSON("$lookup" << args).firstElement(),
+                                                     ctx());
+            }
+        };
+    } // namespace DocumentSourceLookup
+
+    namespace DocumentSourceSample {
+        using mongo::DocumentSourceSample;
+        using mongo::DocumentSourceSampleFromRandomCursor;
+
+        class Base : public DocumentSourceCursor::Base {
+        protected:
+            /** Returns the documents 'stage' outputs from 'input', a JSON array. */
+            vector<Document> runStage(const intrusive_ptr<DocumentSource>& stage,
+                                      const string& input) {
+                BSONObj inputObj = fromjson("{'':" + input + "}");
+                _input = DocumentSourceBsonArray::create(inputObj.firstElement().Obj(), ctx());
+                stage->setSource(_input.get());
+
+                vector<Document> out;
+                while (boost::optional<Document> next = stage->getNext()) {
+                    out.push_back(*next);
+                }
+                return out;
+            }
+
+            intrusive_ptr<DocumentSourceSample> createSample(long long size) {
+                BSONObj spec = BSON("$sample" << BSON("size" << size));
+                intrusive_ptr<DocumentSource> sample =
+                    DocumentSourceSample::createFromBson(spec.firstElement(), ctx());
+                ASSERT_EQUALS(spec, toBson(sample));
+                return static_cast<DocumentSourceSample*>(sample.get());
+            }
+
+            /** Asserts that 'docs' have 'count' distinct _ids, each below 'limit'. */
+            void assertDistinctIds(const vector<Document>& docs, size_t count, int limit) {
+                ASSERT_EQUALS(count, docs.size());
+                set<int> ids;
+                for (size_t i = 0; i < docs.size(); i++) {
+                    int id = docs[i]["_id"].getInt();
+                    ASSERT_LESS_THAN(id, limit);
+                    ids.insert(id);
+                }
+                ASSERT_EQUALS(count, ids.size());
+            }
+
+            /** Returns "[{_id:0},...,{_id:n-1}]". */
+            static string idsUpTo(int n) {
+                BSONArrayBuilder arr;
+                for (int i = 0; i < n; i++) {
+                    arr << BSON("_id" << i);
+                }
+                return arr.arr().jsonString(Strict, 0, true);
+            }
+
+        private:
+            intrusive_ptr<DocumentSourceBsonArray> _input;
+        };
+
+        /** A sample smaller than its input picks distinct input documents. */
+        class SampleSmallerThanInput : public Base {
+        public:
+            void run() {
+                assertDistinctIds(runStage(createSample(3), idsUpTo(10)), 3, 10);
+            }
+        };
+
+        /** A sample larger than its input returns all of it. */
+        class SampleLargerThanInput : public Base {
+        public:
+            void run() {
+                assertDistinctIds(runStage(createSample(20), idsUpTo(10)), 10, 10);
+                ASSERT(runStage(createSample(1), "[]").empty());
+            }
+        };
+
+        /** Every input document is as likely to be sampled. */
+        class Uniform : public Base {
+        public:
+            void run() {
+                vector<int> counts(4, 0);
+                for (int i = 0; i < 4000; i++) {
+                    vector<Document> out = runStage(createSample(1), idsUpTo(4));
+                    ASSERT_EQUALS(1U, out.size());
+                    counts[out[0]["_id"].getInt()]++;
+                }
+                // Each count is 1000 on average with a standard deviation of about 27.
+                for (size_t i = 0; i < counts.size(); i++) {
+                    ASSERT_GREATER_THAN(counts[i], 800);
+                    ASSERT_LESS_THAN(counts[i], 1200);
+                }
+            }
+        };
+
+        /** Shards send their keys, and the merger keeps the smallest and removes them. */
+        class ShardAndMerge : public Base {
+        public:
+            void run() {
+                ctx()->inShard = true;
+                vector<Document> shardOut = runStage(createSample(3), idsUpTo(10));
+                ASSERT_EQUALS(3U, shardOut.size());
+                for (size_t i = 0; i < shardOut.size(); i++) {
+                    double key = shardOut[i][DocumentSourceSample::randValName].getDouble();
+                    ASSERT_GREATER_THAN_OR_EQUALS(key, 0.0);
+                    ASSERT_LESS_THAN(key, 1.0);
+                    if (i > 0) {
+                        ASSERT_LESS_THAN(
+                            shardOut[i - 1][DocumentSourceSample::randValName].getDouble(), key);
+                    }
+                }
+                ctx()->inShard = false;
+
+                intrusive_ptr<DocumentSource> merger = createSample(2)->getMergeSource();
+                ASSERT_EQUALS(fromjson("{$sample:{size:2,$doingMerge:true}}"), toBson(merger));
+                DepsTracker deps;
+                ASSERT_EQUALS(DocumentSource::NOT_SUPPORTED, merger->getDependencies(&deps));
+
+                string mergeInput = "[{_id:0,$randVal:0.5},{_id:1,$randVal:0.1},"
+                                    "{_id:2,$randVal:0.9},{_id:3,$randVal:0.3}]";
+                vector<Document> out = runStage(merger, mergeInput);
+                ASSERT_EQUALS(2U, out.size());
+                ASSERT_EQUALS(fromjson("{_id:1}"), out[0].toBson());
+                ASSERT_EQUALS(fromjson("{_id:3}"), out[1].toBson());
+            }
+        };
+
+        class MemoryLimitGuard {
+        public:
+            explicit MemoryLimitGuard(int bytes)
+                : _old(internalDocumentSourceSampleMaxMemoryBytes) {
+                internalDocumentSourceSampleMaxMemoryBytes = bytes;
+            }
+            ~MemoryLimitGuard() {
+                internalDocumentSourceSampleMaxMemoryBytes = _old;
+            }
+        private:
+            const int _old;
+        };
+
+        /** Past the memory limit the sample fails rather than spilling. */
+        class MemoryLimit : public Base {
+        public:
+            void run() {
+                MemoryLimitGuard guard(1);
+                ASSERT_THROWS(runStage(createSample(3), idsUpTo(10)), UserException);
+            }
+        };
+
+        /** Unknown, missing and invalid arguments are rejected. */
+        class BadSpec : public Base {
+        public:
+            void run() {
+                ASSERT_THROWS(createSample(BSON("$sample" << 1)), UserException);
+                ASSERT_THROWS(createSample(BSON("$sample" << BSONObj())), UserException);
+                ASSERT_THROWS(createSample(BSON("$sample" << BSON("size" << 0))), UserException);
+                ASSERT_THROWS(createSample(BSON("$sample" << BSON("size" << "1"))),
+                              UserException);
+                ASSERT_THROWS(createSample(BSON("$sample" << BSON("size" << 1 << "x" << 1))),
+                              UserException);
+            }
+        private:
+            void createSample(const BSONObj& spec) {
+                DocumentSourceSample::createFromBson(spec.firstElement(), ctx());
+            }
+        };
+
+        /** Sampling from a random cursor skips repeated documents and stops at the size. */
+        class FromRandomCursor : public Base {
+        public:
+            void run() {
+                intrusive_ptr<DocumentSource> sample =
+                    DocumentSourceSampleFromRandomCursor::create(ctx(), 3, 100);
+                vector<Document> out =
+                    runStage(sample, "[{_id:1},{_id:1},{_id:2},{_id:1},{_id:3},{_id:4}]");
+                ASSERT_EQUALS(3U, out.size());
+                ASSERT_EQUALS(fromjson("{_id:1}"), out[0].toBson());
+                ASSERT_EQUALS(fromjson("{_id:2}"), out[1].toBson());
+                ASSERT_EQUALS(fromjson("{_id:3}"), out[2].toBson());
+
+                DepsTracker deps;
+                ASSERT_EQUALS(DocumentSource::SEE_NEXT, sample->getDependencies(&deps));
+                ASSERT_EQUALS(1U, deps.fields.count("_id"));
+            }
+        };
+
+        /** On a shard the documents of a random cursor get increasing keys. */
+        class FromRandomCursorInShard : public Base {
+        public:
+            void run() {
+                ctx()->inShard = true;
+                vector<Document> out = runStage(
+                    DocumentSourceSampleFromRandomCursor::create(ctx(), 5, 10), idsUpTo(5));
+                ASSERT_EQUALS(5U, out.size());
+                double last = 0;
+                for (size_t i = 0; i < out.size(); i++) {
+                    double key = out[i][DocumentSourceSample::randValName].getDouble();
+                    ASSERT_GREATER_THAN(key, last);
+                    ASSERT_LESS_THAN(key, 1.0);
+                    last = key;
+                }
+            }
+        };
+
+        /** A random cursor which keeps repeating the same document is given up on. */
+        class FromRandomCursorTooManyDuplicates : public Base {
+        public:
+            void run() {
+                BSONArrayBuilder input;
+                for (int i = 0; i < 200; i++) {
+                    input << BSON("_id" << 1);
+                }
+                ASSERT_THROWS(runStage(DocumentSourceSampleFromRandomCursor::create(ctx(), 2, 100),
+                                        input.arr().jsonString(Strict, 0, true)),
+                              UserException);
+            }
+        };
+    } // namespace DocumentSourceSample
+
     namespace DocumentSourceMatch {
         using mongo::DocumentSourceMatch;
 
@@ -1923,6 +2407,7 @@ namespace DocumentSourceTests {
             add<DocumentSourceGroup::SingleDocument>();
             add<DocumentSourceGroup::TwoValuesSingleKey>();
             add<DocumentSourceGroup::TwoValuesTwoKeys>();
+            add<DocumentSourceGroup::ManyKeys>();
             add<DocumentSourceGroup::FourValuesTwoKeys>();
             add<DocumentSourceGroup::FourValuesTwoKeysTwoAccumulators>();
             add<DocumentSourceGroup::GroupNullUndefinedIds>();
@@ -1932,6 +2417,10 @@ namespace DocumentSourceTests {
             add<DocumentSourceGroup::Dependencies>();
             add<DocumentSourceGroup::StringConstantIdAndAccumulatorExpressions>();
             add<DocumentSourceGroup::ArrayConstantAccumulatorExpression>();
+            add<DocumentSourceGroup::StreamingFieldPath>();
+            add<DocumentSourceGroup::StreamingCompoundId>();
+            add<DocumentSourceGroup::StreamingEmptyInput>();
+            add<DocumentSourceGroup::IdFieldPaths>();
 
             add<DocumentSourceProject::Inclusion>();
             add<DocumentSourceProject::Optimize>();
@@ -1983,6 +2472,22 @@ namespace DocumentSourceTests {
 
             add<DocumentSourceGeoNear::LimitCoalesce>();
 
+            add<DocumentSourceLookup::HashJoin>();
+            add<DocumentSourceLookup::IndexNestedLoopJoin>();
+            add<DocumentSourceLookup::SortMergeJoin>();
+            add<DocumentSourceLookup::MemoryLimitWithoutDisk>();
+            add<DocumentSourceLookup::BadSpec>();
+
+            add<DocumentSourceSample::SampleSmallerThanInput>();
+            add<DocumentSourceSample::SampleLargerThanInput>();
+            add<DocumentSourceSample::Uniform>();
+            add<DocumentSourceSample::ShardAndMerge>();
+            add<DocumentSourceSample::MemoryLimit>();
+            add<DocumentSourceSample::BadSpec>();
+            add<DocumentSourceSample::FromRandomCursor>();
+            add<DocumentSourceSample::FromRandomCursorInShard>();
+            add<DocumentSourceSample::FromRandomCursorTooManyDuplicates>();
+
             add<DocumentSourceMatch::RedactSafePortion>();
             add<DocumentSourceMatch::Coalesce>();
         }
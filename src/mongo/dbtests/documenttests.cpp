@@ -299,6 +299,32 @@ namespace DocumentTests {
             }
         };
 
+        /** A Document outgrowing the fields reserved for it, and its clones. */
+        class GrowReservedFields {
+        public:
+            void run() {
+                MutableDocument md(2);
+                for (int i = 0; i < 100; ++i) {
+                    md.addField(std::string(str::stream() << "field" << i), Value(i));
+                }
+                Document document = md.freeze();
+                ASSERT_EQUALS(100U, document.size());
+                ASSERT_EQUALS(Value(57), document["field57"]);
+
+                // Grow a clone past its copied buffer, leaving the original unchanged.
+                MutableDocument grown(document.clone());
+                grown.addField("long", Value(std::string(1000, 'x')));
+                ASSERT_EQUALS(101U, grown.peek().size());
+                ASSERT_EQUALS(Value(57), grown.peek()["field57"]);
+                ASSERT_EQUALS(100U, document.size());
+
+                // A clone of an empty Document can grow too.
+                MutableDocument empty(Document().clone());
+                empty.addField("a", Value(1));
+                ASSERT_EQUALS(DOC("a" << 1), empty.freeze());
+            }
+        };
+
         /** FieldIterator for an empty Document. */
         class FieldIteratorEmpty {
         public:
@@ -1424,6 +1450,7 @@ namespace DocumentTests {
             add<Document::CompareNamedNull>();
             add<Document::Clone>();
             add<Document::CloneMultipleFields>();
+            add<Document::GrowReservedFields>();
             add<Document::FieldIteratorEmpty>();
             add<Document::FieldIteratorSingle>();
             add<Document::FieldIteratorMultiple>();
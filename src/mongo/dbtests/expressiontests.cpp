@@ -569,6 +569,122 @@ namespace ExpressionTests {
         
     } // namespace CoerceToBool
 
+    namespace CommonSubexpression {
+
+        /** Collects the distinct ExpressionCommonSubexpressions in a tree. */
+        class SharedCollector : public Expression::ChildVisitor {
+        public:
+            virtual void visit(intrusive_ptr<Expression>* child) {
+                if (dynamic_cast<ExpressionCommonSubexpression*>(child->get())) {
+                    shared.insert(child->get());
+                }
+                (*child)->visitChildren(this);
+            }
+            set<const Expression*> shared;
+        };
+
+        /**
+         * Checks that eliminating common subexpressions from spec() shares the expected number of
+         * subexpressions, leaves the serialized form alone, and evaluates as the original
+         * expression does for a series of documents evaluated with the same Variables.
+         */
+        class Base {
+        public:
+            virtual ~Base() {}
+            void run() {
+                BSONObj specObject = BSON("" << spec());
+                VariablesIdGenerator idGenerator;
+                VariablesParseState vps(&idGenerator);
+                intrusive_ptr<Expression> original =
+                    Expression::parseOperand(specObject.firstElement(), vps)->optimize();
+                intrusive_ptr<Expression> expression =
+                    Expression::parseOperand(specObject.firstElement(), vps)->optimize();
+
+                vector<intrusive_ptr<Expression>*> roots(1, &expression);
+                Expression::eliminateCommonSubexpressions(roots);
+
+                SharedCollector collector;
+                collector.visit(&expression);
+                ASSERT_EQUALS(expectedShared(), collector.shared.size());
+                ASSERT_EQUALS(expressionToBson(original), expressionToBson(expression));
+
+                Variables vars(idGenerator.getIdCount());
+                Variables originalVars(idGenerator.getIdCount());
+                BSONObj docs[] = { fromjson("{a:1, b:2, c:{d:3}}"),
+                                   fromjson("{a:5, b:7, c:{d:11}}"),
+                                   fromjson("{a:5, b:7}") };
+                for (size_t i = 0; i < sizeof(docs) / sizeof(docs[0]); i++) {
+                    vars.setRoot(fromBson(docs[i]));
+                    originalVars.setRoot(fromBson(docs[i]));
+                    ASSERT_EQUALS(toBson(original->evaluate(&originalVars)),
+                                  toBson(expression->evaluate(&vars)));
+                }
+            }
+        protected:
+            virtual BSONObj spec() = 0;
+            virtual size_t expectedShared() = 0;
+        };
+
+        /** A repeated subexpression is shared. */
+        class Repeated : public Base {
+            BSONObj spec() {
+                return fromjson("{x:{$add:['$a',1]}, y:{$multiply:[{$add:['$a',1]},2]}}");
+            }
+            size_t expectedShared() { return 1; }
+        };
+
+        /** A repeated dotted field path is shared. */
+        class DottedFieldPath : public Base {
+            BSONObj spec() { return fromjson("{x:'$c.d', y:{$add:['$c.d',1]}}"); }
+            size_t expectedShared() { return 1; }
+        };
+
+        /** Top level fields and constants are not worth sharing. */
+        class FieldAndConstant : public Base {
+            BSONObj spec() { return fromjson("{x:'$a', y:{$add:['$a','$b']}, z:'$b'}"); }
+            size_t expectedShared() { return 0; }
+        };
+
+        /** Only the outermost of nested repeated subexpressions is shared. */
+        class Nested : public Base {
+            BSONObj spec() {
+                return fromjson("{x:{$add:[{$multiply:['$a','$b']},1]},"
+                                " y:{$add:[{$multiply:['$a','$b']},1]}}");
+            }
+            size_t expectedShared() { return 1; }
+        };
+
+        /** An inner repeat is shared too when it also appears outside the outer one. */
+        class NestedAndOutside : public Base {
+            BSONObj spec() {
+                return fromjson("{x:{$add:[{$multiply:['$a','$b']},1]},"
+                                " y:{$add:[{$multiply:['$a','$b']},1]},"
+                                " z:{$multiply:['$a','$b']}}");
+            }
+            size_t expectedShared() { return 2; }
+        };
+
+        /** Subexpressions of $let variables are distinct even when spelled the same. */
+        class LetVariables : public Base {
+            BSONObj spec() {
+                return fromjson("{x:{$let:{vars:{v:'$a'}, in:{$add:['$$v',1]}}},"
+                                " y:{$let:{vars:{v:'$b'}, in:{$add:['$$v',1]}}}}");
+            }
+            size_t expectedShared() { return 0; }
+        };
+
+        /** Subexpressions depending only on ROOT are shared inside $map. */
+        class InsideMap : public Base {
+            BSONObj spec() {
+                return fromjson("{x:{$map:{input:{$const:[1,2]}, as:'e',"
+                                "          in:{$add:['$$e',{$multiply:['$a','$b']}]}}},"
+                                " y:{$multiply:['$a','$b']}}");
+            }
+            size_t expectedShared() { return 1; }
+        };
+
+    } // namespace CommonSubexpression
+
     namespace Compare {
 
         class OptimizeBase {
@@ -3494,6 +3610,14 @@ namespace ExpressionTests {
             add<CoerceToBool::AddToBsonObj>();
             add<CoerceToBool::AddToBsonArray>();
 
+            add<CommonSubexpression::Repeated>();
+            add<CommonSubexpression::DottedFieldPath>();
+            add<CommonSubexpression::FieldAndConstant>();
+            add<CommonSubexpression::Nested>();
+            add<CommonSubexpression::NestedAndOutside>();
+            add<CommonSubexpression::LetVariables>();
+            add<CommonSubexpression::InsideMap>();
+
             add<Compare::EqLt>();
             add<Compare::EqEq>();
             add<Compare::EqGt>();
@@ -33,8 +33,10 @@
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/md5.hpp"
 
 using mongo::DBDirectClient;
+using mongo::GridFile;
 using mongo::GridFS;
 using mongo::MsgAssertionException;
 
@@ -57,6 +59,41 @@ namespace {
         virtual ~SetChunkSizeTest() {}
     };
 
+    class StoreAndWriteTest {
+    public:
+        virtual void run() {
+            OperationContextImpl txn;
+            DBDirectClient client(&txn);
+            DBDirectClient other(&txn);
+            client.dropDatabase("gridtest");
+
+            string data;
+            for ( int i = 0; i < 1000; i++ )
+                data += char( 'a' + i % 26 );
+
+            // Spread the chunks over two connections.
+            GridFS grid(client, "gridtest");
+            grid.setChunkSize( 7 );
+            grid.addUploadConnection( other );
+            BSONObj file = grid.storeFile( data.c_str(), data.size(), "letters" );
+            ASSERT_EQUALS( md5simpledigest( data ), file["md5"].str() );
+            ASSERT_EQUALS( 143U, client.count( "gridtest.fs.chunks" ) );
+
+            GridFile gridFile = grid.findFile( "letters" );
+            ASSERT( gridFile.exists() );
+            stringstream out;
+            ASSERT_EQUALS( data.size(), gridFile.write( out ) );
+            ASSERT_EQUALS( data, out.str() );
+
+            // A missing chunk is noticed.
+            client.remove( "gridtest.fs.chunks", BSON( "n" << 5 ) );
+            stringstream missing;
+            ASSERT_THROWS( gridFile.write( missing ), UserException );
+        }
+
+        virtual ~StoreAndWriteTest() {}
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "gridfs" ) {
@@ -64,6 +101,7 @@ namespace {
 
         void setupTests() {
             add< SetChunkSizeTest >();
+            add< StoreAndWriteTest >();
         }
     };
 
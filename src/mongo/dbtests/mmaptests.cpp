@@ -32,6 +32,7 @@
 
 #include <boost/filesystem/operations.hpp>
 
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/concurrency/lock_state.h"
 #include "mongo/db/global_environment_experiment.h"
 #include "mongo/db/storage/mmap_v1/data_file.h"
@@ -172,6 +173,44 @@ namespace MMapTests {
         }
     };
 
+    class FlushChunks {
+        const string fn;
+    public:
+        FlushChunks() :
+            fn((boost::filesystem::path(storageGlobalParams.dbpath) / "testchunks.map").string())
+        { }
+        ~FlushChunks() {
+            try { boost::filesystem::remove(fn); }
+            catch(...) { }
+        }
+        void run() {
+            const unsigned long long chunk = 1024 * 1024;
+
+            OwnedPointerVector<MongoFile::Flushable> before;
+            MongoFile::prepareFlushChunks(chunk, &before);
+
+            OwnedPointerVector<MongoFile::Flushable> chunks;
+            {
+                MemoryMappedFile f;
+                char* p = static_cast<char*>(f.create(fn, 3 * chunk + 4096, true));
+                verify(p);
+                strcpy(p + 3 * chunk, "hello");
+
+                // The file's last 4KB get a piece of their own.
+                MongoFile::prepareFlushChunks(chunk, &chunks);
+                ASSERT_EQUALS(before.size() + 4, chunks.size());
+                for (size_t i = 0; i < chunks.size(); i++) {
+                    chunks[i]->flush();
+                }
+            }
+
+            // Pieces of a closed file are skipped.
+            for (size_t i = 0; i < chunks.size(); i++) {
+                chunks[i]->flush();
+            }
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "mmap" ) {}
@@ -181,6 +220,7 @@ namespace MMapTests {
 
             add< LeakTest >();
             add< ExtentSizing >();
+            add< FlushChunks >();
         }
     };
 
@@ -54,12 +54,14 @@
 #include "mongo/db/storage_options.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/dbtests/framework_options.h"
+#include "mongo/platform/unordered_map.h"
 #include "mongo/util/allocator.h"
 #include "mongo/util/checksum.h"
 #include "mongo/util/compress.h"
 #include "mongo/util/fail_point.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mmap.h"
+#include "mongo/util/string_map.h"
 #include "mongo/util/timer.h"
 #include "mongo/util/version.h"
 #include "mongo/util/version_reporting.h"
@@ -431,6 +433,82 @@ namespace PerfTests {
         }
     };
 
+    /**
+     * Keys shaped like the namespaces which catalog lookups use.
+     */
+    const vector<string>& mapKeys() {
+        static vector<string> keys;
+        if ( keys.empty() ) {
+            for ( int i = 0; i < 100 * 1000; i++ ) {
+                keys.push_back( str::stream() << "db" << i % 97 << ".collection" << i );
+            }
+        }
+        return keys;
+    }
+
+    template< typename Map >
+    class MapInsert : public NonDurTest {
+    public:
+        MapInsert() : _next( 0 ) { }
+        void timed() {
+            const vector<string>& keys = mapKeys();
+            for ( int i = 0; i < 64; i++ ) {
+                if ( _next == keys.size() ) {
+                    _map = Map();
+                    _next = 0;
+                }
+                _map[keys[_next++]] = i;
+            }
+        }
+    private:
+        Map _map;
+        size_t _next;
+    };
+
+    template< typename Map >
+    class MapFind : public NonDurTest {
+    public:
+        MapFind() : _next( 0 ) { }
+        void prep() {
+            const vector<string>& keys = mapKeys();
+            for ( size_t i = 0; i < keys.size(); i += 2 ) {
+                _map[keys[i]] = i;
+            }
+        }
+        void timed() {
+            // half of the lookups miss
+            const vector<string>& keys = mapKeys();
+            for ( int i = 0; i < 64; i++ ) {
+                if ( _map.find( keys[_next] ) != _map.end() )
+                    dontOptimizeOutHopefully++;
+                _next = ( _next + 1 ) % keys.size();
+            }
+        }
+    private:
+        Map _map;
+        size_t _next;
+    };
+
+    class StringMapInsert : public MapInsert< StringMap<int> > {
+    public:
+        string name() { return "StringMap-insert"; }
+    };
+
+    class UnorderedMapInsert : public MapInsert< unordered_map<string, int> > {
+    public:
+        string name() { return "unordered_map-insert"; }
+    };
+
+    class StringMapFind : public MapFind< StringMap<int> > {
+    public:
+        string name() { return "StringMap-find"; }
+    };
+
+    class UnorderedMapFind : public MapFind< unordered_map<string, int> > {
+    public:
+        string name() { return "unordered_map-find"; }
+    };
+
     class BSONGetFields1 : public NonDurTest {
     public:
         int n;
@@ -467,6 +545,37 @@ namespace PerfTests {
         }
     };
 
+    /** parses a typical mongoimport line */
+    class FromJson : public NonDurTest {
+    public:
+        int n;
+        string json;
+        string name() { return "fromjson"; }
+        FromJson() {
+            n = 0;
+            json = "{ \"_id\" : 12345, \"name\" : \"a string a string\", \"x\" : 3, "
+                   "\"yaaaaaa\" : 3.00009, \"q\" : false, \"tags\" : [ \"red\", \"green\" ], "
+                   "\"obj\" : { \"city\" : \"New York\", \"zip\" : 10001, \"note\" : "
+                   "\"a longer string with an \\\"escape\\\" in the middle of it\" } }";
+        }
+        void timed() {
+            n += fromjson(json).objsize();
+        }
+    };
+
+    /** writes the same document back out, as REST and mongoexport do */
+    class ToJson : public FromJson {
+    public:
+        bo b;
+        string name() { return "jsonString"; }
+        ToJson() {
+            b = fromjson(json);
+        }
+        void timed() {
+            n += b.jsonString().size();
+        }
+    };
+
     class KeyTest : public B {
     public:
         KeyV1Owned a,b,c;
@@ -1488,6 +1597,12 @@ namespace PerfTests {
                 add< BSONIter >();
                 add< BSONGetFields1 >();
                 add< BSONGetFields2 >();
+                add< StringMapInsert >();
+                add< UnorderedMapInsert >();
+                add< StringMapFind >();
+                add< UnorderedMapFind >();
+                add< FromJson >();
+                add< ToJson >();
                 //add< TaskQueueTest >();
                 add< InsertDup >();
                 add< Insert1 >();
@@ -34,6 +34,7 @@
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/field_path.h"
 #include "mongo/db/pipeline/pipeline.h"
+#include "mongo/db/pipeline/pipeline_result_cache.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/dbtests/dbtests.h"
 
@@ -234,6 +235,149 @@ namespace PipelineTests {
     namespace Optimizations {
         using namespace mongo;
 
+        namespace Local {
+            class Base {
+            public:
+                // These return json arrays of pipeline operators
+                virtual string inputPipeJson() = 0;
+                virtual string outputPipeJson() = 0;
+
+                BSONObj pipelineFromJsonArray(const string& array) {
+                    return fromjson("{pipeline: " + array + "}");
+                }
+                virtual void run() {
+                    const BSONObj inputBson = pipelineFromJsonArray(inputPipeJson());
+                    const BSONObj outputPipeExpected = pipelineFromJsonArray(outputPipeJson());
+
+                    intrusive_ptr<ExpressionContext> ctx =
+                        new ExpressionContext(&_opCtx, NamespaceString("a.collection"));
+                    string errmsg;
+                    intrusive_ptr<Pipeline> outputPipe =
+                        Pipeline::parseCommand(errmsg, inputBson, ctx);
+                    ASSERT_EQUALS(errmsg, "");
+                    ASSERT(outputPipe != NULL);
+
+                    ASSERT_EQUALS(outputPipe->serialize()["pipeline"],
+                                  Value(outputPipeExpected["pipeline"]));
+                }
+
+                virtual ~Base() {};
+
+            private:
+                OperationContextImpl _opCtx;
+            };
+
+            namespace moveMatchBeforeProjectAndUnwind {
+
+                class IncludedField : public Base {
+                    string inputPipeJson() {
+                        return "[{$project: {a: 1, b: 1}}, {$match: {a: 1}}]";
+                    }
+                    string outputPipeJson() {
+                        return "[{$match: {a: 1}}, {$project: {a: true, b: true}}]";
+                    }
+                };
+
+                class ComputedField : public Base {
+                    string inputPipeJson() {
+                        return "[{$project: {a: '$b'}}, {$match: {a: 1}}]";
+                    }
+                    string outputPipeJson() {
+                        return "[{$project: {a: '$b'}}, {$match: {a: 1}}]";
+                    }
+                };
+
+                class NestedInclusion : public Base {
+                    string inputPipeJson() {
+                        return "[{$project: {'a.b': 1}}, {$match: {'a.b': 1}}]";
+                    }
+                    string outputPipeJson() {
+                        return "[{$project: {a: {b: true}}}, {$match: {'a.b': 1}}]";
+                    }
+                };
+
+                class ExcludedId : public Base {
+                    string inputPipeJson() {
+                        return "[{$project: {_id: 0, a: 1}}, {$match: {_id: 1}}]";
+                    }
+                    string outputPipeJson() {
+                        return "[{$project: {_id: false, a: true}}, {$match: {_id: 1}}]";
+                    }
+                };
+
+                class SplitAroundProject : public Base {
+                    string inputPipeJson() {
+                        return "[{$project: {a: 1, c: {$add: ['$b', 1]}}},"
+                               " {$match: {a: 1, c: 2}}]";
+                    }
+                    string outputPipeJson() {
+                        return "[{$match: {a: 1}},"
+                               " {$project: {a: true, c: {$add: ['$b', {$const: 1}]}}},"
+                               " {$match: {c: 2}}]";
+                    }
+                };
+
+                class OtherFieldThanUnwound : public Base {
+                    string inputPipeJson() {
+                        return "[{$unwind: '$a'}, {$match: {b: 1}}]";
+                    }
+                    string outputPipeJson() {
+                        return "[{$match: {b: 1}}, {$unwind: '$a'}]";
+                    }
+                };
+
+                class SplitAroundUnwind : public Base {
+                    string inputPipeJson() {
+                        return "[{$unwind: '$a.b'}, {$match: {'a.b.c': 1, a: 2, 'a.c': 3, x: 4}}]";
+                    }
+                    string outputPipeJson() {
+                        return "[{$match: {$and: [{'a.c': 3}, {x: 4}]}}, {$unwind: '$a.b'},"
+                               " {$match: {$and: [{'a.b.c': 1}, {a: 2}]}}]";
+                    }
+                };
+
+                class OrReadingUnwound : public Base {
+                    string inputPipeJson() {
+                        return "[{$unwind: '$a'}, {$match: {$or: [{a: 1}, {b: 1}]}}]";
+                    }
+                    string outputPipeJson() {
+                        return "[{$unwind: '$a'}, {$match: {$or: [{a: 1}, {b: 1}]}}]";
+                    }
+                };
+
+                class AcrossSeveralStages : public Base {
+                    string inputPipeJson() {
+                        return "[{$project: {a: 1, b: 1}}, {$unwind: '$b'}, {$sort: {b: 1}},"
+                               " {$match: {a: 1}}]";
+                    }
+                    string outputPipeJson() {
+                        return "[{$match: {a: 1}}, {$project: {a: true, b: true}},"
+                               " {$unwind: '$b'}, {$sort: {b: 1}}]";
+                    }
+                };
+
+                class NotAcrossLimit : public Base {
+                    string inputPipeJson() {
+                        return "[{$unwind: '$a'}, {$limit: 5}, {$match: {b: 1}}]";
+                    }
+                    string outputPipeJson() {
+                        return "[{$unwind: '$a'}, {$limit: 5}, {$match: {b: 1}}]";
+                    }
+                };
+
+                class CoalescesMovedMatches : public Base {
+                    string inputPipeJson() {
+                        return "[{$unwind: '$a'}, {$match: {b: 1}}, {$unwind: '$c'},"
+                               " {$match: {b: 2, c: 1}}]";
+                    }
+                    string outputPipeJson() {
+                        return "[{$match: {$and: [{b: 1}, {b: 2}]}}, {$unwind: '$a'},"
+                               " {$unwind: '$c'}, {$match: {c: 1}}]";
+                    }
+                };
+            } // namespace moveMatchBeforeProjectAndUnwind
+        } // namespace Local
+
         namespace Sharded {
             class Base {
             public:
@@ -396,6 +540,143 @@ namespace PipelineTests {
         } // namespace Sharded
     } // namespace Optimizations
 
+    namespace ResultCache {
+
+        /** Sets the cache knobs for the duration of a test. */
+        class KnobGuard {
+        public:
+            KnobGuard(int sizeBytes, int maxStalenessSecs)
+                : _sizeBytes(aggregationResultCacheSizeBytes)
+                , _maxStalenessSecs(aggregationResultCacheMaxStalenessSecs) {
+                aggregationResultCacheSizeBytes = sizeBytes;
+                aggregationResultCacheMaxStalenessSecs = maxStalenessSecs;
+            }
+            ~KnobGuard() {
+                aggregationResultCacheSizeBytes = _sizeBytes;
+                aggregationResultCacheMaxStalenessSecs = _maxStalenessSecs;
+            }
+        private:
+            const int _sizeBytes;
+            const int _maxStalenessSecs;
+        };
+
+        const char ns[] = "unittests.pipeline_result_cache";
+
+        BSONObj results(int n) {
+            BSONArrayBuilder array;
+            for (int i = 0; i < n; i++) {
+                array << BSON("_id" << i);
+            }
+            return array.arr();
+        }
+
+        /** Results are returned while the collection is unchanged, and not after. */
+        class CurrentGeneration {
+        public:
+            void run() {
+                KnobGuard guard(1024 * 1024, 0);
+                PipelineResultCache cache;
+                BSONObj out;
+                ASSERT(!cache.lookup(ns, BSON("a" << 1), 1, 0, &out));
+
+                cache.insert(ns, BSON("a" << 1), 1, 0, results(3));
+                ASSERT(cache.lookup(ns, BSON("a" << 1), 1, 1000, &out));
+                ASSERT_EQUALS(results(3), out);
+
+                ASSERT(!cache.lookup(ns, BSON("a" << 2), 1, 1000, &out));
+                ASSERT(!cache.lookup("unittests.other", BSON("a" << 1), 1, 1000, &out));
+
+                // A changed collection drops the entry.
+                ASSERT(!cache.lookup(ns, BSON("a" << 1), 2, 1000, &out));
+                ASSERT(!cache.lookup(ns, BSON("a" << 1), 1, 1000, &out));
+                ASSERT_EQUALS(0U, cache.bytesUsed());
+            }
+        };
+
+        /** Results of a changed collection are returned until they are too old. */
+        class MaxStaleness {
+        public:
+            void run() {
+                KnobGuard guard(1024 * 1024, 10);
+                PipelineResultCache cache;
+                BSONObj out;
+                cache.insert(ns, BSON("a" << 1), 1, 5000, results(3));
+                ASSERT(cache.lookup(ns, BSON("a" << 1), 2, 15000, &out));
+                ASSERT_EQUALS(results(3), out);
+                ASSERT(!cache.lookup(ns, BSON("a" << 1), 2, 15001, &out));
+            }
+        };
+
+        /** Inserting replaces an existing entry. */
+        class Replace {
+        public:
+            void run() {
+                KnobGuard guard(1024 * 1024, 0);
+                PipelineResultCache cache;
+                BSONObj out;
+                cache.insert(ns, BSON("a" << 1), 1, 0, results(3));
+                const size_t bytesUsed = cache.bytesUsed();
+                cache.insert(ns, BSON("a" << 1), 2, 0, results(3));
+                ASSERT_EQUALS(bytesUsed, cache.bytesUsed());
+                ASSERT(cache.lookup(ns, BSON("a" << 1), 2, 0, &out));
+            }
+        };
+
+        /** The least recently used entries are evicted to stay within the size limit. */
+        class Eviction {
+        public:
+            void run() {
+                KnobGuard guard(1024 * 1024, 0);
+                PipelineResultCache cache;
+                cache.insert(ns, BSON("a" << 1), 1, 0, results(10));
+                const int entryBytes = cache.bytesUsed();
+
+                aggregationResultCacheSizeBytes = 2 * entryBytes;
+                cache.insert(ns, BSON("a" << 2), 1, 0, results(10));
+                BSONObj out;
+                ASSERT(cache.lookup(ns, BSON("a" << 1), 1, 0, &out));
+                cache.insert(ns, BSON("a" << 3), 1, 0, results(10));
+
+                ASSERT(cache.lookup(ns, BSON("a" << 1), 1, 0, &out));
+                ASSERT(!cache.lookup(ns, BSON("a" << 2), 1, 0, &out));
+                ASSERT(cache.lookup(ns, BSON("a" << 3), 1, 0, &out));
+                ASSERT_LESS_THAN_OR_EQUALS(cache.bytesUsed(), 2U * entryBytes);
+
+                // Results larger than the whole cache are not kept.
+                cache.insert(ns, BSON("a" << 4), 1, 0, results(100));
+                ASSERT(!cache.lookup(ns, BSON("a" << 4), 1, 0, &out));
+                ASSERT(cache.lookup(ns, BSON("a" << 3), 1, 0, &out));
+
+                cache.clear();
+                ASSERT_EQUALS(0U, cache.bytesUsed());
+            }
+        };
+
+        /** Pipelines with random results or side effects are not cached. */
+        class CanCacheResults {
+        public:
+            void run() {
+                ASSERT(canCache("[{$match: {a: 1}}, {$group: {_id: '$a'}}, {$sort: {_id: 1}}]"));
+                ASSERT(!canCache("[{$match: {a: 1}}, {$out: 'other'}]"));
+                ASSERT(!canCache("[{$sample: {size: 3}}]"));
+                ASSERT(!canCache("[{$lookup: {from: 'other', localField: 'a',"
+                                 "            foreignField: 'b', as: 'c'}}]"));
+            }
+        private:
+            bool canCache(const string& pipeline) {
+                OperationContextImpl txn;
+                intrusive_ptr<ExpressionContext> ctx =
+                    new ExpressionContext(&txn, NamespaceString(ns));
+                string errmsg;
+                intrusive_ptr<Pipeline> parsed = Pipeline::parseCommand(
+                        errmsg, fromjson("{aggregate: 'c', pipeline: " + pipeline + "}"), ctx);
+                ASSERT(parsed);
+                return parsed->canCacheResults();
+            }
+        };
+
+    } // namespace ResultCache
+
     class All : public Suite {
     public:
         All() : Suite( "pipeline" ) {
@@ -421,6 +702,18 @@ namespace PipelineTests {
             add<FieldPath::Tail>();
             add<FieldPath::TailThreeFields>();
 
+            add<Optimizations::Local::moveMatchBeforeProjectAndUnwind::IncludedField>();
+            add<Optimizations::Local::moveMatchBeforeProjectAndUnwind::ComputedField>();
+            add<Optimizations::Local::moveMatchBeforeProjectAndUnwind::NestedInclusion>();
+            add<Optimizations::Local::moveMatchBeforeProjectAndUnwind::ExcludedId>();
+            add<Optimizations::Local::moveMatchBeforeProjectAndUnwind::SplitAroundProject>();
+            add<Optimizations::Local::moveMatchBeforeProjectAndUnwind::OtherFieldThanUnwound>();
+            add<Optimizations::Local::moveMatchBeforeProjectAndUnwind::SplitAroundUnwind>();
+            add<Optimizations::Local::moveMatchBeforeProjectAndUnwind::OrReadingUnwound>();
+            add<Optimizations::Local::moveMatchBeforeProjectAndUnwind::AcrossSeveralStages>();
+            add<Optimizations::Local::moveMatchBeforeProjectAndUnwind::NotAcrossLimit>();
+            add<Optimizations::Local::moveMatchBeforeProjectAndUnwind::CoalescesMovedMatches>();
+
             add<Optimizations::Sharded::Empty>();
             add<Optimizations::Sharded::moveFinalUnwindFromShardsToMerger::OneUnwind>();
             add<Optimizations::Sharded::moveFinalUnwindFromShardsToMerger::TwoUnwind>();
@@ -432,6 +725,12 @@ namespace PipelineTests {
             add<Optimizations::Sharded::limitFieldsSentFromShardsToMerger::NothingNeeded>();
             add<Optimizations::Sharded::limitFieldsSentFromShardsToMerger::JustNeedsMetadata>();
             add<Optimizations::Sharded::limitFieldsSentFromShardsToMerger::ShardAlreadyExhaustive>();
+
+            add<ResultCache::CurrentGeneration>();
+            add<ResultCache::MaxStaleness>();
+            add<ResultCache::Replace>();
+            add<ResultCache::Eviction>();
+            add<ResultCache::CanCacheResults>();
         }
     };
 
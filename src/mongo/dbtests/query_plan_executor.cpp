@@ -300,6 +300,44 @@ namespace QueryPlanExecutor {
         }
     };
 
+    /**
+     * A fetch over an index scan is executed in batches. Deleting a document which has already
+     * been read into the executor's batch must not leave the executor pointing at the deleted
+     * record.
+     */
+    class BatchedResultsInvalidated : public PlanExecutorBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(&_txn, ns());
+            for (int i = 0; i < 10; ++i) {
+                insert(BSON("_id" << i << "a" << i));
+            }
+            BSONObj indexSpec = BSON("a" << 1);
+            addIndex(indexSpec);
+
+            scoped_ptr<PlanExecutor> exec(makeIndexScanExec(ctx.ctx(), indexSpec, 0, 9));
+            registerExec(exec.get());
+
+            // The first call reads the rest of the index range into the batch.
+            BSONObj objOut;
+            ASSERT_EQUALS(PlanExecutor::ADVANCED, exec->getNext(&objOut, NULL));
+            ASSERT_EQUALS(0, objOut["a"].numberInt());
+
+            exec->saveState();
+            remove(BSON("_id" << 5));
+            ASSERT(exec->restoreState(&_txn));
+
+            // The deleted document was fetched before it went away, so it is still returned.
+            for (int i = 1; i < 10; ++i) {
+                ASSERT_EQUALS(PlanExecutor::ADVANCED, exec->getNext(&objOut, NULL));
+                ASSERT_EQUALS(i, objOut["a"].numberInt());
+            }
+            ASSERT_EQUALS(PlanExecutor::IS_EOF, exec->getNext(&objOut, NULL));
+
+            deregisterExec(exec.get());
+        }
+    };
+
     class SnapshotBase : public PlanExecutorBase {
     protected:
         void setupCollection() {
@@ -502,6 +540,7 @@ namespace QueryPlanExecutor {
             add<DropCollScan>();
             add<DropIndexScan>();
             add<DropIndexScanAgg>();
+            add<BatchedResultsInvalidated>();
             add<SnapshotControl>();
             add<SnapshotTest>();
             add<ClientCursor::Invalidate>();
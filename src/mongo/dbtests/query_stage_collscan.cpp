@@ -372,6 +372,65 @@ namespace QueryStageCollectionScan {
         }
     };
 
+    //
+    // Borrow the documents from the storage engine.  The scan only moves past each one when it
+    // is next worked or saved, so an invalidation during a yield still skips the right object.
+    //
+    class QueryStageCollscanBorrowRecords : public QueryStageCollectionScanBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(&_txn, ns());
+            Collection* coll = ctx.getCollection();
+
+            vector<RecordId> locs;
+            getLocs(coll, CollectionScanParams::FORWARD, &locs);
+
+            CollectionScanParams params;
+            params.collection = coll;
+            params.direction = CollectionScanParams::FORWARD;
+            params.tailable = false;
+            params.borrowRecords = true;
+
+            WorkingSet ws;
+            scoped_ptr<CollectionScan> scan(new CollectionScan(&_txn, params, &ws, NULL));
+            ASSERT_FALSE(scan->supportsBatch());
+
+            int count = 0;
+            while (count < 10) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState state = scan->work(&id);
+                if (PlanStage::ADVANCED == state) {
+                    WorkingSetMember* member = ws.get(id);
+                    ASSERT_EQUALS(locs[count], member->loc);
+                    ASSERT_EQUALS(count, member->obj["foo"].numberInt());
+                    ++count;
+                }
+            }
+
+            // Remove locs[count].
+            scan->saveState();
+            scan->invalidate(&_txn, locs[count], INVALIDATION_DELETION);
+            remove(coll->docFor(&_txn, locs[count]));
+            scan->restoreState(&_txn);
+
+            // Skip over locs[count].
+            ++count;
+
+            while (!scan->isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState state = scan->work(&id);
+                if (PlanStage::ADVANCED == state) {
+                    WorkingSetMember* member = ws.get(id);
+                    ASSERT_EQUALS(locs[count], member->loc);
+                    ASSERT_EQUALS(count, member->obj["foo"].numberInt());
+                    ++count;
+                }
+            }
+
+            ASSERT_EQUALS(numObj(), count);
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "QueryStageCollectionScan" ) {}
@@ -386,6 +445,7 @@ namespace QueryStageCollectionScan {
             add<QueryStageCollscanObjectsInOrderBackward>();
             add<QueryStageCollscanInvalidateUpcomingObject>();
             add<QueryStageCollscanInvalidateUpcomingObjectBackward>();
+            add<QueryStageCollscanBorrowRecords>();
         }
     };
 
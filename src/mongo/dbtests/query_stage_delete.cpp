@@ -36,6 +36,7 @@
 #include "mongo/db/exec/collection_scan.h"
 #include "mongo/db/exec/delete.h"
 #include "mongo/db/operation_context_impl.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/dbtests/dbtests.h"
 
 namespace QueryStageDelete {
@@ -46,7 +47,8 @@ namespace QueryStageDelete {
 
     class QueryStageDeleteBase {
     public:
-        QueryStageDeleteBase() : _client(&_txn) {
+        QueryStageDeleteBase() : _client(&_txn),
+                                 _oldBatchSize(internalQueryExecDeleteBatchSize) {
             Client::WriteContext ctx(&_txn, ns());
 
             for (size_t i = 0; i < numObj(); ++i) {
@@ -57,6 +59,7 @@ namespace QueryStageDelete {
         }
 
         virtual ~QueryStageDeleteBase() {
+            internalQueryExecDeleteBatchSize = _oldBatchSize;
             Client::WriteContext ctx(&_txn, ns());
             _client.dropCollection(ns());
         }
@@ -96,6 +99,7 @@ namespace QueryStageDelete {
 
     private:
         DBDirectClient _client;
+        int _oldBatchSize;
     };
 
     //
@@ -110,6 +114,9 @@ namespace QueryStageDelete {
 
             Collection* coll = ctx.getCollection();
 
+            // Delete exactly up to the target document in the first batch.
+            internalQueryExecDeleteBatchSize = 10;
+
             // Get the RecordIds that would be returned by an in-order scan.
             vector<RecordId> locs;
             getLocs(coll, CollectionScanParams::FORWARD, &locs);
@@ -159,6 +166,92 @@ namespace QueryStageDelete {
         }
     };
 
+    //
+    // A multi-delete removes up to internalQueryExecDeleteBatchSize documents per call to work(),
+    // all in one storage transaction.
+    //
+    class QueryStageDeleteBatched : public QueryStageDeleteBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(&_txn, ns());
+
+            Collection* coll = ctx.getCollection();
+
+            const size_t batchSize = 7;
+            internalQueryExecDeleteBatchSize = batchSize;
+
+            CollectionScanParams collScanParams;
+            collScanParams.collection = coll;
+            collScanParams.direction = CollectionScanParams::FORWARD;
+            collScanParams.tailable = false;
+
+            DeleteStageParams deleteStageParams;
+            deleteStageParams.isMulti = true;
+            deleteStageParams.shouldCallLogOp = false;
+
+            WorkingSet ws;
+            DeleteStage deleteStage(&_txn, deleteStageParams, &ws, coll,
+                                    new CollectionScan(&_txn, collScanParams, &ws, NULL));
+
+            const DeleteStats* stats =
+                static_cast<const DeleteStats*>(deleteStage.getSpecificStats());
+
+            size_t lastDeleted = 0;
+            while (!deleteStage.isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState state = deleteStage.work(&id);
+                invariant(PlanStage::NEED_TIME == state || PlanStage::IS_EOF == state);
+
+                // Every call deletes either nothing or a full batch, except at the end of the
+                // collection.
+                size_t deleted = stats->docsDeleted - lastDeleted;
+                if (deleted != 0 && stats->docsDeleted != numObj()) {
+                    ASSERT_EQUALS(batchSize, deleted);
+                }
+                lastDeleted = stats->docsDeleted;
+            }
+
+            ASSERT_EQUALS(numObj(), stats->docsDeleted);
+            ASSERT_EQUALS(0U, coll->numRecords(&_txn));
+        }
+    };
+
+    //
+    // A single delete removes one document no matter the batch size.
+    //
+    class QueryStageDeleteJustOne : public QueryStageDeleteBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(&_txn, ns());
+
+            Collection* coll = ctx.getCollection();
+
+            CollectionScanParams collScanParams;
+            collScanParams.collection = coll;
+            collScanParams.direction = CollectionScanParams::FORWARD;
+            collScanParams.tailable = false;
+
+            DeleteStageParams deleteStageParams;
+            deleteStageParams.isMulti = false;
+            deleteStageParams.shouldCallLogOp = false;
+
+            WorkingSet ws;
+            DeleteStage deleteStage(&_txn, deleteStageParams, &ws, coll,
+                                    new CollectionScan(&_txn, collScanParams, &ws, NULL));
+
+            while (!deleteStage.isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState state = deleteStage.work(&id);
+                invariant(PlanStage::NEED_TIME == state || PlanStage::IS_EOF == state);
+            }
+
+            const DeleteStats* stats =
+                static_cast<const DeleteStats*>(deleteStage.getSpecificStats());
+            ASSERT_EQUALS(1U, stats->docsDeleted);
+            ASSERT_EQUALS(static_cast<uint64_t>(numObj() - 1), coll->numRecords(&_txn));
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite("query_stage_delete") {}
@@ -166,6 +259,8 @@ namespace QueryStageDelete {
         void setupTests() {
             // Stage-specific tests below.
             add<QueryStageDeleteInvalidateUpcomingObject>();
+            add<QueryStageDeleteBatched>();
+            add<QueryStageDeleteJustOne>();
         }
     };
 
@@ -0,0 +1,231 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file tests db/exec/oplog_scan.cpp.
+ */
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/dbdirectclient.h"
+#include "mongo/db/exec/oplog_scan.h"
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/dbtests/dbtests.h"
+
+namespace QueryStageOplogScan {
+
+    class QueryStageOplogScanBase {
+    public:
+        QueryStageOplogScanBase() : _client(&_txn), _lastTs(0) {
+            Client::WriteContext ctx(&_txn, ns());
+            _client.dropCollection(ns());
+        }
+
+        virtual ~QueryStageOplogScanBase() {
+            Client::WriteContext ctx(&_txn, ns());
+            _client.dropCollection(ns());
+        }
+
+        void insert(const BSONObj& obj) {
+            Client::WriteContext ctx(&_txn, ns());
+            _client.insert(ns(), obj);
+        }
+
+        /**
+         * Inserts 'n' entries of an oplog for namespace 'entryNs', with op 'op'.
+         */
+        void insertEntries(int n, const char* op, const char* entryNs) {
+            for (int i = 0; i < n; ++i) {
+                BSONObjBuilder bob;
+                bob.appendTimestamp("ts", ++_lastTs);
+                bob.append("op", op);
+                bob.append("ns", entryNs);
+                bob.append("o", BSON("x" << i));
+                insert(bob.obj());
+            }
+        }
+
+        /**
+         * Scans the collection with 'filterObj', returning the number of results and setting
+         * '*stats' to the stats of the stage.
+         */
+        int countResults(const BSONObj& filterObj, OplogScanStats* stats) {
+            AutoGetCollectionForRead ctx(&_txn, ns());
+
+            CollectionScanParams params;
+            params.collection = ctx.getCollection();
+            params.direction = CollectionScanParams::FORWARD;
+
+            StatusWithMatchExpression swme = MatchExpressionParser::parse(filterObj);
+            verify(swme.isOK());
+            auto_ptr<MatchExpression> filterExpr(swme.getValue());
+
+            WorkingSet ws;
+            OplogScan scan(&_txn, params, &ws, filterExpr.get());
+
+            int count = 0;
+            while (!scan.isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState state = scan.work(&id);
+                if (PlanStage::ADVANCED == state) {
+                    ++count;
+                    ws.free(id);
+                }
+            }
+
+            *stats = *static_cast<const OplogScanStats*>(scan.getSpecificStats());
+            return count;
+        }
+
+        static const char* ns() { return "unittests.QueryStageOplogScan"; }
+
+    protected:
+        OperationContextImpl _txn;
+
+    private:
+        DBDirectClient _client;
+        unsigned long long _lastTs;
+    };
+
+    //
+    // Entries for other namespaces are skipped without being matched.
+    //
+    class QueryStageOplogScanSkipsOtherNamespaces : public QueryStageOplogScanBase {
+    public:
+        void run() {
+            insertEntries(20, "i", "test.a");
+            insertEntries(5, "i", "test.b");
+            insertEntries(20, "u", "test.a");
+
+            OplogScanStats stats;
+            ASSERT_EQUALS(5, countResults(BSON("ns" << "test.b"), &stats));
+            ASSERT_EQUALS(40U, stats.docsSkipped);
+            ASSERT_EQUALS(5U, stats.docsTested);
+        }
+    };
+
+    //
+    // $in over strings and several fields are pre-filtered, but every other predicate still
+    // applies.
+    //
+    class QueryStageOplogScanInAndOtherPredicates : public QueryStageOplogScanBase {
+    public:
+        void run() {
+            insertEntries(10, "i", "test.a");
+            insertEntries(10, "d", "test.a");
+            insertEntries(10, "u", "test.a");
+            insertEntries(10, "u", "test.b");
+
+            OplogScanStats stats;
+            ASSERT_EQUALS(20, countResults(fromjson("{ns: 'test.a', op: {$in: ['i', 'u']}}"),
+                                           &stats));
+            ASSERT_EQUALS(20U, stats.docsSkipped);
+
+            ASSERT_EQUALS(2, countResults(fromjson("{ns: 'test.a', op: 'u', 'o.x': {$lt: 2}}"),
+                                          &stats));
+            ASSERT_EQUALS(30U, stats.docsSkipped);
+            ASSERT_EQUALS(10U, stats.docsTested);
+        }
+    };
+
+    //
+    // Values the raw check can't judge are left to the full filter.
+    //
+    class QueryStageOplogScanNonStringValues : public QueryStageOplogScanBase {
+    public:
+        void run() {
+            insertEntries(3, "i", "test.a");
+            insert(fromjson("{op: 'i', ns: ['test.b']}"));
+            insert(fromjson("{op: 'i'}"));
+
+            OplogScanStats stats;
+            ASSERT_EQUALS(1, countResults(BSON("ns" << "test.b"), &stats));
+            ASSERT_EQUALS(4U, stats.docsSkipped);
+
+            // A $in containing null matches a missing field, so nothing can be skipped.
+            ASSERT_EQUALS(1, countResults(fromjson("{ns: {$in: ['test.c', null]}}"), &stats));
+            ASSERT_EQUALS(0U, stats.docsSkipped);
+            ASSERT_EQUALS(5U, stats.docsTested);
+        }
+    };
+
+    //
+    // A long run of skipped entries is broken up so that the executor can yield.
+    //
+    class QueryStageOplogScanBoundedSkipsPerWork : public QueryStageOplogScanBase {
+    public:
+        void run() {
+            const int numEntries = OplogScan::kMaxSkippedPerWork + 10;
+            insertEntries(numEntries, "i", "test.a");
+            insertEntries(1, "i", "test.b");
+
+            AutoGetCollectionForRead ctx(&_txn, ns());
+            CollectionScanParams params;
+            params.collection = ctx.getCollection();
+
+            BSONObj filterObj = BSON("ns" << "test.b");
+            StatusWithMatchExpression swme = MatchExpressionParser::parse(filterObj);
+            verify(swme.isOK());
+            auto_ptr<MatchExpression> filterExpr(swme.getValue());
+
+            WorkingSet ws;
+            OplogScan scan(&_txn, params, &ws, filterExpr.get());
+            WorkingSetID id = WorkingSet::INVALID_ID;
+
+            // Initialization.
+            ASSERT_EQUALS(PlanStage::NEED_TIME, scan.work(&id));
+
+            ASSERT_EQUALS(PlanStage::NEED_TIME, scan.work(&id));
+            const OplogScanStats* stats =
+                static_cast<const OplogScanStats*>(scan.getSpecificStats());
+            ASSERT_EQUALS(OplogScan::kMaxSkippedPerWork, stats->docsSkipped);
+
+            ASSERT_EQUALS(PlanStage::ADVANCED, scan.work(&id));
+            ASSERT_EQUALS(static_cast<size_t>(numEntries), stats->docsSkipped);
+            ASSERT_EQUALS(PlanStage::IS_EOF, scan.work(&id));
+        }
+    };
+
+    class All : public Suite {
+    public:
+        All() : Suite( "QueryStageOplogScan" ) {}
+
+        void setupTests() {
+            add<QueryStageOplogScanSkipsOtherNamespaces>();
+            add<QueryStageOplogScanInAndOtherPredicates>();
+            add<QueryStageOplogScanNonStringValues>();
+            add<QueryStageOplogScanBoundedSkipsPerWork>();
+        }
+    };
+
+    SuiteInstance<All> all;
+
+}
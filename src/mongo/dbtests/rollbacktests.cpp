@@ -509,6 +509,64 @@ namespace {
         }
     };
 
+    template<bool rollback>
+    class InsertDocuments {
+    public:
+        void run() {
+            string ns = "unittests.rollback_insert_documents";
+            OperationContextImpl txn;
+            NamespaceString nss( ns );
+            dropDatabase( &txn, nss );
+            createCollection( &txn, nss );
+
+            ScopedTransaction transaction(&txn, MODE_IX);
+            Lock::DBLock dbIXLock( txn.lockState(), nss.db(), MODE_IX );
+            Lock::CollectionLock collXLock( txn.lockState(), ns, MODE_X );
+
+            Client::Context ctx( &txn, ns );
+            Collection* coll = ctx.db()->getCollection( &txn, ns );
+            IndexCatalog* catalog = coll->getIndexCatalog();
+
+            string idxName = "a";
+            BSONObj spec = BSON( "ns" << ns << "key" << BSON( "a" << 1 ) << "name" << idxName );
+            {
+                WriteUnitOfWork uow( &txn );
+                ASSERT_OK( catalog->createIndexOnEmptyCollection( &txn, spec ) );
+                uow.commit();
+            }
+
+            std::vector<BSONObj> docs;
+            docs.push_back( BSON( "_id" << 1 << "a" << 1 ) );
+            docs.push_back( BSON( "_id" << 2 << "a" << 2 ) );
+            docs.push_back( BSON( "_id" << 3 << "a" << 3 ) );
+
+            // END SETUP / START TEST
+
+            {
+                WriteUnitOfWork uow( &txn );
+                std::vector<RecordId> locs;
+                ASSERT_OK( coll->insertDocuments( &txn, docs, false, &locs ) );
+                ASSERT_EQUALS( docs.size(), locs.size() );
+                for ( size_t i = 0; i < docs.size(); i++ ) {
+                    ASSERT_EQUALS( docs[i], coll->docFor( &txn, locs[i] ) );
+                }
+                if ( !rollback ) {
+                    uow.commit();
+                }
+            }
+
+            if ( rollback ) {
+                assertEmpty( &txn, nss );
+                ASSERT_EQUALS( 0u, getNumIndexEntries( &txn, nss, idxName ) );
+                ASSERT_EQUALS( 0u, getNumIndexEntries( &txn, nss, "_id_" ) );
+            }
+            else {
+                ASSERT_EQUALS( docs.size(), getNumIndexEntries( &txn, nss, idxName ) );
+                ASSERT_EQUALS( docs.size(), getNumIndexEntries( &txn, nss, "_id_" ) );
+            }
+        }
+    };
+
     template<bool rollback>
     class DropIndex {
     public:
@@ -751,6 +809,7 @@ namespace {
             addAll< CreateDropCollection >();
             addAll< TruncateCollection >();
             addAll< CreateIndex >();
+            addAll< InsertDocuments >();
             addAll< DropIndex >();
             addAll< CreateDropIndex >();
             addAll< SetIndexHead >();
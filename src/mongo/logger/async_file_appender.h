@@ -0,0 +1,94 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/tss.hpp>
+#include <sstream>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status.h"
+#include "mongo/logger/appender.h"
+#include "mongo/logger/async_log_queue.h"
+#include "mongo/logger/encoder.h"
+#include "mongo/logger/log_severity.h"
+
+namespace mongo {
+namespace logger {
+
+    /**
+     * Appender that formats events on the logging thread and hands them to an AsyncLogQueue,
+     * which writes them out in the background.
+     *
+     * Each logging thread formats into its own reused stream.  Severe events flush the queue
+     * before append() returns, since the process may be about to abort.
+     */
+    template <typename Event>
+    class AsyncFileAppender : public Appender<Event> {
+        MONGO_DISALLOW_COPYING(AsyncFileAppender);
+
+    public:
+        typedef Encoder<Event> EventEncoder;
+
+        /**
+         * Constructs an appender that owns "encoder", but not "queue."  Caller must keep
+         * "queue" in scope at least as long as the constructed appender.
+         */
+        AsyncFileAppender(EventEncoder* encoder, AsyncLogQueue* queue) :
+            _encoder(encoder),
+            _queue(queue) {
+        }
+
+        virtual Status append(const Event& event) {
+            std::ostringstream* buffer = _buffers.get();
+            if (!buffer) {
+                buffer = new std::ostringstream;
+                _buffers.reset(buffer);
+            }
+            buffer->str(std::string());
+            _encoder->encode(event, *buffer);
+
+            std::string message = buffer->str();
+            _queue->push(&message);
+
+            if (event.getSeverity() >= LogSeverity::Severe()) {
+                _queue->flush();
+            }
+            return Status::OK();
+        }
+
+    private:
+        boost::scoped_ptr<EventEncoder> _encoder;
+        AsyncLogQueue* _queue;
+        boost::thread_specific_ptr<std::ostringstream> _buffers;
+    };
+
+}  // namespace logger
+}  // namespace mongo
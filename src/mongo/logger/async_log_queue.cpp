@@ -0,0 +1,229 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/logger/async_log_queue.h"
+
+#include <set>
+
+#include "mongo/logger/message_event.h"
+#include "mongo/logger/message_event_utf8_encoder.h"
+#include "mongo/logger/rotatable_file_writer.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+namespace logger {
+
+namespace {
+    // Every live AsyncLogQueue, for flushAll().
+    boost::mutex queuesMutex;
+    std::set<AsyncLogQueue*> queues;
+
+    uint64_t roundUpToPowerOfTwo(size_t n) {
+        uint64_t result = 1;
+        while (result < n) {
+            result <<= 1;
+        }
+        return result;
+    }
+} // namespace
+
+    AsyncLogQueue::AsyncLogQueue(RotatableFileWriter* writer,
+                                 size_t capacity,
+                                 OverflowPolicy policy)
+        : _writer(writer)
+        , _policy(policy)
+        , _mask(roundUpToPowerOfTwo(capacity) - 1)
+        , _slots(new Slot[_mask + 1])
+        , _head(0)
+        , _droppedReported(0)
+        , _written(0)
+        , _shutdown(false) {
+
+        for (uint64_t i = 0; i <= _mask; i++) {
+            _slots[i].sequence.store(i);
+        }
+
+        _thread = boost::thread(&AsyncLogQueue::_run, this);
+
+        boost::lock_guard<boost::mutex> lk(queuesMutex);
+        queues.insert(this);
+    }
+
+    AsyncLogQueue::~AsyncLogQueue() {
+        {
+            boost::lock_guard<boost::mutex> lk(queuesMutex);
+            queues.erase(this);
+        }
+        {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            _shutdown = true;
+            _wakeWriter.notify_one();
+        }
+        _thread.join();
+    }
+
+    void AsyncLogQueue::flushAll() {
+        boost::lock_guard<boost::mutex> lk(queuesMutex);
+        for (std::set<AsyncLogQueue*>::const_iterator it = queues.begin();
+                it != queues.end(); ++it) {
+            (*it)->flush();
+        }
+    }
+
+    bool AsyncLogQueue::_tryPush(std::string* message) {
+        uint64_t position = _tail.load();
+        while (true) {
+            Slot& slot = _slots[position & _mask];
+            const int64_t lag = static_cast<int64_t>(slot.sequence.load() - position);
+            if (lag < 0) {
+                // The slot still holds the message from one lap ago.
+                return false;
+            }
+            if (lag > 0) {
+                // Another producer claimed this position first.
+                position = _tail.load();
+                continue;
+            }
+
+            const uint64_t claimed = _tail.compareAndSwap(position, position + 1);
+            if (claimed == position) {
+                slot.message.swap(*message);
+                slot.sequence.store(position + 1);
+                return true;
+            }
+            position = claimed;
+        }
+    }
+
+    void AsyncLogQueue::push(std::string* message) {
+        while (!_tryPush(message)) {
+            if (_policy == kDropWhenFull) {
+                _dropped.fetchAndAdd(1);
+                return;
+            }
+
+            boost::unique_lock<boost::mutex> lk(_mutex);
+            _wakeWriter.notify_one();
+            _progress.timed_wait(lk, boost::posix_time::milliseconds(10));
+        }
+
+        // The writer thread sets _writerSleeping before checking the queue one last time, so
+        // either it sees this message or this sees that it has to be woken.
+        if (_writerSleeping.load()) {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            _wakeWriter.notify_one();
+        }
+    }
+
+    void AsyncLogQueue::flush() {
+        const uint64_t target = _tail.load();
+        boost::unique_lock<boost::mutex> lk(_mutex);
+        while (_written < target) {
+            _wakeWriter.notify_one();
+            _progress.timed_wait(lk, boost::posix_time::milliseconds(100));
+        }
+    }
+
+    bool AsyncLogQueue::_headPublished() const {
+        return _slots[_head & _mask].sequence.load() == _head + 1;
+    }
+
+    void AsyncLogQueue::_drain() {
+        if (!_headPublished() && _dropped.load() == _droppedReported) {
+            return;
+        }
+
+        RotatableFileWriter::Use useWriter(_writer);
+        // Messages are discarded while the file can't be written, as they are when appending
+        // synchronously.
+        const bool writable = useWriter.status().isOK();
+        std::string message;
+
+        // Stop after one lap so that flush() and blocked producers hear of progress.
+        for (uint64_t count = 0; count <= _mask && _headPublished(); count++) {
+            Slot& slot = _slots[_head & _mask];
+            message.swap(slot.message);
+            slot.sequence.store(_head + _mask + 1);
+            _head++;
+
+            if (writable) {
+                useWriter.stream() << message;
+            }
+        }
+
+        const uint64_t dropped = _dropped.load();
+        if (dropped != _droppedReported) {
+            if (writable) {
+                const std::string notice = mongoutils::str::stream() << (dropped - _droppedReported)
+                    << " log messages were dropped because the log queue was full";
+                MessageEventDetailsEncoder().encode(
+                        MessageEventEphemeral(jsTime(), LogSeverity::Warning(), "asyncLogWriter",
+                                              notice),
+                        useWriter.stream());
+            }
+            _droppedReported = dropped;
+        }
+
+        if (writable) {
+            useWriter.stream().flush();
+        }
+    }
+
+    void AsyncLogQueue::_run() {
+        setThreadName("asyncLogWriter");
+
+        boost::unique_lock<boost::mutex> lk(_mutex);
+        while (true) {
+            lk.unlock();
+            _drain();
+            lk.lock();
+
+            _written = _head;
+            _progress.notify_all();
+
+            if (_headPublished()) {
+                continue;
+            }
+            if (_shutdown) {
+                break;
+            }
+
+            _writerSleeping.store(1);
+            if (!_headPublished()) {
+                _wakeWriter.timed_wait(lk, boost::posix_time::seconds(1));
+            }
+            _writerSleeping.store(0);
+        }
+    }
+
+}  // namespace logger
+}  // namespace mongo
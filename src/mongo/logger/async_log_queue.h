@@ -0,0 +1,139 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/scoped_array.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/cstdint.h"
+
+namespace mongo {
+namespace logger {
+
+    class RotatableFileWriter;
+
+    /**
+     * Bounded queue of formatted log messages, which a background thread writes to a
+     * RotatableFileWriter, so that threads which log do not wait on the file.
+     *
+     * push() is lock-free.  A producer claims a slot with a compare-and-swap on the tail position
+     * and publishes its message by advancing that slot's sequence number; it only takes the mutex
+     * to wake the writer thread when that thread is asleep.  When the queue is full the
+     * OverflowPolicy decides whether push() waits for room or drops the message.  Dropped
+     * messages are counted, and the writer thread notes in the log how many were dropped.
+     */
+    class AsyncLogQueue {
+        MONGO_DISALLOW_COPYING(AsyncLogQueue);
+    public:
+        enum OverflowPolicy {
+            kBlockWhenFull,
+            kDropWhenFull
+        };
+
+        /**
+         * Starts a writer thread for "writer", which must outlive the queue.  "capacity" is the
+         * number of messages the queue holds, rounded up to a power of two.
+         */
+        AsyncLogQueue(RotatableFileWriter* writer, size_t capacity, OverflowPolicy policy);
+
+        /**
+         * Writes out the queued messages and stops the writer thread.  No thread may call push()
+         * once destruction has begun.
+         */
+        ~AsyncLogQueue();
+
+        /**
+         * Queues the contents of "message" for writing, leaving "message" with unspecified
+         * contents.  The message should end in a newline.
+         */
+        void push(std::string* message);
+
+        /**
+         * Returns once every message pushed before the call has been written and the file
+         * flushed.  Must not be called by the writer thread.
+         */
+        void flush();
+
+        /**
+         * Returns the number of messages dropped because the queue was full.
+         */
+        uint64_t getDroppedCount() const { return _dropped.load(); }
+
+        /**
+         * Flushes every AsyncLogQueue in the process.  Called before the process exits and
+         * before log files are rotated.
+         */
+        static void flushAll();
+
+    private:
+        struct Slot {
+            // Equal to the position a producer may claim this slot for, or that position plus
+            // one once the producer has published its message.
+            AtomicUInt64 sequence;
+            std::string message;
+        };
+
+        bool _tryPush(std::string* message);
+
+        /** Whether the message at _head has been published.  Writer thread only. */
+        bool _headPublished() const;
+
+        /** Writes out the published messages at the head of the queue. */
+        void _drain();
+
+        void _run();
+
+        RotatableFileWriter* const _writer;
+        const OverflowPolicy _policy;
+        const uint64_t _mask;
+        boost::scoped_array<Slot> _slots;
+
+        AtomicUInt64 _tail; // next position for producers to claim
+        uint64_t _head; // next position for the writer thread to read; writer thread only
+        AtomicUInt64 _dropped;
+        uint64_t _droppedReported; // writer thread only
+        AtomicUInt32 _writerSleeping;
+
+        boost::mutex _mutex;
+        boost::condition_variable _wakeWriter;
+        // Notified when the writer thread has written out everything before _written.
+        boost::condition_variable _progress;
+        uint64_t _written; // guarded by _mutex
+        bool _shutdown; // guarded by _mutex
+
+        boost::thread _thread;
+    };
+
+}  // namespace logger
+}  // namespace mongo
@@ -0,0 +1,146 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <boost/thread/thread.hpp>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "mongo/logger/async_log_queue.h"
+#include "mongo/logger/rotatable_file_writer.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+    using namespace mongo;
+    using namespace mongo::logger;
+
+    const std::string logFileName("LogTest_AsyncLogQueue.txt");
+
+    class AsyncLogQueueTest : public mongo::unittest::Test {
+    public:
+        AsyncLogQueueTest() {
+            unlink(logFileName.c_str());
+            RotatableFileWriter::Use writerUse(&_writer);
+            ASSERT_OK(writerUse.setFileName(logFileName, false));
+        }
+
+        virtual ~AsyncLogQueueTest() {
+            unlink(logFileName.c_str());
+        }
+
+    protected:
+        std::vector<std::string> readLines() {
+            std::vector<std::string> lines;
+            std::ifstream ifs(logFileName.c_str());
+            std::string line;
+            while (std::getline(ifs, line)) {
+                lines.push_back(line);
+            }
+            return lines;
+        }
+
+        RotatableFileWriter _writer;
+    };
+
+    void pushMessages(AsyncLogQueue* queue, int thread, int count) {
+        for (int i = 0; i < count; i++) {
+            std::ostringstream os;
+            os << thread << ' ' << i << '\n';
+            std::string message = os.str();
+            queue->push(&message);
+        }
+    }
+
+    TEST_F(AsyncLogQueueTest, FlushWritesEverythingPushed) {
+        AsyncLogQueue queue(&_writer, 16, AsyncLogQueue::kBlockWhenFull);
+        pushMessages(&queue, 0, 3);
+        queue.flush();
+
+        std::vector<std::string> lines = readLines();
+        ASSERT_EQUALS(3U, lines.size());
+        ASSERT_EQUALS("0 0", lines[0]);
+        ASSERT_EQUALS("0 1", lines[1]);
+        ASSERT_EQUALS("0 2", lines[2]);
+    }
+
+    TEST_F(AsyncLogQueueTest, DestructorWritesEverythingPushed) {
+        {
+            AsyncLogQueue queue(&_writer, 16, AsyncLogQueue::kBlockWhenFull);
+            pushMessages(&queue, 0, 100);
+        }
+        ASSERT_EQUALS(100U, readLines().size());
+    }
+
+    TEST_F(AsyncLogQueueTest, BlockWhenFullKeepsEveryMessageInOrder) {
+        const int kThreads = 8;
+        const int kMessages = 2000;
+
+        AsyncLogQueue queue(&_writer, 4, AsyncLogQueue::kBlockWhenFull);
+        std::vector<boost::thread*> threads;
+        for (int t = 0; t < kThreads; t++) {
+            threads.push_back(new boost::thread(pushMessages, &queue, t, kMessages));
+        }
+        for (size_t t = 0; t < threads.size(); t++) {
+            threads[t]->join();
+            delete threads[t];
+        }
+        queue.flush();
+        ASSERT_EQUALS(0U, queue.getDroppedCount());
+
+        std::vector<int> next(kThreads, 0);
+        std::vector<std::string> lines = readLines();
+        ASSERT_EQUALS(static_cast<size_t>(kThreads * kMessages), lines.size());
+        for (size_t i = 0; i < lines.size(); i++) {
+            std::istringstream is(lines[i]);
+            int thread;
+            int message;
+            is >> thread >> message;
+            ASSERT_EQUALS(next[thread], message);
+            next[thread]++;
+        }
+    }
+
+    TEST_F(AsyncLogQueueTest, DropWhenFullCountsDroppedMessages) {
+        AsyncLogQueue queue(&_writer, 4, AsyncLogQueue::kDropWhenFull);
+        {
+            // The writer thread can't take messages off the queue while the file is in use.
+            RotatableFileWriter::Use writerUse(&_writer);
+            pushMessages(&queue, 0, 10);
+        }
+        queue.flush();
+        ASSERT_EQUALS(6U, queue.getDroppedCount());
+
+        std::vector<std::string> lines = readLines();
+        ASSERT_EQUALS(5U, lines.size());
+        ASSERT_EQUALS("0 3", lines[3]);
+        ASSERT_NOT_EQUALS(std::string::npos, lines[4].find("6 log messages were dropped"));
+    }
+
+}  // namespace
@@ -32,9 +32,12 @@
 
 #include "mongo/s/balance.h"
 
+#include <boost/thread/thread.hpp>
+
 #include "mongo/base/owned_pointer_map.h"
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/write_concern.h"
 #include "mongo/db/write_concern_options.h"
 #include "mongo/s/chunk.h"
@@ -51,6 +54,7 @@
 #include "mongo/s/type_mongos.h"
 #include "mongo/s/type_settings.h"
 #include "mongo/s/type_tags.h"
+#include "mongo/stdx/functional.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
 #include "mongo/util/timer.h"
@@ -60,6 +64,14 @@ namespace mongo {
 
     MONGO_FP_DECLARE(skipBalanceRound);
 
+    // Number of chunk migrations a balancing round runs at once, each between a different pair
+    // of shards.  1 moves the chunks one after another.
+    MONGO_EXPORT_SERVER_PARAMETER(balancerMaxConcurrentMigrations, int, 1);
+
+    // When true, the balancer evens out each untagged collection's data size and the shards'
+    // operation rates instead of chunk counts.  Costs a collStats per shard and collection.
+    MONGO_EXPORT_SERVER_PARAMETER(balancerUseDataSizeAndLoad, bool, false);
+
     Balancer balancer;
 
     Balancer::Balancer() : _balancedLastTime(0), _policy( new BalancerPolicy() ) {}
@@ -67,79 +79,152 @@ namespace mongo {
     Balancer::~Balancer() {
     }
 
-    int Balancer::_moveChunks(const vector<CandidateChunkPtr>* candidateChunks,
+    bool Balancer::_moveChunk(const CandidateChunk& chunkInfo,
                               const WriteConcernOptions* writeConcern,
                               bool waitForDelete)
     {
-        int movedCount = 0;
-
-        for ( vector<CandidateChunkPtr>::const_iterator it = candidateChunks->begin(); it != candidateChunks->end(); ++it ) {
-            const CandidateChunk& chunkInfo = *it->get();
+        // Changes to metadata, borked metadata, and connectivity problems should cause us to
+        // abort this chunk move, but shouldn't cause us to abort the entire round of chunks.
+        // TODO: Handle all these things more cleanly, since they're expected problems
+        try {
 
-            // Changes to metadata, borked metadata, and connectivity problems should cause us to
-            // abort this chunk move, but shouldn't cause us to abort the entire round of chunks.
-            // TODO: Handle all these things more cleanly, since they're expected problems
-            try {
+            DBConfigPtr cfg = grid.getDBConfig( chunkInfo.ns );
+            verify( cfg );
 
-                DBConfigPtr cfg = grid.getDBConfig( chunkInfo.ns );
-                verify( cfg );
+            // NOTE: We purposely do not reload metadata here, since _doBalanceRound already
+            // tried to do so once.
+            ChunkManagerPtr cm = cfg->getChunkManager( chunkInfo.ns );
+            verify( cm );
 
-                // NOTE: We purposely do not reload metadata here, since _doBalanceRound already
-                // tried to do so once.
-                ChunkManagerPtr cm = cfg->getChunkManager( chunkInfo.ns );
+            ChunkPtr c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+            if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
+                // likely a split happened somewhere
+                cm = cfg->getChunkManager( chunkInfo.ns , true /* reload */);
                 verify( cm );
 
-                ChunkPtr c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+                c = cm->findIntersectingChunk( chunkInfo.chunk.min );
                 if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
-                    // likely a split happened somewhere
-                    cm = cfg->getChunkManager( chunkInfo.ns , true /* reload */);
-                    verify( cm );
-
-                    c = cm->findIntersectingChunk( chunkInfo.chunk.min );
-                    if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
-                        log() << "chunk mismatch after reload, ignoring will retry issue " << chunkInfo.chunk.toString() << endl;
-                        continue;
-                    }
+                    log() << "chunk mismatch after reload, ignoring will retry issue " << chunkInfo.chunk.toString() << endl;
+                    return false;
                 }
+            }
 
-                BSONObj res;
-                if (c->moveAndCommit(Shard::make(chunkInfo.to),
-                                     Chunk::MaxChunkSize,
-                                     writeConcern,
-                                     waitForDelete,
-                                     0, /* maxTimeMS */
-                                     res)) {
-                    movedCount++;
-                    continue;
+            BSONObj res;
+            if (c->moveAndCommit(Shard::make(chunkInfo.to),
+                                 Chunk::MaxChunkSize,
+                                 writeConcern,
+                                 waitForDelete,
+                                 0, /* maxTimeMS */
+                                 res)) {
+                return true;
+            }
+
+            // the move requires acquiring the collection metadata's lock, which can fail
+            log() << "balancer move failed: " << res << " from: " << chunkInfo.from << " to: " << chunkInfo.to
+                  << " chunk: " << chunkInfo.chunk << endl;
+
+            if ( res["chunkTooBig"].trueValue() ) {
+                // reload just to be safe
+                cm = cfg->getChunkManager( chunkInfo.ns );
+                verify( cm );
+                c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+
+                log() << "performing a split because migrate failed for size reasons";
+
+                Status status = c->split(Chunk::normal, NULL, NULL);
+                log() << "split results: " << status << endl;
+
+                if ( !status.isOK() ) {
+                    log() << "marking chunk as jumbo: " << c->toString() << endl;
+                    c->markAsJumbo();
+                    // we count it as moved so we do another round right away
+                    return true;
                 }
 
-                // the move requires acquiring the collection metadata's lock, which can fail
-                log() << "balancer move failed: " << res << " from: " << chunkInfo.from << " to: " << chunkInfo.to
-                      << " chunk: " << chunkInfo.chunk << endl;
+            }
+        }
+        catch( const DBException& ex ) {
+            warning() << "could not move chunk " << chunkInfo.chunk.toString()
+                      << ", continuing balancing round" << causedBy( ex ) << endl;
+        }
+
+        return false;
+    }
 
-                if ( res["chunkTooBig"].trueValue() ) {
-                    // reload just to be safe
-                    cm = cfg->getChunkManager( chunkInfo.ns );
-                    verify( cm );
-                    c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+    void Balancer::_moveChunkInWave(const CandidateChunk* chunkInfo,
+                                    const WriteConcernOptions* writeConcern,
+                                    bool waitForDelete,
+                                    int* moved)
+    {
+        try {
+            *moved = _moveChunk(*chunkInfo, writeConcern, waitForDelete) ? 1 : 0;
+        }
+        catch (const std::exception& ex) {
+            warning() << "could not move chunk " << chunkInfo->chunk.toString()
+                      << ", continuing balancing round" << causedBy(ex) << endl;
+        }
+    }
 
-                    log() << "performing a split because migrate failed for size reasons";
+    int Balancer::_moveChunks(const vector<CandidateChunkPtr>* candidateChunks,
+                              const WriteConcernOptions* writeConcern,
+                              bool waitForDelete)
+    {
+        int movedCount = 0;
 
-                    Status status = c->split(Chunk::normal, NULL, NULL);
-                    log() << "split results: " << status << endl;
+        if (balancerMaxConcurrentMigrations <= 1) {
+            for (vector<CandidateChunkPtr>::const_iterator it = candidateChunks->begin();
+                 it != candidateChunks->end(); ++it) {
+                if (_moveChunk(*it->get(), writeConcern, waitForDelete))
+                    movedCount++;
+            }
+            return movedCount;
+        }
 
-                    if ( !status.isOK() ) {
-                        log() << "marking chunk as jumbo: " << c->toString() << endl;
-                        c->markAsJumbo();
-                        // we increment moveCount so we do another round right away
-                        movedCount++;
-                    }
+        // A shard takes part in one migration at a time, as donor or as recipient, so each wave
+        // runs at most one move per shard.  Candidates come one per collection, so the moves of
+        // a wave also never compete for the same collection lock.
+        vector<const CandidateChunk*> pending;
+        for (vector<CandidateChunkPtr>::const_iterator it = candidateChunks->begin();
+             it != candidateChunks->end(); ++it) {
+            pending.push_back(it->get());
+        }
 
+        while (!pending.empty()) {
+            set<string> busyShards;
+            vector<const CandidateChunk*> wave;
+            vector<const CandidateChunk*> deferred;
+            for (size_t i = 0; i < pending.size(); i++) {
+                const CandidateChunk* chunkInfo = pending[i];
+                if (static_cast<int>(wave.size()) < balancerMaxConcurrentMigrations
+                        && !busyShards.count(chunkInfo->from)
+                        && !busyShards.count(chunkInfo->to)) {
+                    busyShards.insert(chunkInfo->from);
+                    busyShards.insert(chunkInfo->to);
+                    wave.push_back(chunkInfo);
+                }
+                else {
+                    deferred.push_back(chunkInfo);
                 }
             }
-            catch( const DBException& ex ) {
-                warning() << "could not move chunk " << chunkInfo.chunk.toString()
-                          << ", continuing balancing round" << causedBy( ex ) << endl;
+            pending.swap(deferred);
+
+            LOG(1) << "balancer moving " << wave.size() << " chunks concurrently, "
+                   << pending.size() << " left this round" << endl;
+
+            vector<int> moved(wave.size(), 0);
+            boost::thread_group movers;
+            for (size_t i = 0; i < wave.size(); i++) {
+                movers.create_thread(stdx::bind(&Balancer::_moveChunkInWave,
+                                                this,
+                                                wave[i],
+                                                writeConcern,
+                                                waitForDelete,
+                                                &moved[i]));
+            }
+            movers.join_all();
+
+            for (size_t i = 0; i < moved.size(); i++) {
+                movedCount += moved[i];
             }
         }
 
@@ -354,6 +439,7 @@ namespace mongo {
         
         ShardInfoMap shardInfo;
         DistributionStatus::populateShardInfoMap(allShards, &shardInfo);
+        _setShardLoads( &shardInfo );
 
         OCCASIONALLY warnOnMultiVersion( shardInfo );
 
@@ -410,6 +496,9 @@ namespace mongo {
             }
 
             DistributionStatus status(shardInfo, shardToChunksMap.map());
+            if ( balancerUseDataSizeAndLoad ) {
+                _setCollectionDataSizes( allShards, ns, &status );
+            }
 
             // load tags
             Status result = clusterCreateIndex(TagsType::ConfigNS,
@@ -495,6 +584,52 @@ namespace mongo {
         }
     }
 
+    void Balancer::_setShardLoads( ShardInfoMap* shardInfo ) {
+        const long long now = curTimeMillis64();
+
+        for ( ShardInfoMap::iterator i = shardInfo->begin(); i != shardInfo->end(); ++i ) {
+            const long long opCount = i->second.getOpCount();
+
+            map<string, pair<long long, long long> >::const_iterator last =
+                _lastOpCounts.find( i->first );
+            if ( last != _lastOpCounts.end() &&
+                 opCount >= last->second.first &&
+                 now > last->second.second ) {
+                i->second.setOpsPerSec( ( opCount - last->second.first ) * 1000.0
+                                        / ( now - last->second.second ) );
+            }
+
+            _lastOpCounts[i->first] = make_pair( opCount, now );
+        }
+    }
+
+    void Balancer::_setCollectionDataSizes( const vector<Shard>& shards,
+                                            const string& ns,
+                                            DistributionStatus* status ) {
+        const NamespaceString nss( ns );
+
+        for ( vector<Shard>::const_iterator i = shards.begin(); i != shards.end(); ++i ) {
+            try {
+                ScopedDbConnection conn( i->getConnString() );
+                BSONObj result;
+                if ( conn->runCommand( nss.db().toString(),
+                                       BSON( "collStats" << nss.coll().toString() ),
+                                       result ) ) {
+                    status->setDataSize( i->getName(), result["size"].numberLong() );
+                }
+                else {
+                    LOG(1) << "could not get size of " << ns << " on " << i->getName()
+                           << ": " << result << endl;
+                }
+                conn.done();
+            }
+            catch ( const DBException& e ) {
+                warning() << "could not get size of " << ns << " on " << i->getName()
+                          << causedBy( e ) << endl;
+            }
+        }
+    }
+
     bool Balancer::_init() {
         try {
 
@@ -75,6 +75,9 @@ namespace mongo {
 
         // decide which chunks to move; owned here.
         scoped_ptr<BalancerPolicy> _policy;
+
+        // each shard's opcounters total and when it was sampled, as of the previous round
+        std::map<std::string, std::pair<long long, long long> > _lastOpCounts;
         
         /**
          * Checks that the balancer can connect to all servers it needs to do its job.
@@ -95,7 +98,40 @@ namespace mongo {
         void _doBalanceRound( DBClientBase& conn, std::vector<CandidateChunkPtr>* candidateChunks );
 
         /**
-         * Issues chunk migration request, one at a time.
+         * Sets each shard's operation rate in 'shardInfo' from the change in its opcounters
+         * since the previous round.  Shards seen for the first time, or restarted since, get 0.
+         */
+        void _setShardLoads( ShardInfoMap* shardInfo );
+
+        /**
+         * Records in 'status' the size of collection 'ns' on each of 'shards', as reported by
+         * collStats.  Shards which cannot be reached are left out.
+         */
+        void _setCollectionDataSizes( const std::vector<Shard>& shards,
+                                      const std::string& ns,
+                                      DistributionStatus* status );
+
+        /**
+         * Moves one candidate chunk, splitting it or marking it jumbo if it is too big to move.
+         *
+         * @return true if the chunk counts as moved, i.e. was moved or marked jumbo
+         */
+        bool _moveChunk(const CandidateChunk& chunkInfo,
+                        const WriteConcernOptions* writeConcern,
+                        bool waitForDelete);
+
+        /**
+         * Body of the threads of a concurrent wave of moves: sets '*moved' to 1 if _moveChunk()
+         * counted the chunk as moved, 0 otherwise.
+         */
+        void _moveChunkInWave(const CandidateChunk* chunkInfo,
+                              const WriteConcernOptions* writeConcern,
+                              bool waitForDelete,
+                              int* moved);
+
+        /**
+         * Issues chunk migration requests, one at a time, or with balancerMaxConcurrentMigrations
+         * above 1, in waves of concurrent moves between disjoint pairs of shards.
          *
          * @param candidateChunks possible chunks to move
          * @param writeConcern detailed write concern. NULL means the default write concern.
@@ -32,6 +32,7 @@
 #include "mongo/platform/basic.h"
 
 #include <algorithm>
+#include <cmath>
 
 #include "mongo/s/balancer_policy.h"
 #include "mongo/s/chunk.h"
@@ -57,6 +58,24 @@ namespace mongo {
         }
     }
 
+    void DistributionStatus::setDataSize( const string& shard, long long bytes ) {
+        _dataSizes[shard] = bytes;
+    }
+
+    bool DistributionStatus::hasDataSizes() const {
+        for ( map<string, long long>::const_iterator i = _dataSizes.begin();
+              i != _dataSizes.end(); ++i ) {
+            if ( i->second > 0 )
+                return true;
+        }
+        return false;
+    }
+
+    long long DistributionStatus::dataSizeInShard( const string& shard ) const {
+        map<string, long long>::const_iterator i = _dataSizes.find( shard );
+        return i == _dataSizes.end() ? 0 : i->second;
+    }
+
     const ShardInfo& DistributionStatus::shardInfo( const string& shard ) const {
         ShardInfoMap::const_iterator i = _shardInfo.find( shard );
         verify( i != _shardInfo.end() );
@@ -238,12 +257,13 @@ namespace mongo {
                 it != allShards.end(); ++it ) {
             const Shard& shard = *it;
             ShardStatus status = shard.getStatus();
-            shardInfo->insert(make_pair(shard.getName(),
-                                        ShardInfo(shard.getMaxSize(),
-                                                  status.mapped(),
-                                                  shard.isDraining(),
-                                                  shard.tags(),
-                                                  status.mongoVersion())));
+            ShardInfo info(shard.getMaxSize(),
+                           status.mapped(),
+                           shard.isDraining(),
+                           shard.tags(),
+                           status.mongoVersion());
+            info.setOpCount(status.opCount());
+            shardInfo->insert(make_pair(shard.getName(), info));
         }
     }
 
@@ -413,6 +433,10 @@ namespace mongo {
 
         // 3) for each tag balance
 
+        if ( distribution.hasDataSizes() && distribution.tags().empty() ) {
+            return _balanceByLoad( ns, distribution );
+        }
+
         int threshold = 8;
         if ( balancedLastTime || distribution.totalChunks() < 20 )
             threshold = 2;
@@ -493,6 +517,114 @@ namespace mongo {
         return NULL;
     }
 
+    namespace {
+        // How much the operation rate counts towards a shard's load, next to its data size.
+        const double kLoadOpsWeight = 0.5;
+
+        // Shards whose loads differ by less than this, as a fraction of the average load, are
+        // left alone.
+        const double kLoadImbalanceThreshold = 0.2;
+    }
+
+    MigrateInfo* BalancerPolicy::_balanceByLoad( const string& ns,
+                                                 const DistributionStatus& distribution ) {
+        const set<string>& shards = distribution.shards();
+
+        double totalBytes = 0;
+        double totalOps = 0;
+        for ( set<string>::const_iterator i = shards.begin(); i != shards.end(); ++i ) {
+            totalBytes += distribution.dataSizeInShard( *i );
+            totalOps += distribution.shardInfo( *i ).getOpsPerSec();
+        }
+
+        const double meanBytes = totalBytes / shards.size();
+        const double meanOps = totalOps / shards.size();
+        const double opsWeight = meanOps > 0 ? kLoadOpsWeight : 0;
+
+        map<string, double> load;
+        for ( set<string>::const_iterator i = shards.begin(); i != shards.end(); ++i ) {
+            load[*i] = ( 1 - opsWeight ) * distribution.dataSizeInShard( *i ) / meanBytes;
+            if ( opsWeight > 0 )
+                load[*i] += opsWeight * distribution.shardInfo( *i ).getOpsPerSec() / meanOps;
+        }
+
+        string bestFrom;
+        string bestTo;
+        const ChunkType* bestChunk = NULL;
+        double bestGainPerByte = 0;
+        double bestGap = 0;
+
+        for ( set<string>::const_iterator d = shards.begin(); d != shards.end(); ++d ) {
+            const string& from = *d;
+            const unsigned numChunks = distribution.numberOfChunksInShard( from );
+            const long long bytes = distribution.dataSizeInShard( from );
+            if ( numChunks == 0 || bytes == 0 )
+                continue;
+
+            const vector<ChunkType*>& chunks = distribution.getChunks( from );
+            const ChunkType* chunk = NULL;
+            for ( unsigned j = 0; j < chunks.size(); j++ ) {
+                if ( !( chunks[j]->isJumboSet() && chunks[j]->getJumbo() ) ) {
+                    chunk = chunks[j];
+                    break;
+                }
+            }
+            if ( !chunk )
+                continue;
+
+            // Cost model: a chunk is taken to hold the shard's average share of the data and of
+            // its operations, and the morsel of load it carries moves along with it.
+            const double chunkBytes = static_cast<double>( bytes ) / numChunks;
+            double moved = ( 1 - opsWeight ) * chunkBytes / meanBytes;
+            if ( opsWeight > 0 ) {
+                moved += opsWeight * distribution.shardInfo( from ).getOpsPerSec() / numChunks
+                         / meanOps;
+            }
+
+            for ( set<string>::const_iterator r = shards.begin(); r != shards.end(); ++r ) {
+                const string& to = *r;
+                if ( to == from )
+                    continue;
+
+                const ShardInfo& toInfo = distribution.shardInfo( to );
+                if ( toInfo.isSizeMaxed() || toInfo.isDraining() )
+                    continue;
+
+                const double gap = load[from] - load[to];
+                if ( gap < kLoadImbalanceThreshold )
+                    continue;
+
+                // A move that overshoots, leaving the receiver just as overloaded, gains nothing.
+                const double gain = gap - fabs( gap - 2 * moved );
+                if ( gain <= 0 )
+                    continue;
+
+                // Between moves that are as cheap for what they gain, as is the case whenever
+                // load follows data, relieve the widest gap first.
+                const double gainPerByte = gain / std::max( chunkBytes, 1.0 );
+                const double tolerance = bestGainPerByte * 1e-9;
+                if ( gainPerByte > bestGainPerByte + tolerance ||
+                     ( gainPerByte >= bestGainPerByte - tolerance && gap > bestGap ) ) {
+                    bestGainPerByte = gainPerByte;
+                    bestGap = gap;
+                    bestFrom = from;
+                    bestTo = to;
+                    bestChunk = chunk;
+                }
+            }
+        }
+
+        if ( !bestChunk ) {
+            LOG(1) << "collection " << ns << " is balanced by data size and load" << endl;
+            return NULL;
+        }
+
+        log() << " ns: " << ns << " going to move " << *bestChunk
+              << " from: " << bestFrom << " (load " << load[bestFrom] << ")"
+              << " to: " << bestTo << " (load " << load[bestTo] << ")" << endl;
+        return new MigrateInfo( ns, bestTo, bestFrom, bestChunk->toBSON() );
+    }
+
 
     ShardInfo::ShardInfo( long long maxSize, long long currSize,
                           bool draining,
@@ -502,13 +634,17 @@ namespace mongo {
           _currSize( currSize ),
           _draining( draining ),
           _tags( tags ),
-          _mongoVersion( mongoVersion ) {
+          _mongoVersion( mongoVersion ),
+          _opCount( 0 ),
+          _opsPerSec( 0 ) {
     }
 
     ShardInfo::ShardInfo()
         : _maxSize( 0 ),
           _currSize( 0 ),
-          _draining( false ) {
+          _draining( false ),
+          _opCount( 0 ),
+          _opsPerSec( 0 ) {
     }
 
     void ShardInfo::addTag( const string& tag ) {
@@ -540,6 +676,7 @@ namespace mongo {
                 ss << *i << ",";
         }
         ss << " version: " << _mongoVersion;
+        ss << " opsPerSec: " << _opsPerSec;
         return ss.str();
     }
 
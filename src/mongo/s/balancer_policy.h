@@ -98,6 +98,14 @@ namespace mongo {
 
         long long getCurrSize() const { return _currSize; }
 
+        /** Operations the shard has served since it started, as of its last serverStatus. */
+        long long getOpCount() const { return _opCount; }
+        void setOpCount( long long opCount ) { _opCount = opCount; }
+
+        /** Operations per second the shard has recently served, 0 if unknown. */
+        double getOpsPerSec() const { return _opsPerSec; }
+        void setOpsPerSec( double opsPerSec ) { _opsPerSec = opsPerSec; }
+
         std::string getMongoVersion() const { return _mongoVersion; }
 
         std::string toString() const;
@@ -108,6 +116,8 @@ namespace mongo {
         bool _draining;
         std::set<std::string> _tags;
         std::string _mongoVersion;
+        long long _opCount;
+        double _opsPerSec;
     };
     
     struct MigrateInfo {
@@ -169,6 +179,18 @@ namespace mongo {
         /** @return all tags we know about, not include "" */
         const std::set<std::string>& tags() const { return _allTags; }
 
+        /**
+         * Records 'bytes' as the size of the collection's data on 'shard'.  Once any shard has
+         * data recorded, BalancerPolicy evens out data size and load rather than chunk counts.
+         */
+        void setDataSize( const std::string& shard, long long bytes );
+
+        /** @return true if setDataSize() recorded any data */
+        bool hasDataSizes() const;
+
+        /** @return the size of the collection's data on this shard, 0 if not recorded */
+        long long dataSizeInShard( const std::string& shard ) const;
+
         /** @return the right tag for chunk, possibly "" */
         std::string getTagForChunk(const ChunkType& chunk) const;
         
@@ -206,6 +228,7 @@ namespace mongo {
         std::map<BSONObj,TagRange> _tagRanges;
         std::set<std::string> _allTags;
         std::set<std::string> _shards;
+        std::map<std::string, long long> _dataSizes;
     };
 
     class BalancerPolicy {
@@ -225,6 +248,17 @@ namespace mongo {
         static MigrateInfo* balance( const std::string& ns,
                                      const DistributionStatus& distribution,
                                      int balancedLastTime );
+
+    private:
+        /**
+         * The balancing step used instead of evening out chunk counts when the distribution has
+         * data sizes and no tags.  Each shard's load is its share of the collection's data and
+         * of the operations served.  Of the moves that narrow the gap between an overloaded
+         * shard and a lighter one, it picks the move that narrows the gap most per byte of data
+         * moved.
+         */
+        static MigrateInfo* _balanceByLoad( const std::string& ns,
+                                            const DistributionStatus& distribution );
     };
 
 
@@ -447,6 +447,72 @@ namespace mongo {
             ASSERT( !m );
         }
 
+        /**
+         * With data sizes recorded, equal chunk counts don't mean balanced: the shard holding
+         * most of the data gives a chunk away.
+         */
+        TEST( BalancerPolicyTests, DataSizeImbalance ) {
+            OwnedShardToChunksMap chunks;
+            addShard( chunks, 4 , false );
+            addShard( chunks, 4 , false );
+            addShard( chunks, 4 , true );
+
+            ShardInfoMap shards;
+            shards["shard0"] = ShardInfo(0, 4, false);
+            shards["shard1"] = ShardInfo(0, 4, false);
+            shards["shard2"] = ShardInfo(0, 4, false);
+
+            DistributionStatus d(shards, chunks.map());
+            d.setDataSize( "shard0", 800 );
+            d.setDataSize( "shard1", 100 );
+            d.setDataSize( "shard2", 300 );
+
+            boost::scoped_ptr<MigrateInfo> m(BalancerPolicy::balance( "ns", d, 0 ));
+            ASSERT( m );
+            ASSERT_EQUALS( "shard0" , m->from );
+            ASSERT_EQUALS( "shard1" , m->to );
+        }
+
+        /**
+         * Even data sizes with one shard serving most of the operations: the busy shard gives a
+         * chunk to the idlest one.  Once data and load are even, nothing moves.
+         */
+        TEST( BalancerPolicyTests, DataSizeAndLoad ) {
+            OwnedShardToChunksMap chunks;
+            addShard( chunks, 4 , false );
+            addShard( chunks, 4 , false );
+            addShard( chunks, 4 , true );
+
+            ShardInfoMap shards;
+            shards["shard0"] = ShardInfo(0, 4, false);
+            shards["shard1"] = ShardInfo(0, 4, false);
+            shards["shard2"] = ShardInfo(0, 4, false);
+            shards["shard0"].setOpsPerSec( 100 );
+            shards["shard1"].setOpsPerSec( 1000 );
+            shards["shard2"].setOpsPerSec( 100 );
+
+            {
+                DistributionStatus d(shards, chunks.map());
+                d.setDataSize( "shard0", 400 );
+                d.setDataSize( "shard1", 400 );
+                d.setDataSize( "shard2", 400 );
+
+                boost::scoped_ptr<MigrateInfo> m(BalancerPolicy::balance( "ns", d, 0 ));
+                ASSERT( m );
+                ASSERT_EQUALS( "shard1" , m->from );
+                ASSERT( m->to == "shard0" || m->to == "shard2" );
+            }
+
+            shards["shard1"].setOpsPerSec( 110 );
+            DistributionStatus d(shards, chunks.map());
+            d.setDataSize( "shard0", 400 );
+            d.setDataSize( "shard1", 420 );
+            d.setDataSize( "shard2", 380 );
+
+            boost::scoped_ptr<MigrateInfo> m(BalancerPolicy::balance( "ns", d, 0 ));
+            ASSERT( !m );
+        }
+
         /**
          * Idea behind this test is that we set up several shards, the first two of which are
          * draining and the second two of which have a data size limit.  We also simulate a random
@@ -34,6 +34,8 @@
 
 #include "mongo/s/chunk.h"
 
+#include <algorithm>
+
 #include "mongo/base/owned_pointer_map.h"
 #include "mongo/client/connpool.h"
 #include "mongo/client/dbclientcursor.h"
@@ -173,7 +175,7 @@ namespace mongo {
         : _manager(manager), _lastmod(0, 0, OID()), _dataWritten(mkDataWritten())
     {
         string ns = from.getStringField(ChunkType::ns().c_str());
-        _shard.reset(from.getStringField(ChunkType::shard().c_str()));
+        _shard = _manager->_getSharedShard(from.getStringField(ChunkType::shard().c_str()));
 
         _lastmod = ChunkVersion::fromBSON(from[ChunkType::DEPRECATED_lastmod()]);
         verify( _lastmod.isSet() );
@@ -186,13 +188,17 @@ namespace mongo {
         uassert( 10170 ,  "Chunk needs a ns" , ! ns.empty() );
         uassert( 13327 ,  "Chunk ns must match server ns" , ns == _manager->getns() );
 
-        uassert( 10171 ,  "Chunk needs a server" , _shard.ok() );
+        uassert( 10171 ,  "Chunk needs a server" , _shard->ok() );
 
         uassert( 10172 ,  "Chunk needs a min" , ! _min.isEmpty() );
         uassert( 10173 ,  "Chunk needs a max" , ! _max.isEmpty() );
     }
 
     Chunk::Chunk(const ChunkManager * info , const BSONObj& min, const BSONObj& max, const Shard& shard, ChunkVersion lastmod)
+        : _manager(info), _min(min), _max(max), _shard(new Shard(shard)), _lastmod(lastmod), _jumbo(false), _dataWritten(mkDataWritten())
+    {}
+
+    Chunk::Chunk(const ChunkManager * info , const BSONObj& min, const BSONObj& max, const ShardPtr& shard, ChunkVersion lastmod)
         : _manager(info), _min(min), _max(max), _shard(shard), _lastmod(lastmod), _jumbo(false), _dataWritten(mkDataWritten())
     {}
 
@@ -488,9 +494,9 @@ namespace mongo {
         uassert( 10167 ,  "can't move shard to its current location!" , getShard() != to );
 
         log() << "moving chunk ns: " << _manager->getns() << " moving ( " << toString() << ") "
-              << _shard.toString() << " -> " << to.toString() << endl;
+              << _shard->toString() << " -> " << to.toString() << endl;
 
-        Shard from = _shard;
+        Shard from = *_shard;
         ScopedDbConnection fromconn(from.getConnString());
 
         BSONObjBuilder builder;
@@ -687,7 +693,7 @@ namespace mongo {
         to << ChunkType::ns(_manager->getns());
         to << ChunkType::min(_min);
         to << ChunkType::max(_max);
-        to << ChunkType::shard(_shard.getName());
+        to << ChunkType::shard(_shard->getName());
     }
 
     string Chunk::genID( const string& ns , const BSONObj& o ) {
@@ -706,7 +712,7 @@ namespace mongo {
     string Chunk::toString() const {
         stringstream ss;
         ss << ChunkType::ns()                 << ": " << _manager->getns()   << ", "
-           << ChunkType::shard()              << ": " << _shard.toString()   << ", "
+           << ChunkType::shard()              << ": " << _shard->toString()   << ", "
            << ChunkType::DEPRECATED_lastmod() << ": " << _lastmod.toString() << ", "
            << ChunkType::min()                << ": " << _min                << ", "
            << ChunkType::max()                << ": " << _max;
@@ -772,6 +778,29 @@ namespace mongo {
 
     // -------  ChunkManager --------
 
+    namespace {
+
+        /**
+         * Fills 'hashes' with the upper bounds in 'chunkMaxes' but the last, if those are all
+         * single NumberLong values and the last is MaxKey.  Leaves it empty otherwise.
+         */
+        void loadChunkMaxHashes( const vector<BSONObj>& chunkMaxes, vector<long long>* hashes ) {
+            if ( chunkMaxes.size() < 2 || chunkMaxes.back().firstElement().type() != MaxKey )
+                return;
+
+            hashes->reserve( chunkMaxes.size() - 1 );
+            for ( size_t i = 0; i + 1 < chunkMaxes.size(); i++ ) {
+                const BSONElement bound = chunkMaxes[i].firstElement();
+                if ( bound.type() != NumberLong || chunkMaxes[i].nFields() != 1 ) {
+                    hashes->clear();
+                    return;
+                }
+                hashes->push_back( bound._numberLong() );
+            }
+        }
+
+    }
+
     AtomicUInt32 ChunkManager::NextSequenceNumber(1U);
 
     ChunkManager::ChunkManager( const string& ns, const ShardKeyPattern& pattern , bool unique ) :
@@ -847,6 +876,23 @@ namespace mongo {
                     const_cast<ShardVersionMap&>(_shardVersions).swap(shardVersions);
                     const_cast<ChunkRangeManager&>(_chunkRanges).reloadAll(_chunkMap);
 
+                    vector<BSONObj>& chunkMaxes = const_cast<vector<BSONObj>&>(_chunkMaxes);
+                    vector<ChunkPtr>& chunksByMax = const_cast<vector<ChunkPtr>&>(_chunksByMax);
+                    chunkMaxes.reserve(_chunkMap.size());
+                    chunksByMax.reserve(_chunkMap.size());
+                    for (ChunkMap::const_iterator it = _chunkMap.begin();
+                         it != _chunkMap.end();
+                         ++it) {
+                        chunkMaxes.push_back(it->first);
+                        chunksByMax.push_back(it->second);
+                    }
+
+                    if (_keyPattern.isHashedPattern()) {
+                        vector<long long>& hashes =
+                            const_cast<vector<long long>&>(_chunkMaxHashes);
+                        loadChunkMaxHashes(_chunkMaxes, &hashes);
+                    }
+
                     return;
                 }
             }
@@ -901,6 +947,20 @@ namespace mongo {
 
     };
 
+    ShardPtr ChunkManager::_getSharedShard(const string& name) const {
+        scoped_lock lk( _mutex );
+
+        map<string, ShardPtr>::const_iterator it = _sharedShards.find( name );
+        if ( it != _sharedShards.end() ) {
+            return it->second;
+        }
+
+        ShardPtr shard( new Shard() );
+        shard->reset( name );
+        _sharedShards[name] = shard;
+        return shard;
+    }
+
     bool ChunkManager::_load(const string& config,
                              ChunkMap& chunkMap,
                              set<Shard>& shards,
@@ -926,17 +986,20 @@ namespace mongo {
             // Could be v.expensive
             // TODO: If chunks were immutable and didn't reference the manager, we could do more
             // interesting things here
+            //
+            // The old map is already sorted, so each insert is hinted at the end of the new map
+            // and the Shard of every chunk is shared rather than copied.
             for( ChunkMap::const_iterator it = oldChunkMap.begin(); it != oldChunkMap.end(); it++ ){
 
-                ChunkPtr oldC = it->second;
+                const ChunkPtr& oldC = it->second;
                 ChunkPtr c( new Chunk( this, oldC->getMin(),
                                              oldC->getMax(),
-                                             oldC->getShard(),
+                                             oldC->getShardPtr(),
                                              oldC->getLastmod() ) );
 
                 c->setBytesWritten( oldC->getBytesWritten() );
 
-                chunkMap.insert( make_pair( oldC->getMax(), c ) );
+                chunkMap.insert( chunkMap.end(), make_pair( oldC->getMax(), c ) );
             }
 
             LOG(2) << "loading chunk manager for collection " << _ns
@@ -1153,24 +1216,40 @@ namespace mongo {
         _version = ChunkVersion( 0, 0, version.epoch() );
     }
 
+    ChunkPtr ChunkManager::findIntersectingChunkForHash( long long hash ) const {
+        if ( _chunkMaxHashes.empty() ) {
+            BSONObjBuilder keyBuilder;
+            keyBuilder.append( _keyPattern.toBSON().firstElement().fieldName(), hash );
+            return findIntersectingChunk( keyBuilder.obj() );
+        }
+
+        // Branch-free upper bound: the first chunk whose max is above 'hash', or the last chunk,
+        // which runs up to MaxKey.
+        const long long* base = &_chunkMaxHashes[0];
+        size_t n = _chunkMaxHashes.size();
+        while ( n > 1 ) {
+            const size_t half = n / 2;
+            base = ( base[half] <= hash ) ? base + half : base;
+            n -= half;
+        }
+        const size_t i = ( base - &_chunkMaxHashes[0] ) + ( *base <= hash ? 1 : 0 );
+
+        return _chunksByMax[i];
+    }
+
     ChunkPtr ChunkManager::findIntersectingChunk( const BSONObj& shardKey ) const {
         {
-            BSONObj chunkMin;
-            ChunkPtr chunk;
-            {
-                ChunkMap::const_iterator it = _chunkMap.upper_bound( shardKey );
-                if (it != _chunkMap.end()) {
-                    chunkMin = it->first;
-                    chunk = it->second;
-                }
-            }
-
-            if ( chunk ) {
+            vector<BSONObj>::const_iterator it = std::upper_bound( _chunkMaxes.begin(),
+                                                                   _chunkMaxes.end(),
+                                                                   shardKey,
+                                                                   BSONObjCmp() );
+            if ( it != _chunkMaxes.end() ) {
+                const ChunkPtr& chunk = _chunksByMax[it - _chunkMaxes.begin()];
                 if ( chunk->containsKey( shardKey ) ){
                     return chunk;
                 }
 
-                PRINT(chunkMin);
+                PRINT(*it);
                 PRINT(*chunk);
                 PRINT( shardKey );
 
@@ -1555,12 +1634,13 @@ namespace mongo {
     void ChunkRangeManager::_insertRange(ChunkMap::const_iterator begin, const ChunkMap::const_iterator end) {
         while (begin != end) {
             ChunkMap::const_iterator first = begin;
-            Shard shard = first->second->getShard();
+            const Shard& shard = first->second->getShard();
             while (begin != end && (begin->second->getShard() == shard))
                 ++begin;
 
+            // Ranges are built in key order, so each one goes at the end of the map
             shared_ptr<ChunkRange> cr (new ChunkRange(first, begin));
-            _ranges[cr->getMax()] = cr;
+            _ranges.insert(_ranges.end(), make_pair(cr->getMax(), cr));
         }
     }
 
@@ -86,6 +86,14 @@ namespace mongo {
                const Shard& shard,
                ChunkVersion lastmod = ChunkVersion() );
 
+        // Shares 'shard' with the caller rather than copying it, so that reloading a manager
+        // doesn't duplicate the Shard of every chunk carried over from the previous one.
+        Chunk( const ChunkManager * info ,
+               const BSONObj& min,
+               const BSONObj& max,
+               const ShardPtr& shard,
+               ChunkVersion lastmod = ChunkVersion() );
+
         //
         // serialization support
         //
@@ -248,7 +256,8 @@ namespace mongo {
         bool operator!=(const Chunk& s) const { return ! ( *this == s ); }
 
         std::string getns() const;
-        Shard getShard() const { return _shard; }
+        const Shard& getShard() const { return *_shard; }
+        const ShardPtr& getShardPtr() const { return _shard; }
         const ChunkManager* getManager() const { return _manager; }
         
 
@@ -260,7 +269,8 @@ namespace mongo {
 
         BSONObj _min;
         BSONObj _max;
-        Shard _shard;
+        // Chunks of one manager living on the same shard all point at the same Shard
+        ShardPtr _shard;
         ChunkVersion _lastmod;
         mutable bool _jumbo;
 
@@ -298,7 +308,7 @@ namespace mongo {
     class ChunkRange {
     public:
         const ChunkManager* getManager() const { return _manager; }
-        Shard getShard() const { return _shard; }
+        const Shard& getShard() const { return _shard; }
 
         const BSONObj& getMin() const { return _min; }
         const BSONObj& getMax() const { return _max; }
@@ -434,6 +444,13 @@ namespace mongo {
          */
         ChunkPtr findIntersectingChunk( const BSONObj& shardKey ) const;
 
+        /**
+         * For a hashed shard key, returns the chunk containing the key whose hashed value is
+         * 'hash', as findIntersectingChunk() on { a : NumberLong(hash) } would.  Searches the
+         * chunk bounds as plain 64-bit integers when they are all NumberLong.
+         */
+        ChunkPtr findIntersectingChunkForHash( long long hash ) const;
+
         void getShardsForQuery( std::set<Shard>& shards , const BSONObj& query ) const;
         void getAllShards( std::set<Shard>& all ) const;
         /** @param shards set to the shards covered by the interval [min, max], see SERVER-4791 */
@@ -497,6 +514,10 @@ namespace mongo {
                    const ChunkManager* oldManager);
         static bool _isValid(const ChunkMap& chunks);
 
+        // Returns the Shard named 'name', looking it up only the first time so that every chunk
+        // loaded into this manager for that shard shares one instance
+        ShardPtr _getSharedShard(const std::string& name) const;
+
         // end helpers
 
         // All members should be const for thread-safety
@@ -507,6 +528,15 @@ namespace mongo {
         const ChunkMap _chunkMap;
         const ChunkRangeManager _chunkRanges;
 
+        // The keys and chunks of _chunkMap, in the same order, in arrays: findIntersectingChunk()
+        // binary searches the upper bounds without walking map nodes
+        const std::vector<BSONObj> _chunkMaxes;
+        const std::vector<ChunkPtr> _chunksByMax;
+
+        // For hashed shard keys, the NumberLong upper bounds of all chunks but the last, whose
+        // upper bound is MaxKey.  Empty if the key is not hashed or a bound is not a NumberLong.
+        const std::vector<long long> _chunkMaxHashes;
+
         const std::set<Shard> _shards;
 
         const ShardVersionMap _shardVersions; // max version per shard
@@ -516,6 +546,9 @@ namespace mongo {
 
         mutable mutex _mutex; // only used with _nsLock
 
+        // Shards handed out by _getSharedShard(), guarded by _mutex
+        mutable std::map<std::string, ShardPtr> _sharedShards;
+
         const unsigned long long _sequenceNumber;
 
         //
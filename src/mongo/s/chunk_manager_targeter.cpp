@@ -96,7 +96,18 @@ namespace mongo {
             // Inserts must contain the exact shard key.
             //
 
-            shardKey = _manager->getShardKeyPattern().extractShardKeyFromDoc(doc);
+            const ShardKeyPattern& pattern = _manager->getShardKeyPattern();
+
+            // Hashed keys are routed on the raw hashed value, which is a NumberLong and so is
+            // always within the shard key size limit
+            long long hash;
+            if (pattern.isHashedPattern()) {
+                if (pattern.extractHashFromDoc(doc, &hash))
+                    return targetHashedShardKey(hash, doc.objsize(), endpoint);
+            }
+            else {
+                shardKey = pattern.extractShardKeyFromDoc(doc);
+            }
 
             // Check shard key exists
             if (shardKey.isEmpty()) {
@@ -389,8 +400,20 @@ namespace mongo {
                                                 ShardEndpoint** endpoint) const {
         invariant(NULL != _manager);
 
-        ChunkPtr chunk = _manager->findIntersectingChunk(shardKey);
+        return targetChunk(_manager->findIntersectingChunk(shardKey), estDataSize, endpoint);
+    }
+
+    Status ChunkManagerTargeter::targetHashedShardKey(long long hash,
+                                                      long long estDataSize,
+                                                      ShardEndpoint** endpoint) const {
+        invariant(NULL != _manager);
+
+        return targetChunk(_manager->findIntersectingChunkForHash(hash), estDataSize, endpoint);
+    }
 
+    Status ChunkManagerTargeter::targetChunk(const ChunkPtr& chunk,
+                                             long long estDataSize,
+                                             ShardEndpoint** endpoint) const {
         // Track autosplit stats for sharded collections
         // Note: this is only best effort accounting and is not accurate.
         if (estDataSize > 0)
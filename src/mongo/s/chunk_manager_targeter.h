@@ -139,6 +139,20 @@ namespace mongo {
                               long long estDataSize,
                               ShardEndpoint** endpoint) const;
 
+        /**
+         * As targetShardKey(), for a hashed shard key whose hashed value is 'hash'.
+         */
+        Status targetHashedShardKey(long long hash,
+                                    long long estDataSize,
+                                    ShardEndpoint** endpoint) const;
+
+        /**
+         * Returns a ShardEndpoint for the shard owning 'chunk', and updates the chunk's stats.
+         */
+        Status targetChunk(const ChunkPtr& chunk,
+                           long long estDataSize,
+                           ShardEndpoint** endpoint) const;
+
         NamespaceString _nss;
 
         // Zero or one of these are filled at all times
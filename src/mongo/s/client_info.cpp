@@ -50,6 +50,7 @@
 #include "mongo/s/grid.h"
 #include "mongo/s/request.h"
 #include "mongo/server.h"
+#include "mongo/util/coarse_clock.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/scopeguard.h"
@@ -97,7 +98,7 @@ namespace mongo {
     }
 
     void ClientInfo::newRequest() {
-        _lastAccess = (int) time(0);
+        _lastAccess = (int) (CoarseClock::wallMillis() / 1000);
 
         RequestInfo* temp = _cur;
         _cur = _prev;
@@ -131,6 +132,15 @@ namespace mongo {
         return info;
     }
 
+    ClientInfo* ClientInfo::releaseCurrent() {
+        return _tlInfo.release();
+    }
+
+    void ClientInfo::setCurrent(ClientInfo* info) {
+        massert(28600, "A ClientInfo already exists for this thread", !_tlInfo.get());
+        _tlInfo.reset(info);
+    }
+
     bool ClientInfo::exists() {
         return _tlInfo.get();
     }
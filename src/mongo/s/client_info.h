@@ -126,6 +126,12 @@ namespace mongo {
         static ClientInfo * get(AbstractMessagingPort* messagingPort = NULL);
         // Creates a ClientInfo and stores it in _tlInfo
         static ClientInfo* create(AbstractMessagingPort* messagingPort);
+        // Detaches this thread's ClientInfo from _tlInfo without destroying it, so that the
+        // connection it describes can be serviced by a different thread. Returns NULL if there
+        // is none.
+        static ClientInfo* releaseCurrent();
+        // Installs a ClientInfo previously detached with releaseCurrent() on this thread.
+        static void setCurrent(ClientInfo* info);
 
     private:
 
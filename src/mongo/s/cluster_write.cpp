@@ -32,11 +32,13 @@
 
 #include "mongo/s/cluster_write.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
 #include "mongo/base/init.h"
 #include "mongo/base/status.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/chunk_manager_targeter.h"
 #include "mongo/s/config.h"
 #include "mongo/s/dbclient_multi_command.h"
@@ -55,6 +57,9 @@ namespace mongo {
 
     const int ConfigOpTimeoutMillis = 30 * 1000;
 
+    // Number of child batches of an unordered write which may be outstanding to each shard.
+    MONGO_EXPORT_SERVER_PARAMETER(maxWriteBatchesInFlightPerShard, int, 2);
+
     namespace {
         // TODO: consider writing a type for index instead
         /**
@@ -422,6 +427,7 @@ namespace mongo {
         DBClientShardResolver resolver;
         DBClientMultiCommand dispatcher;
         BatchWriteExec exec( &targeter, &resolver, &dispatcher );
+        exec.setMaxBatchesInFlightPerHost( std::max( maxWriteBatchesInFlightPerShard, 1 ) );
         exec.executeBatch( request, response );
 
         if ( _autoSplit )
@@ -30,6 +30,8 @@
 
 #include "mongo/s/collection_metadata.h"
 
+#include <algorithm>
+
 #include "mongo/bson/util/builder.h" // for StringBuilder
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
@@ -38,6 +40,17 @@ namespace mongo {
 
     using mongoutils::str::stream;
 
+namespace {
+
+    // Orders a key before the ranges whose lower bound is above it
+    struct KeyBeforeRange {
+        bool operator()( const BSONObj& key, const std::pair<BSONObj, BSONObj>& range ) const {
+            return key.woCompare( range.first ) < 0;
+        }
+    };
+
+} // namespace
+
     CollectionMetadata::CollectionMetadata() { }
 
     CollectionMetadata::~CollectionMetadata() { }
@@ -201,6 +214,7 @@ namespace mongo {
         metadata->_pendingMap.erase( pending.getMin() );
         metadata->_chunksMap = this->_chunksMap;
         metadata->_rangesMap = this->_rangesMap;
+        metadata->_rangesVector = this->_rangesVector;
         metadata->_shardVersion = _shardVersion;
         metadata->_collVersion = _collVersion;
 
@@ -236,6 +250,7 @@ namespace mongo {
         metadata->_pendingMap = this->_pendingMap;
         metadata->_chunksMap = this->_chunksMap;
         metadata->_rangesMap = this->_rangesMap;
+        metadata->_rangesVector = this->_rangesVector;
         metadata->_shardVersion = _shardVersion;
         metadata->_collVersion = _collVersion;
 
@@ -426,6 +441,7 @@ namespace mongo {
         metadata->_pendingMap = this->_pendingMap;
         metadata->_chunksMap = this->_chunksMap;
         metadata->_rangesMap = this->_rangesMap;
+        metadata->_rangesVector = this->_rangesVector;
         metadata->_shardVersion = newShardVersion;
         metadata->_collVersion =
                 newShardVersion > _collVersion ? newShardVersion : this->_collVersion;
@@ -447,14 +463,21 @@ namespace mongo {
             return true;
         }
 
-        if ( _rangesMap.size() <= 0 ) {
+        if ( _rangesVector.empty() ) {
             return false;
         }
 
-        RangeMap::const_iterator it = _rangesMap.upper_bound( key );
-        if ( it != _rangesMap.begin() ) it--;
+        // The only range which can contain the key is the last one starting at or before it
+        RangeVector::const_iterator it = std::upper_bound( _rangesVector.begin(),
+                                                           _rangesVector.end(),
+                                                           key,
+                                                           KeyBeforeRange() );
+        if ( it == _rangesVector.begin() ) {
+            return false;
+        }
+        --it;
 
-        bool good = rangeContains( it->first, it->second, key );
+        bool good = key.woCompare( it->second ) < 0;
 
 #if 0
         // DISABLED because of SERVER-11175 - huge amount of logging
@@ -463,7 +486,8 @@ namespace mongo {
             log() << "bad: " << key << " " << it->first << " " << key.woCompare( it->first ) << " "
                   << key.woCompare( it->second ) << endl;
 
-            for ( RangeMap::const_iterator i = _rangesMap.begin(); i != _rangesMap.end(); ++i ) {
+            for ( RangeVector::const_iterator i = _rangesVector.begin(); i != _rangesVector.end();
+                ++i ) {
                 log() << "\t" << i->first << "\t" << i->second << "\t" << endl;
             }
         }
@@ -733,6 +757,8 @@ namespace mongo {
         dassert(!min.isEmpty());
 
         _rangesMap.insert(make_pair(min, max));
+
+        _rangesVector.assign(_rangesMap.begin(), _rangesMap.end());
     }
 
     void CollectionMetadata::fillKeyPatternFields() {
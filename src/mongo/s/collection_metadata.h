@@ -299,13 +299,18 @@ namespace mongo {
         // installations.
         RangeMap _rangesMap;
 
+        // The same ranges as _rangesMap in a sorted vector, which keyBelongsToMe binary searches
+        // without chasing tree nodes.
+        RangeVector _rangesVector;
+
         /**
          * Returns true if this metadata was loaded with all necessary information.
          */
         bool isValid() const;
 
         /**
-         * Try to find chunks that are adjacent and record these intervals in the _rangesMap
+         * Try to find chunks that are adjacent and record these intervals in the _rangesMap and
+         * _rangesVector
          */
         void fillRanges();
 
@@ -70,6 +70,7 @@
 #include "mongo/util/log.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/net/message.h"
+#include "mongo/util/net/message_compressor.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/ramlog.h"
 #include "mongo/util/stringutils.h"
@@ -1580,6 +1581,8 @@ namespace mongo {
                 result.append("maxWireVersion", maxWireVersion);
                 result.append("minWireVersion", minWireVersion);
 
+                negotiateMessageCompressor(cmdObj, ClientBasic::getCurrent()->port(), &result);
+
                 return true;
             }
         } ismaster;
@@ -52,6 +52,7 @@
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/query/lite_parsed_query.h"
+#include "mongo/db/query/query_shape_stats.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/s/client_info.h"
 #include "mongo/s/cluster_explain.h"
@@ -542,6 +543,82 @@ namespace mongo {
             }
         } repairDatabaseCmd;
 
+        class QueryShapeStatsCmd : public Command {
+        public:
+            QueryShapeStatsCmd() : Command("queryShapeStats") { }
+
+            virtual bool slaveOk() const { return true; }
+            virtual bool adminOnly() const { return true; }
+            virtual bool isWriteCommandForConfigServer() const { return false; }
+
+            virtual void help(stringstream& help) const {
+                help << "the query shapes that used the most time or did the most work, "
+                        "over all shards";
+            }
+
+            virtual void addRequiredPrivileges(const std::string& dbname,
+                                               const BSONObj& cmdObj,
+                                               std::vector<Privilege>* out) {
+                ActionSet actions;
+                actions.addAction(ActionType::top);
+                out->push_back(Privilege(ResourcePattern::forClusterResource(), actions));
+            }
+
+            bool run(OperationContext* txn, const string& dbName, BSONObj& cmdObj, int,
+                     string& errmsg, BSONObjBuilder& result, bool) {
+                long long limit = 10;
+                if (cmdObj["limit"].isNumber()) {
+                    limit = cmdObj["limit"].numberLong();
+                }
+                if (limit < 0) {
+                    errmsg = "limit must not be negative";
+                    return false;
+                }
+                const std::string sortBy = cmdObj["sortBy"].eoo() ? "totalMicros"
+                                                                  : cmdObj["sortBy"].str();
+
+                // A shape's totals are spread over the shards, so each reports every shape
+                // and the ranking is done here.
+                BSONObjBuilder shardCmdBuilder;
+                shardCmdBuilder.appendElements(cmdObj.removeField("limit"));
+                shardCmdBuilder.append("limit", 0);
+                const BSONObj shardCmd = shardCmdBuilder.obj();
+
+                vector<Shard> shards;
+                Shard::getAllShards(shards);
+
+                std::vector<BSONObj> shapes;
+                for (vector<Shard>::const_iterator i = shards.begin(); i != shards.end(); ++i) {
+                    ScopedDbConnection conn(i->getConnString());
+                    BSONObj res;
+                    bool ok = conn->runCommand("admin", shardCmd, res);
+                    conn.done();
+
+                    if (!ok) {
+                        result.appendElements(res);
+                        return false;
+                    }
+
+                    BSONObjIterator it(res["shapes"].Obj());
+                    while (it.more()) {
+                        shapes.push_back(it.next().Obj().getOwned());
+                    }
+                }
+
+                std::vector<BSONObj> merged;
+                QueryShapeStats::merge(shapes, &merged);
+
+                BSONArrayBuilder shapesBuilder(result.subarrayStart("shapes"));
+                Status status = QueryShapeStats::appendTop(merged, sortBy, limit, &shapesBuilder);
+                shapesBuilder.done();
+                if (!status.isOK()) {
+                    return appendCommandStatus(result, status);
+                }
+                result.appendNumber("numShapes", static_cast<long long>(merged.size()));
+                return true;
+            }
+        } queryShapeStatsCmd;
+
         class DBStatsCmd : public RunOnAllShardsCommand {
         public:
             DBStatsCmd() :  RunOnAllShardsCommand("dbStats", "dbstats") {}
@@ -933,6 +1010,10 @@ namespace mongo {
                     countCmdBuilder.append(cmdObj["$queryOptions"]);
                 }
 
+                if (cmdObj.hasField("estimate")) {
+                    countCmdBuilder.append(cmdObj["estimate"]);
+                }
+
                 if (cmdObj.hasField(LiteParsedQuery::cmdOptionMaxTimeMS)) {
                     countCmdBuilder.append(cmdObj[LiteParsedQuery::cmdOptionMaxTimeMS]);
                 }
@@ -943,6 +1024,7 @@ namespace mongo {
                             options, fullns, filter, &countResult );
 
                 long long total = 0;
+                bool estimated = false;
                 BSONObjBuilder shardSubTotal( result.subobjStart( "shards" ));
 
                 for( vector<Strategy::CommandResult>::const_iterator iter = countResult.begin();
@@ -954,6 +1036,7 @@ namespace mongo {
 
                         shardSubTotal.appendNumber( shardName, shardCount );
                         total += shardCount;
+                        estimated = estimated || iter->result["estimated"].trueValue();
                     }
                     else {
                         shardSubTotal.doneFast();
@@ -972,6 +1055,9 @@ namespace mongo {
                 shardSubTotal.doneFast();
                 total = applySkipLimit( total , cmdObj );
                 result.appendNumber( "n" , total );
+                if (estimated) {
+                    result.appendBool("estimated", true);
+                }
 
                 return true;
             }
@@ -0,0 +1,197 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kSharding
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/s/config_change_watcher.h"
+
+#include <set>
+
+#include "mongo/client/connpool.h"
+#include "mongo/client/dbclientcursor.h"
+#include "mongo/db/client.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/s/config.h"
+#include "mongo/s/grid.h"
+#include "mongo/s/type_changelog.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+
+    // How long to wait between looks at config.changelog when nothing new has been logged.
+    // 0 turns the watcher off, leaving stale metadata to be found by the shards.
+    MONGO_EXPORT_SERVER_PARAMETER(configChangeWatchIntervalMillis, int, 1000);
+
+namespace {
+
+    // What to refresh for a batch of changes - each database and collection once
+    struct PendingRefreshes {
+        std::set<std::string> collections;
+        std::set<std::string> databases;
+        std::set<std::string> droppedDatabases;
+    };
+
+    void noteChange( const BSONObj& entry, PendingRefreshes* refreshes ) {
+        const std::string what = entry[ChangelogType::what()].str();
+        const std::string ns = entry[ChangelogType::ns()].str();
+        if ( ns.empty() )
+            return;
+
+        if ( what == "split" || what == "multi-split" || what == "merge"
+             || what == "moveChunk.commit" ) {
+            refreshes->collections.insert( ns );
+        }
+        else if ( what == "shardCollection" || what == "dropCollection"
+                  || what == "movePrimary" ) {
+            refreshes->databases.insert( nsToDatabase( ns ) );
+        }
+        else if ( what == "dropDatabase" ) {
+            refreshes->droppedDatabases.insert( ns );
+        }
+    }
+
+    void applyRefreshes( const PendingRefreshes& refreshes ) {
+
+        // Nothing to do for databases this mongos hasn't loaded - they are read fresh on first use
+        for ( std::set<std::string>::const_iterator it = refreshes.droppedDatabases.begin();
+            it != refreshes.droppedDatabases.end(); ++it ) {
+
+            DBConfigPtr config = grid.getDBConfigIfLoaded( *it );
+            if ( config )
+                grid.removeDBIfExists( *config );
+        }
+
+        for ( std::set<std::string>::const_iterator it = refreshes.databases.begin();
+            it != refreshes.databases.end(); ++it ) {
+
+            if ( refreshes.droppedDatabases.count( *it ) )
+                continue;
+
+            DBConfigPtr config = grid.getDBConfigIfLoaded( *it );
+            if ( config && !config->reload() )
+                grid.removeDBIfExists( *config );
+        }
+
+        for ( std::set<std::string>::const_iterator it = refreshes.collections.begin();
+            it != refreshes.collections.end(); ++it ) {
+
+            const std::string db = nsToDatabase( *it );
+            if ( refreshes.droppedDatabases.count( db ) || refreshes.databases.count( db ) )
+                continue;
+
+            DBConfigPtr config = grid.getDBConfigIfLoaded( db );
+            if ( !config || !config->isSharded( *it ) )
+                continue;
+
+            try {
+                // Only reads past the newest chunk when our version is behind
+                config->getChunkManagerIfExists( *it, true );
+            }
+            catch ( const DBException& ex ) {
+                warning() << "could not refresh metadata for " << *it << " after config change"
+                          << causedBy( ex ) << endl;
+            }
+        }
+    }
+
+} // namespace
+
+    ConfigChangeWatcher::ConfigChangeWatcher() :
+        // Changes logged before we started are already reflected in what we load
+        _lastChangeTime( jsTime() ) {
+    }
+
+    std::string ConfigChangeWatcher::name() const {
+        return "ConfigChangeWatcher";
+    }
+
+    void ConfigChangeWatcher::run() {
+        Client::initThread( "ConfigChangeWatcher" );
+
+        while ( !inShutdown() ) {
+
+            if ( configChangeWatchIntervalMillis > 0 ) {
+                try {
+                    _tailChangelog();
+                }
+                catch ( const DBException& ex ) {
+                    LOG( 1 ) << "error tailing config changelog" << causedBy( ex ) << endl;
+                }
+            }
+
+            sleepmillis( configChangeWatchIntervalMillis > 0 ?
+                         configChangeWatchIntervalMillis : 1000 );
+        }
+    }
+
+    void ConfigChangeWatcher::_tailChangelog() {
+
+        ScopedDbConnection conn( configServer.getPrimary().getConnString(), 30.0 );
+
+        // config.changelog is capped, so this follows new changes as they are logged
+        auto_ptr<DBClientCursor> cursor =
+            conn->query( ChangelogType::ConfigNS,
+                         Query( BSON( ChangelogType::time() << GT << _lastChangeTime ) ),
+                         0,
+                         0,
+                         NULL,
+                         QueryOption_CursorTailable | QueryOption_AwaitData );
+        uassert( 28651, "could not query config changelog", cursor.get() );
+
+        while ( !inShutdown() && configChangeWatchIntervalMillis > 0 ) {
+
+            if ( !cursor->more() ) {
+                if ( cursor->isDead() )
+                    break;
+
+                sleepmillis( configChangeWatchIntervalMillis );
+                continue;
+            }
+
+            PendingRefreshes refreshes;
+            do {
+                BSONObj entry = cursor->nextSafe();
+                noteChange( entry, &refreshes );
+
+                BSONElement time = entry[ChangelogType::time()];
+                if ( time.type() == Date && time.date() > _lastChangeTime )
+                    _lastChangeTime = time.date();
+            } while ( cursor->moreInCurrentBatch() );
+
+            applyRefreshes( refreshes );
+        }
+
+        conn.done();
+    }
+
+} // namespace mongo
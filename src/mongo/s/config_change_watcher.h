@@ -0,0 +1,67 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "mongo/util/background.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    /**
+     * Background job that runs only in mongos and tails config.changelog, refreshing the cached
+     * metadata of any database or sharded collection a metadata change is logged for.  This lets
+     * mongos pick up splits, migrations and drops done elsewhere before a shard has to reject a
+     * stale request, and turns one logged change into at most one reload per poll.
+     *
+     * The cache only becomes fresher earlier; a missed or late notification still falls back on
+     * the stale config handling.
+     */
+    class ConfigChangeWatcher : public BackgroundJob {
+    public:
+        ConfigChangeWatcher();
+
+    protected:
+        virtual std::string name() const;
+        virtual void run();
+
+    private:
+
+        /**
+         * Tails the changelog from _lastChangeTime until the cursor dies or is no longer
+         * wanted.  Throws on errors talking to the config server.
+         */
+        void _tailChangelog();
+
+        // Time of the newest change seen so far
+        Date_t _lastChangeTime;
+    };
+
+} // namespace mongo
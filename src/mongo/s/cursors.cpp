@@ -79,6 +79,11 @@ namespace mongo {
 
     ShardedClientCursor::~ShardedClientCursor() {
         verify( _cursor );
+
+        // The shard cursors would otherwise only be killed once their connections are used
+        // again, or time out.
+        DESTRUCTOR_GUARD( _cursor->killShardCursors(); );
+
         delete _cursor;
         _cursor = 0;
     }
@@ -110,7 +115,7 @@ namespace mongo {
         BufBuilder buffer( INIT_REPLY_BUFFER_SIZE );
         int docCount = 0;
         bool hasMore = sendNextBatch( r, _ntoreturn, buffer, docCount );
-        replyToQuery( 0, r.p(), r.m(), buffer.buf(), buffer.len(), docCount,
+        replyToQuery( 0, r.p(), r.m(), buffer, docCount,
                 _totalSent, hasMore ? getId() : 0 );
 
         return hasMore;
@@ -134,6 +139,11 @@ namespace mongo {
         const bool sendMoreBatches = ntoreturn == 0 || ntoreturn > 1;
         ntoreturn = abs( ntoreturn );
 
+        // No shard can contribute more than this batch takes, so further getMores to the
+        // shards need not ask for more. Batches after the first no longer skip anything.
+        if ( sendMoreBatches && ntoreturn > 0 )
+            _cursor->setShardBatchSize( ntoreturn + ( _totalSent == 0 ? _skip : 0 ) );
+
         bool cursorHasMore = true;
         while ( ( cursorHasMore = _cursor->more() ) ) {
             BSONObj o = _cursor->next();
@@ -186,6 +196,10 @@ namespace mongo {
         _totalSent += docCount;
         _done = ! hasMoreBatches;
 
+        // After a single batch nothing will read what the shards still hold.
+        if ( _done && cursorHasMore )
+            _cursor->killShardCursors();
+
         return hasMoreBatches;
     }
 
@@ -58,6 +58,7 @@
 #include "mongo/db/concurrency/lock_state.h"
 #include "mongo/db/dbhelpers.h"
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/storage/mmap_v1/dur.h"
 #include "mongo/db/field_parser.h"
 #include "mongo/db/hasher.h"
@@ -68,6 +69,7 @@
 #include "mongo/db/range_deleter_service.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/repl_coordinator_global.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/write_concern.h"
 #include "mongo/logger/ramlog.h"
@@ -78,6 +80,7 @@
 #include "mongo/s/distlock.h"
 #include "mongo/s/shard.h"
 #include "mongo/s/type_chunk.h"
+#include "mongo/stdx/functional.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/elapsed_tracker.h"
 #include "mongo/util/exit.h"
@@ -127,6 +130,10 @@ namespace mongo {
     MONGO_FP_DECLARE(failMigrationConfigWritePrepare);
     MONGO_FP_DECLARE(failMigrationApplyOps);
 
+    // Lets the donor move a chunk too large to list its documents' locations up front, by
+    // reading them from a cursor over the shard key index instead of failing the migration.
+    MONGO_EXPORT_SERVER_PARAMETER(migrateCloneLargeChunksWithCursor, bool, false);
+
     Tee* migrateLog = RamLog::get("migrate");
 
     class MoveTimingHelper {
@@ -254,6 +261,8 @@ namespace mongo {
             _active = false;
             _inCriticalSection = false;
             _memoryUsed = 0;
+            _cloneLocsNext = 0;
+            _cloneExecDone = false;
         }
 
         /**
@@ -281,6 +290,7 @@ namespace mongo {
             _shardKeyPattern = shardKeyPattern;
 
             verify( _cloneLocs.size() == 0 );
+            verify( _cloneExec.get() == NULL );
             verify( _deleted.size() == 0 );
             verify( _reload.size() == 0 );
             verify( _memoryUsed == 0 );
@@ -307,8 +317,13 @@ namespace mongo {
                 scoped_spinlock lk( _trackerLocks );
                 _deleted.clear();
                 _reload.clear();
-                _cloneLocs.clear();
+                vector<RecordId>().swap(_cloneLocs);
+                vector<bool>().swap(_cloneLocsDeleted);
+                _cloneLocsNext = 0;
             }
+            _cloneExec.reset();
+            _cloneExecDone = false;
+            _cloneExecPending = BSONObj();
             _memoryUsed = 0;
 
             scoped_lock l(_mutex);
@@ -443,6 +458,9 @@ namespace mongo {
         /**
          * Get the disklocs that belong to the chunk migrated and sort them in _cloneLocs (to avoid seeking disk later)
          *
+         * With migrateCloneLargeChunksWithCursor set, a chunk too large to remember this way is
+         * instead cloned straight from a cursor over the shard key index, in key order.
+         *
          * @param maxChunkSize number of bytes beyond which a chunk's base data (no indices) is considered too large to move
          * @param errmsg filled with textual description of error if this call return false
          * @return false if approximate chunk size is too big to move or true otherwise
@@ -517,10 +535,11 @@ namespace mongo {
             bool isLargeChunk = false;
             unsigned long long recCount = 0;;
             RecordId dl;
-            while (PlanExecutor::ADVANCED == exec->getNext(NULL, &dl)) {
+            PlanExecutor::ExecState state;
+            while (PlanExecutor::ADVANCED == (state = exec->getNext(NULL, &dl))) {
                 if ( ! isLargeChunk ) {
                     scoped_spinlock lk( _trackerLocks );
-                    _cloneLocs.insert( dl );
+                    _cloneLocs.push_back( dl );
                 }
 
                 if ( ++recCount > maxRecsWhenFull ) {
@@ -529,6 +548,44 @@ namespace mongo {
             }
             exec.reset();
 
+            if ( isLargeChunk && migrateCloneLargeChunksWithCursor ) {
+                log() << "moveChunk will clone " << recCount << " documents in chunk " << _min
+                      << " -> " << _max << " from a cursor, the chunk exceeds the maximum of "
+                      << maxRecsWhenFull << " documents" << migrateLog;
+
+                {
+                    scoped_spinlock lk( _trackerLocks );
+                    vector<RecordId>().swap( _cloneLocs );
+                }
+
+                // The scan above yielded, so the index may be gone.  If it ended normally, the
+                // collection at least is still there.
+                if ( state != PlanExecutor::IS_EOF ) {
+                    errmsg = "collection dropped while scanning the chunk to move";
+                    return false;
+                }
+                idx = collection->getIndexCatalog()->findIndexByPrefix( txn,
+                                                                        _shardKeyPattern,
+                                                                        false );
+                if ( idx == NULL ) {
+                    errmsg = "shard key index dropped while scanning the chunk to move";
+                    return false;
+                }
+                KeyPattern cloneKp( idx->keyPattern() );
+                min = Helpers::toKeyFormat( cloneKp.extendRangeBound( _min, false ) );
+                max = Helpers::toKeyFormat( cloneKp.extendRangeBound( _max, false ) );
+
+                // Deletions and moves of documents the cursor has yet to reach reach it through
+                // the registration, and changes behind it are sent by _transferMods.
+                _cloneExec.reset(InternalPlanner::indexScan(txn, collection, idx, min, max, false,
+                                                            InternalPlanner::FORWARD,
+                                                            InternalPlanner::IXSCAN_FETCH));
+                _cloneExec->registerExec();
+                _cloneExec->saveState();
+                txn->recoveryUnit()->commitAndRestart();
+                return true;
+            }
+
             if ( isLargeChunk ) {
                 warning() << "cannot move chunk: the maximum number of documents for a chunk is "
                           << maxRecsWhenFull << " , the maximum chunk size is " << maxChunkSize
@@ -543,6 +600,15 @@ namespace mongo {
 
             {
                 scoped_spinlock lk( _trackerLocks );
+
+                // The index may be multikey over fields past the shard key, so a document can
+                // come up more than once.
+                std::sort( _cloneLocs.begin(), _cloneLocs.end() );
+                _cloneLocs.erase( std::unique( _cloneLocs.begin(), _cloneLocs.end() ),
+                                  _cloneLocs.end() );
+                _cloneLocsDeleted.assign( _cloneLocs.size(), false );
+                _cloneLocsNext = 0;
+
                 log() << "moveChunk number of documents: " << _cloneLocs.size() << migrateLog;
             }
             txn->recoveryUnit()->commitAndRestart();
@@ -558,6 +624,10 @@ namespace mongo {
             ElapsedTracker tracker(internalQueryExecYieldIterations,
                                    internalQueryExecYieldPeriodMS);
 
+            if ( _cloneExec.get() ) {
+                return _cloneFromCursor( txn, &tracker, errmsg, result );
+            }
+
             int allocSize;
             {
                 AutoGetCollectionForRead ctx(txn, _ns);
@@ -566,7 +636,8 @@ namespace mongo {
                 scoped_spinlock lk( _trackerLocks );
                 allocSize =
                     std::min(BSONObjMaxUserSize,
-                             (int)((12 + collection->averageObjectSize(txn)) * _cloneLocs.size()));
+                             (int)((12 + collection->averageObjectSize(txn)) *
+                                   (_cloneLocs.size() - _cloneLocsNext)));
             }
             BSONArrayBuilder a (allocSize);
             
@@ -577,14 +648,16 @@ namespace mongo {
                 Collection* collection = ctx.getCollection();
 
                 scoped_spinlock lk( _trackerLocks );
-                set<RecordId>::iterator i = _cloneLocs.begin();
-                for ( ; i!=_cloneLocs.end(); ++i ) {
+                for ( ; _cloneLocsNext < _cloneLocs.size(); ++_cloneLocsNext ) {
                     if (tracker.intervalHasElapsed()) // should I yield?
                         break;
                     
                     invariant( collection );
 
-                    RecordId dl = *i;
+                    if ( _cloneLocsDeleted[_cloneLocsNext] )
+                        continue;
+
+                    RecordId dl = _cloneLocs[_cloneLocsNext];
                     BSONObj o;
                     if ( !collection->findDoc( txn, dl, &o ) ) {
                         // doc was deleted
@@ -602,9 +675,67 @@ namespace mongo {
                     a.append( o );
                 }
                 
-                _cloneLocs.erase( _cloneLocs.begin() , i );
-                
-                if ( _cloneLocs.empty() || filledBuffer )
+                if ( _cloneLocsNext == _cloneLocs.size() || filledBuffer )
+                    break;
+            }
+
+            result.appendArray( "objects" , a.arr() );
+            return true;
+        }
+
+        /**
+         * clone() for a chunk too large for _cloneLocs: fills the batch from _cloneExec, which
+         * is saved again before returning.
+         */
+        bool _cloneFromCursor(OperationContext* txn,
+                              ElapsedTracker* tracker,
+                              string& errmsg,
+                              BSONObjBuilder& result) {
+            BSONArrayBuilder a (BSONObjMaxUserSize);
+
+            if ( !_cloneExecPending.isEmpty() ) {
+                a.append( _cloneExecPending );
+                _cloneExecPending = BSONObj();
+            }
+
+            while ( !_cloneExecDone ) {
+                bool filledBuffer = false;
+
+                AutoGetCollectionForRead ctx(txn, _ns);
+                if ( !ctx.getCollection() || !_cloneExec->restoreState(txn) ) {
+                    errmsg = "collection or index dropped during the clone of " + _ns;
+                    return false;
+                }
+
+                while ( !tracker->intervalHasElapsed() ) {
+                    BSONObj o;
+                    PlanExecutor::ExecState state = _cloneExec->getNext(&o, NULL);
+                    if ( state == PlanExecutor::IS_EOF ) {
+                        _cloneExecDone = true;
+                        break;
+                    }
+                    if ( state != PlanExecutor::ADVANCED ) {
+                        _cloneExec->saveState();
+                        errmsg = str::stream() << "cloning " << _ns << " failed: "
+                                               << WorkingSetCommon::toStatusString(o);
+                        return false;
+                    }
+
+                    // like clone(), always send at least one document
+                    if ( a.arrSize() != 0 &&
+                         a.len() + o.objsize() + 1024 > BSONObjMaxUserSize ) {
+                        // keep it for the next batch
+                        _cloneExecPending = o.getOwned();
+                        filledBuffer = true;
+                        break;
+                    }
+
+                    a.append( o );
+                }
+
+                _cloneExec->saveState();
+
+                if ( filledBuffer )
                     break;
             }
 
@@ -620,12 +751,18 @@ namespace mongo {
             // lock not needed right now
             // but trying to prevent a future bug
             scoped_spinlock lk( _trackerLocks );
-            _cloneLocs.erase( dl );
+            vector<RecordId>::iterator it = std::lower_bound( _cloneLocs.begin(),
+                                                              _cloneLocs.end(),
+                                                              dl );
+            if ( it != _cloneLocs.end() && *it == dl )
+                _cloneLocsDeleted[it - _cloneLocs.begin()] = true;
         }
 
         std::size_t cloneLocsRemaining() {
             scoped_spinlock lk( _trackerLocks );
-            return _cloneLocs.size();
+            if ( _cloneExec.get() )
+                return _cloneExecDone && _cloneExecPending.isEmpty() ? 0 : 1;
+            return _cloneLocs.size() - _cloneLocsNext;
         }
 
         long long mbUsed() const { return _memoryUsed / ( 1024 * 1024 ); }
@@ -676,11 +813,22 @@ namespace mongo {
         // even though it shouldn't be needed under normal operation
         SpinLock _trackerLocks;
 
-        // disk locs yet to be transferred from here to the other side
+        // disk locs to be transferred from here to the other side, sorted, and how far clone()
+        // has got through them.  A deletion only sets the document's bit in _cloneLocsDeleted.
         // no locking needed because built initially by 1 thread in a read lock
-        // emptied by 1 thread in a read lock
+        // consumed by 1 thread in a read lock
         // updates applied by 1 thread in a write lock
-        set<RecordId> _cloneLocs;
+        vector<RecordId> _cloneLocs;
+        vector<bool> _cloneLocsDeleted;
+        size_t _cloneLocsNext;
+
+        // Instead of _cloneLocs, for a chunk too large for them: a saved, registered scan of
+        // the chunk's documents over the shard key index, and whether it has reached the end.
+        scoped_ptr<PlanExecutor> _cloneExec;
+        bool _cloneExecDone;
+
+        // A document _cloneExec returned that didn't fit in the last batch.
+        BSONObj _cloneExecPending;
 
         list<BSONObj> _reload; // objects that were modified that must be recloned
         list<BSONObj> _deleted; // objects deleted during clone that should be deleted later
@@ -779,6 +927,10 @@ namespace mongo {
                           BSONObj * patt,
                           bool notInActiveChunk) {
         migrateFromStatus.logOp(txn, opstr, ns, obj, patt, notInActiveChunk);
+
+        if ( opstr[0] == 'i' && opstr[1] == 0 && !notInActiveChunk ) {
+            noteInsertForSplitting(ns, obj);
+        }
     }
 
     class TransferModsCommand : public ChunkCommandHelper {
@@ -1673,6 +1825,67 @@ namespace mongo {
     MONGO_FP_DECLARE(migrateThreadHangAtStep4);
     MONGO_FP_DECLARE(migrateThreadHangAtStep5);
 
+    /**
+     * Runs _migrateClone against the donor on a thread of its own, so the recipient can ask for
+     * the next batch of documents while it inserts the current one.  One request at most is in
+     * flight, so the donor still sees the requests one after another.
+     */
+    class MigrateCloneFetcher {
+        MONGO_DISALLOW_COPYING(MigrateCloneFetcher);
+    public:
+        explicit MigrateCloneFetcher(DBClientBase* conn)
+            : _conn(conn), _ok(false), _status(Status::OK()) { }
+
+        ~MigrateCloneFetcher() {
+            if (_thread) {
+                _thread->join();
+            }
+        }
+
+        /**
+         * Sends the next _migrateClone.  The previous one must have been wait()ed for.
+         */
+        void start() {
+            invariant(!_thread);
+            _thread.reset(new boost::thread(stdx::bind(&MigrateCloneFetcher::_fetch, this)));
+        }
+
+        /**
+         * Waits for the reply to the request start() sent, returning what runCommand() would
+         * have, and throwing what it would have thrown.
+         */
+        bool wait(BSONObj* res) {
+            invariant(_thread);
+            _thread->join();
+            _thread.reset();
+            uassertStatusOK(_status);
+            *res = _res;
+            return _ok;
+        }
+
+    private:
+        void _fetch() {
+            _res = BSONObj();
+            _status = Status::OK();
+            try {
+                // gets array of objects to copy, in disk order
+                _ok = _conn->runCommand("admin", BSON("_migrateClone" << 1), _res);
+            }
+            catch (const DBException& ex) {
+                _ok = false;
+                _status = ex.toStatus();
+            }
+        }
+
+        DBClientBase* const _conn;
+        scoped_ptr<boost::thread> _thread;
+
+        // Written by the fetching thread, read once it has been joined.
+        bool _ok;
+        BSONObj _res;
+        Status _status;
+    };
+
     class MigrateStatus {
     public:
         enum State {
@@ -1921,9 +2134,12 @@ namespace mongo {
                 // 3. initial bulk clone
                 setState(CLONE);
 
+                MigrateCloneFetcher fetcher(conn.get());
+                fetcher.start();
+
                 while ( true ) {
                     BSONObj res;
-                    if ( ! conn->runCommand( "admin" , BSON( "_migrateClone" << 1 ) , res ) ) {  // gets array of objects to copy, in disk order
+                    if ( ! fetcher.wait( &res ) ) {
                         setState(FAIL);
                         errmsg = "_migrateClone failed: ";
                         errmsg += res.toString();
@@ -1935,6 +2151,10 @@ namespace mongo {
                     BSONObj arr = res["objects"].Obj();
                     int thisTime = 0;
 
+                    // an empty batch means the donor has nothing left to send
+                    if ( ! arr.isEmpty() )
+                        fetcher.start();
+
                     BSONObjIterator i( arr );
                     while( i.more() ) {
                         txn->checkForInterrupt();
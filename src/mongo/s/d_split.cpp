@@ -50,18 +50,66 @@
 #include "mongo/db/instance.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/chunk.h" // for static genID only
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/config.h"
 #include "mongo/s/d_state.h"
 #include "mongo/s/distlock.h"
+#include "mongo/s/range_arithmetic.h"
 #include "mongo/s/shard_key_pattern.h"
+#include "mongo/s/shard_key_sampler.h"
 #include "mongo/s/type_chunk.h"
 #include "mongo/util/log.h"
 #include "mongo/util/timer.h"
 
 namespace mongo {
 
+    // Number of shard keys sampled, as documents are inserted, for each chunk of a sharded
+    // collection.  When non-zero, splitVector picks split points from the sample whenever it
+    // accounts for enough data, rather than scanning the chunk's index range.  0 disables.
+    MONGO_EXPORT_SERVER_PARAMETER(shardKeySampleSize, int, 0);
+
+    namespace {
+        ShardKeySampler shardKeySampler(static_cast<int64_t>(curTimeMillis64()));
+    }
+
+    void noteInsertForSplitting(const char* ns, const BSONObj& doc) {
+        const int sampleSize = shardKeySampleSize;
+        if (sampleSize <= 0 || !shardingState.enabled())
+            return;
+
+        CollectionMetadataPtr metadata = shardingState.getCollectionMetadata(ns);
+        if (!metadata)
+            return;
+
+        const BSONObj key =
+            ShardKeyPattern(metadata->getKeyPattern()).extractShardKeyFromDoc(doc);
+        if (key.isEmpty())
+            return;
+
+        ChunkType chunk;
+        if (!metadata->getNextChunk(key, &chunk) ||
+            !rangeContains(chunk.getMin(), chunk.getMax(), key)) {
+            return;
+        }
+
+        shardKeySampler.noteInsert(ns, chunk.getMin(), chunk.getMax(), key, doc.objsize(),
+                                   sampleSize);
+
+        // Samples of chunks which left the shard are never updated again; drop them once they
+        // outnumber the chunks still here.
+        if (shardKeySampler.numSampledChunks(ns) > 2 * metadata->getNumChunks()) {
+            vector<BSONObj> chunkMins;
+            BSONObj lookupKey = metadata->getMinKey();
+            while (metadata->getNextChunk(lookupKey, &chunk)) {
+                chunkMins.push_back(chunk.getMin());
+                lookupKey = chunk.getMax();
+            }
+            shardKeySampler.retainChunks(ns, chunkMins);
+        }
+    }
+
     class CmdMedianKey : public Command {
     public:
         CmdMedianKey() : Command( "medianKey" ) {}
@@ -216,6 +264,8 @@ namespace mongo {
     public:
         SplitVector() : Command( "splitVector" , false ) {}
         virtual bool slaveOk() const { return false; }
+        // Only reads, so a secondary can split a collection for a cloner syncing from it.
+        virtual bool slaveOverrideOk() const { return true; }
         virtual bool isWriteCommandForConfigServer() const { return false; }
         virtual void help( stringstream &help ) const {
             help <<
@@ -265,6 +315,10 @@ namespace mongo {
                 return false;
             }
 
+            // The chunk's bounds as the shard key sample knows them.
+            const BSONObj chunkMin = min;
+            const BSONObj chunkMax = max;
+
             long long maxSplitPoints = 0;
             BSONElement maxSplitPointsElem = jsobj[ "maxSplitPoints" ];
             if ( maxSplitPointsElem.isNumber() ) {
@@ -372,6 +426,17 @@ namespace mongo {
                     keyCount = maxChunkObjects;
                 }
                 
+                if ( !forceMedianSplit &&
+                     shardKeySampler.pickSplitPoints( ns, chunkMin, chunkMax, maxChunkSize,
+                                                      maxChunkObjects, maxSplitPoints,
+                                                      &splitKeys ) ) {
+                    LOG(1) << "picked " << splitKeys.size() << " split points for chunk " << ns
+                           << " " << min << " -->> " << max << " from the shard key sample"
+                           << endl;
+                    result.append( "splitKeys" , splitKeys );
+                    return true;
+                }
+
                 //
                 // 2. Traverse the index and add the keyCount-th key to the result vector. If that key
                 //    appeared in the vector before, we omit it. The invariant here is that all the
@@ -807,6 +872,7 @@ namespace mongo {
                 newShardVersion.incMinor();
 
                 shardingState.splitChunk(txn, ns, min, max, splitKeys, newShardVersion);
+                shardKeySampler.splitChunk(ns, min, max, splitKeys);
             }
 
             //
@@ -64,6 +64,7 @@
 #include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/log.h"
+#include "mongo/util/scopeguard.h"
 
 
 namespace mongo {
@@ -397,6 +398,40 @@ namespace mongo {
         LOG( 2 ) << "metadata refresh requested for " << ns << " at shard version "
                  << reqShardVersion << endl;
 
+        ChunkVersion storedShardVersion;
+        {
+            scoped_lock lk( _mutex );
+
+            while ( true ) {
+
+                //
+                // Fast path - check if the requested version is at a higher version than the
+                // current metadata version or a different epoch before verifying against config
+                // server.
+                //
+
+                CollectionMetadataMap::iterator it = _collMetadata.find( ns );
+                storedShardVersion = it != _collMetadata.end() ? it->second->getShardVersion() :
+                                                                 ChunkVersion();
+                *latestShardVersion = storedShardVersion;
+
+                if ( storedShardVersion >= reqShardVersion &&
+                     storedShardVersion.epoch() == reqShardVersion.epoch() ) {
+
+                    // Don't need to remotely reload if we're in the same epoch with a >= version
+                    return Status::OK();
+                }
+
+                // Single-flight - if another thread is already reloading this namespace, its
+                // result may be all we need, so wait for it and check again.
+                if ( _refreshesInProgress.insert( ns ).second )
+                    break;
+
+                _refreshFinished.wait( lk.boost() );
+            }
+        }
+        ON_BLOCK_EXIT_OBJ( *this, &ShardingState::_endRefresh, ns );
+
         //
         // Queuing of refresh requests starts here when remote reload is needed. This may take time.
         // TODO: Explicitly expose the queuing discipline.
@@ -405,28 +440,6 @@ namespace mongo {
         _configServerTickets.waitForTicket();
         TicketHolderReleaser needTicketFrom( &_configServerTickets );
 
-        //
-        // Fast path - check if the requested version is at a higher version than the current
-        // metadata version or a different epoch before verifying against config server.
-        //
-
-        CollectionMetadataPtr storedMetadata;
-        {
-            scoped_lock lk( _mutex );
-            CollectionMetadataMap::iterator it = _collMetadata.find( ns );
-            if ( it != _collMetadata.end() ) storedMetadata = it->second;
-        }
-        ChunkVersion storedShardVersion;
-        if ( storedMetadata ) storedShardVersion = storedMetadata->getShardVersion();
-        *latestShardVersion = storedShardVersion;
-
-        if ( storedShardVersion >= reqShardVersion &&
-             storedShardVersion.epoch() == reqShardVersion.epoch() ) {
-
-            // Don't need to remotely reload if we're in the same epoch with a >= version
-            return Status::OK();
-        }
-
         //
         // Slow path - remotely reload
         //
@@ -452,6 +465,12 @@ namespace mongo {
         return doRefreshMetadata(txn, ns, reqShardVersion, true, latestShardVersion);
     }
 
+    void ShardingState::_endRefresh( const string& ns ) {
+        scoped_lock lk( _mutex );
+        _refreshesInProgress.erase( ns );
+        _refreshFinished.notify_all();
+    }
+
     Status ShardingState::refreshMetadataNow(OperationContext* txn,
                                              const string& ns,
                                              ChunkVersion* latestShardVersion) {
@@ -522,15 +541,10 @@ namespace mongo {
         // Determine whether we need to diff or fully reload
         //
 
-        bool fullReload = false;
-        if ( !beforeMetadata ) {
-            // We don't have any metadata to reload from
-            fullReload = true;
-        }
-        else if ( useRequestedVersion && reqShardVersion.epoch() != beforeShardVersion.epoch() ) {
-            // It's not useful to use the metadata as a base because we think the epoch will differ
-            fullReload = true;
-        }
+        // Diffs are always tried when we have metadata to start from - the loader itself falls
+        // back to a full reload when the epoch on the config server isn't ours, even if a stale
+        // client told us about a different one.
+        bool fullReload = !beforeMetadata;
 
         //
         // Load the metadata from the remote server, start construction
@@ -556,6 +570,20 @@ namespace mongo {
                                                  shardName,
                                                  ( fullReload ? NULL : beforeMetadata.get() ),
                                                  remoteMetadataRaw );
+
+        if ( status.code() == ErrorCodes::RemoteChangeDetected && !fullReload ) {
+
+            // The chunks didn't line up with our metadata, which is what happens when the
+            // collection is dropped and recreated between diffs - start from scratch once.
+            LOG( 1 ) << "could not apply metadata diff for " << ns << causedBy( status.reason() )
+                     << ", doing a full reload" << endl;
+
+            fullReload = true;
+            remoteMetadataRaw = new CollectionMetadata();
+            remoteMetadata.reset( remoteMetadataRaw );
+            status = mdLoader.makeCollectionMetadata( ns, shardName, NULL, remoteMetadataRaw );
+        }
+
         long long refreshMillis = refreshTimer.millis();
 
         if ( status.code() == ErrorCodes::NamespaceNotFound ) {
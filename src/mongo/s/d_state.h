@@ -29,6 +29,9 @@
 
 #pragma once
 
+#include <boost/thread/condition.hpp>
+#include <set>
+
 #include "mongo/db/jsobj.h"
 #include "mongo/s/collection_metadata.h"
 #include "mongo/s/chunk_version.h"
@@ -85,6 +88,10 @@ namespace mongo {
          *
          * Otherwise, falls back to refreshMetadataNow.
          *
+         * Only one refresh of a namespace runs at a time through this call; other threads
+         * needing a newer version of the same namespace wait for it and check its result before
+         * reloading themselves.
+         *
          * This call blocks if there are more than N threads
          * currently refreshing metadata. (N is the number of
          * tickets in ShardingState::_configServerTickets,
@@ -290,6 +297,16 @@ namespace mongo {
         // Map from a namespace into the metadata we need for each collection on this shard
         typedef std::map<std::string,CollectionMetadataPtr> CollectionMetadataMap;
         CollectionMetadataMap _collMetadata;
+
+        // Namespaces with a refreshMetadataIfNeeded reload in progress, and the condition their
+        // waiters are woken on when one finishes
+        std::set<std::string> _refreshesInProgress;
+        boost::condition _refreshFinished;
+
+        /**
+         * Marks the reload of 'ns' as finished and wakes the threads waiting for it.
+         */
+        void _endRefresh( const std::string& ns );
     };
 
     extern ShardingState shardingState;
@@ -360,6 +377,12 @@ namespace mongo {
      */
     void ensureShardVersionOKOrThrow(const std::string& ns);
 
+    /**
+     * Feeds the shard key sample splitVector may pick split points from with document 'doc',
+     * just inserted into 'ns'.  Does nothing unless shardKeySampleSize is set and 'ns' is sharded.
+     */
+    void noteInsertForSplitting( const char* ns, const BSONObj& doc );
+
     /**
      * If a migration for the chunk in 'ns' where 'obj' lives is occurring, save this log entry
      * if it's relevant. The entries saved here are later transferred to the receiving side of
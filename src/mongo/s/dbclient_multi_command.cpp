@@ -28,6 +28,9 @@
 
 #include "mongo/s/dbclient_multi_command.h"
 
+#include <set>
+#include <vector>
+
 #include "mongo/bson/mutable/document.h"
 #include "mongo/db/audit.h"
 #include "mongo/db/client_basic.h"
@@ -37,6 +40,8 @@
 #include "mongo/s/write_ops/batched_command_request.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/util/net/message.h"
+#include "mongo/util/net/socket_poll.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
@@ -47,6 +52,8 @@ namespace mongo {
         dbName( dbName.toString() ),
         cmdObj( cmdObj ),
         conn( NULL ),
+        pooled( true ),
+        sent( false ),
         status( Status::OK() ) {
     }
 
@@ -57,6 +64,16 @@ namespace mongo {
         _pendingCommands.push_back( command );
     }
 
+    void DBClientMultiCommand::addCommand( const ConnectionString& endpoint,
+                                           const StringData& dbName,
+                                           const BSONSerializable& request,
+                                           DBClientBase* conn ) {
+        PendingCommand* command = new PendingCommand( endpoint, dbName, request.toBSON() );
+        command->conn = conn;
+        command->pooled = false;
+        _pendingCommands.push_back( command );
+    }
+
     namespace {
 
         //
@@ -79,6 +96,12 @@ namespace mongo {
             return conn->getMinWireVersion() <= BATCH_COMMANDS
                    && conn->getMaxWireVersion() >= BATCH_COMMANDS;
         }
+
+        // A connection with a response still to come can't be used again.
+        void shutDown( DBClientBase* conn ) {
+            DBClientConnection* clientConn = dynamic_cast<DBClientConnection*>( conn );
+            if ( NULL != clientConn ) clientConn->port().shutdown();
+        }
     }
 
     // THROWS
@@ -121,15 +144,20 @@ namespace mongo {
             it != _pendingCommands.end(); ++it ) {
 
             PendingCommand* command = *it;
-            dassert( NULL == command->conn );
+
+            // Already sent, or failed to send, by an earlier sendAll
+            if ( command->sent || !command->status.isOK() ) continue;
+            command->sent = true;
 
             try {
                 dassert( command->endpoint.type() == ConnectionString::MASTER ||
                     command->endpoint.type() == ConnectionString::CUSTOM );
 
-                // TODO: Fix the pool up to take millis directly
-                int timeoutSecs = _timeoutMillis / 1000;
-                command->conn = shardConnectionPool.get( command->endpoint, timeoutSecs );
+                if ( command->pooled ) {
+                    // TODO: Fix the pool up to take millis directly
+                    int timeoutSecs = _timeoutMillis / 1000;
+                    command->conn = shardConnectionPool.get( command->endpoint, timeoutSecs );
+                }
 
                 // Sanity check if we're sending a batch write that we're talking to a new-enough
                 // server.
@@ -142,37 +170,113 @@ namespace mongo {
             }
             catch ( const DBException& ex ) {
                 command->status = ex.toStatus();
+                doneWithConnection( command, false );
+            }
+        }
+    }
 
-                if ( NULL != command->conn ) {
+    void DBClientMultiCommand::doneWithConnection( PendingCommand* command, bool reusable ) {
 
-                    // Confusingly, the pool needs to know about failed connections so that it can
-                    // invalidate other connections which might be bad.  But if the connection
-                    // doesn't seem bad, don't send it back, because we don't want to reuse it.
-                    if ( !command->conn->isFailed() ) {
-                        delete command->conn;
-                    }
-                    else {
-                        shardConnectionPool.release( command->endpoint.toString(), command->conn );
-                    }
+        if ( NULL == command->conn ) return;
 
-                    command->conn = NULL;
-                }
+        if ( command->pooled ) {
+
+            // Confusingly, the pool needs to know about failed connections so that it can
+            // invalidate other connections which might be bad.  But if the connection doesn't
+            // seem bad, don't send it back, because we don't want to reuse it.
+            if ( !reusable && !command->conn->isFailed() ) {
+                shardConnectionPool.decrementEgress( command->endpoint.toString(),
+                                                     command->conn );
+                delete command->conn;
+            }
+            else {
+                shardConnectionPool.release( command->endpoint.toString(), command->conn );
             }
         }
+
+        command->conn = NULL;
     }
 
     int DBClientMultiCommand::numPending() const {
         return static_cast<int>( _pendingCommands.size() );
     }
 
+    DBClientMultiCommand::PendingQueue::iterator
+    DBClientMultiCommand::nextReadyCommand( bool* timedOut ) {
+
+        *timedOut = false;
+
+        // Only the oldest command to each endpoint may be read, so that responses from one
+        // endpoint come back in order.
+        std::set<ConnectionString> seenEndpoints;
+        std::vector<PendingQueue::iterator> candidates;
+        std::vector<pollfd> fds;
+
+        for ( PendingQueue::iterator it = _pendingCommands.begin();
+            it != _pendingCommands.end(); ++it ) {
+
+            PendingCommand* command = *it;
+            if ( !seenEndpoints.insert( command->endpoint ).second ) continue;
+
+            // Errors, and commands we can't poll for, are returned without waiting
+            if ( NULL == command->conn || !command->status.isOK() ) return it;
+            DBClientConnection* conn = dynamic_cast<DBClientConnection*>( command->conn );
+            if ( NULL == conn ) return it;
+
+            pollfd fd;
+            fd.fd = conn->port().psock->rawFD();
+            fd.events = POLLIN;
+            fd.revents = 0;
+            fds.push_back( fd );
+            candidates.push_back( it );
+        }
+
+        dassert( !candidates.empty() );
+        if ( !isPollSupported() ) return candidates.front();
+        if ( candidates.size() == 1u && 0 == _deadlineMillis ) return candidates.front();
+
+        int timeout = _timeoutMillis > 0 ? _timeoutMillis : -1;
+        if ( 0 != _deadlineMillis ) {
+            const unsigned long long now = curTimeMillis64();
+            const int remaining =
+                now >= _deadlineMillis ? 0 : static_cast<int>( _deadlineMillis - now );
+            if ( timeout < 0 || remaining < timeout ) timeout = remaining;
+        }
+        int numReady = socketPoll( &fds[0], fds.size(), timeout );
+
+        if ( 0 == numReady && 0 != _deadlineMillis && curTimeMillis64() >= _deadlineMillis ) {
+            *timedOut = true;
+            return candidates.front();
+        }
+
+        // On timeout or error, fall back to a blocking read of the oldest command, which surfaces
+        // any socket problem through the usual recv path.
+        if ( numReady <= 0 ) return candidates.front();
+
+        for ( size_t i = 0; i < fds.size(); ++i ) {
+            if ( fds[i].revents != 0 ) return candidates[i];
+        }
+
+        return candidates.front();
+    }
+
     Status DBClientMultiCommand::recvAny( ConnectionString* endpoint, BSONSerializable* response ) {
 
-        scoped_ptr<PendingCommand> command( _pendingCommands.front() );
-        _pendingCommands.pop_front();
+        bool timedOut;
+        PendingQueue::iterator readyIt = nextReadyCommand( &timedOut );
+        scoped_ptr<PendingCommand> command( *readyIt );
+        _pendingCommands.erase( readyIt );
 
         *endpoint = command->endpoint;
         if ( !command->status.isOK() ) return command->status;
 
+        if ( timedOut ) {
+            abandonConnection( command.get() );
+            return Status( ErrorCodes::ExceededTimeLimit,
+                           str::stream() << "operation exceeded time limit waiting for "
+                                         << command->endpoint.toString() );
+        }
+
         dassert( NULL != command->conn );
 
         try {
@@ -183,8 +287,7 @@ namespace mongo {
 
             recvAsCmd( command->conn, &toRecv, &result );
 
-            shardConnectionPool.release( command->endpoint.toString(), command->conn );
-            command->conn = NULL;
+            doneWithConnection( command.get(), true );
 
             string errMsg;
             if ( !response->parseBSON( result, &errMsg ) || !response->isValid( &errMsg ) ) {
@@ -192,18 +295,7 @@ namespace mongo {
             }
         }
         catch ( const DBException& ex ) {
-
-            // Confusingly, the pool needs to know about failed connections so that it can
-            // invalidate other connections which might be bad.  But if the connection doesn't seem
-            // bad, don't send it back, because we don't want to reuse it.
-            if ( !command->conn->isFailed() ) {
-                delete command->conn;
-            }
-            else {
-                shardConnectionPool.release( command->endpoint.toString(), command->conn );
-            }
-            command->conn = NULL;
-
+            doneWithConnection( command.get(), false );
             return ex.toStatus();
         }
 
@@ -217,8 +309,7 @@ namespace mongo {
             it != _pendingCommands.end(); ++it ) {
 
             PendingCommand* command = *it;
-
-            if ( NULL != command->conn ) delete command->conn;
+            abandonConnection( command );
             delete command;
             command = NULL;
         }
@@ -226,7 +317,26 @@ namespace mongo {
         _pendingCommands.clear();
     }
 
+    void DBClientMultiCommand::abandonConnection( PendingCommand* command ) {
+
+        if ( NULL == command->conn ) return;
+
+        if ( command->pooled ) {
+            shardConnectionPool.decrementEgress( command->endpoint.toString(), command->conn );
+            delete command->conn;
+        }
+        else if ( command->sent ) {
+            shutDown( command->conn );
+        }
+
+        command->conn = NULL;
+    }
+
     void DBClientMultiCommand::setTimeoutMillis( int milliSecs ) {
         _timeoutMillis = milliSecs;
     }
+
+    void DBClientMultiCommand::setMaxTimeMillis( int milliSecs ) {
+        _deadlineMillis = milliSecs > 0 ? curTimeMillis64() + milliSecs : 0;
+    }
 }
@@ -44,7 +44,7 @@ namespace mongo {
     class DBClientMultiCommand : public MultiCommandDispatch {
     public:
 
-        DBClientMultiCommand() : _timeoutMillis( 0 ) {}
+        DBClientMultiCommand() : _timeoutMillis( 0 ), _deadlineMillis( 0 ) {}
 
         ~DBClientMultiCommand();
 
@@ -52,6 +52,17 @@ namespace mongo {
                          const StringData& dbName,
                          const BSONSerializable& request );
 
+        /**
+         * As above, but sends over 'conn' rather than a pooled connection.  The caller keeps
+         * ownership of 'conn', and must not use it until the response has been received.  If a
+         * response is abandoned at the deadline the connection is shut down, since it would
+         * otherwise read that response later.
+         */
+        void addCommand( const ConnectionString& endpoint,
+                         const StringData& dbName,
+                         const BSONSerializable& request,
+                         DBClientBase* conn );
+
         void sendAll();
 
         int numPending() const;
@@ -60,6 +71,13 @@ namespace mongo {
 
         void setTimeoutMillis( int milliSecs );
 
+        /**
+         * Gives up on responses which have not arrived 'milliSecs' from now, reporting them as
+         * ExceededTimeLimit, so that a command's maxTimeMS bounds the whole fan-out however many
+         * hosts are slow.  0 means no limit.
+         */
+        void setMaxTimeMillis( int milliSecs );
+
     private:
 
         // All info associated with an pre- or in-flight command
@@ -74,16 +92,40 @@ namespace mongo {
             const std::string dbName;
             const BSONObj cmdObj;
 
-            // Where to send it
+            // Where to send it, and whether that came from the shard connection pool
             DBClientBase* conn;
+            bool pooled;
+            bool sent;
 
             // If anything goes wrong
             Status status;
         };
 
         typedef std::deque<PendingCommand*> PendingQueue;
+
+        /**
+         * Returns the sent command whose response should be read next - the oldest command of an
+         * endpoint whose connection has a response ready, preferring earlier commands.  Blocks
+         * until some such response arrives, or the deadline passes, when '*timedOut' is set.
+         */
+        PendingQueue::iterator nextReadyCommand( bool* timedOut );
+
+        /**
+         * Gives back or gets rid of the connection of a finished command.  A connection is only
+         * reused if 'reusable'.
+         */
+        void doneWithConnection( PendingCommand* command, bool reusable );
+
+        /**
+         * Gets rid of the connection of a command whose response will not be read.
+         */
+        void abandonConnection( PendingCommand* command );
+
         PendingQueue _pendingCommands;
         int _timeoutMillis;
+
+        // In curTimeMillis64 terms, or 0 for none
+        unsigned long long _deadlineMillis;
     };
 
 }
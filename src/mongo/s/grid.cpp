@@ -184,6 +184,18 @@ namespace mongo {
 
     }
 
+    DBConfigPtr Grid::getDBConfigIfLoaded( const StringData& db ) {
+        if ( db == "config" )
+            return configServerPtr;
+
+        scoped_lock l( _lock );
+
+        map<string,DBConfigPtr>::const_iterator it = _databases.find( db.toString() );
+        if ( it == _databases.end() )
+            return DBConfigPtr();
+        return it->second;
+    }
+
     void Grid::removeDBIfExists( const DBConfig& database ) {
 
         scoped_lock l( _lock );
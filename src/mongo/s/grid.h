@@ -54,6 +54,12 @@ namespace mongo {
          */
         DBConfigPtr getDBConfig( const StringData& ns , bool create=true , const std::string& shardNameHint="" );
 
+        /**
+         * gets the config of the db if this process has already loaded it, without going to the
+         * config servers.  Returns an empty pointer otherwise.
+         */
+        DBConfigPtr getDBConfigIfLoaded( const StringData& db );
+
         /**
          * removes db entry.
          * on next getDBConfig call will fetch from db
@@ -56,11 +56,13 @@
 #include "mongo/db/log_process_details.h"
 #include "mongo/db/operation_context_noop.h"
 #include "mongo/db/startup_warnings_common.h"
+#include "mongo/logger/async_log_queue.h"
 #include "mongo/platform/process_id.h"
 #include "mongo/s/balance.h"
 #include "mongo/s/chunk.h"
 #include "mongo/s/client_info.h"
 #include "mongo/s/config.h"
+#include "mongo/s/config_change_watcher.h"
 #include "mongo/s/config_server_checker_service.h"
 #include "mongo/s/config_upgrade.h"
 #include "mongo/s/cursors.h"
@@ -183,6 +185,20 @@ namespace mongo {
         virtual void disconnected( AbstractMessagingPort* p ) {
             // all things are thread local
         }
+
+        virtual bool supportsConnectionHandoff() const { return true; }
+
+        virtual void* suspendConnection( AbstractMessagingPort* p ) {
+            return ClientInfo::releaseCurrent();
+        }
+
+        virtual void resumeConnection( AbstractMessagingPort* p, void* state ) {
+            ClientInfo::setCurrent( static_cast<ClientInfo*>( state ) );
+        }
+
+        virtual void destroyConnection( void* state ) {
+            delete static_cast<ClientInfo*>( state );
+        }
     };
 
     void start( const MessageServer::Options& opts ) {
@@ -190,6 +206,8 @@ namespace mongo {
         cursorCache.startTimeoutThread();
         UserCacheInvalidator cacheInvalidatorThread(getGlobalAuthorizationManager());
         cacheInvalidatorThread.go();
+        ConfigChangeWatcher configChangeWatcherThread;
+        configChangeWatcherThread.go();
 
         PeriodicTask::startRunningPeriodicTasks();
 
@@ -489,6 +507,7 @@ void mongo::dbexit( ExitCode rc, const char *why ) {
     log() << "dbexit: " << why
           << " rc:" << rc
           << endl;
+    logger::AsyncLogQueue::flushAll();
     flushForGcov();
     quickExit(rc);
 }
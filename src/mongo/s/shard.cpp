@@ -495,6 +495,11 @@ namespace mongo {
     ShardStatus::ShardStatus( const Shard& shard , const BSONObj& obj )
         : _shard( shard ) {
         _mapped = obj.getFieldDotted( "mem.mapped" ).numberLong();
+        _opCount = 0;
+        BSONObjIterator ops( obj.getObjectField( "opcounters" ) );
+        while ( ops.more() ) {
+            _opCount += ops.next().numberLong();
+        }
         _writeLock = 0; // TODO
         _mongoVersion = obj["version"].String();
     }
@@ -201,6 +201,7 @@ namespace mongo {
             ss << "shard: " << _shard 
                << " mapped: " << _mapped 
                << " writeLock: " << _writeLock
+               << " opCount: " << _opCount
                << " version: " << _mongoVersion;
             return ss.str();
         }
@@ -221,9 +222,15 @@ namespace mongo {
             return _mongoVersion;
         }
 
+        /** @return the sum of the shard's opcounters */
+        long long opCount() const {
+            return _opCount;
+        }
+
     private:
         Shard _shard;
         long long _mapped;
+        long long _opCount;
         double _writeLock;
         std::string _mongoVersion;
     };
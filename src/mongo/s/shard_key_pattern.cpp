@@ -110,14 +110,28 @@ namespace mongo {
         return parsedPaths.release();
     }
 
+    static bool hasOnlyTopLevelPaths(const vector<FieldRef*>& paths) {
+        if (paths.empty())
+            return false;
+
+        for (vector<FieldRef*>::const_iterator it = paths.begin(); it != paths.end(); ++it) {
+            if ((*it)->numParts() != 1)
+                return false;
+        }
+
+        return true;
+    }
+
     ShardKeyPattern::ShardKeyPattern(const BSONObj& keyPattern)
         : _keyPatternPaths(parseShardKeyPattern(keyPattern)),
-          _keyPattern(_keyPatternPaths.empty() ? BSONObj() : keyPattern) {
+          _keyPattern(_keyPatternPaths.empty() ? BSONObj() : keyPattern),
+          _topLevelPaths(hasOnlyTopLevelPaths(_keyPatternPaths.vector())) {
     }
 
     ShardKeyPattern::ShardKeyPattern(const KeyPattern& keyPattern)
         : _keyPatternPaths(parseShardKeyPattern(keyPattern.toBSON())),
-          _keyPattern(_keyPatternPaths.empty() ? KeyPattern(BSONObj()) : keyPattern) {
+          _keyPattern(_keyPatternPaths.empty() ? KeyPattern(BSONObj()) : keyPattern),
+          _topLevelPaths(hasOnlyTopLevelPaths(_keyPatternPaths.vector())) {
     }
 
     bool ShardKeyPattern::isValid() const {
@@ -216,6 +230,21 @@ namespace mongo {
         return matchEl;
     }
 
+    static void appendShardKeyElement(const BSONElement& patternEl,
+                                      const BSONElement& matchEl,
+                                      BSONObjBuilder* keyBuilder) {
+        if (isHashedPatternEl(patternEl)) {
+            keyBuilder->append(patternEl.fieldName(),
+                               BSONElementHasher::hash64(matchEl,
+                                                         BSONElementHasher::DEFAULT_HASH_SEED));
+        }
+        else {
+            // NOTE: The matched element may *not* have the same field name as the path -
+            // index keys don't contain field names, for example
+            keyBuilder->appendAs(matchEl, patternEl.fieldName());
+        }
+    }
+
     BSONObj //
     ShardKeyPattern::extractShardKeyFromMatchable(const MatchableDocument& matchable) const {
 
@@ -234,16 +263,7 @@ namespace mongo {
             if (!isShardKeyElement(matchEl, true))
                 return BSONObj();
 
-            if (isHashedPatternEl(patternEl)) {
-                keyBuilder.append(patternEl.fieldName(),
-                                  BSONElementHasher::hash64(matchEl,
-                                                            BSONElementHasher::DEFAULT_HASH_SEED));
-            }
-            else {
-                // NOTE: The matched element may *not* have the same field name as the path -
-                // index keys don't contain field names, for example
-                keyBuilder.appendAs(matchEl, patternEl.fieldName());
-            }
+            appendShardKeyElement(patternEl, matchEl, &keyBuilder);
         }
 
         dassert(isShardKey(keyBuilder.asTempObj()));
@@ -251,8 +271,52 @@ namespace mongo {
     }
 
     BSONObj ShardKeyPattern::extractShardKeyFromDoc(const BSONObj& doc) const {
-        BSONMatchableDocument matchable(doc);
-        return extractShardKeyFromMatchable(matchable);
+
+        if (!_topLevelPaths) {
+            BSONMatchableDocument matchable(doc);
+            return extractShardKeyFromMatchable(matchable);
+        }
+
+        // Every key field is a top-level field of the document, which finds the same elements
+        // as the path traversal above (arrays are not expanded) without its setup per field.
+        BSONObjBuilder keyBuilder(64);
+
+        BSONObjIterator patternIt(_keyPattern.toBSON());
+        while (patternIt.more()) {
+
+            BSONElement patternEl = patternIt.next();
+            BSONElement docEl = doc.getField(patternEl.fieldNameStringData());
+
+            if (!isShardKeyElement(docEl, true))
+                return BSONObj();
+
+            appendShardKeyElement(patternEl, docEl, &keyBuilder);
+        }
+
+        dassert(isShardKey(keyBuilder.asTempObj()));
+        return keyBuilder.obj();
+    }
+
+    bool ShardKeyPattern::extractHashFromDoc(const BSONObj& doc, long long* hash) const {
+
+        invariant(isHashedPattern());
+
+        const BSONElement patternEl = _keyPattern.toBSON().firstElement();
+
+        BSONElement docEl;
+        if (_topLevelPaths) {
+            docEl = doc.getField(patternEl.fieldNameStringData());
+        }
+        else {
+            BSONMatchableDocument matchable(doc);
+            docEl = extractKeyElementFromMatchable(matchable, patternEl.fieldNameStringData());
+        }
+
+        if (!isShardKeyElement(docEl, true))
+            return false;
+
+        *hash = BSONElementHasher::hash64(docEl, BSONElementHasher::DEFAULT_HASH_SEED);
+        return true;
     }
 
     static BSONElement findEqualityElement(const EqualityMatches& equalities,
@@ -138,6 +138,13 @@ namespace mongo {
          */
         BSONObj extractShardKeyFromDoc(const BSONObj& doc) const;
 
+        /**
+         * For a hashed key pattern, sets '*hash' to the hashed value of the document's key
+         * field, i.e. the value extractShardKeyFromDoc() would return in a NumberLong, without
+         * building the key.  Returns false if the document has no valid shard key.
+         */
+        bool extractHashFromDoc(const BSONObj& doc, long long* hash) const;
+
         /**
          * Given a simple BSON query, extracts the shard key corresponding to the key pattern
          * from equality matches in the query.  The query expression *must not* be a complex query
@@ -224,6 +231,10 @@ namespace mongo {
         const OwnedPointerVector<FieldRef> _keyPatternPaths;
 
         const KeyPattern _keyPattern;
+
+        // True if no path in the key pattern is dotted, so that extractShardKeyFromDoc() can look
+        // the key fields up directly rather than through path traversal
+        const bool _topLevelPaths;
     };
 
 }
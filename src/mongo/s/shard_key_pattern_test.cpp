@@ -29,6 +29,7 @@
 
 #include "mongo/db/hasher.h"
 #include "mongo/db/json.h"
+#include "mongo/db/matcher/matchable.h"
 #include "mongo/unittest/unittest.h"
 
 namespace {
@@ -242,6 +243,40 @@ namespace {
         ASSERT_EQUALS(docKey(pattern, BSON("a" << BSON("c" << value))), BSONObj());
         ASSERT_EQUALS(docKey(pattern, BSON("a" << BSON("b" << BSON_ARRAY(value)))), BSONObj());
         ASSERT_EQUALS(docKey(pattern, BSON("a" << BSON_ARRAY(BSON("b" << value)))), BSONObj());
+
+        // The raw hash is the value of the extracted key
+        long long hash = 0;
+        ASSERT(pattern.extractHashFromDoc(BSON("a" << BSON("b" << value)), &hash));
+        ASSERT_EQUALS(hash, hashValue);
+        ASSERT(!pattern.extractHashFromDoc(BSON("a" << BSON("c" << value)), &hash));
+
+        ShardKeyPattern topLevel(BSON("a" << "hashed"));
+        ASSERT(topLevel.extractHashFromDoc(BSON("c" << 30 << "a" << value), &hash));
+        ASSERT_EQUALS(hash, hashValue);
+        ASSERT(!topLevel.extractHashFromDoc(BSON("a" << BSON_ARRAY(value)), &hash));
+    }
+
+    TEST(ShardKeyPattern, ExtractDocShardKeyTopLevelMatchesTraversal) {
+
+        //
+        // Top-level key patterns look the key fields up directly, which must extract the same
+        // keys as path traversal does
+        //
+
+        ShardKeyPattern single(BSON("a" << 1));
+        ShardKeyPattern compound(BSON("a" << 1 << "b" << 1));
+        ShardKeyPattern hashed(BSON("a" << "hashed"));
+
+        const char* docs[] = { "{a:10, b:'20'}", "{b:'20', a:{c:1}}", "{a:[1, 2], b:1}",
+                               "{a:{$gt:10}, b:1}", "{b:1}", "{}", "{a:null, b:[]}" };
+
+        for (size_t i = 0; i < sizeof(docs) / sizeof(docs[0]); ++i) {
+            const BSONObj doc = fromjson(docs[i]);
+            const BSONMatchableDocument matchable(doc);
+            ASSERT_EQUALS(docKey(single, doc), single.extractShardKeyFromMatchable(matchable));
+            ASSERT_EQUALS(docKey(compound, doc), compound.extractShardKeyFromMatchable(matchable));
+            ASSERT_EQUALS(docKey(hashed, doc), hashed.extractShardKeyFromMatchable(matchable));
+        }
     }
 
     static BSONObj queryKey(const ShardKeyPattern& pattern, const BSONObj& query) {
@@ -0,0 +1,218 @@
+/*    Copyright 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/s/shard_key_sampler.h"
+
+#include <algorithm>
+
+namespace mongo {
+
+    using std::string;
+    using std::vector;
+
+    ShardKeySampler::ShardKeySampler(int64_t seed) : _random(seed) { }
+
+    void ShardKeySampler::noteInsert(const string& ns,
+                                     const BSONObj& min,
+                                     const BSONObj& max,
+                                     const BSONObj& key,
+                                     int bytes,
+                                     size_t sampleSize) {
+        if (sampleSize == 0)
+            return;
+
+        boost::mutex::scoped_lock lk(_mutex);
+
+        ChunkSampleMap& chunks = _samples[ns];
+        ChunkSampleMap::iterator it = chunks.find(min);
+        if (it == chunks.end()) {
+            it = chunks.insert(make_pair(min.getOwned(), ChunkSample())).first;
+            it->second.max = max.getOwned();
+        }
+        else if (it->second.max.woCompare(max) != 0) {
+            it->second = ChunkSample();
+            it->second.max = max.getOwned();
+        }
+
+        ChunkSample& sample = it->second;
+        sample.docs++;
+        sample.bytes += bytes;
+
+        // Reservoir sampling: the n-th key replaces a random one with probability size / n.
+        if (sample.keys.size() < sampleSize) {
+            sample.keys.push_back(key.getOwned());
+        }
+        else {
+            const uint64_t slot = static_cast<uint64_t>(_random.nextInt64()) % sample.docs;
+            if (slot < sample.keys.size()) {
+                sample.keys[slot] = key.getOwned();
+            }
+        }
+    }
+
+    void ShardKeySampler::splitChunk(const string& ns,
+                                     const BSONObj& min,
+                                     const BSONObj& max,
+                                     const vector<BSONObj>& splitKeys) {
+        boost::mutex::scoped_lock lk(_mutex);
+
+        NamespaceSampleMap::iterator nsIt = _samples.find(ns);
+        if (nsIt == _samples.end())
+            return;
+
+        ChunkSampleMap& chunks = nsIt->second;
+        ChunkSampleMap::iterator it = chunks.find(min);
+        if (it == chunks.end())
+            return;
+
+        ChunkSample whole = it->second;
+        chunks.erase(it);
+        if (whole.max.woCompare(max) != 0)
+            return;
+
+        vector<BSONObj> sortedKeys(whole.keys);
+        std::sort(sortedKeys.begin(), sortedKeys.end(), BSONObjCmp());
+
+        vector<BSONObj> bounds;
+        bounds.push_back(min);
+        bounds.insert(bounds.end(), splitKeys.begin(), splitKeys.end());
+        bounds.push_back(max);
+
+        vector<BSONObj>::const_iterator keyIt = sortedKeys.begin();
+        for (size_t i = 0; i + 1 < bounds.size(); i++) {
+            ChunkSample piece;
+            piece.max = bounds[i + 1].getOwned();
+            while (keyIt != sortedKeys.end() && keyIt->woCompare(bounds[i + 1]) < 0) {
+                piece.keys.push_back(*keyIt);
+                ++keyIt;
+            }
+
+            if (!sortedKeys.empty()) {
+                const double share = static_cast<double>(piece.keys.size()) / sortedKeys.size();
+                piece.docs = static_cast<long long>(whole.docs * share);
+                piece.bytes = static_cast<long long>(whole.bytes * share);
+            }
+
+            chunks.insert(make_pair(bounds[i].getOwned(), piece));
+        }
+    }
+
+    bool ShardKeySampler::pickSplitPoints(const string& ns,
+                                          const BSONObj& min,
+                                          const BSONObj& max,
+                                          long long maxChunkSize,
+                                          long long maxChunkObjects,
+                                          long long maxSplitPoints,
+                                          vector<BSONObj>* splitKeys) const {
+        if (maxChunkSize <= 0)
+            return false;
+
+        vector<BSONObj> sortedKeys;
+        long long docs;
+        long long bytes;
+        {
+            boost::mutex::scoped_lock lk(_mutex);
+
+            NamespaceSampleMap::const_iterator nsIt = _samples.find(ns);
+            if (nsIt == _samples.end())
+                return false;
+
+            ChunkSampleMap::const_iterator it = nsIt->second.find(min);
+            if (it == nsIt->second.end() || it->second.max.woCompare(max) != 0)
+                return false;
+
+            sortedKeys = it->second.keys;
+            docs = it->second.docs;
+            bytes = it->second.bytes;
+        }
+
+        if (bytes < maxChunkSize || sortedKeys.size() < 2)
+            return false;
+
+        std::sort(sortedKeys.begin(), sortedKeys.end(), BSONObjCmp());
+
+        // Like the scan, aim for pieces of half the maximum size so that they have room to grow.
+        long long numPieces = bytes / (maxChunkSize / 2);
+        if (maxChunkObjects > 0) {
+            numPieces = std::max(numPieces, docs / std::max(maxChunkObjects / 2, 1LL));
+        }
+        numPieces = std::min(numPieces, static_cast<long long>(sortedKeys.size()));
+
+        vector<BSONObj> picked;
+        for (long long i = 1; i < numPieces; i++) {
+            const BSONObj& key = sortedKeys[i * sortedKeys.size() / numPieces];
+
+            // All the documents with a given key must stay in the same chunk, and a chunk cannot
+            // start at its own min.
+            if (key.woCompare(picked.empty() ? min : picked.back()) == 0)
+                continue;
+
+            picked.push_back(key);
+            if (maxSplitPoints && static_cast<long long>(picked.size()) >= maxSplitPoints)
+                break;
+        }
+
+        if (picked.empty())
+            return false;
+
+        splitKeys->swap(picked);
+        return true;
+    }
+
+    void ShardKeySampler::retainChunks(const string& ns, const vector<BSONObj>& chunkMins) {
+        boost::mutex::scoped_lock lk(_mutex);
+
+        NamespaceSampleMap::iterator nsIt = _samples.find(ns);
+        if (nsIt == _samples.end())
+            return;
+
+        ChunkSampleMap kept;
+        for (vector<BSONObj>::const_iterator i = chunkMins.begin(); i != chunkMins.end(); ++i) {
+            ChunkSampleMap::iterator it = nsIt->second.find(*i);
+            if (it != nsIt->second.end()) {
+                kept.insert(*it);
+            }
+        }
+
+        if (kept.empty()) {
+            _samples.erase(nsIt);
+        }
+        else {
+            nsIt->second.swap(kept);
+        }
+    }
+
+    size_t ShardKeySampler::numSampledChunks(const string& ns) const {
+        boost::mutex::scoped_lock lk(_mutex);
+
+        NamespaceSampleMap::const_iterator nsIt = _samples.find(ns);
+        return nsIt == _samples.end() ? 0 : nsIt->second.size();
+    }
+
+}  // namespace mongo
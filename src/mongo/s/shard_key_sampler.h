@@ -0,0 +1,125 @@
+/*    Copyright 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <boost/thread/mutex.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/random.h"
+
+namespace mongo {
+
+    /**
+     * Keeps, for each chunk a shard owns, a fixed-size uniform sample (a reservoir) of the shard
+     * keys of the documents inserted into it, along with how many documents and bytes were
+     * inserted.  splitVector uses it to pick split points from the sample rather than scanning
+     * the chunk's index range.
+     *
+     * The sample only knows about documents inserted while this process was up, so its counts
+     * are a lower bound on the chunk's contents: callers fall back to scanning whenever the
+     * sample does not account for enough data on its own.
+     *
+     * Chunks are identified by their [min, max) bounds; an insert into bounds which differ from
+     * the ones on record (the chunk was split or merged elsewhere) starts a fresh sample.
+     *
+     * Thread safe.
+     */
+    class ShardKeySampler {
+        MONGO_DISALLOW_COPYING(ShardKeySampler);
+    public:
+        explicit ShardKeySampler(int64_t seed);
+
+        /**
+         * Records the insert of a document of 'bytes' bytes with shard key 'key' into chunk
+         * [min, max) of 'ns', keeping at most 'sampleSize' keys for the chunk.
+         */
+        void noteInsert(const std::string& ns,
+                        const BSONObj& min,
+                        const BSONObj& max,
+                        const BSONObj& key,
+                        int bytes,
+                        size_t sampleSize);
+
+        /**
+         * Splits the sample of chunk [min, max) of 'ns' along with the chunk, at 'splitKeys'
+         * (sorted, strictly inside the chunk).  The documents and bytes recorded for the chunk
+         * are shared out in proportion to the sampled keys that land in each piece.
+         */
+        void splitChunk(const std::string& ns,
+                        const BSONObj& min,
+                        const BSONObj& max,
+                        const std::vector<BSONObj>& splitKeys);
+
+        /**
+         * Fills 'splitKeys' with split points which cut chunk [min, max) of 'ns' into pieces of
+         * about half 'maxChunkSize' bytes and at most half 'maxChunkObjects' documents (0 means
+         * no limit), returning at most 'maxSplitPoints' of them (0 means no limit).
+         *
+         * Returns false, leaving 'splitKeys' alone, if the sample cannot answer: there is no
+         * sample for these bounds, or the inserts it saw do not add up to 'maxChunkSize'.
+         */
+        bool pickSplitPoints(const std::string& ns,
+                             const BSONObj& min,
+                             const BSONObj& max,
+                             long long maxChunkSize,
+                             long long maxChunkObjects,
+                             long long maxSplitPoints,
+                             std::vector<BSONObj>* splitKeys) const;
+
+        /**
+         * Drops the samples of 'ns' whose min is not in 'chunkMins', e.g. chunks migrated away.
+         */
+        void retainChunks(const std::string& ns, const std::vector<BSONObj>& chunkMins);
+
+        /** @return the number of chunks of 'ns' with a sample */
+        size_t numSampledChunks(const std::string& ns) const;
+
+    private:
+        struct ChunkSample {
+            ChunkSample() : docs(0), bytes(0) { }
+
+            BSONObj max;
+            long long docs;
+            long long bytes;
+            std::vector<BSONObj> keys;
+        };
+
+        // chunk min -> sample of the chunk
+        typedef std::map<BSONObj, ChunkSample, BSONObjCmp> ChunkSampleMap;
+        typedef std::map<std::string, ChunkSampleMap> NamespaceSampleMap;
+
+        mutable boost::mutex _mutex;
+        PseudoRandom _random;
+        NamespaceSampleMap _samples;
+    };
+
+}  // namespace mongo
@@ -0,0 +1,135 @@
+/*    Copyright 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/s/shard_key_sampler.h"
+
+#include <cstdlib>
+
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+    using mongo::BSONObj;
+    using mongo::ShardKeySampler;
+    using std::vector;
+
+    const char* const kNs = "test.foo";
+
+    BSONObj key(int x) {
+        return BSON("x" << x);
+    }
+
+    // Inserts one document of 'bytes' bytes for each key in [from, to) into chunk [min, max).
+    void insertRange(ShardKeySampler* sampler, const BSONObj& min, const BSONObj& max,
+                     int from, int to, int bytes, size_t sampleSize) {
+        for (int i = from; i < to; i++) {
+            sampler->noteInsert(kNs, min, max, key(i), bytes, sampleSize);
+        }
+    }
+
+    TEST(ShardKeySampler, NoSampleNoSplitPoints) {
+        ShardKeySampler sampler(1);
+        vector<BSONObj> splitKeys;
+        ASSERT_FALSE(sampler.pickSplitPoints(kNs, key(0), key(100), 1000, 0, 0, &splitKeys));
+
+        // Not enough data seen for the chunk to need splitting.
+        insertRange(&sampler, key(0), key(100), 0, 100, 5, 50);
+        ASSERT_FALSE(sampler.pickSplitPoints(kNs, key(0), key(100), 1000, 0, 0, &splitKeys));
+        ASSERT_TRUE(splitKeys.empty());
+
+        // Different bounds from the sampled chunk.
+        ASSERT_FALSE(sampler.pickSplitPoints(kNs, key(0), key(50), 100, 0, 0, &splitKeys));
+    }
+
+    TEST(ShardKeySampler, SplitPointsFromUniformInserts) {
+        ShardKeySampler sampler(1);
+        insertRange(&sampler, key(0), key(10000), 0, 10000, 100, 200);
+
+        // 1MB seen in a chunk allowed 250KB: pieces of about 125KB, i.e. 8 pieces.
+        vector<BSONObj> splitKeys;
+        ASSERT_TRUE(sampler.pickSplitPoints(kNs, key(0), key(10000), 250 * 1000, 0, 0,
+                                            &splitKeys));
+        ASSERT_EQUALS(7U, splitKeys.size());
+
+        for (size_t i = 0; i < splitKeys.size(); i++) {
+            const int x = splitKeys[i]["x"].numberInt();
+            const int expected = static_cast<int>((i + 1) * 10000 / 8);
+            ASSERT_LESS_THAN(std::abs(x - expected), 500);
+            if (i > 0) {
+                ASSERT_LESS_THAN(splitKeys[i - 1]["x"].numberInt(), x);
+            }
+        }
+
+        // At most 'maxSplitPoints' are returned.
+        ASSERT_TRUE(sampler.pickSplitPoints(kNs, key(0), key(10000), 250 * 1000, 0, 3,
+                                            &splitKeys));
+        ASSERT_EQUALS(3U, splitKeys.size());
+    }
+
+    TEST(ShardKeySampler, RepeatedKeysAreNotSplitPoints) {
+        ShardKeySampler sampler(1);
+        for (int i = 0; i < 1000; i++) {
+            sampler.noteInsert(kNs, key(0), key(100), key(7), 100, 100);
+        }
+
+        vector<BSONObj> splitKeys;
+        ASSERT_TRUE(sampler.pickSplitPoints(kNs, key(0), key(100), 10 * 1000, 0, 0,
+                                            &splitKeys));
+        ASSERT_EQUALS(1U, splitKeys.size());
+        ASSERT_EQUALS(7, splitKeys[0]["x"].numberInt());
+    }
+
+    TEST(ShardKeySampler, SplitChunkSharesOutSample) {
+        ShardKeySampler sampler(1);
+        insertRange(&sampler, key(0), key(1000), 0, 1000, 100, 1000);
+
+        vector<BSONObj> splitAt;
+        splitAt.push_back(key(250));
+        sampler.splitChunk(kNs, key(0), key(1000), splitAt);
+        ASSERT_EQUALS(2U, sampler.numSampledChunks(kNs));
+
+        // The pieces carry 25KB and 75KB: only the upper one is over a 50KB maximum.
+        vector<BSONObj> splitKeys;
+        ASSERT_FALSE(sampler.pickSplitPoints(kNs, key(0), key(250), 50 * 1000, 0, 0,
+                                             &splitKeys));
+        ASSERT_TRUE(sampler.pickSplitPoints(kNs, key(250), key(1000), 50 * 1000, 0, 0,
+                                            &splitKeys));
+        ASSERT_EQUALS(2U, splitKeys.size());
+        ASSERT_EQUALS(500, splitKeys[0]["x"].numberInt());
+        ASSERT_EQUALS(750, splitKeys[1]["x"].numberInt());
+
+        // A stale sample for bounds which changed elsewhere starts over.
+        sampler.noteInsert(kNs, key(250), key(600), key(300), 100, 1000);
+        ASSERT_FALSE(sampler.pickSplitPoints(kNs, key(250), key(600), 50, 0, 0, &splitKeys));
+
+        vector<BSONObj> kept;
+        kept.push_back(key(0));
+        sampler.retainChunks(kNs, kept);
+        ASSERT_EQUALS(1U, sampler.numSampledChunks(kNs));
+    }
+
+}  // namespace
@@ -0,0 +1,254 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kSharding
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/s/shard_reply_waiter.h"
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/once.hpp>
+#include <boost/thread/thread.hpp>
+#include <map>
+
+#ifdef __linux__
+# include <sys/epoll.h>
+#endif
+
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+namespace {
+
+    // Threads which run the continuations of requests whose shard replied. 0 waits for shard
+    // replies on the thread of the request instead.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(shardReplyWaiterThreads, int, 4);
+
+    AtomicInt64 waitsStarted;
+    AtomicInt64 waitsTimedOut;
+
+#ifdef __linux__
+
+    class Reactor {
+    public:
+        Reactor() : _epollFD(-1) {}
+
+        bool start() {
+            _epollFD = epoll_create(1024);
+            if (_epollFD < 0) {
+                error() << "epoll_create failed, waiting for shard replies on request threads: "
+                        << errnoWithDescription() << std::endl;
+                return false;
+            }
+            _workers.reset(new ThreadPool(shardReplyWaiterThreads, "shardReplyWorker"));
+            boost::thread(&Reactor::_loop, this).detach();
+            return true;
+        }
+
+        bool add(int fd, double timeoutSecs, const ShardReplyWaiter::Continuation& continuation) {
+            Waiter waiter;
+            waiter.continuation = continuation;
+            waiter.deadlineMillis = timeoutSecs > 0 ?
+                curTimeMillis64() + static_cast<long long>(timeoutSecs * 1000) : 0;
+
+            boost::mutex::scoped_lock lk(_mutex);
+            _waiters[fd] = waiter;
+
+            epoll_event ev;
+            memset(&ev, 0, sizeof(ev));
+            ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+            ev.data.fd = fd;
+            if (epoll_ctl(_epollFD, EPOLL_CTL_ADD, fd, &ev) != 0) {
+                _waiters.erase(fd);
+                warning() << "epoll_ctl failed, waiting for the shard reply on the request thread: "
+                          << errnoWithDescription() << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        struct Waiter {
+            ShardReplyWaiter::Continuation continuation;
+            long long deadlineMillis; // 0 for none
+        };
+
+        typedef std::map<int, Waiter> WaiterMap;
+
+        void _loop() {
+            setThreadName("shardReplyReactor");
+
+            const int kMaxEvents = 256;
+            const int kTimeoutCheckMillis = 100;
+            epoll_event events[kMaxEvents];
+            long long lastTimeoutCheck = curTimeMillis64();
+
+            while (!inShutdown()) {
+                const int n = epoll_wait(_epollFD, events, kMaxEvents, kTimeoutCheckMillis);
+                if (n < 0 && errno != EINTR) {
+                    error() << "epoll_wait failed: " << errnoWithDescription() << std::endl;
+                    sleepmillis(10);
+                }
+
+                for (int i = 0; i < n; i++) {
+                    _finish(events[i].data.fd, true);
+                }
+
+                const long long now = curTimeMillis64();
+                if (now - lastTimeoutCheck >= kTimeoutCheckMillis) {
+                    lastTimeoutCheck = now;
+                    _timeOut(now);
+                }
+            }
+        }
+
+        /**
+         * Stops watching 'fd' and hands its continuation to a worker. Any continuation runs only
+         * after the socket has left the epoll set, so it may close the socket.
+         */
+        void _finish(int fd, bool readable) {
+            ShardReplyWaiter::Continuation continuation;
+            {
+                boost::mutex::scoped_lock lk(_mutex);
+                WaiterMap::iterator it = _waiters.find(fd);
+                if (it == _waiters.end()) {
+                    return;
+                }
+                continuation.swap(it->second.continuation);
+                _waiters.erase(it);
+                epoll_ctl(_epollFD, EPOLL_CTL_DEL, fd, NULL);
+            }
+
+            if (!readable) {
+                waitsTimedOut.fetchAndAdd(1);
+            }
+            _workers->schedule(continuation, readable);
+        }
+
+        void _timeOut(long long now) {
+            std::vector<int> expired;
+            {
+                boost::mutex::scoped_lock lk(_mutex);
+                for (WaiterMap::const_iterator it = _waiters.begin(); it != _waiters.end(); ++it) {
+                    if (it->second.deadlineMillis && it->second.deadlineMillis <= now) {
+                        expired.push_back(it->first);
+                    }
+                }
+            }
+            for (size_t i = 0; i < expired.size(); i++) {
+                _finish(expired[i], false);
+            }
+        }
+
+        int _epollFD;
+        boost::scoped_ptr<ThreadPool> _workers;
+
+        // Guards _waiters and the membership of the epoll set.
+        boost::mutex _mutex;
+        WaiterMap _waiters;
+    };
+
+    Reactor* reactor = NULL;
+    boost::once_flag startOnce = BOOST_ONCE_INIT;
+
+    void startReactor() {
+        if (shardReplyWaiterThreads <= 0) {
+            return;
+        }
+        std::auto_ptr<Reactor> started(new Reactor());
+        if (started->start()) {
+            reactor = started.release();
+        }
+    }
+
+#endif // __linux__
+
+} // namespace
+
+    // static
+    bool ShardReplyWaiter::enabled() {
+#ifdef __linux__
+        boost::call_once(startReactor, startOnce);
+        return reactor != NULL;
+#else
+        return false;
+#endif
+    }
+
+    // static
+    bool ShardReplyWaiter::whenReadable(int fd,
+                                        double timeoutSecs,
+                                        const Continuation& continuation) {
+#ifdef __linux__
+        if (!enabled() || !reactor->add(fd, timeoutSecs, continuation)) {
+            return false;
+        }
+        waitsStarted.fetchAndAdd(1);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // static
+    void ShardReplyWaiter::appendStats(BSONObjBuilder* builder) {
+        builder->append("threads", enabled() ? shardReplyWaiterThreads : 0);
+        builder->append("waits", waitsStarted.load());
+        builder->append("timedOut", waitsTimedOut.load());
+    }
+
+namespace {
+
+    class ShardReplyWaiterServerStatusSection : public ServerStatusSection {
+    public:
+        ShardReplyWaiterServerStatusSection() : ServerStatusSection("shardReplyWaiter") {}
+
+        virtual bool includeByDefault() const { return true; }
+
+        virtual BSONObj generateSection(OperationContext* txn,
+                                        const BSONElement& configElement) const {
+            BSONObjBuilder ret;
+            ShardReplyWaiter::appendStats(&ret);
+            return ret.obj();
+        }
+
+    } shardReplyWaiterServerStatusSection;
+
+} // namespace
+
+} // namespace mongo
@@ -0,0 +1,73 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/stdx/functional.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+
+    /**
+     * Waits for the replies of shards without holding a thread per request. Sockets which have
+     * had a request sent on them are parked in one epoll set, and when a reply arrives, or the
+     * wait times out, the rest of the request runs on a small pool of threads.
+     *
+     * Together with deferCurrentRequest() this lets mongos requests which only wait on a shard
+     * give their connection worker back in the meantime, so that the number of such requests
+     * is bound by sockets and memory rather than by threads.
+     *
+     * The class is thread safe.
+     */
+    class ShardReplyWaiter {
+    public:
+        /**
+         * Called with true when the socket has a reply to read (or was closed), or with false
+         * when the wait timed out.
+         */
+        typedef stdx::function<void (bool)> Continuation;
+
+        /**
+         * Returns true if continuations can be used here. It is false on platforms without
+         * epoll and when shardReplyWaiterThreads is 0.
+         */
+        static bool enabled();
+
+        /**
+         * Runs 'continuation' on one of the waiter's threads once socket 'fd' is readable, or
+         * after 'timeoutSecs' without a reply if that is non-zero. The socket must not be used
+         * by anyone else until then. Returns false, without ever running 'continuation', if
+         * the socket could not be waited on.
+         */
+        static bool whenReadable(int fd, double timeoutSecs, const Continuation& continuation);
+
+        static void appendStats(BSONObjBuilder* builder);
+    };
+
+} // namespace mongo
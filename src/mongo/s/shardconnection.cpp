@@ -168,6 +168,7 @@ namespace mongo {
                        and isn't needed since all connections will be closed anyway */
                     if ( inShutdown() ) {
                         if( versionManager.isVersionableCB( ss->avail ) ) versionManager.resetShardVersionCB( ss->avail );
+                        shardConnectionPool.decrementEgress( addr , ss->avail );
                         delete ss->avail;
                     }
                     else
@@ -194,7 +195,13 @@ namespace mongo {
             if ( s->avail ) {
                 c.reset( s->avail );
                 s->avail = 0;
-                shardConnectionPool.onHandedOut( c.get() ); // May throw an exception
+                try {
+                    shardConnectionPool.onHandedOut( c.get() ); // May throw an exception
+                }
+                catch ( std::exception& ) {
+                    shardConnectionPool.decrementEgress( addr , c.get() );
+                    throw;
+                }
             } else {
                 c.reset( shardConnectionPool.get( addr ) );
                 s->created++; // After, so failed creation doesn't get counted
@@ -219,6 +226,7 @@ namespace mongo {
                 }
 
                 if (!isConnGood) {
+                    shardConnectionPool.decrementEgress(addr, s->avail);
                     delete s->avail;
                     s->avail = NULL;
                 }
@@ -331,6 +339,7 @@ namespace mongo {
         void clearPool() {
             for(HostMap::iterator iter = _hosts.begin(); iter != _hosts.end(); ++iter) {
                 if (iter->second->avail != NULL) {
+                    shardConnectionPool.decrementEgress(iter->first, iter->second->avail);
                     delete iter->second->avail;
                 }
                 delete iter->second;
@@ -440,6 +449,7 @@ namespace mongo {
                 ClientConnections::threadInstance()->done(_addr, _conn);
             }
             else {
+                shardConnectionPool.decrementEgress(_addr, _conn);
                 delete _conn;
             }
 
@@ -57,12 +57,14 @@
 #include "mongo/s/dbclient_multi_command.h"
 #include "mongo/s/grid.h"
 #include "mongo/s/request.h"
+#include "mongo/s/shard_reply_waiter.h"
 #include "mongo/s/stale_exception.h"
 #include "mongo/s/version_manager.h"
 #include "mongo/s/write_ops/batched_command_request.h"
 #include "mongo/s/write_ops/batch_upconvert.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/net/message_server.h"
 #include "mongo/util/timer.h"
 
 // error codes 8010-8040
@@ -220,7 +222,7 @@ namespace mongo {
                 cursorCache.store( cc, cursorLeftoverMillis );
             }
 
-            replyToQuery( 0, r.p(), r.m(), buffer.buf(), buffer.len(), docCount,
+            replyToQuery( 0, r.p(), r.m(), buffer, docCount,
                     startFrom, hasMore ? cc->getId() : 0 );
         }
         else{
@@ -494,6 +496,11 @@ namespace mongo {
         DBClientShardResolver resolver;
         DBClientMultiCommand dispatcher;
 
+        // Don't wait on shards past the command's own time limit.
+        StatusWith<int> maxTimeMS = LiteParsedQuery::parseMaxTimeMSCommand(command);
+        if (maxTimeMS.isOK())
+            dispatcher.setMaxTimeMillis(maxTimeMS.getValue());
+
         // Assemble requests
         for (vector<ShardEndpoint*>::const_iterator it = endpoints.begin(); it != endpoints.end();
             ++it) {
@@ -582,6 +589,98 @@ namespace mongo {
         return Status::OK();
     }
 
+    /**
+     * A single host getMore whose reply from the shard is waited for by the ShardReplyWaiter,
+     * while the thread which forwarded it goes on to other connections.
+     */
+    struct DeferredGetMore {
+        boost::scoped_ptr<ScopedDbConnection> conn;
+        DeferredRequest* deferred;
+        MSGID sentId;
+        MSGID responseTo;
+        long long cursorId;
+    };
+
+    static void finishDeferredGetMore( boost::shared_ptr<DeferredGetMore> getMore,
+                                       bool readable ) {
+        Message response;
+        try {
+            uassert( 10204, "dbgrid: getmore: error calling db", readable );
+
+            DBClientConnection* shard = static_cast<DBClientConnection*>( getMore->conn->get() );
+            bool ok = shard->recv( response );
+            uassert( 10204, "dbgrid: getmore: error calling db",
+                     ok && response.header().getResponseTo() == getMore->sentId );
+
+            if ( response.singleData().getCursor() == 0 ) {
+                cursorCache.removeRef( getMore->cursorId );
+            }
+            getMore->conn->done();
+        }
+        catch ( const DBException& e ) {
+            // Without done() the shard connection is closed rather than pooled.
+            response.reset();
+            replyToQuery( ResultFlag_ErrSet, response,
+                          BSON( "$err" << e.what() << "code" << e.getCode() ) );
+        }
+
+        try {
+            Message received;
+            getMore->deferred->port()->reply( received, response, getMore->responseTo );
+        }
+        catch ( const DBException& e ) {
+            LOG(1) << "could not reply to deferred getmore: " << e.what() << endl;
+        }
+        getMore->conn.reset();
+        getMore->deferred->finish();
+    }
+
+    /**
+     * Forwards a single host getMore and defers its reply until the shard answers, if both the
+     * connection executor and the ShardReplyWaiter allow it. Returns false, having sent
+     * nothing, when the getMore should be run synchronously instead.
+     */
+    static bool deferSingleGetMore( Request& r, const string& host, long long cursorId ) {
+        if ( !ShardReplyWaiter::enabled() ) {
+            return false;
+        }
+
+        boost::shared_ptr<DeferredGetMore> getMore( new DeferredGetMore() );
+        getMore->conn.reset( new ScopedDbConnection( host ) );
+        DBClientConnection* shard = dynamic_cast<DBClientConnection*>( getMore->conn->get() );
+        if ( !shard ) {
+            getMore->conn->done();
+            return false;
+        }
+
+        getMore->deferred = deferCurrentRequest();
+        if ( !getMore->deferred ) {
+            getMore->conn->done();
+            return false;
+        }
+
+        try {
+            shard->say( r.m() );
+        }
+        catch ( ... ) {
+            getMore->deferred->finish();
+            throw;
+        }
+        getMore->sentId = r.m().header().getId();
+        getMore->responseTo = r.id();
+        getMore->cursorId = cursorId;
+
+        const int fd = shard->port().psock->rawFD();
+        if ( !ShardReplyWaiter::whenReadable( fd, shard->getSoTimeout(),
+                                              stdx::bind( finishDeferredGetMore,
+                                                          getMore,
+                                                          stdx::placeholders::_1 ) ) ) {
+            // The getMore has been sent, so finish it here.
+            finishDeferredGetMore( getMore, true );
+        }
+        return true;
+    }
+
     void Strategy::getMore( Request& r ) {
 
         Timer getMoreTimer;
@@ -622,6 +721,10 @@ namespace mongo {
 
             LOG(3) << "single getmore: " << ns << endl;
 
+            if ( deferSingleGetMore( r, host, id ) ) {
+                return;
+            }
+
             // we used ScopedDbConnection because we don't get about config versions
             // not deleting data is handled elsewhere
             // and we don't want to call setShardVersion
@@ -672,7 +775,7 @@ namespace mongo {
                 cursorCache.remove( id );
             }
 
-            replyToQuery( 0, r.p(), r.m(), buffer.buf(), buffer.len(), docCount,
+            replyToQuery( 0, r.p(), r.m(), buffer, docCount,
                     startFrom, hasMore ? cursor->getId() : 0 );
             return;
         }
@@ -32,8 +32,11 @@
 
 #include "mongo/s/write_ops/batch_write_exec.h"
 
+#include <deque>
+#include <map>
+
 #include "mongo/base/error_codes.h"
-#include "mongo/base/owned_pointer_map.h"
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/base/status.h"
 #include "mongo/bson/util/builder.h"
 #include "mongo/client/dbclientinterface.h" // ConnectionString (header-only)
@@ -49,18 +52,23 @@ namespace mongo {
         _targeter( targeter ),
         _resolver( resolver ),
         _dispatcher( dispatcher ),
+        _maxBatchesInFlightPerHost( 2 ),
         _stats( new BatchWriteExecStats ) {
     }
 
+    void BatchWriteExec::setMaxBatchesInFlightPerHost( int maxBatches ) {
+        invariant( maxBatches > 0 );
+        _maxBatchesInFlightPerHost = maxBatches;
+    }
+
     namespace {
 
         //
-        // Map which allows associating ConnectionString hosts with TargetedWriteBatches
+        // Queues of TargetedWriteBatches by ConnectionString host.
         // This is needed since the dispatcher only returns hosts with responses.
         //
 
-        // TODO: Unordered map?
-        typedef OwnedPointerMap<ConnectionString, TargetedWriteBatch> OwnedHostBatchMap;
+        typedef std::map<ConnectionString, std::deque<TargetedWriteBatch*> > HostBatchQueueMap;
     }
 
     static void buildErrorFrom( const Status& status, WriteErrorDetail* error ) {
@@ -85,6 +93,23 @@ namespace mongo {
         return false;
     }
 
+    // Returns true if more child batches may be targeted - if no host has any batches yet, or if
+    // some host has fewer batches waiting and in flight than its window allows.
+    static bool hasRoomForBatches( const HostBatchQueueMap& toSend,
+                                   const HostBatchQueueMap& inFlight,
+                                   size_t maxInFlightPerHost ) {
+        if ( toSend.empty() )
+            return true;
+
+        for ( HostBatchQueueMap::const_iterator it = toSend.begin(); it != toSend.end(); ++it ) {
+            HostBatchQueueMap::const_iterator inFlightIt = inFlight.find( it->first );
+            size_t numInFlight = inFlightIt == inFlight.end() ? 0 : inFlightIt->second.size();
+            if ( it->second.size() + numInFlight < maxInFlightPerHost )
+                return true;
+        }
+        return false;
+    }
+
     // The number of times we'll try to continue a batch op if no progress is being made
     // This only applies when no writes are occurring and metadata is not changing on reload
     static const int kMaxRoundsWithoutProgress( 5 );
@@ -131,181 +156,208 @@ namespace mongo {
             //    exactly when the metadata changed.
             //
 
+            // Owns every child batch targeted during this round
             OwnedPointerVector<TargetedWriteBatch> childBatchesOwned;
-            vector<TargetedWriteBatch*>& childBatches = childBatchesOwned.mutableVector();
-
-            // If we've already had a targeting error, we've refreshed the metadata once and can
-            // record target errors definitively.
-            bool recordTargetErrors = refreshedTargeter;
-            Status targetStatus = batchOp.targetBatch( *_targeter,
-                                                       recordTargetErrors,
-                                                       &childBatches );
-            if ( !targetStatus.isOK() ) {
-                // Don't do anything until a targeter refresh
-                _targeter->noteCouldNotTarget();
-                refreshedTargeter = true;
-                ++_stats->numTargetErrors;
-                dassert( childBatches.size() == 0u );
-            }
 
-            //
-            // Send all child batches
-            //
+            // Child batches waiting to be sent and out on the network, in order, by host
+            HostBatchQueueMap toSend;
+            HostBatchQueueMap inFlight;
 
-            size_t numSent = 0;
-            size_t numToSend = childBatches.size();
+            // Ordered batches are targeted once per round and sent one at a time to each host, so
+            // that a write is never sent before the writes ahead of it have completed.  Unordered
+            // batches keep a window of batches in flight to every host, and are targeted again as
+            // soon as a host has room, so a slow shard doesn't hold back the others.
+            const bool ordered = clientRequest.getOrdered();
+            const size_t maxInFlightPerHost =
+                ordered ? 1u : static_cast<size_t>( _maxBatchesInFlightPerHost );
+
+            bool canTarget = true;
+            bool targeterChanged = false;
             bool remoteMetadataChanging = false;
-            while ( numSent != numToSend ) {
 
-                // Collect batches out on the network, mapped by endpoint
-                OwnedHostBatchMap ownedPendingBatches;
-                OwnedHostBatchMap::MapType& pendingBatches = ownedPendingBatches.mutableMap();
+            while ( true ) {
 
                 //
-                // Send side
+                // Target side
                 //
 
-                // Get as many batches as we can at once
-                for ( vector<TargetedWriteBatch*>::iterator it = childBatches.begin();
-                    it != childBatches.end(); ++it ) {
+                while ( canTarget && hasRoomForBatches( toSend, inFlight, maxInFlightPerHost )
+                        && batchOp.numWriteOpsIn( WriteOpState_Ready ) > 0 ) {
+
+                    vector<TargetedWriteBatch*> childBatches;
+
+                    // If we've already had a targeting error, we've refreshed the metadata once and
+                    // can record target errors definitively.
+                    bool recordTargetErrors = refreshedTargeter;
+                    Status targetStatus = batchOp.targetBatch( *_targeter,
+                                                               recordTargetErrors,
+                                                               &childBatches );
+                    if ( !targetStatus.isOK() ) {
+                        // Don't do anything until a targeter refresh
+                        _targeter->noteCouldNotTarget();
+                        refreshedTargeter = true;
+                        ++_stats->numTargetErrors;
+                        dassert( childBatches.size() == 0u );
+                    }
+
+                    if ( !targetStatus.isOK() || ordered || childBatches.empty() )
+                        canTarget = false;
 
-                    //
-                    // Collect the info needed to dispatch our targeted batch
-                    //
+                    for ( vector<TargetedWriteBatch*>::iterator it = childBatches.begin();
+                        it != childBatches.end(); ++it ) {
 
-                    TargetedWriteBatch* nextBatch = *it;
-                    // If the batch is NULL, we sent it previously, so skip
-                    if ( nextBatch == NULL ) continue;
+                        TargetedWriteBatch* nextBatch = *it;
+                        childBatchesOwned.mutableVector().push_back( nextBatch );
 
-                    // Figure out what host we need to dispatch our targeted batch
-                    ConnectionString shardHost;
-                    Status resolveStatus = _resolver->chooseWriteHost( nextBatch->getEndpoint()
-                                                                           .shardName,
-                                                                       &shardHost );
-                    if ( !resolveStatus.isOK() ) {
+                        // Figure out what host we need to dispatch our targeted batch
+                        ConnectionString shardHost;
+                        Status resolveStatus = _resolver->chooseWriteHost( nextBatch->getEndpoint()
+                                                                               .shardName,
+                                                                           &shardHost );
+                        if ( !resolveStatus.isOK() ) {
 
-                        ++_stats->numResolveErrors;
+                            ++_stats->numResolveErrors;
 
-                        // Record a resolve failure
-                        // TODO: It may be necessary to refresh the cache if stale, or maybe just
-                        // cancel and retarget the batch
-                        WriteErrorDetail error;
-                        buildErrorFrom( resolveStatus, &error );
+                            // Record a resolve failure
+                            // TODO: It may be necessary to refresh the cache if stale, or maybe
+                            // just cancel and retarget the batch
+                            WriteErrorDetail error;
+                            buildErrorFrom( resolveStatus, &error );
 
-                        LOG( 4 ) << "unable to send write batch to " << shardHost.toString()
-                                 << causedBy( resolveStatus.toString() ) << endl;
+                            LOG( 4 ) << "unable to send write batch to " << shardHost.toString()
+                                     << causedBy( resolveStatus.toString() ) << endl;
 
-                        batchOp.noteBatchError( *nextBatch, error );
+                            batchOp.noteBatchError( *nextBatch, error );
+                            continue;
+                        }
 
-                        // We're done with this batch
-                        // Clean up when we can't resolve a host
-                        delete *it;
-                        *it = NULL;
-                        --numToSend;
-                        continue;
+                        toSend[shardHost].push_back( nextBatch );
                     }
+                }
 
-                    // If we already have a batch for this host, wait until the next time
-                    OwnedHostBatchMap::MapType::iterator pendingIt = pendingBatches.find( shardHost );
-                    if ( pendingIt != pendingBatches.end() ) continue;
+                //
+                // Send side
+                //
 
-                    //
-                    // We now have all the info needed to dispatch the batch
-                    //
+                // Fill the window of every host.  We'll only get several batches for a host at
+                // once if we have broadcast and non-broadcast endpoints for the same host, or if
+                // we targeted again while earlier batches were out.
+                int numToSend = 0;
+                for ( HostBatchQueueMap::iterator it = toSend.begin(); it != toSend.end(); ++it ) {
 
-                    BatchedCommandRequest request( clientRequest.getBatchType() );
-                    batchOp.buildBatchRequest( *nextBatch, &request );
+                    const ConnectionString& shardHost = it->first;
+                    std::deque<TargetedWriteBatch*>& hostQueue = it->second;
+                    std::deque<TargetedWriteBatch*>& hostInFlight = inFlight[shardHost];
 
-                    // Internally we use full namespaces for request/response, but we send the
-                    // command to a database with the collection name in the request.
-                    NamespaceString nss( request.getNS() );
-                    request.setNS( nss.coll() );
+                    while ( !hostQueue.empty() && hostInFlight.size() < maxInFlightPerHost ) {
 
-                    LOG( 4 ) << "sending write batch to " << shardHost.toString() << ": "
-                             << request.toString() << endl;
+                        TargetedWriteBatch* nextBatch = hostQueue.front();
+                        hostQueue.pop_front();
 
-                    _dispatcher->addCommand( shardHost, nss.db(), request );
+                        BatchedCommandRequest request( clientRequest.getBatchType() );
+                        batchOp.buildBatchRequest( *nextBatch, &request );
 
-                    // Indicate we're done by setting the batch to NULL
-                    // We'll only get duplicate hostEndpoints if we have broadcast and non-broadcast
-                    // endpoints for the same host, so this should be pretty efficient without
-                    // moving stuff around.
-                    *it = NULL;
+                        // Internally we use full namespaces for request/response, but we send the
+                        // command to a database with the collection name in the request.
+                        NamespaceString nss( request.getNS() );
+                        request.setNS( nss.coll() );
 
-                    // Recv-side is responsible for cleaning up the nextBatch when used
-                    pendingBatches.insert( make_pair( shardHost, nextBatch ) );
+                        LOG( 4 ) << "sending write batch to " << shardHost.toString() << ": "
+                                 << request.toString() << endl;
+
+                        _dispatcher->addCommand( shardHost, nss.db(), request );
+
+                        // Responses from a host come back in the order the batches were sent
+                        hostInFlight.push_back( nextBatch );
+                        ++numToSend;
+                    }
                 }
 
                 // Send them all out
-                _dispatcher->sendAll();
-                numSent += pendingBatches.size();
+                if ( numToSend > 0 )
+                    _dispatcher->sendAll();
+
+                // Nothing is out on the network and nothing more can be sent - the round is over
+                if ( _dispatcher->numPending() == 0 )
+                    break;
 
                 //
                 // Recv side
                 //
 
-                while ( _dispatcher->numPending() > 0 ) {
-
-                    // Get the response
-                    ConnectionString shardHost;
-                    BatchedCommandResponse response;
-                    Status dispatchStatus = _dispatcher->recvAny( &shardHost, &response );
-
-                    // Get the TargetedWriteBatch to find where to put the response
-                    dassert( pendingBatches.find( shardHost ) != pendingBatches.end() );
-                    TargetedWriteBatch* batch = pendingBatches.find( shardHost )->second;
-
-                    if ( dispatchStatus.isOK() ) {
-
-                        TrackedErrors trackedErrors;
-                        trackedErrors.startTracking( ErrorCodes::StaleShardVersion );
-
-                        LOG( 4 ) << "write results received from " << shardHost.toString() << ": "
-                                 << response.toString() << endl;
-
-                        // Dispatch was ok, note response
-                        batchOp.noteBatchResponse( *batch, response, &trackedErrors );
-
-                        // Note if anything was stale
-                        const vector<ShardError*>& staleErrors =
-                            trackedErrors.getErrors( ErrorCodes::StaleShardVersion );
-
-                        if ( staleErrors.size() > 0 ) {
-                            noteStaleResponses( staleErrors, _targeter );
-                            ++_stats->numStaleBatches;
-                        }
-
-                        // Remember if the shard is actively changing metadata right now
-                        if ( isShardMetadataChanging( staleErrors ) ) {
-                            remoteMetadataChanging = true;
+                // Get the response
+                ConnectionString shardHost;
+                BatchedCommandResponse response;
+                Status dispatchStatus = _dispatcher->recvAny( &shardHost, &response );
+
+                // Get the TargetedWriteBatch to find where to put the response
+                std::deque<TargetedWriteBatch*>& hostInFlight = inFlight[shardHost];
+                dassert( !hostInFlight.empty() );
+                TargetedWriteBatch* batch = hostInFlight.front();
+                hostInFlight.pop_front();
+
+                if ( dispatchStatus.isOK() ) {
+
+                    TrackedErrors trackedErrors;
+                    trackedErrors.startTracking( ErrorCodes::StaleShardVersion );
+
+                    LOG( 4 ) << "write results received from " << shardHost.toString() << ": "
+                             << response.toString() << endl;
+
+                    // Dispatch was ok, note response
+                    batchOp.noteBatchResponse( *batch, response, &trackedErrors );
+
+                    // Note if anything was stale
+                    const vector<ShardError*>& staleErrors =
+                        trackedErrors.getErrors( ErrorCodes::StaleShardVersion );
+
+                    if ( staleErrors.size() > 0 ) {
+                        noteStaleResponses( staleErrors, _targeter );
+                        ++_stats->numStaleBatches;
+
+                        // Retry the stale writes of an unordered batch right away if a refresh
+                        // gives us new metadata, rather than waiting for the other hosts.
+                        // Otherwise, wait for the end of the round to try again.
+                        if ( !ordered && canTarget ) {
+                            bool changed = false;
+                            Status refreshStatus = _targeter->refreshIfNeeded( &changed );
+                            if ( refreshStatus.isOK() && changed )
+                                targeterChanged = true;
+                            else
+                                canTarget = false;
                         }
+                    }
 
-                        // Remember that we successfully wrote to this shard
-                        // NOTE: This will record lastOps for shards where we actually didn't update
-                        // or delete any documents, which preserves old behavior but is conservative
-                        _stats->noteWriteAt( shardHost,
-                                             response.isLastOpSet() ? 
-                                             response.getLastOp() : OpTime(),
-                                             response.isElectionIdSet() ?
-                                             response.getElectionId() : OID());
+                    // Remember if the shard is actively changing metadata right now
+                    if ( isShardMetadataChanging( staleErrors ) ) {
+                        remoteMetadataChanging = true;
                     }
-                    else {
 
-                        // Error occurred dispatching, note it
+                    // Remember that we successfully wrote to this shard
+                    // NOTE: This will record lastOps for shards where we actually didn't update
+                    // or delete any documents, which preserves old behavior but is conservative
+                    _stats->noteWriteAt( shardHost,
+                                         response.isLastOpSet() ?
+                                         response.getLastOp() : OpTime(),
+                                         response.isElectionIdSet() ?
+                                         response.getElectionId() : OID());
+                }
+                else {
 
-                        stringstream msg;
-                        msg << "write results unavailable from " << shardHost.toString()
-                            << causedBy( dispatchStatus.toString() );
+                    // Error occurred dispatching, note it
 
-                        WriteErrorDetail error;
-                        buildErrorFrom( Status( ErrorCodes::RemoteResultsUnavailable, msg.str() ),
-                                        &error );
+                    stringstream msg;
+                    msg << "write results unavailable from " << shardHost.toString()
+                        << causedBy( dispatchStatus.toString() );
 
-                        LOG( 4 ) << "unable to receive write results from " << shardHost.toString()
-                                 << causedBy( dispatchStatus.toString() ) << endl;
+                    WriteErrorDetail error;
+                    buildErrorFrom( Status( ErrorCodes::RemoteResultsUnavailable, msg.str() ),
+                                    &error );
 
-                        batchOp.noteBatchError( *batch, error );
-                    }
+                    LOG( 4 ) << "unable to receive write results from " << shardHost.toString()
+                             << causedBy( dispatchStatus.toString() ) << endl;
+
+                    batchOp.noteBatchError( *batch, error );
                 }
             }
 
@@ -322,8 +374,10 @@ namespace mongo {
             // Refresh the targeter if we need to (no-op if nothing stale)
             //
 
-            bool targeterChanged = false;
-            Status refreshStatus = _targeter->refreshIfNeeded( &targeterChanged );
+            bool refreshChanged = false;
+            Status refreshStatus = _targeter->refreshIfNeeded( &refreshChanged );
+            if ( refreshChanged )
+                targeterChanged = true;
 
             if ( !refreshStatus.isOK() ) {
 
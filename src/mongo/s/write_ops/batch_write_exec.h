@@ -77,6 +77,12 @@ namespace mongo {
         void executeBatch( const BatchedCommandRequest& clientRequest,
                            BatchedCommandResponse* clientResponse );
 
+        /**
+         * Sets how many child batches of an unordered write may be out on the network to a single
+         * host at once.  Ordered writes always send one batch at a time to each host.
+         */
+        void setMaxBatchesInFlightPerHost( int maxBatches );
+
         const BatchWriteExecStats& getStats();
 
         BatchWriteExecStats* releaseStats();
@@ -92,6 +98,9 @@ namespace mongo {
         // Not owned here
         MultiCommandDispatch* _dispatcher;
 
+        // Window of child batches in flight to each host for unordered writes
+        int _maxBatchesInFlightPerHost;
+
         // Stats
         std::auto_ptr<BatchWriteExecStats> _stats;
     };
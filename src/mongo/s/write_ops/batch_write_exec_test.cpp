@@ -146,6 +146,39 @@ namespace {
         ASSERT_EQUALS( stats.numRounds, 1 );
     }
 
+    TEST(BatchWriteExecTests, ManyBatchesOneRound) {
+
+        //
+        // Unordered child batches to the same shard are sent in a single round, ordered ones are
+        // sent one round at a time
+        //
+
+        NamespaceString nss( "foo.bar" );
+
+        for ( int i = 0; i < 2; ++i ) {
+
+            const bool ordered = i == 1;
+            MockSingleShardBackend backend( nss );
+
+            BatchedCommandRequest request( BatchedCommandRequest::BatchType_Insert );
+            request.setNS( nss.ns() );
+            request.setOrdered( ordered );
+            request.setWriteConcern( BSONObj() );
+            // Too many docs for one child batch
+            for ( int x = 0; x < 2500; ++x ) {
+                request.getInsertRequest()->addToDocuments( BSON( "x" << x ) );
+            }
+
+            BatchedCommandResponse response;
+            backend.exec->executeBatch( request, &response );
+            ASSERT( response.getOk() );
+            ASSERT( !response.isErrDetailsSet() );
+
+            const BatchWriteExecStats& stats = backend.exec->getStats();
+            ASSERT_EQUALS( stats.numRounds, ordered ? 3 : 1 );
+        }
+    }
+
     //
     // Test retryable errors
     //
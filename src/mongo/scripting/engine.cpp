@@ -33,12 +33,14 @@
 
 #include "mongo/scripting/engine.h"
 
+#include <algorithm>
 #include <cctype>
 #include <boost/filesystem/operations.hpp>
 
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/global_environment_experiment.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/platform/unordered_set.h"
 #include "mongo/util/file.h"
 #include "mongo/util/log.h"
@@ -52,6 +54,14 @@ namespace {
     const fileofs kMaxJsFileLength = fileofs(2) * 1024 * 1024 * 1024;
 }  // namespace
 
+    // Maximum number of idle scopes kept, across all databases, for getPooledScope().
+    MONGO_EXPORT_SERVER_PARAMETER(internalJSScopePoolSize, int, 10);
+
+    // Number of times a pooled scope is handed out before it is thrown away.  Creating a scope
+    // means a new V8 context and re-running the setup scripts, which costs far more than most
+    // $where or group invocations, so scopes are reused many times.
+    MONGO_EXPORT_SERVER_PARAMETER(internalJSMaxScopeReuse, int, 100);
+
     ScriptEngine::ScriptEngine() : _scopeInitCallback() {
     }
 
@@ -306,13 +316,17 @@ namespace {
                 return;
             }
 
-            if (scope->getTimesUsed() > kMaxScopeReuse)
+            if (scope->getTimesUsed() > internalJSMaxScopeReuse)
                 return; // used too many times to save
 
             if (!scope->getError().empty())
                 return; // not saving errored scopes
 
-            if (_pools.size() >= kMaxPoolSize) {
+            const size_t maxPoolSize = std::max(0, internalJSScopePoolSize);
+            if (maxPoolSize == 0)
+                return;
+
+            while (_pools.size() >= maxPoolSize) {
                 // prefer to keep recently-used scopes
                 _pools.pop_back();
             }
@@ -345,10 +359,8 @@ namespace {
             string poolName;
         };
 
-        // Note: if these numbers change, reconsider choice of datastructure for _pools
-        static const unsigned kMaxPoolSize = 10;
-        static const int kMaxScopeReuse = 10;
-
+        // Note: tryAcquire() scans _pools linearly, which is only reasonable while
+        // internalJSScopePoolSize stays small.
         typedef deque<ScopeAndPool> Pools; // More-recently used Scopes are kept at the front.
         Pools _pools;    // protected by _mutex
         mongo::mutex _mutex;
@@ -36,15 +36,19 @@
 
 #include <pcrecpp.h>
 
+#include <boost/make_shared.hpp>
 #include <boost/thread/thread.hpp>
+#include <cmath>
 
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/operation_context_noop.h"
 #include "mongo/client/dbclientcursor.h"
+#include "mongo/platform/random.h"
 #include "mongo/scripting/bson_template_evaluator.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/util/log.h"
 #include "mongo/util/md5.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/timer.h"
 #include "mongo/util/time_support.h"
 #include "mongo/util/version.h"
@@ -83,11 +87,81 @@ namespace mongo {
     void BenchRunEventCounter::reset() {
         _numEvents = 0;
         _totalTimeMicros = 0;
+        _minTimeMicros = 0;
+        _maxTimeMicros = 0;
+        _histogram.clear();
     }
 
     void BenchRunEventCounter::updateFrom(const BenchRunEventCounter &other) {
+        if (other._numEvents == 0)
+            return;
+
+        if (_numEvents == 0 || other._minTimeMicros < _minTimeMicros)
+            _minTimeMicros = other._minTimeMicros;
+        if (_numEvents == 0 || other._maxTimeMicros > _maxTimeMicros)
+            _maxTimeMicros = other._maxTimeMicros;
         _numEvents += other._numEvents;
         _totalTimeMicros += other._totalTimeMicros;
+
+        if (_histogram.size() < other._histogram.size())
+            _histogram.resize(other._histogram.size(), 0);
+        for (size_t i = 0; i < other._histogram.size(); ++i)
+            _histogram[i] += other._histogram[i];
+    }
+
+    void BenchRunEventCounter::countOne(long long timeMicros) {
+        if (_numEvents == 0 || timeMicros < _minTimeMicros)
+            _minTimeMicros = timeMicros;
+        if (_numEvents == 0 || timeMicros > _maxTimeMicros)
+            _maxTimeMicros = timeMicros;
+        ++_numEvents;
+        _totalTimeMicros += timeMicros;
+
+        const size_t bucket = bucketFor(timeMicros);
+        if (bucket >= _histogram.size())
+            _histogram.resize(bucket + 1, 0);
+        ++_histogram[bucket];
+    }
+
+    long long BenchRunEventCounter::getPercentileMicros(double percentile) const {
+        if (_numEvents == 0)
+            return 0;
+
+        // The rank, counting from one, of the event at "percentile".
+        unsigned long long rank =
+            static_cast<unsigned long long>(std::ceil(percentile / 100 * _numEvents));
+        if (rank == 0)
+            rank = 1;
+
+        unsigned long long seen = 0;
+        for (size_t i = 0; i < _histogram.size(); ++i) {
+            seen += _histogram[i];
+            if (seen >= rank)
+                return std::min(highestMicrosIn(i), _maxTimeMicros);
+        }
+        return _maxTimeMicros;
+    }
+
+    size_t BenchRunEventCounter::bucketFor(long long timeMicros) {
+        if (timeMicros < kSubBuckets)
+            return timeMicros < 0 ? 0 : static_cast<size_t>(timeMicros);
+
+        int highestBit = 0;
+        for (long long rest = timeMicros >> 1; rest; rest >>= 1)
+            ++highestBit;
+
+        // Keep the kSubBucketBits bits below the highest one.
+        const int shift = highestBit - kSubBucketBits;
+        return (shift + 1) * kSubBuckets + static_cast<size_t>((timeMicros >> shift) - kSubBuckets);
+    }
+
+    long long BenchRunEventCounter::highestMicrosIn(size_t bucket) {
+        if (bucket < static_cast<size_t>(kSubBuckets))
+            return bucket;
+
+        const int shift = bucket / kSubBuckets - 1;
+        const long long lowest = kSubBuckets + static_cast<long long>(bucket % kSubBuckets);
+        return (lowest << shift) + (1LL << shift) - 1;
     }
 
     BenchRunStats::BenchRunStats() {
@@ -105,8 +179,10 @@ namespace mongo {
         insertCounter.reset();
         deleteCounter.reset();
         queryCounter.reset();
+        commandCounter.reset();
 
         trappedErrors.clear();
+        intervals.clear();
     }
 
     void BenchRunStats::updateFrom(const BenchRunStats &other) {
@@ -119,9 +195,15 @@ namespace mongo {
         insertCounter.updateFrom(other.insertCounter);
         deleteCounter.updateFrom(other.deleteCounter);
         queryCounter.updateFrom(other.queryCounter);
+        commandCounter.updateFrom(other.commandCounter);
 
         for (size_t i = 0; i < other.trappedErrors.size(); ++i)
             trappedErrors.push_back(other.trappedErrors[i]);
+
+        while (intervals.size() < other.intervals.size())
+            intervals.push_back(boost::make_shared<BenchRunStats>());
+        for (size_t i = 0; i < other.intervals.size(); ++i)
+            intervals[i]->updateFrom(*other.intervals[i]);
     }
 
     BenchRunConfig::BenchRunConfig() {
@@ -136,6 +218,10 @@ namespace mongo {
 
         parallel = 1;
         seconds = 1;
+        statsIntervalSeconds = 0;
+        opsPerSecond = 0;
+        poissonArrivals = false;
+        thinkTimeMillis = 0;
         hideResults = true;
         handleErrors = false;
         hideErrors = false;
@@ -173,6 +259,19 @@ namespace mongo {
             this->parallel = args["parallel"].numberInt();
         if ( args["seconds"].isNumber() )
             this->seconds = args["seconds"].number();
+        if ( args["statsIntervalSeconds"].isNumber() )
+            this->statsIntervalSeconds = args["statsIntervalSeconds"].number();
+        if ( args["opsPerSecond"].isNumber() )
+            this->opsPerSecond = args["opsPerSecond"].number();
+        if ( args["thinkTimeMillis"].isNumber() )
+            this->thinkTimeMillis = args["thinkTimeMillis"].number();
+        if ( ! args["arrivals"].eoo() ) {
+            const std::string arrivals = args["arrivals"].str();
+            uassert(28622,
+                    "arrivals must be \"uniform\" or \"poisson\"",
+                    arrivals == "uniform" || arrivals == "poisson");
+            this->poissonArrivals = (arrivals == "poisson");
+        }
         if ( ! args["hideResults"].eoo() )
             this->hideResults = args["hideResults"].trueValue();
         if ( ! args["handleErrors"].eoo() )
@@ -314,7 +413,7 @@ namespace mongo {
     }
 
     BenchRunWorker::BenchRunWorker(size_t id, const BenchRunConfig *config, BenchRunState *brState)
-        : _id(id), _config(config), _brState(brState) {
+        : _id(id), _config(config), _brState(brState), _intervalIndex(0) {
     }
 
     BenchRunWorker::~BenchRunWorker() {}
@@ -327,6 +426,43 @@ namespace mongo {
         return _brState->shouldWorkerFinish();
     }
 
+    void BenchRunWorker::closeInterval() {
+        if (_config->statsIntervalSeconds > 0) {
+            while (_stats.intervals.size() <= _intervalIndex)
+                _stats.intervals.push_back(boost::make_shared<BenchRunStats>());
+            _stats.intervals[_intervalIndex]->updateFrom(_intervalStats);
+        }
+        _stats.updateFrom(_intervalStats);
+        _intervalStats.reset();
+    }
+
+    bool BenchRunWorker::sleepUntil(unsigned long long wakeMicros) const {
+        // Sleep in slices, so that a slow schedule doesn't hold up the end of the run.
+        const long long kSliceMicros = 100 * 1000;
+        for (unsigned long long now = curTimeMicros64(); now < wakeMicros;
+             now = curTimeMicros64()) {
+            if (shouldStop())
+                return false;
+            sleepmicros(std::min(static_cast<long long>(wakeMicros - now), kSliceMicros));
+        }
+        return !shouldStop();
+    }
+
+    namespace {
+        /**
+         * A random gap to the next event, of "meanMicros" on average.  Exponentially distributed
+         * if "poisson", as between the arrivals of a Poisson process, otherwise fixed.
+         */
+        double nextGapMicros(PseudoRandom* random, double meanMicros, bool poisson) {
+            if (!poisson)
+                return meanMicros;
+            // Uniform in (0, 1].
+            const double uniform =
+                (static_cast<double>(random->nextInt64() & ((1LL << 53) - 1)) + 1) / (1LL << 53);
+            return -meanMicros * std::log(uniform);
+        }
+    }  // namespace
+
     void doNothing(const BSONObj&) { }
 
     void BenchRunWorker::generateLoadOnConnection( DBClientBase* conn ) {
@@ -334,6 +470,21 @@ namespace mongo {
         long long count = 0;
         mongo::Timer timer;
 
+        // Whichever way the load stops, count the events of the last interval.
+        const long long intervalMicros =
+            static_cast<long long>(_config->statsIntervalSeconds * 1000 * 1000);
+        _intervalIndex = 0;
+        ON_BLOCK_EXIT_OBJ(*this, &BenchRunWorker::closeInterval);
+
+        PseudoRandom random(static_cast<int64_t>(curTimeMicros64() * 1000 + _id));
+
+        // In open loop mode the mean gap between the sends of this thread, and when the next send
+        // is due.  The threads' schedules start at random offsets, so they don't send in lockstep.
+        const double sendGapMicros = _config->opsPerSecond > 0 ?
+            1000 * 1000 * _config->parallel / _config->opsPerSecond : 0;
+        double nextSendMicros = static_cast<double>(curTimeMicros64())
+                              + nextGapMicros(&random, sendGapMicros, true);
+
         BsonTemplateEvaluator bsonTemplateEvaluator;
         invariant(bsonTemplateEvaluator.setId(_id) == BsonTemplateEvaluator::StatusSuccess);
 
@@ -391,6 +542,18 @@ namespace mongo {
                     }
                 }
 
+                // How long after its scheduled send time this op was sent.  Its latency counts
+                // from the scheduled time, so that it includes the wait.
+                long long queuedMicros = 0;
+                if (sendGapMicros > 0 && op != "let") {
+                    if (!sleepUntil(static_cast<unsigned long long>(nextSendMicros)))
+                        break;
+                    queuedMicros = std::max(0LL, static_cast<long long>(
+                        static_cast<double>(curTimeMicros64()) - nextSendMicros));
+                    nextSendMicros += nextGapMicros(&random, sendGapMicros,
+                                                    _config->poissonArrivals);
+                }
+
                 try {
                     if ( op == "nop") {
                         // do nothing
@@ -399,7 +562,7 @@ namespace mongo {
 
                         BSONObj result;
                         {
-                            BenchRunEventTrace _bret(&_stats.findOneCounter);
+                            BenchRunEventTrace _bret(&_intervalStats.findOneCounter, queuedMicros);
                             result = conn->findOne( ns , fixQuery( e["query"].Obj(),
                                                                    bsonTemplateEvaluator ) );
                         }
@@ -421,8 +584,12 @@ namespace mongo {
                     else if ( op == "command" ) {
 
                         BSONObj result;
-                        conn->runCommand( ns, fixQuery( e["command"].Obj(), bsonTemplateEvaluator ),
-                                          result, e["options"].numberInt() );
+                        {
+                            BenchRunEventTrace _bret(&_intervalStats.commandCounter, queuedMicros);
+                            conn->runCommand( ns,
+                                              fixQuery( e["command"].Obj(), bsonTemplateEvaluator ),
+                                              result, e["options"].numberInt() );
+                        }
 
                         if( check ){
                             int err = scope->invoke( scopeFunc , 0 , &result,  1000 * 60 , false );
@@ -454,12 +621,12 @@ namespace mongo {
 
                         // use special query function for exhaust query option
                         if (options & QueryOption_Exhaust) {
-                            BenchRunEventTrace _bret(&_stats.queryCounter);
+                            BenchRunEventTrace _bret(&_intervalStats.queryCounter, queuedMicros);
                             stdx::function<void (const BSONObj&)> castedDoNothing(doNothing);
                             count =  conn->query(castedDoNothing, ns, fixedQuery, &filter, options);
                         }
                         else {
-                            BenchRunEventTrace _bret(&_stats.queryCounter);
+                            BenchRunEventTrace _bret(&_intervalStats.queryCounter, queuedMicros);
                             cursor = conn->query(ns, fixedQuery, limit, skip, &filter, options,
                                                  batchSize);
                             count = cursor->itcount();
@@ -495,7 +662,7 @@ namespace mongo {
                         bool safe = e["safe"].trueValue();
 
                         {
-                            BenchRunEventTrace _bret(&_stats.updateCounter);
+                            BenchRunEventTrace _bret(&_intervalStats.updateCounter, queuedMicros);
                             BSONObj query = fixQuery(queryOrginal, bsonTemplateEvaluator);
                             BSONObj update = fixQuery(updateOriginal, bsonTemplateEvaluator);
 
@@ -547,7 +714,7 @@ namespace mongo {
                         BSONObj result;
 
                         {
-                            BenchRunEventTrace _bret(&_stats.insertCounter);
+                            BenchRunEventTrace _bret(&_intervalStats.insertCounter, queuedMicros);
 
                             BSONObj insertDoc = fixQuery(e["doc"].Obj(), bsonTemplateEvaluator);
 
@@ -596,7 +763,7 @@ namespace mongo {
                         bool safe = e["safe"].trueValue();
                         BSONObj result;
                         {
-                            BenchRunEventTrace _bret(&_stats.deleteCounter);
+                            BenchRunEventTrace _bret(&_intervalStats.deleteCounter, queuedMicros);
                             BSONObj predicate = fixQuery(query, bsonTemplateEvaluator);
                             if (useWriteCmd) {
 
@@ -703,6 +870,18 @@ namespace mongo {
                 if (delay > 0)
                     sleepmillis( delay );
 
+                if (sendGapMicros == 0 && _config->thinkTimeMillis > 0) {
+                    sleepmicros(static_cast<long long>(nextGapMicros(
+                        &random, _config->thinkTimeMillis * 1000, _config->poissonArrivals)));
+                }
+
+                if (intervalMicros > 0) {
+                    const long long elapsedIntervals = timer.micros() / intervalMicros;
+                    if (elapsedIntervals > static_cast<long long>(_intervalIndex)) {
+                        closeInterval();
+                        _intervalIndex = static_cast<size_t>(elapsedIntervals);
+                    }
+                }
             }
         }
 
@@ -859,6 +1038,38 @@ namespace mongo {
                         static_cast<double>(counter.getTotalTimeMicros()) / counter.getNumEvents());
      }
 
+     static void appendLatencyIfAvailable(
+             BSONObjBuilder &buf, const std::string &name, const BenchRunEventCounter &counter) {
+
+         if (counter.getNumEvents() == 0)
+             return;
+
+         BSONObjBuilder latency(buf.subobjStart(name));
+         latency.append("count", static_cast<long long>(counter.getNumEvents()));
+         latency.append("averageMicros",
+                        static_cast<double>(counter.getTotalTimeMicros()) / counter.getNumEvents());
+         latency.append("minMicros", counter.getMinTimeMicros());
+         latency.append("p50Micros", counter.getPercentileMicros(50));
+         latency.append("p95Micros", counter.getPercentileMicros(95));
+         latency.append("p99Micros", counter.getPercentileMicros(99));
+         latency.append("p999Micros", counter.getPercentileMicros(99.9));
+         latency.append("maxMicros", counter.getMaxTimeMicros());
+         latency.done();
+     }
+
+     /**
+      * Appends { findOne: { count: ..., averageMicros: ..., p50Micros: ..., ... }, insert: ... }
+      * for the types of operation which "stats" counted.
+      */
+     static void appendLatencies(BSONObjBuilder &buf, const BenchRunStats &stats) {
+         appendLatencyIfAvailable(buf, "findOne", stats.findOneCounter);
+         appendLatencyIfAvailable(buf, "insert", stats.insertCounter);
+         appendLatencyIfAvailable(buf, "delete", stats.deleteCounter);
+         appendLatencyIfAvailable(buf, "update", stats.updateCounter);
+         appendLatencyIfAvailable(buf, "query", stats.queryCounter);
+         appendLatencyIfAvailable(buf, "command", stats.commandCounter);
+     }
+
      BSONObj BenchRunner::finish( BenchRunner* runner ) {
 
          runner->stop();
@@ -885,6 +1096,27 @@ namespace mongo {
          appendAverageMicrosIfAvailable(buf, "deleteLatencyAverageMicros", stats.deleteCounter);
          appendAverageMicrosIfAvailable(buf, "updateLatencyAverageMicros", stats.updateCounter);
          appendAverageMicrosIfAvailable(buf, "queryLatencyAverageMicros", stats.queryCounter);
+         appendAverageMicrosIfAvailable(buf, "commandLatencyAverageMicros", stats.commandCounter);
+
+         {
+             BSONObjBuilder latency(buf.subobjStart("latency"));
+             appendLatencies(latency, stats);
+             latency.done();
+         }
+
+         if (!stats.intervals.empty()) {
+             const double intervalSeconds = runner->config().statsIntervalSeconds;
+             BSONArrayBuilder intervals(buf.subarrayStart("intervals"));
+             for (size_t i = 0; i < stats.intervals.size(); ++i) {
+                 BSONObjBuilder interval(intervals.subobjStart());
+                 interval.append("startSeconds", i * intervalSeconds);
+                 BSONObjBuilder latency(interval.subobjStart("latency"));
+                 appendLatencies(latency, *stats.intervals[i]);
+                 latency.done();
+                 interval.done();
+             }
+             intervals.done();
+         }
 
          {
              BSONObjIterator i( after );
@@ -29,6 +29,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include <boost/shared_ptr.hpp>
 #include <boost/thread/condition.hpp>
@@ -100,6 +101,34 @@ namespace mongo {
          */
         double seconds;
 
+        /**
+         * Length, in seconds, of the intervals into which the run's latencies are also broken
+         * down, so that a run reports a time series as well as its totals.  Zero, the default,
+         * reports only the totals.
+         */
+        double statsIntervalSeconds;
+
+        /**
+         * Target rate, in operations per second across all threads, at which to send operations
+         * "open loop": each thread sends on a schedule rather than as soon as its previous
+         * operation returns, and an operation's latency is measured from its scheduled send time.
+         * Latencies then include the time spent waiting behind slower operations, which a closed
+         * loop hides.  Zero, the default, runs closed loop.
+         */
+        double opsPerSecond;
+
+        /**
+         * Whether the gaps between a thread's scheduled sends, and its think times, are randomly
+         * exponentially distributed around their means (Poisson arrivals) rather than fixed.
+         */
+        bool poissonArrivals;
+
+        /**
+         * Mean time, in milliseconds, for which a thread waits after each operation before
+         * sending the next one in a closed loop, on top of any "delay" of the operation itself.
+         */
+        double thinkTimeMillis;
+
         bool hideResults;
         bool handleErrors;
         bool hideErrors;
@@ -133,6 +162,11 @@ namespace mongo {
     /**
      * An event counter for events that have an associated duration.
      *
+     * Besides the count and total duration it keeps an HDR-style histogram of the durations, from
+     * which percentiles are read.  Durations under kSubBuckets microseconds each get a bucket of
+     * their own, and each power of two above that is split into kSubBuckets equal buckets, so a
+     * percentile is accurate to within 1/kSubBuckets of the true duration at any magnitude.
+     *
      * Not thread safe.  Expected use is one instance per thread during parallel execution.
      */
     class BenchRunEventCounter : private boost::noncopyable {
@@ -154,10 +188,7 @@ namespace mongo {
         /**
          * Count one instance of the event, which took "timeMicros" microseconds.
          */
-        void countOne(long long timeMicros) {
-            ++_numEvents;
-            _totalTimeMicros += timeMicros;
-        }
+        void countOne(long long timeMicros);
 
         /**
          * Get the total number of microseconds ellapsed during all observed events.
@@ -169,9 +200,36 @@ namespace mongo {
          */
         unsigned long long getNumEvents() const { return _numEvents; }
 
+        /**
+         * Get the durations of the shortest and the longest observed events.  Zero if there were
+         * no events.
+         */
+        long long getMinTimeMicros() const { return _minTimeMicros; }
+        long long getMaxTimeMicros() const { return _maxTimeMicros; }
+
+        /**
+         * Get the duration within which "percentile" percent of the observed events finished, up
+         * to the precision of the histogram.  Zero if there were no events.
+         */
+        long long getPercentileMicros(double percentile) const;
+
+        static const int kSubBucketBits = 4;
+        static const int kSubBuckets = 1 << kSubBucketBits;
+
     private:
+        /// The histogram bucket counting events of "timeMicros" microseconds.
+        static size_t bucketFor(long long timeMicros);
+
+        /// The longest duration counted by histogram bucket "bucket".
+        static long long highestMicrosIn(size_t bucket);
+
         unsigned long long _numEvents;
         long long _totalTimeMicros;
+        long long _minTimeMicros;
+        long long _maxTimeMicros;
+
+        // Indexed by bucketFor(), and only as long as the highest bucket yet counted.
+        std::vector<unsigned long long> _histogram;
     };
 
     /**
@@ -193,6 +251,15 @@ namespace mongo {
             initialize(eventCounter, eventCounter, false);
         }
 
+        /**
+         * Counts the event as having started "queuedMicros" before the trace was constructed, as
+         * when the event was scheduled to start then but had to wait for earlier ones.
+         */
+        BenchRunEventTrace(BenchRunEventCounter *eventCounter, long long queuedMicros) {
+            initialize(eventCounter, eventCounter, false);
+            _queuedMicros = queuedMicros;
+        }
+
         BenchRunEventTrace(BenchRunEventCounter *successCounter,
                            BenchRunEventCounter *failCounter,
                            bool defaultToFailure=true) {
@@ -200,7 +267,8 @@ namespace mongo {
         }
 
         ~BenchRunEventTrace() {
-            (_succeeded ? _successCounter : _failCounter)->countOne(_timer.micros());
+            BenchRunEventCounter *counter = _succeeded ? _successCounter : _failCounter;
+            counter->countOne(_timer.micros() + _queuedMicros);
         }
 
         void succeed() { _succeeded = true; }
@@ -213,12 +281,14 @@ namespace mongo {
             _successCounter = successCounter;
             _failCounter = failCounter;
             _succeeded = !defaultToFailure;
+            _queuedMicros = 0;
         }
 
         Timer _timer;
         BenchRunEventCounter *_successCounter;
         BenchRunEventCounter *_failCounter;
         bool _succeeded;
+        long long _queuedMicros;
     };
 
     /**
@@ -241,9 +311,17 @@ namespace mongo {
         BenchRunEventCounter insertCounter;
         BenchRunEventCounter deleteCounter;
         BenchRunEventCounter queryCounter;
+        BenchRunEventCounter commandCounter;
 
         std::map<std::string, long long> opcounters;
         std::vector<BSONObj> trappedErrors;
+
+        /**
+         * The events counted during each BenchRunConfig::statsIntervalSeconds of the run, oldest
+         * first.  Empty unless the run was configured with intervals.  The intervals themselves
+         * carry only their event counters.
+         */
+        std::vector<boost::shared_ptr<BenchRunStats> > intervals;
     };
 
     /**
@@ -349,10 +427,26 @@ namespace mongo {
         /// Predicate, used to decide whether or not it's time to terminate the worker.
         bool shouldStop() const;
 
+        /**
+         * Add the events of the current interval into the totals, and into the interval's entry
+         * in _stats.intervals if the run has intervals, then start counting a new interval.
+         */
+        void closeInterval();
+
+        /**
+         * Sleep until "wakeMicros", on the curTimeMicros64() clock.  Returns false, possibly
+         * early, if the worker should stop.
+         */
+        bool sleepUntil(unsigned long long wakeMicros) const;
+
         size_t _id;
         const BenchRunConfig *_config;
         BenchRunState *_brState;
         BenchRunStats _stats;
+
+        // Events are counted here as they happen, and closeInterval() moves them into _stats.
+        BenchRunStats _intervalStats;
+        size_t _intervalIndex;
     };
 
     /**
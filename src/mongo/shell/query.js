@@ -40,6 +40,8 @@ DBQuery.prototype.help = function () {
     print("\t.max(idxDoc)")
     print("\t.comment(comment)")
     print("\t.snapshot()")
+    print("\t.allowDiskUse() - lets a sort without a limit spill to disk")
+    print("\t.minOpTime(ts) - waits for the member to have applied the write with optime ts")
     print("\t.readPref(mode, tagset)")
     
     print("\nCursor methods");
@@ -124,6 +126,14 @@ DBQuery.prototype._buildCmdOptions = function() {
         options["snapshot"] = this._query.$snapshot;
     }
 
+    if (this._query.$allowDiskUse) {
+        options["allowDiskUse"] = this._query.$allowDiskUse;
+    }
+
+    if (this._query.$minOpTime) {
+        options["minOpTime"] = this._query.$minOpTime;
+    }
+
     if ((this._options & DBQuery.Option.tailable) != 0) {
         options["tailable"] = true;
     }
@@ -438,6 +448,14 @@ DBQuery.prototype.snapshot = function(){
     return this._addSpecial( "$snapshot" , true );
 }
 
+DBQuery.prototype.allowDiskUse = function(){
+    return this._addSpecial( "$allowDiskUse" , true );
+}
+
+DBQuery.prototype.minOpTime = function( ts ){
+    return this._addSpecial( "$minOpTime" , ts );
+}
+
 DBQuery.prototype.pretty = function(){
     this._prettyShell = true;
     return this;
@@ -494,7 +512,8 @@ DBQuery.Option = {
     noTimeout: 0x10,
     awaitData: 0x20,
     exhaust: 0x40,
-    partial: 0x80
+    partial: 0x80,
+    pipelined: 0x100
 };
 
 function DBCommandCursor(mongo, cmdResult, batchSize) {
@@ -36,6 +36,7 @@
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/dbmessage.h"
 #include "mongo/tools/mongobridge_options.h"
+#include "mongo/tools/traffic_recording.h"
 #include "mongo/util/log.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/net/message.h"
@@ -49,6 +50,9 @@ using namespace std;
 
 void cleanup( int sig );
 
+// Set when running with --record.
+scoped_ptr<TrafficRecorder> recorder;
+
 class Forwarder {
 public:
     Forwarder( MessagingPort &mp ) : mp_( mp ) {
@@ -82,6 +86,7 @@ public:
                     mp_.shutdown();
                     break;
                 }
+                if ( recorder ) recorder->record( mp_.connectionId(), false, m );
                 sleepmillis(mongoBridgeGlobalParams.delay);
 
                 int oldId = m.header().getId();
@@ -98,6 +103,7 @@ public:
                     // nothing to reply with?
                     if ( response.empty() ) cleanup(0);
 
+                    if ( recorder ) recorder->record( mp_.connectionId(), true, response );
                     mp_.reply( m, response, oldId );
                     while ( exhaust ) {
                         MsgData::View header = response.header();
@@ -105,6 +111,7 @@ public:
                         if ( qr.getCursorId() ) {
                             response.reset();
                             dest.port().recv( response );
+                            if ( recorder ) recorder->record( mp_.connectionId(), true, response );
                             mp_.reply( m, response ); // m argument is ignored anyway
                         }
                         else {
@@ -142,6 +149,7 @@ auto_ptr< MyListener > listener;
 
 void cleanup( int sig ) {
     ListeningSockets::get()->closeAll();
+    if ( recorder ) recorder->flush();
     for ( set<MessagingPort*>::iterator i = ports.begin(); i != ports.end(); i++ )
         (*i)->shutdown();
     quickExit( 0 );
@@ -173,6 +181,10 @@ int toolMain( int argc, char **argv, char** envp ) {
 
     setupSignals();
 
+    if ( !mongoBridgeGlobalParams.recordFile.empty() ) {
+        recorder.reset(new TrafficRecorder(mongoBridgeGlobalParams.recordFile));
+    }
+
     listener.reset(new MyListener(mongoBridgeGlobalParams.port));
     listener->setupSockets();
     listener->initAndListen();
@@ -51,12 +51,16 @@ namespace mongo {
                                   .setDefault(moe::Value(0));
 
 
+        options->addOptionChaining("record", "record", moe::String,
+                "write forwarded messages to this file for mongoreplay");
+
+
         return Status::OK();
     }
 
     void printMongoBridgeHelp(std::ostream* out) {
-        *out << "Usage: mongobridge --port <port> --dest <dest> [ --delay <ms> ] [ --help ]"
-             << std::endl;
+        *out << "Usage: mongobridge --port <port> --dest <dest> [ --delay <ms> ] "
+             << "[ --record <file> ] [ --help ]" << std::endl;
         *out << moe::startupOptions.helpString();
         *out << std::flush;
     }
@@ -87,6 +91,10 @@ namespace mongo {
             mongoBridgeGlobalParams.delay = params["delay"].as<int>();
         }
 
+        if (params.count("record")) {
+            mongoBridgeGlobalParams.recordFile = params["record"].as<std::string>();
+        }
+
         return Status::OK();
     }
 
@@ -49,6 +49,9 @@ namespace mongo {
         int connectTimeoutSec;
         std::string destUri;
 
+        // When set, every forwarded message is written to this traffic file for mongoreplay.
+        std::string recordFile;
+
         MongoBridgeGlobalParams() : port(0), delay(0), connectTimeoutSec(15) {}
     };
 
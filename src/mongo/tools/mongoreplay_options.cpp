@@ -0,0 +1,98 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/tools/mongoreplay_options.h"
+
+#include "mongo/base/status.h"
+#include "mongo/util/options_parser/startup_options.h"
+
+namespace mongo {
+
+    MongoReplayGlobalParams mongoReplayGlobalParams;
+
+    Status addMongoReplayOptions(moe::OptionSection* options) {
+
+        options->addOptionChaining("help", "help", moe::Switch, "produce help message");
+
+
+        options->addOptionChaining("file", "file", moe::String,
+                "traffic file written by mongobridge --record");
+
+
+        options->addOptionChaining("host", "host", moe::String,
+                "host:port of the server to replay against");
+
+
+        options->addOptionChaining("speed", "speed", moe::Double,
+                "replay this many times faster than recorded (default = 1)")
+                                  .setDefault(moe::Value(1.0));
+
+
+        return Status::OK();
+    }
+
+    void printMongoReplayHelp(std::ostream* out) {
+        *out << "Usage: mongoreplay --file <file> --host <host:port> [ --speed <n> ] [ --help ]"
+             << std::endl;
+        *out << moe::startupOptions.helpString();
+        *out << std::flush;
+    }
+
+    bool handlePreValidationMongoReplayOptions(const moe::Environment& params) {
+        if (params.count("help")) {
+            printMongoReplayHelp(&std::cout);
+            return false;
+        }
+        return true;
+    }
+
+    Status storeMongoReplayOptions(const moe::Environment& params,
+                                   const std::vector<std::string>& args) {
+
+        if (!params.count("file")) {
+            return Status(ErrorCodes::BadValue, "Missing required option: \"--file\"");
+        }
+
+        if (!params.count("host")) {
+            return Status(ErrorCodes::BadValue, "Missing required option: \"--host\"");
+        }
+
+        mongoReplayGlobalParams.file = params["file"].as<std::string>();
+        mongoReplayGlobalParams.host = params["host"].as<std::string>();
+
+        if (params.count("speed")) {
+            mongoReplayGlobalParams.speed = params["speed"].as<double>();
+            if (!(mongoReplayGlobalParams.speed > 0)) {
+                return Status(ErrorCodes::BadValue, "\"--speed\" must be greater than 0");
+            }
+        }
+
+        return Status::OK();
+    }
+
+} // namespace mongo
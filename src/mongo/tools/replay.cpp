@@ -0,0 +1,372 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+// mongoreplay drives the traffic recorded by mongobridge --record against another server.  Each
+// recorded connection gets its own connection and thread, which sends that connection's requests
+// in their recorded order, each at its recorded time divided by --speed.  At the end it prints
+// the latency distribution of every kind of request which waits for a reply.
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kDefault
+
+#include "mongo/platform/basic.h"
+
+#include <algorithm>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "mongo/base/data_view.h"
+#include "mongo/base/initializer.h"
+#include "mongo/client/dbclientinterface.h"
+#include "mongo/db/dbmessage.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/tools/mongoreplay_options.h"
+#include "mongo/tools/traffic_recording.h"
+#include "mongo/util/log.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/quick_exit.h"
+#include "mongo/util/text.h"
+#include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
+
+using namespace mongo;
+using namespace std;
+
+namespace {
+
+    struct Frame {
+        long long offsetMicros;
+        bool isResponse;
+        boost::shared_ptr<Message> message;
+    };
+
+    typedef map<long long, vector<Frame> > FramesByConnection;
+
+    /**
+     * Latencies of the replayed requests, by kind of request, plus how far behind their recorded
+     * time requests went out.  Shared by all the replay threads.
+     */
+    class ReplayStats {
+    public:
+        ReplayStats() : _maxLagMicros(0), _sent(0), _errors(0) {}
+
+        void sent(long long lagMicros) {
+            boost::mutex::scoped_lock lk(_mutex);
+            _sent++;
+            _maxLagMicros = max(_maxLagMicros, lagMicros);
+        }
+
+        void replied(const string& kind, int latencyMicros) {
+            boost::mutex::scoped_lock lk(_mutex);
+            _latencies[kind].push_back(latencyMicros);
+        }
+
+        void error() {
+            boost::mutex::scoped_lock lk(_mutex);
+            _errors++;
+        }
+
+        void report(ostream& out, long long elapsedMicros) {
+            boost::mutex::scoped_lock lk(_mutex);
+
+            out << "replayed " << _sent << " messages in " << elapsedMicros / 1000 << "ms, "
+                << _errors << " errors, up to " << _maxLagMicros / 1000
+                << "ms behind schedule" << endl;
+
+            out << setw(20) << left << "request" << right << setw(10) << "count"
+                << setw(10) << "p50 ms" << setw(10) << "p90 ms" << setw(10) << "p99 ms"
+                << setw(10) << "max ms" << endl;
+
+            for (map<string, vector<int> >::iterator it = _latencies.begin();
+                 it != _latencies.end(); ++it) {
+                vector<int>& latencies = it->second;
+                sort(latencies.begin(), latencies.end());
+                out << setw(20) << left << it->first << right << setw(10) << latencies.size()
+                    << fixed << setprecision(2)
+                    << setw(10) << percentile(latencies, 50)
+                    << setw(10) << percentile(latencies, 90)
+                    << setw(10) << percentile(latencies, 99)
+                    << setw(10) << latencies.back() / 1000.0 << endl;
+            }
+        }
+
+    private:
+        static double percentile(const vector<int>& sorted, int p) {
+            const size_t i = min(sorted.size() - 1, sorted.size() * p / 100);
+            return sorted[i] / 1000.0;
+        }
+
+        boost::mutex _mutex;
+        map<string, vector<int> > _latencies;
+        long long _maxLagMicros;
+        long long _sent;
+        long long _errors;
+    };
+
+    ReplayStats stats;
+
+    bool expectsReply(const Message& m) {
+        return m.operation() == dbQuery || m.operation() == dbMsg || m.operation() == dbGetMore;
+    }
+
+    /**
+     * Names requests for the latency report: commands by their name and everything else by its
+     * wire protocol operation.
+     */
+    string kindOf(Message& m) {
+        switch (m.operation()) {
+        case dbQuery: {
+            DbMessage d(m);
+            QueryMessage q(d);
+            if (nsToCollectionSubstring(q.ns) == "$cmd" && !q.query.isEmpty()) {
+                BSONObj cmd = q.query;
+                if (cmd.hasField("$query") && cmd["$query"].isABSONObj()) {
+                    cmd = cmd["$query"].Obj();
+                }
+                return cmd.firstElementFieldName();
+            }
+            return "query";
+        }
+        case dbGetMore: return "getMore";
+        case dbMsg: return "msg";
+        default: return opToString(m.operation());
+        }
+    }
+
+    long long cursorIdOf(const Message& response) {
+        if (response.empty()) {
+            return 0;
+        }
+        QueryResult::View qr = response.singleData().view2ptr();
+        return (qr.getResultFlags() & ResultFlag_CursorNotFound) ? 0 : qr.getCursorId();
+    }
+
+    /**
+     * Cursor ids differ between the recorded server and the replay target, so getMore and
+     * killCursors requests have their recorded ids swapped for the ones the target handed out.
+     */
+    void mapCursorIds(Message& m, const map<long long, long long>& cursors) {
+        char* p = m.singleData().data() + sizeof(int32_t);
+        int n = 1;
+        if (m.operation() == dbGetMore) {
+            p += strlen(p) + 1 + sizeof(int32_t);
+        }
+        else if (m.operation() == dbKillCursors) {
+            n = ConstDataView(p).readLE<int32_t>();
+            p += sizeof(int32_t);
+        }
+        else {
+            return;
+        }
+
+        for (int i = 0; i < n; ++i, p += sizeof(int64_t)) {
+            map<long long, long long>::const_iterator it =
+                cursors.find(ConstDataView(p).readLE<int64_t>());
+            if (it != cursors.end()) {
+                DataView(p).writeLE<int64_t>(it->second);
+            }
+        }
+    }
+
+    class ConnectionReplayer {
+    public:
+        ConnectionReplayer(long long connectionId,
+                           const vector<Frame>* frames,
+                           unsigned long long startMicros)
+            : _connectionId(connectionId), _frames(frames), _startMicros(startMicros) {}
+
+        void operator()() const {
+            try {
+                run();
+            }
+            catch (const DBException& e) {
+                log() << "replay of connection " << _connectionId << " stopped: " << e.what();
+                stats.error();
+            }
+        }
+
+    private:
+        unsigned long long dueMicros(const Frame& frame) const {
+            return _startMicros +
+                static_cast<unsigned long long>(frame.offsetMicros / mongoReplayGlobalParams.speed);
+        }
+
+        void waitUntil(unsigned long long due) const {
+            const unsigned long long now = curTimeMicros64();
+            if (now < due) {
+                sleepmicros(due - now);
+            }
+        }
+
+        void run() const {
+            if (!_frames->empty()) {
+                waitUntil(dueMicros(_frames->front()));
+            }
+
+            DBClientConnection conn;
+            string errmsg;
+            if (!conn.connect(HostAndPort(mongoReplayGlobalParams.host), errmsg)) {
+                log() << "replay of connection " << _connectionId << " couldn't connect: "
+                      << errmsg;
+                stats.error();
+                return;
+            }
+
+            map<long long, long long> cursors;
+            long long liveCursorId = 0;
+            bool awaitingRecordedReply = false;
+
+            for (vector<Frame>::const_iterator it = _frames->begin();
+                 it != _frames->end(); ++it) {
+                Message& m = *it->message;
+
+                if (it->isResponse) {
+                    // The first recorded reply to a request says which cursor id to map to the
+                    // one the target just returned.
+                    if (awaitingRecordedReply) {
+                        const long long recordedCursorId = cursorIdOf(m);
+                        if (recordedCursorId && liveCursorId) {
+                            cursors[recordedCursorId] = liveCursorId;
+                        }
+                        awaitingRecordedReply = false;
+                    }
+                    continue;
+                }
+
+                const unsigned long long due = dueMicros(*it);
+                waitUntil(due);
+                stats.sent(curTimeMicros64() - due);
+
+                mapCursorIds(m, cursors);
+
+                if (!expectsReply(m)) {
+                    conn.port().say(m);
+                    continue;
+                }
+
+                bool exhaust = false;
+                if (m.operation() == dbQuery) {
+                    // QueryMessage consumes the DbMessage, so it needs one of its own.
+                    DbMessage d(m);
+                    QueryMessage q(d);
+                    exhaust = q.queryOptions & QueryOption_Exhaust;
+                }
+
+                const string kind = kindOf(m);
+                Message response;
+                Timer timer;
+                if (!conn.port().call(m, response)) {
+                    log() << "replay of connection " << _connectionId << " lost its connection";
+                    stats.error();
+                    return;
+                }
+                stats.replied(kind, timer.micros());
+
+                QueryResult::View qr = response.singleData().view2ptr();
+                if (qr.getResultFlags() & ResultFlag_ErrSet) {
+                    stats.error();
+                }
+                liveCursorId = cursorIdOf(response);
+                awaitingRecordedReply = true;
+
+                while (exhaust && cursorIdOf(response)) {
+                    response.reset();
+                    if (!conn.port().recv(response)) {
+                        break;
+                    }
+                }
+            }
+        }
+
+        const long long _connectionId;
+        const vector<Frame>* const _frames;
+        const unsigned long long _startMicros;
+    };
+
+} // namespace
+
+int toolMain(int argc, char** argv, char** envp) {
+    mongo::runGlobalInitializersOrDie(argc, argv, envp);
+
+    static StaticObserver staticObserver;
+
+    // The whole recording is read up front so that reading the file cannot hold up the replay.
+    FramesByConnection frames;
+    long long nFrames = 0;
+    try {
+        TrafficReader reader(mongoReplayGlobalParams.file);
+        Frame frame;
+        long long connectionId;
+        frame.message.reset(new Message());
+        while (reader.next(&frame.offsetMicros, &connectionId, &frame.isResponse,
+                           frame.message.get())) {
+            frames[connectionId].push_back(frame);
+            frame.message.reset(new Message());
+            nFrames++;
+        }
+    }
+    catch (const DBException& e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    cout << "replaying " << nFrames << " recorded messages from " << frames.size()
+         << " connections against " << mongoReplayGlobalParams.host << " at "
+         << mongoReplayGlobalParams.speed << "x speed" << endl;
+
+    const unsigned long long startMicros = curTimeMicros64();
+    boost::thread_group threads;
+    for (FramesByConnection::const_iterator it = frames.begin(); it != frames.end(); ++it) {
+        threads.create_thread(ConnectionReplayer(it->first, &it->second, startMicros));
+    }
+    threads.join_all();
+
+    stats.report(cout, curTimeMicros64() - startMicros);
+    return 0;
+}
+
+#if defined(_WIN32)
+// In Windows, wmain() is an alternate entry point for main(), and receives the same parameters
+// as main() but encoded in Windows Unicode (UTF-16); "wide" 16-bit wchar_t characters.  The
+// WindowsCommandLine object converts these wide character strings to a UTF-8 coded equivalent
+// and makes them available through the argv() and envp() members.  This enables toolMain()
+// to process UTF-8 encoded arguments and environment variables without regard to platform.
+int wmain(int argc, wchar_t* argvW[], wchar_t* envpW[]) {
+    WindowsCommandLine wcl(argc, argvW, envpW);
+    int exitCode = toolMain(argc, wcl.argv(), wcl.envp());
+    quickExit(exitCode);
+}
+#else
+int main(int argc, char* argv[], char** envp) {
+    int exitCode = toolMain(argc, argv, envp);
+    quickExit(exitCode);
+}
+#endif
@@ -0,0 +1,136 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/tools/traffic_recording.h"
+
+#include <cstring>
+
+#include "mongo/base/data_view.h"
+#include "mongo/util/allocator.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    const char kTrafficFileMagic[8] = { 'm', 'g', 'o', 't', 'r', 'a', 'f', 'f' };
+
+    namespace {
+        const size_t kFileHeaderSize = sizeof(kTrafficFileMagic) + sizeof(int32_t);
+        const size_t kFrameHeaderSize = 2 * sizeof(int64_t) + sizeof(int32_t);
+    } // namespace
+
+    TrafficRecorder::TrafficRecorder(const std::string& path)
+        : _out(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc),
+          _startMicros(curTimeMicros64()) {
+
+        uassert(28656, str::stream() << "couldn't open " << path << " to record traffic", _out);
+
+        char header[kFileHeaderSize];
+        memcpy(header, kTrafficFileMagic, sizeof(kTrafficFileMagic));
+        DataView(header).writeLE<int32_t>(kTrafficFileVersion, sizeof(kTrafficFileMagic));
+        _out.write(header, sizeof(header));
+    }
+
+    void TrafficRecorder::record(long long connectionId,
+                                 bool isResponse,
+                                 const Message& message) {
+        MsgData::View data = message.singleData();
+
+        char header[kFrameHeaderSize];
+        DataView(header)
+            .writeLE<int64_t>(curTimeMicros64() - _startMicros, 0)
+            .writeLE<int64_t>(connectionId, sizeof(int64_t))
+            .writeLE<int32_t>(isResponse ? kTrafficFrameResponse : 0, 2 * sizeof(int64_t));
+
+        boost::mutex::scoped_lock lk(_mutex);
+        _out.write(header, sizeof(header));
+        _out.write(data.view2ptr(), data.getLen());
+        uassert(28657, "couldn't write recorded traffic", _out);
+    }
+
+    void TrafficRecorder::flush() {
+        boost::mutex::scoped_lock lk(_mutex);
+        _out.flush();
+    }
+
+    TrafficReader::TrafficReader(const std::string& path)
+        : _in(path.c_str(), std::ios::in | std::ios::binary),
+          _path(path) {
+
+        uassert(28658, str::stream() << "couldn't open traffic file " << path, _in);
+
+        char header[kFileHeaderSize];
+        _in.read(header, sizeof(header));
+        uassert(28659, str::stream() << path << " is not a traffic file",
+                _in && memcmp(header, kTrafficFileMagic, sizeof(kTrafficFileMagic)) == 0);
+
+        const int32_t version = ConstDataView(header).readLE<int32_t>(sizeof(kTrafficFileMagic));
+        uassert(28660, str::stream() << path << " has unsupported traffic file version "
+                                     << version,
+                version == kTrafficFileVersion);
+    }
+
+    bool TrafficReader::next(long long* offsetMicros,
+                             long long* connectionId,
+                             bool* isResponse,
+                             Message* message) {
+        char header[kFrameHeaderSize + sizeof(int32_t)];
+        _in.read(header, sizeof(header));
+        if (_in.gcount() == 0 && _in.eof()) {
+            return false;
+        }
+        uassert(28661, str::stream() << _path << " ends in the middle of a frame", _in);
+
+        ConstDataView view(header);
+        *offsetMicros = view.readLE<int64_t>(0);
+        *connectionId = view.readLE<int64_t>(sizeof(int64_t));
+        *isResponse = view.readLE<int32_t>(2 * sizeof(int64_t)) & kTrafficFrameResponse;
+
+        const int32_t length = view.readLE<int32_t>(kFrameHeaderSize);
+        uassert(28662, str::stream() << _path << " has a frame with bad message length " << length,
+                length >= MsgData::MsgDataHeaderSize &&
+                static_cast<size_t>(length) <= MaxMessageSizeBytes);
+
+        char* buf = static_cast<char*>(mongoMalloc(length));
+        DataView(buf).writeLE<int32_t>(length);
+        _in.read(buf + sizeof(int32_t), length - sizeof(int32_t));
+        if (!_in) {
+            free(buf);
+            uasserted(28663, str::stream() << _path << " ends in the middle of a message");
+        }
+
+        message->reset();
+        message->setData(buf, true);
+        return true;
+    }
+
+} // namespace mongo
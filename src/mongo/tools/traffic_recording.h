@@ -0,0 +1,106 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/thread/mutex.hpp>
+#include <fstream>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+
+namespace mongo {
+
+    class Message;
+
+    /**
+     * mongobridge --record writes every message it forwards to a traffic file, which mongoreplay
+     * later drives against another server.  The file starts with kTrafficFileMagic and a format
+     * version, followed by one frame per message:
+     *
+     *     int64 offsetMicros    time since the recording started
+     *     int64 connectionId    bridge connection the message travelled on
+     *     int32 flags           kTrafficFrameResponse for messages from the server
+     *     message               the whole wire protocol message, starting with its length
+     *
+     * All integers are little endian.  Frames of one connection are in the order the bridge saw
+     * them, and each response follows the request it answers.
+     */
+    extern const char kTrafficFileMagic[8];
+    const int kTrafficFileVersion = 1;
+    const int kTrafficFrameResponse = 1;
+
+    /**
+     * Appends frames to a traffic file.  Safe to call from every forwarding thread at once.
+     */
+    class TrafficRecorder {
+        MONGO_DISALLOW_COPYING(TrafficRecorder);
+    public:
+        /**
+         * Creates the file at 'path', replacing anything already there.  Throws a UserException
+         * if it cannot be written.
+         */
+        explicit TrafficRecorder(const std::string& path);
+
+        void record(long long connectionId, bool isResponse, const Message& message);
+
+        void flush();
+
+    private:
+        boost::mutex _mutex;
+        std::ofstream _out;
+        const unsigned long long _startMicros;
+    };
+
+    /**
+     * Reads the frames of a traffic file back in order.
+     */
+    class TrafficReader {
+        MONGO_DISALLOW_COPYING(TrafficReader);
+    public:
+        /**
+         * Opens the file at 'path' and checks its header.  Throws a UserException if it is not a
+         * traffic file of a known version.
+         */
+        explicit TrafficReader(const std::string& path);
+
+        /**
+         * Fills in the next frame and returns true, or returns false at the end of the file.
+         * Throws a UserException if the file is truncated or corrupt.
+         */
+        bool next(long long* offsetMicros,
+                  long long* connectionId,
+                  bool* isResponse,
+                  Message* message);
+
+    private:
+        std::ifstream _in;
+        const std::string _path;
+    };
+
+} // namespace mongo
@@ -0,0 +1,428 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/unittest/benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+#include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/text.h"
+
+namespace mongo {
+namespace benchmark {
+
+    namespace {
+
+        struct Benchmark {
+            std::string name;
+            BenchmarkFunction function;
+            std::vector<long long> args;
+        };
+
+        std::vector<Benchmark>& registeredBenchmarks() {
+            static std::vector<Benchmark> benchmarks;
+            return benchmarks;
+        }
+
+        // Two-sided 95% critical values of Student's t, by degrees of freedom from 1.
+        const double kStudentT95[] = {
+            12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+            2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+            2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+        };
+
+        double studentT95(size_t degreesOfFreedom) {
+            const size_t kTableSize = sizeof(kStudentT95) / sizeof(kStudentT95[0]);
+            if (degreesOfFreedom == 0) {
+                return 0;
+            }
+            if (degreesOfFreedom > kTableSize) {
+                return 1.960;
+            }
+            return kStudentT95[degreesOfFreedom - 1];
+        }
+
+        /**
+         * Runs one sample of 'iterations' iterations of 'benchmark' with 'arg', returning the
+         * timed microseconds.  The operation latencies the sample recorded are appended to
+         * 'latencyNanos', unless it is NULL, and its items per iteration put in '*items'.
+         */
+        long long runSample(const Benchmark& benchmark,
+                            long long arg,
+                            long long iterations,
+                            std::vector<long long>* latencyNanos = NULL,
+                            long long* items = NULL) {
+            State state(arg, iterations);
+            benchmark.function(state);
+            massert(28623,
+                    str::stream() << "benchmark " << benchmark.name
+                                  << " returned without running its keepRunning() loop to the end",
+                    state.finished());
+            if (latencyNanos) {
+                latencyNanos->insert(latencyNanos->end(),
+                                     state.latencyNanos().begin(),
+                                     state.latencyNanos().end());
+            }
+            if (items) {
+                *items = state.itemsPerIteration();
+            }
+            return state.elapsedMicros();
+        }
+
+        double percentile(const std::vector<long long>& sorted, double fraction) {
+            const size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+            return static_cast<double>(sorted[index]);
+        }
+
+        /**
+         * Doubles the iterations of a sample until it takes at least 'minMicros', and returns
+         * that number of iterations.
+         */
+        long long calibrate(const Benchmark& benchmark, long long arg, double minMicros) {
+            long long iterations = 1;
+            for (;;) {
+                const long long micros = runSample(benchmark, arg, iterations);
+                if (micros >= minMicros) {
+                    return iterations;
+                }
+                // Jump most of the way there once the sample is long enough to measure.
+                if (micros > 100) {
+                    const double scale = 1.2 * minMicros / micros;
+                    iterations = std::max(iterations + 1,
+                                          static_cast<long long>(iterations * scale));
+                }
+                else {
+                    iterations *= 2;
+                }
+            }
+        }
+
+    }  // namespace
+
+    State::State(long long arg, long long iterations)
+        : _arg(arg),
+          _iterations(iterations),
+          _remaining(iterations),
+          _started(false),
+          _running(true),
+          _elapsedMicros(0),
+          _itemsPerIteration(1),
+          _sink(0) {
+    }
+
+    void State::pauseTiming() {
+        _elapsedMicros += _timer.micros();
+        _running = false;
+    }
+
+    void State::resumeTiming() {
+        _running = true;
+        _timer.reset();
+    }
+
+    void State::stopTiming() {
+        if (_running) {
+            _elapsedMicros += _timer.micros();
+            _running = false;
+        }
+    }
+
+    Registration::Registration(const char* name, BenchmarkFunction function, const char* args) {
+        Benchmark benchmark;
+        benchmark.name = name;
+        benchmark.function = function;
+
+        const std::vector<std::string> argStrings = StringSplitter::split(args, ",");
+        for (size_t i = 0; i < argStrings.size(); i++) {
+            benchmark.args.push_back(atoll(argStrings[i].c_str()));
+        }
+        if (benchmark.args.empty()) {
+            benchmark.args.push_back(0);
+        }
+
+        registeredBenchmarks().push_back(benchmark);
+    }
+
+    RunOptions::RunOptions()
+        : minSampleMillis(10),
+          warmupMillis(100),
+          samples(20) {
+    }
+
+    Result::Result()
+        : arg(0),
+          iterationsPerSample(0),
+          median(0),
+          mean(0),
+          min(0),
+          max(0),
+          stddev(0),
+          ci95(0),
+          itemsPerIteration(1),
+          itemsPerSecond(0),
+          latencyCount(0),
+          latencyP50(0),
+          latencyP95(0),
+          latencyP99(0),
+          latencyMax(0) {
+    }
+
+    std::string Result::fullName() const {
+        if (arg == 0) {
+            return name;
+        }
+        return str::stream() << name << '/' << arg;
+    }
+
+    void Result::computeStatistics() {
+        median = mean = min = max = stddev = ci95 = 0;
+        const size_t n = nanosPerIteration.size();
+        if (n == 0) {
+            return;
+        }
+
+        std::vector<double> sorted(nanosPerIteration);
+        std::sort(sorted.begin(), sorted.end());
+        median = n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+        min = sorted.front();
+        max = sorted.back();
+
+        double total = 0;
+        for (size_t i = 0; i < n; i++) {
+            total += sorted[i];
+        }
+        mean = total / n;
+        itemsPerSecond = median > 0 ? 1e9 * itemsPerIteration / median : 0;
+
+        if (n > 1) {
+            double squares = 0;
+            for (size_t i = 0; i < n; i++) {
+                squares += (sorted[i] - mean) * (sorted[i] - mean);
+            }
+            stddev = std::sqrt(squares / (n - 1));
+            ci95 = studentT95(n - 1) * stddev / std::sqrt(static_cast<double>(n));
+        }
+    }
+
+    void Result::computeLatencies(std::vector<long long>* nanos) {
+        latencyCount = nanos->size();
+        latencyP50 = latencyP95 = latencyP99 = latencyMax = 0;
+        if (nanos->empty()) {
+            return;
+        }
+
+        std::sort(nanos->begin(), nanos->end());
+        latencyP50 = percentile(*nanos, 0.50);
+        latencyP95 = percentile(*nanos, 0.95);
+        latencyP99 = percentile(*nanos, 0.99);
+        latencyMax = static_cast<double>(nanos->back());
+    }
+
+    BSONObj Result::toBSON() const {
+        BSONObjBuilder bob;
+        bob.append("name", name);
+        bob.append("arg", arg);
+        bob.append("iterationsPerSample", iterationsPerSample);
+        bob.append("samples", static_cast<int>(nanosPerIteration.size()));
+        bob.append("medianNanos", median);
+        bob.append("meanNanos", mean);
+        bob.append("minNanos", min);
+        bob.append("maxNanos", max);
+        bob.append("stddevNanos", stddev);
+        bob.append("ci95Nanos", ci95);
+        bob.append("itemsPerIteration", itemsPerIteration);
+        bob.append("itemsPerSecond", itemsPerSecond);
+        if (latencyCount > 0) {
+            bob.append("latencyNanos", BSON("count" << static_cast<long long>(latencyCount)
+                                            << "p50" << latencyP50
+                                            << "p95" << latencyP95
+                                            << "p99" << latencyP99
+                                            << "max" << latencyMax));
+        }
+        bob.append("nanosPerIteration", nanosPerIteration);
+        return bob.obj();
+    }
+
+    Result Result::fromBSON(const BSONObj& obj) {
+        Result result;
+        result.name = obj["name"].str();
+        result.arg = obj["arg"].numberLong();
+        result.iterationsPerSample = obj["iterationsPerSample"].numberLong();
+        result.median = obj["medianNanos"].numberDouble();
+        result.mean = obj["meanNanos"].numberDouble();
+        result.min = obj["minNanos"].numberDouble();
+        result.max = obj["maxNanos"].numberDouble();
+        result.stddev = obj["stddevNanos"].numberDouble();
+        result.ci95 = obj["ci95Nanos"].numberDouble();
+        if (obj.hasField("itemsPerIteration")) {
+            result.itemsPerIteration = obj["itemsPerIteration"].numberLong();
+            result.itemsPerSecond = obj["itemsPerSecond"].numberDouble();
+        }
+        if (obj["latencyNanos"].isABSONObj()) {
+            const BSONObj latency = obj["latencyNanos"].Obj();
+            result.latencyCount = static_cast<size_t>(latency["count"].numberLong());
+            result.latencyP50 = latency["p50"].numberDouble();
+            result.latencyP95 = latency["p95"].numberDouble();
+            result.latencyP99 = latency["p99"].numberDouble();
+            result.latencyMax = latency["max"].numberDouble();
+        }
+        return result;
+    }
+
+    std::vector<std::string> listBenchmarks() {
+        std::vector<std::string> names;
+        const std::vector<Benchmark>& benchmarks = registeredBenchmarks();
+        for (size_t i = 0; i < benchmarks.size(); i++) {
+            for (size_t j = 0; j < benchmarks[i].args.size(); j++) {
+                Result result;
+                result.name = benchmarks[i].name;
+                result.arg = benchmarks[i].args[j];
+                names.push_back(result.fullName());
+            }
+        }
+        return names;
+    }
+
+    std::vector<Result> runBenchmarks(const RunOptions& options, std::ostream& out) {
+        out << std::left << std::setw(48) << "benchmark" << std::right
+            << std::setw(14) << "median ns" << std::setw(14) << "+/- 95% ns"
+            << std::setw(14) << "min ns" << std::setw(14) << "iterations" << std::endl;
+
+        std::vector<Result> results;
+        const std::vector<Benchmark>& benchmarks = registeredBenchmarks();
+        for (size_t i = 0; i < benchmarks.size(); i++) {
+            const Benchmark& benchmark = benchmarks[i];
+            if (benchmark.name.find(options.filter) == std::string::npos) {
+                continue;
+            }
+
+            for (size_t j = 0; j < benchmark.args.size(); j++) {
+                Result result;
+                result.name = benchmark.name;
+                result.arg = benchmark.args[j];
+
+                const double minMicros = options.minSampleMillis * 1000;
+                result.iterationsPerSample = calibrate(benchmark, result.arg, minMicros);
+
+                // Warm up caches, the allocator and the CPU's clock before measuring.
+                Timer warmup;
+                while (warmup.micros() < options.warmupMillis * 1000) {
+                    runSample(benchmark, result.arg, result.iterationsPerSample);
+                }
+
+                std::vector<long long> latencyNanos;
+                for (int sample = 0; sample < options.samples; sample++) {
+                    const long long micros = runSample(benchmark,
+                                                       result.arg,
+                                                       result.iterationsPerSample,
+                                                       &latencyNanos,
+                                                       &result.itemsPerIteration);
+                    result.nanosPerIteration.push_back(1000.0 * micros
+                                                       / result.iterationsPerSample);
+                }
+                result.computeStatistics();
+                result.computeLatencies(&latencyNanos);
+
+                out << std::left << std::setw(48) << result.fullName() << std::right
+                    << std::fixed << std::setprecision(1)
+                    << std::setw(14) << result.median << std::setw(14) << result.ci95
+                    << std::setw(14) << result.min
+                    << std::setw(14) << result.iterationsPerSample << std::endl;
+                if (result.itemsPerIteration != 1 || result.latencyCount > 0) {
+                    out << "    " << std::setprecision(0) << result.itemsPerSecond << " ops/s";
+                    if (result.latencyCount > 0) {
+                        out << ", latency ns p50 " << result.latencyP50
+                            << " p95 " << result.latencyP95
+                            << " p99 " << result.latencyP99
+                            << " max " << result.latencyMax;
+                    }
+                    out << std::endl;
+                }
+                results.push_back(result);
+            }
+        }
+        return results;
+    }
+
+    size_t compareToBaseline(const std::vector<Result>& results,
+                             const BSONObj& baseline,
+                             double thresholdPercent,
+                             std::ostream& out) {
+        std::map<std::string, Result> baselineResults;
+        BSONObjIterator it(baseline["benchmarks"].Obj());
+        while (it.more()) {
+            const Result result = Result::fromBSON(it.next().Obj());
+            baselineResults[result.fullName()] = result;
+        }
+
+        out << std::left << std::setw(48) << "benchmark" << std::right
+            << std::setw(14) << "baseline ns" << std::setw(14) << "median ns"
+            << std::setw(10) << "change" << "  verdict" << std::endl;
+
+        size_t regressions = 0;
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& current = results[i];
+            std::map<std::string, Result>::const_iterator found =
+                baselineResults.find(current.fullName());
+            if (found == baselineResults.end()) {
+                continue;
+            }
+            const Result& before = found->second;
+
+            const double changePercent = before.median > 0 ?
+                100 * (current.median - before.median) / before.median : 0;
+            const bool overlapping = current.mean - current.ci95 <= before.mean + before.ci95
+                                  && before.mean - before.ci95 <= current.mean + current.ci95;
+
+            const char* verdict = "unchanged";
+            if (!overlapping && changePercent > thresholdPercent) {
+                verdict = "REGRESSION";
+                regressions++;
+            }
+            else if (!overlapping && changePercent < -thresholdPercent) {
+                verdict = "improvement";
+            }
+
+            out << std::left << std::setw(48) << current.fullName() << std::right
+                << std::fixed << std::setprecision(1)
+                << std::setw(14) << before.median << std::setw(14) << current.median
+                << std::setw(9) << std::showpos << changePercent << std::noshowpos << "%  "
+                << verdict << std::endl;
+        }
+        return regressions;
+    }
+
+}  // namespace benchmark
+}  // namespace mongo
@@ -0,0 +1,257 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * A microbenchmark framework, for timing small units of code repeatably enough to compare builds.
+ *
+ * Define a benchmark in any file linked into the mongo_benchmark program:
+ *
+ *     MONGO_BENCHMARK(BSONObjBuilderAppendInt) {
+ *         // Setup here is not timed.
+ *         while (state.keepRunning()) {
+ *             BSONObjBuilder bob;
+ *             bob.append("a", 1);
+ *             state.doNotOptimize(bob.obj());
+ *         }
+ *     }
+ *
+ * or, to run it once for each of a list of arguments, read through state.arg():
+ *
+ *     MONGO_BENCHMARK_WITH_ARGS(BSONObjIterate, "1,10,100") { ... }
+ *
+ * The runner calibrates how many iterations make up a sample of at least --minSampleMillis, warms
+ * up, then takes --samples samples and reports the median, mean, spread and a 95% confidence
+ * interval of the time per iteration.  A benchmark whose iterations each do several operations
+ * can say how many with state.setItemsPerIteration(), to also report a throughput, and can time
+ * the operations itself and hand those times to state.recordLatency() for percentiles.  See
+ * benchmark_main.cpp for the options, the JSON output and the comparison against a baseline.
+ */
+
+#pragma once
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+namespace benchmark {
+
+    /**
+     * Handed to a benchmark function for each sample: how many iterations to run, and the
+     * argument it was registered with.  Only the time inside the "while (state.keepRunning())"
+     * loop counts, less any time between pauseTiming() and resumeTiming().
+     */
+    class State {
+        MONGO_DISALLOW_COPYING(State);
+    public:
+        State(long long arg, long long iterations);
+
+        /**
+         * Returns true, the first time starting the clock, until the iterations of the sample are
+         * done, and then false, stopping the clock.
+         */
+        bool keepRunning() {
+            if (!_started) {
+                _started = true;
+                _timer.reset();
+            }
+            if (_remaining > 0) {
+                --_remaining;
+                return true;
+            }
+            stopTiming();
+            return false;
+        }
+
+        /**
+         * Exclude the time until resumeTiming() from the sample, as for setup that has to be
+         * repeated each iteration.  Pausing costs a clock read, so is only for iterations which
+         * are much slower than that.
+         */
+        void pauseTiming();
+        void resumeTiming();
+
+        /**
+         * Stops the compiler from optimizing away the computation of 'value' as unused.
+         */
+        template <typename T>
+        void doNotOptimize(const T& value) {
+            _sink = _sink + *reinterpret_cast<const volatile char*>(&value);
+        }
+
+        /**
+         * How many operations each iteration does, for the throughput.  Defaults to 1.
+         */
+        void setItemsPerIteration(long long items) { _itemsPerIteration = items; }
+
+        /**
+         * Records how long one operation took, for the latency percentiles.  Only call this from
+         * the benchmark's own thread; threads the benchmark starts collect their times and hand
+         * them over when they are done.
+         */
+        void recordLatency(long long nanos) { _latencyNanos.push_back(nanos); }
+
+        long long arg() const { return _arg; }
+        long long iterations() const { return _iterations; }
+        long long itemsPerIteration() const { return _itemsPerIteration; }
+        const std::vector<long long>& latencyNanos() const { return _latencyNanos; }
+
+        /// The timed microseconds of the sample, once keepRunning() has returned false.
+        long long elapsedMicros() const { return _elapsedMicros; }
+
+        /// Whether the benchmark ran its loop to the end.
+        bool finished() const { return _started && _remaining == 0 && !_running; }
+
+    private:
+        void stopTiming();
+
+        const long long _arg;
+        const long long _iterations;
+        long long _remaining;
+        bool _started;
+        bool _running;
+        Timer _timer;
+        long long _elapsedMicros;
+        long long _itemsPerIteration;
+        std::vector<long long> _latencyNanos;
+        volatile char _sink;
+    };
+
+    typedef void (*BenchmarkFunction)(State& state);
+
+    /**
+     * Registers a benchmark during static initialization.  Use MONGO_BENCHMARK or
+     * MONGO_BENCHMARK_WITH_ARGS rather than this directly.
+     *
+     * 'args' is a comma separated list of the arguments to run the benchmark with, each run
+     * reported separately, or empty to run it once with the argument 0.
+     */
+    class Registration {
+        MONGO_DISALLOW_COPYING(Registration);
+    public:
+        Registration(const char* name, BenchmarkFunction function, const char* args);
+    };
+
+    struct RunOptions {
+        RunOptions();
+
+        // Only benchmarks whose names contain this are run.  Empty runs all of them.
+        std::string filter;
+
+        // Samples are taken of as many iterations as take at least this long.
+        double minSampleMillis;
+
+        // How long each benchmark runs before its samples are taken.
+        double warmupMillis;
+
+        int samples;
+    };
+
+    /**
+     * The times per iteration of the samples of one run of a benchmark, and their statistics.
+     */
+    struct Result {
+        std::string name;
+        long long arg;
+        long long iterationsPerSample;
+        std::vector<double> nanosPerIteration;
+
+        double median;
+        double mean;
+        double min;
+        double max;
+        double stddev;
+
+        // Half the width of the 95% confidence interval of the mean, from Student's t.
+        double ci95;
+
+        // Operations per second at the median time per iteration.
+        long long itemsPerIteration;
+        double itemsPerSecond;
+
+        // Percentiles of the times passed to State::recordLatency(), if any were.
+        size_t latencyCount;
+        double latencyP50;
+        double latencyP95;
+        double latencyP99;
+        double latencyMax;
+
+        /// "name" or "name/arg".
+        std::string fullName() const;
+
+        Result();
+
+        /// Fills in the statistics from nanosPerIteration and itemsPerIteration.
+        void computeStatistics();
+
+        /// Fills in the latency percentiles.  Sorts 'nanos'.
+        void computeLatencies(std::vector<long long>* nanos);
+
+        BSONObj toBSON() const;
+
+        /// The inverse of toBSON(), without the samples.
+        static Result fromBSON(const BSONObj& obj);
+    };
+
+    /**
+     * Lists the names of the registered benchmarks, each with its arguments, in registration
+     * order.
+     */
+    std::vector<std::string> listBenchmarks();
+
+    /**
+     * Runs the registered benchmarks which match options.filter, printing a line to 'out' as
+     * each run finishes.
+     */
+    std::vector<Result> runBenchmarks(const RunOptions& options, std::ostream& out);
+
+    /**
+     * Compares 'results' with those of an earlier run, as read from its JSON output, printing a
+     * line for each run found in both to 'out'.  A run is a regression when its median is more
+     * than 'thresholdPercent' slower than the baseline's and the confidence intervals of their
+     * means don't overlap.  Returns the number of regressions.
+     */
+    size_t compareToBaseline(const std::vector<Result>& results,
+                             const BSONObj& baseline,
+                             double thresholdPercent,
+                             std::ostream& out);
+
+}  // namespace benchmark
+}  // namespace mongo
+
+#define MONGO_BENCHMARK(NAME) MONGO_BENCHMARK_WITH_ARGS(NAME, "")
+
+#define MONGO_BENCHMARK_WITH_ARGS(NAME, ARGS)                                           \
+    static void _mongoBenchmark_##NAME(::mongo::benchmark::State& state);                \
+    static ::mongo::benchmark::Registration _mongoBenchmarkRegistration_##NAME(          \
+            #NAME, &_mongoBenchmark_##NAME, ARGS);                                       \
+    static void _mongoBenchmark_##NAME(::mongo::benchmark::State& state)
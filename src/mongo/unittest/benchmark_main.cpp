@@ -0,0 +1,183 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * The main() of mongo_benchmark, which runs the benchmarks registered with MONGO_BENCHMARK.
+ *
+ *     mongo_benchmark [--filter <substring>] [--samples <n>] [--minSampleMillis <ms>]
+ *                     [--warmupMillis <ms>] [--json <file>] [--label <label>]
+ *                     [--baseline <file> [--threshold <percent>]] [--list]
+ *
+ * --json writes the results, with every sample, to <file>.  --baseline compares the results with
+ * a file written by --json from an earlier build, and exits with status 1 if any benchmark
+ * regressed by more than --threshold percent (default 5) beyond the noise.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "mongo/base/initializer.h"
+#include "mongo/db/json.h"
+#include "mongo/unittest/benchmark.h"
+#include "mongo/util/signal_handlers_synchronous.h"
+#include "mongo/util/time_support.h"
+
+namespace {
+
+    using namespace mongo;
+
+    int usage(const char* program) {
+        std::cerr << "usage: " << program << " [--filter <substring>] [--samples <n>]"
+                  << " [--minSampleMillis <ms>] [--warmupMillis <ms>] [--json <file>]"
+                  << " [--label <label>] [--baseline <file> [--threshold <percent>]] [--list]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+}  // namespace
+
+int main(int argc, char** argv, char** envp) {
+    ::mongo::setupSynchronousSignalHandlers();
+    ::mongo::runGlobalInitializersOrDie(argc, argv, envp);
+
+    benchmark::RunOptions options;
+    std::string jsonFile;
+    std::string baselineFile;
+    std::string label;
+    double thresholdPercent = 5;
+    bool list = false;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--list") {
+            list = true;
+            continue;
+        }
+        if (i + 1 == argc) {
+            return usage(argv[0]);
+        }
+        const char* value = argv[++i];
+        if (arg == "--filter") {
+            options.filter = value;
+        }
+        else if (arg == "--samples") {
+            options.samples = std::max(1, atoi(value));
+        }
+        else if (arg == "--minSampleMillis") {
+            options.minSampleMillis = atof(value);
+        }
+        else if (arg == "--warmupMillis") {
+            options.warmupMillis = atof(value);
+        }
+        else if (arg == "--json") {
+            jsonFile = value;
+        }
+        else if (arg == "--label") {
+            label = value;
+        }
+        else if (arg == "--baseline") {
+            baselineFile = value;
+        }
+        else if (arg == "--threshold") {
+            thresholdPercent = atof(value);
+        }
+        else {
+            return usage(argv[0]);
+        }
+    }
+
+    if (list) {
+        const std::vector<std::string> names = benchmark::listBenchmarks();
+        for (size_t i = 0; i < names.size(); i++) {
+            std::cout << names[i] << std::endl;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    // Read the baseline first, so that a bad file fails before the benchmarks have run.
+    BSONObj baseline;
+    if (!baselineFile.empty()) {
+        std::ifstream in(baselineFile.c_str());
+        if (!in) {
+            std::cerr << "cannot read baseline " << baselineFile << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::stringstream contents;
+        contents << in.rdbuf();
+        baseline = fromjson(contents.str());
+    }
+
+    const std::vector<benchmark::Result> results = benchmark::runBenchmarks(options, std::cout);
+
+    if (!jsonFile.empty()) {
+        BSONObjBuilder bob;
+        {
+            BSONObjBuilder context(bob.subobjStart("context"));
+            context.append("label", label);
+            context.append("date", dateToISOStringUTC(jsTime()));
+            context.append("filter", options.filter);
+            context.append("samples", options.samples);
+            context.append("minSampleMillis", options.minSampleMillis);
+            context.append("warmupMillis", options.warmupMillis);
+            context.done();
+        }
+        {
+            BSONArrayBuilder benchmarks(bob.subarrayStart("benchmarks"));
+            for (size_t i = 0; i < results.size(); i++) {
+                benchmarks.append(results[i].toBSON());
+            }
+            benchmarks.done();
+        }
+
+        std::ofstream out(jsonFile.c_str());
+        out << bob.obj().jsonString(Strict, 1) << std::endl;
+        if (!out) {
+            std::cerr << "cannot write " << jsonFile << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!baselineFile.empty()) {
+        std::cout << std::endl;
+        const size_t regressions =
+            benchmark::compareToBaseline(results, baseline, thresholdPercent, std::cout);
+        if (regressions > 0) {
+            std::cout << regressions << " regression(s) beyond " << thresholdPercent << "%"
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
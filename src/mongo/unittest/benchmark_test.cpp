@@ -0,0 +1,150 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/unittest/benchmark.h"
+
+#include <sstream>
+
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+    benchmark::Result makeResult(const char* name, double a, double b, double c) {
+        benchmark::Result result;
+        result.name = name;
+        result.arg = 0;
+        result.iterationsPerSample = 1;
+        result.nanosPerIteration.push_back(a);
+        result.nanosPerIteration.push_back(b);
+        result.nanosPerIteration.push_back(c);
+        result.computeStatistics();
+        return result;
+    }
+
+    BSONObj makeBaseline(const benchmark::Result& result) {
+        return BSON("benchmarks" << BSON_ARRAY(result.toBSON()));
+    }
+
+    TEST(BenchmarkResult, Statistics) {
+        const benchmark::Result result = makeResult("b", 30, 10, 20);
+        ASSERT_EQUALS(20, result.median);
+        ASSERT_EQUALS(20, result.mean);
+        ASSERT_EQUALS(10, result.min);
+        ASSERT_EQUALS(30, result.max);
+        ASSERT_EQUALS(10, result.stddev);
+        // t(2 degrees of freedom) * stddev / sqrt(3 samples)
+        ASSERT_APPROX_EQUAL(4.303 * 10 / std::sqrt(3.0), result.ci95, 1e-9);
+    }
+
+    TEST(BenchmarkResult, RoundTripsThroughBSON) {
+        benchmark::Result result = makeResult("b", 30, 10, 20);
+        result.arg = 7;
+        const benchmark::Result parsed = benchmark::Result::fromBSON(result.toBSON());
+        ASSERT_EQUALS("b/7", parsed.fullName());
+        ASSERT_EQUALS(result.median, parsed.median);
+        ASSERT_EQUALS(result.ci95, parsed.ci95);
+    }
+
+    TEST(BenchmarkResult, Throughput) {
+        benchmark::Result result;
+        result.itemsPerIteration = 4;
+        result.nanosPerIteration.push_back(2000);
+        result.computeStatistics();
+        ASSERT_EQUALS(2000000, result.itemsPerSecond);
+    }
+
+    TEST(BenchmarkResult, LatencyPercentiles) {
+        benchmark::Result result;
+        std::vector<long long> nanos;
+        for (long long i = 100; i >= 1; i--) {
+            nanos.push_back(i);
+        }
+        result.computeLatencies(&nanos);
+        ASSERT_EQUALS(100U, result.latencyCount);
+        ASSERT_EQUALS(51, result.latencyP50);
+        ASSERT_EQUALS(95, result.latencyP95);
+        ASSERT_EQUALS(99, result.latencyP99);
+        ASSERT_EQUALS(100, result.latencyMax);
+
+        const benchmark::Result parsed = benchmark::Result::fromBSON(result.toBSON());
+        ASSERT_EQUALS(100U, parsed.latencyCount);
+        ASSERT_EQUALS(result.latencyP99, parsed.latencyP99);
+    }
+
+    TEST(BenchmarkBaseline, ReportsRegression) {
+        std::vector<benchmark::Result> results;
+        results.push_back(makeResult("b", 200, 201, 202));
+
+        std::ostringstream out;
+        ASSERT_EQUALS(1U, benchmark::compareToBaseline(results,
+                                                      makeBaseline(makeResult("b", 100, 101, 102)),
+                                                      5,
+                                                      out));
+        ASSERT_NOT_EQUALS(std::string::npos, out.str().find("REGRESSION"));
+    }
+
+    TEST(BenchmarkBaseline, IgnoresNoise) {
+        // Twice as slow, but the samples are too spread out to tell.
+        std::vector<benchmark::Result> results;
+        results.push_back(makeResult("b", 10, 200, 400));
+
+        std::ostringstream out;
+        ASSERT_EQUALS(0U, benchmark::compareToBaseline(results,
+                                                      makeBaseline(makeResult("b", 10, 100, 200)),
+                                                      5,
+                                                      out));
+    }
+
+    TEST(BenchmarkBaseline, IgnoresChangesBelowThreshold) {
+        std::vector<benchmark::Result> results;
+        results.push_back(makeResult("b", 103, 103, 103));
+
+        std::ostringstream out;
+        ASSERT_EQUALS(0U, benchmark::compareToBaseline(results,
+                                                      makeBaseline(makeResult("b", 100, 100, 100)),
+                                                      5,
+                                                      out));
+    }
+
+    TEST(BenchmarkBaseline, ReportsImprovement) {
+        std::vector<benchmark::Result> results;
+        results.push_back(makeResult("b", 50, 51, 52));
+
+        std::ostringstream out;
+        ASSERT_EQUALS(0U, benchmark::compareToBaseline(results,
+                                                      makeBaseline(makeResult("b", 100, 101, 102)),
+                                                      5,
+                                                      out));
+        ASSERT_NOT_EQUALS(std::string::npos, out.str().find("improvement"));
+    }
+
+}  // namespace
+}  // namespace mongo
@@ -0,0 +1,80 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/coarse_clock.h"
+
+#include <boost/thread/once.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+    AtomicInt64 CoarseClock::_millis;
+    AtomicInt64 CoarseClock::_wallMillis;
+
+    namespace {
+        boost::once_flag startOnce = BOOST_ONCE_INIT;
+    } // namespace
+
+    void CoarseClock::start() {
+        boost::call_once(&CoarseClock::_startThread, startOnce);
+    }
+
+    void CoarseClock::_startThread() {
+        _wallMillis.store(curTimeMillis64());
+        boost::thread(&CoarseClock::_tick).detach();
+    }
+
+    long long CoarseClock::_wallMillisUntilStarted() {
+        start();
+        return curTimeMillis64();
+    }
+
+    void CoarseClock::_tick() {
+        setThreadName("coarseClock");
+
+        // Timer is monotonic, so the clock never goes backwards.
+        const Timer sinceStart;
+        while (true) {
+            sleepmillis(kTickMillis);
+            _millis.store(sinceStart.micros() / 1000);
+
+            // The system clock may be set back; the wall clock waits for it to catch up.
+            const long long wallNow = curTimeMillis64();
+            if (wallNow > _wallMillis.load()) {
+                _wallMillis.store(wallNow);
+            }
+        }
+    }
+
+} // namespace mongo
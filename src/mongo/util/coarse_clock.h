@@ -0,0 +1,77 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/compiler.h"
+
+namespace mongo {
+
+    /**
+     * A clock which is cheap to read and only as precise as its tick.
+     *
+     * A background thread moves the time forward every kTickMillis, so reading it is a plain
+     * load instead of a call into the system clock. It is meant for deciding when something
+     * more expensive, like reading the real time, is worth doing.
+     */
+    class CoarseClock {
+    public:
+        static const int kTickMillis = 2;
+
+        /**
+         * Starts the thread which moves the clock forward, if it isn't running yet. Calling it
+         * again is cheap. Don't call it before forking, as the thread doesn't survive a fork.
+         */
+        static void start();
+
+        /**
+         * @return milliseconds since start() was first called, or 0 if it never was
+         */
+        static long long millis() { return _millis.loadRelaxed(); }
+
+        /**
+         * @return the wall clock time as of the last tick, in milliseconds since the epoch.
+         * It never goes backwards. The first call starts the clock, and reads the system clock
+         * until it is running.
+         */
+        static long long wallMillis() {
+            const long long millis = _wallMillis.loadRelaxed();
+            return MONGO_likely(millis != 0) ? millis : _wallMillisUntilStarted();
+        }
+
+    private:
+        static void _startThread();
+        static void _tick();
+        static long long _wallMillisUntilStarted();
+
+        static AtomicInt64 _millis;
+        static AtomicInt64 _wallMillis;
+    };
+
+} // namespace mongo
@@ -0,0 +1,77 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/coarse_clock.h"
+#include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+namespace {
+
+    TEST(CoarseClockTest, MovesForward) {
+        CoarseClock::start();
+        CoarseClock::start();
+
+        const long long first = CoarseClock::millis();
+        Timer timer;
+        long long last = first;
+        while (timer.millis() < 100) {
+            const long long now = CoarseClock::millis();
+            ASSERT_GREATER_THAN_OR_EQUALS(now, last);
+            last = now;
+            sleepmillis(1);
+        }
+
+        // It keeps up with the real time, give or take a few ticks.
+        ASSERT_GREATER_THAN_OR_EQUALS(last - first, 50);
+        ASSERT_LESS_THAN_OR_EQUALS(last - first, timer.millis() + CoarseClock::kTickMillis);
+    }
+
+    TEST(CoarseClockTest, WallMillisFollowsSystemClock) {
+        const long long before = curTimeMillis64();
+        long long last = CoarseClock::wallMillis();
+        ASSERT_GREATER_THAN_OR_EQUALS(last, before - CoarseClock::kTickMillis);
+
+        Timer timer;
+        while (timer.millis() < 50) {
+            const long long now = CoarseClock::wallMillis();
+            ASSERT_GREATER_THAN_OR_EQUALS(now, last);
+            last = now;
+            sleepmillis(1);
+        }
+
+        // It lags the system clock by about a tick at most.
+        ASSERT_GREATER_THAN_OR_EQUALS(last, before + 25);
+        ASSERT_LESS_THAN_OR_EQUALS(last, curTimeMillis64());
+    }
+
+} // namespace
+} // namespace mongo
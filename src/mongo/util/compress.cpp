@@ -30,10 +30,39 @@
 
 #include "mongo/util/compress.h"
 
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
 #include "snappy.h"
 
+#include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/thread_pool.h"
+
 namespace mongo {
 
+    namespace {
+        // The block size snappy compresses independently (snappy::kBlockSize)
+        const size_t kSnappyBlockSize = 1 << 16;
+
+        size_t encodeVarint32(char* out, size_t value) {
+            size_t len = 0;
+            while (value >= 0x80) {
+                out[len++] = static_cast<char>((value & 0x7f) | 0x80);
+                value >>= 7;
+            }
+            out[len++] = static_cast<char>(value);
+            return len;
+        }
+
+        void compressChunk(const char* input,
+                           size_t length,
+                           std::vector<char>* output,
+                           size_t* outputLength) {
+            snappy::RawCompress(input, length, &(*output)[0], outputLength);
+        }
+    }
+
     void rawCompress(const char* input,
         size_t input_length,
         char* compressed,
@@ -42,6 +71,52 @@ namespace mongo {
         snappy::RawCompress(input, input_length, compressed, compressed_length);
     }
 
+    void rawCompressParallel(const char* input,
+        size_t input_length,
+        char* compressed,
+        size_t* compressed_length,
+        threadpool::ThreadPool* pool,
+        size_t chunk_size)
+    {
+        chunk_size = std::max(chunk_size, kSnappyBlockSize);
+        chunk_size = (chunk_size + kSnappyBlockSize - 1) / kSnappyBlockSize * kSnappyBlockSize;
+
+        const size_t numChunks = (input_length + chunk_size - 1) / chunk_size;
+        if (numChunks <= 1) {
+            rawCompress(input, input_length, compressed, compressed_length);
+            return;
+        }
+
+        // Every piece is compressed as a full snappy stream, whose length preamble is stripped
+        // when the pieces are joined behind the preamble for the whole input.  Buffers are sized
+        // here so that the tasks themselves cannot throw.
+        std::vector<std::vector<char> > outputs(numChunks);
+        std::vector<size_t> outputLengths(numChunks);
+        for (size_t i = 0; i < numChunks; i++) {
+            const size_t length = std::min(chunk_size, input_length - i * chunk_size);
+            outputs[i].resize(snappy::MaxCompressedLength(length));
+            pool->schedule(compressChunk,
+                           input + i * chunk_size,
+                           length,
+                           &outputs[i],
+                           &outputLengths[i]);
+        }
+        pool->join();
+
+        size_t written = encodeVarint32(compressed, input_length);
+        for (size_t i = 0; i < numChunks; i++) {
+            const size_t length = std::min(chunk_size, input_length - i * chunk_size);
+            char preamble[8];
+            const size_t preambleLength = encodeVarint32(preamble, length);
+            invariant(outputLengths[i] >= preambleLength);
+
+            const size_t bodyLength = outputLengths[i] - preambleLength;
+            memcpy(compressed + written, &outputs[i][preambleLength], bodyLength);
+            written += bodyLength;
+        }
+        *compressed_length = written;
+    }
+
     size_t maxCompressedLength(size_t source_len) {
         return snappy::MaxCompressedLength(source_len);
     }
@@ -34,6 +34,10 @@
 
 namespace mongo { 
 
+    namespace threadpool {
+        class ThreadPool;
+    }
+
     size_t compress(const char* input, size_t input_length, std::string* output);
 
     bool uncompress(const char* compressed, size_t compressed_length, std::string* uncompressed);
@@ -44,6 +48,22 @@ namespace mongo {
         char* compressed,
         size_t* compressed_length);
 
+    /**
+     * Produces exactly the same output as rawCompress(), but compresses the input in pieces of
+     * 'chunk_size' bytes in parallel on 'pool'.  'compressed' must have room for
+     * maxCompressedLength(input_length) bytes.
+     *
+     * Snappy compresses each 64KB block on its own, so pieces that start on block boundaries can
+     * be compressed separately and concatenated.  'chunk_size' is rounded up to a whole number
+     * of blocks.  'pool' must not be running other tasks, as this waits for it to go idle.
+     */
+    void rawCompressParallel(const char* input,
+        size_t input_length,
+        char* compressed,
+        size_t* compressed_length,
+        threadpool::ThreadPool* pool,
+        size_t chunk_size);
+
 }
 
 
@@ -40,6 +40,7 @@
 #include "mongo/bson/inline_decls.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/heapcheck.h"
+#include "mongo/util/concurrency/mutex_contention.h"
 #include "mongo/util/concurrency/threadlocal.h"
 #include "mongo/util/time_support.h"
 
@@ -85,7 +86,9 @@ namespace mongo {
         const char * const _name;
         // NOINLINE so that 'mutex::mutex' is always in the frame, this makes
         // it easier for us to suppress the leaks caused by the static observer.
-        NOINLINE_DECL mutex(const char *name) : _name(name)
+        NOINLINE_DECL mutex(const char *name)
+            : _name(name),
+              _contention(MutexContentionStats::get(name))
         {
             _m = new boost::timed_mutex();
             IGNORE_OBJECT( _m  );   // Turn-off heap checking on _m
@@ -112,7 +115,13 @@ namespace mongo {
         class scoped_lock : boost::noncopyable {
         public:
             scoped_lock( mongo::mutex &m ) : 
-            _l( m.boost() ) {
+            _l( m.boost(), boost::defer_lock ) {
+                if (MONGO_unlikely(MutexContentionStats::enabled())) {
+                    m._lockProfiled(_l);
+                }
+                else {
+                    _l.lock();
+                }
             }
             ~scoped_lock() {
             }
@@ -121,8 +130,19 @@ namespace mongo {
             boost::timed_mutex::scoped_lock _l;
         };
     private:
+        NOINLINE_DECL void _lockProfiled(boost::timed_mutex::scoped_lock& l) {
+            if (l.try_lock()) {
+                _contention->recordAcquisition();
+                return;
+            }
+            const unsigned long long start = curTimeMicros64();
+            l.lock();
+            _contention->recordContended(curTimeMicros64() - start, MONGO_CALLER_ADDRESS());
+        }
+
         boost::timed_mutex &boost() { return *_m; }
         boost::timed_mutex *_m;
+        MutexContentionStats* const _contention;
     };
 
     typedef mongo::mutex::scoped_lock scoped_lock;
@@ -135,9 +155,17 @@ namespace mongo {
 #if defined(_WIN32)
     class SimpleMutex : boost::noncopyable {
     public:
-        SimpleMutex( const StringData& ) { InitializeCriticalSection( &_cs ); }
+        SimpleMutex( const StringData& name ) : _contention(MutexContentionStats::get(name)) {
+            InitializeCriticalSection( &_cs );
+        }
         void dassertLocked() const { }
-        void lock() { EnterCriticalSection( &_cs ); }
+        void lock() {
+            if (MONGO_unlikely(MutexContentionStats::enabled())) {
+                _lockProfiled();
+                return;
+            }
+            EnterCriticalSection( &_cs );
+        }
         void unlock() { LeaveCriticalSection( &_cs ); }
         class scoped_lock {
             SimpleMutex& _m;
@@ -148,20 +176,39 @@ namespace mongo {
         };
 
     private:
+        NOINLINE_DECL void _lockProfiled() {
+            if (TryEnterCriticalSection(&_cs)) {
+                _contention->recordAcquisition();
+                return;
+            }
+            const unsigned long long start = curTimeMicros64();
+            EnterCriticalSection(&_cs);
+            _contention->recordContended(curTimeMicros64() - start, MONGO_CALLER_ADDRESS());
+        }
+
         CRITICAL_SECTION _cs;
+        MutexContentionStats* const _contention;
     };
 #else
     class SimpleMutex : boost::noncopyable {
     public:
         void dassertLocked() const { }
-        SimpleMutex(const StringData& name) { verify( pthread_mutex_init(&_lock,0) == 0 ); }
+        SimpleMutex(const StringData& name) : _contention(MutexContentionStats::get(name)) {
+            verify( pthread_mutex_init(&_lock,0) == 0 );
+        }
         ~SimpleMutex(){ 
             if ( ! StaticObserver::_destroyingStatics ) { 
                 verify( pthread_mutex_destroy(&_lock) == 0 ); 
             }
         }
 
-        void lock() { verify( pthread_mutex_lock(&_lock) == 0 ); }
+        void lock() {
+            if (MONGO_unlikely(MutexContentionStats::enabled())) {
+                _lockProfiled();
+                return;
+            }
+            verify( pthread_mutex_lock(&_lock) == 0 );
+        }
         void unlock() { verify( pthread_mutex_unlock(&_lock) == 0 ); }
     public:
         class scoped_lock : boost::noncopyable {
@@ -173,7 +220,18 @@ namespace mongo {
         };
 
     private:
+        NOINLINE_DECL void _lockProfiled() {
+            if (pthread_mutex_trylock(&_lock) == 0) {
+                _contention->recordAcquisition();
+                return;
+            }
+            const unsigned long long start = curTimeMicros64();
+            verify( pthread_mutex_lock(&_lock) == 0 );
+            _contention->recordContended(curTimeMicros64() - start, MONGO_CALLER_ADDRESS());
+        }
+
         pthread_mutex_t _lock;
+        MutexContentionStats* const _contention;
     };
 #endif
 
@@ -0,0 +1,220 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/concurrency/mutex_contention.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/util/hex.h"
+#include "mongo/util/stacktrace.h"
+
+namespace mongo {
+
+    namespace {
+
+        typedef std::map<std::string, MutexContentionStats*> Registry;
+
+        // Mutexes are constructed during static initialization, so the registry is built on
+        // first use, and it is never destroyed because they may be used until exit.
+        boost::mutex& registryMutex() {
+            static boost::mutex* mutex = new boost::mutex();
+            return *mutex;
+        }
+
+        Registry& registry() {
+            static Registry* registry = new Registry();
+            return *registry;
+        }
+
+        int bucketOf(long long micros) {
+            int bucket = 0;
+            while (micros > 0 && bucket < MutexContentionStats::kNumBuckets - 1) {
+                micros >>= 1;
+                bucket++;
+            }
+            return bucket;
+        }
+
+        long long lowerBoundMicrosOf(int bucket) {
+            return bucket == 0 ? 0 : 1LL << (bucket - 1);
+        }
+
+        bool byWaitMicrosDescending(const MutexContentionStats* lhs,
+                                    const MutexContentionStats* rhs) {
+            if (lhs->waitMicros() != rhs->waitMicros()) {
+                return lhs->waitMicros() > rhs->waitMicros();
+            }
+            if (lhs->contended() != rhs->contended()) {
+                return lhs->contended() > rhs->contended();
+            }
+            return lhs->name() < rhs->name();
+        }
+
+        typedef std::pair<long long, std::pair<long long, void*> > SortableCallSite;
+
+        std::string callSiteName(void* address) {
+            if (!address) {
+                return "other";
+            }
+#if defined(_WIN32)
+            return integerToHex(reinterpret_cast<uintptr_t>(address));
+#else
+            return getSymbolName(address);
+#endif
+        }
+
+    }  // namespace
+
+    const size_t MutexContentionStats::kMaxCallSites;
+    AtomicUInt32 MutexContentionStats::_enabled;
+
+    MutexContentionStats::MutexContentionStats(const std::string& name) : _name(name) { }
+
+    void MutexContentionStats::setEnabled(bool enabled) {
+        _enabled.store(enabled ? 1 : 0);
+    }
+
+    MutexContentionStats* MutexContentionStats::get(const StringData& name) {
+        boost::mutex::scoped_lock lk(registryMutex());
+        MutexContentionStats*& stats = registry()[name.toString()];
+        if (!stats) {
+            stats = new MutexContentionStats(name.toString());
+        }
+        return stats;
+    }
+
+    void MutexContentionStats::appendTop(size_t limit,
+                                         size_t callSitesLimit,
+                                         BSONArrayBuilder* out) {
+        std::vector<MutexContentionStats*> all;
+        {
+            boost::mutex::scoped_lock lk(registryMutex());
+            for (Registry::const_iterator it = registry().begin(); it != registry().end(); ++it) {
+                if (it->second->acquisitions() > 0 || it->second->contended() > 0) {
+                    all.push_back(it->second);
+                }
+            }
+        }
+
+        std::sort(all.begin(), all.end(), byWaitMicrosDescending);
+        for (size_t i = 0; i < all.size() && (limit == 0 || i < limit); i++) {
+            BSONObjBuilder builder(out->subobjStart());
+            all[i]->append(callSitesLimit, &builder);
+        }
+    }
+
+    void MutexContentionStats::resetAll() {
+        boost::mutex::scoped_lock lk(registryMutex());
+        for (Registry::const_iterator it = registry().begin(); it != registry().end(); ++it) {
+            it->second->reset();
+        }
+    }
+
+    void MutexContentionStats::recordContended(long long waitMicros, void* callSite) {
+        _acquisitions.increment();
+        _contended.fetchAndAdd(1);
+        _waitMicros.fetchAndAdd(waitMicros);
+        _waitHistogram[bucketOf(waitMicros)].fetchAndAdd(1);
+
+        long long max = _maxWaitMicros.load();
+        while (waitMicros > max) {
+            const long long seen = _maxWaitMicros.compareAndSwap(max, waitMicros);
+            if (seen == max) {
+                break;
+            }
+            max = seen;
+        }
+
+        boost::mutex::scoped_lock lk(_callSitesMutex);
+        CallSiteMap::iterator it = _callSites.find(callSite);
+        if (it == _callSites.end()) {
+            if (_callSites.size() >= kMaxCallSites) {
+                callSite = NULL;
+            }
+            it = _callSites.insert(std::make_pair(callSite, CallSite())).first;
+        }
+        it->second.contended++;
+        it->second.waitMicros += waitMicros;
+    }
+
+    void MutexContentionStats::append(size_t callSitesLimit, BSONObjBuilder* builder) const {
+        builder->append("name", _name);
+        builder->appendNumber("acquisitions", acquisitions());
+        builder->appendNumber("contended", contended());
+        builder->appendNumber("waitMicros", waitMicros());
+        builder->appendNumber("maxWaitMicros", _maxWaitMicros.load());
+
+        BSONArrayBuilder histogramBuilder(builder->subarrayStart("waitHistogram"));
+        for (int i = 0; i < kNumBuckets; i++) {
+            const long long count = _waitHistogram[i].load();
+            if (count > 0) {
+                histogramBuilder.append(BSON("lowerBoundMicros" << lowerBoundMicrosOf(i)
+                                          << "count" << count));
+            }
+        }
+        histogramBuilder.doneFast();
+
+        std::vector<SortableCallSite> sites;
+        {
+            boost::mutex::scoped_lock lk(_callSitesMutex);
+            for (CallSiteMap::const_iterator it = _callSites.begin();
+                 it != _callSites.end();
+                 ++it) {
+                sites.push_back(std::make_pair(it->second.waitMicros,
+                                               std::make_pair(it->second.contended,
+                                                              it->first)));
+            }
+        }
+        std::sort(sites.rbegin(), sites.rend());
+
+        BSONArrayBuilder sitesBuilder(builder->subarrayStart("callSites"));
+        for (size_t i = 0; i < sites.size() && (callSitesLimit == 0 || i < callSitesLimit); i++) {
+            sitesBuilder.append(BSON("site" << callSiteName(sites[i].second.second)
+                                  << "contended" << sites[i].second.first
+                                  << "waitMicros" << sites[i].first));
+        }
+        sitesBuilder.doneFast();
+    }
+
+    void MutexContentionStats::reset() {
+        _acquisitions.reset();
+        _contended.store(0);
+        _waitMicros.store(0);
+        _maxWaitMicros.store(0);
+        for (int i = 0; i < kNumBuckets; i++) {
+            _waitHistogram[i].store(0);
+        }
+        boost::mutex::scoped_lock lk(_callSitesMutex);
+        _callSites.clear();
+    }
+
+}  // namespace mongo
@@ -0,0 +1,122 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/thread/mutex.hpp>
+#include <map>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/sharded_counter.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define MONGO_CALLER_ADDRESS() _ReturnAddress()
+#else
+#define MONGO_CALLER_ADDRESS() __builtin_return_address(0)
+#endif
+
+namespace mongo {
+
+    class BSONArrayBuilder;
+    class BSONObjBuilder;
+
+    /**
+     * Contention statistics for the mutexes of mutex.h and spin_lock.h, shared by every mutex
+     * with the same name.
+     *
+     * Profiling is off by default, when locking costs one extra relaxed load.  While it is on,
+     * each lock first tries to acquire without blocking.  Acquisitions are counted per thread
+     * cell, so that counting doesn't itself contend.  A failed try is counted as contended, and
+     * the time it waits is added to a log2 histogram and charged to the call site, which is the
+     * return address into the function that locked.
+     */
+    class MutexContentionStats {
+        MONGO_DISALLOW_COPYING(MutexContentionStats);
+    public:
+        enum { kNumBuckets = 24 };
+
+        // Call sites beyond this many per name are charged to a single "other" site.
+        static const size_t kMaxCallSites = 256;
+
+        static bool enabled() { return _enabled.loadRelaxed(); }
+        static void setEnabled(bool enabled);
+
+        /**
+         * Returns the statistics for mutexes named "name", creating them if needed.  Never
+         * returns NULL, and the result lives until shutdown.
+         */
+        static MutexContentionStats* get(const StringData& name);
+
+        /**
+         * Appends the "limit" names that waited longest, or all with 0, each with their
+         * "callSitesLimit" call sites that waited longest.
+         */
+        static void appendTop(size_t limit, size_t callSitesLimit, BSONArrayBuilder* out);
+
+        static void resetAll();
+
+        void recordAcquisition() { _acquisitions.increment(); }
+        void recordContended(long long waitMicros, void* callSite);
+
+        const std::string& name() const { return _name; }
+        long long acquisitions() const { return _acquisitions.load(); }
+        long long contended() const { return _contended.load(); }
+        long long waitMicros() const { return _waitMicros.load(); }
+
+        void append(size_t callSitesLimit, BSONObjBuilder* builder) const;
+        void reset();
+
+    private:
+        explicit MutexContentionStats(const std::string& name);
+
+        struct CallSite {
+            CallSite() : contended(0), waitMicros(0) { }
+            long long contended;
+            long long waitMicros;
+        };
+        typedef std::map<void*, CallSite> CallSiteMap;
+
+        static AtomicUInt32 _enabled;
+
+        const std::string _name;
+        ShardedCounter _acquisitions;
+        AtomicInt64 _contended;
+        AtomicInt64 _waitMicros;
+        AtomicInt64 _maxWaitMicros;
+        AtomicInt64 _waitHistogram[kNumBuckets];
+
+        // Only taken on the contended path.
+        mutable boost::mutex _callSitesMutex;
+        CallSiteMap _callSites;
+    };
+
+}  // namespace mongo
@@ -0,0 +1,166 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <boost/thread/thread.hpp>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/concurrency/mutex_contention.h"
+#include "mongo/util/concurrency/spin_lock.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+namespace {
+
+    class ProfilingEnabled {
+    public:
+        ProfilingEnabled() {
+            MutexContentionStats::resetAll();
+            MutexContentionStats::setEnabled(true);
+        }
+        ~ProfilingEnabled() {
+            MutexContentionStats::setEnabled(false);
+        }
+    };
+
+    template <typename Mutex>
+    void lockAndSleep(Mutex* m, int millis) {
+        typename Mutex::scoped_lock lk(*m);
+        sleepmillis(millis);
+    }
+
+    void lockSpinLockAndSleep(SpinLock* lock, int millis) {
+        scoped_spinlock lk(*lock);
+        sleepmillis(millis);
+    }
+
+    /**
+     * Locks "m" in "lockFn" on another thread, waits for it to be held, and then locks it
+     * here, having to wait.
+     */
+    template <typename Mutex, typename LockFn>
+    void contend(Mutex* m, LockFn lockFn) {
+        boost::thread holder(stdx::bind(lockFn, m, 100));
+        sleepmillis(20);
+        lockFn(m, 0);
+        holder.join();
+    }
+
+    TEST(MutexContention, CountsNothingWhenDisabled) {
+        MutexContentionStats::setEnabled(false);
+        SimpleMutex m("MutexContentionTest.disabled");
+        MutexContentionStats* stats = MutexContentionStats::get("MutexContentionTest.disabled");
+        stats->reset();
+
+        contend(&m, lockAndSleep<SimpleMutex>);
+        ASSERT_EQUALS(0, stats->acquisitions());
+        ASSERT_EQUALS(0, stats->contended());
+    }
+
+    TEST(MutexContention, SimpleMutex) {
+        ProfilingEnabled enabled;
+        SimpleMutex m("MutexContentionTest.simple");
+        MutexContentionStats* stats = MutexContentionStats::get("MutexContentionTest.simple");
+
+        lockAndSleep(&m, 0);
+        ASSERT_EQUALS(1, stats->acquisitions());
+        ASSERT_EQUALS(0, stats->contended());
+
+        contend(&m, lockAndSleep<SimpleMutex>);
+        ASSERT_EQUALS(3, stats->acquisitions());
+        ASSERT_EQUALS(1, stats->contended());
+        ASSERT_GREATER_THAN(stats->waitMicros(), 10 * 1000);
+    }
+
+    TEST(MutexContention, MongoMutex) {
+        ProfilingEnabled enabled;
+        mongo::mutex m("MutexContentionTest.mutex");
+        MutexContentionStats* stats = MutexContentionStats::get("MutexContentionTest.mutex");
+
+        contend(&m, lockAndSleep<mongo::mutex>);
+        ASSERT_EQUALS(2, stats->acquisitions());
+        ASSERT_EQUALS(1, stats->contended());
+        ASSERT_GREATER_THAN(stats->waitMicros(), 10 * 1000);
+    }
+
+    TEST(MutexContention, SpinLock) {
+        ProfilingEnabled enabled;
+        SpinLock lock("MutexContentionTest.spin");
+        MutexContentionStats* stats = MutexContentionStats::get("MutexContentionTest.spin");
+
+        contend(&lock, lockSpinLockAndSleep);
+        ASSERT_EQUALS(2, stats->acquisitions());
+        ASSERT_EQUALS(1, stats->contended());
+        ASSERT_GREATER_THAN(stats->waitMicros(), 10 * 1000);
+    }
+
+    TEST(MutexContention, SameNameSharesStats) {
+        ProfilingEnabled enabled;
+        SimpleMutex first("MutexContentionTest.shared");
+        SimpleMutex second("MutexContentionTest.shared");
+
+        lockAndSleep(&first, 0);
+        lockAndSleep(&second, 0);
+        ASSERT_EQUALS(2, MutexContentionStats::get("MutexContentionTest.shared")->acquisitions());
+    }
+
+    TEST(MutexContention, Report) {
+        ProfilingEnabled enabled;
+        SimpleMutex m("MutexContentionTest.report");
+        contend(&m, lockAndSleep<SimpleMutex>);
+
+        BSONArrayBuilder arrayBuilder;
+        MutexContentionStats::appendTop(1, 5, &arrayBuilder);
+        const BSONArray top = arrayBuilder.arr();
+        ASSERT_EQUALS(1, top.nFields());
+
+        const BSONObj report = top["0"].Obj();
+        ASSERT_EQUALS("MutexContentionTest.report", report["name"].str());
+        ASSERT_EQUALS(2, report["acquisitions"].numberLong());
+        ASSERT_EQUALS(1, report["contended"].numberLong());
+        ASSERT_GREATER_THAN_OR_EQUALS(report["maxWaitMicros"].numberLong(), 10 * 1000);
+
+        std::vector<BSONElement> histogram = report["waitHistogram"].Array();
+        ASSERT_EQUALS(1U, histogram.size());
+        ASSERT_EQUALS(1, histogram[0]["count"].numberLong());
+
+        std::vector<BSONElement> callSites = report["callSites"].Array();
+        ASSERT_EQUALS(1U, callSites.size());
+        ASSERT_EQUALS(1, callSites[0]["contended"].numberLong());
+        ASSERT_FALSE(callSites[0]["site"].str().empty());
+
+        MutexContentionStats::resetAll();
+        ASSERT_EQUALS(0, MutexContentionStats::get("MutexContentionTest.report")->contended());
+    }
+
+}  // namespace
+}  // namespace mongo
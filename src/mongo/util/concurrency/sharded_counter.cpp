@@ -0,0 +1,64 @@
+/*    Copyright 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/concurrency/sharded_counter.h"
+
+#include "mongo/util/concurrency/threadlocal.h"
+
+namespace mongo {
+
+    namespace {
+        AtomicUInt32 nextCell;
+
+        // One more than the calling thread's cell, so that 0 means not yet assigned
+#if defined(MONGO_HAVE___THREAD)
+        __thread unsigned myCellPlusOne = 0;
+#elif defined(MONGO_HAVE___DECLSPEC_THREAD)
+        __declspec( thread ) unsigned myCellPlusOne = 0;
+#else
+        ThreadLocalValue<unsigned> myCellPlusOneValue;
+#endif
+    }
+
+    size_t ShardedCounter::currentThreadCell() {
+#if defined(MONGO_HAVE___THREAD) || defined(MONGO_HAVE___DECLSPEC_THREAD)
+        if (myCellPlusOne == 0) {
+            myCellPlusOne = (nextCell.fetchAndAdd(1) % kNumCells) + 1;
+        }
+        return myCellPlusOne - 1;
+#else
+        unsigned& myCellPlusOne = myCellPlusOneValue.getRef();
+        if (myCellPlusOne == 0) {
+            myCellPlusOne = (nextCell.fetchAndAdd(1) % kNumCells) + 1;
+        }
+        return myCellPlusOne - 1;
+#endif
+    }
+
+}  // namespace mongo
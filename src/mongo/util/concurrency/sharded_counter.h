@@ -0,0 +1,96 @@
+/*    Copyright 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+    /**
+     * A counter for statistics which many threads bump and few threads read, such as the
+     * serverStatus opcounters.
+     *
+     * Each thread adds to one of several cells, each on its own cache line, so concurrent
+     * writers rarely touch the same line.  load() sums the cells: it is slower than an atomic
+     * load and, like any unsynchronized read of concurrently updated counters, is not a
+     * snapshot.
+     */
+    class ShardedCounter {
+        MONGO_DISALLOW_COPYING(ShardedCounter);
+    public:
+        enum { kNumCells = 32 };
+
+        ShardedCounter() { }
+
+        void add(long long n) {
+            _cells[currentThreadCell()].value.fetchAndAdd(n);
+        }
+
+        void increment() { add(1); }
+
+        long long load() const {
+            long long total = 0;
+            for (int i = 0; i < kNumCells; i++) {
+                total += _cells[i].value.loadRelaxed();
+            }
+            return total;
+        }
+
+        void reset() {
+            for (int i = 0; i < kNumCells; i++) {
+                _cells[i].value.store(0);
+            }
+        }
+
+        /**
+         * Sets the total to 'n'.  Not atomic with respect to concurrent add()s, any of which may
+         * be lost.
+         */
+        void store(long long n) {
+            reset();
+            _cells[0].value.store(n);
+        }
+
+        /**
+         * The cell, in [0, kNumCells), that the calling thread writes to.  Threads are handed
+         * cells round-robin the first time they ask.  Also useful to stripe other per-thread
+         * state the same way.
+         */
+        static size_t currentThreadCell();
+
+    private:
+        struct Cell {
+            AtomicInt64 value;
+            char pad[64 - sizeof(AtomicInt64)];
+        };
+
+        Cell _cells[kNumCells];
+    };
+
+}  // namespace mongo
@@ -0,0 +1,81 @@
+/*    Copyright 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <boost/thread/thread.hpp>
+
+#include "mongo/stdx/functional.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/concurrency/sharded_counter.h"
+
+namespace mongo {
+namespace {
+
+    TEST(ShardedCounter, AddAndReset) {
+        ShardedCounter counter;
+        ASSERT_EQUALS(0, counter.load());
+
+        counter.increment();
+        counter.add(41);
+        ASSERT_EQUALS(42, counter.load());
+
+        counter.add(-2);
+        ASSERT_EQUALS(40, counter.load());
+
+        counter.reset();
+        ASSERT_EQUALS(0, counter.load());
+    }
+
+    TEST(ShardedCounter, CellIsStablePerThread) {
+        const size_t cell = ShardedCounter::currentThreadCell();
+        ASSERT_LESS_THAN(cell, static_cast<size_t>(ShardedCounter::kNumCells));
+        ASSERT_EQUALS(cell, ShardedCounter::currentThreadCell());
+    }
+
+    void addMany(ShardedCounter* counter, int n) {
+        for (int i = 0; i < n; i++) {
+            counter->increment();
+        }
+    }
+
+    TEST(ShardedCounter, ConcurrentAddsAreAllCounted) {
+        ShardedCounter counter;
+        const int numThreads = 8;
+        const int addsPerThread = 10000;
+
+        boost::thread_group threads;
+        for (int i = 0; i < numThreads; i++) {
+            threads.create_thread(stdx::bind(addMany, &counter, addsPerThread));
+        }
+        threads.join_all();
+
+        ASSERT_EQUALS(numThreads * addsPerThread, counter.load());
+    }
+
+}  // namespace
+}  // namespace mongo
@@ -45,19 +45,56 @@ namespace mongo {
 #endif
     }
 
+namespace {
+
+    // Looked up once, since unnamed spin locks are constructed often, e.g. one per Locker.
+    MutexContentionStats* unnamedContentionStats() {
+        static MutexContentionStats* const stats = MutexContentionStats::get("SpinLock");
+        return stats;
+    }
+
+}  // namespace
+
     SpinLock::SpinLock()
 #if defined(_WIN32)
+        : _contention(unnamedContentionStats())
     { InitializeCriticalSectionAndSpinCount(&_cs, 4000); }
 #elif defined(__USE_XOPEN2K)
+        : _contention(unnamedContentionStats())
     { pthread_spin_init( &_lock , 0 ); }
 #elif defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
-    : _locked( false ) { }
+    : _locked( false ), _contention(unnamedContentionStats()) { }
 #else
     : _mutex( "SpinLock" ) { }
 #endif
 
-#if defined(__USE_XOPEN2K)
-    NOINLINE_DECL void SpinLock::_lk() {
+    SpinLock::SpinLock(const StringData& name)
+#if defined(_WIN32)
+        : _contention(MutexContentionStats::get(name))
+    { InitializeCriticalSectionAndSpinCount(&_cs, 4000); }
+#elif defined(__USE_XOPEN2K)
+        : _contention(MutexContentionStats::get(name))
+    { pthread_spin_init( &_lock , 0 ); }
+#elif defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+    : _locked( false ), _contention(MutexContentionStats::get(name)) { }
+#else
+    : _mutex( name ) { }
+#endif
+
+#if defined(_WIN32)
+    NOINLINE_DECL void SpinLock::_lockProfiled() {
+        if (TryEnterCriticalSection(&_cs)) {
+            _contention->recordAcquisition();
+            return;
+        }
+        const unsigned long long start = curTimeMicros64();
+        EnterCriticalSection(&_cs);
+        _contention->recordContended(curTimeMicros64() - start, MONGO_CALLER_ADDRESS());
+    }
+#elif defined(__USE_XOPEN2K)
+namespace {
+
+    void spinUntilLocked(pthread_spinlock_t* lock) {
         /**
          * this is designed to perform close to the default spin lock
          * the reason for the mild insanity is to prevent horrible performance
@@ -67,7 +104,7 @@ namespace mongo {
          */
         
         for ( int i=0; i<1000; i++ ) {            
-            if ( pthread_spin_trylock( &_lock ) == 0 )
+            if ( pthread_spin_trylock( lock ) == 0 )
                 return;
 #if defined(__i386__) || defined(__x86_64__)
             asm volatile ( "pause" ) ; // maybe trylock does this; just in case.
@@ -75,7 +112,7 @@ namespace mongo {
         }
 
         for ( int i=0; i<1000; i++ ) {
-            if ( pthread_spin_trylock( &_lock ) == 0 )
+            if ( pthread_spin_trylock( lock ) == 0 )
                 return;
             pthread_yield();
         }
@@ -84,18 +121,36 @@ namespace mongo {
         t.tv_sec = 0;
         t.tv_nsec = 5000000;
 
-        while ( pthread_spin_trylock( &_lock ) != 0 ) {
+        while ( pthread_spin_trylock( lock ) != 0 ) {
             nanosleep(&t, NULL);
         }
     }
+
+}  // namespace
+
+    NOINLINE_DECL void SpinLock::_lk() {
+        if (MONGO_likely(!MutexContentionStats::enabled())) {
+            spinUntilLocked(&_lock);
+            return;
+        }
+        const unsigned long long start = curTimeMicros64();
+        spinUntilLocked(&_lock);
+        _contention->recordContended(curTimeMicros64() - start, MONGO_CALLER_ADDRESS());
+    }
 #elif defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
     void SpinLock::lock() {
 
         // fast path
         if (!_locked && !__sync_lock_test_and_set(&_locked, true)) {
+            if (MONGO_unlikely(MutexContentionStats::enabled())) {
+                _contention->recordAcquisition();
+            }
             return;
         }
 
+        const bool profiling = MutexContentionStats::enabled();
+        const unsigned long long start = profiling ? curTimeMicros64() : 0;
+
         // wait for lock
         int wait = 1000;
         while ((wait-- > 0) && (_locked)) {
@@ -111,6 +166,10 @@ namespace mongo {
         while (__sync_lock_test_and_set(&_locked, true)) {
             nanosleep(&t, NULL);
         }
+
+        if (profiling) {
+            _contention->recordContended(curTimeMicros64() - start, MONGO_CALLER_ADDRESS());
+        }
     }
 #endif
 
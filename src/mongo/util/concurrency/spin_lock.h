@@ -41,10 +41,13 @@ namespace mongo {
     /**
      * The spinlock currently requires late GCC support routines to be efficient.
      * Other platforms default to a mutex implemenation.
+     *
+     * Spin locks constructed without a name share their contention statistics under "SpinLock".
      */
     class SpinLock : boost::noncopyable {
     public:
         SpinLock();
+        explicit SpinLock(const StringData& name);
         ~SpinLock();
 
         static bool isfast(); // true if a real spinlock on this platform
@@ -52,21 +55,35 @@ namespace mongo {
     private:
 #if defined(_WIN32)
         CRITICAL_SECTION _cs;
+        MutexContentionStats* _contention;
+        void _lockProfiled();
     public:
-        void lock() {EnterCriticalSection(&_cs); }
+        void lock() {
+            if (MONGO_unlikely(MutexContentionStats::enabled())) {
+                _lockProfiled();
+                return;
+            }
+            EnterCriticalSection(&_cs);
+        }
         void unlock() { LeaveCriticalSection(&_cs); }
 #elif defined(__USE_XOPEN2K)
         pthread_spinlock_t _lock;
+        MutexContentionStats* _contention;
         void _lk();
     public:
         void unlock() { pthread_spin_unlock(&_lock); }
         void lock() {
-            if ( MONGO_likely( pthread_spin_trylock( &_lock ) == 0 ) )
+            if ( MONGO_likely( pthread_spin_trylock( &_lock ) == 0 ) ) {
+                if (MONGO_unlikely(MutexContentionStats::enabled())) {
+                    _contention->recordAcquisition();
+                }
                 return;
+            }
             _lk(); 
         }
 #elif defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
         volatile bool _locked;
+        MutexContentionStats* _contention;
     public:
         void unlock() {__sync_lock_release(&_locked); }
         void lock();
@@ -34,49 +34,94 @@
 
 #include "mongo/util/concurrency/thread_pool.h"
 
+#include <deque>
+
+#include <boost/scoped_ptr.hpp>
 #include <boost/thread/thread.hpp>
 
-#include "mongo/util/concurrency/mvar.h"
+#include "mongo/util/concurrency/threadlocal.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
     namespace threadpool {
 
-        // Worker thread
+        namespace {
+            // The worker whose thread this is, if any, so that tasks it schedules stay local.
+#if defined(MONGO_HAVE___THREAD)
+            __thread Worker* currentWorker = NULL;
+            Worker* getCurrentWorker() { return currentWorker; }
+            void setCurrentWorker(Worker* worker) { currentWorker = worker; }
+#elif defined(MONGO_HAVE___DECLSPEC_THREAD)
+            __declspec( thread ) Worker* currentWorker = NULL;
+            Worker* getCurrentWorker() { return currentWorker; }
+            void setCurrentWorker(Worker* worker) { currentWorker = worker; }
+#else
+            ThreadLocalValue<Worker*> currentWorkerValue(NULL);
+            Worker* getCurrentWorker() { return currentWorkerValue.get(); }
+            void setCurrentWorker(Worker* worker) { currentWorkerValue.set(worker); }
+#endif
+        }
+
+        // Worker thread and its queue
         class Worker : boost::noncopyable {
         public:
-            explicit Worker(ThreadPool& owner, const std::string& threadName)
+            Worker(ThreadPool& owner, size_t index)
                 : _owner(owner)
-                , _is_done(true)
-                , _thread(stdx::bind(&Worker::loop, this, threadName))
+                , _index(index)
             {}
 
-            // destructor will block until current operation is completed
-            // Acts as a "join" on this thread
-            ~Worker() {
-                _task.put(Task());
-                _thread.join();
+            // Waits for the thread to end; the pool must be shutting down
+            void join() {
+                if (_thread)
+                    _thread->join();
+            }
+
+            void start(const std::string& threadName) {
+                _thread.reset(new boost::thread(stdx::bind(&Worker::loop, this, threadName)));
+            }
+
+            ThreadPool& owner() const { return _owner; }
+            size_t index() const { return _index; }
+
+            void push(const Task& task) {
+                boost::lock_guard<boost::mutex> lk(_queueMutex);
+                _queue.push_back(task);
             }
 
-            void set_task(Task& func) {
-                verify(func);
-                verify(_is_done);
-                _is_done = false;
+            // The owning worker takes tasks in the order they were queued...
+            bool pop(Task* task) {
+                boost::lock_guard<boost::mutex> lk(_queueMutex);
+                if (_queue.empty())
+                    return false;
+                task->swap(_queue.front());
+                _queue.pop_front();
+                return true;
+            }
 
-                _task.put(func);
+            // ...and other workers from the other end, so they rarely want the same task.
+            bool steal(Task* task) {
+                boost::lock_guard<boost::mutex> lk(_queueMutex);
+                if (_queue.empty())
+                    return false;
+                task->swap(_queue.back());
+                _queue.pop_back();
+                return true;
             }
 
         private:
             ThreadPool& _owner;
-            MVar<Task> _task;
-            bool _is_done; // only used for error detection
-            boost::thread _thread;
+            const size_t _index; // in the owner's workers
+            boost::mutex _queueMutex;
+            std::deque<Task> _queue;
+            boost::scoped_ptr<boost::thread> _thread;
 
             void loop(const std::string& threadName) {
                 setThreadName(threadName);
+                setCurrentWorker(this);
                 while (true) {
-                    Task task = _task.take();
+                    Task task = _owner.nextTask(this);
                     if (!task)
                         break; // ends the thread
 
@@ -92,91 +137,175 @@ namespace mongo {
                     catch (...) {
                         log() << "Unhandled non-exception in worker thread" << endl;
                     }
-                    _is_done = true;
-                    _owner.task_done(this);
+                    _owner.task_done();
                 }
+                setCurrentWorker(NULL);
             }
         };
 
+        ThreadPool::Stats::Stats()
+            : queued(0), scheduled(0), stolen(0) {
+        }
+
         ThreadPool::ThreadPool(int nThreads, const std::string& threadNamePrefix)
-            : _mutex("ThreadPool"), _tasksRemaining(0)
-            , _nThreads(nThreads)
+            : _mutex("ThreadPool"), _shutdown(false)
+            , _threadsStarted(false)
             , _threadNamePrefix(threadNamePrefix) {
+            for (int i = 0; i < nThreads; ++i) {
+                _workers.push_back(new Worker(*this, i));
+            }
             startThreads();
         }
 
         ThreadPool::ThreadPool(const DoNotStartThreadsTag&,
                                int nThreads,
                                const std::string& threadNamePrefix)
-            : _mutex("ThreadPool"), _tasksRemaining(0)
-            , _nThreads(nThreads)
+            : _mutex("ThreadPool"), _shutdown(false)
+            , _threadsStarted(false)
             , _threadNamePrefix(threadNamePrefix) {
+            for (int i = 0; i < nThreads; ++i) {
+                _workers.push_back(new Worker(*this, i));
+            }
         }
 
         void ThreadPool::startThreads() {
             scoped_lock lock(_mutex);
-            for (int i = 0; i < _nThreads; ++i) {
+            verify(!_threadsStarted);
+            _threadsStarted = true;
+            for (size_t i = 0; i < _workers.size(); ++i) {
                 const std::string threadName(_threadNamePrefix.empty() ?
                                                         _threadNamePrefix :
                                                         str::stream() << _threadNamePrefix << i);
-                Worker* worker = new Worker(*this, threadName);
-                if (_tasks.empty()) {
-                    _freeWorkers.push_front(worker);
-                }
-                else {
-                    worker->set_task(_tasks.front());
-                    _tasks.pop_front();
-                }
+                _workers[i]->start(threadName);
             }
         }
 
         ThreadPool::~ThreadPool() {
             join();
 
-            verify(_tasksRemaining == 0);
+            verify(_tasksRemaining.load() == 0);
 
-            while(!_freeWorkers.empty()) {
-                delete _freeWorkers.front();
-                _freeWorkers.pop_front();
+            {
+                scoped_lock lock(_mutex);
+                _shutdown = true;
+                _workAvailable.notify_all();
+            }
+
+            // Every thread must be gone before any queue is, as idle workers look at them all.
+            for (size_t i = 0; i < _workers.size(); ++i) {
+                _workers[i]->join();
+            }
+            for (size_t i = 0; i < _workers.size(); ++i) {
+                delete _workers[i];
             }
         }
 
         void ThreadPool::join() {
             scoped_lock lock(_mutex);
-            while(_tasksRemaining) {
+            while(_tasksRemaining.load()) {
                 _condition.wait(lock.boost());
             }
         }
 
         void ThreadPool::schedule(Task task) {
-            scoped_lock lock(_mutex);
+            verify(!_workers.empty());
+
+            Worker* worker = getCurrentWorker();
+            if (!worker || &worker->owner() != this) {
+                worker = _workers[_nextWorker.fetchAndAdd(1) % _workers.size()];
+            }
 
-            _tasksRemaining++;
+            _tasksRemaining.fetchAndAdd(1);
+            _tasksScheduled.fetchAndAdd(1);
+            // Counted before it is queued, so that a worker never sleeps while it is queued.
+            _tasksQueued.fetchAndAdd(1);
+            worker->push(task);
 
-            if (!_freeWorkers.empty()) {
-                _freeWorkers.front()->set_task(task);
-                _freeWorkers.pop_front();
+            if (_idleWorkers.load() > 0) {
+                scoped_lock lock(_mutex);
+                _workAvailable.notify_one();
             }
-            else {
-                _tasks.push_back(task);
+        }
+
+        Task ThreadPool::nextTask(Worker* worker) {
+            Task task;
+            while (true) {
+                if (worker->pop(&task)) {
+                    _tasksQueued.subtractAndFetch(1);
+                    return task;
+                }
+
+                for (size_t i = 1; i < _workers.size(); ++i) {
+                    if (_workers[(worker->index() + i) % _workers.size()]->steal(&task)) {
+                        _tasksQueued.subtractAndFetch(1);
+                        _tasksStolen.fetchAndAdd(1);
+                        return task;
+                    }
+                }
+
+                scoped_lock lock(_mutex);
+                if (_shutdown)
+                    return Task();
+
+                // Announce that this worker is going idle before looking at the queued count a
+                // last time; schedule() does the opposite, so one of them sees the other.
+                _idleWorkers.fetchAndAdd(1);
+                if (_tasksQueued.load() == 0) {
+                    _workAvailable.wait(lock.boost());
+                }
+                _idleWorkers.subtractAndFetch(1);
             }
         }
 
         // should only be called by a worker from the worker thread
-        void ThreadPool::task_done(Worker* worker) {
-            scoped_lock lock(_mutex);
+        void ThreadPool::task_done() {
+            if (_tasksRemaining.subtractAndFetch(1) == 0) {
+                scoped_lock lock(_mutex);
+                _condition.notify_all();
+            }
+        }
+
+        ThreadPool::Stats ThreadPool::getStats() const {
+            Stats stats;
+            stats.queued = _tasksQueued.load();
+            stats.scheduled = _tasksScheduled.load();
+            stats.stolen = _tasksStolen.load();
+            return stats;
+        }
 
-            if (!_tasks.empty()) {
-                worker->set_task(_tasks.front());
-                _tasks.pop_front();
+        TaskGroup::TaskGroup(ThreadPool* pool)
+            : _pool(pool)
+            , _mutex("TaskGroup")
+            , _tasksRemaining(0) {
+        }
+
+        TaskGroup::~TaskGroup() {
+            join();
+        }
+
+        void TaskGroup::schedule(Task task) {
+            {
+                scoped_lock lock(_mutex);
+                _tasksRemaining++;
             }
-            else {
-                _freeWorkers.push_front(worker);
+            _pool->schedule(stdx::bind(&TaskGroup::runTask, this, task));
+        }
+
+        void TaskGroup::join() {
+            scoped_lock lock(_mutex);
+            while (_tasksRemaining) {
+                _condition.wait(lock.boost());
             }
+        }
 
-            _tasksRemaining--;
+        void TaskGroup::runTask(TaskGroup* group, const Task& task) {
+            ON_BLOCK_EXIT_OBJ(*group, &TaskGroup::taskDone);
+            task();
+        }
 
-            if(_tasksRemaining == 0)
+        void TaskGroup::taskDone() {
+            scoped_lock lock(_mutex);
+            if (--_tasksRemaining == 0)
                 _condition.notify_all();
         }
 
@@ -29,10 +29,12 @@
 
 #pragma once
 
-#include <list>
+#include <string>
+#include <vector>
 
 #include <boost/thread/condition.hpp>
 
+#include "mongo/platform/atomic_word.h"
 #include "mongo/stdx/functional.h"
 #include "mongo/util/concurrency/mutex.h"
 
@@ -44,10 +46,22 @@ namespace mongo {
         typedef stdx::function<void(void)> Task; //nullary function or functor
 
         // exported to the mongo namespace
+        //
+        // Each worker has its own queue.  Tasks scheduled by a worker go to its own queue and
+        // tasks scheduled by other threads are spread over the queues round robin.  A worker
+        // runs its own queue in order and, when it is empty, steals from the back of the others.
         class ThreadPool : boost::noncopyable {
         public:
             struct DoNotStartThreadsTag {};
 
+            struct Stats {
+                Stats();
+
+                int queued;           // tasks waiting for a worker
+                long long scheduled;  // total tasks scheduled
+                long long stolen;     // tasks run by a worker other than the one queueing them
+            };
+
             explicit ThreadPool(int nThreads=8, const std::string& threadNamePrefix="");
             explicit ThreadPool(const DoNotStartThreadsTag&,
                                 int nThreads=8,
@@ -64,6 +78,7 @@ namespace mongo {
             // blocks until all tasks are complete (tasks_remaining() == 0)
             // does not prevent new tasks from being scheduled so could wait forever.
             // Also, new tasks could be scheduled after this returns.
+            // Use a TaskGroup to wait for only some of the tasks.
             void join();
 
             // task will be copied a few times so make sure it's relatively cheap
@@ -82,23 +97,70 @@ namespace mongo {
             template<typename F, typename A, typename B, typename C, typename D, typename E>
             void schedule(F f, A a, B b, C c, D d, E e) { schedule(stdx::bind(f,a,b,c,d,e)); }
 
-            int tasks_remaining() { return _tasksRemaining; }
+            int tasks_remaining() { return _tasksRemaining.load(); }
+
+            Stats getStats() const;
 
         private:
-            mongo::mutex _mutex;
-            boost::condition _condition;
+            // Returns the next task for 'worker' to run, from its own queue or stolen from
+            // another, or an empty task once the pool is shutting down.  Blocks while there is
+            // nothing to run.
+            Task nextTask(Worker* worker);
+
+            // should only be called by a worker from the worker's thread
+            void task_done();
 
-            std::list<Worker*> _freeWorkers; //used as LIFO stack (always front)
-            std::list<Task> _tasks; //used as FIFO queue (push_back, pop_front)
-            int _tasksRemaining; // in queue + currently processing
-            int _nThreads; // only used for sanity checking. could be removed in the future.
+            mongo::mutex _mutex;
+            boost::condition _condition; // signalled when _tasksRemaining drops to 0
+            boost::condition _workAvailable;
+            bool _shutdown;
+
+            std::vector<Worker*> _workers; // fixed after construction
+            AtomicUInt32 _nextWorker; // the queue for the next task scheduled by a non-worker
+            AtomicInt32 _tasksRemaining; // in queue + currently processing
+            AtomicInt32 _tasksQueued;
+            AtomicInt32 _idleWorkers;
+            AtomicInt64 _tasksScheduled;
+            AtomicInt64 _tasksStolen;
+            bool _threadsStarted;
             const std::string _threadNamePrefix; // used for logging/diagnostics
 
-            // should only be called by a worker from the worker's thread
-            void task_done(Worker* worker);
             friend class Worker;
         };
 
+        /**
+         * Tasks scheduled on a pool through a TaskGroup can be waited for on their own, whatever
+         * else the pool runs.  The destructor waits for the group's tasks.
+         */
+        class TaskGroup : boost::noncopyable {
+        public:
+            explicit TaskGroup(ThreadPool* pool);
+            ~TaskGroup();
+
+            void schedule(Task task);
+
+            template<typename F, typename A>
+            void schedule(F f, A a) { schedule(stdx::bind(f,a)); }
+            template<typename F, typename A, typename B>
+            void schedule(F f, A a, B b) { schedule(stdx::bind(f,a,b)); }
+            template<typename F, typename A, typename B, typename C>
+            void schedule(F f, A a, B b, C c) { schedule(stdx::bind(f,a,b,c)); }
+            template<typename F, typename A, typename B, typename C, typename D>
+            void schedule(F f, A a, B b, C c, D d) { schedule(stdx::bind(f,a,b,c,d)); }
+
+            // blocks until every task scheduled through this group is complete
+            void join();
+
+        private:
+            static void runTask(TaskGroup* group, const Task& task);
+            void taskDone();
+
+            ThreadPool* const _pool;
+            mongo::mutex _mutex;
+            boost::condition _condition;
+            int _tasksRemaining;
+        };
+
     } //namespace threadpool
 
     using threadpool::ThreadPool;
@@ -0,0 +1,160 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+namespace {
+
+    void increment(AtomicInt32* counter) {
+        counter->fetchAndAdd(1);
+    }
+
+    // Blocks the calling worker until open() is called.
+    class Gate {
+    public:
+        Gate() : _open(false) {}
+
+        void open() {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            _open = true;
+            _condition.notify_all();
+        }
+
+        static void wait(Gate* gate) {
+            boost::unique_lock<boost::mutex> lk(gate->_mutex);
+            while (!gate->_open) {
+                gate->_condition.wait(lk);
+            }
+        }
+
+    private:
+        boost::mutex _mutex;
+        boost::condition_variable _condition;
+        bool _open;
+    };
+
+    TEST(ThreadPool, ScheduleAndJoin) {
+        ThreadPool pool(4);
+        AtomicInt32 counter;
+        for (int i = 0; i < 1000; ++i) {
+            pool.schedule(&increment, &counter);
+        }
+        pool.join();
+        ASSERT_EQUALS(1000, counter.load());
+        ASSERT_EQUALS(0, pool.tasks_remaining());
+
+        ThreadPool::Stats stats = pool.getStats();
+        ASSERT_EQUALS(0, stats.queued);
+        ASSERT_EQUALS(1000, stats.scheduled);
+    }
+
+    TEST(ThreadPool, DoNotStartThreads) {
+        ThreadPool pool(ThreadPool::DoNotStartThreadsTag(), 2);
+        AtomicInt32 counter;
+        for (int i = 0; i < 10; ++i) {
+            pool.schedule(&increment, &counter);
+        }
+        ASSERT_EQUALS(10, pool.getStats().queued);
+        ASSERT_EQUALS(0, counter.load());
+
+        pool.startThreads();
+        pool.join();
+        ASSERT_EQUALS(10, counter.load());
+    }
+
+    // Fills the queue of the worker running it, which then blocks while others steal its tasks.
+    void scheduleLocally(ThreadPool* pool, AtomicInt32* counter, Gate* gate) {
+        for (int i = 0; i < 100; ++i) {
+            pool->schedule(&increment, counter);
+        }
+        Gate::wait(gate);
+    }
+
+    TEST(ThreadPool, IdleWorkersSteal) {
+        ThreadPool pool(2);
+        AtomicInt32 counter;
+        Gate gate;
+        pool.schedule(&scheduleLocally, &pool, &counter, &gate);
+
+        while (counter.load() < 100) {
+            sleepmillis(1);
+        }
+        // The first task itself may have been stolen too.
+        ASSERT_GREATER_THAN_OR_EQUALS(pool.getStats().stolen, 100);
+
+        gate.open();
+        pool.join();
+    }
+
+    TEST(TaskGroup, JoinWaitsOnlyForItsTasks) {
+        ThreadPool pool(2);
+        Gate gate;
+        pool.schedule(&Gate::wait, &gate);
+
+        AtomicInt32 counter;
+        {
+            threadpool::TaskGroup group(&pool);
+            for (int i = 0; i < 100; ++i) {
+                group.schedule(&increment, &counter);
+            }
+            group.join();
+            ASSERT_EQUALS(100, counter.load());
+            // The gated task is still running.
+            ASSERT_GREATER_THAN_OR_EQUALS(pool.tasks_remaining(), 1);
+
+            // Joining again with nothing scheduled returns at once.
+            group.join();
+        }
+
+        gate.open();
+        pool.join();
+    }
+
+    TEST(TaskGroup, DestructorJoins) {
+        ThreadPool pool(3);
+        AtomicInt32 counter;
+        {
+            threadpool::TaskGroup group(&pool);
+            for (int i = 0; i < 100; ++i) {
+                group.schedule(&increment, &counter);
+            }
+        }
+        ASSERT_EQUALS(100, counter.load());
+    }
+
+}  // namespace
+}  // namespace mongo
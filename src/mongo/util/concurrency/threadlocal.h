@@ -93,6 +93,8 @@ namespace mongo {
     public:
         T* get() const;
         void reset(T* v);
+        // Detaches the value from this thread without deleting it.
+        T* release();
         T* getMake() { 
             T *t = get();
             if( t == 0 )
@@ -111,7 +113,13 @@ namespace mongo {
     void TSP<T>::reset(T* v) { \
         tsp.reset(v); \
         _ ## p = v; \
-    } 
+    } \
+    template<> T* TSP<T>::release() { \
+        T* v = _ ## p; \
+        tsp.release(); \
+        _ ## p = 0; \
+        return v; \
+    }
 # else
 
 #  define TSP_DECLARE(T,p) \
@@ -125,6 +133,12 @@ namespace mongo {
         tsp.reset(v); \
         _ ## p = v; \
     } \
+    template<> T* TSP<T>::release() { \
+        T* v = _ ## p; \
+        tsp.release(); \
+        _ ## p = 0; \
+        return v; \
+    } \
     TSP<T> p;
 # endif
 
@@ -156,6 +170,12 @@ namespace mongo {
             verify( pthread_setspecific( _key, v ) == 0 ); 
         }
 
+        T* release() {
+            T* v = get();
+            verify( pthread_setspecific( _key, 0 ) == 0 );
+            return v;
+        }
+
         T* getMake() { 
             T *t = get();
             if( t == 0 ) {
@@ -178,6 +198,7 @@ namespace mongo {
     public:
         T* get() const { return tsp.get(); }
         void reset(T* v) { tsp.reset(v); }
+        T* release() { return tsp.release(); }
         T* getMake() { 
             T *t = get();
             if( t == 0 )
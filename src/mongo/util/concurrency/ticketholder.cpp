@@ -0,0 +1,156 @@
+/*    Copyright 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/concurrency/ticketholder.h"
+
+#include "mongo/util/assert_util.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+    const long long TicketHolder::kWaitHistogramBucketMicros[] = {
+        100, 1000, 10 * 1000, 100 * 1000, 1000 * 1000, 10 * 1000 * 1000
+    };
+
+    TicketHolder::Stats::Stats() : acquired(0), waited(0), totalWaitMicros(0) {
+        for (int i = 0; i < kNumWaitHistogramBuckets; i++) {
+            waitHistogram[i] = 0;
+        }
+    }
+
+    TicketHolder::TicketHolder( int num ) : _outof(num), _num(num) {
+    }
+
+    bool TicketHolder::_tryAcquireTicket() {
+        int num = _num.load();
+        while (num > 0) {
+            const int old = _num.compareAndSwap(num, num - 1);
+            if (old == num) {
+                _acquired.fetchAndAdd(1);
+                return true;
+            }
+            num = old;
+        }
+        return false;
+    }
+
+    bool TicketHolder::tryAcquire() {
+        // Queued threads have priority over new arrivals
+        if (_numWaiters.load() > 0) {
+            return false;
+        }
+        return _tryAcquireTicket();
+    }
+
+    void TicketHolder::waitForTicket() {
+        if (tryAcquire()) {
+            return;
+        }
+
+        Timer timer;
+        Waiter waiter;
+        {
+            boost::unique_lock<boost::mutex> lk(_mutex);
+
+            // Registering as a waiter before the final attempt pairs with release(), which
+            // returns the ticket before checking for waiters: either we see its ticket or it
+            // sees us and hands the ticket over under the mutex.
+            _numWaiters.fetchAndAdd(1);
+            if (_waiters.empty() && _tryAcquireTicket()) {
+                _numWaiters.fetchAndSubtract(1);
+                return;
+            }
+
+            _waiters.push_back(&waiter);
+            _grantToWaiters_inlock();
+
+            while (!waiter.granted) {
+                waiter.condition.wait(lk);
+            }
+        }
+
+        _recordWait(timer.micros());
+    }
+
+    void TicketHolder::release() {
+        _num.fetchAndAdd(1);
+
+        if (_numWaiters.load() == 0) {
+            return;
+        }
+
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        _grantToWaiters_inlock();
+    }
+
+    void TicketHolder::resize( int newSize ) {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+
+        const int delta = newSize - _outof.load();
+        _outof.store(newSize);
+        _num.fetchAndAdd(delta);
+
+        _grantToWaiters_inlock();
+    }
+
+    void TicketHolder::_grantToWaiters_inlock() {
+        while (!_waiters.empty() && _tryAcquireTicket()) {
+            Waiter* waiter = _waiters.front();
+            _waiters.pop_front();
+            _numWaiters.fetchAndSubtract(1);
+
+            waiter->granted = true;
+            waiter->condition.notify_one();
+        }
+    }
+
+    void TicketHolder::_recordWait( long long micros ) {
+        _waited.fetchAndAdd(1);
+        _totalWaitMicros.fetchAndAdd(micros);
+
+        int bucket = 0;
+        while (bucket < kNumWaitHistogramBuckets - 1 &&
+               micros > kWaitHistogramBucketMicros[bucket]) {
+            bucket++;
+        }
+        _waitHistogram[bucket].fetchAndAdd(1);
+    }
+
+    TicketHolder::Stats TicketHolder::getStats() const {
+        Stats stats;
+        stats.acquired = _acquired.load();
+        stats.waited = _waited.load();
+        stats.totalWaitMicros = _totalWaitMicros.load();
+        for (int i = 0; i < kNumWaitHistogramBuckets; i++) {
+            stats.waitHistogram[i] = _waitHistogram[i].load();
+        }
+        return stats;
+    }
+
+}  // namespace mongo
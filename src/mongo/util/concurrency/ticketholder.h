@@ -27,85 +27,96 @@
 #pragma once
 
 #include <boost/thread/condition_variable.hpp>
-#include <iostream>
+#include <boost/thread/mutex.hpp>
+#include <deque>
 
-#include "mongo/util/concurrency/mutex.h"
+#include "mongo/base/disallow_copying.h"
+#include "mongo/platform/atomic_word.h"
 
 namespace mongo {
 
+    /**
+     * A counting semaphore used for admission control.
+     *
+     * Acquiring and releasing a ticket is a single atomic operation while no thread is queued.
+     * Threads which have to wait are queued in FIFO order and tickets are handed to them
+     * directly on release, so a waiter cannot be overtaken by threads which arrive later.
+     */
     class TicketHolder {
+        MONGO_DISALLOW_COPYING(TicketHolder);
     public:
-        TicketHolder( int num ) : _mutex("TicketHolder") {
-            _outof = num;
-            _num = num;
-        }
-
-        bool tryAcquire() {
-            scoped_lock lk( _mutex );
-            return _tryAcquire();
-        }
+        /**
+         * Upper bounds, in microseconds, of the buckets used for the wait time histogram. The
+         * last bucket counts all waits longer than the last bound.
+         */
+        static const int kNumWaitHistogramBuckets = 7;
+        static const long long kWaitHistogramBucketMicros[kNumWaitHistogramBuckets - 1];
 
-        void waitForTicket() {
-            scoped_lock lk( _mutex );
+        struct Stats {
+            Stats();
 
-            while( ! _tryAcquire() ) {
-                _newTicket.wait( lk.boost() );
-            }
-        }
+            long long acquired;        // total tickets handed out
+            long long waited;          // acquisitions which had to queue
+            long long totalWaitMicros; // time spent queued by those acquisitions
+            long long waitHistogram[kNumWaitHistogramBuckets];
+        };
 
-        void release() {
-            {
-                scoped_lock lk( _mutex );
-                _num++;
-            }
-            _newTicket.notify_one();
-        }
+        explicit TicketHolder( int num );
 
-        void resize( int newSize ) {
-            {
-                scoped_lock lk( _mutex );
+        bool tryAcquire();
 
-                int used = _outof - _num;
-                if ( used > newSize ) {
-                    std::cout << "can't resize since we're using (" << used << ") more than newSize(" << newSize << ")" << std::endl;
-                    return;
-                }
+        void waitForTicket();
 
-                _outof = newSize;
-                _num = _outof - used;
-            }
+        void release();
 
-            // Potentially wasteful, but easier to see is correct
-            _newTicket.notify_all();
-        }
+        /**
+         * Changes the number of tickets. Shrinking below the number in use is allowed; the
+         * holder is then oversubscribed and hands out no new tickets until enough are released.
+         */
+        void resize( int newSize );
 
         int available() const {
-            return _num;
+            const int num = _num.load();
+            return num > 0 ? num : 0;
         }
 
-        int used() const {
-            return _outof - _num;
-        }
+        int used() const { return _outof.load() - _num.load(); }
+
+        int outof() const { return _outof.load(); }
 
-        int outof() const { return _outof; }
+        /** Number of threads currently queued in waitForTicket(). */
+        int queueDepth() const { return _numWaiters.load(); }
+
+        Stats getStats() const;
 
     private:
+        struct Waiter {
+            Waiter() : granted(false) {}
 
-        bool _tryAcquire(){
-            if ( _num <= 0 ) {
-                if ( _num < 0 ) {
-                    std::cerr << "DISASTER! in TicketHolder" << std::endl;
-                }
-                return false;
-            }
-            _num--;
-            return true;
-        }
+            boost::condition_variable condition;
+            bool granted;
+        };
+
+        bool _tryAcquireTicket();
+
+        /**
+         * Moves available tickets to queued waiters, oldest first. Must hold _mutex.
+         */
+        void _grantToWaiters_inlock();
+
+        void _recordWait( long long micros );
+
+        AtomicInt32 _outof;
+        AtomicInt32 _num;        // tickets available; negative while oversubscribed
+        AtomicInt32 _numWaiters; // threads in waitForTicket()'s slow path
+
+        boost::mutex _mutex;     // protects _waiters
+        std::deque<Waiter*> _waiters;
 
-        int _outof;
-        int _num;
-        mongo::mutex _mutex;
-        boost::condition_variable_any _newTicket;
+        AtomicInt64 _acquired;
+        AtomicInt64 _waited;
+        AtomicInt64 _totalWaitMicros;
+        AtomicInt64 _waitHistogram[kNumWaitHistogramBuckets];
     };
 
     class ScopedTicket {
@@ -0,0 +1,142 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <boost/thread/thread.hpp>
+#include <vector>
+
+#include "mongo/stdx/functional.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+namespace {
+
+    TEST(TicketHolder, AcquireAndRelease) {
+        TicketHolder holder(2);
+        ASSERT_EQUALS(2, holder.available());
+
+        ASSERT(holder.tryAcquire());
+        ASSERT(holder.tryAcquire());
+        ASSERT_FALSE(holder.tryAcquire());
+        ASSERT_EQUALS(2, holder.used());
+        ASSERT_EQUALS(0, holder.available());
+
+        holder.release();
+        ASSERT_EQUALS(1, holder.available());
+        ASSERT(holder.tryAcquire());
+
+        holder.release();
+        holder.release();
+        ASSERT_EQUALS(0, holder.used());
+        ASSERT_EQUALS(3, holder.getStats().acquired);
+    }
+
+    TEST(TicketHolder, ShrinkWhileInUse) {
+        TicketHolder holder(4);
+        for (int i = 0; i < 4; i++) {
+            ASSERT(holder.tryAcquire());
+        }
+
+        holder.resize(2);
+        ASSERT_EQUALS(2, holder.outof());
+        ASSERT_EQUALS(4, holder.used());
+        ASSERT_EQUALS(0, holder.available());
+
+        // Two releases only pay back the oversubscription
+        holder.release();
+        holder.release();
+        ASSERT_FALSE(holder.tryAcquire());
+
+        holder.release();
+        ASSERT(holder.tryAcquire());
+    }
+
+    void takeTicket(TicketHolder* holder, int id, boost::mutex* mutex, std::vector<int>* order) {
+        holder->waitForTicket();
+        {
+            boost::lock_guard<boost::mutex> lk(*mutex);
+            order->push_back(id);
+        }
+    }
+
+    TEST(TicketHolder, WaitersAreServedInArrivalOrder) {
+        TicketHolder holder(1);
+        ASSERT(holder.tryAcquire());
+
+        const int kNumWaiters = 4;
+        boost::mutex mutex;
+        std::vector<int> order;
+        std::vector<boost::thread*> threads;
+        for (int i = 0; i < kNumWaiters; i++) {
+            threads.push_back(new boost::thread(
+                stdx::bind(takeTicket, &holder, i, &mutex, &order)));
+            while (holder.queueDepth() != i + 1) {
+                sleepmillis(1);
+            }
+        }
+
+        // New arrivals do not overtake queued threads
+        holder.release();
+        ASSERT_FALSE(holder.tryAcquire());
+
+        for (int i = 0; i < kNumWaiters; i++) {
+            threads[i]->join();
+            delete threads[i];
+            if (i + 1 < kNumWaiters) {
+                // Hand the ticket taken by waiter i to the next one
+                holder.release();
+            }
+        }
+
+        ASSERT_EQUALS(static_cast<size_t>(kNumWaiters), order.size());
+        for (int i = 0; i < kNumWaiters; i++) {
+            ASSERT_EQUALS(i, order[i]);
+        }
+        ASSERT_EQUALS(kNumWaiters, holder.getStats().waited);
+    }
+
+    TEST(TicketHolder, GrowWakesWaiters) {
+        TicketHolder holder(0);
+        boost::mutex mutex;
+        std::vector<int> order;
+        boost::thread waiter(stdx::bind(takeTicket, &holder, 0, &mutex, &order));
+        while (holder.queueDepth() != 1) {
+            sleepmillis(1);
+        }
+
+        holder.resize(1);
+        waiter.join();
+        ASSERT_EQUALS(1U, order.size());
+        ASSERT_EQUALS(1, holder.used());
+    }
+
+} // namespace
+} // namespace mongo
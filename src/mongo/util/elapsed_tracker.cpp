@@ -32,25 +32,26 @@
 
 #include "mongo/util/elapsed_tracker.h"
 
-#include "mongo/util/net/listen.h"
+#include "mongo/util/coarse_clock.h"
 
 namespace mongo {
 
     ElapsedTracker::ElapsedTracker( int32_t hitsBetweenMarks, int32_t msBetweenMarks ) :
         _hitsBetweenMarks( hitsBetweenMarks ),
         _msBetweenMarks( msBetweenMarks ),
-        _pings( 0 ),
-        _last( Listener::getElapsedTimeMillis() ) {
+        _pings( 0 ) {
+        CoarseClock::start();
+        _last = CoarseClock::millis();
     }
 
     bool ElapsedTracker::intervalHasElapsed() {
         if ( ++_pings >= _hitsBetweenMarks ) {
             _pings = 0;
-            _last = Listener::getElapsedTimeMillis();
+            _last = CoarseClock::millis();
             return true;
         }
 
-        long long now = Listener::getElapsedTimeMillis();
+        long long now = CoarseClock::millis();
         if ( now - _last > _msBetweenMarks ) {
             _pings = 0;
             _last = now;
@@ -62,7 +63,7 @@ namespace mongo {
 
     void ElapsedTracker::resetLastTime() {
         _pings = 0;
-        _last = Listener::getElapsedTimeMillis();
+        _last = CoarseClock::millis();
     }
 
 } // namespace mongo
@@ -105,8 +105,17 @@ namespace mongo {
     }
 
 
-    void FileAllocator::start() {
-        boost::thread t( stdx::bind( &FileAllocator::run , this ) );
+    void FileAllocator::start( int numThreads ) {
+        verify( numThreads >= 1 );
+        {
+            // initialize unique temporary file name counter
+            // TODO: SERVER-6055 -- Unify temporary file name selection
+            SimpleMutex::scoped_lock lk(_uniqueNumberMutex);
+            _uniqueNumber = curTimeMicros64();
+        }
+        for ( int i = 0; i < numThreads; i++ ) {
+            boost::thread t( stdx::bind( &FileAllocator::run , this ) );
+        }
     }
 
     void FileAllocator::requestAllocation( const string &name, long &size ) {
@@ -138,13 +147,10 @@ namespace mongo {
         }
         checkFailure();
         _pendingSize[ name ] = size;
-        if ( _pending.size() == 0 )
-            _pending.push_back( name );
-        else if ( _pending.front() != name ) {
+        if ( _claimed.count( name ) == 0 ) {
+            // workers skip claimed files, so the front is the next one picked up
             _pending.remove( name );
-            list< string >::iterator i = _pending.begin();
-            ++i;
-            _pending.insert( i, name );
+            _pending.push_front( name );
         }
         _pendingUpdated.notify_all();
         while( inProgress( name ) ) {
@@ -282,6 +288,14 @@ namespace mongo {
         return false;
     }
 
+    // caller must hold _pendingMutex lock.
+    string FileAllocator::nextUnclaimed() const {
+        for( list< string >::const_iterator i = _pending.begin(); i != _pending.end(); ++i )
+            if ( _claimed.count( *i ) == 0 )
+                return *i;
+        return "";
+    }
+
     string FileAllocator::makeTempFileName( boost::filesystem::path root ) {
         while( 1 ) {
             boost::filesystem::path p = root / "_tmp";
@@ -305,16 +319,10 @@ namespace mongo {
 
     void FileAllocator::run( FileAllocator * fa ) {
         setThreadName( "FileAllocator" );
-        {
-            // initialize unique temporary file name counter
-            // TODO: SERVER-6055 -- Unify temporary file name selection
-            SimpleMutex::scoped_lock lk(_uniqueNumberMutex);
-            _uniqueNumber = curTimeMicros64();
-        }
         while( 1 ) {
             {
                 scoped_lock lk( fa->_pendingMutex );
-                if ( fa->_pending.size() == 0 )
+                if ( fa->nextUnclaimed().empty() )
                     fa->_pendingUpdated.wait( lk.boost() );
             }
             while( 1 ) {
@@ -322,10 +330,11 @@ namespace mongo {
                 long size = 0;
                 {
                     scoped_lock lk( fa->_pendingMutex );
-                    if ( fa->_pending.size() == 0 )
+                    name = fa->nextUnclaimed();
+                    if ( name.empty() )
                         break;
-                    name = fa->_pending.front();
                     size = fa->_pendingSize[ name ];
+                    fa->_claimed.insert( name );
                 }
 
                 string tmp;
@@ -395,6 +404,7 @@ namespace mongo {
                     {
                         scoped_lock lk(fa->_pendingMutex);
                         fa->_failed = true;
+                        fa->_claimed.erase( name );
 
                         // TODO: Should we remove the file from pending?
                         fa->_pendingUpdated.notify_all();
@@ -408,7 +418,8 @@ namespace mongo {
                 {
                     scoped_lock lk( fa->_pendingMutex );
                     fa->_pendingSize.erase( name );
-                    fa->_pending.pop_front();
+                    fa->_pending.remove( name );
+                    fa->_claimed.erase( name );
                     fa->_pendingUpdated.notify_all();
                 }
             }
@@ -30,6 +30,7 @@
 #include "mongo/pch.h"
 
 #include <list>
+#include <set>
 #include <boost/filesystem/path.hpp>
 #include <boost/thread/condition.hpp>
 
@@ -39,7 +40,9 @@ namespace mongo {
 
     /*
      * Handles allocation of contiguous files on disk.  Allocation may be
-     * requested asynchronously or synchronously.
+     * requested asynchronously or synchronously.  Several worker threads may
+     * allocate different files at once, which helps when the filesystem
+     * lacks posix_fallocate and each file has to be filled with zeroes.
      * singleton
      */
     class FileAllocator : boost::noncopyable {
@@ -49,7 +52,8 @@ namespace mongo {
          * size specified per file will be used.
         */
     public:
-        void start();
+        /** Starts 'numThreads' worker threads, which must be at least one. */
+        void start( int numThreads = 1 );
 
         /**
          * May be called if file exists. If file exists, or its allocation has
@@ -84,6 +88,10 @@ namespace mongo {
         // caller must hold pendingMutex_ lock.
         bool inProgress( const std::string &name ) const;
 
+        // caller must hold pendingMutex_ lock.  Returns the first pending file no
+        // worker has claimed yet, or the empty string if there is none.
+        std::string nextUnclaimed() const;
+
         /** called from the worked thread */
         static void run( FileAllocator * fa );
 
@@ -96,6 +104,9 @@ namespace mongo {
         std::list< std::string > _pending;
         mutable std::map< std::string, long > _pendingSize;
 
+        // pending files which a worker thread is currently allocating
+        std::set< std::string > _claimed;
+
         // unique number for temporary files
         static unsigned long long _uniqueNumber;
 
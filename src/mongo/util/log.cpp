@@ -37,6 +37,7 @@
 #include <unistd.h>
 #endif
 
+#include "mongo/logger/async_log_queue.h"
 #include "mongo/logger/ramlog.h"
 #include "mongo/logger/rotatable_file_manager.h"
 #include "mongo/util/assert_util.h"
@@ -69,6 +70,9 @@ namespace mongo {
     }
 
     bool rotateLogs(bool renameFiles) {
+        // Write out queued messages first, so that they land in the file they were logged to.
+        logger::AsyncLogQueue::flushAll();
+
         using logger::RotatableFileManager;
         RotatableFileManager* manager = logger::globalRotatableFileManager();
         RotatableFileManager::FileNameStatusPairVector result(
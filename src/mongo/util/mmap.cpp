@@ -153,19 +153,38 @@ namespace {
         return total;
     }
 
-    void nullFunc() { }
+    unsigned long long nullPreFlush() { return 0; }
+    void nullPostFlush(unsigned long long preFlushToken) { }
 
     // callback notifications
-    void (*MongoFile::notifyPreFlush)() = nullFunc;
-    void (*MongoFile::notifyPostFlush)() = nullFunc;
+    unsigned long long (*MongoFile::notifyPreFlush)() = nullPreFlush;
+    void (*MongoFile::notifyPostFlush)(unsigned long long) = nullPostFlush;
 
     /*static*/ int MongoFile::flushAll( bool sync ) {
-        if ( sync ) notifyPreFlush();
+        unsigned long long preFlushToken = 0;
+        if ( sync ) preFlushToken = notifyPreFlush();
         int x = _flushAll(sync);
-        if ( sync ) notifyPostFlush();
+        if ( sync ) notifyPostFlush(preFlushToken);
         return x;
     }
 
+    /*static*/ void MongoFile::prepareFlushChunks(unsigned long long chunkBytes,
+                                                  OwnedPointerVector<Flushable>* out) {
+        invariant(chunkBytes > 0);
+        LockMongoFilesShared lk;
+        for ( set<MongoFile*>::iterator i = mmfiles.begin(); i != mmfiles.end(); i++ ) {
+            MongoFile* mmf = *i;
+            if ( !mmf )
+                continue;
+
+            const unsigned long long len = mmf->length();
+            for ( unsigned long long offset = 0; offset < len; offset += chunkBytes ) {
+                out->push_back( mmf->prepareFlushRange( offset,
+                                                        std::min( chunkBytes, len - offset ) ) );
+            }
+        }
+    }
+
     /*static*/ int MongoFile::_flushAll( bool sync ) {
         if ( ! sync ) {
             int num = 0;
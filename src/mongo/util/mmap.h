@@ -41,6 +41,8 @@
 
 namespace mongo {
 
+    template <typename T> class OwnedPointerVector;
+
     extern const size_t g_minOSPageSizeBytes;
     void minOSPageSizeBytesTest(size_t minOSPageSizeBytes);  // lame-o
 
@@ -114,11 +116,21 @@ namespace mongo {
 */
         static std::set<MongoFile*>& getAllFiles();
 
-        // callbacks if you need them
-        static void (*notifyPreFlush)();
-        static void (*notifyPostFlush)();
+        // callbacks if you need them.  notifyPostFlush is passed what the notifyPreFlush call
+        // which began the same flush returned, as flushes may overlap.
+        static unsigned long long (*notifyPreFlush)();
+        static void (*notifyPostFlush)(unsigned long long preFlushToken);
 
         static int flushAll( bool sync ); // returns n flushed
+
+        /**
+         * Appends thread safe objects to 'out' which together sync every file as flushAll(true)
+         * does, each covering at most 'chunkBytes' of one file, so that a caller can spread the
+         * writes out.  'chunkBytes' must be a multiple of the page size.  Unlike flushAll(), this
+         * doesn't call notifyPreFlush and notifyPostFlush.
+         */
+        static void prepareFlushChunks(unsigned long long chunkBytes,
+                                       OwnedPointerVector<Flushable>* out);
         static long long totalMappedLength();
         static void closeAllFiles( std::stringstream &message );
 
@@ -141,6 +153,12 @@ namespace mongo {
          */
         virtual Flushable * prepareFlush() = 0;
 
+        /**
+         * Like prepareFlush(), for the 'length' bytes of the file starting at 'offset'.
+         */
+        virtual Flushable * prepareFlushRange(unsigned long long offset,
+                                              unsigned long long length) = 0;
+
         void created(); /* subclass must call after create */
 
         /* subclass must call in destructor (or at close).
@@ -208,6 +226,8 @@ namespace mongo {
 
         void flush(bool sync);
         virtual Flushable * prepareFlush();
+        virtual Flushable * prepareFlushRange(unsigned long long offset,
+                                              unsigned long long length);
 
         long shortLength() const          { return (long) len; }
         unsigned long long length() const { return len; }
@@ -269,21 +269,28 @@ namespace mongo {
 
     class PosixFlushable : public MemoryMappedFile::Flushable {
     public:
-        PosixFlushable( MemoryMappedFile* theFile, void* view , HANDLE fd , long len)
-            : _theFile( theFile ), _view( view ), _fd(fd), _len(len), _id(_theFile->getUniqueId()) {
+        /**
+         * Flushes the whole file, unless 'wholeFile' is false, in which case just the 'len' bytes
+         * at 'view' are synced.
+         */
+        PosixFlushable( MemoryMappedFile* theFile, void* view , HANDLE fd , long len,
+                        bool wholeFile = true )
+            : _theFile( theFile ), _view( view ), _fd(fd), _len(len), _id(_theFile->getUniqueId()),
+              _wholeFile( wholeFile ) {
         }
 
         void flush() {
             if ( _view == NULL || _fd == 0 )
                 return;
 
-            if ( ProcessInfo::preferMsyncOverFSync() ?
+            if ( ( !_wholeFile || ProcessInfo::preferMsyncOverFSync() ) ?
                 msync(_view, _len, MS_SYNC ) == 0 :
                 fsync(_fd) == 0 ) {
                 return;
             }
 
-            if ( errno == EBADF ) {
+            // ENOMEM means the view was unmapped, which happens when the file is closed
+            if ( errno == EBADF || errno == ENOMEM ) {
                 // ok, we were unlocked, so this file was closed
                 return;
             }
@@ -309,12 +316,19 @@ namespace mongo {
         HANDLE _fd;
         long _len;
         const uint64_t _id;
+        const bool _wholeFile;
     };
 
     MemoryMappedFile::Flushable * MemoryMappedFile::prepareFlush() {
         return new PosixFlushable( this, viewForFlushing(), fd, len);
     }
 
+    MemoryMappedFile::Flushable * MemoryMappedFile::prepareFlushRange(unsigned long long offset,
+                                                                      unsigned long long length) {
+        char* view = static_cast<char*>( viewForFlushing() );
+        return new PosixFlushable( this, view ? view + offset : NULL, fd, length, false );
+    }
+
 
 } // namespace mongo
 
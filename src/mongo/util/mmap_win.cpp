@@ -438,14 +438,18 @@ namespace mongo {
 
     class WindowsFlushable : public MemoryMappedFile::Flushable {
     public:
+        /**
+         * Flushes 'length' bytes of the view starting at 'view', or all of it if 'length' is 0.
+         */
         WindowsFlushable( MemoryMappedFile* theFile,
                           void * view,
                           HANDLE fd,
                           const uint64_t id,
                           const std::string& filename,
-                          boost::mutex& flushMutex )
+                          boost::mutex& flushMutex,
+                          size_t length = 0 )
             : _theFile(theFile), _view(view), _fd(fd), _id(id), _filename(filename),
-              _flushMutex(flushMutex)
+              _flushMutex(flushMutex), _length(length)
         {}
 
         void flush() {
@@ -476,7 +480,7 @@ namespace mongo {
             Timer t;
             while ( !success && !timeout ) {
                 ++loopCount;
-                success = FALSE != FlushViewOfFile( _view, 0 );
+                success = FALSE != FlushViewOfFile( _view, _length );
                 if ( !success ) {
                     dosError = GetLastError();
                     if ( dosError != ERROR_LOCK_VIOLATION ) {
@@ -516,6 +520,7 @@ namespace mongo {
         const uint64_t _id;
         string _filename;
         boost::mutex& _flushMutex;
+        const size_t _length;
     };
 
     void MemoryMappedFile::flush(bool sync) {
@@ -531,4 +536,11 @@ namespace mongo {
                                     filename(), _flushMutex);
     }
 
+    MemoryMappedFile::Flushable * MemoryMappedFile::prepareFlushRange(unsigned long long offset,
+                                                                      unsigned long long length) {
+        char* view = static_cast<char*>(viewForFlushing());
+        return new WindowsFlushable(this, view ? view + offset : NULL, fd, _uniqueId,
+                                    filename(), _flushMutex, static_cast<size_t>(length));
+    }
+
 }
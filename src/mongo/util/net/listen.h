@@ -36,6 +36,7 @@
 #include <vector>
 
 #include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/net/sock.h"
 
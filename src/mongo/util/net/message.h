@@ -63,7 +63,8 @@ namespace mongo {
         dbQuery = 2004,
         dbGetMore = 2005,
         dbDelete = 2006,
-        dbKillCursors = 2007
+        dbKillCursors = 2007,
+        opCompressed = 2012, /* another message, compressed. see message_compressor.h */
     };
 
     bool doesOpGetAResponse( int op );
@@ -79,6 +80,7 @@ namespace mongo {
         case dbGetMore: return "getmore";
         case dbDelete: return "remove";
         case dbKillCursors: return "killcursors";
+        case opCompressed: return "compressed";
         default:
             massert( 16141, str::stream() << "cannot translate opcode " << op, !op );
             return "";
@@ -94,6 +96,7 @@ namespace mongo {
         case dbQuery:
         case dbGetMore:
         case dbKillCursors:
+        case opCompressed:
             return false;
 
         case dbUpdate:
@@ -0,0 +1,343 @@
+/*    Copyright 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/net/message_compressor.h"
+
+#include <algorithm>
+#include <snappy.h>
+#include <vector>
+#include <zlib.h>
+
+#include "mongo/base/data_view.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/allocator.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/sharded_counter.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/net/message_port.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+
+    using std::string;
+    using std::vector;
+
+    // Comma separated compressors this process offers and accepts on its connections, in order
+    // of preference: "snappy" and/or "zlib".  Unknown names are ignored.  Empty leaves every
+    // connection uncompressed.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(networkMessageCompressors, std::string, "");
+
+    namespace {
+
+        // Between the standard header and the compressed body an opCompressed message holds the
+        // original opcode (int32), the uncompressed body length (int32) and the compressor id
+        // (uint8).
+        const int kCompressedPrefixBytes = 4 + 4 + 1;
+
+        ShardedCounter messagesCompressed;
+        ShardedCounter bytesOutUncompressed;
+        ShardedCounter bytesOutCompressed;
+        ShardedCounter messagesDecompressed;
+        ShardedCounter bytesInCompressed;
+        ShardedCounter bytesInUncompressed;
+
+        MessageCompressorId compressorFromName(StringData name) {
+            if (name == "snappy")
+                return kMessageCompressorSnappy;
+            if (name == "zlib")
+                return kMessageCompressorZlib;
+            return kMessageCompressorNone;
+        }
+
+        const char* compressorName(MessageCompressorId compressor) {
+            switch (compressor) {
+            case kMessageCompressorSnappy:
+                return "snappy";
+            case kMessageCompressorZlib:
+                return "zlib";
+            default:
+                return "none";
+            }
+        }
+
+        /**
+         * The compressors networkMessageCompressors allows, in order of preference.
+         */
+        vector<MessageCompressorId> allowedCompressors() {
+            vector<MessageCompressorId> allowed;
+            const string& names = networkMessageCompressors;
+            size_t start = 0;
+            while (start <= names.size()) {
+                size_t end = names.find(',', start);
+                if (string::npos == end)
+                    end = names.size();
+                MessageCompressorId compressor =
+                    compressorFromName(StringData(names).substr(start, end - start));
+                if (kMessageCompressorNone != compressor
+                        && allowed.end() == std::find(allowed.begin(), allowed.end(), compressor))
+                    allowed.push_back(compressor);
+                start = end + 1;
+            }
+            return allowed;
+        }
+
+        // The bundled zlib leaves out compress.c and uncompr.c, so these are the equivalents of
+        // compressBound(), compress() and uncompress() on top of the streaming interface.
+
+        size_t zlibMaxCompressedLength(size_t inputLen) {
+            return inputLen + (inputLen >> 12) + (inputLen >> 14) + (inputLen >> 25) + 13;
+        }
+
+        /**
+         * Deflates 'input' into 'output', which has room for *outputLen bytes, at least
+         * zlibMaxCompressedLength(inputLen).  Sets *outputLen to the compressed length.
+         */
+        bool zlibCompress(const char* input, size_t inputLen, char* output, size_t* outputLen) {
+            z_stream stream;
+            memset(&stream, 0, sizeof(stream));
+            if (Z_OK != ::deflateInit(&stream, Z_DEFAULT_COMPRESSION))
+                return false;
+
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input));
+            stream.avail_in = inputLen;
+            stream.next_out = reinterpret_cast<Bytef*>(output);
+            stream.avail_out = *outputLen;
+            const int ret = ::deflate(&stream, Z_FINISH);
+            *outputLen = stream.total_out;
+            ::deflateEnd(&stream);
+            return Z_STREAM_END == ret;
+        }
+
+        /**
+         * Inflates 'input' into 'output', succeeding only if it produces exactly 'outputLen'
+         * bytes.
+         */
+        bool zlibUncompress(const char* input, size_t inputLen, char* output, size_t outputLen) {
+            z_stream stream;
+            memset(&stream, 0, sizeof(stream));
+            if (Z_OK != ::inflateInit(&stream))
+                return false;
+
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input));
+            stream.avail_in = inputLen;
+            stream.next_out = reinterpret_cast<Bytef*>(output);
+            stream.avail_out = outputLen;
+            const int ret = ::inflate(&stream, Z_FINISH);
+            const bool ok = Z_STREAM_END == ret && stream.total_out == outputLen;
+            ::inflateEnd(&stream);
+            return ok;
+        }
+
+        bool isAllowed(MessageCompressorId compressor) {
+            vector<MessageCompressorId> allowed = allowedCompressors();
+            return allowed.end() != std::find(allowed.begin(), allowed.end(), compressor);
+        }
+
+    }  // namespace
+
+    bool compressMessage(MessageCompressorId compressor, const Message& in, Message* out) {
+        invariant(out->empty());
+
+        MsgData::ConstView inView = in.singleData();
+        const char* body = inView.data();
+        const size_t bodyLen = inView.dataLen();
+        if (bodyLen < static_cast<size_t>(kMinMessageBytesToCompress))
+            return false;
+
+        size_t maxCompressedLen;
+        switch (compressor) {
+        case kMessageCompressorSnappy:
+            maxCompressedLen = snappy::MaxCompressedLength(bodyLen);
+            break;
+        case kMessageCompressorZlib:
+            maxCompressedLen = zlibMaxCompressedLength(bodyLen);
+            break;
+        default:
+            return false;
+        }
+
+        const size_t prefixLen = MsgData::MsgDataHeaderSize + kCompressedPrefixBytes;
+        char* buf = static_cast<char*>(mongoMalloc(prefixLen + maxCompressedLen));
+        ScopeGuard guard = MakeGuard(free, buf);
+
+        size_t compressedLen = maxCompressedLen;
+        if (kMessageCompressorSnappy == compressor) {
+            snappy::RawCompress(body, bodyLen, buf + prefixLen, &compressedLen);
+        }
+        else {
+            if (!zlibCompress(body, bodyLen, buf + prefixLen, &compressedLen))
+                return false;
+        }
+
+        if (compressedLen + kCompressedPrefixBytes >= bodyLen)
+            return false;
+
+        MsgData::View outView(buf);
+        outView.setLen(prefixLen + compressedLen);
+        outView.setId(inView.getId());
+        outView.setResponseTo(inView.getResponseTo());
+        outView.setOperation(opCompressed);
+        DataView(outView.data())
+            .writeLE<int32_t>(inView.getOperation(), 0)
+            .writeLE<int32_t>(bodyLen, 4)
+            .writeLE<uint8_t>(compressor, 8);
+
+        guard.Dismiss();
+        out->setData(buf, true);
+
+        messagesCompressed.increment();
+        bytesOutUncompressed.add(bodyLen);
+        bytesOutCompressed.add(compressedLen + kCompressedPrefixBytes);
+        return true;
+    }
+
+    void decompressMessage(Message* message) {
+        MsgData::ConstView view = message->singleData();
+        invariant(opCompressed == view.getOperation());
+        uassert(28606, "compressed message is too short",
+                view.dataLen() >= kCompressedPrefixBytes);
+
+        ConstDataView prefix(view.data());
+        const int32_t originalOperation = prefix.readLE<int32_t>(0);
+        const int32_t bodyLen = prefix.readLE<int32_t>(4);
+        const uint8_t compressor = prefix.readLE<uint8_t>(8);
+        uassert(28607,
+                str::stream() << "invalid uncompressed message length " << bodyLen,
+                bodyLen >= 0 && static_cast<size_t>(bodyLen) + MsgData::MsgDataHeaderSize
+                                    <= MaxMessageSizeBytes);
+
+        const char* compressed = view.data() + kCompressedPrefixBytes;
+        const size_t compressedLen = view.dataLen() - kCompressedPrefixBytes;
+
+        char* buf = static_cast<char*>(mongoMalloc(MsgData::MsgDataHeaderSize + bodyLen));
+        ScopeGuard guard = MakeGuard(free, buf);
+        char* body = buf + MsgData::MsgDataHeaderSize;
+
+        bool ok = false;
+        switch (compressor) {
+        case kMessageCompressorSnappy: {
+            size_t len;
+            ok = snappy::GetUncompressedLength(compressed, compressedLen, &len)
+                && len == static_cast<size_t>(bodyLen)
+                && snappy::RawUncompress(compressed, compressedLen, body);
+            break;
+        }
+        case kMessageCompressorZlib:
+            ok = zlibUncompress(compressed, compressedLen, body, bodyLen);
+            break;
+        default:
+            uasserted(28608, str::stream() << "unknown message compressor " << int(compressor));
+        }
+        uassert(28609, str::stream() << "failed to decompress a " << compressorName(
+                    static_cast<MessageCompressorId>(compressor)) << " message", ok);
+
+        MsgData::View outView(buf);
+        outView.setLen(MsgData::MsgDataHeaderSize + bodyLen);
+        outView.setId(view.getId());
+        outView.setResponseTo(view.getResponseTo());
+        outView.setOperation(originalOperation);
+
+        messagesDecompressed.increment();
+        bytesInCompressed.add(view.dataLen());
+        bytesInUncompressed.add(bodyLen);
+
+        guard.Dismiss();
+        message->reset();
+        message->setData(buf, true);
+    }
+
+    bool hasMessageCompressors() {
+        return !allowedCompressors().empty();
+    }
+
+    void appendMessageCompressors(BSONObjBuilder* isMasterCmd) {
+        vector<MessageCompressorId> allowed = allowedCompressors();
+        BSONArrayBuilder names(isMasterCmd->subarrayStart("compression"));
+        for (size_t i = 0; i < allowed.size(); i++) {
+            names.append(compressorName(allowed[i]));
+        }
+        names.done();
+    }
+
+    void negotiateMessageCompressor(const BSONObj& isMasterCmd,
+                                    AbstractMessagingPort* port,
+                                    BSONObjBuilder* result) {
+        BSONElement requested = isMasterCmd["compression"];
+        if (Array != requested.type())
+            return;
+
+        BSONArrayBuilder accepted(result->subarrayStart("compression"));
+        BSONObjIterator it(requested.embeddedObject());
+        while (NULL != port && it.more()) {
+            BSONElement name = it.next();
+            if (String != name.type())
+                continue;
+
+            MessageCompressorId compressor = compressorFromName(name.valueStringData());
+            if (kMessageCompressorNone != compressor && isAllowed(compressor)) {
+                port->setMessageCompressor(compressor);
+                accepted.append(compressorName(compressor));
+                break;
+            }
+        }
+        accepted.done();
+    }
+
+    MessageCompressorId getNegotiatedMessageCompressor(const BSONObj& reply) {
+        BSONElement accepted = reply["compression"];
+        if (Array != accepted.type())
+            return kMessageCompressorNone;
+
+        BSONObjIterator it(accepted.embeddedObject());
+        if (!it.more())
+            return kMessageCompressorNone;
+
+        BSONElement name = it.next();
+        if (String != name.type())
+            return kMessageCompressorNone;
+
+        // Only take what was offered.
+        MessageCompressorId compressor = compressorFromName(name.valueStringData());
+        return isAllowed(compressor) ? compressor : kMessageCompressorNone;
+    }
+
+    void appendMessageCompressionStats(BSONObjBuilder* b) {
+        BSONObjBuilder compression(b->subobjStart("compression"));
+        compression.appendNumber("messagesCompressed", messagesCompressed.load());
+        compression.appendNumber("bytesOutUncompressed", bytesOutUncompressed.load());
+        compression.appendNumber("bytesOutCompressed", bytesOutCompressed.load());
+        compression.appendNumber("messagesDecompressed", messagesDecompressed.load());
+        compression.appendNumber("bytesInCompressed", bytesInCompressed.load());
+        compression.appendNumber("bytesInUncompressed", bytesInUncompressed.load());
+        compression.done();
+    }
+
+}  // namespace mongo
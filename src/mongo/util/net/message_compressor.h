@@ -0,0 +1,104 @@
+/*    Copyright 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace mongo {
+
+    class AbstractMessagingPort;
+    class BSONObj;
+    class BSONObjBuilder;
+    class Message;
+
+    /**
+     * The algorithms an opCompressed message body can be compressed with.  The values go on the
+     * wire and must not change.
+     */
+    enum MessageCompressorId {
+        kMessageCompressorNone = 0,
+        kMessageCompressorSnappy = 1,
+        kMessageCompressorZlib = 2,
+    };
+
+    /**
+     * Messages whose body is shorter than this are not worth compressing.
+     */
+    const int kMinMessageBytesToCompress = 512;
+
+    /**
+     * Compresses the single-buffer message 'in' with 'compressor' into an opCompressed message
+     * in 'out', which must be empty.  The id and responseTo of 'in' are carried over.
+     *
+     * Returns false, leaving 'out' empty, if 'in' is too short or does not shrink.
+     */
+    bool compressMessage(MessageCompressorId compressor, const Message& in, Message* out);
+
+    /**
+     * Replaces the single-buffer opCompressed 'message' with the message it holds.  Throws if
+     * the message is corrupt or uses an unknown compressor.
+     */
+    void decompressMessage(Message* message);
+
+    /**
+     * Returns true if the networkMessageCompressors parameter enables any compressor.
+     */
+    bool hasMessageCompressors();
+
+    //
+    // Negotiation.  A client that wants compression lists the compressors it allows, in order of
+    // preference, in the "compression" array of an isMaster command.  The server picks the first
+    // one it allows too, starts compressing what it sends on that connection and names it in the
+    // "compression" array of the reply, which the client then uses as well.  Either side always
+    // decompresses what it receives.
+    //
+
+    /**
+     * Client side: appends the compressors this process allows to an isMaster command.
+     */
+    void appendMessageCompressors(BSONObjBuilder* isMasterCmd);
+
+    /**
+     * Server side: handles the "compression" field of 'isMasterCmd', received on 'port', which
+     * may be NULL for a direct client.  Does nothing if the field is absent.
+     */
+    void negotiateMessageCompressor(const BSONObj& isMasterCmd,
+                                    AbstractMessagingPort* port,
+                                    BSONObjBuilder* result);
+
+    /**
+     * Client side: returns the compressor the server picked in its isMaster 'reply'.
+     */
+    MessageCompressorId getNegotiatedMessageCompressor(const BSONObj& reply);
+
+    /**
+     * Appends the "compression" section of the serverStatus network counters.
+     */
+    void appendMessageCompressionStats(BSONObjBuilder* b);
+
+}  // namespace mongo
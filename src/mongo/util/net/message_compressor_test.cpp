@@ -0,0 +1,139 @@
+/*    Copyright 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <string>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/net/message_compressor.h"
+
+namespace mongo {
+
+    extern std::string networkMessageCompressors;
+
+namespace {
+
+    /**
+     * Builds a single-buffer message with 'body' repeated 'copies' times.
+     */
+    void buildMessage(Message* message, int operation, const std::string& body, int copies) {
+        BufBuilder b;
+        b.skip(MsgData::MsgDataHeaderSize);
+        for (int i = 0; i < copies; i++) {
+            b.appendStr(body, false);
+        }
+        MsgData::View md = b.buf();
+        md.setLen(b.len());
+        md.setId(1234);
+        md.setResponseTo(5678);
+        md.setOperation(operation);
+        b.decouple();
+        message->setData(md.view2ptr(), true);
+    }
+
+    void assertRoundTrip(MessageCompressorId compressor) {
+        Message original;
+        buildMessage(&original, dbQuery, "compressible ", 1000);
+
+        Message compressed;
+        ASSERT_TRUE(compressMessage(compressor, original, &compressed));
+        ASSERT_EQUALS(opCompressed, compressed.operation());
+        ASSERT_EQUALS(1234, compressed.header().getId());
+        ASSERT_EQUALS(5678, compressed.header().getResponseTo());
+        ASSERT_LESS_THAN(compressed.size(), original.size());
+
+        decompressMessage(&compressed);
+        ASSERT_EQUALS(dbQuery, compressed.operation());
+        ASSERT_EQUALS(1234, compressed.header().getId());
+        ASSERT_EQUALS(5678, compressed.header().getResponseTo());
+        ASSERT_EQUALS(original.size(), compressed.size());
+        ASSERT_EQUALS(0, memcmp(original.singleData().data(),
+                                compressed.singleData().data(),
+                                original.dataSize()));
+    }
+
+    TEST(MessageCompressor, SnappyRoundTrip) {
+        assertRoundTrip(kMessageCompressorSnappy);
+    }
+
+    TEST(MessageCompressor, ZlibRoundTrip) {
+        assertRoundTrip(kMessageCompressorZlib);
+    }
+
+    TEST(MessageCompressor, SmallMessageNotCompressed) {
+        Message original;
+        buildMessage(&original, dbQuery, "x", 10);
+
+        Message compressed;
+        ASSERT_FALSE(compressMessage(kMessageCompressorSnappy, original, &compressed));
+        ASSERT_TRUE(compressed.empty());
+    }
+
+    TEST(MessageCompressor, CorruptMessageRejected) {
+        Message original;
+        buildMessage(&original, dbQuery, "compressible ", 1000);
+
+        Message compressed;
+        ASSERT_TRUE(compressMessage(kMessageCompressorZlib, original, &compressed));
+
+        // Claim a longer body than the compressed data holds.
+        DataView(compressed.singleData().data()).writeLE<int32_t>(original.dataSize() + 1, 4);
+        ASSERT_THROWS(decompressMessage(&compressed), UserException);
+    }
+
+    TEST(MessageCompressor, Negotiation) {
+        networkMessageCompressors = "";
+        ASSERT_FALSE(hasMessageCompressors());
+
+        networkMessageCompressors = "bogus,zlib,snappy";
+        ASSERT_TRUE(hasMessageCompressors());
+
+        BSONObjBuilder isMasterCmd;
+        appendMessageCompressors(&isMasterCmd);
+        ASSERT_EQUALS(BSON("compression" << BSON_ARRAY("zlib" << "snappy")), isMasterCmd.obj());
+
+        // A server that only has snappy answers with it, and the client accepts.
+        ASSERT_EQUALS(kMessageCompressorSnappy, getNegotiatedMessageCompressor(
+                          BSON("ok" << 1 << "compression" << BSON_ARRAY("snappy"))));
+
+        // An old server leaves the field out, and a server allowing nothing answers [].
+        ASSERT_EQUALS(kMessageCompressorNone, getNegotiatedMessageCompressor(BSON("ok" << 1)));
+        ASSERT_EQUALS(kMessageCompressorNone, getNegotiatedMessageCompressor(
+                          BSON("ok" << 1 << "compression" << BSONArray())));
+
+        networkMessageCompressors = "snappy";
+        ASSERT_EQUALS(kMessageCompressorNone, getNegotiatedMessageCompressor(
+                          BSON("ok" << 1 << "compression" << BSON_ARRAY("zlib"))));
+
+        networkMessageCompressors = "";
+    }
+
+}  // namespace
+}  // namespace mongo
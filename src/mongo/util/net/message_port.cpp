@@ -240,6 +240,17 @@ again:
 
             guard.Dismiss();
             m.setData(md.view2ptr(), true);
+
+            if (opCompressed == m.operation()) {
+                try {
+                    decompressMessage(&m);
+                }
+                catch (const DBException& e) {
+                    LOG(0) << "recv(): " << e.what() << ' ' << psock->remoteString();
+                    m.reset();
+                    return false;
+                }
+            }
             return true;
 
         }
@@ -312,6 +323,16 @@ again:
             }
         }
 
+        if (kMessageCompressorNone != getMessageCompressor()
+                && toSend.dataSize() >= kMinMessageBytesToCompress) {
+            toSend.concat();
+            Message compressed;
+            if (compressMessage(getMessageCompressor(), toSend, &compressed)) {
+                compressed.send( *this, "say" );
+                return;
+            }
+        }
+
         toSend.send( *this, "say" );
     }
 
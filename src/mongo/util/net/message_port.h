@@ -32,6 +32,7 @@
 #include <vector>
 
 #include "mongo/util/net/message.h"
+#include "mongo/util/net/message_compressor.h"
 #include "mongo/util/net/sock.h"
 
 namespace mongo {
@@ -41,7 +42,8 @@ namespace mongo {
 
     class AbstractMessagingPort : boost::noncopyable {
     public:
-        AbstractMessagingPort() : tag(0), _connectionId(0) {}
+        AbstractMessagingPort()
+            : tag(0), _connectionId(0), _compressor(kMessageCompressorNone) {}
         virtual ~AbstractMessagingPort() { }
         virtual void reply(Message& received, Message& response, MSGID responseTo) = 0; // like the reply below, but doesn't rely on received.data still being available
         virtual void reply(Message& received, Message& response) = 0;
@@ -62,6 +64,13 @@ namespace mongo {
         long long connectionId() const { return _connectionId; }
         void setConnectionId( long long connectionId );
 
+        /**
+         * The compressor negotiated for messages sent on this port, see message_compressor.h.
+         * Received messages are decompressed whatever this is set to.
+         */
+        MessageCompressorId getMessageCompressor() const { return _compressor; }
+        void setMessageCompressor(MessageCompressorId compressor) { _compressor = compressor; }
+
     public:
         // TODO make this private with some helpers
 
@@ -71,6 +80,7 @@ namespace mongo {
     private:
         long long _connectionId;
         std::string _x509SubjectName;
+        MessageCompressorId _compressor;
     };
 
     class MessagingPort : public AbstractMessagingPort {
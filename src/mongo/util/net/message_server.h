@@ -59,8 +59,74 @@ namespace mongo {
          * called once when a socket is disconnected
          */
         virtual void disconnected( AbstractMessagingPort* p ) = 0;
+
+        /**
+         * Returns true if the per-connection state this handler keeps in thread-local storage
+         * can be moved between threads with suspendConnection() and resumeConnection(). Only
+         * such handlers can be served by the event-driven connection executor, which runs many
+         * connections over a small pool of worker threads.
+         */
+        virtual bool supportsConnectionHandoff() const { return false; }
+
+        /**
+         * Detaches the state for connection "p" from the calling thread and returns it as an
+         * opaque handle. Called after connected() or process() when the worker is done with
+         * the connection for now.
+         */
+        virtual void* suspendConnection( AbstractMessagingPort* p ) { return NULL; }
+
+        /**
+         * Installs state previously returned by suspendConnection() on the calling thread.
+         */
+        virtual void resumeConnection( AbstractMessagingPort* p, void* state ) {}
+
+        /**
+         * Frees state returned by suspendConnection() after disconnected() has been called.
+         */
+        virtual void destroyConnection( void* state ) {}
+
+        /**
+         * Returns detached state for running request "m" from connection "p" on another thread,
+         * at the same time as the connection's other requests, or NULL if "m" has to be run in
+         * order.  Called with the connection's state installed.  The result is installed with
+         * resumeConnection(), and freed with disconnected() and destroyConnection() once "m"
+         * has been processed.
+         */
+        virtual void* forkConnection( AbstractMessagingPort* p, const Message& m ) { return NULL; }
     };
 
+    /**
+     * A request which its MessageHandler finishes after process() has returned, from whichever
+     * thread it likes, so that no thread is held while the request waits on something else.
+     * See deferCurrentRequest().
+     */
+    class DeferredRequest {
+    public:
+        virtual ~DeferredRequest() {}
+
+        /**
+         * The port to reply to the request through. It may be used from any thread until
+         * finish() is called.
+         */
+        virtual AbstractMessagingPort* port() = 0;
+
+        /**
+         * Marks the request as done, after its reply has been sent or the request has failed.
+         * Must be called exactly once, and frees this object.
+         */
+        virtual void finish() = 0;
+    };
+
+    /**
+     * Called from MessageHandler::process(). Returns a handle for finishing the request being
+     * processed later, or NULL if the server running it can't do that. Once it has returned a
+     * handle, process() must not reply to the request itself. The connection's next request
+     * is not processed until finish() has been called, so requests keep their order.
+     *
+     * Only the event-driven executor defers requests.
+     */
+    DeferredRequest* deferCurrentRequest();
+
     class MessageServer {
     public:
         struct Options {
@@ -70,12 +136,26 @@ namespace mongo {
             Options() : port(0), ipList("") {}
         };
 
+        /** Names accepted by the connectionExecutor server parameter. */
+        static const char kThreadPerConnection[];
+        static const char kEventDriven[];
+
         virtual ~MessageServer() {}
         virtual void run() = 0;
         virtual void setAsTimeTracker() = 0;
         virtual void setupSockets() = 0;
     };
 
-    // TODO use a factory here to decide between port and asio variations
+    /**
+     * Creates the server for "handler". Uses the thread-per-connection server unless the
+     * connectionExecutor server parameter selects the event-driven executor and it is supported.
+     */
     MessageServer * createServer( const MessageServer::Options& opts , MessageHandler * handler );
+
+    /**
+     * Returns the event-driven server if the connectionExecutor server parameter asks for it and
+     * it can be used with "handler" on this platform, otherwise NULL.
+     */
+    MessageServer * createEventMessageServer( const MessageServer::Options& opts,
+                                              MessageHandler * handler );
 }
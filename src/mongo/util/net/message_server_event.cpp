@@ -0,0 +1,663 @@
+// message_server_event.cpp
+
+/*    Copyright 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+/**
+ * Event-driven connection executor.
+ *
+ * Instead of dedicating a thread to each accepted socket, idle connections are parked in an
+ * epoll set owned by a single reactor thread.  When a socket becomes readable the reactor hands
+ * the connection to a bounded pool of worker threads, which read and process the pending
+ * requests and then re-arm the socket.  An idle connection therefore costs a file descriptor
+ * and a small bookkeeping structure rather than a thread and its stack.
+ *
+ * The message handler must be able to move its thread-local connection state between threads
+ * (see MessageHandler::supportsConnectionHandoff).  Operations that block for a long time
+ * (e.g. awaitData getMores or fsyncLock) hold a worker while they run, so the pool should be
+ * sized for the expected number of concurrently *active* operations.
+ *
+ * A request which the handler can fork off (see MessageHandler::forkConnection, mongod does so
+ * for queries flagged QueryOption_Pipelined) is run by a second pool while the worker goes on
+ * reading the connection, so one socket can carry several requests at once and their replies
+ * go out as they finish.  Any other request waits for those in flight, which keeps the order
+ * of a client's unflagged requests as it was.
+ *
+ * A handler may also defer a request (see deferCurrentRequest()) and finish it from another
+ * thread once whatever it waits on is ready; mongos does so while it waits for a shard's reply.
+ * A deferred request counts as running out of order until it finishes, so the worker is free to
+ * serve other connections in the meantime.
+ *
+ * With NUMA placement enabled (see NumaPlacement) both pools are split per node, their threads
+ * bound to the node, and each connection is given a node on accept and served by its pools only,
+ * so a connection's buffers and operation state stay in one node's memory.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kNetwork
+
+#include "mongo/pch.h"
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp>
+
+#ifdef __linux__
+# include <sys/epoll.h>
+# include <sys/socket.h>
+#endif
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "mongo/base/owned_pointer_vector.h"
+#include "mongo/db/lasterror.h"
+#include "mongo/db/server_options.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/stats/counters.h"
+#include "mongo/stdx/functional.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/concurrency/threadlocal.h"
+#include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+#include "mongo/util/net/listen.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/net/message_port.h"
+#include "mongo/util/net/message_server.h"
+#include "mongo/util/net/socket_poll.h"
+#include "mongo/util/net/ssl_options.h"
+#include "mongo/util/numa.h"
+#include "mongo/util/processinfo.h"
+
+namespace mongo {
+
+    const char MessageServer::kThreadPerConnection[] = "threadPerConnection";
+    const char MessageServer::kEventDriven[] = "eventDriven";
+
+namespace {
+
+    std::string connectionExecutor = MessageServer::kThreadPerConnection;
+
+    class ExportedConnectionExecutorParameter : public ExportedServerParameter<std::string> {
+    public:
+        ExportedConnectionExecutorParameter() :
+            ExportedServerParameter<std::string>(ServerParameterSet::getGlobal(),
+                                                 "connectionExecutor",
+                                                 &connectionExecutor,
+                                                 true,
+                                                 false) {}
+
+        virtual Status validate( const std::string& potentialNewValue ) {
+            if (potentialNewValue != MessageServer::kThreadPerConnection &&
+                potentialNewValue != MessageServer::kEventDriven) {
+                return Status(ErrorCodes::BadValue,
+                              str::stream() << "connectionExecutor must be either '"
+                                            << MessageServer::kThreadPerConnection << "' or '"
+                                            << MessageServer::kEventDriven << "'");
+            }
+            return Status::OK();
+        }
+    } exportedConnectionExecutorParam;
+
+    // Number of worker threads used by the event-driven executor. 0 means four per core.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(connectionExecutorWorkerThreads, int, 0);
+
+    // How many requests from one connection the event-driven executor runs at once, out of
+    // order. 0 runs every request in order.
+    MONGO_EXPORT_SERVER_PARAMETER(connectionExecutorMaxPipelinedRequests, int, 8);
+
+    /**
+     * Lets deferCurrentRequest() defer the request the current thread is processing.
+     */
+    class RequestDeferral {
+    public:
+        virtual ~RequestDeferral() {}
+        virtual DeferredRequest* defer() = 0;
+    };
+
+    // Set while a request which may be deferred is being processed.
+    ThreadLocalValue<RequestDeferral*> currentDeferral;
+
+#ifdef __linux__
+
+    // Upper bound on the number of pipelined requests a worker serves from one connection
+    // before handing the socket back to the reactor, so that a busy client cannot starve others.
+    const int kMaxRequestsPerDispatch = 16;
+
+    const char kWorkerThreadName[] = "connWorker";
+    const char kPipelineWorkerThreadName[] = "connPipelineWorker";
+
+    class EventMessageServer : public MessageServer , public Listener {
+    public:
+        /**
+         * @param handler the handler to use. Caller is responsible for managing this object
+         *     and should make sure that it lives longer than this server.
+         */
+        EventMessageServer( const MessageServer::Options& opts,
+                            MessageHandler* handler,
+                            int numWorkers ) :
+            Listener( "" , opts.ipList, opts.port ),
+            _handler( handler ),
+            _epollFD( -1 ),
+            _numWorkers( numWorkers ),
+            _numNodes( NumaPlacement::enabled() ? NumaPlacement::nodeCount() : 1 ),
+            _nextNode( 0 ) {
+            const int perNode = std::max( 1, numWorkers / _numNodes );
+            for ( int node = 0; node < _numNodes; node++ ) {
+                _workers.push_back( new ThreadPool( ThreadPool::DoNotStartThreadsTag(),
+                                                    perNode,
+                                                    kWorkerThreadName ) );
+                _pipelineWorkers.push_back( new ThreadPool( ThreadPool::DoNotStartThreadsTag(),
+                                                            perNode,
+                                                            kPipelineWorkerThreadName ) );
+            }
+        }
+
+        virtual void acceptedMP( MessagingPort* p ) {
+            if ( ! Listener::globalTicketHolder.tryAcquire() ) {
+                log() << "connection refused because too many open connections: "
+                      << Listener::globalTicketHolder.used() << endl;
+
+                p->shutdown();
+                delete p;
+
+                sleepmillis(2); // otherwise we'll hard loop
+                return;
+            }
+
+            p->psock->setLogLevel(logger::LogSeverity::Debug(1));
+
+            // Only the listener thread accepts, so the nodes can simply take turns.
+            Connection* conn = new Connection( p, _nextNode );
+            _nextNode = ( _nextNode + 1 ) % _numNodes;
+
+            // The first dispatch runs MessageHandler::connected() on a worker; the socket is only
+            // added to the epoll set once that is done.
+            _workers[conn->node]->schedule( &EventMessageServer::_serviceConnection, this, conn );
+        }
+
+        virtual void setAsTimeTracker() {
+            Listener::setAsTimeTracker();
+        }
+
+        virtual void setupSockets() {
+            Listener::setupSockets();
+        }
+
+        void run() {
+            _epollFD = epoll_create(1024);
+            massert(28601,
+                    str::stream() << "epoll_create failed: " << errnoWithDescription(),
+                    _epollFD >= 0);
+
+            log() << "using event-driven connection executor with "
+                  << _numWorkers << " worker threads" << endl;
+            if ( _numNodes > 1 ) {
+                log() << "binding connection worker threads to " << _numNodes << " NUMA nodes"
+                      << endl;
+            }
+
+            for ( int node = 0; node < _numNodes; node++ ) {
+                _workers[node]->startThreads();
+                _pipelineWorkers[node]->startThreads();
+            }
+            boost::thread reactor( stdx::bind( &EventMessageServer::_reactorLoop, this ) );
+
+            initAndListen();
+        }
+
+        virtual bool useUnixSockets() const { return true; }
+
+    private:
+        /**
+         * Bookkeeping for one client connection.  At any time it is owned either by the epoll
+         * set (armed, waiting for input) or by exactly one worker thread.
+         */
+        struct Connection {
+            Connection( MessagingPort* inPort, int inNode ) :
+                port( inPort ),
+                node( inNode ),
+                le( new LastError() ),
+                state( NULL ),
+                connected( false ),
+                registered( false ),
+                inFlight( 0 ) {
+                threadName = "conn";
+                if ( inPort->connectionId() > 0 )
+                    threadName = str::stream() << threadName << inPort->connectionId();
+            }
+
+            boost::scoped_ptr<MessagingPort> port;
+            const int node;         // NUMA node whose workers serve this connection
+            boost::scoped_ptr<LastError> le;
+            void* state;            // handler state while suspended
+            bool connected;         // MessageHandler::connected() has run
+            bool registered;        // socket has been added to the epoll set
+            std::string threadName;
+            std::string otherSide;
+
+            // Serializes the replies of requests running out of order.
+            boost::mutex sendMutex;
+
+            // Number of requests running out of order, guarded by pipelineMutex.
+            boost::mutex pipelineMutex;
+            boost::condition_variable pipelineDone;
+            int inFlight;
+        };
+
+        /**
+         * The port a request running out of order replies through.  Several of them may reply at
+         * once, and the worker reading the connection may be using it at the same time, so this
+         * only lets them send one at a time.
+         */
+        class PipelinedPort : public AbstractMessagingPort {
+        public:
+            explicit PipelinedPort( Connection* conn ) : _conn( conn ) {
+                MessagingPort* p = conn->port.get();
+                tag = p->tag;
+                setConnectionId( p->connectionId() );
+                setX509SubjectName( p->getX509SubjectName() );
+                setMessageCompressor( p->getMessageCompressor() );
+            }
+
+            virtual void reply( Message& received, Message& response, MSGID responseTo ) {
+                boost::mutex::scoped_lock lk( _conn->sendMutex );
+                _conn->port->reply( received, response, responseTo );
+            }
+
+            virtual void reply( Message& received, Message& response ) {
+                boost::mutex::scoped_lock lk( _conn->sendMutex );
+                _conn->port->reply( received, response );
+            }
+
+            virtual HostAndPort remote() const { return _conn->port->remote(); }
+            virtual unsigned remotePort() const { return _conn->port->remotePort(); }
+            virtual SockAddr remoteAddr() const { return _conn->port->remoteAddr(); }
+            virtual SockAddr localAddr() const { return _conn->port->localAddr(); }
+
+        private:
+            Connection* const _conn;
+        };
+
+        /**
+         * A request of a connection which is finished after MessageHandler::process() returned.
+         * Until then it counts as a request running out of order, which holds back the
+         * connection's next request and keeps the connection open.
+         */
+        class ConnectionDeferredRequest : public DeferredRequest {
+        public:
+            explicit ConnectionDeferredRequest( Connection* conn ) : _conn( conn ), _port( conn ) {}
+
+            virtual AbstractMessagingPort* port() { return &_port; }
+
+            virtual void finish() {
+                Connection* conn = _conn;
+                delete this;
+
+                // Once inFlight drops the connection may be closed and freed at any moment.
+                boost::mutex::scoped_lock lk( conn->pipelineMutex );
+                conn->inFlight--;
+                conn->pipelineDone.notify_all();
+            }
+
+        private:
+            Connection* const _conn;
+            PipelinedPort _port;
+        };
+
+        /**
+         * Lets the request processed for "conn" on this thread be deferred, once, for as long as
+         * it is in scope.
+         */
+        class ConnectionRequestDeferral : public RequestDeferral {
+        public:
+            explicit ConnectionRequestDeferral( Connection* conn ) :
+                _conn( conn ), _deferred( false ) {
+                currentDeferral.set( this );
+            }
+
+            virtual ~ConnectionRequestDeferral() {
+                currentDeferral.set( NULL );
+            }
+
+            virtual DeferredRequest* defer() {
+                if ( _deferred )
+                    return NULL;
+                _deferred = true;
+
+                boost::mutex::scoped_lock lk( _conn->pipelineMutex );
+                _conn->inFlight++;
+                return new ConnectionDeferredRequest( _conn );
+            }
+
+        private:
+            Connection* const _conn;
+            bool _deferred;
+        };
+
+        void _reactorLoop() {
+            setThreadName( "connReactor" );
+
+            const int kMaxEvents = 256;
+            epoll_event events[kMaxEvents];
+
+            while ( ! inShutdown() ) {
+                int n = epoll_wait( _epollFD, events, kMaxEvents, 1000 );
+                if ( n < 0 ) {
+                    if ( errno == EINTR )
+                        continue;
+                    error() << "epoll_wait failed: " << errnoWithDescription() << endl;
+                    sleepmillis(10);
+                    continue;
+                }
+
+                for ( int i = 0; i < n; i++ ) {
+                    // EPOLLONESHOT disarmed the socket; it now belongs to the worker.
+                    Connection* conn = static_cast<Connection*>( events[i].data.ptr );
+                    _workers[conn->node]->schedule( &EventMessageServer::_serviceConnection,
+                                                    this,
+                                                    conn );
+                }
+            }
+        }
+
+        /**
+         * Hands the connection back to the reactor. Once this returns true another worker may
+         * already own "conn", so the caller must not touch it again.
+         */
+        bool _arm( Connection* conn ) {
+            epoll_event ev;
+            memset( &ev, 0, sizeof(ev) );
+            ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+            ev.data.ptr = conn;
+
+            int op = conn->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+            conn->registered = true;
+            if ( epoll_ctl( _epollFD, op, conn->port->psock->rawFD(), &ev ) != 0 ) {
+                conn->registered = ( op == EPOLL_CTL_MOD );
+                log() << "epoll_ctl failed, closing client connection: "
+                      << errnoWithDescription() << endl;
+                return false;
+            }
+            return true;
+        }
+
+        /** Returns true if a request can be read from "p" without blocking on the reactor. */
+        static bool _hasPendingInput( MessagingPort* p ) {
+            pollfd pfd;
+            pfd.fd = p->psock->rawFD();
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            return socketPoll( &pfd, 1, 0 ) > 0 && ( pfd.revents & POLLIN );
+        }
+
+        /**
+         * Serves requests from "conn" until no more input is immediately available, then
+         * suspends the handler state and re-arms the socket, or tears the connection down.
+         *
+         * Mirrors the per-request loop and error handling of the thread-per-connection server.
+         */
+        void _serviceConnection( Connection* conn ) {
+            NumaPlacement::ensureThisThreadOn( conn->node );
+            setThreadName( conn->threadName.c_str() );
+
+            MessagingPort* p = conn->port.get();
+            lastError.reset( conn->le.get() );
+
+            bool keepOpen = true;
+            Message m;
+            try {
+                if ( ! conn->connected ) {
+                    conn->otherSide = p->psock->remoteString();
+                    conn->connected = true;
+                    _handler->connected( p );
+                }
+                else {
+                    _handler->resumeConnection( p, conn->state );
+                    conn->state = NULL;
+                }
+
+                for ( int i = 0; i < kMaxRequestsPerDispatch; i++ ) {
+                    if ( inShutdown() ) {
+                        keepOpen = false;
+                        break;
+                    }
+
+                    m.reset();
+                    p->psock->clearCounters();
+
+                    if ( ! p->recv(m) ) {
+                        if (!serverGlobalParams.quiet) {
+                            int conns = Listener::globalTicketHolder.used()-1;
+                            const char* word = (conns == 1 ? " connection" : " connections");
+                            log() << "end connection " << conn->otherSide
+                                  << " (" << conns << word << " now open)" << endl;
+                        }
+                        p->shutdown();
+                        keepOpen = false;
+                        break;
+                    }
+
+                    if ( ! _dispatchPipelined( conn, m ) ) {
+                        _waitForPipelined( conn, 0 );
+                        ConnectionRequestDeferral deferral( conn );
+                        _handler->process( m , p , conn->le.get() );
+                    }
+                    networkCounter.hit( p->psock->getBytesIn() , p->psock->getBytesOut() );
+
+                    if ( ! _hasPendingInput( p ) )
+                        break;
+                }
+            }
+            catch ( AssertionException& e ) {
+                log() << "AssertionException handling request, closing client connection: " << e << endl;
+                p->shutdown();
+                keepOpen = false;
+            }
+            catch ( SocketException& e ) {
+                log() << "SocketException handling request, closing client connection: " << e << endl;
+                p->shutdown();
+                keepOpen = false;
+            }
+            catch ( const DBException& e ) { // must be right above std::exception to avoid catching subclasses
+                log() << "DBException handling request, closing client connection: " << e << endl;
+                p->shutdown();
+                keepOpen = false;
+            }
+            catch ( std::exception &e ) {
+                error() << "Uncaught std::exception: " << e.what() << ", terminating" << endl;
+                dbexit( EXIT_UNCAUGHT );
+            }
+
+            if ( keepOpen ) {
+                conn->state = _handler->suspendConnection( p );
+                lastError.release();
+                setThreadName( kWorkerThreadName );
+
+                if ( _arm( conn ) )
+                    return;
+
+                // Could not hand the socket back; reinstall the state so we can tear down.
+                lastError.reset( conn->le.get() );
+                _handler->resumeConnection( p, conn->state );
+                conn->state = NULL;
+                p->shutdown();
+            }
+
+            _closeConnection( conn );
+            setThreadName( kWorkerThreadName );
+        }
+
+        /**
+         * Hands "m" to a pipeline worker if the handler lets it run out of order, and returns
+         * whether it did.  Waits while the connection already has as many such requests running
+         * as it may.  Called with the handler state installed on the current thread.
+         */
+        bool _dispatchPipelined( Connection* conn, Message& m ) {
+            const int maxInFlight = connectionExecutorMaxPipelinedRequests;
+            if ( maxInFlight <= 0 )
+                return false;
+
+            void* state = _handler->forkConnection( conn->port.get(), m );
+            if ( ! state )
+                return false;
+
+            _waitForPipelined( conn, maxInFlight - 1 );
+            {
+                boost::mutex::scoped_lock lk( conn->pipelineMutex );
+                conn->inFlight++;
+            }
+
+            // The new Message takes the buffer over from "m".
+            _pipelineWorkers[conn->node]->schedule( &EventMessageServer::_servicePipelined,
+                                                    this,
+                                                    conn,
+                                                    new Message( m ),
+                                                    state );
+            return true;
+        }
+
+        /** Waits until no more than "maxInFlight" requests of "conn" run out of order. */
+        static void _waitForPipelined( Connection* conn, int maxInFlight ) {
+            boost::mutex::scoped_lock lk( conn->pipelineMutex );
+            while ( conn->inFlight > maxInFlight )
+                conn->pipelineDone.wait( lk );
+        }
+
+        /**
+         * Runs one request out of order with the state forkConnection() gave for it.  A failure
+         * shuts the socket down, so that the worker reading the connection closes it.
+         */
+        void _servicePipelined( Connection* conn, Message* m, void* state ) {
+            NumaPlacement::ensureThisThreadOn( conn->node );
+            setThreadName( conn->threadName.c_str() );
+
+            boost::scoped_ptr<Message> owned( m );
+            boost::scoped_ptr<LastError> le( new LastError() );
+            lastError.reset( le.get() );
+            _handler->resumeConnection( conn->port.get(), state );
+
+            PipelinedPort port( conn );
+            try {
+                _handler->process( *m , &port , le.get() );
+            }
+            catch ( const DBException& e ) {
+                log() << "DBException handling pipelined request, closing client connection: "
+                      << e << endl;
+                ::shutdown( conn->port->psock->rawFD(), SHUT_RDWR );
+            }
+            catch ( std::exception &e ) {
+                error() << "Uncaught std::exception: " << e.what() << ", terminating" << endl;
+                dbexit( EXIT_UNCAUGHT );
+            }
+
+            _handler->disconnected( conn->port.get() );
+            _handler->destroyConnection( _handler->suspendConnection( conn->port.get() ) );
+            lastError.release();
+            setThreadName( kPipelineWorkerThreadName );
+
+            // Once inFlight drops the connection may be closed and freed at any moment.
+            boost::mutex::scoped_lock lk( conn->pipelineMutex );
+            conn->inFlight--;
+            conn->pipelineDone.notify_all();
+        }
+
+        /** Called with the handler state installed on the current thread. */
+        void _closeConnection( Connection* conn ) {
+            MessagingPort* p = conn->port.get();
+
+            // Requests still running out of order use the port.
+            _waitForPipelined( conn, 0 );
+
+            if ( conn->connected ) {
+                _handler->disconnected( p );
+                _handler->destroyConnection( _handler->suspendConnection( p ) );
+            }
+            lastError.release();
+
+            if ( conn->registered )
+                epoll_ctl( _epollFD, EPOLL_CTL_DEL, p->psock->rawFD(), NULL );
+
+            delete conn;
+            Listener::globalTicketHolder.release();
+        }
+
+        MessageHandler* _handler;
+        int _epollFD;
+        const int _numWorkers;
+        const int _numNodes;
+        int _nextNode;
+
+        // One pool of each per NUMA node, or just one of each without NUMA placement
+        OwnedPointerVector<ThreadPool> _workers;
+        OwnedPointerVector<ThreadPool> _pipelineWorkers;
+    };
+
+#endif // __linux__
+
+} // namespace
+
+    DeferredRequest* deferCurrentRequest() {
+        RequestDeferral* deferral = currentDeferral.get();
+        return deferral ? deferral->defer() : NULL;
+    }
+
+    MessageServer* createEventMessageServer( const MessageServer::Options& opts,
+                                             MessageHandler* handler ) {
+        if ( connectionExecutor != MessageServer::kEventDriven )
+            return NULL;
+
+#ifdef __linux__
+        if ( ! handler->supportsConnectionHandoff() ) {
+            warning() << "connectionExecutor " << connectionExecutor << " is not supported by"
+                      << " this server, using " << MessageServer::kThreadPerConnection << endl;
+            return NULL;
+        }
+
+#ifdef MONGO_SSL
+        if ( sslGlobalParams.sslMode.load() != SSLGlobalParams::SSLMode_disabled ) {
+            // Decrypted data buffered inside the SSL connection is invisible to epoll.
+            warning() << "connectionExecutor " << connectionExecutor << " can not be used"
+                      << " with SSL, using " << MessageServer::kThreadPerConnection << endl;
+            return NULL;
+        }
+#endif
+
+        int numWorkers = connectionExecutorWorkerThreads;
+        if ( numWorkers <= 0 ) {
+            ProcessInfo pi;
+            numWorkers = std::max( 4U, pi.getNumCores() * 4 );
+        }
+        return new EventMessageServer( opts, handler, numWorkers );
+#else
+        warning() << "connectionExecutor " << connectionExecutor << " is only supported on"
+                  << " Linux, using " << MessageServer::kThreadPerConnection << endl;
+        return NULL;
+#endif
+    }
+
+} // namespace mongo
@@ -266,6 +266,9 @@ namespace mongo {
 
 
     MessageServer * createServer( const MessageServer::Options& opts , MessageHandler * handler ) {
+        MessageServer* eventServer = createEventMessageServer( opts , handler );
+        if ( eventServer )
+            return eventServer;
         return new PortMessageServer( opts , handler );
     }
 
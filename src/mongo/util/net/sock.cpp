@@ -629,6 +629,44 @@ namespace mongo {
         }
     }
 
+#ifdef MONGO_SSL
+    void Socket::_sendCoalesced( const vector< pair< char *, int > > &data,
+                                 const char *context ) {
+        // The largest plaintext a TLS record holds.
+        const int kMaxRecordSize = 16 * 1024;
+        char buffer[kMaxRecordSize];
+        int buffered = 0;
+
+        for (vector< pair<char *, int> >::const_iterator i = data.begin();
+             i != data.end();
+             ++i) {
+            if ( buffered + i->second <= kMaxRecordSize ) {
+                memcpy( buffer + buffered, i->first, i->second );
+                buffered += i->second;
+                continue;
+            }
+
+            if ( buffered > 0 ) {
+                send( buffer, buffered, context );
+                buffered = 0;
+            }
+
+            // Buffers too big to gather make full records by themselves.
+            if ( i->second >= kMaxRecordSize ) {
+                send( i->first, i->second, context );
+            }
+            else {
+                memcpy( buffer, i->first, i->second );
+                buffered = i->second;
+            }
+        }
+
+        if ( buffered > 0 ) {
+            send( buffer, buffered, context );
+        }
+    }
+#endif
+
     /** sends all data or throws an exception
      * @param context descriptive for logging
      */
@@ -636,7 +674,7 @@ namespace mongo {
 
 #ifdef MONGO_SSL
         if ( _sslConnection.get() ) {
-            _send( data , context );
+            _sendCoalesced( data , context );
             return;
         }
 #endif
@@ -295,6 +295,15 @@ namespace mongo {
         /** sends dumbly, just each buffer at a time */
         void _send( const std::vector< std::pair< char *, int > > &data, const char *context );
 
+#ifdef MONGO_SSL
+        /**
+         * sends over SSL, copying small buffers together so that each SSL write, which makes
+         * its own records and its own send() of them, carries up to a full record
+         */
+        void _sendCoalesced( const std::vector< std::pair< char *, int > > &data,
+                             const char *context );
+#endif
+
         /** raw send, same semantics as ::send with an additional context parameter */
         int _send( const char * data , int len , const char * context );
 
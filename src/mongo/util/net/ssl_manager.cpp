@@ -32,8 +32,10 @@
 #include "mongo/util/net/ssl_manager.h"
 
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/thread/recursive_mutex.hpp>
 #include <boost/thread/tss.hpp>
+#include <map>
 #include <ostream>
 #include <sstream>
 #include <string>
@@ -41,6 +43,7 @@
 
 #include "mongo/base/init.h"
 #include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/exit.h"
@@ -51,6 +54,7 @@
 #include "mongo/util/net/ssl_expiration.h"
 #include "mongo/util/net/ssl_options.h"
 #include "mongo/util/scopeguard.h"
+#include "mongo/util/timer.h"
 
 #ifdef MONGO_SSL
 #include <openssl/evp.h>
@@ -153,6 +157,17 @@ namespace mongo {
         static const int BUFFER_SIZE = 8*1024;
         static const int DATE_LEN = 128;
 
+        // Sessions this server keeps for clients to resume, and sessions kept of the servers
+        // this process connects to.  0 disables resumption and session tickets.
+        MONGO_EXPORT_STARTUP_SERVER_PARAMETER(sslSessionCacheSize, int, 20 * 1024);
+
+        // How long after its full handshake a session can be resumed.
+        MONGO_EXPORT_STARTUP_SERVER_PARAMETER(sslSessionTimeoutSecs, int, 300);
+
+        // Identifies the sessions of this server's contexts, which OpenSSL requires in order to
+        // resume sessions when peer certificates are verified.
+        const unsigned char sessionIdContext[] = "mongodb";
+
         struct Params {
             Params(const std::string& pemfile,
                    const std::string& pempwd,
@@ -208,6 +223,8 @@ namespace mongo {
 
             virtual std::string getSSLErrorMessage(int code);
 
+            virtual SSLHandshakeStats getHandshakeStats() const;
+
             virtual int SSL_read(SSLConnection* conn, void* buf, int num);
 
             virtual int SSL_write(SSLConnection* conn, const void* buf, int num);
@@ -231,6 +248,30 @@ namespace mongo {
             bool _allowInvalidHostnames;
             SSLConfiguration _sslConfiguration;
 
+            // The session of the last full outgoing handshake with each remote address, each
+            // holding a reference.
+            typedef std::map<std::string, SSL_SESSION*> ClientSessionMap;
+            boost::mutex _clientSessionsMutex;
+            ClientSessionMap _clientSessions;
+
+            AtomicInt64 _handshakesAccepted;
+            AtomicInt64 _handshakesAcceptedResumed;
+            AtomicInt64 _handshakesConnected;
+            AtomicInt64 _handshakesConnectedResumed;
+            AtomicInt64 _handshakesFailed;
+            AtomicInt64 _handshakeMicros;
+
+            /**
+             * Offers the session kept for 'remote', if any, to resume on 'ssl'.
+             */
+            void _resumeClientSession(const std::string& remote, SSL* ssl);
+
+            /**
+             * Keeps the session just negotiated on 'ssl' for later connections to 'remote', or
+             * forgets the one kept if 'ssl' is NULL.
+             */
+            void _saveClientSession(const std::string& remote, SSL* ssl);
+
             /**
              * creates an SSL object to be used for this file descriptor.
              * caller must SSL_free it.
@@ -413,6 +454,17 @@ namespace mongo {
         return security.obj();
     }
 
+    BSONObj SSLHandshakeStats::toBSON() const {
+        BSONObjBuilder b;
+        b.append("accepted", accepted);
+        b.append("acceptedResumed", acceptedResumed);
+        b.append("connected", connected);
+        b.append("connectedResumed", connectedResumed);
+        b.append("failed", failed);
+        b.append("totalMicros", totalMicros);
+        return b.obj();
+    }
+
     SSLManagerInterface::~SSLManagerInterface() {}
 
     SSLManager::SSLManager(const Params& params, bool isServer) :
@@ -491,6 +543,11 @@ namespace mongo {
         if (NULL != _clientContext) {
             SSL_CTX_free(_clientContext);
         }
+        for (ClientSessionMap::const_iterator it = _clientSessions.begin();
+             it != _clientSessions.end();
+             ++it) {
+            SSL_SESSION_free(it->second);
+        }
     }
 
     int SSLManager::password_cb(char *buf,int num, int rwflag,void *userdata) {
@@ -585,18 +642,40 @@ namespace mongo {
         // SSL_OP_NO_SSLv3 - Disable SSL v3 support
         SSL_CTX_set_options(*context, SSL_OP_ALL|SSL_OP_NO_SSLv2|SSL_OP_NO_SSLv3);
 
+        // AESGCM - Prefer AES-GCM ciphers, which run on the AES-NI and carry-less multiply
+        //          instructions of modern CPUs, over others of the same strength
         // HIGH - Enable strong ciphers
         // !EXPORT - Disable export ciphers (40/56 bit) 
         // !aNULL - Disable anonymous auth ciphers
         // @STRENGTH - Sort ciphers based on strength 
-        SSL_CTX_set_cipher_list(*context, "HIGH:!EXPORT:!aNULL@STRENGTH");
+        SSL_CTX_set_cipher_list(*context, "AESGCM:HIGH:!EXPORT:!aNULL@STRENGTH");
+
+        // As a server, pick the cipher by our preference above rather than the client's.
+        if (context == &_serverContext) {
+            SSL_CTX_set_options(*context, SSL_OP_CIPHER_SERVER_PREFERENCE);
+        }
 
         // If renegotiation is needed, don't return from recv() or send() until it's successful.
         // Note: this is for blocking sockets only.
         SSL_CTX_set_mode(*context, SSL_MODE_AUTO_RETRY);
 
-        // Disable session caching (see SERVER-10261)
-        SSL_CTX_set_session_cache_mode(*context, SSL_SESS_CACHE_OFF);
+        // Let reconnecting clients resume their sessions, from our cache or from a ticket,
+        // without a full handshake.  Outgoing connections keep their sessions in
+        // _clientSessions instead of OpenSSL's client cache, which does not look them up.
+        // Without a session id context a context verifying peer certificates refuses to resume
+        // sessions (see SERVER-10261).
+        if (sslSessionCacheSize > 0) {
+            SSL_CTX_set_session_cache_mode(*context, SSL_SESS_CACHE_SERVER);
+            SSL_CTX_sess_set_cache_size(*context, sslSessionCacheSize);
+            SSL_CTX_set_timeout(*context, sslSessionTimeoutSecs);
+            SSL_CTX_set_session_id_context(*context,
+                                           sessionIdContext,
+                                           sizeof(sessionIdContext) - 1);
+        }
+        else {
+            SSL_CTX_set_session_cache_mode(*context, SSL_SESS_CACHE_OFF);
+            SSL_CTX_set_options(*context, SSL_OP_NO_TICKET);
+        }
  
         // Use the clusterfile for internal outgoing SSL connections if specified 
         if (context == &_clientContext && !params.clusterfile.empty()) {
@@ -860,18 +939,73 @@ namespace mongo {
         }
     }
 
+    void SSLManager::_resumeClientSession(const std::string& remote, SSL* ssl) {
+        boost::lock_guard<boost::mutex> lk(_clientSessionsMutex);
+        ClientSessionMap::const_iterator it = _clientSessions.find(remote);
+        if (it != _clientSessions.end()) {
+            // Takes its own reference.
+            SSL_set_session(ssl, it->second);
+        }
+    }
+
+    void SSLManager::_saveClientSession(const std::string& remote, SSL* ssl) {
+        SSL_SESSION* session = ssl ? SSL_get1_session(ssl) : NULL;
+
+        boost::lock_guard<boost::mutex> lk(_clientSessionsMutex);
+        ClientSessionMap::iterator it = _clientSessions.find(remote);
+        if (it != _clientSessions.end()) {
+            SSL_SESSION_free(it->second);
+            _clientSessions.erase(it);
+        }
+        if (!session) {
+            return;
+        }
+
+        // Rather than tracking which sessions are oldest, start over once the map is full.
+        if (_clientSessions.size() >= static_cast<size_t>(sslSessionCacheSize)) {
+            for (it = _clientSessions.begin(); it != _clientSessions.end(); ++it) {
+                SSL_SESSION_free(it->second);
+            }
+            _clientSessions.clear();
+        }
+        _clientSessions[remote] = session;
+    }
+
     SSLConnection* SSLManager::connect(Socket* socket) {
+        Timer timer;
+        ScopeGuard failedGuard = MakeObjGuard(_handshakesFailed, &AtomicInt64::fetchAndAdd, 1);
+
         SSLConnection* sslConn = new SSLConnection(_clientContext, socket, NULL, 0);
         ScopeGuard sslGuard = MakeGuard(::SSL_free, sslConn->ssl);
         ScopeGuard bioGuard = MakeGuard(::BIO_free, sslConn->networkBIO);
+
+        const std::string remote = socket->remoteString();
+        const bool keepSessions = sslSessionCacheSize > 0;
+        if (keepSessions) {
+            _resumeClientSession(remote, sslConn->ssl);
+        }
  
         int ret;
         do {
             ret = ::SSL_connect(sslConn->ssl);
         } while(!_doneWithSSLOp(sslConn, ret));
  
-        if (ret != 1)
+        if (ret != 1) {
+            if (keepSessions) {
+                _saveClientSession(remote, NULL);
+            }
             _handleSSLError(SSL_get_error(sslConn, ret), ret);
+        }
+
+        if (SSL_session_reused(sslConn->ssl)) {
+            _handshakesConnectedResumed.fetchAndAdd(1);
+        }
+        else if (keepSessions) {
+            _saveClientSession(remote, sslConn->ssl);
+        }
+        _handshakesConnected.fetchAndAdd(1);
+        _handshakeMicros.fetchAndAdd(timer.micros());
+        failedGuard.Dismiss();
  
         sslGuard.Dismiss();
         bioGuard.Dismiss();
@@ -879,6 +1013,9 @@ namespace mongo {
     }
 
     SSLConnection* SSLManager::accept(Socket* socket, const char* initialBytes, int len) {
+        Timer timer;
+        ScopeGuard failedGuard = MakeObjGuard(_handshakesFailed, &AtomicInt64::fetchAndAdd, 1);
+
         SSLConnection* sslConn = new SSLConnection(_serverContext, socket, initialBytes, len);
         ScopeGuard sslGuard = MakeGuard(::SSL_free, sslConn->ssl);
         ScopeGuard bioGuard = MakeGuard(::BIO_free, sslConn->networkBIO);
@@ -890,12 +1027,30 @@ namespace mongo {
  
         if (ret != 1)
             _handleSSLError(SSL_get_error(sslConn, ret), ret);
+
+        if (SSL_session_reused(sslConn->ssl)) {
+            _handshakesAcceptedResumed.fetchAndAdd(1);
+        }
+        _handshakesAccepted.fetchAndAdd(1);
+        _handshakeMicros.fetchAndAdd(timer.micros());
+        failedGuard.Dismiss();
  
         sslGuard.Dismiss();
         bioGuard.Dismiss();
         return sslConn;
     }
 
+    SSLHandshakeStats SSLManager::getHandshakeStats() const {
+        SSLHandshakeStats stats;
+        stats.accepted = _handshakesAccepted.load();
+        stats.acceptedResumed = _handshakesAcceptedResumed.load();
+        stats.connected = _handshakesConnected.load();
+        stats.connectedResumed = _handshakesConnectedResumed.load();
+        stats.failed = _handshakesFailed.load();
+        stats.totalMicros = _handshakeMicros.load();
+        return stats;
+    }
+
     // TODO SERVER-11601 Use NFC Unicode canonicalization
     bool SSLManager::_hostNameMatch(const char* nameToMatch, 
                                     const char* certHostName) {
@@ -83,6 +83,25 @@ namespace mongo {
         bool hasCA;
     };
 
+    /**
+     * Counts of the TLS handshakes an SSLManager has done, for serverStatus.
+     */
+    struct SSLHandshakeStats {
+        SSLHandshakeStats() :
+            accepted(0), acceptedResumed(0),
+            connected(0), connectedResumed(0),
+            failed(0), totalMicros(0) {}
+
+        BSONObj toBSON() const;
+
+        long long accepted;          // incoming handshakes completed
+        long long acceptedResumed;   // ... of which resumed a cached session or ticket
+        long long connected;         // outgoing handshakes completed
+        long long connectedResumed;  // ... of which resumed a session from an earlier connection
+        long long failed;            // handshakes in either direction which failed
+        long long totalMicros;       // time spent in all handshakes
+    };
+
     class SSLManagerInterface {
     public:
         virtual ~SSLManagerInterface();
@@ -125,6 +144,11 @@ namespace mongo {
         * Fetches the error text for an error code, in a thread-safe manner.
         */
         virtual std::string getSSLErrorMessage(int code) = 0;
+
+        /**
+         * Returns the handshake counts since startup.
+         */
+        virtual SSLHandshakeStats getHandshakeStats() const = 0;
  
         /**
          * ssl.h wrappers 
@@ -0,0 +1,221 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kControl
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/numa.h"
+
+#include <algorithm>
+#include <boost/thread/once.hpp>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/concurrency/threadlocal.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace {
+
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(numaPlacement, bool, false);
+
+    // From <numaif.h>, which comes with libnuma rather than the C library.
+    const int kMpolPreferred = 1;
+
+    const int kNoNode = -1;
+
+    struct Topology {
+        // CPUs of each node
+        std::vector<std::vector<int> > nodeCpus;
+
+        // Node of each CPU, kNoNode for CPUs which are not online
+        std::vector<int> cpuNodes;
+    };
+
+    Topology* topology = NULL;
+    boost::once_flag topologyOnce = BOOST_ONCE_INIT;
+
+    // Node the calling thread was last bound to
+    ThreadLocalValue<int> boundNode(kNoNode);
+
+    /**
+     * Parses a kernel CPU list such as "0-7,16-23".
+     */
+    std::vector<int> parseCpuList(const std::string& list) {
+        std::vector<int> cpus;
+        size_t pos = 0;
+        while (pos < list.size()) {
+            size_t end = list.find(',', pos);
+            if (end == std::string::npos) {
+                end = list.size();
+            }
+            const std::string range = list.substr(pos, end - pos);
+            int first = 0;
+            int last = 0;
+            const int fields = sscanf(range.c_str(), "%d-%d", &first, &last);
+            if (fields == 1) {
+                last = first;
+            }
+            for (int cpu = first; fields >= 1 && cpu <= last; cpu++) {
+                cpus.push_back(cpu);
+            }
+            pos = end + 1;
+        }
+        return cpus;
+    }
+
+    void loadTopology() {
+        Topology* result = new Topology();
+#ifdef __linux__
+        for (int node = 0; ; node++) {
+            const std::string path = str::stream() << "/sys/devices/system/node/node" << node
+                                                   << "/cpulist";
+            std::ifstream f(path.c_str());
+            if (!f.is_open()) {
+                break;
+            }
+            std::string line;
+            std::getline(f, line);
+            const std::vector<int> cpus = parseCpuList(line);
+            result->nodeCpus.push_back(cpus);
+            for (size_t i = 0; i < cpus.size(); i++) {
+                if (static_cast<size_t>(cpus[i]) >= result->cpuNodes.size()) {
+                    result->cpuNodes.resize(cpus[i] + 1, kNoNode);
+                }
+                result->cpuNodes[cpus[i]] = node;
+            }
+        }
+#endif
+        topology = result;
+    }
+
+    const Topology& getTopology() {
+        boost::call_once(loadTopology, topologyOnce);
+        return *topology;
+    }
+
+} // namespace
+
+    bool NumaPlacement::enabled() {
+        return numaPlacement && nodeCount() > 1;
+    }
+
+    int NumaPlacement::nodeCount() {
+        return std::max(1, static_cast<int>(getTopology().nodeCpus.size()));
+    }
+
+    int NumaPlacement::currentNode() {
+#ifdef __linux__
+        const Topology& t = getTopology();
+        const int cpu = sched_getcpu();
+        if (cpu >= 0 && static_cast<size_t>(cpu) < t.cpuNodes.size() &&
+                t.cpuNodes[cpu] != kNoNode) {
+            return t.cpuNodes[cpu];
+        }
+#endif
+        return 0;
+    }
+
+    bool NumaPlacement::bindThisThread(int node) {
+#ifdef __linux__
+        const Topology& t = getTopology();
+        if (node < 0 || static_cast<size_t>(node) >= t.nodeCpus.size()) {
+            return false;
+        }
+
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (size_t i = 0; i < t.nodeCpus[node].size(); i++) {
+            CPU_SET(t.nodeCpus[node][i], &cpus);
+        }
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (err != 0) {
+            warning() << "failed to bind thread to the CPUs of NUMA node " << node << ": "
+                      << errnoWithDescription(err);
+            return false;
+        }
+
+        const size_t bitsPerWord = sizeof(unsigned long) * 8;
+        std::vector<unsigned long> nodes(node / bitsPerWord + 1, 0);
+        nodes[node / bitsPerWord] |= 1UL << (node % bitsPerWord);
+        if (syscall(SYS_set_mempolicy, kMpolPreferred, &nodes[0],
+                    nodes.size() * bitsPerWord + 1) != 0) {
+            warning() << "failed to prefer the memory of NUMA node " << node << ": "
+                      << errnoWithDescription();
+            return false;
+        }
+
+        boundNode.set(node);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void NumaPlacement::ensureThisThreadOn(int node) {
+        if (boundNode.get() != node && enabled()) {
+            bindThisThread(node);
+        }
+    }
+
+    void NumaPlacement::appendStats(BSONObjBuilder* builder) {
+        builder->append("enabled", enabled());
+        builder->append("nodes", nodeCount());
+#ifdef __linux__
+        for (int node = 0; node < static_cast<int>(getTopology().nodeCpus.size()); node++) {
+            const std::string path = str::stream() << "/sys/devices/system/node/node" << node
+                                                   << "/numastat";
+            std::ifstream f(path.c_str());
+            if (!f.is_open()) {
+                continue;
+            }
+            const std::string name = str::stream() << "node" << node;
+            BSONObjBuilder nodeBuilder(builder->subobjStart(name));
+            std::string counter;
+            long long value;
+            while (f >> counter >> value) {
+                nodeBuilder.appendNumber(counter, value);
+            }
+            nodeBuilder.doneFast();
+        }
+#endif
+    }
+
+} // namespace mongo
@@ -0,0 +1,80 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+namespace mongo {
+
+    class BSONObjBuilder;
+
+    /**
+     * Optional NUMA-aware placement of threads and their memory, as an alternative to running the
+     * whole server under "numactl --interleave=all".  Enabled with the numaPlacement startup
+     * parameter on machines with more than one NUMA node; everything here is a no-op otherwise.
+     *
+     * The topology is read once from /sys/devices/system/node, so no NUMA library is needed.
+     */
+    class NumaPlacement {
+    public:
+        /**
+         * True if numaPlacement is set and the machine has more than one node.
+         */
+        static bool enabled();
+
+        /**
+         * Number of NUMA nodes of the machine, 1 where the platform does not tell.
+         */
+        static int nodeCount();
+
+        /**
+         * The node of the CPU the calling thread runs on, 0 if unknown.
+         */
+        static int currentNode();
+
+        /**
+         * Restricts the calling thread to the CPUs of 'node' and makes the node its preferred
+         * source of memory, falling back to the others when it has none left.  Returns false if
+         * the operating system refused.
+         */
+        static bool bindThisThread(int node);
+
+        /**
+         * Like bindThisThread but does nothing when placement is disabled or the thread is already
+         * bound to 'node', so that pooled threads can call it before each task.
+         */
+        static void ensureThisThreadOn(int node);
+
+        /**
+         * Appends the kernel's per-node allocation counters: pages allocated on the node they were
+         * intended for ("numa_hit"), and those which had to come from ("numa_miss") or went to
+         * ("numa_foreign") another node, among others.  The counters cover the whole machine.
+         */
+        static void appendStats(BSONObjBuilder* builder);
+    };
+
+} // namespace mongo
@@ -0,0 +1,65 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/numa.h"
+
+namespace mongo {
+namespace {
+
+    TEST(NumaPlacement, CurrentNodeIsInRange) {
+        ASSERT_GREATER_THAN_OR_EQUALS(NumaPlacement::nodeCount(), 1);
+        ASSERT_GREATER_THAN_OR_EQUALS(NumaPlacement::currentNode(), 0);
+        ASSERT_LESS_THAN(NumaPlacement::currentNode(), NumaPlacement::nodeCount());
+    }
+
+    TEST(NumaPlacement, DisabledByDefault) {
+        ASSERT_FALSE(NumaPlacement::enabled());
+
+        // Does nothing rather than binding the thread.
+        NumaPlacement::ensureThisThreadOn(0);
+    }
+
+    TEST(NumaPlacement, RefusesUnknownNode) {
+        ASSERT_FALSE(NumaPlacement::bindThisThread(-1));
+        ASSERT_FALSE(NumaPlacement::bindThisThread(NumaPlacement::nodeCount() + 1));
+    }
+
+    TEST(NumaPlacement, ReportsNodes) {
+        BSONObjBuilder builder;
+        NumaPlacement::appendStats(&builder);
+        const BSONObj stats = builder.obj();
+        ASSERT_EQUALS(NumaPlacement::nodeCount(), stats["nodes"].numberInt());
+        ASSERT_FALSE(stats["enabled"].trueValue());
+    }
+
+} // namespace
+} // namespace mongo
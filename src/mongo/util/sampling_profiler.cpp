@@ -0,0 +1,502 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kControl
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/sampling_profiler.h"
+
+#include <algorithm>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <map>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <sys/time.h>
+#endif
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/backtrace.h"
+#include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/stacktrace.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    namespace {
+
+        // Returned stacks and operations are cut off at these sizes, to fit in a command reply.
+        const int kMaxFoldedBytes = 8 * 1024 * 1024;
+        const size_t kMaxTopOps = 20;
+
+    }  // namespace
+
+    const int SamplingProfiler::kMaxHz;
+
+    void SamplingProfiler::Results::append(BSONObjBuilder* builder) const {
+        builder->appendNumber("samples", samples);
+        builder->appendNumber("dropped", dropped);
+        builder->appendNumber("durationMillis", durationMillis);
+
+        bool truncated = false;
+        int foldedBytes = 0;
+        BSONArrayBuilder foldedBuilder(builder->subarrayStart("folded"));
+        for (size_t i = 0; i < folded.size(); i++) {
+            foldedBytes += folded[i].size();
+            if (foldedBytes > kMaxFoldedBytes) {
+                truncated = true;
+                break;
+            }
+            foldedBuilder.append(folded[i]);
+        }
+        foldedBuilder.doneFast();
+        if (truncated) {
+            builder->append("foldedTruncated", true);
+        }
+
+        BSONArrayBuilder topOpsBuilder(builder->subarrayStart("topOps"));
+        for (size_t i = 0; i < topOps.size() && i < kMaxTopOps; i++) {
+            topOpsBuilder.append(topOps[i]);
+        }
+        topOpsBuilder.doneFast();
+    }
+
+#if defined(_WIN32)
+
+    Status SamplingProfiler::start(int hz) {
+        return Status(ErrorCodes::IllegalOperation,
+                      "the sampling profiler is not available on Windows");
+    }
+
+    Status SamplingProfiler::stop(Results* results) {
+        return Status(ErrorCodes::IllegalOperation,
+                      "the sampling profiler is not available on Windows");
+    }
+
+    bool SamplingProfiler::isRunning() {
+        return false;
+    }
+
+    void SamplingProfiler::tagCurrentThread(unsigned opNum,
+                                            const char* opName,
+                                            const StringData& ns) {
+    }
+
+    void SamplingProfiler::clearCurrentThreadTag() {
+    }
+
+#else
+
+namespace {
+
+    const int kMaxFrames = 64;
+
+    // The signal handler and the signal trampoline, at the top of every sample.
+    const int kSkipFrames = 2;
+
+    const size_t kNumSlots = 4096;
+
+    // How many slots the signal handler tries before dropping the sample.
+    const size_t kSlotProbes = 8;
+
+    // Limits on what the drain thread accumulates, so that a forgotten profile can't grow
+    // without bound.  Samples beyond them are dropped.
+    const size_t kMaxStacks = 100000;
+    const size_t kMaxOps = 100000;
+
+    const int kDrainIntervalMillis = 10;
+
+    const size_t kMaxNsSize = 128;
+
+    // Keeps the compiler from moving memory accesses across it, which is all the ordering needed
+    // between a thread and a signal handler interrupting that thread.
+#define MONGO_SIGNAL_FENCE() __asm__ __volatile__("" ::: "memory")
+
+    enum { kTagNone = 0, kTagUpdating = 1, kTagSet = 2 };
+
+    struct ThreadTag {
+        volatile sig_atomic_t state;
+        unsigned generation;
+        unsigned opNum;
+        const char* opName;
+        char ns[kMaxNsSize];
+    };
+
+#if defined(MONGO_HAVE___THREAD)
+    // Zero-initialized, so starts as kTagNone.
+    __thread ThreadTag threadTag;
+#endif
+
+    enum { kSlotEmpty = 0, kSlotWriting = 1, kSlotFull = 2 };
+
+    struct Slot {
+        AtomicUInt32 state;
+        int numFrames;
+        void* frames[kMaxFrames];
+        bool tagged;
+        unsigned opNum;
+        const char* opName;
+        char ns[kMaxNsSize];
+    };
+
+    // Allocated by the first start() and never freed, since a signal handler may still be
+    // writing to a slot after stop().
+    Slot* slots = NULL;
+
+    AtomicUInt32 running;
+
+    // Incremented by each start(), so that tags left over from an earlier profile are ignored.
+    AtomicUInt32 generation;
+    AtomicUInt32 nextSlot;
+    AtomicInt64 numSamples;
+    AtomicInt64 numDropped;
+
+    void onSample(int, siginfo_t*, void*) {
+        if (!running.loadRelaxed()) {
+            return;
+        }
+        const int savedErrno = errno;
+
+        numSamples.fetchAndAdd(1);
+
+        const unsigned first = nextSlot.fetchAndAdd(1);
+        Slot* slot = NULL;
+        for (size_t i = 0; i < kSlotProbes; i++) {
+            Slot* candidate = &slots[(first + i) % kNumSlots];
+            if (candidate->state.compareAndSwap(kSlotEmpty, kSlotWriting) == kSlotEmpty) {
+                slot = candidate;
+                break;
+            }
+        }
+
+        if (!slot) {
+            numDropped.fetchAndAdd(1);
+            errno = savedErrno;
+            return;
+        }
+
+        void* frames[kMaxFrames + kSkipFrames];
+        const int numFrames = backtrace(frames, kMaxFrames + kSkipFrames) - kSkipFrames;
+        slot->numFrames = std::max(numFrames, 0);
+        if (numFrames > 0) {
+            memcpy(slot->frames, frames + kSkipFrames, numFrames * sizeof(void*));
+        }
+
+        slot->tagged = false;
+#if defined(MONGO_HAVE___THREAD)
+        if (threadTag.state == kTagSet && threadTag.generation == generation.loadRelaxed()) {
+            slot->tagged = true;
+            slot->opNum = threadTag.opNum;
+            slot->opName = threadTag.opName;
+            memcpy(slot->ns, threadTag.ns, kMaxNsSize);
+        }
+#endif
+
+        slot->state.store(kSlotFull);
+        errno = savedErrno;
+    }
+
+    struct OpSamples {
+        OpSamples() : opName(NULL), samples(0) { }
+        const char* opName;
+        std::string ns;
+        long long samples;
+    };
+
+    // (tag, frames leaf first) -> number of samples; the tag is "<op type>;<ns>" or empty.
+    typedef std::map<std::pair<std::string, std::vector<void*> >, long long> StackCounts;
+    typedef std::map<unsigned, OpSamples> OpCounts;
+
+    // Serializes start() and stop().
+    boost::mutex profilerMutex;
+
+    // Written by the drain thread while running, and by stop() once it has joined that thread.
+    StackCounts stackCounts;
+    OpCounts opCounts;
+
+    boost::scoped_ptr<boost::thread> drainThread;
+    long long startMillis = 0;
+
+    void drainSlots() {
+        for (size_t i = 0; i < kNumSlots; i++) {
+            Slot& slot = slots[i];
+            if (slot.state.load() != kSlotFull) {
+                continue;
+            }
+
+            std::string tag;
+            if (slot.tagged) {
+                const StringData ns(slot.ns);
+                tag = str::stream() << slot.opName << ';' << (ns.empty() ? "-" : ns);
+            }
+            std::pair<std::string, std::vector<void*> > key(
+                    tag, std::vector<void*>(slot.frames, slot.frames + slot.numFrames));
+
+            StackCounts::iterator it = stackCounts.find(key);
+            if (it != stackCounts.end()) {
+                it->second++;
+            }
+            else if (stackCounts.size() < kMaxStacks) {
+                stackCounts[key] = 1;
+            }
+            else {
+                numDropped.fetchAndAdd(1);
+            }
+
+            if (slot.tagged) {
+                OpCounts::iterator op = opCounts.find(slot.opNum);
+                if (op != opCounts.end()) {
+                    op->second.samples++;
+                }
+                else if (opCounts.size() < kMaxOps) {
+                    OpSamples& samples = opCounts[slot.opNum];
+                    samples.opName = slot.opName;
+                    samples.ns = slot.ns;
+                    samples.samples = 1;
+                }
+            }
+
+            slot.state.store(kSlotEmpty);
+        }
+    }
+
+    void drainLoop() {
+        while (running.load()) {
+            sleepmillis(kDrainIntervalMillis);
+            drainSlots();
+        }
+    }
+
+    Status setTimer(int hz) {
+        struct itimerval timer;
+        timer.it_interval.tv_sec = 0;
+        timer.it_interval.tv_usec = hz ? 1000 * 1000 / hz : 0;
+        timer.it_value = timer.it_interval;
+        if (setitimer(ITIMER_PROF, &timer, NULL) != 0) {
+            const int err = errno;
+            return Status(ErrorCodes::OperationFailed,
+                          str::stream() << "setitimer failed: " << errnoWithDescription(err));
+        }
+        return Status::OK();
+    }
+
+    bool bySamplesDescending(const std::pair<long long, std::string>& lhs,
+                             const std::pair<long long, std::string>& rhs) {
+        if (lhs.first != rhs.first) {
+            return lhs.first > rhs.first;
+        }
+        return lhs.second < rhs.second;
+    }
+
+    bool byOpSamplesDescending(const std::pair<unsigned, OpSamples>& lhs,
+                               const std::pair<unsigned, OpSamples>& rhs) {
+        if (lhs.second.samples != rhs.second.samples) {
+            return lhs.second.samples > rhs.second.samples;
+        }
+        return lhs.first < rhs.first;
+    }
+
+    /**
+     * Symbolizes "stackCounts" into folded stacks, merging the stacks whose frames have the same
+     * names, and orders them and "opCounts" by number of samples.
+     */
+    void buildResults(SamplingProfiler::Results* results) {
+        std::map<void*, std::string> names;
+        std::map<std::string, long long> folded;
+        for (StackCounts::const_iterator it = stackCounts.begin();
+             it != stackCounts.end();
+             ++it) {
+            const std::vector<void*>& frames = it->first.second;
+            std::string line = it->first.first;
+            for (std::vector<void*>::const_reverse_iterator frame = frames.rbegin();
+                 frame != frames.rend();
+                 ++frame) {
+                std::map<void*, std::string>::iterator name = names.find(*frame);
+                if (name == names.end()) {
+                    std::string symbol = getSymbolName(*frame);
+                    // ';' separates frames in the folded format.
+                    std::replace(symbol.begin(), symbol.end(), ';', ':');
+                    name = names.insert(std::make_pair(*frame, symbol)).first;
+                }
+                if (!line.empty()) {
+                    line += ';';
+                }
+                line += name->second;
+            }
+            if (line.empty()) {
+                line = "???";
+            }
+            folded[line] += it->second;
+        }
+
+        std::vector<std::pair<long long, std::string> > sorted;
+        for (std::map<std::string, long long>::const_iterator it = folded.begin();
+             it != folded.end();
+             ++it) {
+            sorted.push_back(std::make_pair(it->second, it->first));
+        }
+        std::sort(sorted.begin(), sorted.end(), bySamplesDescending);
+        for (size_t i = 0; i < sorted.size(); i++) {
+            results->folded.push_back(str::stream() << sorted[i].second << ' ' << sorted[i].first);
+        }
+
+        std::vector<std::pair<unsigned, OpSamples> > ops(opCounts.begin(), opCounts.end());
+        std::sort(ops.begin(), ops.end(), byOpSamplesDescending);
+        for (size_t i = 0; i < ops.size() && i < kMaxTopOps; i++) {
+            results->topOps.push_back(BSON("opid" << ops[i].first
+                                        << "op" << ops[i].second.opName
+                                        << "ns" << ops[i].second.ns
+                                        << "samples" << ops[i].second.samples));
+        }
+    }
+
+}  // namespace
+
+    Status SamplingProfiler::start(int hz) {
+        boost::mutex::scoped_lock lk(profilerMutex);
+        if (running.load()) {
+            return Status(ErrorCodes::IllegalOperation, "the sampling profiler is already running");
+        }
+        if (hz < 1 || hz > kMaxHz) {
+            return Status(ErrorCodes::BadValue,
+                          str::stream() << "sampling rate must be between 1 and " << kMaxHz
+                                        << " per second, not " << hz);
+        }
+
+        if (!slots) {
+            slots = new Slot[kNumSlots];
+        }
+        for (size_t i = 0; i < kNumSlots; i++) {
+            slots[i].state.store(kSlotEmpty);
+        }
+        stackCounts.clear();
+        opCounts.clear();
+        numSamples.store(0);
+        numDropped.store(0);
+        generation.fetchAndAdd(1);
+
+        // The first backtrace() may load the unwinder, which mallocs: do it outside the handler.
+        void* frames[kMaxFrames];
+        backtrace(frames, kMaxFrames);
+
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_sigaction = onSample;
+        action.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        if (sigaction(SIGPROF, &action, NULL) != 0) {
+            const int err = errno;
+            return Status(ErrorCodes::OperationFailed,
+                          str::stream() << "sigaction failed: " << errnoWithDescription(err));
+        }
+
+        running.store(1);
+        drainThread.reset(new boost::thread(drainLoop));
+
+        Status status = setTimer(hz);
+        if (!status.isOK()) {
+            running.store(0);
+            drainThread->join();
+            drainThread.reset();
+            return status;
+        }
+
+        startMillis = curTimeMillis64();
+        log() << "started the sampling profiler at " << hz << " samples per second";
+        return Status::OK();
+    }
+
+    Status SamplingProfiler::stop(Results* results) {
+        boost::mutex::scoped_lock lk(profilerMutex);
+        if (!running.load()) {
+            return Status(ErrorCodes::IllegalOperation, "the sampling profiler is not running");
+        }
+
+        Status status = setTimer(0);
+        if (!status.isOK()) {
+            warning() << "could not stop the profiling timer: " << status;
+        }
+        running.store(0);
+        drainThread->join();
+        drainThread.reset();
+
+        // Pick up the samples written since the drain thread's last pass.
+        drainSlots();
+
+        results->samples = numSamples.load();
+        results->dropped = numDropped.load();
+        results->durationMillis = curTimeMillis64() - startMillis;
+        buildResults(results);
+
+        stackCounts.clear();
+        opCounts.clear();
+
+        log() << "stopped the sampling profiler after " << results->samples << " samples";
+        return Status::OK();
+    }
+
+    bool SamplingProfiler::isRunning() {
+        return running.loadRelaxed();
+    }
+
+    void SamplingProfiler::tagCurrentThread(unsigned opNum,
+                                            const char* opName,
+                                            const StringData& ns) {
+#if defined(MONGO_HAVE___THREAD)
+        if (!isRunning()) {
+            return;
+        }
+        threadTag.state = kTagUpdating;
+        MONGO_SIGNAL_FENCE();
+        threadTag.generation = generation.loadRelaxed();
+        threadTag.opNum = opNum;
+        threadTag.opName = opName;
+        const size_t nsSize = std::min(ns.size(), kMaxNsSize - 1);
+        memcpy(threadTag.ns, ns.rawData(), nsSize);
+        threadTag.ns[nsSize] = '\0';
+        MONGO_SIGNAL_FENCE();
+        threadTag.state = kTagSet;
+#endif
+    }
+
+    void SamplingProfiler::clearCurrentThreadTag() {
+#if defined(MONGO_HAVE___THREAD)
+        threadTag.state = kTagNone;
+#endif
+    }
+
+#endif  // defined(_WIN32)
+
+}  // namespace mongo
@@ -0,0 +1,99 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/base/status.h"
+#include "mongo/base/string_data.h"
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    /**
+     * A sampling CPU profiler for the whole process, always compiled in and cheap enough to run
+     * on production servers.
+     *
+     * While running, an ITIMER_PROF timer sends SIGPROF at "hz" times per second of CPU used by
+     * the process, and the signal handler records the stack of whichever thread was running
+     * along with that thread's tag: the operation it was working on, set by CurOp.  The samples
+     * go to a fixed pool of slots without locking or allocating; a background thread folds them
+     * into a count per distinct stack.  If the pool is full, the sample is dropped and counted.
+     *
+     * stop() symbolizes the stacks and returns them in the "folded" format that flamegraph.pl
+     * reads: one line per stack, frames root first separated by ';', then a space and the number
+     * of samples.  Tagged stacks begin with "<op type>;<namespace>".
+     *
+     * Only one profile runs at a time.  Not available on Windows.  Do not use together with the
+     * gperftools profiler of the _cpuProfilerStart command, which also uses SIGPROF.
+     */
+    class SamplingProfiler {
+    public:
+        struct Results {
+            Results() : samples(0), dropped(0), durationMillis(0) { }
+
+            void append(BSONObjBuilder* builder) const;
+
+            long long samples;
+            long long dropped;
+            long long durationMillis;
+
+            // "<frame>;<frame>;... <count>", in decreasing order of count.
+            std::vector<std::string> folded;
+
+            // The operations with the most samples: { opid, op, ns, samples }.
+            std::vector<BSONObj> topOps;
+        };
+
+        /**
+         * Starts sampling at "hz" samples per second of CPU time.  Fails if the profiler is
+         * already running or "hz" is not between 1 and kMaxHz.
+         */
+        static Status start(int hz);
+
+        /**
+         * Stops sampling and fills "results" with the profile since start().  Fails if the
+         * profiler is not running.
+         */
+        static Status stop(Results* results);
+
+        static bool isRunning();
+
+        /**
+         * Tags the samples taken on the current thread, until it is tagged again or cleared.
+         * Cheap when the profiler is not running.
+         */
+        static void tagCurrentThread(unsigned opNum, const char* opName, const StringData& ns);
+        static void clearCurrentThreadTag();
+
+        static const int kMaxHz = 1000;
+    };
+
+}  // namespace mongo
@@ -0,0 +1,142 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <cstdlib>
+
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/sampling_profiler.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+namespace {
+
+#if !defined(_WIN32)
+
+    volatile unsigned long long sink;
+
+    void burnCpu(int millis) {
+        Timer timer;
+        while (timer.millis() < millis) {
+            for (int i = 0; i < 100000; i++) {
+                sink = sink * 31 + i;
+            }
+        }
+    }
+
+    long long countOf(const std::string& line) {
+        const size_t space = line.rfind(' ');
+        ASSERT_NOT_EQUALS(std::string::npos, space);
+        return atoll(line.c_str() + space + 1);
+    }
+
+    TEST(SamplingProfiler, RejectsBadRates) {
+        ASSERT_EQUALS(ErrorCodes::BadValue, SamplingProfiler::start(0));
+        ASSERT_EQUALS(ErrorCodes::BadValue, SamplingProfiler::start(SamplingProfiler::kMaxHz + 1));
+        ASSERT_FALSE(SamplingProfiler::isRunning());
+    }
+
+    TEST(SamplingProfiler, StartsAndStopsOnce) {
+        SamplingProfiler::Results results;
+        ASSERT_EQUALS(ErrorCodes::IllegalOperation, SamplingProfiler::stop(&results));
+
+        ASSERT_OK(SamplingProfiler::start(100));
+        ASSERT_TRUE(SamplingProfiler::isRunning());
+        ASSERT_EQUALS(ErrorCodes::IllegalOperation, SamplingProfiler::start(100));
+
+        ASSERT_OK(SamplingProfiler::stop(&results));
+        ASSERT_FALSE(SamplingProfiler::isRunning());
+        ASSERT_EQUALS(ErrorCodes::IllegalOperation, SamplingProfiler::stop(&results));
+    }
+
+    TEST(SamplingProfiler, FoldsTaggedSamples) {
+        ASSERT_OK(SamplingProfiler::start(SamplingProfiler::kMaxHz));
+        SamplingProfiler::tagCurrentThread(42, "query", "test.coll");
+        burnCpu(500);
+        SamplingProfiler::clearCurrentThreadTag();
+
+        SamplingProfiler::Results results;
+        ASSERT_OK(SamplingProfiler::stop(&results));
+
+        ASSERT_GREATER_THAN(results.samples, 0);
+        ASSERT_FALSE(results.folded.empty());
+
+        // Every sample is in exactly one folded stack, unless it was dropped.
+        long long folded = 0;
+        long long tagged = 0;
+        for (size_t i = 0; i < results.folded.size(); i++) {
+            const long long count = countOf(results.folded[i]);
+            ASSERT_GREATER_THAN(count, 0);
+            if (i > 0) {
+                ASSERT_LESS_THAN_OR_EQUALS(count, countOf(results.folded[i - 1]));
+            }
+            folded += count;
+            if (results.folded[i].find("query;test.coll;") == 0) {
+                tagged += count;
+            }
+        }
+        ASSERT_EQUALS(results.samples - results.dropped, folded);
+        ASSERT_GREATER_THAN(tagged, 0);
+
+        ASSERT_FALSE(results.topOps.empty());
+        ASSERT_EQUALS(42, results.topOps[0]["opid"].numberLong());
+        ASSERT_EQUALS("query", results.topOps[0]["op"].str());
+        ASSERT_EQUALS("test.coll", results.topOps[0]["ns"].str());
+        ASSERT_EQUALS(tagged, results.topOps[0]["samples"].numberLong());
+
+        BSONObjBuilder builder;
+        results.append(&builder);
+        const BSONObj obj = builder.obj();
+        ASSERT_EQUALS(results.samples, obj["samples"].numberLong());
+        ASSERT_EQUALS(static_cast<int>(results.folded.size()),
+                      static_cast<int>(obj["folded"].Obj().nFields()));
+    }
+
+    TEST(SamplingProfiler, IgnoresTagsFromEarlierProfiles) {
+        ASSERT_OK(SamplingProfiler::start(100));
+        SamplingProfiler::tagCurrentThread(7, "update", "test.old");
+        SamplingProfiler::Results results;
+        ASSERT_OK(SamplingProfiler::stop(&results));
+
+        ASSERT_OK(SamplingProfiler::start(SamplingProfiler::kMaxHz));
+        burnCpu(200);
+        results = SamplingProfiler::Results();
+        ASSERT_OK(SamplingProfiler::stop(&results));
+
+        ASSERT_GREATER_THAN(results.samples, 0);
+        ASSERT_TRUE(results.topOps.empty());
+        for (size_t i = 0; i < results.folded.size(); i++) {
+            ASSERT_EQUALS(std::string::npos, results.folded[i].find("test.old"));
+        }
+    }
+
+#endif
+
+}  // namespace
+}  // namespace mongo
@@ -76,6 +76,13 @@ namespace mongo {
             return _holder ? _holder->data() : NULL;
         }
 
+        /**
+         * Returns true if anything other than this SharedBuffer refers to the buffer.
+         */
+        bool isShared() const {
+            return _holder && _holder->isShared();
+        }
+
         class Holder {
         public:
             explicit Holder(AtomicUInt32::WordType initial = AtomicUInt32::WordType())
@@ -95,6 +102,10 @@ namespace mongo {
                 }
             }
 
+            bool isShared() const {
+                return _refCount.load() > 1;
+            }
+
             char* data() {
                 return reinterpret_cast<char *>(this + 1);
             }
@@ -32,6 +32,7 @@
 #pragma once
 
 #include <iostream>
+#include <string>
 
 #include "mongo/logger/log_severity.h"
 #include "mongo/logger/logger.h"
@@ -58,6 +59,17 @@ namespace mongo {
     // Print stack trace information to "os", default to the log stream.
     void printStackTrace(std::ostream &os=getStackTraceLogger().stream());
 
+#if !defined(_WIN32)
+    /**
+     * Returns a name for the code at "address", as printStackTrace() does in its human-readable
+     * trace: the demangled name of the enclosing exported symbol, or else the basename of the
+     * object containing it plus the offset into the object.
+     *
+     * Mallocs; not for use in signal handlers.
+     */
+    std::string getSymbolName(void* address);
+#endif
+
 #if defined(_WIN32)
     // Print stack trace (using a specified stack context) to "os", default to the log stream.
     void printWindowsStackTrace(CONTEXT &context, std::ostream &os=getStackTraceLogger().stream());
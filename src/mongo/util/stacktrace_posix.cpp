@@ -32,8 +32,10 @@
 #include "mongo/util/stacktrace.h"
 
 #include <cstdlib>
+#include <cxxabi.h>
 #include <dlfcn.h>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <sys/utsname.h>
 
@@ -174,6 +176,29 @@ namespace {
         os << "-----  END BACKTRACE  -----" << std::endl;
     }
 
+    std::string getSymbolName(void* address) {
+        Dl_info dlinfo;
+        if (!dladdr(address, &dlinfo) || !dlinfo.dli_fbase) {
+            return "???";
+        }
+
+        if (dlinfo.dli_sname) {
+            int status;
+            char* niceName = abi::__cxa_demangle(dlinfo.dli_sname, 0, 0, &status);
+            if (!niceName) {
+                return dlinfo.dli_sname;
+            }
+            std::string name = niceName;
+            free(niceName);
+            return name;
+        }
+
+        const uintptr_t offset = uintptr_t(address) - uintptr_t(dlinfo.dli_fbase);
+        std::ostringstream os;
+        os << getBaseName(dlinfo.dli_fname) << "+0x" << std::hex << std::uppercase << offset;
+        return os.str();
+    }
+
 namespace {
 
     void addOSComponentsToSoMap(BSONObjBuilder* soMap);
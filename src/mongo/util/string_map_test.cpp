@@ -31,6 +31,8 @@
 
 #include "mongo/unittest/unittest.h"
 
+#include <vector>
+
 #include "mongo/platform/random.h"
 #include "mongo/platform/unordered_map.h"
 #include "mongo/util/string_map.h"
@@ -205,4 +207,122 @@ namespace {
         y = m;
         ASSERT_EQUALS( 5, y["eliot"] );
     }
+
+    TEST( StringMapTest, StringDataLookup ) {
+        StringMap<int> m;
+        m["abc"] = 5;
+
+        // lookups don't need a std::string, or even a terminated string
+        const char buf[] = "abcdef";
+        ASSERT_EQUALS( 5, m.find( StringData( buf, 3 ) )->second );
+        ASSERT( m.end() == m.find( StringData( buf, 4 ) ) );
+        ASSERT_EQUALS( 1U, m.erase( StringData( buf, 3 ) ) );
+        ASSERT( m.end() == m.find( "abc" ) );
+    }
+
+    TEST( StringMapTest, GrowIncrementally ) {
+        StringMap<int> m;
+        char buf[64];
+
+        // Every key stays visible, to both lookups and iteration, while the table moves keys
+        // into a bigger area.
+        for ( int i = 0; i < 2000; i++ ) {
+            sprintf( buf, "foo%d", i );
+            m[buf] = i;
+            ASSERT_EQUALS( static_cast<size_t>( i + 1 ), m.size() );
+
+            for ( int j = 0; j <= i; j += 7 ) {
+                sprintf( buf, "foo%d", j );
+                StringMap<int>::const_iterator it = m.find( buf );
+                ASSERT( it != m.end() );
+                ASSERT_EQUALS( j, it->second );
+            }
+
+            size_t count = 0;
+            long long sum = 0;
+            for ( StringMap<int>::const_iterator it = m.begin(); it != m.end(); ++it ) {
+                count++;
+                sum += it->second;
+            }
+            ASSERT_EQUALS( m.size(), count );
+            ASSERT_EQUALS( static_cast<long long>( i ) * ( i + 1 ) / 2, sum );
+        }
+        ASSERT_GREATER_THAN_OR_EQUALS( m.capacity(), 2000U );
+    }
+
+    TEST( StringMapTest, EraseWhileGrowing ) {
+        StringMap<int> m;
+        std::vector<bool> present( 5000, false );
+        char buf[64];
+
+        for ( int i = 0; i < 5000; i++ ) {
+            sprintf( buf, "foo%d", i );
+            m[buf] = i;
+            present[i] = true;
+
+            // erase keys which may still be waiting to move across
+            if ( i % 3 == 0 ) {
+                sprintf( buf, "foo%d", i / 2 );
+                ASSERT_EQUALS( present[i / 2] ? 1U : 0U, m.erase( buf ) );
+                present[i / 2] = false;
+            }
+        }
+
+        size_t count = 0;
+        for ( int i = 0; i < 5000; i++ ) {
+            sprintf( buf, "foo%d", i );
+            ASSERT_EQUALS( present[i], m.find( buf ) != m.end() );
+            count += present[i];
+        }
+        ASSERT_EQUALS( count, m.size() );
+    }
+
+    TEST( StringMapTest, CopyWhileGrowing ) {
+        StringMap<int> m;
+        char buf[64];
+
+        for ( int i = 0; i < 30; i++ ) {
+            sprintf( buf, "foo%d", i );
+            m[buf] = i;
+        }
+
+        StringMap<int> y = m;
+        for ( int i = 0; i < 30; i++ ) {
+            sprintf( buf, "foo%d", i );
+            ASSERT_EQUALS( i, y[buf] );
+        }
+        ASSERT_EQUALS( 30U, y.size() );
+
+        y["foo0"] = 100;
+        ASSERT_EQUALS( 0, m["foo0"] );
+    }
+
+    struct BadHash {
+        size_t operator()( const StringData& str ) const {
+            return str.size();
+        }
+    };
+
+    TEST( StringMapTest, Collisions ) {
+        // Every key has the same hash, so every key has the same tag and probe sequence.
+        UnorderedFastKeyTable<StringData, std::string, int, BadHash, StringMapDefaultEqual,
+                              StringMapDefaultConvertor, StringMapDefaultConvertorOther> m;
+        char buf[64];
+
+        for ( int i = 0; i < 500; i++ ) {
+            sprintf( buf, "%05d", i );
+            m[buf] = i;
+        }
+
+        for ( int i = 0; i < 500; i += 2 ) {
+            sprintf( buf, "%05d", i );
+            ASSERT_EQUALS( 1U, m.erase( buf ) );
+        }
+
+        for ( int i = 0; i < 500; i++ ) {
+            sprintf( buf, "%05d", i );
+            ASSERT_EQUALS( i % 2 == 1, m.find( buf ) != m.end() );
+        }
+        ASSERT_EQUALS( 250U, m.size() );
+    }
 }
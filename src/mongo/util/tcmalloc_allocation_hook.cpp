@@ -0,0 +1,61 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <third_party/gperftools-2.2/src/gperftools/malloc_hook.h>
+
+#include "mongo/base/init.h"
+#include "mongo/db/exec/scoped_timer.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+namespace {
+
+    // Gives the bytes of each allocation to the plan stage timers, for explain's detailed stats.
+
+    void recordNew(const void* ptr, size_t size) {
+        ScopedTimer::recordAllocation(size);
+    }
+
+    void installAllocationHook(bool install) {
+        if (install) {
+            fassert(28669, MallocHook::AddNewHook(&recordNew));
+        }
+        else {
+            fassert(28670, MallocHook::RemoveNewHook(&recordNew));
+        }
+    }
+
+    MONGO_INITIALIZER(TCMallocAllocationHook)(InitializerContext* context) {
+        ScopedTimer::setAllocationHookInstaller(&installAllocationHook);
+        return Status::OK();
+    }
+
+} // namespace
+} // namespace mongo
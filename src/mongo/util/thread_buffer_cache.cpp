@@ -0,0 +1,222 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/thread_buffer_cache.h"
+
+#include <boost/thread/tss.hpp>
+#include <cstdlib>
+#include <cstring>
+
+#include "mongo/util/allocator.h"
+
+namespace mongo {
+
+namespace {
+    const int kNumSizeClasses = 11; // 64 bytes to 64KB
+    const int kMaxBuffersPerClass = 8;
+
+    int sizeClassOf(size_t size) {
+        int sizeClass = 0;
+        for (size_t classSize = ThreadBufferCache::kMinBufferSize; classSize < size;
+                classSize <<= 1) {
+            sizeClass++;
+        }
+        return sizeClass;
+    }
+
+    size_t sizeOfClass(int sizeClass) {
+        return ThreadBufferCache::kMinBufferSize << sizeClass;
+    }
+
+    class BufferCacheState {
+    public:
+        BufferCacheState() : _bytes(0), _allocations(0) {
+            memset(_counts, 0, sizeof(_counts));
+            memset(_lowWater, 0, sizeof(_lowWater));
+        }
+
+        ~BufferCacheState();
+
+        void* take(int sizeClass) {
+            void* buffer = NULL;
+            int& count = _counts[sizeClass];
+            if (count > 0) {
+                buffer = _buffers[sizeClass][--count];
+                _bytes -= sizeOfClass(sizeClass);
+                if (count < _lowWater[sizeClass]) {
+                    _lowWater[sizeClass] = count;
+                }
+            }
+
+            if (++_allocations >= ThreadBufferCache::kTrimInterval) {
+                trim();
+            }
+            return buffer;
+        }
+
+        bool put(void* buffer, int sizeClass) {
+            int& count = _counts[sizeClass];
+            const size_t size = sizeOfClass(sizeClass);
+            if (count == kMaxBuffersPerClass
+                    || _bytes + size > ThreadBufferCache::kMaxCachedBytes) {
+                return false;
+            }
+            _buffers[sizeClass][count++] = buffer;
+            _bytes += size;
+            return true;
+        }
+
+        size_t bytes() const { return _bytes; }
+
+    private:
+        /**
+         * Frees the buffers of each class that were not taken since the last trim, which is the
+         * fewest the class held at any point since then.
+         */
+        void trim() {
+            for (int c = 0; c < kNumSizeClasses; c++) {
+                for (; _lowWater[c] > 0; _lowWater[c]--) {
+                    free(_buffers[c][--_counts[c]]);
+                    _bytes -= sizeOfClass(c);
+                }
+                _lowWater[c] = _counts[c];
+            }
+            _allocations = 0;
+        }
+
+        void* _buffers[kNumSizeClasses][kMaxBuffersPerClass];
+        int _counts[kNumSizeClasses];
+        int _lowWater[kNumSizeClasses];
+        size_t _bytes;
+        int _allocations;
+    };
+
+#if defined(MONGO_HAVE___THREAD)
+    __thread BufferCacheState* threadBufferCacheState;
+#elif defined(MONGO_HAVE___DECLSPEC_THREAD)
+    __declspec(thread) BufferCacheState* threadBufferCacheState;
+#endif
+
+    /**
+     * Owns each thread's BufferCacheState, deleting it when the thread exits.  Never destroyed,
+     * and created on first use, since BufBuilders are used by static initializers and
+     * destructors as well.
+     */
+    boost::thread_specific_ptr<BufferCacheState>& bufferCacheStateOwner() {
+        static boost::thread_specific_ptr<BufferCacheState>* owner =
+            new boost::thread_specific_ptr<BufferCacheState>;
+        return *owner;
+    }
+
+    BufferCacheState* getBufferCacheState() {
+#if defined(MONGO_HAVE___THREAD) || defined(MONGO_HAVE___DECLSPEC_THREAD)
+        // Reading the intrinsic thread local is much faster than thread_specific_ptr::get().
+        BufferCacheState* state = threadBufferCacheState;
+#else
+        BufferCacheState* state = bufferCacheStateOwner().get();
+#endif
+        if (!state) {
+            state = new BufferCacheState;
+            bufferCacheStateOwner().reset(state);
+#if defined(MONGO_HAVE___THREAD) || defined(MONGO_HAVE___DECLSPEC_THREAD)
+            threadBufferCacheState = state;
+#endif
+        }
+        return state;
+    }
+
+    BufferCacheState::~BufferCacheState() {
+        for (int c = 0; c < kNumSizeClasses; c++) {
+            for (int i = 0; i < _counts[c]; i++) {
+                free(_buffers[c][i]);
+            }
+        }
+#if defined(MONGO_HAVE___THREAD) || defined(MONGO_HAVE___DECLSPEC_THREAD)
+        // Runs at thread exit, on the exiting thread.  A later BufBuilder on this thread gets a
+        // new state rather than this deleted one.
+        threadBufferCacheState = NULL;
+#endif
+    }
+} // namespace
+
+    const size_t ThreadBufferCache::kMinBufferSize;
+    const size_t ThreadBufferCache::kMaxBufferSize;
+    const size_t ThreadBufferCache::kMaxCachedBytes;
+    const int ThreadBufferCache::kTrimInterval;
+
+    void* ThreadBufferCache::allocate(size_t size, size_t* capacity) {
+        if (size > kMaxBufferSize) {
+            *capacity = size;
+            return mongoMalloc(size);
+        }
+
+        const int sizeClass = sizeClassOf(size);
+        *capacity = sizeOfClass(sizeClass);
+        if (void* buffer = getBufferCacheState()->take(sizeClass)) {
+            return buffer;
+        }
+        return mongoMalloc(*capacity);
+    }
+
+    void* ThreadBufferCache::reallocate(void* buffer,
+                                        size_t capacity,
+                                        size_t size,
+                                        size_t* newCapacity) {
+        if (!buffer) {
+            return allocate(size, newCapacity);
+        }
+        if (size <= capacity) {
+            *newCapacity = capacity;
+            return buffer;
+        }
+        if (capacity > kMaxBufferSize) {
+            // Was never cached, and realloc may be able to grow it in place.
+            *newCapacity = size;
+            return mongoRealloc(buffer, size);
+        }
+
+        void* grown = allocate(size, newCapacity);
+        memcpy(grown, buffer, capacity);
+        release(buffer, capacity);
+        return grown;
+    }
+
+    void ThreadBufferCache::release(void* buffer, size_t capacity) {
+        if (capacity > kMaxBufferSize
+                || !getBufferCacheState()->put(buffer, sizeClassOf(capacity))) {
+            free(buffer);
+        }
+    }
+
+    size_t ThreadBufferCache::cachedBytes() {
+        return getBufferCacheState()->bytes();
+    }
+
+} // namespace mongo
@@ -0,0 +1,77 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace mongo {
+
+    /**
+     * Per-thread cache of freed buffers, used by BufBuilder so that a thread which keeps building
+     * replies, commands, oplog entries and index keys reuses the same few buffers instead of
+     * calling malloc, realloc and free for each of them.
+     *
+     * Buffers are grouped by power of two size classes from 64 bytes to 64KB.  Each thread keeps
+     * up to kMaxCachedBytes of freed buffers, and every kTrimInterval allocations it frees the
+     * buffers of each class that went unused since the last trim, so that a thread only keeps
+     * what its recent work needed.  Larger requests go straight to malloc.
+     *
+     * Every buffer is ordinary malloc'd memory, so a buffer may also be handed off and free()d
+     * instead of being released here, and may be released on a different thread.
+     */
+    class ThreadBufferCache {
+    public:
+        static const size_t kMinBufferSize = 64;
+        static const size_t kMaxBufferSize = 64 * 1024;
+        static const size_t kMaxCachedBytes = 256 * 1024;
+        static const int kTrimInterval = 1024;
+
+        /**
+         * Returns a buffer of at least "size" bytes and sets "*capacity" to its actual size.
+         */
+        static void* allocate(size_t size, size_t* capacity);
+
+        /**
+         * Returns a buffer of at least "size" bytes holding the contents of "buffer", which has
+         * "capacity" bytes, and sets "*newCapacity" to its size.  A NULL "buffer" is allocated.
+         */
+        static void* reallocate(void* buffer, size_t capacity, size_t size, size_t* newCapacity);
+
+        /**
+         * Gives back "buffer", of "capacity" bytes, which came from allocate() or reallocate().
+         */
+        static void release(void* buffer, size_t capacity);
+
+        /**
+         * Returns the number of bytes of freed buffers the current thread has cached.
+         */
+        static size_t cachedBytes();
+    };
+
+} // namespace mongo
@@ -0,0 +1,125 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/thread_buffer_cache.h"
+
+#include <cstring>
+#include <vector>
+
+#include "mongo/unittest/unittest.h"
+
+namespace {
+    using mongo::ThreadBufferCache;
+
+    TEST(ThreadBufferCache, RoundsUpToSizeClass) {
+        size_t capacity;
+        void* buffer = ThreadBufferCache::allocate(100, &capacity);
+        ASSERT_EQUALS(128U, capacity);
+        ThreadBufferCache::release(buffer, capacity);
+
+        buffer = ThreadBufferCache::allocate(1, &capacity);
+        ASSERT_EQUALS(ThreadBufferCache::kMinBufferSize, capacity);
+        ThreadBufferCache::release(buffer, capacity);
+    }
+
+    TEST(ThreadBufferCache, ReusesReleasedBuffer) {
+        size_t capacity;
+        void* buffer = ThreadBufferCache::allocate(1000, &capacity);
+        const size_t cachedBefore = ThreadBufferCache::cachedBytes();
+        ThreadBufferCache::release(buffer, capacity);
+        ASSERT_EQUALS(cachedBefore + capacity, ThreadBufferCache::cachedBytes());
+
+        size_t secondCapacity;
+        ASSERT_EQUALS(buffer, ThreadBufferCache::allocate(1000, &secondCapacity));
+        ASSERT_EQUALS(capacity, secondCapacity);
+        ASSERT_EQUALS(cachedBefore, ThreadBufferCache::cachedBytes());
+        ThreadBufferCache::release(buffer, secondCapacity);
+    }
+
+    TEST(ThreadBufferCache, ReallocateWithinCapacityKeepsBuffer) {
+        size_t capacity;
+        void* buffer = ThreadBufferCache::allocate(300, &capacity);
+        size_t newCapacity;
+        ASSERT_EQUALS(buffer, ThreadBufferCache::reallocate(buffer, capacity, 400, &newCapacity));
+        ASSERT_EQUALS(capacity, newCapacity);
+        ThreadBufferCache::release(buffer, newCapacity);
+    }
+
+    TEST(ThreadBufferCache, ReallocateKeepsContents) {
+        size_t capacity;
+        char* buffer = static_cast<char*>(ThreadBufferCache::allocate(64, &capacity));
+        memset(buffer, 'x', capacity);
+
+        const size_t sizes[] = { 1000, ThreadBufferCache::kMaxBufferSize * 2,
+                                 ThreadBufferCache::kMaxBufferSize * 4 };
+        size_t filled = capacity;
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+            buffer = static_cast<char*>(
+                ThreadBufferCache::reallocate(buffer, capacity, sizes[i], &capacity));
+            ASSERT_GREATER_THAN_OR_EQUALS(capacity, sizes[i]);
+            for (size_t j = 0; j < filled; j++) {
+                ASSERT_EQUALS('x', buffer[j]);
+            }
+            memset(buffer, 'x', capacity);
+            filled = capacity;
+        }
+        ThreadBufferCache::release(buffer, capacity);
+    }
+
+    TEST(ThreadBufferCache, CachedBytesAreBounded) {
+        std::vector<void*> buffers;
+        size_t capacity;
+        for (int i = 0; i < 100; i++) {
+            buffers.push_back(ThreadBufferCache::allocate(ThreadBufferCache::kMaxBufferSize,
+                                                          &capacity));
+        }
+        for (size_t i = 0; i < buffers.size(); i++) {
+            ThreadBufferCache::release(buffers[i], capacity);
+        }
+        ASSERT_LESS_THAN_OR_EQUALS(ThreadBufferCache::cachedBytes(),
+                                   ThreadBufferCache::kMaxCachedBytes);
+    }
+
+    TEST(ThreadBufferCache, TrimFreesUnusedBuffers) {
+        size_t capacity;
+        void* unused = ThreadBufferCache::allocate(8 * 1024, &capacity);
+        ThreadBufferCache::release(unused, capacity);
+
+        // Two trim intervals of other work: the first notes that the 8KB buffer was never
+        // taken, the second frees it.
+        size_t smallCapacity;
+        for (int i = 0; i < 2 * ThreadBufferCache::kTrimInterval; i++) {
+            void* buffer = ThreadBufferCache::allocate(100, &smallCapacity);
+            ThreadBufferCache::release(buffer, smallCapacity);
+        }
+        ASSERT_EQUALS(smallCapacity, ThreadBufferCache::cachedBytes());
+    }
+
+}  // namespace
@@ -133,4 +133,15 @@ namespace mongo {
         return _timerNow();
     }
 
+    // static
+    long long Timer::nowNanos() {
+        const long long ticks = _timerNow();
+        if (_countsPerSecond == nanosPerSecond)
+            return ticks;
+
+        // Split the conversion so that it cannot overflow.
+        return (ticks / _countsPerSecond) * nanosPerSecond
+            + ((ticks % _countsPerSecond) * nanosPerSecond) / _countsPerSecond;
+    }
+
 }  // namespace mongo
@@ -74,6 +74,12 @@ namespace mongo {
 
         inline void reset() { _old = now(); }
 
+        /**
+         * Nanoseconds since an arbitrary fixed point, read from the same clock as the timers.
+         * The difference between two readings is the time between them.
+         */
+        static long long nowNanos();
+
         /**
          * Internally, the timer counts platform-dependent ticks of some sort, and
          * must then convert those ticks to microseconds and their ilk.  This field
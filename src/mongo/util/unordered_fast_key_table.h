@@ -30,6 +30,7 @@
 #pragma once
 
 #include <boost/smart_ptr/scoped_array.hpp>
+#include <new>
 
 #include "mongo/base/disallow_copying.h"
 
@@ -42,6 +43,24 @@ namespace mongo {
         }
     };
 
+    /**
+     * An open addressing hash table in the style of a Swiss table.
+     *
+     * Slots are split into groups of 16. Next to each slot there is one control byte, which is
+     * either empty, deleted, or the low 7 bits of the hash of the key in that slot. A lookup
+     * compares its 7 bit tag against a whole group of control bytes at once (with SSE2 where
+     * available), so keys are only compared against slots whose tag matches. A lookup stops at
+     * the first group which has an empty slot.
+     *
+     * When the table fills up it does not rehash everything at once. A new area is allocated
+     * and new keys go there, while each insert moves one group of the old area across. Lookups
+     * and iteration look at both areas until the old one is drained.
+     *
+     * Lookups are done with K_L, so a StringMap can be searched with a StringData without
+     * building a std::string.
+     *
+     * Inserting a new key invalidates iterators and references into the table; erasing does not.
+     */
     template< typename K_L, // key lookup
               typename K_S, // key storage
               typename V, // value
@@ -58,47 +77,114 @@ namespace mongo {
 
     private:
         struct Entry {
-            Entry()
-                : used( false ), everUsed( false ) {
-            }
-
-            bool used;
-            bool everUsed;
             size_t curHash;
             value_type data;
         };
 
         struct Area {
-            Area( unsigned capacity, double maxProbeRatio );
+            static const unsigned kGroupSize = 16;
+
+            // Control bytes of slots without a key. Full slots hold a tag between 0 and 127.
+            static const signed char kEmpty = -128;
+            static const signed char kDeleted = -2;
+
+            explicit Area( unsigned capacity );
             Area( const Area& other );
+            ~Area();
+
+            /**
+             * @return offset into _entries of 'key', or -1 if not there
+             */
+            int find( const K_L& key, size_t hash, const UnorderedFastKeyTable& sm ) const;
+
+            /**
+             * @return the first empty or deleted slot along the probe sequence of 'hash'
+             */
+            int findInsertSlot( size_t hash ) const;
+
+            /**
+             * Constructs an entry with a default value_type in the free slot 'pos'.
+             */
+            void fill( int pos, size_t hash ) {
+                new ( &_entries[pos] ) Entry();
+                if ( _ctrl[pos] == kDeleted )
+                    _deleted--;
+                _ctrl[pos] = tag( hash );
+                _entries[pos].curHash = hash;
+                _used++;
+            }
 
-            int find( const K_L& key, size_t hash, int* firstEmpty, const UnorderedFastKeyTable& sm ) const;
+            /**
+             * Destroys the entry in 'pos' and marks it as no longer used. The slot can go back
+             * to empty when its group still has an empty slot, since then no probe sequence has
+             * ever gone past this group.
+             */
+            void clear( int pos ) {
+                _entries[pos].~Entry();
+                const unsigned group = pos & ~( kGroupSize - 1 );
+                if ( matchEmpty( &_ctrl[group] ) ) {
+                    _ctrl[pos] = kEmpty;
+                }
+                else {
+                    _ctrl[pos] = kDeleted;
+                    _deleted++;
+                }
+                _used--;
+            }
 
-            bool transfer( Area* newArea, const UnorderedFastKeyTable& sm ) const;
+            bool isFull( int pos ) const { return _ctrl[pos] >= 0; }
+
+            /**
+             * @return whether one more key can go in without going over the maximum load
+             */
+            bool hasRoom() const { return _used + _deleted < maxLoad( _capacity ); }
 
             void swap( Area* other ) {
                 using std::swap;
                 swap( _capacity, other->_capacity );
-                swap( _maxProbe, other->_maxProbe );
+                swap( _used, other->_used );
+                swap( _deleted, other->_deleted );
+                swap( _ctrl, other->_ctrl );
                 swap( _entries, other->_entries );
             }
 
-            unsigned _capacity;
-            unsigned _maxProbe;
-            boost::scoped_array<Entry> _entries;
+            static unsigned maxLoad( unsigned capacity ) { return capacity - capacity / 8; }
+
+            static signed char tag( size_t hash ) {
+                return static_cast<signed char>( hash & 0x7F );
+            }
+
+            /**
+             * Each of these returns a mask with bit i set when control byte i of the
+             * group starting at 'ctrl' matches.
+             */
+            static unsigned match( const signed char* ctrl, signed char t );
+            static unsigned matchEmpty( const signed char* ctrl );
+            static unsigned matchEmptyOrDeleted( const signed char* ctrl );
+
+            static unsigned lowestBit( unsigned mask );
+
+            unsigned _capacity; // a power of two, and a multiple of kGroupSize, or 0
+            unsigned _used;
+            unsigned _deleted;
+            boost::scoped_array<signed char> _ctrl;
+
+            // Raw storage, where only the full slots hold a constructed Entry. This keeps
+            // allocating a new area cheap no matter how big it is.
+            Entry* _entries;
+
+        private:
+            Area& operator=( const Area& other ); // not defined, areas are only swapped
         };
 
     public:
         static const unsigned DEFAULT_STARTING_CAPACITY = 20;
 
         /**
-         * @param startingCapacity how many buckets should exist on initial creation
-         *                         DEFAULT_STARTING_CAPACITY
-         * @param maxProbeRatio the percentage of buckets we're willing to probe
-         *                      no defined default as you can't have a static const double on windows
+         * @param startingCapacity how many buckets should exist on initial creation,
+         *                         rounded up to a power of two of at least 16
          */
-        UnorderedFastKeyTable( unsigned startingCapacity = DEFAULT_STARTING_CAPACITY,
-                               double maxProbeRatio = 0.05 );
+        UnorderedFastKeyTable( unsigned startingCapacity = DEFAULT_STARTING_CAPACITY );
 
         UnorderedFastKeyTable( const UnorderedFastKeyTable& other );
 
@@ -134,17 +220,13 @@ namespace mongo {
             friend class UnorderedFastKeyTable;
 
         public:
-            const_iterator() { _position = -1; }
-            const_iterator( const Area* area ) {
-                _area = area;
-                _position = 0;
-                _max = _area->_capacity - 1;
+            const_iterator() : _area( NULL ), _next( NULL ), _position( -1 ), _max( -1 ) {}
+            const_iterator( const Area* area, const Area* next )
+                : _area( area ), _next( next ), _position( 0 ), _max( area->_capacity - 1 ) {
                 _skip();
             }
-            const_iterator( const Area* area, int pos ) {
-                _area = area;
-                _position = pos;
-                _max = pos;
+            const_iterator( const Area* area, int pos )
+                : _area( area ), _next( NULL ), _position( pos ), _max( pos ) {
             }
 
             const value_type* operator->() const { return &_area->_entries[_position].data; }
@@ -155,35 +237,44 @@ namespace mongo {
                 if ( _position < 0 )
                     return *this;
                 _position++;
-                if ( _position > _max )
-                    _position = -1;
-                else
-                    _skip();
+                _skip();
                 return *this;
             }
 
             bool operator==( const const_iterator& other ) const {
-                return _position == other._position;
+                return _position == other._position &&
+                    ( _position < 0 || _area == other._area );
             }
             bool operator!=( const const_iterator& other ) const {
-                return _position != other._position;
+                return !( *this == other );
             }
 
         private:
 
+            /**
+             * Moves forward to the next full slot, going on to '_next' at the end of '_area'.
+             */
             void _skip() {
                 while ( true ) {
-                    if ( _area->_entries[_position].used )
-                        break;
-                    if ( _position >= _max ) {
-                        _position = -1;
-                        break;
+                    if ( _position > _max ) {
+                        if ( !_next ) {
+                            _position = -1;
+                            break;
+                        }
+                        _area = _next;
+                        _next = NULL;
+                        _position = 0;
+                        _max = _area->_capacity - 1;
+                        continue;
                     }
+                    if ( _area->isFull( _position ) )
+                        break;
                     ++_position;
                 }
             }
 
             const Area* _area;
+            const Area* _next; // the area to go on to after this one, if any
             int _position;
             int _max; // inclusive
         };
@@ -200,21 +291,30 @@ namespace mongo {
         const_iterator end() const;
 
     private:
-        /*
-         * @param firstEmpty, if we return -1, and firstEmpty != NULL,
-         *                    this will be set to the first empty bucket we found
-         * @retrun offset into _entries or -1 if not there
-         */
-        int _find( const K_L& key, int hash, int* firstEmpty ) const;
+        void _erase( Area* area, int pos );
 
+        /**
+         * Makes room for one more key in _area, starting to move everything into a new area.
+         */
         void _grow();
 
+        /**
+         * Moves up to 'slots' slots of _oldArea into _area, and frees _oldArea once it is empty.
+         */
+        void _migrate( unsigned slots );
+
         // ----
 
         size_t _size;
-        double _maxProbeRatio;
+
+        // Where new keys go.
         Area _area;
 
+        // The area from before the last _grow(), with keys not moved into _area yet.
+        // Its capacity is 0 when there is nothing left to move.
+        Area _oldArea;
+        unsigned _migratePos; // slots of _oldArea below this have been moved
+
         H _hash;
         E _equals;
         C _convertor;
@@ -28,104 +28,177 @@
  *    then also delete it in the license file.
  */
 
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "mongo/util/assert_util.h"
 
 namespace mongo {
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
-    inline UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::Area(unsigned capacity,
-                                                                   double maxProbeRatio)
-        : _capacity( capacity ),
-          _maxProbe( static_cast<unsigned>( capacity * maxProbeRatio ) ),
-          _entries( new Entry[_capacity] ) {
+    const unsigned UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::kGroupSize;
+
+    template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
+    const signed char UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::kEmpty;
+
+    template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
+    const signed char UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::kDeleted;
+
+    template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
+    inline UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::Area( unsigned capacity )
+        : _capacity( 0 ), _used( 0 ), _deleted( 0 ), _entries( NULL ) {
+        if ( capacity == 0 )
+            return;
+
+        _capacity = kGroupSize;
+        while ( _capacity < capacity )
+            _capacity *= 2;
+        _ctrl.reset( new signed char[_capacity] );
+        std::fill( _ctrl.get(), _ctrl.get() + _capacity, kEmpty );
+        _entries = static_cast<Entry*>( ::operator new( _capacity * sizeof(Entry) ) );
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
-    inline UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::Area(const Area& other )
+    inline UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::Area( const Area& other )
         : _capacity( other._capacity ),
-          _maxProbe( other._maxProbe ),
-          _entries( new Entry[_capacity] ) {
+          _used( other._used ),
+          _deleted( other._deleted ),
+          _entries( NULL ) {
+        if ( _capacity == 0 )
+            return;
+
+        _ctrl.reset( new signed char[_capacity] );
+        std::copy( other._ctrl.get(), other._ctrl.get() + _capacity, _ctrl.get() );
+        _entries = static_cast<Entry*>( ::operator new( _capacity * sizeof(Entry) ) );
         for ( unsigned i = 0; i < _capacity; i++ ) {
-            _entries[i] = other._entries[i];
+            if ( isFull( i ) )
+                new ( &_entries[i] ) Entry( other._entries[i] );
         }
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
-    inline int UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::find(
-            const K_L& key,
-            size_t hash,
-            int* firstEmpty,
-            const UnorderedFastKeyTable& sm ) const {
-        if ( firstEmpty )
-            *firstEmpty = -1;
-
-        for ( unsigned probe = 0; probe < _maxProbe; probe++ ) {
-            unsigned pos = (hash + probe) % _capacity;
+    inline UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::~Area() {
+        for ( unsigned i = 0; i < _capacity; i++ ) {
+            if ( isFull( i ) )
+                _entries[i].~Entry();
+        }
+        ::operator delete( _entries );
+    }
 
-            if ( ! _entries[pos].used ) {
-                // space is empty
-                if ( firstEmpty && *firstEmpty == -1 )
-                    *firstEmpty = pos;
-                if ( ! _entries[pos].everUsed )
-                    return -1;
-                continue;
-            }
+    template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
+    inline unsigned UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::match(
+            const signed char* ctrl, signed char t ) {
+#if defined(__SSE2__)
+        const __m128i group = _mm_loadu_si128( reinterpret_cast<const __m128i*>( ctrl ) );
+        return _mm_movemask_epi8( _mm_cmpeq_epi8( group, _mm_set1_epi8( t ) ) );
+#else
+        unsigned mask = 0;
+        for ( unsigned i = 0; i < kGroupSize; i++ ) {
+            if ( ctrl[i] == t )
+                mask |= 1U << i;
+        }
+        return mask;
+#endif
+    }
 
-            if ( _entries[pos].curHash != hash ) {
-                // space has something else
-                continue;
-            }
+    template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
+    inline unsigned UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::matchEmpty(
+            const signed char* ctrl ) {
+        return match( ctrl, kEmpty );
+    }
 
-            if ( ! sm._equals(key, sm._convertor( _entries[pos].data.first ) ) ) {
-                // hashes match
-                // strings are not equals
-                continue;
-            }
+    template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
+    inline unsigned UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::matchEmptyOrDeleted(
+            const signed char* ctrl ) {
+        // Empty and deleted are the only control bytes with the sign bit set.
+#if defined(__SSE2__)
+        return _mm_movemask_epi8( _mm_loadu_si128( reinterpret_cast<const __m128i*>( ctrl ) ) );
+#else
+        unsigned mask = 0;
+        for ( unsigned i = 0; i < kGroupSize; i++ ) {
+            if ( ctrl[i] < 0 )
+                mask |= 1U << i;
+        }
+        return mask;
+#endif
+    }
 
-            // hashes and strings are equal
-            // yay!
-            return pos;
+    template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
+    inline unsigned UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::lowestBit(
+            unsigned mask ) {
+#if defined(__GNUC__)
+        return __builtin_ctz( mask );
+#else
+        unsigned bit = 0;
+        while ( !( mask & 1 ) ) {
+            mask >>= 1;
+            bit++;
         }
-        return -1;
+        return bit;
+#endif
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
-    inline bool UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::transfer(
-            Area* newArea,
-            const UnorderedFastKeyTable& sm) const {
-        for ( unsigned i = 0; i < _capacity; i++ ) {
-            if ( ! _entries[i].used )
-                continue;
+    inline int UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::find( const K_L& key,
+                              size_t hash,
+                              const UnorderedFastKeyTable& sm ) const {
+        if ( _capacity == 0 )
+            return -1;
+
+        // The low 7 bits of the hash are the tag, the rest picks the first group. Groups are
+        // probed at triangular offsets, which visits every group once since there are a power
+        // of two of them.
+        const signed char t = tag( hash );
+        const unsigned groupMask = _capacity / kGroupSize - 1;
+        unsigned group = ( hash >> 7 ) & groupMask;
+        for ( unsigned probe = 0; probe <= groupMask; probe++ ) {
+            const signed char* ctrl = &_ctrl[group * kGroupSize];
+            for ( unsigned mask = match( ctrl, t ); mask; mask &= mask - 1 ) {
+                const unsigned pos = group * kGroupSize + lowestBit( mask );
+                if ( _entries[pos].curHash == hash &&
+                     sm._equals( key, sm._convertor( _entries[pos].data.first ) ) )
+                    return pos;
+            }
 
-            int firstEmpty = -1;
-            int loc = newArea->find( sm._convertor( _entries[i].data.first ),
-                                     _entries[i].curHash,
-                                     &firstEmpty,
-                                     sm );
+            // a key is never put past a group with an empty slot
+            if ( matchEmpty( ctrl ) )
+                return -1;
 
-            verify( loc == -1 );
-            if ( firstEmpty < 0 ) {
-                return false;
-            }
+            group = ( group + probe + 1 ) & groupMask;
+        }
+        return -1;
+    }
 
-            newArea->_entries[firstEmpty] = _entries[i];
+    template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
+    inline int UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::findInsertSlot(
+            size_t hash ) const {
+        const unsigned groupMask = _capacity / kGroupSize - 1;
+        unsigned group = ( hash >> 7 ) & groupMask;
+        for ( unsigned probe = 0; probe <= groupMask; probe++ ) {
+            const unsigned mask = matchEmptyOrDeleted( &_ctrl[group * kGroupSize] );
+            if ( mask )
+                return group * kGroupSize + lowestBit( mask );
+
+            group = ( group + probe + 1 ) & groupMask;
         }
-        return true;
+        msgasserted( 16471, "UnorderedFastKeyTable has no free slot" );
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
     inline UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::UnorderedFastKeyTable(
-            unsigned startingCapacity,
-            double maxProbeRatio)
-        : _maxProbeRatio( maxProbeRatio ), _area( startingCapacity, maxProbeRatio ) {
-        _size = 0;
+            unsigned startingCapacity )
+        : _size( 0 ), _area( std::max( startingCapacity, 1U ) ), _oldArea( 0 ), _migratePos( 0 ) {
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
     inline UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::UnorderedFastKeyTable(
             const UnorderedFastKeyTable& other )
         : _size( other._size ),
-          _maxProbeRatio( other._maxProbeRatio ),
           _area( other._area ),
+          _oldArea( other._oldArea ),
+          _migratePos( other._migratePos ),
           _hash( other._hash ),
           _equals( other._equals ),
           _convertor( other._convertor ),
@@ -133,11 +206,14 @@ namespace mongo {
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
-    inline void UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::copyTo( UnorderedFastKeyTable* out ) const {
+    inline void UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::copyTo(
+            UnorderedFastKeyTable* out ) const {
         out->_size = _size;
-        out->_maxProbeRatio = _maxProbeRatio;
         Area x( _area );
         out->_area.swap( &x );
+        Area y( _oldArea );
+        out->_oldArea.swap( &y );
+        out->_migratePos = _migratePos;
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
@@ -145,69 +221,113 @@ namespace mongo {
 
         const size_t hash = _hash( key );
 
-        for ( int numGrowTries = 0; numGrowTries < 5; numGrowTries++ ) {
-            int firstEmpty = -1;
-            int pos = _area.find( key, hash, &firstEmpty, *this );
+        int pos = _area.find( key, hash, *this );
+        if ( pos >= 0 )
+            return _area._entries[pos].data.second;
+
+        if ( _oldArea._capacity ) {
+            pos = _oldArea.find( key, hash, *this );
             if ( pos >= 0 )
-                return _area._entries[pos].data.second;
-
-            // key not in map
-            // need to add
-            if ( firstEmpty >= 0 ) {
-                _size++;
-                _area._entries[firstEmpty].used = true;
-                _area._entries[firstEmpty].everUsed = true;
-                _area._entries[firstEmpty].curHash = hash;
-                _area._entries[firstEmpty].data.first = _convertorOther(key);
-                return _area._entries[firstEmpty].data.second;
-            }
+                return _oldArea._entries[pos].data.second;
 
-            // no space left in map
-            _grow();
+            // Moving one group per insert drains _oldArea well before _area fills up.
+            _migrate( Area::kGroupSize );
         }
-        msgasserted( 16471, "UnorderedFastKeyTable couldn't add entry after growing many times" );
+
+        // key not in map
+        // need to add
+        if ( !_area.hasRoom() )
+            _grow();
+
+        K_S stored = _convertorOther( key );
+        pos = _area.findInsertSlot( hash );
+        _area.fill( pos, hash );
+        using std::swap;
+        swap( _area._entries[pos].data.first, stored );
+        _size++;
+        return _area._entries[pos].data.second;
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
     inline size_t UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::erase( const K_L& key ) {
 
         const size_t hash = _hash( key );
-        int pos = _area.find( key, hash, NULL, *this );
 
-        if ( pos < 0 )
-            return 0;
+        int pos = _area.find( key, hash, *this );
+        if ( pos >= 0 ) {
+            _erase( &_area, pos );
+            return 1;
+        }
 
-        --_size;
-        _area._entries[pos].used = false;
-        _area._entries[pos].data.second = V();
-        return 1;
+        pos = _oldArea.find( key, hash, *this );
+        if ( pos >= 0 ) {
+            _erase( &_oldArea, pos );
+            return 1;
+        }
+
+        return 0;
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
     void UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::erase( const_iterator it ) {
+        Area* area = it._area == &_oldArea ? &_oldArea : &_area;
         dassert(it._position >= 0);
-        dassert(it._area == &_area);
+        dassert(it._area == area);
 
+        _erase( area, it._position );
+    }
+
+    template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
+    inline void UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::_erase( Area* area, int pos ) {
         --_size;
-        _area._entries[it._position].used = false;
-        _area._entries[it._position].data.second = V();
+        area->clear( pos );
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
     inline void UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::_grow() {
+        if ( _oldArea._capacity )
+            _migrate( _oldArea._capacity );
+
+        // Only deleted slots are in the way when less than half the maximum load is in use,
+        // and then rehashing into the same capacity is enough.
         unsigned capacity = _area._capacity;
-        for ( int numGrowTries = 0; numGrowTries < 5; numGrowTries++ ) {
+        if ( _size >= Area::maxLoad( capacity ) / 2 ) {
+            massert( 16845,
+                     "UnorderedFastKeyTable::_grow couldn't grow any further",
+                     capacity < ( 1U << 31 ) );
             capacity *= 2;
-            Area newArea( capacity, _maxProbeRatio );
-            bool success = _area.transfer( &newArea, *this );
-            if ( !success ) {
+        }
+
+        Area newArea( capacity );
+        _oldArea.swap( &_area );
+        _area.swap( &newArea );
+        _migratePos = 0;
+    }
+
+    template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
+    inline void UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::_migrate( unsigned slots ) {
+        const unsigned end = std::min( _migratePos + slots, _oldArea._capacity );
+        for ( ; _migratePos < end; _migratePos++ ) {
+            if ( !_oldArea.isFull( _migratePos ) )
                 continue;
-            }
-            _area.swap( &newArea );
-            return;
+
+            Entry& from = _oldArea._entries[_migratePos];
+            const int pos = _area.findInsertSlot( from.curHash );
+            _area.fill( pos, from.curHash );
+
+            // swapping into the default constructed entry avoids copying keys and values
+            using std::swap;
+            Entry& to = _area._entries[pos];
+            swap( to.data.first, from.data.first );
+            swap( to.data.second, from.data.second );
+            _oldArea.clear( _migratePos );
+        }
+
+        if ( _migratePos == _oldArea._capacity ) {
+            Area none( 0 );
+            _oldArea.swap( &none );
+            _migratePos = 0;
         }
-        msgasserted( 16845,
-                     "UnorderedFastKeyTable::_grow couldn't add entry after growing many times" );
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
@@ -215,10 +335,17 @@ namespace mongo {
     UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::find( const K_L& key ) const {
         if ( _size == 0 )
             return const_iterator();
-        int pos = _area.find( key, _hash(key), 0, *this );
-        if ( pos < 0 )
-            return const_iterator();
-        return const_iterator( &_area, pos );
+
+        const size_t hash = _hash( key );
+        int pos = _area.find( key, hash, *this );
+        if ( pos >= 0 )
+            return const_iterator( &_area, pos );
+
+        pos = _oldArea.find( key, hash, *this );
+        if ( pos >= 0 )
+            return const_iterator( &_oldArea, pos );
+
+        return const_iterator();
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
@@ -230,6 +357,6 @@ namespace mongo {
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
     inline typename UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::const_iterator
     UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::begin() const {
-        return const_iterator( &_area );
+        return const_iterator( &_area, _oldArea._capacity ? &_oldArea : NULL );
     }
 }